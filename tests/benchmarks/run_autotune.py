@@ -0,0 +1,378 @@
+#!/usr/bin/env python
+'''VIC image driver runtime knob autotuner
+
+Runs short trial segments of a real image driver configuration and searches
+the performance options with a coordinate search: one option at a time is
+set to each of its candidate values while the others are held, the fastest
+value is kept, and the passes over the options are repeated until no option
+changes. The options of the physics are timed with COMPUTE_BENCHMARK and the
+options of the I/O with IO_BENCHMARK, so that each trial only measures the
+part of the run the option acts on. The best settings are written as a
+global parameter snippet, together with the phase timings of a segment of
+the real configuration with the initial and with the best settings.
+'''
+
+from __future__ import print_function
+import os
+import sys
+import json
+import shutil
+import argparse
+import datetime
+
+import psutil
+
+here = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, here)
+from run_scaling import run_vic, parse_timing_profile  # noqa: E402
+
+description = '''
+                        VIC Runtime Knob Autotuner
+-------------------------------------------------------------------------------
+Coordinate search of the performance options of the VIC image driver on short
+trial segments of a real configuration.
+-------------------------------------------------------------------------------
+'''
+
+epilog = '''
+-------------------------------------------------------------------------------
+For questions about the development or use of VIC or use of this test module,
+please email the VIC users list serve at vic_users@u.washington.edu.
+-------------------------------------------------------------------------------
+'''
+
+# keys of the global parameter file that the trials set themselves
+run_keys = ('NRECS', 'ENDYEAR', 'ENDMONTH', 'ENDDAY', 'IO_BENCHMARK',
+            'COMPUTE_BENCHMARK', 'LOG_DIR', 'RESULT_DIR', 'STATEYEAR',
+            'STATEMONTH', 'STATEDAY', 'STATESEC', 'STATENAME')
+
+
+class CustomFormatter(argparse.ArgumentDefaultsHelpFormatter,
+                      argparse.RawDescriptionHelpFormatter):
+    pass
+
+
+def log2_range(m, start=1):
+    '''powers of 2 from start up to m'''
+    n = start
+    values = []
+    while n <= m:
+        values.append(n)
+        n *= 2
+    return values
+
+
+def get_knobs(args):
+    '''options of the search as (name, mode, stream option, candidates),
+    searched in this order'''
+    ncompute = args.nprocs
+    threads = log2_range(max(1, psutil.cpu_count() // args.nprocs))
+    knobs = [('NTHREADS', 'compute', False, [str(n) for n in threads]),
+             ('DECOMPOSITION', 'compute', False,
+              ['ROUND_ROBIN', 'COST_WEIGHTED', 'HILBERT']),
+             ('IO_SERVERS', 'io', False,
+              [str(n) for n in [0] + log2_range(args.nprocs // 2)]),
+             ('FORCE_READERS', 'io', False,
+              [str(n) for n in log2_range(ncompute)]),
+             ('FORCE_PREFETCH', 'io', False, ['FALSE', 'TRUE']),
+             ('CHUNK', 'io', True, ['DEFAULT', 'SLICE']),
+             ('FLUSH', 'io', True,
+              ['ALWAYS', 'NEVER', 'NRECORDS {0}'.format(args.flush_records),
+               'STATE'])]
+    return [k for k in knobs if k[0] not in args.skip]
+
+
+def read_global(global_file):
+    '''lines of a global parameter file and the values of its options'''
+    with open(global_file, 'r') as f:
+        lines = f.read().splitlines()
+    values = {}
+    for line in lines:
+        words = line.split('#')[0].split()
+        if words and words[0] == 'OUTFILE':
+            break
+        if words:
+            values[words[0]] = ' '.join(words[1:])
+    # stream options of the first stream that has them
+    for line in lines:
+        words = line.split('#')[0].split()
+        if words and words[0] in ('CHUNK', 'FLUSH'):
+            values.setdefault(words[0], ' '.join(words[1:]))
+    return lines, values
+
+
+def get_dates(values, days):
+    '''end date of a trial segment of days days and the date of its state'''
+    start = datetime.date(int(values['STARTYEAR']), int(values['STARTMONTH']),
+                          int(values['STARTDAY']))
+    end = start + datetime.timedelta(days=days - 1)
+    return end, end + datetime.timedelta(days=1)
+
+
+def make_global(lines, values, settings, mode, days, knobs, run_dir):
+    '''write the global parameter file of a trial'''
+    stream_knobs = set(k[0] for k in knobs if k[2])
+    global_knobs = set(k[0] for k in knobs if not k[2])
+    end, state = get_dates(values, days)
+
+    head = ['ENDYEAR {0}'.format(end.year),
+            'ENDMONTH {0}'.format(end.month),
+            'ENDDAY {0}'.format(end.day)]
+    if mode == 'compute':
+        head.append('COMPUTE_BENCHMARK TRUE')
+    elif mode == 'io':
+        head.append('IO_BENCHMARK TRUE')
+    head.append('RESULT_DIR {0}'.format(os.path.join(run_dir, 'results')))
+    if 'STATENAME' in values:
+        head += ['STATENAME {0}'.format(os.path.join(
+                     run_dir, 'state',
+                     os.path.basename(values['STATENAME'].split()[0]))),
+                 'STATEYEAR {0}'.format(state.year),
+                 'STATEMONTH {0}'.format(state.month),
+                 'STATEDAY {0}'.format(state.day),
+                 'STATESEC 0']
+    for key in sorted(global_knobs):
+        head.append('{0} {1}'.format(key, settings[key]))
+
+    out = []
+    in_streams = False
+    for line in lines:
+        words = line.split('#')[0].split()
+        key = words[0] if words else ''
+        if key == 'OUTFILE':
+            if not in_streams:
+                out += head + ['']
+                in_streams = True
+            out.append(line)
+            for k in sorted(stream_knobs):
+                out.append('{0} {1}'.format(k, settings[k]))
+            continue
+        if key in run_keys or key in global_knobs or key in stream_knobs:
+            continue
+        out.append(line)
+    if not in_streams:
+        out += head
+
+    for name in ('results', 'state', 'logs'):
+        if not os.path.isdir(os.path.join(run_dir, name)):
+            os.makedirs(os.path.join(run_dir, name))
+    global_file = os.path.join(run_dir, 'global_param.txt')
+    with open(global_file, 'w') as f:
+        f.write('\n'.join(out) + '\n')
+    return global_file
+
+
+def is_valid(settings, nprocs):
+    '''whether the VIC options of a trial can be combined'''
+    nservers = int(settings.get('IO_SERVERS', 0))
+    nreaders = int(settings.get('FORCE_READERS', 1))
+    if nservers >= nprocs or nreaders > nprocs - nservers:
+        return False
+    if nreaders > 1 and settings.get('FORCE_PREFETCH') == 'TRUE':
+        return False
+    return True
+
+
+class Trials(object):
+    '''trial runs of a configuration, cached by mode and settings'''
+
+    def __init__(self, args, lines, values, knobs):
+        self.args = args
+        self.lines = lines
+        self.values = values
+        self.knobs = knobs
+        self.cache = {}
+        self.records = []
+
+    def run(self, settings, mode, days, label=None):
+        '''record of a trial, with its run time (s) unless it failed'''
+        key = (mode, days, tuple(sorted(settings.items())))
+        if key in self.cache:
+            return self.cache[key]
+
+        run_dir = os.path.join(self.args.output_dir, 'trials',
+                               label or 'trial{0:03d}'.format(
+                                   len(self.records)))
+        if os.path.isdir(run_dir):
+            shutil.rmtree(run_dir)
+        global_file = make_global(self.lines, self.values, settings, mode,
+                                  days, self.knobs, run_dir)
+        log_file = os.path.join(run_dir, 'logs', 'stdout.txt')
+        cmd = [self.args.mpiexec, '-np', str(self.args.nprocs),
+               self.args.vic_exe, '-g', global_file]
+
+        # the fastest of the repeats, to be less sensitive to noise
+        best = None
+        for i in range(self.args.repeats):
+            returncode, wall, peak_total, peak_rank = run_vic(cmd, log_file)
+            tables = parse_timing_profile(log_file)
+            if returncode != 0:
+                best = None
+                break
+            try:
+                run_time = tables['Timing Table']['Run Time']['wall']
+            except KeyError:
+                run_time = wall
+            if best is None or run_time < best[0]:
+                best = (run_time, wall, peak_total, peak_rank, tables)
+
+        record = dict(mode=mode, days=days, settings=dict(settings),
+                      run_dir=run_dir, returncode=returncode)
+        if best:
+            record.update(run_time=best[0], wall_time=best[1],
+                          peak_rss_total_mb=best[2],
+                          peak_rss_rank_mb=best[3])
+            record.update(best[4])
+        self.records.append(record)
+        with open(self.args.results + '.json', 'a') as f:
+            f.write(json.dumps(record, sort_keys=True) + '\n')
+
+        if best:
+            print('  {0:7} {1}: {2:.3f} s'.format(
+                mode, format_settings(settings), best[0]))
+        else:
+            print('  {0:7} {1}: failed, see {2}'.format(
+                mode, format_settings(settings), log_file))
+        self.cache[key] = record
+        return record
+
+
+def format_settings(settings):
+    '''settings on one line'''
+    return ', '.join('{0}={1}'.format(k, v)
+                     for k, v in sorted(settings.items()))
+
+
+def coordinate_search(trials, knobs, settings, args):
+    '''coordinate search of the knobs, each timed in its own mode'''
+    settings = dict(settings)
+    for npass in range(args.max_passes):
+        changed = False
+        for name, mode, stream, candidates in knobs:
+            print('Pass {0}, {1}:'.format(npass + 1, name))
+            best_value = settings[name]
+            best_time = trials.run(settings, mode,
+                                   args.days).get('run_time')
+            for value in candidates:
+                trial = dict(settings)
+                trial[name] = value
+                if value == settings[name] or \
+                        not is_valid(trial, args.nprocs):
+                    continue
+                run_time = trials.run(trial, mode, args.days).get('run_time')
+                if run_time is None:
+                    continue
+                # a new value has to be faster by more than the noise
+                if best_time is None or \
+                        run_time < best_time * (1. - args.threshold):
+                    best_value = value
+                    best_time = run_time
+            if best_value != settings[name]:
+                settings[name] = best_value
+                changed = True
+        if not changed:
+            break
+    return settings
+
+
+def write_snippet(filename, initial, best, knobs, timings):
+    '''write the best settings as a global parameter snippet, with the phase
+    timings of the real configuration as comments'''
+    lines = ['# VIC image driver settings found by run_autotune.py',
+             '# {0}'.format(datetime.datetime.now().isoformat()),
+             '#']
+    for label, tables in timings:
+        if 'run_time' not in tables:
+            lines.append('# {0}: failed'.format(label))
+            continue
+        lines.append('# {0}: {1:g} s run time'.format(label,
+                                                     tables['run_time']))
+        for phase, t in sorted(tables.get('Phase Timing Table', {}).items()):
+            lines.append('#   {0:16} {1:12.4f} s (max over pes)'.format(
+                phase, t['max']))
+    lines.append('')
+    for name, mode, stream, candidates in knobs:
+        if stream:
+            continue
+        line = '{0:17} {1}'.format(name, best[name])
+        if best[name] != initial[name]:
+            line += '  # was {0}'.format(initial[name])
+        lines.append(line)
+    lines.append('')
+    lines.append('# options of each output stream, after its OUTFILE')
+    for name, mode, stream, candidates in knobs:
+        if stream:
+            lines.append('{0:11} {1}'.format(name, best[name]))
+    with open(filename, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+def main():
+    ''' '''
+    ymd = datetime.datetime.now().strftime('%Y%m%d')
+
+    parser = argparse.ArgumentParser(description=description, epilog=epilog,
+                                     formatter_class=CustomFormatter)
+    parser.add_argument('vic_exe', type=str,
+                        help='VIC image driver executable to tune')
+    parser.add_argument('global_param', type=str,
+                        help='global parameter file of the configuration')
+    parser.add_argument('--nprocs', type=int, default=psutil.cpu_count(),
+                        help='number of MPI processes of the runs')
+    parser.add_argument('--days', type=int, default=10,
+                        help='days of simulation of a trial segment')
+    parser.add_argument('--repeats', type=int, default=1,
+                        help='runs of each trial, the fastest one counts')
+    parser.add_argument('--max_passes', type=int, default=3,
+                        help='largest number of passes over the options')
+    parser.add_argument('--threshold', type=float, default=0.02,
+                        help='relative speedup that a new value needs')
+    parser.add_argument('--flush_records', type=int, default=24,
+                        help='count of the FLUSH NRECORDS candidate')
+    parser.add_argument('--skip', type=str, nargs='*', default=[],
+                        help='options that are not searched')
+    parser.add_argument('--output_dir', type=str, default='vic_autotune',
+                        help='directory of the trial runs')
+    parser.add_argument('--results', type=str,
+                        default='vic_autotune_{0}'.format(ymd),
+                        help='prefix of the .json records of the trials and '
+                             'of the .txt snippet of the best settings')
+    parser.add_argument('--mpiexec', type=str,
+                        default=os.getenv('MPIEXEC', 'mpiexec'),
+                        help='MPI launcher')
+    args = parser.parse_args()
+
+    args.vic_exe = os.path.abspath(args.vic_exe)
+    args.output_dir = os.path.abspath(args.output_dir)
+    lines, values = read_global(args.global_param)
+    knobs = get_knobs(args)
+
+    defaults = {'NTHREADS': '1', 'DECOMPOSITION': 'ROUND_ROBIN',
+                'IO_SERVERS': '0', 'FORCE_READERS': '1',
+                'FORCE_PREFETCH': 'FALSE', 'CHUNK': 'DEFAULT',
+                'FLUSH': 'ALWAYS'}
+    initial = {}
+    for name, mode, stream, candidates in knobs:
+        initial[name] = values.get(name, defaults[name])
+    if not is_valid(initial, args.nprocs):
+        print('The settings of {0} are not valid with {1} processes'.format(
+            args.global_param, args.nprocs))
+        return 1
+
+    trials = Trials(args, lines, values, knobs)
+    best = coordinate_search(trials, knobs, initial, args)
+
+    # the real configuration with the initial and the best settings
+    print('Real configuration:')
+    timings = []
+    for label, settings in (('initial', initial), ('best', best)):
+        timings.append((label, trials.run(settings, 'full', args.days,
+                                          label=label)))
+    write_snippet(args.results + '.txt', initial, best, knobs, timings)
+    print('See {0}.txt for the best settings and {0}.json for the '
+          'trials'.format(args.results))
+    return 0 if all('run_time' in r for label, r in timings) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,441 @@
+#!/usr/bin/env python
+'''VIC image driver scaling benchmarks
+
+Runs the image driver on synthetic domains made by replicating the STEHE
+test domain. Strong scaling runs keep the domain fixed and increase the
+number of processes, weak scaling runs grow the domain with the number of
+processes. Both are run with a compute-heavy and an I/O-heavy set of options.
+Each run adds a record with the timers of the VIC timing table and the
+memory high-water marks to a JSON lines file and a CSV file, so that the
+scaling of different versions can be compared with --baseline.
+'''
+
+from __future__ import print_function
+import os
+import re
+import sys
+import csv
+import glob
+import json
+import time
+import socket
+import string
+import argparse
+import datetime
+import subprocess
+
+import psutil
+import xarray as xr
+
+here = os.path.dirname(os.path.abspath(__file__))
+
+description = '''
+                        VIC Scaling Benchmarks
+-------------------------------------------------------------------------------
+Strong and weak MPI scaling of the VIC image driver on replicated STEHE
+domains, with machine readable results.
+-------------------------------------------------------------------------------
+'''
+
+epilog = '''
+-------------------------------------------------------------------------------
+For questions about the development or use of VIC or use of this test module,
+please email the VIC users list serve at vic_users@u.washington.edu.
+-------------------------------------------------------------------------------
+'''
+
+# options that are set in the global parameter file, and the output streams
+# that replace the ones of the template
+option_sets = {
+    'compute': dict(options={'FULL_ENERGY': 'TRUE',
+                             'FROZEN_SOIL': 'TRUE',
+                             'NODES': '10'},
+                    state=False,
+                    output='''OUTFILE     fluxes
+AGGFREQ     NDAYS   1
+OUTVAR      OUT_RUNOFF
+OUTVAR      OUT_BASEFLOW
+OUTVAR      OUT_SWE
+'''),
+    'io': dict(options={'FULL_ENERGY': 'FALSE',
+                        'FROZEN_SOIL': 'FALSE'},
+               state=True,
+               output='''OUTFILE     fluxes
+AGGFREQ     NHOURS   1
+OUTVAR      OUT_PREC
+OUTVAR      OUT_RAINF
+OUTVAR      OUT_SNOWF
+OUTVAR      OUT_AIR_TEMP
+OUTVAR      OUT_SWDOWN
+OUTVAR      OUT_LWDOWN
+OUTVAR      OUT_PRESSURE
+OUTVAR      OUT_WIND
+OUTVAR      OUT_DENSITY
+OUTVAR      OUT_REL_HUMID
+OUTVAR      OUT_QAIR
+OUTVAR      OUT_VP
+OUTVAR      OUT_VPD
+OUTVAR      OUT_RUNOFF
+OUTVAR      OUT_BASEFLOW
+OUTVAR      OUT_EVAP
+OUTVAR      OUT_SWE
+OUTVAR      OUT_SOIL_MOIST
+OUTVAR      OUT_ALBEDO
+OUTVAR      OUT_SOIL_TEMP
+
+OUTFILE     snow
+AGGFREQ     NHOURS   1
+OUTVAR      OUT_SWE
+OUTVAR      OUT_SNOW_DEPTH
+OUTVAR      OUT_SNOW_CANOPY
+OUTVAR      OUT_SNOW_COVER
+OUTVAR      OUT_SNOW_MELT
+''')}
+
+# output keys of the template that are replaced by those of the option set
+output_keys = ('OUTFILE', 'AGGFREQ', 'OUTVAR', 'HISTFREQ', 'OUT_FORMAT',
+               'COMPRESS')
+state_keys = ('STATENAME', 'STATEYEAR', 'STATEMONTH', 'STATEDAY', 'STATESEC')
+
+# tables of the VIC timing profile and the names of their columns
+timing_tables = {'Timing Table': ('wall', 'cpu', 'wall_per_day',
+                                  'cpu_per_day'),
+                 'Phase Timing Table': ('min', 'max', 'mean'),
+                 'I/O Table': ('volume', 'time', 'rate'),
+                 'Solver Table': ('total', 'max'),
+                 'Memory Table': ('min', 'max', 'mean', 'master'),
+                 'Allocation Table': ('total', 'max', 'master')}
+
+
+class CustomFormatter(argparse.ArgumentDefaultsHelpFormatter,
+                      argparse.RawDescriptionHelpFormatter):
+    pass
+
+
+def log2_range(m):
+    '''powers of 2 up to m'''
+    n = 1
+    values = []
+    while n <= m:
+        values.append(n)
+        n *= 2
+    return values
+
+
+def replicate_dataset(ds, n, ncells):
+    '''tile a dataset n times along lon, offsetting the coordinates'''
+    lons = ds['lon'].values
+    if len(lons) > 1:
+        width = (lons[-1] - lons[0]) * len(lons) / (len(lons) - 1)
+    else:
+        width = 1.
+    copies = []
+    for i in range(n):
+        copy = ds.copy(deep=True)
+        copy['lon'] = ds['lon'] + i * width
+        if 'gridcell' in copy:
+            copy['gridcell'] = ds['gridcell'] + i * ncells
+        copies.append(copy)
+    return xr.concat(copies, dim='lon', data_vars='minimal',
+                     coords='minimal')
+
+
+def make_domain(data_dir, out_dir, n):
+    '''write the STEHE domain, parameter and forcing files replicated n
+    times along lon, return their paths and the number of active cells'''
+    stehekin = os.path.join(data_dir, 'image', 'Stehekin')
+    files = {'domain': os.path.join(stehekin, 'parameters',
+                                    'domain.stehekin.20151028.nc'),
+             'parameters': os.path.join(stehekin, 'parameters',
+                                        'Stehekin_test_params_20160327.nc')}
+    forcing_prefix = os.path.join(
+        stehekin, 'forcings', 'Stehekin_image_test.forcings_10days.')
+
+    domain_dir = os.path.join(out_dir, 'domains', 'x{0}'.format(n))
+    new_files = {'forcing': os.path.join(
+        domain_dir, os.path.basename(forcing_prefix))}
+    for key, fname in files.items():
+        new_files[key] = os.path.join(domain_dir, os.path.basename(fname))
+
+    with xr.open_dataset(files['domain']) as ds:
+        ncells = int(ds['mask'].sum())
+    if os.path.isdir(domain_dir):
+        return new_files, n * ncells
+    os.makedirs(domain_dir)
+
+    sources = list(files.items())
+    sources += [('forcing', f) for f in
+                sorted(glob.glob(forcing_prefix + '*.nc'))]
+    for key, fname in sources:
+        with xr.open_dataset(fname) as ds:
+            new = replicate_dataset(ds.load(), n, ncells)
+        new.to_netcdf(os.path.join(domain_dir, os.path.basename(fname)),
+                      format='NETCDF4_CLASSIC')
+
+    return new_files, n * ncells
+
+
+def make_global(template, option_set, files, out_dir):
+    '''write a global parameter file for a domain and an option set'''
+    with open(template, 'r') as f:
+        s = string.Template(f.read())
+    text = s.safe_substitute(result_dir=os.path.join(out_dir, 'results'),
+                             state_dir=os.path.join(out_dir, 'state'))
+
+    lines = []
+    for line in text.splitlines():
+        words = line.split()
+        key = words[0] if words else ''
+        if key in output_keys:
+            continue
+        if key in state_keys and not option_set['state']:
+            continue
+        if key == 'DOMAIN':
+            line = 'DOMAIN {0}'.format(files['domain'])
+        elif key == 'PARAMETERS':
+            line = 'PARAMETERS {0}'.format(files['parameters'])
+        elif key == 'FORCING1':
+            line = 'FORCING1 {0}'.format(files['forcing'])
+        elif key in option_set['options']:
+            line = '{0} {1}'.format(key, option_set['options'][key])
+        lines.append(line)
+    present = set(line.split()[0] for line in lines if line.split())
+    for key, value in option_set['options'].items():
+        if key not in present:
+            lines.append('{0} {1}'.format(key, value))
+    lines.append('')
+    lines.append(option_set['output'])
+
+    for name in ('results', 'state', 'logs'):
+        if not os.path.isdir(os.path.join(out_dir, name)):
+            os.makedirs(os.path.join(out_dir, name))
+    global_file = os.path.join(out_dir, 'global_param.txt')
+    with open(global_file, 'w') as f:
+        f.write('\n'.join(lines))
+    return global_file
+
+
+def run_vic(cmd, log_file, interval=0.1):
+    '''run VIC, sampling the resident memory of its processes
+
+    Returns the return code, the wall time, and the high-water marks of the
+    memory of all processes and of the largest process in MB.
+    '''
+    peak_total = 0
+    peak_rank = 0
+    start = time.time()
+    with open(log_file, 'w') as log:
+        proc = subprocess.Popen(cmd, stdout=log, stderr=subprocess.STDOUT)
+        parent = psutil.Process(proc.pid)
+        while proc.poll() is None:
+            rss = []
+            try:
+                for p in [parent] + parent.children(recursive=True):
+                    if 'vic' in p.name().lower():
+                        rss.append(p.memory_info().rss)
+            except psutil.Error:
+                pass
+            if rss:
+                peak_total = max(peak_total, sum(rss))
+                peak_rank = max(peak_rank, max(rss))
+            time.sleep(interval)
+    wall = time.time() - start
+    return proc.returncode, wall, peak_total / 2.**20, peak_rank / 2.**20
+
+
+def parse_timing_profile(log_file):
+    '''read the tables of the VIC timing profile from a log file'''
+    row = re.compile(r'^\|\s*([A-Za-z+][^|]*?)\s*\|((?:\s*[-+0-9.eE]+\s*\|)+)'
+                     r'\s*$')
+    tables = {}
+    table = None
+    with open(log_file, 'r') as f:
+        for line in f:
+            heading = line.strip().split('(')[0].rstrip(' :')
+            if heading in timing_tables:
+                table = heading
+                tables[table] = {}
+                continue
+            match = row.match(line)
+            if table and match:
+                values = [float(v) for v in
+                          match.group(2).strip(' |').split('|')]
+                tables[table][match.group(1)] = dict(
+                    zip(timing_tables[table], values))
+            elif table and line.strip() and not line.startswith('|'):
+                table = None
+    return tables
+
+
+def flatten(record, prefix=''):
+    '''flatten the nested dictionaries of a record for the CSV file'''
+    flat = {}
+    for key, value in record.items():
+        name = prefix + re.sub(r'\W+', '_', key).strip('_').lower()
+        if isinstance(value, dict):
+            flat.update(flatten(value, name + '.'))
+        else:
+            flat[name] = value
+    return flat
+
+
+def get_git_version():
+    '''git version of the test suite'''
+    try:
+        return subprocess.check_output(
+            ['git', 'describe', '--abbrev=4', '--dirty', '--always',
+             '--tags'], cwd=here).decode().strip()
+    except (subprocess.CalledProcessError, OSError):
+        return 'unknown'
+
+
+def scaling_runs(args):
+    '''list the runs as (kind, option set, processes, replicates)'''
+    runs = []
+    procs = log2_range(args.max_procs)
+    for option_set in args.option_sets:
+        if args.kind in ('strong', 'both'):
+            runs += [('strong', option_set, n, args.replicates)
+                     for n in procs]
+        if args.kind in ('weak', 'both'):
+            runs += [('weak', option_set, n, n * args.weak_replicates)
+                     for n in procs]
+    return runs
+
+
+def compare_baseline(records, baseline_file, tolerance):
+    '''print the change of the run times from a baseline, return the number
+    of runs that are slower by more than tolerance'''
+    baseline = {}
+    with open(baseline_file, 'r') as f:
+        for line in f:
+            if line.strip():
+                r = json.loads(line)
+                baseline[(r['kind'], r['option_set'], r['nprocs'],
+                          r['replicates'])] = r
+    nslow = 0
+    print('{0:7} | {1:8} | {2:6} | {3:10} | {4:10} | {5:8}'.format(
+        'Kind', 'Options', 'Cores', 'Time (s)', 'Baseline', 'Change'))
+    for r in records:
+        key = (r['kind'], r['option_set'], r['nprocs'], r['replicates'])
+        if key not in baseline or r['returncode'] != 0:
+            continue
+        ref = baseline[key]['wall_time']
+        change = r['wall_time'] / ref - 1.
+        flag = ''
+        if change > tolerance:
+            flag = ' REGRESSION'
+            nslow += 1
+        print('{0:7} | {1:8} | {2:6} | {3:10.2f} | {4:10.2f} | '
+              '{5:+7.1%}{6}'.format(r['kind'], r['option_set'], r['nprocs'],
+                                   r['wall_time'], ref, change, flag))
+    return nslow
+
+
+def main():
+    ''' '''
+    ymd = datetime.datetime.now().strftime('%Y%m%d')
+
+    parser = argparse.ArgumentParser(description=description, epilog=epilog,
+                                     formatter_class=CustomFormatter)
+    parser.add_argument('vic_exe', type=str,
+                        help='VIC image driver executable to test')
+    parser.add_argument('--data_dir', type=str, required=True,
+                        help='data directory of the VIC sample data')
+    parser.add_argument('--template', type=str,
+                        default=os.path.join(here, '..', 'system',
+                                             'global.image.STEHE.txt'),
+                        help='global parameter file template')
+    parser.add_argument('--output_dir', type=str, default='vic_scaling',
+                        help='directory of the domains and of the runs')
+    parser.add_argument('--results', type=str,
+                        default='vic_scaling_{0}'.format(ymd),
+                        help='prefix of the .json and .csv result files')
+    parser.add_argument('--kind', type=str, default='both',
+                        choices=['strong', 'weak', 'both'],
+                        help='kind of scaling runs')
+    parser.add_argument('--option_sets', type=str, nargs='+',
+                        default=sorted(option_sets.keys()),
+                        choices=sorted(option_sets.keys()),
+                        help='option sets of the runs')
+    parser.add_argument('--max_procs', type=int,
+                        default=psutil.cpu_count(),
+                        help='largest number of processes, the runs use '
+                             'the powers of 2 up to it')
+    parser.add_argument('--replicates', type=int, default=None,
+                        help='copies of the STEHE domain in the strong '
+                             'scaling runs [max_procs]')
+    parser.add_argument('--weak_replicates', type=int, default=1,
+                        help='copies of the STEHE domain per process in the '
+                             'weak scaling runs')
+    parser.add_argument('--mpiexec', type=str,
+                        default=os.getenv('MPIEXEC', 'mpiexec'),
+                        help='MPI launcher')
+    parser.add_argument('--baseline', type=str, default=None,
+                        help='JSON results of an earlier version to '
+                             'compare the run times with')
+    parser.add_argument('--tolerance', type=float, default=0.1,
+                        help='relative slowdown flagged as a regression')
+    parser.add_argument('--test', action='store_true',
+                        help='list the runs but do not run VIC')
+    args = parser.parse_args()
+    if args.replicates is None:
+        args.replicates = args.max_procs
+
+    vic_exe = os.path.abspath(args.vic_exe)
+    out_dir = os.path.abspath(args.output_dir)
+    runs = scaling_runs(args)
+    if args.test:
+        for run in runs:
+            print('{0} scaling, {1} options: {2} processes, {3} copies of '
+                  'STEHE'.format(*run))
+        return 0
+
+    header = dict(date=datetime.datetime.now().isoformat(),
+                  hostname=socket.gethostname(),
+                  git_version=get_git_version(), vic_exe=vic_exe)
+    records = []
+    for kind, option_set, nprocs, replicates in runs:
+        files, ncells = make_domain(os.path.abspath(args.data_dir), out_dir,
+                                    replicates)
+        run_dir = os.path.join(out_dir, 'runs', '{0}_{1}_np{2}_x{3}'.format(
+            kind, option_set, nprocs, replicates))
+        global_file = make_global(args.template, option_sets[option_set],
+                                  files, run_dir)
+        log_file = os.path.join(run_dir, 'logs', 'stdout.txt')
+        print('Running {0} scaling, {1} options, {2} processes, {3} '
+              'cells'.format(kind, option_set, nprocs, ncells))
+
+        cmd = [args.mpiexec, '-np', str(nprocs), vic_exe, '-g', global_file]
+        returncode, wall, peak_total, peak_rank = run_vic(cmd, log_file)
+        if returncode != 0:
+            print('  failed, see {0}'.format(log_file))
+
+        record = dict(header)
+        record.update(kind=kind, option_set=option_set, nprocs=nprocs,
+                      replicates=replicates, ncells=ncells,
+                      returncode=returncode, wall_time=wall,
+                      peak_rss_total_mb=peak_total,
+                      peak_rss_rank_mb=peak_rank)
+        record.update(parse_timing_profile(log_file))
+        records.append(record)
+        with open(args.results + '.json', 'a') as f:
+            f.write(json.dumps(record, sort_keys=True) + '\n')
+
+    # the CSV file has the columns of all the runs of this invocation
+    rows = [flatten(r) for r in records]
+    fieldnames = sorted(set(k for row in rows for k in row))
+    with open(args.results + '.csv', 'w') as f:
+        writer = csv.DictWriter(f, fieldnames=fieldnames)
+        writer.writeheader()
+        writer.writerows(rows)
+    print('See {0}.json and {0}.csv for the results'.format(args.results))
+
+    nfailed = sum(r['returncode'] != 0 for r in records)
+    if args.baseline:
+        nfailed += compare_baseline(records, args.baseline, args.tolerance)
+    return 1 if nfailed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,846 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Microbenchmarks of the physics kernels of vic_run.
+ *
+ * vic_bench runs the classic driver on a global parameter file and times the
+ * kernels on the inputs they get during that run. The kernels are wrapped at
+ * link time (ld --wrap, see `make bench` in the classic driver Makefile):
+ *
+ * - svp and penman are pure functions. Their arguments are recorded during
+ *   the run and replayed in a tight loop afterwards.
+ * - The other kernels change their arguments. Every BENCH_STRIDE-th call is
+ *   timed in place: the state the kernel changes is saved, the kernel is run
+ *   BENCH_REPS times, restoring the state before each repetition, and the
+ *   time of the restores alone is subtracted. The call of the model then
+ *   runs on the restored state.
+ *
+ * Kernels called while another kernel is timed are not timed themselves, so
+ * the time of root_brent_ctx includes the evaluations of
+ * func_surf_energy_bal and the kernels they call. The results are reported
+ * in ns/call and calls/s and can be saved as a baseline, against which later
+ * runs flag regressions.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_classic.h>
+
+// the classic driver is built with -Dmain=vic_classic_main
+#undef main
+
+#define BENCH_MAX_RECORDS 1000000 /**< recorded calls of the pure kernels */
+
+/******************************************************************************
+ * @brief   Kernels timed by vic_bench.
+ *****************************************************************************/
+enum bench_kernels
+{
+    BENCH_SVP,
+    BENCH_PENMAN,
+    BENCH_ARNO_EVAP,
+    BENCH_RUNOFF,
+    BENCH_SURF_ENERGY_BAL,
+    BENCH_SOLVE_T_PROFILE,
+    BENCH_SOLVE_T_PROFILE_IMPLICIT,
+    BENCH_SNOW_MELT,
+    BENCH_SOLVE_LAKE,
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_BENCH_KERNELS
+};
+
+/******************************************************************************
+ * @brief   Timing of a kernel.
+ *****************************************************************************/
+typedef struct {
+    const char *name;     /**< name of the kernel */
+    size_t calls;         /**< calls during the run of the model */
+    size_t samples;       /**< timed calls */
+    size_t reps;          /**< timed repetitions */
+    double seconds;       /**< time of the repetitions */
+    double baseline;      /**< ns/call of the baseline, 0 = none */
+} bench_kernel_struct;
+
+/******************************************************************************
+ * @brief   Arguments of a recorded call of penman.
+ *****************************************************************************/
+typedef struct {
+    double tair;
+    double elevation;
+    double rad;
+    double vpd;
+    double ra;
+    double rc;
+    double rarc;
+} bench_penman_args;
+
+static bench_kernel_struct kernels[N_BENCH_KERNELS] = {
+    {"svp", 0, 0, 0, 0., 0.},
+    {"penman", 0, 0, 0, 0., 0.},
+    {"arno_evap", 0, 0, 0, 0., 0.},
+    {"runoff", 0, 0, 0, 0., 0.},
+    {"root_brent_ctx", 0, 0, 0, 0., 0.},
+    {"solve_T_profile", 0, 0, 0, 0., 0.},
+    {"solve_T_profile_implicit", 0, 0, 0, 0., 0.},
+    {"snow_melt", 0, 0, 0, 0., 0.},
+    {"solve_lake", 0, 0, 0, 0., 0.}
+};
+
+static size_t             bench_stride = 10;
+static size_t             bench_reps = 20;
+static bool               bench_busy = false;
+static double            *svp_args = NULL;
+static size_t             svp_nargs = 0;
+static bench_penman_args *penman_args = NULL;
+static size_t             penman_nargs = 0;
+static volatile double    bench_sink;
+
+int vic_classic_main(int argc, char *argv[]);
+
+double __real_arno_evap(layer_data_struct *, double, double, double, double,
+                        double, double, double, double, double, double,
+                        double *);
+double __real_penman(double, double, double, double, double, double, double);
+double __real_root_brent_ctx(double, double, double (*)(double, void *),
+                             void *);
+int __real_runoff(cell_data_struct *, energy_bal_struct *, soil_con_struct *,
+                  double, double *, int);
+int __real_snow_melt(double, double, double, double, double *, double,
+                     double *, double, double, double, double, double, double,
+                     double, double, double, double, double, double, double,
+                     double *, double *, double *, double *, double *,
+                     double *, double *, double *, double *, double *,
+                     double *, double *, int, int, int, snow_data_struct *);
+int __real_solve_lake(double, double, double, double, double, double, double,
+                      double, double, double, lake_var_struct *,
+                      soil_con_struct, double, double, dmy_struct, double);
+int __real_solve_T_profile(double *, double *, char *, unsigned int *,
+                           double *, double *, double *, double *, double,
+                           double *, double *, double *, double *, double *,
+                           double *, double *, double, int,
+                           soil_thermal_struct *, int, int, int);
+int __real_solve_T_profile_implicit(double *, double *, char *,
+                                    unsigned int *, double *, double *,
+                                    double *, double *, double, double *,
+                                    double *, double *, double *, double *,
+                                    double *, double *, double, int,
+                                    soil_thermal_struct *, int, int, double *,
+                                    double *, double *, double *, double *,
+                                    double *, double *);
+double __real_svp(double);
+
+/******************************************************************************
+ * @brief    Monotonic time in seconds.
+ *****************************************************************************/
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + 1.e-9 * (double) ts.tv_nsec;
+}
+
+/******************************************************************************
+ * @brief    Count a call of a kernel and decide whether to time it.
+ *****************************************************************************/
+static bool
+bench_sample(enum bench_kernels kernel)
+{
+    // calls made by a kernel that is being timed are not calls of the model
+    if (bench_busy) {
+        return false;
+    }
+    kernels[kernel].calls++;
+    return (kernels[kernel].calls - 1) % bench_stride == 0;
+}
+
+/******************************************************************************
+ * @brief    Time bench_reps repetitions of CALL in place.
+ * @details  RESTORE restores the state that CALL changes. It is run before
+ *           every repetition and once more at the end, and its time is
+ *           subtracted.
+ *****************************************************************************/
+#define BENCH_REPEAT(kernel, RESTORE, CALL) \
+    do { \
+        size_t bench_r; \
+        double bench_t0; \
+        double bench_t1; \
+        bench_busy = true; \
+        bench_t0 = bench_now(); \
+        for (bench_r = 0; bench_r < bench_reps; bench_r++) { \
+            RESTORE; \
+            CALL; \
+        } \
+        bench_t1 = bench_now(); \
+        for (bench_r = 0; bench_r < bench_reps; bench_r++) { \
+            RESTORE; \
+            __asm__ __volatile__ ("" : : : "memory"); \
+        } \
+        kernels[kernel].seconds += (bench_t1 - bench_t0) - \
+                                   (bench_now() - bench_t1); \
+        kernels[kernel].samples++; \
+        kernels[kernel].reps += bench_reps; \
+        RESTORE; \
+        bench_busy = false; \
+    } while (0)
+
+/******************************************************************************
+ * @brief    Record the argument of svp.
+ *****************************************************************************/
+double
+__wrap_svp(double temp)
+{
+    if (bench_sample(BENCH_SVP) && svp_nargs < BENCH_MAX_RECORDS) {
+        svp_args[svp_nargs++] = temp;
+    }
+    return __real_svp(temp);
+}
+
+/******************************************************************************
+ * @brief    Record the arguments of penman.
+ *****************************************************************************/
+double
+__wrap_penman(double tair,
+              double elevation,
+              double rad,
+              double vpd,
+              double ra,
+              double rc,
+              double rarc)
+{
+    bench_penman_args *args;
+
+    if (bench_sample(BENCH_PENMAN) && penman_nargs < BENCH_MAX_RECORDS) {
+        args = &(penman_args[penman_nargs++]);
+        args->tair = tair;
+        args->elevation = elevation;
+        args->rad = rad;
+        args->vpd = vpd;
+        args->ra = ra;
+        args->rc = rc;
+        args->rarc = rarc;
+    }
+    return __real_penman(tair, elevation, rad, vpd, ra, rc, rarc);
+}
+
+/******************************************************************************
+ * @brief    Time arno_evap in place.
+ *****************************************************************************/
+double
+__wrap_arno_evap(layer_data_struct *layer,
+                 double             rad,
+                 double             air_temp,
+                 double             vpd,
+                 double             depth1,
+                 double             max_moist,
+                 double             elevation,
+                 double             b_infilt,
+                 double             ra,
+                 double             delta_t,
+                 double             moist_resid,
+                 double            *frost_fract)
+{
+    extern option_struct options;
+
+    layer_data_struct    save[MAX_LAYERS];
+    size_t               nbytes = options.Nlayer * sizeof(*layer);
+
+    if (bench_sample(BENCH_ARNO_EVAP)) {
+        memcpy(save, layer, nbytes);
+        BENCH_REPEAT(BENCH_ARNO_EVAP, memcpy(layer, save, nbytes),
+                     __real_arno_evap(layer, rad, air_temp, vpd, depth1,
+                                      max_moist, elevation, b_infilt, ra,
+                                      delta_t, moist_resid, frost_fract));
+    }
+    return __real_arno_evap(layer, rad, air_temp, vpd, depth1, max_moist,
+                            elevation, b_infilt, ra, delta_t, moist_resid,
+                            frost_fract);
+}
+
+/******************************************************************************
+ * @brief    Time runoff in place.
+ *****************************************************************************/
+int
+__wrap_runoff(cell_data_struct  *cell,
+              energy_bal_struct *energy,
+              soil_con_struct   *soil_con,
+              double             ppt,
+              double            *frost_fract,
+              int                Nnodes)
+{
+    cell_data_struct  save_cell;
+    energy_bal_struct save_energy;
+
+    if (bench_sample(BENCH_RUNOFF)) {
+        save_cell = *cell;
+        save_energy = *energy;
+        BENCH_REPEAT(BENCH_RUNOFF,
+                     (*cell = save_cell, *energy = save_energy),
+                     __real_runoff(cell, energy, soil_con, ppt, frost_fract,
+                                   Nnodes));
+    }
+    return __real_runoff(cell, energy, soil_con, ppt, frost_fract, Nnodes);
+}
+
+/******************************************************************************
+ * @brief    Time the surface energy balance solutions of root_brent_ctx in
+ *           place.
+ * @details  The residual only depends on the state at the start of the
+ *           iteration, so the solution is repeated without restoring.
+ *****************************************************************************/
+double
+__wrap_root_brent_ctx(double LowerBound,
+                      double UpperBound,
+                      double (*Function)(double, void *),
+                      void  *ctx)
+{
+    if (Function == func_surf_energy_bal_ctx &&
+        bench_sample(BENCH_SURF_ENERGY_BAL)) {
+        BENCH_REPEAT(BENCH_SURF_ENERGY_BAL, (void) 0,
+                     bench_sink = __real_root_brent_ctx(LowerBound,
+                                                        UpperBound, Function,
+                                                        ctx));
+    }
+    return __real_root_brent_ctx(LowerBound, UpperBound, Function, ctx);
+}
+
+/******************************************************************************
+ * @brief    Time the explicit soil temperature solution in place.
+ *****************************************************************************/
+int
+__wrap_solve_T_profile(double              *T,
+                       double              *T0,
+                       char                *Tfbflag,
+                       unsigned            *Tfbcount,
+                       double              *Zsum,
+                       double              *kappa,
+                       double              *Cs,
+                       double              *moist,
+                       double               deltat,
+                       double              *max_moist,
+                       double              *bubble,
+                       double              *expt,
+                       double              *ice,
+                       double              *alpha,
+                       double              *beta,
+                       double              *gamma,
+                       double               Dp,
+                       int                  Nnodes,
+                       soil_thermal_struct *soil_thermal,
+                       int                  FS_ACTIVE,
+                       int                  NOFLUX,
+                       int                  EXP_TRANS)
+{
+    double              save_T[MAX_NODES];
+    char                save_Tfbflag[MAX_NODES];
+    unsigned            save_Tfbcount[MAX_NODES];
+    soil_thermal_struct save_thermal;
+    size_t              n = (size_t) Nnodes;
+
+    if (bench_sample(BENCH_SOLVE_T_PROFILE)) {
+        memcpy(save_T, T, n * sizeof(*T));
+        memcpy(save_Tfbflag, Tfbflag, n * sizeof(*Tfbflag));
+        memcpy(save_Tfbcount, Tfbcount, n * sizeof(*Tfbcount));
+        save_thermal = *soil_thermal;
+        BENCH_REPEAT(BENCH_SOLVE_T_PROFILE,
+                     (memcpy(T, save_T, n * sizeof(*T)),
+                      memcpy(Tfbflag, save_Tfbflag, n * sizeof(*Tfbflag)),
+                      memcpy(Tfbcount, save_Tfbcount, n * sizeof(*Tfbcount)),
+                      *soil_thermal = save_thermal),
+                     __real_solve_T_profile(T, T0, Tfbflag, Tfbcount, Zsum,
+                                            kappa, Cs, moist, deltat,
+                                            max_moist, bubble, expt, ice,
+                                            alpha, beta, gamma, Dp, Nnodes,
+                                            soil_thermal, FS_ACTIVE, NOFLUX,
+                                            EXP_TRANS));
+    }
+    return __real_solve_T_profile(T, T0, Tfbflag, Tfbcount, Zsum, kappa, Cs,
+                                  moist, deltat, max_moist, bubble, expt, ice,
+                                  alpha, beta, gamma, Dp, Nnodes, soil_thermal,
+                                  FS_ACTIVE, NOFLUX, EXP_TRANS);
+}
+
+/******************************************************************************
+ * @brief    Time the implicit soil temperature solution in place.
+ *****************************************************************************/
+int
+__wrap_solve_T_profile_implicit(double              *T,
+                                double              *T0,
+                                char                *Tfbflag,
+                                unsigned            *Tfbcount,
+                                double              *Zsum,
+                                double              *kappa,
+                                double              *Cs,
+                                double              *moist,
+                                double               deltat,
+                                double              *max_moist,
+                                double              *bubble,
+                                double              *expt,
+                                double              *ice,
+                                double              *alpha,
+                                double              *beta,
+                                double              *gamma,
+                                double               Dp,
+                                int                  Nnodes,
+                                soil_thermal_struct *soil_thermal,
+                                int                  NOFLUX,
+                                int                  EXP_TRANS,
+                                double              *bulk_dens_min,
+                                double              *soil_dens_min,
+                                double              *quartz,
+                                double              *bulk_density,
+                                double              *soil_density,
+                                double              *organic,
+                                double              *depth)
+{
+    double              save_T[MAX_NODES];
+    double              save_kappa[MAX_NODES];
+    double              save_Cs[MAX_NODES];
+    double              save_ice[MAX_NODES];
+    char                save_Tfbflag[MAX_NODES];
+    unsigned            save_Tfbcount[MAX_NODES];
+    soil_thermal_struct save_thermal;
+    size_t              n = (size_t) Nnodes;
+
+    if (bench_sample(BENCH_SOLVE_T_PROFILE_IMPLICIT)) {
+        memcpy(save_T, T, n * sizeof(*T));
+        memcpy(save_kappa, kappa, n * sizeof(*kappa));
+        memcpy(save_Cs, Cs, n * sizeof(*Cs));
+        memcpy(save_ice, ice, n * sizeof(*ice));
+        memcpy(save_Tfbflag, Tfbflag, n * sizeof(*Tfbflag));
+        memcpy(save_Tfbcount, Tfbcount, n * sizeof(*Tfbcount));
+        save_thermal = *soil_thermal;
+        BENCH_REPEAT(BENCH_SOLVE_T_PROFILE_IMPLICIT,
+                     (memcpy(T, save_T, n * sizeof(*T)),
+                      memcpy(kappa, save_kappa, n * sizeof(*kappa)),
+                      memcpy(Cs, save_Cs, n * sizeof(*Cs)),
+                      memcpy(ice, save_ice, n * sizeof(*ice)),
+                      memcpy(Tfbflag, save_Tfbflag, n * sizeof(*Tfbflag)),
+                      memcpy(Tfbcount, save_Tfbcount, n * sizeof(*Tfbcount)),
+                      *soil_thermal = save_thermal),
+                     __real_solve_T_profile_implicit(T, T0, Tfbflag,
+                                                     Tfbcount, Zsum, kappa,
+                                                     Cs, moist, deltat,
+                                                     max_moist, bubble, expt,
+                                                     ice, alpha, beta, gamma,
+                                                     Dp, Nnodes, soil_thermal,
+                                                     NOFLUX, EXP_TRANS,
+                                                     bulk_dens_min,
+                                                     soil_dens_min, quartz,
+                                                     bulk_density,
+                                                     soil_density, organic,
+                                                     depth));
+    }
+    return __real_solve_T_profile_implicit(T, T0, Tfbflag, Tfbcount, Zsum,
+                                           kappa, Cs, moist, deltat,
+                                           max_moist, bubble, expt, ice,
+                                           alpha, beta, gamma, Dp, Nnodes,
+                                           soil_thermal, NOFLUX, EXP_TRANS,
+                                           bulk_dens_min, soil_dens_min,
+                                           quartz, bulk_density, soil_density,
+                                           organic, depth);
+}
+
+/******************************************************************************
+ * @brief    Time snow_melt in place.
+ *****************************************************************************/
+int
+__wrap_snow_melt(double            Le,
+                 double            NetShortSnow,
+                 double            Tcanopy,
+                 double            Tgrnd,
+                 double           *Z0,
+                 double            aero_resist,
+                 double           *aero_resist_used,
+                 double            air_temp,
+                 double            coverage,
+                 double            delta_t,
+                 double            density,
+                 double            grnd_flux,
+                 double            LongSnowIn,
+                 double            pressure,
+                 double            rainfall,
+                 double            snowfall,
+                 double            vp,
+                 double            vpd,
+                 double            wind,
+                 double            z2,
+                 double           *NetLongSnow,
+                 double           *OldTSurf,
+                 double           *melt,
+                 double           *save_Qnet,
+                 double           *save_advected_sensible,
+                 double           *save_advection,
+                 double           *save_deltaCC,
+                 double           *save_grnd_flux,
+                 double           *save_latent,
+                 double           *save_latent_sub,
+                 double           *save_refreeze_energy,
+                 double           *save_sensible,
+                 int               UNSTABLE_SNOW,
+                 int               iveg,
+                 int               band,
+                 snow_data_struct *snow)
+{
+    snow_data_struct save_snow;
+    double           save_ra_used;
+    double           save_OldTSurf;
+
+    if (bench_sample(BENCH_SNOW_MELT)) {
+        // the other pointer arguments are only written
+        save_snow = *snow;
+        save_ra_used = *aero_resist_used;
+        save_OldTSurf = *OldTSurf;
+        BENCH_REPEAT(BENCH_SNOW_MELT,
+                     (*snow = save_snow, *aero_resist_used = save_ra_used,
+                      *OldTSurf = save_OldTSurf),
+                     __real_snow_melt(Le, NetShortSnow, Tcanopy, Tgrnd, Z0,
+                                      aero_resist, aero_resist_used,
+                                      air_temp, coverage, delta_t, density,
+                                      grnd_flux, LongSnowIn, pressure,
+                                      rainfall, snowfall, vp, vpd, wind, z2,
+                                      NetLongSnow, OldTSurf, melt, save_Qnet,
+                                      save_advected_sensible, save_advection,
+                                      save_deltaCC, save_grnd_flux,
+                                      save_latent, save_latent_sub,
+                                      save_refreeze_energy, save_sensible,
+                                      UNSTABLE_SNOW, iveg, band, snow));
+    }
+    return __real_snow_melt(Le, NetShortSnow, Tcanopy, Tgrnd, Z0, aero_resist,
+                            aero_resist_used, air_temp, coverage, delta_t,
+                            density, grnd_flux, LongSnowIn, pressure,
+                            rainfall, snowfall, vp, vpd, wind, z2,
+                            NetLongSnow, OldTSurf, melt, save_Qnet,
+                            save_advected_sensible, save_advection,
+                            save_deltaCC, save_grnd_flux, save_latent,
+                            save_latent_sub, save_refreeze_energy,
+                            save_sensible, UNSTABLE_SNOW, iveg, band, snow);
+}
+
+/******************************************************************************
+ * @brief    Time solve_lake in place.
+ *****************************************************************************/
+int
+__wrap_solve_lake(double           snowfall,
+                  double           rainfall,
+                  double           tair,
+                  double           wind,
+                  double           vp,
+                  double           shortin,
+                  double           longin,
+                  double           vpd,
+                  double           pressure,
+                  double           air_density,
+                  lake_var_struct *lake,
+                  soil_con_struct  soil_con,
+                  double           dt,
+                  double           wind_h,
+                  dmy_struct       dmy,
+                  double           fracprv)
+{
+    static lake_var_struct save_lake;
+
+    if (bench_sample(BENCH_SOLVE_LAKE)) {
+        save_lake = *lake;
+        BENCH_REPEAT(BENCH_SOLVE_LAKE, *lake = save_lake,
+                     __real_solve_lake(snowfall, rainfall, tair, wind, vp,
+                                       shortin, longin, vpd, pressure,
+                                       air_density, lake, soil_con, dt,
+                                       wind_h, dmy, fracprv));
+    }
+    return __real_solve_lake(snowfall, rainfall, tair, wind, vp, shortin,
+                             longin, vpd, pressure, air_density, lake,
+                             soil_con, dt, wind_h, dmy, fracprv);
+}
+
+/******************************************************************************
+ * @brief    Replay the recorded calls of the pure kernels.
+ *****************************************************************************/
+static void
+replay_pure_kernels(void)
+{
+    size_t             i;
+    size_t             r;
+    double             t0;
+    double             sum = 0.;
+    bench_penman_args *args;
+
+    t0 = bench_now();
+    for (r = 0; r < bench_reps; r++) {
+        for (i = 0; i < svp_nargs; i++) {
+            sum += __real_svp(svp_args[i]);
+        }
+    }
+    kernels[BENCH_SVP].seconds = bench_now() - t0;
+    kernels[BENCH_SVP].samples = svp_nargs;
+    kernels[BENCH_SVP].reps = bench_reps * svp_nargs;
+
+    t0 = bench_now();
+    for (r = 0; r < bench_reps; r++) {
+        for (i = 0; i < penman_nargs; i++) {
+            args = &(penman_args[i]);
+            sum += __real_penman(args->tair, args->elevation, args->rad,
+                                 args->vpd, args->ra, args->rc, args->rarc);
+        }
+    }
+    kernels[BENCH_PENMAN].seconds = bench_now() - t0;
+    kernels[BENCH_PENMAN].samples = penman_nargs;
+    kernels[BENCH_PENMAN].reps = bench_reps * penman_nargs;
+
+    bench_sink = sum;
+}
+
+/******************************************************************************
+ * @brief    Time per call of a kernel in ns, 0 if it was not timed.
+ *****************************************************************************/
+static double
+ns_per_call(bench_kernel_struct *kernel)
+{
+    if (kernel->reps == 0 || kernel->seconds <= 0.) {
+        return 0.;
+    }
+    return kernel->seconds * 1.e9 / (double) kernel->reps;
+}
+
+/******************************************************************************
+ * @brief    Read the ns/call of the kernels from a baseline file.
+ * @return   false if the file does not exist
+ *****************************************************************************/
+static bool
+read_baseline(char *filename)
+{
+    FILE  *fp;
+    char   line[MAXSTRING];
+    char   name[MAXSTRING];
+    double ns;
+    size_t i;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    while (fgets(line, MAXSTRING, fp) != NULL) {
+        if (line[0] == '#' || sscanf(line, "%s %lf", name, &ns) != 2) {
+            continue;
+        }
+        for (i = 0; i < N_BENCH_KERNELS; i++) {
+            if (strcmp(name, kernels[i].name) == 0) {
+                kernels[i].baseline = ns;
+            }
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Write the ns/call of the kernels to a baseline file.
+ *****************************************************************************/
+static void
+write_baseline(char *filename,
+               char *global)
+{
+    FILE  *fp;
+    size_t i;
+
+    fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "vic_bench: unable to write %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(fp, "# vic_bench baseline of %s\n", global);
+    fprintf(fp, "# kernel ns/call\n");
+    for (i = 0; i < N_BENCH_KERNELS; i++) {
+        if (kernels[i].reps > 0) {
+            fprintf(fp, "%s %.6g\n", kernels[i].name,
+                    ns_per_call(&(kernels[i])));
+        }
+    }
+    fclose(fp);
+}
+
+/******************************************************************************
+ * @brief    Print the results and count the regressions.
+ * @return   number of kernels that are slower than the baseline by more than
+ *           tolerance
+ *****************************************************************************/
+static size_t
+report(double tolerance)
+{
+    size_t i;
+    size_t nslow = 0;
+    double ns;
+    double change;
+
+    printf("\n");
+    printf("------------------------------"
+           " VIC KERNEL BENCHMARKS "
+           "------------------------------\n\n");
+    printf("  Repetitions per sample : %zu\n", bench_reps);
+    printf("  Timed call stride      : %zu\n\n", bench_stride);
+    printf("| %-24s | %12s | %10s | %12s | %14s | %12s | %8s |\n",
+           "Kernel", "Model Calls", "Samples", "ns/call", "calls/s",
+           "Baseline", "Change");
+    printf("|--------------------------|--------------|------------|"
+           "--------------|----------------|--------------|----------|\n");
+    for (i = 0; i < N_BENCH_KERNELS; i++) {
+        if (kernels[i].reps == 0) {
+            printf("| %-24s | %12zu | %10s | %12s | %14s | %12s | %8s |\n",
+                   kernels[i].name, kernels[i].calls, "-", "not called", "-",
+                   "-", "-");
+            continue;
+        }
+        ns = ns_per_call(&(kernels[i]));
+        printf("| %-24s | %12zu | %10zu | %12.1f | %14.4g | ",
+               kernels[i].name, kernels[i].calls, kernels[i].samples, ns,
+               ns > 0. ? 1.e9 / ns : 0.);
+        if (kernels[i].baseline > 0.) {
+            change = ns / kernels[i].baseline - 1.;
+            printf("%12.1f | %+7.1f%% |", kernels[i].baseline,
+                   100. * change);
+            if (change > tolerance) {
+                printf(" REGRESSION");
+                nslow++;
+            }
+            printf("\n");
+        }
+        else {
+            printf("%12s | %8s |\n", "-", "-");
+        }
+    }
+    printf("\n");
+
+    return nslow;
+}
+
+/******************************************************************************
+ * @brief    Print the usage of vic_bench.
+ *****************************************************************************/
+static void
+bench_usage(char *executable)
+{
+    fprintf(stderr,
+            "Usage: %s -g <global_parameter_file> [-r <reps>] "
+            "[-s <stride>] [-b <baseline_file>] [-w <baseline_file>] "
+            "[-t <tolerance>]\n"
+            "  -g  classic global parameter file of the run\n"
+            "  -r  repetitions of each timed call [%zu]\n"
+            "  -s  time every s-th call of a kernel [%zu]\n"
+            "  -b  compare with this baseline, fail on regressions\n"
+            "  -w  write the results to this baseline file\n"
+            "  -t  relative slowdown flagged as a regression [0.1]\n",
+            executable, bench_reps, bench_stride);
+}
+
+/******************************************************************************
+ * @brief   Run the classic driver and time the physics kernels.
+ *****************************************************************************/
+int
+main(int   argc,
+     char *argv[])
+{
+    extern option_struct options;
+
+    char                *global = NULL;
+    char                *baseline = NULL;
+    char                *new_baseline = NULL;
+    char                *vic_argv[4];
+    double               tolerance = 0.1;
+    size_t               nslow = 0;
+    int                  optchar;
+
+    while ((optchar = getopt(argc, argv, "g:r:s:b:w:t:")) != EOF) {
+        switch (optchar) {
+        case 'g':
+            global = optarg;
+            break;
+        case 'r':
+            bench_reps = (size_t) atol(optarg);
+            break;
+        case 's':
+            bench_stride = (size_t) atol(optarg);
+            break;
+        case 'b':
+            baseline = optarg;
+            break;
+        case 'w':
+            new_baseline = optarg;
+            break;
+        case 't':
+            tolerance = atof(optarg);
+            break;
+        default:
+            bench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (global == NULL || bench_reps < 1 || bench_stride < 1) {
+        bench_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    svp_args = malloc(BENCH_MAX_RECORDS * sizeof(*svp_args));
+    penman_args = malloc(BENCH_MAX_RECORDS * sizeof(*penman_args));
+    if (svp_args == NULL || penman_args == NULL) {
+        fprintf(stderr, "vic_bench: memory allocation error\n");
+        return EXIT_FAILURE;
+    }
+
+    // run the model, timing the stateful kernels and recording the calls of
+    // the pure kernels
+    vic_argv[0] = argv[0];
+    vic_argv[1] = "-g";
+    vic_argv[2] = global;
+    vic_argv[3] = NULL;
+    optind = 1;
+    if (vic_classic_main(3, vic_argv) != EXIT_SUCCESS) {
+        fprintf(stderr, "vic_bench: the run of %s failed\n", global);
+        return EXIT_FAILURE;
+    }
+    if (options.NWORKERS > 1) {
+        fprintf(stderr, "vic_bench: only the grid cells of the first of the "
+                "%zu worker processes were timed\n", options.NWORKERS);
+    }
+
+    replay_pure_kernels();
+
+    if (baseline != NULL && !read_baseline(baseline)) {
+        fprintf(stderr, "vic_bench: no baseline %s, not checking for "
+                "regressions\n", baseline);
+    }
+    nslow = report(tolerance);
+    if (new_baseline != NULL) {
+        write_baseline(new_baseline, global);
+        printf("  Wrote the baseline to %s\n\n", new_baseline);
+    }
+
+    free(svp_args);
+    free(penman_args);
+
+    if (nslow > 0) {
+        printf("  %zu kernels are more than %.0f%% slower than the "
+               "baseline\n\n", nslow, 100. * tolerance);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#!/usr/bin/env python
+'''Compare the outputs of two VIC executables on the same global files
+
+Used by `make check-release` to check an optimized build against the -O0
+build, and by `make check-mixed` to check a MIXED_PRECISION build against the
+double precision build within the tolerances --rtol and --atol. The global
+parameter files are templates as in tests/system, with $test_data_dir,
+$result_dir and $state_dir filled in for each run.
+'''
+
+from __future__ import print_function
+import os
+import sys
+import argparse
+import filecmp
+import string
+import subprocess
+
+description = 'Compare the outputs of two VIC executables'
+
+
+def run_vic(exe, template, data_dir, out_dir):
+    '''fill in a global parameter template and run it with exe'''
+    dirs = {}
+    for name in ('results', 'state', 'logs'):
+        dirs[name] = os.path.join(out_dir, name)
+        if not os.path.isdir(dirs[name]):
+            os.makedirs(dirs[name])
+
+    with open(template, 'r') as f:
+        s = string.Template(f.read())
+    global_param = s.safe_substitute(test_data_dir=data_dir,
+                                     result_dir=dirs['results'],
+                                     state_dir=dirs['state'])
+    global_file = os.path.join(out_dir, os.path.basename(template))
+    with open(global_file, 'w') as f:
+        f.write(global_param)
+
+    with open(os.path.join(dirs['logs'], 'stdout.txt'), 'w') as log:
+        returncode = subprocess.call([exe, '-g', global_file], stdout=log,
+                                     stderr=subprocess.STDOUT)
+    if returncode != 0:
+        raise RuntimeError('{0} failed on {1}, see {2}'.format(
+            exe, global_file, dirs['logs']))
+
+    return dirs['results']
+
+
+def values_close(ref, test, rtol, atol):
+    '''compare two words of ASCII output, numbers within the tolerances'''
+    try:
+        ref_value, test_value = float(ref), float(test)
+    except ValueError:
+        return ref == test
+    return abs(ref_value - test_value) <= atol + rtol * abs(ref_value)
+
+
+def ascii_files_close(ref_file, test_file, rtol, atol):
+    '''compare two ASCII output files word by word'''
+    with open(ref_file, 'r') as ref, open(test_file, 'r') as test:
+        ref_lines, test_lines = ref.readlines(), test.readlines()
+    if len(ref_lines) != len(test_lines):
+        return False
+    for ref_line, test_line in zip(ref_lines, test_lines):
+        ref_words, test_words = ref_line.split(), test_line.split()
+        if len(ref_words) != len(test_words):
+            return False
+        if not all(values_close(r, t, rtol, atol)
+                   for r, t in zip(ref_words, test_words)):
+            return False
+    return True
+
+
+def files_match(ref_file, test_file, rtol=0., atol=0.):
+    '''compare two output files, netCDF files by their variables
+
+    With the default tolerances of 0 the files must be identical.
+    '''
+    exact = rtol == 0. and atol == 0.
+    if ref_file.endswith('.nc'):
+        import xarray as xr
+        with xr.open_dataset(ref_file) as ref, \
+                xr.open_dataset(test_file) as test:
+            if exact:
+                return ref.equals(test)
+            try:
+                xr.testing.assert_allclose(ref, test, rtol=rtol, atol=atol)
+            except AssertionError:
+                return False
+            return True
+    if exact:
+        return filecmp.cmp(ref_file, test_file, shallow=False)
+    return ascii_files_close(ref_file, test_file, rtol, atol)
+
+
+def compare_results(ref_dir, test_dir, rtol=0., atol=0.):
+    '''return the names of the output files that differ'''
+    ref_files = sorted(os.listdir(ref_dir))
+    differ = []
+    if ref_files != sorted(os.listdir(test_dir)):
+        differ.append('(list of files)')
+    for fname in ref_files:
+        test_file = os.path.join(test_dir, fname)
+        if (os.path.isfile(test_file) and
+                not files_match(os.path.join(ref_dir, fname), test_file,
+                                rtol=rtol, atol=atol)):
+            differ.append(fname)
+    return differ
+
+
+def main():
+    parser = argparse.ArgumentParser(description=description)
+    parser.add_argument('globals', type=str, nargs='+',
+                        help='global parameter file templates')
+    parser.add_argument('--reference', type=str, required=True,
+                        help='reference VIC executable, e.g. the -O0 build')
+    parser.add_argument('--test', type=str, required=True,
+                        help='VIC executable to check')
+    parser.add_argument('--data_dir', type=str, required=True,
+                        help='directory of the test data ($test_data_dir)')
+    parser.add_argument('--output_dir', type=str, default='check_release',
+                        help='directory of the runs')
+    parser.add_argument('--rtol', type=float, default=0.,
+                        help='relative tolerance of the output values')
+    parser.add_argument('--atol', type=float, default=0.,
+                        help='absolute tolerance of the output values')
+    args = parser.parse_args()
+
+    nfailed = 0
+    for template in args.globals:
+        name = os.path.splitext(os.path.basename(template))[0]
+        results = [run_vic(os.path.abspath(exe), template,
+                           os.path.abspath(args.data_dir),
+                           os.path.join(os.path.abspath(args.output_dir),
+                                        name, build))
+                   for exe, build in ((args.reference, 'reference'),
+                                      (args.test, 'test'))]
+        differ = compare_results(*results, rtol=args.rtol, atol=args.atol)
+        if differ:
+            nfailed += 1
+            print('{0}: outputs differ: {1}'.format(name, ', '.join(differ)))
+        elif args.rtol or args.atol:
+            print('{0}: outputs within tolerance'.format(name))
+        else:
+            print('{0}: outputs identical'.format(name))
+
+    return 1 if nfailed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -123,7 +123,9 @@ This is the VIC Profiling Test Suite. There are 2 main test types:
     1. Gprof Profiling: This test will generate a profiling call graph using
         gprof. This test requires building your VIC executable with the
         flags `-pg`.
-    2. Scaling: This test will generate a MPI scaling timing table.
+    2. Scaling: This test will generate a MPI scaling timing table. See
+        benchmarks/run_scaling.py for scaling tests with machine readable
+        results.
 -------------------------------------------------------------------------------
 '''
 
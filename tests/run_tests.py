@@ -7,7 +7,10 @@ import sys
 import glob
 import argparse
 import datetime
+import json
+import socket
 from collections import OrderedDict
+import statistics
 import string
 import warnings
 
@@ -26,10 +29,13 @@ from test_utils import (
     check_multistream_classic,
     setup_subdirs_and_fill_in_global_param_driver_match_test,
     check_drivers_match_fluxes,
-    plot_science_tests)
-from test_image_driver import (test_image_driver_no_output_file_nans,
-                               setup_subdirs_and_fill_in_global_param_mpi_test,
-                               check_mpi_fluxes, check_mpi_states)
+    plot_science_tests,
+    read_vic_timing_profile)
+from test_image_driver import (
+    test_image_driver_no_output_file_nans,
+    setup_subdirs_and_fill_in_global_param_mpi_test,
+    setup_subdirs_and_fill_in_global_param_distributed_domain_test,
+    check_mpi_fluxes, check_mpi_states, check_distributed_domain)
 from test_restart import (prepare_restart_run_periods,
                           setup_subdirs_and_fill_in_global_param_restart_test,
                           check_exact_restart_fluxes,
@@ -64,6 +70,8 @@ This is the VIC Test Suite. There are six main test types:
     4. examples: a set of examples that users may download and run.
     5. release: longer, full domain simulations performed prior to release
             demonstrating model output for a final release.
+    6. performance: repeated runs of a fixed configuration, whose timers and
+            hardware counters are compared with a recorded baseline.
 -------------------------------------------------------------------------------
 '''
 
@@ -124,7 +132,7 @@ def main():
     parser.add_argument('tests', type=str,
                         help='Test sets to run',
                         choices=['all', 'unit', 'system', 'science',
-                                 'examples', 'release'],
+                                 'examples', 'release', 'performance'],
                         default=['unit', 'system'], nargs='+')
     parser.add_argument('--system', type=str,
                         help='system tests configuration file',
@@ -140,6 +148,17 @@ def main():
     parser.add_argument('--release', type=str,
                         help='release tests configuration file',
                         default=os.path.join(test_dir, 'release/release.cfg'))
+    parser.add_argument('--performance', type=str,
+                        help='performance tests configuration file',
+                        default=os.path.join(test_dir,
+                                             'performance/performance.cfg'))
+    parser.add_argument('--perf_baseline', type=str,
+                        help='baseline of the performance tests',
+                        default=os.path.join(
+                            test_dir, 'performance/performance_baseline.json'))
+    parser.add_argument('--update_baseline', action='store_true',
+                        help='write the medians of the performance tests '
+                             'to the baseline instead of comparing them')
     parser.add_argument('--classic', type=str,
                         help='classic driver executable to test')
     parser.add_argument('--image', type=str,
@@ -230,6 +249,13 @@ def main():
     # release
     if any(i in ['all', 'release'] for i in args.tests):
         test_results['release'] = run_release(args.release)
+    # performance (not part of 'all', since it needs a baseline of the
+    # machine)
+    if 'performance' in args.tests:
+        test_results['performance'] = run_performance(
+            args.performance, dict_drivers, data_dir,
+            os.path.join(out_dir, 'performance'), args.perf_baseline,
+            args.update_baseline)
 
     # Print test results
     summary = OrderedDict()
@@ -403,6 +429,15 @@ def run_system(config_file, dict_drivers, test_data_dir, out_dir):
                 raise ValueError('Need at least two values in n_proc to run'
                                  'mpi test!')
             list_n_proc = test_dict['mpi']['n_proc']
+        # If distributed domain test, prepare a list of number of processors
+        # to be run with and without DISTRIBUTED_DOMAIN
+        elif 'distributed_domain' in test_dict['check']:
+            if len(dict_drivers) > 1:
+                raise ValueError('Only support single driver for '
+                                 'distributed domain tests!')
+            list_n_proc = test_dict['mpi']['n_proc']
+            if not isinstance(list_n_proc, list):
+                list_n_proc = [list_n_proc]
 
         # create template string
         dict_s = {}
@@ -428,6 +463,17 @@ def run_system(config_file, dict_drivers, test_data_dir, out_dir):
                 setup_subdirs_and_fill_in_global_param_mpi_test(
                     s, list_n_proc, dirs['results'], dirs['state'],
                     test_data_dir)
+            list_run_n_proc = list_n_proc
+            list_run_names = ['processors_{}'.format(n_proc)
+                              for n_proc in list_n_proc]
+        # --- if distributed domain test, two runs for each number of
+        # processors --- #
+        elif 'distributed_domain' in test_dict['check']:
+            s = dict_s[driver]
+            list_global_param, list_run_n_proc, list_run_names = \
+                setup_subdirs_and_fill_in_global_param_distributed_domain_test(
+                    s, list_n_proc, dirs['results'], dirs['state'],
+                    test_data_dir)
         # --- if driver-match test, one run for each driver --- #
         elif 'driver_match' in test_dict['check']:
             # Set up subdirectories and output directories in global file for
@@ -459,7 +505,8 @@ def run_system(config_file, dict_drivers, test_data_dir, out_dir):
             if 'STATE_FORMAT' in replacements:
                 state_format = replacements['STATE_FORMAT']
         if 'exact_restart' in test_dict['check'] or\
-           'mpi' in test_dict['check']:  # if multiple runs
+           'mpi' in test_dict['check'] or\
+           'distributed_domain' in test_dict['check']:  # if multiple runs
             for j, gp in enumerate(list_global_param):
                 # save a copy of replacements for the next global file
                 replacements_cp = replacements.copy()
@@ -491,13 +538,14 @@ def run_system(config_file, dict_drivers, test_data_dir, out_dir):
                 with open(test_global_file, mode='w') as f:
                     for line in gp:
                         f.write(line)
-        elif 'mpi' in test_dict['check']:
+        elif 'mpi' in test_dict['check'] or\
+                'distributed_domain' in test_dict['check']:
             list_test_global_file = []
             for j, gp in enumerate(list_global_param):
                 test_global_file = os.path.join(
                     dirs['test'],
-                    '{}_globalparam_processors_{}.txt'.format(
-                        testname, list_n_proc[j]))
+                    '{}_globalparam_{}.txt'.format(
+                        testname, list_run_names[j]))
                 list_test_global_file.append(test_global_file)
                 with open(test_global_file, mode='w') as f:
                     for line in gp:
@@ -539,14 +587,15 @@ def run_system(config_file, dict_drivers, test_data_dir, out_dir):
                     # Check return code
                     check_returncode(vic_exe,
                                      test_dict.pop('expected_retval', 0))
-            elif 'mpi' in test_dict['check']:
+            elif 'mpi' in test_dict['check'] or\
+                    'distributed_domain' in test_dict['check']:
                 for j, test_global_file in enumerate(list_test_global_file):
                     # Overwrite mpi_proc in option kwargs
-                    n_proc = list_n_proc[j]
+                    n_proc = list_run_n_proc[j]
                     if n_proc == 1:
                         run_kwargs['mpi_proc'] = None
                     else:
-                        run_kwargs['mpi_proc'] = list_n_proc[j]
+                        run_kwargs['mpi_proc'] = n_proc
                     # Run VIC
                     returncode = vic_exe.run(test_global_file,
                                              logdir=dirs['logs'],
@@ -646,6 +695,12 @@ def run_system(config_file, dict_drivers, test_data_dir, out_dir):
                     check_mpi_fluxes(dirs['results'], list_n_proc)
                     check_mpi_states(dirs['state'], list_n_proc)
 
+                # check that the distributed domain setup gives the same
+                # results
+                if 'distributed_domain' in test_dict['check']:
+                    check_distributed_domain(dirs['results'], dirs['state'],
+                                             list_n_proc)
+
                 # check that results from different drivers match
                 if 'driver_match' in test_dict['check']:
                     check_drivers_match_fluxes(list(dict_drivers.keys()),
@@ -966,6 +1021,231 @@ def run_examples(config_file, vic_exe, test_data_dir, out_dir, driver):
     return test_results
 
 
+def get_performance_metrics(tables):
+    '''Metrics of the performance tests from the timing profile
+
+    Returns a dict of (metric name, kind), where kind is 'wall' for the wall
+    times and cycles and 'count' for the instruction counts.
+    '''
+    metrics = OrderedDict()
+    columns = [('Timing Table', 'wall', 'wall'),
+               ('Phase Timing Table', 'mean', 'wall'),
+               ('Hardware Counter Table', 'cycles', 'wall'),
+               ('Hardware Counter Table', 'instructions', 'count')]
+    for table, column, kind in columns:
+        for row, values in tables.get(table, {}).items():
+            if column not in values:
+                continue
+            # zero counts: the hardware counters are not available
+            if table == 'Hardware Counter Table' and values[column] == 0:
+                continue
+            name = '{0}/{1}/{2}'.format(table, row, column)
+            metrics[name] = (values[column], kind)
+    return metrics
+
+
+def run_performance(config_file, dict_drivers, test_data_dir, out_dir,
+                    baseline_file, update_baseline=False):
+    '''Run performance regression tests from config file
+
+    Parameters
+    ----------
+    config_file : str
+        Configuration file for performance tests.
+    dict_drivers : dict
+        Keys: driver names {'classic', 'image'}
+        Content: corresponding VIC executable object (see tonic documentation)
+    test_data_dir : str
+        Path to test data sets.
+    out_dir : str
+        Path to output location
+    baseline_file : str
+        JSON file with the median of each metric of each test.
+    update_baseline : bool
+        If True, write the medians of the tests to baseline_file instead of
+        comparing them with it.
+
+    Returns
+    -------
+    test_results : dict
+        Test results for all tests in config_file.
+
+    See Also
+    --------
+    run_unit_tests
+    run_system
+    run_examples
+    run_science
+    '''
+
+    # Print test set welcome
+    print('\n-'.ljust(OUTPUT_WIDTH + 1, '-'))
+    print('Running Performance Tests')
+    print('-'.ljust(OUTPUT_WIDTH, '-'))
+
+    # Get setup
+    config = read_config(config_file)
+
+    baseline = {}
+    if os.path.isfile(baseline_file):
+        with open(baseline_file, 'r') as f:
+            baseline = json.load(f)
+    elif not update_baseline:
+        warnings.warn('performance baseline {0} does not exist, record it '
+                      'with --update_baseline'.format(baseline_file))
+
+    test_results = OrderedDict()
+
+    # Run individual tests
+    for i, (testname, test_dict) in enumerate(config.items()):
+
+        # print out status info
+        print('Running test {0}/{1}: {2}'.format(i + 1, len(config.items()),
+                                                 testname))
+        driver = test_dict['driver'].lower()
+        if driver not in dict_drivers:
+            print('\tskipped, no {0} driver executable'.format(driver))
+            continue
+        vic_exe = dict_drivers[driver]
+
+        # Setup directories for test
+        dirs = setup_test_dirs(testname, out_dir,
+                               mkdirs=['results', 'state', 'logs', 'plots'])
+
+        # read template global parameter file from the examples
+        infile = os.path.join(test_dir, 'examples',
+                              test_dict['global_parameter_file'])
+
+        with open(infile, 'r') as global_file:
+            global_param = global_file.read()
+
+        # create template string
+        s = string.Template(global_param)
+
+        # fill in global parameter options
+        global_param = s.safe_substitute(test_data_dir=test_data_dir,
+                                         result_dir=dirs['results'],
+                                         state_dir=dirs['state'],
+                                         testname=testname,
+                                         test_root=test_dir)
+        replacements = test_dict.get('options', OrderedDict()).copy()
+        global_param = replace_global_values(global_param, replacements)
+
+        test_global_file = os.path.join(dirs['test'],
+                                        '{0}_globalparam.txt'.format(testname))
+
+        # write global parameter file
+        with open(test_global_file, 'w') as f:
+            for line in global_param:
+                f.write(line)
+
+        # Get optional kwargs for run executable
+        run_kwargs = pop_run_kwargs(test_dict)
+        run_kwargs['valgrind'] = False
+
+        repeats = int(test_dict.get('repeats', 5))
+        tolerance = {'wall': float(test_dict.get('wall_tolerance', 0.15)),
+                     'count': float(test_dict.get('count_tolerance', 0.02))}
+        min_wall = float(test_dict.get('min_wall', 0.05))
+
+        # run VIC
+        test_complete = False
+        test_passed = False
+        test_comment = ''
+        error_message = ''
+        returncode = None
+
+        try:
+            samples = OrderedDict()
+            kinds = {}
+            for r in range(repeats):
+                logdir = os.path.join(dirs['logs'], 'run{0}'.format(r))
+                os.makedirs(logdir, exist_ok=True)
+                returncode = vic_exe.run(test_global_file, logdir=logdir,
+                                         **run_kwargs)
+                check_returncode(vic_exe)
+                tables = {}
+                for fname in sorted(glob.glob(os.path.join(logdir, '*'))):
+                    tables = read_vic_timing_profile(fname)
+                    if tables:
+                        break
+                if not tables:
+                    raise VICTestError('no timing profile in the logs of '
+                                       '{0}'.format(testname))
+                for name, (value, kind) in get_performance_metrics(
+                        tables).items():
+                    samples.setdefault(name, []).append(value)
+                    kinds[name] = kind
+            test_complete = True
+
+            medians = OrderedDict((name, statistics.median(values))
+                                  for name, values in samples.items())
+
+            if update_baseline:
+                baseline[testname] = {'machine': socket.gethostname(),
+                                      'date': str(datetime.datetime.now()),
+                                      'repeats': repeats,
+                                      'metrics': medians}
+                test_comment = 'baseline updated'
+            elif testname not in baseline:
+                raise VICTestError('no baseline for {0}'.format(testname))
+            else:
+                ref = baseline[testname]['metrics']
+                regressions = []
+                print('\t{0:60} | {1:>12} | {2:>12} | {3:>8}'.format(
+                    'Metric', 'Median', 'Baseline', 'Change'))
+                for name, value in medians.items():
+                    if name not in ref:
+                        continue
+                    if kinds[name] == 'wall' and \
+                            not name.startswith('Hardware') and \
+                            ref[name] < min_wall:
+                        continue
+                    if ref[name] <= 0:
+                        continue
+                    change = value / ref[name] - 1.
+                    flag = ''
+                    if change > tolerance[kinds[name]]:
+                        flag = ' REGRESSION'
+                        regressions.append('{0} {1:+.1%}'.format(name,
+                                                                 change))
+                    print('\t{0:60} | {1:12.5g} | {2:12.5g} | {3:+7.1%}'
+                          '{4}'.format(name, value, ref[name], change, flag))
+                if regressions:
+                    raise VICTestError('performance regression: ' +
+                                       ', '.join(regressions))
+                test_comment = 'no regression over {0} metrics'.format(
+                    len(medians))
+
+            # if we got this far, the test passed.
+            test_passed = True
+
+        # Handle errors
+        except Exception as e:
+            test_comment, error_message = process_error(e, vic_exe)
+
+        # record the test results
+        test_results[testname] = TestResults(testname,
+                                             test_complete=test_complete,
+                                             passed=test_passed,
+                                             comment=test_comment,
+                                             error_message=error_message,
+                                             returncode=returncode)
+
+    if update_baseline:
+        with open(baseline_file, 'w') as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write('\n')
+        print('Wrote the performance baseline {0}'.format(baseline_file))
+
+    # Print performance footer
+    print('-'.ljust(OUTPUT_WIDTH, '-'))
+    print('Finished testing performance.')
+    print('-'.ljust(OUTPUT_WIDTH, '-'))
+
+    return test_results
+
+
 def run_release(config_file):
     '''Run release from config file
 
@@ -206,7 +206,6 @@ def check_mpi_fluxes(result_basedir, list_n_proc):
     os
     glob
     numpy
-    warnings
     '''
 
     # Read the first run - as base
@@ -214,14 +213,9 @@ def check_mpi_fluxes(result_basedir, list_n_proc):
     result_dir = os.path.join(
         result_basedir,
         'processors_{}'.format(n_proc))
-    if len(glob.glob(os.path.join(result_dir, '*.nc'))) > 1:
-        warnings.warn(
-            'More than one netCDF file found under directory {}'.
-            format(result_dir))
-    fname = glob.glob(os.path.join(result_dir, '*.nc'))[0]
-    ds_first_run = xr.open_dataset(fname)
+    fnames = sorted(glob.glob(os.path.join(result_dir, '*.nc')))
 
-    # Loop over all rest runs and compare fluxes with the base run
+    # Loop over all rest runs and compare each history file with the base run
     for i, n_proc in enumerate(list_n_proc):
         # Skip the first run
         if i == 0:
@@ -230,16 +224,17 @@ def check_mpi_fluxes(result_basedir, list_n_proc):
         result_dir = os.path.join(
             result_basedir,
             'processors_{}'.format(n_proc))
-        if len(glob.glob(os.path.join(result_dir, '*.nc'))) > 1:
-            warnings.warn('More than one netCDF file found under '
-                          'directory {}'.format(result_dir))
-        fname = glob.glob(os.path.join(result_dir, '*.nc'))[0]
-        ds_current_run = xr.open_dataset(fname)
-        # Compare current run with base run
-        for var in ds_first_run.data_vars:
-            npt.assert_array_equal(ds_current_run[var].values,
-                                   ds_first_run[var].values,
-                                   err_msg='Fluxes are not an exact match')
+        for fname in fnames:
+            ds_first_run = xr.open_dataset(fname)
+            ds_current_run = xr.open_dataset(
+                os.path.join(result_dir, os.path.basename(fname)))
+            # Compare current run with base run
+            for var in ds_first_run.data_vars:
+                npt.assert_array_equal(ds_current_run[var].values,
+                                       ds_first_run[var].values,
+                                       err_msg='Fluxes are not an exact '
+                                               'match in {}'.format(
+                                                   os.path.basename(fname)))
 
 
 def check_mpi_states(state_basedir, list_n_proc):
@@ -292,3 +287,113 @@ def check_mpi_states(state_basedir, list_n_proc):
             npt.assert_array_equal(ds_current_run[var].values,
                                    ds_first_run[var].values,
                                    err_msg='States are not an exact match')
+
+
+def setup_subdirs_and_fill_in_global_param_distributed_domain_test(
+        s, list_n_proc, result_basedir, state_basedir, test_data_dir):
+    ''' Fill in global parameter output directories for a run without and a
+        run with DISTRIBUTED_DOMAIN on each number of processors, image driver
+
+    Parameters
+    ----------
+    s: <string.Template>
+        Template of the global param file to be filled in
+    list_n_proc: <list>
+        A list of number of processors to run
+    result_basedir: <str>
+        Base directory of output fluxes results; runs are output to
+        subdirectories under the base directory
+    state_basedir: <str>
+        Base directory of output state results; runs are output to
+        subdirectories under the base directory
+    test_data_dir: <str>
+        Base directory of test data
+
+    Returns
+    ----------
+    list_global_param: <list>
+        A list of global parameter strings to be run with parameters filled in
+    list_run_n_proc: <list>
+        The number of processors of each run
+    list_run_names: <list>
+        The name of each run, which is also its subdirectory
+
+    Require
+    ----------
+    os
+    '''
+
+    list_global_param = []
+    list_run_n_proc = []
+    list_run_names = []
+    for n_proc in list_n_proc:
+        for distributed in [False, True]:
+            # Set up subdirectories for results and states
+            subdir = distributed_domain_subdir(n_proc, distributed)
+            result_dir = os.path.join(result_basedir, subdir)
+            state_dir = os.path.join(state_basedir, subdir)
+            os.makedirs(result_dir, exist_ok=True)
+            os.makedirs(state_dir, exist_ok=True)
+
+            # Fill in global parameter options
+            global_param = s.safe_substitute(test_data_dir=test_data_dir,
+                                             result_dir=result_dir,
+                                             state_dir=state_dir)
+            global_param += '\nDISTRIBUTED_DOMAIN {}\n'.format(
+                str(distributed).upper())
+            list_global_param.append(global_param)
+            list_run_n_proc.append(n_proc)
+            list_run_names.append(subdir)
+
+    return(list_global_param, list_run_n_proc, list_run_names)
+
+
+def distributed_domain_subdir(n_proc, distributed):
+    ''' Subdirectory of a run of the DISTRIBUTED_DOMAIN test '''
+    return 'processors_{}_distributed_domain_{}'.format(
+        n_proc, str(distributed).lower())
+
+
+def check_distributed_domain(result_basedir, state_basedir, list_n_proc):
+    ''' Check whether the fluxes and the output states of the runs with
+        DISTRIBUTED_DOMAIN are the same as those of the runs without it on
+        the same number of processors, image driver
+
+    Parameters
+    ----------
+    result_basedir: <str>
+        Base directory of output fluxes results
+    state_basedir: <str>
+        Base directory of output states
+    list_n_proc: <list>
+        A list of number of processors that were run
+
+    Require
+    ----------
+    os
+    glob
+    numpy
+    '''
+
+    for n_proc in list_n_proc:
+        for basedir, kind in [(result_basedir, 'Fluxes'),
+                              (state_basedir, 'States')]:
+            base_dir = os.path.join(
+                basedir, distributed_domain_subdir(n_proc, False))
+            dist_dir = os.path.join(
+                basedir, distributed_domain_subdir(n_proc, True))
+            fnames = sorted(glob.glob(os.path.join(base_dir, '*.nc')))
+            if not fnames:
+                raise ValueError('No netCDF file found under directory '
+                                 '{}'.format(base_dir))
+            for fname in fnames:
+                ds_base_run = xr.open_dataset(fname)
+                ds_dist_run = xr.open_dataset(
+                    os.path.join(dist_dir, os.path.basename(fname)))
+                for var in ds_base_run.data_vars:
+                    npt.assert_array_equal(
+                        ds_dist_run[var].values, ds_base_run[var].values,
+                        err_msg='{} are not an exact match in {} on {} '
+                                'processors'.format(kind,
+                                                    os.path.basename(fname),
+                                                    n_proc))
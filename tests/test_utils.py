@@ -277,6 +277,55 @@ def find_global_param_value(gp, param_name):
             return line_list[1]
 
 
+# columns of the tables of the VIC timing profile
+TIMING_TABLES = {'Timing Table': ('wall', 'cpu', 'wall_per_day',
+                                  'cpu_per_day'),
+                 'Phase Timing Table': ('min', 'max', 'mean'),
+                 'Hardware Counter Table': ('calls', 'cycles',
+                                            'instructions', 'ipc',
+                                            'cache_misses', 'miss_rate')}
+
+
+def read_vic_timing_profile(log_file):
+    ''' Read the tables of the VIC timing profile from a log file
+
+    Parameters
+    ----------
+    log_file: <str>
+        VIC log file, or any file holding the output of VIC on LOG_DEST
+
+    Returns
+    ----------
+    tables: <dict>
+        tables[table][row][column] for the tables in TIMING_TABLES, e.g.
+        tables['Timing Table']['Run Time']['wall']. Empty if the file has
+        no timing profile.
+    '''
+    row = re.compile(r'^\|\s*([A-Za-z+][^|]*?)\s*\|(.*)\|\s*$')
+    tables = {}
+    table = None
+    with open(log_file, 'r', errors='replace') as f:
+        for line in f:
+            heading = line.strip().split('(')[0].rstrip(' :')
+            if heading in TIMING_TABLES:
+                table = heading
+                tables[table] = OrderedDict()
+                continue
+            match = row.match(line)
+            if table and match:
+                try:
+                    values = [float(v.strip().rstrip('%'))
+                              for v in match.group(2).split('|')]
+                except ValueError:
+                    # the column headings
+                    continue
+                tables[table][match.group(1)] = dict(
+                    zip(TIMING_TABLES[table], values))
+            elif table and line.strip() and not line.startswith('|'):
+                table = None
+    return tables
+
+
 def check_multistream_classic(fnames):
     '''
     Test the multistream aggregation in the classic driver '''
@@ -11,4 +11,4 @@ from vic import lib as vic_lib
 
 # def test_free_all_vars():
 #     all_vars_p = ffi.new('all_vars_struct *')
-#     assert vic_lib.free_all_vars(all_vars_p, 12) is None
+#     assert vic_lib.free_all_vars(all_vars_p) is None
@@ -1,4 +1,5 @@
 from vic import lib as vic_lib
+from vic.vic import ffi
 
 
 def test_str_to_bool():
@@ -8,14 +9,34 @@ def test_str_to_bool():
         assert vic_lib.str_to_bool(s.encode()) == expected
 
 
+def test_str_to_doubles():
+    values = ffi.new('double[4]', [-1.] * 4)
+    s = ' 1.5\t-2e3  7 \n'.encode()
+    assert vic_lib.str_to_doubles(s, values, 4) == 3
+    assert list(values) == [1.5, -2000., 7., -1.]
+    assert vic_lib.str_to_doubles(s, values, 2) == 2
+    assert vic_lib.str_to_doubles(''.encode(), values, 4) == 0
+
+
 def test_str_to_agg_type():
     assert vic_lib.str_to_agg_type(''.encode()) == vic_lib.AGG_TYPE_DEFAULT
     assert vic_lib.str_to_agg_type('*'.encode()) == vic_lib.AGG_TYPE_DEFAULT
     for s in ['AGG_TYPE_AVG', 'AGG_TYPE_BEG', 'AGG_TYPE_END',
-              'AGG_TYPE_MAX', 'AGG_TYPE_MIN', 'AGG_TYPE_SUM']:
+              'AGG_TYPE_MAX', 'AGG_TYPE_MIN', 'AGG_TYPE_SUM',
+              'AGG_TYPE_VAR', 'AGG_TYPE_STDEV']:
         expected = getattr(vic_lib, s)
         assert vic_lib.str_to_agg_type(s.encode()) == expected
         assert vic_lib.str_to_agg_type(s.lower().encode()) == expected
+    for s in ['AGG_TYPE_ABOVE', 'AGG_TYPE_BELOW', 'AGG_TYPE_QUANTILE']:
+        expected = getattr(vic_lib, s)
+        assert vic_lib.str_to_agg_type((s + ':0.5').encode()) == expected
+
+
+def test_str_to_agg_param():
+    assert vic_lib.str_to_agg_param('AGG_TYPE_AVG'.encode()) == 0.
+    assert vic_lib.str_to_agg_param('AGG_TYPE_ABOVE:0.3'.encode()) == 0.3
+    assert vic_lib.str_to_agg_param('AGG_TYPE_BELOW:-2e1'.encode()) == -20.
+    assert vic_lib.str_to_agg_param('AGG_TYPE_QUANTILE:0.9'.encode()) == 0.9
 
 
 def test_str_to_out_type():
@@ -1,4 +1,5 @@
 import numpy as np
+from vic.vic import ffi
 from vic import lib as vic_lib
 
 np.random.seed(1234)
@@ -31,3 +32,27 @@ def test_calc_energy_balance_error():
         assert vic_lib.calc_energy_balance_error(
             net_rads[rec], latents[rec], sensibles[rec], grnd_fluxes[rec],
             snow_fluxes[rec]) != 0.
+
+
+def test_balance_check_requested():
+    save_data = ffi.new('save_data_struct *')
+    save_data.balance_cell = False
+
+    # the first time step after the initialization is always checked
+    vic_lib.options.BALANCE_CHECK = vic_lib.BALANCE_CHECK_CELLS
+    save_data.balance_steps = 0
+    assert vic_lib.balance_check_requested(save_data)
+    save_data.balance_steps = 1
+    assert not vic_lib.balance_check_requested(save_data)
+
+    vic_lib.options.BALANCE_CHECK = vic_lib.BALANCE_CHECK_STEPS
+    vic_lib.options.BALANCE_CHECK_N = 4
+    checked = []
+    for step in range(1, 9):
+        save_data.balance_steps = step
+        checked.append(vic_lib.balance_check_requested(save_data))
+    assert checked == [False, False, False, True, False, False, False, True]
+
+    vic_lib.options.BALANCE_CHECK = vic_lib.BALANCE_CHECK_ALL
+    vic_lib.options.BALANCE_CHECK_N = 1
+    assert vic_lib.balance_check_requested(save_data)
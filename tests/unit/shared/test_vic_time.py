@@ -354,6 +354,69 @@ def test_timedelta():
     assert actual == 366
 
 
+def test_day_number_from_dmy():
+    dmy = ffi.new('dmy_struct *')
+    dmy[0].year = 2000
+    dmy[0].month = 1
+    dmy[0].day = 1
+    for cal in ['standard', 'gregorian', 'proleptic_gregorian']:
+        assert vic_lib.day_number_from_dmy(dmy, calendars[cal]) == 2451545
+
+    # consecutive days have consecutive day numbers
+    for cal, cal_num in calendars.items():
+        dmy[0].year = 1899
+        dmy[0].month = 12
+        dmy[0].day = 1
+        first = vic_lib.day_number_from_dmy(dmy, cal_num)
+        for i in range(0, 800 * 366, 7):
+            vic_lib.dmy_from_day_number(first + i, cal_num, dmy)
+            assert vic_lib.invalid_date(cal_num, dmy) == 0
+            assert vic_lib.day_number_from_dmy(dmy, cal_num) == first + i
+
+
+def test_dmy_add_seconds():
+    dmy = datetime_to_dmy(datetime.datetime(2015, 2, 28, 23))
+    result = ffi.new('dmy_struct *')
+    vic_lib.dmy_add_seconds(dmy, 3600, calendars['noleap'], result)
+    assert (result[0].month, result[0].day, result[0].dayseconds) == (3, 1, 0)
+    vic_lib.dmy_add_seconds(dmy, 3600, calendars['all_leap'], result)
+    assert (result[0].month, result[0].day, result[0].dayseconds) == (2, 29, 0)
+    vic_lib.dmy_add_seconds(dmy, 3600, calendars['360_day'], result)
+    assert (result[0].month, result[0].day, result[0].dayseconds) == (2, 29, 0)
+    vic_lib.dmy_add_seconds(dmy, -3600 * 24 * 59, calendars['standard'],
+                            result)
+    assert (result[0].year, result[0].month, result[0].day,
+            result[0].dayseconds, result[0].day_in_year) == (2014, 12, 31,
+                                                             82800, 365)
+
+
+def test_dmy_add_months():
+    dmy = datetime_to_dmy(datetime.datetime(2015, 11, 30))
+    result = ffi.new('dmy_struct *')
+    assert vic_lib.dmy_add_months(dmy, 2, calendars['standard'], result) == 0
+    assert (result[0].year, result[0].month, result[0].day,
+            result[0].day_in_year) == (2016, 1, 30, 30)
+    assert vic_lib.dmy_add_months(dmy, 3, calendars['standard'], result) > 0
+
+
+def test_dmy_from_step():
+    vic_lib.global_param.dt = 3600
+    vic_lib.global_param.startsec = 0
+    vic_lib.global_param.startday = 1
+    vic_lib.global_param.startmonth = 1
+    vic_lib.global_param.startyear = 2015
+    dmy = ffi.new('dmy_struct *')
+    start = datetime.datetime(2015, 1, 1)
+    for cal in ['standard', 'proleptic_gregorian', 'julian']:
+        vic_lib.global_param.calendar = calendars[cal]
+        for step in range(0, 24 * 3000, 23):
+            vic_lib.dmy_from_step(ffi.addressof(vic_lib.global_param), step,
+                                  dmy)
+            expected = start + datetime.timedelta(hours=step)
+            assert dmy_to_datetime(dmy) == expected
+            assert dmy[0].day_in_year == expected.timetuple().tm_yday
+
+
 def test_dmy_equal():
     dmy1 = datetime_to_dmy(datetime.datetime(2015, 12, 12, 8))
     dmy2 = datetime_to_dmy(datetime.datetime(2015, 12, 12, 8))
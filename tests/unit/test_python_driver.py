@@ -25,3 +25,120 @@ def test_globals_are_initialized():
     assert vic_lib.global_param.atmos_dt == -99999.
     assert vic_lib.options.AboveTreelineVeg == -1
     assert vic_lib.param.LAPSE_RATE == -0.0065
+
+
+def test_vic_run_batch_shapes():
+    import numpy as np
+    import pytest
+    from vic import ffi, vic_run_batch
+
+    cells = ffi.new('batch_cell_struct[]', 1)
+    forcing = np.zeros((0, vic_lib.NF, vic_lib.N_BATCH_FORCING))
+    out, errors = vic_run_batch(cells, forcing, ffi.NULL, ['OUT_RUNOFF'])
+    assert out.shape == (0, 1, 1)
+    assert errors.shape == (0, )
+
+    with pytest.raises(ValueError):
+        vic_run_batch(cells, np.zeros((1, vic_lib.NF, 3)), ffi.NULL,
+                      ['OUT_RUNOFF'])
+    with pytest.raises(ValueError):
+        vic_run_batch(cells, forcing, ffi.NULL, ['NOT_A_VARIABLE'])
+
+
+def test_vic_branch_copies_state():
+    from vic import ffi, vic_branch
+
+    ntiles = 3
+    veg_con = ffi.new('veg_con_struct[]', ntiles)
+    veg_con[0].vegetat_type_num = ntiles - 1
+    all_vars = ffi.new('all_vars_struct *', vic_lib.make_all_vars(ntiles - 1))
+    all_vars.snow[1][0].swq = 12.5
+    cell = ffi.new('batch_cell_struct *')
+    cell.veg_con = veg_con
+    cell.all_vars = all_vars
+
+    members, states = vic_branch(cell, 2)
+    assert members[1].veg_con == veg_con
+    assert members[1].all_vars.snow[1][0].swq == 12.5
+    members[0].all_vars.snow[1][0].swq = 3.
+    assert members[1].all_vars.snow[1][0].swq == 12.5
+    assert all_vars.snow[1][0].swq == 12.5
+    vic_lib.free_all_vars(all_vars)
+
+
+def test_snapshot_ring_rolls_back():
+    from vic import ffi, SnapshotRing
+
+    ntiles = 3
+    veg_con = ffi.new('veg_con_struct[]', ntiles)
+    veg_con[0].vegetat_type_num = ntiles - 1
+    all_vars = ffi.new('all_vars_struct *', vic_lib.make_all_vars(ntiles - 1))
+    cells = ffi.new('batch_cell_struct[]', 1)
+    cells[0].veg_con = veg_con
+    cells[0].all_vars = all_vars
+
+    ring = SnapshotRing(cells, 2)
+    for step in range(3):
+        all_vars.snow[1][0].swq = float(step)
+        ring.take(step)
+    assert ring.steps == [1, 2]
+    ring.restore(1)
+    assert all_vars.snow[1][0].swq == 1.
+    assert ring.steps == [1]
+    try:
+        ring.restore(0)
+        assert False
+    except ValueError:
+        pass
+    vic_lib.free_all_vars(all_vars)
+
+
+def test_vic_set_soil_param_derived():
+    from vic import ffi
+
+    vic_lib.options.Nlayer = 3
+    soil_con = ffi.new('soil_con_struct *')
+    soil_con.max_moist[0] = 10.
+    soil_con.max_moist[1] = 20.
+    assert vic_lib.vic_set_soil_param(soil_con, vic_lib.CALIB_B_INFILT, 0,
+                                      0.5) == 0
+    assert soil_con.max_infil == 1.5 * 30.
+    assert vic_lib.vic_set_soil_param(soil_con, vic_lib.CALIB_B_INFILT, 0,
+                                      -1.) == -1
+    assert soil_con.b_infilt == 0.5
+    assert vic_lib.vic_set_soil_param(soil_con, vic_lib.CALIB_DEPTH, 0,
+                                      0.5) == -1
+
+
+def test_state_views_are_zero_copy():
+    from vic import layer_view, tile_view
+
+    ntiles = 3
+    all_vars = vic_lib.make_all_vars(ntiles - 1)
+
+    swq = tile_view(all_vars, ntiles, 'snow', 'swq')
+    assert swq.shape == (ntiles, vic_lib.options.SNOW_BAND)
+    swq[1, 0] = 12.5
+    assert all_vars.snow[1][0].swq == 12.5
+
+    moist = layer_view(all_vars, ntiles, 'moist')
+    assert moist.shape == (ntiles, vic_lib.options.SNOW_BAND,
+                           vic_lib.options.Nlayer)
+    moist[2, 0, 1] = 0.25
+    assert all_vars.cell[2][0].layer[1].moist == 0.25
+
+
+def test_vic_run_ensemble_shapes():
+    import numpy as np
+    import pytest
+    from vic import ffi, vic_run_ensemble
+
+    members = ffi.new('batch_cell_struct[]', 0)
+    forcing = np.zeros((vic_lib.NF, vic_lib.N_BATCH_FORCING))
+    out, errors = vic_run_ensemble(members, forcing, ffi.NULL,
+                                   ['OUT_RUNOFF'])
+    assert out.shape == (0, 1, 1)
+
+    with pytest.raises(ValueError):
+        vic_run_ensemble(members, np.zeros((1, 2, 3)), ffi.NULL,
+                         ['OUT_RUNOFF'])
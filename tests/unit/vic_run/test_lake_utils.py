@@ -0,0 +1,34 @@
+from vic.vic import ffi
+from vic import lib as vic_lib
+
+
+def make_lake_con(numnod=4, maxdepth=10., maxarea=1e6):
+    lake_con = ffi.new('lake_con_struct *')
+    lake_con.numnod = numnod
+    for i in range(numnod + 1):
+        lake_con.z[i] = maxdepth * (numnod - i) / numnod
+        lake_con.basin[i] = maxarea * (lake_con.z[i] / maxdepth) ** 0.5
+    lake_con.maxdepth = maxdepth
+    vic_lib.compute_lake_basin_volume(lake_con)
+    lake_con.maxvolume = lake_con.basin_volume[0]
+    return lake_con
+
+
+def test_compute_lake_basin_volume():
+    lake_con = make_lake_con()
+    assert lake_con.basin_volume[lake_con.numnod] == 0.
+    for i in range(lake_con.numnod):
+        assert lake_con.basin_volume[i] > lake_con.basin_volume[i + 1]
+
+
+def test_get_volume_get_depth():
+    lake_con = make_lake_con()
+    volume = ffi.new('double *')
+    depth = ffi.new('double *')
+    sarea = ffi.new('double *')
+    for d in [0.5, 2.5, 5., 7.3, 9.9]:
+        assert vic_lib.get_volume(lake_con, d, volume) == 0
+        assert vic_lib.get_depth(lake_con, volume[0], depth) == 0
+        assert abs(depth[0] - d) < 1e-10
+        assert vic_lib.get_sarea(lake_con, d, sarea) == 0
+        assert 0. < sarea[0] <= lake_con.basin[0]
@@ -0,0 +1,11 @@
+from vic.vic import ffi
+from vic import lib as vic_lib
+
+
+def test_penman_atmos_matches_penman():
+    atmos = ffi.new('penman_atmos_struct *')
+    for tair in (-5., 10., 25.):
+        vic_lib.set_penman_atmos(tair, 1500., atmos)
+        for rc in (0., 100., 2000.):
+            assert (vic_lib.penman_atmos(atmos, 300., 800., 50., rc, 25.) ==
+                    vic_lib.penman(tair, 1500., 300., 800., 50., rc, 25.))
@@ -0,0 +1,44 @@
+from vic.vic import ffi
+from vic import lib as vic_lib
+
+
+def test_root_brent_ctx():
+    assert vic_lib.initialize_parameters() is None
+
+    @ffi.callback('double(double, void *)')
+    def func(x, ctx):
+        return x - 2.
+
+    root = vic_lib.root_brent_ctx(0., 5., func, ffi.NULL)
+    assert abs(root - 2.) < 1e-6
+
+
+def test_root_brent_batch_ctx():
+    assert vic_lib.initialize_parameters() is None
+    n = 3
+
+    @ffi.callback('void(size_t, const double *, const bool *, double *, '
+                  'void *)')
+    def func(n, x, active, f, ctx):
+        for k in range(n):
+            if active[k]:
+                f[k] = x[k] - (k + 1.)
+
+    lower = ffi.new('double[]', [0.] * n)
+    upper = ffi.new('double[]', [5.] * n)
+    root = ffi.new('double[]', n)
+    assert vic_lib.root_brent_batch_ctx(n, lower, upper, func, ffi.NULL,
+                                        root) is None
+    for k in range(n):
+        assert abs(root[k] - (k + 1.)) < 1e-6
+
+
+def test_root_brent_retry_ctx():
+    assert vic_lib.initialize_parameters() is None
+
+    @ffi.callback('double(double, void *)')
+    def func(x, ctx):
+        return x - 2.
+
+    root = vic_lib.root_brent_retry_ctx(1.5, func, ffi.NULL)
+    assert abs(root - 2.) < 1e-6
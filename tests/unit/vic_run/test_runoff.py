@@ -0,0 +1,149 @@
+from vic.vic import ffi
+from vic import lib as vic_lib
+
+MAX_FROST_AREAS = len(ffi.new('layer_data_struct *').ice)
+
+
+def test_frost_area_repeats():
+    nlayer = vic_lib.options.Nlayer
+    vic_lib.options.Nlayer = 3
+    try:
+        layer = ffi.new('layer_data_struct[]', 3)
+        evap = ffi.new('double[3][%d]' % MAX_FROST_AREAS)
+        for lidx in range(3):
+            for fidx in range(2):
+                layer[lidx].ice[fidx] = 1.5 * lidx
+                evap[lidx][fidx] = 0.1
+        assert vic_lib.frost_area_repeats(layer, evap, 1)
+        layer[2].ice[1] = 2.
+        assert not vic_lib.frost_area_repeats(layer, evap, 1)
+        layer[2].ice[1] = layer[2].ice[0]
+        evap[0][1] = 0.2
+        assert not vic_lib.frost_area_repeats(layer, evap, 1)
+    finally:
+        vic_lib.options.Nlayer = nlayer
+
+
+def test_get_runoff_steps():
+    nlayer = vic_lib.options.Nlayer
+    model_steps_per_day = vic_lib.global_param.model_steps_per_day
+    adapt_runoff_frac = vic_lib.param.ADAPT_RUNOFF_FRAC
+    vic_lib.options.Nlayer = 2
+    vic_lib.global_param.model_steps_per_day = 24
+    vic_lib.param.ADAPT_RUNOFF_FRAC = 0.1
+    try:
+        layer = ffi.new('layer_data_struct[]', 2)
+        soil_con = ffi.new('soil_con_struct *')
+        resid_moist = ffi.new('double[]', [0., 0.])
+        for lidx in range(2):
+            soil_con.max_moist[lidx] = 100.
+            soil_con.Ksat[lidx] = 240.
+            soil_con.expt[lidx] = 10.
+            layer[lidx].moist = 10.
+        soil_con.Dsmax = 10.
+        soil_con.Ds = 0.1
+        soil_con.Ws = 0.9
+        soil_con.c = 2.
+
+        # dry soil without rain needs a single sub-step
+        assert vic_lib.get_runoff_steps(layer, soil_con, 0., resid_moist,
+                                        12) == 1
+        # 25 mm of rain through a 100 mm layer needs 3 sub-steps
+        assert vic_lib.get_runoff_steps(layer, soil_con, 25., resid_moist,
+                                        12) == 3
+        # at most max_steps sub-steps
+        assert vic_lib.get_runoff_steps(layer, soil_con, 500., resid_moist,
+                                        12) == 12
+    finally:
+        vic_lib.options.Nlayer = nlayer
+        vic_lib.global_param.model_steps_per_day = model_steps_per_day
+        vic_lib.param.ADAPT_RUNOFF_FRAC = adapt_runoff_frac
+
+
+def test_runoff_flat():
+    saved = (vic_lib.options.Nlayer, vic_lib.options.Nfrost,
+             vic_lib.options.ADAPTIVE_SUBSTEPS, vic_lib.options.COMPUTE_ZWT,
+             vic_lib.options.FULL_ENERGY, vic_lib.options.FROZEN_SOIL,
+             vic_lib.global_param.model_steps_per_day,
+             vic_lib.global_param.runoff_steps_per_day)
+    nlayers = 3
+    vic_lib.options.Nlayer = nlayers
+    vic_lib.options.Nfrost = 1
+    vic_lib.options.ADAPTIVE_SUBSTEPS = False
+    vic_lib.options.COMPUTE_ZWT = False
+    vic_lib.options.FULL_ENERGY = False
+    vic_lib.options.FROZEN_SOIL = False
+    vic_lib.global_param.model_steps_per_day = 24
+    vic_lib.global_param.runoff_steps_per_day = 96
+    try:
+        # (ppt, moist of each layer, evap of each layer) of each cell: dry,
+        # wet, saturated, evaporation larger than the bottom layer holds
+        cells = [(0., (20., 60., 200.), (0.1, 0.05, 0.)),
+                 (5., (80., 150., 500.), (0.2, 0.1, 0.01)),
+                 (40., (100., 200., 600.), (0., 0., 0.)),
+                 (0., (30., 60., 61.), (0., 0., 5.))]
+        ncells = len(cells)
+        frost_fract = ffi.new('double[]', [1.])
+        energy = ffi.new('energy_bal_struct *')
+
+        soil_con = ffi.new('soil_con_struct *')
+        soil_con.b_infilt = 0.2
+        soil_con.Ds = 0.1
+        soil_con.Dsmax = 10.
+        soil_con.Ws = 0.8
+        soil_con.c = 2.
+        for lidx, depth in enumerate((0.1, 0.3, 1.)):
+            soil_con.depth[lidx] = depth
+            soil_con.max_moist[lidx] = 500. * depth + 50. * lidx
+            soil_con.resid_moist[lidx] = 0.06
+            soil_con.Ksat[lidx] = 200. / (lidx + 1)
+            soil_con.expt[lidx] = 10. + lidx
+
+        arrays = {}
+        for name in ('b_infilt', 'Ds', 'Dsmax', 'Ws', 'c'):
+            arrays[name] = ffi.new('double[]', [getattr(soil_con, name)] *
+                                   ncells)
+        for name in ('expt', 'Ksat', 'max_moist', 'resid_moist'):
+            values = []
+            for lidx in range(nlayers):
+                value = getattr(soil_con, name)[lidx]
+                if name == 'resid_moist':
+                    value *= soil_con.depth[lidx] * 1000.
+                values.extend([value] * ncells)
+            arrays[name] = ffi.new('double[]', values)
+        arrays['moist'] = ffi.new('double[]', [
+            cell[1][lidx] for lidx in range(nlayers) for cell in cells])
+        arrays['evap'] = ffi.new('double[]', [
+            cell[2][lidx] for lidx in range(nlayers) for cell in cells])
+        arrays['ppt'] = ffi.new('double[]', [cell[0] for cell in cells])
+        for name in ('runoff', 'baseflow', 'asat'):
+            arrays[name] = ffi.new('double[]', ncells)
+        rf = ffi.new('runoff_flat_struct *')
+        rf.ncells = ncells
+        rf.nlayers = nlayers
+        for name, array in arrays.items():
+            setattr(rf, name, array)
+
+        vic_lib.runoff_flat_enter(rf)
+        vic_lib.runoff_flat(rf, 4, 96.)
+        vic_lib.runoff_flat_exit(rf)
+
+        for i, (ppt, moist, evap) in enumerate(cells):
+            cell = ffi.new('cell_data_struct *')
+            for lidx in range(nlayers):
+                cell.layer[lidx].moist = moist[lidx]
+                cell.layer[lidx].evap = evap[lidx]
+            assert vic_lib.runoff(cell, energy, soil_con, ppt, frost_fract,
+                                  0) == 0
+            assert rf.runoff[i] == cell.runoff
+            assert rf.baseflow[i] == cell.baseflow
+            assert rf.asat[i] == cell.asat
+            for lidx in range(nlayers):
+                assert rf.moist[lidx * ncells + i] == cell.layer[lidx].moist
+                assert rf.evap[lidx * ncells + i] == cell.layer[lidx].evap
+    finally:
+        (vic_lib.options.Nlayer, vic_lib.options.Nfrost,
+         vic_lib.options.ADAPTIVE_SUBSTEPS, vic_lib.options.COMPUTE_ZWT,
+         vic_lib.options.FULL_ENERGY, vic_lib.options.FROZEN_SOIL,
+         vic_lib.global_param.model_steps_per_day,
+         vic_lib.global_param.runoff_steps_per_day) = saved
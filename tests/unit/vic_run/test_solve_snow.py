@@ -0,0 +1,123 @@
+from vic.vic import ffi
+from vic import lib as vic_lib
+
+MAX_LAYERS = len(ffi.new('cell_data_struct *').layer)
+# indices of gauge_correction (the RAIN and SNOW macros of vic_def.h)
+RAIN = 0
+SNOW = 1
+
+ptr_names = ['AlbedoUnder', 'Le', 'LongUnderIn', 'NetLongSnow',
+             'NetShortGrnd', 'NetShortSnow', 'ShortUnderIn', 'Torg_snow',
+             'aero_resist', 'aero_resist_used', 'coverage', 'delta_coverage',
+             'delta_snow_heat', 'displacement', 'gauge_correction',
+             'melt_energy', 'out_prec', 'out_rain', 'out_snow', 'ppt',
+             'rainfall', 'ref_height', 'roughness', 'snow_inflow', 'snowfall',
+             'surf_atten', 'wind', 'root']
+struct_names = ['energy', 'snow', 'veg_var']
+
+
+def snow_free_tile(gauge_snow):
+    tile = {}
+    for name in ptr_names:
+        tile[name] = ffi.new('double[%d]' % MAX_LAYERS)
+    for q in range(3):
+        tile['aero_resist'][q] = 50.
+        tile['wind'][q] = 2.
+        tile['ref_height'][q] = 10.
+        tile['roughness'][q] = 0.01
+    tile['gauge_correction'][RAIN] = 1.1
+    tile['gauge_correction'][SNOW] = gauge_snow
+    tile['UnderStory'] = ffi.new('int *', 999)
+    tile['dryFrac'] = ffi.new('double *', -1.)
+    tile['dmy'] = ffi.new('dmy_struct *')
+    tile['dmy'].month = 7
+    tile['dmy'].day_in_year = 190
+    tile['force'] = ffi.new('force_data_struct *')
+    tile['force_data'] = []
+    for name, value in (('density', 1.2), ('longwave', 300.),
+                        ('pressure', 95000.), ('shortwave', 400.),
+                        ('vp', 1000.), ('vpd', 500.)):
+        data = ffi.new('double[1]', [value])
+        tile['force_data'].append(data)
+        setattr(tile['force'], name, data)
+    tile['energy'] = ffi.new('energy_bal_struct *')
+    tile['layer'] = ffi.new('layer_data_struct[%d]' % MAX_LAYERS)
+    tile['snow'] = ffi.new('snow_data_struct *')
+    tile['snow'].MELTING = True
+    tile['snow'].last_snow = 20
+    tile['snow'].store_coverage = 0.5
+    tile['soil_con'] = ffi.new('soil_con_struct *')
+    tile['veg_var'] = ffi.new('veg_var_struct *')
+    return tile
+
+
+def call_solve_snow(tile, min_rain_temp, max_snow_temp, air_temp, prec):
+    # bare soil tile (iveg == Nveg) without an overstory
+    return vic_lib.solve_snow(
+        b'\x00', 0.2, 300., min_rain_temp, max_snow_temp, air_temp, air_temp,
+        air_temp, prec, 0., *[tile[name] for name in ptr_names],
+        False, 1, 1, 0, 3600., 0, 0, ffi.NULL, tile['UnderStory'], ffi.NULL,
+        tile['dryFrac'], tile['dmy'], tile['force'], tile['energy'],
+        tile['layer'], tile['snow'], tile['soil_con'], tile['veg_var'])
+
+
+def snow_free_reference(gauge_snow, air_temp, rainfall):
+    # the terms that both paths of solve_snow set on a snow-free tile
+    tile = snow_free_tile(gauge_snow)
+    tile['rainfall'][0] = rainfall
+    tile['out_prec'][0] = rainfall
+    tile['out_rain'][0] = rainfall
+    tile['Le'][0] = vic_lib.calc_latent_heat_of_vaporization(air_temp)
+    tile['ShortUnderIn'][0] = tile['force'].shortwave[0]
+    tile['LongUnderIn'][0] = tile['force'].longwave[0]
+    assert vic_lib.solve_snow_free(
+        0.2, air_temp, air_temp, tile['AlbedoUnder'], tile['NetLongSnow'],
+        tile['NetShortGrnd'], tile['NetShortSnow'], tile['delta_coverage'],
+        tile['UnderStory'], tile['energy'], tile['snow']) is None
+    tile['energy'].melt_energy *= -1.
+    return tile
+
+
+def assert_same_tile(tile, reference):
+    for name in ptr_names:
+        for q in range(MAX_LAYERS):
+            assert tile[name][q] == reference[name][q], name
+    for name in struct_names:
+        assert (ffi.buffer(tile[name])[:] ==
+                ffi.buffer(reference[name])[:]), name
+    assert tile['UnderStory'][0] == 0
+    assert not tile['snow'].snow
+    assert not tile['snow'].MELTING
+
+
+def test_solve_snow_free_fast_path():
+    # all of the precipitation falls as rain
+    min_rain_temp = -0.5
+    max_snow_temp = 0.5
+    air_temp = 1.
+    prec = 2.
+
+    tile = snow_free_tile(1.)
+    melt = call_solve_snow(tile, min_rain_temp, max_snow_temp, air_temp,
+                           prec)
+
+    assert melt == 0.
+    assert_same_tile(tile, snow_free_reference(1., air_temp, 1.1 * prec))
+
+
+def test_solve_snow_free_full_path():
+    # mixed precipitation, but the snow gauge correction removes the
+    # snowfall, so the tile stays free of snow
+    min_rain_temp = -0.5
+    max_snow_temp = 0.5
+    air_temp = 0.2
+    prec = 2.
+    rainonly = vic_lib.calc_rainonly(air_temp, prec, max_snow_temp,
+                                     min_rain_temp)
+
+    tile = snow_free_tile(0.)
+    melt = call_solve_snow(tile, min_rain_temp, max_snow_temp, air_temp,
+                           prec)
+
+    assert melt == 0.
+    assert_same_tile(tile, snow_free_reference(0., air_temp, 1.1 * rainonly))
@@ -9,3 +9,21 @@ def test_svp():
 def test_svp_slope():
     assert vic_lib.svp_slope(0.) > 0.
     assert vic_lib.svp_slope(0.) > vic_lib.svp_slope(-1.)
+
+
+def test_svp_table():
+    assert vic_lib.initialize_parameters() is None
+    assert vic_lib.initialize_svp_table() is None
+    vic_lib.options.FAST_SVP = True
+    try:
+        for t in [-99.9, -50.3, -10.01, -0.5, 0., 0.5, 12.34, 37.7, 99.9]:
+            exact = vic_lib.svp_exact(t)
+            assert abs(vic_lib.svp(t) - exact) <= 1.5e-6 * exact
+            exact = vic_lib.svp_slope_exact(t)
+            assert abs(vic_lib.svp_slope(t) - exact) <= 1.5e-6 * exact
+        # outside of the table the exact expressions are used
+        for t in [-150., 150.]:
+            assert vic_lib.svp(t) == vic_lib.svp_exact(t)
+            assert vic_lib.svp_slope(t) == vic_lib.svp_slope_exact(t)
+    finally:
+        vic_lib.options.FAST_SVP = False
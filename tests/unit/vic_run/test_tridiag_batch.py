@@ -0,0 +1,45 @@
+from vic.vic import ffi
+from vic import lib as vic_lib
+
+
+def test_tridiag_batch():
+    n = 5
+    nsys = 3
+    a = ffi.new('double[]', n * nsys)
+    b = ffi.new('double[]', n * nsys)
+    c = ffi.new('double[]', n * nsys)
+    y = ffi.new('double[]', n * nsys)
+    x = ffi.new('double[]', n * nsys)
+    work = ffi.new('double[]', 2 * n * nsys)
+    for i in range(n):
+        for s in range(nsys):
+            k = i * nsys + s
+            a[k] = -1. - s
+            b[k] = 4. + 2. * s
+            c[k] = -1.
+            y[k] = i + s
+    assert vic_lib.tridiag_batch(n, nsys, a, b, c, y, x, work) is None
+    for i in range(n):
+        for s in range(nsys):
+            k = i * nsys + s
+            res = b[k] * x[k] - y[k]
+            if i > 0:
+                res += a[k] * x[k - nsys]
+            if i < n - 1:
+                res += c[k] * x[k + nsys]
+            assert abs(res) < 1e-12
+
+
+def test_tridia_matches_batch():
+    n = 4
+    a = ffi.new('double[]', [0., -1., -1., -1.])
+    b = ffi.new('double[]', [3., 3., 3., 3.])
+    c = ffi.new('double[]', [-1., -1., -1., 0.])
+    y = ffi.new('double[]', [1., 2., 3., 4.])
+    x1 = ffi.new('double[]', n)
+    x2 = ffi.new('double[]', n)
+    work = ffi.new('double[]', 2 * n)
+    assert vic_lib.tridia(n, a, b, c, y, x1) is None
+    assert vic_lib.tridiag_batch(n, 1, a, b, c, y, x2, work) is None
+    for i in range(n):
+        assert x1[i] == x2[i]
@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+'''List, unpack and pack VIC classic driver cell container files.
+
+A cell container holds the per-cell files of many grid cells, one after the
+other, followed by an index of the cells and a trailer:
+
+    cell data ...
+    index:   ncells x (char name[48], uint64 offset, uint64 length)
+    trailer: uint64 ncells, uint64 index_offset, char magic[8] = "VICCELLS"
+
+The name of a cell is the "lat_lng" part of its per-cell file name. All
+numbers are in the byte order of the machine that wrote the file.
+'''
+
+from __future__ import print_function
+import argparse
+import os
+import struct
+
+MAGIC = b'VICCELLS'
+NAME_LEN = 48
+INDEX_ENTRY = struct.Struct('=%dsQQ' % NAME_LEN)
+TRAILER = struct.Struct('=QQ8s')
+
+
+def read_index(path):
+    '''Return the list of (name, offset, length) of a cell container'''
+    with open(path, 'rb') as f:
+        f.seek(-TRAILER.size, os.SEEK_END)
+        ncells, index_offset, magic = TRAILER.unpack(f.read(TRAILER.size))
+        if magic != MAGIC:
+            raise ValueError('%s is not a cell container' % path)
+        f.seek(index_offset)
+        index = []
+        for _ in range(ncells):
+            name, offset, length = INDEX_ENTRY.unpack(
+                f.read(INDEX_ENTRY.size))
+            index.append((name.rstrip(b'\0').decode(), offset, length))
+    return index
+
+
+def unpack(path, outdir, prefix, ext):
+    '''Write every cell of a container to its own per-cell file'''
+    with open(path, 'rb') as f:
+        for name, offset, length in read_index(path):
+            f.seek(offset)
+            outfile = os.path.join(outdir, '%s_%s%s' % (prefix, name, ext))
+            with open(outfile, 'wb') as out:
+                out.write(f.read(length))
+
+
+def cell_name(path):
+    '''Return the "lat_lng" part of a per-cell file name'''
+    base = os.path.basename(path)
+    for ext in ('.txt', '.bin'):
+        if base.endswith(ext):
+            base = base[:-len(ext)]
+    return '_'.join(base.split('_')[-2:])
+
+
+def pack(path, cellfiles):
+    '''Write per-cell files (e.g. forcing files) into one cell container'''
+    index = []
+    with open(path, 'wb') as out:
+        for cellfile in cellfiles:
+            name = cell_name(cellfile).encode()
+            if len(name) >= NAME_LEN:
+                raise ValueError('cell name of %s is too long' % cellfile)
+            with open(cellfile, 'rb') as f:
+                data = f.read()
+            index.append((name, out.tell(), len(data)))
+            out.write(data)
+        index_offset = out.tell()
+        for entry in index:
+            out.write(INDEX_ENTRY.pack(*entry))
+        out.write(TRAILER.pack(len(index), index_offset, MAGIC))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    subparsers = parser.add_subparsers(dest='command')
+
+    p = subparsers.add_parser('list', help='list the cells of a container')
+    p.add_argument('container')
+
+    p = subparsers.add_parser('unpack', help='write one file per cell')
+    p.add_argument('container')
+    p.add_argument('--outdir', default='.',
+                   help='directory of the per-cell files')
+    p.add_argument('--prefix', required=True,
+                   help='prefix of the per-cell files, e.g. fluxes')
+    p.add_argument('--ext', default='.txt',
+                   help='extension of the per-cell files (.txt or .bin)')
+
+    p = subparsers.add_parser('pack', help='pack per-cell files')
+    p.add_argument('container')
+    p.add_argument('cellfiles', nargs='+')
+
+    args = parser.parse_args()
+    if args.command == 'list':
+        for name, offset, length in read_index(args.container):
+            print(name, offset, length)
+    elif args.command == 'unpack':
+        unpack(args.container, args.outdir, args.prefix, args.ext)
+    elif args.command == 'pack':
+        pack(args.container, args.cellfiles)
+    else:
+        parser.print_help()
+
+
+if __name__ == '__main__':
+    main()
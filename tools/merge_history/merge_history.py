@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+'''Merge the split history files of a record into one history file.
+
+With OUT_SPLIT, the image driver writes the history files of a record over
+groups of processes (prefix.<date>.<group>.nc). Each of these files holds the
+active cells of its group along a "land" dimension, and the "land" variable
+holds the index of each cell in the grid, with the names of the two grid
+dimensions in its "compress" attribute (CF compression by gathering).
+
+The merged file has the variables on the full grid, with the fill value in
+the cells that are not in any of the files.
+'''
+
+from __future__ import print_function
+import argparse
+
+import netCDF4
+import numpy as np
+
+LAND = 'land'
+SPLIT_ATTRS = ('split_file', 'split_nfiles')
+
+
+def check_files(datasets):
+    '''Check that the files are the complete split files of one record'''
+    nfiles = int(datasets[0].getncattr('split_nfiles'))
+    groups = sorted(int(ds.getncattr('split_file')) for ds in datasets)
+    if groups != list(range(nfiles)):
+        raise ValueError('expected the %d split files of the record, got '
+                         'the files of groups %s' % (nfiles, groups))
+
+
+def merge(outfile, infiles):
+    '''Merge split history files into one history file on the full grid'''
+    datasets = sorted((netCDF4.Dataset(f) for f in infiles),
+                      key=lambda ds: int(ds.getncattr('split_file')))
+    try:
+        check_files(datasets)
+        first = datasets[0]
+        ydim, xdim = first.variables[LAND].getncattr('compress').split()
+        shape = (len(first.dimensions[ydim]), len(first.dimensions[xdim]))
+
+        with netCDF4.Dataset(outfile, 'w', format=first.data_model) as out:
+            out.setncatts(dict((k, first.getncattr(k))
+                               for k in first.ncattrs()
+                               if k not in SPLIT_ATTRS))
+            for name, dim in first.dimensions.items():
+                if name != LAND:
+                    out.createDimension(
+                        name, None if dim.isunlimited() else len(dim))
+
+            for name, var in first.variables.items():
+                if name == LAND:
+                    continue
+                dims = var.dimensions
+                if LAND in dims:
+                    dims = dims[:-1] + (ydim, xdim)
+                fill = var.getncattr('_FillValue') \
+                    if '_FillValue' in var.ncattrs() else None
+                outvar = out.createVariable(name, var.dtype, dims,
+                                            fill_value=fill)
+                outvar.setncatts(dict((k, var.getncattr(k))
+                                      for k in var.ncattrs()
+                                      if k != '_FillValue'))
+
+                if LAND not in var.dimensions:
+                    outvar[:] = var[:]
+                    continue
+
+                # the cells of every file are moved to their grid cells
+                ntime = max(len(ds.dimensions['time']) for ds in datasets)
+                grid = np.ma.masked_all((ntime, ) + var.shape[1:-1] +
+                                        (shape[0] * shape[1], ),
+                                        dtype=var.dtype)
+                for ds in datasets:
+                    cells = ds.variables[LAND][:]
+                    values = ds.variables[name][:]
+                    grid[:values.shape[0], ..., cells] = values
+                outvar[:] = grid.reshape(grid.shape[:-1] + shape)
+    finally:
+        for ds in datasets:
+            ds.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('outfile', help='merged history file')
+    parser.add_argument('infiles', nargs='+',
+                        help='split history files of the record')
+    args = parser.parse_args()
+    merge(args.outfile, args.infiles)
+
+
+if __name__ == '__main__':
+    main()
@@ -169,7 +169,7 @@ void print_case_metadata(case_metadata *cmeta);
 void print_l2x_data(l2x_data_struct *l2x);
 void print_vic_clock(vic_clock *vclock);
 void print_x2l_data(x2l_data_struct *x2l);
-void read_rpointer_file(char *fname);
+void read_rpointer_file(char *fname, unsigned short int *state_format);
 unsigned short int start_type_from_char(char *start_str);
 char *trim(char *str);
 void validate_filenames(filenames_struct *filenames);
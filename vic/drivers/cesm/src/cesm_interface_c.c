@@ -30,6 +30,7 @@ size_t              NF, NR;
 size_t              current;
 size_t             *filter_active_cells = NULL;
 size_t             *mpi_map_mapping_array = NULL;
+size_t             *mpi_map_grid_array = NULL;
 all_vars_struct    *all_vars = NULL;
 force_data_struct  *force = NULL;
 x2l_data_struct    *x2l_vic = NULL;
@@ -40,7 +41,9 @@ filep_struct        filep;
 domain_struct       global_domain;
 domain_struct       local_domain;
 global_param_struct global_param;
-lake_con_struct     lake_con;
+lake_con_struct    *lake_con = NULL;
+size_t             *lake_cells = NULL;  // [nlake_cells]
+size_t              nlake_cells = 0;
 MPI_Comm            MPI_COMM_VIC;
 MPI_Datatype        mpi_domain_struct_type;
 MPI_Datatype        mpi_global_struct_type;
@@ -181,6 +181,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "IMPLICIT\t\tFALSE\n");
     }
+    if (options.ANALYTIC_JACOBIAN) {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tFALSE\n");
+    }
     if (options.NOFLUX) {
         fprintf(LOG_DEST, "NOFLUX\t\t\tTRUE\n");
     }
@@ -199,6 +205,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "QUICK_SOLVE\t\tFALSE\n");
     }
+    if (options.QUIESCENT_SOIL) {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tFALSE\n");
+    }
     if (options.SPATIAL_FROST) {
         fprintf(LOG_DEST, "SPATIAL_FROST\t\tTRUE\n");
         fprintf(LOG_DEST, "Nfrost\t\t%zu\n", options.Nfrost);
@@ -224,6 +236,24 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "TFALLBACK\t\tFALSE\n");
     }
+    if (options.TSURF_NEWTON) {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tFALSE\n");
+    }
+    if (options.ROOT_RETRY) {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tFALSE\n");
+    }
+    if (options.FAST_SVP) {
+        fprintf(LOG_DEST, "FAST_SVP\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FAST_SVP\t\tFALSE\n");
+    }
     fprintf(LOG_DEST, "WIND_H\t\t\t%f\n", global_param.wind_h);
     fprintf(LOG_DEST, "NODES\t\t\t%zu\n", options.Nnode);
     if (options.CARBON) {
@@ -374,6 +404,9 @@ display_current_settings(int mode)
         else if (options.STATE_FORMAT == NETCDF4) {
             fprintf(LOG_DEST, "STATE_FORMAT\t\tNETCDF4\n");
         }
+        else if (options.STATE_FORMAT == BINARY_FAST) {
+            fprintf(LOG_DEST, "STATE_FORMAT\t\tBINARY_FAST\n");
+        }
     }
     else {
         fprintf(LOG_DEST, "INIT_STATE\t\tFALSE\n");
@@ -399,11 +432,18 @@ display_current_settings(int mode)
         else if (options.STATE_FORMAT == NETCDF4) {
             fprintf(LOG_DEST, "STATE_FORMAT\t\tNETCDF4\n");
         }
+        else if (options.STATE_FORMAT == BINARY_FAST) {
+            fprintf(LOG_DEST, "STATE_FORMAT\t\tBINARY_FAST\n");
+        }
     }
     else {
         fprintf(LOG_DEST, "SAVE_STATE\t\tFALSE\n");
     }
 
+    fprintf(LOG_DEST, "\n");
+    fprintf(LOG_DEST, "Parallelization:\n");
+    fprintf(LOG_DEST, "NTHREADS\t\t%zu\n", options.NTHREADS);
+
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "Output Data:\n");
     fprintf(LOG_DEST, "Result dir:\t\t%s\n", filenames.result_dir);
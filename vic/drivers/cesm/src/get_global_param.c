@@ -92,6 +92,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.QUICK_SOLVE = str_to_bool(flgstr);
             }
+            else if (strcasecmp("QUIESCENT_SOIL", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.QUIESCENT_SOIL = str_to_bool(flgstr);
+            }
             else if ((strcasecmp("NOFLUX",
                                  optstr) == 0) ||
                      (strcasecmp("NO_FLUX", optstr) == 0)) {
@@ -104,6 +108,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.IMPLICIT = str_to_bool(flgstr);
             }
+            else if (strcasecmp("ANALYTIC_JACOBIAN", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ANALYTIC_JACOBIAN = str_to_bool(flgstr);
+            }
             else if (strcasecmp("EXP_TRANS", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.EXP_TRANS = str_to_bool(flgstr);
@@ -144,6 +152,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.BLOWING_SPATIAL_WIND = str_to_bool(flgstr);
             }
+            else if (strcasecmp("BLOWING_FAST", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.BLOWING_FAST = str_to_bool(flgstr);
+            }
             else if (strcasecmp("CORRPREC", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.CORRPREC = str_to_bool(flgstr);
@@ -210,6 +222,18 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.TFALLBACK = str_to_bool(flgstr);
             }
+            else if (strcasecmp("TSURF_NEWTON", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.TSURF_NEWTON = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("ROOT_RETRY", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ROOT_RETRY = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("FAST_SVP", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.FAST_SVP = str_to_bool(flgstr);
+            }
             else if (strcasecmp("SHARE_LAYER_MOIST", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.SHARE_LAYER_MOIST = str_to_bool(flgstr);
@@ -234,6 +258,13 @@ get_global_param(FILE *gp)
                 }
             }
 
+            /*************************************
+               Define parallelization options
+            *************************************/
+            else if (strcasecmp("NTHREADS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.NTHREADS);
+            }
+
             /*************************************
                Define log directory
             *************************************/
@@ -265,9 +296,13 @@ get_global_param(FILE *gp)
                 else if (strcasecmp("NETCDF4", flgstr) == 0) {
                     options.STATE_FORMAT = NETCDF4;
                 }
+                else if (strcasecmp("BINARY_FAST", flgstr) == 0) {
+                    options.STATE_FORMAT = BINARY_FAST;
+                }
                 else {
                     log_err("STATE_FORMAT must be either NETCDF3_CLASSIC, "
-                            "NETCDF3_64BIT_OFFSET, NETCDF4_CLASSIC, or NETCDF4.");
+                            "NETCDF3_64BIT_OFFSET, NETCDF4_CLASSIC, NETCDF4, "
+                            "or BINARY_FAST.");
                 }
             }
 
@@ -513,6 +548,20 @@ validate_global_param(global_param_struct *gp)
 void
 validate_options(option_struct *options)
 {
+    // Validate parallelization options
+    if (options->NTHREADS < 1) {
+        log_err("NTHREADS must be at least 1. Currently NTHREADS is set to "
+                "%zu.", options->NTHREADS);
+    }
+#ifndef _OPENMP
+    if (options->NTHREADS > 1) {
+        log_warn("NTHREADS = %zu, but VIC was compiled without OpenMP "
+                 "support.  Grid cells will be run on a single thread.",
+                 options->NTHREADS);
+        options->NTHREADS = 1;
+    }
+#endif
+
     // Validate SPATIAL_FROST information
     if (options->SPATIAL_FROST) {
         if (options->Nfrost > MAX_FROST_AREAS) {
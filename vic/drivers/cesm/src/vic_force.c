@@ -27,261 +27,249 @@
 #include <vic_driver_cesm.h>
 
 /******************************************************************************
- * @brief    Read atmospheric forcing data.
+ * @brief    Unpack the coupler fields of one cell into its forcing data.
+ *
+ * @note     The coupler delivers one value per field and coupling step, so the
+ *           sub-steps of the forcing arrays all hold the same values and the
+ *           step average in the NR field equals the sub-step value. The
+ *           derived quantities are therefore computed once per cell and the
+ *           sub-step replication is skipped when NF == 1 (the coupled case,
+ *           where NR == 0).
  *****************************************************************************/
-void
-vic_force(void)
+static void
+x2l_to_force(x2l_data_struct   *x2l,
+             soil_con_struct   *soil_con_i,
+             location_struct   *location,
+             force_data_struct *cell_force)
 {
     extern size_t              NF;
     extern size_t              NR;
-    extern size_t              current;
-    extern force_data_struct  *force;
-    extern x2l_data_struct    *x2l_vic;
     extern dmy_struct          dmy_current;
-    extern domain_struct       global_domain;
-    extern domain_struct       local_domain;
-    extern filenames_struct    filenames;
     extern global_param_struct global_param;
     extern option_struct       options;
-    extern soil_con_struct    *soil_con;
-    extern veg_con_map_struct *veg_con_map;
-    extern veg_hist_struct   **veg_hist;
-    extern veg_lib_struct    **veg_lib;
     extern parameters_struct   param;
 
-    double                     t_offset;
-    size_t                     i;
+    double                     air_temp;
+    double                     prec;
+    double                     shortwave;
+    double                     longwave;
+    double                     wind;
+    double                     pressure;
+    double                     vp;
+    double                     vpd;
+    double                     density;
+    double                     fdir = 0.;
+    double                     Catm = 0.;
+    double                     coszen = 0.;
+    double                     channel_in = 0.;
+    char                       snowflag;
     size_t                     j;
-    size_t                     v;
-    int                        vidx;
-
-    // Check to make sure variables have been set by coupler
-    for (i = 0; i < local_domain.ncells_active; i++) {
-        if (!x2l_vic[i].x2l_vars_set) {
-            if (current == 0) {
-                make_dummy_forcings(&x2l_vic[i]);
-            }
-            else {
-                log_err("x2l_vars_set is false");
-            }
-        }
-    }
 
     // Air temperature
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: K
-            // VIC units: C
-            force[i].air_temp[j] = x2l_vic[i].x2l_Sa_tbot - CONST_TKFRZ;
-        }
-    }
+    // CESM units: K
+    // VIC units: C
+    air_temp = x2l->x2l_Sa_tbot - CONST_TKFRZ;
 
     // Precipitation
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: km m-2 s-1
-            // VIC units: mm / timestep
-            // Note: VIC does not use liquid/solid precip partitioning
-            force[i].prec[j] = (x2l_vic[i].x2l_Faxa_rainc +
-                                x2l_vic[i].x2l_Faxa_rainl +
-                                x2l_vic[i].x2l_Faxa_snowc +
-                                x2l_vic[i].x2l_Faxa_snowl) *
-                               global_param.snow_dt;
-        }
-    }
+    // CESM units: km m-2 s-1
+    // VIC units: mm / timestep
+    // Note: VIC does not use liquid/solid precip partitioning
+    prec = (x2l->x2l_Faxa_rainc + x2l->x2l_Faxa_rainl +
+            x2l->x2l_Faxa_snowc + x2l->x2l_Faxa_snowl) * global_param.snow_dt;
 
     // Downward solar radiation
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: W m-2
-            // VIC units: W m-2
-            // Note: VIC does not use partitioned shortwave fluxes.
-            force[i].shortwave[j] = (x2l_vic[i].x2l_Faxa_swndr +
-                                     x2l_vic[i].x2l_Faxa_swvdr +
-                                     x2l_vic[i].x2l_Faxa_swndf +
-                                     x2l_vic[i].x2l_Faxa_swvdf);
-        }
-    }
+    // CESM units: W m-2
+    // VIC units: W m-2
+    // Note: VIC does not use partitioned shortwave fluxes.
+    shortwave = (x2l->x2l_Faxa_swndr + x2l->x2l_Faxa_swvdr +
+                 x2l->x2l_Faxa_swndf + x2l->x2l_Faxa_swvdf);
 
     // Downward longwave radiation
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: W m-2
-            // VIC units: W m-2
-            force[i].longwave[j] = x2l_vic[i].x2l_Faxa_lwdn;
-        }
-    }
+    // CESM units: W m-2
+    // VIC units: W m-2
+    longwave = x2l->x2l_Faxa_lwdn;
 
     // Wind speed
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: m s-1
-            // VIC units: m s-1
-            // Note: VIC does not use partitioned wind speeds
-            force[i].wind[j] = sqrt(pow(x2l_vic[i].x2l_Sa_u, 2) +
-                                    pow(x2l_vic[i].x2l_Sa_v, 2));
-        }
-    }
+    // CESM units: m s-1
+    // VIC units: m s-1
+    // Note: VIC does not use partitioned wind speeds
+    wind = sqrt(x2l->x2l_Sa_u * x2l->x2l_Sa_u + x2l->x2l_Sa_v * x2l->x2l_Sa_v);
 
     // Pressure
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: Pa
-            // VIC units: kPa
-            force[i].pressure[j] = x2l_vic[i].x2l_Sa_pbot / PA_PER_KPA;
-        }
-    }
+    // CESM units: Pa
+    // VIC units: kPa
+    pressure = x2l->x2l_Sa_pbot / PA_PER_KPA;
 
     // Vapor Pressure
-    for (j = 0; j < NF; j++) {
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            // CESM units: shum is specific humidity (g/g)
-            // VIC units: kPa
-            force[i].vp[j] = q_to_vp(x2l_vic[i].x2l_Sa_shum,
-                                     force[i].pressure[j]);
-        }
-    }
+    // CESM units: shum is specific humidity (g/g)
+    // VIC units: kPa
+    vp = q_to_vp(x2l->x2l_Sa_shum, pressure);
+
+    // vapor pressure deficit
+    vpd = svp(air_temp) - vp;
+    // air density
+    density = air_density(air_temp, pressure);
+    // snow flag (SNOW_BAND > 1 is not implemented, so t_offset is 0)
+    snowflag = will_it_snow(&air_temp, 0., param.SNOW_MAX_SNOW_TEMP, &prec, 1);
 
     if (options.CARBON) {
         // Fraction of incoming shortwave that is direct
-        for (j = 0; j < NF; j++) {
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                // CESM units: n/a (calculated from SW fluxes)
-                // VIC units: fraction
-                if (force[i].shortwave[j] != 0.) {
-                    force[i].fdir[j] = (x2l_vic[i].x2l_Faxa_swndr +
-                                        x2l_vic[i].x2l_Faxa_swvdr) /
-                                       (x2l_vic[i].x2l_Faxa_swndf +
-                                        x2l_vic[i].x2l_Faxa_swvdf);
-                }
-                else {
-                    force[i].fdir[j] = 0.;
-                }
-            }
+        // CESM units: n/a (calculated from SW fluxes)
+        // VIC units: fraction
+        if (shortwave != 0.) {
+            fdir = (x2l->x2l_Faxa_swndr + x2l->x2l_Faxa_swvdr) /
+                   (x2l->x2l_Faxa_swndf + x2l->x2l_Faxa_swvdf);
         }
 
         // Concentration of CO2
-        for (j = 0; j < NF; j++) {
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                // CESM units: 1e-6 mol/mol
-                // VIC units: mol CO2/ mol air
-                force[i].Catm[j] = 1e6 * x2l_vic[i].x2l_Sa_co2prog;
-            }
-        }
+        // CESM units: 1e-6 mol/mol
+        // VIC units: mol CO2/ mol air
+        Catm = 1e6 * x2l->x2l_Sa_co2prog;
 
         // Cosine of solar zenith angle
-        for (j = 0; j < NF; j++) {
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                force[i].coszen[j] = compute_coszen(
-                    local_domain.locations[i].latitude,
-                    local_domain.locations[i].longitude,
-                    soil_con[i].time_zone_lng, dmy_current.day_in_year,
-                    dmy_current.dayseconds);
-            }
-        }
+        coszen = compute_coszen(location->latitude, location->longitude,
+                                soil_con_i->time_zone_lng,
+                                dmy_current.day_in_year,
+                                dmy_current.dayseconds);
     }
 
     if (options.LAKES) {
         // incoming channel inflow
-        for (j = 0; j < NF; j++) {
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                // CESM units: kg m-2 s-1
-                // VIC units: mm
-                force[i].channel_in[j] = x2l_vic[i].x2l_Flrr_flood *
-                                         global_param.snow_dt;
-            }
-        }
+        // CESM units: kg m-2 s-1
+        // VIC units: mm
+        channel_in = x2l->x2l_Flrr_flood * global_param.snow_dt;
     }
 
-    if (options.SNOW_BAND > 1) {
-        log_err("SNOW_BAND not implemented");
-    }
-    else {
-        t_offset = 0;
-    }
-
-    // Convert forcings into what we need and calculate missing ones
-    for (i = 0; i < local_domain.ncells_active; i++) {
-        for (j = 0; j < NF; j++) {
-            // vapor pressure deficit
-            force[i].vpd[j] = svp(force[i].air_temp[j]) - force[i].vp[j];
-            // photosynthetically active radiation
-            // TODO: Add CARBON_SW2PAR back to the parameters structure
-            // force[i].par[j] = param.CARBON_SW2PAR * force[i].shortwave[j];
-            // air density
-            force[i].density[j] = air_density(force[i].air_temp[j],
-                                              force[i].pressure[j]);
-            // snow flag
-            force[i].snowflag[j] = will_it_snow(&(force[i].air_temp[j]),
-                                                t_offset,
-                                                param.SNOW_MAX_SNOW_TEMP,
-                                                &(force[i].prec[j]), 1);
+    // Sub-step values; with NF == 1 this is the NR field
+    for (j = 0; j < NF; j++) {
+        cell_force->air_temp[j] = air_temp;
+        cell_force->prec[j] = prec;
+        cell_force->shortwave[j] = shortwave;
+        cell_force->longwave[j] = longwave;
+        cell_force->wind[j] = wind;
+        cell_force->pressure[j] = pressure;
+        cell_force->vp[j] = vp;
+        cell_force->vpd[j] = vpd;
+        cell_force->density[j] = density;
+        cell_force->snowflag[j] = snowflag;
+        // photosynthetically active radiation
+        // TODO: Add CARBON_SW2PAR back to the parameters structure
+        // cell_force->par[j] = param.CARBON_SW2PAR * shortwave;
+        if (options.CARBON) {
+            cell_force->fdir[j] = fdir;
+            cell_force->Catm[j] = Catm;
+            cell_force->coszen[j] = coszen;
+        }
+        if (options.LAKES) {
+            cell_force->channel_in[j] = channel_in;
         }
     }
 
-
-    // Put average value in NR field
-    for (i = 0; i < local_domain.ncells_active; i++) {
-        force[i].air_temp[NR] = average(force[i].air_temp, NF);
+    // Step values in the NR field (averages of identical sub-steps)
+    if (NF > 1) {
+        cell_force->air_temp[NR] = air_temp;
         // For precipitation put total
-        force[i].prec[NR] = average(force[i].prec, NF) * NF;
-        force[i].shortwave[NR] = average(force[i].shortwave, NF);
-        force[i].longwave[NR] = average(force[i].longwave, NF);
-        force[i].pressure[NR] = average(force[i].pressure, NF);
-        force[i].wind[NR] = average(force[i].wind, NF);
-        force[i].vp[NR] = average(force[i].vp, NF);
-        force[i].vpd[NR] = (svp(force[i].air_temp[NR]) - force[i].vp[NR]);
-        force[i].density[NR] = air_density(force[i].air_temp[NR],
-                                           force[i].pressure[NR]);
-        force[i].snowflag[NR] = will_it_snow(force[i].air_temp, t_offset,
-                                             param.SNOW_MAX_SNOW_TEMP,
-                                             force[i].prec, NF);
-
-        // Optional inputs
+        cell_force->prec[NR] = prec * NF;
+        cell_force->shortwave[NR] = shortwave;
+        cell_force->longwave[NR] = longwave;
+        cell_force->pressure[NR] = pressure;
+        cell_force->wind[NR] = wind;
+        cell_force->vp[NR] = vp;
+        cell_force->vpd[NR] = vpd;
+        cell_force->density[NR] = density;
+        cell_force->snowflag[NR] = snowflag;
         if (options.LAKES) {
-            force[i].channel_in[NR] = average(force[i].channel_in, NF) * NF;
+            cell_force->channel_in[NR] = channel_in * NF;
         }
         if (options.CARBON) {
-            force[i].Catm[NR] = average(force[i].Catm, NF);
-            force[i].fdir[NR] = average(force[i].fdir, NF);
-            force[i].par[NR] = average(force[i].par, NF);
-            // for coszen, use value at noon
-            force[i].coszen[NR] = compute_coszen(
-                local_domain.locations[i].latitude,
-                local_domain.locations[i].longitude, soil_con[i].time_zone_lng,
-                dmy_current.day_in_year, SEC_PER_DAY / 2);
+            cell_force->Catm[NR] = Catm;
+            cell_force->fdir[NR] = fdir;
         }
     }
+    if (options.CARBON) {
+        // for coszen, use value at noon
+        cell_force->coszen[NR] = compute_coszen(location->latitude,
+                                                location->longitude,
+                                                soil_con_i->time_zone_lng,
+                                                dmy_current.day_in_year,
+                                                SEC_PER_DAY / 2);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read atmospheric forcing data.
+ *
+ * @note     In coupled mode the forcings come from the coupler fields in
+ *           x2l_vic, so none of the forcing file machinery of the image driver
+ *           is used. The forcing and veg_hist arrays are allocated once at
+ *           initialization and are filled in place in a single pass over the
+ *           local cells.
+ *****************************************************************************/
+void
+vic_force(void)
+{
+    extern size_t              NF;
+    extern size_t              NR;
+    extern size_t              current;
+    extern force_data_struct  *force;
+    extern x2l_data_struct    *x2l_vic;
+    extern dmy_struct          dmy_current;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_map_struct *veg_con_map;
+    extern veg_con_struct    **veg_con;
+    extern veg_hist_struct   **veg_hist;
+
+    size_t                     i;
+    size_t                     j;
+    size_t                     m;
+    int                        vidx;
+    veg_con_struct            *cell_veg_con;
+    veg_hist_struct           *cell_veg_hist;
+
+    if (options.SNOW_BAND > 1) {
+        log_err("SNOW_BAND not implemented");
+    }
+
+    m = dmy_current.month - 1;
 
-    // Update the veg_hist structure with the current vegetation parameters.
-    // Currently only implemented for climatological values in image mode
     for (i = 0; i < local_domain.ncells_active; i++) {
-        for (v = 0; v < options.NVEGTYPES; v++) {
-            vidx = veg_con_map[i].vidx[v];
-            if (vidx != NODATA_VEG) {
-                for (j = 0; j < NF; j++) {
-                    veg_hist[i][vidx].albedo[j] =
-                        veg_lib[i][v].albedo[dmy_current.month - 1];
-                    veg_hist[i][vidx].displacement[j] =
-                        veg_lib[i][v].displacement[dmy_current.month - 1];
-                    veg_hist[i][vidx].fcanopy[j] =
-                        veg_lib[i][v].fcanopy[dmy_current.month - 1];
-                    veg_hist[i][vidx].LAI[j] =
-                        veg_lib[i][v].LAI[dmy_current.month - 1];
-                    veg_hist[i][vidx].roughness[j] =
-                        veg_lib[i][v].roughness[dmy_current.month - 1];
-                }
+        // Check to make sure variables have been set by coupler
+        if (!x2l_vic[i].x2l_vars_set) {
+            if (current == 0) {
+                make_dummy_forcings(&x2l_vic[i]);
+            }
+            else {
+                log_err("x2l_vars_set is false");
+            }
+        }
+
+        x2l_to_force(&x2l_vic[i], &soil_con[i], &local_domain.locations[i],
+                     &force[i]);
+
+        // Update the veg_hist structure with the current vegetation
+        // parameters. Currently only implemented for climatological values.
+        for (vidx = 0; vidx < (int) veg_con_map[i].nv_classes; vidx++) {
+            cell_veg_con = &veg_con[i][vidx];
+            cell_veg_hist = &veg_hist[i][vidx];
+            // with NF == 1 the sub-step is the NR field; otherwise the
+            // average of the identical sub-steps is the climatological value
+            for (j = 0; j < NF; j++) {
+                cell_veg_hist->albedo[j] = cell_veg_con->albedo[m];
+                cell_veg_hist->displacement[j] = cell_veg_con->displacement[m];
+                cell_veg_hist->fcanopy[j] = cell_veg_con->fcanopy[m];
+                cell_veg_hist->LAI[j] = cell_veg_con->LAI[m];
+                cell_veg_hist->roughness[j] = cell_veg_con->roughness[m];
+            }
+            if (NF > 1) {
                 // not the correct way to calculate average albedo, but leave
                 // for now
-                veg_hist[i][vidx].albedo[NR] = average(veg_hist[i][vidx].albedo,
-                                                       NF);
-                veg_hist[i][vidx].displacement[NR] = average(
-                    veg_hist[i][vidx].displacement, NF);
-                veg_hist[i][vidx].fcanopy[NR] = average(
-                    veg_hist[i][vidx].fcanopy, NF);
-                veg_hist[i][vidx].LAI[NR] = average(veg_hist[i][vidx].LAI, NF);
-                veg_hist[i][vidx].roughness[NR] = average(
-                    veg_hist[i][vidx].roughness, NF);
+                cell_veg_hist->albedo[NR] = cell_veg_con->albedo[m];
+                cell_veg_hist->displacement[NR] = cell_veg_con->displacement[m];
+                cell_veg_hist->fcanopy[NR] = cell_veg_con->fcanopy[m];
+                cell_veg_hist->LAI[NR] = cell_veg_con->LAI[m];
+                cell_veg_hist->roughness[NR] = cell_veg_con->roughness[m];
             }
         }
     }
@@ -293,9 +281,6 @@ vic_force(void)
 void
 make_dummy_forcings(x2l_data_struct *x2l)
 {
-    extern x2l_data_struct *x2l_vic;
-    extern domain_struct    local_domain;
-
     x2l->x2l_Sa_z = 10;  /** bottom atm level height */
     x2l->x2l_Sa_u = 1.;  /** bottom atm level zon wind */
     x2l->x2l_Sa_v = 1.;  /** bottom atm level mer wind */
@@ -43,6 +43,8 @@ vic_populate_model_state(char *runtype_str)
 
     size_t                  i;
     unsigned short int      runtype;
+    unsigned short int      state_format;
+    unsigned short int      save_format;
 
     debug("In vic_populate_model_state");
 
@@ -50,15 +52,19 @@ vic_populate_model_state(char *runtype_str)
 
     // read the model state from the netcdf file
     if (runtype == CESM_RUNTYPE_RESTART || runtype == CESM_RUNTYPE_BRANCH) {
-        // Get restart file from rpointer file
-        read_rpointer_file(filenames.init_state);
+        // Get restart file and its format from rpointer file
+        read_rpointer_file(filenames.init_state, &state_format);
 
         // set options.INIT_STATE to true since we have found a state file in
         // the rpointer file.
         options.INIT_STATE = true;
 
-        // read initial state file -- specified in rpointer file
+        // read initial state file -- specified in rpointer file -- in the
+        // format it was written in, the next states keep STATE_FORMAT
+        save_format = options.STATE_FORMAT;
+        options.STATE_FORMAT = state_format;
         vic_restore();
+        options.STATE_FORMAT = save_format;
     }
     else if (runtype == CESM_RUNTYPE_CLEANSTART) {
         if (options.INIT_STATE) {
@@ -70,7 +76,7 @@ vic_populate_model_state(char *runtype_str)
             for (i = 0; i < local_domain.ncells_active; i++) {
                 generate_default_state(&(all_vars[i]), &(soil_con[i]),
                                        veg_con[i]);
-                if (options.LAKES) {
+                if (all_vars[i].lake_var != NULL) {
                     generate_default_lake_state(&(all_vars[i]), &(soil_con[i]),
                                                 lake_con[i]);
                 }
@@ -81,9 +87,9 @@ vic_populate_model_state(char *runtype_str)
     // compute those state variables that are derived from the others
     for (i = 0; i < local_domain.ncells_active; i++) {
         compute_derived_state_vars(&(all_vars[i]), &(soil_con[i]), veg_con[i]);
-        if (options.LAKES) {
-            compute_derived_lake_dimensions(&(all_vars[i].lake_var),
-                                            lake_con[i]);
+        if (all_vars[i].lake_var != NULL) {
+            compute_derived_lake_dimensions(all_vars[i].lake_var,
+                                            &(lake_con[i]));
         }
     }
 }
@@ -111,44 +117,98 @@ start_type_from_char(char *start_str)
 
 /******************************************************************************
  * @brief Read rpointer file
+ * @details The first line that is not a comment is the name of the state.
+ *          It may be followed by the STATE_FORMAT of the state and, for
+ *          BINARY_FAST, the number of STATE_FILES, i.e. the number of
+ *          processes that wrote it. A pointer file without STATE_FORMAT
+ *          points to a netCDF state.
  *****************************************************************************/
 void
-read_rpointer_file(char *fname)
+read_rpointer_file(char               *fname,
+                   unsigned short int *state_format)
 {
-    FILE *fp = NULL;
-    char  linestr[MAXSTRING];
+    extern option_struct options;
+
+    FILE                *fp = NULL;
+    char                 linestr[MAXSTRING];
+    char                 key[MAXSTRING];
+    char                 value[MAXSTRING];
+    bool                 found = false;
+
+    // any netCDF format reads a netCDF state
+    *state_format = options.STATE_FORMAT;
+    if (*state_format == BINARY_FAST) {
+        *state_format = NETCDF4_CLASSIC;
+    }
 
     fp = open_file(RPOINTER, "r");
 
-    fgets(linestr, MAXSTRING, fp);
-
-    // Read through rpointer file file to find state file name
-    while (!feof(fp)) {
-        if (linestr[0] != '#' && linestr[0] != '\n' && linestr[0] != '\0') {
+    // Read through rpointer file file to find state file name and format
+    while (fgets(linestr, MAXSTRING, fp) != NULL) {
+        if (linestr[0] == '#' || linestr[0] == '\n' || linestr[0] == '\0') {
+            continue;
+        }
+        if (!found) {
             sscanf(linestr, "%s", fname);
-            break;
+            found = true;
+        }
+        else if (sscanf(linestr, "%s %s", key, value) == 2 &&
+                 strcasecmp("STATE_FORMAT", key) == 0 &&
+                 strcasecmp("BINARY_FAST", value) == 0) {
+            *state_format = BINARY_FAST;
         }
-        fgets(linestr, MAXSTRING, fp);
     }
     fclose(fp);
 
-    // remove trailing newline if present
-    fname[strcspn(fname, "\n")] = 0;
+    if (!found) {
+        log_err("No state file in %s", RPOINTER);
+    }
 }
 
 /******************************************************************************
  * @brief Write rpointer file
+ * @details Called by all nodes. The master node writes the pointer file
+ *          once the state is complete, first to a temporary file that
+ *          replaces the previous pointer file, so that the pointer file
+ *          always points to a complete state.
  *****************************************************************************/
 void
 write_rpointer_file(char *fname)
 {
-    FILE *fp = NULL;
-    char *header = "# VIC CESM Driver restart pointer file\n";
+    extern option_struct options;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+
+    FILE                *fp = NULL;
+    char                *header = "# VIC CESM Driver restart pointer file\n";
+    char                 tmp_fname[MAXSTRING];
+    int                  status;
+
+    // every node writes the BINARY_FAST state file of its own cells
+    if (options.STATE_FORMAT == BINARY_FAST) {
+        status = MPI_Barrier(MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
+    if (mpi_rank != VIC_MPI_ROOT) {
+        return;
+    }
 
-    fp = open_file(RPOINTER, "w");
+    snprintf(tmp_fname, MAXSTRING, "%s.tmp", RPOINTER);
+    fp = open_file(tmp_fname, "w");
 
-    fprintf(fp, header, fname);
+    fprintf(fp, "%s", header);
     fprintf(fp, "%s\n", fname);
+    if (options.STATE_FORMAT == BINARY_FAST) {
+        fprintf(fp, "STATE_FORMAT BINARY_FAST\n");
+        fprintf(fp, "STATE_FILES %d\n", mpi_size);
+    }
+    else {
+        fprintf(fp, "STATE_FORMAT NETCDF\n");
+    }
 
     fclose(fp);
+    if (rename(tmp_fname, RPOINTER) != 0) {
+        log_err("Unable to rename %s to %s", tmp_fname, RPOINTER);
+    }
 }
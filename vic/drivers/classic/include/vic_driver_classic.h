@@ -28,12 +28,31 @@
 #define VIC_DRIVER_CLASSIC_H
 
 #include <vic_driver_shared_all.h>
+#include <stdint.h>
 
 #define VIC_DRIVER "Classic"
 
 #define BINHEADERSIZE 256
 #define MAX_VEGPARAM_LINE_LENGTH 500
 #define ASCII_STATE_FLOAT_FMT "%.16g"
+#define FORCE_READ_BLOCK 8192  /**< records per read of binary forcing files */
+#define OUT_BUFFER_SIZE 65536  /**< bytes of output buffered per stream */
+#define MAX_FIXED_DIGITS 32    /**< max length of a formatted output value */
+#define FIXED_FORMAT_MAX 1e12  /**< max scaled value printed by sprint_fixed */
+#define FIXED_FORMAT_TIE 1e-3  /**< distance from a rounding tie below which
+                                    sprint_fixed falls back to printf */
+#define CELL_CONTAINER_EXT ".cells"     /**< extension of cell containers */
+#define CELL_CONTAINER_MAGIC "VICCELLS" /**< last 8 bytes of a cell container */
+#define CELL_NAME_LEN 48                /**< length of a cell name in the
+                                             index of a cell container */
+#define RUN_BUNDLE_MAGIC "VICBUNDL"     /**< first 8 bytes of a run bundle */
+#define RUN_BUNDLE_NSIZES 7             /**< number of structure sizes
+                                             checked when loading a bundle */
+#define PARAM_INDEX_MAGIC "VICPIDX1"    /**< first 8 bytes of a parameter
+                                             index file */
+#define STATE_RECORD_HEADER_SIZE (4 * sizeof(int)) /**< cell number, Nveg,
+                                                        Nbands and Nbytes of a
+                                                        binary state record */
 
 /******************************************************************************
  * @brief   file structures
@@ -52,6 +71,79 @@ typedef struct {
     FILE *logfile;      /**< log file */
 } filep_struct;
 
+/******************************************************************************
+ * @brief   This structure stores the location of one grid cell in a cell
+ *          container file.
+ *****************************************************************************/
+typedef struct {
+    char name[CELL_NAME_LEN]; /**< "lat_lng" part of the per-cell file name */
+    uint64_t offset;          /**< offset of the data of the cell [bytes] */
+    uint64_t length;          /**< length of the data of the cell [bytes] */
+} cell_index_struct;
+
+/******************************************************************************
+ * @brief   This structure is stored at the end of a cell container file.
+ *****************************************************************************/
+typedef struct {
+    uint64_t ncells;       /**< number of grid cells in the index */
+    uint64_t index_offset; /**< offset of the cell index [bytes] */
+    char magic[8];         /**< CELL_CONTAINER_MAGIC, without the final '\0' */
+} cell_container_trailer_struct;
+
+/******************************************************************************
+ * @brief   This structure is stored at the start of a run bundle file.
+ *****************************************************************************/
+typedef struct {
+    char magic[8];           /**< RUN_BUNDLE_MAGIC, without the final '\0' */
+    char version[MAXSTRING]; /**< VIC version that wrote the bundle */
+    uint64_t sizes[RUN_BUNDLE_NSIZES]; /**< sizes of the bundled structures */
+    uint64_t Nveg_type;      /**< number of vegetation library classes */
+    uint64_t NF;             /**< value of NF after parsing */
+    uint64_t NR;             /**< value of NR after parsing */
+} run_bundle_header_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the offsets of the parameters of one active
+ *          grid cell in the soil, vegetation and snow band files.
+ *****************************************************************************/
+typedef struct {
+    int64_t gridcel;  /**< grid cell number */
+    int64_t soil;     /**< offset of the soil parameter line [bytes] */
+    int64_t veg;      /**< offset of the vegetation parameters [bytes] */
+    int64_t snowband; /**< offset of the snow band line [bytes], -1 if the
+                           cell is not in the snow band file */
+} param_index_cell_struct;
+
+/******************************************************************************
+ * @brief   This structure is stored at the start of a parameter index file.
+ *****************************************************************************/
+typedef struct {
+    char magic[8];     /**< PARAM_INDEX_MAGIC, without the final '\0' */
+    uint64_t hash;     /**< hash of the indexed files and options */
+    uint64_t ncells;   /**< number of active grid cells */
+} param_index_header_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the parameter offsets of all active grid
+ *          cells, in the order of the soil parameter file.
+ *****************************************************************************/
+typedef struct {
+    size_t ncells;                  /**< number of active grid cells */
+    param_index_cell_struct *cells; /**< offsets of the grid cells */
+} param_index_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the location of the record of each grid cell
+ *          in a binary state file.
+ *****************************************************************************/
+typedef struct {
+    size_t ncells;  /**< number of records */
+    size_t next;    /**< record after the last one that was read */
+    int *cellnum;   /**< cell number of each record */
+    long *offset;   /**< offset of each record [bytes] */
+    size_t *length; /**< length of each record, with its header [bytes] */
+} state_index_struct;
+
 /******************************************************************************
  * @brief   This structure stores input and output filenames.
  *****************************************************************************/
@@ -69,46 +161,72 @@ typedef struct {
     char veg[MAXSTRING];           /**< vegetation grid coverage file */
     char veglib[MAXSTRING];        /**< vegetation parameter library file */
     char log_path[MAXSTRING];      /**< Location to write log file to*/
+    char run_bundle[MAXSTRING];    /**< run bundle to write after parsing */
+    char param_index[MAXSTRING];   /**< index of the soil, vegetation and snow
+                                        band files */
 } filenames_struct;
 
 void alloc_atmos(int, force_data_struct **);
 void alloc_veg_hist(int nrecs, int nveg, veg_hist_struct ***veg_hist);
+void build_param_index(filep_struct *filep, filenames_struct *fnames,
+                       param_index_struct *index);
 void calc_netlongwave(double *, double, double, double);
 double calc_netshort(double, int, double, double *);
 void check_files(filep_struct *, filenames_struct *);
-bool check_save_state_flag(dmy_struct *, size_t);
+bool check_save_state_flag(size_t);
 FILE  *check_state_file(char *, size_t, size_t, int *);
+void close_cell_containers(stream_struct **streams);
 void close_files(filep_struct *filep, stream_struct **streams);
+void close_forcing_containers(void);
 void compute_cell_area(soil_con_struct *);
+void finish_cell_workers(size_t worker);
+void finish_container_cell(stream_struct *stream, size_t streamnum);
+void flush_stream_buffer(stream_struct *stream);
 void free_atmos(int nrecs, force_data_struct **force);
+void free_param_index(param_index_struct *index);
+void free_state_index(void);
 void free_veg_hist(int nrecs, int nveg, veg_hist_struct ***veg_hist);
 void free_veglib(veg_lib_struct **);
 double get_dist(double lat1, double long1, double lat2, double long2);
 void get_force_type(char *, int, int *);
 void get_global_param(FILE *);
+void init_stream_buffer(stream_struct *stream);
 void initialize_filenames(void);
 void initialize_fileps(void);
 void initialize_forcing_files(void);
+bool is_cell_container(char filename[]);
+bool is_run_bundle(char filename[]);
 void make_in_and_outfiles(filep_struct *filep, filenames_struct *filenames,
                           soil_con_struct *soil, stream_struct **streams,
                           dmy_struct *dmy);
+void open_cell_containers(stream_struct **streams, filenames_struct *fnames,
+                          size_t worker);
+FILE *open_container_cell(size_t filenum, char path[], char name[]);
+FILE *open_compressed_file(char filename[], short int level);
 FILE *open_state_file(global_param_struct *, filenames_struct, size_t, size_t);
 void print_atmos_data(force_data_struct *force, size_t nr);
 void parse_output_info(FILE *gp, stream_struct **output_streams,
                        dmy_struct *dmy_current);
-void read_atmos_data(FILE *, global_param_struct, int, int, double **,
+void read_atmos_data(FILE *, global_param_struct, int, int, size_t, double **,
                      double ***);
-double **read_forcing_data(FILE **, global_param_struct, double ****);
+double **read_forcing_data(FILE **, global_param_struct, size_t, double ****);
 void read_initial_model_state(FILE *, all_vars_struct *, int, int, int,
                               soil_con_struct *, lake_con_struct);
 lake_con_struct read_lakeparam(FILE *, soil_con_struct, veg_con_struct *);
 void read_snowband(FILE *, soil_con_struct *);
 void read_soilparam(FILE *soilparam, soil_con_struct *temp, bool *RUN_MODEL,
                     bool *MODEL_DONE);
+void read_run_bundle(char filename[], stream_struct **streams,
+                     veg_lib_struct **veg_lib, size_t *Nveg_type);
 veg_lib_struct *read_veglib(FILE *, size_t *);
 veg_con_struct *read_vegparam(FILE *, int, size_t);
+bool seek_param_index(param_index_struct *index, filep_struct *filep,
+                      size_t worker, int *cellnum);
+size_t start_cell_workers(filep_struct *filep, filenames_struct *fnames);
+void start_container_cell(stream_struct *stream, size_t streamnum,
+                          char name[]);
 void vic_force(force_data_struct *, dmy_struct *, FILE **, veg_con_struct *,
-               veg_hist_struct **, soil_con_struct *);
+               veg_hist_struct **, soil_con_struct *, size_t, size_t);
 void vic_populate_model_state(all_vars_struct *, filep_struct, size_t,
                               soil_con_struct *, veg_con_struct *,
                               lake_con_struct);
@@ -117,5 +235,7 @@ void write_header(stream_struct **streams, dmy_struct *dmy);
 void write_model_state(all_vars_struct *, int, int, filep_struct *,
                        soil_con_struct *);
 void write_output(stream_struct **streams, dmy_struct *dmy);
+void write_run_bundle(char filename[], stream_struct *streams,
+                      veg_lib_struct *veg_lib, size_t Nveg_type);
 void write_vic_timing_table(timer_struct *timers);
 #endif
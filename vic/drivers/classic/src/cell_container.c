@@ -0,0 +1,455 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Write the output of many grid cells into one container file per stream and
+ * read the forcings of many grid cells from one container file.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_classic.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+ * @brief   The cell index of a forcing container file.
+ *****************************************************************************/
+typedef struct {
+    char path[MAXSTRING];     /**< path of the container */
+    int fd;                   /**< file descriptor of the container */
+    cell_index_struct *index; /**< cells of the container, sorted by name */
+    size_t ncells;            /**< number of cells in index */
+} forcing_container_struct;
+
+/******************************************************************************
+ * @brief   The part of a forcing container read through one stream.
+ *****************************************************************************/
+typedef struct {
+    int fd;                   /**< file descriptor of the container */
+    off_t start;              /**< offset of the data of the cell */
+    off_t length;             /**< length of the data of the cell */
+    off_t pos;                /**< current position in the data of the cell */
+} cell_reader_struct;
+
+static cell_index_struct       **container_index = NULL;
+static size_t                   *container_ncells = NULL;
+static size_t                   *container_nalloc = NULL;
+static forcing_container_struct  forcing_containers[MAX_FORCE_FILES];
+
+static void close_forcing_container(forcing_container_struct *container);
+
+/******************************************************************************
+ * @brief    Open one cell container file for every output stream.
+ *
+ * @details  A cell container holds the output files of many grid cells. The
+ *           data of a grid cell is exactly the per-cell output file that
+ *           would be written without OUT_CONTAINER, and the cells follow
+ *           each other in the order they are run. The file ends with an
+ *           index of the cells (cell_index_struct) and a trailer
+ *           (cell_container_trailer_struct). Every worker process writes its
+ *           own container, so the workers never share an output file.
+ *****************************************************************************/
+void
+open_cell_containers(stream_struct    **streams,
+                     filenames_struct  *fnames,
+                     size_t             worker)
+{
+    extern option_struct options;
+    extern FILE *open_file(char string[], char type[]);
+
+    size_t               streamnum;
+    char                 suffix[MAXSTRING];
+
+    container_index = calloc(options.Noutstreams, sizeof(*container_index));
+    check_alloc_status(container_index, "Memory allocation error.");
+    container_ncells = calloc(options.Noutstreams, sizeof(*container_ncells));
+    check_alloc_status(container_ncells, "Memory allocation error.");
+    container_nalloc = calloc(options.Noutstreams, sizeof(*container_nalloc));
+    check_alloc_status(container_nalloc, "Memory allocation error.");
+
+    if (options.NWORKERS > 1) {
+        sprintf(suffix, "_%zu%s", worker, CELL_CONTAINER_EXT);
+    }
+    else {
+        strcpy(suffix, CELL_CONTAINER_EXT);
+    }
+
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        if ((*streams)[streamnum].compress) {
+            log_err("COMPRESS is not supported with OUT_CONTAINER = TRUE "
+                    "(stream %s)", (*streams)[streamnum].prefix);
+        }
+        strcpy((*streams)[streamnum].filename, fnames->result_dir);
+        strcat((*streams)[streamnum].filename, "/");
+        strcat((*streams)[streamnum].filename, (*streams)[streamnum].prefix);
+        strcat((*streams)[streamnum].filename, suffix);
+        (*streams)[streamnum].fh = open_file((*streams)[streamnum].filename,
+                                             "wb");
+        init_stream_buffer(&((*streams)[streamnum]));
+    }
+}
+
+/******************************************************************************
+ * @brief    Start the data of a grid cell in the container of a stream.
+ *
+ * @param    name "lat_lng" part of the per-cell output file name
+ *****************************************************************************/
+void
+start_container_cell(stream_struct *stream,
+                     size_t         streamnum,
+                     char           name[])
+{
+    cell_index_struct *cell;
+
+    if (strlen(name) >= CELL_NAME_LEN) {
+        log_err("Grid cell name %s is too long for a cell container", name);
+    }
+
+    if (container_ncells[streamnum] == container_nalloc[streamnum]) {
+        container_nalloc[streamnum] = 2 * container_nalloc[streamnum] + 64;
+        container_index[streamnum] = realloc(container_index[streamnum],
+                                             container_nalloc[streamnum] *
+                                             sizeof(**container_index));
+        check_alloc_status(container_index[streamnum],
+                           "Memory allocation error.");
+    }
+
+    cell = &(container_index[streamnum][container_ncells[streamnum]]);
+    memset(cell, 0, sizeof(*cell));
+    strcpy(cell->name, name);
+    cell->offset = (uint64_t) ftello(stream->fh);
+    cell->length = 0;
+}
+
+/******************************************************************************
+ * @brief    Finish the data of a grid cell in the container of a stream.
+ *****************************************************************************/
+void
+finish_container_cell(stream_struct *stream,
+                      size_t         streamnum)
+{
+    cell_index_struct *cell;
+
+    cell = &(container_index[streamnum][container_ncells[streamnum]]);
+    cell->length = (uint64_t) ftello(stream->fh) - cell->offset;
+    container_ncells[streamnum]++;
+}
+
+/******************************************************************************
+ * @brief    Write the cell index of every container and close the files.
+ *****************************************************************************/
+void
+close_cell_containers(stream_struct **streams)
+{
+    extern option_struct          options;
+
+    size_t                        streamnum;
+    cell_container_trailer_struct trailer;
+    FILE                         *fh;
+
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        fh = (*streams)[streamnum].fh;
+
+        memset(&trailer, 0, sizeof(trailer));
+        trailer.ncells = container_ncells[streamnum];
+        trailer.index_offset = (uint64_t) ftello(fh);
+        memcpy(trailer.magic, CELL_CONTAINER_MAGIC, sizeof(trailer.magic));
+
+        if (fwrite(container_index[streamnum], sizeof(**container_index),
+                   container_ncells[streamnum], fh) !=
+            container_ncells[streamnum] ||
+            fwrite(&trailer, sizeof(trailer), 1, fh) != 1) {
+            log_err("Error writing the cell index of %s",
+                    (*streams)[streamnum].filename);
+        }
+        if (fclose(fh) != 0) {
+            log_err("Error closing %s", (*streams)[streamnum].filename);
+        }
+        free(container_index[streamnum]);
+    }
+    free(container_index);
+    free(container_ncells);
+    free(container_nalloc);
+    container_index = NULL;
+    container_ncells = NULL;
+    container_nalloc = NULL;
+}
+
+/******************************************************************************
+ * @brief    Return true if a file name is the name of a cell container.
+ *****************************************************************************/
+bool
+is_cell_container(char filename[])
+{
+    size_t len;
+    size_t extlen;
+
+    len = strlen(filename);
+    extlen = strlen(CELL_CONTAINER_EXT);
+
+    return len > extlen &&
+           strcmp(&(filename[len - extlen]), CELL_CONTAINER_EXT) == 0;
+}
+
+/******************************************************************************
+ * @brief    Compare two cells of a cell index by name.
+ *****************************************************************************/
+static int
+compare_cell_names(const void *a,
+                   const void *b)
+{
+    return strcmp(((const cell_index_struct *) a)->name,
+                  ((const cell_index_struct *) b)->name);
+}
+
+/******************************************************************************
+ * @brief    Open a forcing container and read its cell index.
+ *****************************************************************************/
+static void
+load_forcing_container(forcing_container_struct *container,
+                       char                      path[])
+{
+    cell_container_trailer_struct trailer;
+    struct stat                   st;
+    size_t                        i;
+    size_t                        nbytes;
+
+    container->fd = open(path, O_RDONLY);
+    if (container->fd < 0) {
+        log_err("Unable to open forcing container %s", path);
+    }
+    if (fstat(container->fd, &st) != 0 ||
+        st.st_size < (off_t) sizeof(trailer) ||
+        pread(container->fd, &trailer, sizeof(trailer),
+              st.st_size - sizeof(trailer)) != (ssize_t) sizeof(trailer) ||
+        memcmp(trailer.magic, CELL_CONTAINER_MAGIC,
+               sizeof(trailer.magic)) != 0) {
+        log_err("%s is not a cell container", path);
+    }
+
+    container->ncells = trailer.ncells;
+    nbytes = container->ncells * sizeof(*(container->index));
+    container->index = malloc(nbytes);
+    check_alloc_status(container->index, "Memory allocation error.");
+    if (pread(container->fd, container->index, nbytes,
+              (off_t) trailer.index_offset) != (ssize_t) nbytes) {
+        log_err("Unable to read the cell index of %s", path);
+    }
+    for (i = 0; i < container->ncells; i++) {
+        container->index[i].name[CELL_NAME_LEN - 1] = '\0';
+    }
+    qsort(container->index, container->ncells, sizeof(*(container->index)),
+          compare_cell_names);
+
+    strcpy(container->path, path);
+}
+
+/******************************************************************************
+ * @brief    Read from the data of a cell in a forcing container.
+ *****************************************************************************/
+static ssize_t
+cell_read(void  *cookie,
+          char  *buf,
+          size_t size)
+{
+    cell_reader_struct *reader = (cell_reader_struct *) cookie;
+    ssize_t             nread;
+
+    if ((off_t) size > reader->length - reader->pos) {
+        size = reader->length - reader->pos;
+    }
+    if (size == 0) {
+        return 0;
+    }
+    nread = pread(reader->fd, buf, size, reader->start + reader->pos);
+    if (nread > 0) {
+        reader->pos += nread;
+    }
+    return nread;
+}
+
+/******************************************************************************
+ * @brief    Move the position in the data of a cell in a forcing container.
+ *****************************************************************************/
+static int
+cell_seek(void  *cookie,
+          off_t *offset,
+          int    whence)
+{
+    cell_reader_struct *reader = (cell_reader_struct *) cookie;
+    off_t               pos;
+
+    if (whence == SEEK_SET) {
+        pos = *offset;
+    }
+    else if (whence == SEEK_CUR) {
+        pos = reader->pos + *offset;
+    }
+    else if (whence == SEEK_END) {
+        pos = reader->length + *offset;
+    }
+    else {
+        return -1;
+    }
+    if (pos < 0) {
+        return -1;
+    }
+    reader->pos = pos;
+    *offset = pos;
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Free the reader of a cell when its stream is closed.
+ *
+ * @details  The container stays open for the next grid cell.
+ *****************************************************************************/
+static int
+cell_close(void *cookie)
+{
+    free(cookie);
+    return 0;
+}
+
+#if defined(__APPLE__) || defined(__FreeBSD__)
+/******************************************************************************
+ * @brief    funopen() version of cell_read().
+ *****************************************************************************/
+static int
+cell_funopen_read(void *cookie,
+                  char *buf,
+                  int   size)
+{
+    return (int) cell_read(cookie, buf, (size_t) size);
+}
+
+/******************************************************************************
+ * @brief    funopen() version of cell_seek().
+ *****************************************************************************/
+static fpos_t
+cell_funopen_seek(void  *cookie,
+                  fpos_t offset,
+                  int    whence)
+{
+    off_t pos = (off_t) offset;
+
+    if (cell_seek(cookie, &pos, whence) != 0) {
+        return -1;
+    }
+    return (fpos_t) pos;
+}
+#endif
+
+/******************************************************************************
+ * @brief    Open the forcings of a grid cell in a forcing container.
+ *
+ * @details  The container is opened and its index is read when the first
+ *           grid cell is opened. The returned stream reads the data of the
+ *           grid cell with pread(), so no file is opened for a grid cell and
+ *           the worker processes can share the container. The stream ends
+ *           at the end of the data of the grid cell.
+ *
+ * @param    filenum number of the forcing file [0, MAX_FORCE_FILES)
+ * @param    path path of the container
+ * @param    name "lat_lng" part of the per-cell forcing file name
+ * @return   a pointer to the file structure associated with the stream.
+ *****************************************************************************/
+FILE *
+open_container_cell(size_t filenum,
+                    char   path[],
+                    char   name[])
+{
+    forcing_container_struct *container;
+    cell_index_struct         key;
+    cell_index_struct        *cell;
+    cell_reader_struct       *reader;
+    FILE                     *stream;
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+    cookie_io_functions_t     cell_io = {
+        cell_read, NULL, cell_seek, cell_close
+    };
+#endif
+
+    container = &(forcing_containers[filenum]);
+    if (container->index == NULL || strcmp(container->path, path) != 0) {
+        close_forcing_container(container);
+        load_forcing_container(container, path);
+    }
+
+    if (strlen(name) >= CELL_NAME_LEN) {
+        log_err("Grid cell name %s is too long for a cell container", name);
+    }
+    memset(&key, 0, sizeof(key));
+    strcpy(key.name, name);
+    cell = bsearch(&key, container->index, container->ncells,
+                   sizeof(*(container->index)), compare_cell_names);
+    if (cell == NULL) {
+        log_err("Grid cell %s is not in forcing container %s", name, path);
+    }
+
+    reader = malloc(sizeof(*reader));
+    check_alloc_status(reader, "Memory allocation error.");
+    reader->fd = container->fd;
+    reader->start = (off_t) cell->offset;
+    reader->length = (off_t) cell->length;
+    reader->pos = 0;
+
+#if defined(__APPLE__) || defined(__FreeBSD__)
+    stream = funopen(reader, cell_funopen_read, NULL, cell_funopen_seek,
+                     cell_close);
+#else
+    stream = fopencookie(reader, "r", cell_io);
+#endif
+    if (stream == NULL) {
+        log_err("Unable to open a stream for grid cell %s in %s", name, path);
+    }
+
+    return stream;
+}
+
+/******************************************************************************
+ * @brief    Close a forcing container and free its cell index.
+ *****************************************************************************/
+static void
+close_forcing_container(forcing_container_struct *container)
+{
+    if (container->index == NULL) {
+        return;
+    }
+    close(container->fd);
+    free(container->index);
+    container->index = NULL;
+    container->ncells = 0;
+    container->path[0] = '\0';
+}
+
+/******************************************************************************
+ * @brief    Close all forcing containers.
+ *****************************************************************************/
+void
+close_forcing_containers(void)
+{
+    size_t filenum;
+
+    for (filenum = 0; filenum < MAX_FORCE_FILES; filenum++) {
+        close_forcing_container(&(forcing_containers[filenum]));
+    }
+}
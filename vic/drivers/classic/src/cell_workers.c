@@ -0,0 +1,153 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Run the grid cells of the classic driver on several worker processes.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <sys/wait.h>
+#include <vic_driver_classic.h>
+
+static pid_t *worker_pids = NULL;
+
+/******************************************************************************
+ * @brief    Give a worker process its own stream of an input file.
+ *
+ * @details  The stream inherited from the parent shares the file offset with
+ *           the parent. Its descriptor is closed before the stream, so that
+ *           closing the stream cannot move the offset of the parent.
+ *****************************************************************************/
+static void
+reopen_input_file(FILE **fp,
+                  char   filename[])
+{
+    extern FILE *open_file(char string[], char type[]);
+
+    close(fileno(*fp));
+    fclose(*fp);
+    *fp = open_file(filename, "r");
+}
+
+/******************************************************************************
+ * @brief    Start options.NWORKERS - 1 worker processes.
+ *
+ * @details  Must be called after the vegetation library has been read and
+ *           before the first grid cell is read. The calling process is
+ *           worker 0. Every worker reads the parameter files itself and runs
+ *           the active grid cells whose cell number modulo options.NWORKERS
+ *           equals its worker index.
+ *
+ * @return   index of the calling process among the workers
+ *****************************************************************************/
+size_t
+start_cell_workers(filep_struct     *filep,
+                   filenames_struct *fnames)
+{
+    extern option_struct options;
+    extern FILE         *LOG_DEST;
+
+    size_t               worker;
+    pid_t                pid;
+
+    if (options.NWORKERS <= 1) {
+        return 0;
+    }
+
+    worker_pids = calloc(options.NWORKERS, sizeof(*worker_pids));
+    check_alloc_status(worker_pids, "Memory allocation error.");
+
+    // don't let the workers write the buffered log messages once more
+    fflush(stdout);
+    fflush(LOG_DEST);
+
+    for (worker = 1; worker < options.NWORKERS; worker++) {
+        pid = fork();
+        if (pid < 0) {
+            log_err("Could not start worker process %zu of %zu",
+                    worker, options.NWORKERS);
+        }
+        else if (pid == 0) {
+            free(worker_pids);
+            worker_pids = NULL;
+
+            reopen_input_file(&(filep->soilparam), fnames->soil);
+            reopen_input_file(&(filep->vegparam), fnames->veg);
+            if (options.SNOW_BAND > 1) {
+                reopen_input_file(&(filep->snowband), fnames->snowband);
+            }
+            if (options.LAKES) {
+                reopen_input_file(&(filep->lakeparam), fnames->lakeparam);
+            }
+            return worker;
+        }
+        worker_pids[worker] = pid;
+    }
+
+    log_info("Running grid cells on %zu worker processes", options.NWORKERS);
+
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Stop the worker processes.
+ *
+ * @details  A worker process exits. Worker 0 waits for all other workers and
+ *           exits with an error if one of them failed.
+ *****************************************************************************/
+void
+finish_cell_workers(size_t worker)
+{
+    extern option_struct options;
+    extern FILE         *LOG_DEST;
+
+    size_t               i;
+    size_t               nfailed;
+    int                  status;
+
+    if (options.NWORKERS <= 1) {
+        return;
+    }
+
+    if (worker > 0) {
+        // the streams inherited from worker 0 must not be flushed or closed
+        fflush(LOG_DEST);
+        _exit(EXIT_SUCCESS);
+    }
+
+    nfailed = 0;
+    for (i = 1; i < options.NWORKERS; i++) {
+        if (waitpid(worker_pids[i], &status, 0) < 0 ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            log_warn("Worker process %zu (pid %d) failed", i,
+                     (int) worker_pids[i]);
+            nfailed++;
+        }
+    }
+    free(worker_pids);
+    worker_pids = NULL;
+
+    if (nfailed > 0) {
+        log_err("%zu of %zu worker processes failed. The output files of "
+                "their grid cells are incomplete.", nfailed,
+                options.NWORKERS);
+    }
+}
@@ -32,25 +32,16 @@
  *          current time step
  *****************************************************************************/
 bool
-check_save_state_flag(dmy_struct *dmy,
-                      size_t      current)
+check_save_state_flag(size_t current)
 {
     extern global_param_struct global_param;
 
-    double                     offset;
-    double                     time_num;
     dmy_struct                 dmy_offset;
 
-    // Advance dmy by one timestep because dmy is the "timestep-beginning"
-    // timestamp, but we want to check whether the end of the current
-    // time step is the user-specified output state time
-    offset = global_param.dt / (double) SEC_PER_DAY;
-    time_num = date2num(global_param.time_origin_num, &dmy[current], 0,
-                        global_param.calendar, TIME_UNITS_DAYS);
-    time_num += offset;
-    num2date(global_param.time_origin_num, time_num, 0,
-             global_param.calendar, TIME_UNITS_DAYS,
-             &dmy_offset);
+    // The dates are "timestep-beginning" timestamps, but we want to check
+    // whether the end of the current time step (the beginning of the next
+    // one) is the user-specified output state time
+    dmy_from_step(&global_param, current + 1, &dmy_offset);
 
     // Check if the end of the current time step is equal to the state output
     // timestep specified by user
@@ -51,10 +51,14 @@ close_files(filep_struct   *filep,
        Close Output Files
     *******************/
     for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
-        fclose((*streams)[streamnum].fh);
-        if ((*streams)[streamnum].compress) {
-            compress_files((*streams)[streamnum].filename,
-                           (*streams)[streamnum].compress);
+        flush_stream_buffer(&((*streams)[streamnum]));
+        if (options.OUT_CONTAINER) {
+            // the container stays open for the next grid cell
+            finish_container_cell(&((*streams)[streamnum]), streamnum);
+        }
+        else {
+            // closing a compressed stream also finishes the gzip file
+            fclose((*streams)[streamnum].fh);
         }
     }
 }
@@ -57,6 +57,10 @@ display_current_settings(int mode)
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "LOG_LEVEL:\t\t%d\n", LOG_LVL);
     fprintf(LOG_DEST, "\n");
+#ifdef VIC_SPECIALIZE
+    fprintf(LOG_DEST, "SPECIALIZE:\t\t%s\n", VIC_SPECIALIZE);
+    fprintf(LOG_DEST, "\n");
+#endif
     fprintf(LOG_DEST, "Maximum Array Sizes:\n");
     fprintf(LOG_DEST, "MAX_BANDS\t\t%2d\n", MAX_BANDS);
     fprintf(LOG_DEST, "MAX_FRONTS\t\t%2d\n", MAX_FRONTS);
@@ -147,6 +151,13 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "CONTINUEONERROR\t\tFALSE\n");
     }
+    fprintf(LOG_DEST, "NWORKERS\t\t%zu\n", options.NWORKERS);
+    if (options.PERF_REGIONS) {
+        fprintf(LOG_DEST, "PERF_REGIONS\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "PERF_REGIONS\t\tFALSE\n");
+    }
     if (options.CORRPREC) {
         fprintf(LOG_DEST, "CORRPREC\t\tTRUE\n");
     }
@@ -183,6 +194,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "IMPLICIT\t\tFALSE\n");
     }
+    if (options.ANALYTIC_JACOBIAN) {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tFALSE\n");
+    }
     if (options.NOFLUX) {
         fprintf(LOG_DEST, "NOFLUX\t\t\tTRUE\n");
     }
@@ -201,6 +218,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "QUICK_SOLVE\t\tFALSE\n");
     }
+    if (options.QUIESCENT_SOIL) {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tFALSE\n");
+    }
     if (options.SPATIAL_FROST) {
         fprintf(LOG_DEST, "SPATIAL_FROST\t\tTRUE\n");
         fprintf(LOG_DEST, "Nfrost\t\t%zu\n", options.Nfrost);
@@ -214,6 +237,18 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "SPATIAL_SNOW\t\tFALSE\n");
     }
+    if (options.ADAPTIVE_SUBSTEPS) {
+        fprintf(LOG_DEST, "ADAPTIVE_SUBSTEPS\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ADAPTIVE_SUBSTEPS\tFALSE\n");
+    }
+    if (options.BAND_MERGE) {
+        fprintf(LOG_DEST, "BAND_MERGE\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "BAND_MERGE\t\tFALSE\n");
+    }
     if (options.SNOW_DENSITY == DENS_BRAS) {
         fprintf(LOG_DEST, "SNOW_DENSITY\t\tDENS_BRAS\n");
     }
@@ -226,6 +261,24 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "TFALLBACK\t\tFALSE\n");
     }
+    if (options.TSURF_NEWTON) {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tFALSE\n");
+    }
+    if (options.ROOT_RETRY) {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tFALSE\n");
+    }
+    if (options.FAST_SVP) {
+        fprintf(LOG_DEST, "FAST_SVP\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FAST_SVP\t\tFALSE\n");
+    }
     fprintf(LOG_DEST, "WIND_H\t\t\t%f\n", global_param.wind_h);
     fprintf(LOG_DEST, "NODES\t\t\t%zu\n", options.Nnode);
     if (options.CARBON) {
@@ -241,6 +294,19 @@ display_current_settings(int mode)
         fprintf(LOG_DEST, "SHARE_LAYER_MOIST\t\tFALSE\n");
     }
     fprintf(LOG_DEST, "Ncanopy\t\t%zu\n", options.Ncanopy);
+    if (options.BALANCE_CHECK == BALANCE_CHECK_STEPS) {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tSTEPS\n");
+    }
+    else if (options.BALANCE_CHECK == BALANCE_CHECK_CELLS) {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tCELLS\n");
+    }
+    else if (options.BALANCE_CHECK == BALANCE_CHECK_OUTPUT) {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tOUTPUT\n");
+    }
+    else {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tALL\n");
+    }
+    fprintf(LOG_DEST, "BALANCE_CHECK_N\t\t%zu\n", options.BALANCE_CHECK_N);
 
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "Input Forcing Data:\n");
@@ -274,6 +340,7 @@ display_current_settings(int mode)
         }
     }
     fprintf(LOG_DEST, "GRID_DECIMAL\t\t%d\n", options.GRID_DECIMAL);
+    fprintf(LOG_DEST, "FORCE_WINDOW\t\t%zu\n", options.FORCE_WINDOW);
 
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "Constants File\t\t%s\n", filenames.constants);
@@ -433,5 +500,19 @@ display_current_settings(int mode)
     fprintf(LOG_DEST, "Output Data:\n");
     fprintf(LOG_DEST, "Result dir:\t\t%s\n", filenames.result_dir);
     fprintf(LOG_DEST, "Noutstreams:\t\t%zu\n", options.Noutstreams);
+    if (options.OUT_CONTAINER) {
+        fprintf(LOG_DEST, "OUT_CONTAINER\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "OUT_CONTAINER\t\tFALSE\n");
+    }
+    if (options.OUT_CASCADE) {
+        fprintf(LOG_DEST, "OUT_CASCADE\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "OUT_CASCADE\t\tFALSE\n");
+    }
+    fprintf(LOG_DEST, "RUN_BUNDLE\t\t%s\n", filenames.run_bundle);
+    fprintf(LOG_DEST, "PARAM_INDEX\t\t%s\n", filenames.param_index);
     fprintf(LOG_DEST, "\n");
 }
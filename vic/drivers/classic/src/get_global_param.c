@@ -144,6 +144,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.QUICK_SOLVE = str_to_bool(flgstr);
             }
+            else if (strcasecmp("QUIESCENT_SOIL", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.QUIESCENT_SOIL = str_to_bool(flgstr);
+            }
             else if ((strcasecmp("NOFLUX",
                                  optstr) == 0) ||
                      (strcasecmp("NO_FLUX", optstr) == 0)) {
@@ -154,6 +158,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.IMPLICIT = str_to_bool(flgstr);
             }
+            else if (strcasecmp("ANALYTIC_JACOBIAN", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ANALYTIC_JACOBIAN = str_to_bool(flgstr);
+            }
             else if (strcasecmp("EXP_TRANS", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.EXP_TRANS = str_to_bool(flgstr);
@@ -194,6 +202,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.BLOWING_SPATIAL_WIND = str_to_bool(flgstr);
             }
+            else if (strcasecmp("BLOWING_FAST", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.BLOWING_FAST = str_to_bool(flgstr);
+            }
             else if (strcasecmp("CORRPREC", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.CORRPREC = str_to_bool(flgstr);
@@ -206,6 +218,13 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.CONTINUEONERROR = str_to_bool(flgstr);
             }
+            else if (strcasecmp("NWORKERS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.NWORKERS);
+            }
+            else if (strcasecmp("PERF_REGIONS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.PERF_REGIONS = str_to_bool(flgstr);
+            }
             else if (strcasecmp("COMPUTE_TREELINE", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 if (strcasecmp("FALSE", flgstr) == 0) {
@@ -264,10 +283,30 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.SPATIAL_SNOW = str_to_bool(flgstr);
             }
+            else if (strcasecmp("ADAPTIVE_SUBSTEPS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ADAPTIVE_SUBSTEPS = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("BAND_MERGE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.BAND_MERGE = str_to_bool(flgstr);
+            }
             else if (strcasecmp("TFALLBACK", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.TFALLBACK = str_to_bool(flgstr);
             }
+            else if (strcasecmp("TSURF_NEWTON", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.TSURF_NEWTON = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("ROOT_RETRY", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ROOT_RETRY = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("FAST_SVP", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.FAST_SVP = str_to_bool(flgstr);
+            }
             else if (strcasecmp("SHARE_LAYER_MOIST", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.SHARE_LAYER_MOIST = str_to_bool(flgstr);
@@ -291,6 +330,27 @@ get_global_param(FILE *gp)
                     log_err("Unknown RC_MODE option: %s", flgstr);
                 }
             }
+            else if (strcasecmp("BALANCE_CHECK", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                if (strcasecmp("ALL", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_ALL;
+                }
+                else if (strcasecmp("STEPS", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_STEPS;
+                }
+                else if (strcasecmp("CELLS", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_CELLS;
+                }
+                else if (strcasecmp("OUTPUT", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_OUTPUT;
+                }
+                else {
+                    log_err("Unknown BALANCE_CHECK option: %s", flgstr);
+                }
+            }
+            else if (strcasecmp("BALANCE_CHECK_N", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.BALANCE_CHECK_N);
+            }
 
             /*************************************
                Define log directory
@@ -299,6 +359,20 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", filenames.log_path);
             }
 
+            /*************************************
+               Define run bundle
+            *************************************/
+            else if (strcasecmp("RUN_BUNDLE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.run_bundle);
+            }
+
+            /*************************************
+               Define parameter index
+            *************************************/
+            else if (strcasecmp("PARAM_INDEX", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.param_index);
+            }
+
             /*************************************
                Define state files
             *************************************/
@@ -415,6 +489,9 @@ get_global_param(FILE *gp)
             else if (strcasecmp("GRID_DECIMAL", optstr) == 0) {
                 sscanf(cmdstr, "%*s %hu", &options.GRID_DECIMAL);
             }
+            else if (strcasecmp("FORCE_WINDOW", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.FORCE_WINDOW);
+            }
             else if (strcasecmp("WIND_H", optstr) == 0) {
                 sscanf(cmdstr, "%*s %lf", &global_param.wind_h);
             }
@@ -551,6 +628,14 @@ get_global_param(FILE *gp)
             else if (strcasecmp("RESULT_DIR", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", filenames.result_dir);
             }
+            else if (strcasecmp("OUT_CONTAINER", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.OUT_CONTAINER = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("OUT_CASCADE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.OUT_CASCADE = str_to_bool(flgstr);
+            }
 
             /*************************************
                Define output file contents
@@ -1172,8 +1257,8 @@ get_global_param(FILE *gp)
         }
         if (options.SNOW_BAND > MAX_BANDS) {
             log_err("Global file wants more snow bands (%zu) than are "
-                    "defined by MAX_BANDS (%d).  Edit vic_run/include/vic_def.h "
-                    "and recompile.", options.SNOW_BAND,
+                    "defined by MAX_BANDS (%d).  Recompile with a larger "
+                    "MAX_BANDS (make MAX_BANDS=n).", options.SNOW_BAND,
                     MAX_BANDS);
         }
     }
@@ -1194,6 +1279,11 @@ get_global_param(FILE *gp)
         }
     }
 
+    // Validate the balance checks
+    if (options.BALANCE_CHECK_N == 0) {
+        log_err("BALANCE_CHECK_N must be at least 1.");
+    }
+
     // Validate the output state file information
     if (options.SAVE_STATE) {
         if (strcmp(filenames.statefile, "MISSING") == 0) {
@@ -1245,6 +1335,17 @@ get_global_param(FILE *gp)
                 filenames.statefile, filenames.init_state);
     }
 
+    // Validate parallelization options
+    if (options.NWORKERS < 1) {
+        log_err("NWORKERS must be at least 1. Currently NWORKERS is set to "
+                "%zu.", options.NWORKERS);
+    }
+    if (options.NWORKERS > 1 && options.SAVE_STATE) {
+        log_err("SAVE_STATE = TRUE is not supported with NWORKERS > 1, "
+                "because the grid cells of the state file must be written "
+                "in the order of the soil parameter file.");
+    }
+
     // Default file formats (if unset)
     if (options.SAVE_STATE && options.STATE_FORMAT == UNSET_FILE_FORMAT) {
         options.STATE_FORMAT = ASCII;
@@ -1296,14 +1397,14 @@ get_global_param(FILE *gp)
     }
     if (options.Nlayer > MAX_LAYERS) {
         log_err("Global file wants more soil moisture layers (%zu) than "
-                "are defined by MAX_LAYERS (%d).  Edit vic_run/include/vic_def.h "
-                "and recompile.", options.Nlayer,
+                "are defined by MAX_LAYERS (%d).  Recompile with a larger "
+                "MAX_LAYERS (make MAX_LAYERS=n).", options.Nlayer,
                 MAX_LAYERS);
     }
     if (options.Nnode > MAX_NODES) {
         log_err("Global file wants more soil thermal nodes (%zu) than are "
-                "defined by MAX_NODES (%d).  Edit vic_run/include/vic_def.h and "
-                "recompile.", options.Nnode,
+                "defined by MAX_NODES (%d).  Recompile with a larger "
+                "MAX_NODES (make MAX_NODES=n).", options.Nnode,
                 MAX_NODES);
     }
     if (!options.FULL_ENERGY && options.CLOSE_ENERGY) {
@@ -1311,12 +1412,6 @@ get_global_param(FILE *gp)
                 "FULL_ENERGY to TRUE to run CLOSE_ENERGY, or set "
                 "CLOSE_ENERGY to FALSE.");
     }
-    if (options.COMPUTE_TREELINE && !options.JULY_TAVG_SUPPLIED) {
-        log_err("COMPUTE_TREELINE is TRUE but JULY_TAVG_SUPPLIED is "
-                "FALSE. Set JULY_TAVG_SUPPLIED to TRUE and include July "
-                "Average Temperature in the soil parameter file to run "
-                "COMPUTE_TREELINE, or set both to FALSE.");
-    }
     // Validate lake parameter information
     if (options.LAKES) {
         if (!options.FULL_ENERGY) {
@@ -48,6 +48,8 @@ initialize_filenames()
     strcpy(filenames.lakeparam, "MISSING");
     strcpy(filenames.result_dir, "MISSING");
     strcpy(filenames.log_path, "MISSING");
+    strcpy(filenames.run_bundle, "MISSING");
+    strcpy(filenames.param_index, "MISSING");
     for (i = 0; i < 2; i++) {
         strcpy(filenames.f_path_pfx[i], "MISSING");
     }
@@ -27,6 +27,37 @@
 
 #include <vic_driver_classic.h>
 
+/******************************************************************************
+ * @brief    Open the forcing file of a grid cell.
+ *
+ * @details  If the forcing path is a cell container, the forcings of the
+ *           grid cell are read from the container.
+ *****************************************************************************/
+static FILE *
+open_forcing_file(filenames_struct *filenames,
+                  size_t            filenum,
+                  char              cellname[])
+{
+    extern param_set_struct param_set;
+    extern FILE *open_file(char string[], char type[]);
+
+    strcpy(filenames->forcing[filenum], filenames->f_path_pfx[filenum]);
+    if (is_cell_container(filenames->f_path_pfx[filenum])) {
+        strcat(filenames->forcing[filenum], ":");
+        strcat(filenames->forcing[filenum], cellname);
+        return open_container_cell(filenum, filenames->f_path_pfx[filenum],
+                                   cellname);
+    }
+
+    strcat(filenames->forcing[filenum], cellname);
+    if (param_set.FORCE_FORMAT[0] == BINARY) {
+        return open_file(filenames->forcing[filenum], "rb");
+    }
+    else {
+        return open_file(filenames->forcing[filenum], "r");
+    }
+}
+
 /******************************************************************************
  * @brief    Build files names for input and output of grided data files.
  *****************************************************************************/
@@ -37,12 +68,12 @@ make_in_and_outfiles(filep_struct     *filep,
                      stream_struct   **streams,
                      dmy_struct       *dmy)
 {
-    extern option_struct    options;
-    extern param_set_struct param_set;
+    extern option_struct options;
     extern FILE *open_file(char string[], char type[]);
 
-    char                    latchar[20], lngchar[20], junk[6];
-    size_t                  filenum;
+    char                 latchar[20], lngchar[20], junk[6];
+    char                 cellname[MAXSTRING];
+    size_t               filenum;
 
     sprintf(junk, "%%.%if", options.GRID_DECIMAL);
     sprintf(latchar, junk, soil->lat);
@@ -52,29 +83,13 @@ make_in_and_outfiles(filep_struct     *filep,
        Input Forcing Files
     ********************************/
 
-    strcpy(filenames->forcing[0], filenames->f_path_pfx[0]);
-    strcat(filenames->forcing[0], latchar);
-    strcat(filenames->forcing[0], "_");
-    strcat(filenames->forcing[0], lngchar);
-    if (param_set.FORCE_FORMAT[0] == BINARY) {
-        filep->forcing[0] = open_file(filenames->forcing[0], "rb");
-    }
-    else {
-        filep->forcing[0] = open_file(filenames->forcing[0], "r");
-    }
+    sprintf(cellname, "%s_%s", latchar, lngchar);
+
+    filep->forcing[0] = open_forcing_file(filenames, 0, cellname);
 
     filep->forcing[1] = NULL;
     if (strcasecmp(filenames->f_path_pfx[1], "MISSING") != 0) {
-        strcpy(filenames->forcing[1], filenames->f_path_pfx[1]);
-        strcat(filenames->forcing[1], latchar);
-        strcat(filenames->forcing[1], "_");
-        strcat(filenames->forcing[1], lngchar);
-        if (param_set.FORCE_FORMAT[0] == BINARY) {
-            filep->forcing[1] = open_file(filenames->forcing[1], "rb");
-        }
-        else {
-            filep->forcing[1] = open_file(filenames->forcing[1], "r");
-        }
+        filep->forcing[1] = open_forcing_file(filenames, 1, cellname);
     }
 
     /********************************
@@ -82,6 +97,11 @@ make_in_and_outfiles(filep_struct     *filep,
     ********************************/
 
     for (filenum = 0; filenum < options.Noutstreams; filenum++) {
+        if (options.OUT_CONTAINER) {
+            // append the cell to the container opened for the whole run
+            start_container_cell(&((*streams)[filenum]), filenum, cellname);
+            continue;
+        }
         strcpy((*streams)[filenum].filename, filenames->result_dir);
         strcat((*streams)[filenum].filename, "/");
         strcat((*streams)[filenum].filename,
@@ -92,17 +112,27 @@ make_in_and_outfiles(filep_struct     *filep,
         strcat((*streams)[filenum].filename, lngchar);
         if ((*streams)[filenum].file_format == BINARY) {
             strcat((*streams)[filenum].filename, ".bin");
-            (*streams)[filenum].fh = open_file(
-                (*streams)[filenum].filename, "wb");
         }
         else if ((*streams)[filenum].file_format == ASCII) {
             strcat((*streams)[filenum].filename, ".txt");
-            (*streams)[filenum].fh = open_file(
-                (*streams)[filenum].filename, "w");
         }
         else {
             log_err("Unrecognized OUT_FORMAT option");
         }
+        if ((*streams)[filenum].compress) {
+            strcat((*streams)[filenum].filename, ".gz");
+            (*streams)[filenum].fh = open_compressed_file(
+                (*streams)[filenum].filename, (*streams)[filenum].compress);
+        }
+        else if ((*streams)[filenum].file_format == BINARY) {
+            (*streams)[filenum].fh = open_file(
+                (*streams)[filenum].filename, "wb");
+        }
+        else {
+            (*streams)[filenum].fh = open_file(
+                (*streams)[filenum].filename, "w");
+        }
+        init_stream_buffer(&((*streams)[filenum]));
     }
     /** Write output file headers **/
     write_header(streams, dmy);
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Open an output file that is gzip compressed while it is written.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_classic.h>
+#include <zlib.h>
+
+/******************************************************************************
+ * @brief    Compress a block of data written to the stream.
+ *****************************************************************************/
+static int
+gz_write(void       *cookie,
+         const char *buf,
+         int         size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    if (gzwrite((gzFile) cookie, buf, (unsigned int) size) != size) {
+        return -1;
+    }
+    return size;
+}
+
+/******************************************************************************
+ * @brief    Finish the compressed file when the stream is closed.
+ *****************************************************************************/
+static int
+gz_close(void *cookie)
+{
+    if (gzclose((gzFile) cookie) != Z_OK) {
+        return EOF;
+    }
+    return 0;
+}
+
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+/******************************************************************************
+ * @brief    fopencookie() version of gz_write().
+ *****************************************************************************/
+static ssize_t
+gz_cookie_write(void       *cookie,
+                const char *buf,
+                size_t      size)
+{
+    return gz_write(cookie, buf, (int) size);
+}
+#endif
+
+/******************************************************************************
+ * @brief    Open an output file that is gzip compressed while it is written.
+ *
+ * @details  The returned stream is used like any other output stream. All
+ *           data written to it is passed through zlib, so the file is
+ *           written in a single pass without a separate gzip process. The
+ *           compressed file is finished when the stream is closed.
+ *
+ * @param    filename path of the compressed file
+ * @param    level gzip compression level [1-9]
+ * @return   a pointer to the file structure associated with the stream.
+ *****************************************************************************/
+FILE *
+open_compressed_file(char      filename[],
+                     short int level)
+{
+    FILE                 *stream;
+    gzFile                gz;
+    char                  mode[MAXSTRING];
+#if !defined(__APPLE__) && !defined(__FreeBSD__)
+    cookie_io_functions_t gz_io = {
+        NULL, gz_cookie_write, NULL, gz_close
+    };
+#endif
+
+    if (level < 1 || level > 9) {
+        log_err("Invalid compression level %d for gzip, must be an integer "
+                "1-9", level);
+    }
+
+    sprintf(mode, "wb%d", level);
+    gz = gzopen(filename, mode);
+    if (gz == NULL) {
+        log_err("Unable to open compressed file %s", filename);
+    }
+
+#if defined(__APPLE__) || defined(__FreeBSD__)
+    stream = funopen(gz, NULL, gz_write, NULL, gz_close);
+#else
+    stream = fopencookie(gz, "w", gz_io);
+#endif
+    if (stream == NULL) {
+        log_err("Unable to open a stream for compressed file %s", filename);
+    }
+
+    return stream;
+}
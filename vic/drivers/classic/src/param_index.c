@@ -0,0 +1,490 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Index of the soil, vegetation and snow band parameter files.
+ *
+ * The index holds the offset of every active grid cell in the three files,
+ * so that each grid cell is read by seeking to its parameters instead of
+ * reading the files from the top. With NWORKERS > 1, every worker only
+ * reads the grid cells it runs. The index is built by worker 0 before the
+ * workers are started. With PARAM_INDEX, it is saved to that file and loaded
+ * from it by later runs, as long as the parameter files and the options that
+ * change their layout are the same.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_classic.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+ * @brief    Offset of a grid cell in the vegetation or snow band file.
+ *****************************************************************************/
+typedef struct {
+    int64_t gridcel;
+    int64_t offset;
+} param_offset_struct;
+
+/******************************************************************************
+ * @brief    Add nbytes of ptr to a 64-bit FNV-1a hash.
+ *****************************************************************************/
+static uint64_t
+hash_param_index(uint64_t    hash,
+                 const void *ptr,
+                 size_t      nbytes)
+{
+    const unsigned char *bytes = (const unsigned char *) ptr;
+    size_t               i;
+
+    for (i = 0; i < nbytes; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/******************************************************************************
+ * @brief    Hash the name, size and modification time of an indexed file.
+ *****************************************************************************/
+static uint64_t
+hash_param_index_file(uint64_t hash,
+                      char     filename[])
+{
+    struct stat st;
+    uint64_t    values[2];
+
+    if (stat(filename, &st) != 0) {
+        log_err("Unable to stat %s", filename);
+    }
+    values[0] = (uint64_t) st.st_size;
+    values[1] = (uint64_t) st.st_mtime;
+
+    hash = hash_param_index(hash, filename, strlen(filename));
+
+    return hash_param_index(hash, values, sizeof(values));
+}
+
+/******************************************************************************
+ * @brief    Hash the indexed files and the options of their layout.
+ *****************************************************************************/
+static uint64_t
+get_param_index_hash(filenames_struct *fnames)
+{
+    extern option_struct options;
+
+    uint64_t             hash;
+    uint64_t             values[4];
+
+    values[0] = options.VEGPARAM_LAI;
+    values[1] = options.VEGPARAM_FCAN;
+    values[2] = options.VEGPARAM_ALB;
+    values[3] = options.SNOW_BAND;
+    hash = hash_param_index(14695981039346656037ULL, values, sizeof(values));
+    hash = hash_param_index_file(hash, fnames->soil);
+    hash = hash_param_index_file(hash, fnames->veg);
+    if (options.SNOW_BAND > 1) {
+        hash = hash_param_index_file(hash, fnames->snowband);
+    }
+
+    return hash;
+}
+
+/******************************************************************************
+ * @brief    Order the offsets by grid cell number and position in the file.
+ *****************************************************************************/
+static int
+compare_param_offsets(const void *a,
+                      const void *b)
+{
+    const param_offset_struct *pa = (const param_offset_struct *) a;
+    const param_offset_struct *pb = (const param_offset_struct *) b;
+
+    if (pa->gridcel != pb->gridcel) {
+        return (pa->gridcel < pb->gridcel) ? -1 : 1;
+    }
+    if (pa->offset != pb->offset) {
+        return (pa->offset < pb->offset) ? -1 : 1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Find the first offset of a grid cell.
+ *
+ * @return   offset of the grid cell, -1 if it is not in the file
+ *****************************************************************************/
+static int64_t
+find_param_offset(param_offset_struct *offsets,
+                  size_t               noffsets,
+                  int64_t              gridcel)
+{
+    size_t lo;
+    size_t hi;
+    size_t mid;
+
+    // the first entry that is not smaller than gridcel
+    lo = 0;
+    hi = noffsets;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (offsets[mid].gridcel < gridcel) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    if (lo < noffsets && offsets[lo].gridcel == gridcel) {
+        return offsets[lo].offset;
+    }
+    return -1;
+}
+
+/******************************************************************************
+ * @brief    Add an offset to a growing list of offsets.
+ *****************************************************************************/
+static void
+add_param_offset(param_offset_struct **offsets,
+                 size_t               *noffsets,
+                 size_t               *nalloc,
+                 int64_t               gridcel,
+                 int64_t               offset)
+{
+    if (*noffsets == *nalloc) {
+        *nalloc = (*nalloc > 0) ? 2 * (*nalloc) : 1024;
+        *offsets = realloc(*offsets, *nalloc * sizeof(**offsets));
+        check_alloc_status(*offsets, "Memory allocation error.");
+    }
+    (*offsets)[*noffsets].gridcel = gridcel;
+    (*offsets)[*noffsets].offset = offset;
+    (*noffsets)++;
+}
+
+/******************************************************************************
+ * @brief    Find the active grid cells of the soil parameter file.
+ * @details  Reads the lines as read_soilparam() does.
+ *****************************************************************************/
+static void
+scan_soilparam(FILE                *soilparam,
+               param_offset_struct **cells,
+               size_t              *ncells)
+{
+    char    line[MAXSTRING];
+    size_t  nalloc;
+    int64_t offset;
+    int     flag;
+    int     gridcel;
+
+    nalloc = 0;
+    offset = ftell(soilparam);
+    while (fscanf(soilparam, "%d", &flag) != EOF) {
+        if (fgets(line, MAXSTRING, soilparam) == NULL) {
+            log_err("Unexpected EOF while reading soil file");
+        }
+        if (flag) {
+            if (sscanf(line, "%d", &gridcel) != 1) {
+                log_err("Can't find values for CELL NUMBER in soil file");
+            }
+            add_param_offset(cells, ncells, &nalloc, gridcel, offset);
+        }
+        offset = ftell(soilparam);
+    }
+}
+
+/******************************************************************************
+ * @brief    Find the grid cells of the vegetation parameter file.
+ * @details  Reads the records as read_vegparam() does.
+ *****************************************************************************/
+static void
+scan_vegparam(FILE                *vegparam,
+              param_offset_struct **offsets,
+              size_t              *noffsets)
+{
+    extern option_struct options;
+
+    char                 str[MAX_VEGPARAM_LINE_LENGTH];
+    size_t               nalloc;
+    int64_t              offset;
+    int                  vegcel;
+    int                  vegetat_type_num;
+    int                  skip;
+    int                  i;
+
+    skip = 1;
+    if (options.VEGPARAM_LAI) {
+        skip++;
+    }
+    if (options.VEGPARAM_FCAN) {
+        skip++;
+    }
+    if (options.VEGPARAM_ALB) {
+        skip++;
+    }
+
+    nalloc = 0;
+    offset = ftell(vegparam);
+    while (fscanf(vegparam, "%d %d", &vegcel, &vegetat_type_num) == 2) {
+        if (vegetat_type_num < 0) {
+            log_err("number of vegetation tiles (%i) given for cell %i "
+                    "is < 0.", vegetat_type_num, vegcel);
+        }
+        add_param_offset(offsets, noffsets, &nalloc, vegcel, offset);
+        for (i = 0; i <= vegetat_type_num * skip; i++) {
+            if (fgets(str, MAX_VEGPARAM_LINE_LENGTH, vegparam) == NULL) {
+                log_err("unexpected EOF for cell %i while reading root zones "
+                        "and LAI", vegcel);
+            }
+        }
+        offset = ftell(vegparam);
+    }
+}
+
+/******************************************************************************
+ * @brief    Find the grid cells of the snow band file.
+ * @details  Reads the lines as read_snowband() does.
+ *****************************************************************************/
+static void
+scan_snowband(FILE                *snowband,
+              param_offset_struct **offsets,
+              size_t              *noffsets)
+{
+    char    line[MAXSTRING];
+    size_t  nalloc;
+    int64_t offset;
+    int     cell;
+
+    nalloc = 0;
+    offset = ftell(snowband);
+    while (fscanf(snowband, "%d", &cell) == 1) {
+        add_param_offset(offsets, noffsets, &nalloc, cell, offset);
+        if (fgets(line, MAXSTRING, snowband) == NULL) {
+            break;
+        }
+        offset = ftell(snowband);
+    }
+}
+
+/******************************************************************************
+ * @brief    Load the index from the PARAM_INDEX file.
+ *
+ * @return   FALSE if the file does not exist or is out of date
+ *****************************************************************************/
+static bool
+load_param_index(char                filename[],
+                 uint64_t            hash,
+                 param_index_struct *index)
+{
+    param_index_header_struct header;
+    FILE                     *fp;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, PARAM_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.hash != hash) {
+        fclose(fp);
+        return false;
+    }
+
+    index->ncells = (size_t) header.ncells;
+    index->cells = malloc(index->ncells * sizeof(*(index->cells)));
+    check_alloc_status(index->cells, "Memory allocation error.");
+    if (index->ncells > 0 &&
+        fread(index->cells, sizeof(*(index->cells)), index->ncells,
+              fp) != index->ncells) {
+        log_err("Error reading parameter index %s", filename);
+    }
+    fclose(fp);
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Save the index to the PARAM_INDEX file.
+ *****************************************************************************/
+static void
+save_param_index(char                filename[],
+                 uint64_t            hash,
+                 param_index_struct *index)
+{
+    param_index_header_struct header;
+    FILE                     *fp;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PARAM_INDEX_MAGIC, sizeof(header.magic));
+    header.hash = hash;
+    header.ncells = index->ncells;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        log_err("Unable to open parameter index %s", filename);
+    }
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        (index->ncells > 0 &&
+         fwrite(index->cells, sizeof(*(index->cells)), index->ncells,
+                fp) != index->ncells)) {
+        log_err("Error writing parameter index %s", filename);
+    }
+    fclose(fp);
+}
+
+/******************************************************************************
+ * @brief    Build the index of the soil, vegetation and snow band files.
+ *
+ * @details  Must be called after check_files() and before the first grid cell
+ *           is read. The positions of the files are not changed.
+ *****************************************************************************/
+void
+build_param_index(filep_struct       *filep,
+                  filenames_struct   *fnames,
+                  param_index_struct *index)
+{
+    extern option_struct options;
+
+    param_offset_struct *soil = NULL;
+    param_offset_struct *veg = NULL;
+    param_offset_struct *band = NULL;
+    size_t               nsoil = 0;
+    size_t               nveg = 0;
+    size_t               nband = 0;
+    size_t               k;
+    uint64_t             hash;
+    bool                 saved;
+    long                 pos[3];
+
+    index->ncells = 0;
+    index->cells = NULL;
+
+    saved = strcasecmp(fnames->param_index, "MISSING") != 0;
+    hash = 0;
+    if (saved) {
+        hash = get_param_index_hash(fnames);
+        if (load_param_index(fnames->param_index, hash, index)) {
+            log_info("Read the parameter index %s", fnames->param_index);
+            return;
+        }
+    }
+
+    pos[0] = ftell(filep->soilparam);
+    pos[1] = ftell(filep->vegparam);
+    scan_soilparam(filep->soilparam, &soil, &nsoil);
+    scan_vegparam(filep->vegparam, &veg, &nveg);
+    qsort(veg, nveg, sizeof(*veg), compare_param_offsets);
+    if (options.SNOW_BAND > 1) {
+        pos[2] = ftell(filep->snowband);
+        scan_snowband(filep->snowband, &band, &nband);
+        qsort(band, nband, sizeof(*band), compare_param_offsets);
+    }
+
+    index->ncells = nsoil;
+    index->cells = malloc(nsoil * sizeof(*(index->cells)));
+    check_alloc_status(index->cells, "Memory allocation error.");
+    for (k = 0; k < nsoil; k++) {
+        index->cells[k].gridcel = soil[k].gridcel;
+        index->cells[k].soil = soil[k].offset;
+        index->cells[k].veg = find_param_offset(veg, nveg, soil[k].gridcel);
+        if (index->cells[k].veg < 0) {
+            log_err("Grid cell %d not found", (int) soil[k].gridcel);
+        }
+        index->cells[k].snowband = find_param_offset(band, nband,
+                                                     soil[k].gridcel);
+    }
+
+    // the files are read from the first grid cell
+    clearerr(filep->soilparam);
+    clearerr(filep->vegparam);
+    fseek(filep->soilparam, pos[0], SEEK_SET);
+    fseek(filep->vegparam, pos[1], SEEK_SET);
+    if (options.SNOW_BAND > 1) {
+        clearerr(filep->snowband);
+        fseek(filep->snowband, pos[2], SEEK_SET);
+    }
+
+    free(soil);
+    free(veg);
+    free(band);
+
+    if (saved) {
+        save_param_index(fnames->param_index, hash, index);
+        log_info("Wrote the parameter index %s", fnames->param_index);
+    }
+}
+
+/******************************************************************************
+ * @brief    Move the parameter files to the next grid cell of a worker.
+ *
+ * @details  cellnum is the number of the last grid cell that was read and
+ *           is set to the number before the next grid cell of the worker, so
+ *           that the next call of read_soilparam() reads that grid cell.
+ *
+ * @return   FALSE if the worker has no more grid cells
+ *****************************************************************************/
+bool
+seek_param_index(param_index_struct *index,
+                 filep_struct       *filep,
+                 size_t              worker,
+                 int                *cellnum)
+{
+    extern option_struct     options;
+
+    param_index_cell_struct *cell;
+    size_t                   k;
+
+    k = (size_t) (*cellnum + 1);
+    while (k < index->ncells && k % options.NWORKERS != worker) {
+        k++;
+    }
+    if (k >= index->ncells) {
+        return false;
+    }
+
+    cell = &(index->cells[k]);
+    if (fseek(filep->soilparam, (long) cell->soil, SEEK_SET) != 0 ||
+        fseek(filep->vegparam, (long) cell->veg, SEEK_SET) != 0) {
+        log_err("Unable to seek to grid cell %d", (int) cell->gridcel);
+    }
+    if (options.SNOW_BAND > 1) {
+        // a grid cell that is not in the file is read at the end of the file
+        if (cell->snowband >= 0) {
+            fseek(filep->snowband, (long) cell->snowband, SEEK_SET);
+        }
+        else {
+            fseek(filep->snowband, 0, SEEK_END);
+        }
+    }
+    *cellnum = (int) k - 1;
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Free the index of the parameter files.
+ *****************************************************************************/
+void
+free_param_index(param_index_struct *index)
+{
+    free(index->cells);
+    index->cells = NULL;
+    index->ncells = 0;
+}
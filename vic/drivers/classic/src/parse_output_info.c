@@ -160,7 +160,8 @@ parse_output_info(FILE           *gp,
                     }
                     sscanf(cmdstr, "%*s %s", flgstr);
                     if (strcasecmp("TRUE", flgstr) == 0) {
-                        (*streams)[streamnum].compress = COMPRESSION_LVL_UNSET;
+                        (*streams)[streamnum].compress =
+                            COMPRESSION_LVL_DEFAULT;
                     }
                     else if (strcasecmp("FALSE", flgstr) == 0) {
                         (*streams)[streamnum].compress = 0;
@@ -210,6 +211,8 @@ parse_output_info(FILE           *gp,
                     // Add OUTVAR to stream
                     set_output_var(&(*streams)[streamnum], varname, outvarnum,
                                    format, type, mult, agg_type);
+                    (*streams)[streamnum].aggparam[outvarnum] =
+                        str_to_agg_param(aggstr);
                     outvarnum++;
                 }
             }
@@ -140,6 +140,8 @@ print_filenames(filenames_struct *fnames)
     fprintf(LOG_DEST, "\tf_path_pfx[0]: %s\n", fnames->f_path_pfx[0]);
     fprintf(LOG_DEST, "\tf_path_pfx[1]: %s\n", fnames->f_path_pfx[1]);
     fprintf(LOG_DEST, "\tglobal       : %s\n", fnames->global);
+    fprintf(LOG_DEST, "\trun_bundle   : %s\n", fnames->run_bundle);
+    fprintf(LOG_DEST, "\tparam_index  : %s\n", fnames->param_index);
     fprintf(LOG_DEST, "\tconstants    : %s\n", fnames->constants);
     fprintf(LOG_DEST, "\tinit_state   : %s\n", fnames->init_state);
     fprintf(LOG_DEST, "\tlakeparam    : %s\n", fnames->lakeparam);
@@ -26,14 +26,51 @@
 
 #include <vic_driver_classic.h>
 
+/******************************************************************************
+ * @brief    Scale one field of a block of binary forcing records.
+ *
+ * @param values first value of the field, already in machine byte order
+ * @param Nrecs number of records in the block
+ * @param stride number of values per record
+ * @param type forcing variable type (sign and multiplier)
+ * @param data destination of the Nrecs decoded values
+ *****************************************************************************/
+static void
+decode_forcing_values(unsigned short int *values,
+                      size_t              Nrecs,
+                      size_t              stride,
+                      force_type_struct  *type,
+                      double             *data)
+{
+    size_t rec;
+
+    if (type->SIGNED) {
+        for (rec = 0; rec < Nrecs; rec++) {
+            data[rec] = (double) ((signed short) values[rec * stride]) /
+                        type->multiplier;
+        }
+    }
+    else {
+        for (rec = 0; rec < Nrecs; rec++) {
+            data[rec] = (double) values[rec * stride] / type->multiplier;
+        }
+    }
+}
+
 /******************************************************************************
  * @brief    Read in atmospheric data values from a binary/ascii file.
+ *
+ * @details  Reads the forcings of global_param.nrecs model time steps
+ *           starting at model time step rec_start. The file is positioned at
+ *           the start of the simulation period only for rec_start = 0; later
+ *           calls continue where the previous call stopped.
  *****************************************************************************/
 void
 read_atmos_data(FILE               *infile,
                 global_param_struct global_param,
                 int                 file_num,
                 int                 forceskip,
+                size_t              rec_start,
                 double            **forcing_data,
                 double           ***veg_hist_data)
 {
@@ -46,10 +83,17 @@ read_atmos_data(FILE               *infile,
     unsigned int            Nfields;
     int                    *field_index;
     unsigned short int      ustmp;
-    signed short            stmp;
-    char                    str[MAXSTRING + 1];
     unsigned short int      Identifier[4];
     int                     Nbytes;
+    unsigned short int     *buffer;
+    size_t                  Nvalues;
+    size_t                  Nblock;
+    size_t                  Nread;
+    size_t                  k;
+    unsigned int            Nrecs;
+    double                 *values;
+    char                   *line = NULL;
+    size_t                  linesize = 0;
 
     Nfields = param_set.N_TYPES[file_num];
     field_index = param_set.FORCE_INDEX[file_num];
@@ -88,6 +132,20 @@ read_atmos_data(FILE               *infile,
         log_info("NULL file");
     }
 
+    /** number of values per record and of records to read **/
+    Nvalues = 0;
+    for (i = 0; i < Nfields; i++) {
+        if (field_index[i] != ALBEDO && field_index[i] != LAI_IN &&
+            field_index[i] != FCANOPY) {
+            Nvalues++;
+        }
+        else {
+            Nvalues += param_set.TYPE[field_index[i]].N_ELEM;
+        }
+    }
+    Nrecs = (unsigned int) ceil(global_param.nrecs * global_param.dt /
+                                param_set.FORCE_DT[file_num]);
+
     /***************************
        Read BINARY Forcing Data
     ***************************/
@@ -102,102 +160,90 @@ read_atmos_data(FILE               *infile,
             endian = BIG;
         }
 
-        // Check for presence of a header, & skip over it if appropriate.
-        // A VIC header will start with 4 instances of the identifier,
-        // followed by number of bytes in the header (Nbytes).
-        // Nbytes is assumed to be the byte offset at which the data records start.
-        fseek(infile, 0, SEEK_SET);
-        if (feof(infile)) {
-            log_err("No data in the forcing file.");
-        }
-        for (i = 0; i < 4; i++) {
-            fread(&ustmp, sizeof(unsigned short int), 1, infile);
-            if (endian != param_set.FORCE_ENDIAN[file_num]) {
-                ustmp = ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
+        // Later windows of records continue where the previous call stopped
+        if (rec_start == 0) {
+            // Check for presence of a header, & skip over it if appropriate.
+            // A VIC header will start with 4 instances of the identifier,
+            // followed by number of bytes in the header (Nbytes).
+            // Nbytes is assumed to be the byte offset at which the data records
+            // start.
+            fseek(infile, 0, SEEK_SET);
+            if (feof(infile)) {
+                log_err("No data in the forcing file.");
             }
-            Identifier[i] = ustmp;
-        }
-        if (Identifier[0] != 0xFFFF || Identifier[1] != 0xFFFF ||
-            Identifier[2] != 0xFFFF || Identifier[3] != 0xFFFF) {
-            Nbytes = 0;
-        }
-        else {
-            fread(&ustmp, sizeof(unsigned short int), 1, infile);
-            if (endian != param_set.FORCE_ENDIAN[file_num]) {
-                ustmp = ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
+            for (i = 0; i < 4; i++) {
+                fread(&ustmp, sizeof(unsigned short int), 1, infile);
+                if (endian != param_set.FORCE_ENDIAN[file_num]) {
+                    ustmp = ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
+                }
+                Identifier[i] = ustmp;
             }
-            Nbytes = (int) ustmp;
-        }
-        fseek(infile, Nbytes, SEEK_SET);
-
+            if (Identifier[0] != 0xFFFF || Identifier[1] != 0xFFFF ||
+                Identifier[2] != 0xFFFF || Identifier[3] != 0xFFFF) {
+                Nbytes = 0;
+            }
+            else {
+                fread(&ustmp, sizeof(unsigned short int), 1, infile);
+                if (endian != param_set.FORCE_ENDIAN[file_num]) {
+                    ustmp = ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
+                }
+                Nbytes = (int) ustmp;
+            }
+            fseek(infile, Nbytes, SEEK_SET);
 
-        /** if forcing file starts before the model simulation,
-            skip over its starting records **/
-        fseek(infile, skip_recs * Nfields * sizeof(short int), SEEK_CUR);
-        if (feof(infile)) {
-            log_err("No data for the specified time period in the forcing "
-                    "file.");
+            /** if forcing file starts before the model simulation,
+                skip over its starting records **/
+            fseek(infile, skip_recs * Nvalues * sizeof(short int), SEEK_CUR);
+            if (feof(infile)) {
+                log_err("No data for the specified time period in the forcing "
+                        "file.");
+            }
         }
 
-        /** Read BINARY forcing data **/
+        /** Read BINARY forcing data in blocks of records **/
+        buffer = malloc(FORCE_READ_BLOCK * Nvalues * sizeof(*buffer));
+        check_alloc_status(buffer, "Memory allocation error.");
+
         rec = 0;
+        while (rec < Nrecs) {
+            Nblock = min(FORCE_READ_BLOCK, Nrecs - rec);
+            Nread = fread(buffer, Nvalues * sizeof(*buffer), Nblock, infile);
 
-        while (!feof(infile) && (rec * param_set.FORCE_DT[file_num] <
-                                 global_param.nrecs * global_param.dt)) {
+            if (endian != param_set.FORCE_ENDIAN[file_num]) {
+                for (k = 0; k < Nread * Nvalues; k++) {
+                    buffer[k] = ((buffer[k] & 0xFF) << 8) |
+                                ((buffer[k] >> 8) & 0xFF);
+                }
+            }
+
+            // decode the block one field at a time
+            k = 0;
             for (i = 0; i < Nfields; i++) {
                 if (field_index[i] != ALBEDO && field_index[i] != LAI_IN &&
                     field_index[i] != FCANOPY) {
-                    if (param_set.TYPE[field_index[i]].SIGNED) {
-                        fread(&stmp, sizeof(short int), 1, infile);
-                        if (endian != param_set.FORCE_ENDIAN[file_num]) {
-                            stmp = ((stmp & 0xFF) << 8) | ((stmp >> 8) & 0xFF);
-                        }
-                        forcing_data[field_index[i]][rec] =
-                            (double) stmp /
-                            param_set.TYPE[field_index[i]].multiplier;
-                    }
-                    else {
-                        fread(&ustmp, sizeof(unsigned short int), 1, infile);
-                        if (endian != param_set.FORCE_ENDIAN[file_num]) {
-                            ustmp =
-                                ((ustmp & 0xFF) << 8) | ((ustmp >> 8) & 0xFF);
-                        }
-                        forcing_data[field_index[i]][rec] =
-                            (double) ustmp /
-                            param_set.TYPE[field_index[i]].multiplier;
-                    }
+                    decode_forcing_values(buffer + k, Nread, Nvalues,
+                                          &(param_set.TYPE[field_index[i]]),
+                                          forcing_data[field_index[i]] + rec);
+                    k++;
                 }
                 else {
                     for (j = 0; j < param_set.TYPE[field_index[i]].N_ELEM;
                          j++) {
-                        if (param_set.TYPE[field_index[i]].SIGNED) {
-                            fread(&stmp, sizeof(short int), 1, infile);
-                            if (endian != param_set.FORCE_ENDIAN[file_num]) {
-                                stmp =
-                                    ((stmp & 0xFF) << 8) | ((stmp >> 8) & 0xFF);
-                            }
-                            veg_hist_data[field_index[i]][j][rec] =
-                                (double) stmp /
-                                param_set.TYPE[field_index[i]].multiplier;
-                        }
-                        else {
-                            fread(&ustmp, sizeof(unsigned short int), 1,
-                                  infile);
-                            if (endian != param_set.FORCE_ENDIAN[file_num]) {
-                                ustmp =
-                                    ((ustmp &
-                                      0xFF) << 8) | ((ustmp >> 8) & 0xFF);
-                            }
-                            veg_hist_data[field_index[i]][j][rec] =
-                                (double) ustmp /
-                                param_set.TYPE[field_index[i]].multiplier;
-                        }
+                        decode_forcing_values(buffer + k, Nread, Nvalues,
+                                              &(param_set.TYPE[field_index[i]]),
+                                              veg_hist_data[field_index[i]][j] +
+                                              rec);
+                        k++;
                     }
                 }
             }
 
-            rec++;
+            rec += Nread;
+            if (Nread < Nblock) {
+                break;
+            }
         }
+        free(buffer);
     }
 
     /**************************
@@ -213,34 +259,48 @@ read_atmos_data(FILE               *infile,
         // also read the headers if necessary).
 
         /* skip to the beginning of the required met data */
-        for (i = 0; i < skip_recs; i++) {
-            if (fgets(str, MAXSTRING, infile) == NULL) {
+        for (i = 0; rec_start == 0 && i < skip_recs; i++) {
+            if (getline(&line, &linesize, infile) < 0) {
                 log_err("No data for the specified time period in the forcing "
                         "file.");
             }
         }
 
-        /* read forcing data */
+        /* read forcing data, one line per record */
+        values = calloc(Nvalues, sizeof(*values));
+        check_alloc_status(values, "Memory allocation error.");
+
         rec = 0;
+        while (rec < Nrecs && getline(&line, &linesize, infile) >= 0) {
+            Nread = str_to_doubles(line, values, Nvalues);
+            if (Nread == 0) {
+                // skip blank lines
+                continue;
+            }
+            if (Nread < Nvalues) {
+                log_err("Record %u of forcing file %i has %zu values, but "
+                        "%zu forcing values were specified in the global "
+                        "file.", skip_recs + rec + 1, file_num + 1, Nread,
+                        Nvalues);
+            }
 
-        while (!feof(infile) && (rec * param_set.FORCE_DT[file_num] <
-                                 global_param.nrecs * global_param.dt)) {
+            k = 0;
             for (i = 0; i < Nfields; i++) {
                 if (field_index[i] != ALBEDO && field_index[i] != LAI_IN &&
                     field_index[i] != FCANOPY) {
-                    fscanf(infile, "%lf", &forcing_data[field_index[i]][rec]);
+                    forcing_data[field_index[i]][rec] = values[k++];
                 }
                 else {
                     for (j = 0; j < param_set.TYPE[field_index[i]].N_ELEM;
                          j++) {
-                        fscanf(infile, "%lf",
-                               &veg_hist_data[field_index[i]][j][rec]);
+                        veg_hist_data[field_index[i]][j][rec] = values[k++];
                     }
                 }
             }
-            fgets(str, MAXSTRING, infile);
             rec++;
         }
+        free(values);
+        free(line);
     }
 
     if (rec * param_set.FORCE_DT[file_num] <
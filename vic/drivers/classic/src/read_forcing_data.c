@@ -31,10 +31,14 @@
 /******************************************************************************
  * @brief    Control the order and number of forcing variables read from the
  *           forcing data files.
+ *
+ * @details  Reads global_param.nrecs model time steps starting at model time
+ *           step rec_start, see read_atmos_data().
  *****************************************************************************/
 double **
 read_forcing_data(FILE              **infile,
                   global_param_struct global_param,
+                  size_t              rec_start,
                   double          ****veg_hist_data)
 {
     extern param_set_struct param_set;
@@ -74,7 +78,7 @@ read_forcing_data(FILE              **infile,
     /** Read First Forcing Data File **/
     if (param_set.FORCE_DT[0] > 0) {
         read_atmos_data(infile[0], global_param, 0, global_param.forceskip[0],
-                        forcing_data, (*veg_hist_data));
+                        rec_start, forcing_data, (*veg_hist_data));
     }
     else {
         log_err("File time step must be defined for at least the first "
@@ -84,7 +88,7 @@ read_forcing_data(FILE              **infile,
     /** Read Second Forcing Data File **/
     if (param_set.FORCE_DT[1] > 0) {
         read_atmos_data(infile[1], global_param, 1, global_param.forceskip[1],
-                        forcing_data, (*veg_hist_data));
+                        rec_start, forcing_data, (*veg_hist_data));
     }
 
     return(forcing_data);
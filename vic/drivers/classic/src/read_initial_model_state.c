@@ -32,6 +32,121 @@
 
 #include <vic_driver_classic.h>
 
+static state_index_struct state_index;
+
+/******************************************************************************
+ * @brief    Find the records of all grid cells in a binary state file.
+ * @details  Only the header of each record is read, the records are skipped
+ *           with their length. The index starts at the current position of
+ *           the state file, after the header of the file.
+ *****************************************************************************/
+static void
+build_state_index(FILE *init_state)
+{
+    size_t nalloc;
+    long   offset;
+    int    header[4];
+
+    nalloc = 0;
+    state_index.ncells = 0;
+    state_index.next = 0;
+    offset = ftell(init_state);
+    while (fread(header, sizeof(int), 4, init_state) == 4) {
+        if (header[3] < 0) {
+            log_err("Invalid record of grid cell %d in the model state file.",
+                    header[0]);
+        }
+        if (state_index.ncells == nalloc) {
+            nalloc = (nalloc > 0) ? 2 * nalloc : 1024;
+            state_index.cellnum = realloc(state_index.cellnum,
+                                          nalloc * sizeof(int));
+            state_index.offset = realloc(state_index.offset,
+                                         nalloc * sizeof(long));
+            state_index.length = realloc(state_index.length,
+                                         nalloc * sizeof(size_t));
+            if (state_index.cellnum == NULL || state_index.offset == NULL ||
+                state_index.length == NULL) {
+                log_err("Memory allocation error.");
+            }
+        }
+        state_index.cellnum[state_index.ncells] = header[0];
+        state_index.offset[state_index.ncells] = offset;
+        state_index.length[state_index.ncells] = STATE_RECORD_HEADER_SIZE +
+                                                 (size_t) header[3];
+        state_index.ncells++;
+        if (fseek(init_state, (long) header[3], SEEK_CUR) != 0) {
+            break;
+        }
+        offset = ftell(init_state);
+    }
+    clearerr(init_state);
+}
+
+/******************************************************************************
+ * @brief    Read the record of a grid cell from a binary state file.
+ *
+ * @details  The record is read with one fread and returned as a stream in
+ *           memory. The grid cells are usually read in the order of the state
+ *           file, so the search starts after the record read before.
+ *
+ * @return   stream of the record, to be closed and freed by the caller
+ *****************************************************************************/
+static FILE *
+open_state_record(FILE *init_state,
+                  int   cellnum,
+                  char **record)
+{
+    FILE  *state;
+    size_t i;
+    size_t k;
+
+    if (state_index.cellnum == NULL) {
+        build_state_index(init_state);
+    }
+
+    for (i = 0; i < state_index.ncells; i++) {
+        k = (state_index.next + i) % state_index.ncells;
+        if (state_index.cellnum[k] == cellnum) {
+            break;
+        }
+    }
+    if (i == state_index.ncells) {
+        log_err("Requested grid cell (%d) is not in the model state file.",
+                cellnum);
+    }
+    state_index.next = k + 1;
+
+    *record = malloc(state_index.length[k]);
+    check_alloc_status(*record, "Memory allocation error.");
+    if (fseek(init_state, state_index.offset[k], SEEK_SET) != 0 ||
+        fread(*record, state_index.length[k], 1, init_state) != 1) {
+        log_err("Unable to read grid cell %d from the model state file.",
+                cellnum);
+    }
+    state = fmemopen(*record, state_index.length[k], "rb");
+    if (state == NULL) {
+        log_err("Memory allocation error.");
+    }
+
+    return state;
+}
+
+/******************************************************************************
+ * @brief    Free the index of the binary state file.
+ *****************************************************************************/
+void
+free_state_index(void)
+{
+    free(state_index.cellnum);
+    free(state_index.offset);
+    free(state_index.length);
+    state_index.cellnum = NULL;
+    state_index.offset = NULL;
+    state_index.length = NULL;
+    state_index.ncells = 0;
+    state_index.next = 0;
+}
+
 /******************************************************************************
  * @brief    This subroutine initializes the model state at hour 0 of the date
  *           defined in the given state file.
@@ -48,7 +163,8 @@ read_initial_model_state(FILE            *init_state,
     extern option_struct options;
 
     char                 tmpstr[MAXSTRING];
-    char                 tmpchar;
+    char                *record = NULL;
+    FILE                *state;
     int                  veg, iveg;
     int                  band, iband;
     size_t               lidx;
@@ -57,7 +173,7 @@ read_initial_model_state(FILE            *init_state,
     int                  tmp_Nveg;
     int                  tmp_Nband;
     int                  tmp_char;
-    int                  byte, Nbytes;
+    int                  Nbytes;
     int                  node;
     size_t               frost_area;
 
@@ -71,48 +187,37 @@ read_initial_model_state(FILE            *init_state,
     veg_var = all_vars->veg_var;
     snow = all_vars->snow;
     energy = all_vars->energy;
-    lake_var = &all_vars->lake_var;
+    lake_var = all_vars->lake_var;
 
     /* read cell information */
     if (options.STATE_FORMAT == BINARY) {
-        fread(&tmp_cellnum, sizeof(int), 1, init_state);
-        fread(&tmp_Nveg, sizeof(int), 1, init_state);
-        fread(&tmp_Nband, sizeof(int), 1, init_state);
-        fread(&Nbytes, sizeof(int), 1, init_state);
+        state = open_state_record(init_state, cellnum, &record);
+        fread(&tmp_cellnum, sizeof(int), 1, state);
+        fread(&tmp_Nveg, sizeof(int), 1, state);
+        fread(&tmp_Nband, sizeof(int), 1, state);
+        fread(&Nbytes, sizeof(int), 1, state);
     }
     else {
-        fscanf(init_state, "%d %d %d", &tmp_cellnum, &tmp_Nveg, &tmp_Nband);
-    }
-    // Skip over unused cell information
-    while (tmp_cellnum != cellnum && !feof(init_state)) {
-        if (options.STATE_FORMAT == BINARY) {
-            // skip rest of current cells info
-            for (byte = 0; byte < Nbytes; byte++) {
-                fread(&tmpchar, 1, 1, init_state);
-            }
-            // read info for next cell
-            fread(&tmp_cellnum, sizeof(int), 1, init_state);
-            fread(&tmp_Nveg, sizeof(int), 1, init_state);
-            fread(&tmp_Nband, sizeof(int), 1, init_state);
-            fread(&Nbytes, sizeof(int), 1, init_state);
-        }
-        else {
+        state = init_state;
+        fscanf(state, "%d %d %d", &tmp_cellnum, &tmp_Nveg, &tmp_Nband);
+        // Skip over unused cell information
+        while (tmp_cellnum != cellnum && !feof(state)) {
             // skip rest of current cells info
-            fgets(tmpstr, MAXSTRING, init_state); // skip rest of general cell info
+            fgets(tmpstr, MAXSTRING, state); // skip rest of general cell info
             for (veg = 0; veg <= tmp_Nveg; veg++) {
                 for (band = 0; band < tmp_Nband; band++) {
-                    fgets(tmpstr, MAXSTRING, init_state); // skip snowband info
+                    fgets(tmpstr, MAXSTRING, state); // skip snowband info
                 }
             }
             if (options.LAKES) {
-                fgets(tmpstr, MAXSTRING, init_state); // skip lake info
+                fgets(tmpstr, MAXSTRING, state); // skip lake info
             }
             // read info for next cell
-            fscanf(init_state, "%d %d %d", &tmp_cellnum, &tmp_Nveg, &tmp_Nband);
-        } // end if
-    } // end while
+            fscanf(state, "%d %d %d", &tmp_cellnum, &tmp_Nveg, &tmp_Nband);
+        } // end while
+    }
 
-    if (feof(init_state)) {
+    if (feof(state)) {
         log_err("Requested grid cell (%d) is not in the model state file.",
                 cellnum);
     }
@@ -131,10 +236,10 @@ read_initial_model_state(FILE            *init_state,
     /* Read soil thermal node deltas */
     for (nidx = 0; nidx < options.Nnode; nidx++) {
         if (options.STATE_FORMAT == BINARY) {
-            fread(&soil_con->dz_node[nidx], sizeof(double), 1, init_state);
+            fread(&soil_con->dz_node[nidx], sizeof(double), 1, state);
         }
         else {
-            fscanf(init_state, "%lf", &soil_con->dz_node[nidx]);
+            fscanf(state, "%lf", &soil_con->dz_node[nidx]);
         }
     }
     if (options.Nnode == 1) {
@@ -144,10 +249,10 @@ read_initial_model_state(FILE            *init_state,
     /* Read soil thermal node depths */
     for (nidx = 0; nidx < options.Nnode; nidx++) {
         if (options.STATE_FORMAT == BINARY) {
-            fread(&soil_con->Zsum_node[nidx], sizeof(double), 1, init_state);
+            fread(&soil_con->Zsum_node[nidx], sizeof(double), 1, state);
         }
         else {
-            fscanf(init_state, "%lf", &soil_con->Zsum_node[nidx]);
+            fscanf(state, "%lf", &soil_con->Zsum_node[nidx]);
         }
     }
     if (options.Nnode == 1) {
@@ -166,15 +271,15 @@ read_initial_model_state(FILE            *init_state,
         for (band = 0; band < Nbands; band++) {
             /* Read cell identification information */
             if (options.STATE_FORMAT == BINARY) {
-                if (fread(&iveg, sizeof(int), 1, init_state) != 1) {
+                if (fread(&iveg, sizeof(int), 1, state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
-                if (fread(&iband, sizeof(int), 1, init_state) != 1) {
+                if (fread(&iband, sizeof(int), 1, state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
             else {
-                if (fscanf(init_state, "%d %d", &iveg, &iband) == EOF) {
+                if (fscanf(state, "%d %d", &iveg, &iband) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
@@ -191,12 +296,12 @@ read_initial_model_state(FILE            *init_state,
             for (lidx = 0; lidx < options.Nlayer; lidx++) {
                 if (options.STATE_FORMAT == BINARY) {
                     if (fread(&cell[veg][band].layer[lidx].moist,
-                              sizeof(double), 1, init_state) != 1) {
+                              sizeof(double), 1, state) != 1) {
                         log_err("End of model state file found unexpectedly");
                     }
                 }
                 else {
-                    if (fscanf(init_state, " %lf",
+                    if (fscanf(state, " %lf",
                                &cell[veg][band].layer[lidx].moist) == EOF) {
                         log_err("End of model state file found unexpectedly");
                     }
@@ -209,13 +314,13 @@ read_initial_model_state(FILE            *init_state,
                      frost_area++) {
                     if (options.STATE_FORMAT == BINARY) {
                         if (fread(&cell[veg][band].layer[lidx].ice[frost_area],
-                                  sizeof(double), 1, init_state) != 1) {
+                                  sizeof(double), 1, state) != 1) {
                             log_err("End of model state file found"
                                     "unexpectedly");
                         }
                     }
                     else {
-                        if (fscanf(init_state, " %lf",
+                        if (fscanf(state, " %lf",
                                    &cell[veg][band].layer[lidx].ice[frost_area])
                             ==
                             EOF) {
@@ -230,12 +335,12 @@ read_initial_model_state(FILE            *init_state,
                 /* Read dew storage */
                 if (options.STATE_FORMAT == BINARY) {
                     if (fread(&veg_var[veg][band].Wdew, sizeof(double), 1,
-                              init_state) != 1) {
+                              state) != 1) {
                         log_err("End of model state file found unexpectedly");
                     }
                 }
                 else {
-                    if (fscanf(init_state, " %lf",
+                    if (fscanf(state, " %lf",
                                &veg_var[veg][band].Wdew) == EOF) {
                         log_err("End of model state file found unexpectedly");
                     }
@@ -245,47 +350,47 @@ read_initial_model_state(FILE            *init_state,
                     if (options.STATE_FORMAT == BINARY) {
                         /* Read cumulative annual NPP */
                         if (fread(&(veg_var[veg][band].AnnualNPP),
-                                  sizeof(double), 1, init_state) != 1) {
+                                  sizeof(double), 1, state) != 1) {
                             log_err("End of model state file found unexpectedly");
                         }
                         if (fread(&(veg_var[veg][band].AnnualNPPPrev),
-                                  sizeof(double), 1, init_state) != 1) {
+                                  sizeof(double), 1, state) != 1) {
                             log_err("End of model state file found unexpectedly");
                         }
                         /* Read Soil Carbon Storage */
                         if (fread(&(cell[veg][band].CLitter), sizeof(double), 1,
-                                  init_state) != 1) {
+                                  state) != 1) {
                             log_err("End of model state file found unexpectedly");
                         }
                         if (fread(&(cell[veg][band].CInter), sizeof(double), 1,
-                                  init_state) != 1) {
+                                  state) != 1) {
                             log_err("End of model state file found unexpectedly");
                         }
                         if (fread(&(cell[veg][band].CSlow), sizeof(double), 1,
-                                  init_state) != 1) {
+                                  state) != 1) {
                             log_err("End of model state file found unexpectedly");
                         }
                     }
                     else {
                         /* Read cumulative annual NPP */
-                        if (fscanf(init_state, " %lf",
+                        if (fscanf(state, " %lf",
                                    &veg_var[veg][band].AnnualNPP) == EOF) {
                             log_err("End of model state file found unexpectedly");
                         }
-                        if (fscanf(init_state, " %lf",
+                        if (fscanf(state, " %lf",
                                    &veg_var[veg][band].AnnualNPPPrev) == EOF) {
                             log_err("End of model state file found unexpectedly");
                         }
                         /* Read Soil Carbon Storage */
-                        if (fscanf(init_state, " %lf",
+                        if (fscanf(state, " %lf",
                                    &cell[veg][band].CLitter) == EOF) {
                             log_err("End of model state file found unexpectedly");
                         }
-                        if (fscanf(init_state, " %lf",
+                        if (fscanf(state, " %lf",
                                    &cell[veg][band].CInter) == EOF) {
                             log_err("End of model state file found unexpectedly");
                         }
-                        if (fscanf(init_state, " %lf",
+                        if (fscanf(state, " %lf",
                                    &cell[veg][band].CSlow) == EOF) {
                             log_err("End of model state file found unexpectedly");
                         }
@@ -296,52 +401,52 @@ read_initial_model_state(FILE            *init_state,
             /* Read snow data */
             if (options.STATE_FORMAT == BINARY) {
                 if (fread(&snow[veg][band].last_snow, sizeof(int), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].MELTING, sizeof(char), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].coverage, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].swq, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].surf_temp, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].surf_water, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].pack_temp, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].pack_water, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].density, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].coldcontent, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&snow[veg][band].snow_canopy, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
             else {
-                if (fscanf(init_state,
+                if (fscanf(state,
                            " %d %d %lf %lf %lf %lf %lf %lf %lf %lf %lf",
                            &snow[veg][band].last_snow, &tmp_char,
                            &snow[veg][band].coverage, &snow[veg][band].swq,
@@ -362,12 +467,12 @@ read_initial_model_state(FILE            *init_state,
             for (nidx = 0; nidx < options.Nnode; nidx++) {
                 if (options.STATE_FORMAT == BINARY) {
                     if (fread(&energy[veg][band].T[nidx], sizeof(double), 1,
-                              init_state) != 1) {
+                              state) != 1) {
                         log_err("End of model state file found unexpectedly");
                     }
                 }
                 else {
-                    if (fscanf(init_state, " %lf",
+                    if (fscanf(state, " %lf",
                                &energy[veg][band].T[nidx]) == EOF) {
                         log_err("End of model state file found unexpectedly");
                     }
@@ -377,12 +482,12 @@ read_initial_model_state(FILE            *init_state,
             /* Read foliage temperature*/
             if (options.STATE_FORMAT == BINARY) {
                 if (fread(&energy[veg][band].Tfoliage, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
             else {
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &energy[veg][band].Tfoliage) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
@@ -392,12 +497,12 @@ read_initial_model_state(FILE            *init_state,
             /* TO-DO: this is a flux. Saving it to the state file is a temporary solution! */
             if (options.STATE_FORMAT == BINARY) {
                 if (fread(&energy[veg][band].LongUnderOut, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
             else {
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &energy[veg][band].LongUnderOut) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
@@ -407,12 +512,12 @@ read_initial_model_state(FILE            *init_state,
             /* TO-DO: this is a flux. Saving it to the state file is a temporary solution! */
             if (options.STATE_FORMAT == BINARY) {
                 if (fread(&energy[veg][band].snow_flux, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
             else {
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &energy[veg][band].snow_flux) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
@@ -424,7 +529,7 @@ read_initial_model_state(FILE            *init_state,
             /* Read total soil moisture */
             for (lidx = 0; lidx < options.Nlayer; lidx++) {
                 if (fread(&lake_var->soil.layer[lidx].moist, sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
@@ -434,7 +539,7 @@ read_initial_model_state(FILE            *init_state,
                 for (frost_area = 0; frost_area < options.Nfrost;
                      frost_area++) {
                     if (fread(&lake_var->soil.layer[lidx].ice[frost_area],
-                              sizeof(double), 1, init_state) != 1) {
+                              sizeof(double), 1, state) != 1) {
                         log_err("End of model state file found unexpectedly");
                     }
                 }
@@ -443,62 +548,62 @@ read_initial_model_state(FILE            *init_state,
             if (options.CARBON) {
                 /* Read Soil Carbon Storage */
                 if (fread(&(lake_var->soil.CLitter), sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&(lake_var->soil.CInter), sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
                 if (fread(&(lake_var->soil.CSlow), sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
 
             /* Read snow data */
             if (fread(&lake_var->snow.last_snow, sizeof(int), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.MELTING, sizeof(char), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.coverage, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.swq, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.surf_temp, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.surf_water, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.pack_temp, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.pack_water, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.density, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.coldcontent, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->snow.snow_canopy, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (lake_var->snow.density > 0.) {
@@ -509,96 +614,96 @@ read_initial_model_state(FILE            *init_state,
             /* Read soil thermal node temperatures */
             for (nidx = 0; nidx < options.Nnode; nidx++) {
                 if (fread(&lake_var->energy.T[nidx], sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
 
             /* Read lake-specific variables */
-            if (fread(&lake_var->activenod, sizeof(int), 1, init_state) != 1) {
+            if (fread(&lake_var->activenod, sizeof(int), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->dz, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->dz, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->surfdz, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->surfdz, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->ldepth, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->ldepth, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             for (node = 0; node <= lake_var->activenod; node++) {
                 if (fread(&lake_var->surface[node], sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
-            if (fread(&lake_var->sarea, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->sarea, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->volume, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->volume, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             for (node = 0; node < lake_var->activenod; node++) {
                 if (fread(&lake_var->temp[node], sizeof(double), 1,
-                          init_state) != 1) {
+                          state) != 1) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
-            if (fread(&lake_var->tempavg, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->tempavg, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->areai, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->areai, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->new_ice_area, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->ice_water_eq, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->hice, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->hice, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->tempi, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->tempi, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->swe, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->swe, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->surf_temp, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->pack_temp, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->coldcontent, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->surf_water, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
             if (fread(&lake_var->pack_water, sizeof(double), 1,
-                      init_state) != 1) {
+                      state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->SAlbedo, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->SAlbedo, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fread(&lake_var->sdepth, sizeof(double), 1, init_state) != 1) {
+            if (fread(&lake_var->sdepth, sizeof(double), 1, state) != 1) {
                 log_err("End of model state file found unexpectedly");
             }
         }
         else {
             /* Read total soil moisture */
             for (lidx = 0; lidx < options.Nlayer; lidx++) {
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &lake_var->soil.layer[lidx].moist) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
@@ -608,7 +713,7 @@ read_initial_model_state(FILE            *init_state,
             for (lidx = 0; lidx < options.Nlayer; lidx++) {
                 for (frost_area = 0; frost_area < options.Nfrost;
                      frost_area++) {
-                    if (fscanf(init_state, " %lf",
+                    if (fscanf(state, " %lf",
                                &lake_var->soil.layer[lidx].ice[frost_area]) ==
                         EOF) {
                         log_err("End of model state file found unexpectedly");
@@ -618,20 +723,20 @@ read_initial_model_state(FILE            *init_state,
 
             if (options.CARBON) {
                 /* Read Soil Carbon Storage */
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &lake_var->soil.CLitter) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
-                if (fscanf(init_state, " %lf", &lake_var->soil.CInter) == EOF) {
+                if (fscanf(state, " %lf", &lake_var->soil.CInter) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
-                if (fscanf(init_state, " %lf", &lake_var->soil.CSlow) == EOF) {
+                if (fscanf(state, " %lf", &lake_var->soil.CSlow) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
 
             /* Read snow data */
-            if (fscanf(init_state, " %d %d %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+            if (fscanf(state, " %d %d %lf %lf %lf %lf %lf %lf %lf %lf %lf",
                        &lake_var->snow.last_snow, &tmp_char,
                        &lake_var->snow.coverage, &lake_var->snow.swq,
                        &lake_var->snow.surf_temp, &lake_var->snow.surf_water,
@@ -649,82 +754,82 @@ read_initial_model_state(FILE            *init_state,
 
             /* Read soil thermal node temperatures */
             for (nidx = 0; nidx < options.Nnode; nidx++) {
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &lake_var->energy.T[nidx]) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
 
             /* Read lake-specific variables */
-            if (fscanf(init_state, " %hu", &lake_var->activenod) == EOF) {
+            if (fscanf(state, " %hu", &lake_var->activenod) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->dz) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->dz) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->surfdz) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->surfdz) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->ldepth) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->ldepth) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
             for (node = 0; node <= lake_var->activenod; node++) {
-                if (fscanf(init_state, " %lf",
+                if (fscanf(state, " %lf",
                            &lake_var->surface[node]) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
-            if (fscanf(init_state, " %lf", &lake_var->sarea) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->sarea) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->volume) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->volume) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
             for (node = 0; node < lake_var->activenod; node++) {
-                if (fscanf(init_state, " %lf", &lake_var->temp[node]) == EOF) {
+                if (fscanf(state, " %lf", &lake_var->temp[node]) == EOF) {
                     log_err("End of model state file found unexpectedly");
                 }
             }
-            if (fscanf(init_state, " %lf", &lake_var->tempavg) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->tempavg) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->areai) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->areai) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->new_ice_area) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->new_ice_area) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->ice_water_eq) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->ice_water_eq) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->hice) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->hice) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->tempi) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->tempi) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->swe) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->swe) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->surf_temp) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->surf_temp) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->pack_temp) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->pack_temp) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->coldcontent) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->coldcontent) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->surf_water) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->surf_water) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->pack_water) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->pack_water) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->SAlbedo) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->SAlbedo) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
-            if (fscanf(init_state, " %lf", &lake_var->sdepth) == EOF) {
+            if (fscanf(state, " %lf", &lake_var->sdepth) == EOF) {
                 log_err("End of model state file found unexpectedly");
             }
         }
@@ -782,4 +887,9 @@ read_initial_model_state(FILE            *init_state,
             }
         }
     }
+
+    if (options.STATE_FORMAT == BINARY) {
+        fclose(state);
+        free(record);
+    }
 }
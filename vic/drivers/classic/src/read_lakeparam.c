@@ -76,7 +76,8 @@ read_lakeparam(FILE           *lakeparam,
         if (temp.numnod > MAX_LAKE_NODES) {
             log_err("Number of lake nodes (%zu) in cell %d specified in the "
                     "lake parameter file exceeds the maximum allowable (%d), "
-                    "edit MAX_LAKE_NODES in user_def.h.", temp.numnod,
+                    "recompile with a larger MAX_LAKE_NODES "
+                    "(make MAX_LAKE_NODES=n).", temp.numnod,
                     soil_con.gridcel, MAX_LAKE_NODES);
         }
         fscanf(lakeparam, "%lf", &temp.mindepth);
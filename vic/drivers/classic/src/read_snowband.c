@@ -39,6 +39,8 @@ read_snowband(FILE            *snowband,
     extern parameters_struct param;
 
     char                     ErrStr[MAXSTRING];
+    char                     line[MAXSTRING];
+    double                   values[3 * MAX_BANDS];
     size_t                   band;
     size_t                   Nbands;
     unsigned int             cell;
@@ -66,10 +68,17 @@ read_snowband(FILE            *snowband,
             return;
         }
 
-        /** Read Area Fraction **/
+        /** Read All Band Values of the Grid Cell **/
+        if (fgets(line, MAXSTRING, snowband) == NULL ||
+            str_to_doubles(line, values, 3 * Nbands) < 3 * Nbands) {
+            log_err("Expected %zu values for grid cell %i in the snow band "
+                    "file.", 3 * Nbands, soil_con->gridcel);
+        }
+
+        /** Area Fraction **/
         total = 0.;
         for (band = 0; band < Nbands; band++) {
-            fscanf(snowband, "%lf", &area_fract);
+            area_fract = values[band];
             if (area_fract < 0) {
                 log_err("Negative snow band area fraction (%f) read from file",
                         area_fract);
@@ -85,10 +94,10 @@ read_snowband(FILE            *snowband,
             }
         }
 
-        /** Read Band Elevation **/
+        /** Band Elevation **/
         avg_elev = 0;
         for (band = 0; band < Nbands; band++) {
-            fscanf(snowband, "%lf", &band_elev);
+            band_elev = values[Nbands + band];
             if (band_elev < 0) {
                 log_err("Negative snow band elevation (%f) read from file",
                         band_elev);
@@ -109,10 +118,10 @@ read_snowband(FILE            *snowband,
                  soil_con->elevation) * param.LAPSE_RATE;
         }
 
-        /** Read Precipitation Fraction **/
+        /** Precipitation Fraction **/
         total = 0.;
         for (band = 0; band < options.SNOW_BAND; band++) {
-            fscanf(snowband, "%lf", &prec_frac);
+            prec_frac = values[2 * Nbands + band];
             if (prec_frac < 0) {
                 log_err("Snow band precipitation fraction (%f) must be "
                         "between 0 and 1", prec_frac);
@@ -91,7 +91,7 @@ read_soilparam(FILE            *soilparam,
         if ((token = strtok(tmpline, delimiters)) == NULL) {
             log_err("Can't find values for CELL NUMBER in soil file");
         }
-        sscanf(token, "%d", &(temp->gridcel));
+        temp->gridcel = atoi(token);
         token = strtok(NULL, delimiters);
         while (token != NULL && (length = strlen(token)) == 0) {
             token = strtok(NULL, delimiters);
@@ -99,7 +99,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for CELL LATITUDE in soil file");
         }
-        sscanf(token, "%lf", &(temp->lat));
+        temp->lat = strtod(token, NULL);
         token = strtok(NULL, delimiters);
         while (token != NULL && (length = strlen(token)) == 0) {
             token = strtok(NULL, delimiters);
@@ -107,7 +107,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for CELL LONGITUDE in soil file");
         }
-        sscanf(token, "%lf", &(temp->lng));
+        temp->lng = strtod(token, NULL);
 
         /* read infiltration parameter */
         token = strtok(NULL, delimiters);
@@ -117,7 +117,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for INFILTRATION in soil file");
         }
-        sscanf(token, "%lf", &(temp->b_infilt));
+        temp->b_infilt = strtod(token, NULL);
         if (temp->b_infilt <= 0) {
             log_err("b_infilt (%f) in soil file is <= 0; b_infilt must "
                     "be positive", temp->b_infilt);
@@ -132,7 +132,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for FRACTION OF BASEFLOW RATE "
                     "in soil file");
         }
-        sscanf(token, "%lf", &(temp->Ds));
+        temp->Ds = strtod(token, NULL);
 
         /* read maximum baseflow rate */
         token = strtok(NULL, delimiters);
@@ -143,7 +143,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for MAXIMUM BASEFLOW RATE in "
                     "soil file");
         }
-        sscanf(token, "%lf", &(temp->Dsmax));
+        temp->Dsmax = strtod(token, NULL);
 
         /* read fraction of bottom soil layer moisture */
         token = strtok(NULL, delimiters);
@@ -154,7 +154,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for FRACTION OF BOTTOM SOIL LAYER "
                     "MOISTURE in soil file");
         }
-        sscanf(token, "%lf", &(temp->Ws));
+        temp->Ws = strtod(token, NULL);
 
         /* read exponential */
         token = strtok(NULL, delimiters);
@@ -164,7 +164,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for EXPONENTIAL in soil file");
         }
-        sscanf(token, "%lf", &(temp->c));
+        temp->c = strtod(token, NULL);
 
         /* read expt for each layer */
         for (layer = 0; layer < options.Nlayer; layer++) {
@@ -176,7 +176,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for EXPT for layer %zu in "
                         "soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->expt)[layer]);
+            temp->expt[layer] = strtod(token, NULL);
             if (temp->expt[layer] < 3.0) {
                 log_err("Exponent in layer %zu is %f < 3.0; This must be "
                         "> 3.0", layer, temp->expt[layer]);
@@ -193,7 +193,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for SATURATED HYDRAULIC "
                         "CONDUCTIVITY for layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->Ksat)[layer]);
+            (temp->Ksat)[layer] = strtod(token, NULL);
         }
 
         /* read layer phi_s */
@@ -206,7 +206,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for PHI_S for layer %zu in "
                         "soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->phi_s)[layer]);
+            temp->phi_s[layer] = strtod(token, NULL);
         }
 
         /* read layer initial moisture */
@@ -219,7 +219,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for INITIAL MOISTURE for "
                         "layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->init_moist)[layer]);
+            temp->init_moist[layer] = strtod(token, NULL);
             if (temp->init_moist[layer] < 0.) {
                 log_err("Initial moisture for layer %zu cannot be "
                         "negative (%f)", layer, temp->init_moist[layer]);
@@ -235,7 +235,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for CELL MEAN ELEVATION in soil "
                     "file");
         }
-        sscanf(token, "%lf", &(temp->elevation));
+        temp->elevation = strtod(token, NULL);
 
         /* soil layer thicknesses */
         for (layer = 0; layer < options.Nlayer; layer++) {
@@ -247,7 +247,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for LAYER THICKNESS for "
                         "layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->depth)[layer]);
+            temp->depth[layer] = strtod(token, NULL);
         }
         /* round soil layer thicknesses to nearest mm */
         for (layer = 0; layer < options.Nlayer; layer++) {
@@ -264,7 +264,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for AVERAGE SOIL TEMPERATURE in "
                     "soil file");
         }
-        sscanf(token, "%lf", &(temp->avg_temp));
+        temp->avg_temp = strtod(token, NULL);
         if ((options.FULL_ENERGY || options.LAKES) &&
             (temp->avg_temp > 100. || temp->avg_temp < -50)) {
             log_err("Need valid average soil temperature in degrees C to "
@@ -281,7 +281,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for SOIL DAMPING DEPTH in soil "
                     "file");
         }
-        sscanf(token, "%lf", &(temp->dp));
+        temp->dp = strtod(token, NULL);
 
         /* read layer bubbling pressure */
         for (layer = 0; layer < options.Nlayer; layer++) {
@@ -293,7 +293,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for BUBBLING PRESSURE for "
                         "layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->bubble)[layer]);
+            temp->bubble[layer] = strtod(token, NULL);
             if ((options.FULL_ENERGY ||
                  options.FROZEN_SOIL) && temp->bubble[layer] < 0) {
                 log_err("Bubbling pressure in layer %zu is %f < 0; "
@@ -312,7 +312,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for QUARTZ CONTENT for "
                         "layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->quartz)[layer]);
+            temp->quartz[layer] = strtod(token, NULL);
             if (options.FULL_ENERGY &&
                 (temp->quartz[layer] > 1. || temp->quartz[layer] < 0)) {
                 log_err("Need valid quartz content as a fraction to run "
@@ -331,7 +331,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for mineral BULK DENSITY "
                         "for layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->bulk_dens_min)[layer]);
+            temp->bulk_dens_min[layer] = strtod(token, NULL);
             if (temp->bulk_dens_min[layer] <= 0) {
                 log_err("layer %zu mineral bulk density (%f) must "
                         "be > 0", layer, temp->bulk_dens_min[layer]);
@@ -348,7 +348,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for mineral SOIL DENSITY "
                         "for layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->soil_dens_min)[layer]);
+            temp->soil_dens_min[layer] = strtod(token, NULL);
             if (temp->soil_dens_min[layer] <= 0) {
                 log_err("layer %zu mineral soil density (%f) must "
                         "be > 0", layer, temp->soil_dens_min[layer]);
@@ -372,7 +372,7 @@ read_soilparam(FILE            *soilparam,
                     log_err("Can't find values for ORGANIC CONTENT for "
                             "layer %zu in soil file", layer);
                 }
-                sscanf(token, "%lf", &(temp->organic)[layer]);
+                temp->organic[layer] = strtod(token, NULL);
                 if (temp->organic[layer] > 1. || temp->organic[layer] < 0) {
                     log_err("Need valid volumetric organic soil "
                             "fraction when options.ORGANIC_FRACT is set "
@@ -391,7 +391,7 @@ read_soilparam(FILE            *soilparam,
                     log_err("Can't find values for organic BULK "
                             "DENSITY for layer %zu in soil file", layer);
                 }
-                sscanf(token, "%lf", &(temp->bulk_dens_org)[layer]);
+                temp->bulk_dens_org[layer] = strtod(token, NULL);
                 if (temp->bulk_dens_org[layer] <= 0 && temp->organic[layer] >
                     0) {
                     log_warn("layer %zu organic bulk density (%f) must "
@@ -412,7 +412,7 @@ read_soilparam(FILE            *soilparam,
                     log_err("Can't find values for organic SOIL DENSITY for "
                             "layer %zu in soil file", layer);
                 }
-                sscanf(token, "%lf", &(temp->soil_dens_org)[layer]);
+                temp->soil_dens_org[layer] = strtod(token, NULL);
                 if (temp->soil_dens_org[layer] <= 0 && temp->organic[layer] >
                     0) {
                     log_warn("layer %zu organic soil density (%f) must be "
@@ -446,7 +446,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for GMT OFFSET in soil file");
         }
-        sscanf(token, "%lf", &off_gmt);
+        off_gmt = strtod(token, NULL);
 
         /* read layer critical point */
         for (layer = 0; layer < options.Nlayer; layer++) {
@@ -458,7 +458,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for CRITICAL POINT for layer %zu "
                         "in soil file", layer);
             }
-            sscanf(token, "%lf", &(Wcr_FRACT[layer]));
+            Wcr_FRACT[layer] = strtod(token, NULL);
         }
 
         /* read layer wilting point */
@@ -471,7 +471,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for WILTING POINT for layer %zu "
                         "in soil file", layer);
             }
-            sscanf(token, "%lf", &(Wpwp_FRACT[layer]));
+            Wpwp_FRACT[layer] = strtod(token, NULL);
         }
 
         /* read soil roughness */
@@ -482,7 +482,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for SOIL ROUGHNESS in soil file");
         }
-        sscanf(token, "%lf", &(temp->rough));
+        temp->rough = strtod(token, NULL);
 
         /* Overwrite default bare soil aerodynamic resistance parameters
            with the values taken from the soil parameter file */
@@ -501,7 +501,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for SNOW ROUGHNESS in soil file");
         }
-        sscanf(token, "%lf", &(temp->snow_rough));
+        temp->snow_rough = strtod(token, NULL);
 
         /* read cell annual precipitation */
         token = strtok(NULL, delimiters);
@@ -511,7 +511,7 @@ read_soilparam(FILE            *soilparam,
         if (token == NULL) {
             log_err("Can't find values for ANNUAL PRECIPITATION in soil file");
         }
-        sscanf(token, "%lf", &(temp->annual_prec));
+        temp->annual_prec = strtod(token, NULL);
 
         /* read layer residual moisture content */
         for (layer = 0; layer < options.Nlayer; layer++) {
@@ -523,7 +523,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for RESIDUAL MOISTURE CONTENT for "
                         "layer %zu in soil file", layer);
             }
-            sscanf(token, "%lf", &(temp->resid_moist)[layer]);
+            temp->resid_moist[layer] = strtod(token, NULL);
         }
 
         /* read frozen soil active flag */
@@ -535,7 +535,7 @@ read_soilparam(FILE            *soilparam,
             log_err("Can't find values for FROZEN SOIL ACTIVE FLAG in "
                     "soil file");
         }
-        sscanf(token, "%d", &tempint);
+        tempint = atoi(token);
         temp->FS_ACTIVE = (char)tempint;
 
         /* read minimum snow depth for full coverage */
@@ -547,7 +547,7 @@ read_soilparam(FILE            *soilparam,
             if (token == NULL) {
                 log_err("Can't find values for SPATIAL SNOW in soil file");
             }
-            sscanf(token, "%lf", &tempdbl);
+            tempdbl = strtod(token, NULL);
             temp->max_snow_distrib_slope = tempdbl;
         }
         else {
@@ -563,7 +563,7 @@ read_soilparam(FILE            *soilparam,
             if (token == NULL) {
                 log_err("Can't find values for SPATIAL FROST in soil file");
             }
-            sscanf(token, "%lf", &tempdbl);
+            tempdbl = strtod(token, NULL);
             temp->frost_slope = tempdbl;
         }
         else {
@@ -581,7 +581,7 @@ read_soilparam(FILE            *soilparam,
                 log_err("Can't find values for average July Tair in "
                         "soil file");
             }
-            sscanf(token, "%lf", &tempdbl);
+            tempdbl = strtod(token, NULL);
             temp->avgJulyAirTemp = tempdbl;
         }
 
@@ -0,0 +1,314 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Save the parsed configuration of a simulation in a run bundle file and
+ * load it instead of parsing the global parameter, constants and vegetation
+ * library files.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_classic.h>
+#include <sys/stat.h>
+
+/******************************************************************************
+ * @brief    Return true if a file is a run bundle.
+ *****************************************************************************/
+bool
+is_run_bundle(char filename[])
+{
+    FILE *fp;
+    char  magic[sizeof(RUN_BUNDLE_MAGIC) - 1];
+    bool  found;
+
+    fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    found = fread(magic, sizeof(magic), 1, fp) == 1 &&
+            memcmp(magic, RUN_BUNDLE_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+
+    return found;
+}
+
+/******************************************************************************
+ * @brief    Fill the part of the header that identifies the executable.
+ *****************************************************************************/
+static void
+init_run_bundle_header(run_bundle_header_struct *header)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, RUN_BUNDLE_MAGIC, sizeof(header->magic));
+    strncpy(header->version, VERSION, sizeof(header->version) - 1);
+    header->sizes[0] = sizeof(option_struct);
+    header->sizes[1] = sizeof(global_param_struct);
+    header->sizes[2] = sizeof(parameters_struct);
+    header->sizes[3] = sizeof(param_set_struct);
+    header->sizes[4] = sizeof(filenames_struct);
+    header->sizes[5] = sizeof(veg_lib_struct);
+    header->sizes[6] = sizeof(stream_struct);
+}
+
+/******************************************************************************
+ * @brief    Write a block of a run bundle.
+ *****************************************************************************/
+static void
+write_bundle_block(FILE       *fp,
+                   const void *data,
+                   size_t      size,
+                   char        filename[])
+{
+    if (size > 0 && fwrite(data, size, 1, fp) != 1) {
+        log_err("Error writing run bundle %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write the parsed configuration of the simulation to a run bundle.
+ *
+ * @details  The run bundle holds the options, global parameters, model
+ *           parameters, forcing file information, file names, vegetation
+ *           library and output stream layout as they are after all input
+ *           files have been parsed. A run bundle can only be read by the
+ *           same version of the classic driver on the same platform.
+ *****************************************************************************/
+void
+write_run_bundle(char           filename[],
+                 stream_struct *streams,
+                 veg_lib_struct *veg_lib,
+                 size_t          Nveg_type)
+{
+    extern option_struct       options;
+    extern global_param_struct global_param;
+    extern parameters_struct   param;
+    extern param_set_struct    param_set;
+    extern filenames_struct    filenames;
+    extern size_t              NF, NR;
+
+    run_bundle_header_struct   header;
+    size_t                     streamnum;
+    size_t                     i;
+    size_t                     nvars;
+    FILE                      *fp;
+
+    init_run_bundle_header(&header);
+    header.Nveg_type = Nveg_type;
+    header.NF = NF;
+    header.NR = NR;
+
+    fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        log_err("Unable to open run bundle %s", filename);
+    }
+
+    write_bundle_block(fp, &header, sizeof(header), filename);
+    write_bundle_block(fp, &options, sizeof(options), filename);
+    write_bundle_block(fp, &global_param, sizeof(global_param), filename);
+    write_bundle_block(fp, &param, sizeof(param), filename);
+    write_bundle_block(fp, &param_set, sizeof(param_set), filename);
+    write_bundle_block(fp, &filenames, sizeof(filenames), filename);
+    // the vegetation library ends with the bare soil class
+    write_bundle_block(fp, veg_lib, (Nveg_type + 1) * sizeof(*veg_lib),
+                       filename);
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        nvars = streams[streamnum].nvars;
+        write_bundle_block(fp, &(streams[streamnum]), sizeof(*streams),
+                           filename);
+        write_bundle_block(fp, streams[streamnum].varid,
+                           nvars * sizeof(*(streams->varid)), filename);
+        write_bundle_block(fp, streams[streamnum].aggtype,
+                           nvars * sizeof(*(streams->aggtype)), filename);
+        write_bundle_block(fp, streams[streamnum].type,
+                           nvars * sizeof(*(streams->type)), filename);
+        write_bundle_block(fp, streams[streamnum].mult,
+                           nvars * sizeof(*(streams->mult)), filename);
+        write_bundle_block(fp, streams[streamnum].aggparam,
+                           nvars * sizeof(*(streams->aggparam)), filename);
+        for (i = 0; i < nvars; i++) {
+            write_bundle_block(fp, streams[streamnum].format[i], MAXSTRING,
+                               filename);
+        }
+    }
+
+    if (fclose(fp) != 0) {
+        log_err("Error writing run bundle %s", filename);
+    }
+    log_info("Wrote run bundle %s", filename);
+}
+
+/******************************************************************************
+ * @brief    Take the next block of a run bundle that was read into memory.
+ *****************************************************************************/
+static char *
+take_bundle_block(char **cursor,
+                  char  *end,
+                  size_t size,
+                  char   filename[])
+{
+    char *block = *cursor;
+
+    if ((size_t) (end - *cursor) < size) {
+        log_err("Run bundle %s is truncated", filename);
+    }
+    *cursor += size;
+
+    return block;
+}
+
+/******************************************************************************
+ * @brief    Load the configuration of the simulation from a run bundle.
+ *
+ * @details  The whole bundle is read with a single read. The loaded state
+ *           replaces get_global_param(), get_parameters(),
+ *           parse_output_info() and read_veglib(). The name of the global
+ *           parameter file is set to the name of the bundle. The aggdata of
+ *           the streams is allocated once the output metadata is set.
+ *****************************************************************************/
+void
+read_run_bundle(char             filename[],
+                stream_struct  **streams,
+                veg_lib_struct **veg_lib,
+                size_t          *Nveg_type)
+{
+    extern option_struct       options;
+    extern global_param_struct global_param;
+    extern parameters_struct   param;
+    extern param_set_struct    param_set;
+    extern filenames_struct    filenames;
+    extern size_t              NF, NR;
+
+    run_bundle_header_struct   expected;
+    run_bundle_header_struct   header;
+    stream_struct             *stream;
+    stream_struct              saved;
+    char                       bundle_name[MAXSTRING];
+    char                      *data;
+    char                      *cursor;
+    char                      *end;
+    struct stat                st;
+    size_t                     streamnum;
+    size_t                     i;
+    size_t                     nvars;
+    FILE                      *fp;
+
+    strcpy(bundle_name, filename);
+
+    fp = fopen(bundle_name, "rb");
+    if (fp == NULL || fstat(fileno(fp), &st) != 0) {
+        log_err("Unable to open run bundle %s", bundle_name);
+    }
+    data = malloc(st.st_size);
+    check_alloc_status(data, "Memory allocation error.");
+    if (fread(data, 1, st.st_size, fp) != (size_t) st.st_size) {
+        log_err("Error reading run bundle %s", bundle_name);
+    }
+    fclose(fp);
+    cursor = data;
+    end = data + st.st_size;
+
+    memcpy(&header, take_bundle_block(&cursor, end, sizeof(header),
+                                      bundle_name), sizeof(header));
+    header.version[sizeof(header.version) - 1] = '\0';
+    init_run_bundle_header(&expected);
+    if (memcmp(header.magic, expected.magic, sizeof(expected.magic)) != 0 ||
+        strcmp(header.version, expected.version) != 0 ||
+        memcmp(header.sizes, expected.sizes, sizeof(expected.sizes)) != 0) {
+        log_err("Run bundle %s was written by a different version of the "
+                "classic driver (%s) and cannot be used by this version "
+                "(%s). Write it again with RUN_BUNDLE.", bundle_name,
+                header.version, expected.version);
+    }
+    *Nveg_type = header.Nveg_type;
+    NF = header.NF;
+    NR = header.NR;
+
+    memcpy(&options, take_bundle_block(&cursor, end, sizeof(options),
+                                       bundle_name), sizeof(options));
+    memcpy(&global_param, take_bundle_block(&cursor, end,
+                                            sizeof(global_param),
+                                            bundle_name),
+           sizeof(global_param));
+    memcpy(&param, take_bundle_block(&cursor, end, sizeof(param),
+                                     bundle_name), sizeof(param));
+    memcpy(&param_set, take_bundle_block(&cursor, end, sizeof(param_set),
+                                         bundle_name), sizeof(param_set));
+    memcpy(&filenames, take_bundle_block(&cursor, end, sizeof(filenames),
+                                         bundle_name), sizeof(filenames));
+    strcpy(filenames.global, bundle_name);
+    // a loaded bundle is not written again
+    strcpy(filenames.run_bundle, "MISSING");
+
+    *veg_lib = calloc(*Nveg_type + 1, sizeof(**veg_lib));
+    check_alloc_status(*veg_lib, "Memory allocation error.");
+    memcpy(*veg_lib, take_bundle_block(&cursor, end,
+                                       (*Nveg_type + 1) * sizeof(**veg_lib),
+                                       bundle_name),
+           (*Nveg_type + 1) * sizeof(**veg_lib));
+
+    *streams = calloc(options.Noutstreams, sizeof(**streams));
+    check_alloc_status(*streams, "Memory allocation error.");
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        stream = &((*streams)[streamnum]);
+        memcpy(&saved, take_bundle_block(&cursor, end, sizeof(saved),
+                                         bundle_name), sizeof(saved));
+        // allocate the arrays of the stream and restore its settings
+        setup_stream(stream, saved.nvars, 1);
+        nvars = stream->nvars;
+        strcpy(stream->prefix, saved.prefix);
+        stream->file_format = saved.file_format;
+        stream->compress = saved.compress;
+        stream->flush = saved.flush;
+        stream->flush_n = saved.flush_n;
+        stream->agg_alarm = saved.agg_alarm;
+        stream->write_alarm = saved.write_alarm;
+        memcpy(stream->varid, take_bundle_block(&cursor, end,
+                                                nvars * sizeof(*(stream->varid)),
+                                                bundle_name),
+               nvars * sizeof(*(stream->varid)));
+        memcpy(stream->aggtype,
+               take_bundle_block(&cursor, end,
+                                 nvars * sizeof(*(stream->aggtype)),
+                                 bundle_name),
+               nvars * sizeof(*(stream->aggtype)));
+        memcpy(stream->type, take_bundle_block(&cursor, end,
+                                               nvars * sizeof(*(stream->type)),
+                                               bundle_name),
+               nvars * sizeof(*(stream->type)));
+        memcpy(stream->mult, take_bundle_block(&cursor, end,
+                                               nvars * sizeof(*(stream->mult)),
+                                               bundle_name),
+               nvars * sizeof(*(stream->mult)));
+        memcpy(stream->aggparam,
+               take_bundle_block(&cursor, end,
+                                 nvars * sizeof(*(stream->aggparam)),
+                                 bundle_name),
+               nvars * sizeof(*(stream->aggparam)));
+        for (i = 0; i < nvars; i++) {
+            memcpy(stream->format[i], take_bundle_block(&cursor, end,
+                                                        MAXSTRING,
+                                                        bundle_name),
+                   MAXSTRING);
+        }
+    }
+
+    free(data);
+}
@@ -46,7 +46,8 @@ metadata_struct     out_metadata[N_OUTVAR_TYPES];
 /******************************************************************************
  * @brief   Classic driver of the VIC model
  * @details The classic driver runs VIC for a single grid cell for all
- *          timesteps before moving on to the next grid cell.
+ *          timesteps before moving on to the next grid cell. With
+ *          NWORKERS > 1 the grid cells are dealt out to NWORKERS processes.
  *
  * @param argc Argument count
  * @param argv Argument vector
@@ -59,18 +60,28 @@ main(int   argc,
     extern FILE       *LOG_DEST;
 
     bool               MODEL_DONE;
+    bool               RUN_BUNDLE;
     bool               RUN_MODEL;
-    char               dmy_str[MAXSTRING];
+    bool               force_loaded;
     size_t             rec;
+    size_t             wrec;
+    size_t             Nwindow;
+    size_t             window_start;
+    size_t             dmy_start;
     size_t             Nveg_type;
+    size_t             Nveg_alloc;
     int                cellnum;
     int                startrec;
     int                ErrorFlag;
     int                n;
     size_t             streamnum;
+    size_t             filenum;
+    long               forcing_start[MAX_FORCE_FILES];
+    size_t             worker;
     dmy_struct        *dmy;
+    dmy_struct         dmy_first;
     force_data_struct *force;
-    veg_hist_struct  **veg_hist;
+    veg_hist_struct  **veg_hist = NULL;
     veg_con_struct    *veg_con;
     soil_con_struct    soil_con;
     all_vars_struct    all_vars;
@@ -80,6 +91,11 @@ main(int   argc,
     save_data_struct   save_data;
     timer_struct       global_timers[N_TIMERS];
     timer_struct       cell_timer;
+    bool               cell_timer_wall;
+    bool               cell_timer_cpu;
+    july_tavg_struct   july_tavg;
+    param_index_struct param_index;
+    bool               PARAM_INDEX;
 
     // start vic all timer
     timer_start(&(global_timers[TIMER_VIC_ALL]));
@@ -101,45 +117,96 @@ main(int   argc,
     /* Initilize forcing file param structure */
     initialize_forcing_files();
 
-    /** Read Global Control File **/
-    filep.globalparam = open_file(filenames.global, "r");
-    get_global_param(filep.globalparam);
-    fclose(filep.globalparam);
+    /** Read Global Control File or Load the Run Bundle **/
+    RUN_BUNDLE = is_run_bundle(filenames.global);
+    if (RUN_BUNDLE) {
+        read_run_bundle(filenames.global, &streams, &veg_lib, &Nveg_type);
+    }
+    else {
+        filep.globalparam = open_file(filenames.global, "r");
+        get_global_param(filep.globalparam);
+        fclose(filep.globalparam);
+    }
 
     // Set Log Destination
     setup_logging(MISSING, filenames.log_path, &(filep.logfile));
 
     /** Set model constants **/
-    if (strcmp(filenames.constants, "MISSING") != 0) {
+    if (!RUN_BUNDLE && strcmp(filenames.constants, "MISSING") != 0) {
         filep.constants = open_file(filenames.constants, "r");
         get_parameters(filep.constants);
     }
     // Check that model parameters are valid
     validate_parameters();
+    check_specialized_options();
+    initialize_svp_table();
 
-    /** Make Date Data Structure **/
+    /** Set up the Model Time Steps **/
     initialize_time();
-    dmy = make_dmy(&global_param);
+    initialize_time_steps(&global_param);
+    dmy_from_step(&global_param, 0, &dmy_first);
 
     /** Set up output data structures **/
     set_output_met_data_info();
     // out_data is shape [ngridcells (1), N_OUTVAR_TYPES]
     alloc_out_data(1, &out_data);
-    filep.globalparam = open_file(filenames.global, "r");
-    parse_output_info(filep.globalparam, &streams, &(dmy[0]));
+    if (RUN_BUNDLE) {
+        for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+            alloc_aggdata(&(streams[streamnum]));
+        }
+    }
+    else {
+        filep.globalparam = open_file(filenames.global, "r");
+        parse_output_info(filep.globalparam, &streams, &dmy_first);
+    }
     validate_streams(&streams);
 
     /** Check and Open Files **/
     check_files(&filep, &filenames);
 
     /** Read Vegetation Library File **/
-    veg_lib = read_veglib(filep.veglib, &Nveg_type);
+    if (!RUN_BUNDLE) {
+        veg_lib = read_veglib(filep.veglib, &Nveg_type);
+    }
+
+    /** Save the Parsed Configuration for Later Runs **/
+    if (strcmp(filenames.run_bundle, "MISSING") != 0) {
+        write_run_bundle(filenames.run_bundle, streams, veg_lib, Nveg_type);
+    }
+
+    /** Index the Parameter Files for the Workers **/
+    PARAM_INDEX = (options.NWORKERS > 1 ||
+                   strcasecmp(filenames.param_index, "MISSING") != 0);
+    if (PARAM_INDEX) {
+        build_param_index(&filep, &filenames, &param_index);
+    }
+
+    /** Start the Worker Processes **/
+    worker = start_cell_workers(&filep, &filenames);
+
+    /** Open the Cell Containers of the Output Streams **/
+    if (options.OUT_CONTAINER) {
+        open_cell_containers(&streams, &filenames, worker);
+    }
 
     /** Initialize Parameters **/
     cellnum = -1;
+    Nveg_alloc = 0;
+
+    /** Number of time steps of forcings kept in memory **/
+    Nwindow = global_param.nrecs;
+    if (options.FORCE_WINDOW > 0 &&
+        options.FORCE_WINDOW * global_param.model_steps_per_day < Nwindow) {
+        Nwindow = options.FORCE_WINDOW * global_param.model_steps_per_day;
+    }
 
     /** allocate memory for the force_data_struct **/
-    alloc_atmos(global_param.nrecs, &force);
+    alloc_atmos(Nwindow, &force);
+
+    /** Dates of the time steps in the forcing window **/
+    dmy = calloc(Nwindow, sizeof(*dmy));
+    check_alloc_status(dmy, "Memory allocation error.");
+    dmy_start = global_param.nrecs;
 
     /** Initial state **/
     startrec = 0;
@@ -164,17 +231,40 @@ main(int   argc,
     ************************************/
     MODEL_DONE = false;
 
+    // the cell timer only reads the clocks of the requested outputs
+    cell_timer_wall = outvar_group_requested(OUT_GROUP_TIME_WALL);
+    cell_timer_cpu = outvar_group_requested(OUT_GROUP_TIME_CPU);
+
     // stop init timer
     timer_stop(&(global_timers[TIMER_VIC_INIT]));
     // start vic run timer
     timer_start(&(global_timers[TIMER_VIC_RUN]));
 
     while (!MODEL_DONE) {
+        /** Go to the Next Grid Cell of This Worker **/
+        if (PARAM_INDEX &&
+            !seek_param_index(&param_index, &filep, worker, &cellnum)) {
+            MODEL_DONE = true;
+            break;
+        }
+
         read_soilparam(filep.soilparam, &soil_con, &RUN_MODEL, &MODEL_DONE);
 
         if (RUN_MODEL) {
             cellnum++;
 
+            /** Skip Grid Cells Run by Other Workers **/
+            if ((size_t) cellnum % options.NWORKERS != worker) {
+                free((char *) soil_con.AreaFract);
+                free((char *) soil_con.BandElev);
+                free((char *) soil_con.Tfactor);
+                free((char *) soil_con.Pfactor);
+                free((char *) soil_con.AboveTreeLine);
+                continue;
+            }
+            vic_run_ref.id_name = "cellnum";
+            vic_run_ref.id = (size_t) cellnum;
+
             /** Read Grid Cell Vegetation Parameters **/
             veg_con = read_vegparam(filep.vegparam, soil_con.gridcel,
                                     Nveg_type);
@@ -187,14 +277,14 @@ main(int   argc,
 
             /** Build Gridded Filenames, and Open **/
             make_in_and_outfiles(&filep, &filenames, &soil_con,
-                                 &streams, dmy);
+                                 &streams, &dmy_first);
 
             /** Reset agg_alarm for Each Stream **/
             for (streamnum = 0;
                  streamnum < (size_t) options.Noutstreams;
                  streamnum++) {
                 n = streams[streamnum].agg_alarm.n;
-                set_alarm(&(dmy[0]), streams[streamnum].agg_alarm.freq,
+                set_alarm(&dmy_first, streams[streamnum].agg_alarm.freq,
                           &n,
                           &(streams[streamnum].agg_alarm));
             }
@@ -203,18 +293,76 @@ main(int   argc,
             read_snowband(filep.snowband, &soil_con);
 
             /** Make Top-level Control Structure **/
-            all_vars = make_all_vars(veg_con[0].vegetat_type_num);
+            // the structures of the previous grid cell are reused, unless
+            // this grid cell has more vegetation tiles
+            if (veg_hist == NULL || veg_con[0].vegetat_type_num > Nveg_alloc) {
+                if (veg_hist != NULL) {
+                    free_veg_hist(Nwindow, Nveg_alloc, &veg_hist);
+                    free_all_vars(&all_vars);
+                }
+                Nveg_alloc = veg_con[0].vegetat_type_num;
+                all_vars = make_all_vars(Nveg_alloc);
+                if (options.LAKES) {
+                    all_vars.lake_var = make_lake_var();
+                }
 
-            /** allocate memory for the veg_hist_struct **/
-            alloc_veg_hist(global_param.nrecs, veg_con[0].vegetat_type_num,
-                           &veg_hist);
+                /** allocate memory for the veg_hist_struct **/
+                alloc_veg_hist(Nwindow, Nveg_alloc, &veg_hist);
+            }
+            else {
+                // vic_force() overwrites veg_hist of all vegetation tiles
+                reset_all_vars(&all_vars, veg_con[0].vegetat_type_num);
+            }
 
             /**************************************************
                Initialize Meteological Forcing Values That
                Have not Been Specifically Set
             **************************************************/
 
-            vic_force(force, dmy, filep.forcing, veg_con, veg_hist, &soil_con);
+            window_start = 0;
+            force_loaded = false;
+            if (options.COMPUTE_TREELINE && !options.JULY_TAVG_SUPPLIED) {
+                // pre-pass over the forcing windows for the average July
+                // air temperature, so that only a window is held in memory
+                reset_july_tavg(&july_tavg);
+                for (filenum = 0; filenum < MAX_FORCE_FILES; filenum++) {
+                    if (filep.forcing[filenum] != NULL) {
+                        forcing_start[filenum] = ftell(filep.forcing[filenum]);
+                    }
+                }
+                while (window_start < global_param.nrecs) {
+                    wrec = global_param.nrecs - window_start;
+                    if (wrec > Nwindow) {
+                        wrec = Nwindow;
+                    }
+                    set_dmy_window(&global_param, window_start, wrec, dmy);
+                    dmy_start = window_start;
+                    vic_force(force, dmy, filep.forcing, veg_con, veg_hist,
+                              &soil_con, window_start, wrec);
+                    accumulate_july_tavg(force, dmy, wrec, &july_tavg);
+                    window_start += Nwindow;
+                }
+                compute_treeline(get_july_tavg(&july_tavg), soil_con.Tfactor,
+                                 soil_con.AboveTreeLine);
+                window_start = 0;
+                // a single window is still resident, otherwise the ASCII
+                // forcing files are rewound to the first record of the cell
+                force_loaded = (Nwindow >= global_param.nrecs);
+                for (filenum = 0; filenum < MAX_FORCE_FILES; filenum++) {
+                    if (!force_loaded && filep.forcing[filenum] != NULL) {
+                        fseek(filep.forcing[filenum], forcing_start[filenum],
+                              SEEK_SET);
+                    }
+                }
+            }
+            if (!force_loaded) {
+                if (dmy_start != window_start) {
+                    set_dmy_window(&global_param, window_start, Nwindow, dmy);
+                    dmy_start = window_start;
+                }
+                vic_force(force, dmy, filep.forcing, veg_con, veg_hist,
+                          &soil_con, window_start, Nwindow);
+            }
 
             /**************************************************
                Initialize Energy Balance and Snow Variables
@@ -227,55 +375,72 @@ main(int   argc,
             initialize_save_data(&all_vars, &force[0], &soil_con, veg_con,
                                  veg_lib, &lake_con, out_data[0], &save_data,
                                  &cell_timer);
+            save_data.balance_cell =
+                (soil_con.gridcel % options.BALANCE_CHECK_N == 0);
 
             /******************************************
                Run Model in Grid Cell for all Time Steps
             ******************************************/
 
             for (rec = startrec; rec < global_param.nrecs; rec++) {
-                // Set global reference string (for debugging inside vic_run)
-                sprint_dmy(dmy_str, &(dmy[rec]));
-                sprintf(vic_run_ref_str,
-                        "Gridcell cellnum: %i, timestep info: %s",
-                        cellnum, dmy_str);
+                /** Read the Next Window of Forcings **/
+                while (rec >= window_start + Nwindow) {
+                    window_start += Nwindow;
+                    wrec = global_param.nrecs - window_start;
+                    if (wrec > Nwindow) {
+                        wrec = Nwindow;
+                    }
+                    set_dmy_window(&global_param, window_start, wrec, dmy);
+                    dmy_start = window_start;
+                    vic_force(force, dmy, filep.forcing, veg_con, veg_hist,
+                              &soil_con, window_start, wrec);
+                }
+                // index of the current time step in the forcing window
+                wrec = rec - window_start;
+
+                // Set global reference (for debugging inside vic_run)
+                vic_run_ref.dmy = &(dmy[wrec]);
 
                 /**************************************************
                    Update data structures for current time step
                 **************************************************/
                 ErrorFlag = update_step_vars(&all_vars, veg_con,
-                                             veg_hist[rec]);
+                                             veg_hist[wrec]);
 
                 /**************************************************
                    Compute cell physics for 1 timestep
                 **************************************************/
-                timer_start(&cell_timer);
-                ErrorFlag = vic_run(&force[rec], &all_vars,
-                                    &(dmy[rec]), &global_param, &lake_con,
+                timer_start_clocks(&cell_timer, cell_timer_wall,
+                                   cell_timer_cpu);
+                ErrorFlag = vic_run(&force[wrec], &all_vars,
+                                    &(dmy[wrec]), &global_param, &lake_con,
                                     &soil_con, veg_con, veg_lib);
-                timer_stop(&cell_timer);
+                timer_stop_clocks(&cell_timer, cell_timer_wall,
+                                  cell_timer_cpu);
 
                 /**************************************************
                    Calculate cell average values for current time step
                 **************************************************/
-                put_data(&all_vars, &force[rec], &soil_con, veg_con, veg_lib,
+                set_outvar_groups_step(streams, &(dmy[wrec]));
+                put_data(&all_vars, &force[wrec], &soil_con, veg_con, veg_lib,
                          &lake_con, out_data[0], &save_data, &cell_timer);
 
                 for (streamnum = 0;
                      streamnum < options.Noutstreams;
                      streamnum++) {
-                    agg_stream_data(&(streams[streamnum]), &(dmy[rec]),
+                    agg_stream_data(&(streams[streamnum]), &(dmy[wrec]),
                                     out_data);
                 }
 
                 // Write cell average values for current time step
-                write_output(&streams, &dmy[rec]);
+                write_output(&streams, &(dmy[wrec]));
 
                 /************************************
                    Save model state at assigned date
                    (after the final time step of the assigned date)
                 ************************************/
                 if (filep.statefile != NULL &&
-                    check_save_state_flag(dmy, rec)) {
+                    check_save_state_flag(rec)) {
                     write_model_state(&all_vars, veg_con->vegetat_type_num,
                                       soil_con.gridcel, &filep, &soil_con);
                 }
@@ -304,9 +469,6 @@ main(int   argc,
 
             close_files(&filep, &streams);
 
-            free_veg_hist(global_param.nrecs, veg_con[0].vegetat_type_num,
-                          &veg_hist);
-            free_all_vars(&all_vars, veg_con[0].vegetat_type_num);
             free_vegcon(&veg_con);
             free((char *) soil_con.AreaFract);
             free((char *) soil_con.BandElev);
@@ -316,13 +478,30 @@ main(int   argc,
         } /* End Run Model Condition */
     }   /* End Grid Loop */
 
+    /** Write the Cell Index of the Containers **/
+    if (options.OUT_CONTAINER) {
+        close_cell_containers(&streams);
+    }
+
+    /** Wait for the Other Workers **/
+    finish_cell_workers(worker);
+
     // stop vic run timer
     timer_stop(&(global_timers[TIMER_VIC_RUN]));
     // start vic final timer
     timer_start(&(global_timers[TIMER_VIC_FINAL]));
 
     /** cleanup **/
-    free_atmos(global_param.nrecs, &force);
+    free_atmos(Nwindow, &force);
+    if (veg_hist != NULL) {
+        free_veg_hist(Nwindow, Nveg_alloc, &veg_hist);
+        free_all_vars(&all_vars);
+    }
+    close_forcing_containers();
+    if (PARAM_INDEX) {
+        free_param_index(&param_index);
+    }
+    free_scratch_arena();
     free_dmy(&dmy);
     free_streams(&streams);
     free_out_data(1, out_data);  // 1 is for the number of gridcells, 1 in classic driver
@@ -338,10 +517,12 @@ main(int   argc,
     }
     if (options.INIT_STATE) {
         fclose(filep.init_state);
+        free_state_index();
     }
     if (options.SAVE_STATE && strcmp(filenames.statefile, "NONE") != 0) {
         fclose(filep.statefile);
     }
+    print_log_summary();
     finalize_logging();
 
     log_info("Completed running VIC %s", VIC_DRIVER);
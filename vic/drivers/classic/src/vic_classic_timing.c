@@ -35,8 +35,10 @@ write_vic_timing_table(timer_struct *timers)
     extern FILE               *LOG_DEST;
     extern filenames_struct    filenames;
     extern global_param_struct global_param;
+    extern option_struct       options;
 
     char                       machine[MAXSTRING];
+    unsigned long long         perf_counts[N_PERF_REGIONS][N_PERF_COUNTERS];
     char                       user[MAXSTRING];
     time_t                     curr_date_time;
     struct tm                 *timeinfo;
@@ -140,6 +142,12 @@ write_vic_timing_table(timer_struct *timers)
             "|------------|----------------------|----------------------|----------------------|----------------------|\n");
     fprintf(LOG_DEST, "\n");
 
+    if (options.PERF_REGIONS) {
+        // grid cells run on other worker processes are not included
+        collect_perf_regions(perf_counts);
+        write_perf_regions_table(perf_counts, 1);
+    }
+
     fprintf(LOG_DEST,
             "\n------------------------------"
             " END VIC TIMING PROFILE "
@@ -29,6 +29,12 @@
 
 /******************************************************************************
  * @brief    Initialize atmospheric variables for the model and snow time steps.
+ *
+ * @details  Fills force[0] to force[nrecs - 1] and veg_hist[0] to
+ *           veg_hist[nrecs - 1] with the forcings of the model time steps
+ *           rec_start to rec_start + nrecs - 1. The windows of a grid cell must
+ *           be read in order, starting with rec_start = 0. dmy holds the dates
+ *           of the time steps of the window.
  *****************************************************************************/
 void
 vic_force(force_data_struct *force,
@@ -36,7 +42,9 @@ vic_force(force_data_struct *force,
           FILE             **infile,
           veg_con_struct    *veg_con,
           veg_hist_struct  **veg_hist,
-          soil_con_struct   *soil_con)
+          soil_con_struct   *soil_con,
+          size_t             rec_start,
+          size_t             nrecs)
 {
     extern option_struct       options;
     extern param_set_struct    param_set;
@@ -55,6 +63,7 @@ vic_force(force_data_struct *force,
     double                     avgJulyAirTemp;
     double                    *Tfactor;
     bool                      *AboveTreeLine;
+    global_param_struct        window_param;
 
     /*******************************
        Check that required inputs were supplied
@@ -106,9 +115,14 @@ vic_force(force_data_struct *force,
        read in meteorological data
     *******************************/
 
-    forcing_data = read_forcing_data(infile, global_param, &veg_hist_data);
+    window_param = global_param;
+    window_param.nrecs = nrecs;
+    forcing_data = read_forcing_data(infile, window_param, rec_start,
+                                     &veg_hist_data);
 
-    log_info("Read meteorological forcing file");
+    if (rec_start == 0) {
+        log_info("Read meteorological forcing file");
+    }
 
     /****************************************************
        Variables in the atmos_data structure
@@ -121,7 +135,7 @@ vic_force(force_data_struct *force,
         }
     }
 
-    for (rec = 0; rec < global_param.nrecs; rec++) {
+    for (rec = 0; rec < nrecs; rec++) {
         for (i = 0; i < NF; i++) {
             uidx = rec * NF + i;
             // temperature in Celsius
@@ -217,7 +231,7 @@ vic_force(force_data_struct *force,
     ****************************************************/
 
     /* First, assign default climatology */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
+    for (rec = 0; rec < nrecs; rec++) {
         for (v = 0; v <= veg_con[0].vegetat_type_num; v++) {
             for (i = 0; i < NF; i++) {
                 veg_hist[rec][v].albedo[i] =
@@ -235,7 +249,7 @@ vic_force(force_data_struct *force,
     }
 
     /* Next, overwrite with veg_hist values, validate, and average */
-    for (rec = 0; rec < global_param.nrecs; rec++) {
+    for (rec = 0; rec < nrecs; rec++) {
         for (v = 0; v <= veg_con[0].vegetat_type_num; v++) {
             for (i = 0; i < NF; i++) {
                 uidx = rec * NF + i;
@@ -263,7 +277,7 @@ vic_force(force_data_struct *force,
                 // Check on fcanopy
                 if (veg_hist[rec][v].fcanopy[i] < MIN_FCANOPY) {
                     log_warn(
-                        "rec %zu, veg %zu substep %zu fcanopy %f < minimum of %f; setting = %f", rec, v, i,
+                        "rec %zu, veg %zu substep %zu fcanopy %f < minimum of %f; setting = %f", rec_start + rec, v, i,
                         veg_hist[rec][v].fcanopy[i], MIN_FCANOPY,
                         MIN_FCANOPY);
                     veg_hist[rec][v].fcanopy[i] = MIN_FCANOPY;
@@ -304,13 +318,12 @@ vic_force(force_data_struct *force,
     free(veg_hist_data);
 
     /****************************************************
-       Compute treeline based on July average temperature
+       Compute treeline based on supplied July average temperature
+       (the forcing average is computed in a pre-pass, see vic_classic)
     ****************************************************/
 
-    if (options.COMPUTE_TREELINE) {
-        if (!(options.JULY_TAVG_SUPPLIED && avgJulyAirTemp == -999)) {
-            compute_treeline(force, dmy, avgJulyAirTemp, Tfactor,
-                             AboveTreeLine);
-        }
+    if (options.COMPUTE_TREELINE && options.JULY_TAVG_SUPPLIED &&
+        rec_start == 0 && avgJulyAirTemp != -999) {
+        compute_treeline(avgJulyAirTemp, Tfactor, AboveTreeLine);
     }
 }
@@ -26,165 +26,383 @@
 
 #include <vic_driver_classic.h>
 
+/******************************************************************************
+ * @brief    Make room for size more bytes in the buffer of a stream.
+ *****************************************************************************/
+static char *
+reserve_buffer(stream_struct *stream,
+               size_t         size)
+{
+    if (stream->buffer_len + size > stream->buffer_size) {
+        stream->buffer_size = stream->buffer_len + size + OUT_BUFFER_SIZE;
+        stream->buffer = realloc(stream->buffer, stream->buffer_size);
+        check_alloc_status(stream->buffer, "Memory allocation error.");
+    }
+    return &(stream->buffer[stream->buffer_len]);
+}
+
+/******************************************************************************
+ * @brief    Return the number of bytes of a value of a binary output type.
+ *****************************************************************************/
+static size_t
+get_binary_type_size(unsigned short int type)
+{
+    if (type == OUT_TYPE_CHAR) {
+        return sizeof(char);
+    }
+    else if (type == OUT_TYPE_SINT) {
+        return sizeof(short int);
+    }
+    else if (type == OUT_TYPE_USINT) {
+        return sizeof(unsigned short int);
+    }
+    else if (type == OUT_TYPE_INT) {
+        return sizeof(int);
+    }
+    else if (type == OUT_TYPE_FLOAT) {
+        return sizeof(float);
+    }
+    return sizeof(double);
+}
+
+/******************************************************************************
+ * @brief    Allocate the record buffer of a stream.
+ *
+ * @details  Called when the output file of the stream is opened. A BINARY
+ *           record has a fixed size, so the buffer holds a whole number of
+ *           records, as many as fit in OUT_BUFFER_SIZE bytes, and is written
+ *           with one fwrite once it is full. The buffer of an ASCII stream
+ *           grows as needed. The buffer is kept for the files of the
+ *           following grid cells.
+ *****************************************************************************/
+void
+init_stream_buffer(stream_struct *stream)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 var_idx;
+    size_t                 nrecs;
+    size_t                 size;
+
+    stream->buffer_len = 0;
+    stream->record_size = 0;
+    if (stream->file_format == BINARY) {
+        stream->record_size = (stream->agg_alarm.is_subdaily ? 4 : 3) *
+                              sizeof(int);
+        for (var_idx = 0; var_idx < stream->nvars; var_idx++) {
+            stream->record_size +=
+                out_metadata[stream->varid[var_idx]].nelem *
+                get_binary_type_size(stream->type[var_idx]);
+        }
+        nrecs = OUT_BUFFER_SIZE / stream->record_size;
+        if (nrecs == 0) {
+            nrecs = 1;
+        }
+        size = nrecs * stream->record_size;
+    }
+    else {
+        size = OUT_BUFFER_SIZE + MAXSTRING;
+    }
+
+    if (stream->buffer_size < size) {
+        free(stream->buffer);
+        stream->buffer = malloc(size);
+        check_alloc_status(stream->buffer, "Memory allocation error.");
+        stream->buffer_size = size;
+    }
+}
+
+/******************************************************************************
+ * @brief    Append a value to the buffer of a stream in its binary type.
+ *****************************************************************************/
+static void
+buffer_binary_value(stream_struct     *stream,
+                    unsigned short int type,
+                    double             value)
+{
+    char               cval;
+    short int          sival;
+    unsigned short int usival;
+    int                ival;
+    float              fval;
+    char              *dest;
+
+    dest = reserve_buffer(stream, sizeof(double));
+    if (type == OUT_TYPE_CHAR) {
+        cval = (char) value;
+        memcpy(dest, &cval, sizeof(cval));
+        stream->buffer_len += sizeof(cval);
+    }
+    else if (type == OUT_TYPE_SINT) {
+        sival = (short int) value;
+        memcpy(dest, &sival, sizeof(sival));
+        stream->buffer_len += sizeof(sival);
+    }
+    else if (type == OUT_TYPE_USINT) {
+        usival = (unsigned short int) value;
+        memcpy(dest, &usival, sizeof(usival));
+        stream->buffer_len += sizeof(usival);
+    }
+    else if (type == OUT_TYPE_INT) {
+        ival = (int) value;
+        memcpy(dest, &ival, sizeof(ival));
+        stream->buffer_len += sizeof(ival);
+    }
+    else if (type == OUT_TYPE_FLOAT) {
+        fval = (float) value;
+        memcpy(dest, &fval, sizeof(fval));
+        stream->buffer_len += sizeof(fval);
+    }
+    else if (type == OUT_TYPE_DOUBLE) {
+        memcpy(dest, &value, sizeof(value));
+        stream->buffer_len += sizeof(value);
+    }
+}
+
+/******************************************************************************
+ * @brief    Return the precision of a "%.Nf" or "%.Nlf" format.
+ *
+ * @return   the precision N, or -1 if format has any other form
+ *****************************************************************************/
+static int
+fixed_format_precision(char *format)
+{
+    if (format[0] != '%' || format[1] != '.' ||
+        format[2] < '0' || format[2] > '9') {
+        return -1;
+    }
+    if ((format[3] == 'f' && format[4] == '\0') ||
+        (format[3] == 'l' && format[4] == 'f' && format[5] == '\0')) {
+        return format[2] - '0';
+    }
+    return -1;
+}
+
+/******************************************************************************
+ * @brief    Print a value with a fixed number of decimals.
+ *
+ * @details  Gives the same characters as printf() with "%.Nf". Values that
+ *           are not finite, too large or too close to a rounding tie to be
+ *           rounded safely from the scaled double are not printed.
+ *
+ * @return   number of characters printed, or 0 if the value was not printed
+ *****************************************************************************/
+static size_t
+sprint_fixed(char  *str,
+             double value,
+             int    precision)
+{
+    static const unsigned long long pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000
+    };
+
+    double                          scaled;
+    double                          whole;
+    double                          frac;
+    unsigned long long              digits;
+    unsigned long long              ipart;
+    unsigned long long              fpart;
+    char                            tmp[MAX_FIXED_DIGITS];
+    size_t                          ntmp;
+    size_t                          len;
+    int                             i;
+
+    if (!isfinite(value)) {
+        return 0;
+    }
+    scaled = fabs(value) * (double) pow10[precision];
+    if (scaled >= FIXED_FORMAT_MAX) {
+        return 0;
+    }
+    whole = floor(scaled);
+    frac = scaled - whole;
+    if (fabs(frac - 0.5) < FIXED_FORMAT_TIE) {
+        return 0;
+    }
+    digits = (unsigned long long) whole;
+    if (frac > 0.5) {
+        digits++;
+    }
+    ipart = digits / pow10[precision];
+    fpart = digits % pow10[precision];
+
+    len = 0;
+    if (signbit(value)) {
+        str[len++] = '-';
+    }
+    ntmp = 0;
+    do {
+        tmp[ntmp++] = (char) ('0' + ipart % 10);
+        ipart /= 10;
+    }
+    while (ipart > 0);
+    while (ntmp > 0) {
+        str[len++] = tmp[--ntmp];
+    }
+    if (precision > 0) {
+        str[len++] = '.';
+        for (i = precision - 1; i >= 0; i--) {
+            str[len + i] = (char) ('0' + fpart % 10);
+            fpart /= 10;
+        }
+        len += precision;
+    }
+
+    return len;
+}
+
+/******************************************************************************
+ * @brief    Append a value to the buffer of a stream as text.
+ *****************************************************************************/
+static void
+buffer_ascii_value(stream_struct *stream,
+                   char          *format,
+                   int            precision,
+                   double         value)
+{
+    char  *dest;
+    size_t len;
+    int    n;
+
+    dest = reserve_buffer(stream, MAX_FIXED_DIGITS + 1);
+    len = 0;
+    if (precision >= 0) {
+        len = sprint_fixed(dest, value, precision);
+    }
+    if (len == 0) {
+        n = snprintf(dest, MAX_FIXED_DIGITS + 1, format, value);
+        if (n < 0) {
+            log_err("Could not format output value with %s", format);
+        }
+        if ((size_t) n > MAX_FIXED_DIGITS) {
+            dest = reserve_buffer(stream, (size_t) n + 1);
+            snprintf(dest, (size_t) n + 1, format, value);
+        }
+        len = (size_t) n;
+    }
+    stream->buffer_len += len;
+}
+
+/******************************************************************************
+ * @brief    Write the buffered records of a stream to its file.
+ *****************************************************************************/
+void
+flush_stream_buffer(stream_struct *stream)
+{
+    if (stream->buffer_len == 0) {
+        return;
+    }
+    if (fwrite(stream->buffer, 1, stream->buffer_len, stream->fh) !=
+        stream->buffer_len) {
+        log_err("Error writing output file %s", stream->filename);
+    }
+    stream->buffer_len = 0;
+}
+
 /******************************************************************************
  * @brief    write all variables to output files.
+ *
+ * @details  The record is appended to the buffer of the stream, which is
+ *           written to the file once it is full (BINARY) or holds
+ *           OUT_BUFFER_SIZE bytes (ASCII), and when the file is closed.
  *****************************************************************************/
 void
 write_data(stream_struct *stream)
 {
-    extern option_struct   options;
     extern metadata_struct out_metadata[N_OUTVAR_TYPES];
 
-    size_t                 n;
     size_t                 var_idx;
     size_t                 elem_idx;
-    size_t                 ptr_idx;
     unsigned int           varid;
-    char                  *tmp_cptr;
-    short int             *tmp_siptr;
-    unsigned short int    *tmp_usiptr;
-    int                   *tmp_iptr;
-    float                 *tmp_fptr;
-    double                *tmp_dptr;
+    int                    date[4];
+    int                    precision;
+    char                  *dest;
 
     if (stream->file_format == BINARY) {
-        n = N_OUTVAR_TYPES * options.Nlayer * options.SNOW_BAND;
-        // Initialize pointers
-        tmp_cptr = calloc(n, sizeof(*tmp_cptr));
-        tmp_siptr = calloc(n, sizeof(*tmp_siptr));
-        tmp_usiptr = calloc(n, sizeof(*tmp_usiptr));
-        tmp_iptr = calloc(n, sizeof(*tmp_iptr));
-        tmp_fptr = calloc(n, sizeof(*tmp_fptr));
-        tmp_dptr = calloc(n, sizeof(*tmp_dptr));
-
         // Time
-        tmp_iptr[0] = stream->time_bounds[0].year;
-        tmp_iptr[1] = stream->time_bounds[0].month;
-        tmp_iptr[2] = stream->time_bounds[0].day;
-        tmp_iptr[3] = stream->time_bounds[0].dayseconds;
+        date[0] = stream->time_bounds[0].year;
+        date[1] = stream->time_bounds[0].month;
+        date[2] = stream->time_bounds[0].day;
+        date[3] = stream->time_bounds[0].dayseconds;
 
         // Write the date
+        dest = reserve_buffer(stream, sizeof(date));
         if (stream->agg_alarm.is_subdaily) {
             // Write year, month, day, and sec
-            fwrite(tmp_iptr, sizeof(int), 4,
-                   stream->fh);
+            memcpy(dest, date, 4 * sizeof(int));
+            stream->buffer_len += 4 * sizeof(int);
         }
         else {
             // Only write year, month, and day
-            fwrite(tmp_iptr, sizeof(int), 3,
-                   stream->fh);
+            memcpy(dest, date, 3 * sizeof(int));
+            stream->buffer_len += 3 * sizeof(int);
         }
 
         // Loop over this output file's data variables
         for (var_idx = 0; var_idx < stream->nvars; var_idx++) {
             varid = stream->varid[var_idx];
             // Loop over this variable's elements
-            ptr_idx = 0;
-            if (stream->type[var_idx] == OUT_TYPE_CHAR) {
-                for (elem_idx = 0;
-                     elem_idx < out_metadata[varid].nelem;
-                     elem_idx++) {
-                    tmp_cptr[ptr_idx++] =
-                        (char) stream->aggdata[0][var_idx][elem_idx][0];
-                }
-                fwrite(tmp_cptr, sizeof(char), ptr_idx,
-                       stream->fh);
-            }
-            else if (stream->type[var_idx] == OUT_TYPE_SINT) {
-                for (elem_idx = 0; elem_idx < out_metadata[varid].nelem;
-                     elem_idx++) {
-                    tmp_siptr[ptr_idx++] =
-                        (short int) stream->aggdata[0][var_idx][elem_idx][0];
-                }
-                fwrite(tmp_siptr, sizeof(short int), ptr_idx,
-                       stream->fh);
-            }
-            else if (stream->type[var_idx] == OUT_TYPE_USINT) {
-                for (elem_idx = 0;
-                     elem_idx < out_metadata[varid].nelem;
-                     elem_idx++) {
-                    tmp_usiptr[ptr_idx++] =
-                        (unsigned short int) stream->aggdata[0][var_idx][
-                            elem_idx][0];
-                }
-                fwrite(tmp_usiptr, sizeof(unsigned short int), ptr_idx,
-                       stream->fh);
-            }
-            else if (stream->type[var_idx] == OUT_TYPE_INT) {
-                for (elem_idx = 0;
-                     elem_idx < out_metadata[varid].nelem;
-                     elem_idx++) {
-                    tmp_iptr[ptr_idx++] =
-                        (int) stream->aggdata[0][var_idx][elem_idx][0];
-                }
-                fwrite(tmp_iptr, sizeof(int), ptr_idx,
-                       stream->fh);
-            }
-            else if (stream->type[var_idx] == OUT_TYPE_FLOAT) {
-                for (elem_idx = 0;
-                     elem_idx < out_metadata[varid].nelem;
-                     elem_idx++) {
-                    tmp_fptr[ptr_idx++] =
-                        (float) stream->aggdata[0][var_idx][elem_idx][0];
-                }
-                fwrite(tmp_fptr, sizeof(float), ptr_idx,
-                       stream->fh);
-            }
-            else if (stream->type[var_idx] == OUT_TYPE_DOUBLE) {
-                for (elem_idx = 0;
-                     elem_idx < out_metadata[varid].nelem;
-                     elem_idx++) {
-                    tmp_dptr[ptr_idx++] =
-                        (double) stream->aggdata[0][var_idx][elem_idx][0];
-                }
-                fwrite(tmp_dptr, sizeof(double), ptr_idx,
-                       stream->fh);
+            for (elem_idx = 0; elem_idx < out_metadata[varid].nelem;
+                 elem_idx++) {
+                buffer_binary_value(stream, stream->type[var_idx],
+                                    stream->aggdata[0][var_idx][elem_idx][0]);
             }
         }
-
-        // Free the arrays
-        free((char *) tmp_cptr);
-        free((char *) tmp_siptr);
-        free((char *) tmp_usiptr);
-        free((char *) tmp_iptr);
-        free((char *) tmp_fptr);
-        free((char *) tmp_dptr);
     }
     else if (stream->file_format == ASCII) {
         // Write the date
+        dest = reserve_buffer(stream, MAXSTRING);
         if (stream->agg_alarm.is_subdaily) {
             // Write year, month, day, and sec
-            fprintf(stream->fh,
-                    "%04u\t%02hu\t%02hu\t%05u\t",
-                    stream->time_bounds[0].year, stream->time_bounds[0].month,
-                    stream->time_bounds[0].day,
-                    stream->time_bounds[0].dayseconds);
+            stream->buffer_len += snprintf(dest, MAXSTRING,
+                                           "%04u\t%02hu\t%02hu\t%05u\t",
+                                           stream->time_bounds[0].year,
+                                           stream->time_bounds[0].month,
+                                           stream->time_bounds[0].day,
+                                           stream->time_bounds[0].dayseconds);
         }
         else {
             // Only write year, month, and day
-            fprintf(stream->fh,
-                    "%04u\t%02hu\t%02hu\t",
-                    stream->time_bounds[0].year, stream->time_bounds[0].month,
-                    stream->time_bounds[0].day);
+            stream->buffer_len += snprintf(dest, MAXSTRING,
+                                           "%04u\t%02hu\t%02hu\t",
+                                           stream->time_bounds[0].year,
+                                           stream->time_bounds[0].month,
+                                           stream->time_bounds[0].day);
         }
 
         // Loop over this output file's data variables
         for (var_idx = 0; var_idx < stream->nvars; var_idx++) {
             varid = stream->varid[var_idx];
+            precision = fixed_format_precision(stream->format[var_idx]);
             // Loop over this variable's elements
             for (elem_idx = 0; elem_idx < out_metadata[varid].nelem;
                  elem_idx++) {
                 if (!(var_idx == 0 && elem_idx == 0)) {
-                    fprintf(stream->fh, "\t ");
+                    dest = reserve_buffer(stream, 2);
+                    dest[0] = '\t';
+                    dest[1] = ' ';
+                    stream->buffer_len += 2;
                 }
-                fprintf(stream->fh,
-                        stream->format[var_idx],
-                        stream->aggdata[0][var_idx][elem_idx][0]);
+                buffer_ascii_value(stream, stream->format[var_idx],
+                                   precision,
+                                   stream->aggdata[0][var_idx][elem_idx][0]);
             }
         }
-        fprintf(stream->fh, "\n");
+        dest = reserve_buffer(stream, 1);
+        dest[0] = '\n';
+        stream->buffer_len++;
     }
     else {
         log_err("Unrecognized OUT_FORMAT option");
     }
+
+    if (stream->file_format == BINARY) {
+        if (stream->buffer_len + stream->record_size > stream->buffer_size) {
+            flush_stream_buffer(stream);
+        }
+    }
+    else if (stream->buffer_len >= OUT_BUFFER_SIZE) {
+        flush_stream_buffer(stream);
+    }
 }
@@ -27,18 +27,228 @@
 #ifndef VIC_DRIVER_IMAGE_H
 #define VIC_DRIVER_IMAGE_H
 
+#include <pthread.h>
 #include <vic_driver_shared_image.h>
+#include <rout.h>
 
 #define VIC_DRIVER "Image"
 
+#define CHECKPOINT_MAGIC "VICCKPT"
+#define CHECKPOINT_VERSION 1
+
+#define DA_VERSION 1
+
+#define MAX_FORCE_FIELDS 11     /**< forcing fields read per time step */
+
+#define DISAGG_TMIN_HOUR 6.     /**< local solar hour of TMIN */
+#define DISAGG_TMAX_HOUR 15.    /**< local solar hour of TMAX */
+#define DISAGG_SOLAR_CONST 1368.  /**< solar constant [W/m2] */
+#define DISAGG_TAU_MAX 0.75     /**< clear sky transmissivity */
+#define DISAGG_TAU_B 0.0035     /**< Bristow-Campbell coefficient [C-C] */
+#define DISAGG_TAU_C 2.4        /**< Bristow-Campbell exponent */
+
+#define SYNTH_TMEAN_EQUATOR 26.  /**< annual mean air temperature at the
+                                    equator and sea level [C] */
+#define SYNTH_TMEAN_POLE 40.    /**< decrease of the annual mean air
+                                   temperature from the equator to the
+                                   poles [C] */
+#define SYNTH_TAMP_POLE 15.     /**< seasonal amplitude of the air
+                                   temperature at the poles [C] */
+#define SYNTH_WET_PROB 0.3      /**< probability of a wet day */
+#define SYNTH_MAX_PREC 30.      /**< maximum precipitation of a wet day
+                                   [mm] */
+#define SYNTH_EMISSIVITY 0.8    /**< emissivity of the sky */
+#define SYNTH_CATM 400.         /**< CO2 mixing ratio [ppm] */
+#define SYNTH_PAR_FRACTION 0.45  /**< fraction of the shortwave that is
+                                    photosynthetically active */
+
+/******************************************************************************
+ * @brief   Tags of the messages exchanged with the data assimilation program
+ *****************************************************************************/
+enum {
+    DA_TAG_HEADER = 1,
+    DA_TAG_CELLS,
+    DA_TAG_STATE,
+    DA_TAG_UPDATE,
+    DA_TAG_KEEP,
+    DA_TAG_END
+};
+
+/******************************************************************************
+ * @brief   Structure for one forcing read (all sub-steps of one variable)
+ *****************************************************************************/
+typedef struct {
+    size_t file_num;              /**< forcing file number (0 or 1) */
+    char nc_name[MAXSTRING];      /**< name of the netcdf file */
+    char var_name[MAXSTRING];     /**< name of the netcdf variable */
+    int ndims;                    /**< number of dimensions of the variable */
+    size_t start[MAXDIMS];        /**< start of the hyperslab */
+    size_t count[MAXDIMS];        /**< count of the hyperslab */
+    size_t nelem;                 /**< number of elements in data */
+    int nc_type;                  /**< type of data: NC_DOUBLE, or NC_FLOAT
+                                       or NC_SHORT (FORCE_PRECISION_SINGLE) */
+    double scale_factor;          /**< unpacking of NC_SHORT data */
+    double add_offset;            /**< unpacking of NC_SHORT data */
+    void *data;                   /**< data on the master node */
+} force_read_struct;
+
+/******************************************************************************
+ * @brief   Structure for the forcing prefetch pipeline
+ *****************************************************************************/
+typedef struct {
+    size_t nreads;                /**< number of reads per time step */
+    size_t nalloc;                /**< number of allocated reads */
+    size_t next;                  /**< next read during vic_force */
+    force_read_struct *reads;     /**< reads of the last (or next) time step */
+    bool active;                  /**< TRUE = reader thread is running */
+    pthread_t thread;             /**< reader thread */
+} force_prefetch_struct;
+
+/******************************************************************************
+ * @brief   Structure for the forcing reader processes (FORCE_READERS)
+ * @details The first nreaders processes each read some of the forcing fields
+ *          of a time step and scatter them from there. The decomposition is
+ *          copied from the master node to the other readers.
+ *****************************************************************************/
+typedef struct {
+    size_t nreaders;              /**< number of reader processes */
+    size_t ncells_total;          /**< number of cells of the grid */
+    size_t ncells_active;         /**< number of active cells */
+    int nprocs;                   /**< number of processes of the maps */
+    int *sizes;                   /**< number of cells of each process */
+    int *offsets;                 /**< offset of the cells of each process */
+    size_t *grid_map;             /**< grid cell of the active cells in the
+                                       order of the processes */
+    int *counts;                  /**< number of values sent to each process */
+    int *displs;                  /**< offset of the values of each process */
+    double *grid;                 /**< a field on the full grid (reader) */
+    size_t grid_size;             /**< number of values of grid */
+    double *sendbuf;              /**< fields read by this process, in the
+                                       order of the processes (reader) */
+    size_t sendbuf_size;          /**< number of values of sendbuf */
+    MPI_Request *requests;        /**< scatter of each field */
+    size_t nrequests;             /**< number of allocated requests */
+} force_readers_struct;
+
+/******************************************************************************
+ * @brief   Structure for the staging of the forcing files (FORCE_STAGE_DIR)
+ *****************************************************************************/
+typedef struct {
+    bool enabled;                 /**< TRUE = this process stages its files */
+    char current[MAXSTRING];      /**< forcing file in use */
+    char current_local[MAXSTRING]; /**< its local copy, empty if it is read
+                                        from the shared file system */
+    char next[MAXSTRING];         /**< forcing file that is staged next */
+    char next_local[MAXSTRING];   /**< its local copy */
+    bool next_ready;              /**< TRUE = the copy of next is complete */
+    bool active;                  /**< TRUE = stager thread is running */
+    pthread_t thread;             /**< stager thread */
+} force_stage_struct;
+
+/******************************************************************************
+ * @brief   Structure for the persistent workspace of vic_force
+ *****************************************************************************/
+typedef struct {
+    double *dvar;                 /**< all NF sub-steps of the forcing fields
+                                       of the local cells
+                                       [MAX_FORCE_FIELDS * NF * ncells] */
+    double *t_offset;             /**< lowest temperature offset of the
+                                       elevation bands of each cell [ncells] */
+} force_workspace_struct;
+
+/******************************************************************************
+ * @brief   Structure for the catalog of the forcing files (FORCE_CATALOG)
+ *****************************************************************************/
+typedef struct {
+    size_t nfiles;                /**< number of files */
+    double dt;                    /**< length of a record [days] */
+    char *nc_names;               /**< names of the files [nfiles * MAXSTRING],
+                                       by the time of their first record */
+    double *start;                /**< time of the first record of each file
+                                       [days] */
+    size_t *nrecs;                /**< number of records of each file */
+} force_catalog_struct;
+
+/******************************************************************************
+ * @brief   Structure for the daily forcings of FORCE_DISAGG
+ *****************************************************************************/
+typedef struct {
+    bool valid;                   /**< TRUE = the record of a day was read */
+    char nc_name[MAXSTRING];      /**< forcing file of the record */
+    size_t start;                 /**< index of the record in the file */
+    double *tmin;                 /**< minimum air temperature [C] */
+    double *tmax;                 /**< maximum air temperature [C] */
+    double *prec;                 /**< precipitation of the day [mm] */
+    double *wind;                 /**< wind speed [m/s] */
+    double *vp;                   /**< vapor pressure [kPa] */
+    double *pressure;             /**< air pressure [kPa] */
+    double *sw_scale;             /**< shortwave per cosine of the solar
+                                       zenith angle [W/m2] */
+    double *lw_scale;             /**< longwave per fourth power of the air
+                                       temperature (LWDOWN) [W/m2/K4] */
+    double *t4_mean;              /**< daily mean of the fourth power of the
+                                       air temperature [K4] */
+    double *cloud;                /**< cloud fraction of the day */
+    double *coszen;               /**< cosine of the solar zenith angle of a
+                                       sub-step */
+} force_disagg_struct;
+
+/******************************************************************************
+ * @brief   Header of the stream file of a checkpoint of one process
+ *****************************************************************************/
+typedef struct {
+    char magic[8];                /**< CHECKPOINT_MAGIC */
+    unsigned int version;         /**< CHECKPOINT_VERSION */
+    int mpi_rank;                 /**< process that wrote the file */
+    size_t ncells;                /**< number of local cells */
+    size_t next_step;             /**< first time step after the checkpoint */
+    unsigned short int forceoffset[2]; /**< global_param.forceoffset */
+    unsigned int forceskip[2];    /**< global_param.forceskip */
+} checkpoint_header_struct;
+
+void broadcast_force_catalog(void);
+bool check_checkpoint_signal(void);
 bool check_save_state_flag(size_t);
 void display_current_settings(int);
+void finalize_checkpoint(void);
+void finalize_da(void);
+void finalize_force_catalog(void);
+bool get_force_catalog_next_file(char *nc_name, char *next_name);
+bool get_force_catalog_record(dmy_struct *dmy, char *nc_name, size_t *start);
 void get_forcing_file_info(param_set_struct *param_set, size_t file_num);
 void get_global_param(FILE *);
+void get_staged_forcing_file(char *nc_name, unsigned short int year,
+                             char *read_name);
+void get_scatter_forcing_field(size_t file_num, char *nc_name, char *var_name,
+                               int ndims, size_t *start, size_t *count,
+                               double *var);
+void get_scatter_forcing_fields(size_t file_num, char *nc_name,
+                                size_t nfields, char **var_names, int ndims,
+                                size_t *start, size_t *count, double **vars);
+void initialize_checkpoint(void);
+void initialize_da(void);
+void initialize_force_catalog(param_set_struct *param_set);
+size_t restore_checkpoint(void);
+void vic_checkpoint(void);
+void vic_da(void);
 void vic_force(void);
+void vic_force_disagg(size_t start);
+void vic_force_disagg_finalize(void);
+void vic_force_disagg_init(void);
+void vic_force_finalize(void);
+void vic_force_init(void);
+void vic_force_prefetch_finalize(void);
+void vic_force_prefetch_start(void);
+void vic_force_prefetch_wait(void);
+void vic_force_readers_finalize(void);
+void vic_force_readers_init(void);
+void vic_force_stage_finalize(void);
+void vic_force_stage_init(void);
+void vic_force_synthetic(void);
 void vic_image_init(void);
 void vic_image_finalize();
 void vic_image_start(void);
 void vic_populate_model_state(void);
+void vic_spinup(void);
 
 #endif
@@ -58,6 +58,10 @@ display_current_settings(int mode)
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "LOG_LEVEL:\t\t%d\n", LOG_LVL);
     fprintf(LOG_DEST, "\n");
+#ifdef VIC_SPECIALIZE
+    fprintf(LOG_DEST, "SPECIALIZE:\t\t%s\n", VIC_SPECIALIZE);
+    fprintf(LOG_DEST, "\n");
+#endif
     fprintf(LOG_DEST, "Maximum Array Sizes:\n");
     fprintf(LOG_DEST, "MAX_BANDS\t\t%2d\n", MAX_BANDS);
     fprintf(LOG_DEST, "MAX_FRONTS\t\t%2d\n", MAX_FRONTS);
@@ -184,6 +188,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "IMPLICIT\t\tFALSE\n");
     }
+    if (options.ANALYTIC_JACOBIAN) {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tFALSE\n");
+    }
     if (options.NOFLUX) {
         fprintf(LOG_DEST, "NOFLUX\t\t\tTRUE\n");
     }
@@ -202,6 +212,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "QUICK_SOLVE\t\tFALSE\n");
     }
+    if (options.QUIESCENT_SOIL) {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tFALSE\n");
+    }
     if (options.SPATIAL_FROST) {
         fprintf(LOG_DEST, "SPATIAL_FROST\t\tTRUE\n");
         fprintf(LOG_DEST, "Nfrost\t\t%zu\n", options.Nfrost);
@@ -215,6 +231,18 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "SPATIAL_SNOW\t\tFALSE\n");
     }
+    if (options.ADAPTIVE_SUBSTEPS) {
+        fprintf(LOG_DEST, "ADAPTIVE_SUBSTEPS\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ADAPTIVE_SUBSTEPS\tFALSE\n");
+    }
+    if (options.BAND_MERGE) {
+        fprintf(LOG_DEST, "BAND_MERGE\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "BAND_MERGE\t\tFALSE\n");
+    }
     if (options.SNOW_DENSITY == DENS_BRAS) {
         fprintf(LOG_DEST, "SNOW_DENSITY\t\tDENS_BRAS\n");
     }
@@ -227,6 +255,24 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "TFALLBACK\t\tFALSE\n");
     }
+    if (options.TSURF_NEWTON) {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tFALSE\n");
+    }
+    if (options.ROOT_RETRY) {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tFALSE\n");
+    }
+    if (options.FAST_SVP) {
+        fprintf(LOG_DEST, "FAST_SVP\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FAST_SVP\t\tFALSE\n");
+    }
     fprintf(LOG_DEST, "WIND_H\t\t\t%f\n", global_param.wind_h);
     fprintf(LOG_DEST, "NODES\t\t\t%zu\n", options.Nnode);
     if (options.CARBON) {
@@ -270,6 +316,12 @@ display_current_settings(int mode)
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "Constants File\t\t%s\n", filenames.constants);
     fprintf(LOG_DEST, "Parameters file\t\t%s\n", filenames.params);
+    if (strcasecmp(filenames.param_cache, "MISSING") != 0) {
+        fprintf(LOG_DEST, "PARAM_CACHE\t\t%s\n", filenames.param_cache);
+    }
+    if (strcasecmp(filenames.rout_params, "MISSING") != 0) {
+        fprintf(LOG_DEST, "ROUT_PARAM\t\t%s\n", filenames.rout_params);
+    }
     if (options.BASEFLOW == ARNO) {
         fprintf(LOG_DEST, "BASEFLOW\t\tARNO\n");
     }
@@ -391,6 +443,9 @@ display_current_settings(int mode)
         else if (options.STATE_FORMAT == NETCDF4) {
             fprintf(LOG_DEST, "STATE_FORMAT\t\tNETCDF4\n");
         }
+        else if (options.STATE_FORMAT == BINARY_FAST) {
+            fprintf(LOG_DEST, "STATE_FORMAT\t\tBINARY_FAST\n");
+        }
     }
     else {
         fprintf(LOG_DEST, "INIT_STATE\t\tFALSE\n");
@@ -417,11 +472,196 @@ display_current_settings(int mode)
         else if (options.STATE_FORMAT == NETCDF4) {
             fprintf(LOG_DEST, "STATE_FORMAT\t\tNETCDF4\n");
         }
+        else if (options.STATE_FORMAT == BINARY_FAST) {
+            fprintf(LOG_DEST, "STATE_FORMAT\t\tBINARY_FAST\n");
+        }
+        if (options.STATE_INCREMENTAL) {
+            fprintf(LOG_DEST, "STATE_INCREMENTAL\tTRUE\n");
+        }
+        else {
+            fprintf(LOG_DEST, "STATE_INCREMENTAL\tFALSE\n");
+        }
+        if (options.STATE_ASYNC) {
+            fprintf(LOG_DEST, "STATE_ASYNC\t\tTRUE\n");
+        }
+        else {
+            fprintf(LOG_DEST, "STATE_ASYNC\t\tFALSE\n");
+        }
+        if (options.STATE_STREAMS) {
+            fprintf(LOG_DEST, "STATE_STREAMS\t\tTRUE\n");
+        }
+        else {
+            fprintf(LOG_DEST, "STATE_STREAMS\t\tFALSE\n");
+        }
     }
     else {
         fprintf(LOG_DEST, "SAVE_STATE\t\tFALSE\n");
     }
 
+    fprintf(LOG_DEST, "\n");
+    fprintf(LOG_DEST, "Spin-up:\n");
+    fprintf(LOG_DEST, "SPINUP_CYCLES\t\t%zu\n", global_param.spinup_cycles);
+    if (global_param.spinup_cycles > 0) {
+        fprintf(LOG_DEST, "SPINUP_YEARS\t\t%zu\n", global_param.spinup_years);
+        fprintf(LOG_DEST, "SPINUP_TOL\t\t%f\n", global_param.spinup_tol);
+        fprintf(LOG_DEST, "SPINUP_BLOCK_STEPS\t%zu\n",
+                global_param.spinup_block_steps);
+        if (options.SPINUP_FLOAT) {
+            fprintf(LOG_DEST, "SPINUP_FLOAT\t\tTRUE\n");
+        }
+        else {
+            fprintf(LOG_DEST, "SPINUP_FLOAT\t\tFALSE\n");
+        }
+    }
+
+    fprintf(LOG_DEST, "\n");
+    fprintf(LOG_DEST, "Parallelization:\n");
+    fprintf(LOG_DEST, "NTHREADS\t\t%zu\n", options.NTHREADS);
+    if (options.DECOMPOSITION == DECOMP_ROUND_ROBIN) {
+        fprintf(LOG_DEST, "DECOMPOSITION\t\tROUND_ROBIN\n");
+    }
+    else if (options.DECOMPOSITION == DECOMP_COST_WEIGHTED) {
+        fprintf(LOG_DEST, "DECOMPOSITION\t\tCOST_WEIGHTED\n");
+        fprintf(LOG_DEST, "Cost file\t\t%s\n", filenames.decomp_cost);
+    }
+    else if (options.DECOMPOSITION == DECOMP_HILBERT) {
+        fprintf(LOG_DEST, "DECOMPOSITION\t\tHILBERT\n");
+        fprintf(LOG_DEST, "Cost file\t\t%s\n", filenames.decomp_cost);
+    }
+    if (strcasecmp(filenames.cost_map, "MISSING") != 0) {
+        fprintf(LOG_DEST, "COST_MAP\t\t%s\n", filenames.cost_map);
+    }
+    if (strcasecmp(filenames.checkpoint, "MISSING") != 0) {
+        fprintf(LOG_DEST, "CHECKPOINT\t\t%s\n", filenames.checkpoint);
+    }
+    if (strcasecmp(filenames.da_port, "MISSING") != 0) {
+        fprintf(LOG_DEST, "DA_PORT\t\t\t%s\n", filenames.da_port);
+    }
+    if (strcasecmp(filenames.force_stage, "MISSING") != 0) {
+        fprintf(LOG_DEST, "FORCE_STAGE_DIR\t\t%s\n", filenames.force_stage);
+    }
+    if (strcasecmp(filenames.trace, "MISSING") != 0) {
+        fprintf(LOG_DEST, "TRACE_FILE\t\t%s\n", filenames.trace);
+    }
+    if (options.FORCE_PRECISION == FORCE_PRECISION_SINGLE) {
+        fprintf(LOG_DEST, "FORCE_PRECISION\t\tSINGLE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FORCE_PRECISION\t\tDOUBLE\n");
+    }
+    if (options.FORCE_CATALOG) {
+        fprintf(LOG_DEST, "FORCE_CATALOG\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FORCE_CATALOG\t\tFALSE\n");
+    }
+    if (options.FORCE_DISAGG) {
+        fprintf(LOG_DEST, "FORCE_DISAGG\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FORCE_DISAGG\t\tFALSE\n");
+    }
+    if (options.FORCE_PREFETCH) {
+        fprintf(LOG_DEST, "FORCE_PREFETCH\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FORCE_PREFETCH\t\tFALSE\n");
+    }
+    fprintf(LOG_DEST, "FORCE_READERS\t\t%zu\n", options.FORCE_READERS);
+    if (options.PARALLEL_IO) {
+        fprintf(LOG_DEST, "PARALLEL_IO\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "PARALLEL_IO\t\tFALSE\n");
+    }
+    if (options.ASYNC_OUTPUT) {
+        fprintf(LOG_DEST, "ASYNC_OUTPUT\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ASYNC_OUTPUT\t\tFALSE\n");
+    }
+    fprintf(LOG_DEST, "IO_SERVERS\t\t%zu\n", options.IO_SERVERS);
+    if (options.NODE_SHARED_TABLES) {
+        fprintf(LOG_DEST, "NODE_SHARED_TABLES\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "NODE_SHARED_TABLES\tFALSE\n");
+    }
+    if (options.HIERARCHICAL_IO) {
+        fprintf(LOG_DEST, "HIERARCHICAL_IO\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "HIERARCHICAL_IO\t\tFALSE\n");
+    }
+    if (options.DISTRIBUTED_DOMAIN) {
+        fprintf(LOG_DEST, "DISTRIBUTED_DOMAIN\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "DISTRIBUTED_DOMAIN\tFALSE\n");
+    }
+    if (options.NUMA_FIRST_TOUCH) {
+        fprintf(LOG_DEST, "NUMA_FIRST_TOUCH\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "NUMA_FIRST_TOUCH\tFALSE\n");
+    }
+    if (options.OUT_CASCADE) {
+        fprintf(LOG_DEST, "OUT_CASCADE\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "OUT_CASCADE\t\tFALSE\n");
+    }
+    if (options.OUT_LAYOUT == OUT_LAYOUT_LAND) {
+        fprintf(LOG_DEST, "OUT_LAYOUT\t\tLAND\n");
+    }
+    else {
+        fprintf(LOG_DEST, "OUT_LAYOUT\t\tGRID\n");
+    }
+    fprintf(LOG_DEST, "OUT_SPLIT\t\t%zu\n", options.OUT_SPLIT);
+    fprintf(LOG_DEST, "COMPRESS_THREADS\t%zu\n", options.COMPRESS_THREADS);
+    if (options.REPRODUCIBLE) {
+        fprintf(LOG_DEST, "REPRODUCIBLE\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "REPRODUCIBLE\t\tFALSE\n");
+    }
+    if (options.PERF_REGIONS) {
+        fprintf(LOG_DEST, "PERF_REGIONS\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "PERF_REGIONS\t\tFALSE\n");
+    }
+    if (options.IO_BENCHMARK) {
+        fprintf(LOG_DEST, "IO_BENCHMARK\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "IO_BENCHMARK\t\tFALSE\n");
+    }
+    if (options.COMPUTE_BENCHMARK) {
+        fprintf(LOG_DEST, "COMPUTE_BENCHMARK\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "COMPUTE_BENCHMARK\tFALSE\n");
+    }
+    fprintf(LOG_DEST, "HEARTBEAT_STEPS\t\t%zu\n", options.HEARTBEAT_STEPS);
+    fprintf(LOG_DEST, "HEARTBEAT_SECONDS\t%zu\n", options.HEARTBEAT_SECONDS);
+    fprintf(LOG_DEST, "LOG_BUFFER\t\t%zu\n", options.LOG_BUFFER);
+    fprintf(LOG_DEST, "REBALANCE_STEPS\t\t%zu\n", options.REBALANCE_STEPS);
+    fprintf(LOG_DEST, "DA_STEPS\t\t%zu\n", options.DA_STEPS);
+    if (options.BALANCE_CHECK == BALANCE_CHECK_STEPS) {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tSTEPS\n");
+    }
+    else if (options.BALANCE_CHECK == BALANCE_CHECK_CELLS) {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tCELLS\n");
+    }
+    else if (options.BALANCE_CHECK == BALANCE_CHECK_OUTPUT) {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tOUTPUT\n");
+    }
+    else {
+        fprintf(LOG_DEST, "BALANCE_CHECK\t\tALL\n");
+    }
+    fprintf(LOG_DEST, "BALANCE_CHECK_N\t\t%zu\n", options.BALANCE_CHECK_N);
+
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "Output Data:\n");
     fprintf(LOG_DEST, "Result dir:\t\t%s\n", filenames.result_dir);
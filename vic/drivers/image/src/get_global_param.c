@@ -39,6 +39,7 @@ get_global_param(FILE *gp)
     extern param_set_struct    param_set;
     extern filenames_struct    filenames;
     extern size_t              NF, NR;
+    extern int                 mpi_size;
 
     char                       cmdstr[MAXSTRING];
     char                       optstr[MAXSTRING];
@@ -137,6 +138,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.QUICK_SOLVE = str_to_bool(flgstr);
             }
+            else if (strcasecmp("QUIESCENT_SOIL", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.QUIESCENT_SOIL = str_to_bool(flgstr);
+            }
             else if ((strcasecmp("NOFLUX",
                                  optstr) == 0) ||
                      (strcasecmp("NO_FLUX", optstr) == 0)) {
@@ -149,6 +154,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.IMPLICIT = str_to_bool(flgstr);
             }
+            else if (strcasecmp("ANALYTIC_JACOBIAN", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ANALYTIC_JACOBIAN = str_to_bool(flgstr);
+            }
             else if (strcasecmp("EXP_TRANS", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.EXP_TRANS = str_to_bool(flgstr);
@@ -189,6 +198,10 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.BLOWING_SPATIAL_WIND = str_to_bool(flgstr);
             }
+            else if (strcasecmp("BLOWING_FAST", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.BLOWING_FAST = str_to_bool(flgstr);
+            }
             else if (strcasecmp("CORRPREC", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.CORRPREC = str_to_bool(flgstr);
@@ -251,10 +264,30 @@ get_global_param(FILE *gp)
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.SPATIAL_SNOW = str_to_bool(flgstr);
             }
+            else if (strcasecmp("ADAPTIVE_SUBSTEPS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ADAPTIVE_SUBSTEPS = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("BAND_MERGE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.BAND_MERGE = str_to_bool(flgstr);
+            }
             else if (strcasecmp("TFALLBACK", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.TFALLBACK = str_to_bool(flgstr);
             }
+            else if (strcasecmp("TSURF_NEWTON", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.TSURF_NEWTON = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("ROOT_RETRY", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ROOT_RETRY = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("FAST_SVP", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.FAST_SVP = str_to_bool(flgstr);
+            }
             else if (strcasecmp("SHARE_LAYER_MOIST", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 options.SHARE_LAYER_MOIST = str_to_bool(flgstr);
@@ -279,12 +312,170 @@ get_global_param(FILE *gp)
                 }
             }
 
+            /*************************************
+               Define parallelization options
+            *************************************/
+            else if (strcasecmp("NTHREADS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.NTHREADS);
+            }
+            else if (strcasecmp("DECOMPOSITION", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                if (strcasecmp("ROUND_ROBIN", flgstr) == 0) {
+                    options.DECOMPOSITION = DECOMP_ROUND_ROBIN;
+                }
+                else if (strcasecmp("COST_WEIGHTED", flgstr) == 0) {
+                    options.DECOMPOSITION = DECOMP_COST_WEIGHTED;
+                    sscanf(cmdstr, "%*s %*s %s", filenames.decomp_cost);
+                }
+                else if (strcasecmp("HILBERT", flgstr) == 0) {
+                    options.DECOMPOSITION = DECOMP_HILBERT;
+                    sscanf(cmdstr, "%*s %*s %s", filenames.decomp_cost);
+                }
+                else {
+                    log_err("Unknown DECOMPOSITION option: %s", flgstr);
+                }
+            }
+            else if (strcasecmp("FORCE_PRECISION", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                if (strcasecmp("DOUBLE", flgstr) == 0) {
+                    options.FORCE_PRECISION = FORCE_PRECISION_DOUBLE;
+                }
+                else if (strcasecmp("SINGLE", flgstr) == 0) {
+                    options.FORCE_PRECISION = FORCE_PRECISION_SINGLE;
+                }
+                else {
+                    log_err("Unknown FORCE_PRECISION option: %s", flgstr);
+                }
+            }
+            else if (strcasecmp("BALANCE_CHECK", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                if (strcasecmp("ALL", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_ALL;
+                }
+                else if (strcasecmp("STEPS", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_STEPS;
+                }
+                else if (strcasecmp("CELLS", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_CELLS;
+                }
+                else if (strcasecmp("OUTPUT", flgstr) == 0) {
+                    options.BALANCE_CHECK = BALANCE_CHECK_OUTPUT;
+                }
+                else {
+                    log_err("Unknown BALANCE_CHECK option: %s", flgstr);
+                }
+            }
+            else if (strcasecmp("BALANCE_CHECK_N", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.BALANCE_CHECK_N);
+            }
+            else if (strcasecmp("FORCE_CATALOG", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.FORCE_CATALOG = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("FORCE_DISAGG", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.FORCE_DISAGG = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("FORCE_PREFETCH", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.FORCE_PREFETCH = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("FORCE_READERS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.FORCE_READERS);
+            }
+            else if (strcasecmp("PARALLEL_IO", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.PARALLEL_IO = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("ASYNC_OUTPUT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.ASYNC_OUTPUT = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("IO_SERVERS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.IO_SERVERS);
+            }
+            else if (strcasecmp("NODE_SHARED_TABLES", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.NODE_SHARED_TABLES = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("HIERARCHICAL_IO", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.HIERARCHICAL_IO = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("DISTRIBUTED_DOMAIN", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.DISTRIBUTED_DOMAIN = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("NUMA_FIRST_TOUCH", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.NUMA_FIRST_TOUCH = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("OUT_CASCADE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.OUT_CASCADE = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("OUT_LAYOUT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                if (strcasecmp("GRID", flgstr) == 0) {
+                    options.OUT_LAYOUT = OUT_LAYOUT_GRID;
+                }
+                else if (strcasecmp("LAND", flgstr) == 0) {
+                    options.OUT_LAYOUT = OUT_LAYOUT_LAND;
+                }
+                else {
+                    log_err("Unknown OUT_LAYOUT option: %s", flgstr);
+                }
+            }
+            else if (strcasecmp("OUT_SPLIT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.OUT_SPLIT);
+            }
+            else if (strcasecmp("COMPRESS_THREADS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.COMPRESS_THREADS);
+            }
+            else if (strcasecmp("REPRODUCIBLE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.REPRODUCIBLE = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("PERF_REGIONS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.PERF_REGIONS = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("IO_BENCHMARK", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.IO_BENCHMARK = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("COMPUTE_BENCHMARK", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.COMPUTE_BENCHMARK = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("HEARTBEAT_STEPS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.HEARTBEAT_STEPS);
+            }
+            else if (strcasecmp("HEARTBEAT_SECONDS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.HEARTBEAT_SECONDS);
+            }
+            else if (strcasecmp("LOG_BUFFER", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.LOG_BUFFER);
+            }
+            else if (strcasecmp("REBALANCE_STEPS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.REBALANCE_STEPS);
+            }
+            else if (strcasecmp("DA_STEPS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &options.DA_STEPS);
+            }
+
             /*************************************
                Define log directory
             *************************************/
             else if (strcasecmp("LOG_DIR", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", filenames.log_path);
             }
+            else if (strcasecmp("COST_MAP", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.cost_map);
+            }
+            else if (strcasecmp("TRACE_FILE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.trace);
+            }
 
             /*************************************
                Define state files
@@ -299,6 +490,22 @@ get_global_param(FILE *gp)
                     strcpy(filenames.init_state, flgstr);
                 }
             }
+            else if (strcasecmp("SPINUP_CYCLES", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &global_param.spinup_cycles);
+            }
+            else if (strcasecmp("SPINUP_YEARS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &global_param.spinup_years);
+            }
+            else if (strcasecmp("SPINUP_TOL", optstr) == 0) {
+                sscanf(cmdstr, "%*s %lf", &global_param.spinup_tol);
+            }
+            else if (strcasecmp("SPINUP_BLOCK_STEPS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %zu", &global_param.spinup_block_steps);
+            }
+            else if (strcasecmp("SPINUP_FLOAT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.SPINUP_FLOAT = str_to_bool(flgstr);
+            }
             else if (strcasecmp("STATENAME", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", filenames.statefile);
                 options.SAVE_STATE = true;
@@ -329,11 +536,27 @@ get_global_param(FILE *gp)
                 else if (strcasecmp("NETCDF4", flgstr) == 0) {
                     options.STATE_FORMAT = NETCDF4;
                 }
+                else if (strcasecmp("BINARY_FAST", flgstr) == 0) {
+                    options.STATE_FORMAT = BINARY_FAST;
+                }
                 else {
                     log_err("STATE_FORMAT must be either NETCDF3_CLASSIC, "
-                            "NETCDF3_64BIT_OFFSET, NETCDF4_CLASSIC, or NETCDF4.");
+                            "NETCDF3_64BIT_OFFSET, NETCDF4_CLASSIC, NETCDF4, "
+                            "or BINARY_FAST.");
                 }
             }
+            else if (strcasecmp("STATE_INCREMENTAL", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.STATE_INCREMENTAL = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("STATE_ASYNC", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.STATE_ASYNC = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("STATE_STREAMS", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", flgstr);
+                options.STATE_STREAMS = str_to_bool(flgstr);
+            }
 
             /*************************************
                Define forcing files
@@ -382,6 +605,21 @@ get_global_param(FILE *gp)
             else if (strcasecmp("PARAMETERS", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", filenames.params);
             }
+            else if (strcasecmp("PARAM_CACHE", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.param_cache);
+            }
+            else if (strcasecmp("ROUT_PARAM", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.rout_params);
+            }
+            else if (strcasecmp("CHECKPOINT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.checkpoint);
+            }
+            else if (strcasecmp("DA_PORT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.da_port);
+            }
+            else if (strcasecmp("FORCE_STAGE_DIR", optstr) == 0) {
+                sscanf(cmdstr, "%*s %s", filenames.force_stage);
+            }
             else if (strcasecmp("ARNO_PARAMS", optstr) == 0) {
                 sscanf(cmdstr, "%*s %s", flgstr);
                 if (strcasecmp("TRUE", flgstr) == 0) {
@@ -780,16 +1018,47 @@ get_global_param(FILE *gp)
                 "for NRECS.", global_param.nrecs);
     }
 
+    // the meteorological forcings of COMPUTE_BENCHMARK are generated in
+    // memory, at the time step of the snow model
+    if (options.COMPUTE_BENCHMARK) {
+        if (options.IO_BENCHMARK) {
+            log_err("COMPUTE_BENCHMARK = TRUE and IO_BENCHMARK = TRUE cannot "
+                    "be used together.");
+        }
+        if (options.FORCE_CATALOG || options.FORCE_DISAGG ||
+            options.FORCE_PREFETCH ||
+            strcasecmp(filenames.force_stage, "MISSING") != 0) {
+            log_warn("The forcings are not read with COMPUTE_BENCHMARK = "
+                     "TRUE.  Setting FORCE_CATALOG, FORCE_DISAGG and "
+                     "FORCE_PREFETCH to FALSE and ignoring FORCE_STAGE_DIR.");
+            options.FORCE_CATALOG = false;
+            options.FORCE_DISAGG = false;
+            options.FORCE_PREFETCH = false;
+            strcpy(filenames.force_stage, "MISSING");
+        }
+        param_set.force_steps_per_day[0] = global_param.snow_steps_per_day;
+        global_param.forceyear[0] = global_param.startyear;
+        global_param.forcemonth[0] = global_param.startmonth;
+        global_param.forceday[0] = global_param.startday;
+        global_param.forcesec[0] = global_param.startsec;
+    }
+
     // Validate forcing files and variables
-    if (strcmp(filenames.f_path_pfx[0], "MISSING") == 0) {
+    if (strcmp(filenames.f_path_pfx[0], "MISSING") == 0 &&
+        !options.COMPUTE_BENCHMARK) {
         log_err("No forcing file has been defined.  Make sure that the global "
                 "file defines FORCING1.");
     }
 
     // Get information from the forcing file(s)
-    sprintf(filenames.forcing[0], "%s%4d.nc", filenames.f_path_pfx[0],
-            global_param.startyear);
-    get_forcing_file_info(&param_set, 0);
+    if (options.FORCE_CATALOG) {
+        initialize_force_catalog(&param_set);
+    }
+    else if (!options.COMPUTE_BENCHMARK) {
+        sprintf(filenames.forcing[0], "%s%4d.nc", filenames.f_path_pfx[0],
+                global_param.startyear);
+        get_forcing_file_info(&param_set, 0);
+    }
     if (param_set.N_TYPES[1] != MISSING) {
         sprintf(filenames.forcing[1], "%s%4d.nc", filenames.f_path_pfx[1],
                 global_param.startyear);
@@ -913,10 +1182,11 @@ get_global_param(FILE *gp)
     }
     // Set the statename here temporarily to compare with INIT_STATE name
     if (options.SAVE_STATE) {
-        sprintf(flgstr2, "%s.%04i%02i%02i_%05u.nc",
+        sprintf(flgstr2, "%s.%04i%02i%02i_%05u.%s",
                 filenames.statefile, global_param.stateyear,
                 global_param.statemonth, global_param.stateday,
-                global_param.statesec);
+                global_param.statesec,
+                options.STATE_FORMAT == BINARY_FAST ? "bin" : "nc");
     }
     if (options.INIT_STATE && options.SAVE_STATE &&
         (strcmp(filenames.init_state, flgstr2) == 0)) {
@@ -960,8 +1230,8 @@ get_global_param(FILE *gp)
     }
     if (options.Nnode > MAX_NODES) {
         log_err("Global file wants more soil thermal nodes (%zu) than "
-                "are defined by MAX_NODES (%d).  Edit vic_driver_shared.h and "
-                "recompile.", options.Nnode, MAX_NODES);
+                "are defined by MAX_NODES (%d).  Recompile with a larger "
+                "MAX_NODES (make MAX_NODES=n).", options.Nnode, MAX_NODES);
     }
     if (!options.FULL_ENERGY && options.CLOSE_ENERGY) {
         log_err("CLOSE_ENERGY is TRUE but FULL_ENERGY is FALSE. Set "
@@ -991,10 +1261,202 @@ get_global_param(FILE *gp)
         }
     }
 
+    // Validate parallelization options
+    if (options.NTHREADS < 1) {
+        log_err("NTHREADS must be at least 1. Currently NTHREADS is set to "
+                "%zu.", options.NTHREADS);
+    }
+#ifndef _OPENMP
+    if (options.NTHREADS > 1) {
+        log_warn("NTHREADS = %zu, but VIC was compiled without OpenMP "
+                 "support.  Grid cells will be run on a single thread.",
+                 options.NTHREADS);
+        options.NTHREADS = 1;
+    }
+#endif
+#ifndef VIC_PARALLEL_IO
+    if (options.PARALLEL_IO) {
+        log_err("PARALLEL_IO = TRUE, but VIC was compiled against a netCDF "
+                "library without parallel I/O support.");
+    }
+#endif
+    if (options.FORCE_DISAGG) {
+        if (!param_set.TYPE[TMIN].SUPPLIED || !param_set.TYPE[TMAX].SUPPLIED ||
+            !param_set.TYPE[PREC].SUPPLIED || !param_set.TYPE[WIND].SUPPLIED) {
+            log_err("FORCE_DISAGG = TRUE requires the forcing types TMIN, "
+                    "TMAX, PREC and WIND.");
+        }
+        if (options.LAKES || options.CARBON) {
+            log_err("FORCE_DISAGG = TRUE is not supported with LAKES = TRUE "
+                    "or CARBON = TRUE.");
+        }
+    }
+    if (options.PARALLEL_IO && options.FORCE_PREFETCH) {
+        // the reader thread cannot take part in collective reads
+        log_warn("FORCE_PREFETCH is not supported with PARALLEL_IO = TRUE.  "
+                 "Setting FORCE_PREFETCH to FALSE.");
+        options.FORCE_PREFETCH = false;
+    }
+    if (options.PARALLEL_IO && options.ASYNC_OUTPUT) {
+        // the writer thread cannot take part in collective writes
+        log_warn("ASYNC_OUTPUT is not supported with PARALLEL_IO = TRUE.  "
+                 "Setting ASYNC_OUTPUT to FALSE.");
+        options.ASYNC_OUTPUT = false;
+    }
+    if (options.IO_SERVERS >= (size_t) mpi_size) {
+        log_err("IO_SERVERS must be smaller than the number of MPI "
+                "processes. Currently IO_SERVERS is set to %zu with %d "
+                "processes.", options.IO_SERVERS, mpi_size);
+    }
+    if (options.IO_SERVERS > 0 && options.PARALLEL_IO) {
+        // with PARALLEL_IO all processes write the history files
+        log_warn("IO_SERVERS is not supported with PARALLEL_IO = TRUE.  "
+                 "Setting IO_SERVERS to 0.");
+        options.IO_SERVERS = 0;
+    }
+    if (options.PARALLEL_IO &&
+        options.FORCE_PRECISION == FORCE_PRECISION_SINGLE) {
+        // every node reads its own cells of the forcings in double precision
+        log_warn("FORCE_PRECISION = SINGLE is not supported with PARALLEL_IO "
+                 "= TRUE.  Setting FORCE_PRECISION to DOUBLE.");
+        options.FORCE_PRECISION = FORCE_PRECISION_DOUBLE;
+    }
+    if (options.FORCE_READERS == 0) {
+        options.FORCE_READERS = 1;
+    }
+    if (options.FORCE_READERS > 1 &&
+        options.FORCE_READERS > (size_t) mpi_size - options.IO_SERVERS) {
+        log_warn("FORCE_READERS is larger than the number of compute "
+                 "processes.  Setting FORCE_READERS to %zu.",
+                 (size_t) mpi_size - options.IO_SERVERS);
+        options.FORCE_READERS = (size_t) mpi_size - options.IO_SERVERS;
+    }
+    if (options.FORCE_READERS > 1 &&
+        (options.PARALLEL_IO || options.FORCE_PREFETCH ||
+         options.FORCE_PRECISION == FORCE_PRECISION_SINGLE)) {
+        // the readers read the whole field in double precision on the main
+        // thread
+        log_warn("FORCE_READERS is not supported with PARALLEL_IO, "
+                 "FORCE_PREFETCH or FORCE_PRECISION = SINGLE.  Setting "
+                 "FORCE_READERS to 1.");
+        options.FORCE_READERS = 1;
+    }
+    if (options.IO_SERVERS > 0 && options.ASYNC_OUTPUT) {
+        log_warn("ASYNC_OUTPUT is not needed with IO_SERVERS > 0.  Setting "
+                 "ASYNC_OUTPUT to FALSE.");
+        options.ASYNC_OUTPUT = false;
+    }
+    if (options.IO_SERVERS > 0 && options.HIERARCHICAL_IO) {
+        // the I/O servers leave MPI_COMM_VIC after the initialization
+        log_warn("HIERARCHICAL_IO is not supported with IO_SERVERS > 0.  "
+                 "Setting HIERARCHICAL_IO to FALSE.");
+        options.HIERARCHICAL_IO = false;
+    }
+    if (options.OUT_LAYOUT == OUT_LAYOUT_LAND &&
+        (options.PARALLEL_IO || options.ASYNC_OUTPUT ||
+         options.IO_SERVERS > 0)) {
+        // these write the history files on the full grid
+        log_warn("OUT_LAYOUT = LAND is not supported with PARALLEL_IO, "
+                 "ASYNC_OUTPUT or IO_SERVERS.  Setting OUT_LAYOUT to GRID.");
+        options.OUT_LAYOUT = OUT_LAYOUT_GRID;
+    }
+    if (options.OUT_SPLIT > 0 &&
+        (options.PARALLEL_IO || options.ASYNC_OUTPUT ||
+         options.IO_SERVERS > 0)) {
+        // these write one history file per stream
+        log_warn("OUT_SPLIT is not supported with PARALLEL_IO, ASYNC_OUTPUT "
+                 "or IO_SERVERS.  Setting OUT_SPLIT to 0.");
+        options.OUT_SPLIT = 0;
+    }
+    if (options.COMPRESS_THREADS > 0 &&
+        (options.PARALLEL_IO || options.ASYNC_OUTPUT ||
+         options.IO_SERVERS > 0)) {
+        // these write the history files through the netCDF library
+        log_warn("COMPRESS_THREADS is not supported with PARALLEL_IO, "
+                 "ASYNC_OUTPUT or IO_SERVERS.  Setting COMPRESS_THREADS to "
+                 "0.");
+        options.COMPRESS_THREADS = 0;
+    }
+    if (options.DISTRIBUTED_DOMAIN &&
+        options.DECOMPOSITION != DECOMP_COST_WEIGHTED) {
+        // the processes get blocks of consecutive active cells
+        log_warn("DISTRIBUTED_DOMAIN = TRUE decomposes the domain into "
+                 "blocks of consecutive active cells.  Setting "
+                 "DECOMPOSITION to COST_WEIGHTED.");
+        options.DECOMPOSITION = DECOMP_COST_WEIGHTED;
+    }
+    if (options.PARALLEL_IO && options.DECOMPOSITION == DECOMP_ROUND_ROBIN) {
+        log_warn("PARALLEL_IO = TRUE with DECOMPOSITION = ROUND_ROBIN reads "
+                 "and writes every grid cell separately.  Use DECOMPOSITION "
+                 "= COST_WEIGHTED for contiguous blocks of cells.");
+    }
+
+    // the buffer of the log only applies to the log files of the processes
+    if (options.LOG_BUFFER > 0 && strcmp(filenames.log_path, "MISSING") == 0) {
+        log_warn("LOG_BUFFER has no effect without LOG_DIR.  Setting "
+                 "LOG_BUFFER to 0.");
+        options.LOG_BUFFER = 0;
+    }
+
+    // Validate the checkpoint
+    if (strcasecmp(filenames.checkpoint, "MISSING") != 0) {
+        // the history files are written by one process of the domain
+        if (options.PARALLEL_IO || options.IO_SERVERS > 0) {
+            log_err("CHECKPOINT is not supported with PARALLEL_IO = TRUE or "
+                    "IO_SERVERS > 0.");
+        }
+    }
+
+    // Validate the staging of the forcing files
+    if (strcasecmp(filenames.force_stage, "MISSING") != 0 &&
+        (options.PARALLEL_IO || options.FORCE_PREFETCH)) {
+        // these read the forcing files from the shared file system directly
+        log_warn("FORCE_STAGE_DIR is not supported with PARALLEL_IO or "
+                 "FORCE_PREFETCH.  Reading the forcing files from their "
+                 "original location.");
+        strcpy(filenames.force_stage, "MISSING");
+    }
+
+    // Validate the balance checks
+    if (options.BALANCE_CHECK_N == 0) {
+        log_err("BALANCE_CHECK_N must be at least 1.");
+    }
+
+    // Validate the data assimilation channel
+    if ((strcasecmp(filenames.da_port, "MISSING") != 0) !=
+        (options.DA_STEPS > 0)) {
+        log_err("DA_PORT and DA_STEPS must be set together.");
+    }
+    if (options.DA_STEPS > 0 && options.LAKES) {
+        log_err("DA_STEPS is not supported with LAKES = TRUE.");
+    }
+
+    // Validate the spin-up
+    if (global_param.spinup_cycles > 0) {
+        if (global_param.spinup_years < 1) {
+            log_err("SPINUP_YEARS must be at least 1.");
+        }
+        if (global_param.spinup_tol < 0.) {
+            log_err("SPINUP_TOL must not be negative.");
+        }
+        if (global_param.spinup_block_steps < 1) {
+            log_err("SPINUP_BLOCK_STEPS must be at least 1.");
+        }
+    }
+
     // Default file formats (if unset)
     if (options.SAVE_STATE && options.STATE_FORMAT == UNSET_FILE_FORMAT) {
         options.STATE_FORMAT = NETCDF4_CLASSIC;
     }
+    if (options.STATE_INCREMENTAL && options.STATE_FORMAT != BINARY_FAST) {
+        log_err("STATE_INCREMENTAL requires STATE_FORMAT BINARY_FAST.");
+    }
+    if (options.STATE_ASYNC && options.STATE_FORMAT != BINARY_FAST) {
+        // the netCDF state file is gathered with MPI on the main thread
+        log_warn("STATE_ASYNC is only supported with STATE_FORMAT "
+                 "BINARY_FAST.  Setting STATE_ASYNC to FALSE.");
+        options.STATE_ASYNC = false;
+    }
 
     /*********************************
        Output major options
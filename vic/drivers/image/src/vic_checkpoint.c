@@ -0,0 +1,340 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Checkpoints of a preempted run.
+ *
+ * With CHECKPOINT, a SIGTERM or SIGUSR1 (e.g. the notice of a preemptible or
+ * spot node, or of the end of a batch allocation) makes the image driver
+ * finish the current time step, write a checkpoint and stop. The checkpoint
+ * consists of a BINARY_FAST state file of the model state of every process
+ * and a stream file of every process with the aggregation buffers and alarms
+ * of the output streams, the positions in the history files and the offsets
+ * into the forcing files.
+ *
+ * A run with the same global parameter file that finds a complete
+ * checkpoint resumes after the time step of the checkpoint, without a
+ * spin-up. The history files of the records in progress are reopened and
+ * continued, so that the history files are the same as if the run had not
+ * been stopped. The checkpoint files are removed when the run completes.
+ *
+ * The signal only sets a flag. The processes agree on the flag at the end of
+ * each time step, since a signal may not reach all processes.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+#include <signal.h>
+
+static volatile sig_atomic_t checkpoint_signal = 0;
+
+/******************************************************************************
+ * @brief    Signal handler: ask for a checkpoint at the end of the time step.
+ *****************************************************************************/
+static void
+handle_checkpoint_signal(int signum)
+{
+    checkpoint_signal = signum;
+}
+
+/******************************************************************************
+ * @brief    Name of the stream file of the checkpoint of the local node.
+ *****************************************************************************/
+static void
+get_checkpoint_filename(char *filename,
+                        bool  tmp)
+{
+    extern filenames_struct filenames;
+    extern int              mpi_rank;
+
+    snprintf(filename, MAXSTRING, "%s.streams.%04d%s", filenames.checkpoint,
+             mpi_rank, tmp ? ".tmp" : "");
+}
+
+/******************************************************************************
+ * @brief    Write to the stream file of a checkpoint.
+ *****************************************************************************/
+static void
+write_checkpoint(const void *ptr,
+                 size_t      size,
+                 size_t      nmemb,
+                 FILE       *fp,
+                 char       *filename)
+{
+    if (fwrite(ptr, size, nmemb, fp) != nmemb) {
+        log_err("Error writing checkpoint file %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read from the stream file of a checkpoint.
+ *****************************************************************************/
+static void
+read_checkpoint(void   *ptr,
+                size_t  size,
+                size_t  nmemb,
+                FILE   *fp,
+                char   *filename)
+{
+    if (fread(ptr, size, nmemb, fp) != nmemb) {
+        log_err("Error reading checkpoint file %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Install the checkpoint signal handlers.
+ *****************************************************************************/
+void
+initialize_checkpoint(void)
+{
+    extern filenames_struct filenames;
+
+    struct sigaction        action;
+
+    if (strcasecmp(filenames.checkpoint, "MISSING") == 0) {
+        return;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_checkpoint_signal;
+    sigemptyset(&(action.sa_mask));
+    if (sigaction(SIGTERM, &action, NULL) != 0 ||
+        sigaction(SIGUSR1, &action, NULL) != 0) {
+        log_err("Could not install the checkpoint signal handlers");
+    }
+}
+
+/******************************************************************************
+ * @brief    Check whether any process received a checkpoint signal.
+ * @details  Called by all processes at the end of each time step.
+ *****************************************************************************/
+bool
+check_checkpoint_signal(void)
+{
+    extern size_t           current;
+    extern filenames_struct filenames;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern int              mpi_rank;
+
+    int                     signum;
+    int                     status;
+
+    if (strcasecmp(filenames.checkpoint, "MISSING") == 0) {
+        return false;
+    }
+
+    signum = (int) checkpoint_signal;
+    status = MPI_Allreduce(MPI_IN_PLACE, &signum, 1, MPI_INT, MPI_MAX,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    if (signum != 0 && mpi_rank == VIC_MPI_ROOT) {
+        log_info("Received signal %d, writing a checkpoint after time step "
+                 "%zu", signum, current);
+    }
+
+    return (signum != 0);
+}
+
+/******************************************************************************
+ * @brief    Write a checkpoint at the end of the current time step.
+ * @details  The records of the history files are completed first. The
+ *           stream file is written last and under a temporary name, so that
+ *           only a complete checkpoint is found by restore_checkpoint().
+ *****************************************************************************/
+void
+vic_checkpoint(void)
+{
+    extern size_t              current;
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern int                 mpi_rank;
+    extern rout_struct         rout;
+
+    checkpoint_header_struct   header;
+    char                       filename[MAXSTRING];
+    char                       tmp_filename[MAXSTRING];
+    dmy_struct                 dmy_next;
+    FILE                      *fp;
+    size_t                     i;
+    int                        status;
+
+    // the history files hold all records written so far
+    progress_history_records();
+    if (options.ASYNC_OUTPUT) {
+        wait_async_output();
+    }
+
+    // a stream file only exists next to a complete state file
+    get_checkpoint_filename(filename, false);
+    get_checkpoint_filename(tmp_filename, true);
+    remove(filename);
+    status = MPI_Barrier(MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    dmy_from_step(&global_param, current + 1, &dmy_next);
+    vic_store_fast(&dmy_next, filenames.checkpoint);
+    wait_async_state();
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.mpi_rank = mpi_rank;
+    header.ncells = local_domain.ncells_active;
+    header.next_step = current + 1;
+    for (i = 0; i < 2; i++) {
+        header.forceoffset[i] = global_param.forceoffset[i];
+        header.forceskip[i] = global_param.forceskip[i];
+    }
+
+    fp = fopen(tmp_filename, "wb");
+    if (fp == NULL) {
+        log_err("Unable to open checkpoint file %s", tmp_filename);
+    }
+    write_checkpoint(&header, sizeof(header), 1, fp, tmp_filename);
+    write_stream_state(fp, tmp_filename);
+    if (fclose(fp) != 0) {
+        log_err("Error closing checkpoint file %s", tmp_filename);
+    }
+    if (rename(tmp_filename, filename) != 0) {
+        log_err("Unable to rename checkpoint file %s to %s", tmp_filename,
+                filename);
+    }
+
+    status = MPI_Barrier(MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (mpi_rank == VIC_MPI_ROOT) {
+        log_info("Checkpoint written to %s, run VIC again with the same "
+                 "global parameter file to resume at time step %zu",
+                 filenames.checkpoint, current + 1);
+        if (rout.active) {
+            log_warn("The channel storage of the inline routing is not "
+                     "saved, the resumed run starts with empty channels");
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Resume from a checkpoint, if there is one.
+ * @details  Called after the output streams are initialized. Returns the
+ *           first time step to run, 0 if there is no checkpoint.
+ *****************************************************************************/
+size_t
+restore_checkpoint(void)
+{
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern domain_struct       local_domain;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern int                 mpi_rank;
+
+    checkpoint_header_struct   header;
+    char                       filename[MAXSTRING];
+    FILE                      *fp;
+    size_t                     i;
+    int                        found[2];
+    int                        status;
+
+    if (strcasecmp(filenames.checkpoint, "MISSING") == 0) {
+        return 0;
+    }
+
+    get_checkpoint_filename(filename, false);
+    fp = fopen(filename, "rb");
+
+    // all processes must find their part of the checkpoint
+    found[0] = (fp != NULL);
+    found[1] = -found[0];
+    status = MPI_Allreduce(MPI_IN_PLACE, found, 2, MPI_INT, MPI_MIN,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (found[0] == 0 && found[1] < 0) {
+        log_err("The checkpoint %s is incomplete", filenames.checkpoint);
+    }
+    if (found[0] == 0) {
+        return 0;
+    }
+
+    read_checkpoint(&header, sizeof(header), 1, fp, filename);
+    if (strncmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION) {
+        log_err("%s is not a checkpoint file of this version of VIC",
+                filename);
+    }
+    if (header.mpi_rank != mpi_rank ||
+        header.ncells != local_domain.ncells_active ||
+        header.next_step >= global_param.nrecs) {
+        log_err("Checkpoint file %s was written by a different run",
+                filename);
+    }
+
+    // the model state
+    vic_restore_fast_file(filenames.checkpoint);
+
+    for (i = 0; i < 2; i++) {
+        global_param.forceoffset[i] = header.forceoffset[i];
+        global_param.forceskip[i] = header.forceskip[i];
+    }
+
+    // the output streams and the history files of their current records
+    read_stream_state(fp, filename, true);
+    if (fclose(fp) != 0) {
+        log_err("Error closing checkpoint file %s", filename);
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        log_info("Resuming from checkpoint %s at time step %zu",
+                 filenames.checkpoint, header.next_step);
+    }
+
+    return header.next_step;
+}
+
+/******************************************************************************
+ * @brief    Remove the checkpoint files once the run is complete.
+ *****************************************************************************/
+void
+finalize_checkpoint(void)
+{
+    extern size_t              current;
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern domain_struct       local_domain;
+    extern int                 mpi_rank;
+
+    char                       filename[MAXSTRING];
+
+    if (strcasecmp(filenames.checkpoint, "MISSING") == 0 ||
+        current < global_param.nrecs) {
+        return;
+    }
+
+    get_checkpoint_filename(filename, false);
+    remove(filename);
+    if (local_domain.ncells_active > 0) {
+        snprintf(filename, MAXSTRING, "%s.%04d", filenames.checkpoint,
+                 mpi_rank);
+        remove(filename);
+    }
+}
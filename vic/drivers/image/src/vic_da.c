@@ -0,0 +1,482 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Data assimilation channel.
+ *
+ * With DA_PORT and DA_STEPS, the image driver connects to a data
+ * assimilation program (e.g. an ensemble Kalman filter) through an MPI
+ * intercommunicator, instead of stopping and restarting from state files
+ * for every analysis. The assimilation program opens an MPI port
+ * (MPI_Open_port) and writes the name of the port to the DA_PORT file before
+ * VIC starts; all VIC processes connect to it with MPI_Comm_connect.
+ *
+ * Every DA_STEPS time steps, VIC pauses after the state of the time step is
+ * complete and sends the state variables of all active cells, waits for the
+ * analysis and applies it before the next time step. Only the master node
+ * exchanges messages with the first process of the assimilation program:
+ *
+ * - on connection, DA_TAG_HEADER: int {DA_VERSION, ncells, Nlayer,
+ *   SNOW_BAND}, then DA_TAG_CELLS: int [ncells], the index of each active
+ *   cell in the grid of the domain file;
+ * - at each analysis time, DA_TAG_STATE: double [1 + nfields * ncells], the
+ *   time at the end of the time step (in the time units of the history
+ *   files) followed by the fields, each for all active cells: the grid cell
+ *   mean soil moisture of each layer (mm), then the mean snow water
+ *   equivalent of each elevation band (mm);
+ * - the assimilation program answers with DA_TAG_UPDATE: double
+ *   [nfields * ncells], the analysis of the fields (NaN = no update of a
+ *   field of a cell), or with an empty DA_TAG_KEEP message;
+ * - at the end of the run, an empty DA_TAG_END message.
+ *
+ * The analysis of the soil moisture is added to the moisture of every tile
+ * as the increment of the grid cell mean, within the ice content and the
+ * maximum moisture of the layer. The snow packs of every tile of a band are
+ * scaled by the ratio of the analysis and the band mean; snow is not created
+ * in a band that has none.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+
+static MPI_Comm da_comm = MPI_COMM_NULL;
+
+/******************************************************************************
+ * @brief    Number of state fields exchanged with the assimilation program.
+ *****************************************************************************/
+static size_t
+get_da_nfields(void)
+{
+    extern option_struct options;
+
+    return options.Nlayer + options.SNOW_BAND;
+}
+
+/******************************************************************************
+ * @brief    Grid cell means of the state fields of the local cells.
+ * @details  state[f * ncells + i] holds field f of local cell i.
+ *****************************************************************************/
+static void
+get_da_state(double *state)
+{
+    extern all_vars_struct    *all_vars;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_map_struct *veg_con_map;
+
+    size_t                     ncells;
+    size_t                     i;
+    size_t                     j;
+    size_t                     k;
+    size_t                     m;
+    int                        v;
+    double                     w;
+    double                     wsum;
+    double                     sum;
+
+    ncells = local_domain.ncells_active;
+    for (i = 0; i < ncells; i++) {
+        // soil moisture of each layer, over the tiles and bands
+        for (j = 0; j < options.Nlayer; j++) {
+            sum = 0.;
+            wsum = 0.;
+            for (m = 0; m < options.NVEGTYPES; m++) {
+                v = veg_con_map[i].vidx[m];
+                if (v < 0) {
+                    continue;
+                }
+                for (k = 0; k < options.SNOW_BAND; k++) {
+                    w = veg_con_map[i].Cv[m] * soil_con[i].AreaFract[k];
+                    sum += w * all_vars[i].cell[v][k].layer[j].moist;
+                    wsum += w;
+                }
+            }
+            state[j * ncells + i] = (wsum > 0.) ? sum / wsum : 0.;
+        }
+        // snow water equivalent of each band, over the tiles
+        for (k = 0; k < options.SNOW_BAND; k++) {
+            sum = 0.;
+            wsum = 0.;
+            for (m = 0; m < options.NVEGTYPES; m++) {
+                v = veg_con_map[i].vidx[m];
+                if (v < 0) {
+                    continue;
+                }
+                w = veg_con_map[i].Cv[m];
+                sum += w * all_vars[i].snow[v][k].swq * MM_PER_M;
+                wsum += w;
+            }
+            state[(options.Nlayer + k) * ncells + i] =
+                (wsum > 0.) ? sum / wsum : 0.;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Apply the analysis of the state fields to the local cells.
+ * @details  state holds the grid cell means before the analysis, see
+ *           get_da_state().
+ *
+ * @return   number of bands of the local cells where the analysis asks for
+ *           snow that cannot be created
+ *****************************************************************************/
+static size_t
+apply_da_update(double *state,
+                double *update)
+{
+    extern all_vars_struct    *all_vars;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_map_struct *veg_con_map;
+
+    layer_data_struct         *layer;
+    snow_data_struct          *snow;
+    size_t                     ncells;
+    size_t                     nskipped = 0;
+    size_t                     i;
+    size_t                     j;
+    size_t                     k;
+    size_t                     m;
+    size_t                     p;
+    size_t                     f;
+    int                        v;
+    double                     delta;
+    double                     ratio;
+    double                     min_moist;
+
+    ncells = local_domain.ncells_active;
+    for (i = 0; i < ncells; i++) {
+        // increment of the soil moisture of each layer
+        for (j = 0; j < options.Nlayer; j++) {
+            f = j * ncells + i;
+            if (isnan(update[f])) {
+                continue;
+            }
+            delta = update[f] - state[f];
+            for (m = 0; m < options.NVEGTYPES; m++) {
+                v = veg_con_map[i].vidx[m];
+                if (v < 0) {
+                    continue;
+                }
+                for (k = 0; k < options.SNOW_BAND; k++) {
+                    layer = &(all_vars[i].cell[v][k].layer[j]);
+                    min_moist = 0.;
+                    for (p = 0; p < options.Nfrost; p++) {
+                        if (layer->ice[p] > min_moist) {
+                            min_moist = layer->ice[p];
+                        }
+                    }
+                    layer->moist += delta;
+                    if (layer->moist > soil_con[i].max_moist[j]) {
+                        layer->moist = soil_con[i].max_moist[j];
+                    }
+                    if (layer->moist < min_moist) {
+                        layer->moist = min_moist;
+                    }
+                }
+            }
+        }
+        // ratio of the snow water equivalent of each band
+        for (k = 0; k < options.SNOW_BAND; k++) {
+            f = (options.Nlayer + k) * ncells + i;
+            if (isnan(update[f])) {
+                continue;
+            }
+            if (state[f] <= 0.) {
+                if (update[f] > 0.) {
+                    nskipped++;
+                }
+                continue;
+            }
+            ratio = (update[f] > 0.) ? update[f] / state[f] : 0.;
+            for (m = 0; m < options.NVEGTYPES; m++) {
+                v = veg_con_map[i].vidx[m];
+                if (v < 0) {
+                    continue;
+                }
+                snow = &(all_vars[i].snow[v][k]);
+                snow->swq *= ratio;
+                snow->depth *= ratio;
+                snow->pack_water *= ratio;
+                snow->surf_water *= ratio;
+                if (snow->swq <= 0.) {
+                    snow->coverage = 0.;
+                }
+            }
+        }
+    }
+
+    return nskipped;
+}
+
+/******************************************************************************
+ * @brief    Gather a field of the local cells in the order of the active
+ *           cells of the domain on the master node.
+ *****************************************************************************/
+static void
+gather_da_field(double *var,
+                double *dvar,
+                double *nodes)
+{
+    extern domain_struct global_domain;
+    extern size_t       *mpi_map_mapping_array;
+    extern int           mpi_rank;
+
+    size_t               i;
+
+    gather_field_double(var, nodes);
+    if (mpi_rank == VIC_MPI_ROOT) {
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            dvar[mpi_map_mapping_array[i]] = nodes[i];
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Scatter a field in the order of the active cells of the domain
+ *           from the master node to the local cells.
+ *****************************************************************************/
+static void
+scatter_da_field(double *dvar,
+                 double *var,
+                 double *nodes)
+{
+    extern domain_struct global_domain;
+    extern domain_struct local_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern size_t       *mpi_map_mapping_array;
+    extern int          *mpi_map_global_array_offsets;
+    extern int          *mpi_map_local_array_sizes;
+    extern int           mpi_rank;
+
+    size_t               i;
+    int                  status;
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            nodes[i] = dvar[mpi_map_mapping_array[i]];
+        }
+    }
+    status = MPI_Scatterv(nodes, mpi_map_local_array_sizes,
+                          mpi_map_global_array_offsets, MPI_DOUBLE, var,
+                          (int) local_domain.ncells_active, MPI_DOUBLE,
+                          VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+}
+
+/******************************************************************************
+ * @brief    Connect to the data assimilation program.
+ * @details  Called by all compute processes before the time loop.
+ *****************************************************************************/
+void
+initialize_da(void)
+{
+    extern filenames_struct filenames;
+    extern domain_struct    global_domain;
+    extern option_struct    options;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern int              mpi_rank;
+
+    char                    port[MPI_MAX_PORT_NAME];
+    int                     header[4];
+    int                    *cells;
+    FILE                   *fp;
+    size_t                  i;
+    int                     status;
+
+    if (options.DA_STEPS == 0) {
+        return;
+    }
+
+    port[0] = '\0';
+    if (mpi_rank == VIC_MPI_ROOT) {
+        fp = fopen(filenames.da_port, "r");
+        if (fp == NULL) {
+            log_err("Unable to open DA_PORT file %s", filenames.da_port);
+        }
+        if (fgets(port, sizeof(port), fp) == NULL) {
+            log_err("DA_PORT file %s holds no MPI port name",
+                    filenames.da_port);
+        }
+        fclose(fp);
+        port[strcspn(port, "\r\n")] = '\0';
+        log_info("Connecting to the data assimilation program at MPI port %s",
+                 port);
+    }
+    status = MPI_Comm_connect(port, MPI_INFO_NULL, VIC_MPI_ROOT,
+                              MPI_COMM_VIC, &da_comm);
+    check_mpi_status(status, "MPI error.");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        header[0] = DA_VERSION;
+        header[1] = (int) global_domain.ncells_active;
+        header[2] = (int) options.Nlayer;
+        header[3] = (int) options.SNOW_BAND;
+        status = MPI_Send(header, 4, MPI_INT, 0, DA_TAG_HEADER, da_comm);
+        check_mpi_status(status, "MPI error.");
+
+        cells = malloc(global_domain.ncells_active * sizeof(*cells));
+        check_alloc_status(cells, "Memory allocation error.");
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            cells[global_domain.locations[i].global_idx] =
+                (int) global_domain.locations[i].io_idx;
+        }
+        status = MPI_Send(cells, (int) global_domain.ncells_active, MPI_INT,
+                          0, DA_TAG_CELLS, da_comm);
+        check_mpi_status(status, "MPI error.");
+        free(cells);
+    }
+}
+
+/******************************************************************************
+ * @brief    Exchange the state with the data assimilation program.
+ * @details  Called by all compute processes at the end of each time step.
+ *           Every DA_STEPS time steps, the state is sent and the analysis is
+ *           applied before the next time step.
+ *****************************************************************************/
+void
+vic_da(void)
+{
+    extern size_t              current;
+    extern global_param_struct global_param;
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern int                 mpi_rank;
+
+    MPI_Status                 mpi_status;
+    dmy_struct                 dmy_next;
+    double                    *state;
+    double                    *update;
+    double                    *dvar = NULL;
+    double                    *nodes = NULL;
+    size_t                     nfields;
+    size_t                     ncells;
+    size_t                     nskipped;
+    size_t                     i;
+    int                        count;
+    int                        keep;
+    int                        status;
+
+    if (options.DA_STEPS == 0 || (current + 1) % options.DA_STEPS != 0) {
+        return;
+    }
+
+    nfields = get_da_nfields();
+    ncells = local_domain.ncells_active;
+    state = malloc((nfields * ncells + 1) * sizeof(*state));
+    check_alloc_status(state, "Memory allocation error.");
+    update = malloc((nfields * ncells + 1) * sizeof(*update));
+    check_alloc_status(update, "Memory allocation error.");
+    if (mpi_rank == VIC_MPI_ROOT) {
+        dvar = malloc((1 + nfields * global_domain.ncells_active) *
+                      sizeof(*dvar));
+        check_alloc_status(dvar, "Memory allocation error.");
+        nodes = malloc(global_domain.ncells_active * sizeof(*nodes));
+        check_alloc_status(nodes, "Memory allocation error.");
+    }
+
+    get_da_state(state);
+    for (i = 0; i < nfields; i++) {
+        gather_da_field(state + i * ncells,
+                        (dvar != NULL) ?
+                        dvar + 1 + i * global_domain.ncells_active : NULL,
+                        nodes);
+    }
+
+    keep = 0;
+    if (mpi_rank == VIC_MPI_ROOT) {
+        // the time at the end of the time step
+        dmy_from_step(&global_param, current + 1, &dmy_next);
+        dvar[0] = date2num(global_param.time_origin_num, &dmy_next, 0.,
+                           global_param.calendar, global_param.time_units);
+        status = MPI_Send(dvar,
+                          (int) (1 + nfields * global_domain.ncells_active),
+                          MPI_DOUBLE, 0, DA_TAG_STATE, da_comm);
+        check_mpi_status(status, "MPI error.");
+
+        status = MPI_Recv(dvar + 1,
+                          (int) (nfields * global_domain.ncells_active),
+                          MPI_DOUBLE, 0, MPI_ANY_TAG, da_comm, &mpi_status);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Get_count(&mpi_status, MPI_DOUBLE, &count);
+        check_mpi_status(status, "MPI error.");
+        if (mpi_status.MPI_TAG == DA_TAG_KEEP) {
+            keep = 1;
+        }
+        else if (mpi_status.MPI_TAG != DA_TAG_UPDATE ||
+                 count != (int) (nfields * global_domain.ncells_active)) {
+            log_err("Unexpected message from the data assimilation program "
+                    "(tag %d, %d values)", mpi_status.MPI_TAG, count);
+        }
+    }
+    status = MPI_Bcast(&keep, 1, MPI_INT, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    if (!keep) {
+        for (i = 0; i < nfields; i++) {
+            scatter_da_field((dvar != NULL) ?
+                             dvar + 1 + i * global_domain.ncells_active : NULL,
+                             update + i * ncells, nodes);
+        }
+        nskipped = apply_da_update(state, update);
+        status = MPI_Reduce(mpi_rank == VIC_MPI_ROOT ? MPI_IN_PLACE :
+                            &nskipped, &nskipped, 1, MPI_AINT, MPI_SUM,
+                            VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        if (mpi_rank == VIC_MPI_ROOT && nskipped > 0) {
+            log_warn("The analysis after time step %zu adds snow to %zu "
+                     "elevation bands without snow, which is not applied",
+                     current, nskipped);
+        }
+    }
+
+    free(state);
+    free(update);
+    free(dvar);
+    free(nodes);
+}
+
+/******************************************************************************
+ * @brief    Disconnect from the data assimilation program.
+ *****************************************************************************/
+void
+finalize_da(void)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+    extern int      mpi_rank;
+
+    int             status;
+
+    if (da_comm == MPI_COMM_NULL) {
+        return;
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        status = MPI_Send(NULL, 0, MPI_DOUBLE, 0, DA_TAG_END, da_comm);
+        check_mpi_status(status, "MPI error.");
+    }
+    status = MPI_Comm_disconnect(&da_comm);
+    check_mpi_status(status, "MPI error.");
+}
@@ -26,6 +26,71 @@
 
 #include <vic_driver_image.h>
 
+static force_workspace_struct force_workspace;
+
+// month of the climatological vegetation parameters in veg_hist
+static unsigned short veg_hist_month = 0;
+
+/******************************************************************************
+ * @brief    Allocate and initialize the persistent workspace of vic_force.
+ *****************************************************************************/
+void
+vic_force_init(void)
+{
+    extern size_t           NF;
+    extern domain_struct    local_domain;
+    extern option_struct    options;
+    extern soil_con_struct *soil_con;
+
+    double                 *Tfactor;
+    size_t                  i;
+    size_t                  band;
+
+    force_workspace.dvar = malloc(MAX_FORCE_FIELDS * NF *
+                                  local_domain.ncells_active *
+                                  sizeof(*force_workspace.dvar));
+    check_alloc_status(force_workspace.dvar, "Memory allocation error.");
+    force_workspace.t_offset = malloc(local_domain.ncells_active *
+                                      sizeof(*force_workspace.t_offset));
+    check_alloc_status(force_workspace.t_offset, "Memory allocation error.");
+
+    // the snow flag uses the coldest elevation band of each cell
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (options.SNOW_BAND > 1) {
+            Tfactor = soil_con[i].Tfactor;
+            force_workspace.t_offset[i] = Tfactor[0];
+            for (band = 1; band < options.SNOW_BAND; band++) {
+                if (Tfactor[band] < force_workspace.t_offset[i]) {
+                    force_workspace.t_offset[i] = Tfactor[band];
+                }
+            }
+        }
+        else {
+            force_workspace.t_offset[i] = 0;
+        }
+    }
+
+    // the decomposition of the domain on the forcing readers
+    vic_force_readers_init();
+
+    // the staging of the forcing files on a local directory
+    vic_force_stage_init();
+}
+
+/******************************************************************************
+ * @brief    Free the persistent workspace of vic_force.
+ *****************************************************************************/
+void
+vic_force_finalize(void)
+{
+    free(force_workspace.dvar);
+    free(force_workspace.t_offset);
+    force_workspace.dvar = NULL;
+    force_workspace.t_offset = NULL;
+    vic_force_readers_finalize();
+    vic_force_stage_finalize();
+}
+
 /******************************************************************************
  * @brief    Read atmospheric forcing data.
  *****************************************************************************/
@@ -36,219 +101,269 @@ vic_force(void)
     extern size_t              NR;
     extern size_t              current;
     extern force_data_struct  *force;
-    extern dmy_struct         *dmy;
+    extern dmy_struct          dmy_current;
     extern domain_struct       global_domain;
     extern domain_struct       local_domain;
     extern filenames_struct    filenames;
     extern global_param_struct global_param;
     extern option_struct       options;
-    extern soil_con_struct    *soil_con;
+    extern solar_geom_struct  *solar_geom;
     extern veg_con_map_struct *veg_con_map;
     extern veg_con_struct    **veg_con;
     extern veg_hist_struct   **veg_hist;
     extern parameters_struct   param;
     extern param_set_struct    param_set;
-
-    double                    *t_offset = NULL;
-    double                    *dvar = NULL;
+    extern timer_struct        global_timers[N_TIMERS];
+
+    double                    *t_offset;
+    double                    *dvar;
+    double                    *fvar;
+    double                    *field_vars[MAX_FORCE_FIELDS];
+    char                      *field_names[MAX_FORCE_FIELDS];
+    int                        field_types[MAX_FORCE_FIELDS];
+    size_t                     nfields;
+    size_t                     k;
     size_t                     i;
     size_t                     j;
     size_t                     v;
-    size_t                     band;
+    size_t                     m;
     int                        vidx;
     size_t                     d3count[3];
     size_t                     d3start[3];
     size_t                     d4count[4];
     size_t                     d4start[4];
-    double                    *Tfactor;
-
-    // allocate memory for variables to be read
-    dvar = malloc(local_domain.ncells_active * sizeof(*dvar));
-    check_alloc_status(dvar, "Memory allocation error.");
+    double                     cosdecl;
+    double                     sindecl;
+    char                       nc_name[MAXSTRING];
+    char                       read_name[MAXSTRING];
+    size_t                     force_start;
+    dmy_struct                 dmy_previous;
+    bool                       new_year;
+    bool                       catalog;
+    bool                       update_veg_hist;
+
+    // the reader thread must be done before the netCDF files are touched
+    timer_continue(&(global_timers[TIMER_VIC_FORCE_READ]));
+    vic_force_prefetch_wait();
+    // the history writer thread may still be writing
+    lock_netcdf();
+    timer_stop(&(global_timers[TIMER_VIC_FORCE_READ]));
+
+    // variables are read for all NF sub-steps at once
+    dvar = force_workspace.dvar;
+    t_offset = force_workspace.t_offset;
+
+    // the forcing files restart every year
+    new_year = false;
+    if (current > 1) {
+        dmy_from_step(&global_param, current - 1, &dmy_previous);
+        new_year = (dmy_current.year != dmy_previous.year);
+    }
 
-    // for now forcing file is determined by the year
-    sprintf(filenames.forcing[0], "%s%4d.nc", filenames.f_path_pfx[0],
-            dmy[current].year);
+    // the forcing file is looked up in the catalog or determined by the year
+    catalog = get_force_catalog_record(&dmy_current, nc_name, &force_start);
+    if (!catalog) {
+        sprintf(nc_name, "%s%4d.nc", filenames.f_path_pfx[0],
+                dmy_current.year);
+    }
+    // the file may be read from its staged copy
+    get_staged_forcing_file(nc_name, dmy_current.year, read_name);
+    if (strcmp(read_name, filenames.forcing[0]) != 0) {
+        // the file of the previous year is no longer needed
+        close_nc_file(filenames.forcing[0]);
+        strcpy(filenames.forcing[0], read_name);
+    }
 
     // global_param.forceoffset[0] resets every year since the met file restarts
     // every year
     // global_param.forceskip[0] should also reset to 0 after the first year
-    if (current > 1 && (dmy[current].year != dmy[current - 1].year)) {
+    if (new_year) {
         global_param.forceoffset[0] = 0;
         global_param.forceskip[0] = 0;
     }
-
-    // only the time slice changes for the met file reads. The rest is constant
-    d3start[1] = 0;
-    d3start[2] = 0;
-    d3count[0] = 1;
-    d3count[1] = global_domain.n_ny;
-    d3count[2] = global_domain.n_nx;
-
-    // Air temperature: tas
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[AIR_TEMP].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].air_temp[j] = (double) dvar[i];
-        }
+    if (!catalog) {
+        force_start = global_param.forceskip[0] + global_param.forceoffset[0];
     }
 
-    // Precipitation: prcp
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[PREC].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].prec[j] = (double) dvar[i];
-        }
+    if (options.COMPUTE_BENCHMARK) {
+        // the sub-steps are generated in memory
+        vic_force_synthetic();
+        compute_solar_decl(dmy_current.day_in_year, &cosdecl, &sindecl);
     }
-
-    // Downward solar radiation: dswrf
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[SWDOWN].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].shortwave[j] = (double) dvar[i];
-        }
+    else if (options.FORCE_DISAGG) {
+        // the sub-steps are generated from the daily forcings
+        vic_force_disagg(force_start);
     }
-
-    // Downward longwave radiation: dlwrf
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[LWDOWN].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].longwave[j] = (double) dvar[i];
+    else {
+        // all NF sub-steps of all variables are read and scattered at once.
+        // The rest is constant
+        d3start[0] = force_start;
+        d3start[1] = 0;
+        d3start[2] = 0;
+        d3count[0] = NF;
+        d3count[1] = global_domain.n_ny;
+        d3count[2] = global_domain.n_nx;
+
+        // fields in the order in which they are copied below
+        nfields = 0;
+        field_types[nfields++] = AIR_TEMP;
+        field_types[nfields++] = PREC;
+        field_types[nfields++] = SWDOWN;
+        field_types[nfields++] = LWDOWN;
+        field_types[nfields++] = WIND;
+        field_types[nfields++] = VP;
+        field_types[nfields++] = PRESSURE;
+        if (options.LAKES) {
+            field_types[nfields++] = CHANNEL_IN;
         }
-    }
-
-    // Wind speed: wind
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[WIND].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].wind[j] = (double) dvar[i];
+        if (options.CARBON) {
+            field_types[nfields++] = CATM;
+            field_types[nfields++] = FDIR;
+            field_types[nfields++] = PAR;
         }
-    }
+        for (k = 0; k < nfields; k++) {
+            field_names[k] = param_set.TYPE[field_types[k]].varname;
+            field_vars[k] = dvar + k * NF * local_domain.ncells_active;
+        }
+        get_scatter_forcing_fields(0, filenames.forcing[0], nfields,
+                                   field_names, 3, d3start, d3count,
+                                   field_vars);
+        k = 0;
 
-    // vapor pressure: vp
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[VP].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].vp[j] = (double) dvar[i];
+        // Air temperature: tas
+        fvar = field_vars[k++];
+        for (j = 0; j < NF; j++) {
+            for (i = 0; i < local_domain.ncells_active; i++) {
+                force[i].air_temp[j] = fvar[j * local_domain.ncells_active + i];
+            }
         }
-    }
 
-    // Pressure: pressure
-    for (j = 0; j < NF; j++) {
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[PRESSURE].varname,
-                                    d3start, d3count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            force[i].pressure[j] = (double) dvar[i];
+        // Precipitation: prcp
+        fvar = field_vars[k++];
+        for (j = 0; j < NF; j++) {
+            for (i = 0; i < local_domain.ncells_active; i++) {
+                force[i].prec[j] = fvar[j * local_domain.ncells_active + i];
+            }
         }
-    }
-    // Optional inputs
-    if (options.LAKES) {
-        // Channel inflow to lake
-        d3start[0] = global_param.forceskip[0] + global_param.forceoffset[0] +
-                     j;
-        get_scatter_nc_field_double(filenames.forcing[0],
-                                    param_set.TYPE[CHANNEL_IN].varname,
-                                    d3start, d3count, dvar);
+
+        // Downward solar radiation: dswrf
+        fvar = field_vars[k++];
         for (j = 0; j < NF; j++) {
             for (i = 0; i < local_domain.ncells_active; i++) {
-                force[i].channel_in[j] = (double) dvar[i];
+                force[i].shortwave[j] =
+                    fvar[j * local_domain.ncells_active + i];
             }
         }
-    }
-    if (options.CARBON) {
-        // Atmospheric CO2 mixing ratio
+
+        // Downward longwave radiation: dlwrf
+        fvar = field_vars[k++];
         for (j = 0; j < NF; j++) {
-            d3start[0] = global_param.forceskip[0] +
-                         global_param.forceoffset[0] + j;
-            get_scatter_nc_field_double(filenames.forcing[0],
-                                        param_set.TYPE[CATM].varname,
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                force[i].Catm[j] = (double) dvar[i];
+                force[i].longwave[j] = fvar[j * local_domain.ncells_active + i];
             }
         }
-        // Cosine of solar zenith angle
+
+        // Wind speed: wind
+        fvar = field_vars[k++];
         for (j = 0; j < NF; j++) {
             for (i = 0; i < local_domain.ncells_active; i++) {
-                force[i].coszen[j] = compute_coszen(
-                    local_domain.locations[i].latitude,
-                    local_domain.locations[i].longitude,
-                    soil_con[i].time_zone_lng, dmy[current].day_in_year,
-                    dmy[current].dayseconds);
+                force[i].wind[j] = fvar[j * local_domain.ncells_active + i];
             }
         }
-        // Fraction of shortwave that is direct
+
+        // vapor pressure: vp
+        fvar = field_vars[k++];
         for (j = 0; j < NF; j++) {
-            d3start[0] = global_param.forceskip[0] +
-                         global_param.forceoffset[0] + j;
-            get_scatter_nc_field_double(filenames.forcing[0],
-                                        param_set.TYPE[FDIR].varname,
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                force[i].fdir[j] = (double) dvar[i];
+                force[i].vp[j] = fvar[j * local_domain.ncells_active + i];
             }
         }
-        // Photosynthetically active radiation
+
+        // Pressure: pressure
+        fvar = field_vars[k++];
         for (j = 0; j < NF; j++) {
-            d3start[0] = global_param.forceskip[0] +
-                         global_param.forceoffset[0] + j;
-            get_scatter_nc_field_double(filenames.forcing[0],
-                                        param_set.TYPE[PAR].varname,
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                force[i].par[j] = (double) dvar[i];
+                force[i].pressure[j] = fvar[j * local_domain.ncells_active + i];
+            }
+        }
+
+        // Optional inputs
+        if (options.LAKES) {
+            // Channel inflow to lake
+            fvar = field_vars[k++];
+            for (j = 0; j < NF; j++) {
+                for (i = 0; i < local_domain.ncells_active; i++) {
+                    force[i].channel_in[j] =
+                        fvar[j * local_domain.ncells_active + i];
+                }
+            }
+        }
+        if (options.CARBON) {
+            // Atmospheric CO2 mixing ratio
+            fvar = field_vars[k++];
+            for (j = 0; j < NF; j++) {
+                for (i = 0; i < local_domain.ncells_active; i++) {
+                    force[i].Catm[j] = fvar[j * local_domain.ncells_active + i];
+                }
+            }
+            // Fraction of shortwave that is direct
+            fvar = field_vars[k++];
+            for (j = 0; j < NF; j++) {
+                for (i = 0; i < local_domain.ncells_active; i++) {
+                    force[i].fdir[j] = fvar[j * local_domain.ncells_active + i];
+                }
+            }
+            // Photosynthetically active radiation
+            fvar = field_vars[k++];
+            for (j = 0; j < NF; j++) {
+                for (i = 0; i < local_domain.ncells_active; i++) {
+                    force[i].par[j] = fvar[j * local_domain.ncells_active + i];
+                }
+            }
+            // Cosine of solar zenith angle, the same for all sub-steps
+            compute_solar_decl(dmy_current.day_in_year, &cosdecl, &sindecl);
+            compute_coszen_cells(local_domain.ncells_active, solar_geom,
+                                 cosdecl, sindecl, dmy_current.dayseconds,
+                                 dvar);
+            for (j = 0; j < NF; j++) {
+                for (i = 0; i < local_domain.ncells_active; i++) {
+                    force[i].coszen[j] = dvar[i];
+                }
             }
         }
     }
 
     // Update the offset counter
-    global_param.forceoffset[0] += NF;
+    if (!options.FORCE_DISAGG) {
+        global_param.forceoffset[0] += NF;
+    }
 
     // Initialize the veg_hist structure with the current climatological
     // vegetation parameters.  This may be overwritten with the historical
-    // forcing time series.
-    for (i = 0; i < local_domain.ncells_active; i++) {
-        for (v = 0; v < options.NVEGTYPES; v++) {
-            vidx = veg_con_map[i].vidx[v];
-            if (vidx != NODATA_VEG) {
+    // forcing time series. The climatology is monthly, so unless the
+    // veg_hist files are read the structure only changes with the month.
+    // The first step always updates it, since the spin-up may have left the
+    // values of another step in it.
+    m = dmy_current.month - 1;
+    update_veg_hist = (current == 0 || dmy_current.month != veg_hist_month ||
+                       options.LAI_SRC == FROM_VEGHIST ||
+                       options.FCAN_SRC == FROM_VEGHIST ||
+                       options.ALB_SRC == FROM_VEGHIST);
+    veg_hist_month = dmy_current.month;
+    if (update_veg_hist) {
+        for (i = 0; i < local_domain.ncells_active; i++) {
+            for (vidx = 0; vidx < (int) veg_con_map[i].nv_classes; vidx++) {
                 for (j = 0; j < NF; j++) {
                     veg_hist[i][vidx].albedo[j] =
-                        veg_con[i][vidx].albedo[dmy[current].month - 1];
+                        veg_con[i][vidx].albedo[m];
                     veg_hist[i][vidx].displacement[j] =
-                        veg_con[i][vidx].displacement[dmy[current].month - 1];
+                        veg_con[i][vidx].displacement[m];
                     veg_hist[i][vidx].fcanopy[j] =
-                        veg_con[i][vidx].fcanopy[dmy[current].month - 1];
+                        veg_con[i][vidx].fcanopy[m];
                     veg_hist[i][vidx].LAI[j] =
-                        veg_con[i][vidx].LAI[dmy[current].month - 1];
+                        veg_con[i][vidx].LAI[m];
                     veg_hist[i][vidx].roughness[j] =
-                        veg_con[i][vidx].roughness[dmy[current].month - 1];
+                        veg_con[i][vidx].roughness[m];
                 }
             }
         }
@@ -259,36 +374,41 @@ vic_force(void)
         options.FCAN_SRC == FROM_VEGHIST ||
         options.ALB_SRC == FROM_VEGHIST) {
         // for now forcing file is determined by the year
-        sprintf(filenames.forcing[1], "%s%4d.nc", filenames.f_path_pfx[1],
-                dmy[current].year);
+        sprintf(nc_name, "%s%4d.nc", filenames.f_path_pfx[1],
+                dmy_current.year);
+        if (strcmp(nc_name, filenames.forcing[1]) != 0) {
+            close_nc_file(filenames.forcing[1]);
+            strcpy(filenames.forcing[1], nc_name);
+        }
 
         // global_param.forceoffset[1] resets every year since the met file restarts
         // every year
-        if (current > 1 && (dmy[current].year != dmy[current - 1].year)) {
+        if (new_year) {
             global_param.forceoffset[1] = 0;
         }
 
-        // only the time slice changes for the met file reads. The rest is constant
+        // all NF sub-steps of a variable are read and scattered at once. The
+        // rest is constant
+        d4start[0] = global_param.forceskip[1] + global_param.forceoffset[1];
         d4start[2] = 0;
         d4start[3] = 0;
-        d4count[0] = 1;
+        d4count[0] = NF;
         d4count[1] = 1;
         d4count[2] = global_domain.n_ny;
         d4count[3] = global_domain.n_nx;
 
         // Leaf Area Index: lai
         if (options.LAI_SRC == FROM_VEGHIST) {
-            for (j = 0; j < NF; j++) {
-                d4start[0] = global_param.forceskip[1] +
-                             global_param.forceoffset[1] + j;
-                for (v = 0; v < options.NVEGTYPES; v++) {
-                    d4start[1] = v;
-                    get_scatter_nc_field_double(filenames.forcing[1], "lai",
-                                                d4start, d4count, dvar);
+            for (v = 0; v < options.NVEGTYPES; v++) {
+                d4start[1] = v;
+                get_scatter_forcing_field(1, filenames.forcing[1], "lai", 4,
+                                          d4start, d4count, dvar);
+                for (j = 0; j < NF; j++) {
                     for (i = 0; i < local_domain.ncells_active; i++) {
                         vidx = veg_con_map[i].vidx[v];
                         if (vidx != NODATA_VEG) {
-                            veg_hist[i][vidx].LAI[j] = (double) dvar[i];
+                            veg_hist[i][vidx].LAI[j] =
+                                dvar[j * local_domain.ncells_active + i];
                         }
                     }
                 }
@@ -297,17 +417,16 @@ vic_force(void)
 
         // Partial veg cover fraction: fcov
         if (options.FCAN_SRC == FROM_VEGHIST) {
-            for (j = 0; j < NF; j++) {
-                d4start[0] = global_param.forceskip[1] +
-                             global_param.forceoffset[1] + j;
-                for (v = 0; v < options.NVEGTYPES; v++) {
-                    d4start[1] = v;
-                    get_scatter_nc_field_double(filenames.forcing[1], "fcov",
-                                                d4start, d4count, dvar);
+            for (v = 0; v < options.NVEGTYPES; v++) {
+                d4start[1] = v;
+                get_scatter_forcing_field(1, filenames.forcing[1], "fcov", 4,
+                                          d4start, d4count, dvar);
+                for (j = 0; j < NF; j++) {
                     for (i = 0; i < local_domain.ncells_active; i++) {
                         vidx = veg_con_map[i].vidx[v];
                         if (vidx != NODATA_VEG) {
-                            veg_hist[i][vidx].fcanopy[j] = (double) dvar[i];
+                            veg_hist[i][vidx].fcanopy[j] =
+                                dvar[j * local_domain.ncells_active + i];
                         }
                     }
                 }
@@ -316,17 +435,16 @@ vic_force(void)
 
         // Albedo: alb
         if (options.ALB_SRC == FROM_VEGHIST) {
-            for (j = 0; j < NF; j++) {
-                d4start[0] = global_param.forceskip[1] +
-                             global_param.forceoffset[1] + j;
-                for (v = 0; v < options.NVEGTYPES; v++) {
-                    d4start[1] = v;
-                    get_scatter_nc_field_double(filenames.forcing[1], "alb",
-                                                d4start, d4count, dvar);
+            for (v = 0; v < options.NVEGTYPES; v++) {
+                d4start[1] = v;
+                get_scatter_forcing_field(1, filenames.forcing[1], "alb", 4,
+                                          d4start, d4count, dvar);
+                for (j = 0; j < NF; j++) {
                     for (i = 0; i < local_domain.ncells_active; i++) {
                         vidx = veg_con_map[i].vidx[v];
                         if (vidx != NODATA_VEG) {
-                            veg_hist[i][vidx].albedo[j] = (double) dvar[i];
+                            veg_hist[i][vidx].albedo[j] =
+                                dvar[j * local_domain.ncells_active + i];
                         }
                     }
                 }
@@ -336,27 +454,16 @@ vic_force(void)
         // Update the offset counter
         global_param.forceoffset[1] += NF;
     }
+    unlock_netcdf();
 
-
-    // allocate memory for t_offset
-    t_offset = malloc(local_domain.ncells_active * sizeof(*t_offset));
-    check_alloc_status(t_offset, "Memory allocation error.");
-
-    for (i = 0; i < local_domain.ncells_active; i++) {
-        if (options.SNOW_BAND > 1) {
-            Tfactor = soil_con[i].Tfactor;
-            t_offset[i] = Tfactor[0];
-            for (band = 1; band < options.SNOW_BAND; band++) {
-                if (Tfactor[band] < t_offset[i]) {
-                    t_offset[i] = Tfactor[band];
-                }
-            }
-        }
-        else {
-            t_offset[i] = 0;
-        }
+    // for coszen in the NR field, use value at noon
+    if (options.CARBON) {
+        compute_coszen_cells(local_domain.ncells_active, solar_geom, cosdecl,
+                             sindecl, SEC_PER_DAY / 2, dvar);
     }
-    // Convert forcings into what we need and calculate missing ones
+
+    // Convert forcings into what we need, calculate missing ones and put
+    // the average values in the NR field, in one pass over the cells
     for (i = 0; i < local_domain.ncells_active; i++) {
         for (j = 0; j < NF; j++) {
             // pressure in Pa
@@ -379,14 +486,14 @@ vic_force(void)
                                                 &(force[i].prec[j]), 1);
         }
         // Check on fcanopy
-        for (v = 0; v < options.NVEGTYPES; v++) {
-            vidx = veg_con_map[i].vidx[v];
-            if (vidx != NODATA_VEG) {
+        if (update_veg_hist) {
+            for (vidx = 0; vidx < (int) veg_con_map[i].nv_classes; vidx++) {
                 for (j = 0; j < NF; j++) {
                     if ((veg_hist[i][vidx].fcanopy[j] < MIN_FCANOPY) &&
                         ((current == 0) ||
                          (options.FCAN_SRC == FROM_VEGHIST))) {
-                        // Only issue this warning once if not using veg hist fractions
+                        // Only issue this warning once if not using veg
+                        // hist fractions
                         log_warn(
                             "cell %zu, veg` %d substep %zu fcanopy %f < minimum of %f; setting = %f", i, vidx, j,
                             veg_hist[i][vidx].fcanopy[j], MIN_FCANOPY,
@@ -396,11 +503,8 @@ vic_force(void)
                 }
             }
         }
-    }
-
 
-    // Put average value in NR field
-    for (i = 0; i < local_domain.ncells_active; i++) {
+        // Put average value in NR field
         force[i].air_temp[NR] = average(force[i].air_temp, NF);
         // For precipitation put total
         force[i].prec[NR] = average(force[i].prec, NF) * NF;
@@ -416,19 +520,19 @@ vic_force(void)
                                              param.SNOW_MAX_SNOW_TEMP,
                                              force[i].prec, NF);
 
-        for (v = 0; v < options.NVEGTYPES; v++) {
-            vidx = veg_con_map[i].vidx[v];
-            if (vidx != NODATA_VEG) {
-                // not the correct way to calculate average albedo in general,
-                // but leave for now (it's correct if albedo is constant over
-                // the model step)
-                veg_hist[i][vidx].albedo[NR] = average(veg_hist[i][vidx].albedo,
-                                                       NF);
+        if (update_veg_hist) {
+            for (vidx = 0; vidx < (int) veg_con_map[i].nv_classes; vidx++) {
+                // not the correct way to calculate average albedo in
+                // general, but leave for now (it's correct if albedo is
+                // constant over the model step)
+                veg_hist[i][vidx].albedo[NR] = average(
+                    veg_hist[i][vidx].albedo, NF);
                 veg_hist[i][vidx].displacement[NR] = average(
                     veg_hist[i][vidx].displacement, NF);
                 veg_hist[i][vidx].fcanopy[NR] = average(
                     veg_hist[i][vidx].fcanopy, NF);
-                veg_hist[i][vidx].LAI[NR] = average(veg_hist[i][vidx].LAI, NF);
+                veg_hist[i][vidx].LAI[NR] = average(
+                    veg_hist[i][vidx].LAI, NF);
                 veg_hist[i][vidx].roughness[NR] = average(
                     veg_hist[i][vidx].roughness, NF);
             }
@@ -442,17 +546,12 @@ vic_force(void)
             force[i].Catm[NR] = average(force[i].Catm, NF);
             force[i].fdir[NR] = average(force[i].fdir, NF);
             force[i].par[NR] = average(force[i].par, NF);
-            // for coszen, use value at noon
-            force[i].coszen[NR] = compute_coszen(
-                local_domain.locations[i].latitude,
-                local_domain.locations[i].longitude, soil_con[i].time_zone_lng,
-                dmy[current].day_in_year, SEC_PER_DAY / 2);
+            force[i].coszen[NR] = dvar[i];
         }
     }
 
-
-    // cleanup
-    free(dvar);
+    // start reading the forcings of the next time step
+    vic_force_prefetch_start();
 }
 
 /******************************************************************************
@@ -464,6 +563,7 @@ get_forcing_file_info(param_set_struct *param_set,
 {
     extern global_param_struct global_param;
     extern filenames_struct    filenames;
+    extern option_struct       options;
 
     double                     nc_times[2];
     double                     nc_time_origin;
@@ -518,8 +618,15 @@ get_forcing_file_info(param_set_struct *param_set,
     }
 
     // check that this forcing file will work
-    if (param_set->force_steps_per_day[file_num] !=
-        global_param.snow_steps_per_day) {
+    if (file_num == 0 && options.FORCE_DISAGG) {
+        if (param_set->force_steps_per_day[file_num] != 1) {
+            log_err("Forcing file timestep must be one day with "
+                    "FORCE_DISAGG = TRUE.  The forcing file timestep is set "
+                    "to %zu per day", param_set->force_steps_per_day[file_num])
+        }
+    }
+    else if (param_set->force_steps_per_day[file_num] !=
+             global_param.snow_steps_per_day) {
         log_err("Forcing file timestep must match the snow model timestep.  "
                 "Snow model timesteps per day is set to %zu and the forcing "
                 "file timestep is set to %zu",
@@ -0,0 +1,392 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Catalog of the meteorological forcing files.
+ *
+ * With FORCE_CATALOG = TRUE, FORCING1 is a glob pattern (e.g.
+ * forcings/met_*.nc) or, without wildcards, a text file with the name of one
+ * forcing file per line. The files may hold any period: a month, a decade or
+ * the whole run. The master node reads the time coordinate of every file
+ * once at startup, the catalog is broadcast to all nodes, and the file and
+ * the record of each read are looked up by time, instead of opening the file
+ * of every year to find its records. The records of a time step (or, with
+ * FORCE_DISAGG, the record of a day) must be in one file.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+#include <glob.h>
+
+static force_catalog_struct force_catalog;
+
+/******************************************************************************
+ * @brief    Add a file to the catalog.
+ *****************************************************************************/
+static void
+add_force_catalog_file(char *nc_name)
+{
+    size_t n;
+
+    n = force_catalog.nfiles + 1;
+    force_catalog.nc_names = realloc(force_catalog.nc_names,
+                                     n * MAXSTRING *
+                                     sizeof(*force_catalog.nc_names));
+    check_alloc_status(force_catalog.nc_names, "Memory allocation error.");
+    force_catalog.start = realloc(force_catalog.start,
+                                  n * sizeof(*force_catalog.start));
+    check_alloc_status(force_catalog.start, "Memory allocation error.");
+    force_catalog.nrecs = realloc(force_catalog.nrecs,
+                                  n * sizeof(*force_catalog.nrecs));
+    check_alloc_status(force_catalog.nrecs, "Memory allocation error.");
+
+    snprintf(&(force_catalog.nc_names[force_catalog.nfiles * MAXSTRING]),
+             MAXSTRING, "%s", nc_name);
+    force_catalog.nfiles = n;
+}
+
+/******************************************************************************
+ * @brief    Read the time coordinate of a file of the catalog.
+ * @details  Sets the time of the first record [days] and the number of
+ *           records of file k, and checks that
+ *           the records are regular with a length of force_catalog.dt.
+ *****************************************************************************/
+static void
+scan_force_catalog_file(size_t k)
+{
+    extern global_param_struct global_param;
+
+    char                      *nc_name;
+    char                      *nc_unit_chars = NULL;
+    char                      *calendar_char = NULL;
+    double                    *nc_times;
+    double                     nc_time_origin;
+    double                     days_per_unit;
+    double                     dt;
+    size_t                     start = 0;
+    size_t                     nrecs;
+    size_t                     i;
+    unsigned short int         time_units;
+    unsigned short int         calendar;
+    dmy_struct                 nc_origin_dmy;
+    dmy_struct                 nc_start_dmy;
+
+    nc_name = &(force_catalog.nc_names[k * MAXSTRING]);
+    nrecs = get_nc_dimension(nc_name, "time");
+    if (nrecs == 0) {
+        log_err("Forcing file %s has no records", nc_name);
+    }
+    nc_times = malloc(nrecs * sizeof(*nc_times));
+    check_alloc_status(nc_times, "Memory allocation error.");
+    get_nc_field_double(nc_name, "time", &start, &nrecs, nc_times);
+    get_nc_var_attr(nc_name, "time", "units", &nc_unit_chars);
+    get_nc_var_attr(nc_name, "time", "calendar", &calendar_char);
+
+    calendar = str_to_calendar(calendar_char);
+    if (calendar != global_param.calendar) {
+        log_err("Calendar in forcing file %s (%s) does not match the "
+                "calendar of VIC's clock", nc_name, calendar_char);
+    }
+    parse_nc_time_units(nc_unit_chars, &time_units, &nc_origin_dmy);
+    if (time_units == TIME_UNITS_HOURS) {
+        days_per_unit = 1. / HOURS_PER_DAY;
+    }
+    else if (time_units == TIME_UNITS_MINUTES) {
+        days_per_unit = 1. / MIN_PER_DAY;
+    }
+    else if (time_units == TIME_UNITS_SECONDS) {
+        days_per_unit = 1. / SEC_PER_DAY;
+    }
+    else {
+        days_per_unit = 1.;
+    }
+
+    // the records must be regular
+    for (i = 1; i < nrecs; i++) {
+        dt = (nc_times[i] - nc_times[i - 1]) * days_per_unit;
+        if (fabs(dt - force_catalog.dt) > 0.01 * force_catalog.dt) {
+            log_err("Forcing file %s: record %zu is %f days after the "
+                    "previous record, expected %f days", nc_name, i, dt,
+                    force_catalog.dt);
+        }
+    }
+
+    // the first record on the clock of the run
+    nc_time_origin = date2num(0., &nc_origin_dmy, 0., calendar,
+                              TIME_UNITS_DAYS);
+    num2date(nc_time_origin, nc_times[0], 0., calendar, time_units,
+             &nc_start_dmy);
+    force_catalog.start[k] = date2num(0., &nc_start_dmy, 0., calendar,
+                                      TIME_UNITS_DAYS);
+    force_catalog.nrecs[k] = nrecs;
+
+    free(nc_times);
+    free(nc_unit_chars);
+    free(calendar_char);
+    close_nc_file(nc_name);
+}
+
+/******************************************************************************
+ * @brief    Sort the files of the catalog by the time of their first record.
+ *****************************************************************************/
+static void
+sort_force_catalog(void)
+{
+    char   nc_name[MAXSTRING];
+    double start;
+    size_t nrecs;
+    size_t i;
+    size_t j;
+
+    // insertion sort, the files are usually in order already
+    for (i = 1; i < force_catalog.nfiles; i++) {
+        strcpy(nc_name, &(force_catalog.nc_names[i * MAXSTRING]));
+        start = force_catalog.start[i];
+        nrecs = force_catalog.nrecs[i];
+        for (j = i; j > 0 && force_catalog.start[j - 1] > start; j--) {
+            strcpy(&(force_catalog.nc_names[j * MAXSTRING]),
+                   &(force_catalog.nc_names[(j - 1) * MAXSTRING]));
+            force_catalog.start[j] = force_catalog.start[j - 1];
+            force_catalog.nrecs[j] = force_catalog.nrecs[j - 1];
+        }
+        strcpy(&(force_catalog.nc_names[j * MAXSTRING]), nc_name);
+        force_catalog.start[j] = start;
+        force_catalog.nrecs[j] = nrecs;
+    }
+}
+
+/******************************************************************************
+ * @brief    Build the catalog of the meteorological forcing files.
+ * @details  Called by the master node from get_global_param() instead of
+ *           get_forcing_file_info() for the first forcing file.
+ *****************************************************************************/
+void
+initialize_force_catalog(param_set_struct *param_set)
+{
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern option_struct       options;
+
+    char                       line[MAXSTRING];
+    char                       nc_name[MAXSTRING];
+    glob_t                     files;
+    FILE                      *fp;
+    dmy_struct                 dmy;
+    size_t                     k;
+    int                        status;
+
+    // the length of a record
+    param_set->force_steps_per_day[0] = global_param.snow_steps_per_day;
+    if (options.FORCE_DISAGG) {
+        param_set->force_steps_per_day[0] = 1;
+    }
+    force_catalog.dt = 1. / param_set->force_steps_per_day[0];
+
+    if (strpbrk(filenames.f_path_pfx[0], "*?[") != NULL) {
+        status = glob(filenames.f_path_pfx[0], 0, NULL, &files);
+        if (status != 0) {
+            log_err("No forcing file matches FORCING1 %s",
+                    filenames.f_path_pfx[0]);
+        }
+        for (k = 0; k < files.gl_pathc; k++) {
+            add_force_catalog_file(files.gl_pathv[k]);
+        }
+        globfree(&files);
+    }
+    else {
+        fp = open_file(filenames.f_path_pfx[0], "r");
+        while (fgets(line, MAXSTRING, fp) != NULL) {
+            if (sscanf(line, "%s", nc_name) == 1 && nc_name[0] != '#') {
+                add_force_catalog_file(nc_name);
+            }
+        }
+        fclose(fp);
+        if (force_catalog.nfiles == 0) {
+            log_err("The forcing file list %s is empty",
+                    filenames.f_path_pfx[0]);
+        }
+    }
+
+    for (k = 0; k < force_catalog.nfiles; k++) {
+        scan_force_catalog_file(k);
+    }
+    sort_force_catalog();
+    for (k = 1; k < force_catalog.nfiles; k++) {
+        if (force_catalog.start[k] < force_catalog.start[k - 1] +
+            (force_catalog.nrecs[k - 1] - 0.5) * force_catalog.dt) {
+            log_err("Forcing files %s and %s overlap",
+                    &(force_catalog.nc_names[(k - 1) * MAXSTRING]),
+                    &(force_catalog.nc_names[k * MAXSTRING]));
+        }
+    }
+
+    // the first record of the catalog
+    strcpy(filenames.forcing[0], force_catalog.nc_names);
+    num2date(0., force_catalog.start[0], 0., global_param.calendar,
+             TIME_UNITS_DAYS, &dmy);
+    global_param.forceyear[0] = dmy.year;
+    global_param.forcemonth[0] = dmy.month;
+    global_param.forceday[0] = dmy.day;
+    global_param.forcesec[0] = dmy.dayseconds;
+
+    log_info("Forcing catalog of %zu files", force_catalog.nfiles);
+}
+
+/******************************************************************************
+ * @brief    Send the catalog of the forcing files to all nodes.
+ *****************************************************************************/
+void
+broadcast_force_catalog(void)
+{
+    extern option_struct options;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern int           mpi_rank;
+
+    int                  status;
+
+    if (!options.FORCE_CATALOG) {
+        return;
+    }
+
+    status = MPI_Bcast(&(force_catalog.nfiles), 1, MPI_AINT, VIC_MPI_ROOT,
+                       MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(&(force_catalog.dt), 1, MPI_DOUBLE, VIC_MPI_ROOT,
+                       MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (mpi_rank != VIC_MPI_ROOT) {
+        force_catalog.nc_names = malloc(force_catalog.nfiles * MAXSTRING *
+                                        sizeof(*force_catalog.nc_names));
+        check_alloc_status(force_catalog.nc_names, "Memory allocation error.");
+        force_catalog.start = malloc(force_catalog.nfiles *
+                                     sizeof(*force_catalog.start));
+        check_alloc_status(force_catalog.start, "Memory allocation error.");
+        force_catalog.nrecs = malloc(force_catalog.nfiles *
+                                     sizeof(*force_catalog.nrecs));
+        check_alloc_status(force_catalog.nrecs, "Memory allocation error.");
+    }
+    status = MPI_Bcast(force_catalog.nc_names,
+                       (int) (force_catalog.nfiles * MAXSTRING), MPI_CHAR,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(force_catalog.start, (int) force_catalog.nfiles,
+                       MPI_DOUBLE, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(force_catalog.nrecs, (int) force_catalog.nfiles,
+                       MPI_AINT, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+}
+
+/******************************************************************************
+ * @brief    Free the catalog of the forcing files.
+ *****************************************************************************/
+void
+finalize_force_catalog(void)
+{
+    free(force_catalog.nc_names);
+    free(force_catalog.start);
+    free(force_catalog.nrecs);
+    memset(&force_catalog, 0, sizeof(force_catalog));
+}
+
+/******************************************************************************
+ * @brief    Find the file and the first record of the meteorological
+ *           forcings of a time step.
+ * @details  The records of the time step that starts at dmy (of its day with
+ *           FORCE_DISAGG) are looked up in the catalog.
+ *
+ * @return   FALSE without FORCE_CATALOG
+ *****************************************************************************/
+bool
+get_force_catalog_record(dmy_struct *dmy,
+                         char       *nc_name,
+                         size_t     *start)
+{
+    extern size_t              NF;
+    extern global_param_struct global_param;
+    extern option_struct       options;
+
+    dmy_struct                 dmy_record;
+    double                     t;
+    size_t                     count;
+    size_t                     lo;
+    size_t                     hi;
+    size_t                     k;
+    double                     rec;
+
+    if (!options.FORCE_CATALOG) {
+        return false;
+    }
+
+    dmy_record = *dmy;
+    count = NF;
+    if (options.FORCE_DISAGG) {
+        dmy_record.dayseconds = 0;
+        count = 1;
+    }
+    t = date2num(0., &dmy_record, 0., global_param.calendar,
+                 TIME_UNITS_DAYS);
+
+    // the last file that starts before the record
+    lo = 0;
+    hi = force_catalog.nfiles;
+    while (hi - lo > 1) {
+        k = (lo + hi) / 2;
+        if (force_catalog.start[k] <= t + 0.5 * force_catalog.dt) {
+            lo = k;
+        }
+        else {
+            hi = k;
+        }
+    }
+    k = lo;
+
+    rec = nearbyint((t - force_catalog.start[k]) / force_catalog.dt);
+    if (rec < 0 || (size_t) rec + count > force_catalog.nrecs[k]) {
+        log_err("The forcing records of %04d-%02d-%02d-%05u are not in one "
+                "file of the forcing catalog", dmy_record.year,
+                dmy_record.month, dmy_record.day, dmy_record.dayseconds);
+    }
+    strcpy(nc_name, &(force_catalog.nc_names[k * MAXSTRING]));
+    *start = (size_t) rec;
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Find the file of the catalog that follows a file.
+ *
+ * @return   FALSE if nc_name is the last file or not in the catalog
+ *****************************************************************************/
+bool
+get_force_catalog_next_file(char *nc_name,
+                            char *next_name)
+{
+    size_t k;
+
+    for (k = 0; k + 1 < force_catalog.nfiles; k++) {
+        if (strcmp(&(force_catalog.nc_names[k * MAXSTRING]), nc_name) == 0) {
+            strcpy(next_name, &(force_catalog.nc_names[(k + 1) * MAXSTRING]));
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,385 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Temporal disaggregation of daily forcings.
+ *
+ * With FORCE_DISAGG = TRUE, the forcing files hold one record per day, and
+ * the sub-steps of each time step are generated from the record of the day
+ * in memory, instead of being read from (much larger) sub-daily files. The
+ * record of a day is read once, at the first time step of the day:
+ *
+ * - air temperature: a diurnal cycle through TMIN at DISAGG_TMIN_HOUR and
+ *   TMAX at DISAGG_TMAX_HOUR local solar time, with half cosines for the
+ *   rising and the falling limb;
+ * - precipitation: the daily total, evenly over the sub-steps of the day;
+ * - shortwave: the daily mean (SWDOWN), or the top of atmosphere irradiance
+ *   scaled by the transmissivity of the diurnal temperature range (Bristow
+ *   and Campbell, 1984), distributed with the cosine of the solar zenith
+ *   angle;
+ * - vapor pressure: the daily mean (VP), or the saturated vapor pressure at
+ *   TMIN;
+ * - longwave: the daily mean (LWDOWN) distributed with the fourth power of
+ *   the air temperature, or the clear sky emissivity of Prata (1996) with
+ *   the cloud fraction from the transmissivity;
+ * - pressure: the daily mean (PRESSURE), or the pressure of the standard
+ *   atmosphere at the elevation of the cell;
+ * - wind speed: the daily mean.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+
+static force_disagg_struct force_disagg;
+
+/******************************************************************************
+ * @brief    Air temperature of the diurnal cycle at a local solar hour.
+ *****************************************************************************/
+static double
+disagg_air_temp(double tmin,
+                double tmax,
+                double hour)
+{
+    double rise;
+    double h;
+    double f;
+
+    // hours since the minimum temperature
+    rise = DISAGG_TMAX_HOUR - DISAGG_TMIN_HOUR;
+    h = fmod(hour - DISAGG_TMIN_HOUR + 2 * HOURS_PER_DAY, HOURS_PER_DAY);
+    if (h <= rise) {
+        f = 0.5 * (1. - cos(CONST_PI * h / rise));
+    }
+    else {
+        f = 0.5 * (1. + cos(CONST_PI * (h - rise) / (HOURS_PER_DAY - rise)));
+    }
+
+    return tmin + (tmax - tmin) * f;
+}
+
+/******************************************************************************
+ * @brief    Incoming longwave radiation of a clear or cloudy sky.
+ * @details  Clear sky emissivity of Prata (1996), cloudy sky of Deardorff
+ *           (1978).
+ *****************************************************************************/
+static double
+disagg_longwave(double air_temp,
+                double vp,
+                double cloud)
+{
+    double tk;
+    double w;
+    double emissivity;
+
+    tk = air_temp + CONST_TKFRZ;
+    // precipitable water [cm] from the vapor pressure [hPa]
+    w = 46.5 * vp * 10. / tk;
+    emissivity = 1. - (1. + w) * exp(-sqrt(1.2 + 3. * w));
+    emissivity = emissivity * (1. - cloud) + cloud;
+
+    return emissivity * CONST_STEBOL * tk * tk * tk * tk;
+}
+
+/******************************************************************************
+ * @brief    Allocate the daily forcings of the local cells.
+ *****************************************************************************/
+void
+vic_force_disagg_init(void)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+
+    size_t               n;
+
+    if (!options.FORCE_DISAGG) {
+        return;
+    }
+
+    n = local_domain.ncells_active;
+    force_disagg.valid = false;
+    force_disagg.tmin = malloc(n * sizeof(*force_disagg.tmin));
+    check_alloc_status(force_disagg.tmin, "Memory allocation error.");
+    force_disagg.tmax = malloc(n * sizeof(*force_disagg.tmax));
+    check_alloc_status(force_disagg.tmax, "Memory allocation error.");
+    force_disagg.prec = malloc(n * sizeof(*force_disagg.prec));
+    check_alloc_status(force_disagg.prec, "Memory allocation error.");
+    force_disagg.wind = malloc(n * sizeof(*force_disagg.wind));
+    check_alloc_status(force_disagg.wind, "Memory allocation error.");
+    force_disagg.vp = malloc(n * sizeof(*force_disagg.vp));
+    check_alloc_status(force_disagg.vp, "Memory allocation error.");
+    force_disagg.pressure = malloc(n * sizeof(*force_disagg.pressure));
+    check_alloc_status(force_disagg.pressure, "Memory allocation error.");
+    force_disagg.sw_scale = malloc(n * sizeof(*force_disagg.sw_scale));
+    check_alloc_status(force_disagg.sw_scale, "Memory allocation error.");
+    force_disagg.lw_scale = malloc(n * sizeof(*force_disagg.lw_scale));
+    check_alloc_status(force_disagg.lw_scale, "Memory allocation error.");
+    force_disagg.t4_mean = malloc(n * sizeof(*force_disagg.t4_mean));
+    check_alloc_status(force_disagg.t4_mean, "Memory allocation error.");
+    force_disagg.cloud = malloc(n * sizeof(*force_disagg.cloud));
+    check_alloc_status(force_disagg.cloud, "Memory allocation error.");
+    force_disagg.coszen = malloc(n * sizeof(*force_disagg.coszen));
+    check_alloc_status(force_disagg.coszen, "Memory allocation error.");
+}
+
+/******************************************************************************
+ * @brief    Free the daily forcings of the local cells.
+ *****************************************************************************/
+void
+vic_force_disagg_finalize(void)
+{
+    free(force_disagg.tmin);
+    free(force_disagg.tmax);
+    free(force_disagg.prec);
+    free(force_disagg.wind);
+    free(force_disagg.vp);
+    free(force_disagg.pressure);
+    free(force_disagg.sw_scale);
+    free(force_disagg.lw_scale);
+    free(force_disagg.t4_mean);
+    free(force_disagg.cloud);
+    free(force_disagg.coszen);
+    memset(&force_disagg, 0, sizeof(force_disagg));
+}
+
+/******************************************************************************
+ * @brief    Read the daily forcings of a day and compute the terms of its
+ *           diurnal cycles.
+ *****************************************************************************/
+static void
+read_disagg_day(size_t start)
+{
+    extern dmy_struct          dmy_current;
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern param_set_struct    param_set;
+    extern soil_con_struct    *soil_con;
+    extern solar_geom_struct  *solar_geom;
+
+    size_t                     ncells;
+    size_t                     nsteps;
+    size_t                     d3count[3];
+    size_t                     d3start[3];
+    size_t                     i;
+    size_t                     s;
+    unsigned int               second;
+    double                     cosdecl;
+    double                     sindecl;
+    double                     hour;
+    double                     tk;
+    double                     toa;
+    double                     tau;
+    double                     dtr;
+    double                     sw;
+
+    ncells = local_domain.ncells_active;
+    d3start[0] = start;
+    d3start[1] = 0;
+    d3start[2] = 0;
+    d3count[0] = 1;
+    d3count[1] = global_domain.n_ny;
+    d3count[2] = global_domain.n_nx;
+
+    get_scatter_forcing_field(0, filenames.forcing[0],
+                              param_set.TYPE[TMIN].varname, 3, d3start,
+                              d3count, force_disagg.tmin);
+    get_scatter_forcing_field(0, filenames.forcing[0],
+                              param_set.TYPE[TMAX].varname, 3, d3start,
+                              d3count, force_disagg.tmax);
+    get_scatter_forcing_field(0, filenames.forcing[0],
+                              param_set.TYPE[PREC].varname, 3, d3start,
+                              d3count, force_disagg.prec);
+    get_scatter_forcing_field(0, filenames.forcing[0],
+                              param_set.TYPE[WIND].varname, 3, d3start,
+                              d3count, force_disagg.wind);
+    if (param_set.TYPE[VP].SUPPLIED) {
+        get_scatter_forcing_field(0, filenames.forcing[0],
+                                  param_set.TYPE[VP].varname, 3, d3start,
+                                  d3count, force_disagg.vp);
+    }
+    else {
+        // the dew point is close to the minimum temperature
+        for (i = 0; i < ncells; i++) {
+            force_disagg.vp[i] = svp(force_disagg.tmin[i]) / PA_PER_KPA;
+        }
+    }
+    if (param_set.TYPE[PRESSURE].SUPPLIED) {
+        get_scatter_forcing_field(0, filenames.forcing[0],
+                                  param_set.TYPE[PRESSURE].varname, 3,
+                                  d3start, d3count, force_disagg.pressure);
+    }
+    else {
+        for (i = 0; i < ncells; i++) {
+            force_disagg.pressure[i] = CONST_PSTD / PA_PER_KPA *
+                                       exp(-soil_con[i].elevation /
+                                           calc_scale_height(
+                                               0.5 * (force_disagg.tmin[i] +
+                                                      force_disagg.tmax[i]),
+                                               soil_con[i].elevation));
+        }
+    }
+    // the daily means of the radiation are kept until the scale factors are
+    // computed
+    if (param_set.TYPE[SWDOWN].SUPPLIED) {
+        get_scatter_forcing_field(0, filenames.forcing[0],
+                                  param_set.TYPE[SWDOWN].varname, 3, d3start,
+                                  d3count, force_disagg.cloud);
+    }
+    if (param_set.TYPE[LWDOWN].SUPPLIED) {
+        get_scatter_forcing_field(0, filenames.forcing[0],
+                                  param_set.TYPE[LWDOWN].varname, 3, d3start,
+                                  d3count, force_disagg.lw_scale);
+    }
+
+    // means of the cosine of the solar zenith angle and of the fourth power
+    // of the air temperature over the sub-steps of the day
+    nsteps = global_param.snow_steps_per_day;
+    for (i = 0; i < ncells; i++) {
+        force_disagg.sw_scale[i] = 0.;
+        force_disagg.t4_mean[i] = 0.;
+    }
+    compute_solar_decl(dmy_current.day_in_year, &cosdecl, &sindecl);
+    for (s = 0; s < nsteps; s++) {
+        second = (unsigned int) ((s + 0.5) * global_param.snow_dt);
+        compute_coszen_cells(ncells, solar_geom, cosdecl, sindecl, second,
+                             force_disagg.coszen);
+        for (i = 0; i < ncells; i++) {
+            if (force_disagg.coszen[i] > 0.) {
+                force_disagg.sw_scale[i] += force_disagg.coszen[i] / nsteps;
+            }
+            hour = second / (double) SEC_PER_HOUR + solar_geom[i].hour_offset;
+            tk = disagg_air_temp(force_disagg.tmin[i], force_disagg.tmax[i],
+                                 hour) + CONST_TKFRZ;
+            force_disagg.t4_mean[i] += tk * tk * tk * tk / nsteps;
+        }
+    }
+
+    for (i = 0; i < ncells; i++) {
+        // top of atmosphere and surface shortwave of the day
+        toa = DISAGG_SOLAR_CONST * force_disagg.sw_scale[i];
+        if (param_set.TYPE[SWDOWN].SUPPLIED) {
+            sw = force_disagg.cloud[i];
+            tau = (toa > 0.) ? sw / toa : DISAGG_TAU_MAX;
+        }
+        else {
+            dtr = force_disagg.tmax[i] - force_disagg.tmin[i];
+            if (dtr < 0.) {
+                dtr = 0.;
+            }
+            tau = DISAGG_TAU_MAX *
+                  (1. - exp(-DISAGG_TAU_B * pow(dtr, DISAGG_TAU_C)));
+            sw = tau * toa;
+        }
+        force_disagg.cloud[i] = 1. - tau / DISAGG_TAU_MAX;
+        if (force_disagg.cloud[i] < 0.) {
+            force_disagg.cloud[i] = 0.;
+        }
+        else if (force_disagg.cloud[i] > 1.) {
+            force_disagg.cloud[i] = 1.;
+        }
+        if (force_disagg.sw_scale[i] > 0.) {
+            force_disagg.sw_scale[i] = sw / force_disagg.sw_scale[i];
+        }
+        if (param_set.TYPE[LWDOWN].SUPPLIED) {
+            force_disagg.lw_scale[i] /= force_disagg.t4_mean[i];
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Generate the NF sub-steps of the meteorological forcings of the
+ *           current time step from the daily forcings.
+ * @details  Called by vic_force with the netCDF lock and the record of the
+ *           day in filenames.forcing[0]. The record is read at the first time
+ *           step of the day, and the offset into the forcing file advances at
+ *           the last time step of the day.
+ *****************************************************************************/
+void
+vic_force_disagg(size_t start)
+{
+    extern size_t              NF;
+    extern force_data_struct  *force;
+    extern dmy_struct          dmy_current;
+    extern domain_struct       local_domain;
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern param_set_struct    param_set;
+    extern solar_geom_struct  *solar_geom;
+
+    size_t                     ncells;
+    size_t                     i;
+    size_t                     j;
+    unsigned int               second;
+    double                     cosdecl;
+    double                     sindecl;
+    double                     hour;
+    double                     tk;
+
+    ncells = local_domain.ncells_active;
+    if (!force_disagg.valid || force_disagg.start != start ||
+        strcmp(force_disagg.nc_name, filenames.forcing[0]) != 0) {
+        read_disagg_day(start);
+        strcpy(force_disagg.nc_name, filenames.forcing[0]);
+        force_disagg.start = start;
+        force_disagg.valid = true;
+    }
+
+    compute_solar_decl(dmy_current.day_in_year, &cosdecl, &sindecl);
+    for (j = 0; j < NF; j++) {
+        // the middle of the sub-step
+        second = dmy_current.dayseconds +
+                 (unsigned int) ((j + 0.5) * global_param.snow_dt);
+        compute_coszen_cells(ncells, solar_geom, cosdecl, sindecl, second,
+                             force_disagg.coszen);
+        for (i = 0; i < ncells; i++) {
+            hour = second / (double) SEC_PER_HOUR + solar_geom[i].hour_offset;
+            force[i].air_temp[j] = disagg_air_temp(force_disagg.tmin[i],
+                                                   force_disagg.tmax[i],
+                                                   hour);
+            force[i].prec[j] = force_disagg.prec[i] /
+                               global_param.snow_steps_per_day;
+            force[i].shortwave[j] = 0.;
+            if (force_disagg.coszen[i] > 0.) {
+                force[i].shortwave[j] = force_disagg.sw_scale[i] *
+                                        force_disagg.coszen[i];
+            }
+            if (param_set.TYPE[LWDOWN].SUPPLIED) {
+                tk = force[i].air_temp[j] + CONST_TKFRZ;
+                force[i].longwave[j] = force_disagg.lw_scale[i] *
+                                       tk * tk * tk * tk;
+            }
+            else {
+                force[i].longwave[j] = disagg_longwave(force[i].air_temp[j],
+                                                       force_disagg.vp[i],
+                                                       force_disagg.cloud[i]);
+            }
+            force[i].wind[j] = force_disagg.wind[i];
+            force[i].vp[j] = force_disagg.vp[i];
+            force[i].pressure[j] = force_disagg.pressure[i];
+        }
+    }
+
+    // the record of the next day
+    if (dmy_current.dayseconds + global_param.dt >= SEC_PER_DAY) {
+        global_param.forceoffset[0]++;
+    }
+}
@@ -0,0 +1,409 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Prefetch pipeline for the atmospheric forcing data.
+ *
+ * When FORCE_PREFETCH is TRUE, the master node reads the forcings of the next
+ * time step on a reader thread while the current time step is run. The reads
+ * of a time step are recorded in the order in which vic_force issues them, and
+ * the reads of the next time step are predicted from them. A prefetched read
+ * is only used if it matches the read that vic_force actually issues, so a
+ * misprediction falls back to a synchronous read and does not change results.
+ *
+ * The netCDF library is not thread-safe. The master node therefore must call
+ * vic_force_prefetch_wait() before any other netCDF access. The reads take
+ * the netCDF lock, since the history writer thread may run at the same time
+ * (ASYNC_OUTPUT).
+ *
+ * Without FORCE_PREFETCH, the reads use the same buffers, but are always
+ * synchronous. The master node reads each field and then scatters it, so
+ * that the read and the scatter are timed separately.
+ *
+ * With FORCE_PRECISION = SINGLE, a field is read and scattered in single
+ * precision, or as short integers if the file stores it packed, and is only
+ * converted to double precision (and unpacked) on the node that uses it.
+ * This halves (or quarters) the memory of the master node buffers and the
+ * volume of the scatter. Fields stored in single precision or packed give
+ * the same values as with FORCE_PRECISION = DOUBLE.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+
+static force_prefetch_struct force_prefetch;
+
+/******************************************************************************
+ * @brief    Check whether a recorded read matches a requested read.
+ *****************************************************************************/
+static bool
+match_forcing_read(force_read_struct *read,
+                   char              *nc_name,
+                   char              *var_name,
+                   int                ndims,
+                   size_t            *start,
+                   size_t            *count)
+{
+    int i;
+
+    if (read->ndims != ndims || strcmp(read->nc_name, nc_name) != 0 ||
+        strcmp(read->var_name, var_name) != 0) {
+        return false;
+    }
+    for (i = 0; i < ndims; i++) {
+        if (read->start[i] != start[i] || read->count[i] != count[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Make sure the data buffer of a read can hold its hyperslab.
+ *****************************************************************************/
+static void
+alloc_forcing_read(force_read_struct *read)
+{
+    size_t nelem;
+    int    i;
+
+    nelem = 1;
+    for (i = 0; i < read->ndims; i++) {
+        nelem *= read->count[i];
+    }
+    if (nelem != read->nelem) {
+        // large enough for any type of data
+        free(read->data);
+        read->data = malloc(nelem * sizeof(double));
+        check_alloc_status(read->data, "Memory allocation error.");
+        read->nelem = nelem;
+    }
+}
+
+/******************************************************************************
+ * @brief    Read the hyperslab of a read in the precision of FORCE_PRECISION.
+ * @details  The caller holds the netCDF lock.
+ *****************************************************************************/
+static void
+read_forcing_data(force_read_struct *read)
+{
+    extern option_struct options;
+
+    read->nc_type = NC_DOUBLE;
+    if (options.FORCE_PRECISION == FORCE_PRECISION_SINGLE) {
+        read->nc_type = get_nc_var_type(read->nc_name, read->var_name);
+        if (read->nc_type == NC_SHORT) {
+            get_nc_var_packing(read->nc_name, read->var_name,
+                               &(read->scale_factor), &(read->add_offset));
+        }
+        else {
+            read->nc_type = NC_FLOAT;
+        }
+    }
+
+    if (read->nc_type == NC_SHORT) {
+        get_nc_field_short(read->nc_name, read->var_name, read->start,
+                           read->count, read->data);
+    }
+    else if (read->nc_type == NC_FLOAT) {
+        get_nc_field_float(read->nc_name, read->var_name, read->start,
+                           read->count, read->data);
+    }
+    else {
+        get_nc_field_double(read->nc_name, read->var_name, read->start,
+                            read->count, read->data);
+    }
+}
+
+/******************************************************************************
+ * @brief    Scatter the data of a read and convert it to double precision.
+ * @details  read is NULL on the other nodes. The master node sends the type
+ *           and packing of the data along.
+ *****************************************************************************/
+static void
+scatter_forcing_data(force_read_struct *read,
+                     size_t             nsteps,
+                     double            *var)
+{
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern domain_struct local_domain;
+    extern option_struct options;
+    extern int           mpi_rank;
+
+    double               packing[3];
+    float               *fvar = NULL;
+    short int           *svar = NULL;
+    size_t               nelem;
+    size_t               k;
+    int                  status;
+
+    if (options.FORCE_PRECISION == FORCE_PRECISION_DOUBLE) {
+        scatter_field_double_steps(nsteps, read == NULL ? NULL : read->data,
+                                   var);
+        return;
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        packing[0] = (double) read->nc_type;
+        packing[1] = read->scale_factor;
+        packing[2] = read->add_offset;
+    }
+    status = MPI_Bcast(packing, 3, MPI_DOUBLE, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    nelem = nsteps * local_domain.ncells_active;
+    if ((int) packing[0] == NC_SHORT) {
+        svar = malloc(nelem * sizeof(*svar));
+        check_alloc_status(svar, "Memory allocation error.");
+        scatter_field_short_steps(nsteps, read == NULL ? NULL : read->data,
+                                  svar);
+        for (k = 0; k < nelem; k++) {
+            var[k] = svar[k] * packing[1] + packing[2];
+        }
+        free(svar);
+    }
+    else {
+        fvar = malloc(nelem * sizeof(*fvar));
+        check_alloc_status(fvar, "Memory allocation error.");
+        scatter_field_float_steps(nsteps, read == NULL ? NULL : read->data,
+                                  fvar);
+        for (k = 0; k < nelem; k++) {
+            var[k] = (double) fvar[k];
+        }
+        free(fvar);
+    }
+}
+
+/******************************************************************************
+ * @brief    Reader thread: read all predicted forcing fields.
+ *****************************************************************************/
+static void *
+read_forcing_fields(void *arg)
+{
+    force_prefetch_struct *prefetch = (force_prefetch_struct *) arg;
+    force_read_struct     *read;
+    size_t                 k;
+
+    trace_begin(TRACE_FORCE_PREFETCH);
+    for (k = 0; k < prefetch->nreads; k++) {
+        read = &(prefetch->reads[k]);
+        lock_netcdf();
+        read_forcing_data(read);
+        unlock_netcdf();
+    }
+    trace_end(TRACE_FORCE_PREFETCH);
+
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief    Read several time steps of a forcing field and scatter, using the
+ *           prefetched data if available
+ * @details  Drop-in replacement for get_scatter_nc_field_double_steps() that
+ *           is used by vic_force. file_num is the index of the forcing file
+ *           prefix the file name was built from.
+ *****************************************************************************/
+void
+get_scatter_forcing_field(size_t  file_num,
+                          char   *nc_name,
+                          char   *var_name,
+                          int     ndims,
+                          size_t *start,
+                          size_t *count,
+                          double *var)
+{
+    extern option_struct options;
+    extern int           mpi_rank;
+    extern timer_struct  global_timers[N_TIMERS];
+
+    force_read_struct   *read = NULL;
+    size_t               nbytes;
+    size_t               k;
+    int                  i;
+
+    // the volume of the field is counted once, on the master node
+    if (mpi_rank == VIC_MPI_ROOT) {
+        nbytes = sizeof(double);
+        for (i = 0; i < ndims; i++) {
+            nbytes *= count[i];
+        }
+        add_vic_io_bytes(IO_PHASE_FORCE, nbytes);
+    }
+
+    if (!options.FORCE_PREFETCH && options.PARALLEL_IO) {
+        // each node reads its own cells
+        timer_continue(&(global_timers[TIMER_VIC_FORCE_READ]));
+        get_scatter_nc_field_double_steps(nc_name, var_name, start, count,
+                                          var);
+        timer_stop(&(global_timers[TIMER_VIC_FORCE_READ]));
+        return;
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        k = force_prefetch.next++;
+        if (k >= force_prefetch.nalloc) {
+            force_prefetch.reads =
+                realloc(force_prefetch.reads,
+                        (k + 1) * sizeof(*(force_prefetch.reads)));
+            check_alloc_status(force_prefetch.reads,
+                               "Memory allocation error.");
+            memset(&(force_prefetch.reads[k]), 0,
+                   sizeof(*(force_prefetch.reads)));
+            force_prefetch.nalloc = k + 1;
+        }
+        read = &(force_prefetch.reads[k]);
+
+        timer_continue(&(global_timers[TIMER_VIC_FORCE_READ]));
+        if (!options.FORCE_PREFETCH ||
+            !match_forcing_read(read, nc_name, var_name, ndims, start,
+                                count)) {
+            // not prefetched (first time step or misprediction)
+            read->file_num = file_num;
+            strcpy(read->nc_name, nc_name);
+            strcpy(read->var_name, var_name);
+            read->ndims = ndims;
+            for (i = 0; i < ndims; i++) {
+                read->start[i] = start[i];
+                read->count[i] = count[i];
+            }
+            alloc_forcing_read(read);
+            read_forcing_data(read);
+        }
+        timer_stop(&(global_timers[TIMER_VIC_FORCE_READ]));
+    }
+
+    timer_continue(&(global_timers[TIMER_VIC_FORCE_SCATTER]));
+    scatter_forcing_data(read, count[0], var);
+    timer_stop(&(global_timers[TIMER_VIC_FORCE_SCATTER]));
+}
+
+/******************************************************************************
+ * @brief    Start reading the forcings of the next time step.
+ * @details  Called at the end of vic_force. The reads of the next time step
+ *           are predicted in the same way that vic_force advances the file
+ *           name and the offsets into the forcing files.
+ *****************************************************************************/
+void
+vic_force_prefetch_start(void)
+{
+    extern size_t              current;
+    extern dmy_struct          dmy_current;
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern option_struct       options;
+    extern int                 mpi_rank;
+
+    force_read_struct         *read;
+    dmy_struct                 dmy_next;
+    size_t                     next;
+    size_t                     skip;
+    size_t                     offset;
+    size_t                     k;
+    int                        status;
+
+    if (mpi_rank != VIC_MPI_ROOT) {
+        return;
+    }
+
+    // with FORCE_DISAGG, the reads of the first time step of a day predict
+    // the reads of the next day
+    if (!options.FORCE_DISAGG || force_prefetch.next > 0) {
+        force_prefetch.nreads = force_prefetch.next;
+    }
+    force_prefetch.next = 0;
+    if (!options.FORCE_PREFETCH) {
+        return;
+    }
+
+    next = current + 1;
+    if (next >= global_param.nrecs || force_prefetch.nreads == 0) {
+        return;
+    }
+
+    dmy_from_step(&global_param, next, &dmy_next);
+    if (options.FORCE_DISAGG && dmy_next.day == dmy_current.day) {
+        return;
+    }
+    for (k = 0; k < force_prefetch.nreads; k++) {
+        read = &(force_prefetch.reads[k]);
+        if (read->file_num == 0 &&
+            get_force_catalog_record(&dmy_next, read->nc_name,
+                                     &(read->start[0]))) {
+            continue;
+        }
+        skip = global_param.forceskip[read->file_num];
+        offset = global_param.forceoffset[read->file_num];
+        // the forcing files restart every year
+        if (next > 1 && dmy_next.year != dmy_current.year) {
+            offset = 0;
+            if (read->file_num == 0) {
+                skip = 0;
+            }
+        }
+        sprintf(read->nc_name, "%s%4d.nc",
+                filenames.f_path_pfx[read->file_num], dmy_next.year);
+        read->start[0] = skip + offset;
+    }
+
+    status = pthread_create(&(force_prefetch.thread), NULL,
+                            read_forcing_fields, &force_prefetch);
+    if (status != 0) {
+        log_err("Could not start forcing reader thread: %d", status);
+    }
+    force_prefetch.active = true;
+}
+
+/******************************************************************************
+ * @brief    Wait until the forcings of the next time step have been read.
+ *****************************************************************************/
+void
+vic_force_prefetch_wait(void)
+{
+    int status;
+
+    if (force_prefetch.active) {
+        status = pthread_join(force_prefetch.thread, NULL);
+        if (status != 0) {
+            log_err("Could not join forcing reader thread: %d", status);
+        }
+        force_prefetch.active = false;
+    }
+}
+
+/******************************************************************************
+ * @brief    Stop the prefetch pipeline and free its buffers.
+ *****************************************************************************/
+void
+vic_force_prefetch_finalize(void)
+{
+    size_t k;
+
+    vic_force_prefetch_wait();
+
+    for (k = 0; k < force_prefetch.nalloc; k++) {
+        free(force_prefetch.reads[k].data);
+    }
+    free(force_prefetch.reads);
+    force_prefetch.reads = NULL;
+    force_prefetch.nreads = 0;
+    force_prefetch.nalloc = 0;
+    force_prefetch.next = 0;
+}
@@ -0,0 +1,313 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Forcing reader processes.
+ *
+ * When FORCE_READERS > 1, the forcing fields of a time step are dealt out to
+ * the first FORCE_READERS processes in turn: field k is read by process
+ * k % FORCE_READERS. Every reader reads its fields at the same time as the
+ * others and then scatters them from there, with one non-blocking
+ * MPI_Iscatterv per field rooted at its reader. The master node therefore no
+ * longer reads all forcing fields one after another.
+ *
+ * Each reader holds the decomposition of the domain, which the master node
+ * sends at initialization, and one field on the full grid while it is read.
+ * The fields are read and scattered in double precision.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+
+// message tag of the decomposition sent to the readers
+#define FORCE_READERS_TAG 1
+
+static force_readers_struct force_readers;
+
+/******************************************************************************
+ * @brief    Send the decomposition of the domain to the forcing readers.
+ * @details  The readers keep the maps, with the number of processes at
+ *           initialization. I/O servers are the last processes and have no
+ *           cells, so the maps also hold for the compute processes alone.
+ *****************************************************************************/
+void
+vic_force_readers_init(void)
+{
+    extern domain_struct global_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern option_struct options;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+    extern int          *mpi_map_global_array_offsets;
+    extern int          *mpi_map_local_array_sizes;
+    extern size_t       *mpi_map_grid_array;
+
+    size_t               sizes[2];
+    int                  reader;
+    int                  status;
+
+    memset(&force_readers, 0, sizeof(force_readers));
+    force_readers.nreaders = options.FORCE_READERS;
+    if (force_readers.nreaders <= 1) {
+        return;
+    }
+
+    force_readers.nprocs = mpi_size;
+    if (mpi_rank == VIC_MPI_ROOT) {
+        force_readers.ncells_total = global_domain.ncells_total;
+        force_readers.ncells_active = global_domain.ncells_active;
+        force_readers.sizes = mpi_map_local_array_sizes;
+        force_readers.offsets = mpi_map_global_array_offsets;
+        force_readers.grid_map = mpi_map_grid_array;
+
+        sizes[0] = force_readers.ncells_total;
+        sizes[1] = force_readers.ncells_active;
+        for (reader = 1; reader < (int) force_readers.nreaders; reader++) {
+            status = MPI_Send(sizes, 2, MPI_UNSIGNED_LONG, reader,
+                              FORCE_READERS_TAG, MPI_COMM_VIC);
+            check_mpi_status(status, "MPI error.");
+            status = MPI_Send(mpi_map_local_array_sizes, mpi_size, MPI_INT,
+                              reader, FORCE_READERS_TAG, MPI_COMM_VIC);
+            check_mpi_status(status, "MPI error.");
+            status = MPI_Send(mpi_map_global_array_offsets, mpi_size, MPI_INT,
+                              reader, FORCE_READERS_TAG, MPI_COMM_VIC);
+            check_mpi_status(status, "MPI error.");
+            status = MPI_Send(mpi_map_grid_array, sizes[1],
+                              MPI_UNSIGNED_LONG, reader, FORCE_READERS_TAG,
+                              MPI_COMM_VIC);
+            check_mpi_status(status, "MPI error.");
+        }
+    }
+    else if ((size_t) mpi_rank < force_readers.nreaders) {
+        status = MPI_Recv(sizes, 2, MPI_UNSIGNED_LONG, VIC_MPI_ROOT,
+                          FORCE_READERS_TAG, MPI_COMM_VIC, MPI_STATUS_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        force_readers.ncells_total = sizes[0];
+        force_readers.ncells_active = sizes[1];
+
+        force_readers.sizes = malloc(mpi_size *
+                                     sizeof(*(force_readers.sizes)));
+        check_alloc_status(force_readers.sizes, "Memory allocation error.");
+        force_readers.offsets = malloc(mpi_size *
+                                       sizeof(*(force_readers.offsets)));
+        check_alloc_status(force_readers.offsets, "Memory allocation error.");
+        force_readers.grid_map = malloc(sizes[1] *
+                                        sizeof(*(force_readers.grid_map)));
+        check_alloc_status(force_readers.grid_map,
+                           "Memory allocation error.");
+
+        status = MPI_Recv(force_readers.sizes, mpi_size, MPI_INT,
+                          VIC_MPI_ROOT, FORCE_READERS_TAG, MPI_COMM_VIC,
+                          MPI_STATUS_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Recv(force_readers.offsets, mpi_size, MPI_INT,
+                          VIC_MPI_ROOT, FORCE_READERS_TAG, MPI_COMM_VIC,
+                          MPI_STATUS_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Recv(force_readers.grid_map, sizes[1],
+                          MPI_UNSIGNED_LONG, VIC_MPI_ROOT, FORCE_READERS_TAG,
+                          MPI_COMM_VIC, MPI_STATUS_IGNORE);
+        check_mpi_status(status, "MPI error.");
+    }
+
+    if ((size_t) mpi_rank < force_readers.nreaders) {
+        force_readers.counts = malloc(mpi_size *
+                                      sizeof(*(force_readers.counts)));
+        check_alloc_status(force_readers.counts, "Memory allocation error.");
+        force_readers.displs = malloc(mpi_size *
+                                      sizeof(*(force_readers.displs)));
+        check_alloc_status(force_readers.displs, "Memory allocation error.");
+    }
+}
+
+/******************************************************************************
+ * @brief    Free the buffers of the forcing readers.
+ *****************************************************************************/
+void
+vic_force_readers_finalize(void)
+{
+    extern int mpi_rank;
+
+    // the master node uses the maps of the decomposition
+    if (mpi_rank != VIC_MPI_ROOT) {
+        free(force_readers.sizes);
+        free(force_readers.offsets);
+        free(force_readers.grid_map);
+    }
+    free(force_readers.counts);
+    free(force_readers.displs);
+    free(force_readers.grid);
+    free(force_readers.sendbuf);
+    free(force_readers.requests);
+    memset(&force_readers, 0, sizeof(force_readers));
+}
+
+/******************************************************************************
+ * @brief    Read a forcing field on a reader and put it in the order of the
+ *           processes.
+ * @details  nsteps slices of the field are stored in send, the share of each
+ *           process slice after slice, as the processes expect it in var
+ *           (see scatter_field_double_steps()).
+ *****************************************************************************/
+static void
+read_reader_field(char   *nc_name,
+                  char   *var_name,
+                  size_t *start,
+                  size_t *count,
+                  size_t  nsteps,
+                  double *send)
+{
+    size_t  ncells;
+    size_t *node_map;
+    double *node;
+    int     i;
+    size_t  j;
+
+    get_nc_field_double(nc_name, var_name, start, count, force_readers.grid);
+    add_vic_io_bytes(IO_PHASE_FORCE, nsteps * force_readers.ncells_total *
+                     sizeof(double));
+
+    for (i = 0; i < force_readers.nprocs; i++) {
+        ncells = (size_t) force_readers.sizes[i];
+        node_map = &(force_readers.grid_map[force_readers.offsets[i]]);
+        node = send + (size_t) force_readers.offsets[i] * nsteps;
+        for (j = 0; j < nsteps; j++) {
+            map_from_grid(sizeof(double), ncells, node_map,
+                          force_readers.grid + j * force_readers.ncells_total,
+                          node + j * ncells);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Read several forcing fields and scatter them
+ * @details  All fields are read from the same file with the same hyperslab.
+ *           On return, vars[k][j * ncells + i] holds sub-step j of field k of
+ *           local cell i. With FORCE_READERS > 1, field k is read and
+ *           scattered by process k % FORCE_READERS; otherwise the fields are
+ *           read one after another with get_scatter_forcing_field().
+ *****************************************************************************/
+void
+get_scatter_forcing_fields(size_t   file_num,
+                           char    *nc_name,
+                           size_t   nfields,
+                           char   **var_names,
+                           int      ndims,
+                           size_t  *start,
+                           size_t  *count,
+                           double **vars)
+{
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern domain_struct local_domain;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+    extern timer_struct  global_timers[N_TIMERS];
+
+    size_t               nsteps;
+    size_t               nlocal;
+    size_t               nreads;
+    size_t               offset;
+    size_t               k;
+    int                  reader;
+    int                  i;
+    int                  status;
+    double              *send;
+
+    if (force_readers.nreaders <= 1) {
+        for (k = 0; k < nfields; k++) {
+            get_scatter_forcing_field(file_num, nc_name, var_names[k], ndims,
+                                      start, count, vars[k]);
+        }
+        return;
+    }
+
+    nsteps = count[0];
+    nlocal = nsteps * local_domain.ncells_active;
+    if (nfields > force_readers.nrequests) {
+        free(force_readers.requests);
+        force_readers.requests =
+            malloc(nfields * sizeof(*(force_readers.requests)));
+        check_alloc_status(force_readers.requests,
+                           "Memory allocation error.");
+        force_readers.nrequests = nfields;
+    }
+
+    // every reader reads its fields, at the same time as the other readers
+    if ((size_t) mpi_rank < force_readers.nreaders) {
+        timer_continue(&(global_timers[TIMER_VIC_FORCE_READ]));
+        nreads = 0;
+        for (k = (size_t) mpi_rank; k < nfields; k += force_readers.nreaders) {
+            nreads++;
+        }
+        if (nreads * nsteps * force_readers.ncells_active >
+            force_readers.sendbuf_size) {
+            free(force_readers.sendbuf);
+            force_readers.sendbuf_size = nreads * nsteps *
+                                         force_readers.ncells_active;
+            force_readers.sendbuf =
+                malloc(force_readers.sendbuf_size *
+                       sizeof(*(force_readers.sendbuf)));
+            check_alloc_status(force_readers.sendbuf,
+                               "Memory allocation error.");
+        }
+        if (nsteps * force_readers.ncells_total > force_readers.grid_size) {
+            free(force_readers.grid);
+            force_readers.grid_size = nsteps * force_readers.ncells_total;
+            force_readers.grid = malloc(force_readers.grid_size *
+                                        sizeof(*(force_readers.grid)));
+            check_alloc_status(force_readers.grid,
+                               "Memory allocation error.");
+        }
+        offset = 0;
+        for (k = (size_t) mpi_rank; k < nfields;
+             k += force_readers.nreaders) {
+            read_reader_field(nc_name, var_names[k], start, count, nsteps,
+                              force_readers.sendbuf + offset);
+            offset += nsteps * force_readers.ncells_active;
+        }
+        for (i = 0; i < mpi_size; i++) {
+            force_readers.counts[i] = force_readers.sizes[i] * (int) nsteps;
+            force_readers.displs[i] = force_readers.offsets[i] * (int) nsteps;
+        }
+        timer_stop(&(global_timers[TIMER_VIC_FORCE_READ]));
+    }
+
+    // the scatters of all fields are in flight at the same time
+    timer_continue(&(global_timers[TIMER_VIC_FORCE_SCATTER]));
+    offset = 0;
+    for (k = 0; k < nfields; k++) {
+        reader = (int) (k % force_readers.nreaders);
+        send = NULL;
+        if (reader == mpi_rank) {
+            send = force_readers.sendbuf + offset;
+            offset += nsteps * force_readers.ncells_active;
+        }
+        status = MPI_Iscatterv(send, force_readers.counts,
+                               force_readers.displs, MPI_DOUBLE, vars[k],
+                               (int) nlocal, MPI_DOUBLE, reader, MPI_COMM_VIC,
+                               &(force_readers.requests[k]));
+        check_mpi_status(status, "MPI error.");
+    }
+    status = MPI_Waitall((int) nfields, force_readers.requests,
+                         MPI_STATUSES_IGNORE);
+    check_mpi_status(status, "MPI error.");
+    timer_stop(&(global_timers[TIMER_VIC_FORCE_SCATTER]));
+}
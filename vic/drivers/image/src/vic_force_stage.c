@@ -0,0 +1,287 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Staging of the meteorological forcing files on a local directory.
+ *
+ * With FORCE_STAGE_DIR, every process that reads the forcings copies the
+ * forcing file that follows the one in use (the next file of the forcing
+ * catalog, or the file of the next year) to the directory on a background
+ * thread, e.g. to the local disk of its node. When the model reaches that
+ * file, it is read from the local copy and the copy of the previous file is
+ * removed. A file that was not staged in time, or that was not predicted
+ * (e.g. at the restart of a spin-up cycle), is read from its original
+ * location. Only the files of FORCING1 are staged.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+#include <sys/stat.h>
+
+#define FORCE_STAGE_BUFSIZE 4194304
+
+static force_stage_struct force_stage;
+
+/******************************************************************************
+ * @brief    Copy the next forcing file to its local name.
+ * @details  Runs on the stager thread. The copy is written to a temporary
+ *           file that is renamed when it is complete, so that a copy that
+ *           failed is never read.
+ *****************************************************************************/
+static void *
+copy_forcing_file(void *arg)
+{
+    force_stage_struct *stage = (force_stage_struct *) arg;
+    char                part_name[MAXSTRING];
+    char               *buf;
+    FILE               *src;
+    FILE               *dst;
+    size_t              nbytes;
+    bool                ok;
+
+    stage->next_ready = false;
+    snprintf(part_name, MAXSTRING, "%s.part", stage->next_local);
+
+    buf = malloc(FORCE_STAGE_BUFSIZE);
+    if (buf == NULL) {
+        return NULL;
+    }
+    src = fopen(stage->next, "rb");
+    if (src == NULL) {
+        free(buf);
+        return NULL;
+    }
+    dst = fopen(part_name, "wb");
+    if (dst == NULL) {
+        fclose(src);
+        free(buf);
+        return NULL;
+    }
+
+    ok = true;
+    while ((nbytes = fread(buf, 1, FORCE_STAGE_BUFSIZE, src)) > 0) {
+        if (fwrite(buf, 1, nbytes, dst) != nbytes) {
+            ok = false;
+            break;
+        }
+    }
+    if (ferror(src)) {
+        ok = false;
+    }
+    fclose(src);
+    if (fclose(dst) != 0) {
+        ok = false;
+    }
+    free(buf);
+
+    if (ok && rename(part_name, stage->next_local) == 0) {
+        stage->next_ready = true;
+    }
+    else {
+        remove(part_name);
+    }
+
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief    Wait for the stager thread.
+ *****************************************************************************/
+static void
+wait_force_stage(void)
+{
+    int status;
+
+    if (force_stage.active) {
+        status = pthread_join(force_stage.thread, NULL);
+        if (status != 0) {
+            log_err("Could not join forcing stager thread: %d", status);
+        }
+        force_stage.active = false;
+    }
+}
+
+/******************************************************************************
+ * @brief    Start the copy of a forcing file to the staging directory.
+ *****************************************************************************/
+static void
+start_force_stage(char *nc_name)
+{
+    extern filenames_struct filenames;
+    extern int              mpi_rank;
+
+    char                   *base;
+    int                     status;
+
+    base = strrchr(nc_name, '/');
+    base = (base == NULL) ? nc_name : base + 1;
+
+    strcpy(force_stage.next, nc_name);
+    snprintf(force_stage.next_local, MAXSTRING, "%s/vic_stage.%d.%s",
+             filenames.force_stage, mpi_rank, base);
+    force_stage.next_ready = false;
+
+    status = pthread_create(&(force_stage.thread), NULL, copy_forcing_file,
+                            &force_stage);
+    if (status != 0) {
+        log_err("Could not start forcing stager thread: %d", status);
+    }
+    force_stage.active = true;
+}
+
+/******************************************************************************
+ * @brief    Set up the staging of the forcing files.
+ *****************************************************************************/
+void
+vic_force_stage_init(void)
+{
+    extern filenames_struct filenames;
+    extern option_struct    options;
+    extern int              mpi_rank;
+
+    struct stat             st;
+
+    force_stage.enabled = false;
+    force_stage.active = false;
+    force_stage.next_ready = false;
+    force_stage.current[0] = '\0';
+    force_stage.current_local[0] = '\0';
+    force_stage.next[0] = '\0';
+    force_stage.next_local[0] = '\0';
+
+    if (strcasecmp(filenames.force_stage, "MISSING") == 0) {
+        return;
+    }
+    // only the processes that read the forcing files stage them
+    if (mpi_rank != VIC_MPI_ROOT &&
+        (size_t) mpi_rank >= options.FORCE_READERS) {
+        return;
+    }
+
+    if (stat(filenames.force_stage, &st) != 0) {
+        if (mkdir(filenames.force_stage, 0755) != 0 &&
+            stat(filenames.force_stage, &st) != 0) {
+            log_err("Unable to create FORCE_STAGE_DIR %s",
+                    filenames.force_stage);
+        }
+    }
+    else if (!S_ISDIR(st.st_mode)) {
+        log_err("FORCE_STAGE_DIR %s is not a directory",
+                filenames.force_stage);
+    }
+
+    force_stage.enabled = true;
+}
+
+/******************************************************************************
+ * @brief    Stop the staging and remove the local copies.
+ *****************************************************************************/
+void
+vic_force_stage_finalize(void)
+{
+    if (!force_stage.enabled) {
+        return;
+    }
+
+    wait_force_stage();
+    if (force_stage.next_ready) {
+        remove(force_stage.next_local);
+        force_stage.next_ready = false;
+    }
+    if (force_stage.current_local[0] != '\0') {
+        remove(force_stage.current_local);
+        force_stage.current_local[0] = '\0';
+    }
+    force_stage.enabled = false;
+}
+
+/******************************************************************************
+ * @brief    Get the name to read a forcing file from.
+ *
+ * @details  At a new forcing file, the staged copy is used if it is
+ *           complete, the copy of the previous file is removed, and the copy
+ *           of the file that follows is started.
+ *
+ * @param    nc_name    forcing file of FORCING1 in original location
+ * @param    year       year of the forcing file
+ * @param    read_name  name of the file to read
+ *****************************************************************************/
+void
+get_staged_forcing_file(char              *nc_name,
+                        unsigned short int year,
+                        char              *read_name)
+{
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern option_struct       options;
+
+    char                       next_name[MAXSTRING];
+    bool                       next;
+
+    if (!force_stage.enabled) {
+        strcpy(read_name, nc_name);
+        return;
+    }
+
+    if (strcmp(nc_name, force_stage.current) != 0) {
+        wait_force_stage();
+
+        // the copy of the previous file is no longer needed
+        if (force_stage.current_local[0] != '\0') {
+            remove(force_stage.current_local);
+            force_stage.current_local[0] = '\0';
+        }
+
+        strcpy(force_stage.current, nc_name);
+        if (force_stage.next_ready &&
+            strcmp(force_stage.next, nc_name) == 0) {
+            strcpy(force_stage.current_local, force_stage.next_local);
+        }
+        else if (force_stage.next_ready) {
+            // the staged file was not the one that is needed
+            remove(force_stage.next_local);
+        }
+        force_stage.next_ready = false;
+
+        // the file that follows
+        if (options.FORCE_CATALOG) {
+            next = get_force_catalog_next_file(nc_name, next_name);
+        }
+        else if (year < global_param.endyear) {
+            sprintf(next_name, "%s%4d.nc", filenames.f_path_pfx[0],
+                    year + 1);
+            next = true;
+        }
+        else {
+            next = false;
+        }
+        if (next) {
+            start_force_stage(next_name);
+        }
+    }
+
+    if (force_stage.current_local[0] != '\0') {
+        strcpy(read_name, force_stage.current_local);
+    }
+    else {
+        strcpy(read_name, nc_name);
+    }
+}
@@ -0,0 +1,183 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Synthetic meteorological forcings of COMPUTE_BENCHMARK.
+ *
+ * With COMPUTE_BENCHMARK = TRUE, the forcings are generated in memory instead
+ * of being read, so that the cost of vic_run and put_data can be measured
+ * without the cost of the I/O. The forcings of a cell are smooth seasonal
+ * and diurnal cycles, whose amplitudes, phases and precipitation events are
+ * drawn from a hash of the cell number and the day, so that a run is
+ * reproducible for any domain decomposition:
+ *
+ * - air temperature: an annual mean that decreases with latitude and
+ *   elevation, a seasonal cycle with its maximum in the summer of the
+ *   hemisphere and a diurnal cycle with its maximum in the afternoon;
+ * - precipitation: a wet day with a probability of SYNTH_WET_PROB, with an
+ *   amount of up to SYNTH_MAX_PREC, evenly over the sub-steps of the day;
+ * - shortwave: the top of atmosphere irradiance scaled by a transmissivity
+ *   that is lower on wet days, with the cosine of the solar zenith angle;
+ * - longwave: a constant emissivity of the sky;
+ * - vapor pressure: a relative humidity that is higher on wet days;
+ * - pressure: the standard atmosphere at the elevation of the cell;
+ * - wind speed: a daily mean with a diurnal cycle.
+ *
+ * The channel inflow of the lakes is zero, the CO2 mixing ratio is constant,
+ * and half of the shortwave is direct.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * @brief    Uniform random number in [0, 1) of a cell and a key.
+ * @details  The splitmix64 finalizer of the cell number and the key, so that
+ *           the number does not depend on the order of the cells.
+ *****************************************************************************/
+static double
+synthetic_uniform(size_t cell,
+                  size_t key)
+{
+    uint64_t z;
+
+    z = (uint64_t) cell * 0x9E3779B97F4A7C15ULL + (uint64_t) key;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z = z ^ (z >> 31);
+
+    return (double) (z >> 11) / 9007199254740992.;
+}
+
+/******************************************************************************
+ * @brief    Generate the NF sub-steps of the meteorological forcings of the
+ *           current time step.
+ * @details  Called by vic_force with the netCDF lock. Pressure and vapor
+ *           pressure are in kPa, as they are read from the forcing files.
+ *****************************************************************************/
+void
+vic_force_synthetic(void)
+{
+    extern size_t              NF;
+    extern size_t              current;
+    extern force_data_struct  *force;
+    extern dmy_struct          dmy_current;
+    extern domain_struct       local_domain;
+    extern global_param_struct global_param;
+    extern option_struct       options;
+    extern parameters_struct   param;
+    extern soil_con_struct    *soil_con;
+    extern solar_geom_struct  *solar_geom;
+
+    size_t                     ncells;
+    size_t                     cell;
+    size_t                     day;
+    size_t                     i;
+    size_t                     j;
+    unsigned int               second;
+    double                    *coszen;
+    double                     cosdecl;
+    double                     sindecl;
+    double                     season;
+    double                     hour;
+    double                     tmean;
+    double                     tamp;
+    double                     wet;
+    double                     tau;
+    double                     rh;
+    double                     tk;
+
+    ncells = local_domain.ncells_active;
+    coszen = malloc(ncells * sizeof(*coszen));
+    check_alloc_status(coszen, "Memory allocation error.");
+
+    // days since the start of the run, the key of the daily values
+    day = (size_t) (global_param.dt * (double) current / SEC_PER_DAY);
+    // seasonal cycle with its maximum at the end of July in the north
+    season = cos(2. * CONST_PI * (dmy_current.day_in_year - 205.) /
+                 DAYS_PER_YEAR);
+
+    compute_solar_decl(dmy_current.day_in_year, &cosdecl, &sindecl);
+    for (j = 0; j < NF; j++) {
+        // the middle of the sub-step
+        second = dmy_current.dayseconds +
+                 (unsigned int) ((j + 0.5) * global_param.snow_dt);
+        compute_coszen_cells(ncells, solar_geom, cosdecl, sindecl, second,
+                             coszen);
+        for (i = 0; i < ncells; i++) {
+            cell = local_domain.locations[i].global_idx;
+            hour = second / (double) SEC_PER_HOUR + solar_geom[i].hour_offset;
+            wet = synthetic_uniform(cell, 4 * day);
+
+            // the climate of the cell
+            tmean = SYNTH_TMEAN_EQUATOR -
+                    SYNTH_TMEAN_POLE * fabs(solar_geom[i].sinlat) +
+                    param.LAPSE_RATE * soil_con[i].elevation;
+            tamp = SYNTH_TAMP_POLE * solar_geom[i].sinlat * season;
+            force[i].air_temp[j] = tmean + tamp +
+                                   (3. + 4. * synthetic_uniform(cell, SIZE_MAX)) *
+                                   cos(2. * CONST_PI * (hour - 15.) /
+                                       HOURS_PER_DAY);
+
+            force[i].prec[j] = 0.;
+            if (wet < SYNTH_WET_PROB) {
+                force[i].prec[j] = SYNTH_MAX_PREC *
+                                   synthetic_uniform(cell, 4 * day + 1) /
+                                   global_param.snow_steps_per_day;
+            }
+
+            tau = (wet < SYNTH_WET_PROB) ? 0.4 : DISAGG_TAU_MAX;
+            force[i].shortwave[j] = 0.;
+            if (coszen[i] > 0.) {
+                force[i].shortwave[j] = tau * DISAGG_SOLAR_CONST * coszen[i];
+            }
+            tk = force[i].air_temp[j] + CONST_TKFRZ;
+            force[i].longwave[j] = SYNTH_EMISSIVITY * CONST_STEBOL *
+                                   tk * tk * tk * tk;
+
+            rh = (wet < SYNTH_WET_PROB) ? 0.9 :
+                 0.4 + 0.4 * synthetic_uniform(cell, 4 * day + 2);
+            force[i].vp[j] = rh * svp(force[i].air_temp[j]) / PA_PER_KPA;
+            force[i].pressure[j] = CONST_PSTD / PA_PER_KPA *
+                                   exp(-soil_con[i].elevation /
+                                       calc_scale_height(tmean,
+                                                         soil_con[i].
+                                                         elevation));
+            force[i].wind[j] = (1. + 4. * synthetic_uniform(cell,
+                                                            4 * day + 3)) *
+                               (1. + 0.3 * cos(2. * CONST_PI * (hour - 14.) /
+                                               HOURS_PER_DAY));
+
+            if (options.LAKES) {
+                force[i].channel_in[j] = 0.;
+            }
+            if (options.CARBON) {
+                force[i].Catm[j] = SYNTH_CATM * PPM_to_MIXRATIO;
+                force[i].fdir[j] = 0.5;
+                force[i].par[j] = SYNTH_PAR_FRACTION * force[i].shortwave[j];
+                force[i].coszen[j] = coszen[i];
+            }
+        }
+    }
+
+    free(coszen);
+}
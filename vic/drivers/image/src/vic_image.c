@@ -30,14 +30,17 @@ size_t              NF, NR;
 size_t              current;
 size_t             *filter_active_cells = NULL;
 size_t             *mpi_map_mapping_array = NULL;
+size_t             *mpi_map_grid_array = NULL;
 all_vars_struct    *all_vars = NULL;
 force_data_struct  *force = NULL;
-dmy_struct         *dmy = NULL;
+dmy_struct          dmy_current;
 filenames_struct    filenames;
 filep_struct        filep;
 domain_struct       global_domain;
 global_param_struct global_param;
 lake_con_struct    *lake_con = NULL;
+size_t             *lake_cells = NULL;  // [nlake_cells]
+size_t              nlake_cells = 0;
 domain_struct       local_domain;
 MPI_Comm            MPI_COMM_VIC = MPI_COMM_WORLD;
 MPI_Datatype        mpi_global_struct_type;
@@ -53,7 +56,9 @@ int                 mpi_size;
 option_struct       options;
 parameters_struct   param;
 param_set_struct    param_set;
+rout_struct         rout;
 soil_con_struct    *soil_con = NULL;
+solar_geom_struct  *solar_geom = NULL;
 veg_con_map_struct *veg_con_map = NULL;
 veg_con_struct    **veg_con = NULL;
 veg_hist_struct   **veg_hist = NULL;
@@ -64,6 +69,7 @@ save_data_struct   *save_data;  // [ncells]
 double           ***out_data = NULL;  // [ncells, nvars, nelem]
 stream_struct      *output_streams = NULL;  // [nstreams]
 nc_file_struct     *nc_hist_files = NULL;  // [nstreams]
+timer_struct        global_timers[N_TIMERS];
 
 /******************************************************************************
  * @brief   Stand-alone image mode driver of the VIC model
@@ -77,9 +83,10 @@ int
 main(int    argc,
      char **argv)
 {
-    int          status;
-    timer_struct global_timers[N_TIMERS];
-    char         state_filename[MAXSTRING];
+    int    status;
+    int    provided;
+    char   state_filename[MAXSTRING];
+    size_t first_step;
 
     // start vic all timer
     timer_start(&(global_timers[TIMER_VIC_ALL]));
@@ -87,7 +94,9 @@ main(int    argc,
     timer_start(&(global_timers[TIMER_VIC_INIT]));
 
     // Initialize MPI - note: logging not yet initialized
-    status = MPI_Init(&argc, &argv);
+    // Only the main thread makes MPI calls (MPI_THREAD_FUNNELED), the OpenMP
+    // cell loop and the forcing reader thread do not.
+    status = MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     if (status != MPI_SUCCESS) {
         fprintf(stderr, "MPI error in main(): %d\n", status);
         exit(EXIT_FAILURE);
@@ -107,17 +116,38 @@ main(int    argc,
     // read global parameters
     vic_image_start();
 
+    // start the event trace
+    initialize_trace();
+
     // allocate memory
+    trace_begin(TRACE_INIT_ALLOC);
     vic_alloc();
+    trace_end(TRACE_INIT_ALLOC);
 
     // initialize model parameters from parameter files
+    trace_begin(TRACE_INIT_PARAMS);
     vic_image_init();
+    trace_end(TRACE_INIT_PARAMS);
 
     // populate model state, either using a cold start or from a restart file
+    trace_begin(TRACE_INIT_STATE);
     vic_populate_model_state();
+    trace_end(TRACE_INIT_STATE);
 
     // initialize output structures
-    vic_init_output(&(dmy[0]));
+    trace_begin(TRACE_INIT_OUTPUT);
+    vic_init_output(&dmy_current);
+    trace_end(TRACE_INIT_OUTPUT);
+
+    // split off the I/O servers
+    trace_begin(TRACE_INIT_IO_SERVERS);
+    initialize_io_servers();
+    trace_end(TRACE_INIT_IO_SERVERS);
+
+    // read the river network of the inline routing
+    if (!is_io_server()) {
+        rout_init();
+    }
 
     // Initialization is complete, print settings
     log_info(
@@ -125,29 +155,97 @@ main(int    argc,
     print_global_param(&global_param);
     print_option(&options);
 
+    // memory high-water mark at the end of the initialization
+    sample_vic_memory(MEMORY_AT_INIT);
+
     // stop init timer
     timer_stop(&(global_timers[TIMER_VIC_INIT]));
     // start vic run timer
     timer_start(&(global_timers[TIMER_VIC_RUN]));
 
-    // loop over all timesteps
-    for (current = 0; current < global_param.nrecs; current++) {
-        // read forcing data
-        vic_force();
+    if (is_io_server()) {
+        // write the history files of the compute processes
+        vic_io_server();
+        sample_vic_memory(MEMORY_AT_WRITE);
+    }
+    else {
+        // resume from the checkpoint of a preempted run, or spin up the
+        // model state on the first years of forcings
+        initialize_checkpoint();
+        first_step = restore_checkpoint();
+        if (first_step == 0) {
+            vic_spinup();
+        }
+
+        // log the progress of the run
+        initialize_heartbeat();
+
+        // connect to the data assimilation program
+        initialize_da();
+
+        // loop over all timesteps
+        for (current = first_step; current < global_param.nrecs; current++) {
+            trace_begin(TRACE_TIME_STEP);
+
+            // date of the current time step
+            dmy_from_step(&global_param, current, &dmy_current);
 
-        // run vic over the domain
-        vic_image_run(&(dmy[current]));
+            // read forcing data
+            vic_force();
+            sample_vic_memory(MEMORY_AT_FORCE);
 
-        // Write history files
-        vic_write_output(&(dmy[current]));
+            // run vic over the domain
+            vic_image_run(&dmy_current);
+            sample_vic_memory(MEMORY_AT_RUN);
 
-        // Write state file
-        if (check_save_state_flag(current)) {
-            debug("writing state file for timestep %zu", current);
-            vic_store(&(dmy[current]), state_filename);
-            debug("finished storing state file: %s", state_filename)
+            // route the runoff and write the streamflow at the gauges
+            rout_run(&dmy_current);
+
+            // the netCDF library is not thread-safe: wait for the forcing
+            // reader
+            vic_force_prefetch_wait();
+
+            // Write history files, the output of COMPUTE_BENCHMARK is
+            // discarded
+            if (!options.COMPUTE_BENCHMARK) {
+                vic_write_output(&dmy_current);
+            }
+            sample_vic_memory(MEMORY_AT_WRITE);
+
+            // Write state file
+            if (check_save_state_flag(current) &&
+                !options.COMPUTE_BENCHMARK) {
+                debug("writing state file for timestep %zu", current);
+                vic_store(&dmy_current, state_filename);
+                sample_vic_memory(MEMORY_AT_STATE);
+                debug("finished storing state file: %s", state_filename)
+            }
+
+            // log the progress of the run
+            update_heartbeat(&dmy_current);
+
+            // evaluate the decomposition on the measured cell costs
+            update_load_balance();
+
+            // exchange the state with the data assimilation program
+            vic_da();
+
+            trace_end(TRACE_TIME_STEP);
+
+            // stop after this time step if the run is being preempted
+            if (check_checkpoint_signal()) {
+                vic_checkpoint();
+                break;
+            }
         }
+        finalize_heartbeat();
+        finalize_checkpoint();
+        finalize_da();
+
+        // write the wall time of vic_run per grid cell
+        write_cost_map();
     }
+    finalize_io_servers();
     // stop vic run timer
     timer_stop(&(global_timers[TIMER_VIC_RUN]));
     // start vic final timer
@@ -155,6 +253,12 @@ main(int    argc,
     // clean up
     vic_image_finalize();
 
+    // range of the phase timers over the processes
+    reduce_vic_phase_timers(global_timers);
+
+    // write the event trace
+    write_trace();
+
     // finalize MPI
     status = MPI_Finalize();
     if (status != MPI_SUCCESS) {
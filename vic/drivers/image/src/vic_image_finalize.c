@@ -32,10 +32,15 @@
 void
 vic_image_finalize(void)
 {
-    extern dmy_struct *dmy;
+    extern solar_geom_struct *solar_geom;
 
     // free data structures specific to to image driver
-    free(dmy);
+    vic_force_prefetch_finalize();
+    vic_force_finalize();
+    vic_force_disagg_finalize();
+    finalize_force_catalog();
+    rout_finalize();
+    free(solar_geom);
 
     vic_finalize();
 }
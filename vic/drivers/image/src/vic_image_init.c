@@ -32,12 +32,37 @@
 void
 vic_image_init(void)
 {
-    extern dmy_struct         *dmy;
+    extern dmy_struct          dmy_current;
+    extern domain_struct       local_domain;
     extern global_param_struct global_param;
+    extern option_struct       options;
+    extern soil_con_struct    *soil_con;
+    extern solar_geom_struct  *solar_geom;
 
-    // make_dmy()
+    size_t                     i;
+
+    // time steps of the simulation
     initialize_time();
-    dmy = make_dmy(&global_param);
+    initialize_time_steps(&global_param);
+    dmy_from_step(&global_param, 0, &dmy_current);
 
     vic_init();
+
+    // time-invariant solar geometry for the solar zenith angle
+    if (options.CARBON || options.FORCE_DISAGG) {
+        solar_geom = malloc(local_domain.ncells_active * sizeof(*solar_geom));
+        check_alloc_status(solar_geom, "Memory allocation error.");
+        for (i = 0; i < local_domain.ncells_active; i++) {
+            compute_solar_geom(local_domain.locations[i].latitude,
+                               local_domain.locations[i].longitude,
+                               soil_con[i].time_zone_lng, &(solar_geom[i]));
+        }
+    }
+
+    // persistent workspace of vic_force
+    vic_force_init();
+    vic_force_disagg_init();
+
+    // wall time of vic_run per grid cell
+    initialize_cost_map();
 }
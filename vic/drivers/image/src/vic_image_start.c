@@ -47,4 +47,7 @@ vic_image_start(void)
 
     // initialize image mode structures and settings
     vic_start();
+
+    // the forcing files are looked up on all nodes
+    broadcast_force_catalog();
 }
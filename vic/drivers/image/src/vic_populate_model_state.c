@@ -33,10 +33,13 @@
 #include <vic_driver_image.h>
 
 /******************************************************************************
- * @brief    This function handles tasks related to populating model state.
+ * @brief    Generate the default state of a block of cells, if there is no
+ *           initial state, and compute the state variables that are derived
+ *           from the others.
  *****************************************************************************/
-void
-vic_populate_model_state(void)
+static void
+populate_cell_block(size_t n,
+                    size_t block)
 {
     extern all_vars_struct *all_vars;
     extern lake_con_struct *lake_con;
@@ -46,28 +49,68 @@ vic_populate_model_state(void)
     extern veg_con_struct **veg_con;
 
     size_t                  i;
+    size_t                  last;
 
-    // read the model state from the netcdf file if there is one
-    if (options.INIT_STATE) {
-        vic_restore();
+    last = (n + 1) * block;
+    if (last > local_domain.ncells_active) {
+        last = local_domain.ncells_active;
     }
-    else {
-        // else generate a default state
-        for (i = 0; i < local_domain.ncells_active; i++) {
+    for (i = n * block; i < last; i++) {
+        if (!options.INIT_STATE) {
             generate_default_state(&(all_vars[i]), &(soil_con[i]), veg_con[i]);
-            if (options.LAKES) {
+            if (all_vars[i].lake_var != NULL) {
                 generate_default_lake_state(&(all_vars[i]), &(soil_con[i]),
                                             lake_con[i]);
             }
         }
-    }
 
-    // compute those state variables that are derived from the others
-    for (i = 0; i < local_domain.ncells_active; i++) {
         compute_derived_state_vars(&(all_vars[i]), &(soil_con[i]), veg_con[i]);
-        if (options.LAKES) {
-            compute_derived_lake_dimensions(&(all_vars[i].lake_var),
-                                            lake_con[i]);
+        if (all_vars[i].lake_var != NULL) {
+            compute_derived_lake_dimensions(all_vars[i].lake_var,
+                                            &(lake_con[i]));
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    This function handles tasks related to populating model state.
+ * @details  The cells are independent of each other once the state file is
+ *           read, and are populated by the threads of vic_image_run(), in
+ *           its blocks of cells. With NUMA_FIRST_TOUCH, each thread
+ *           populates the blocks it first touched in vic_alloc().
+ *****************************************************************************/
+void
+vic_populate_model_state(void)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+
+    size_t               block;
+    size_t               nblocks;
+    size_t               n;
+
+    // read the model state from the netcdf file if there is one
+    if (options.INIT_STATE) {
+        vic_restore();
+    }
+
+    // else generate a default state, and compute those state variables that
+    // are derived from the others
+    block = get_run_block_size();
+    nblocks = (local_domain.ncells_active + block - 1) / block;
+    #pragma omp parallel num_threads(options.NTHREADS)
+    {
+        if (options.NUMA_FIRST_TOUCH) {
+            #pragma omp for schedule(static)
+            for (n = 0; n < nblocks; n++) {
+                populate_cell_block(n, block);
+            }
+        }
+        else {
+            #pragma omp for schedule(dynamic, 1)
+            for (n = 0; n < nblocks; n++) {
+                populate_cell_block(n, block);
+            }
         }
     }
 }
@@ -0,0 +1,517 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Spin-up of the model state on a recycled period of forcings.
+ *
+ * With SPINUP_CYCLES > 0, the first SPINUP_YEARS years of the simulation
+ * period are run SPINUP_CYCLES times before the simulation starts. The
+ * forcings of the local cells are read from the forcing files in the first
+ * cycle only. They are kept in memory as vic_force left them, so that the
+ * later cycles do not touch the forcing files. With SPINUP_FLOAT, they are
+ * kept in single precision, which halves the size of the cache but changes
+ * the forcings of the later cycles in the last digits.
+ *
+ * The spin-up cycles write no history or state files. If SPINUP_TOL > 0,
+ * the spin-up stops after the first cycle in which the water storage (soil
+ * moisture and snow water equivalent) of no cell changed by more than
+ * SPINUP_TOL mm. The simulation then starts from the spun-up state at the
+ * start of the simulation period.
+ *
+ * In the cycles after the first, the forcings of all time steps are in
+ * memory and the cells are independent of each other. With
+ * SPINUP_BLOCK_STEPS > 1, each cell is therefore advanced that many time
+ * steps at a time while its state is in cache, before the thread moves on to
+ * the next cell. This gives the same results as advancing all cells one time
+ * step at a time.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_image.h>
+
+#define MAX_SPINUP_SERIES 14
+
+static size_t  spinup_nvalues;          // cached values per time step
+static size_t  spinup_veg_offset;       // vegetation history in a time step
+static size_t *spinup_offsets = NULL;   // forcings of each cell in a time
+                                        // step [ncells]
+static double *spinup_dcache = NULL;    // [nsteps, nvalues]
+static float  *spinup_fcache = NULL;    // [nsteps, nvalues]
+
+/******************************************************************************
+ * @brief    Collect the forcing series of a cell, except the snow flag.
+ *****************************************************************************/
+static size_t
+get_force_series(force_data_struct *force,
+                 double           **series)
+{
+    extern option_struct options;
+
+    size_t               n = 0;
+
+    series[n++] = force->air_temp;
+    series[n++] = force->density;
+    series[n++] = force->longwave;
+    series[n++] = force->prec;
+    series[n++] = force->pressure;
+    series[n++] = force->shortwave;
+    series[n++] = force->vp;
+    series[n++] = force->vpd;
+    series[n++] = force->wind;
+    if (options.LAKES) {
+        series[n++] = force->channel_in;
+    }
+    if (options.CARBON) {
+        series[n++] = force->Catm;
+        series[n++] = force->coszen;
+        series[n++] = force->fdir;
+        series[n++] = force->par;
+    }
+
+    return n;
+}
+
+/******************************************************************************
+ * @brief    Copy a series into or out of the spin-up cache.
+ *****************************************************************************/
+static void
+move_spinup_series(double *series,
+                   size_t  n,
+                   size_t  offset,
+                   bool    store)
+{
+    extern option_struct options;
+
+    size_t               k;
+
+    if (options.SPINUP_FLOAT) {
+        if (store) {
+            for (k = 0; k < n; k++) {
+                spinup_fcache[offset + k] = (float) series[k];
+            }
+        }
+        else {
+            for (k = 0; k < n; k++) {
+                series[k] = (double) spinup_fcache[offset + k];
+            }
+        }
+    }
+    else if (store) {
+        memcpy(spinup_dcache + offset, series, n * sizeof(*series));
+    }
+    else {
+        memcpy(series, spinup_dcache + offset, n * sizeof(*series));
+    }
+}
+
+/******************************************************************************
+ * @brief    Copy the snow flags of a cell into or out of the spin-up cache.
+ *****************************************************************************/
+static void
+move_spinup_flags(bool  *flags,
+                  size_t n,
+                  size_t offset,
+                  bool   store)
+{
+    extern option_struct options;
+
+    size_t               k;
+
+    if (options.SPINUP_FLOAT) {
+        for (k = 0; k < n; k++) {
+            if (store) {
+                spinup_fcache[offset + k] = flags[k] ? 1. : 0.;
+            }
+            else {
+                flags[k] = spinup_fcache[offset + k] > 0.5;
+            }
+        }
+    }
+    else {
+        for (k = 0; k < n; k++) {
+            if (store) {
+                spinup_dcache[offset + k] = flags[k] ? 1. : 0.;
+            }
+            else {
+                flags[k] = spinup_dcache[offset + k] > 0.5;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Copy the forcings of a cell for a time step into or out of the
+ *           cache.
+ * @details  The values of a time step are the forcing series of all cells,
+ *           each followed by its snow flags, then the vegetation history
+ *           slab. Different cells can be copied by different threads.
+ *****************************************************************************/
+static void
+move_spinup_cell(size_t step,
+                 size_t i,
+                 bool   store)
+{
+    extern force_data_struct  *force;
+    extern veg_con_map_struct *veg_con_map;
+    extern veg_hist_struct   **veg_hist;
+
+    double                    *series[MAX_SPINUP_SERIES];
+    size_t                     offset;
+    size_t                     nseries;
+    size_t                     k;
+
+    offset = step * spinup_nvalues + spinup_offsets[i];
+    nseries = get_force_series(&(force[i]), series);
+    for (k = 0; k < nseries; k++) {
+        move_spinup_series(series[k], NR + 1, offset, store);
+        offset += NR + 1;
+    }
+    move_spinup_flags(force[i].snowflag, NR + 1, offset, store);
+
+    // the tiles of a cell are contiguous in the vegetation history slab,
+    // see vic_alloc
+    if (veg_con_map[i].nv_active > 0) {
+        offset = step * spinup_nvalues + spinup_veg_offset +
+                 (size_t) (veg_hist[i] - veg_hist[0]) * 5 * (NR + 1);
+        move_spinup_series(veg_hist[i][0].albedo,
+                           veg_con_map[i].nv_active * 5 * (NR + 1), offset,
+                           store);
+    }
+}
+
+/******************************************************************************
+ * @brief    Soil moisture and snow water equivalent of each cell (mm).
+ *****************************************************************************/
+static void
+get_water_storage(double *storage)
+{
+    extern all_vars_struct *all_vars;
+    extern domain_struct    local_domain;
+    extern option_struct    options;
+    extern soil_con_struct *soil_con;
+    extern veg_con_struct **veg_con;
+
+    double                  fract;
+    size_t                  i;
+    size_t                  veg;
+    size_t                  nveg;
+    size_t                  band;
+    size_t                  l;
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        storage[i] = 0.;
+        nveg = veg_con[i][0].vegetat_type_num;
+        for (veg = 0; veg <= nveg; veg++) {
+            if (veg_con[i][veg].Cv <= 0.) {
+                continue;
+            }
+            for (band = 0; band < options.SNOW_BAND; band++) {
+                fract = veg_con[i][veg].Cv * soil_con[i].AreaFract[band];
+                if (fract <= 0.) {
+                    continue;
+                }
+                for (l = 0; l < options.Nlayer; l++) {
+                    storage[i] += fract *
+                                  all_vars[i].cell[veg][band].layer[l].moist;
+                }
+                storage[i] += fract * all_vars[i].snow[veg][band].swq *
+                              MM_PER_M;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Advance the cells of one block over nblock_steps time steps of
+ *           the spin-up.
+ * @details  With load, the forcings of each cell are copied out of the cache
+ *           before each of its time steps. Otherwise, vic_force left the
+ *           forcings of the single time step in force.
+ *****************************************************************************/
+static void
+run_spinup_block(size_t      n,
+                 size_t      block,
+                 size_t      first_step,
+                 size_t      nblock_steps,
+                 bool        load,
+                 dmy_struct *dmys)
+{
+    extern all_vars_struct    *all_vars;
+    extern force_data_struct  *force;
+    extern domain_struct       local_domain;
+    extern global_param_struct global_param;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_struct    **veg_con;
+    extern veg_hist_struct   **veg_hist;
+    extern veg_lib_struct    **veg_lib;
+
+    size_t                     i;
+    size_t                     k;
+    size_t                     last;
+
+    last = (n + 1) * block;
+    if (last > local_domain.ncells_active) {
+        last = local_domain.ncells_active;
+    }
+    for (i = n * block; i < last; i++) {
+        // Set thread-local reference (for debugging inside vic_run)
+        vic_run_ref.id_name = "io_idx";
+        vic_run_ref.id = local_domain.locations[i].io_idx;
+
+        for (k = 0; k < nblock_steps; k++) {
+            if (load) {
+                move_spinup_cell(first_step + k, i, false);
+            }
+            vic_run_ref.dmy = &(dmys[k]);
+
+            update_step_vars(&(all_vars[i]), veg_con[i], veg_hist[i]);
+            vic_run(&(force[i]), &(all_vars[i]), &(dmys[k]), &global_param,
+                    get_lake_con(i), &(soil_con[i]), veg_con[i], veg_lib[i]);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Advance the local domain over nblock_steps time steps of the
+ *           spin-up.
+ * @details  Same cell loop as vic_image_run, but without put_data and the
+ *           aggregation of the output streams.
+ *****************************************************************************/
+static void
+run_spinup_steps(size_t      first_step,
+                 size_t      nblock_steps,
+                 bool        load,
+                 dmy_struct *dmys)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+
+    size_t               n;
+    size_t               block;
+    size_t               nblocks;
+
+    block = get_run_block_size();
+    nblocks = (local_domain.ncells_active + block - 1) / block;
+
+    if (options.NUMA_FIRST_TOUCH) {
+        #pragma omp parallel for num_threads(options.NTHREADS) \
+        schedule(static)
+        for (n = 0; n < nblocks; n++) {
+            run_spinup_block(n, block, first_step, nblock_steps, load, dmys);
+        }
+    }
+    else {
+        #pragma omp parallel for num_threads(options.NTHREADS) \
+        schedule(dynamic, 1)
+        for (n = 0; n < nblocks; n++) {
+            run_spinup_block(n, block, first_step, nblock_steps, load, dmys);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Spin up the model state before the simulation.
+ *****************************************************************************/
+void
+vic_spinup(void)
+{
+    extern size_t              current;
+    extern all_vars_struct    *all_vars;
+    extern dmy_struct          dmy_current;
+    extern force_data_struct  *force;
+    extern global_param_struct global_param;
+    extern domain_struct       local_domain;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern option_struct       options;
+    extern double           ***out_data;
+    extern save_data_struct   *save_data;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_map_struct *veg_con_map;
+    extern veg_con_struct    **veg_con;
+    extern veg_lib_struct    **veg_lib;
+
+    double                    *series[MAX_SPINUP_SERIES];
+    double                    *storage = NULL;
+    double                    *storage_last = NULL;
+    double                    *swap;
+    dmy_struct                *dmys;
+    double                     change;
+    double                     max_change;
+    unsigned short int         forceoffset[2];
+    unsigned int               forceskip[2];
+    size_t                     nsteps;
+    size_t                     nveg;
+    size_t                     nblock_steps;
+    size_t                     cycle;
+    size_t                     step;
+    size_t                     i;
+    size_t                     k;
+    int                        status;
+    dmy_struct                 dmy;
+    timer_struct               timer;
+
+    if (global_param.spinup_cycles == 0) {
+        return;
+    }
+
+    // number of time steps in the spin-up period
+    for (nsteps = 0; nsteps < global_param.nrecs; nsteps++) {
+        dmy_from_step(&global_param, nsteps, &dmy);
+        if ((size_t) dmy.year >=
+            global_param.startyear + global_param.spinup_years) {
+            break;
+        }
+    }
+    if (nsteps == global_param.nrecs) {
+        log_warn("SPINUP_YEARS is longer than the simulation period, the "
+                 "spin-up cycles cover the whole simulation period.");
+    }
+
+    // number of cached values per time step and the position of the
+    // forcings of each cell
+    spinup_offsets = malloc(local_domain.ncells_active *
+                            sizeof(*spinup_offsets));
+    check_alloc_status(spinup_offsets, "Memory allocation error.");
+    spinup_nvalues = 0;
+    nveg = 0;
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        spinup_offsets[i] = spinup_nvalues;
+        spinup_nvalues += (get_force_series(&(force[i]), series) + 1) *
+                          (NR + 1);
+        nveg += veg_con_map[i].nv_active;
+    }
+    spinup_veg_offset = spinup_nvalues;
+    spinup_nvalues += nveg * 5 * (NR + 1);
+
+    if (options.SPINUP_FLOAT) {
+        spinup_fcache = malloc(nsteps * spinup_nvalues *
+                               sizeof(*spinup_fcache));
+        check_alloc_status(spinup_fcache, "Memory allocation error.");
+    }
+    else {
+        spinup_dcache = malloc(nsteps * spinup_nvalues *
+                               sizeof(*spinup_dcache));
+        check_alloc_status(spinup_dcache, "Memory allocation error.");
+    }
+    log_info("Spin-up: %zu cycles of %zu time steps, %.1f MB of forcings "
+             "cached on this process", global_param.spinup_cycles, nsteps,
+             (double) nsteps * spinup_nvalues *
+             (options.SPINUP_FLOAT ? sizeof(float) : sizeof(double)) /
+             (1024. * 1024.));
+
+    dmys = malloc(global_param.spinup_block_steps * sizeof(*dmys));
+    check_alloc_status(dmys, "Memory allocation error.");
+    storage = malloc(local_domain.ncells_active * sizeof(*storage));
+    check_alloc_status(storage, "Memory allocation error.");
+    storage_last = malloc(local_domain.ncells_active * sizeof(*storage_last));
+    check_alloc_status(storage_last, "Memory allocation error.");
+    get_water_storage(storage_last);
+
+    // vic_force advances the offsets into the forcing files
+    for (i = 0; i < 2; i++) {
+        forceoffset[i] = global_param.forceoffset[i];
+        forceskip[i] = global_param.forceskip[i];
+    }
+
+    for (cycle = 0; cycle < global_param.spinup_cycles; cycle++) {
+        if (cycle == 0) {
+            // the forcings are read and cached one time step at a time
+            for (step = 0; step < nsteps; step++) {
+                current = step;
+                dmy_from_step(&global_param, step, &dmy_current);
+                vic_force();
+                for (i = 0; i < local_domain.ncells_active; i++) {
+                    move_spinup_cell(step, i, true);
+                }
+                run_spinup_steps(step, 1, false, &dmy_current);
+            }
+        }
+        else {
+            for (step = 0; step < nsteps; step += nblock_steps) {
+                nblock_steps = global_param.spinup_block_steps;
+                if (nblock_steps > nsteps - step) {
+                    nblock_steps = nsteps - step;
+                }
+                for (k = 0; k < nblock_steps; k++) {
+                    dmy_from_step(&global_param, step + k, &(dmys[k]));
+                }
+                current = step + nblock_steps - 1;
+                dmy_current = dmys[nblock_steps - 1];
+                run_spinup_steps(step, nblock_steps, true, dmys);
+            }
+        }
+        if (cycle == 0) {
+            // the forcings of the time step after the spin-up period
+            vic_force_prefetch_wait();
+        }
+
+        // largest change of the water storage over the cycle
+        get_water_storage(storage);
+        max_change = 0.;
+        for (i = 0; i < local_domain.ncells_active; i++) {
+            change = fabs(storage[i] - storage_last[i]);
+            if (change > max_change) {
+                max_change = change;
+            }
+        }
+        status = MPI_Allreduce(MPI_IN_PLACE, &max_change, 1, MPI_DOUBLE,
+                               MPI_MAX, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        log_info("Spin-up cycle %zu of %zu: largest change in water storage "
+                 "%.4f mm", cycle + 1, global_param.spinup_cycles,
+                 max_change);
+        if (global_param.spinup_tol > 0. &&
+            max_change < global_param.spinup_tol) {
+            log_info("Spin-up converged after %zu cycles", cycle + 1);
+            break;
+        }
+        swap = storage_last;
+        storage_last = storage;
+        storage = swap;
+    }
+
+    // the simulation starts over at the start of the forcing files
+    for (i = 0; i < 2; i++) {
+        global_param.forceoffset[i] = forceoffset[i];
+        global_param.forceskip[i] = forceskip[i];
+    }
+    current = 0;
+
+    // the water and energy balances start from the spun-up state
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        initialize_save_data(&(all_vars[i]), &(force[i]), &(soil_con[i]),
+                             veg_con[i], veg_lib[i], get_lake_con(i),
+                             out_data[i], &(save_data[i]), &timer);
+        save_data[i].balance_cell =
+            (local_domain.locations[i].global_idx %
+             options.BALANCE_CHECK_N == 0);
+    }
+
+    free(storage);
+    free(storage_last);
+    free(spinup_dcache);
+    spinup_dcache = NULL;
+    free(spinup_fcache);
+    spinup_fcache = NULL;
+    free(spinup_offsets);
+    spinup_offsets = NULL;
+    free(dmys);
+}
@@ -31,4 +31,91 @@
 
 #define VIC_DRIVER "Python"
 
+/******************************************************************************
+ * @brief   Forcing variables of a batch run, in the order of the last
+ *          dimension of the forcing array
+ *****************************************************************************/
+enum
+{
+    BATCH_AIR_TEMP,    /**< air temperature (C) */
+    BATCH_PREC,        /**< precipitation (mm) */
+    BATCH_PRESSURE,    /**< atmospheric pressure (kPa) */
+    BATCH_SWDOWN,      /**< incoming shortwave radiation (W/m2) */
+    BATCH_LWDOWN,      /**< incoming longwave radiation (W/m2) */
+    BATCH_VP,          /**< vapor pressure (kPa) */
+    BATCH_WIND,        /**< wind speed (m/s) */
+    BATCH_CATM,        /**< atmospheric CO2 mixing ratio (CARBON only) */
+    BATCH_FDIR,        /**< fraction of shortwave that is direct (CARBON only) */
+    BATCH_PAR,         /**< photosynthetically active radiation (CARBON only) */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_BATCH_FORCING    /**< used as a loop counter */
+};
+
+/******************************************************************************
+ * @brief   Soil parameters of a calibration, see vic_set_soil_param
+ *****************************************************************************/
+enum
+{
+    CALIB_B_INFILT,    /**< infiltration shape parameter (-) */
+    CALIB_DS,          /**< fraction of Dsmax where nonlinear baseflow starts */
+    CALIB_DSMAX,       /**< maximum baseflow velocity (mm/day) */
+    CALIB_WS,          /**< fraction of the maximum moisture of the bottom
+                            layer where nonlinear baseflow starts */
+    CALIB_C,           /**< exponent of the baseflow curve (-) */
+    CALIB_EXPT,        /**< exponent of the Campbell conductivity of a layer */
+    CALIB_KSAT,        /**< saturated conductivity of a layer (mm/day) */
+    CALIB_DEPTH,       /**< thickness of a layer below the top one (m) */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_CALIB_PARAMS     /**< used as a loop counter */
+};
+
+/******************************************************************************
+ * @brief   Model structures of one grid cell of a batch run
+ *****************************************************************************/
+typedef struct {
+    size_t id;                 /**< cell identifier, used in error messages */
+    soil_con_struct *soil_con; /**< soil parameters */
+    veg_con_struct *veg_con;   /**< vegetation tiles [nveg + 1] */
+    veg_lib_struct *veg_lib;   /**< vegetation library */
+    lake_con_struct *lake_con; /**< lake parameters */
+    all_vars_struct *all_vars; /**< model state, updated in place */
+    int error;                 /**< status of vic_run, 0 if the run succeeded */
+} batch_cell_struct;
+
+/******************************************************************************
+ * @brief   Ring of in-memory snapshots of the states of a batch of cells
+ *****************************************************************************/
+typedef struct {
+    size_t nslots;             /**< number of snapshots in the ring */
+    size_t ncells;             /**< number of cells of a snapshot */
+    size_t *nveg;              /**< number of vegetation tiles per cell */
+    size_t nsnaps;             /**< number of snapshots taken and kept */
+    size_t next;               /**< slot of the next snapshot */
+    size_t *step;              /**< model step of the snapshot per slot */
+    all_vars_struct *all_vars; /**< states [nslots * ncells], slot major */
+} snapshot_ring_struct;
+
+void vic_branch(batch_cell_struct *base, size_t nmembers,
+                batch_cell_struct *members, all_vars_struct *all_vars);
+void vic_free_branch(size_t nmembers, all_vars_struct *all_vars);
+void vic_free_snapshot_ring(snapshot_ring_struct *ring);
+void vic_make_snapshot_ring(size_t nslots, size_t ncells,
+                            batch_cell_struct *cells,
+                            snapshot_ring_struct *ring);
+int vic_restore_snapshot(snapshot_ring_struct *ring, size_t step,
+                         batch_cell_struct *cells);
+int vic_run_batch(size_t ncells, size_t nsteps, batch_cell_struct *cells,
+                  dmy_struct *dmy, double *forcing, size_t noutvars,
+                  unsigned int *outvars, double *out);
+int vic_run_ensemble(size_t nmembers, size_t nsteps, batch_cell_struct *members,
+                     dmy_struct *dmy, double *forcing, double *scale,
+                     double *offset, size_t noutvars, unsigned int *outvars,
+                     double *out);
+int vic_set_soil_param(soil_con_struct *soil_con, unsigned int calib_param,
+                       size_t layer, double value);
+void vic_take_snapshot(snapshot_ring_struct *ring, size_t step,
+                       batch_cell_struct *cells);
+
 #endif
@@ -23,6 +23,18 @@ from setuptools.extension import Extension
 # | DEBUG     | < 10             |
 log_level = 0
 
+# Build with OpenMP to run the cells of vic_run_batch in parallel
+use_openmp = False
+
+# Build the cffi module in API mode: the VIC sources are compiled into the
+# extension module vic/_vic, and the Python calls of the C functions are
+# direct calls.  In ABI mode (False), the functions of the vic_core shared
+# library are called through libffi, which costs more per call.
+use_cffi_api = True
+
+# Optimization flags of the C sources
+optimize_args = ['-O3']
+
 MAJOR = 5
 MINOR = 0
 MICRO = 1
@@ -61,8 +73,10 @@ class CleanCommand(Command):
             except FileNotFoundError:
                 pass
 
-        files = ['vic/_vic.py', 'vic_headers.py']
+        files = ['vic/_vic.py', 'vic_headers.py', 'vic_build_config.py']
         files.extend(glob.glob('vic/*pyc'))
+        files.extend(glob.glob('vic/_vic*.so'))
+        files.extend(glob.glob('vic/_vic*.c'))
         files.extend(glob.glob('vic_core*'))
 
         for filename in files:
@@ -105,6 +119,7 @@ def maybe_eval_between_brackets(s):
 def make_cffi_headers():
     '''Process the C headers such that CFFI can interpret them'''
 
+    # functions cffi cannot use, the prototypes that name them are skipped
     omissions = ['va_list',
                  'error_print_atmos_energy_bal',
                  'error_print_atmos_moist_bal',
@@ -113,6 +128,8 @@ def make_cffi_headers():
                  'error_print_surf_energy_bal',
                  'ErrorPrintIcePackEnergyBalance',
                  'ErrorPrintSnowPackEnergyBalance',
+                 'CalcSnowPackEnergyBalance',
+                 'ErrorSnowPackEnergyBalance',
                  'func_atmos_energy_bal',
                  'func_atmos_moist_bal',
                  'func_canopy_energy_bal',
@@ -120,9 +137,8 @@ def make_cffi_headers():
                  'IceEnergyBalance',
                  'root_brent',
                  'SnowPackEnergyBalance',
-                 'soil_thermal_eqn',
-                 'zwtvmoist_zwt',
-                 'zwtvmoist_moist']
+                 'soil_thermal_eqn']
+    omit = re.compile(r'\b(%s)\b' % '|'.join(omissions))
 
     args = ['gcc', '-std=c99', '-E',
             '-P', os.path.join(vic_root_abs_path, 'vic', 'drivers',
@@ -155,6 +171,8 @@ def make_cffi_headers():
         # now we write the preprocessed headers, skipping the system headers
         f.write("headers = '''\n")
         skip_headers = True
+        statement = []
+        depth = 0
         for line in stdout.split('\n'):
             # Note: This check for LOG_DEST is here because the subprocess call
             # above includes system headers which we don't want in headers.py.
@@ -163,15 +181,24 @@ def make_cffi_headers():
             # the standard out stream.
             if 'LOG_DEST' in line:
                 skip_headers = False
-
-            # Skip some lines if they contain functions cffi cannot use
-            for omit in omissions:
-                if omit in line:
-                    skip_omit = True
-                    break
-                else:
-                    skip_omit = False
-            if not skip_headers and not skip_omit:
+            if skip_headers:
+                continue
+
+            # Gather the lines of a statement, a prototype may be continued
+            # on the next lines until its parentheses are closed
+            statement.append(line)
+            depth += (line.count('{') + line.count('(') -
+                      line.count('}') - line.count(')'))
+            if depth > 0:
+                continue
+            depth = 0
+
+            # Skip the prototypes of the functions cffi cannot use
+            text = '\n'.join(statement)
+            statement = []
+            if '{' not in text and omit.search(text):
+                continue
+            for line in text.split('\n'):
                 # Evaluate strings that are not completely evaluated by the
                 # preprocessor.
                 line = maybe_eval_between_brackets(line)
@@ -179,6 +206,20 @@ def make_cffi_headers():
                 f.write('\n')
         f.write("'''\n")
 
+# -------------------------------------------------------------------- #
+def write_build_config(sources, includes, compile_args, link_args):
+    '''Write the build settings of the cffi module for vic_build.py'''
+    with open(os.path.join(setup_dir, 'vic_build_config.py'), 'w') as f:
+        f.write('#!/usr/bin/env python\n')
+        f.write("'''\n    Build Settings for the VIC Python Driver\n"
+                "    Last updated %s\n'''\n\n" % datetime.now())
+        f.write('use_cffi_api = %r\n' % use_cffi_api)
+        f.write('sources = %r\n' % sources)
+        f.write('include_dirs = %r\n' % includes)
+        f.write('extra_compile_args = %r\n' % compile_args)
+        f.write('extra_link_args = %r\n' % link_args)
+# -------------------------------------------------------------------- #
+
 # -------------------------------------------------------------------- #
 # Get version string
 if ISRELEASED:
@@ -251,12 +292,26 @@ includes.append(os.path.join(vic_root_abs_path, 'vic',
 
 ext_name = 'vic_core'
 # platform safe path to extension
-ext_obj = ext_name + sysconfig.get_config_var('SO')
-ext_module = Extension(ext_name,
-                       sources=sources,
-                       include_dirs=includes,
-                       extra_compile_args=['-std=c99',
-                                           '-DLOG_LVL={0}'.format(log_level)])
+ext_obj = ext_name + (sysconfig.get_config_var('EXT_SUFFIX') or
+                      sysconfig.get_config_var('SO'))
+# the headers define LOG_DEST in every source, which the linker only merges
+# as a common symbol (the default of gcc < 10)
+compile_args = ['-std=c99', '-fcommon', '-DLOG_LVL={0}'.format(log_level)]
+compile_args.extend(optimize_args)
+link_args = []
+if use_openmp:
+    compile_args.append('-fopenmp')
+    link_args.append('-fopenmp')
+write_build_config(sources, includes, compile_args, link_args)
+if use_cffi_api:
+    # the sources are compiled into the cffi module
+    ext_modules = []
+else:
+    ext_modules = [Extension(ext_name,
+                             sources=sources,
+                             include_dirs=includes,
+                             extra_compile_args=compile_args,
+                             extra_link_args=link_args)]
 
 # -------------------------------------------------------------------- #
 # Run Setup
@@ -267,13 +322,13 @@ setup(name='vic',
       author_email='jhamman1@uw.edu',
       cmdclass={'clean': CleanCommand},
       setup_requires=["cffi>=1.0.0"],
-      install_requires=["cffi>=1.0.0"],
+      install_requires=["cffi>=1.0.0", "numpy"],
       tests_require=['pytest'],
       url='https://github.com/UW-Hydro/VIC',
       py_modules=["vic"],
       cffi_modules=["vic_build.py:ffi"],
       packages=find_packages(),
-      ext_modules=[ext_module])
+      ext_modules=ext_modules)
 # -------------------------------------------------------------------- #
 
 os.chdir(start_dir)
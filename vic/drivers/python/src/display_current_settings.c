@@ -178,6 +178,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "IMPLICIT\t\tFALSE\n");
     }
+    if (options.ANALYTIC_JACOBIAN) {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ANALYTIC_JACOBIAN\tFALSE\n");
+    }
     if (options.NOFLUX) {
         fprintf(LOG_DEST, "NOFLUX\t\t\tTRUE\n");
     }
@@ -196,6 +202,12 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "QUICK_SOLVE\t\tFALSE\n");
     }
+    if (options.QUIESCENT_SOIL) {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "QUIESCENT_SOIL\t\tFALSE\n");
+    }
     if (options.SPATIAL_FROST) {
         fprintf(LOG_DEST, "SPATIAL_FROST\t\tTRUE\n");
         fprintf(LOG_DEST, "Nfrost\t\t%zu\n", options.Nfrost);
@@ -221,6 +233,24 @@ display_current_settings(int mode)
     else {
         fprintf(LOG_DEST, "TFALLBACK\t\tFALSE\n");
     }
+    if (options.TSURF_NEWTON) {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "TSURF_NEWTON\t\tFALSE\n");
+    }
+    if (options.ROOT_RETRY) {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "ROOT_RETRY\t\tFALSE\n");
+    }
+    if (options.FAST_SVP) {
+        fprintf(LOG_DEST, "FAST_SVP\t\tTRUE\n");
+    }
+    else {
+        fprintf(LOG_DEST, "FAST_SVP\t\tFALSE\n");
+    }
     fprintf(LOG_DEST, "WIND_H\t\t\t%f\n", global_param.wind_h);
     fprintf(LOG_DEST, "NODES\t\t\t%zu\n", options.Nnode);
     if (options.CARBON) {
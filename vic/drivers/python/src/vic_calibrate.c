@@ -0,0 +1,172 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Change the soil parameters of a cell between the trials of a calibration.
+ *
+ * A calibration (e.g. SCE-UA or DDS) runs the same cells many times with
+ * other soil parameters. The parameters of a trial are set on the soil
+ * structure of a cell, and the parameters that are derived from them at
+ * initialization are computed again here, so that the cells do not have to
+ * be initialized again for each trial.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_python.h>
+
+/******************************************************************************
+ * @brief    Compute the maximum infiltration of the upper layers.
+ *****************************************************************************/
+static void
+set_max_infil(soil_con_struct *soil_con)
+{
+    extern option_struct options;
+
+    if (options.Nlayer == 2) {
+        soil_con->max_infil = (1.0 + soil_con->b_infilt) *
+                              soil_con->max_moist[0];
+    }
+    else {
+        soil_con->max_infil = (1.0 + soil_con->b_infilt) *
+                              (soil_con->max_moist[0] +
+                               soil_con->max_moist[1]);
+    }
+}
+
+/******************************************************************************
+ * @brief    Compute the soil parameters of the thermal nodes and the soil
+ *           moistures of the water table depths.
+ *****************************************************************************/
+static void
+set_soil_profile(soil_con_struct *soil_con)
+{
+    extern option_struct options;
+
+    set_node_parameters(soil_con->Zsum_node, soil_con->max_moist_node,
+                        soil_con->expt_node, soil_con->bubble_node,
+                        soil_con->alpha, soil_con->beta, soil_con->gamma,
+                        soil_con->depth, soil_con->max_moist, soil_con->expt,
+                        soil_con->bubble, options.Nnode, options.Nlayer);
+    soil_moisture_from_water_table(soil_con, options.Nlayer);
+}
+
+/******************************************************************************
+ * @brief    Set a soil parameter of a cell and the parameters derived from
+ *           it.
+ *
+ * @details  Ds, Dsmax, Ws and c are the ARNO baseflow parameters that are
+ *           used by the model, i.e. after the conversion of the NIJSSEN2001
+ *           parameters at initialization. The thickness of the top layer
+ *           is not calibrated, since the positions of the thermal nodes
+ *           depend on it. The critical and wilting point moistures of a
+ *           layer keep their fractions of its maximum moisture.
+ *
+ * @param soil_con    soil parameters of the cell
+ * @param calib_param parameter, one of the CALIB_* enum
+ * @param layer       soil layer of CALIB_EXPT, CALIB_KSAT and CALIB_DEPTH,
+ *                    ignored otherwise
+ * @param value       value of the parameter
+ *
+ * @return 0 if the parameter was set, -1 if the parameter, the layer or the
+ *         value is not valid, in which case the soil parameters are not
+ *         changed
+ *****************************************************************************/
+int
+vic_set_soil_param(soil_con_struct *soil_con,
+                   unsigned int     calib_param,
+                   size_t           layer,
+                   double           value)
+{
+    extern option_struct options;
+
+    double               max_moist;
+
+    if ((calib_param == CALIB_EXPT || calib_param == CALIB_KSAT ||
+         calib_param == CALIB_DEPTH) && layer >= options.Nlayer) {
+        return -1;
+    }
+
+    switch (calib_param) {
+    case CALIB_B_INFILT:
+        if (value <= 0) {
+            return -1;
+        }
+        soil_con->b_infilt = value;
+        set_max_infil(soil_con);
+        break;
+    case CALIB_DS:
+        if (value < 0 || value > 1) {
+            return -1;
+        }
+        soil_con->Ds = value;
+        break;
+    case CALIB_DSMAX:
+        if (value < 0) {
+            return -1;
+        }
+        soil_con->Dsmax = value;
+        break;
+    case CALIB_WS:
+        if (value <= 0 || value > 1) {
+            return -1;
+        }
+        soil_con->Ws = value;
+        break;
+    case CALIB_C:
+        if (value <= 0) {
+            return -1;
+        }
+        soil_con->c = value;
+        break;
+    case CALIB_EXPT:
+        if (value < 3.0) {
+            return -1;
+        }
+        soil_con->expt[layer] = value;
+        set_soil_profile(soil_con);
+        break;
+    case CALIB_KSAT:
+        if (value <= 0) {
+            return -1;
+        }
+        soil_con->Ksat[layer] = value;
+        break;
+    case CALIB_DEPTH:
+        if (layer == 0 || value < MINSOILDEPTH ||
+            (layer == 1 && value < soil_con->depth[0])) {
+            return -1;
+        }
+        // the depths are rounded to mm, as they are read
+        soil_con->depth[layer] = round(value * MM_PER_M) / MM_PER_M;
+        max_moist = soil_con->depth[layer] * soil_con->porosity[layer] *
+                    MM_PER_M;
+        soil_con->Wcr[layer] *= max_moist / soil_con->max_moist[layer];
+        soil_con->Wpwp[layer] *= max_moist / soil_con->max_moist[layer];
+        soil_con->max_moist[layer] = max_moist;
+        set_max_infil(soil_con);
+        set_soil_profile(soil_con);
+        break;
+    default:
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,523 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Run a batch of independent grid cells over a period in a single call.
+ *
+ * The forcings of all cells come in one contiguous array and the selected
+ * output variables go to one contiguous, preallocated array, so that a
+ * caller (the Python driver) can pass NumPy buffers and run the integration
+ * loop without a round trip per cell or per time step. The cells are run in
+ * parallel when the library is built with OpenMP.
+ *
+ * An ensemble run is a batch run whose members share one forcing series,
+ * perturbed per member, so that the forcings are read and passed in once for
+ * all members.
+ *
+ * A branched run starts the members of a forecast from the state of one cell,
+ * e.g. at the end of a spin-up, without a state file and without its
+ * initialization per member.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_python.h>
+
+/******************************************************************************
+ * @brief    Allocate the forcing structure of one cell.
+ *****************************************************************************/
+static void
+alloc_batch_force(force_data_struct *force)
+{
+    extern size_t NR;
+
+    force->air_temp = calloc(NR + 1, sizeof(*(force->air_temp)));
+    force->Catm = calloc(NR + 1, sizeof(*(force->Catm)));
+    force->channel_in = calloc(NR + 1, sizeof(*(force->channel_in)));
+    force->coszen = calloc(NR + 1, sizeof(*(force->coszen)));
+    force->density = calloc(NR + 1, sizeof(*(force->density)));
+    force->fdir = calloc(NR + 1, sizeof(*(force->fdir)));
+    force->longwave = calloc(NR + 1, sizeof(*(force->longwave)));
+    force->par = calloc(NR + 1, sizeof(*(force->par)));
+    force->prec = calloc(NR + 1, sizeof(*(force->prec)));
+    force->pressure = calloc(NR + 1, sizeof(*(force->pressure)));
+    force->shortwave = calloc(NR + 1, sizeof(*(force->shortwave)));
+    force->snowflag = calloc(NR + 1, sizeof(*(force->snowflag)));
+    force->vp = calloc(NR + 1, sizeof(*(force->vp)));
+    force->vpd = calloc(NR + 1, sizeof(*(force->vpd)));
+    force->wind = calloc(NR + 1, sizeof(*(force->wind)));
+    if (force->air_temp == NULL || force->Catm == NULL ||
+        force->channel_in == NULL || force->coszen == NULL ||
+        force->density == NULL || force->fdir == NULL ||
+        force->longwave == NULL || force->par == NULL ||
+        force->prec == NULL || force->pressure == NULL ||
+        force->shortwave == NULL || force->snowflag == NULL ||
+        force->vp == NULL || force->vpd == NULL || force->wind == NULL) {
+        log_err("Memory allocation error.");
+    }
+}
+
+/******************************************************************************
+ * @brief    Free the forcing structure of one cell.
+ *****************************************************************************/
+static void
+free_batch_force(force_data_struct *force)
+{
+    free(force->air_temp);
+    free(force->Catm);
+    free(force->channel_in);
+    free(force->coszen);
+    free(force->density);
+    free(force->fdir);
+    free(force->longwave);
+    free(force->par);
+    free(force->prec);
+    free(force->pressure);
+    free(force->shortwave);
+    free(force->snowflag);
+    free(force->vp);
+    free(force->vpd);
+    free(force->wind);
+}
+
+/******************************************************************************
+ * @brief    Allocate the vegetation history of the tiles of one cell. The
+ *           five series of a tile share one block.
+ *****************************************************************************/
+static veg_hist_struct *
+alloc_batch_veg_hist(size_t nveg)
+{
+    extern size_t    NR;
+
+    size_t           v;
+    double          *values;
+    veg_hist_struct *veg_hist;
+
+    veg_hist = calloc(nveg, sizeof(*veg_hist));
+    check_alloc_status(veg_hist, "Memory allocation error.");
+    values = calloc(nveg * 5 * (NR + 1), sizeof(*values));
+    check_alloc_status(values, "Memory allocation error.");
+
+    for (v = 0; v < nveg; v++) {
+        veg_hist[v].albedo = values;
+        veg_hist[v].displacement = values + (NR + 1);
+        veg_hist[v].fcanopy = values + 2 * (NR + 1);
+        veg_hist[v].LAI = values + 3 * (NR + 1);
+        veg_hist[v].roughness = values + 4 * (NR + 1);
+        values += 5 * (NR + 1);
+    }
+
+    return veg_hist;
+}
+
+/******************************************************************************
+ * @brief    Fill the forcings and the vegetation history of one cell for one
+ *           model step, the way the image driver derives them. If scale is
+ *           not NULL, the forcings are perturbed as forcing * scale + offset.
+ *****************************************************************************/
+static void
+set_batch_force(batch_cell_struct *cell,
+                dmy_struct        *dmy,
+                double            *forcing,
+                double            *scale,
+                double            *offset,
+                double             t_offset,
+                force_data_struct *force,
+                veg_hist_struct   *veg_hist)
+{
+    extern option_struct   options;
+    extern parameters_struct param;
+    extern size_t          NF;
+    extern size_t          NR;
+
+    size_t                 j;
+    size_t                 k;
+    size_t                 v;
+    size_t                 nveg;
+    double                 f[N_BATCH_FORCING];
+    soil_con_struct       *soil_con = cell->soil_con;
+    veg_con_struct        *veg_con = cell->veg_con;
+
+    for (j = 0; j < NF; j++) {
+        for (k = 0; k < N_BATCH_FORCING; k++) {
+            f[k] = forcing[j * N_BATCH_FORCING + k];
+            if (scale != NULL) {
+                f[k] = f[k] * scale[k] + offset[k];
+            }
+        }
+        if (f[BATCH_PREC] < 0) {
+            f[BATCH_PREC] = 0;
+        }
+        force->air_temp[j] = f[BATCH_AIR_TEMP];
+        force->prec[j] = f[BATCH_PREC];
+        force->shortwave[j] = f[BATCH_SWDOWN];
+        force->longwave[j] = f[BATCH_LWDOWN];
+        force->wind[j] = f[BATCH_WIND];
+        force->channel_in[j] = 0.;
+        // pressure and vapor pressure come in kPa
+        force->pressure[j] = f[BATCH_PRESSURE] * PA_PER_KPA;
+        force->vp[j] = f[BATCH_VP] * PA_PER_KPA;
+        force->vpd[j] = svp(force->air_temp[j]) - force->vp[j];
+        if (force->vpd[j] < 0) {
+            force->vpd[j] = 0;
+            force->vp[j] = svp(force->air_temp[j]);
+        }
+        force->density[j] = air_density(force->air_temp[j],
+                                        force->pressure[j]);
+        force->snowflag[j] = will_it_snow(&(force->air_temp[j]), t_offset,
+                                          param.SNOW_MAX_SNOW_TEMP,
+                                          &(force->prec[j]), 1);
+        if (options.CARBON) {
+            force->Catm[j] = f[BATCH_CATM];
+            force->fdir[j] = f[BATCH_FDIR];
+            force->par[j] = f[BATCH_PAR];
+            force->coszen[j] = compute_coszen(soil_con->lat, soil_con->lng,
+                                              soil_con->time_zone_lng,
+                                              dmy->day_in_year,
+                                              dmy->dayseconds);
+        }
+    }
+
+    force->air_temp[NR] = average(force->air_temp, NF);
+    force->prec[NR] = average(force->prec, NF) * NF;
+    force->shortwave[NR] = average(force->shortwave, NF);
+    force->longwave[NR] = average(force->longwave, NF);
+    force->pressure[NR] = average(force->pressure, NF);
+    force->wind[NR] = average(force->wind, NF);
+    force->vp[NR] = average(force->vp, NF);
+    force->vpd[NR] = (svp(force->air_temp[NR]) - force->vp[NR]);
+    force->density[NR] = air_density(force->air_temp[NR],
+                                     force->pressure[NR]);
+    force->snowflag[NR] = will_it_snow(force->air_temp, t_offset,
+                                       param.SNOW_MAX_SNOW_TEMP,
+                                       force->prec, NF);
+    force->channel_in[NR] = 0.;
+    if (options.CARBON) {
+        force->Catm[NR] = average(force->Catm, NF);
+        force->fdir[NR] = average(force->fdir, NF);
+        force->par[NR] = average(force->par, NF);
+        force->coszen[NR] = compute_coszen(soil_con->lat, soil_con->lng,
+                                           soil_con->time_zone_lng,
+                                           dmy->day_in_year, 0);
+    }
+
+    // climatological vegetation parameters of the current month
+    nveg = veg_con[0].vegetat_type_num + 1;
+    for (v = 0; v < nveg; v++) {
+        for (j = 0; j <= NR; j++) {
+            veg_hist[v].albedo[j] = veg_con[v].albedo[dmy->month - 1];
+            veg_hist[v].displacement[j] =
+                veg_con[v].displacement[dmy->month - 1];
+            veg_hist[v].fcanopy[j] = veg_con[v].fcanopy[dmy->month - 1];
+            veg_hist[v].LAI[j] = veg_con[v].LAI[dmy->month - 1];
+            veg_hist[v].roughness[j] = veg_con[v].roughness[dmy->month - 1];
+            if (veg_hist[v].fcanopy[j] < MIN_FCANOPY) {
+                veg_hist[v].fcanopy[j] = MIN_FCANOPY;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Run one cell of the batch over all model steps.
+ *****************************************************************************/
+static void
+run_batch_cell(batch_cell_struct *cell,
+               size_t             nsteps,
+               dmy_struct        *dmy,
+               double            *forcing,
+               double            *scale,
+               double            *offset,
+               size_t             noutvars,
+               unsigned int      *outvars,
+               size_t             nvalues,
+               double            *out)
+{
+    extern global_param_struct global_param;
+    extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
+    extern option_struct       options;
+    extern size_t              NF;
+
+    size_t                     i;
+    size_t                     k;
+    size_t                     n;
+    size_t                     e;
+    size_t                     band;
+    double                     t_offset;
+    double                  ***out_data;
+    force_data_struct          force;
+    veg_hist_struct           *veg_hist;
+    save_data_struct           save_data;
+    timer_struct               timer;
+    bool                       timer_wall;
+    bool                       timer_cpu;
+    soil_con_struct           *soil_con = cell->soil_con;
+
+    cell->error = 0;
+
+    t_offset = 0;
+    if (options.SNOW_BAND > 1) {
+        t_offset = soil_con->Tfactor[0];
+        for (band = 1; band < options.SNOW_BAND; band++) {
+            if (soil_con->Tfactor[band] < t_offset) {
+                t_offset = soil_con->Tfactor[band];
+            }
+        }
+    }
+
+    alloc_batch_force(&force);
+    veg_hist = alloc_batch_veg_hist(cell->veg_con[0].vegetat_type_num + 1);
+    alloc_out_data(1, &out_data);
+    timer_init(&timer);
+    timer_wall = outvar_group_requested(OUT_GROUP_TIME_WALL);
+    timer_cpu = outvar_group_requested(OUT_GROUP_TIME_CPU);
+
+    for (i = 0; i < nsteps; i++) {
+        vic_run_ref.id_name = "batch cell";
+        vic_run_ref.id = cell->id;
+        vic_run_ref.dmy = &(dmy[i]);
+
+        set_batch_force(cell, &(dmy[i]), forcing + i * NF * N_BATCH_FORCING,
+                        scale, offset, t_offset, &force, veg_hist);
+        if (i == 0) {
+            initialize_save_data(cell->all_vars, &force, soil_con,
+                                 cell->veg_con, cell->veg_lib, cell->lake_con,
+                                 out_data[0], &save_data, &timer);
+        }
+
+        update_step_vars(cell->all_vars, cell->veg_con, veg_hist);
+        timer_start_clocks(&timer, timer_wall, timer_cpu);
+        cell->error = vic_run(&force, cell->all_vars, &(dmy[i]),
+                              &global_param, cell->lake_con, soil_con,
+                              cell->veg_con, cell->veg_lib);
+        timer_stop_clocks(&timer, timer_wall, timer_cpu);
+        if (cell->error != 0) {
+            break;
+        }
+
+        put_data(cell->all_vars, &force, soil_con, cell->veg_con,
+                 cell->veg_lib, cell->lake_con, out_data[0], &save_data,
+                 &timer);
+
+        n = 0;
+        for (k = 0; k < noutvars; k++) {
+            for (e = 0; e < out_metadata[outvars[k]].nelem; e++) {
+                out[i * nvalues + n++] = out_data[0][outvars[k]][e];
+            }
+        }
+    }
+
+    // the steps after a failure have no outputs
+    for (; i < nsteps; i++) {
+        for (n = 0; n < nvalues; n++) {
+            out[i * nvalues + n] = NAN;
+        }
+    }
+
+    free_out_data(1, out_data);
+    free(veg_hist[0].albedo);
+    free(veg_hist);
+    free_batch_force(&force);
+}
+
+/******************************************************************************
+ * @brief    Check the setup of a batch run and return the number of output
+ *           values per cell and time step.
+ *****************************************************************************/
+static size_t
+get_batch_nvalues(size_t        noutvars,
+                  unsigned int *outvars)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+    extern option_struct   options;
+
+    size_t                 k;
+    size_t                 nvalues;
+
+    if (options.LAKES) {
+        log_err("The batch run does not support lakes.");
+    }
+    for (k = 0; k < noutvars; k++) {
+        if (outvars[k] >= N_OUTVAR_TYPES) {
+            log_err("Invalid output variable index %u.", outvars[k]);
+        }
+    }
+
+    set_output_met_data_info();
+
+    nvalues = 0;
+    for (k = 0; k < noutvars; k++) {
+        nvalues += out_metadata[outvars[k]].nelem;
+    }
+
+    return nvalues;
+}
+
+/******************************************************************************
+ * @brief    Run a batch of grid cells over nsteps model steps.
+ *
+ * @param ncells   number of cells
+ * @param nsteps   number of model steps
+ * @param cells    model structures of the cells, initialized by the caller
+ * @param dmy      dates of the model steps [nsteps]
+ * @param forcing  forcings [ncells, nsteps * NF, N_BATCH_FORCING], in the
+ *                 units of the image driver forcing files
+ * @param noutvars number of output variables
+ * @param outvars  output variables (OUT_* indices) [noutvars]
+ * @param out      outputs [ncells, nsteps, nvalues], where nvalues is the
+ *                 sum of the numbers of elements of the output variables
+ *
+ * @return number of cells whose run failed
+ *****************************************************************************/
+int
+vic_run_batch(size_t             ncells,
+              size_t             nsteps,
+              batch_cell_struct *cells,
+              dmy_struct        *dmy,
+              double            *forcing,
+              size_t             noutvars,
+              unsigned int      *outvars,
+              double            *out)
+{
+    extern size_t NF;
+
+    size_t        c;
+    size_t        nvalues;
+    int           nerrors;
+
+    nvalues = get_batch_nvalues(noutvars, outvars);
+
+    nerrors = 0;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:nerrors)
+    for (c = 0; c < ncells; c++) {
+        run_batch_cell(&(cells[c]), nsteps, dmy,
+                       forcing + c * nsteps * NF * N_BATCH_FORCING,
+                       NULL, NULL, noutvars, outvars, nvalues,
+                       out + c * nsteps * nvalues);
+        if (cells[c].error != 0) {
+            nerrors++;
+        }
+    }
+
+    return nerrors;
+}
+
+/******************************************************************************
+ * @brief    Run an ensemble of members of one grid cell over nsteps model
+ *           steps.
+ *
+ * The members share one forcing series, which is perturbed per member as
+ * forcing * scale + offset. Parameter perturbations are applied by giving
+ * the members their own soil_con, veg_con or veg_lib.
+ *
+ * @param nmembers number of members
+ * @param nsteps   number of model steps
+ * @param members  model structures of the members, initialized by the caller
+ * @param dmy      dates of the model steps [nsteps]
+ * @param forcing  shared forcings [nsteps * NF, N_BATCH_FORCING]
+ * @param scale    forcing scale factors [nmembers, N_BATCH_FORCING]
+ * @param offset   forcing offsets [nmembers, N_BATCH_FORCING]
+ * @param noutvars number of output variables
+ * @param outvars  output variables (OUT_* indices) [noutvars]
+ * @param out      outputs [nmembers, nsteps, nvalues]
+ *
+ * @return number of members whose run failed
+ *****************************************************************************/
+int
+vic_run_ensemble(size_t             nmembers,
+                 size_t             nsteps,
+                 batch_cell_struct *members,
+                 dmy_struct        *dmy,
+                 double            *forcing,
+                 double            *scale,
+                 double            *offset,
+                 size_t             noutvars,
+                 unsigned int      *outvars,
+                 double            *out)
+{
+    size_t m;
+    size_t nvalues;
+    int    nerrors;
+
+    nvalues = get_batch_nvalues(noutvars, outvars);
+
+    nerrors = 0;
+    #pragma omp parallel for schedule(dynamic, 1) reduction(+:nerrors)
+    for (m = 0; m < nmembers; m++) {
+        run_batch_cell(&(members[m]), nsteps, dmy, forcing,
+                       scale + m * N_BATCH_FORCING,
+                       offset + m * N_BATCH_FORCING,
+                       noutvars, outvars, nvalues,
+                       out + m * nsteps * nvalues);
+        if (members[m].error != 0) {
+            nerrors++;
+        }
+    }
+
+    return nerrors;
+}
+
+/******************************************************************************
+ * @brief    Branch the members of a forecast from the state of a cell.
+ *
+ * The members share the parameter structures of the base cell, which are
+ * only read by vic_run, and get their own copy of its state. They are then
+ * run with vic_run_batch, each with its own forcings, or with
+ * vic_run_ensemble.
+ *
+ * @param base     base cell, e.g. at the end of a spin-up
+ * @param nmembers number of members
+ * @param members  model structures of the members [nmembers]
+ * @param all_vars states of the members [nmembers], made here and released
+ *                 with vic_free_branch
+ *****************************************************************************/
+void
+vic_branch(batch_cell_struct *base,
+           size_t             nmembers,
+           batch_cell_struct *members,
+           all_vars_struct   *all_vars)
+{
+    size_t m;
+    size_t nveg;
+
+    nveg = base->veg_con[0].vegetat_type_num;
+    for (m = 0; m < nmembers; m++) {
+        all_vars[m] = make_all_vars(nveg);
+        copy_all_vars(&(all_vars[m]), base->all_vars, nveg);
+        members[m] = *base;
+        members[m].id = m;
+        members[m].all_vars = &(all_vars[m]);
+        members[m].error = 0;
+    }
+}
+
+/******************************************************************************
+ * @brief    Release the states of the members of vic_branch.
+ *****************************************************************************/
+void
+vic_free_branch(size_t           nmembers,
+                all_vars_struct *all_vars)
+{
+    size_t m;
+
+    for (m = 0; m < nmembers; m++) {
+        free_all_vars(&(all_vars[m]));
+    }
+}
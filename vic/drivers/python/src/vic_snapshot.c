@@ -0,0 +1,165 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Ring of in-memory snapshots of the states of a batch of cells.
+ *
+ * A smoother or a reanalysis rewinds the run by a few days and runs it again
+ * with corrected states or forcings. The snapshots of the states are taken
+ * every few steps into a ring that is allocated once, so that rolling back
+ * is a copy in memory instead of a restart from a state file. The oldest
+ * snapshot is overwritten when the ring is full.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_python.h>
+
+/******************************************************************************
+ * @brief    Allocate a ring of snapshots of the states of a batch of cells.
+ *
+ * @param nslots number of snapshots kept
+ * @param ncells number of cells
+ * @param cells  model structures of the cells [ncells]
+ * @param ring   ring, released with vic_free_snapshot_ring
+ *****************************************************************************/
+void
+vic_make_snapshot_ring(size_t                nslots,
+                       size_t                ncells,
+                       batch_cell_struct    *cells,
+                       snapshot_ring_struct *ring)
+{
+    size_t i;
+    size_t c;
+
+    if (nslots == 0) {
+        log_err("A snapshot ring needs at least one slot.");
+    }
+
+    ring->nslots = nslots;
+    ring->ncells = ncells;
+    ring->nsnaps = 0;
+    ring->next = 0;
+
+    ring->nveg = calloc(ncells, sizeof(*(ring->nveg)));
+    check_alloc_status(ring->nveg, "Memory allocation error.");
+    ring->step = calloc(nslots, sizeof(*(ring->step)));
+    check_alloc_status(ring->step, "Memory allocation error.");
+    ring->all_vars = calloc(nslots * ncells, sizeof(*(ring->all_vars)));
+    check_alloc_status(ring->all_vars, "Memory allocation error.");
+
+    for (c = 0; c < ncells; c++) {
+        ring->nveg[c] = cells[c].veg_con[0].vegetat_type_num;
+    }
+    for (i = 0; i < nslots; i++) {
+        for (c = 0; c < ncells; c++) {
+            ring->all_vars[i * ncells + c] = make_all_vars(ring->nveg[c]);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Take a snapshot of the states of the cells at a model step.
+ *
+ * @param ring  ring
+ * @param step  model step of the states, e.g. the number of steps run
+ * @param cells model structures of the cells [ring->ncells]
+ *****************************************************************************/
+void
+vic_take_snapshot(snapshot_ring_struct *ring,
+                  size_t                step,
+                  batch_cell_struct    *cells)
+{
+    size_t c;
+    size_t slot;
+
+    slot = ring->next;
+    for (c = 0; c < ring->ncells; c++) {
+        copy_all_vars(&(ring->all_vars[slot * ring->ncells + c]),
+                      cells[c].all_vars, ring->nveg[c]);
+    }
+    ring->step[slot] = step;
+    ring->next = (slot + 1) % ring->nslots;
+    if (ring->nsnaps < ring->nslots) {
+        ring->nsnaps++;
+    }
+}
+
+/******************************************************************************
+ * @brief    Roll the states of the cells back to the snapshot of a model
+ *           step.
+ *
+ * @details  The snapshots after the one restored are dropped, since the run
+ *           continues from it.
+ *
+ * @param ring  ring
+ * @param step  model step of the snapshot
+ * @param cells model structures of the cells [ring->ncells]
+ *
+ * @return 0 if the states were restored, -1 if the ring holds no snapshot of
+ *         the step
+ *****************************************************************************/
+int
+vic_restore_snapshot(snapshot_ring_struct *ring,
+                     size_t                step,
+                     batch_cell_struct    *cells)
+{
+    size_t age;
+    size_t c;
+    size_t slot;
+
+    // from the newest snapshot to the oldest
+    for (age = 0; age < ring->nsnaps; age++) {
+        slot = (ring->next + ring->nslots - 1 - age) % ring->nslots;
+        if (ring->step[slot] == step) {
+            break;
+        }
+    }
+    if (age == ring->nsnaps) {
+        return -1;
+    }
+
+    for (c = 0; c < ring->ncells; c++) {
+        copy_all_vars(cells[c].all_vars,
+                      &(ring->all_vars[slot * ring->ncells + c]),
+                      ring->nveg[c]);
+        cells[c].error = 0;
+    }
+    ring->nsnaps -= age;
+    ring->next = (slot + 1) % ring->nslots;
+
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Release the snapshots of vic_make_snapshot_ring.
+ *****************************************************************************/
+void
+vic_free_snapshot_ring(snapshot_ring_struct *ring)
+{
+    size_t i;
+
+    for (i = 0; i < ring->nslots * ring->ncells; i++) {
+        free_all_vars(&(ring->all_vars[i]));
+    }
+    free(ring->all_vars);
+    free(ring->step);
+    free(ring->nveg);
+}
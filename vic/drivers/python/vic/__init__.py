@@ -1,2 +1,5 @@
 from .vic import *
+from .driver import (Calibration, SnapshotRing, vic_branch, vic_run_batch,
+                     vic_run_ensemble)
+from .views import layer_view, out_data_view, tile_view
 VIC_DRIVER = b'Python'
@@ -24,7 +24,9 @@
   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 """
 
-from .vic import lib
+import numpy as np
+
+from .vic import ffi, lib
 
 
 def vic_init():
@@ -37,3 +39,341 @@ def vic_run():
 
 def vic_final():
     pass
+
+
+def _outvar_index(name):
+    '''Return the OUT_* index of an output variable, e.g. 'OUT_RUNOFF' or
+    'RUNOFF'.'''
+    if not name.startswith('OUT_'):
+        name = 'OUT_' + name
+    try:
+        return getattr(lib, name)
+    except AttributeError:
+        raise ValueError('unknown output variable %s' % name)
+
+
+def _get_outputs(outvars, ncells, nsteps, out):
+    '''Return the OUT_* indices of the output variables and the output
+    buffer, allocated if out is None.'''
+    indices = [_outvar_index(name) for name in outvars]
+    lib.set_output_met_data_info()
+    nvalues = sum(lib.out_metadata[i].nelem for i in indices)
+
+    shape = (ncells, nsteps, nvalues)
+    if out is None:
+        out = np.empty(shape, dtype=np.float64)
+    elif (out.shape != shape or out.dtype != np.float64 or
+          not out.flags['C_CONTIGUOUS']):
+        raise ValueError('out must be a C-contiguous float64 array of shape '
+                         '%s' % (shape, ))
+
+    return indices, out
+
+
+def _as_double_ptr(array):
+    '''Return a double pointer to the data of a C-contiguous float64
+    array.'''
+    return ffi.cast('double *', ffi.from_buffer(array))
+
+
+def vic_run_batch(cells, forcing, dmy, outvars, out=None):
+    '''Run a batch of grid cells over a period in a single call.
+
+    The integration loop of all cells and time steps runs in C; the cells are
+    run in parallel if the library was built with OpenMP.
+
+    Parameters
+    ----------
+    cells : cdata 'batch_cell_struct[]'
+        Model structures of the cells, initialized by the caller. The states
+        in ``all_vars`` are updated in place.
+    forcing : array_like
+        Forcings, shape ``[ncells, nsteps * NF, N_BATCH_FORCING]``, in the
+        order and units of the ``BATCH_*`` enum (pressure and vapor pressure
+        in kPa).
+    dmy : cdata 'dmy_struct *'
+        Dates of the ``nsteps`` model steps, e.g. from ``lib.make_dmy``.
+    outvars : sequence of str
+        Output variables, e.g. ``['OUT_RUNOFF', 'OUT_BASEFLOW']``.
+    out : ndarray, optional
+        Preallocated float64 C-contiguous output buffer of shape
+        ``[ncells, nsteps, nvalues]``, where ``nvalues`` is the sum of the
+        numbers of elements of the output variables.
+
+    Returns
+    -------
+    out : ndarray
+        Outputs. The steps of a cell after a failure of vic_run are NaN.
+    errors : ndarray
+        Status of vic_run per cell, 0 if the run succeeded.
+    '''
+    forcing = np.ascontiguousarray(forcing, dtype=np.float64)
+    if forcing.ndim != 3 or forcing.shape[2] != lib.N_BATCH_FORCING:
+        raise ValueError('forcing must have shape [ncells, nsteps * NF, %d]'
+                         % lib.N_BATCH_FORCING)
+    ncells = forcing.shape[0]
+    if forcing.shape[1] % lib.NF:
+        raise ValueError('the forcing steps are not a multiple of NF')
+    nsteps = forcing.shape[1] // lib.NF
+    if len(cells) < ncells:
+        raise ValueError('fewer cells than forcing cells')
+
+    indices, out = _get_outputs(outvars, ncells, nsteps, out)
+
+    c_outvars = ffi.new('unsigned int[]', indices)
+    lib.vic_run_batch(ncells, nsteps, cells, dmy, _as_double_ptr(forcing),
+                      len(indices), c_outvars, _as_double_ptr(out))
+
+    errors = np.array([cells[c].error for c in range(ncells)], dtype=np.int32)
+
+    return out, errors
+
+
+def vic_branch(cell, nmembers):
+    '''Branch the members of a forecast from the state of a cell.
+
+    The members share the parameter structures of ``cell``, which are only
+    read by vic_run, and start from copies of its state, e.g. at the end of a
+    spin-up. They are run with ``vic_run_batch``, each with its own forcings,
+    or with ``vic_run_ensemble``.
+
+    Parameters
+    ----------
+    cell : cdata 'batch_cell_struct *'
+        Base cell.
+    nmembers : int
+        Number of members.
+
+    Returns
+    -------
+    members : cdata 'batch_cell_struct[]'
+        Model structures of the members.
+    states : cdata 'all_vars_struct[]'
+        States of the members, released when this object is collected. It
+        must be kept as long as ``members`` is used.
+    '''
+    members = ffi.new('batch_cell_struct[]', nmembers)
+    states = ffi.new('all_vars_struct[]', nmembers)
+    lib.vic_branch(cell, nmembers, members, states)
+    states = ffi.gc(states, lambda s: lib.vic_free_branch(nmembers, s))
+
+    return members, states
+
+
+def vic_run_ensemble(members, forcing, dmy, outvars, scale=None, offset=None,
+                     out=None):
+    '''Run an ensemble of members of one grid cell in a single call.
+
+    The members share one forcing series, perturbed per member as
+    ``forcing * scale + offset`` (negative precipitation is set to 0).
+    Parameter perturbations are applied by giving the members their own
+    structures, e.g. ``ffi.new('soil_con_struct *', soil_con[0])`` for a copy
+    of the soil parameters that is then perturbed.
+
+    Parameters
+    ----------
+    members : cdata 'batch_cell_struct[]'
+        Model structures of the members, initialized by the caller.
+    forcing : array_like
+        Shared forcings, shape ``[nsteps * NF, N_BATCH_FORCING]``.
+    dmy : cdata 'dmy_struct *'
+        Dates of the ``nsteps`` model steps.
+    outvars : sequence of str
+        Output variables.
+    scale, offset : array_like, optional
+        Forcing perturbations, shape ``[nmembers, N_BATCH_FORCING]``.
+        Default to 1 and 0.
+    out : ndarray, optional
+        Preallocated output buffer of shape ``[nmembers, nsteps, nvalues]``.
+
+    Returns
+    -------
+    out : ndarray
+        Outputs.
+    errors : ndarray
+        Status of vic_run per member, 0 if the run succeeded.
+    '''
+    forcing = np.ascontiguousarray(forcing, dtype=np.float64)
+    if forcing.ndim != 2 or forcing.shape[1] != lib.N_BATCH_FORCING:
+        raise ValueError('forcing must have shape [nsteps * NF, %d]'
+                         % lib.N_BATCH_FORCING)
+    if forcing.shape[0] % lib.NF:
+        raise ValueError('the forcing steps are not a multiple of NF')
+    nsteps = forcing.shape[0] // lib.NF
+    nmembers = len(members)
+
+    pshape = (nmembers, lib.N_BATCH_FORCING)
+    if scale is None:
+        scale = np.ones(pshape)
+    if offset is None:
+        offset = np.zeros(pshape)
+    scale = np.ascontiguousarray(np.broadcast_to(scale, pshape),
+                                 dtype=np.float64)
+    offset = np.ascontiguousarray(np.broadcast_to(offset, pshape),
+                                  dtype=np.float64)
+
+    indices, out = _get_outputs(outvars, nmembers, nsteps, out)
+
+    c_outvars = ffi.new('unsigned int[]', indices)
+    lib.vic_run_ensemble(nmembers, nsteps, members, dmy,
+                         _as_double_ptr(forcing), _as_double_ptr(scale),
+                         _as_double_ptr(offset), len(indices), c_outvars,
+                         _as_double_ptr(out))
+
+    errors = np.array([members[m].error for m in range(nmembers)],
+                      dtype=np.int32)
+
+    return out, errors
+
+
+class SnapshotRing(object):
+    '''Ring of in-memory snapshots of the states of a batch of cells, for
+    rolling a run back, e.g. in a smoother, without a state file.
+
+    The states of all snapshots are allocated once. When the ring is full, a
+    new snapshot overwrites the oldest.
+
+    Parameters
+    ----------
+    cells : cdata 'batch_cell_struct[]'
+        Model structures of the cells.
+    nslots : int
+        Number of snapshots kept.
+    '''
+
+    def __init__(self, cells, nslots):
+        self.cells = cells
+        self._ring = ffi.new('snapshot_ring_struct *')
+        lib.vic_make_snapshot_ring(nslots, len(cells), cells, self._ring)
+        self._ring = ffi.gc(self._ring, lib.vic_free_snapshot_ring)
+
+    @property
+    def steps(self):
+        '''Model steps of the snapshots kept, from the oldest to the
+        newest.'''
+        ring = self._ring
+        first = ring.next + ring.nslots - ring.nsnaps
+        return [ring.step[(first + i) % ring.nslots]
+                for i in range(ring.nsnaps)]
+
+    def take(self, step):
+        '''Take a snapshot of the states of the cells at a model step.'''
+        lib.vic_take_snapshot(self._ring, step, self.cells)
+
+    def restore(self, step):
+        '''Roll the states of the cells back to the snapshot of a model step.
+        The snapshots after it are dropped.'''
+        if lib.vic_restore_snapshot(self._ring, step, self.cells):
+            raise ValueError('no snapshot of step %d' % step)
+
+
+def _calib_param_index(name):
+    '''Return the CALIB_* index of a soil parameter, e.g. 'b_infilt'.'''
+    try:
+        return getattr(lib, 'CALIB_' + name.upper())
+    except AttributeError:
+        raise ValueError('unknown calibration parameter %s' % name)
+
+
+class Calibration(object):
+    '''Calibration loop of the soil parameters of a batch of cells.
+
+    The forcings stay in memory, and the initial states and soil parameters
+    of the cells are kept, so that each trial resets the cells, sets its
+    parameters and runs them again without an initialization and without
+    writing outputs.
+
+    Parameters
+    ----------
+    cells : cdata 'batch_cell_struct[]'
+        Model structures of the cells, in their initial states. Each cell
+        must have its own soil parameters.
+    forcing : array_like
+        Forcings, see ``vic_run_batch``.
+    dmy : cdata 'dmy_struct *'
+        Dates of the model steps.
+    observed : array_like
+        Observations, shape ``[ncells, nsteps]``.
+    outvars : sequence of str, optional
+        Output variables whose sum is compared to the observations.
+    '''
+
+    def __init__(self, cells, forcing, dmy, observed,
+                 outvars=('OUT_RUNOFF', 'OUT_BASEFLOW')):
+        self.cells = cells
+        self.forcing = np.ascontiguousarray(forcing, dtype=np.float64)
+        self.dmy = dmy
+        self.observed = np.asarray(observed, dtype=np.float64)
+        self.outvars = list(outvars)
+        ncells = self.forcing.shape[0]
+        self._soil_con = [ffi.new('soil_con_struct *', cells[c].soil_con[0])
+                          for c in range(ncells)]
+        self._states = SnapshotRing(cells, 1)
+        self._states.take(0)
+        self._out = None
+
+    def reset(self):
+        '''Reset the states and the soil parameters of the cells.'''
+        for c, soil_con in enumerate(self._soil_con):
+            self.cells[c].soil_con[0] = soil_con[0]
+        self._states.restore(0)
+
+    def set_params(self, params):
+        '''Set soil parameters of the cells.
+
+        Parameters
+        ----------
+        params : dict
+            Values of the parameters, by name, e.g. ``'b_infilt'``, or by
+            name and soil layer, e.g. ``('depth', 2)``, see the ``CALIB_*``
+            enum. A value is a scalar or a sequence with one value per
+            cell.
+        '''
+        ncells = len(self._soil_con)
+        for key, values in params.items():
+            name, layer = key if isinstance(key, tuple) else (key, 0)
+            index = _calib_param_index(name)
+            values = np.broadcast_to(np.asarray(values, dtype=np.float64),
+                                     (ncells, ))
+            for c in range(ncells):
+                if lib.vic_set_soil_param(self.cells[c].soil_con, index,
+                                          layer, values[c]):
+                    raise ValueError('invalid %s = %f of layer %d of cell '
+                                     '%d' % (name, values[c], layer, c))
+
+    def trial(self, params):
+        '''Run a trial from the initial states.
+
+        Parameters
+        ----------
+        params : dict
+            Soil parameters of the trial, see ``set_params``. The other
+            parameters have their initial values.
+
+        Returns
+        -------
+        stats : dict
+            Bias, root mean square error, Nash-Sutcliffe and Kling-Gupta
+            efficiencies of the simulation over all cells and steps, and the
+            number of cells whose run failed.
+        '''
+        self.reset()
+        self.set_params(params)
+        self._out, errors = vic_run_batch(self.cells, self.forcing, self.dmy,
+                                          self.outvars, out=self._out)
+        sim = self._out.sum(axis=2)
+        obs = self.observed
+        valid = np.isfinite(sim) & np.isfinite(obs)
+        sim = sim[valid]
+        obs = obs[valid]
+
+        r = np.corrcoef(sim, obs)[0, 1]
+        alpha = sim.std() / obs.std()
+        beta = sim.mean() / obs.mean()
+        return {'bias': sim.mean() - obs.mean(),
+                'rmse': np.sqrt(np.mean((sim - obs) ** 2)),
+                'nse': 1 - np.sum((sim - obs) ** 2) /
+                np.sum((obs - obs.mean()) ** 2),
+                'kge': 1 - np.sqrt((r - 1) ** 2 + (alpha - 1) ** 2 +
+                                   (beta - 1) ** 2),
+                'nerrors': int(np.count_nonzero(errors))}
@@ -30,14 +30,20 @@ from ._vic import ffi
 def _load_lib(lib):
     import os
     import sysconfig
-    suffix = sysconfig.get_config_var('SO')
+    suffix = (sysconfig.get_config_var('EXT_SUFFIX') or
+              sysconfig.get_config_var('SO'))
     path = os.path.join(os.path.dirname(__file__), os.pardir,
                         '{0}{1}'.format(lib, suffix))
 
     return ffi.dlopen(path)
 
 
-lib = _load_lib('vic_core')
+try:
+    # API mode: the VIC sources are compiled into the cffi module
+    from ._vic import lib
+except ImportError:
+    # ABI mode: the functions of vic_core are called through libffi
+    lib = _load_lib('vic_core')
 
 # Initialize global structures
 lib.initialize_log()
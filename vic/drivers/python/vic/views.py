@@ -0,0 +1,144 @@
+"""
+  @section DESCRIPTION
+
+  Zero-copy NumPy views of the VIC state and output buffers
+
+  The tiles (vegetation types x snow bands) of the state structures of a cell
+  are allocated as one block per structure type, and the output values of all
+  cells as one block (see make_all_vars and alloc_out_data). A field of these
+  structures is therefore a regularly strided array and can be viewed as a
+  NumPy array without copying. Writing to a view writes to the model state.
+
+  The views are only valid as long as the underlying C memory is allocated.
+
+  @section LICENSE
+
+  The Variable Infiltration Capacity (VIC) macroscale hydrological model
+  Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+  and Environmental Engineering, University of Washington.
+
+  The VIC model is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along with
+  this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+"""
+
+import numpy as np
+
+from .vic import ffi, lib
+from .driver import _outvar_index
+
+
+def _double_field(ctype, field):
+    '''Return the byte offset of a double field of a struct type.'''
+    fields = dict(ffi.typeof(ctype).fields)
+    if field not in fields:
+        raise ValueError('%s has no field %s' % (ctype, field))
+    if fields[field].type.cname != 'double':
+        raise ValueError('%s.%s is not a double' % (ctype, field))
+    return fields[field].offset
+
+
+def _tile_view(block, ntiles, ctype, offset, shape, strides):
+    '''View a field of a block of ntiles * SNOW_BAND structs.'''
+    nbytes = ntiles * lib.options.SNOW_BAND * ffi.sizeof(ctype)
+    buf = ffi.buffer(block, nbytes)
+    return np.ndarray(shape, dtype=np.float64, buffer=buf, offset=offset,
+                      strides=strides)
+
+
+def tile_view(all_vars, ntiles, struct, field):
+    '''Return a view of a double field of the state of each tile.
+
+    Parameters
+    ----------
+    all_vars : cdata 'all_vars_struct *'
+        State of a cell, e.g. from ``lib.make_all_vars``.
+    ntiles : int
+        Number of tiles, i.e. the number of vegetation types + 1
+        (``veg_con[0].vegetat_type_num + 1``).
+    struct : {'cell', 'energy', 'snow', 'veg_var'}
+        State structure.
+    field : str
+        Name of a double field of the structure, e.g. ``'swq'``.
+
+    Returns
+    -------
+    view : ndarray, shape ``[ntiles, SNOW_BAND]``
+    '''
+    ctypes = {'cell': 'cell_data_struct', 'energy': 'energy_bal_struct',
+              'snow': 'snow_data_struct', 'veg_var': 'veg_var_struct'}
+    if struct not in ctypes:
+        raise ValueError('unknown state structure %s' % struct)
+    ctype = ctypes[struct]
+    size = ffi.sizeof(ctype)
+    nbands = lib.options.SNOW_BAND
+
+    return _tile_view(getattr(all_vars, struct)[0], ntiles, ctype,
+                      _double_field(ctype, field), (ntiles, nbands),
+                      (nbands * size, size))
+
+
+def layer_view(all_vars, ntiles, field):
+    '''Return a view of a double field of the soil layers of each tile.
+
+    Parameters
+    ----------
+    all_vars : cdata 'all_vars_struct *'
+        State of a cell.
+    ntiles : int
+        Number of tiles (vegetation types + 1).
+    field : str
+        Name of a double field of layer_data_struct, e.g. ``'moist'``.
+
+    Returns
+    -------
+    view : ndarray, shape ``[ntiles, SNOW_BAND, Nlayer]``
+    '''
+    size = ffi.sizeof('cell_data_struct')
+    nbands = lib.options.SNOW_BAND
+    offset = (ffi.offsetof('cell_data_struct', 'layer') +
+              _double_field('layer_data_struct', field))
+
+    return _tile_view(all_vars.cell[0], ntiles, 'cell_data_struct', offset,
+                      (ntiles, nbands, lib.options.Nlayer),
+                      (nbands * size, size, ffi.sizeof('layer_data_struct')))
+
+
+def out_data_view(out_data, ncells, outvar):
+    '''Return a view of an output variable of all cells.
+
+    Parameters
+    ----------
+    out_data : cdata 'double ***'
+        Output buffer from ``lib.alloc_out_data``.
+    ncells : int
+        Number of cells of the buffer.
+    outvar : str
+        Output variable, e.g. ``'OUT_SOIL_MOIST'``.
+
+    Returns
+    -------
+    view : ndarray, shape ``[ncells, nelem]``
+    '''
+    index = _outvar_index(outvar)
+    nvalues = sum(lib.out_metadata[i].nelem
+                  for i in range(lib.N_OUTVAR_TYPES))
+    size = ffi.sizeof('double')
+    values = out_data[0][0]
+    offset = (int(ffi.cast('uintptr_t', out_data[0][index])) -
+              int(ffi.cast('uintptr_t', values)))
+    buf = ffi.buffer(values, ncells * nvalues * size)
+
+    return np.ndarray((ncells, lib.out_metadata[index].nelem),
+                      dtype=np.float64, buffer=buf, offset=offset,
+                      strides=(nvalues * size, size))
@@ -1,9 +1,79 @@
+import re
+
 from cffi import FFI
 from vic_headers import headers
+import vic_build_config as config
+
+
+def defined_functions(sources):
+    '''Names of the functions defined in the C sources. The names of the
+    function definitions start the line, after the return type on the line
+    above (see the VIC style guide).'''
+    names = set()
+    for source in sources:
+        with open(source) as f:
+            names.update(re.findall(r'^([A-Za-z_]\w*)\s*\(', f.read(),
+                                    re.MULTILINE))
+    return names
+
+
+def api_headers(headers, names):
+    '''Drop the prototypes of the functions that are not defined in the
+    sources of the module, e.g. those of the image driver, which cannot be
+    linked in API mode.'''
+    headers = '\n'.join(line for line in headers.split('\n')
+                        if not line.lstrip().startswith('#'))
+    statements = []
+    start = 0
+    depth = 0
+    for i, c in enumerate(headers):
+        if c == '{':
+            depth += 1
+        elif c == '}':
+            depth -= 1
+        elif c == ';' and depth == 0:
+            statements.append(headers[start:i + 1])
+            start = i + 1
+    statements.append(headers[start:])
+
+    kept = []
+    for statement in statements:
+        head = statement.split('(', 1)[0].split()
+        # a prototype has a return type and a name before its arguments
+        if ('(' in statement and len(head) >= 2 and
+                head[0] not in ('typedef', 'extern') and
+                re.match(r'^\**([A-Za-z_]\w*)$', head[-1])):
+            name = re.match(r'^\**([A-Za-z_]\w*)$', head[-1]).group(1)
+            if name not in names:
+                continue
+        kept.append(statement)
+    return ''.join(kept)
+
+
+# the globals of src/globals.c, which only the functions that use them declare
+api_preamble = '''#include <vic_driver_python.h>
+extern int                 flag;
+extern global_param_struct global_param;
+extern option_struct       options;
+extern parameters_struct   param;
+extern param_set_struct    param_set;
+extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
+'''
 
 ffi = FFI()
-ffi.cdef(headers)
-ffi.set_source('vic/_vic', None)
+if config.use_cffi_api:
+    # the VIC sources are compiled into the module, the functions are called
+    # directly
+    ffi.cdef(api_headers(headers, defined_functions(config.sources)))
+    ffi.set_source('vic._vic', api_preamble,
+                   sources=config.sources,
+                   include_dirs=config.include_dirs,
+                   extra_compile_args=config.extra_compile_args,
+                   extra_link_args=config.extra_link_args)
+else:
+    # the functions of vic_core are called through libffi
+    ffi.cdef(headers)
+    ffi.set_source('vic._vic', None)
 
 if __name__ == '__main__':
     ffi.compile()
@@ -56,7 +56,41 @@ enum
     NETCDF3_CLASSIC,
     NETCDF3_64BIT_OFFSET,
     NETCDF4_CLASSIC,
-    NETCDF4
+    NETCDF4,
+    BINARY_FAST,
+    ADIOS2_SST,
+    ADIOS2_BP5
+};
+
+/******************************************************************************
+ * @brief   History file flush policies
+ *****************************************************************************/
+enum
+{
+    FLUSH_ALWAYS,    /**< sync after every record */
+    FLUSH_NEVER,     /**< sync only when the file is closed */
+    FLUSH_NRECORDS,  /**< sync every flush_n records */
+    FLUSH_STATE,     /**< sync when a state file is written */
+    FLUSH_SECONDS    /**< sync at most every flush_n seconds (wall clock) */
+};
+
+/******************************************************************************
+ * @brief   History file chunk shapes
+ *****************************************************************************/
+enum
+{
+    CHUNK_DEFAULT,   /**< chunk shapes chosen by the netCDF library */
+    CHUNK_SLICE,     /**< one record of the full grid per chunk */
+    CHUNK_SERIES     /**< chunk_n records of a chunk_n tile per chunk */
+};
+
+/******************************************************************************
+ * @brief   Reductions of the cells of a region of a region stream
+ *****************************************************************************/
+enum
+{
+    REGION_MEAN,     /**< area weighted mean of the cells of a region */
+    REGION_SUM       /**< area weighted sum of the cells of a region */
 };
 
 /******************************************************************************
@@ -97,6 +131,8 @@ enum
     PRESSURE,    /**< atmospheric pressure [kPa] */
     VP,          /**< vapor pressure [kPa] */
     SWDOWN,      /**< incoming shortwave [W/m2] */
+    TMAX,        /**< daily maximum air temperature (FORCE_DISAGG) [C] */
+    TMIN,        /**< daily minimum air temperature (FORCE_DISAGG) [C] */
     WIND,        /**< wind speed [m/s] */
     SKIP,        /**< place holder for unused data columns */
     // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
@@ -282,6 +318,16 @@ enum
     // Timing and Profiling Terms
     OUT_TIME_VICRUN_WALL, /**< Wall time spent inside vic_run [seconds] */
     OUT_TIME_VICRUN_CPU,  /**< Wall time spent inside vic_run [seconds] */
+    // Solver Counters
+    OUT_SOLVER_BRENT_ITER, /**< iterations of root_brent [count] */
+    OUT_SOLVER_BRENT_FAIL, /**< root_brent calls that did not bracket the root [count] */
+    OUT_SOLVER_NEWT_RAPH_ITER, /**< iterations of newt_raph [count] */
+    OUT_SOLVER_RUNOFF_STEPS, /**< sub-steps of runoff [count] */
+    OUT_SOLVER_SNOW_MELT, /**< snow pack energy balance solutions [count] */
+    OUT_SOLVER_LAKE_MIX_ITER, /**< convective mixing passes of the lake [count] */
+    OUT_SOLVER_SNOW_STEPS, /**< sub-steps of the surface energy balance [count] */
+    OUT_SOLVER_BRENT_RETRY, /**< roots bracketed by the ROOT_RETRY search [count] */
+    OUT_SOLVER_BAND_SOLVES, /**< surface flux solutions of the snow bands [count] */
     // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
     // used as a loop counter and must be >= the largest value in this enum
     N_OUTVAR_TYPES        /**< used as a loop counter*/
@@ -385,7 +431,37 @@ enum
     AGG_TYPE_END,     /**< value at end of agg interval */
     AGG_TYPE_MAX,     /**< maximum value over agg interval */
     AGG_TYPE_MIN,     /**< minimum value over agg interval */
-    AGG_TYPE_SUM      /**< sum over agg interval */
+    AGG_TYPE_SUM,     /**< sum over agg interval */
+    AGG_TYPE_VAR,     /**< variance over agg interval */
+    AGG_TYPE_STDEV,   /**< standard deviation over agg interval */
+    AGG_TYPE_ABOVE,   /**< time steps above a threshold in agg interval */
+    AGG_TYPE_BELOW,   /**< time steps below a threshold in agg interval */
+    AGG_TYPE_QUANTILE /**< approximate quantile over agg interval */
+};
+
+/******************************************************************************
+ * @brief   Markers of the P-square quantile estimate of AGG_TYPE_QUANTILE
+ *****************************************************************************/
+#define AGG_QUANTILE_MARKERS 5
+
+/******************************************************************************
+ * @brief   Groups of output variables that put_data only computes when a
+ *          stream requests one of their variables
+ *****************************************************************************/
+enum
+{
+    OUT_GROUP_BASE,    /**< always computed */
+    OUT_GROUP_ENERGY,  /**< energy balance terms */
+    OUT_GROUP_BAND,    /**< snow band terms */
+    OUT_GROUP_CARBON,  /**< carbon cycle terms */
+    OUT_GROUP_LAKE,    /**< lake terms */
+    OUT_GROUP_BALANCE, /**< water and energy balance errors, for
+                          BALANCE_CHECK = OUTPUT */
+    OUT_GROUP_TIME_WALL, /**< wall time of vic_run, for the cell timer */
+    OUT_GROUP_TIME_CPU, /**< CPU time of vic_run, for the cell timer */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_OUT_GROUPS       /**< used as a loop counter*/
 };
 
 /******************************************************************************
@@ -444,6 +520,8 @@ enum time_units
 
 /******************************************************************************
  * @brief   Codes for timers
+ * @details The timers after TIMER_VIC_FINAL accumulate the time spent in the
+ *          phases of the time steps. They are used by the image driver.
  *****************************************************************************/
 enum timers
 {
@@ -451,6 +529,15 @@ enum timers
     TIMER_VIC_INIT,
     TIMER_VIC_RUN,
     TIMER_VIC_FINAL,
+    TIMER_VIC_FORCE_READ,     /**< reading the forcings (master node) */
+    TIMER_VIC_FORCE_SCATTER,  /**< scattering the forcings */
+    TIMER_VIC_PHYSICS,        /**< vic_run */
+    TIMER_VIC_PUT_DATA,       /**< put_data */
+    TIMER_VIC_AGG,            /**< aggregation of the output streams */
+    TIMER_VIC_HIST_GATHER,    /**< gathering the history records */
+    TIMER_VIC_HIST_WRITE,     /**< writing the history files */
+    TIMER_VIC_STATE_WRITE,    /**< writing the state files */
+    TIMER_VIC_ROUTING,        /**< inline routing (ROUT_PARAM) */
     N_TIMERS
 };
 
@@ -506,6 +593,16 @@ typedef struct {
     FILE *fh;                        /**< filehandle */
     unsigned short int file_format;  /**< output file format */
     short int compress;              /**< Compress output files in stream*/
+    unsigned short int flush;        /**< flush policy of the history file */
+    int flush_n;                     /**< number of records or seconds
+                                          between flushes */
+    bool shuffle;                    /**< apply the shuffle filter when
+                                          compressing */
+    unsigned short int chunk;        /**< chunk shape of the history file */
+    int chunk_n[3];                  /**< records, rows and columns per chunk
+                                          (CHUNK_SERIES, 0 = full extent) */
+    int chunk_cache;                 /**< chunk cache per variable [MB],
+                                          0 = library default */
     unsigned short int *type;        /**< type, when written to a binary file;
                                           OUT_TYPE_USINT  = unsigned short int
                                           OUT_TYPE_SINT   = short int
@@ -518,9 +615,44 @@ typedef struct {
                                           The order of the id numbers in the varid array
                                           is the order in which the variables will be written. */
     unsigned short int *aggtype;     /**< type of aggregation to use [shape=(nvars, )] */
+    double *aggparam;                /**< threshold (AGG_TYPE_ABOVE,
+                                          AGG_TYPE_BELOW) or probability
+                                          (AGG_TYPE_QUANTILE) of the
+                                          aggregation [shape=(nvars, )] */
+    int *digits;                     /**< significant decimal digits kept in the history file,
+                                          0 = all [shape=(nvars, )] */
     double ****aggdata;              /**< array of aggregated data values [shape=(ngridcells, nvars, nelem, nbins)] */
+    double *aggvalues;               /**< contiguous storage of aggdata [shape=(nvars, nelem, ngridcells)],
+                                          followed by aggbins */
+    double *aggbins;                 /**< bins 1 to nbins - 1 of the variables with more than one bin,
+                                          the state of their aggregation
+                                          [shape=(nelem * (nbins - 1), ngridcells) for each variable] */
+    size_t naggvalues;               /**< number of values in aggvalues, including aggbins */
     alarm_struct agg_alarm;          /**< alaram for stream aggregation */
     alarm_struct write_alarm;        /**< alaram for controlling stream write */
+    alarm_struct *cascade_alarm;     /**< aggregation alarm of the finer stream
+                                          whose records are aggregated into
+                                          this stream, NULL = aggregated from
+                                          out_data (OUT_CASCADE) */
+    double *cascade_values;          /**< aggvalues of that stream */
+    size_t *cascade_rows;            /**< first row of each variable in
+                                          cascade_values [shape=(nvars, )] */
+    char mask[MAXSTRING];            /**< domain variable that selects the
+                                          cells of the stream, "" = all
+                                          cells (OUTMASK) */
+    size_t *cells;                   /**< selected cells in ascending order
+                                          [shape=(ngridcells, )] */
+    double ***cell_data;             /**< out_data of the selected cells
+                                          [shape=(ngridcells, )] */
+    char region[MAXSTRING];          /**< domain variable with the region of
+                                          each cell, "" = not a region
+                                          stream (OUTREGION) */
+    unsigned short int region_reduce; /**< reduction of the cells of a
+                                          region: REGION_MEAN or REGION_SUM */
+    char *buffer;                    /**< records not yet written to fh */
+    size_t buffer_size;              /**< allocated size of buffer */
+    size_t buffer_len;               /**< number of bytes stored in buffer */
+    size_t record_size;              /**< bytes of a BINARY record */
 } stream_struct;
 
 /******************************************************************************
@@ -533,6 +665,12 @@ typedef struct {
     double surfstor;              /**< surface water storage [mm] */
     double swe;                   /**< snow water equivalent [mm] */
     double wdew;                  /**< canopy interception [mm] */
+    double balance_flux;          /**< inflow - outflow since the last water
+                                     balance check [mm] */
+    size_t balance_steps;         /**< time steps since the last
+                                     initialization */
+    bool balance_cell;            /**< FALSE = the balances of the cell are
+                                     not checked with BALANCE_CHECK = CELLS */
 } save_data_struct;
 
 /******************************************************************************
@@ -576,7 +714,23 @@ typedef struct {
     double delta_cpu;
 } timer_struct;
 
+/******************************************************************************
+ * @brief   This structure accumulates the average July air temperature of
+ *          the forcings over consecutive forcing windows
+ *****************************************************************************/
+typedef struct {
+    double MonthSum;   /**< sum of the air temperature of the current July */
+    size_t MonthCnt;   /**< number of sub-steps in the current July */
+    double AnnualSum;  /**< sum of the average temperatures of past Julys */
+    size_t AnnualCnt;  /**< number of past Julys */
+} july_tavg_struct;
+
 double air_density(double t, double p);
+void accumulate_july_tavg(force_data_struct *, dmy_struct *, size_t,
+                          july_tavg_struct *);
+void agg_stream_alarm(stream_struct *stream, dmy_struct *dmy_current);
+void agg_stream_cells(stream_struct *stream, dmy_struct *dmy_current,
+                      size_t first, size_t last, double ***out_data);
 void agg_stream_data(stream_struct *stream, dmy_struct *dmy_current,
                      double ***out_data);
 double all_30_day_from_dmy(dmy_struct *dmy);
@@ -584,35 +738,52 @@ double all_leap_from_dmy(dmy_struct *dmy);
 void alloc_aggdata(stream_struct *stream);
 void alloc_out_data(size_t ngridcells, double ****out_data);
 double average(double *ar, size_t n);
+bool balance_check_requested(save_data_struct *save_data);
 double calc_energy_balance_error(double, double, double, double, double);
 void calc_root_fractions(veg_con_struct *veg_con, soil_con_struct *soil_con);
 double calc_water_balance_error(double, double, double, double);
 bool cell_method_from_agg_type(unsigned short int aggtype, char cell_method[]);
 bool check_write_flag(int rec);
-void collect_eb_terms(energy_bal_struct, snow_data_struct, cell_data_struct,
-                      double, double, double, bool, bool, double, bool, int,
+void check_specialized_options(void);
+void collect_band_terms(const energy_bal_struct *, const snow_data_struct *,
+                        double, bool, double, bool, int, double **);
+void collect_eb_terms(const energy_bal_struct *, const snow_data_struct *,
+                      const cell_data_struct *, double, bool, bool, bool,
                       double *, double, double **);
-void collect_wb_terms(cell_data_struct, veg_var_struct, snow_data_struct,
-                      double, double, double, bool, double, bool, double *,
+void collect_wb_terms(const cell_data_struct *, const veg_var_struct *,
+                      const snow_data_struct *, double, bool, bool, double *,
                       double **);
+void collect_lake_terms(const lake_var_struct *, double, double, double,
+                        double **);
+void collect_perf_regions(
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS]);
 void compute_derived_state_vars(all_vars_struct *, soil_con_struct *,
                                 veg_con_struct *);
 void compute_lake_params(lake_con_struct *, soil_con_struct);
-void compute_treeline(force_data_struct *, dmy_struct *, double, double *,
-                      bool *);
+void compute_treeline(double, double *, bool *);
+void copy_all_vars(all_vars_struct *dst, all_vars_struct *src, size_t nveg);
 size_t count_force_vars(FILE *gp);
 void count_nstreams_nvars(FILE *gp, size_t *nstreams, size_t nvars[]);
 void cmd_proc(int argc, char **argv, char *globalfilename);
-void compress_files(char string[], short int level);
 stream_struct create_outstream(stream_struct *output_streams);
 double get_cpu_time();
 void get_current_datetime(char *cdt);
+double get_elapsed_time();
+double get_july_tavg(july_tavg_struct *);
 double get_wall_time();
 double date2num(double origin, dmy_struct *date, double tzoffset,
                 unsigned short int calendar, unsigned short int time_units);
+long day_number_from_dmy(dmy_struct *dmy, unsigned short int calendar);
+int dmy_add_months(dmy_struct *dmy, int n, unsigned short int calendar,
+                   dmy_struct *result);
+void dmy_add_seconds(dmy_struct *dmy, long long seconds,
+                     unsigned short int calendar, dmy_struct *result);
 void dmy_all_30_day(double julian, dmy_struct *dmy);
 void dmy_all_leap(double julian, dmy_struct *dmy);
 bool dmy_equal(dmy_struct *a, dmy_struct *b);
+void dmy_from_day_number(long day_number, unsigned short int calendar,
+                         dmy_struct *dmy);
+void dmy_from_step(global_param_struct *global, size_t step, dmy_struct *dmy);
 void dmy_julian_day(double julian, unsigned short int calendar,
                     dmy_struct *dmy);
 void dmy_no_leap_day(double julian, dmy_struct *dmy);
@@ -620,7 +791,7 @@ void dt_seconds_to_time_units(unsigned short int time_units, double dt_seconds,
                               double *dt_time_units);
 void display_current_settings(int);
 double fractional_day_from_dmy(dmy_struct *dmy);
-void free_all_vars(all_vars_struct *all_vars, int Nveg);
+void free_all_vars(all_vars_struct *all_vars);
 void free_dmy(dmy_struct **dmy);
 void free_out_data(size_t ngridcells, double ***out_data);
 void free_streams(stream_struct **streams);
@@ -645,6 +816,7 @@ void initialize_save_data(all_vars_struct *all_vars, force_data_struct *force,
 void initialize_snow(snow_data_struct **snow, size_t veg_num);
 void initialize_soil(cell_data_struct **cell, size_t veg_num);
 void initialize_time(void);
+void initialize_time_steps(global_param_struct *global);
 void initialize_veg(veg_var_struct **veg_var, size_t nveg);
 double julian_day_from_dmy(dmy_struct *dmy, unsigned short int calendar);
 bool leap_year(unsigned short int year, unsigned short int calendar);
@@ -652,6 +824,7 @@ all_vars_struct make_all_vars(size_t nveg);
 cell_data_struct **make_cell_data(size_t veg_type_num);
 dmy_struct *make_dmy(global_param_struct *global);
 energy_bal_struct **make_energy_bal(size_t nveg);
+lake_var_struct *make_lake_var(void);
 void make_lastday(unsigned short int calendar, unsigned short int year,
                   unsigned short int lastday[]);
 snow_data_struct **make_snow_data(size_t nveg);
@@ -698,25 +871,38 @@ void print_usage(char *);
 double q_to_vp(double q, double p);
 bool raise_alarm(alarm_struct *alarm, dmy_struct *dmy_current);
 void reset_alarm(alarm_struct *alarm, dmy_struct *dmy_current);
+void reset_all_vars(all_vars_struct *all_vars, size_t nveg);
+void reset_july_tavg(july_tavg_struct *);
 void reset_stream(stream_struct *stream, dmy_struct *dmy_current);
 void set_output_var(stream_struct *stream, char *varname, size_t varnum,
                     char *format, unsigned short int type, double mult,
                     unsigned short int aggtype);
 unsigned int get_default_outvar_aggtype(unsigned int varid);
+size_t get_agg_type_nbins(unsigned short int aggtype);
+unsigned short int get_outvar_group(unsigned int varid);
+bool outvar_group_requested(unsigned short int group);
 void set_alarm(dmy_struct *dmy_current, unsigned int freq, void *value,
                alarm_struct *alarm);
+void set_dmy_window(global_param_struct *global, size_t first, size_t n,
+                    dmy_struct *dmy);
 void set_output_defaults(stream_struct **output_streams,
                          dmy_struct     *dmy_current,
                          unsigned short  default_file_format);
 void set_output_met_data_info();
+void set_outvar_groups(stream_struct *streams);
+void set_outvar_groups_step(stream_struct *streams, dmy_struct *dmy_current);
+void set_stream_cascades(stream_struct *streams);
+void set_timer_hook(void (*hook)(timer_struct *t, bool start));
 void setup_stream(stream_struct *stream, size_t nvars, size_t ngridcells);
 void soil_moisture_from_water_table(soil_con_struct *soil_con, size_t nlayers);
 void sprint_dmy(char *str, dmy_struct *dmy);
 void str_from_calendar(unsigned short int calendar, char *calendar_str);
 void str_from_time_units(unsigned short int time_units, char *unit_str);
+double str_to_agg_param(char aggstr[]);
 unsigned short int str_to_agg_type(char aggstr[]);
 void str_to_ascii_format(char *format);
 bool str_to_bool(char str[]);
+size_t str_to_doubles(char str[], double *values, size_t nvalues);
 unsigned short int str_to_calendar(char *cal_chars);
 unsigned short int str_to_freq_flag(char freq[]);
 double str_to_out_mult(char multstr[]);
@@ -727,13 +913,17 @@ double time_delta(dmy_struct *dmy_current, unsigned short int freq, int n);
 void timer_continue(timer_struct *t);
 void timer_init(timer_struct *t);
 void timer_start(timer_struct *t);
+void timer_start_clocks(timer_struct *t, bool wall, bool cpu);
 void timer_stop(timer_struct *t);
+void timer_stop_clocks(timer_struct *t, bool wall, bool cpu);
 int update_step_vars(all_vars_struct *, veg_con_struct *, veg_hist_struct *);
 int invalid_date(unsigned short int calendar, dmy_struct *dmy);
 void validate_parameters(void);
 void validate_streams(stream_struct **stream);
 char will_it_snow(double *t, double t_offset, double max_snow_temp,
                   double *prcp, size_t n);
+void write_perf_regions_table(
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS], int nprocs);
 void zero_output_list(double **);
 
 #endif
@@ -27,80 +27,618 @@
 #include <vic_driver_shared_all.h>
 
 /******************************************************************************
- * @brief    Perform temporal aggregation on stream data
+ * @brief    Advance the aggregation alarm of a stream by one time step.
+ * @details  Must be called once per time step before agg_stream_cells().
  *****************************************************************************/
 void
-agg_stream_data(stream_struct *stream,
-                dmy_struct    *dmy_current,
-                double      ***out_data)
+agg_stream_alarm(stream_struct *stream,
+                 dmy_struct    *dmy_current)
+{
+    alarm_struct *alarm;
+
+    alarm = &(stream->agg_alarm);
+    alarm->count++;
+
+    if (alarm->count == 1) {
+        stream->time_bounds[0] = *dmy_current;
+    }
+
+    if (raise_alarm(alarm, dmy_current)) {
+        stream->time_bounds[1] = *dmy_current;
+    }
+}
+
+/******************************************************************************
+ * @brief    Length of the aggregation interval of a stream with a uniform
+ *           interval.
+ * @return   number of seconds, 0 if the intervals differ in length (months
+ *           and years) or are not periodic
+ *****************************************************************************/
+static long long
+get_cascade_seconds(alarm_struct *alarm)
+{
+    extern global_param_struct global_param;
+
+    if (alarm->freq == FREQ_NSTEPS) {
+        return (long long) alarm->n * (long long) global_param.dt;
+    }
+    else if (alarm->freq == FREQ_NSECONDS) {
+        return (long long) alarm->n;
+    }
+    else if (alarm->freq == FREQ_NMINUTES) {
+        return (long long) alarm->n * SEC_PER_MIN;
+    }
+    else if (alarm->freq == FREQ_NHOURS) {
+        return (long long) alarm->n * SEC_PER_HOUR;
+    }
+    else if (alarm->freq == FREQ_NDAYS) {
+        return (long long) alarm->n * SEC_PER_DAY;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Find the rows of the variables of a stream in a finer stream.
+ * @return   false if a variable of the stream is not in the finer stream, or
+ *           is aggregated differently there
+ *****************************************************************************/
+static bool
+get_cascade_rows(stream_struct *stream,
+                 stream_struct *fine,
+                 size_t        *rows)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 row;
+    size_t                 j;
+    size_t                 m;
+
+    for (j = 0; j < stream->nvars; j++) {
+        row = 0;
+        for (m = 0; m < fine->nvars; m++) {
+            if (fine->varid[m] == stream->varid[j]) {
+                break;
+            }
+            row += out_metadata[fine->varid[m]].nelem;
+        }
+        if (m == fine->nvars || fine->aggtype[m] != stream->aggtype[j] ||
+            get_agg_type_nbins(stream->aggtype[j]) > 1 ||
+            stream->aggtype[j] == AGG_TYPE_ABOVE ||
+            stream->aggtype[j] == AGG_TYPE_BELOW) {
+            // the statistics of a record are not derived from the records
+            // of a finer stream
+            return false;
+        }
+        rows[j] = row;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Feed coarse output streams from the records of finer streams.
+ * @details  With OUT_CASCADE, a stream is aggregated from the aggregated
+ *           values of an earlier stream instead of from out_data when every
+ *           end of its interval is also the end of an interval of the earlier
+ *           stream, and the earlier stream holds all of its variables with
+ *           the same aggregation types. The intervals of both streams start
+ *           at the start of the run, so this holds if the interval of the
+ *           finer stream is uniform and divides the interval of the coarse
+ *           stream, or divides a day for monthly and yearly streams. A
+ *           monthly stream after a daily stream is then only aggregated once
+ *           a day. Of the finer streams that qualify, the coarsest one is
+ *           used.
+ *
+ *           The records of the coarse stream are the same as without
+ *           OUT_CASCADE up to round-off in the sums and averages.
+ *****************************************************************************/
+void
+set_stream_cascades(stream_struct *streams)
+{
+    extern option_struct options;
+
+    stream_struct       *stream;
+    stream_struct       *fine;
+    size_t              *rows;
+    long long            seconds;
+    long long            fine_seconds;
+    long long            best_seconds;
+    size_t               s;
+    size_t               f;
+
+    if (!options.OUT_CASCADE) {
+        return;
+    }
+
+    for (s = 1; s < options.Noutstreams; s++) {
+        stream = &(streams[s]);
+        seconds = get_cascade_seconds(&(stream->agg_alarm));
+        if (seconds == 0 && stream->agg_alarm.freq != FREQ_NMONTHS &&
+            stream->agg_alarm.freq != FREQ_NYEARS) {
+            continue;
+        }
+
+        rows = malloc(stream->nvars * sizeof(*rows));
+        check_alloc_status(rows, "Memory allocation error.");
+
+        best_seconds = 0;
+        for (f = 0; f < s; f++) {
+            fine = &(streams[f]);
+            fine_seconds = get_cascade_seconds(&(fine->agg_alarm));
+            if (fine_seconds == 0 || fine_seconds <= best_seconds ||
+                fine->ngridcells != stream->ngridcells ||
+                strcmp(fine->mask, stream->mask) != 0 ||
+                strcmp(fine->region, stream->region) != 0) {
+                continue;
+            }
+            if (seconds > 0) {
+                if (fine_seconds >= seconds || seconds % fine_seconds != 0) {
+                    continue;
+                }
+            }
+            else if (SEC_PER_DAY % fine_seconds != 0) {
+                continue;
+            }
+            if (!get_cascade_rows(stream, fine, rows)) {
+                continue;
+            }
+
+            if (stream->cascade_rows == NULL) {
+                stream->cascade_rows = malloc(stream->nvars *
+                                              sizeof(*(stream->cascade_rows)));
+                check_alloc_status(stream->cascade_rows,
+                                   "Memory allocation error.");
+            }
+            memcpy(stream->cascade_rows, rows,
+                   stream->nvars * sizeof(*rows));
+            stream->cascade_alarm = &(fine->agg_alarm);
+            stream->cascade_values = fine->aggvalues;
+            best_seconds = fine_seconds;
+            debug("stream %zu (%s) is aggregated from stream %zu (%s)", s,
+                  stream->prefix, f, fine->prefix);
+        }
+        free(rows);
+    }
+}
+
+/******************************************************************************
+ * @brief    Aggregate the grid cells first to last - 1 of a stream from the
+ *           records of the finer stream that feeds it.
+ * @details  The finer stream has aggregated the cells in this time step
+ *           already. Its completed records are summed, averaged weighted by
+ *           their number of time steps, or compared, and its first and last
+ *           values are the first and last values of this stream.
+ *****************************************************************************/
+static void
+agg_stream_cascade(stream_struct *stream,
+                   dmy_struct    *dmy_current,
+                   size_t         first,
+                   size_t         last)
 {
     extern metadata_struct out_metadata[N_OUTVAR_TYPES];
 
     alarm_struct          *alarm;
+    double                *aggvalues;
+    double                *fine;
+    double                 nfine;
     size_t                 i;
     size_t                 j;
     size_t                 k;
     size_t                 nelem;
-    unsigned int           varid;
     bool                   alarm_now;
+    bool                   fine_now;
 
     alarm = &(stream->agg_alarm);
-    alarm->count++;
     alarm_now = raise_alarm(alarm, dmy_current);
+    fine_now = raise_alarm(stream->cascade_alarm, dmy_current);
 
-    if (alarm->count == 1) {
-        stream->time_bounds[0] = *dmy_current;
+    // nothing to do until the finer stream completes a record, except at
+    // the start of a record
+    if (!fine_now && alarm->count != 1) {
+        return;
     }
+    nfine = (double) stream->cascade_alarm->count;
 
-    if (alarm_now) {
-        stream->time_bounds[1] = *dmy_current;
+    aggvalues = stream->aggvalues;
+    for (j = 0; j < stream->nvars; j++) {
+        nelem = out_metadata[stream->varid[j]].nelem;
+
+        for (k = 0; k < nelem; k++) {
+            fine = &(stream->cascade_values[(stream->cascade_rows[j] + k) *
+                                            stream->ngridcells]);
+            if ((stream->aggtype[j] == AGG_TYPE_END) && (alarm_now)) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = fine[i];
+                }
+            }
+            else if ((stream->aggtype[j] == AGG_TYPE_BEG) &&
+                     (alarm->count == 1)) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = fine[i];
+                }
+            }
+            else if (!fine_now) {
+                ;  // the record of the finer stream is not complete
+            }
+            else if (stream->aggtype[j] == AGG_TYPE_SUM) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] += fine[i];
+                }
+            }
+            else if (stream->aggtype[j] == AGG_TYPE_AVG) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] += fine[i] * nfine;
+                }
+            }
+            else if (stream->aggtype[j] == AGG_TYPE_MAX) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = max(aggvalues[i], fine[i]);
+                }
+            }
+            else if (stream->aggtype[j] == AGG_TYPE_MIN) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = min(aggvalues[i], fine[i]);
+                }
+            }
+            if ((stream->aggtype[j] == AGG_TYPE_AVG) && (alarm_now)) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] /= (double) alarm->count;
+                }
+            }
+            aggvalues += stream->ngridcells;
+        }
     }
+}
 
-    for (i = 0; i < stream->ngridcells; i++) {
-        for (j = 0; j < stream->nvars; j++) {
-            varid = stream->varid[j];
-            nelem = out_metadata[varid].nelem;
+/******************************************************************************
+ * @brief    Sort the first n of the quantile markers of a cell.
+ *****************************************************************************/
+static void
+sort_quantile_markers(double *q,
+                      size_t  n)
+{
+    double value;
+    size_t m;
+    size_t l;
 
+    for (m = 1; m < n; m++) {
+        value = q[m];
+        for (l = m; l > 0 && q[l - 1] > value; l--) {
+            q[l] = q[l - 1];
+        }
+        q[l] = value;
+    }
+}
+
+/******************************************************************************
+ * @brief    Add the value of a time step to the P-square estimate of a
+ *           quantile of a cell (Jain and Chlamtac, 1985).
+ * @details  bins holds the heights of the AGG_QUANTILE_MARKERS markers,
+ *           followed by the positions of the inner markers, stride values
+ *           apart. The first markers hold the first values of the record.
+ *****************************************************************************/
+static void
+agg_quantile_cell(double *bins,
+                  size_t  stride,
+                  double  value,
+                  size_t  count,
+                  double  prob)
+{
+    double q[AGG_QUANTILE_MARKERS];
+    double pos[AGG_QUANTILE_MARKERS];
+    double desired;
+    double qnew;
+    double d;
+    size_t m;
+    size_t cell;
+
+    if (count <= AGG_QUANTILE_MARKERS) {
+        bins[(count - 1) * stride] = value;
+        if (count == AGG_QUANTILE_MARKERS) {
+            for (m = 0; m < AGG_QUANTILE_MARKERS; m++) {
+                q[m] = bins[m * stride];
+            }
+            sort_quantile_markers(q, AGG_QUANTILE_MARKERS);
+            for (m = 0; m < AGG_QUANTILE_MARKERS; m++) {
+                bins[m * stride] = q[m];
+            }
+            for (m = 1; m < AGG_QUANTILE_MARKERS - 1; m++) {
+                bins[(AGG_QUANTILE_MARKERS + m - 1) * stride] =
+                    (double) (m + 1);
+            }
+        }
+        return;
+    }
+
+    for (m = 0; m < AGG_QUANTILE_MARKERS; m++) {
+        q[m] = bins[m * stride];
+    }
+    pos[0] = 1.;
+    for (m = 1; m < AGG_QUANTILE_MARKERS - 1; m++) {
+        pos[m] = bins[(AGG_QUANTILE_MARKERS + m - 1) * stride];
+    }
+    pos[AGG_QUANTILE_MARKERS - 1] = (double) (count - 1);
+
+    // the markers above the new value move up by one position
+    if (value < q[0]) {
+        q[0] = value;
+        cell = 0;
+    }
+    else if (value >= q[AGG_QUANTILE_MARKERS - 1]) {
+        q[AGG_QUANTILE_MARKERS - 1] = value;
+        cell = AGG_QUANTILE_MARKERS - 2;
+    }
+    else {
+        for (cell = 0; value >= q[cell + 1]; cell++) {
+            ;
+        }
+    }
+    for (m = cell + 1; m < AGG_QUANTILE_MARKERS; m++) {
+        pos[m] += 1.;
+    }
+
+    // move the inner markers towards their desired positions
+    for (m = 1; m < AGG_QUANTILE_MARKERS - 1; m++) {
+        if (m == 1) {
+            desired = 1. + (count - 1) * prob / 2.;
+        }
+        else if (m == 2) {
+            desired = 1. + (count - 1) * prob;
+        }
+        else {
+            desired = 1. + (count - 1) * (1. + prob) / 2.;
+        }
+        d = desired - pos[m];
+        if ((d >= 1. && pos[m + 1] - pos[m] > 1.) ||
+            (d <= -1. && pos[m - 1] - pos[m] < -1.)) {
+            d = d > 0. ? 1. : -1.;
+            // piecewise parabolic prediction, else linear
+            qnew = q[m] + d / (pos[m + 1] - pos[m - 1]) *
+                   ((pos[m] - pos[m - 1] + d) * (q[m + 1] - q[m]) /
+                    (pos[m + 1] - pos[m]) +
+                    (pos[m + 1] - pos[m] - d) * (q[m] - q[m - 1]) /
+                    (pos[m] - pos[m - 1]));
+            if (qnew <= q[m - 1] || qnew >= q[m + 1]) {
+                if (d > 0.) {
+                    qnew = q[m] + (q[m + 1] - q[m]) / (pos[m + 1] - pos[m]);
+                }
+                else {
+                    qnew = q[m] - (q[m - 1] - q[m]) / (pos[m - 1] - pos[m]);
+                }
+            }
+            q[m] = qnew;
+            pos[m] += d;
+        }
+    }
+
+    for (m = 0; m < AGG_QUANTILE_MARKERS; m++) {
+        bins[m * stride] = q[m];
+    }
+    for (m = 1; m < AGG_QUANTILE_MARKERS - 1; m++) {
+        bins[(AGG_QUANTILE_MARKERS + m - 1) * stride] = pos[m];
+    }
+}
+
+/******************************************************************************
+ * @brief    Quantile of a cell at the end of a record.
+ * @details  The middle marker of the P-square estimate, or the interpolated
+ *           quantile of the values of a record with fewer values than
+ *           markers.
+ *****************************************************************************/
+static double
+get_quantile_cell(double *bins,
+                  size_t  stride,
+                  size_t  count,
+                  double  prob)
+{
+    double q[AGG_QUANTILE_MARKERS];
+    double h;
+    size_t lo;
+    size_t m;
+
+    if (count >= AGG_QUANTILE_MARKERS) {
+        return bins[(AGG_QUANTILE_MARKERS / 2) * stride];
+    }
+
+    for (m = 0; m < count; m++) {
+        q[m] = bins[m * stride];
+    }
+    sort_quantile_markers(q, count);
+    h = prob * (double) (count - 1);
+    lo = (size_t) h;
+    if (lo + 1 >= count) {
+        return q[count - 1];
+    }
+    return q[lo] + (h - (double) lo) * (q[lo + 1] - q[lo]);
+}
+
+/******************************************************************************
+ * @brief    Position in a stream of selected cells of the first selected cell
+ *           at or after a cell.
+ *****************************************************************************/
+static size_t
+get_stream_cell_position(stream_struct *stream,
+                         size_t         cell)
+{
+    size_t lo;
+    size_t hi;
+    size_t mid;
+
+    lo = 0;
+    hi = stream->ngridcells;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (stream->cells[mid] < cell) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/******************************************************************************
+ * @brief    Perform temporal aggregation on the grid cells first to last - 1
+ *           of a stream.
+ * @details  The cells are independent of each other, so disjoint ranges of
+ *           cells can be aggregated by different threads. For a stream of
+ *           selected cells (OUTMASK, OUTREGION), first and last are cells of
+ *           out_data and the selected cells in the range are aggregated.
+ *****************************************************************************/
+void
+agg_stream_cells(stream_struct *stream,
+                 dmy_struct    *dmy_current,
+                 size_t         first,
+                 size_t         last,
+                 double      ***out_data)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    alarm_struct          *alarm;
+    double                *aggvalues;
+    double                *aggbins;
+    double                 value;
+    double                 delta;
+    size_t                 i;
+    size_t                 j;
+    size_t                 k;
+    size_t                 nelem;
+    size_t                 nbins;
+    unsigned int           varid;
+    bool                   alarm_now;
+
+    // a stream of selected cells aggregates its cells in the range
+    if (stream->cells != NULL) {
+        first = get_stream_cell_position(stream, first);
+        last = get_stream_cell_position(stream, last);
+        out_data = stream->cell_data;
+    }
+
+    // coarse streams are aggregated from a finer stream
+    if (stream->cascade_alarm != NULL) {
+        agg_stream_cascade(stream, dmy_current, first, last);
+        return;
+    }
+
+    alarm = &(stream->agg_alarm);
+    alarm_now = raise_alarm(alarm, dmy_current);
+
+    // the cells of each element of a variable are contiguous in aggvalues,
+    // and so are the cells of each of its other bins in aggbins
+    aggvalues = stream->aggvalues;
+    aggbins = stream->aggbins;
+    for (j = 0; j < stream->nvars; j++) {
+        varid = stream->varid[j];
+        nelem = out_metadata[varid].nelem;
+        nbins = get_agg_type_nbins(stream->aggtype[j]);
+
+        for (k = 0; k < nelem; k++) {
             // Instantaneous at the beginning of the period
             if ((stream->aggtype[j] == AGG_TYPE_END) && (alarm_now)) {
-                for (k = 0; k < nelem; k++) {
-                    stream->aggdata[i][j][k][0] = out_data[i][varid][k];
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = out_data[i][varid][k];
                 }
             }
             // Instantaneous at the end of the period
             else if ((stream->aggtype[j] == AGG_TYPE_BEG) &&
                      (alarm->count == 1)) {
-                for (k = 0; k < nelem; k++) {
-                    stream->aggdata[i][j][k][0] = out_data[i][varid][k];
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = out_data[i][varid][k];
                 }
             }
             // Sum over the period
             else if ((stream->aggtype[j] == AGG_TYPE_SUM) ||
                      (stream->aggtype[j] == AGG_TYPE_AVG)) {
-                for (k = 0; k < nelem; k++) {
-                    stream->aggdata[i][j][k][0] += out_data[i][varid][k];
+                for (i = first; i < last; i++) {
+                    aggvalues[i] += out_data[i][varid][k];
                 }
             }
             // Maximum over the period
             else if (stream->aggtype[j] == AGG_TYPE_MAX) {
-                for (k = 0; k < nelem; k++) {
-                    stream->aggdata[i][j][k][0] =
-                        max(stream->aggdata[i][j][k][0], out_data[i][varid][k]);
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = max(aggvalues[i], out_data[i][varid][k]);
                 }
             }
             // Minimum over the period
             else if (stream->aggtype[j] == AGG_TYPE_MIN) {
-                for (k = 0; k < nelem; k++) {
-                    stream->aggdata[i][j][k][0] =
-                        min(stream->aggdata[i][j][k][0], out_data[i][varid][k]);
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = min(aggvalues[i], out_data[i][varid][k]);
+                }
+            }
+            // Time steps above or below a threshold
+            else if (stream->aggtype[j] == AGG_TYPE_ABOVE) {
+                for (i = first; i < last; i++) {
+                    if (out_data[i][varid][k] > stream->aggparam[j]) {
+                        aggvalues[i] += 1.;
+                    }
+                }
+            }
+            else if (stream->aggtype[j] == AGG_TYPE_BELOW) {
+                for (i = first; i < last; i++) {
+                    if (out_data[i][varid][k] < stream->aggparam[j]) {
+                        aggvalues[i] += 1.;
+                    }
+                }
+            }
+            // Running mean (bin 1) and sum of squared deviations (Welford)
+            else if ((stream->aggtype[j] == AGG_TYPE_VAR) ||
+                     (stream->aggtype[j] == AGG_TYPE_STDEV)) {
+                for (i = first; i < last; i++) {
+                    value = out_data[i][varid][k];
+                    delta = value - aggbins[i];
+                    aggbins[i] += delta / (double) alarm->count;
+                    aggvalues[i] += delta * (value - aggbins[i]);
+                }
+            }
+            // Quantile markers (bins 1 to 8)
+            else if (stream->aggtype[j] == AGG_TYPE_QUANTILE) {
+                for (i = first; i < last; i++) {
+                    agg_quantile_cell(&(aggbins[i]), stream->ngridcells,
+                                      out_data[i][varid][k], alarm->count,
+                                      stream->aggparam[j]);
                 }
             }
             // Average over the period if counter is full
             if ((stream->aggtype[j] == AGG_TYPE_AVG) && (alarm_now)) {
-                for (k = 0; k < nelem; k++) {
-                    stream->aggdata[i][j][k][0] /= (double) alarm->count;
+                for (i = first; i < last; i++) {
+                    aggvalues[i] /= (double) alarm->count;
+                }
+            }
+            // Variance over the period if counter is full
+            else if ((stream->aggtype[j] == AGG_TYPE_VAR) && (alarm_now)) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] /= (double) alarm->count;
+                }
+            }
+            else if ((stream->aggtype[j] == AGG_TYPE_STDEV) && (alarm_now)) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = sqrt(aggvalues[i] / (double) alarm->count);
                 }
             }
+            else if ((stream->aggtype[j] == AGG_TYPE_QUANTILE) && (alarm_now)) {
+                for (i = first; i < last; i++) {
+                    aggvalues[i] = get_quantile_cell(&(aggbins[i]),
+                                                     stream->ngridcells,
+                                                     alarm->count,
+                                                     stream->aggparam[j]);
+                }
+            }
+            aggvalues += stream->ngridcells;
+            aggbins += (nbins - 1) * stream->ngridcells;
         }
     }
 }
+
+/******************************************************************************
+ * @brief    Perform temporal aggregation on stream data
+ *****************************************************************************/
+void
+agg_stream_data(stream_struct *stream,
+                dmy_struct    *dmy_current,
+                double      ***out_data)
+{
+    agg_stream_alarm(stream, dmy_current);
+    agg_stream_cells(stream, dmy_current, 0, stream->ngridcells, out_data);
+}
@@ -27,6 +27,30 @@
 
 #include <vic_driver_shared_all.h>
 
+/******************************************************************************
+ * @brief   Length of the interval of an alarm with a uniform frequency.
+ * @return  number of seconds
+ *****************************************************************************/
+static long long
+alarm_seconds(alarm_struct *alarm)
+{
+    if (alarm->freq == FREQ_NSECONDS) {
+        return (long long) alarm->n;
+    }
+    else if (alarm->freq == FREQ_NMINUTES) {
+        return (long long) alarm->n * SEC_PER_MIN;
+    }
+    else if (alarm->freq == FREQ_NHOURS) {
+        return (long long) alarm->n * SEC_PER_HOUR;
+    }
+    else if (alarm->freq == FREQ_NDAYS) {
+        return (long long) alarm->n * SEC_PER_DAY;
+    }
+    else {
+        log_err("Unknown frequency found during time_delta computation");
+    }
+}
+
 /******************************************************************************
  * @brief   This routine resets an alarm
  *****************************************************************************/
@@ -36,14 +60,13 @@ reset_alarm(alarm_struct *alarm,
 {
     extern global_param_struct global_param;
 
-    double                     delta;
-    double                     current;
-    double                     next;
-    double                     offset;
-    dmy_struct                 dmy_current_offset;
+    int                        status;
 
     alarm->count = 0;
 
+    // The next time of the alarm is computed with the integer date
+    // arithmetic in vic_time.c, so there are no round trips through the
+    // floating point numeric dates
     if ((alarm->freq == FREQ_NEVER) || (alarm->freq == FREQ_NSTEPS) ||
         (alarm->freq == FREQ_DATE) || (alarm->freq == FREQ_END)) {
         ;  // Do nothing, already set
@@ -62,33 +85,31 @@ reset_alarm(alarm_struct *alarm,
         // there might be a problem if startday > 28 !!!
 
         // Shift forward by one time step
-        offset = global_param.dt / (double) SEC_PER_DAY;
-        current = date2num(global_param.time_origin_num, dmy_current, 0,
-                           global_param.calendar, TIME_UNITS_DAYS);
-        current += offset;
-        num2date(global_param.time_origin_num, current, 0,
-                 global_param.calendar, TIME_UNITS_DAYS,
-                 &dmy_current_offset);
+        dmy_add_seconds(dmy_current, (long long) global_param.dt,
+                        global_param.calendar, &(alarm->next_dmy));
         // Advance
-        delta = time_delta(&dmy_current_offset, alarm->freq, alarm->n);
-        current = date2num(global_param.time_origin_num, &dmy_current_offset,
-                           0, global_param.calendar, TIME_UNITS_DAYS);
-        next = delta + current;
+        status = dmy_add_months(&(alarm->next_dmy), alarm->n,
+                                global_param.calendar, &(alarm->next_dmy));
+        if (status != 0) {
+            log_err("Invalid date found during time_delta computation");
+        }
         // Shift backward by one time step
-        next -= offset;
-        num2date(global_param.time_origin_num, next, 0,
-                 global_param.calendar, TIME_UNITS_DAYS,
-                 &(alarm->next_dmy));
+        dmy_add_seconds(&(alarm->next_dmy), -(long long) global_param.dt,
+                        global_param.calendar, &(alarm->next_dmy));
+    }
+    else if (alarm->freq == FREQ_NYEARS) {
+        status = dmy_add_months(dmy_current, alarm->n * MONTHS_PER_YEAR,
+                                global_param.calendar, &(alarm->next_dmy));
+        if (status != 0) {
+            log_err("VIC does not support a simulation starting from "
+                    "Feb 29 of a leap year with yearly AGGFREQ or "
+                    "HISTFREQ.");
+        }
     }
     else {
         // If other frequency types, directly advance without shifting
-        delta = time_delta(dmy_current, alarm->freq, alarm->n);
-        current = date2num(global_param.time_origin_num, dmy_current, 0,
-                           global_param.calendar, TIME_UNITS_DAYS);
-        next = delta + current;
-        num2date(global_param.time_origin_num, next, 0,
-                 global_param.calendar, TIME_UNITS_DAYS,
-                 &(alarm->next_dmy));
+        dmy_add_seconds(dmy_current, alarm_seconds(alarm),
+                        global_param.calendar, &(alarm->next_dmy));
     }
 }
 
@@ -120,8 +141,6 @@ set_alarm(dmy_struct   *dmy_current,
 {
     extern global_param_struct global_param;
     dmy_struct                 dmy_current_offset;
-    double                     delta;
-    double                     current;
 
     alarm->count = 0;
     alarm->freq = freq;
@@ -164,14 +183,8 @@ set_alarm(dmy_struct   *dmy_current,
         ;  // Do nothing, already set
     }
     else {
-        delta = time_delta(dmy_current, FREQ_NSECONDS,
-                           (int) global_param.dt);
-        current = date2num(global_param.time_origin_num, dmy_current, 0,
-                           global_param.calendar, TIME_UNITS_DAYS);
-        current -= delta;
-        num2date(global_param.time_origin_num, current, 0,
-                 global_param.calendar, TIME_UNITS_DAYS,
-                 &dmy_current_offset);
+        dmy_add_seconds(dmy_current, -(long long) global_param.dt,
+                        global_param.calendar, &dmy_current_offset);
     }
     // set alarm->next
     reset_alarm(alarm, &dmy_current_offset);
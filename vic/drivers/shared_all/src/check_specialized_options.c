@@ -0,0 +1,125 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Check the options of the run against the options fixed when compiling.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_all.h>
+
+#ifdef VIC_SPECIALIZE
+/******************************************************************************
+ * @brief    Stop if a boolean option differs from the specialized build.
+ *****************************************************************************/
+static void
+check_bool_option(char name[],
+                  bool value,
+                  bool specialized)
+{
+    if (value != specialized) {
+        log_err("This executable was built with SPECIALIZE=%s, which "
+                "requires %s = %s, but the run sets %s = %s. Use an "
+                "executable built without SPECIALIZE or with a matching "
+                "profile.", VIC_SPECIALIZE, name,
+                specialized ? "TRUE" : "FALSE", name,
+                value ? "TRUE" : "FALSE");
+    }
+}
+
+/******************************************************************************
+ * @brief    Stop if a size option differs from the specialized build.
+ *****************************************************************************/
+static void
+check_size_option(char   name[],
+                  size_t value,
+                  size_t specialized)
+{
+    if (value != specialized) {
+        log_err("This executable was built with SPECIALIZE=%s, which "
+                "requires %s = %zu, but the run sets %s = %zu. Use an "
+                "executable built without SPECIALIZE or with a matching "
+                "profile.", VIC_SPECIALIZE, name, specialized, name,
+                value);
+    }
+}
+#endif
+
+/******************************************************************************
+ * @brief    Check the options of the run against the options fixed when
+ *           compiling.
+ *
+ * @details  A specialized build (make SPECIALIZE=<profile>) reads the options
+ *           of its profile as constants in vic_run, see vic_specialize.h.
+ *           A mixed precision build (make MIXED_PRECISION=1) only runs water
+ *           balance simulations. Must be called once the options are final.
+ *           Without SPECIALIZE or MIXED_PRECISION, any options are accepted.
+ *****************************************************************************/
+void
+check_specialized_options(void)
+{
+#if defined(VIC_SPECIALIZE) || defined(VIC_MIXED_PRECISION)
+    extern option_struct options;
+#endif
+
+#ifdef VIC_MIXED_PRECISION
+    if (options.FULL_ENERGY || options.FROZEN_SOIL) {
+        log_err("This executable was built with MIXED_PRECISION, which only "
+                "runs water balance simulations with FULL_ENERGY = FALSE and "
+                "FROZEN_SOIL = FALSE. Use an executable built without "
+                "MIXED_PRECISION.");
+    }
+#endif
+
+#ifdef VIC_SPECIALIZE
+
+#ifdef SPECIALIZED_FULL_ENERGY
+    check_bool_option("FULL_ENERGY", options.FULL_ENERGY,
+                      SPECIALIZED_FULL_ENERGY);
+#endif
+#ifdef SPECIALIZED_FROZEN_SOIL
+    check_bool_option("FROZEN_SOIL", options.FROZEN_SOIL,
+                      SPECIALIZED_FROZEN_SOIL);
+#endif
+#ifdef SPECIALIZED_QUICK_FLUX
+    check_bool_option("QUICK_FLUX", options.QUICK_FLUX,
+                      SPECIALIZED_QUICK_FLUX);
+#endif
+#ifdef SPECIALIZED_CARBON
+    check_bool_option("CARBON", options.CARBON, SPECIALIZED_CARBON);
+#endif
+#ifdef SPECIALIZED_LAKES
+    check_bool_option("LAKES", options.LAKES, SPECIALIZED_LAKES);
+#endif
+#ifdef SPECIALIZED_BLOWING
+    check_bool_option("BLOWING", options.BLOWING, SPECIALIZED_BLOWING);
+#endif
+#ifdef SPECIALIZED_SNOW_BAND
+    check_size_option("SNOW_BAND", options.SNOW_BAND, SPECIALIZED_SNOW_BAND);
+#endif
+#ifdef SPECIALIZED_Nlayer
+    check_size_option("NLAYER", options.Nlayer, SPECIALIZED_Nlayer);
+#endif
+#ifdef SPECIALIZED_Nnode
+    check_size_option("NODES", options.Nnode, SPECIALIZED_Nnode);
+#endif
+#endif
+}
@@ -70,6 +70,17 @@ compute_derived_state_vars(all_vars_struct *all_vars,
     snow = all_vars->snow;
     Nveg = veg_con[0].vegetat_type_num;
 
+    // moisture-independent thermal properties of the soil layers
+    for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        set_soil_thermal_coef(soil_con->soil_dens_min[lidx],
+                              soil_con->bulk_dens_min[lidx],
+                              soil_con->quartz[lidx],
+                              soil_con->soil_density[lidx],
+                              soil_con->bulk_density[lidx],
+                              soil_con->organic[lidx],
+                              &(soil_con->thermal_coef[lidx]));
+    }
+
     // allocate memory for tmpT and tmpZ
     malloc_3d_double(tmpTshape, &tmpT);
     malloc_2d_double(tmpZshape, &tmpZ);
@@ -139,33 +150,34 @@ compute_derived_state_vars(all_vars_struct *all_vars,
                                             options.Nnode, options.Nlayer);
                     }
 
+                    // in water balance mode the node moisture properties
+                    // and layer temperatures are not used before the first
+                    // call to calc_surf_energy_bal() recomputes them, which
+                    // saves their work at initialization and restart
+                    if (!options.FULL_ENERGY && !options.FROZEN_SOIL) {
+                        continue;
+                    }
+
                     // set soil moisture properties for all soil thermal nodes
-                    if (options.FULL_ENERGY || options.FROZEN_SOIL) {
-                        ErrorFlag =
-                            distribute_node_moisture_properties(
-                                energy[veg][band].moist,
-                                energy[veg][band].ice,
-                                energy[veg][band].kappa_node,
-                                energy[veg][band].Cs_node,
-                                soil_con->Zsum_node,
-                                energy[veg][band].T,
-                                soil_con->max_moist_node,
-                                soil_con->expt_node,
-                                soil_con->bubble_node,
-                                moist[veg][band],
-                                soil_con->depth,
-                                soil_con->soil_dens_min,
-                                soil_con->bulk_dens_min,
-                                soil_con->quartz,
-                                soil_con->soil_density,
-                                soil_con->bulk_density,
-                                soil_con->organic,
-                                options.Nnode, options.Nlayer,
-                                soil_con->FS_ACTIVE);
-                        if (ErrorFlag == ERROR) {
-                            log_err("Error setting physical properties for "
-                                    "soil thermal nodes");
-                        }
+                    ErrorFlag =
+                        distribute_node_moisture_properties(
+                            energy[veg][band].moist,
+                            energy[veg][band].ice,
+                            energy[veg][band].kappa_node,
+                            energy[veg][band].Cs_node,
+                            soil_con->Zsum_node,
+                            energy[veg][band].T,
+                            soil_con->max_moist_node,
+                            soil_con->expt_node,
+                            soil_con->bubble_node,
+                            moist[veg][band],
+                            soil_con->depth,
+                            soil_con->thermal_coef,
+                            options.Nnode, options.Nlayer,
+                            soil_con->FS_ACTIVE);
+                    if (ErrorFlag == ERROR) {
+                        log_err("Error setting physical properties for "
+                                "soil thermal nodes");
                     }
 
                     // Check node spacing v time step
@@ -85,8 +85,11 @@ compute_lake_params(lake_con_struct *lake_con,
                                (lake_con->z[i - 1] - lake_con->z[i]) / 2.;
     }
 
+    // compute basin volume below each node
+    compute_lake_basin_volume(lake_con);
+
     // compute volume corresponding to mindepth
-    ErrFlag = get_volume(*lake_con, lake_con->mindepth, &(lake_con->minvolume));
+    ErrFlag = get_volume(lake_con, lake_con->mindepth, &(lake_con->minvolume));
     if (ErrFlag == ERROR) {
         log_err("Error calculating depth: depth %f volume %f",
                 lake_con->mindepth, lake_con->minvolume);
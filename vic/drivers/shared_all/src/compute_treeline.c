@@ -3,7 +3,7 @@
  *
  * Compute treeline.
  *
- * This routine computes the annual average July temperature for the current
+ * These routines compute the annual average July temperature for the current
  * gridcell.  The temperature is than lapsed to determine the elevation at
  * which the annual average temperature is equal to 10C. Snow elevation bands
  * above this elevation are considered to be above the treeline.  When gridcell
@@ -38,65 +38,90 @@
 #include <vic_driver_shared_all.h>
 
 /******************************************************************************
- * @brief    Compute treeline.
+ * @brief    Reset the July air temperature accumulator.
  *****************************************************************************/
 void
-compute_treeline(force_data_struct *force,
-                 dmy_struct        *dmy,
-                 double             avgJulyAirTemp,
-                 double            *Tfactor,
-                 bool              *AboveTreeLine)
+reset_july_tavg(july_tavg_struct *july_tavg)
 {
-    extern option_struct       options;
-    extern global_param_struct global_param;
-    extern size_t              NF;
+    july_tavg->MonthSum = 0;
+    july_tavg->MonthCnt = 0;
+    july_tavg->AnnualSum = 0;
+    july_tavg->AnnualCnt = 0;
+}
 
-    double                     MonthSum;
-    double                     AnnualSum;
-    int                        MonthCnt;
-    int                        AnnualCnt;
-    unsigned int               rec;
-    size_t                     band;
-    size_t                     i;
+/******************************************************************************
+ * @brief    Add the air temperature of a forcing window to the July average.
+ *
+ * @note     The windows must be passed in order; a July that spans two
+ *           windows is carried over in MonthSum and MonthCnt.
+ *****************************************************************************/
+void
+accumulate_july_tavg(force_data_struct *force,
+                     dmy_struct        *dmy,
+                     size_t             nrecs,
+                     july_tavg_struct  *july_tavg)
+{
+    extern size_t NF;
 
-    if (options.JULY_TAVG_SUPPLIED) {
-        // use supplied average annual July air temperature
-        AnnualSum = avgJulyAirTemp;
-    }
-    else {
-        // compute average annual July air temperature from forcing
-        AnnualSum = 0;
-        AnnualCnt = 0;
-        rec = 0;
-        while (rec < global_param.nrecs) {
-            if (dmy[rec].month == 7) {
-                MonthSum = 0;
-                MonthCnt = 0;
-                while (dmy[rec].month == 7) {
-                    for (i = 0; i < NF; i++) {
-                        MonthSum += force[rec].air_temp[i];
-                        MonthCnt++;
-                    }
-                    rec++;
-                }
-                if (MonthCnt > 0) {
-                    // Sum monthly average July temperature
-                    AnnualSum += MonthSum / (double) MonthCnt;
-                    AnnualCnt++;
-                }
+    size_t        rec;
+    size_t        i;
+
+    for (rec = 0; rec < nrecs; rec++) {
+        if (dmy[rec].month == 7) {
+            for (i = 0; i < NF; i++) {
+                july_tavg->MonthSum += force[rec].air_temp[i];
+                july_tavg->MonthCnt++;
             }
-            rec++;
         }
-
-        // Compute average annual July air temperature
-        if (AnnualCnt > 0) {
-            AnnualSum /= (double) AnnualCnt;
+        else if (july_tavg->MonthCnt > 0) {
+            // Sum monthly average July temperature
+            july_tavg->AnnualSum += july_tavg->MonthSum /
+                                    (double) july_tavg->MonthCnt;
+            july_tavg->AnnualCnt++;
+            july_tavg->MonthSum = 0;
+            july_tavg->MonthCnt = 0;
         }
     }
+}
+
+/******************************************************************************
+ * @brief    Return the average annual July air temperature accumulated so
+ *           far, including a July at the end of the simulation period.
+ *****************************************************************************/
+double
+get_july_tavg(july_tavg_struct *july_tavg)
+{
+    double AnnualSum;
+    size_t AnnualCnt;
+
+    AnnualSum = july_tavg->AnnualSum;
+    AnnualCnt = july_tavg->AnnualCnt;
+    if (july_tavg->MonthCnt > 0) {
+        AnnualSum += july_tavg->MonthSum / (double) july_tavg->MonthCnt;
+        AnnualCnt++;
+    }
+
+    if (AnnualCnt > 0) {
+        return AnnualSum / (double) AnnualCnt;
+    }
+    return 0.;
+}
+
+/******************************************************************************
+ * @brief    Compute treeline from the average annual July air temperature.
+ *****************************************************************************/
+void
+compute_treeline(double avgJulyAirTemp,
+                 double *Tfactor,
+                 bool   *AboveTreeLine)
+{
+    extern option_struct options;
+
+    size_t               band;
 
     // Lapse average annual July air temperature to 10C and determine elevation
     for (band = 0; band < options.SNOW_BAND; band++) {
-        if (AnnualSum + Tfactor[band] <= 10.) {
+        if (avgJulyAirTemp + Tfactor[band] <= 10.) {
             // Band is above treeline
             AboveTreeLine[band] = true;
         }
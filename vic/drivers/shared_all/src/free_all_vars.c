@@ -31,40 +31,26 @@
 
 /******************************************************************************
  * @brief    Free all variables.
+ *
+ * @details  The arrays made by make_all_vars() are single blocks, so the
+ *           number of calls to free() does not depend on the number of
+ *           vegetation types.
  *****************************************************************************/
 void
-free_all_vars(all_vars_struct *all_vars,
-              int              Nveg)
+free_all_vars(all_vars_struct *all_vars)
 {
     extern option_struct options;
 
-    int                  i, j, Nitems;
-    size_t               k;
-
-    Nitems = Nveg + 1;
-
-    for (j = 0; j < Nitems; j++) {
-        free((char *) all_vars[0].cell[j]);
-    }
+    free((char *) all_vars[0].cell[0]);
     free((char *) all_vars[0].cell);
-    for (j = 0; j < Nitems; j++) {
-        if (options.CARBON) {
-            for (k = 0; k < options.SNOW_BAND; k++) {
-                free((char *) all_vars[0].veg_var[j][k].NscaleFactor);
-                free((char *) all_vars[0].veg_var[j][k].aPARLayer);
-                free((char *) all_vars[0].veg_var[j][k].CiLayer);
-                free((char *) all_vars[0].veg_var[j][k].rsLayer);
-            }
-        }
-        free((char *)(*all_vars).veg_var[j]);
-    }
-    free((char *)(*all_vars).veg_var);
-    for (j = 0; j < Nitems; j++) {
-        free((char *) all_vars[0].energy[j]);
+    if (options.CARBON) {
+        free((char *) all_vars[0].veg_var[0][0].NscaleFactor);
     }
+    free((char *) all_vars[0].veg_var[0]);
+    free((char *) all_vars[0].veg_var);
+    free((char *) all_vars[0].energy[0]);
     free((char *) all_vars[0].energy);
-    for (i = 0; i < Nitems; i++) {
-        free((char *) all_vars[0].snow[i]);
-    }
+    free((char *) all_vars[0].snow[0]);
     free((char *) all_vars[0].snow);
+    free((char *) all_vars[0].lake_var);
 }
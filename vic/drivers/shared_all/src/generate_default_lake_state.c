@@ -42,7 +42,7 @@ generate_default_lake_state(all_vars_struct *all_vars,
 
     lake_var_struct      lake;
 
-    lake = all_vars->lake_var;
+    lake = *(all_vars->lake_var);
 
     /************************************************************************
        Initialize lake state variables
@@ -522,6 +522,23 @@ get_parameters(FILE *paramfile)
             else if (strcasecmp("ROOT_BRENT_T", optstr) == 0) {
                 sscanf(cmdstr, "%*s %lf", &param.ROOT_BRENT_T);
             }
+            else if (strcasecmp("ROOT_BRENT_RETRY_DT", optstr) == 0) {
+                sscanf(cmdstr, "%*s %lf", &param.ROOT_BRENT_RETRY_DT);
+            }
+            // Adaptive Sub-step Parameters
+            else if (strcasecmp("ADAPT_RUNOFF_FRAC", optstr) == 0) {
+                sscanf(cmdstr, "%*s %lf", &param.ADAPT_RUNOFF_FRAC);
+            }
+            else if (strcasecmp("ADAPT_SNOW_TAIR", optstr) == 0) {
+                sscanf(cmdstr, "%*s %lf", &param.ADAPT_SNOW_TAIR);
+            }
+            // Band Merging Parameters
+            else if (strcasecmp("BAND_MERGE_TDIFF", optstr) == 0) {
+                sscanf(cmdstr, "%*s %lf", &param.BAND_MERGE_TDIFF);
+            }
+            else if (strcasecmp("BAND_MERGE_FDIFF", optstr) == 0) {
+                sscanf(cmdstr, "%*s %lf", &param.BAND_MERGE_FDIFF);
+            }
             else {
                 log_warn("Unrecognized option in the parameter file:  %s "
                          "- check your spelling", optstr);
@@ -918,4 +935,20 @@ validate_parameters()
     if (!(param.ROOT_BRENT_T >= 0.)) {
         log_err("ROOT_BRENT_T must be defined on the interval [0, inf)");
     }
+    if (!(param.ROOT_BRENT_RETRY_DT > 0.)) {
+        log_err("ROOT_BRENT_RETRY_DT must be defined on the interval (0, inf)");
+    }
+
+    // Adaptive Sub-step Parameters
+    if (!(param.ADAPT_RUNOFF_FRAC > 0.)) {
+        log_err("ADAPT_RUNOFF_FRAC must be defined on the interval (0, inf)");
+    }
+
+    // Band Merging Parameters
+    if (!(param.BAND_MERGE_TDIFF >= 0.)) {
+        log_err("BAND_MERGE_TDIFF must be defined on the interval [0, inf)");
+    }
+    if (!(param.BAND_MERGE_FDIFF >= 0.)) {
+        log_err("BAND_MERGE_FDIFF must be defined on the interval [0, inf)");
+    }
 }
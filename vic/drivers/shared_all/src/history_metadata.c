@@ -1476,6 +1476,101 @@ set_output_met_data_info()
     strcpy(out_metadata[OUT_TIME_VICRUN_CPU].description,
            "CPU time spent inside vic_run");
 
+    /* Iterations of root_brent [count] */
+    strcpy(out_metadata[OUT_SOLVER_BRENT_ITER].varname,
+           "OUT_SOLVER_BRENT_ITER");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_ITER].long_name, "solver_brent_iter");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_ITER].standard_name,
+           "vic_run_brent_iter");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_ITER].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_ITER].description,
+           "Iterations of root_brent");
+
+    /* Calls of root_brent that did not bracket the root [count] */
+    strcpy(out_metadata[OUT_SOLVER_BRENT_FAIL].varname,
+           "OUT_SOLVER_BRENT_FAIL");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_FAIL].long_name, "solver_brent_fail");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_FAIL].standard_name,
+           "vic_run_brent_fail");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_FAIL].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_FAIL].description,
+           "Calls of root_brent that did not bracket the root");
+
+    /* Iterations of newt_raph [count] */
+    strcpy(out_metadata[OUT_SOLVER_NEWT_RAPH_ITER].varname,
+           "OUT_SOLVER_NEWT_RAPH_ITER");
+    strcpy(out_metadata[OUT_SOLVER_NEWT_RAPH_ITER].long_name,
+           "solver_newt_raph_iter");
+    strcpy(out_metadata[OUT_SOLVER_NEWT_RAPH_ITER].standard_name,
+           "vic_run_newt_raph_iter");
+    strcpy(out_metadata[OUT_SOLVER_NEWT_RAPH_ITER].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_NEWT_RAPH_ITER].description,
+           "Iterations of newt_raph");
+
+    /* Sub-steps of runoff [count] */
+    strcpy(out_metadata[OUT_SOLVER_RUNOFF_STEPS].varname,
+           "OUT_SOLVER_RUNOFF_STEPS");
+    strcpy(out_metadata[OUT_SOLVER_RUNOFF_STEPS].long_name,
+           "solver_runoff_steps");
+    strcpy(out_metadata[OUT_SOLVER_RUNOFF_STEPS].standard_name,
+           "vic_run_runoff_steps");
+    strcpy(out_metadata[OUT_SOLVER_RUNOFF_STEPS].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_RUNOFF_STEPS].description,
+           "Sub-steps of runoff");
+
+    /* Snow pack energy balance solutions [count] */
+    strcpy(out_metadata[OUT_SOLVER_SNOW_MELT].varname, "OUT_SOLVER_SNOW_MELT");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_MELT].long_name, "solver_snow_melt");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_MELT].standard_name,
+           "vic_run_snow_melt");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_MELT].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_MELT].description,
+           "Snow pack energy balance solutions");
+
+    /* Convective mixing passes of the lake [count] */
+    strcpy(out_metadata[OUT_SOLVER_LAKE_MIX_ITER].varname,
+           "OUT_SOLVER_LAKE_MIX_ITER");
+    strcpy(out_metadata[OUT_SOLVER_LAKE_MIX_ITER].long_name,
+           "solver_lake_mix_iter");
+    strcpy(out_metadata[OUT_SOLVER_LAKE_MIX_ITER].standard_name,
+           "vic_run_lake_mix_iter");
+    strcpy(out_metadata[OUT_SOLVER_LAKE_MIX_ITER].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_LAKE_MIX_ITER].description,
+           "Convective mixing passes of the lake");
+
+    /* Sub-steps of the surface energy balance [count] */
+    strcpy(out_metadata[OUT_SOLVER_SNOW_STEPS].varname,
+           "OUT_SOLVER_SNOW_STEPS");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_STEPS].long_name,
+           "solver_snow_steps");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_STEPS].standard_name,
+           "vic_run_snow_steps");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_STEPS].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_SNOW_STEPS].description,
+           "Sub-steps of the surface energy balance");
+
+    /* Roots bracketed by the ROOT_RETRY search [count] */
+    strcpy(out_metadata[OUT_SOLVER_BRENT_RETRY].varname,
+           "OUT_SOLVER_BRENT_RETRY");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_RETRY].long_name,
+           "solver_brent_retry");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_RETRY].standard_name,
+           "vic_run_brent_retry");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_RETRY].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_BRENT_RETRY].description,
+           "Roots bracketed by the ROOT_RETRY search");
+
+    /* Surface flux solutions of the snow bands [count] */
+    strcpy(out_metadata[OUT_SOLVER_BAND_SOLVES].varname,
+           "OUT_SOLVER_BAND_SOLVES");
+    strcpy(out_metadata[OUT_SOLVER_BAND_SOLVES].long_name,
+           "solver_band_solves");
+    strcpy(out_metadata[OUT_SOLVER_BAND_SOLVES].standard_name,
+           "vic_run_band_solves");
+    strcpy(out_metadata[OUT_SOLVER_BAND_SOLVES].units, "count");
+    strcpy(out_metadata[OUT_SOLVER_BAND_SOLVES].description,
+           "Surface flux solutions of the snow bands");
+
     if (options.FROZEN_SOIL) {
         out_metadata[OUT_FDEPTH].nelem = MAX_FRONTS;
         out_metadata[OUT_TDEPTH].nelem = MAX_FRONTS;
@@ -71,4 +71,8 @@ initialize_global()
     global_param.calendar = CALENDAR_STANDARD;
     global_param.time_units = TIME_UNITS_DAYS;
     global_param.time_origin_num = MISSING;
+    global_param.spinup_cycles = 0;
+    global_param.spinup_years = 1;
+    global_param.spinup_tol = 0.;
+    global_param.spinup_block_steps = 1;
 }
@@ -47,6 +47,7 @@ initialize_options()
     options.BLOWING_SIMPLE = false;
     options.BLOWING_FETCH = true;
     options.BLOWING_SPATIAL_WIND = true;
+    options.BLOWING_FAST = false;
     options.CARBON = false;
     options.CLOSE_ENERGY = false;
     options.COMPUTE_TREELINE = false;
@@ -58,17 +59,24 @@ initialize_options()
     options.FULL_ENERGY = false;
     options.GRND_FLUX_TYPE = GF_410;
     options.IMPLICIT = true;
+    options.ANALYTIC_JACOBIAN = false;
     options.LAKES = false;
     options.LAKE_PROFILE = false;
     options.NOFLUX = false;
     options.QUICK_FLUX = true;
     options.QUICK_SOLVE = false;
+    options.QUIESCENT_SOIL = false;
     options.RC_MODE = RC_JARVIS;
     options.SHARE_LAYER_MOIST = true;
     options.SNOW_DENSITY = DENS_BRAS;
     options.SPATIAL_FROST = false;
     options.SPATIAL_SNOW = false;
+    options.ADAPTIVE_SUBSTEPS = false;
+    options.BAND_MERGE = false;
     options.TFALLBACK = true;
+    options.TSURF_NEWTON = false;
+    options.ROOT_RETRY = false;
+    options.FAST_SVP = false;
     // Model dimensions
     options.Ncanopy = 3;
     options.Nfrost = 1;
@@ -81,6 +89,7 @@ initialize_options()
     options.BASEFLOW = ARNO;
     options.FCAN_SRC = FROM_DEFAULT;
     options.GRID_DECIMAL = 2;
+    options.FORCE_WINDOW = 0;
     options.JULY_TAVG_SUPPLIED = false;
     options.LAI_SRC = FROM_VEGLIB;
     options.ORGANIC_FRACT = false;
@@ -93,6 +102,44 @@ initialize_options()
     options.STATE_FORMAT = UNSET_FILE_FORMAT;
     options.INIT_STATE = false;
     options.SAVE_STATE = false;
+    options.STATE_INCREMENTAL = false;
+    options.STATE_ASYNC = false;
+    options.STATE_STREAMS = false;
     // output options
     options.Noutstreams = 2;
+    options.OUT_CONTAINER = false;
+    options.OUT_CASCADE = false;
+    options.COMPUTE_ZWT = true;
+    // parallelization options
+    options.NTHREADS = 1;
+    options.DECOMPOSITION = DECOMP_ROUND_ROBIN;
+    options.NWORKERS = 1;
+    options.FORCE_PREFETCH = false;
+    options.FORCE_PRECISION = FORCE_PRECISION_DOUBLE;
+    options.FORCE_DISAGG = false;
+    options.FORCE_CATALOG = false;
+    options.FORCE_READERS = 1;
+    options.PARALLEL_IO = false;
+    options.ASYNC_OUTPUT = false;
+    options.IO_SERVERS = 0;
+    options.NODE_SHARED_TABLES = false;
+    options.HIERARCHICAL_IO = false;
+    options.DISTRIBUTED_DOMAIN = false;
+    options.NUMA_FIRST_TOUCH = false;
+    options.OUT_LAYOUT = OUT_LAYOUT_GRID;
+    options.OUT_SPLIT = 0;
+    options.COMPRESS_THREADS = 0;
+    options.SPINUP_FLOAT = false;
+    options.REPRODUCIBLE = false;
+    // profiling options
+    options.PERF_REGIONS = false;
+    options.IO_BENCHMARK = false;
+    options.COMPUTE_BENCHMARK = false;
+    options.HEARTBEAT_STEPS = 0;
+    options.HEARTBEAT_SECONDS = 0;
+    options.LOG_BUFFER = 0;
+    options.REBALANCE_STEPS = 0;
+    options.DA_STEPS = 0;
+    options.BALANCE_CHECK = BALANCE_CHECK_ALL;
+    options.BALANCE_CHECK_N = 1;
 }
@@ -227,6 +227,15 @@ initialize_parameters()
     param.ROOT_BRENT_MAXITER = 1000;
     param.ROOT_BRENT_TSTEP = 10;
     param.ROOT_BRENT_T = 1.0e-7;
+    param.ROOT_BRENT_RETRY_DT = 25.;
+
+    // Adaptive Sub-step Parameters
+    param.ADAPT_RUNOFF_FRAC = 0.1;
+    param.ADAPT_SNOW_TAIR = -5.;
+
+    // Band Merging Parameters
+    param.BAND_MERGE_TDIFF = 0.5;
+    param.BAND_MERGE_FDIFF = 0.05;
 
     // Frozen Soil Parameters
     param.FROZEN_MAXITER = 1000;
@@ -43,6 +43,36 @@ str_to_bool(char str[])
     }
 }
 
+/******************************************************************************
+ * @brief    Convert a string of whitespace separated numbers to doubles
+ *
+ * @details  Reads up to nvalues numbers with strtod() in a single pass over
+ *           the string, which is much cheaper than one sscanf() or fscanf()
+ *           call per number.
+ *
+ * @return   number of values read
+ *****************************************************************************/
+size_t
+str_to_doubles(char    str[],
+               double *values,
+               size_t  nvalues)
+{
+    char  *end;
+    double value;
+    size_t i;
+
+    for (i = 0; i < nvalues; i++) {
+        value = strtod(str, &end);
+        if (end == str) {
+            break;
+        }
+        values[i] = value;
+        str = end;
+    }
+
+    return i;
+}
+
 /******************************************************************************
  * @brief    This routine determines the counts the number of output variables
              in each output file specified in the global parameter file.
@@ -102,13 +132,41 @@ count_nstreams_nvars(FILE   *gp,
 
 /******************************************************************************
  * @brief    Convert string version of AGG_TYPE_* to enum value
+ * @details  The threshold of AGG_TYPE_ABOVE and AGG_TYPE_BELOW and the
+ *           probability of AGG_TYPE_QUANTILE follow a colon, e.g.
+ *           AGG_TYPE_QUANTILE:0.9, see str_to_agg_param().
  *****************************************************************************/
 unsigned short int
 str_to_agg_type(char aggstr[])
 {
-    if ((strcasecmp("", aggstr) == 0) || (strcasecmp("*", aggstr) == 0)) {
+    char  typestr[MAXSTRING];
+    char *param;
+
+    strncpy(typestr, aggstr, MAXSTRING - 1);
+    typestr[MAXSTRING - 1] = '\0';
+    param = strchr(typestr, ':');
+    if (param != NULL) {
+        *param = '\0';
+    }
+
+    if ((strcasecmp("", typestr) == 0) || (strcasecmp("*", typestr) == 0)) {
         return AGG_TYPE_DEFAULT;
     }
+    else if (param != NULL) {
+        if (strcasecmp("AGG_TYPE_ABOVE", typestr) == 0) {
+            return AGG_TYPE_ABOVE;
+        }
+        else if (strcasecmp("AGG_TYPE_BELOW", typestr) == 0) {
+            return AGG_TYPE_BELOW;
+        }
+        else if (strcasecmp("AGG_TYPE_QUANTILE", typestr) == 0) {
+            return AGG_TYPE_QUANTILE;
+        }
+        else {
+            log_err("Unknown aggregation type with a parameter found: %s",
+                    aggstr);
+        }
+    }
     else {
         if (strcasecmp("AGG_TYPE_AVG", aggstr) == 0) {
             return AGG_TYPE_AVG;
@@ -128,12 +186,56 @@ str_to_agg_type(char aggstr[])
         else if (strcasecmp("AGG_TYPE_SUM", aggstr) == 0) {
             return AGG_TYPE_SUM;
         }
+        else if (strcasecmp("AGG_TYPE_VAR", aggstr) == 0) {
+            return AGG_TYPE_VAR;
+        }
+        else if (strcasecmp("AGG_TYPE_STDEV", aggstr) == 0) {
+            return AGG_TYPE_STDEV;
+        }
+        else if ((strcasecmp("AGG_TYPE_ABOVE", aggstr) == 0) ||
+                 (strcasecmp("AGG_TYPE_BELOW", aggstr) == 0) ||
+                 (strcasecmp("AGG_TYPE_QUANTILE", aggstr) == 0)) {
+            log_err("Aggregation type %s requires a parameter, e.g. %s:0.5",
+                    aggstr, aggstr);
+        }
         else {
             log_err("Unknown aggregation type found: %s", aggstr);
         }
     }
 }
 
+/******************************************************************************
+ * @brief    Convert the parameter of an AGG_TYPE_* string to a value
+ * @return   the threshold of AGG_TYPE_ABOVE and AGG_TYPE_BELOW, the
+ *           probability of AGG_TYPE_QUANTILE, 0 for the other types
+ *****************************************************************************/
+double
+str_to_agg_param(char aggstr[])
+{
+    unsigned short int aggtype;
+    char              *param;
+    char              *end;
+    double             value;
+
+    aggtype = str_to_agg_type(aggstr);
+    if (aggtype != AGG_TYPE_ABOVE && aggtype != AGG_TYPE_BELOW &&
+        aggtype != AGG_TYPE_QUANTILE) {
+        return 0.;
+    }
+
+    param = strchr(aggstr, ':') + 1;
+    value = strtod(param, &end);
+    if (end == param || *end != '\0') {
+        log_err("Invalid parameter of aggregation type %s", aggstr);
+    }
+    if (aggtype == AGG_TYPE_QUANTILE && (value <= 0. || value >= 1.)) {
+        log_err("The probability of aggregation type %s must be between 0 "
+                "and 1", aggstr);
+    }
+
+    return value;
+}
+
 /******************************************************************************
  * @brief    Convert string version of OUT_TYPE* to enum value
  *****************************************************************************/
@@ -390,6 +492,14 @@ cell_method_from_agg_type(unsigned short int aggtype,
         strcpy(cell_method, "time: beg");
         return true;
     }
+    else if (aggtype == AGG_TYPE_VAR) {
+        strcpy(cell_method, "time: variance");
+        return true;
+    }
+    else if (aggtype == AGG_TYPE_STDEV) {
+        strcpy(cell_method, "time: standard_deviation");
+        return true;
+    }
     else {
         return false;
     }
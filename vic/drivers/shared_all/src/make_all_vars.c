@@ -43,6 +43,128 @@ make_all_vars(size_t nveg)
     temp.energy = make_energy_bal(Nitems);
     temp.veg_var = make_veg_var(Nitems);
     temp.cell = make_cell_data(Nitems);
+    // the lake variables are made by the driver for the cells with a lake
+    temp.lake_var = NULL;
 
     return (temp);
 }
+
+/******************************************************************************
+ * @brief    Reset the states and fluxes of a cell to the values of a newly
+ *           made all_vars structure, keeping its allocations.
+ *
+ * @param    all_vars structure made with make_all_vars() for nveg (or more)
+ *           vegetation tiles
+ * @param    nveg number of vegetation tiles all_vars was made for
+ *****************************************************************************/
+void
+reset_all_vars(all_vars_struct *all_vars,
+               size_t           nveg)
+{
+    extern option_struct options;
+
+    size_t               i;
+    size_t               j;
+    size_t               Nitems;
+    veg_var_struct      *veg_var;
+    double              *NscaleFactor;
+    double              *aPARLayer;
+    double              *CiLayer;
+    double              *rsLayer;
+
+    Nitems = nveg + 1;
+
+    for (i = 0; i < Nitems; i++) {
+        memset(all_vars->snow[i], 0,
+               options.SNOW_BAND * sizeof(*(all_vars->snow[i])));
+        memset(all_vars->energy[i], 0,
+               options.SNOW_BAND * sizeof(*(all_vars->energy[i])));
+        memset(all_vars->cell[i], 0,
+               options.SNOW_BAND * sizeof(*(all_vars->cell[i])));
+        for (j = 0; j < options.SNOW_BAND; j++) {
+            all_vars->energy[i][j].frozen = false;
+
+            // the carbon arrays of the vegetation are kept
+            veg_var = &(all_vars->veg_var[i][j]);
+            NscaleFactor = veg_var->NscaleFactor;
+            aPARLayer = veg_var->aPARLayer;
+            CiLayer = veg_var->CiLayer;
+            rsLayer = veg_var->rsLayer;
+            memset(veg_var, 0, sizeof(*veg_var));
+            if (options.CARBON) {
+                veg_var->NscaleFactor = NscaleFactor;
+                veg_var->aPARLayer = aPARLayer;
+                veg_var->CiLayer = CiLayer;
+                veg_var->rsLayer = rsLayer;
+                memset(NscaleFactor, 0,
+                       options.Ncanopy * sizeof(*NscaleFactor));
+                memset(aPARLayer, 0, options.Ncanopy * sizeof(*aPARLayer));
+                memset(CiLayer, 0, options.Ncanopy * sizeof(*CiLayer));
+                memset(rsLayer, 0, options.Ncanopy * sizeof(*rsLayer));
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Copy the states and fluxes of a cell into another all_vars
+ *           structure, keeping the allocations of the copy.
+ *
+ * @param    dst structure made with make_all_vars() for nveg (or more)
+ *           vegetation tiles
+ * @param    src structure to copy
+ * @param    nveg number of vegetation tiles of the cell
+ *****************************************************************************/
+void
+copy_all_vars(all_vars_struct *dst,
+              all_vars_struct *src,
+              size_t           nveg)
+{
+    extern option_struct options;
+
+    size_t               i;
+    size_t               j;
+    size_t               Nitems;
+    veg_var_struct      *veg_var;
+    double              *NscaleFactor;
+    double              *aPARLayer;
+    double              *CiLayer;
+    double              *rsLayer;
+
+    Nitems = nveg + 1;
+
+    for (i = 0; i < Nitems; i++) {
+        memcpy(dst->snow[i], src->snow[i],
+               options.SNOW_BAND * sizeof(*(dst->snow[i])));
+        memcpy(dst->energy[i], src->energy[i],
+               options.SNOW_BAND * sizeof(*(dst->energy[i])));
+        memcpy(dst->cell[i], src->cell[i],
+               options.SNOW_BAND * sizeof(*(dst->cell[i])));
+        for (j = 0; j < options.SNOW_BAND; j++) {
+            // the carbon arrays of the copy are kept
+            veg_var = &(dst->veg_var[i][j]);
+            NscaleFactor = veg_var->NscaleFactor;
+            aPARLayer = veg_var->aPARLayer;
+            CiLayer = veg_var->CiLayer;
+            rsLayer = veg_var->rsLayer;
+            *veg_var = src->veg_var[i][j];
+            veg_var->NscaleFactor = NscaleFactor;
+            veg_var->aPARLayer = aPARLayer;
+            veg_var->CiLayer = CiLayer;
+            veg_var->rsLayer = rsLayer;
+            if (options.CARBON) {
+                memcpy(NscaleFactor, src->veg_var[i][j].NscaleFactor,
+                       options.Ncanopy * sizeof(*NscaleFactor));
+                memcpy(aPARLayer, src->veg_var[i][j].aPARLayer,
+                       options.Ncanopy * sizeof(*aPARLayer));
+                memcpy(CiLayer, src->veg_var[i][j].CiLayer,
+                       options.Ncanopy * sizeof(*CiLayer));
+                memcpy(rsLayer, src->veg_var[i][j].rsLayer,
+                       options.Ncanopy * sizeof(*rsLayer));
+            }
+        }
+    }
+    if (dst->lake_var != NULL && src->lake_var != NULL) {
+        *(dst->lake_var) = *(src->lake_var);
+    }
+}
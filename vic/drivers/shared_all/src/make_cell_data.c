@@ -40,8 +40,14 @@ make_cell_data(size_t veg_type_num)
     cell_data_struct   **temp;
 
     temp = calloc(veg_type_num, sizeof(*temp));
-    for (i = 0; i < veg_type_num; i++) {
-        temp[i] = calloc(options.SNOW_BAND, sizeof(*(temp[i])));
+    check_alloc_status(temp, "Memory allocation error.");
+
+    // the snow bands of all vegetation types are one block
+    temp[0] = calloc(veg_type_num * options.SNOW_BAND, sizeof(*(temp[0])));
+    check_alloc_status(temp[0], "Memory allocation error.");
+
+    for (i = 1; i < veg_type_num; i++) {
+        temp[i] = temp[0] + i * options.SNOW_BAND;
     }
     return temp;
 }
@@ -28,20 +28,22 @@
 #include <vic_driver_shared_all.h>
 
 /******************************************************************************
- * @brief    This subroutine creates an array of structures that contain
- *           information about the day, month and year of each time step.
+ * @brief    This subroutine sets the number of time steps of the simulation
+ *           and the number of forcing records to skip before its start.
+ *
+ * @details  The dates of the time steps are not stored. They are computed
+ *           when needed with dmy_from_step or set_dmy_window, so the memory
+ *           used does not grow with the length of the simulation.
  *****************************************************************************/
-dmy_struct *
-make_dmy(global_param_struct *global)
+void
+initialize_time_steps(global_param_struct *global)
 {
     extern param_set_struct param_set;
 
-    dmy_struct             *temp;
     dmy_struct              start_dmy, end_dmy, force_dmy;
     size_t                  i;
     unsigned int            offset;
-    double                  dt_time_units, start_num, end_num, force_num,
-                            numdate;
+    double                  start_num, end_num, force_num;
 
     start_dmy.dayseconds = global->startsec;
     start_dmy.year = global->startyear;
@@ -101,17 +103,45 @@ make_dmy(global_param_struct *global)
         }
     }
 
+}
+
+/******************************************************************************
+ * @brief    Set the dates of n consecutive time steps, starting at time step
+ *           first.
+ *****************************************************************************/
+void
+set_dmy_window(global_param_struct *global,
+               size_t               first,
+               size_t               n,
+               dmy_struct          *dmy)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        dmy_from_step(global, first + i, &(dmy[i]));
+    }
+}
+
+/******************************************************************************
+ * @brief    This subroutine creates an array of structures that contain
+ *           information about the day, month and year of each time step.
+ *
+ * @note     The drivers do not keep this array for the whole simulation,
+ *           see initialize_time_steps.
+ *****************************************************************************/
+dmy_struct *
+make_dmy(global_param_struct *global)
+{
+    dmy_struct *temp;
+
+    initialize_time_steps(global);
+
     // allocate dmy struct
     temp = calloc(global->nrecs, sizeof(*temp));
+    check_alloc_status(temp, "Memory allocation error.");
 
     /** Create Date Structure for each Model Time Step **/
-    for (i = 0; i < global->nrecs; i++) {
-        dt_seconds_to_time_units(global->time_units, i * global->dt,
-                                 &dt_time_units);
-        numdate = start_num + dt_time_units;
-        num2date(global->time_origin_num, numdate, 0., global->calendar,
-                 global->time_units, &temp[i]);
-    }
+    set_dmy_window(global, 0, global->nrecs, temp);
 
     return temp;
 }
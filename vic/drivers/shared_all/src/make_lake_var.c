@@ -1,7 +1,7 @@
 /******************************************************************************
  * @section DESCRIPTION
  *
- * This subroutine compresses the file "string" using a system call.
+ * This routine makes the lake/wetland variables of a cell.
  *
  * @section LICENSE
  *
@@ -27,24 +27,18 @@
 #include <vic_driver_shared_all.h>
 
 /******************************************************************************
- * @brief    This subroutine compresses the file "string" using a system call.
+ * @brief    Make the lake/wetland variables of a cell.
+ *
+ * @details  The lake variables are only made for the cells that are run with
+ *           a lake, and are freed by free_all_vars().
  *****************************************************************************/
-void
-compress_files(char      string[],
-               short int level)
+lake_var_struct *
+make_lake_var(void)
 {
-    char command[MAXSTRING];
+    lake_var_struct *temp = NULL;
 
-    // Compress the file
-    if (level == COMPRESSION_LVL_DEFAULT) {
-        sprintf(command, "nice gzip -f %s &", string);
-    }
-    else if (level != COMPRESSION_LVL_UNSET) {
-        sprintf(command, "nice gzip -%d -f %s &", level, string);
-    }
-    else if (level <= 0) {
-        log_err("Invalid compression level for gzip, must be an integer 1-9");
-    }
+    temp = calloc(1, sizeof(*temp));
+    check_alloc_status(temp, "Memory allocation error.");
 
-    system(command);
+    return temp;
 }
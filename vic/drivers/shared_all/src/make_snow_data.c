@@ -30,6 +30,9 @@
 /******************************************************************************
  * @brief    Make an array of snow cover data structures, one for each
  *           vegetation type plus bare soil.
+ *
+ * @details  The snow bands of all vegetation types are allocated as one
+ *           block, which is freed with temp[0].
  *****************************************************************************/
 snow_data_struct **
 make_snow_data(size_t nveg)
@@ -40,12 +43,13 @@ make_snow_data(size_t nveg)
     snow_data_struct   **temp = NULL;
 
     temp = calloc(nveg, sizeof(*temp));
-
     check_alloc_status(temp, "Memory allocation error.");
 
-    for (i = 0; i < nveg; i++) {
-        temp[i] = calloc(options.SNOW_BAND, sizeof(*(temp[i])));
-        check_alloc_status(temp[i], "Memory allocation error.");
+    temp[0] = calloc(nveg * options.SNOW_BAND, sizeof(*(temp[0])));
+    check_alloc_status(temp[0], "Memory allocation error.");
+
+    for (i = 1; i < nveg; i++) {
+        temp[i] = temp[0] + i * options.SNOW_BAND;
     }
 
     return temp;
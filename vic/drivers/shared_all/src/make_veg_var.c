@@ -35,34 +35,36 @@ make_veg_var(size_t veg_type_num)
     extern option_struct options;
 
     size_t               i, j;
+    size_t               nitems;
     veg_var_struct     **temp = NULL;
+    double              *layers = NULL;
+
+    nitems = veg_type_num * options.SNOW_BAND;
 
     temp = calloc(veg_type_num, sizeof(*temp));
     check_alloc_status(temp, "Memory allocation error.");
 
+    // the snow bands of all vegetation types are one block
+    temp[0] = calloc(nitems, sizeof(*(temp[0])));
+    check_alloc_status(temp[0], "Memory allocation error.");
+
+    if (options.CARBON) {
+        // the four canopy layer arrays of all records are one block, which
+        // starts at temp[0][0].NscaleFactor
+        layers = calloc(nitems * 4 * options.Ncanopy, sizeof(*layers));
+        check_alloc_status(layers, "Memory allocation error.");
+    }
+
     for (i = 0; i < veg_type_num; i++) {
-        temp[i] = calloc(options.SNOW_BAND, sizeof(*(temp[i])));
-        check_alloc_status(temp[i], "Memory allocation error.");
+        temp[i] = temp[0] + i * options.SNOW_BAND;
 
         if (options.CARBON) {
             for (j = 0; j < options.SNOW_BAND; j++) {
-                temp[i][j].NscaleFactor = calloc(options.Ncanopy,
-                                                 sizeof(*(temp[i][j].
-                                                          NscaleFactor)));
-                check_alloc_status(temp[i][j].NscaleFactor,
-                                   "Memory allocation error.");
-                temp[i][j].aPARLayer = calloc(options.Ncanopy,
-                                              sizeof(*(temp[i][j].aPARLayer)));
-                check_alloc_status(temp[i][j].aPARLayer,
-                                   "Memory allocation error.");
-                temp[i][j].CiLayer = calloc(options.Ncanopy,
-                                            sizeof(*(temp[i][j].CiLayer)));
-                check_alloc_status(temp[i][j].CiLayer,
-                                   "Memory allocation error.");
-                temp[i][j].rsLayer = calloc(options.Ncanopy,
-                                            sizeof(*(temp[i][j].rsLayer)));
-                check_alloc_status(temp[i][j].rsLayer,
-                                   "Memory allocation error.");
+                temp[i][j].NscaleFactor = layers;
+                temp[i][j].aPARLayer = layers + options.Ncanopy;
+                temp[i][j].CiLayer = layers + 2 * options.Ncanopy;
+                temp[i][j].rsLayer = layers + 3 * options.Ncanopy;
+                layers += 4 * options.Ncanopy;
             }
         }
     }
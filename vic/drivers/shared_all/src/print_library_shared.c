@@ -283,6 +283,11 @@ print_global_param(global_param_struct *gp)
     fprintf(LOG_DEST, "\tstatemonth          : %hu\n", gp->statemonth);
     fprintf(LOG_DEST, "\tstateyear           : %hu\n", gp->stateyear);
     fprintf(LOG_DEST, "\tstatesec            : %u\n", gp->statesec);
+    fprintf(LOG_DEST, "\tspinup_cycles       : %zu\n", gp->spinup_cycles);
+    fprintf(LOG_DEST, "\tspinup_years        : %zu\n", gp->spinup_years);
+    fprintf(LOG_DEST, "\tspinup_tol          : %.4f\n", gp->spinup_tol);
+    fprintf(LOG_DEST, "\tspinup_block_steps  : %zu\n",
+            gp->spinup_block_steps);
 }
 
 /******************************************************************************
@@ -311,6 +316,11 @@ print_lake_con(lake_con_struct *lcon,
         fprintf(LOG_DEST, "\t%.4f", lcon->Cl[i]);
     }
     fprintf(LOG_DEST, "\n");
+    fprintf(LOG_DEST, "\tbasin_volume:");
+    for (i = 0; i < nlnodes; i++) {
+        fprintf(LOG_DEST, "\t%.4f", lcon->basin_volume[i]);
+    }
+    fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "\tb        : %.4f\n", lcon->b);
     fprintf(LOG_DEST, "\tmaxdepth : %.4f\n", lcon->maxdepth);
     fprintf(LOG_DEST, "\tmindepth : %.4f\n", lcon->mindepth);
@@ -443,6 +453,7 @@ print_option(option_struct *option)
     fprintf(LOG_DEST, "\tBLOWING_FETCH        : %d\n", option->BLOWING_FETCH);
     fprintf(LOG_DEST, "\tBLOWING_SPATIAL_WIND : %d\n",
             option->BLOWING_SPATIAL_WIND);
+    fprintf(LOG_DEST, "\tBLOWING_FAST         : %d\n", option->BLOWING_FAST);
     fprintf(LOG_DEST, "\tCARBON               : %d\n", option->CARBON);
     fprintf(LOG_DEST, "\tCLOSE_ENERGY         : %d\n", option->CLOSE_ENERGY);
     fprintf(LOG_DEST, "\tCOMPUTE_TREELINE     : %d\n",
@@ -455,6 +466,8 @@ print_option(option_struct *option)
     fprintf(LOG_DEST, "\tFULL_ENERGY          : %d\n", option->FULL_ENERGY);
     fprintf(LOG_DEST, "\tGRND_FLUX_TYPE       : %d\n", option->GRND_FLUX_TYPE);
     fprintf(LOG_DEST, "\tIMPLICIT             : %d\n", option->IMPLICIT);
+    fprintf(LOG_DEST, "\tANALYTIC_JACOBIAN    : %d\n",
+            option->ANALYTIC_JACOBIAN);
     fprintf(LOG_DEST, "\tJULY_TAVG_SUPPLIED   : %d\n",
             option->JULY_TAVG_SUPPLIED);
     fprintf(LOG_DEST, "\tLAKES                : %d\n", option->LAKES);
@@ -469,15 +482,24 @@ print_option(option_struct *option)
     fprintf(LOG_DEST, "\tROOT_ZONES           : %zu\n", option->ROOT_ZONES);
     fprintf(LOG_DEST, "\tQUICK_FLUX           : %d\n", option->QUICK_FLUX);
     fprintf(LOG_DEST, "\tQUICK_SOLVE          : %d\n", option->QUICK_SOLVE);
+    fprintf(LOG_DEST, "\tQUIESCENT_SOIL       : %d\n",
+            option->QUIESCENT_SOIL);
     fprintf(LOG_DEST, "\tSHARE_LAYER_MOIST    : %d\n",
             option->SHARE_LAYER_MOIST);
     fprintf(LOG_DEST, "\tSNOW_DENSITY         : %d\n", option->SNOW_DENSITY);
     fprintf(LOG_DEST, "\tSNOW_BAND            : %zu\n", option->SNOW_BAND);
     fprintf(LOG_DEST, "\tSPATIAL_FROST        : %d\n", option->SPATIAL_FROST);
     fprintf(LOG_DEST, "\tSPATIAL_SNOW         : %d\n", option->SPATIAL_SNOW);
+    fprintf(LOG_DEST, "\tADAPTIVE_SUBSTEPS    : %d\n",
+            option->ADAPTIVE_SUBSTEPS);
+    fprintf(LOG_DEST, "\tBAND_MERGE           : %d\n", option->BAND_MERGE);
     fprintf(LOG_DEST, "\tTFALLBACK            : %d\n", option->TFALLBACK);
+    fprintf(LOG_DEST, "\tTSURF_NEWTON         : %d\n", option->TSURF_NEWTON);
+    fprintf(LOG_DEST, "\tROOT_RETRY           : %d\n", option->ROOT_RETRY);
+    fprintf(LOG_DEST, "\tFAST_SVP             : %d\n", option->FAST_SVP);
     fprintf(LOG_DEST, "\tBASEFLOW             : %d\n", option->BASEFLOW);
     fprintf(LOG_DEST, "\tGRID_DECIMAL         : %d\n", option->GRID_DECIMAL);
+    fprintf(LOG_DEST, "\tFORCE_WINDOW         : %zu\n", option->FORCE_WINDOW);
     fprintf(LOG_DEST, "\tVEGLIB_PHOTO         : %d\n", option->VEGLIB_PHOTO);
     fprintf(LOG_DEST, "\tVEGLIB_FCAN          : %d\n", option->VEGLIB_FCAN);
     fprintf(LOG_DEST, "\tVEGPARAM_ALB         : %d\n", option->VEGPARAM_ALB);
@@ -492,7 +514,61 @@ print_option(option_struct *option)
     fprintf(LOG_DEST, "\tSTATE_FORMAT         : %d\n", option->STATE_FORMAT);
     fprintf(LOG_DEST, "\tINIT_STATE           : %d\n", option->INIT_STATE);
     fprintf(LOG_DEST, "\tSAVE_STATE           : %d\n", option->SAVE_STATE);
+    fprintf(LOG_DEST, "\tSTATE_INCREMENTAL    : %d\n",
+            option->STATE_INCREMENTAL);
+    fprintf(LOG_DEST, "\tSTATE_ASYNC          : %d\n", option->STATE_ASYNC);
+    fprintf(LOG_DEST, "\tSTATE_STREAMS        : %d\n", option->STATE_STREAMS);
     fprintf(LOG_DEST, "\tNoutstreams          : %zu\n", option->Noutstreams);
+    fprintf(LOG_DEST, "\tOUT_CONTAINER        : %d\n", option->OUT_CONTAINER);
+    fprintf(LOG_DEST, "\tOUT_CASCADE          : %d\n", option->OUT_CASCADE);
+    fprintf(LOG_DEST, "\tCOMPUTE_ZWT          : %d\n", option->COMPUTE_ZWT);
+    fprintf(LOG_DEST, "\tNTHREADS             : %zu\n", option->NTHREADS);
+    fprintf(LOG_DEST, "\tDECOMPOSITION        : %d\n", option->DECOMPOSITION);
+    fprintf(LOG_DEST, "\tNWORKERS             : %zu\n", option->NWORKERS);
+    fprintf(LOG_DEST, "\tFORCE_PREFETCH       : %d\n",
+            option->FORCE_PREFETCH);
+    fprintf(LOG_DEST, "\tFORCE_PRECISION      : %hu\n",
+            option->FORCE_PRECISION);
+    fprintf(LOG_DEST, "\tFORCE_DISAGG         : %d\n",
+            option->FORCE_DISAGG);
+    fprintf(LOG_DEST, "\tFORCE_CATALOG        : %d\n",
+            option->FORCE_CATALOG);
+    fprintf(LOG_DEST, "\tFORCE_READERS        : %zu\n",
+            option->FORCE_READERS);
+    fprintf(LOG_DEST, "\tPARALLEL_IO          : %d\n", option->PARALLEL_IO);
+    fprintf(LOG_DEST, "\tASYNC_OUTPUT         : %d\n", option->ASYNC_OUTPUT);
+    fprintf(LOG_DEST, "\tIO_SERVERS           : %zu\n", option->IO_SERVERS);
+    fprintf(LOG_DEST, "\tNODE_SHARED_TABLES   : %d\n",
+            option->NODE_SHARED_TABLES);
+    fprintf(LOG_DEST, "\tHIERARCHICAL_IO      : %d\n",
+            option->HIERARCHICAL_IO);
+    fprintf(LOG_DEST, "\tDISTRIBUTED_DOMAIN   : %d\n",
+            option->DISTRIBUTED_DOMAIN);
+    fprintf(LOG_DEST, "\tNUMA_FIRST_TOUCH     : %d\n",
+            option->NUMA_FIRST_TOUCH);
+    fprintf(LOG_DEST, "\tOUT_LAYOUT           : %hu\n", option->OUT_LAYOUT);
+    fprintf(LOG_DEST, "\tOUT_SPLIT            : %zu\n", option->OUT_SPLIT);
+    fprintf(LOG_DEST, "\tCOMPRESS_THREADS     : %zu\n",
+            option->COMPRESS_THREADS);
+    fprintf(LOG_DEST, "\tSPINUP_FLOAT         : %d\n", option->SPINUP_FLOAT);
+    fprintf(LOG_DEST, "\tREPRODUCIBLE         : %d\n", option->REPRODUCIBLE);
+    fprintf(LOG_DEST, "\tPERF_REGIONS         : %d\n", option->PERF_REGIONS);
+    fprintf(LOG_DEST, "\tIO_BENCHMARK         : %d\n", option->IO_BENCHMARK);
+    fprintf(LOG_DEST, "\tCOMPUTE_BENCHMARK    : %d\n",
+            option->COMPUTE_BENCHMARK);
+    fprintf(LOG_DEST, "\tHEARTBEAT_STEPS      : %zu\n",
+            option->HEARTBEAT_STEPS);
+    fprintf(LOG_DEST, "\tHEARTBEAT_SECONDS    : %zu\n",
+            option->HEARTBEAT_SECONDS);
+    fprintf(LOG_DEST, "\tLOG_BUFFER           : %zu\n", option->LOG_BUFFER);
+    fprintf(LOG_DEST, "\tREBALANCE_STEPS      : %zu\n",
+            option->REBALANCE_STEPS);
+    fprintf(LOG_DEST, "\tDA_STEPS             : %zu\n",
+            option->DA_STEPS);
+    fprintf(LOG_DEST, "\tBALANCE_CHECK        : %hu\n",
+            option->BALANCE_CHECK);
+    fprintf(LOG_DEST, "\tBALANCE_CHECK_N      : %zu\n",
+            option->BALANCE_CHECK_N);
 }
 
 /******************************************************************************
@@ -535,20 +611,25 @@ print_stream(stream_struct   *stream,
     fprintf(LOG_DEST, "\tfilename: %s\n", stream->filename);
     fprintf(LOG_DEST, "\tfh: %p\n", stream->fh);
     fprintf(LOG_DEST, "\tfile_format: %hu\n", stream->file_format);
+    fprintf(LOG_DEST, "\tflush: %hu\n", stream->flush);
+    fprintf(LOG_DEST, "\tflush_n: %d\n", stream->flush_n);
     fprintf(LOG_DEST, "\tnvars: %zu\n", stream->nvars);
     fprintf(LOG_DEST, "\tngridcells: %zu\n", stream->ngridcells);
+    fprintf(LOG_DEST, "\tmask: %s\n", stream->mask);
+    fprintf(LOG_DEST, "\tregion: %s\n", stream->region);
+    fprintf(LOG_DEST, "\tregion_reduce: %hu\n", stream->region_reduce);
     fprintf(LOG_DEST, "\tagg_alarm:\n    ");
     print_alarm(&(stream->agg_alarm));
     fprintf(LOG_DEST,
-            "\t# \tVARID        \tVARNAME \tTYPE \tMULT \tFORMAT        \tAGGTYPE\n");
+            "\t# \tVARID        \tVARNAME \tTYPE \tMULT \tFORMAT        \tAGGTYPE \tDIGITS\n");
     for (i = 0; i < stream->nvars; i++) {
         varid = stream->varid[i];
-        fprintf(LOG_DEST, "\t%zu \t%u \t%20s \t%hu \t%f \t%10s \t%hu\n",
+        fprintf(LOG_DEST, "\t%zu \t%u \t%20s \t%hu \t%f \t%10s \t%hu \t%d\n",
                 i, varid, metadata[varid].varname,
                 stream->type[i], stream->mult[i], stream->format[i],
-                stream->aggtype[i]);
+                stream->aggtype[i], stream->digits[i]);
     }
-    fprintf(LOG_DEST, "\taggdata shape: (%zu, %zu, nelem, 1)\n",
+    fprintf(LOG_DEST, "\taggdata shape: (%zu, %zu, nelem, nbins)\n",
             stream->ngridcells, stream->nvars);
 
     fprintf(LOG_DEST, "\n");
@@ -783,6 +864,12 @@ print_parameters(parameters_struct *param)
     fprintf(LOG_DEST, "\tROOT_BRENT_MAXITER: %d\n", param->ROOT_BRENT_MAXITER);
     fprintf(LOG_DEST, "\tROOT_BRENT_TSTEP: %.4f\n", param->ROOT_BRENT_TSTEP);
     fprintf(LOG_DEST, "\tROOT_BRENT_T: %.4f\n", param->ROOT_BRENT_T);
+    fprintf(LOG_DEST, "\tROOT_BRENT_RETRY_DT: %.4f\n",
+            param->ROOT_BRENT_RETRY_DT);
+    fprintf(LOG_DEST, "\tADAPT_RUNOFF_FRAC: %.4f\n", param->ADAPT_RUNOFF_FRAC);
+    fprintf(LOG_DEST, "\tADAPT_SNOW_TAIR: %.4f\n", param->ADAPT_SNOW_TAIR);
+    fprintf(LOG_DEST, "\tBAND_MERGE_TDIFF: %.4f\n", param->BAND_MERGE_TDIFF);
+    fprintf(LOG_DEST, "\tBAND_MERGE_FDIFF: %.4f\n", param->BAND_MERGE_FDIFF);
     fprintf(LOG_DEST, "\tFROZEN_MAXITER: %d\n", param->FROZEN_MAXITER);
 }
 
@@ -799,6 +886,9 @@ print_save_data(save_data_struct *save)
     fprintf(LOG_DEST, "\tsurfstor: %.4f\n", save->surfstor);
     fprintf(LOG_DEST, "\tswe: %.4f\n", save->swe);
     fprintf(LOG_DEST, "\twdew: %.4f\n", save->wdew);
+    fprintf(LOG_DEST, "\tbalance_flux: %.4f\n", save->balance_flux);
+    fprintf(LOG_DEST, "\tbalance_steps: %zu\n", save->balance_steps);
+    fprintf(LOG_DEST, "\tbalance_cell: %d\n", save->balance_cell);
 }
 
 /******************************************************************************
@@ -70,8 +70,15 @@ put_data(all_vars_struct   *all_vars,
     double                     TreeAdjustFactor[MAX_BANDS];
     double                     ThisAreaFract;
     double                     ThisTreeAdjust;
+    double                     TileFract;
+    double                     AreaFactor;
+    double                     LakeAreaFactor;
     size_t                     i;
     double                     dt_sec;
+    bool                       energy_terms;
+    bool                       band_terms;
+    bool                       lake_terms;
+    bool                       check_balance;
 
     cell_data_struct         **cell;
     energy_bal_struct        **energy;
@@ -81,9 +88,13 @@ put_data(all_vars_struct   *all_vars,
 
     cell = all_vars->cell;
     energy = all_vars->energy;
-    lake_var = all_vars->lake_var;
     snow = all_vars->snow;
     veg_var = all_vars->veg_var;
+    // the wetland values override some of the lake variables of the output,
+    // so a copy is used, which is only made for the cells with a lake
+    if (options.LAKES && lake_con->lake_idx >= 0) {
+        lake_var = *(all_vars->lake_var);
+    }
 
     AboveTreeLine = soil_con->AboveTreeLine;
     AreaFract = soil_con->AreaFract;
@@ -92,6 +103,11 @@ put_data(all_vars_struct   *all_vars,
     frost_slope = soil_con->frost_slope;
     dt_sec = global_param.dt;
 
+    // groups of output variables that are not used by any stream are skipped
+    energy_terms = outvar_group_requested(OUT_GROUP_ENERGY);
+    band_terms = outvar_group_requested(OUT_GROUP_BAND);
+    lake_terms = outvar_group_requested(OUT_GROUP_LAKE);
+
     // Compute treeline adjustment factors
     for (band = 0; band < options.SNOW_BAND; band++) {
         if (AboveTreeLine[band]) {
@@ -204,30 +220,33 @@ put_data(all_vars_struct   *all_vars,
                                             (AboveTreeLine[band] &&
                                              !overstory)))) {
                     /** compute running totals of various landcovers **/
+                    TileFract = Cv * ThisAreaFract * ThisTreeAdjust;
                     if (HasVeg) {
-                        cv_veg += Cv * ThisAreaFract * ThisTreeAdjust;
+                        cv_veg += TileFract;
                     }
                     else {
-                        cv_baresoil += Cv * ThisAreaFract * ThisTreeAdjust;
+                        cv_baresoil += TileFract;
                     }
                     if (overstory) {
-                        cv_overstory += Cv * ThisAreaFract * ThisTreeAdjust;
+                        cv_overstory += TileFract;
                     }
                     if (snow[veg][band].swq > 0.0) {
-                        cv_snow += Cv * ThisAreaFract * ThisTreeAdjust;
+                        cv_snow += TileFract;
                     }
 
+                    // fractions of the grid cell of the tile, without the
+                    // lake, and of the lake
+                    AreaFactor = TileFract * (1 - Clake);
+                    LakeAreaFactor = TileFract * Clake;
+
                     /*********************************
                        Record Water Balance Terms
                     *********************************/
-                    collect_wb_terms(cell[veg][band],
-                                     veg_var[veg][band],
-                                     snow[veg][band],
-                                     Cv,
-                                     ThisAreaFract,
-                                     ThisTreeAdjust,
+                    collect_wb_terms(&(cell[veg][band]),
+                                     &(veg_var[veg][band]),
+                                     &(snow[veg][band]),
+                                     AreaFactor,
                                      HasVeg,
-                                     (1 - Clake),
                                      overstory,
                                      frost_fract,
                                      out_data);
@@ -235,23 +254,31 @@ put_data(all_vars_struct   *all_vars,
                     /**********************************
                        Record Energy Balance Terms
                     **********************************/
-                    collect_eb_terms(energy[veg][band],
-                                     snow[veg][band],
-                                     cell[veg][band],
-                                     Cv,
-                                     ThisAreaFract,
-                                     ThisTreeAdjust,
-                                     HasVeg,
-                                     0,
-                                     (1 - Clake),
-                                     overstory,
-                                     band,
-                                     frost_fract,
-                                     frost_slope,
-                                     out_data);
+                    if (energy_terms) {
+                        collect_eb_terms(&(energy[veg][band]),
+                                         &(snow[veg][band]),
+                                         &(cell[veg][band]),
+                                         AreaFactor,
+                                         HasVeg,
+                                         0,
+                                         overstory,
+                                         frost_fract,
+                                         frost_slope,
+                                         out_data);
+                    }
+                    if (band_terms) {
+                        collect_band_terms(&(energy[veg][band]),
+                                           &(snow[veg][band]),
+                                           Cv,
+                                           HasVeg,
+                                           (1 - Clake),
+                                           overstory,
+                                           band,
+                                           out_data);
+                    }
 
                     // Store Wetland-Specific Variables
-                    if (IsWet) {
+                    if (IsWet && energy_terms) {
                         // Wetland soil temperatures
                         for (i = 0; i < options.Nnode; i++) {
                             out_data[OUT_SOIL_TNODE_WL][i] =
@@ -289,14 +316,11 @@ put_data(all_vars_struct   *all_vars,
                         /*********************************
                            Record Water Balance Terms
                         *********************************/
-                        collect_wb_terms(lake_var.soil,
-                                         veg_var[0][0],
-                                         lake_var.snow,
-                                         Cv,
-                                         ThisAreaFract,
-                                         ThisTreeAdjust,
+                        collect_wb_terms(&(lake_var.soil),
+                                         &(veg_var[0][0]),
+                                         &(lake_var.snow),
+                                         LakeAreaFactor,
                                          0,
-                                         Clake,
                                          overstory,
                                          frost_fract,
                                          out_data);
@@ -304,128 +328,45 @@ put_data(all_vars_struct   *all_vars,
                         /**********************************
                            Record Energy Balance Terms
                         **********************************/
-                        collect_eb_terms(lake_var.energy,
-                                         lake_var.snow,
-                                         lake_var.soil,
-                                         Cv,
-                                         ThisAreaFract,
-                                         ThisTreeAdjust,
-                                         0,
-                                         1,
-                                         Clake,
-                                         overstory,
-                                         band,
-                                         frost_fract,
-                                         frost_slope,
-                                         out_data);
-
-                        // Store Lake-Specific Variables
-
-                        // Lake ice
-                        if (lake_var.new_ice_area > 0.0) {
-                            out_data[OUT_LAKE_ICE][0] =
-                                (lake_var.ice_water_eq /
-                                 lake_var.new_ice_area) * CONST_RHOICE /
-                                CONST_RHOFW;
-                            out_data[OUT_LAKE_ICE_TEMP][0] =
-                                lake_var.tempi;
-                            out_data[OUT_LAKE_ICE_HEIGHT][0] =
-                                lake_var.hice;
-                            out_data[OUT_LAKE_SWE][0] = lake_var.swe /
-                                                        lake_var.areai;       // m over lake ice
-                            out_data[OUT_LAKE_SWE_V][0] = lake_var.swe;  // m3
+                        if (energy_terms) {
+                            collect_eb_terms(&(lake_var.energy),
+                                             &(lake_var.snow),
+                                             &(lake_var.soil),
+                                             LakeAreaFactor,
+                                             0,
+                                             1,
+                                             overstory,
+                                             frost_fract,
+                                             frost_slope,
+                                             out_data);
                         }
-                        else {
-                            out_data[OUT_LAKE_ICE][0] = 0.0;
-                            out_data[OUT_LAKE_ICE_TEMP][0] = 0.0;
-                            out_data[OUT_LAKE_ICE_HEIGHT][0] = 0.0;
-                            out_data[OUT_LAKE_SWE][0] = 0.0;
-                            out_data[OUT_LAKE_SWE_V][0] = 0.0;
+                        if (band_terms) {
+                            collect_band_terms(&(lake_var.energy),
+                                               &(lake_var.snow),
+                                               Cv,
+                                               0,
+                                               Clake,
+                                               overstory,
+                                               band,
+                                               out_data);
                         }
-                        out_data[OUT_LAKE_DSWE_V][0] = lake_var.swe -
-                                                       lake_var.swe_save;       // m3
-                        // same as OUT_LAKE_MOIST
-                        out_data[OUT_LAKE_DSWE][0] =
-                            (lake_var.swe - lake_var.swe_save) * MM_PER_M /
-                            soil_con->cell_area;
-
-                        // Lake dimensions
-                        out_data[OUT_LAKE_AREA_FRAC][0] = Cv * Clake;
-                        out_data[OUT_LAKE_DEPTH][0] = lake_var.ldepth;
-                        out_data[OUT_LAKE_SURF_AREA][0] = lake_var.sarea;
-                        if (out_data[OUT_LAKE_SURF_AREA][0] > 0) {
-                            out_data[OUT_LAKE_ICE_FRACT][0] =
-                                lake_var.new_ice_area /
-                                out_data[OUT_LAKE_SURF_AREA][0];
-                        }
-                        else {
-                            out_data[OUT_LAKE_ICE_FRACT][0] = 0.;
+
+                        // Store Lake-Specific Variables
+                        if (lake_terms) {
+                            collect_lake_terms(&lake_var, Cv, Clake,
+                                               soil_con->cell_area, out_data);
                         }
-                        out_data[OUT_LAKE_VOLUME][0] = lake_var.volume;
-                        out_data[OUT_LAKE_DSTOR_V][0] = lake_var.volume -
-                                                        lake_var.
-                                                        volume_save;
-                        // mm over gridcell
-                        out_data[OUT_LAKE_DSTOR][0] =
-                            (lake_var.volume - lake_var.volume_save) *
-                            MM_PER_M /
-                            soil_con->cell_area;
-
-                        // Other lake characteristics
-                        out_data[OUT_LAKE_SURF_TEMP][0] = lake_var.temp[0];
-                        if (out_data[OUT_LAKE_SURF_AREA][0] > 0) {
+
+                        // Lake storage is part of the water balance
+                        if (lake_var.sarea > 0) {
                             // mm over gridcell
-                            out_data[OUT_LAKE_MOIST][0] =
-                                (lake_var.volume / soil_con->cell_area) *
-                                MM_PER_M;
-                            // same as OUT_LAKE_MOIST
                             out_data[OUT_SURFSTOR][0] =
                                 (lake_var.volume / soil_con->cell_area) *
                                 MM_PER_M;
                         }
                         else {
-                            out_data[OUT_LAKE_MOIST][0] = 0;
                             out_data[OUT_SURFSTOR][0] = 0;
                         }
-
-                        // Lake moisture fluxes
-                        out_data[OUT_LAKE_BF_IN_V][0] =
-                            lake_var.baseflow_in;  // m3
-                        out_data[OUT_LAKE_BF_OUT_V][0] =
-                            lake_var.baseflow_out;  // m3
-                        out_data[OUT_LAKE_CHAN_IN_V][0] =
-                            lake_var.channel_in;  // m3
-                        out_data[OUT_LAKE_CHAN_OUT_V][0] =
-                            lake_var.runoff_out;  // m3
-                        out_data[OUT_LAKE_EVAP_V][0] = lake_var.evapw;  // m3
-                        out_data[OUT_LAKE_PREC_V][0] = lake_var.prec;  // m3
-                        out_data[OUT_LAKE_RCHRG_V][0] = lake_var.recharge;  // m3
-                        out_data[OUT_LAKE_RO_IN_V][0] = lake_var.runoff_in;  // m3
-                        out_data[OUT_LAKE_VAPFLX_V][0] =
-                            lake_var.vapor_flux;  // m3
-                        out_data[OUT_LAKE_BF_IN][0] =
-                            lake_var.baseflow_in * MM_PER_M /
-                            soil_con->cell_area;  // mm over gridcell
-                        out_data[OUT_LAKE_BF_OUT][0] =
-                            lake_var.baseflow_out * MM_PER_M /
-                            soil_con->cell_area;  // mm over gridcell
-                        out_data[OUT_LAKE_CHAN_OUT][0] =
-                            lake_var.runoff_out * MM_PER_M /
-                            soil_con->cell_area;  // mm over gridcell
-                        // mm over gridcell
-                        out_data[OUT_LAKE_EVAP][0] = lake_var.evapw * MM_PER_M /
-                                                     soil_con->cell_area;
-                        // mm over gridcell
-                        out_data[OUT_LAKE_RCHRG][0] = lake_var.recharge *
-                                                      MM_PER_M /
-                                                      soil_con->cell_area;
-                        // mm over gridcell
-                        out_data[OUT_LAKE_RO_IN][0] = lake_var.runoff_in *
-                                                      MM_PER_M /
-                                                      soil_con->cell_area;
-                        out_data[OUT_LAKE_VAPFLX][0] =
-                            lake_var.vapor_flux * MM_PER_M /
-                            soil_con->cell_area;  // mm over gridcell
                     } // End if options.LAKES etc.
                 } // End if ThisAreaFract etc.
             } // End loop over bands
@@ -506,9 +447,12 @@ put_data(all_vars_struct   *all_vars,
                                    save_data->surfstor;
 
     // Energy terms
-    out_data[OUT_REFREEZE][0] =
-        (out_data[OUT_RFRZ_ENERGY][0] / CONST_LATICE) * dt_sec;
-    out_data[OUT_R_NET][0] = out_data[OUT_SWNET][0] + out_data[OUT_LWNET][0];
+    if (energy_terms) {
+        out_data[OUT_REFREEZE][0] =
+            (out_data[OUT_RFRZ_ENERGY][0] / CONST_LATICE) * dt_sec;
+        out_data[OUT_R_NET][0] = out_data[OUT_SWNET][0] +
+                                 out_data[OUT_LWNET][0];
+    }
 
     // Save current moisture state for use in next time step
     save_data->total_soil_moist = 0;
@@ -520,7 +464,7 @@ put_data(all_vars_struct   *all_vars,
     save_data->wdew = out_data[OUT_WDEW][0];
 
     // Carbon Terms
-    if (options.CARBON) {
+    if (options.CARBON && outvar_group_requested(OUT_GROUP_CARBON)) {
         out_data[OUT_RHET][0] *= dt_sec / SEC_PER_DAY;  // convert to gC/m2d
         out_data[OUT_NEE][0] = out_data[OUT_NPP][0] - out_data[OUT_RHET][0];
     }
@@ -528,28 +472,41 @@ put_data(all_vars_struct   *all_vars,
     /********************
        Check Water Balance
     ********************/
+    // the fluxes are accumulated at every time step, so that the error of a
+    // check covers all time steps since the previous check
+    check_balance = balance_check_requested(save_data);
+    save_data->balance_steps++;
     inflow = out_data[OUT_PREC][0] + out_data[OUT_LAKE_CHAN_IN][0];  // mm over grid cell
     outflow = out_data[OUT_EVAP][0] + out_data[OUT_RUNOFF][0] +
               out_data[OUT_BASEFLOW][0];  // mm over grid cell
-    storage = 0.;
-    for (index = 0; index < options.Nlayer; index++) {
-        storage += out_data[OUT_SOIL_LIQ][index] +
-                   out_data[OUT_SOIL_ICE][index];
+    save_data->balance_flux += inflow - outflow;
+    if (check_balance) {
+        storage = 0.;
+        for (index = 0; index < options.Nlayer; index++) {
+            storage += out_data[OUT_SOIL_LIQ][index] +
+                       out_data[OUT_SOIL_ICE][index];
+        }
+        storage += out_data[OUT_SWE][0] + out_data[OUT_SNOW_CANOPY][0] +
+                   out_data[OUT_WDEW][0] + out_data[OUT_SURFSTOR][0];
+        out_data[OUT_WATER_ERROR][0] = calc_water_balance_error(
+            save_data->balance_flux, 0., storage,
+            save_data->total_moist_storage);
+
+        // Store total storage for next check
+        save_data->total_moist_storage = storage;
+        save_data->balance_flux = 0.;
+    }
+    else {
+        out_data[OUT_WATER_ERROR][0] = 0.;
     }
-    storage += out_data[OUT_SWE][0] + out_data[OUT_SNOW_CANOPY][0] +
-               out_data[OUT_WDEW][0] + out_data[OUT_SURFSTOR][0];
-    out_data[OUT_WATER_ERROR][0] = calc_water_balance_error(inflow,
-                                                            outflow,
-                                                            storage,
-                                                            save_data->total_moist_storage);
-
-    // Store total storage for next timestep
-    save_data->total_moist_storage = storage;
 
     /********************
        Check Energy Balance
     ********************/
-    if (options.FULL_ENERGY) {
+    if (!check_balance) {
+        out_data[OUT_ENERGY_ERROR][0] = 0.;
+    }
+    else if (options.FULL_ENERGY && energy_terms) {
         out_data[OUT_ENERGY_ERROR][0] = \
             calc_energy_balance_error(out_data[OUT_SWNET][0] +
                                       out_data[OUT_LWNET][0],
@@ -572,28 +529,39 @@ put_data(all_vars_struct   *all_vars,
     // vic_run run time
     out_data[OUT_TIME_VICRUN_WALL][0] = timer->delta_wall;
     out_data[OUT_TIME_VICRUN_CPU][0] = timer->delta_cpu;
+
+    // vic_run solver counters
+    out_data[OUT_SOLVER_BRENT_ITER][0] = solver_stats[SOLVER_BRENT_ITER];
+    out_data[OUT_SOLVER_BRENT_FAIL][0] =
+        solver_stats[SOLVER_BRENT_BRACKET_FAIL];
+    out_data[OUT_SOLVER_NEWT_RAPH_ITER][0] =
+        solver_stats[SOLVER_NEWT_RAPH_ITER];
+    out_data[OUT_SOLVER_RUNOFF_STEPS][0] = solver_stats[SOLVER_RUNOFF_STEPS];
+    out_data[OUT_SOLVER_SNOW_MELT][0] = solver_stats[SOLVER_SNOW_MELT];
+    out_data[OUT_SOLVER_LAKE_MIX_ITER][0] = solver_stats[SOLVER_LAKE_MIX_ITER];
+    out_data[OUT_SOLVER_SNOW_STEPS][0] = solver_stats[SOLVER_SNOW_STEPS];
+    out_data[OUT_SOLVER_BRENT_RETRY][0] = solver_stats[SOLVER_BRENT_RETRY];
+    out_data[OUT_SOLVER_BAND_SOLVES][0] = solver_stats[SOLVER_BAND_SOLVES];
 }
 
 /******************************************************************************
  * @brief    This routine collects water balance terms.
+ * @details  AreaFactor is the fraction of the grid cell that the tile
+ *           covers, i.e. Cv * AreaFract * TreeAdjustFactor * lakefactor.
  *****************************************************************************/
 void
-collect_wb_terms(cell_data_struct cell,
-                 veg_var_struct   veg_var,
-                 snow_data_struct snow,
-                 double           Cv,
-                 double           AreaFract,
-                 double           TreeAdjustFactor,
-                 bool             HasVeg,
-                 double           lakefactor,
-                 bool             overstory,
-                 double          *frost_fract,
-                 double         **out_data)
+collect_wb_terms(const cell_data_struct *cell,
+                 const veg_var_struct   *veg_var,
+                 const snow_data_struct *snow,
+                 double                  AreaFactor,
+                 bool                    HasVeg,
+                 bool                    overstory,
+                 double                 *frost_fract,
+                 double                **out_data)
 {
     extern option_struct     options;
     extern parameters_struct param;
 
-    double                   AreaFactor;
     double                   tmp_evap;
     double                   tmp_cond1;
     double                   tmp_cond2;
@@ -602,81 +570,80 @@ collect_wb_terms(cell_data_struct cell,
     size_t                   index;
     size_t                   frost_area;
 
-    AreaFactor = Cv * AreaFract * TreeAdjustFactor * lakefactor;
 
     /** record evaporation components **/
     tmp_evap = 0.0;
     for (index = 0; index < options.Nlayer; index++) {
-        tmp_evap += cell.layer[index].evap;
+        tmp_evap += cell->layer[index].evap;
         if (HasVeg) {
-            out_data[OUT_EVAP_BARE][0] += cell.layer[index].evap *
-                                          cell.layer[index].bare_evap_frac
+            out_data[OUT_EVAP_BARE][0] += cell->layer[index].evap *
+                                          cell->layer[index].bare_evap_frac
                                           *
                                           AreaFactor;
-            out_data[OUT_TRANSP_VEG][0] += cell.layer[index].evap *
+            out_data[OUT_TRANSP_VEG][0] += cell->layer[index].evap *
                                            (1 -
-                                            cell.layer[index].
+                                            cell->layer[index].
                                             bare_evap_frac) * AreaFactor;
         }
         else {
-            out_data[OUT_EVAP_BARE][0] += cell.layer[index].evap *
+            out_data[OUT_EVAP_BARE][0] += cell->layer[index].evap *
                                           AreaFactor;
         }
     }
-    tmp_evap += snow.vapor_flux * MM_PER_M;
-    out_data[OUT_SUB_SNOW][0] += snow.vapor_flux * MM_PER_M * AreaFactor;
-    out_data[OUT_SUB_SURFACE][0] += snow.surface_flux * MM_PER_M *
+    tmp_evap += snow->vapor_flux * MM_PER_M;
+    out_data[OUT_SUB_SNOW][0] += snow->vapor_flux * MM_PER_M * AreaFactor;
+    out_data[OUT_SUB_SURFACE][0] += snow->surface_flux * MM_PER_M *
                                     AreaFactor;
-    out_data[OUT_SUB_BLOWING][0] += snow.blowing_flux * MM_PER_M *
+    out_data[OUT_SUB_BLOWING][0] += snow->blowing_flux * MM_PER_M *
                                     AreaFactor;
     if (HasVeg) {
-        tmp_evap += snow.canopy_vapor_flux * MM_PER_M;
-        out_data[OUT_SUB_CANOP][0] += snow.canopy_vapor_flux * MM_PER_M *
+        tmp_evap += snow->canopy_vapor_flux * MM_PER_M;
+        out_data[OUT_SUB_CANOP][0] += snow->canopy_vapor_flux * MM_PER_M *
                                       AreaFactor;
     }
     if (HasVeg) {
-        tmp_evap += veg_var.canopyevap;
-        out_data[OUT_EVAP_CANOP][0] += veg_var.canopyevap * AreaFactor;
+        tmp_evap += veg_var->canopyevap;
+        out_data[OUT_EVAP_CANOP][0] += veg_var->canopyevap * AreaFactor;
     }
     out_data[OUT_EVAP][0] += tmp_evap * AreaFactor;  // mm over gridcell
 
     /** record potential evap **/
-    out_data[OUT_PET][0] += cell.pot_evap * AreaFactor;
+    out_data[OUT_PET][0] += cell->pot_evap * AreaFactor;
 
     /** record saturated area fraction **/
-    out_data[OUT_ASAT][0] += cell.asat * AreaFactor;
+    out_data[OUT_ASAT][0] += cell->asat * AreaFactor;
 
     /** record runoff **/
-    out_data[OUT_RUNOFF][0] += cell.runoff * AreaFactor;
+    out_data[OUT_RUNOFF][0] += cell->runoff * AreaFactor;
 
     /** record baseflow **/
-    out_data[OUT_BASEFLOW][0] += cell.baseflow * AreaFactor;
+    out_data[OUT_BASEFLOW][0] += cell->baseflow * AreaFactor;
 
     /** record inflow **/
-    out_data[OUT_INFLOW][0] += (cell.inflow) * AreaFactor;
+    out_data[OUT_INFLOW][0] += (cell->inflow) * AreaFactor;
 
     /** record canopy interception **/
     if (HasVeg) {
-        out_data[OUT_WDEW][0] += veg_var.Wdew * AreaFactor;
+        out_data[OUT_WDEW][0] += veg_var->Wdew * AreaFactor;
     }
 
     /** record LAI **/
-    out_data[OUT_LAI][0] += veg_var.LAI * AreaFactor;
+    out_data[OUT_LAI][0] += veg_var->LAI * AreaFactor;
 
     /** record fcanopy **/
-    out_data[OUT_FCANOPY][0] += veg_var.fcanopy * AreaFactor;
+    out_data[OUT_FCANOPY][0] += veg_var->fcanopy * AreaFactor;
 
     /** record aerodynamic conductance and resistance **/
-    if (cell.aero_resist[0] > DBL_EPSILON) {
-        tmp_cond1 = (1 / cell.aero_resist[0]) * AreaFactor;
+    if (cell->aero_resist[0] > DBL_EPSILON) {
+        tmp_cond1 = (1 / cell->aero_resist[0]) * AreaFactor;
     }
     else {
         tmp_cond1 = param.HUGE_RESIST;
     }
     out_data[OUT_AERO_COND1][0] += tmp_cond1;
     if (overstory) {
-        if (cell.aero_resist[1] > DBL_EPSILON) {
-            tmp_cond2 = (1 / cell.aero_resist[1]) * AreaFactor;
+        if (cell->aero_resist[1] > DBL_EPSILON) {
+            tmp_cond2 = (1 / cell->aero_resist[1]) * AreaFactor;
         }
         else {
             tmp_cond2 = param.HUGE_RESIST;
@@ -690,27 +657,27 @@ collect_wb_terms(cell_data_struct cell,
 
     /** record layer moistures **/
     for (index = 0; index < options.Nlayer; index++) {
-        tmp_moist = cell.layer[index].moist;
+        tmp_moist = cell->layer[index].moist;
         tmp_ice = 0;
         for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
             tmp_ice +=
-                (cell.layer[index].ice[frost_area] * frost_fract[frost_area]);
+                (cell->layer[index].ice[frost_area] * frost_fract[frost_area]);
         }
         tmp_moist -= tmp_ice;
 
         out_data[OUT_SOIL_LIQ][index] += tmp_moist * AreaFactor;
         out_data[OUT_SOIL_ICE][index] += tmp_ice * AreaFactor;
     }
-    out_data[OUT_SOIL_WET][0] += cell.wetness * AreaFactor;
-    out_data[OUT_ROOTMOIST][0] += cell.rootmoist * AreaFactor;
+    out_data[OUT_SOIL_WET][0] += cell->wetness * AreaFactor;
+    out_data[OUT_ROOTMOIST][0] += cell->rootmoist * AreaFactor;
 
     /** record water table position **/
-    out_data[OUT_ZWT][0] += cell.zwt * AreaFactor;
-    out_data[OUT_ZWT_LUMPED][0] += cell.zwt_lumped * AreaFactor;
+    out_data[OUT_ZWT][0] += cell->zwt * AreaFactor;
+    out_data[OUT_ZWT_LUMPED][0] += cell->zwt_lumped * AreaFactor;
 
     /** record layer temperatures **/
     for (index = 0; index < options.Nlayer; index++) {
-        out_data[OUT_SOIL_TEMP][index] += cell.layer[index].T * AreaFactor;
+        out_data[OUT_SOIL_TEMP][index] += cell->layer[index].T * AreaFactor;
     }
 
     /*****************************
@@ -718,80 +685,76 @@ collect_wb_terms(cell_data_struct cell,
     *****************************/
 
     /** record snow water equivalence **/
-    out_data[OUT_SWE][0] += snow.swq * AreaFactor * MM_PER_M;
+    out_data[OUT_SWE][0] += snow->swq * AreaFactor * MM_PER_M;
 
     /** record snowpack depth **/
-    out_data[OUT_SNOW_DEPTH][0] += snow.depth * AreaFactor * CM_PER_M;
+    out_data[OUT_SNOW_DEPTH][0] += snow->depth * AreaFactor * CM_PER_M;
 
     /** record snowpack albedo, temperature **/
-    if (snow.swq > 0.0) {
-        out_data[OUT_SALBEDO][0] += snow.albedo * AreaFactor;
-        out_data[OUT_SNOW_SURF_TEMP][0] += snow.surf_temp * AreaFactor;
-        out_data[OUT_SNOW_PACK_TEMP][0] += snow.pack_temp * AreaFactor;
+    if (snow->swq > 0.0) {
+        out_data[OUT_SALBEDO][0] += snow->albedo * AreaFactor;
+        out_data[OUT_SNOW_SURF_TEMP][0] += snow->surf_temp * AreaFactor;
+        out_data[OUT_SNOW_PACK_TEMP][0] += snow->pack_temp * AreaFactor;
     }
 
     /** record canopy intercepted snow **/
     if (HasVeg) {
-        out_data[OUT_SNOW_CANOPY][0] += (snow.snow_canopy) * AreaFactor *
+        out_data[OUT_SNOW_CANOPY][0] += (snow->snow_canopy) * AreaFactor *
                                         MM_PER_M;
     }
 
     /** record snowpack melt **/
-    out_data[OUT_SNOW_MELT][0] += snow.melt * AreaFactor;
+    out_data[OUT_SNOW_MELT][0] += snow->melt * AreaFactor;
 
     /** record snow cover fraction **/
-    out_data[OUT_SNOW_COVER][0] += snow.coverage * AreaFactor;
+    out_data[OUT_SNOW_COVER][0] += snow->coverage * AreaFactor;
 
     /*****************************
        Record Carbon Cycling Variables
     *****************************/
-    if (options.CARBON) {
-        out_data[OUT_APAR][0] += veg_var.aPAR * AreaFactor;
-        out_data[OUT_GPP][0] += veg_var.GPP * CONST_MWC / MOLE_PER_KMOLE *
+    if (options.CARBON && outvar_group_requested(OUT_GROUP_CARBON)) {
+        out_data[OUT_APAR][0] += veg_var->aPAR * AreaFactor;
+        out_data[OUT_GPP][0] += veg_var->GPP * CONST_MWC / MOLE_PER_KMOLE *
                                 CONST_CDAY *
                                 AreaFactor;
-        out_data[OUT_RAUT][0] += veg_var.Raut * CONST_MWC /
+        out_data[OUT_RAUT][0] += veg_var->Raut * CONST_MWC /
                                  MOLE_PER_KMOLE * CONST_CDAY *
                                  AreaFactor;
-        out_data[OUT_NPP][0] += veg_var.NPP * CONST_MWC / MOLE_PER_KMOLE *
+        out_data[OUT_NPP][0] += veg_var->NPP * CONST_MWC / MOLE_PER_KMOLE *
                                 CONST_CDAY *
                                 AreaFactor;
-        out_data[OUT_LITTERFALL][0] += veg_var.Litterfall * AreaFactor;
-        out_data[OUT_RHET][0] += cell.RhTot * AreaFactor;
-        out_data[OUT_CLITTER][0] += cell.CLitter * AreaFactor;
-        out_data[OUT_CINTER][0] += cell.CInter * AreaFactor;
-        out_data[OUT_CSLOW][0] += cell.CSlow * AreaFactor;
+        out_data[OUT_LITTERFALL][0] += veg_var->Litterfall * AreaFactor;
+        out_data[OUT_RHET][0] += cell->RhTot * AreaFactor;
+        out_data[OUT_CLITTER][0] += cell->CLitter * AreaFactor;
+        out_data[OUT_CINTER][0] += cell->CInter * AreaFactor;
+        out_data[OUT_CSLOW][0] += cell->CSlow * AreaFactor;
     }
 }
 
 /******************************************************************************
  * @brief    This routine collects energy balance terms.
+ * @details  AreaFactor is the fraction of the grid cell that the tile
+ *           covers, see collect_wb_terms().
  *****************************************************************************/
 void
-collect_eb_terms(energy_bal_struct energy,
-                 snow_data_struct  snow,
-                 cell_data_struct  cell_wet,
-                 double            Cv,
-                 double            AreaFract,
-                 double            TreeAdjustFactor,
-                 bool              HasVeg,
-                 bool              IsWet,
-                 double            lakefactor,
-                 bool              overstory,
-                 int               band,
-                 double           *frost_fract,
-                 double            frost_slope,
-                 double          **out_data)
+collect_eb_terms(const energy_bal_struct *energy,
+                 const snow_data_struct  *snow,
+                 const cell_data_struct  *cell_wet,
+                 double                   AreaFactor,
+                 bool                     HasVeg,
+                 bool                     IsWet,
+                 bool                     overstory,
+                 double                  *frost_fract,
+                 double                   frost_slope,
+                 double                 **out_data)
 {
     extern option_struct options;
-    double               AreaFactor;
     double               tmp_fract;
     double               rad_temp;
     double               surf_temp;
     size_t               index;
     size_t               frost_area;
 
-    AreaFactor = Cv * AreaFract * TreeAdjustFactor * lakefactor;
 
     /**********************************
        Record Frozen Soil Variables
@@ -800,12 +763,12 @@ collect_eb_terms(energy_bal_struct energy,
     /** record freezing and thawing front depths **/
     if (options.FROZEN_SOIL) {
         for (index = 0; index < MAX_FRONTS; index++) {
-            if (energy.fdepth[index] != MISSING) {
-                out_data[OUT_FDEPTH][index] += energy.fdepth[index] *
+            if (energy->fdepth[index] != MISSING) {
+                out_data[OUT_FDEPTH][index] += energy->fdepth[index] *
                                                AreaFactor * CM_PER_M;
             }
-            if (energy.tdepth[index] != MISSING) {
-                out_data[OUT_TDEPTH][index] += energy.tdepth[index] *
+            if (energy->tdepth[index] != MISSING) {
+                out_data[OUT_TDEPTH][index] += energy->tdepth[index] *
                                                AreaFactor * CM_PER_M;
             }
         }
@@ -813,18 +776,18 @@ collect_eb_terms(energy_bal_struct energy,
 
     tmp_fract = 0;
     for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
-        if (cell_wet.layer[0].ice[frost_area]) {
+        if (cell_wet->layer[0].ice[frost_area]) {
             tmp_fract += frost_fract[frost_area];
         }
     }
     out_data[OUT_SURF_FROST_FRAC][0] += tmp_fract * AreaFactor;
 
     tmp_fract = 0;
-    if ((energy.T[0] + frost_slope / 2.) > 0) {
-        if ((energy.T[0] - frost_slope / 2.) <= 0) {
+    if ((energy->T[0] + frost_slope / 2.) > 0) {
+        if ((energy->T[0] - frost_slope / 2.) <= 0) {
             tmp_fract +=
-                linear_interp(0, (energy.T[0] + frost_slope / 2.),
-                              (energy.T[0] - frost_slope / 2.), 1,
+                linear_interp(0, (energy->T[0] + frost_slope / 2.),
+                              (energy->T[0] - frost_slope / 2.), 1,
                               0) * AreaFactor;
         }
     }
@@ -837,15 +800,15 @@ collect_eb_terms(energy_bal_struct energy,
     **********************************/
 
     /** record surface radiative temperature **/
-    if (overstory && snow.snow && !(options.LAKES && IsWet)) {
-        rad_temp = energy.Tfoliage + CONST_TKFRZ;
+    if (overstory && snow->snow && !(options.LAKES && IsWet)) {
+        rad_temp = energy->Tfoliage + CONST_TKFRZ;
     }
     else {
-        rad_temp = energy.Tsurf + CONST_TKFRZ;
+        rad_temp = energy->Tsurf + CONST_TKFRZ;
     }
 
     /** record surface skin temperature **/
-    surf_temp = energy.Tsurf;
+    surf_temp = energy->Tsurf;
 
     /** record landcover temperature **/
     if (!HasVeg) {
@@ -855,9 +818,9 @@ collect_eb_terms(energy_bal_struct energy,
     }
     else {
         // landcover is vegetation
-        if (overstory && !snow.snow) {
+        if (overstory && !snow->snow) {
             // here, rad_temp will be wrong since it will pick the understory temperature
-            out_data[OUT_VEGT][0] += energy.Tfoliage * AreaFactor;
+            out_data[OUT_VEGT][0] += energy->Tfoliage * AreaFactor;
         }
         else {
             out_data[OUT_VEGT][0] += (rad_temp - CONST_TKFRZ) * AreaFactor;
@@ -869,63 +832,63 @@ collect_eb_terms(energy_bal_struct energy,
 
     /** record thermal node temperatures **/
     for (index = 0; index < options.Nnode; index++) {
-        out_data[OUT_SOIL_TNODE][index] += energy.T[index] * AreaFactor;
+        out_data[OUT_SOIL_TNODE][index] += energy->T[index] * AreaFactor;
     }
     if (IsWet) {
         for (index = 0; index < options.Nnode; index++) {
-            out_data[OUT_SOIL_TNODE_WL][index] = energy.T[index];
+            out_data[OUT_SOIL_TNODE_WL][index] = energy->T[index];
         }
     }
 
     /** record temperature flags  **/
-    out_data[OUT_SURFT_FBFLAG][0] += energy.Tsurf_fbflag * AreaFactor;
+    out_data[OUT_SURFT_FBFLAG][0] += energy->Tsurf_fbflag * AreaFactor;
     for (index = 0; index < options.Nnode; index++) {
-        out_data[OUT_SOILT_FBFLAG][index] += energy.T_fbflag[index] *
+        out_data[OUT_SOILT_FBFLAG][index] += energy->T_fbflag[index] *
                                              AreaFactor;
     }
-    out_data[OUT_SNOWT_FBFLAG][0] += snow.surf_temp_fbflag * AreaFactor;
-    out_data[OUT_TFOL_FBFLAG][0] += energy.Tfoliage_fbflag * AreaFactor;
-    out_data[OUT_TCAN_FBFLAG][0] += energy.Tcanopy_fbflag * AreaFactor;
+    out_data[OUT_SNOWT_FBFLAG][0] += snow->surf_temp_fbflag * AreaFactor;
+    out_data[OUT_TFOL_FBFLAG][0] += energy->Tfoliage_fbflag * AreaFactor;
+    out_data[OUT_TCAN_FBFLAG][0] += energy->Tcanopy_fbflag * AreaFactor;
 
     /** record net shortwave radiation **/
-    out_data[OUT_SWNET][0] += energy.NetShortAtmos * AreaFactor;
+    out_data[OUT_SWNET][0] += energy->NetShortAtmos * AreaFactor;
 
     /** record net longwave radiation **/
-    out_data[OUT_LWNET][0] += energy.NetLongAtmos * AreaFactor;
+    out_data[OUT_LWNET][0] += energy->NetLongAtmos * AreaFactor;
 
     /** record incoming longwave radiation at ground surface (under veg) **/
-    if (snow.snow && overstory) {
-        out_data[OUT_IN_LONG][0] += energy.LongOverIn * AreaFactor;
+    if (snow->snow && overstory) {
+        out_data[OUT_IN_LONG][0] += energy->LongOverIn * AreaFactor;
     }
     else {
-        out_data[OUT_IN_LONG][0] += energy.LongUnderIn * AreaFactor;
+        out_data[OUT_IN_LONG][0] += energy->LongUnderIn * AreaFactor;
     }
 
     /** record albedo **/
-    if (snow.snow && overstory) {
-        out_data[OUT_ALBEDO][0] += energy.AlbedoOver * AreaFactor;
+    if (snow->snow && overstory) {
+        out_data[OUT_ALBEDO][0] += energy->AlbedoOver * AreaFactor;
     }
     else {
-        out_data[OUT_ALBEDO][0] += energy.AlbedoUnder * AreaFactor;
+        out_data[OUT_ALBEDO][0] += energy->AlbedoUnder * AreaFactor;
     }
 
     /** record latent heat flux **/
-    out_data[OUT_LATENT][0] -= energy.AtmosLatent * AreaFactor;
+    out_data[OUT_LATENT][0] -= energy->AtmosLatent * AreaFactor;
 
     /** record latent heat flux from sublimation **/
-    out_data[OUT_LATENT_SUB][0] -= energy.AtmosLatentSub * AreaFactor;
+    out_data[OUT_LATENT_SUB][0] -= energy->AtmosLatentSub * AreaFactor;
 
     /** record sensible heat flux **/
-    out_data[OUT_SENSIBLE][0] -= energy.AtmosSensible * AreaFactor;
+    out_data[OUT_SENSIBLE][0] -= energy->AtmosSensible * AreaFactor;
 
     /** record ground heat flux (+ heat storage) **/
-    out_data[OUT_GRND_FLUX][0] -= energy.grnd_flux * AreaFactor;
+    out_data[OUT_GRND_FLUX][0] -= energy->grnd_flux * AreaFactor;
 
     /** record heat storage **/
-    out_data[OUT_DELTAH][0] -= energy.deltaH * AreaFactor;
+    out_data[OUT_DELTAH][0] -= energy->deltaH * AreaFactor;
 
     /** record heat of fusion **/
-    out_data[OUT_FUSION][0] -= energy.fusion * AreaFactor;
+    out_data[OUT_FUSION][0] -= energy->fusion * AreaFactor;
 
     /** record radiative effective temperature [K],
         emissivities set = 1.0  **/
@@ -933,121 +896,250 @@ collect_eb_terms(energy_bal_struct energy,
         ((rad_temp) * (rad_temp) * (rad_temp) * (rad_temp)) * AreaFactor;
 
     /** record snowpack cold content **/
-    out_data[OUT_DELTACC][0] += energy.deltaCC * AreaFactor;
+    out_data[OUT_DELTACC][0] += energy->deltaCC * AreaFactor;
 
     /** record snowpack advection **/
-    if (snow.snow && overstory) {
-        out_data[OUT_ADVECTION][0] += energy.canopy_advection * AreaFactor;
+    if (snow->snow && overstory) {
+        out_data[OUT_ADVECTION][0] += energy->canopy_advection * AreaFactor;
     }
-    out_data[OUT_ADVECTION][0] += energy.advection * AreaFactor;
+    out_data[OUT_ADVECTION][0] += energy->advection * AreaFactor;
 
     /** record snow energy flux **/
-    out_data[OUT_SNOW_FLUX][0] += energy.snow_flux * AreaFactor;
+    out_data[OUT_SNOW_FLUX][0] += energy->snow_flux * AreaFactor;
 
     /** record refreeze energy **/
-    if (snow.snow && overstory) {
-        out_data[OUT_RFRZ_ENERGY][0] += energy.canopy_refreeze *
+    if (snow->snow && overstory) {
+        out_data[OUT_RFRZ_ENERGY][0] += energy->canopy_refreeze *
                                         AreaFactor;
     }
-    out_data[OUT_RFRZ_ENERGY][0] += energy.refreeze_energy * AreaFactor;
+    out_data[OUT_RFRZ_ENERGY][0] += energy->refreeze_energy * AreaFactor;
 
     /** record melt energy **/
-    out_data[OUT_MELT_ENERGY][0] += energy.melt_energy * AreaFactor;
+    out_data[OUT_MELT_ENERGY][0] += energy->melt_energy * AreaFactor;
 
     /** record advected sensible heat energy **/
     if (!overstory) {
-        out_data[OUT_ADV_SENS][0] -= energy.advected_sensible * AreaFactor;
+        out_data[OUT_ADV_SENS][0] -= energy->advected_sensible * AreaFactor;
     }
+}
 
+/******************************************************************************
+ * @brief    This routine collects snow band terms.
+ *****************************************************************************/
+void
+collect_band_terms(const energy_bal_struct *energy,
+                   const snow_data_struct  *snow,
+                   double                   Cv,
+                   bool                     HasVeg,
+                   double                   lakefactor,
+                   bool                     overstory,
+                   int                      band,
+                   double                 **out_data)
+{
     /**********************************
        Record Band-Specific Variables
     **********************************/
 
     /** record band snow water equivalent **/
-    out_data[OUT_SWE_BAND][band] += snow.swq * Cv * lakefactor * MM_PER_M;
+    out_data[OUT_SWE_BAND][band] += snow->swq * Cv * lakefactor * MM_PER_M;
 
     /** record band snowpack depth **/
-    out_data[OUT_SNOW_DEPTH_BAND][band] += snow.depth * Cv * lakefactor *
+    out_data[OUT_SNOW_DEPTH_BAND][band] += snow->depth * Cv * lakefactor *
                                            CM_PER_M;
 
     /** record band canopy intercepted snow **/
     if (HasVeg) {
-        out_data[OUT_SNOW_CANOPY_BAND][band] += (snow.snow_canopy) * Cv *
+        out_data[OUT_SNOW_CANOPY_BAND][band] += (snow->snow_canopy) * Cv *
                                                 lakefactor * MM_PER_M;
     }
 
     /** record band snow melt **/
-    out_data[OUT_SNOW_MELT_BAND][band] += snow.melt * Cv * lakefactor;
+    out_data[OUT_SNOW_MELT_BAND][band] += snow->melt * Cv * lakefactor;
 
     /** record band snow coverage **/
-    out_data[OUT_SNOW_COVER_BAND][band] += snow.coverage * Cv * lakefactor;
+    out_data[OUT_SNOW_COVER_BAND][band] += snow->coverage * Cv * lakefactor;
 
     /** record band cold content **/
-    out_data[OUT_DELTACC_BAND][band] += energy.deltaCC * Cv * lakefactor;
+    out_data[OUT_DELTACC_BAND][band] += energy->deltaCC * Cv * lakefactor;
 
     /** record band advection **/
-    out_data[OUT_ADVECTION_BAND][band] += energy.advection * Cv *
+    out_data[OUT_ADVECTION_BAND][band] += energy->advection * Cv *
                                           lakefactor;
 
     /** record band snow flux **/
-    out_data[OUT_SNOW_FLUX_BAND][band] += energy.snow_flux * Cv *
+    out_data[OUT_SNOW_FLUX_BAND][band] += energy->snow_flux * Cv *
                                           lakefactor;
 
     /** record band refreeze energy **/
-    out_data[OUT_RFRZ_ENERGY_BAND][band] += energy.refreeze_energy * Cv *
+    out_data[OUT_RFRZ_ENERGY_BAND][band] += energy->refreeze_energy * Cv *
                                             lakefactor;
 
     /** record band melt energy **/
-    out_data[OUT_MELT_ENERGY_BAND][band] += energy.melt_energy * Cv *
+    out_data[OUT_MELT_ENERGY_BAND][band] += energy->melt_energy * Cv *
                                             lakefactor;
 
     /** record band advected sensble heat **/
-    out_data[OUT_ADV_SENS_BAND][band] -= energy.advected_sensible * Cv *
+    out_data[OUT_ADV_SENS_BAND][band] -= energy->advected_sensible * Cv *
                                          lakefactor;
 
     /** record surface layer temperature **/
-    out_data[OUT_SNOW_SURFT_BAND][band] += snow.surf_temp * Cv *
+    out_data[OUT_SNOW_SURFT_BAND][band] += snow->surf_temp * Cv *
                                            lakefactor;
 
     /** record pack layer temperature **/
-    out_data[OUT_SNOW_PACKT_BAND][band] += snow.pack_temp * Cv *
+    out_data[OUT_SNOW_PACKT_BAND][band] += snow->pack_temp * Cv *
                                            lakefactor;
 
     /** record latent heat of sublimation **/
-    out_data[OUT_LATENT_SUB_BAND][band] += energy.latent_sub * Cv *
+    out_data[OUT_LATENT_SUB_BAND][band] += energy->latent_sub * Cv *
                                            lakefactor;
 
     /** record band net downwards shortwave radiation **/
-    out_data[OUT_SWNET_BAND][band] += energy.NetShortAtmos * Cv *
+    out_data[OUT_SWNET_BAND][band] += energy->NetShortAtmos * Cv *
                                       lakefactor;
 
     /** record band net downwards longwave radiation **/
-    out_data[OUT_LWNET_BAND][band] += energy.NetLongAtmos * Cv *
+    out_data[OUT_LWNET_BAND][band] += energy->NetLongAtmos * Cv *
                                       lakefactor;
 
     /** record band albedo **/
-    if (snow.snow && overstory) {
-        out_data[OUT_ALBEDO_BAND][band] += energy.AlbedoOver * Cv *
+    if (snow->snow && overstory) {
+        out_data[OUT_ALBEDO_BAND][band] += energy->AlbedoOver * Cv *
                                            lakefactor;
     }
     else {
-        out_data[OUT_ALBEDO_BAND][band] += energy.AlbedoUnder * Cv *
+        out_data[OUT_ALBEDO_BAND][band] += energy->AlbedoUnder * Cv *
                                            lakefactor;
     }
 
     /** record band net latent heat flux **/
-    out_data[OUT_LATENT_BAND][band] -= energy.latent * Cv * lakefactor;
+    out_data[OUT_LATENT_BAND][band] -= energy->latent * Cv * lakefactor;
 
     /** record band net sensible heat flux **/
-    out_data[OUT_SENSIBLE_BAND][band] -= energy.sensible * Cv * lakefactor;
+    out_data[OUT_SENSIBLE_BAND][band] -= energy->sensible * Cv * lakefactor;
 
     /** record band net ground heat flux **/
-    out_data[OUT_GRND_FLUX_BAND][band] -= energy.grnd_flux * Cv *
+    out_data[OUT_GRND_FLUX_BAND][band] -= energy->grnd_flux * Cv *
                                           lakefactor;
 }
 
+/******************************************************************************
+ * @brief    This routine collects lake terms.
+ *****************************************************************************/
+void
+collect_lake_terms(const lake_var_struct *lake_var,
+                   double                 Cv,
+                   double                 Clake,
+                   double                 cell_area,
+                   double               **out_data)
+{
+    // Lake ice
+    if (lake_var->new_ice_area > 0.0) {
+        out_data[OUT_LAKE_ICE][0] =
+            (lake_var->ice_water_eq / lake_var->new_ice_area) * CONST_RHOICE /
+            CONST_RHOFW;
+        out_data[OUT_LAKE_ICE_TEMP][0] = lake_var->tempi;
+        out_data[OUT_LAKE_ICE_HEIGHT][0] = lake_var->hice;
+        out_data[OUT_LAKE_SWE][0] = lake_var->swe / lake_var->areai;  // m over lake ice
+        out_data[OUT_LAKE_SWE_V][0] = lake_var->swe;  // m3
+    }
+    else {
+        out_data[OUT_LAKE_ICE][0] = 0.0;
+        out_data[OUT_LAKE_ICE_TEMP][0] = 0.0;
+        out_data[OUT_LAKE_ICE_HEIGHT][0] = 0.0;
+        out_data[OUT_LAKE_SWE][0] = 0.0;
+        out_data[OUT_LAKE_SWE_V][0] = 0.0;
+    }
+    out_data[OUT_LAKE_DSWE_V][0] = lake_var->swe - lake_var->swe_save;  // m3
+    // same as OUT_LAKE_MOIST
+    out_data[OUT_LAKE_DSWE][0] =
+        (lake_var->swe - lake_var->swe_save) * MM_PER_M / cell_area;
+
+    // Lake dimensions
+    out_data[OUT_LAKE_AREA_FRAC][0] = Cv * Clake;
+    out_data[OUT_LAKE_DEPTH][0] = lake_var->ldepth;
+    out_data[OUT_LAKE_SURF_AREA][0] = lake_var->sarea;
+    if (out_data[OUT_LAKE_SURF_AREA][0] > 0) {
+        out_data[OUT_LAKE_ICE_FRACT][0] =
+            lake_var->new_ice_area / out_data[OUT_LAKE_SURF_AREA][0];
+    }
+    else {
+        out_data[OUT_LAKE_ICE_FRACT][0] = 0.;
+    }
+    out_data[OUT_LAKE_VOLUME][0] = lake_var->volume;
+    out_data[OUT_LAKE_DSTOR_V][0] = lake_var->volume - lake_var->volume_save;
+    // mm over gridcell
+    out_data[OUT_LAKE_DSTOR][0] =
+        (lake_var->volume - lake_var->volume_save) * MM_PER_M / cell_area;
+
+    // Other lake characteristics
+    out_data[OUT_LAKE_SURF_TEMP][0] = lake_var->temp[0];
+    if (out_data[OUT_LAKE_SURF_AREA][0] > 0) {
+        // mm over gridcell
+        out_data[OUT_LAKE_MOIST][0] =
+            (lake_var->volume / cell_area) * MM_PER_M;
+    }
+    else {
+        out_data[OUT_LAKE_MOIST][0] = 0;
+    }
+
+    // Lake moisture fluxes
+    out_data[OUT_LAKE_BF_IN_V][0] = lake_var->baseflow_in;  // m3
+    out_data[OUT_LAKE_BF_OUT_V][0] = lake_var->baseflow_out;  // m3
+    out_data[OUT_LAKE_CHAN_IN_V][0] = lake_var->channel_in;  // m3
+    out_data[OUT_LAKE_CHAN_OUT_V][0] = lake_var->runoff_out;  // m3
+    out_data[OUT_LAKE_EVAP_V][0] = lake_var->evapw;  // m3
+    out_data[OUT_LAKE_PREC_V][0] = lake_var->prec;  // m3
+    out_data[OUT_LAKE_RCHRG_V][0] = lake_var->recharge;  // m3
+    out_data[OUT_LAKE_RO_IN_V][0] = lake_var->runoff_in;  // m3
+    out_data[OUT_LAKE_VAPFLX_V][0] = lake_var->vapor_flux;  // m3
+    out_data[OUT_LAKE_BF_IN][0] =
+        lake_var->baseflow_in * MM_PER_M / cell_area;  // mm over gridcell
+    out_data[OUT_LAKE_BF_OUT][0] =
+        lake_var->baseflow_out * MM_PER_M / cell_area;  // mm over gridcell
+    out_data[OUT_LAKE_CHAN_OUT][0] =
+        lake_var->runoff_out * MM_PER_M / cell_area;  // mm over gridcell
+    // mm over gridcell
+    out_data[OUT_LAKE_EVAP][0] = lake_var->evapw * MM_PER_M / cell_area;
+    // mm over gridcell
+    out_data[OUT_LAKE_RCHRG][0] = lake_var->recharge * MM_PER_M / cell_area;
+    // mm over gridcell
+    out_data[OUT_LAKE_RO_IN][0] = lake_var->runoff_in * MM_PER_M / cell_area;
+    out_data[OUT_LAKE_VAPFLX][0] =
+        lake_var->vapor_flux * MM_PER_M / cell_area;  // mm over gridcell
+}
+
+/******************************************************************************
+ * @brief    Return whether the water and energy balances of a cell are checked
+ *           at this time step.
+ * @details  The first time step after initialize_save_data() is always
+ *           checked, since it sets the storage that the next check starts
+ *           from.
+ *****************************************************************************/
+bool
+balance_check_requested(save_data_struct *save_data)
+{
+    extern option_struct options;
+
+    if (save_data->balance_steps == 0) {
+        return true;
+    }
+    switch (options.BALANCE_CHECK) {
+    case BALANCE_CHECK_STEPS:
+        return (save_data->balance_steps % options.BALANCE_CHECK_N == 0);
+    case BALANCE_CHECK_CELLS:
+        return save_data->balance_cell;
+    case BALANCE_CHECK_OUTPUT:
+        return outvar_group_requested(OUT_GROUP_BALANCE);
+    default:
+        return true;
+    }
+}
+
 /******************************************************************************
  * @brief    Initialize the save data structure.
+ * @details  The cell is checked with BALANCE_CHECK = CELLS unless the driver
+ *           clears save_data->balance_cell.
  *****************************************************************************/
 void
 initialize_save_data(all_vars_struct   *all_vars,
@@ -1060,6 +1152,10 @@ initialize_save_data(all_vars_struct   *all_vars,
                      save_data_struct  *save_data,
                      timer_struct      *timer)
 {
+    save_data->balance_flux = 0.;
+    save_data->balance_steps = 0;
+    save_data->balance_cell = true;
+
     // Calling put data will populate the save data storage terms
     put_data(all_vars, atmos, soil_con, veg_con, veg_lib, lake_con,
              out_data, save_data, timer);
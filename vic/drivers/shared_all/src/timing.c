@@ -26,6 +26,21 @@
 
 #include <vic_driver_shared_all.h>
 
+// called by timer_start(), timer_continue() and timer_stop(), if set
+static void (*timer_hook)(timer_struct *t, bool start) = NULL;
+
+/******************************************************************************
+ * @brief    Set a function that is called each time a timer is started,
+ *           continued or stopped, e.g. to trace the timers.
+ * @details  The function gets the timer and whether it was started or
+ *           continued (true) or stopped (false). NULL removes the hook.
+ *****************************************************************************/
+void
+set_timer_hook(void (*hook)(timer_struct *t, bool start))
+{
+    timer_hook = hook;
+}
+
 /******************************************************************************
  * @brief    Get wall time
  *****************************************************************************/
@@ -39,6 +54,27 @@ get_wall_time()
     return (double) time.tv_sec + (double) time.tv_usec * 0.000001;
 }
 
+/******************************************************************************
+ * @brief    Get the time of the monotonic clock
+ * @details  Only differences of its values are meaningful. It is read
+ *           through the vDSO where the system provides it and is not
+ *           affected by changes of the system clock, for short intervals
+ *           such as one call of vic_run.
+ *****************************************************************************/
+double
+get_elapsed_time()
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec time;
+    if (clock_gettime(CLOCK_MONOTONIC, &time)) {
+        log_err("Unable to get the monotonic clock time")
+    }
+    return (double) time.tv_sec + (double) time.tv_nsec * 1e-9;
+#else
+    return get_wall_time();
+#endif
+}
+
 /******************************************************************************
  * @brief    Get CPU time
  *****************************************************************************/
@@ -71,6 +107,32 @@ timer_start(timer_struct *t)
 
     t->start_wall = get_wall_time();
     t->start_cpu = get_cpu_time();
+
+    if (timer_hook != NULL) {
+        timer_hook(t, true);
+    }
+}
+
+/******************************************************************************
+ * @brief    Start a timer that only reads the given clocks
+ * @details  For the timers around every call of vic_run, where reading the
+ *           CPU time is a system call. The wall time is read from
+ *           get_elapsed_time(), and the delta of a clock that is not read
+ *           stays 0. The timer hook is not called.
+ *****************************************************************************/
+void
+timer_start_clocks(timer_struct *t,
+                   bool          wall,
+                   bool          cpu)
+{
+    timer_init(t);
+
+    if (wall) {
+        t->start_wall = get_elapsed_time();
+    }
+    if (cpu) {
+        t->start_cpu = get_cpu_time();
+    }
 }
 
 /******************************************************************************
@@ -84,6 +146,28 @@ timer_stop(timer_struct *t)
 
     t->delta_wall += t->stop_wall - t->start_wall;
     t->delta_cpu += t->stop_cpu - t->start_cpu;
+
+    if (timer_hook != NULL) {
+        timer_hook(t, false);
+    }
+}
+
+/******************************************************************************
+ * @brief    Stop a timer started by timer_start_clocks()
+ *****************************************************************************/
+void
+timer_stop_clocks(timer_struct *t,
+                  bool          wall,
+                  bool          cpu)
+{
+    if (wall) {
+        t->stop_wall = get_elapsed_time();
+        t->delta_wall += t->stop_wall - t->start_wall;
+    }
+    if (cpu) {
+        t->stop_cpu = get_cpu_time();
+        t->delta_cpu += t->stop_cpu - t->start_cpu;
+    }
 }
 
 /******************************************************************************
@@ -94,4 +178,85 @@ timer_continue(timer_struct *t)
 {
     t->start_wall = get_wall_time();
     t->start_cpu = get_cpu_time();
+
+    if (timer_hook != NULL) {
+        timer_hook(t, true);
+    }
+}
+
+/******************************************************************************
+ * @brief    Collect the PERF_REGIONS counts of all threads of the process.
+ * @details  The counts of a thread are kept by the thread itself, so the
+ *           threads are started once more to hand them over.
+ *****************************************************************************/
+void
+collect_perf_regions(
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS])
+{
+    extern option_struct options;
+
+    memset(counts, 0, N_PERF_REGIONS * sizeof(*counts));
+
+    #pragma omp parallel num_threads(options.NTHREADS)
+    {
+        #pragma omp critical (collect_perf_regions)
+        perf_regions_collect(counts);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write the PERF_REGIONS counts to LOG_DEST.
+ * @details  The counts of a region include those of the regions nested in
+ *           it. IPC is the number of instructions per cycle, the miss rate
+ *           is the share of the cache references that missed the last level
+ *           cache.
+ *****************************************************************************/
+void
+write_perf_regions_table(
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS],
+    int                nprocs)
+{
+    extern FILE *LOG_DEST;
+
+    char        *region_names[N_PERF_REGIONS];
+    size_t       i;
+    double       ipc;
+    double       miss_rate;
+
+    region_names[PERF_SURFACE_FLUXES] = "Surface Fluxes";
+    region_names[PERF_SOLVE_SNOW] = "Solve Snow";
+    region_names[PERF_SURF_ENERGY_BAL] = "Surf Energy Bal";
+    region_names[PERF_RUNOFF] = "Runoff";
+    region_names[PERF_FROZEN_SOIL] = "Frozen Soil";
+    region_names[PERF_LAKES] = "Lakes";
+    region_names[PERF_CARBON] = "Carbon";
+
+    fprintf(LOG_DEST, "  Hardware Counter Table (summed over %d pes):\n",
+            nprocs);
+    fprintf(LOG_DEST,
+            "|-----------------|--------------|------------------|------------------|--------|------------------|-----------|\n");
+    fprintf(LOG_DEST,
+            "| Region          | Calls        | Cycles           | Instructions     | IPC    | Cache Misses     | Miss Rate |\n");
+    fprintf(LOG_DEST,
+            "|-----------------|--------------|------------------|------------------|--------|------------------|-----------|\n");
+    for (i = 0; i < N_PERF_REGIONS; i++) {
+        ipc = 0.;
+        if (counts[i][PERF_CYCLES] > 0) {
+            ipc = (double) counts[i][PERF_INSTRUCTIONS] /
+                  (double) counts[i][PERF_CYCLES];
+        }
+        miss_rate = 0.;
+        if (counts[i][PERF_CACHE_REFS] > 0) {
+            miss_rate = (double) counts[i][PERF_CACHE_MISSES] /
+                        (double) counts[i][PERF_CACHE_REFS];
+        }
+        fprintf(LOG_DEST, "| %-15s | %12llu | %16llu | %16llu | %6.2f | "
+                "%16llu | %8.2f%% |\n", region_names[i],
+                counts[i][PERF_CALLS], counts[i][PERF_CYCLES],
+                counts[i][PERF_INSTRUCTIONS], ipc,
+                counts[i][PERF_CACHE_MISSES], 100. * miss_rate);
+    }
+    fprintf(LOG_DEST,
+            "|-----------------|--------------|------------------|------------------|--------|------------------|-----------|\n");
+    fprintf(LOG_DEST, "\n");
 }
@@ -43,6 +43,7 @@ update_step_vars(all_vars_struct *all_vars,
     unsigned short       band;
     size_t               Nbands;
     veg_var_struct     **veg_var;
+    veg_hist_struct     *hist;
 
     /* set local pointers */
     veg_var = all_vars->veg_var;
@@ -52,14 +53,25 @@ update_step_vars(all_vars_struct *all_vars,
     /* Set number of vegetation types */
     Nveg = veg_con[0].vegetat_type_num;
 
-    /* Assign current veg characteristics */
+    /* Assign current veg characteristics. The bands of a tile are always
+       updated together, so band 0 tells whether the veg_hist values of the
+       step differ from the ones already assigned, which in runs with
+       climatological vegetation they only do when the month changes. */
     for (iveg = 0; iveg <= Nveg; iveg++) {
+        hist = &(veg_hist[iveg]);
+        if (veg_var[iveg][0].albedo == hist->albedo[NR] &&
+            veg_var[iveg][0].displacement == hist->displacement[NR] &&
+            veg_var[iveg][0].fcanopy == hist->fcanopy[NR] &&
+            veg_var[iveg][0].LAI == hist->LAI[NR] &&
+            veg_var[iveg][0].roughness == hist->roughness[NR]) {
+            continue;
+        }
         for (band = 0; band < Nbands; band++) {
-            veg_var[iveg][band].albedo = veg_hist[iveg].albedo[NR];
-            veg_var[iveg][band].displacement = veg_hist[iveg].displacement[NR];
-            veg_var[iveg][band].fcanopy = veg_hist[iveg].fcanopy[NR];
-            veg_var[iveg][band].LAI = veg_hist[iveg].LAI[NR];
-            veg_var[iveg][band].roughness = veg_hist[iveg].roughness[NR];
+            veg_var[iveg][band].albedo = hist->albedo[NR];
+            veg_var[iveg][band].displacement = hist->displacement[NR];
+            veg_var[iveg][band].fcanopy = hist->fcanopy[NR];
+            veg_var[iveg][band].LAI = hist->LAI[NR];
+            veg_var[iveg][band].roughness = hist->roughness[NR];
         }
     }
 
@@ -26,6 +26,16 @@
 
 #include <vic_driver_shared_all.h>
 
+// output variable groups requested by the streams, until set_outvar_groups()
+// is called all groups are computed
+static bool outvar_groups_set = false;
+static bool outvar_groups[N_OUT_GROUPS];
+// groups whose variables are only written as instantaneous values, and
+// whether they are sampled at the current time step, see
+// set_outvar_groups_step()
+static bool outvar_groups_snapshot[N_OUT_GROUPS];
+static bool outvar_groups_step[N_OUT_GROUPS];
+
 /******************************************************************************
  * @brief    This routine creates the list of output data.
  *****************************************************************************/
@@ -37,25 +47,32 @@ alloc_out_data(size_t     ngridcells,
 
     size_t                 i;
     size_t                 j;
-    size_t                 k;
+    size_t                 nelem;
+    double               **rows;
+    double                *values;
+
+    nelem = 0;
+    for (j = 0; j < N_OUTVAR_TYPES; j++) {
+        nelem += out_metadata[j].nelem;
+    }
 
     *out_data = calloc(ngridcells, sizeof(*(*out_data)));
     check_alloc_status(*out_data, "Memory allocation error.");
 
+    // the rows and the values of all cells are two contiguous blocks, the
+    // values of one cell stay together [shape=(ngridcells, nvars, nelem)]
+    rows = calloc(ngridcells * N_OUTVAR_TYPES, sizeof(*rows));
+    check_alloc_status(rows, "Memory allocation error.");
+    values = calloc(ngridcells * nelem, sizeof(*values));
+    check_alloc_status(values, "Memory allocation error.");
+
     for (i = 0; i < ngridcells; i++) {
-        (*out_data)[i] = calloc(N_OUTVAR_TYPES, sizeof(*((*out_data)[i])));
-        check_alloc_status((*out_data)[i], "Memory allocation error.");
-        // Allocate space for data
+        (*out_data)[i] = rows;
         for (j = 0; j < N_OUTVAR_TYPES; j++) {
-            (*out_data)[i][j] =
-                calloc(out_metadata[j].nelem, sizeof(*((*out_data)[i][j])));
-            check_alloc_status((*out_data)[i][j], "Memory allocation error.");
-
-            // initialize data member
-            for (k = 0; k < out_metadata[j].nelem; k++) {
-                (*out_data)[i][j][k] = 0;
-            }
+            (*out_data)[i][j] = values;
+            values += out_metadata[j].nelem;
         }
+        rows += N_OUTVAR_TYPES;
     }
 }
 
@@ -76,6 +93,26 @@ setup_stream(stream_struct *stream,
     stream->ngridcells = ngridcells;
     stream->file_format = UNSET_FILE_FORMAT;
     stream->compress = false;
+    stream->flush = FLUSH_ALWAYS;
+    stream->flush_n = 1;
+    stream->shuffle = true;
+    stream->chunk = CHUNK_DEFAULT;
+    for (i = 0; i < 3; i++) {
+        stream->chunk_n[i] = 0;
+    }
+    stream->chunk_cache = 0;
+    stream->buffer = NULL;
+    stream->buffer_size = 0;
+    stream->buffer_len = 0;
+    stream->record_size = 0;
+    stream->cascade_alarm = NULL;
+    stream->cascade_values = NULL;
+    stream->cascade_rows = NULL;
+    stream->mask[0] = '\0';
+    stream->cells = NULL;
+    stream->cell_data = NULL;
+    stream->region[0] = '\0';
+    stream->region_reduce = REGION_MEAN;
 
     // Initialize dmy_junk - this step is to avoid time-related error caused
     // by junk dmy; the date set here does not matter and will be overwritten
@@ -105,6 +142,12 @@ setup_stream(stream_struct *stream,
     stream->mult = calloc(nvars, sizeof(*(stream->mult)));
     check_alloc_status(stream->mult, "Memory allocation error.");
 
+    stream->digits = calloc(nvars, sizeof(*(stream->digits)));
+    check_alloc_status(stream->digits, "Memory allocation error.");
+
+    stream->aggparam = calloc(nvars, sizeof(*(stream->aggparam)));
+    check_alloc_status(stream->aggparam, "Memory allocation error.");
+
     // Question: do we have to dynamically allocate the length of each string
     stream->format = calloc(nvars, sizeof(*(stream->format)));
     check_alloc_status(stream->format, "Memory allocation error.");
@@ -134,7 +177,9 @@ validate_streams(stream_struct **streams)
 
     // validate stream settings
     for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
-        if ((*streams)[streamnum].ngridcells < 1) {
+        // a stream of selected cells may have none on a node
+        if ((*streams)[streamnum].ngridcells < 1 &&
+            (*streams)[streamnum].cells == NULL) {
             log_err("Number of gridcells in stream is less than 1");
         }
         if ((*streams)[streamnum].nvars < 1) {
@@ -162,11 +207,22 @@ validate_streams(stream_struct **streams)
             log_err("Stream agg_data array not allocated");
         }
     }
+
+    // only the output variable groups used by a stream are computed
+    set_outvar_groups(*streams);
+
+    // coarse streams are aggregated from the records of finer streams
+    set_stream_cascades(*streams);
 }
 
 /******************************************************************************
  * @brief   This routine allocates memory for the stream aggdata array.  The
             shape of this array is [ngridcells, nvars, nelems, nbins].
+ * @details aggdata points to the first bin of each value, which holds the
+            record that is written. The other bins of the aggregation types
+            with a state (e.g. the running mean of AGG_TYPE_VAR) are stored
+            after the records in aggvalues (aggbins), so that the records
+            of all variables stay contiguous.
  *****************************************************************************/
 void
 alloc_aggdata(stream_struct *stream)
@@ -177,29 +233,47 @@ alloc_aggdata(stream_struct *stream)
     size_t                 j;
     size_t                 k;
     size_t                 nelem;
+    size_t                 nbins;
+    size_t                 offset;
+    double              ***rows;
+    double               **elems;
+
+    nelem = 0;
+    nbins = 0;
+    for (j = 0; j < stream->nvars; j++) {
+        nelem += out_metadata[stream->varid[j]].nelem;
+        nbins += out_metadata[stream->varid[j]].nelem *
+                 (get_agg_type_nbins(stream->aggtype[j]) - 1);
+    }
+
+    stream->naggvalues = (nelem + nbins) * stream->ngridcells;
+    stream->aggvalues = calloc(stream->naggvalues + 1,
+                               sizeof(*(stream->aggvalues)));
+    check_alloc_status(stream->aggvalues, "Memory allocation error.");
+    stream->aggbins = stream->aggvalues + nelem * stream->ngridcells;
 
     stream->aggdata = calloc(stream->ngridcells, sizeof(*(stream->aggdata)));
     check_alloc_status(stream->aggdata, "Memory allocation error.");
+    rows = calloc(stream->ngridcells * stream->nvars, sizeof(*rows));
+    check_alloc_status(rows, "Memory allocation error.");
+    elems = calloc(stream->ngridcells * nelem, sizeof(*elems));
+    check_alloc_status(elems, "Memory allocation error.");
 
+    // aggdata indexes the values in aggvalues, where the cells of an
+    // element of a variable are contiguous
     for (i = 0; i < stream->ngridcells; i++) {
-        stream->aggdata[i] =
-            calloc(stream->nvars, sizeof(*(stream->aggdata[i])));
-        check_alloc_status(stream->aggdata[i], "Memory allocation error.");
+        stream->aggdata[i] = rows;
+        offset = 0;
         for (j = 0; j < stream->nvars; j++) {
-            nelem = out_metadata[stream->varid[j]].nelem;
-            stream->aggdata[i][j] =
-                calloc(nelem, sizeof(*(stream->aggdata[i][j])));
-            check_alloc_status(stream->aggdata[i][j],
-                               "Memory allocation error.");
-
-            for (k = 0; k < nelem; k++) {
-                // TODO: Also allocate for nbins, for now just setting to size 1
+            stream->aggdata[i][j] = elems;
+            for (k = 0; k < out_metadata[stream->varid[j]].nelem; k++) {
                 stream->aggdata[i][j][k] =
-                    calloc(1, sizeof(*(stream->aggdata[i][j][k])));
-                check_alloc_status(stream->aggdata[i][j][k],
-                                   "Memory allocation error.");
+                    &(stream->aggvalues[(offset + k) * stream->ngridcells + i]);
             }
+            offset += out_metadata[stream->varid[j]].nelem;
+            elems += out_metadata[stream->varid[j]].nelem;
         }
+        rows += stream->nvars;
     }
 }
 
@@ -210,25 +284,275 @@ void
 reset_stream(stream_struct *stream,
              dmy_struct    *dmy_current)
 {
-    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
-
-    size_t                 i;
-    size_t                 j;
-    size_t                 k;
-    size_t                 varid;
+    size_t i;
 
     // Reset alarm to next agg period
     reset_alarm(&(stream->agg_alarm), dmy_current);
 
-    // Set aggdata to zero
-    for (i = 0; i < stream->ngridcells; i++) {
-        for (j = 0; j < stream->nvars; j++) {
-            varid = stream->varid[j];
-            for (k = 0; k < out_metadata[varid].nelem; k++) {
-                stream->aggdata[i][j][k][0] = 0.;
+    // Set aggdata to zero, including the state of the aggregation
+    for (i = 0; i < stream->naggvalues; i++) {
+        stream->aggvalues[i] = 0.;
+    }
+}
+
+/******************************************************************************
+ * @brief   Return the group of an output variable
+ * @details Variables of the OUT_GROUP_BASE group are always computed by
+ *          put_data, since the water balance check and the saved storage
+ *          terms depend on them.
+ *****************************************************************************/
+unsigned short int
+get_outvar_group(unsigned int varid)
+{
+    switch (varid) {
+    // energy balance terms
+    case OUT_ADV_SENS:
+    case OUT_ADVECTION:
+    case OUT_ALBEDO:
+    case OUT_BARESOILT:
+    case OUT_DELTACC:
+    case OUT_DELTAH:
+    case OUT_ENERGY_ERROR:
+    case OUT_FDEPTH:
+    case OUT_FUSION:
+    case OUT_GRND_FLUX:
+    case OUT_IN_LONG:
+    case OUT_LATENT:
+    case OUT_LATENT_SUB:
+    case OUT_LWNET:
+    case OUT_MELT_ENERGY:
+    case OUT_R_NET:
+    case OUT_RAD_TEMP:
+    case OUT_REFREEZE:
+    case OUT_RFRZ_ENERGY:
+    case OUT_SENSIBLE:
+    case OUT_SNOW_FLUX:
+    case OUT_SNOWT_FBFLAG:
+    case OUT_SOIL_TNODE:
+    case OUT_SOIL_TNODE_WL:
+    case OUT_SOILT_FBFLAG:
+    case OUT_SURF_FROST_FRAC:
+    case OUT_SURF_TEMP:
+    case OUT_SURFT_FBFLAG:
+    case OUT_SWNET:
+    case OUT_TCAN_FBFLAG:
+    case OUT_TDEPTH:
+    case OUT_TFOL_FBFLAG:
+    case OUT_VEGT:
+        return OUT_GROUP_ENERGY;
+    // snow band terms
+    case OUT_ADV_SENS_BAND:
+    case OUT_ADVECTION_BAND:
+    case OUT_ALBEDO_BAND:
+    case OUT_DELTACC_BAND:
+    case OUT_GRND_FLUX_BAND:
+    case OUT_LATENT_BAND:
+    case OUT_LATENT_SUB_BAND:
+    case OUT_LWNET_BAND:
+    case OUT_MELT_ENERGY_BAND:
+    case OUT_RFRZ_ENERGY_BAND:
+    case OUT_SENSIBLE_BAND:
+    case OUT_SNOW_CANOPY_BAND:
+    case OUT_SNOW_COVER_BAND:
+    case OUT_SNOW_DEPTH_BAND:
+    case OUT_SNOW_FLUX_BAND:
+    case OUT_SNOW_MELT_BAND:
+    case OUT_SNOW_PACKT_BAND:
+    case OUT_SNOW_SURFT_BAND:
+    case OUT_SWE_BAND:
+    case OUT_SWNET_BAND:
+        return OUT_GROUP_BAND;
+    // carbon cycle terms
+    case OUT_APAR:
+    case OUT_CINTER:
+    case OUT_CLITTER:
+    case OUT_CSLOW:
+    case OUT_GPP:
+    case OUT_LITTERFALL:
+    case OUT_NEE:
+    case OUT_NPP:
+    case OUT_RAUT:
+    case OUT_RHET:
+        return OUT_GROUP_CARBON;
+    // lake terms
+    case OUT_LAKE_AREA_FRAC:
+    case OUT_LAKE_BF_IN:
+    case OUT_LAKE_BF_IN_V:
+    case OUT_LAKE_BF_OUT:
+    case OUT_LAKE_BF_OUT_V:
+    case OUT_LAKE_CHAN_IN_V:
+    case OUT_LAKE_CHAN_OUT:
+    case OUT_LAKE_CHAN_OUT_V:
+    case OUT_LAKE_DEPTH:
+    case OUT_LAKE_DSTOR:
+    case OUT_LAKE_DSTOR_V:
+    case OUT_LAKE_DSWE:
+    case OUT_LAKE_DSWE_V:
+    case OUT_LAKE_EVAP:
+    case OUT_LAKE_EVAP_V:
+    case OUT_LAKE_ICE:
+    case OUT_LAKE_ICE_FRACT:
+    case OUT_LAKE_ICE_HEIGHT:
+    case OUT_LAKE_ICE_TEMP:
+    case OUT_LAKE_MOIST:
+    case OUT_LAKE_PREC_V:
+    case OUT_LAKE_RCHRG:
+    case OUT_LAKE_RCHRG_V:
+    case OUT_LAKE_RO_IN:
+    case OUT_LAKE_RO_IN_V:
+    case OUT_LAKE_SURF_AREA:
+    case OUT_LAKE_SURF_TEMP:
+    case OUT_LAKE_SWE:
+    case OUT_LAKE_SWE_V:
+    case OUT_LAKE_VAPFLX:
+    case OUT_LAKE_VAPFLX_V:
+    case OUT_LAKE_VOLUME:
+        return OUT_GROUP_LAKE;
+    default:
+        return OUT_GROUP_BASE;
+    }
+}
+
+/******************************************************************************
+ * @brief   Set the output variable groups requested by the output streams
+ * @details OUT_GROUP_BALANCE is set if a stream writes OUT_WATER_ERROR or
+ *          OUT_ENERGY_ERROR, OUT_GROUP_TIME_WALL and OUT_GROUP_TIME_CPU if it
+ *          writes OUT_TIME_VICRUN_WALL or OUT_TIME_VICRUN_CPU. Also sets options.COMPUTE_ZWT, since the water table position is
+ *          only needed by the OUT_ZWT and OUT_ZWT_LUMPED outputs and by the
+ *          soil respiration of the carbon cycle.
+ *****************************************************************************/
+void
+set_outvar_groups(stream_struct *streams)
+{
+    extern option_struct options;
+
+    size_t               streamnum;
+    size_t               i;
+    unsigned int         varid;
+    unsigned short int   group;
+
+    for (i = 0; i < N_OUT_GROUPS; i++) {
+        outvar_groups[i] = false;
+        outvar_groups_step[i] = true;
+    }
+    outvar_groups[OUT_GROUP_BASE] = true;
+    options.COMPUTE_ZWT = options.CARBON;
+
+    // only the groups of put_data() that no other term depends on can be
+    // skipped between the samples of their streams
+    outvar_groups_snapshot[OUT_GROUP_BASE] = false;
+    outvar_groups_snapshot[OUT_GROUP_ENERGY] = true;
+    outvar_groups_snapshot[OUT_GROUP_BAND] = true;
+    outvar_groups_snapshot[OUT_GROUP_CARBON] = true;
+    outvar_groups_snapshot[OUT_GROUP_LAKE] = true;
+    outvar_groups_snapshot[OUT_GROUP_BALANCE] = false;
+    outvar_groups_snapshot[OUT_GROUP_TIME_WALL] = false;
+    outvar_groups_snapshot[OUT_GROUP_TIME_CPU] = false;
+
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        for (i = 0; i < streams[streamnum].nvars; i++) {
+            varid = streams[streamnum].varid[i];
+            group = get_outvar_group(varid);
+            outvar_groups[group] = true;
+            if (streams[streamnum].aggtype[i] != AGG_TYPE_BEG &&
+                streams[streamnum].aggtype[i] != AGG_TYPE_END) {
+                outvar_groups_snapshot[group] = false;
+            }
+            if (varid == OUT_ZWT || varid == OUT_ZWT_LUMPED) {
+                options.COMPUTE_ZWT = true;
+            }
+            if (varid == OUT_WATER_ERROR || varid == OUT_ENERGY_ERROR) {
+                outvar_groups[OUT_GROUP_BALANCE] = true;
+            }
+            if (varid == OUT_TIME_VICRUN_WALL) {
+                outvar_groups[OUT_GROUP_TIME_WALL] = true;
+            }
+            if (varid == OUT_TIME_VICRUN_CPU) {
+                outvar_groups[OUT_GROUP_TIME_CPU] = true;
             }
         }
     }
+    outvar_groups_set = true;
+}
+
+/******************************************************************************
+ * @brief   Set the output variable groups that are computed at a time step
+ * @details A group whose variables are all written as instantaneous values
+ *          (AGG_TYPE_BEG or AGG_TYPE_END) is only computed at the time steps
+ *          where one of its streams samples it, e.g. once a day for the end
+ *          of day states of a daily stream. Must be called before
+ *          put_data() and before the aggregation alarms of the streams are
+ *          advanced for the time step.
+ *****************************************************************************/
+void
+set_outvar_groups_step(stream_struct *streams,
+                       dmy_struct    *dmy_current)
+{
+    extern option_struct options;
+
+    size_t               streamnum;
+    size_t               i;
+    unsigned short int   group;
+    bool                 beg_step;
+    bool                 end_step;
+    alarm_struct         alarm;
+
+    if (!outvar_groups_set) {
+        return;
+    }
+
+    for (i = 0; i < N_OUT_GROUPS; i++) {
+        outvar_groups_step[i] = !outvar_groups_snapshot[i];
+    }
+
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        // the alarm as agg_stream_alarm() will advance it
+        alarm = streams[streamnum].agg_alarm;
+        beg_step = (alarm.count == 0);
+        alarm.count++;
+        end_step = raise_alarm(&alarm, dmy_current);
+
+        for (i = 0; i < streams[streamnum].nvars; i++) {
+            group = get_outvar_group(streams[streamnum].varid[i]);
+            if ((streams[streamnum].aggtype[i] == AGG_TYPE_BEG && beg_step) ||
+                (streams[streamnum].aggtype[i] == AGG_TYPE_END && end_step)) {
+                outvar_groups_step[group] = true;
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief   Return whether the variables of an output group are computed
+ *****************************************************************************/
+bool
+outvar_group_requested(unsigned short int group)
+{
+    if (!outvar_groups_set) {
+        return true;
+    }
+    return outvar_groups[group] && outvar_groups_step[group];
+}
+
+/******************************************************************************
+ * @brief   Number of bins of the aggregated values of an aggregation type.
+ * @details Bin 0 is the record. AGG_TYPE_VAR and AGG_TYPE_STDEV keep the sum
+            of squared deviations in it and the running mean (Welford) in
+            bin 1. AGG_TYPE_QUANTILE keeps the heights and the positions of
+            the inner markers of its P-square estimate in bins 1 to 8.
+ *****************************************************************************/
+size_t
+get_agg_type_nbins(unsigned short int aggtype)
+{
+    switch (aggtype) {
+    case AGG_TYPE_VAR:
+    case AGG_TYPE_STDEV:
+        return 2;
+    case AGG_TYPE_QUANTILE:
+        return 1 + AGG_QUANTILE_MARKERS + (AGG_QUANTILE_MARKERS - 2);
+    default:
+        return 1;
+    }
 }
 
 /******************************************************************************
@@ -324,6 +648,15 @@ get_default_outvar_aggtype(unsigned int varid)
     case OUT_SURFT_FBFLAG:
     case OUT_TCAN_FBFLAG:
     case OUT_TFOL_FBFLAG:
+    case OUT_SOLVER_BRENT_ITER:
+    case OUT_SOLVER_BRENT_FAIL:
+    case OUT_SOLVER_NEWT_RAPH_ITER:
+    case OUT_SOLVER_RUNOFF_STEPS:
+    case OUT_SOLVER_SNOW_MELT:
+    case OUT_SOLVER_LAKE_MIX_ITER:
+    case OUT_SOLVER_SNOW_STEPS:
+    case OUT_SOLVER_BRENT_RETRY:
+    case OUT_SOLVER_BAND_SOLVES:
         agg_type = AGG_TYPE_SUM;
         break;
     default:
@@ -404,28 +737,21 @@ set_output_var(stream_struct     *stream,
 void
 free_streams(stream_struct **streams)
 {
-    extern option_struct   options;
-    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+    extern option_struct options;
 
-    size_t                 streamnum;
-    size_t                 i;
-    size_t                 j;
-    size_t                 k;
-    size_t                 varid;
+    size_t               streamnum;
+    size_t               j;
 
     // free output streams
     for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
         // Free aggdata first
-        for (i = 0; i < (*streams)[streamnum].ngridcells; i++) {
-            for (j = 0; j < (*streams)[streamnum].nvars; j++) {
-                varid = (*streams)[streamnum].varid[j];
-                for (k = 0; k < out_metadata[varid].nelem; k++) {
-                    free((*streams)[streamnum].aggdata[i][j][k]);
-                }
-                free((*streams)[streamnum].aggdata[i][j]);
+        if ((*streams)[streamnum].ngridcells > 0) {
+            if ((*streams)[streamnum].nvars > 0) {
+                free((*streams)[streamnum].aggdata[0][0]);
             }
-            free((*streams)[streamnum].aggdata[i]);
+            free((*streams)[streamnum].aggdata[0]);
         }
+        free((*streams)[streamnum].aggvalues);
         for (j = 0; j < (*streams)[streamnum].nvars; j++) {
             free((*streams)[streamnum].format[j]);
         }
@@ -436,6 +762,12 @@ free_streams(stream_struct **streams)
         free((*streams)[streamnum].format);
         free((*streams)[streamnum].varid);
         free((*streams)[streamnum].aggtype);
+        free((*streams)[streamnum].aggparam);
+        free((*streams)[streamnum].digits);
+        free((*streams)[streamnum].buffer);
+        free((*streams)[streamnum].cascade_rows);
+        free((*streams)[streamnum].cells);
+        free((*streams)[streamnum].cell_data);
     }
     free(*streams);
 }
@@ -447,19 +779,14 @@ void
 free_out_data(size_t    ngridcells,
               double ***out_data)
 {
-    size_t i;
-    size_t j;
-
-
     if (out_data == NULL) {
         return;
     }
 
-    for (i = 0; i < ngridcells; i++) {
-        for (j = 0; j < N_OUTVAR_TYPES; j++) {
-            free(out_data[i][j]);
-        }
-        free(out_data[i]);
+    // the rows and values of all cells were allocated as two blocks
+    if (ngridcells > 0) {
+        free(out_data[0][0]);
+        free(out_data[0]);
     }
 
     free(out_data);
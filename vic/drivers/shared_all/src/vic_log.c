@@ -30,6 +30,157 @@
 
 #include <vic_driver_shared_all.h>
 
+static size_t log_repeat_suppressed = 0;
+
+// call sites of log_warn_repeat that have warned, for the summary at the end
+// of the run
+static struct {
+    const char *file;
+    int line;
+    size_t *count;
+} log_repeat_sites[MAX_LOG_SITES];
+static size_t log_repeat_nsites = 0;
+
+// name of the log file, to open it again with another buffer
+static char   log_filename[MAXSTRING] = "";
+
+/******************************************************************************
+ * @brief    Count a warning from a call site of log_warn_repeat.
+ *
+ * @return   true if the warning is to be printed, false if it has been printed
+ *           LOG_WARN_REPEAT times already.
+ *****************************************************************************/
+bool
+count_log_repeat(size_t     *count,
+                 const char *file,
+                 int         line)
+{
+    extern FILE *LOG_DEST;
+
+    size_t       n;
+
+    #pragma omp atomic capture
+    n = ++(*count);
+
+    if (n == 1) {
+        #pragma omp critical (log_repeat_sites)
+        {
+            if (log_repeat_nsites < MAX_LOG_SITES) {
+                log_repeat_sites[log_repeat_nsites].file = file;
+                log_repeat_sites[log_repeat_nsites].line = line;
+                log_repeat_sites[log_repeat_nsites].count = count;
+                log_repeat_nsites++;
+            }
+        }
+    }
+
+    if (LOG_WARN_REPEAT == 0) {
+        return true;
+    }
+    if (n > LOG_WARN_REPEAT) {
+        #pragma omp atomic
+        log_repeat_suppressed++;
+        return false;
+    }
+    if (n == LOG_WARN_REPEAT) {
+        fprintf(LOG_DEST, "[WARN] %s:%d: warning repeated %d times, further "
+                "occurrences are not printed\n", file, line, LOG_WARN_REPEAT);
+    }
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Get the number of call sites of log_warn_repeat that have warned.
+ *****************************************************************************/
+size_t
+get_log_repeat_nsites(void)
+{
+    return log_repeat_nsites;
+}
+
+/******************************************************************************
+ * @brief    Get a call site of log_warn_repeat and its number of warnings,
+ *           including the warnings that were not printed.
+ *
+ * @param    i     call site, 0 <= i < get_log_repeat_nsites()
+ * @param    file  source file of the call site
+ * @param    line  line of the call site
+ * @return   number of warnings from the call site
+ *****************************************************************************/
+size_t
+get_log_repeat_site(size_t       i,
+                    const char **file,
+                    int         *line)
+{
+    size_t n;
+
+    *file = log_repeat_sites[i].file;
+    *line = log_repeat_sites[i].line;
+    #pragma omp atomic read
+    n = *(log_repeat_sites[i].count);
+
+    return n;
+}
+
+/******************************************************************************
+ * @brief    Log the number of warnings of each call site of log_warn_repeat,
+ *           including the warnings that were not printed.
+ *****************************************************************************/
+void
+print_log_summary(void)
+{
+    extern FILE *LOG_DEST;
+
+    size_t       i;
+    size_t       n;
+    const char  *file;
+    int          line;
+
+    if (log_repeat_nsites == 0) {
+        return;
+    }
+
+    fprintf(LOG_DEST, "[WARN] Warnings by call site:\n");
+    fprintf(LOG_DEST, "\t%12s  %s\n", "Warnings", "Call site");
+    for (i = 0; i < log_repeat_nsites; i++) {
+        n = get_log_repeat_site(i, &file, &line);
+        fprintf(LOG_DEST, "\t%12zu  %s:%d\n", n, file, line);
+    }
+}
+
+/******************************************************************************
+ * @brief    Give the log file a buffer of another size.
+ *
+ * @details  The log file is written in blocks of the size of the buffer,
+ *           instead of the block size of the file system, and it is flushed
+ *           when the buffer is full and at the end of the run. The buffer
+ *           of a stream can only be set before its first output, so the log
+ *           file is closed and opened again for appending. Logging to
+ *           stdout or stderr is not changed.
+ *
+ * @param    size    size of the buffer in bytes
+ * @param    logfile log file opened by setup_logging()
+ *****************************************************************************/
+void
+buffer_logging(size_t size,
+               FILE **logfile)
+{
+    extern FILE *LOG_DEST;
+
+    if (size == 0 || LOG_DEST == stdout || LOG_DEST == stderr ||
+        strlen(log_filename) == 0) {
+        return;
+    }
+
+    fclose(LOG_DEST);
+    *logfile = open_file(log_filename, "a");
+    LOG_DEST = *logfile;
+    if (setvbuf(LOG_DEST, NULL, _IOFBF, size) != 0) {
+        log_warn("The buffer of the log file could not be set to %zu bytes",
+                 size);
+    }
+}
+
 /******************************************************************************
  * @brief    Finalize logging - called after all logging is completed
  *****************************************************************************/
@@ -38,6 +189,11 @@ finalize_logging(void)
 {
     extern FILE *LOG_DEST;
 
+    if (log_repeat_suppressed > 0) {
+        log_warn("%zu repeated warnings were not printed, see "
+                 "LOG_WARN_REPEAT", log_repeat_suppressed);
+    }
+
     if (!(LOG_DEST == stdout || LOG_DEST == stderr)) {
         fclose(LOG_DEST);
         LOG_DEST = stderr;
@@ -122,12 +278,16 @@ setup_logging(int    id,
     if (strcmp(log_path, "MISSING") != 0) {
         // Create logfile name
         get_logname(log_path, id, logfilename);
+        strcpy(log_filename, logfilename);
 
         // Open Logfile
         *logfile = open_file(logfilename, "w");
 
-        // Print log file name to stderr
-        log_info("Initialized Log File: %s", logfilename);
+        // Print log file name to stderr, from the first process only when
+        // every process has its own log file
+        if (id == MISSING || id == 0) {
+            log_info("Initialized Log File: %s", logfilename);
+        }
 
         // Set Log Destination
         LOG_DEST = *logfile;
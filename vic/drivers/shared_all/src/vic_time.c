@@ -911,6 +911,232 @@ dmy_equal(dmy_struct *a,
     return false;
 }
 
+/******************************************************************************
+ * @brief   Integer day number of the date in a dmy structure.
+ * @return  Day number, consecutive days have consecutive numbers.
+ * @note    For the julian, standard, gregorian and proleptic_gregorian
+ *          calendars this is the Julian Day Number (the Julian Day at noon of
+ *          the date). For the other calendars days are counted from the first
+ *          day of year 0. Only integer operations are used, so the numbers
+ *          are exact, unlike those of date2num.
+ *****************************************************************************/
+long
+day_number_from_dmy(dmy_struct        *dmy,
+                    unsigned short int calendar)
+{
+    static const unsigned short int cumdays[MONTHS_PER_YEAR] = {
+        0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+    };
+    static const unsigned short int cumdays_leap[MONTHS_PER_YEAR] = {
+        0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335
+    };
+    long                            a, y, m;
+    bool                            gregorian;
+
+    if (calendar == CALENDAR_JULIAN ||
+        calendar == CALENDAR_STANDARD ||
+        calendar == CALENDAR_GREGORIAN ||
+        calendar == CALENDAR_PROLEPTIC_GREGORIAN) {
+        gregorian = true;
+        if (calendar == CALENDAR_JULIAN) {
+            gregorian = false;
+        }
+        else if (calendar == CALENDAR_STANDARD ||
+                 calendar == CALENDAR_GREGORIAN) {
+            // The Gregorian calendar starts on 1582-10-15
+            a = (long) dmy->year * 10000 + dmy->month * 100 + dmy->day;
+            if (a < 15821015) {
+                if (a >= 15821005) {
+                    log_err("impossible date (falls in gap between end of "
+                            "Julian calendar and beginning of Gregorian "
+                            "calendar");
+                }
+                gregorian = false;
+            }
+        }
+        a = (14 - dmy->month) / MONTHS_PER_YEAR;
+        y = (long) dmy->year + 4800 - a;
+        m = dmy->month + MONTHS_PER_YEAR * a - 3;
+        if (gregorian) {
+            return dmy->day + (153 * m + 2) / 5 + 365 * y + y / 4 - y / 100 +
+                   y / 400 - 32045;
+        }
+        return dmy->day + (153 * m + 2) / 5 + 365 * y + y / 4 - 32083;
+    }
+    else if (calendar == CALENDAR_NOLEAP || calendar == CALENDAR_365_DAY) {
+        return (long) dmy->year * DAYS_PER_YEAR + cumdays[dmy->month - 1] +
+               dmy->day - 1;
+    }
+    else if (calendar == CALENDAR_ALL_LEAP || calendar == CALENDAR_366_DAY) {
+        return (long) dmy->year * DAYS_PER_LYEAR +
+               cumdays_leap[dmy->month - 1] + dmy->day - 1;
+    }
+    else if (calendar == CALENDAR_360_DAY) {
+        return (long) dmy->year * DAYS_PER_360DAY_YEAR +
+               (dmy->month - 1) * 30 + dmy->day - 1;
+    }
+    else {
+        log_err("Unknown Calendar Flag: %hu", calendar);
+    }
+}
+
+/******************************************************************************
+ * @brief   Set the date of a dmy structure from a day number.
+ * @note    This is the inverse of day_number_from_dmy. The dayseconds of the
+ *          dmy structure are not changed.
+ *****************************************************************************/
+void
+dmy_from_day_number(long               day_number,
+                    unsigned short int calendar,
+                    dmy_struct        *dmy)
+{
+    static const unsigned short int cumdays[MONTHS_PER_YEAR] = {
+        0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+    };
+    static const unsigned short int cumdays_leap[MONTHS_PER_YEAR] = {
+        0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335
+    };
+    const unsigned short int       *cum;
+    long                            f, e, h, ndays;
+    unsigned short int              month;
+
+    if (calendar == CALENDAR_JULIAN ||
+        calendar == CALENDAR_STANDARD ||
+        calendar == CALENDAR_GREGORIAN ||
+        calendar == CALENDAR_PROLEPTIC_GREGORIAN) {
+        // Richards, E. G. (2013) Calendars. In: Explanatory Supplement to
+        // the Astronomical Almanac (3rd Edition). p. 617
+        f = day_number + 1401;
+        if (calendar == CALENDAR_PROLEPTIC_GREGORIAN ||
+            (calendar != CALENDAR_JULIAN && day_number >= 2299161)) {
+            f += (((4 * day_number + 274277) / 146097) * 3) / 4 - 38;
+        }
+        e = 4 * f + 3;
+        h = 5 * ((e % 1461) / 4) + 2;
+        dmy->day = (h % 153) / 5 + 1;
+        dmy->month = ((h / 153 + 2) % MONTHS_PER_YEAR) + 1;
+        dmy->year = e / 1461 - 4716 + (MONTHS_PER_YEAR + 2 - dmy->month) /
+                    MONTHS_PER_YEAR;
+        dmy->day_in_year = cumdays[dmy->month - 1] + dmy->day;
+        if (dmy->month > 2 && leap_year(dmy->year, calendar)) {
+            dmy->day_in_year += 1;
+        }
+        return;
+    }
+    else if (calendar == CALENDAR_NOLEAP || calendar == CALENDAR_365_DAY) {
+        ndays = DAYS_PER_YEAR;
+        cum = cumdays;
+    }
+    else if (calendar == CALENDAR_ALL_LEAP || calendar == CALENDAR_366_DAY) {
+        ndays = DAYS_PER_LYEAR;
+        cum = cumdays_leap;
+    }
+    else if (calendar == CALENDAR_360_DAY) {
+        dmy->year = day_number / DAYS_PER_360DAY_YEAR;
+        dmy->day_in_year = day_number % DAYS_PER_360DAY_YEAR + 1;
+        dmy->month = (dmy->day_in_year - 1) / 30 + 1;
+        dmy->day = dmy->day_in_year - (dmy->month - 1) * 30;
+        return;
+    }
+    else {
+        log_err("Unknown Calendar Flag: %hu", calendar);
+    }
+
+    dmy->year = day_number / ndays;
+    dmy->day_in_year = day_number % ndays + 1;
+    month = 1;
+    while (month < MONTHS_PER_YEAR && cum[month] < dmy->day_in_year) {
+        month++;
+    }
+    dmy->month = month;
+    dmy->day = dmy->day_in_year - cum[month - 1];
+}
+
+/******************************************************************************
+ * @brief   Add a number of seconds to the time in a dmy structure.
+ * @note    result may point to dmy.
+ *****************************************************************************/
+void
+dmy_add_seconds(dmy_struct        *dmy,
+                long long          seconds,
+                unsigned short int calendar,
+                dmy_struct        *result)
+{
+    long long days;
+    long long dayseconds;
+
+    dayseconds = (long long) dmy->dayseconds + seconds;
+    days = dayseconds / SEC_PER_DAY;
+    dayseconds %= SEC_PER_DAY;
+    if (dayseconds < 0) {
+        dayseconds += SEC_PER_DAY;
+        days--;
+    }
+
+    if (days != 0) {
+        dmy_from_day_number(day_number_from_dmy(dmy, calendar) + (long) days,
+                            calendar, result);
+    }
+    else if (result != dmy) {
+        *result = *dmy;
+    }
+    result->dayseconds = (unsigned int) dayseconds;
+}
+
+/******************************************************************************
+ * @brief   Add a number of months to the date in a dmy structure.
+ * @return  0 if ok, the return value of invalid_date if the day does not exist
+ *          in the new month (e.g. Feb 30).
+ * @note    result may point to dmy.
+ *****************************************************************************/
+int
+dmy_add_months(dmy_struct        *dmy,
+               int                n,
+               unsigned short int calendar,
+               dmy_struct        *result)
+{
+    int months;
+    int status;
+
+    months = (int) dmy->month - 1 + n;
+    *result = *dmy;
+    result->year = dmy->year + months / MONTHS_PER_YEAR;
+    result->month = months % MONTHS_PER_YEAR + 1;
+    // day_in_year is set below, give it a valid value for the check
+    result->day_in_year = 1;
+    status = invalid_date(calendar, result);
+    if (status != 0) {
+        return status;
+    }
+    dmy_from_day_number(day_number_from_dmy(result, calendar), calendar,
+                        result);
+    return 0;
+}
+
+/******************************************************************************
+ * @brief   Get the time of a model time step.
+ * @note    The time is computed directly from the start time of the
+ *          simulation, there is no need to have the times of the earlier
+ *          time steps.
+ *****************************************************************************/
+void
+dmy_from_step(global_param_struct *global,
+              size_t               step,
+              dmy_struct          *dmy)
+{
+    long long seconds;
+
+    dmy->year = global->startyear;
+    dmy->month = global->startmonth;
+    dmy->day = global->startday;
+
+    seconds = (long long) global->startsec +
+              (long long) step * (long long) global->dt;
+    dmy_from_day_number(day_number_from_dmy(dmy, global->calendar) +
+                        (long) (seconds / SEC_PER_DAY), global->calendar, dmy);
+    dmy->dayseconds = (unsigned int) (seconds % SEC_PER_DAY);
+}
+
 /******************************************************************************
  * @brief  convert a string representation of a date/time to a dmy_struct
  *****************************************************************************/
@@ -31,9 +31,45 @@
 #include <vic_image_log.h>
 #include <vic_mpi.h>
 
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/resource.h>
 #include <netcdf.h>
+#include <netcdf_meta.h>
+
+// netCDF with parallel I/O support (netCDF-4/HDF5 and/or PnetCDF)
+#if defined(NC_HAS_PARALLEL) && NC_HAS_PARALLEL
+#include <netcdf_par.h>
+#define VIC_PARALLEL_IO
+#endif
+
+#ifdef VIC_ADIOS2
+#include <adios2_c.h>
+#endif
+
+#ifdef VIC_DIRECT_CHUNK
+#include <hdf5.h>
+#endif
 
 #define MAXDIMS 10
+#define MAX_NC_FILE_CACHE 8
+#define MAX_NC_META_CACHE 64
+#define MAX_ASYNC_RECORDS 4
+#define STATE_FAST_MAGIC "VICFAST"
+#define STATE_FAST_VERSION 3
+#define MAX_STATE_FAST_DEPTH 100
+#define PARAM_CACHE_MAGIC "VICPARM"
+#define PARAM_CACHE_VERSION 1
+#define STREAM_STATE_MAGIC "VICSTRM"
+#define STREAM_STATE_VERSION 1
+#define MAX_RUN_BLOCK 32
+#define RUN_BLOCKS_PER_THREAD 16
+#define TRACE_RING_SIZE 65536  /**< events kept per thread with TRACE_FILE */
+#define MAX_HISTORY_DIGITS 15  /**< significant digits of a double */
+#define HISTORY_COPY_SIZE 1048576  /**< bytes copied at once from the
+                                      template of the history files */
+#define REGION_EXACT_NWORDS 67  /**< 32-bit digits of an exact sum of
+                                      doubles with REPRODUCIBLE */
 
 /******************************************************************************
  * @brief   NetCDF file types
@@ -42,8 +78,100 @@ enum
 {
     NC_HISTORY_FILE,
     NC_STATE_FILE,
+    NC_COST_MAP_FILE,
+    NC_STREAMFLOW_FILE,
+};
+
+/******************************************************************************
+ * @brief   Points of the run at which the memory high-water mark of a process
+ *          is sampled, see sample_vic_memory()
+ *****************************************************************************/
+enum
+{
+    MEMORY_AT_INIT,      /**< end of the initialization */
+    MEMORY_AT_FORCE,     /**< after reading the forcings */
+    MEMORY_AT_RUN,       /**< after vic_run, put_data and the aggregation */
+    MEMORY_AT_WRITE,     /**< after writing the history files */
+    MEMORY_AT_STATE,     /**< after writing a state file */
+    MEMORY_AT_FINAL,     /**< end of the finalization */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_MEMORY_SAMPLES     /**< used as a loop counter*/
+};
+
+/******************************************************************************
+ * @brief   I/O phases whose bytes are counted for the I/O table of the
+ *          timing table
+ *****************************************************************************/
+enum
+{
+    IO_PHASE_FORCE,      /**< forcing fields read */
+    IO_PHASE_HIST,       /**< history records written */
+    IO_PHASE_STATE,      /**< state files written */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_IO_PHASES          /**< used as a loop counter*/
 };
 
+/******************************************************************************
+ * @brief   Major allocations of a process, whose sizes are estimated in the
+ *          timing table
+ *****************************************************************************/
+enum
+{
+    MEMORY_ALL_VARS,
+    MEMORY_OUT_DATA,
+    MEMORY_AGGDATA,
+    MEMORY_VEG_LIB,
+    MEMORY_FORCE,
+    MEMORY_SOIL_CON,
+    MEMORY_IO_BUFFERS,   /**< gather and scatter buffers of the netCDF I/O */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_MEMORY_ITEMS       /**< used as a loop counter*/
+};
+
+/******************************************************************************
+ * @brief   Events of the event trace, see TRACE_FILE
+ * @details The phases of the time steps are traced through the global timers
+ *          of the same name.
+ *****************************************************************************/
+enum
+{
+    TRACE_INIT,            /**< initialization */
+    TRACE_INIT_START,      /**< global parameters and domain */
+    TRACE_INIT_ALLOC,      /**< vic_alloc */
+    TRACE_INIT_PARAMS,     /**< parameter files */
+    TRACE_INIT_STATE,      /**< model state */
+    TRACE_INIT_OUTPUT,     /**< output structures */
+    TRACE_INIT_IO_SERVERS, /**< I/O servers */
+    TRACE_RUN,             /**< time loop */
+    TRACE_FINAL,           /**< finalization */
+    TRACE_TIME_STEP,       /**< one time step */
+    TRACE_FORCE_READ,      /**< reading the forcings */
+    TRACE_FORCE_PREFETCH,  /**< reading the forcings on the reader thread */
+    TRACE_FORCE_SCATTER,   /**< scattering the forcings */
+    TRACE_CELLS,           /**< vic_run and put_data of the cells of a
+                                thread */
+    TRACE_AGG,             /**< aggregation of the output streams */
+    TRACE_HIST_GATHER,     /**< gathering the history records */
+    TRACE_HIST_WRITE,      /**< writing the history files */
+    TRACE_STATE_WRITE,     /**< writing the state files */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_TRACE_EVENTS         /**< used as a loop counter*/
+};
+
+/******************************************************************************
+ * @brief    A completed event of the event trace.
+ *****************************************************************************/
+typedef struct {
+    int event;     /**< TRACE_* */
+    int thread;    /**< thread of the process */
+    double start;  /**< wall time at the start (seconds) */
+    double end;    /**< wall time at the end (seconds) */
+} trace_event_struct;
+
 /******************************************************************************
  * @brief    Structure to store location information for individual grid cells.
  * @details  The global and local indices show the position of the grid cell
@@ -90,6 +218,34 @@ typedef struct {
     domain_info_struct info; /**< structure storing domain file info */
 } domain_struct;
 
+/******************************************************************************
+ * @brief    Direct chunk writes of a compressed history variable
+ *           (COMPRESS_THREADS > 0).
+ * @details  The chunks of a record are deflated on several threads of the
+ *           master node and written to the HDF5 dataset of the variable with
+ *           H5Dwrite_chunk, instead of being compressed one after the other
+ *           by the netCDF library.
+ *****************************************************************************/
+typedef struct {
+#ifdef VIC_DIRECT_CHUNK
+    hid_t dset_id;               /**< dataset of the variable */
+#endif
+    bool active;                 /**< TRUE: the records of the variable are
+                                    written with direct chunk writes */
+    size_t ndims;                /**< number of dimensions, time first */
+    size_t shape[MAXDIMS];       /**< extent of a record */
+    size_t chunk[MAXDIMS];       /**< chunk shape, 1 along time */
+    size_t nchunks;              /**< number of chunks of a record */
+    size_t type_size;            /**< bytes per value */
+    bool shuffle;                /**< TRUE: the bytes are shuffled before
+                                    they are deflated */
+    int level;                   /**< deflate level */
+    char *zbuf;                  /**< compressed chunks of a record */
+    size_t zbound;               /**< bytes of zbuf per chunk */
+    size_t *zsize;               /**< compressed bytes of each chunk
+                                    [nchunks] */
+} direct_chunk_var_struct;
+
 /******************************************************************************
  * @brief    Structure for netcdf variable information
  *****************************************************************************/
@@ -99,8 +255,209 @@ typedef struct {
     int nc_dimids[MAXDIMS];         /**< ids of dimensions */
     size_t nc_counts[MAXDIMS];      /**< size of dimid */
     size_t nc_dims;                 /**< number of dimensions */
+    size_t io_start[MAXDIMS];       /**< start of the pending write */
+    size_t io_count[MAXDIMS];       /**< count of the pending write */
+    direct_chunk_var_struct direct; /**< direct chunk writes */
 } nc_var_struct;
 
+/******************************************************************************
+ * @brief    Field in a gather or scatter request.
+ * @details  var holds nslices consecutive 2-D slices on the local node, i.e.
+ *           var[j * ncells + i] holds slice j of local cell i, where ncells
+ *           is the number of active cells on the local node. The product of
+ *           the leading (non-spatial) counts of the hyperslab must equal
+ *           nslices.
+ *****************************************************************************/
+typedef struct {
+    int nc_id;                   /**< file to write to (gather) */
+    int nc_varid;                /**< variable to write to (gather) */
+    char *nc_name;               /**< file to read from (scatter) */
+    char *var_name;              /**< variable to read from (scatter) */
+    int nc_type;                 /**< type of var: NC_DOUBLE, NC_FLOAT,
+                                    NC_INT, NC_SHORT or NC_CHAR */
+    double fillval;              /**< value of the cells that are not active
+                                    (gather) */
+    size_t nslices;              /**< number of 2-D slices */
+    size_t *start;               /**< start of the hyperslab */
+    size_t *count;               /**< count of the hyperslab */
+    void *grid;                  /**< values on the full grid on the master
+                                    node, read from file if NULL (scatter) */
+    bool land;                   /**< TRUE: the active cells are written
+                                    along a land dimension instead of the
+                                    full grid (gather) */
+    void *var;                   /**< values of the local cells */
+} nc_io_field_struct;
+
+/******************************************************************************
+ * @brief    Selected cells of a gather request.
+ * @details  Each node sends the values of its selected cells only. The master
+ *           node writes them along the land dimension, in the order of the
+ *           active cells of the domain.
+ *****************************************************************************/
+typedef struct {
+    size_t ncells;               /**< selected cells of the local node */
+    size_t ncells_total;         /**< selected cells of all nodes */
+    int *node_ncells;            /**< selected cells per node (master node)
+                                    [mpi_size] */
+    int *node_offsets;           /**< first selected cell of each node in the
+                                    gathered values (master node)
+                                    [mpi_size] */
+    size_t *map;                 /**< position along the land dimension of
+                                    each gathered value (master node)
+                                    [ncells_total] */
+    size_t *grid_cells;          /**< grid index of each position along the
+                                    land dimension (master node)
+                                    [ncells_total] */
+} nc_io_subset_struct;
+
+/******************************************************************************
+ * @brief    Regions of a region stream.
+ * @details  The aggregated values of the cells of each region are reduced to
+ *           their area weighted sum or mean, and only the values of the
+ *           regions are sent to the master node.
+ *****************************************************************************/
+typedef struct {
+    size_t nregions;             /**< number of regions */
+    int *ids;                    /**< region IDs in ascending order
+                                    [nregions] */
+    size_t *cell_region;         /**< region of each selected cell
+                                    [ncells] */
+    double *cell_area;           /**< area of each selected cell (m2)
+                                    [ncells] */
+    double *area;                /**< area of each region (m2, master node)
+                                    [nregions] */
+    double *sums;                /**< area weighted sums of the local cells,
+                                    with REPRODUCIBLE the sums of the
+                                    values that are not finite only
+                                    [nelem * nregions] */
+    int64_t *exact;              /**< exact area weighted sums of the local
+                                    cells, to 2^-1074 (REPRODUCIBLE only)
+                                    [nelem * nregions * REGION_EXACT_NWORDS] */
+    double *values;              /**< reduced values of a record (master
+                                    node) [nelem * nregions] */
+} nc_region_struct;
+
+/******************************************************************************
+ * @brief    Publisher of a stream with OUT_FORMAT ADIOS2_SST or ADIOS2_BP5.
+ * @details  Every node publishes the values of its own cells as a block of
+ *           each variable, together with the grid index and coordinates of
+ *           the cells.
+ *****************************************************************************/
+typedef struct {
+#ifdef VIC_ADIOS2
+    adios2_io *io;               /**< IO of the stream */
+    adios2_engine *engine;       /**< SST or BP5 engine of the stream */
+    adios2_variable **vars;      /**< output variables [nvars] */
+    adios2_variable *cell_var;   /**< grid index of the cells */
+    adios2_variable *lat_var;    /**< latitude of the cells */
+    adios2_variable *lon_var;    /**< longitude of the cells */
+    adios2_variable *time_var;   /**< time of the record (master node) */
+    adios2_variable *time_bounds_var; /**< time bounds of the record (master
+                                         node) */
+#endif
+    int *cells;                  /**< grid index of the local cells
+                                    [ngridcells] */
+    double *lat;                 /**< latitude of the local cells
+                                    [ngridcells] */
+    double *lon;                 /**< longitude of the local cells
+                                    [ngridcells] */
+} adios2_stream_struct;
+
+/******************************************************************************
+ * @brief    Gather or scatter request of a list of fields.
+ * @details  All fields travel in a single non-blocking collective. The
+ *           buffers are kept between requests and only grow.
+ *****************************************************************************/
+typedef struct {
+    bool pending;                /**< TRUE: the request is not completed */
+    bool gather;                 /**< TRUE: gather and write, FALSE: read and
+                                    scatter */
+    size_t nfields;              /**< number of fields */
+    size_t maxfields;            /**< allocated number of fields */
+    nc_io_field_struct *fields;  /**< copy of the fields */
+    size_t nbytes;               /**< bytes per cell of all fields */
+    mpi_io_buffer_struct sendbuf; /**< packed values to send */
+    mpi_io_buffer_struct recvbuf; /**< packed values received */
+    int *counts;                 /**< bytes per node (master node) */
+    int *displs;                 /**< displacement per node (master node) */
+    mpi_io_buffer_struct nodebuf; /**< values of the compute node (node
+                                     leader, HIERARCHICAL_IO) */
+    int *node_counts;            /**< bytes per process of the compute node
+                                    (node leader, HIERARCHICAL_IO) */
+    int *node_displs;            /**< displacement per process of the compute
+                                    node (node leader, HIERARCHICAL_IO) */
+    int *leader_counts;          /**< bytes per compute node (master node,
+                                    HIERARCHICAL_IO) */
+    int *leader_displs;          /**< displacement per compute node (master
+                                    node, HIERARCHICAL_IO) */
+    nc_io_subset_struct *subset; /**< selected cells of a gather, NULL = all
+                                    active cells */
+    nc_var_struct *nc_vars;      /**< variables of the fields, whose records
+                                    may be written with direct chunk writes
+                                    (master node), NULL = all fields are
+                                    written by the netCDF library */
+    MPI_Request mpi_request;     /**< request of the collective */
+    timer_struct *mpi_timer;     /**< accumulates the time of the collective,
+                                    if not NULL */
+    timer_struct *io_timer;      /**< accumulates the time of the netCDF
+                                    reads or writes, if not NULL */
+} nc_io_request_struct;
+
+/******************************************************************************
+ * @brief    Two-level layout of the gather and scatter functions when
+ *           HIERARCHICAL_IO is TRUE.
+ * @details  The values of the processes of a compute node are collected on
+ *           the first process of the node (the node leader) through shared
+ *           memory, and only the node leaders exchange values with the
+ *           master node.
+ *****************************************************************************/
+typedef struct {
+    MPI_Comm node_comm;          /**< processes of the compute node */
+    MPI_Comm leader_comm;        /**< node leaders; MPI_COMM_NULL on the
+                                    other processes */
+    int node_size;               /**< number of processes of the compute
+                                    node */
+    int *node_ncells;            /**< cells per process of the compute node
+                                    (node leader) [node_size] */
+    int node_ncells_total;       /**< cells of the compute node (node
+                                    leader) */
+    int nleaders;                /**< number of node leaders (master node) */
+    int *leader_ncells;          /**< cells per compute node (master node)
+                                    [nleaders] */
+    int *order;                  /**< processes in the order of the values
+                                    received by the master node [mpi_size] */
+} node_io_struct;
+
+/******************************************************************************
+ * @brief    Groups of processes that write their own history files when
+ *           OUT_SPLIT > 0.
+ * @details  Each group of OUT_SPLIT consecutive processes gathers the values
+ *           of its cells on its first process (the group leader), which
+ *           writes them to the history file of the group along a land
+ *           dimension.
+ *****************************************************************************/
+typedef struct {
+    MPI_Comm comm;               /**< processes of the group */
+    int rank;                    /**< rank in the group, 0 = group leader */
+    int group;                   /**< index of the group */
+    int ngroups;                 /**< number of groups */
+    size_t ncells_total;         /**< cells of the group */
+    int *counts;                 /**< cells per process of the group (group
+                                    leader) [group size] */
+    int *displs;                 /**< first cell of each process of the
+                                    group (group leader) [group size] */
+    int *grid_cells;             /**< grid index of the cells of the group
+                                    (group leader) [ncells_total] */
+    int *byte_counts;            /**< bytes per process of a record (group
+                                    leader) [group size] */
+    int *byte_displs;            /**< displacement per process of a record
+                                    (group leader) [group size] */
+    mpi_io_buffer_struct recvbuf; /**< values of a record received (group
+                                     leader) */
+    mpi_io_buffer_struct gridbuf; /**< values of a field along the land
+                                     dimension (group leader) */
+} split_io_struct;
+
 /******************************************************************************
  * @brief    Structure for netcdf file information. Initially to store
  *           information for the output files (state and history)
@@ -116,6 +473,7 @@ typedef struct {
     int front_dimid;
     int frost_dimid;
     int lake_node_dimid;
+    int land_dimid;
     int layer_dimid;
     int ni_dimid;
     int nj_dimid;
@@ -130,6 +488,9 @@ typedef struct {
     size_t front_size;
     size_t frost_size;
     size_t lake_node_size;
+    size_t land_size;            /**< number of active (or selected) cells
+                                    if the grid is compressed to a land
+                                    dimension, else 0 */
     size_t layer_size;
     size_t ni_size;
     size_t nj_size;
@@ -138,9 +499,304 @@ typedef struct {
     size_t time_size;
     size_t veg_size;
     bool open;
+    bool parallel;
+    bool split;                /**< TRUE: history file of the group of the
+                                  process (OUT_SPLIT) */
+    char template_file[MAXSTRING]; /**< template of the history files of the
+                                      stream, empty if none */
+    unsigned int flush_count;  /**< records written since the last sync */
+    double flush_time;         /**< wall clock time of the last sync */
     nc_var_struct *nc_vars;
+    nc_io_field_struct *io_fields;   /**< fields of a record */
+    nc_io_request_struct io_request; /**< pending write of a record */
+    nc_io_subset_struct subset;      /**< selected cells of a stream with
+                                        OUTMASK */
+    nc_region_struct region;         /**< regions of a stream with
+                                        OUTREGION */
+    adios2_stream_struct publisher;  /**< publisher of a stream with
+                                        OUT_FORMAT ADIOS2_SST or
+                                        ADIOS2_BP5 */
+#ifdef VIC_DIRECT_CHUNK
+    hid_t h5_id;                     /**< HDF5 handle of the open file for
+                                        direct chunk writes */
+#endif
+    bool direct;                     /**< TRUE: the file is open for direct
+                                        chunk writes */
 } nc_file_struct;
 
+/******************************************************************************
+ * @brief    Metadata of a variable of a netCDF input file.
+ *****************************************************************************/
+typedef struct {
+    char name[NC_MAX_NAME + 1]; /**< variable name */
+    int nc_id;                  /**< netCDF id of the open file */
+    int var_id;                 /**< variable id */
+    nc_type xtype;              /**< variable type */
+    int ndims;                  /**< number of dimensions */
+} nc_var_meta_struct;
+
+/******************************************************************************
+ * @brief    Metadata of a dimension of a netCDF input file.
+ *****************************************************************************/
+typedef struct {
+    char name[NC_MAX_NAME + 1]; /**< dimension name */
+    size_t len;                 /**< dimension length */
+} nc_dim_meta_struct;
+
+/******************************************************************************
+ * @brief    Structure for an entry in the cache of open netCDF input files.
+ *****************************************************************************/
+typedef struct {
+    char name[MAXSTRING]; /**< file name */
+    int nc_id;            /**< netCDF id of the open file */
+    bool open;            /**< TRUE: file is open */
+    size_t nvars;         /**< number of variables queried */
+    nc_var_meta_struct vars[MAX_NC_META_CACHE]; /**< variables queried */
+    size_t ndims;         /**< number of dimensions queried */
+    nc_dim_meta_struct dims[MAX_NC_META_CACHE]; /**< dimensions queried */
+} nc_file_cache_struct;
+
+/******************************************************************************
+ * @brief    Header of the stream state file of one process.
+ *****************************************************************************/
+typedef struct {
+    char magic[8];          /**< STREAM_STATE_MAGIC */
+    unsigned int version;   /**< STREAM_STATE_VERSION */
+    int mpi_rank;           /**< process that wrote the file */
+    size_t nstreams;        /**< number of output streams */
+} stream_state_header_struct;
+
+/******************************************************************************
+ * @brief    State of one output stream in a stream state file, followed by
+ *           its aggregated values.
+ *****************************************************************************/
+typedef struct {
+    size_t nvars;                /**< stream_struct.nvars */
+    size_t ngridcells;           /**< stream_struct.ngridcells */
+    alarm_struct agg_alarm;      /**< stream_struct.agg_alarm */
+    alarm_struct write_alarm;    /**< stream_struct.write_alarm */
+    dmy_struct time_bounds[2];   /**< stream_struct.time_bounds */
+    char filename[MAXSTRING];    /**< stream_struct.filename */
+    bool open;                   /**< nc_file_struct.open */
+    unsigned int flush_count;    /**< nc_file_struct.flush_count */
+} stream_state_struct;
+
+/******************************************************************************
+ * @brief    Structure with the hyperslabs through which the local node reads
+ *           and writes its own cells when PARALLEL_IO is TRUE.
+ * @details  The local cells are covered by nslabs rectangular (y, x) slabs
+ *           that do not contain active cells of other nodes. The slabs are
+ *           stored one after the other in a buffer of nelem elements.
+ *****************************************************************************/
+typedef struct {
+    size_t nslabs;       /**< number of slabs on the local node */
+    size_t nslabs_max;   /**< maximum number of slabs over all nodes */
+    size_t *slab_start;  /**< (y, x) start of each slab [nslabs * 2] */
+    size_t *slab_count;  /**< (y, x) count of each slab [nslabs * 2] */
+    size_t *slab_offset; /**< offset of each slab in the buffer [nslabs] */
+    size_t nelem;        /**< number of elements in the buffer */
+    size_t *cell_slab;   /**< slab of each local cell [ncells_active] */
+    size_t *cell_pos;    /**< position of each local cell in its slab
+                            [ncells_active] */
+} par_io_struct;
+
+/******************************************************************************
+ * @brief    Structure for a history record that is queued for the writer
+ *           thread when ASYNC_OUTPUT is TRUE.
+ *****************************************************************************/
+typedef struct {
+    stream_struct *stream;        /**< output stream of the record */
+    nc_file_struct *nc_hist_file; /**< history file of the record */
+    size_t time_idx;              /**< position in the time dimension */
+    double time_bounds[2];        /**< time bounds in time units */
+    bool close;                   /**< TRUE: close the file after writing */
+    bool sync;                    /**< TRUE: sync the file after writing */
+    size_t nelem;                 /**< number of elements in data */
+    double *data;                 /**< gathered values of all variables and
+                                     layers, in the order of the nodes */
+} async_record_struct;
+
+/******************************************************************************
+ * @brief    Structure with the state of the asynchronous history writer.
+ * @details  The queued records form a ring buffer. A record stays in the
+ *           buffer until the writer thread has written it.
+ *****************************************************************************/
+typedef struct {
+    async_record_struct records[MAX_ASYNC_RECORDS]; /**< ring buffer */
+    size_t first;            /**< oldest queued record */
+    size_t nqueued;          /**< number of queued records */
+    bool active;             /**< TRUE: the writer thread is running */
+    bool done;               /**< TRUE: the writer thread has to stop */
+    double *dvar;            /**< local values of a variable layer */
+    void *cvar;              /**< converted values of a variable layer */
+    void *cvar_grid;         /**< variable layer on the full grid */
+    pthread_t thread;        /**< writer thread */
+    pthread_mutex_t mutex;   /**< protects first, nqueued and done */
+    pthread_cond_t cond;     /**< signals changes of nqueued and done */
+} async_output_struct;
+
+/******************************************************************************
+ * @brief    Header of a message from the master node to an I/O server.
+ * @details  A record header is followed by the values of the record from
+ *           every compute node.
+ *****************************************************************************/
+typedef struct {
+    size_t stream_idx;      /**< output stream */
+    size_t time_idx;        /**< position in the time dimension */
+    double time_bounds[2];  /**< time bounds in time units */
+    dmy_struct start;       /**< beginning of the aggregation window, used
+                               to name a new history file */
+    bool close;             /**< TRUE: close the file after writing */
+    bool sync;              /**< TRUE: sync the file after writing */
+} io_record_struct;
+
+/******************************************************************************
+ * @brief    Structure with the state of the I/O servers (IO_SERVERS).
+ * @details  The last nservers processes of the original MPI_COMM_VIC are I/O
+ *           servers. The output streams are dealt out to the servers in turn.
+ *****************************************************************************/
+typedef struct {
+    bool active;              /**< TRUE: IO_SERVERS > 0 */
+    bool server;              /**< TRUE: the local process is an I/O server */
+    size_t nservers;          /**< number of I/O servers */
+    size_t ncompute;          /**< number of compute processes */
+    MPI_Comm comm;            /**< communicator with all processes */
+    MPI_Datatype record_type; /**< MPI type of io_record_struct */
+    bool *open;               /**< compute master: a history file of the
+                                 stream is open on its server [nstreams] */
+    io_record_struct *headers; /**< compute master: headers in flight
+                                  [nstreams] */
+    MPI_Request *header_requests; /**< compute master: [nstreams] */
+    double **sendbuf;         /**< compute nodes: values in flight
+                                 [nstreams][nelem * ncells_active] */
+    MPI_Request *data_requests; /**< compute nodes: [nstreams] */
+    double *recvbuf;          /**< I/O servers: values of one node */
+    double **data;            /**< I/O servers: gathered values of each
+                                 stream [nstreams] */
+} io_server_struct;
+
+/******************************************************************************
+ * @brief    Header of a BINARY_FAST state file.
+ * @details  The header is followed by the map of the cells of one process
+ *           (the io_idx and the number of active vegetation tiles of each
+ *           cell) and by their raw state components. The sizes of the
+ *           structures guard against reading a file written by a different
+ *           build. In an incremental file, the components are preceded by a
+ *           mask (one byte per cell, one bit per component) of the
+ *           components that are stored.
+ *****************************************************************************/
+typedef struct {
+    char magic[8];               /**< STATE_FAST_MAGIC */
+    unsigned int version;        /**< STATE_FAST_VERSION */
+    int mpi_rank;                /**< process that wrote the file */
+    int mpi_size;                /**< number of processes of the run */
+    unsigned long long domain_hash; /**< hash of the cells of the process */
+    size_t ncells;               /**< number of active cells */
+    size_t global_ncells;        /**< number of active cells of the domain */
+    size_t nlayer;               /**< number of soil layers */
+    size_t nnode;                /**< number of soil thermal nodes */
+    size_t nfrost;               /**< number of frost subareas */
+    size_t snow_band;            /**< number of snow bands */
+    size_t ncanopy;              /**< number of canopy layers */
+    size_t nlakenodes;           /**< number of lake nodes */
+    bool lakes;                  /**< lake state is included */
+    bool carbon;                 /**< carbon state is included */
+    size_t cell_size;            /**< sizeof(cell_data_struct) */
+    size_t energy_size;          /**< sizeof(energy_bal_struct) */
+    size_t snow_size;            /**< sizeof(snow_data_struct) */
+    size_t veg_var_size;         /**< sizeof(veg_var_struct) */
+    size_t lake_var_size;        /**< sizeof(lake_var_struct) */
+    size_t save_data_size;       /**< sizeof(save_data_struct) */
+    dmy_struct dmy;              /**< time of the state */
+    bool incremental;            /**< only changed components are stored */
+    char base[MAXSTRING];        /**< state the increment applies to */
+} state_fast_header_struct;
+
+/******************************************************************************
+ * @brief    Header of a parameter cache file.
+ * @details  The header is followed by the initialized parameter structures
+ *           of the cells of one process. The file is only used by a run for
+ *           which the header is the same: the same parameter and domain
+ *           files, decomposition, options, constants and build.
+ *****************************************************************************/
+typedef struct {
+    char magic[8];               /**< PARAM_CACHE_MAGIC */
+    unsigned int version;        /**< PARAM_CACHE_VERSION */
+    int mpi_rank;                /**< process that wrote the file */
+    int mpi_size;                /**< number of processes of the run */
+    unsigned long long domain_hash; /**< hash of the cells of the process */
+    unsigned long long input_hash; /**< hash of the parameter and domain
+                                      file names, sizes and times */
+    unsigned long long options_hash; /**< hash of the options and model
+                                        constants */
+    size_t ncells;               /**< number of active cells */
+    size_t nv_total;             /**< number of vegetation tiles */
+    size_t soil_con_size;        /**< sizeof(soil_con_struct) */
+    size_t veg_con_size;         /**< sizeof(veg_con_struct) */
+    size_t veg_lib_size;         /**< sizeof(veg_lib_struct) */
+    size_t lake_con_size;        /**< sizeof(lake_con_struct) */
+} param_cache_header_struct;
+
+/******************************************************************************
+ * @brief    Components of the state of a cell in a BINARY_FAST state file.
+ *****************************************************************************/
+enum
+{
+    STATE_FAST_CELL,
+    STATE_FAST_ENERGY,
+    STATE_FAST_SNOW,
+    STATE_FAST_VEG_VAR,
+    STATE_FAST_LAKE,
+    STATE_FAST_SAVE_DATA,
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_STATE_FAST_COMPONENTS       /**< used as a loop counter*/
+};
+
+/******************************************************************************
+ * @brief    Copy of the last saved or restored BINARY_FAST state of the
+ *           local cells, used as the base of incremental state files.
+ *****************************************************************************/
+typedef struct {
+    bool valid;                  /**< data holds a saved or restored state */
+    char name[MAXSTRING];        /**< name of the state */
+    size_t size;                 /**< number of bytes in data */
+    char *data;                  /**< packed state components */
+} state_fast_base_struct;
+
+/******************************************************************************
+ * @brief    BINARY_FAST state of the cells of one process of another
+ *           decomposition, read to be sent to the processes that now run
+ *           them.
+ *****************************************************************************/
+typedef struct {
+    size_t ncells;               /**< number of cells */
+    size_t *io_idx;              /**< io_idx of the cells [ncells] */
+    size_t *nveg;                /**< active vegetation tiles [ncells] */
+    size_t size;                 /**< number of bytes in data */
+    char *data;                  /**< packed state components */
+} state_fast_piece_struct;
+
+/******************************************************************************
+ * @brief    Snapshot of the BINARY_FAST state of the local cells.
+ * @details  The arena is allocated once and holds the packed state
+ *           components of all local cells. With STATE_ASYNC, a checkpoint
+ *           thread writes the pending snapshot while the model advances.
+ *****************************************************************************/
+typedef struct {
+    state_fast_header_struct header; /**< header of the state file */
+    char name[MAXSTRING];        /**< name of the state */
+    char filename[MAXSTRING];    /**< state file of the local node */
+    size_t size;                 /**< number of bytes in data */
+    char *data;                  /**< packed state components */
+    bool pending;                /**< TRUE: the snapshot is not written yet */
+    bool active;                 /**< TRUE: the checkpoint thread is running */
+    bool done;                   /**< TRUE: the checkpoint thread has to stop */
+    pthread_t thread;            /**< checkpoint thread */
+    pthread_mutex_t mutex;       /**< protects pending and done */
+    pthread_cond_t cond;         /**< signals changes of pending and done */
+} state_fast_snapshot_struct;
+
 /******************************************************************************
  * @brief    Structure for mapping the vegetation types for each grid cell as
  *           stored in VIC's veg_con_struct to a regular array.
@@ -152,6 +808,10 @@ typedef struct {
                       /**< way that VIC defines nveg, this is nveg+1 */
                       /**< (for bare soil) or nveg+2 (if the treeline option */
                       /**< is active as well) */
+    size_t nv_classes; /**< number of vegetation types with a tile. vidx */
+                       /**< maps them to tiles 0 to nv_classes - 1 in the */
+                       /**< order of the types, and veg_class of each of */
+                       /**< these tiles maps them back */
     int *vidx;     /**< array of indices for active vegetation types */
     double *Cv;    /**< array of fractional coverage for nc_types */
 } veg_con_map_struct;
@@ -184,25 +844,74 @@ typedef struct {
     char result_dir[MAXSTRING];    /**< directory where results will be written */
     char statefile[MAXSTRING];     /**< name of file in which to store model state */
     char log_path[MAXSTRING];      /**< Location to write log file to */
+    char decomp_cost[MAXSTRING];   /**< per-cell cost file used for the domain decomposition */
+    char cost_map[MAXSTRING];      /**< file for the measured cost per cell */
+    char trace[MAXSTRING];         /**< Chrome trace file of the run */
+    char param_cache[MAXSTRING];   /**< prefix of the parameter cache files */
+    char rout_params[MAXSTRING];   /**< river network file of the inline routing */
+    char checkpoint[MAXSTRING];    /**< prefix of the checkpoint files */
+    char da_port[MAXSTRING];       /**< file with the MPI port of the data
+                                      assimilation program */
+    char force_stage[MAXSTRING];   /**< local directory of the staged
+                                      forcing files */
 } filenames_struct;
 
 void add_nveg_to_global_domain(char *nc_name, domain_struct *global_domain);
-void alloc_force(force_data_struct *force);
-void alloc_veg_hist(veg_hist_struct *veg_hist);
+void add_vic_io_bytes(int phase, size_t nbytes);
+void add_vic_solver_stats(size_t *counts);
+void alloc_force(size_t ncells, force_data_struct *force);
+void alloc_veg_hist(size_t nveg, veg_hist_struct *veg_hist);
 double air_density(double t, double p);
 double average(double *ar, size_t n);
+bool check_flush_history_file(stream_struct *stream,
+                              nc_file_struct *nc_hist_file);
 void check_init_state_file(void);
+void close_direct_chunks(nc_file_struct *nc, stream_struct *stream);
+void close_nc_file(char *nc_name);
+void close_nc_files(void);
 void compare_ncdomain_with_global_domain(char *ncfile);
+void create_par_nc_file(char *nc_name, int cmode, int *nc_id);
+void alloc_history_record_buffers(void);
+void finalize_adios2_streams(void);
+void finalize_async_output(void);
+void finalize_async_state(void);
+void finalize_heartbeat(void);
+void finalize_io_servers(void);
+void finalize_node_io(void);
+void finalize_par_io(void);
+void finalize_split_io(void);
 void free_force(force_data_struct *force);
+void free_history_record_buffers(void);
+void free_nc_io_request(nc_io_request_struct *request);
+void free_run_blocks(void);
+void free_state_fast_base(void);
+void free_stream_mask(nc_file_struct *nc);
+void free_stream_regions(nc_file_struct *nc);
 void free_veg_hist(veg_hist_struct *veg_hist);
+void free_veg_lib(void);
+void gather_put_nc_fields(size_t nfields, nc_io_field_struct *fields);
+void gather_put_split_fields(size_t nfields, nc_io_field_struct *fields);
 void get_domain_type(char *cmdstr);
+void get_history_time_bounds(stream_struct *stream, double *bounds);
+int get_history_keepbits(int digits, int nc_type);
+lake_con_struct *get_lake_con(size_t i);
+void get_distributed_domain(void);
 size_t get_global_domain(char *domain_nc_name, char *param_nc_name,
                          domain_struct *global_domain);
 void copy_domain_info(domain_struct *domain_from, domain_struct *domain_to);
 void get_nc_latlon(char *nc_name, domain_struct *nc_domain);
+void *get_mpi_io_buffer(mpi_io_buffer_struct *buffer, size_t nbytes);
+size_t get_mpi_io_buffer_size(void);
+size_t get_run_block_size(void);
+size_t get_nc_io_type_size(int nc_type);
+size_t get_veg_lib_tables(veg_lib_struct ***tables, size_t **index);
+void *get_nc_io_send_buffer(nc_io_request_struct *request, size_t nbytes);
 size_t get_nc_dimension(char *nc_name, char *dim_name);
+int *get_split_grid_cells(void);
 void get_nc_var_attr(char *nc_name, char *var_name, char *attr_name,
                      char **attr);
+void get_nc_var_packing(char *nc_name, char *var_name, double *scale_factor,
+                        double *add_offset);
 int get_nc_var_type(char *nc_name, char *var_name);
 int get_nc_varndimensions(char *nc_name, char *var_name);
 int get_nc_field_double(char *nc_name, char *var_name, size_t *start,
@@ -211,13 +920,32 @@ int get_nc_field_float(char *nc_name, char *var_name, size_t *start,
                        size_t *count, float *var);
 int get_nc_field_int(char *nc_name, char *var_name, size_t *start,
                      size_t *count, int *var);
+int get_nc_field_short(char *nc_name, char *var_name, size_t *start,
+                       size_t *count, short int *var);
+void get_global_domain_costs(char *param_nc_name, char *cost_nc_name,
+                             domain_struct *global_domain, double *cell_costs);
 int get_nc_dtype(unsigned short int dtype);
+int get_nc_file_id(char *nc_name);
+size_t get_nc_dim_meta(char *nc_name, char *dim_name);
+nc_var_meta_struct *get_nc_var_meta(char *nc_name, char *var_name);
 int get_nc_mode(unsigned short int format);
+int get_par_nc_file_id(char *nc_name);
+void get_scatter_nc_fields(size_t nfields, nc_io_field_struct *fields);
+void get_par_nc_field_double_steps(char *nc_name, char *var_name,
+                                   size_t *start, size_t *count, double *var);
+void get_par_nc_field_int_steps(char *nc_name, char *var_name, size_t *start,
+                                size_t *count, int *var);
+void initialize_adios2_stream(stream_struct *stream, nc_file_struct *nc);
+void initialize_async_output(void);
+void initialize_async_state(void);
+void initialize_cost_map(void);
+void initialize_io_servers(void);
 void initialize_domain(domain_struct *domain);
 void initialize_domain_info(domain_info_struct *info);
 void initialize_filenames(void);
 void initialize_fileps(void);
 void initialize_global_structures(void);
+void initialize_heartbeat(void);
 void initialize_history_file(nc_file_struct *nc, stream_struct *stream,
                              dmy_struct *dmy_current);
 void initialize_state_file(char *filename, nc_file_struct *nc_state_file,
@@ -228,8 +956,19 @@ int initialize_model_state(all_vars_struct *all_vars, size_t Nveg,
                            soil_con_struct *soil_con, veg_con_struct *veg_con);
 void initialize_nc_file(nc_file_struct *nc_file, size_t nvars,
                         unsigned int *varids, unsigned short int *dtypes);
+void initialize_node_io(void);
+void initialize_par_io(void);
 void initialize_soil_con(soil_con_struct *soil_con);
+void initialize_split_io(void);
+void initialize_trace(void);
 void initialize_veg_con(veg_con_struct *veg_con);
+bool is_direct_chunk_stream(stream_struct *stream, nc_file_struct *nc);
+bool is_history_writer(nc_file_struct *nc);
+bool is_io_server(void);
+bool is_published_stream(stream_struct *stream);
+void lock_netcdf(void);
+void open_direct_chunks(nc_file_struct *nc, stream_struct *stream);
+void open_par_nc_file(char *nc_name, int *nc_id);
 void parse_output_info(FILE *gp, stream_struct **output_streams,
                        dmy_struct *dmy_current);
 void print_force_data(force_data_struct *force);
@@ -238,27 +977,90 @@ void print_location(location_struct *location);
 void print_nc_file(nc_file_struct *nc);
 void print_nc_var(nc_var_struct *nc_var);
 void print_veg_con_map(veg_con_map_struct *veg_con_map);
+bool read_param_cache(void);
+void progress_history_records(void);
+void put_adios2_record(stream_struct *stream, nc_file_struct *nc,
+                       dmy_struct *dmy_current);
+void put_direct_chunks(direct_chunk_var_struct *var,
+                       nc_io_field_struct *field, void *grid);
 void put_nc_attr(int nc_id, int var_id, const char *name, const char *value);
+void put_par_nc_field_double(int nc_id, int var_id, double fillval,
+                             size_t *start, size_t *count, double *var);
+void put_par_nc_field_float(int nc_id, int var_id, float fillval,
+                            size_t *start, size_t *count, float *var);
+void put_par_nc_field_int(int nc_id, int var_id, int fillval, size_t *start,
+                          size_t *count, int *var);
+void put_par_nc_field_short(int nc_id, int var_id, short int fillval,
+                            size_t *start, size_t *count, short int *var);
+void put_par_nc_field_schar(int nc_id, int var_id, char fillval,
+                            size_t *start, size_t *count, char *var);
+void put_region_record(stream_struct *stream, nc_file_struct *nc);
+void read_stream_state(FILE *fp, char *filename, bool history);
+void reopen_history_file(nc_file_struct *nc, stream_struct *stream);
+void round_history_values(stream_struct *stream, nc_file_struct *nc,
+                          size_t varidx, double *values, size_t nvalues);
+void reduce_log_summary(void);
+void reduce_vic_phase_timers(timer_struct *timers);
+void sample_vic_memory(int sample);
 void set_force_type(char *cmdstr, int file_num, int *field);
 void set_global_nc_attributes(int ncid, unsigned short int file_type);
+void set_lake_cells(void);
 void set_state_meta_data_info();
+void set_stream_mask(stream_struct *stream, nc_file_struct *nc);
+void set_stream_regions(stream_struct *stream, nc_file_struct *nc);
+void set_stream_split(stream_struct *stream, nc_file_struct *nc);
+void set_split_filename(char *filename);
+void set_split_nc_attributes(int nc_id);
+void share_node_veg_lib(void);
+void share_veg_lib(void);
 void set_nc_var_dimids(unsigned int varid, nc_file_struct *nc_hist_file,
                        nc_var_struct *nc_var);
 void set_nc_var_info(unsigned int varid, unsigned short int dtype,
                      nc_file_struct *nc_hist_file, nc_var_struct *nc_var);
 void set_nc_state_file_info(nc_file_struct *nc_state_file);
 void set_nc_state_var_info(nc_file_struct *nc_state_file);
+void set_par_nc_var_collective(int nc_id, int var_id);
 void sprint_location(char *str, location_struct *loc);
+void start_gather_put_nc_fields(nc_io_request_struct *request,
+                                size_t nfields, nc_io_field_struct *fields);
+void start_get_scatter_nc_fields(nc_io_request_struct *request,
+                                 size_t nfields, nc_io_field_struct *fields);
+void sync_history_file(stream_struct *stream, nc_file_struct *nc_hist_file);
+void sync_history_files_on_state(void);
+void sync_io_server_file(size_t stream_idx);
+void trace_begin(int event);
+void trace_end(int event);
+void unlock_netcdf(void);
+void update_cost_map(size_t cell, double wall_time);
+void update_heartbeat(dmy_struct *dmy_current);
+void update_load_balance(void);
 void vic_alloc(void);
 void vic_finalize(void);
 void vic_image_run(dmy_struct *dmy_current);
 void vic_init(void);
 void vic_init_output(dmy_struct *dmy_current);
+void vic_io_server(void);
 void vic_restore(void);
+void vic_restore_fast(void);
+void vic_restore_fast_file(char *filename);
+void vic_restore_streams(void);
 void vic_start(void);
 void vic_store(dmy_struct *dmy_current, char *state_filename);
+void vic_store_fast(dmy_struct *dmy_current, char *filename);
+void vic_store_streams(char *filename);
 void vic_write(stream_struct *stream, nc_file_struct *nc_hist_file,
                dmy_struct *dmy_current);
+void vic_write_async(stream_struct *stream, nc_file_struct *nc_hist_file,
+                     dmy_struct *dmy_current);
+void vic_write_io_server(size_t stream_idx, dmy_struct *dmy_current);
 void vic_write_output(dmy_struct *dmy);
+void wait_async_output(void);
+void wait_async_state(void);
+void wait_nc_io_request(nc_io_request_struct *request);
+void write_cost_map(void);
+void write_history_record(async_record_struct *record);
+void write_param_cache(void);
+void write_stream_state(FILE *fp, char *filename);
+void write_trace(void);
 void write_vic_timing_table(timer_struct *timers, char *driver);
 #endif
@@ -73,7 +73,7 @@
                                     "[ERROR] %s:%d: errno: %d: " M " \n", \
                                     __FILE__, __LINE__, e, \
                                     ## __VA_ARGS__); \
-    MPI_Abort(MPI_COMM_VIC, e);
+    fflush(LOG_DEST); MPI_Abort(MPI_COMM_VIC, e);
 
 #define check_mpi_status(A, M, ...) if (A != MPI_SUCCESS) {log_mpi_err(A, M, \
                                                                        ## __VA_ARGS__); \
@@ -32,12 +32,32 @@
 
 #define VIC_MPI_ROOT 0
 
+#define DECOMP_LAKE_COST 10. /**< cost of a lake relative to one vegetation
+                                tile in one snow band */
+
+/******************************************************************************
+ * @brief    Buffer of the gather and scatter functions on the master node.
+ *****************************************************************************/
+typedef struct {
+    size_t size;                 /**< number of bytes in data */
+    void *data;                  /**< buffer */
+} mpi_io_buffer_struct;
+
 void create_MPI_filenames_struct_type(MPI_Datatype *mpi_type);
 void create_MPI_global_struct_type(MPI_Datatype *mpi_type);
 void create_MPI_location_struct_type(MPI_Datatype *mpi_type);
 void create_MPI_alarm_struct_type(MPI_Datatype *mpi_type);
 void create_MPI_option_struct_type(MPI_Datatype *mpi_type);
+void create_MPI_io_record_struct_type(MPI_Datatype *mpi_type);
 void create_MPI_param_struct_type(MPI_Datatype *mpi_type);
+void free_mpi_io_buffers(void);
+void gather_field_double(double *var, double *dvar);
+void gather_put_nc_block_double(int nc_id, int var_id, double fillval,
+                                size_t nslices, size_t *start, size_t *count,
+                                double *var);
+void gather_put_nc_block_int(int nc_id, int var_id, int fillval,
+                             size_t nslices, size_t *start, size_t *count,
+                             int *var);
 void gather_put_nc_field_double(int nc_id, int var_id, double fillval,
                                 size_t *start, size_t *count, double *var);
 void gather_put_nc_field_float(int nc_id, int var_id, float fillval,
@@ -48,8 +68,16 @@ void gather_put_nc_field_short(int nc_id, int var_id, short int fillval,
                                size_t *start, size_t *count, short int *var);
 void gather_put_nc_field_schar(int nc_id, int var_id, char fillval,
                                size_t *start, size_t *count, char *var);
+void get_scatter_nc_block_double(char *nc_name, char *var_name,
+                                 size_t nslices, size_t *start, size_t *count,
+                                 double *var);
+void get_scatter_nc_block_int(char *nc_name, char *var_name, size_t nslices,
+                              size_t *start, size_t *count, int *var);
 void get_scatter_nc_field_double(char *nc_name, char *var_name, size_t *start,
                                  size_t *count, double *var);
+void get_scatter_nc_field_double_steps(char *nc_name, char *var_name,
+                                       size_t *start, size_t *count,
+                                       double *var);
 void get_scatter_nc_field_float(char *nc_name, char *var_name, size_t *start,
                                 size_t *count, float *var);
 void get_scatter_nc_field_int(char *nc_name, char *var_name, size_t *start,
@@ -57,10 +85,28 @@ void get_scatter_nc_field_int(char *nc_name, char *var_name, size_t *start,
 void initialize_mpi(void);
 void map(size_t size, size_t n, size_t *from_map, size_t *to_map, void *from,
          void *to);
+void map_from_grid(size_t size, size_t n, size_t *grid_map, void *from,
+                   void *to);
+void map_to_grid(size_t size, size_t n, size_t *grid_map, void *from,
+                 void *to);
 void mpi_map_decomp_domain(size_t ncells, size_t mpi_size,
+                           double *cell_costs,
                            int **mpi_map_local_array_sizes,
                            int **mpi_map_global_array_offsets,
                            size_t **mpi_map_mapping_array);
+void mpi_map_decomp_hilbert(size_t ncells, size_t n_nx, size_t n_ny,
+                            size_t *grid_idx, size_t mpi_size,
+                            double *cell_costs,
+                            int **mpi_map_local_array_sizes,
+                            int **mpi_map_global_array_offsets,
+                            size_t **mpi_map_mapping_array);
+void mpi_map_grid_domain(size_t ncells, size_t *filter_active_cells,
+                         size_t *mpi_map_mapping_array,
+                         size_t **mpi_map_grid_array);
 void print_mpi_error_str(int error_code);
+void scatter_field_double_steps(size_t nsteps, double *dvar, double *var);
+void scatter_field_float_steps(size_t nsteps, float *fvar, float *var);
+void scatter_field_short_steps(size_t nsteps, short int *svar,
+                               short int *var);
 
 #endif
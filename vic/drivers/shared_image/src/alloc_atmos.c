@@ -27,91 +27,89 @@
 #include <vic_driver_shared_image.h>
 
 /******************************************************************************
- * @brief    Allocate memory for the force data structure.
+ * @brief    Allocate the forcing time series of an array of force data
+ *           structures.
+ * @details  All time series of one forcing variable are allocated as one
+ *           slab, ordered by grid cell, and the slabs of all the variables
+ *           as one block, so each grid cell only holds views into it.
+ *           free_force() frees the block at once.
  *****************************************************************************/
 void
-alloc_force(force_data_struct *force)
+alloc_force(size_t             ncells,
+            force_data_struct *force)
 {
     extern option_struct options;
 
-    force->air_temp = calloc(NR + 1, sizeof(*(force->air_temp)));
-    check_alloc_status(force->air_temp, "Memory allocation error.");
+    size_t               i;
+    size_t               nvars;
+    size_t               nsteps;
+    double              *series;
+    bool                *snowflag;
 
-    force->density = calloc(NR + 1, sizeof(*(force->density)));
-    check_alloc_status(force->density, "Memory allocation error.");
-
-    force->longwave = calloc(NR + 1, sizeof(*(force->longwave)));
-    check_alloc_status(force->longwave, "Memory allocation error.");
-
-    force->prec = calloc(NR + 1, sizeof(*(force->prec)));
-    check_alloc_status(force->prec, "Memory allocation error.");
-
-    force->pressure = calloc(NR + 1, sizeof(*(force->pressure)));
-    check_alloc_status(force->pressure, "Memory allocation error.");
-
-    force->shortwave = calloc(NR + 1, sizeof(*(force->shortwave)));
-    check_alloc_status(force->shortwave, "Memory allocation error.");
-
-    force->snowflag = calloc(NR + 1, sizeof(*(force->snowflag)));
-    check_alloc_status(force->snowflag, "Memory allocation error.");
-
-    force->vp = calloc(NR + 1, sizeof(*(force->vp)));
-    check_alloc_status(force->vp, "Memory allocation error.");
-
-    force->vpd = calloc(NR + 1, sizeof(*(force->vpd)));
-    check_alloc_status(force->vpd, "Memory allocation error.");
-
-    force->wind = calloc(NR + 1, sizeof(*(force->wind)));
-    check_alloc_status(force->wind, "Memory allocation error.");
+    if (ncells == 0) {
+        return;
+    }
 
+    // air_temp, density, longwave, prec, pressure, shortwave, vp, vpd and
+    // wind, then the optional variables. snowflag is a slab of its own.
+    nvars = 9;
     if (options.LAKES) {
-        force->channel_in = calloc(NR + 1, sizeof(*(force->channel_in)));
-        check_alloc_status(force->channel_in, "Memory allocation error.");
+        nvars += 1;
     }
     if (options.CARBON) {
-        force->Catm = calloc(NR + 1, sizeof(*(force->Catm)));
-        check_alloc_status(force->Catm, "Memory allocation error.");
-
-        force->coszen = calloc(NR + 1, sizeof(*(force->coszen)));
-        check_alloc_status(force->coszen, "Memory allocation error.");
-
-        force->fdir = calloc(NR + 1, sizeof(*(force->fdir)));
-        check_alloc_status(force->fdir, "Memory allocation error.");
-
-        force->par = calloc(NR + 1, sizeof(*(force->par)));
-        check_alloc_status(force->par, "Memory allocation error.");
+        nvars += 4;
+    }
+    nsteps = ncells * (NR + 1);
+
+    series = calloc(nvars * nsteps, sizeof(*series));
+    check_alloc_status(series, "Memory allocation error.");
+    snowflag = calloc(nsteps, sizeof(*snowflag));
+    check_alloc_status(snowflag, "Memory allocation error.");
+
+    for (i = 0; i < ncells; i++) {
+        force[i].air_temp = series + i * (NR + 1);
+        force[i].density = force[i].air_temp + nsteps;
+        force[i].longwave = force[i].density + nsteps;
+        force[i].prec = force[i].longwave + nsteps;
+        force[i].pressure = force[i].prec + nsteps;
+        force[i].shortwave = force[i].pressure + nsteps;
+        force[i].vp = force[i].shortwave + nsteps;
+        force[i].vpd = force[i].vp + nsteps;
+        force[i].wind = force[i].vpd + nsteps;
+        force[i].snowflag = snowflag + i * (NR + 1);
+        force[i].channel_in = NULL;
+        force[i].Catm = NULL;
+        force[i].coszen = NULL;
+        force[i].fdir = NULL;
+        force[i].par = NULL;
+        if (options.LAKES) {
+            force[i].channel_in = force[i].wind + nsteps;
+        }
+        if (options.CARBON) {
+            if (options.LAKES) {
+                force[i].Catm = force[i].channel_in + nsteps;
+            }
+            else {
+                force[i].Catm = force[i].wind + nsteps;
+            }
+            force[i].coszen = force[i].Catm + nsteps;
+            force[i].fdir = force[i].coszen + nsteps;
+            force[i].par = force[i].fdir + nsteps;
+        }
     }
 }
 
 /******************************************************************************
- * @brief    Free memory for the force data structure.
+ * @brief    Free the forcing time series of an array of force data
+ *           structures, see alloc_force().
  *****************************************************************************/
 void
 free_force(force_data_struct *force)
 {
-    extern option_struct options;
-
     if (force == NULL) {
         return;
     }
 
-    free(force->air_temp);
-    free(force->density);
-    free(force->longwave);
-    free(force->prec);
-    free(force->pressure);
-    free(force->shortwave);
-    free(force->snowflag);
-    free(force->vp);
-    free(force->vpd);
-    free(force->wind);
-    if (options.LAKES) {
-        free(force->channel_in);
-    }
-    if (options.CARBON) {
-        free(force->Catm);
-        free(force->coszen);
-        free(force->fdir);
-        free(force->par);
-    }
+    free(force[0].air_temp);
+    free(force[0].snowflag);
 }
@@ -27,29 +27,37 @@
  #include <vic_driver_shared_image.h>
 
 /******************************************************************************
- * @brief
+ * @brief    Allocate the time series of an array of veg hist structures.
+ *
+ * @details  The series of all nveg structures are allocated as one block,
+ *           which starts at veg_hist[0].albedo.
  *****************************************************************************/
 void
-alloc_veg_hist(veg_hist_struct *veg_hist)
+alloc_veg_hist(size_t           nveg,
+               veg_hist_struct *veg_hist)
 {
-    veg_hist->albedo = calloc(NR + 1, sizeof(*(veg_hist->albedo)));
-    check_alloc_status(veg_hist->albedo, "Memory allocation error.");
-
-    veg_hist->displacement = calloc(NR + 1, sizeof(*(veg_hist->displacement)));
-    check_alloc_status(veg_hist->displacement, "Memory allocation error.");
+    size_t  i;
+    double *series;
 
-    veg_hist->fcanopy = calloc(NR + 1, sizeof(*(veg_hist->fcanopy)));
-    check_alloc_status(veg_hist->fcanopy, "Memory allocation error.");
+    if (nveg == 0) {
+        return;
+    }
 
-    veg_hist->LAI = calloc(NR + 1, sizeof(*(veg_hist->LAI)));
-    check_alloc_status(veg_hist->LAI, "Memory allocation error.");
+    series = calloc(nveg * 5 * (NR + 1), sizeof(*series));
+    check_alloc_status(series, "Memory allocation error.");
 
-    veg_hist->roughness = calloc(NR + 1, sizeof(*(veg_hist->roughness)));
-    check_alloc_status(veg_hist->roughness, "Memory allocation error.");
+    for (i = 0; i < nveg; i++) {
+        veg_hist[i].albedo = series;
+        veg_hist[i].displacement = series + (NR + 1);
+        veg_hist[i].fcanopy = series + 2 * (NR + 1);
+        veg_hist[i].LAI = series + 3 * (NR + 1);
+        veg_hist[i].roughness = series + 4 * (NR + 1);
+        series += 5 * (NR + 1);
+    }
 }
 
 /******************************************************************************
- * @brief    Free veg hist structure.
+ * @brief    Free the time series of an array of veg hist structures.
  *****************************************************************************/
 void
 free_veg_hist(veg_hist_struct *veg_hist)
@@ -58,9 +66,5 @@ free_veg_hist(veg_hist_struct *veg_hist)
         return;
     }
 
-    free(veg_hist->albedo);
-    free(veg_hist->displacement);
-    free(veg_hist->fcanopy);
-    free(veg_hist->LAI);
-    free(veg_hist->roughness);
+    free(veg_hist[0].albedo);
 }
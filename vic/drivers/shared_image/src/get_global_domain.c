@@ -355,6 +355,120 @@ add_nveg_to_global_domain(char          *nc_name,
     free(ivar);
 }
 
+/******************************************************************************
+ * @brief    Get the relative cost of running each active grid cell.
+ * @details  If a cost file is given, the costs are read from its "cell_cost"
+ *           variable, which must be on the domain grid (e.g. written from the
+ *           cell timers of an earlier run). Otherwise the cost is estimated
+ *           as the number of tiles (vegetation types plus bare soil) times
+ *           the number of snow bands with nonzero area, plus a fixed extra
+ *           cost for cells with a lake.
+ *****************************************************************************/
+void
+get_global_domain_costs(char          *param_nc_name,
+                        char          *cost_nc_name,
+                        domain_struct *global_domain,
+                        double        *cell_costs)
+{
+    extern option_struct options;
+
+    size_t               d2count[2];
+    size_t               d2start[2];
+    size_t               d3count[3];
+    size_t               d3start[3];
+    size_t               grid_size;
+    size_t               i;
+    size_t               j;
+    size_t               k;
+    size_t               nbands;
+    double              *dvar = NULL;
+    int                 *ivar = NULL;
+
+    grid_size = global_domain->ncells_total;
+
+    d2start[0] = 0;
+    d2start[1] = 0;
+    d2count[0] = global_domain->n_ny;
+    d2count[1] = global_domain->n_nx;
+
+    if (strcasecmp(cost_nc_name, "MISSING")) {
+        dvar = malloc(grid_size * sizeof(*dvar));
+        check_alloc_status(dvar, "Memory allocation error.");
+
+        get_nc_field_double(cost_nc_name, "cell_cost", d2start, d2count, dvar);
+
+        for (i = 0, k = 0; i < grid_size; i++) {
+            if (global_domain->locations[i].run) {
+                cell_costs[k] = dvar[global_domain->locations[i].io_idx];
+                if (!(cell_costs[k] >= 0.)) {
+                    log_err("cell_cost in %s must be non-negative for all "
+                            "active cells, found %f for cell %zu",
+                            cost_nc_name, cell_costs[k], i);
+                }
+                k++;
+            }
+        }
+        free(dvar);
+        return;
+    }
+
+    // tiles: vegetation types plus bare soil
+    for (i = 0, k = 0; i < grid_size; i++) {
+        if (global_domain->locations[i].run) {
+            cell_costs[k++] = (double) (global_domain->locations[i].nveg + 1);
+        }
+    }
+
+    // snow bands with nonzero area
+    if (options.SNOW_BAND > 1) {
+        dvar = malloc(grid_size * options.SNOW_BAND * sizeof(*dvar));
+        check_alloc_status(dvar, "Memory allocation error.");
+
+        d3start[0] = 0;
+        d3start[1] = 0;
+        d3start[2] = 0;
+        d3count[0] = options.SNOW_BAND;
+        d3count[1] = global_domain->n_ny;
+        d3count[2] = global_domain->n_nx;
+        get_nc_field_double(param_nc_name, "AreaFract", d3start, d3count, dvar);
+
+        for (i = 0, k = 0; i < grid_size; i++) {
+            if (global_domain->locations[i].run) {
+                nbands = 0;
+                for (j = 0; j < options.SNOW_BAND; j++) {
+                    if (dvar[j * grid_size +
+                             global_domain->locations[i].io_idx] > 0.) {
+                        nbands++;
+                    }
+                }
+                if (nbands < 1) {
+                    nbands = 1;
+                }
+                cell_costs[k++] *= (double) nbands;
+            }
+        }
+        free(dvar);
+    }
+
+    // lakes
+    if (options.LAKES) {
+        ivar = malloc(grid_size * sizeof(*ivar));
+        check_alloc_status(ivar, "Memory allocation error.");
+
+        get_nc_field_int(param_nc_name, "lake_idx", d2start, d2count, ivar);
+
+        for (i = 0, k = 0; i < grid_size; i++) {
+            if (global_domain->locations[i].run) {
+                if (ivar[global_domain->locations[i].io_idx] != -1) {
+                    cell_costs[k] += DECOMP_LAKE_COST;
+                }
+                k++;
+            }
+        }
+        free(ivar);
+    }
+}
+
 /******************************************************************************
  * @brief    Parse the domain variable types.
  *****************************************************************************/
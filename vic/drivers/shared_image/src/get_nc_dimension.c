@@ -33,29 +33,6 @@ size_t
 get_nc_dimension(char *nc_name,
                  char *dim_name)
 {
-    int    nc_id;
-    int    dim_id;
-    size_t dim_size;
-    int    status;
-
-    // open the netcdf file
-    status = nc_open(nc_name, NC_NOWRITE, &nc_id);
-    check_nc_status(status, "Error opening %s", nc_name);
-
-    // get dimension id
-    status = nc_inq_dimid(nc_id, dim_name, &dim_id);
-    check_nc_status(status, "Error getting dimension id %s in %s", dim_name,
-                    nc_name);
-
-    // get dimension size
-    status = nc_inq_dimlen(nc_id, dim_id, &dim_size);
-    check_nc_status(status, "Error getting dimension size for dim %s in %s",
-                    dim_name,
-                    nc_name);
-
-    // close the netcdf file
-    status = nc_close(nc_id);
-    check_nc_status(status, "Error closing %s", nc_name);
-
-    return dim_size;
+    // get the (cached) dimension of the (cached) netcdf file
+    return get_nc_dim_meta(nc_name, dim_name);
 }
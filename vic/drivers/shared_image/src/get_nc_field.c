@@ -36,27 +36,16 @@ get_nc_field_double(char   *nc_name,
                     size_t *count,
                     double *var)
 {
-    int nc_id;
-    int status;
-    int var_id;
+    int                 status;
+    nc_var_meta_struct *meta;
 
-    // open the netcdf file
-    status = nc_open(nc_name, NC_NOWRITE, &nc_id);
-    check_nc_status(status, "Error opening %s", nc_name);
+    // get the (cached) variable of the (cached) netcdf file
+    meta = get_nc_var_meta(nc_name, var_name);
 
-    /* get NetCDF variable */
-    status = nc_inq_varid(nc_id, var_name, &var_id);
-    check_nc_status(status, "Error getting variable id for %s in %s", var_name,
-                    nc_name);
-
-    status = nc_get_vara_double(nc_id, var_id, start, count, var);
+    status = nc_get_vara_double(meta->nc_id, meta->var_id, start, count, var);
     check_nc_status(status, "Error getting values for %s in %s", var_name,
                     nc_name);
 
-    // close the netcdf file
-    status = nc_close(nc_id);
-    check_nc_status(status, "Error closing %s", nc_name);
-
     return status;
 }
 
@@ -70,27 +59,16 @@ get_nc_field_float(char   *nc_name,
                    size_t *count,
                    float  *var)
 {
-    int nc_id;
-    int status;
-    int var_id;
+    int                 status;
+    nc_var_meta_struct *meta;
 
-    // open the netcdf file
-    status = nc_open(nc_name, NC_NOWRITE, &nc_id);
-    check_nc_status(status, "Error opening %s", nc_name);
-
-    /* get NetCDF variable */
-    status = nc_inq_varid(nc_id, var_name, &var_id);
-    check_nc_status(status, "Error getting variable id for %s in %s", var_name,
-                    nc_name);
+    // get the (cached) variable of the (cached) netcdf file
+    meta = get_nc_var_meta(nc_name, var_name);
 
-    status = nc_get_vara_float(nc_id, var_id, start, count, var);
+    status = nc_get_vara_float(meta->nc_id, meta->var_id, start, count, var);
     check_nc_status(status, "Error getting values for %s in %s", var_name,
                     nc_name);
 
-    // close the netcdf file
-    status = nc_close(nc_id);
-    check_nc_status(status, "Error closing %s", nc_name);
-
     return status;
 }
 
@@ -104,26 +82,38 @@ get_nc_field_int(char   *nc_name,
                  size_t *count,
                  int    *var)
 {
-    int nc_id;
-    int status;
-    int var_id;
+    int                 status;
+    nc_var_meta_struct *meta;
 
-    // open the netcdf file
-    status = nc_open(nc_name, NC_NOWRITE, &nc_id);
-    check_nc_status(status, "Error opening %s", nc_name);
+    // get the (cached) variable of the (cached) netcdf file
+    meta = get_nc_var_meta(nc_name, var_name);
 
-    /* get NetCDF variable */
-    status = nc_inq_varid(nc_id, var_name, &var_id);
-    check_nc_status(status, "Error getting variable id for %s in %s", var_name,
+    status = nc_get_vara_int(meta->nc_id, meta->var_id, start, count, var);
+    check_nc_status(status, "Error getting values for %s in %s", var_name,
                     nc_name);
 
-    status = nc_get_vara_int(nc_id, var_id, start, count, var);
+    return status;
+}
+
+/******************************************************************************
+ * @brief    Read short integer netCDF field from file.
+ *****************************************************************************/
+int
+get_nc_field_short(char      *nc_name,
+                   char      *var_name,
+                   size_t    *start,
+                   size_t    *count,
+                   short int *var)
+{
+    int                 status;
+    nc_var_meta_struct *meta;
+
+    // get the (cached) variable of the (cached) netcdf file
+    meta = get_nc_var_meta(nc_name, var_name);
+
+    status = nc_get_vara_short(meta->nc_id, meta->var_id, start, count, var);
     check_nc_status(status, "Error getting values for %s in %s", var_name,
                     nc_name);
 
-    // close the netcdf file
-    status = nc_close(nc_id);
-    check_nc_status(status, "Error closing %s", nc_name);
-
     return status;
 }
@@ -35,19 +35,16 @@ get_nc_var_attr(char  *nc_name,
                 char  *attr_name,
                 char **attr)
 {
-    int    nc_id;
-    int    var_id;
-    int    status;
-    size_t attr_len;
+    int                 nc_id;
+    int                 var_id;
+    int                 status;
+    size_t              attr_len;
+    nc_var_meta_struct *meta;
 
-    // open the netcdf file
-    status = nc_open(nc_name, NC_NOWRITE, &nc_id);
-    check_nc_status(status, "Error opening %s", nc_name);
-
-    // get variable id
-    status = nc_inq_varid(nc_id, var_name, &var_id);
-    check_nc_status(status, "Error getting variable id %s in %s", var_name,
-                    nc_name);
+    // get the (cached) variable of the (cached) netcdf file
+    meta = get_nc_var_meta(nc_name, var_name);
+    nc_id = meta->nc_id;
+    var_id = meta->var_id;
 
     // get size of the attribute
     status = nc_inq_attlen(nc_id, var_id, attr_name, &attr_len);
@@ -68,8 +65,40 @@ get_nc_var_attr(char  *nc_name,
 
     // we need to null terminate the string ourselves according to NetCDF docs
     (*attr)[attr_len] = '\0';
+}
+
+/******************************************************************************
+ * @brief    Get the packing attributes of a netCDF variable.
+ * @details  The unpacked value is packed * scale_factor + add_offset. A
+ *           missing attribute leaves the value unchanged (1 and 0).
+ *****************************************************************************/
+void
+get_nc_var_packing(char   *nc_name,
+                   char   *var_name,
+                   double *scale_factor,
+                   double *add_offset)
+{
+    int                 nc_id;
+    int                 var_id;
+    int                 status;
+    nc_var_meta_struct *meta;
+
+    // get the (cached) variable of the (cached) netcdf file
+    meta = get_nc_var_meta(nc_name, var_name);
+    nc_id = meta->nc_id;
+    var_id = meta->var_id;
+
+    *scale_factor = 1.;
+    status = nc_get_att_double(nc_id, var_id, "scale_factor", scale_factor);
+    if (status != NC_ENOTATT) {
+        check_nc_status(status, "Error getting scale_factor for %s in %s",
+                        var_name, nc_name);
+    }
 
-    // close the netcdf file
-    status = nc_close(nc_id);
-    check_nc_status(status, "Error closing %s", nc_name);
+    *add_offset = 0.;
+    status = nc_get_att_double(nc_id, var_id, "add_offset", add_offset);
+    if (status != NC_ENOTATT) {
+        check_nc_status(status, "Error getting add_offset for %s in %s",
+                        var_name, nc_name);
+    }
 }
@@ -33,30 +33,6 @@ int
 get_nc_varndimensions(char *nc_name,
                       char *var_name)
 {
-    int nc_id;
-    int var_id;
-    int ndims;
-    int status;
-
-    // open the netcdf file
-    status = nc_open(nc_name, NC_NOWRITE, &nc_id);
-    check_nc_status(status, "Error opening %s", nc_name);
-
-    // get variable id
-    status = nc_inq_varid(nc_id, var_name, &var_id);
-    check_nc_status(status, "Error getting variable id %s in %s", var_name,
-                    nc_name);
-
-    // get number of dimensions
-    status = nc_inq_varndims(nc_id, var_id, &ndims);
-    check_nc_status(status,
-                    "Error getting number of dimensions for var %s in %s",
-                    var_name,
-                    nc_name);
-
-    // close the netcdf file
-    status = nc_close(nc_id);
-    check_nc_status(status, "Error closing %s", nc_name);
-
-    return ndims;
+    // get the (cached) variable of the (cached) netcdf file
+    return get_nc_var_meta(nc_name, var_name)->ndims;
 }
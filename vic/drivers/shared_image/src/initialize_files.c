@@ -44,6 +44,14 @@ initialize_filenames()
     strcpy(filenames.params, "MISSING");
     strcpy(filenames.result_dir, "MISSING");
     strcpy(filenames.log_path, "MISSING");
+    strcpy(filenames.decomp_cost, "MISSING");
+    strcpy(filenames.cost_map, "MISSING");
+    strcpy(filenames.trace, "MISSING");
+    strcpy(filenames.param_cache, "MISSING");
+    strcpy(filenames.rout_params, "MISSING");
+    strcpy(filenames.checkpoint, "MISSING");
+    strcpy(filenames.da_port, "MISSING");
+    strcpy(filenames.force_stage, "MISSING");
     for (i = 0; i < 2; i++) {
         strcpy(filenames.f_path_pfx[i], "MISSING");
     }
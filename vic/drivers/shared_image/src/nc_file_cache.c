@@ -0,0 +1,277 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Cache of open netCDF input files and of the metadata of their variables
+ * and dimensions.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+/******************************************************************************
+ * @brief    Open netCDF input files, keyed by file name.
+ * @details  Files opened for parallel access by all nodes (PARALLEL_IO) are
+ *           kept in a cache of their own. Opening and closing those is
+ *           collective, so the parallel cache must evolve in the same way on
+ *           all nodes, independent of the files that only the master node
+ *           opens.
+ *****************************************************************************/
+static nc_file_cache_struct nc_file_cache[MAX_NC_FILE_CACHE];
+static nc_file_cache_struct nc_par_file_cache[MAX_NC_FILE_CACHE];
+
+/******************************************************************************
+ * @brief    Find a file in a cache, or make room for it.
+ * @details  Returns the slot of the file. If the file is not open yet, the
+ *           slot is free and the caller has to open the file.
+ *****************************************************************************/
+static size_t
+find_nc_file_slot(nc_file_cache_struct *cache,
+                  size_t               *next,
+                  char                 *nc_name)
+{
+    size_t i;
+    int    status;
+
+    for (i = 0; i < MAX_NC_FILE_CACHE; i++) {
+        if (cache[i].open && strcmp(cache[i].name, nc_name) == 0) {
+            return i;
+        }
+    }
+
+    // use an empty slot or replace the oldest file
+    for (i = 0; i < MAX_NC_FILE_CACHE; i++) {
+        if (!cache[i].open) {
+            return i;
+        }
+    }
+    i = *next;
+    *next = (*next + 1) % MAX_NC_FILE_CACHE;
+    status = nc_close(cache[i].nc_id);
+    check_nc_status(status, "Error closing %s", cache[i].name);
+    cache[i].open = false;
+
+    return i;
+}
+
+/******************************************************************************
+ * @brief    Get the id of a netCDF input file, opening it if it is not
+ *           already open.
+ * @details  Files stay open until they are closed with close_nc_file() or
+ *           close_nc_files(), so that repeated reads from the same file
+ *           (e.g. one forcing variable per time step) do not reread the
+ *           file header each time. If the cache is full, one of the open
+ *           files is closed to make room.
+ *****************************************************************************/
+int
+get_nc_file_id(char *nc_name)
+{
+    static size_t nc_file_cache_next = 0;
+
+    size_t        i;
+    int           status;
+
+    i = find_nc_file_slot(nc_file_cache, &nc_file_cache_next, nc_name);
+    if (!nc_file_cache[i].open) {
+        // open the netcdf file
+        status = nc_open(nc_name, NC_NOWRITE, &(nc_file_cache[i].nc_id));
+        check_nc_status(status, "Error opening %s", nc_name);
+        strcpy(nc_file_cache[i].name, nc_name);
+        nc_file_cache[i].open = true;
+        nc_file_cache[i].nvars = 0;
+        nc_file_cache[i].ndims = 0;
+    }
+
+    return nc_file_cache[i].nc_id;
+}
+
+/******************************************************************************
+ * @brief    Get the cache entry of a netCDF input file, opening it if it is
+ *           not already open.
+ *****************************************************************************/
+static nc_file_cache_struct *
+get_nc_file_entry(char *nc_name)
+{
+    size_t i;
+
+    get_nc_file_id(nc_name);
+    for (i = 0; i < MAX_NC_FILE_CACHE; i++) {
+        if (nc_file_cache[i].open &&
+            strcmp(nc_file_cache[i].name, nc_name) == 0) {
+            break;
+        }
+    }
+
+    return &(nc_file_cache[i]);
+}
+
+/******************************************************************************
+ * @brief    Get the metadata of a variable of a netCDF input file.
+ * @details  The id, type and number of dimensions of a variable are queried
+ *           once per open file, so that the repeated lookups of the same
+ *           variable (e.g. a forcing variable per time step, or the
+ *           coordinates at initialization) are a search of the cache. If
+ *           the cache of the file is full, the oldest variable is replaced.
+ *           The entry is valid until the next call.
+ *****************************************************************************/
+nc_var_meta_struct *
+get_nc_var_meta(char *nc_name,
+                char *var_name)
+{
+    size_t                i;
+    int                   status;
+    nc_file_cache_struct *entry;
+    nc_var_meta_struct   *meta;
+
+    entry = get_nc_file_entry(nc_name);
+    for (i = 0; i < entry->nvars && i < MAX_NC_META_CACHE; i++) {
+        if (strcmp(entry->vars[i].name, var_name) == 0) {
+            return &(entry->vars[i]);
+        }
+    }
+
+    meta = &(entry->vars[entry->nvars % MAX_NC_META_CACHE]);
+    entry->nvars++;
+    meta->nc_id = entry->nc_id;
+
+    status = nc_inq_varid(entry->nc_id, var_name, &(meta->var_id));
+    check_nc_status(status, "Error getting variable id %s in %s", var_name,
+                    nc_name);
+    status = nc_inq_var(entry->nc_id, meta->var_id, NULL, &(meta->xtype),
+                        &(meta->ndims), NULL, NULL);
+    check_nc_status(status, "Error getting variable info %s in %s", var_name,
+                    nc_name);
+    snprintf(meta->name, sizeof(meta->name), "%s", var_name);
+
+    return meta;
+}
+
+/******************************************************************************
+ * @brief    Get the length of a dimension of a netCDF input file.
+ * @details  Queried once per open file, see get_nc_var_meta().
+ *****************************************************************************/
+size_t
+get_nc_dim_meta(char *nc_name,
+                char *dim_name)
+{
+    size_t                i;
+    int                   dim_id;
+    int                   status;
+    nc_file_cache_struct *entry;
+    nc_dim_meta_struct   *meta;
+
+    entry = get_nc_file_entry(nc_name);
+    for (i = 0; i < entry->ndims && i < MAX_NC_META_CACHE; i++) {
+        if (strcmp(entry->dims[i].name, dim_name) == 0) {
+            return entry->dims[i].len;
+        }
+    }
+
+    meta = &(entry->dims[entry->ndims % MAX_NC_META_CACHE]);
+    entry->ndims++;
+
+    // get dimension id
+    status = nc_inq_dimid(entry->nc_id, dim_name, &dim_id);
+    check_nc_status(status, "Error getting dimension id %s in %s", dim_name,
+                    nc_name);
+
+    // get dimension size
+    status = nc_inq_dimlen(entry->nc_id, dim_id, &(meta->len));
+    check_nc_status(status, "Error getting dimension size for dim %s in %s",
+                    dim_name, nc_name);
+    snprintf(meta->name, sizeof(meta->name), "%s", dim_name);
+
+    return meta->len;
+}
+
+/******************************************************************************
+ * @brief    Get the id of a netCDF input file opened for parallel access,
+ *           opening it if it is not already open.
+ * @details  Must be called by all nodes.
+ *****************************************************************************/
+int
+get_par_nc_file_id(char *nc_name)
+{
+    static size_t nc_par_file_cache_next = 0;
+
+    size_t        i;
+
+    i = find_nc_file_slot(nc_par_file_cache, &nc_par_file_cache_next,
+                          nc_name);
+    if (!nc_par_file_cache[i].open) {
+        // open the netcdf file
+        open_par_nc_file(nc_name, &(nc_par_file_cache[i].nc_id));
+        strcpy(nc_par_file_cache[i].name, nc_name);
+        nc_par_file_cache[i].open = true;
+    }
+
+    return nc_par_file_cache[i].nc_id;
+}
+
+/******************************************************************************
+ * @brief    Close a netCDF input file if it is open.
+ *****************************************************************************/
+void
+close_nc_file(char *nc_name)
+{
+    size_t i;
+    int    status;
+
+    for (i = 0; i < MAX_NC_FILE_CACHE; i++) {
+        if (nc_file_cache[i].open &&
+            strcmp(nc_file_cache[i].name, nc_name) == 0) {
+            status = nc_close(nc_file_cache[i].nc_id);
+            check_nc_status(status, "Error closing %s", nc_name);
+            nc_file_cache[i].open = false;
+        }
+        if (nc_par_file_cache[i].open &&
+            strcmp(nc_par_file_cache[i].name, nc_name) == 0) {
+            status = nc_close(nc_par_file_cache[i].nc_id);
+            check_nc_status(status, "Error closing %s", nc_name);
+            nc_par_file_cache[i].open = false;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Close all open netCDF input files.
+ *****************************************************************************/
+void
+close_nc_files(void)
+{
+    size_t i;
+    int    status;
+
+    for (i = 0; i < MAX_NC_FILE_CACHE; i++) {
+        if (nc_file_cache[i].open) {
+            status = nc_close(nc_file_cache[i].nc_id);
+            check_nc_status(status, "Error closing %s",
+                            nc_file_cache[i].name);
+            nc_file_cache[i].open = false;
+        }
+        if (nc_par_file_cache[i].open) {
+            status = nc_close(nc_par_file_cache[i].nc_id);
+            check_nc_status(status, "Error closing %s",
+                            nc_par_file_cache[i].name);
+            nc_par_file_cache[i].open = false;
+        }
+    }
+}
@@ -50,12 +50,14 @@ parse_output_info(FILE           *gp,
     int                        type;
     char                       multstr[MAXSTRING];
     char                       aggstr[MAXSTRING];
+    char                       digitstr[MAXSTRING];
     double                     mult;
     unsigned short int         freq;
     int                        freq_n;
     dmy_struct                 freq_dmy;
     unsigned short int         agg_type;
     int                        found;
+    int                        i;
 
     streamnum = -1;
 
@@ -184,6 +186,140 @@ parse_output_info(FILE           *gp,
                     (*streams)[streamnum].compress = atoi(flgstr);
                 }
             }
+            else if (strcasecmp("SHUFFLE", optstr) == 0) {
+                if (streamnum < 0) {
+                    log_err("Error in global param file: \"OUTFILE\" must be "
+                            "specified before you can specify \"SHUFFLE\".");
+                }
+                sscanf(cmdstr, "%*s %s", flgstr);
+                (*streams)[streamnum].shuffle = str_to_bool(flgstr);
+            }
+            else if (strcasecmp("OUTMASK", optstr) == 0) {
+                if (streamnum < 0) {
+                    log_err("Error in global param file: \"OUTFILE\" must be "
+                            "specified before you can specify \"OUTMASK\".");
+                }
+                if (sscanf(cmdstr, "%*s %s",
+                           (*streams)[streamnum].mask) != 1) {
+                    log_err("OUTMASK requires the name of a variable of the "
+                            "domain file");
+                }
+            }
+            else if (strcasecmp("OUTREGION", optstr) == 0) {
+                if (streamnum < 0) {
+                    log_err("Error in global param file: \"OUTFILE\" must be "
+                            "specified before you can specify \"OUTREGION\".");
+                }
+                found = sscanf(cmdstr, "%*s %s %s",
+                               (*streams)[streamnum].region, flgstr);
+                if (found < 1) {
+                    log_err("OUTREGION requires the name of a variable of the "
+                            "domain file");
+                }
+                if (found < 2 || strcasecmp("MEAN", flgstr) == 0) {
+                    (*streams)[streamnum].region_reduce = REGION_MEAN;
+                }
+                else if (strcasecmp("SUM", flgstr) == 0) {
+                    (*streams)[streamnum].region_reduce = REGION_SUM;
+                }
+                else {
+                    log_err("Unknown OUTREGION reduction: %s", flgstr);
+                }
+            }
+            else if (strcasecmp("CHUNK", optstr) == 0) {
+                if (streamnum < 0) {
+                    log_err("Error in global param file: \"OUTFILE\" must be "
+                            "specified before you can specify \"CHUNK\".");
+                }
+                found = sscanf(cmdstr, "%*s %s %d %d %d", flgstr,
+                               &((*streams)[streamnum].chunk_n[0]),
+                               &((*streams)[streamnum].chunk_n[1]),
+                               &((*streams)[streamnum].chunk_n[2]));
+                if (found < 1) {
+                    log_err("No arguments found after CHUNK");
+                }
+                if (strcasecmp("DEFAULT", flgstr) == 0) {
+                    (*streams)[streamnum].chunk = CHUNK_DEFAULT;
+                }
+                else if (strcasecmp("SLICE", flgstr) == 0) {
+                    (*streams)[streamnum].chunk = CHUNK_SLICE;
+                }
+                else if (strcasecmp("SERIES", flgstr) == 0) {
+                    (*streams)[streamnum].chunk = CHUNK_SERIES;
+                    if (found < 2 || (*streams)[streamnum].chunk_n[0] < 1) {
+                        log_err("CHUNK SERIES requires a number of records "
+                                "of at least 1");
+                    }
+                    if (found == 3) {
+                        log_err("CHUNK SERIES requires both a number of rows "
+                                "and a number of columns");
+                    }
+                    if (found == 4 &&
+                        ((*streams)[streamnum].chunk_n[1] < 0 ||
+                         (*streams)[streamnum].chunk_n[2] < 0)) {
+                        log_err("CHUNK SERIES rows and columns must not be "
+                                "negative");
+                    }
+                }
+                else {
+                    log_err("Unknown CHUNK option: %s", flgstr);
+                }
+                // unused counts fall back to the full extent
+                for (i = found - 1; i < 3; i++) {
+                    (*streams)[streamnum].chunk_n[i] = 0;
+                }
+            }
+            else if (strcasecmp("CHUNK_CACHE", optstr) == 0) {
+                if (streamnum < 0) {
+                    log_err("Error in global param file: \"OUTFILE\" must be "
+                            "specified before you can specify "
+                            "\"CHUNK_CACHE\".");
+                }
+                found = sscanf(cmdstr, "%*s %d",
+                               &((*streams)[streamnum].chunk_cache));
+                if (found != 1 || (*streams)[streamnum].chunk_cache < 0) {
+                    log_err("CHUNK_CACHE must be a size in MB of at least 0");
+                }
+            }
+            else if (strcasecmp("FLUSH", optstr) == 0) {
+                if (streamnum < 0) {
+                    log_err("Error in global param file: \"OUTFILE\" must be "
+                            "specified before you can specify \"FLUSH\".");
+                }
+                found = sscanf(cmdstr, "%*s %s %s", flgstr, freq_value_str);
+                if (found < 1) {
+                    log_err("No arguments found after FLUSH");
+                }
+                if (strcasecmp("ALWAYS", flgstr) == 0) {
+                    (*streams)[streamnum].flush = FLUSH_ALWAYS;
+                }
+                else if (strcasecmp("NEVER", flgstr) == 0) {
+                    (*streams)[streamnum].flush = FLUSH_NEVER;
+                }
+                else if (strcasecmp("STATE", flgstr) == 0) {
+                    (*streams)[streamnum].flush = FLUSH_STATE;
+                }
+                else if (strcasecmp("NRECORDS", flgstr) == 0 ||
+                         strcasecmp("SECONDS", flgstr) == 0) {
+                    if (strcasecmp("NRECORDS", flgstr) == 0) {
+                        (*streams)[streamnum].flush = FLUSH_NRECORDS;
+                    }
+                    else {
+                        (*streams)[streamnum].flush = FLUSH_SECONDS;
+                    }
+                    if (found != 2) {
+                        log_err("FLUSH %s requires a number", flgstr);
+                    }
+                    (*streams)[streamnum].flush_n = atoi(freq_value_str);
+                    if ((*streams)[streamnum].flush_n < 1) {
+                        log_err("FLUSH %s must be at least 1, found %s",
+                                flgstr, freq_value_str);
+                    }
+                }
+                else {
+                    log_err("Unknown FLUSH option: %s", flgstr);
+                }
+            }
             else if (strcasecmp("OUT_FORMAT", optstr) == 0) {
                 if (streamnum < 0) {
                     log_err("Error in global param file: \"OUTFILE\" must be "
@@ -203,9 +339,16 @@ parse_output_info(FILE           *gp,
                 else if (strcasecmp("NETCDF4", flgstr) == 0) {
                     (*streams)[streamnum].file_format = NETCDF4;
                 }
+                else if (strcasecmp("ADIOS2_SST", flgstr) == 0) {
+                    (*streams)[streamnum].file_format = ADIOS2_SST;
+                }
+                else if (strcasecmp("ADIOS2_BP5", flgstr) == 0) {
+                    (*streams)[streamnum].file_format = ADIOS2_BP5;
+                }
                 else {
                     log_err(
-                        "Image driver file format must be a valid NETCDF format");
+                        "Image driver file format must be a valid NETCDF "
+                        "format or ADIOS2 engine");
                 }
             }
             else if (strcasecmp("OUTVAR", optstr) == 0) {
@@ -219,8 +362,9 @@ parse_output_info(FILE           *gp,
                 strcpy(typestr, "");
                 strcpy(multstr, "");
                 strcpy(aggstr, "");
-                found = sscanf(cmdstr, "%*s %s %s %s %s %s", varname,
-                               format, typestr, multstr, aggstr);
+                strcpy(digitstr, "");
+                found = sscanf(cmdstr, "%*s %s %s %s %s %s %s", varname,
+                               format, typestr, multstr, aggstr, digitstr);
                 if (!found) {
                     log_err("OUTVAR specified but no variable was listed");
                 }
@@ -233,6 +377,21 @@ parse_output_info(FILE           *gp,
                 // Add OUTVAR to stream
                 set_output_var(&((*streams)[streamnum]), varname, outvarnum,
                                format, type, mult, agg_type);
+                (*streams)[streamnum].aggparam[outvarnum] =
+                    str_to_agg_param(aggstr);
+
+                // significant digits of the history file (lossy compression)
+                if (strcmp(digitstr, "") != 0 &&
+                    strcasecmp(digitstr, "*") != 0) {
+                    (*streams)[streamnum].digits[outvarnum] = atoi(digitstr);
+                    if ((*streams)[streamnum].digits[outvarnum] < 1 ||
+                        (*streams)[streamnum].digits[outvarnum] >
+                        MAX_HISTORY_DIGITS) {
+                        log_err("The significant digits of OUTVAR %s must be "
+                                "between 1 and %d", varname,
+                                MAX_HISTORY_DIGITS);
+                    }
+                }
                 outvarnum++;
             }
         }
@@ -151,6 +151,7 @@ print_nc_file(nc_file_struct *nc)
     fprintf(LOG_DEST, "\ttime_size      : %zd\n", nc->time_size);
     fprintf(LOG_DEST, "\tveg_size       : %zd\n", nc->veg_size);
     fprintf(LOG_DEST, "\topen           : %d\n", nc->open);
+    fprintf(LOG_DEST, "\tsplit          : %d\n", nc->split);
 }
 
 /******************************************************************************
@@ -188,6 +189,7 @@ print_veg_con_map(veg_con_map_struct *veg_con_map)
     fprintf(LOG_DEST, "veg_con_map:\n");
     fprintf(LOG_DEST, "\tnv_types : %zd\n", veg_con_map->nv_types);
     fprintf(LOG_DEST, "\tnv_active: %zd\n", veg_con_map->nv_active);
+    fprintf(LOG_DEST, "\tnv_classes: %zd\n", veg_con_map->nv_classes);
     for (i = 0; i < veg_con_map->nv_types; i++) {
         fprintf(LOG_DEST, "\t%zd      : %d (vidx) %f (Cv)\n", i,
                 veg_con_map->vidx[i],
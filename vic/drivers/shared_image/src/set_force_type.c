@@ -108,6 +108,14 @@ set_force_type(char *cmdstr,
     else if (strcasecmp("SWDOWN", optstr) == 0) {
         type = SWDOWN;
     }
+    /* daily maximum air temperature [C] */
+    else if (strcasecmp("TMAX", optstr) == 0) {
+        type = TMAX;
+    }
+    /* daily minimum air temperature [C] */
+    else if (strcasecmp("TMIN", optstr) == 0) {
+        type = TMIN;
+    }
     /* type 12: vegetation cover fraction */
     else if (strcasecmp("FCANOPY", optstr) == 0) {
         type = FCANOPY;
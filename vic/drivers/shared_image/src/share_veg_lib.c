@@ -0,0 +1,399 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Share one vegetation library between the grid cells of a node.
+ *
+ * With NODE_SHARED_TABLES, the libraries are further shared between the MPI
+ * processes that run on the same compute node.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+#include <stdint.h>
+
+static veg_lib_struct **veg_lib_tables = NULL;
+static size_t           Nveg_lib_tables = 0;
+static size_t          *veg_lib_index = NULL;
+static MPI_Comm         veg_lib_node_comm = MPI_COMM_NULL;
+static MPI_Win          veg_lib_win = MPI_WIN_NULL;
+
+/******************************************************************************
+ * @brief    FNV-1a hash of the vegetation library of a grid cell.
+ *****************************************************************************/
+static uint64_t
+hash_veg_lib(veg_lib_struct *veg_lib,
+             size_t          nbytes)
+{
+    unsigned char *bytes = (unsigned char *) veg_lib;
+    uint64_t       hash = 14695981039346656037ULL;
+    size_t         i;
+
+    for (i = 0; i < nbytes; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/******************************************************************************
+ * @brief    Share one vegetation library between the grid cells of a node.
+ *
+ * @details  Must be called after the monthly vegetation parameters have been
+ *           copied to the vegetation tiles in veg_con, which hold them for
+ *           each grid cell from then on. The monthly arrays of the library
+ *           are cleared, and grid cells whose remaining library is identical
+ *           then point to one shared, read-only copy. A grid cell whose
+ *           library differs from all others keeps its own copy, so the
+ *           results do not depend on whether the library is spatially
+ *           uniform. free_veg_lib() frees the shared copies.
+ *****************************************************************************/
+void
+share_veg_lib(void)
+{
+    extern domain_struct    local_domain;
+    extern option_struct    options;
+    extern veg_lib_struct **veg_lib;
+
+    size_t                  i;
+    size_t                  j;
+    size_t                  k;
+    size_t                  nbytes;
+    size_t                  nslots;
+    size_t                  slot;
+    size_t                 *slots;
+    uint64_t               *hashes;
+    uint64_t                hash;
+    veg_lib_struct         *lib;
+
+    if (local_domain.ncells_active == 0) {
+        return;
+    }
+
+    nbytes = options.NVEGTYPES * sizeof(*(veg_lib[0]));
+
+    // open addressing table of the distinct libraries, at most half full
+    nslots = 1;
+    while (nslots < 2 * local_domain.ncells_active) {
+        nslots *= 2;
+    }
+    slots = malloc(nslots * sizeof(*slots));
+    check_alloc_status(slots, "Memory allocation error.");
+    hashes = malloc(nslots * sizeof(*hashes));
+    check_alloc_status(hashes, "Memory allocation error.");
+    for (slot = 0; slot < nslots; slot++) {
+        slots[slot] = local_domain.ncells_active;
+    }
+
+    veg_lib_tables = malloc(local_domain.ncells_active *
+                            sizeof(*veg_lib_tables));
+    check_alloc_status(veg_lib_tables, "Memory allocation error.");
+    veg_lib_index = malloc(local_domain.ncells_active *
+                           sizeof(*veg_lib_index));
+    check_alloc_status(veg_lib_index, "Memory allocation error.");
+    Nveg_lib_tables = 0;
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        lib = veg_lib[i];
+
+        // the monthly parameters are read from veg_con
+        for (j = 0; j < options.NVEGTYPES; j++) {
+            for (k = 0; k < MONTHS_PER_YEAR; k++) {
+                lib[j].albedo[k] = 0.;
+                lib[j].displacement[k] = 0.;
+                lib[j].emissivity[k] = 0.;
+                lib[j].fcanopy[k] = 0.;
+                lib[j].LAI[k] = 0.;
+                lib[j].roughness[k] = 0.;
+                lib[j].Wdmax[k] = 0.;
+            }
+        }
+
+        hash = hash_veg_lib(lib, nbytes);
+        slot = (size_t) hash & (nslots - 1);
+        while (slots[slot] < local_domain.ncells_active) {
+            if (hashes[slot] == hash &&
+                memcmp(veg_lib_tables[slots[slot]], lib, nbytes) == 0) {
+                break;
+            }
+            slot = (slot + 1) & (nslots - 1);
+        }
+
+        if (slots[slot] < local_domain.ncells_active) {
+            // an identical library exists already
+            veg_lib[i] = veg_lib_tables[slots[slot]];
+            veg_lib_index[i] = slots[slot];
+            free(lib);
+        }
+        else {
+            slots[slot] = Nveg_lib_tables;
+            hashes[slot] = hash;
+            veg_lib_index[i] = Nveg_lib_tables;
+            veg_lib_tables[Nveg_lib_tables++] = lib;
+        }
+    }
+
+    log_info("%zu distinct vegetation libraries for %zu grid cells",
+             Nveg_lib_tables, local_domain.ncells_active);
+
+    free(slots);
+    free(hashes);
+}
+
+/******************************************************************************
+ * @brief    Distinct vegetation libraries of the grid cells of a node.
+ *
+ * @details  Only valid after share_veg_lib(). Returns the number of shared
+ *           libraries, tables is set to the libraries and index to the
+ *           library of each grid cell.
+ *****************************************************************************/
+size_t
+get_veg_lib_tables(veg_lib_struct ***tables,
+                   size_t          **index)
+{
+    *tables = veg_lib_tables;
+    *index = veg_lib_index;
+
+    return Nveg_lib_tables;
+}
+
+/******************************************************************************
+ * @brief    Share the vegetation libraries between the MPI processes of a
+ *           compute node.
+ *
+ * @details  Must be called by all processes after share_veg_lib(). The
+ *           distinct libraries of the processes of a compute node are
+ *           gathered on the first process of the node, which keeps one copy
+ *           of each in an MPI-3 shared memory window. All processes of the
+ *           node then point their grid cells to the copies in the window and
+ *           free their own. free_veg_lib() frees the window.
+ *****************************************************************************/
+void
+share_node_veg_lib(void)
+{
+    extern domain_struct    local_domain;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern option_struct    options;
+    extern veg_lib_struct **veg_lib;
+
+    MPI_Datatype            lib_type;
+    MPI_Aint                win_size;
+    veg_lib_struct         *libs = NULL;
+    veg_lib_struct         *node_libs = NULL;
+    veg_lib_struct         *win_libs = NULL;
+    uint64_t               *hashes = NULL;
+    uint64_t                hash;
+    size_t                  nbytes;
+    size_t                  nslots;
+    size_t                  nunique;
+    size_t                  slot;
+    size_t                 *slots = NULL;
+    size_t                  i;
+    int                     node_rank;
+    int                     node_size;
+    int                     nlibs;
+    int                     nlibs_node;
+    int                     disp_unit;
+    int                    *counts = NULL;
+    int                    *displs = NULL;
+    int                    *local_map = NULL;
+    int                    *node_map = NULL;
+    int                     status;
+
+    status = MPI_Comm_split_type(MPI_COMM_VIC, MPI_COMM_TYPE_SHARED, 0,
+                                 MPI_INFO_NULL, &veg_lib_node_comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_rank(veg_lib_node_comm, &node_rank);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_size(veg_lib_node_comm, &node_size);
+    check_mpi_status(status, "MPI error.");
+
+    // one element is the library of a grid cell
+    nbytes = options.NVEGTYPES * sizeof(*(veg_lib[0]));
+    status = MPI_Type_contiguous((int) nbytes, MPI_BYTE, &lib_type);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Type_commit(&lib_type);
+    check_mpi_status(status, "MPI error.");
+
+    // the libraries of this process, one after the other
+    nlibs = (int) Nveg_lib_tables;
+    libs = malloc((Nveg_lib_tables + 1) * nbytes);
+    check_alloc_status(libs, "Memory allocation error.");
+    for (i = 0; i < Nveg_lib_tables; i++) {
+        memcpy(&(libs[i * options.NVEGTYPES]), veg_lib_tables[i], nbytes);
+    }
+
+    // gather the libraries of the node on its first process
+    if (node_rank == 0) {
+        counts = malloc(node_size * sizeof(*counts));
+        check_alloc_status(counts, "Memory allocation error.");
+        displs = malloc(node_size * sizeof(*displs));
+        check_alloc_status(displs, "Memory allocation error.");
+    }
+    status = MPI_Gather(&nlibs, 1, MPI_INT, counts, 1, MPI_INT, 0,
+                        veg_lib_node_comm);
+    check_mpi_status(status, "MPI error.");
+    nlibs_node = 0;
+    if (node_rank == 0) {
+        for (i = 0; i < (size_t) node_size; i++) {
+            displs[i] = nlibs_node;
+            nlibs_node += counts[i];
+        }
+        node_libs = malloc((nlibs_node + 1) * nbytes);
+        check_alloc_status(node_libs, "Memory allocation error.");
+        node_map = malloc((nlibs_node + 1) * sizeof(*node_map));
+        check_alloc_status(node_map, "Memory allocation error.");
+    }
+    status = MPI_Gatherv(libs, nlibs, lib_type, node_libs, counts, displs,
+                         lib_type, 0, veg_lib_node_comm);
+    check_mpi_status(status, "MPI error.");
+
+    // find the distinct libraries of the node, in place at the front of
+    // node_libs
+    nunique = 0;
+    if (node_rank == 0) {
+        nslots = 1;
+        while (nslots < 2 * (size_t) nlibs_node) {
+            nslots *= 2;
+        }
+        slots = malloc(nslots * sizeof(*slots));
+        check_alloc_status(slots, "Memory allocation error.");
+        hashes = malloc(nslots * sizeof(*hashes));
+        check_alloc_status(hashes, "Memory allocation error.");
+        for (slot = 0; slot < nslots; slot++) {
+            slots[slot] = (size_t) nlibs_node;
+        }
+        for (i = 0; i < (size_t) nlibs_node; i++) {
+            hash = hash_veg_lib(&(node_libs[i * options.NVEGTYPES]), nbytes);
+            slot = (size_t) hash & (nslots - 1);
+            while (slots[slot] < (size_t) nlibs_node) {
+                if (hashes[slot] == hash &&
+                    memcmp(&(node_libs[slots[slot] * options.NVEGTYPES]),
+                           &(node_libs[i * options.NVEGTYPES]),
+                           nbytes) == 0) {
+                    break;
+                }
+                slot = (slot + 1) & (nslots - 1);
+            }
+            if (slots[slot] == (size_t) nlibs_node) {
+                if (nunique < i) {
+                    memcpy(&(node_libs[nunique * options.NVEGTYPES]),
+                           &(node_libs[i * options.NVEGTYPES]), nbytes);
+                }
+                slots[slot] = nunique;
+                hashes[slot] = hash;
+                nunique++;
+            }
+            node_map[i] = (int) slots[slot];
+        }
+        free(slots);
+        free(hashes);
+    }
+
+    // one copy of the distinct libraries in the memory of the node
+    win_size = 0;
+    if (node_rank == 0) {
+        win_size = (MPI_Aint) (nunique * nbytes);
+    }
+    status = MPI_Win_allocate_shared(win_size, 1, MPI_INFO_NULL,
+                                     veg_lib_node_comm, &win_libs,
+                                     &veg_lib_win);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Win_shared_query(veg_lib_win, 0, &win_size, &disp_unit,
+                                  &win_libs);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Win_fence(0, veg_lib_win);
+    check_mpi_status(status, "MPI error.");
+    if (node_rank == 0) {
+        memcpy(win_libs, node_libs, nunique * nbytes);
+        log_info("%zu distinct vegetation libraries on the compute node of "
+                 "%d processes", nunique, node_size);
+    }
+    status = MPI_Win_fence(0, veg_lib_win);
+    check_mpi_status(status, "MPI error.");
+
+    // point the grid cells to the shared copies
+    local_map = malloc((Nveg_lib_tables + 1) * sizeof(*local_map));
+    check_alloc_status(local_map, "Memory allocation error.");
+    status = MPI_Scatterv(node_map, counts, displs, MPI_INT, local_map, nlibs,
+                          MPI_INT, 0, veg_lib_node_comm);
+    check_mpi_status(status, "MPI error.");
+    for (i = 0; i < Nveg_lib_tables; i++) {
+        free(veg_lib_tables[i]);
+        veg_lib_tables[i] = &(win_libs[local_map[i] * options.NVEGTYPES]);
+    }
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        veg_lib[i] = veg_lib_tables[veg_lib_index[i]];
+    }
+
+    status = MPI_Type_free(&lib_type);
+    check_mpi_status(status, "MPI error.");
+    free(libs);
+    free(node_libs);
+    free(node_map);
+    free(local_map);
+    free(counts);
+    free(displs);
+}
+
+/******************************************************************************
+ * @brief    Free the vegetation libraries of the grid cells.
+ * @details  Must be called by all processes if NODE_SHARED_TABLES is TRUE.
+ *****************************************************************************/
+void
+free_veg_lib(void)
+{
+    extern domain_struct    local_domain;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern veg_lib_struct **veg_lib;
+
+    size_t                  i;
+    int                     status;
+
+    if (veg_lib_tables == NULL) {
+        // the libraries were not shared
+        for (i = 0; i < local_domain.ncells_active; i++) {
+            free(veg_lib[i]);
+        }
+    }
+    else {
+        if (veg_lib_win == MPI_WIN_NULL) {
+            for (i = 0; i < Nveg_lib_tables; i++) {
+                free(veg_lib_tables[i]);
+            }
+        }
+        free(veg_lib_tables);
+        free(veg_lib_index);
+        veg_lib_tables = NULL;
+        veg_lib_index = NULL;
+        Nveg_lib_tables = 0;
+    }
+    free(veg_lib);
+
+    // the libraries shared between the processes of a compute node
+    if (veg_lib_win != MPI_WIN_NULL) {
+        status = MPI_Win_free(&veg_lib_win);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Comm_free(&veg_lib_node_comm);
+        check_mpi_status(status, "MPI error.");
+    }
+}
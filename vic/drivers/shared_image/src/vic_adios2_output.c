@@ -0,0 +1,407 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Output streams published through ADIOS2.
+ *
+ * With OUT_FORMAT ADIOS2_SST or ADIOS2_BP5, an output stream writes no
+ * history files. Each record is published as one ADIOS2 step, so that
+ * consumers (e.g. a routing model or a visualization service) receive it in
+ * memory over the network (SST) or read the steps while they are written
+ * (BP5). Every node publishes the values of its own cells as a block of each
+ * variable, without a gather to the master node. The blocks hold the grid
+ * index (the position in the domain file) and the coordinates of their cells
+ * as well, and the master node publishes the time and time bounds of the
+ * record.
+ *
+ * The image driver must be built with ADIOS2 support (make ADIOS2=TRUE).
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+#ifdef VIC_ADIOS2
+static adios2_adios *adios2_handle = NULL;
+
+/******************************************************************************
+ * @brief    Check the status of an ADIOS2 call.
+ *****************************************************************************/
+static void
+check_adios2_status(adios2_error   status,
+                    stream_struct *stream,
+                    const char    *what)
+{
+    if (status != adios2_error_none) {
+        log_err("ADIOS2 error %d %s of output stream %s", (int) status,
+                what, stream->prefix);
+    }
+}
+
+/******************************************************************************
+ * @brief    Define a block of the local cells.
+ * @details  ADIOS2 local arrays: the blocks of the nodes have no global
+ *           shape and are read block by block.
+ *****************************************************************************/
+static adios2_variable *
+define_adios2_block(stream_struct *stream,
+                    adios2_io     *io,
+                    const char    *name,
+                    adios2_type    type,
+                    size_t         nelem)
+{
+    adios2_variable *var;
+    size_t           count[2];
+    size_t           ndims;
+
+    ndims = 0;
+    if (nelem > 1) {
+        count[ndims++] = nelem;
+    }
+    count[ndims++] = stream->ngridcells;
+
+    var = adios2_define_variable(io, name, type, ndims, NULL, NULL, count,
+                                 adios2_constant_dims_true);
+    if (var == NULL) {
+        log_err("Error defining ADIOS2 variable %s of output stream %s",
+                name, stream->prefix);
+    }
+
+    return var;
+}
+
+/******************************************************************************
+ * @brief    Add a text attribute to an ADIOS2 variable.
+ *****************************************************************************/
+static void
+put_adios2_attr(stream_struct *stream,
+                adios2_io     *io,
+                const char    *varname,
+                const char    *name,
+                const char    *value)
+{
+    if (adios2_define_variable_attribute(io, name, adios2_type_string, value,
+                                         varname, "/") == NULL) {
+        log_err("Error adding attribute %s of ADIOS2 variable %s of output "
+                "stream %s", name, varname, stream->prefix);
+    }
+}
+#endif
+
+/******************************************************************************
+ * @brief    Check whether a stream is published through ADIOS2.
+ *****************************************************************************/
+bool
+is_published_stream(stream_struct *stream)
+{
+    return (stream->file_format == ADIOS2_SST ||
+            stream->file_format == ADIOS2_BP5);
+}
+
+/******************************************************************************
+ * @brief    Open the ADIOS2 engine of a published stream.
+ * @details  Called by vic_init_output() on all nodes after the cells of the
+ *           stream are selected.
+ *****************************************************************************/
+void
+initialize_adios2_stream(stream_struct  *stream,
+                         nc_file_struct *nc)
+{
+#ifdef VIC_ADIOS2
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern int                 mpi_rank;
+
+    adios2_stream_struct      *publisher;
+    char                       name[MAXSTRING];
+    char                       unit_str[MAXSTRING];
+    char                       calendar_str[MAXSTRING];
+    char                       str[MAXSTRING];
+    char                       cell_method[MAXSTRING];
+    size_t                     two = 2;
+    size_t                     cell;
+    size_t                     i;
+    size_t                     j;
+#endif
+
+    if (!is_published_stream(stream)) {
+        return;
+    }
+
+#ifdef VIC_ADIOS2
+    // the record is published by every node, not by the master node
+    if (options.IO_SERVERS > 0) {
+        log_err("OUT_FORMAT %s of output stream %s is not supported with "
+                "IO_SERVERS", stream->file_format == ADIOS2_SST ?
+                "ADIOS2_SST" : "ADIOS2_BP5", stream->prefix);
+    }
+    if (stream->region[0] != '\0') {
+        log_err("Output stream %s has both OUTREGION and an ADIOS2 "
+                "OUT_FORMAT", stream->prefix);
+    }
+
+    if (adios2_handle == NULL) {
+        adios2_handle = adios2_init_mpi(MPI_COMM_VIC);
+        if (adios2_handle == NULL) {
+            log_err("Error initializing ADIOS2");
+        }
+    }
+
+    publisher = &(nc->publisher);
+    publisher->io = adios2_declare_io(adios2_handle, stream->prefix);
+    if (publisher->io == NULL) {
+        log_err("Error declaring the ADIOS2 IO of output stream %s",
+                stream->prefix);
+    }
+    if (stream->file_format == ADIOS2_SST) {
+        check_adios2_status(adios2_set_engine(publisher->io, "SST"), stream,
+                            "setting the engine");
+        // the model does not wait for the consumers and keeps at most
+        // MAX_ASYNC_RECORDS steps that they have not read yet
+        snprintf(str, MAXSTRING, "%d", MAX_ASYNC_RECORDS);
+        check_adios2_status(adios2_set_parameter(publisher->io,
+                                                 "RendezvousReaderCount",
+                                                 "0"), stream,
+                            "setting the engine parameters");
+        check_adios2_status(adios2_set_parameter(publisher->io, "QueueLimit",
+                                                 str), stream,
+                            "setting the engine parameters");
+        check_adios2_status(adios2_set_parameter(publisher->io,
+                                                 "QueueFullPolicy",
+                                                 "Discard"), stream,
+                            "setting the engine parameters");
+        snprintf(name, MAXSTRING, "%s/%s", filenames.result_dir,
+                 stream->prefix);
+    }
+    else {
+        check_adios2_status(adios2_set_engine(publisher->io, "BP5"), stream,
+                            "setting the engine");
+        snprintf(name, MAXSTRING, "%s/%s.bp", filenames.result_dir,
+                 stream->prefix);
+    }
+
+    // the cells of the local blocks
+    publisher->cells = malloc((stream->ngridcells + 1) *
+                              sizeof(*(publisher->cells)));
+    check_alloc_status(publisher->cells, "Memory allocation error.");
+    publisher->lat = malloc((stream->ngridcells + 1) *
+                            sizeof(*(publisher->lat)));
+    check_alloc_status(publisher->lat, "Memory allocation error.");
+    publisher->lon = malloc((stream->ngridcells + 1) *
+                            sizeof(*(publisher->lon)));
+    check_alloc_status(publisher->lon, "Memory allocation error.");
+    for (i = 0; i < stream->ngridcells; i++) {
+        cell = stream->cells != NULL ? stream->cells[i] : i;
+        publisher->cells[i] = (int) local_domain.locations[cell].io_idx;
+        publisher->lat[i] = local_domain.locations[cell].latitude;
+        publisher->lon[i] = local_domain.locations[cell].longitude;
+    }
+
+    // nodes without cells publish no blocks
+    publisher->vars = calloc(stream->nvars, sizeof(*(publisher->vars)));
+    check_alloc_status(publisher->vars, "Memory allocation error.");
+    if (stream->ngridcells > 0) {
+        publisher->cell_var = define_adios2_block(stream, publisher->io,
+                                                  "cell",
+                                                  adios2_type_int32_t, 1);
+        publisher->lat_var = define_adios2_block(stream, publisher->io, "lat",
+                                                 adios2_type_double, 1);
+        publisher->lon_var = define_adios2_block(stream, publisher->io, "lon",
+                                                 adios2_type_double, 1);
+        for (j = 0; j < stream->nvars; j++) {
+            publisher->vars[j] = define_adios2_block(
+                stream, publisher->io, out_metadata[stream->varid[j]].varname,
+                adios2_type_double, out_metadata[stream->varid[j]].nelem);
+        }
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        publisher->time_var = adios2_define_variable(publisher->io, "time",
+                                                     adios2_type_double, 0,
+                                                     NULL, NULL, NULL,
+                                                     adios2_constant_dims_true);
+        publisher->time_bounds_var = adios2_define_variable(
+            publisher->io, "time_bnds", adios2_type_double, 1, &two, NULL,
+            &two, adios2_constant_dims_true);
+        if (publisher->time_var == NULL || publisher->time_bounds_var == NULL) {
+            log_err("Error defining the time of output stream %s",
+                    stream->prefix);
+        }
+
+        str_from_time_units(global_param.time_units, unit_str);
+        snprintf(str, MAXSTRING, "%s since %s", unit_str,
+                 global_param.time_origin_str);
+        str_from_calendar(global_param.calendar, calendar_str);
+        put_adios2_attr(stream, publisher->io, "time", "units", str);
+        put_adios2_attr(stream, publisher->io, "time", "calendar",
+                        calendar_str);
+        put_adios2_attr(stream, publisher->io, "cell", "long_name",
+                        "index of the cell in the grid of the domain file");
+        put_adios2_attr(stream, publisher->io, "lat", "units",
+                        "degrees_north");
+        put_adios2_attr(stream, publisher->io, "lon", "units",
+                        "degrees_east");
+        for (j = 0; j < stream->nvars; j++) {
+            i = stream->varid[j];
+            put_adios2_attr(stream, publisher->io, out_metadata[i].varname,
+                            "long_name", out_metadata[i].long_name);
+            put_adios2_attr(stream, publisher->io, out_metadata[i].varname,
+                            "units", out_metadata[i].units);
+            if (cell_method_from_agg_type(stream->aggtype[j], cell_method)) {
+                put_adios2_attr(stream, publisher->io,
+                                out_metadata[i].varname, "cell_methods",
+                                cell_method);
+            }
+        }
+    }
+
+    publisher->engine = adios2_open(publisher->io, name, adios2_mode_write);
+    if (publisher->engine == NULL) {
+        log_err("Error opening ADIOS2 engine %s of output stream %s", name,
+                stream->prefix);
+    }
+    debug("output stream %s is published to %s", stream->prefix, name);
+#else
+    (void) nc;
+    log_err("OUT_FORMAT of output stream %s is an ADIOS2 engine, but VIC was "
+            "compiled without ADIOS2 support (make ADIOS2=TRUE)",
+            stream->prefix);
+#endif
+}
+
+/******************************************************************************
+ * @brief    Publish a record of a stream as one ADIOS2 step.
+ * @details  Called by vic_write_output() on all nodes instead of vic_write().
+ *****************************************************************************/
+void
+put_adios2_record(stream_struct  *stream,
+                  nc_file_struct *nc,
+                  dmy_struct     *dmy_current)
+{
+#ifdef VIC_ADIOS2
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+    extern int             mpi_rank;
+    extern timer_struct    global_timers[N_TIMERS];
+
+    adios2_stream_struct  *publisher;
+    adios2_step_status     step_status;
+    double                 bounds[2];
+    double                *aggvalues;
+    size_t                 j;
+
+    timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+    publisher = &(nc->publisher);
+    check_adios2_status(adios2_begin_step(publisher->engine,
+                                          adios2_step_mode_append, -1.,
+                                          &step_status), stream,
+                        "beginning a step");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        get_history_time_bounds(stream, bounds);
+        check_adios2_status(adios2_put(publisher->engine, publisher->time_var,
+                                       &(bounds[0]), adios2_mode_sync),
+                            stream, "publishing the time");
+        check_adios2_status(adios2_put(publisher->engine,
+                                       publisher->time_bounds_var, bounds,
+                                       adios2_mode_sync), stream,
+                            "publishing the time bounds");
+    }
+
+    // the blocks are sent when the step ends, before the stream is reset
+    if (stream->ngridcells > 0) {
+        check_adios2_status(adios2_put(publisher->engine, publisher->cell_var,
+                                       publisher->cells,
+                                       adios2_mode_deferred), stream,
+                            "publishing the cells");
+        check_adios2_status(adios2_put(publisher->engine, publisher->lat_var,
+                                       publisher->lat, adios2_mode_deferred),
+                            stream, "publishing the cells");
+        check_adios2_status(adios2_put(publisher->engine, publisher->lon_var,
+                                       publisher->lon, adios2_mode_deferred),
+                            stream, "publishing the cells");
+        aggvalues = stream->aggvalues;
+        for (j = 0; j < stream->nvars; j++) {
+            check_adios2_status(adios2_put(publisher->engine,
+                                           publisher->vars[j], aggvalues,
+                                           adios2_mode_deferred), stream,
+                                "publishing a variable");
+            aggvalues += out_metadata[stream->varid[j]].nelem *
+                         stream->ngridcells;
+        }
+    }
+
+    check_adios2_status(adios2_end_step(publisher->engine), stream,
+                        "ending a step");
+    timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+
+    // the write alarm only counts the records, there are no files to close
+    stream->write_alarm.count++;
+    if (raise_alarm(&(stream->write_alarm), dmy_current)) {
+        reset_alarm(&(stream->write_alarm), dmy_current);
+    }
+#else
+    (void) stream;
+    (void) nc;
+    (void) dmy_current;
+#endif
+}
+
+/******************************************************************************
+ * @brief    Close the ADIOS2 engines of the published streams.
+ * @details  The consumers see the end of the stream.
+ *****************************************************************************/
+void
+finalize_adios2_streams(void)
+{
+#ifdef VIC_ADIOS2
+    extern option_struct   options;
+    extern stream_struct  *output_streams;
+    extern nc_file_struct *nc_hist_files;
+
+    adios2_stream_struct  *publisher;
+    size_t                 i;
+
+    if (adios2_handle == NULL) {
+        return;
+    }
+
+    for (i = 0; i < options.Noutstreams; i++) {
+        if (!is_published_stream(&(output_streams[i]))) {
+            continue;
+        }
+        publisher = &(nc_hist_files[i].publisher);
+        check_adios2_status(adios2_close(publisher->engine),
+                            &(output_streams[i]), "closing the engine");
+        free(publisher->vars);
+        free(publisher->cells);
+        free(publisher->lat);
+        free(publisher->lon);
+    }
+
+    if (adios2_finalize(adios2_handle) != adios2_error_none) {
+        log_err("Error finalizing ADIOS2");
+    }
+    adios2_handle = NULL;
+#endif
+}
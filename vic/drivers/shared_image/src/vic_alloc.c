@@ -28,6 +28,11 @@
 
 /******************************************************************************
  * @brief    Allocate memory for VIC structures.
+ * @details  With NUMA_FIRST_TOUCH, the arrays of the grid cells are
+ *           initialized by the threads that run the cells in vic_image_run(),
+ *           in the same blocks and with the same static schedule, so that
+ *           the operating system places their pages in the memory of the NUMA
+ *           node of that thread.
  *****************************************************************************/
 void
 vic_alloc(void)
@@ -46,6 +51,26 @@ vic_alloc(void)
     extern lake_con_struct    *lake_con;
     size_t                     i;
     size_t                     j;
+    size_t                     n;
+    size_t                     v;
+    size_t                     ncells;
+    size_t                     nv_total;
+    size_t                     block;
+    size_t                     nblocks;
+    size_t                     last;
+    size_t                    *tile_start;
+    double                    *zone_depth;
+    double                    *zone_fract;
+    double                    *CanopLayerBnd;
+    double                    *AreaFract;
+    double                    *BandElev;
+    double                    *Tfactor;
+    double                    *Pfactor;
+    bool                      *AboveTreeLine;
+    int                       *vidx;
+    double                    *Cv;
+    veg_con_struct            *veg_con_slab;
+    veg_hist_struct           *veg_hist_slab;
 
     // allocate memory for force structure
     force = malloc(local_domain.ncells_active * sizeof(*force));
@@ -89,81 +114,155 @@ vic_alloc(void)
     save_data = malloc(local_domain.ncells_active * sizeof(*save_data));
     check_alloc_status(save_data, "Memory allocation error.");
 
-    // allocate memory for individual grid cells
+    // the number of vegetation tiles of each grid cell and the first tile
+    // of each grid cell in the vegetation tile slabs
+    tile_start = malloc(local_domain.ncells_active * sizeof(*tile_start));
+    check_alloc_status(tile_start, "Memory allocation error.");
+    nv_total = 0;
+    zone_depth = NULL;
+    zone_fract = NULL;
+    CanopLayerBnd = NULL;
     for (i = 0; i < local_domain.ncells_active; i++) {
-        // force allocation - allocate enough memory for NR+1 steps
-        alloc_force(&(force[i]));
-
-        // snow band allocation
-        soil_con[i].AreaFract = calloc(options.SNOW_BAND,
-                                       sizeof(*(soil_con[i].AreaFract)));
-        check_alloc_status(soil_con[i].AreaFract, "Memory allocation error.");
-        soil_con[i].BandElev = calloc(options.SNOW_BAND,
-                                      sizeof(*(soil_con[i].BandElev)));
-        check_alloc_status(soil_con[i].BandElev, "Memory allocation error.");
-        soil_con[i].Tfactor = calloc(options.SNOW_BAND,
-                                     sizeof(*(soil_con[i].Tfactor)));
-        check_alloc_status(soil_con[i].Tfactor, "Memory allocation error.");
-        soil_con[i].Pfactor = calloc(options.SNOW_BAND,
-                                     sizeof(*(soil_con[i].Pfactor)));
-        check_alloc_status(soil_con[i].Pfactor, "Memory allocation error.");
-        soil_con[i].AboveTreeLine = calloc(options.SNOW_BAND,
-                                           sizeof(*(soil_con[i].AboveTreeLine)));
-        check_alloc_status(soil_con[i].AboveTreeLine,
+        veg_con_map[i].nv_types = options.NVEGTYPES;
+        veg_con_map[i].nv_classes = 0;
+        veg_con_map[i].nv_active = (size_t) local_domain.locations[i].nveg + 1;
+        if (options.AboveTreelineVeg >= 0) {
+            veg_con_map[i].nv_active += 1;
+        }
+        tile_start[i] = nv_total;
+        nv_total += veg_con_map[i].nv_active;
+    }
+
+    // the small arrays of all grid cells on this node are allocated as one
+    // slab per array, with the arrays of the first grid cell at the start.
+    // vic_finalize() frees each slab at once.
+    if (local_domain.ncells_active > 0) {
+        ncells = local_domain.ncells_active;
+
+        // snow band slabs
+        soil_con[0].AreaFract = calloc(ncells * options.SNOW_BAND,
+                                       sizeof(*(soil_con[0].AreaFract)));
+        check_alloc_status(soil_con[0].AreaFract, "Memory allocation error.");
+        soil_con[0].BandElev = calloc(ncells * options.SNOW_BAND,
+                                      sizeof(*(soil_con[0].BandElev)));
+        check_alloc_status(soil_con[0].BandElev, "Memory allocation error.");
+        soil_con[0].Tfactor = calloc(ncells * options.SNOW_BAND,
+                                     sizeof(*(soil_con[0].Tfactor)));
+        check_alloc_status(soil_con[0].Tfactor, "Memory allocation error.");
+        soil_con[0].Pfactor = calloc(ncells * options.SNOW_BAND,
+                                     sizeof(*(soil_con[0].Pfactor)));
+        check_alloc_status(soil_con[0].Pfactor, "Memory allocation error.");
+        soil_con[0].AboveTreeLine = calloc(ncells * options.SNOW_BAND,
+                                           sizeof(*(soil_con[0].AboveTreeLine)));
+        check_alloc_status(soil_con[0].AboveTreeLine,
                            "Memory allocation error.");
 
-        initialize_soil_con(&(soil_con[i]));
+        // vegetation mapping slabs
+        veg_con_map[0].vidx = calloc(ncells * options.NVEGTYPES,
+                                     sizeof(*(veg_con_map[0].vidx)));
+        check_alloc_status(veg_con_map[0].vidx, "Memory allocation error.");
+        veg_con_map[0].Cv = calloc(ncells * options.NVEGTYPES,
+                                   sizeof(*(veg_con_map[0].Cv)));
+        check_alloc_status(veg_con_map[0].Cv, "Memory allocation error.");
 
-        // vegetation tile allocation
+        // vegetation tile slabs
+        veg_con[0] = malloc(nv_total * sizeof(*(veg_con[0])));
+        check_alloc_status(veg_con[0], "Memory allocation error.");
+        zone_depth = calloc(nv_total * options.ROOT_ZONES,
+                            sizeof(*zone_depth));
+        check_alloc_status(zone_depth, "Memory allocation error.");
+        zone_fract = calloc(nv_total * options.ROOT_ZONES,
+                            sizeof(*zone_fract));
+        check_alloc_status(zone_fract, "Memory allocation error.");
+        if (options.CARBON) {
+            CanopLayerBnd = calloc(nv_total * options.Ncanopy,
+                                   sizeof(*CanopLayerBnd));
+            check_alloc_status(CanopLayerBnd, "Memory allocation error.");
+        }
 
-        veg_con_map[i].nv_types = options.NVEGTYPES;
+        // forcing slabs
+        alloc_force(ncells, force);
+
+        // vegetation history slab
+        veg_hist[0] = calloc(nv_total, sizeof(*(veg_hist[0])));
+        check_alloc_status(veg_hist[0], "Memory allocation error.");
+        alloc_veg_hist(nv_total, veg_hist[0]);
+    }
 
-        veg_con_map[i].vidx = calloc(veg_con_map[i].nv_types,
-                                     sizeof(*(veg_con_map[i].vidx)));
-        check_alloc_status(veg_con_map[i].vidx, "Memory allocation error.");
-        veg_con_map[i].Cv = calloc(veg_con_map[i].nv_types,
-                                   sizeof(*(veg_con_map[i].Cv)));
-        check_alloc_status(veg_con_map[i].Cv, "Memory allocation error.");
+    // the slabs are only read through these in the cell loop, so that the
+    // threads do not race on the pointers of the first grid cell
+    if (local_domain.ncells_active > 0) {
+        AreaFract = soil_con[0].AreaFract;
+        BandElev = soil_con[0].BandElev;
+        Tfactor = soil_con[0].Tfactor;
+        Pfactor = soil_con[0].Pfactor;
+        AboveTreeLine = soil_con[0].AboveTreeLine;
+        vidx = veg_con_map[0].vidx;
+        Cv = veg_con_map[0].Cv;
+        veg_con_slab = veg_con[0];
+        veg_hist_slab = veg_hist[0];
+    }
+    else {
+        AreaFract = NULL;
+        BandElev = NULL;
+        Tfactor = NULL;
+        Pfactor = NULL;
+        AboveTreeLine = NULL;
+        vidx = NULL;
+        Cv = NULL;
+        veg_con_slab = NULL;
+        veg_hist_slab = NULL;
+    }
 
-        veg_con_map[i].nv_active = (size_t) local_domain.locations[i].nveg + 1;
-        if (options.AboveTreelineVeg >= 0) {
-            veg_con_map[i].nv_active += 1;
+    // allocate memory for individual grid cells, in the blocks of
+    // vic_image_run()
+    block = get_run_block_size();
+    nblocks = (local_domain.ncells_active + block - 1) / block;
+    #pragma omp parallel for num_threads(options.NTHREADS) \
+    schedule(static) if (options.NUMA_FIRST_TOUCH) private(i, j, v, last)
+    for (n = 0; n < nblocks; n++) {
+        last = (n + 1) * block;
+        if (last > local_domain.ncells_active) {
+            last = local_domain.ncells_active;
         }
+        for (i = n * block; i < last; i++) {
+            // snow band allocation
+            soil_con[i].AreaFract = AreaFract + i * options.SNOW_BAND;
+            soil_con[i].BandElev = BandElev + i * options.SNOW_BAND;
+            soil_con[i].Tfactor = Tfactor + i * options.SNOW_BAND;
+            soil_con[i].Pfactor = Pfactor + i * options.SNOW_BAND;
+            soil_con[i].AboveTreeLine = AboveTreeLine + i * options.SNOW_BAND;
 
-        veg_con[i] = malloc((veg_con_map[i].nv_active) * sizeof(*(veg_con[i])));
-        check_alloc_status(veg_con[i], "Memory allocation error.");
-
-        for (j = 0; j < veg_con_map[i].nv_active; j++) {
-            veg_con[i][j].zone_depth = calloc(options.ROOT_ZONES,
-                                              sizeof(*(veg_con[i][j].zone_depth)));
-            check_alloc_status(veg_con[i][j].zone_depth,
-                               "Memory allocation error.");
-            veg_con[i][j].zone_fract = calloc(options.ROOT_ZONES,
-                                              sizeof(*(veg_con[i][j].zone_fract)));
-            check_alloc_status(veg_con[i][j].zone_fract,
-                               "Memory allocation error.");
-            if (options.CARBON) {
-                veg_con[i][j].CanopLayerBnd = calloc(options.Ncanopy,
-                                                     sizeof(*(veg_con[i][j].
-                                                              CanopLayerBnd)));
-                check_alloc_status(veg_con[i][j].CanopLayerBnd,
-                                   "Memory allocation error.");
-            }
-            initialize_veg_con(&(veg_con[i][j]));
-        }
+            initialize_soil_con(&(soil_con[i]));
 
-        // vegetation library allocation - there is a veg library for each
-        // active grid cell
+            // vegetation tile allocation
+            veg_con_map[i].vidx = vidx + i * options.NVEGTYPES;
+            veg_con_map[i].Cv = Cv + i * options.NVEGTYPES;
 
-        veg_lib[i] = calloc(options.NVEGTYPES, sizeof(*(veg_lib[i])));
-        check_alloc_status(veg_lib[i], "Memory allocation error.");
+            v = tile_start[i];
+            veg_con[i] = veg_con_slab + v;
+            veg_hist[i] = veg_hist_slab + v;
 
-        all_vars[i] = make_all_vars(veg_con_map[i].nv_active);
+            for (j = 0; j < veg_con_map[i].nv_active; j++) {
+                veg_con[i][j].zone_depth = zone_depth +
+                                           (v + j) * options.ROOT_ZONES;
+                veg_con[i][j].zone_fract = zone_fract +
+                                           (v + j) * options.ROOT_ZONES;
+                if (options.CARBON) {
+                    veg_con[i][j].CanopLayerBnd = CanopLayerBnd +
+                                                  (v + j) * options.Ncanopy;
+                }
+                initialize_veg_con(&(veg_con[i][j]));
+            }
 
-        // allocate memory for veg_hist
-        veg_hist[i] = calloc(veg_con_map[i].nv_active, sizeof(*(veg_hist[i])));
-        for (j = 0; j < veg_con_map[i].nv_active; j++) {
-            alloc_veg_hist(&(veg_hist[i][j]));
+            // vegetation library allocation - there is a veg library for
+            // each active grid cell
+            veg_lib[i] = calloc(options.NVEGTYPES, sizeof(*(veg_lib[i])));
+            check_alloc_status(veg_lib[i], "Memory allocation error.");
+
+            all_vars[i] = make_all_vars(veg_con_map[i].nv_active);
         }
     }
+
+    free(tile_start);
 }
@@ -0,0 +1,422 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Cost map of the grid cells.
+ *
+ * When COST_MAP is given in the global parameter file, the wall time that
+ * vic_run spends on each grid cell is accumulated over the whole run and is
+ * written once at the end of the run to a netCDF file on the grid of the
+ * domain file. The cell_cost variable of the file can be used directly as the
+ * cost file of DECOMPOSITION COST_WEIGHTED.
+ *
+ * The cost of the grid cells changes over the seasons (snow in spring, frozen
+ * soil in winter, lake ice), so a decomposition on the costs of a whole run
+ * drifts out of balance. With REBALANCE_STEPS, the costs of the last
+ * REBALANCE_STEPS time steps are reduced onto the master process, which logs
+ * the load imbalance of the current decomposition and of the cost weighted
+ * decomposition of the measured costs. With COST_MAP, the measured costs are
+ * also written to a cost map with the date appended, as for the state files.
+ * The new decomposition is applied by restarting from the state file of that
+ * date with the cost map as the cost file of DECOMPOSITION COST_WEIGHTED: the
+ * cells are not migrated between the processes while the model runs, since
+ * every per-cell cache of the image driver would have to be rebuilt.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+// accumulated wall time of vic_run per local cell, NULL without COST_MAP and
+// REBALANCE_STEPS
+static double *cell_wall_time = NULL;
+// accumulated wall time at the last rebalancing, and wall time since then
+static double *cell_wall_time_last = NULL;
+static double *cell_wall_time_interval = NULL;
+
+/******************************************************************************
+ * @brief    Allocate the cost map if COST_MAP or REBALANCE_STEPS is set.
+ *****************************************************************************/
+void
+initialize_cost_map(void)
+{
+    extern domain_struct    local_domain;
+    extern filenames_struct filenames;
+    extern option_struct    options;
+
+    if (strcasecmp(filenames.cost_map, "MISSING") == 0 &&
+        options.REBALANCE_STEPS == 0) {
+        return;
+    }
+
+    // one extra element, so that nodes without active cells get a buffer
+    cell_wall_time = calloc(local_domain.ncells_active + 1,
+                            sizeof(*cell_wall_time));
+    check_alloc_status(cell_wall_time, "Memory allocation error.");
+
+    if (options.REBALANCE_STEPS > 0) {
+        cell_wall_time_last = calloc(local_domain.ncells_active + 1,
+                                     sizeof(*cell_wall_time_last));
+        check_alloc_status(cell_wall_time_last, "Memory allocation error.");
+        cell_wall_time_interval = calloc(local_domain.ncells_active + 1,
+                                         sizeof(*cell_wall_time_interval));
+        check_alloc_status(cell_wall_time_interval,
+                           "Memory allocation error.");
+    }
+}
+
+/******************************************************************************
+ * @brief    Add the wall time of vic_run for a local cell to the cost map.
+ * @details  Does nothing without COST_MAP. Cells can be updated by different
+ *           threads at the same time.
+ *****************************************************************************/
+void
+update_cost_map(size_t cell,
+                double wall_time)
+{
+    if (cell_wall_time != NULL) {
+        cell_wall_time[cell] += wall_time;
+    }
+}
+
+/******************************************************************************
+ * @brief    Write a cost map file.
+ * @details  Must be called by all processes of MPI_COMM_VIC that run grid
+ *           cells.
+ *
+ *           The file has the dimensions and the coordinate variables of the
+ *           domain file. cell_cost holds the wall time of vic_run over nrecs
+ *           time steps in seconds; inactive cells hold the fill value.
+ *****************************************************************************/
+static void
+write_cost_map_file(char   *filename,
+                    double *costs,
+                    size_t  nrecs,
+                    char   *description)
+{
+    extern domain_struct global_domain;
+    extern int           mpi_rank;
+
+    int                  nc_id = -1;
+    int                  dimids[2];
+    int                  lon_var_id;
+    int                  lat_var_id;
+    int                  cost_var_id = -1;
+    int                  status;
+    size_t               dstart[2] = {0, 0};
+    size_t               dcount[2];
+    size_t               i;
+    double               fillval = NC_FILL_DOUBLE;
+    double               model_timesteps;
+    double              *dvar = NULL;
+
+    dcount[0] = global_domain.n_ny;
+    dcount[1] = global_domain.n_nx;
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        status = nc_create(filename, get_nc_mode(NETCDF4_CLASSIC), &nc_id);
+        check_nc_status(status, "Error creating %s", filename);
+        set_global_nc_attributes(nc_id, NC_COST_MAP_FILE);
+        model_timesteps = (double) nrecs;
+        status = nc_put_att_double(nc_id, NC_GLOBAL, "model_timesteps",
+                                   NC_DOUBLE, 1, &model_timesteps);
+        check_nc_status(status, "Error adding attribute in %s",
+                        filename);
+
+        status = nc_def_dim(nc_id, global_domain.info.y_dim,
+                            global_domain.n_ny, &(dimids[0]));
+        check_nc_status(status, "Error defining y dimension in %s",
+                        filename);
+        status = nc_def_dim(nc_id, global_domain.info.x_dim,
+                            global_domain.n_nx, &(dimids[1]));
+        check_nc_status(status, "Error defining x dimension in %s",
+                        filename);
+
+        // coordinate variables, as in the state file
+        if (global_domain.info.n_coord_dims == 1) {
+            status = nc_def_var(nc_id, global_domain.info.lon_var, NC_DOUBLE,
+                                1, &(dimids[1]), &lon_var_id);
+            check_nc_status(status, "Error defining lon variable in %s",
+                            filename);
+            status = nc_def_var(nc_id, global_domain.info.lat_var, NC_DOUBLE,
+                                1, &(dimids[0]), &lat_var_id);
+            check_nc_status(status, "Error defining lat variable in %s",
+                            filename);
+        }
+        else if (global_domain.info.n_coord_dims == 2) {
+            status = nc_def_var(nc_id, global_domain.info.lon_var, NC_DOUBLE,
+                                2, dimids, &lon_var_id);
+            check_nc_status(status, "Error defining lon variable in %s",
+                            filename);
+            status = nc_def_var(nc_id, global_domain.info.lat_var, NC_DOUBLE,
+                                2, dimids, &lat_var_id);
+            check_nc_status(status, "Error defining lat variable in %s",
+                            filename);
+        }
+        else {
+            log_err("COORD_DIMS_OUT should be 1 or 2");
+        }
+        put_nc_attr(nc_id, lon_var_id, "long_name", "longitude");
+        put_nc_attr(nc_id, lon_var_id, "units", "degrees_east");
+        put_nc_attr(nc_id, lon_var_id, "standard_name", "longitude");
+        put_nc_attr(nc_id, lat_var_id, "long_name", "latitude");
+        put_nc_attr(nc_id, lat_var_id, "units", "degrees_north");
+        put_nc_attr(nc_id, lat_var_id, "standard_name", "latitude");
+
+        status = nc_def_var(nc_id, "cell_cost", NC_DOUBLE, 2, dimids,
+                            &cost_var_id);
+        check_nc_status(status, "Error defining cell_cost variable in %s",
+                        filename);
+        status = nc_put_att_double(nc_id, cost_var_id, "_FillValue",
+                                   NC_DOUBLE, 1, &fillval);
+        check_nc_status(status, "Error putting _FillValue attribute in %s",
+                        filename);
+        put_nc_attr(nc_id, cost_var_id, "long_name", "cell_cost");
+        put_nc_attr(nc_id, cost_var_id, "units", "s");
+        put_nc_attr(nc_id, cost_var_id, "description", description);
+
+        status = nc_enddef(nc_id);
+        check_nc_status(status, "Error leaving define mode for %s",
+                        filename);
+
+        // coordinates of the grid, in the order of the grid cells
+        dvar = malloc(global_domain.ncells_total * sizeof(*dvar));
+        check_alloc_status(dvar, "Memory allocation error.");
+        if (global_domain.info.n_coord_dims == 1) {
+            for (i = 0; i < global_domain.n_nx; i++) {
+                dvar[i] = global_domain.locations[i].longitude;
+            }
+            status = nc_put_vara_double(nc_id, lon_var_id, dstart,
+                                        &(dcount[1]), dvar);
+            check_nc_status(status, "Error adding data to lon in %s",
+                            filename);
+            for (i = 0; i < global_domain.n_ny; i++) {
+                dvar[i] =
+                    global_domain.locations[i * global_domain.n_nx].latitude;
+            }
+            status = nc_put_vara_double(nc_id, lat_var_id, dstart,
+                                        &(dcount[0]), dvar);
+            check_nc_status(status, "Error adding data to lat in %s",
+                            filename);
+        }
+        else {
+            for (i = 0; i < global_domain.ncells_total; i++) {
+                dvar[i] = global_domain.locations[i].longitude;
+            }
+            status = nc_put_vara_double(nc_id, lon_var_id, dstart, dcount,
+                                        dvar);
+            check_nc_status(status, "Error adding data to lon in %s",
+                            filename);
+            for (i = 0; i < global_domain.ncells_total; i++) {
+                dvar[i] = global_domain.locations[i].latitude;
+            }
+            status = nc_put_vara_double(nc_id, lat_var_id, dstart, dcount,
+                                        dvar);
+            check_nc_status(status, "Error adding data to lat in %s",
+                            filename);
+        }
+        free(dvar);
+    }
+
+    gather_put_nc_field_double(nc_id, cost_var_id, fillval, dstart, dcount,
+                               costs);
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        status = nc_close(nc_id);
+        check_nc_status(status, "Error closing %s", filename);
+        log_info("Wrote the cost map of the grid cells to %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Largest summed cost of a process over the mean.
+ * @details  costs are in the order of the processes, as gathered with
+ *           sizes and offsets.
+ *****************************************************************************/
+static double
+get_cost_imbalance(double *costs,
+                   size_t  nprocs,
+                   int    *sizes,
+                   int    *offsets)
+{
+    size_t i;
+    size_t k;
+    double sum;
+    double total = 0.;
+    double max = 0.;
+
+    for (i = 0; i < nprocs; i++) {
+        sum = 0.;
+        for (k = 0; k < (size_t) sizes[i]; k++) {
+            sum += costs[offsets[i] + k];
+        }
+        total += sum;
+        if (sum > max) {
+            max = sum;
+        }
+    }
+    if (total <= 0.) {
+        return 1.;
+    }
+
+    return max * nprocs / total;
+}
+
+/******************************************************************************
+ * @brief    Evaluate the decomposition on the measured cell costs.
+ * @details  Must be called by all compute processes at the end of every time
+ *           step. Does nothing without REBALANCE_STEPS. Every
+ *           REBALANCE_STEPS time steps, the wall time of vic_run per cell
+ *           since the last evaluation is gathered onto the master process,
+ *           which logs the compute max/mean of the current decomposition and
+ *           of the decomposition that DECOMPOSITION COST_WEIGHTED (or
+ *           HILBERT, if that is the current decomposition) makes of these
+ *           costs. With COST_MAP, the costs are written to COST_MAP
+ *           with the date of the next time step appended, the date of the
+ *           state file written at the end of this time step.
+ *****************************************************************************/
+void
+update_load_balance(void)
+{
+    extern size_t              current;
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern option_struct       options;
+    extern int                 mpi_rank;
+    extern int                 mpi_size;
+    extern int                *mpi_map_local_array_sizes;
+    extern int                *mpi_map_global_array_offsets;
+    extern size_t             *mpi_map_mapping_array;
+    extern size_t             *filter_active_cells;
+
+    char                       filename[MAXSTRING];
+    dmy_struct                 dmy_next;
+    size_t                     i;
+    double                    *gathered = NULL;
+    double                    *costs = NULL;
+    double                     imbalance;
+    double                     imbalance_new;
+    int                       *sizes = NULL;
+    int                       *offsets = NULL;
+    size_t                    *mapping = NULL;
+
+    if (options.REBALANCE_STEPS == 0 ||
+        (current + 1) % options.REBALANCE_STEPS != 0) {
+        return;
+    }
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        cell_wall_time_interval[i] = cell_wall_time[i] -
+                                     cell_wall_time_last[i];
+        cell_wall_time_last[i] = cell_wall_time[i];
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        gathered = malloc(global_domain.ncells_active * sizeof(*gathered));
+        check_alloc_status(gathered, "Memory allocation error.");
+    }
+    gather_field_double(cell_wall_time_interval, gathered);
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        imbalance = get_cost_imbalance(gathered, (size_t) mpi_size,
+                                       mpi_map_local_array_sizes,
+                                       mpi_map_global_array_offsets);
+
+        // the decompositions take the costs in the order of the active
+        // cells
+        costs = malloc(global_domain.ncells_active * sizeof(*costs));
+        check_alloc_status(costs, "Memory allocation error.");
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            costs[mpi_map_mapping_array[i]] = gathered[i];
+        }
+        if (options.DECOMPOSITION == DECOMP_HILBERT) {
+            mpi_map_decomp_hilbert(global_domain.ncells_active,
+                                   global_domain.n_nx, global_domain.n_ny,
+                                   filter_active_cells, (size_t) mpi_size,
+                                   costs, &sizes, &offsets, &mapping);
+        }
+        else {
+            mpi_map_decomp_domain(global_domain.ncells_active,
+                                  (size_t) mpi_size, costs, &sizes, &offsets,
+                                  &mapping);
+        }
+        // the costs in the order of the processes of the new decomposition
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            gathered[i] = costs[mapping[i]];
+        }
+        imbalance_new = get_cost_imbalance(gathered, (size_t) mpi_size, sizes,
+                                           offsets);
+
+        log_info("Load balance of time steps %zu to %zu: compute max/mean "
+                 "%.2f, %.2f with DECOMPOSITION %s on the measured costs",
+                 current + 1 - options.REBALANCE_STEPS, current, imbalance,
+                 imbalance_new,
+                 options.DECOMPOSITION == DECOMP_HILBERT ? "HILBERT" :
+                 "COST_WEIGHTED");
+
+        free(gathered);
+        free(costs);
+        free(sizes);
+        free(offsets);
+        free(mapping);
+    }
+
+    if (strcasecmp(filenames.cost_map, "MISSING") != 0) {
+        dmy_from_step(&global_param, current + 1, &dmy_next);
+        sprintf(filename, "%s.%04i%02i%02i_%05u.nc", filenames.cost_map,
+                dmy_next.year, dmy_next.month, dmy_next.day,
+                dmy_next.dayseconds);
+        write_cost_map_file(filename, cell_wall_time_interval,
+                            options.REBALANCE_STEPS,
+                            "wall time of vic_run for the grid cell over the "
+                            "last REBALANCE_STEPS time steps");
+    }
+}
+
+/******************************************************************************
+ * @brief    Write the cost map and free it.
+ * @details  Must be called by all processes of MPI_COMM_VIC that run grid
+ *           cells. Does nothing without COST_MAP.
+ *****************************************************************************/
+void
+write_cost_map(void)
+{
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+
+    if (cell_wall_time == NULL) {
+        return;
+    }
+
+    if (strcasecmp(filenames.cost_map, "MISSING") != 0) {
+        write_cost_map_file(filenames.cost_map, cell_wall_time,
+                            global_param.nrecs,
+                            "total wall time of vic_run for the grid cell");
+    }
+
+    free(cell_wall_time);
+    cell_wall_time = NULL;
+    free(cell_wall_time_last);
+    cell_wall_time_last = NULL;
+    free(cell_wall_time_interval);
+    cell_wall_time_interval = NULL;
+}
@@ -0,0 +1,536 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Threaded compression of the chunks of the history files.
+ *
+ * With deflate or shuffle set on a stream (COMPRESS), the netCDF library
+ * compresses the chunks of the records one after the other inside
+ * nc_put_vara on the master node, while the other nodes wait for the next
+ * gather. When COMPRESS_THREADS > 0, the master node opens its history files
+ * a second time with HDF5, deflates the chunks of a record on
+ * COMPRESS_THREADS threads and writes the compressed chunks to the datasets
+ * with H5Dwrite_chunk. The files are the same netCDF4 files: the chunks are
+ * compressed with the filters of the datasets (shuffle and deflate) and only
+ * skip the filter pipeline of the library.
+ *
+ * The records of a variable must cover whole chunks, i.e. one record per
+ * chunk along the time dimension. Variables with other chunk shapes or
+ * filters are left to the netCDF library. The significant digits of a
+ * variable are kept by round_history_values(), since the quantization of the
+ * netCDF library is part of the pipeline that is skipped.
+ *
+ * The image driver must be built with HDF5 and zlib (make DIRECT_CHUNK=TRUE).
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+#ifdef VIC_DIRECT_CHUNK
+#include <zlib.h>
+
+/******************************************************************************
+ * @brief    Share of the chunks of a record that one thread compresses.
+ *****************************************************************************/
+typedef struct {
+    direct_chunk_var_struct *var;    /**< variable of the record */
+    nc_io_field_struct *field;       /**< field of the record */
+    char *grid;                      /**< values of the record */
+    size_t thread;                   /**< index of the thread */
+    size_t nthreads;                 /**< number of threads */
+    int status;                      /**< zlib status of the first failed
+                                        chunk, Z_OK if none */
+} direct_chunk_job_struct;
+
+/******************************************************************************
+ * @brief    Fill n values of a chunk with the fill value of a field.
+ *****************************************************************************/
+static void
+fill_direct_chunk(char   *values,
+                  size_t  n,
+                  int     nc_type,
+                  double  fillval)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        if (nc_type == NC_DOUBLE) {
+            ((double *) values)[i] = fillval;
+        }
+        else if (nc_type == NC_FLOAT) {
+            ((float *) values)[i] = (float) fillval;
+        }
+        else if (nc_type == NC_INT) {
+            ((int *) values)[i] = (int) fillval;
+        }
+        else if (nc_type == NC_SHORT) {
+            ((short int *) values)[i] = (short int) fillval;
+        }
+        else {
+            ((signed char *) values)[i] = (signed char) fillval;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Position of a chunk of a record, in values along each dimension.
+ *****************************************************************************/
+static void
+get_direct_chunk_offset(direct_chunk_var_struct *var,
+                        size_t                   c,
+                        hsize_t                 *offset)
+{
+    size_t d;
+    size_t n;
+
+    for (d = var->ndims - 1; d > 0; d--) {
+        n = (var->shape[d] + var->chunk[d] - 1) / var->chunk[d];
+        offset[d] = (hsize_t) ((c % n) * var->chunk[d]);
+        c /= n;
+    }
+    offset[0] = 0;
+}
+
+/******************************************************************************
+ * @brief    Copy a chunk out of a record. The values of an edge chunk that
+ *           are outside of the record hold the fill value.
+ *****************************************************************************/
+static void
+copy_direct_chunk(direct_chunk_var_struct *var,
+                  nc_io_field_struct      *field,
+                  char                    *grid,
+                  hsize_t                 *offset,
+                  char                    *chunk)
+{
+    size_t idx[MAXDIMS];
+    size_t nrows;
+    size_t ncols;
+    size_t last;
+    size_t row;
+    size_t pos;
+    size_t r;
+    size_t d;
+    bool   inside;
+
+    last = var->ndims - 1;
+    nrows = 1;
+    for (d = 1; d < last; d++) {
+        nrows *= var->chunk[d];
+    }
+    ncols = var->chunk[last];
+    if (offset[last] + ncols > var->shape[last]) {
+        ncols = var->shape[last] - offset[last];
+    }
+
+    for (r = 0; r < nrows; r++) {
+        // position of the row in the record
+        row = r;
+        inside = true;
+        for (d = last - 1; d > 0; d--) {
+            idx[d] = offset[d] + row % var->chunk[d];
+            row /= var->chunk[d];
+            if (idx[d] >= var->shape[d]) {
+                inside = false;
+            }
+        }
+        if (!inside) {
+            fill_direct_chunk(chunk + r * var->chunk[last] * var->type_size,
+                              var->chunk[last], field->nc_type,
+                              field->fillval);
+            continue;
+        }
+        pos = 0;
+        for (d = 1; d < last; d++) {
+            pos = pos * var->shape[d] + idx[d];
+        }
+        pos = pos * var->shape[last] + offset[last];
+        memcpy(chunk + r * var->chunk[last] * var->type_size,
+               grid + pos * var->type_size, ncols * var->type_size);
+        if (ncols < var->chunk[last]) {
+            fill_direct_chunk(chunk + (r * var->chunk[last] + ncols) *
+                              var->type_size, var->chunk[last] - ncols,
+                              field->nc_type, field->fillval);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Compress the chunks c = thread, thread + nthreads, ... of a
+ *           record.
+ *****************************************************************************/
+static void *
+compress_direct_chunks(void *arg)
+{
+    direct_chunk_job_struct *job = (direct_chunk_job_struct *) arg;
+    direct_chunk_var_struct *var = job->var;
+    hsize_t                  offset[MAXDIMS];
+    char                    *chunk;
+    char                    *shuffled;
+    uLongf                   zsize;
+    size_t                   nvalues;
+    size_t                   nbytes;
+    size_t                   c;
+    size_t                   i;
+    size_t                   b;
+    int                      status;
+
+    nvalues = 1;
+    for (i = 1; i < var->ndims; i++) {
+        nvalues *= var->chunk[i];
+    }
+    nbytes = nvalues * var->type_size;
+    chunk = malloc(2 * nbytes);
+    if (chunk == NULL) {
+        job->status = Z_MEM_ERROR;
+        return NULL;
+    }
+    shuffled = chunk + nbytes;
+
+    job->status = Z_OK;
+    for (c = job->thread; c < var->nchunks; c += job->nthreads) {
+        get_direct_chunk_offset(var, c, offset);
+        copy_direct_chunk(var, job->field, job->grid, offset, chunk);
+
+        // the shuffle filter stores byte b of all values together
+        if (var->shuffle && var->type_size > 1) {
+            for (i = 0; i < nvalues; i++) {
+                for (b = 0; b < var->type_size; b++) {
+                    shuffled[b * nvalues + i] =
+                        chunk[i * var->type_size + b];
+                }
+            }
+            memcpy(chunk, shuffled, nbytes);
+        }
+
+        zsize = (uLongf) var->zbound;
+        status = compress2((Bytef *) (var->zbuf + c * var->zbound), &zsize,
+                           (const Bytef *) chunk, (uLong) nbytes, var->level);
+        if (status != Z_OK && job->status == Z_OK) {
+            job->status = status;
+        }
+        var->zsize[c] = (size_t) zsize;
+    }
+
+    free(chunk);
+
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief    Set up the direct chunk writes of a variable.
+ * @details  Only chunked datasets of a native integer or floating point type
+ *           with one record per chunk and with no filters other than
+ *           shuffle and deflate are written directly.
+ *
+ * @return   TRUE if the records of the variable can be written directly
+ *****************************************************************************/
+static bool
+open_direct_chunk_var(hid_t                    h5_id,
+                      char                    *name,
+                      nc_var_struct           *nc_var,
+                      direct_chunk_var_struct *var)
+{
+    hid_t        dcpl;
+    hid_t        dtype;
+    H5Z_filter_t filter;
+    hsize_t      chunk[MAXDIMS];
+    unsigned int flags;
+    unsigned int cd_values[8];
+    size_t       cd_nelmts;
+    size_t       nbytes;
+    size_t       i;
+    int          nfilters;
+    int          f;
+    bool         deflate = false;
+    bool         ok = true;
+
+    var->dset_id = H5Dopen2(h5_id, name, H5P_DEFAULT);
+    if (var->dset_id < 0) {
+        return false;
+    }
+
+    var->ndims = nc_var->nc_dims;
+    var->type_size = get_nc_io_type_size(nc_var->nc_type);
+    var->shuffle = false;
+    var->level = 0;
+
+    // the values are copied in the byte order of the master node
+    dtype = H5Dget_type(var->dset_id);
+    if (H5Tget_size(dtype) != var->type_size ||
+        (H5Tget_class(dtype) != H5T_INTEGER &&
+         H5Tget_class(dtype) != H5T_FLOAT) ||
+        H5Tget_order(dtype) != H5Tget_order(H5T_NATIVE_INT)) {
+        ok = false;
+    }
+    H5Tclose(dtype);
+
+    dcpl = H5Dget_create_plist(var->dset_id);
+    if (ok && (var->ndims < 2 || var->ndims > MAXDIMS ||
+               H5Pget_layout(dcpl) != H5D_CHUNKED ||
+               H5Pget_chunk(dcpl, (int) var->ndims, chunk) !=
+               (int) var->ndims || chunk[0] != 1)) {
+        ok = false;
+    }
+    nfilters = H5Pget_nfilters(dcpl);
+    for (f = 0; ok && f < nfilters; f++) {
+        cd_nelmts = sizeof(cd_values) / sizeof(cd_values[0]);
+        filter = H5Pget_filter2(dcpl, (unsigned int) f, &flags, &cd_nelmts,
+                                cd_values, 0, NULL, NULL);
+        if (filter == H5Z_FILTER_SHUFFLE && f == 0) {
+            var->shuffle = true;
+        }
+        else if (filter == H5Z_FILTER_DEFLATE && !deflate && cd_nelmts > 0) {
+            deflate = true;
+            var->level = (int) cd_values[0];
+        }
+        else {
+            ok = false;
+        }
+    }
+    H5Pclose(dcpl);
+    if (!ok || !deflate) {
+        H5Dclose(var->dset_id);
+        return false;
+    }
+
+    var->nchunks = 1;
+    nbytes = var->type_size;
+    for (i = 0; i < var->ndims; i++) {
+        var->chunk[i] = (size_t) chunk[i];
+        var->shape[i] = nc_var->nc_counts[i];
+        nbytes *= var->chunk[i];
+        if (i > 0) {
+            var->nchunks *= (var->shape[i] + var->chunk[i] - 1) /
+                            var->chunk[i];
+        }
+    }
+    var->shape[0] = 1;
+    var->zbound = (size_t) compressBound((uLong) nbytes);
+    var->zbuf = malloc(var->nchunks * var->zbound);
+    check_alloc_status(var->zbuf, "Memory allocation error.");
+    var->zsize = malloc(var->nchunks * sizeof(*(var->zsize)));
+    check_alloc_status(var->zsize, "Memory allocation error.");
+
+    return true;
+}
+#endif
+
+/******************************************************************************
+ * @brief    Return whether the history files of a stream are written with
+ *           direct chunk writes.
+ * @details  Only compressed netCDF4 files that are written by the master
+ *           node, one record per chunk, are.
+ *****************************************************************************/
+bool
+is_direct_chunk_stream(stream_struct  *stream,
+                       nc_file_struct *nc)
+{
+    extern option_struct options;
+
+    if (options.COMPRESS_THREADS == 0 || stream->compress <= 0 ||
+        (stream->file_format != NETCDF4_CLASSIC &&
+         stream->file_format != NETCDF4) ||
+        nc->parallel || nc->split || stream->region[0] != '\0') {
+        return false;
+    }
+    if (stream->chunk == CHUNK_SERIES && stream->chunk_n[0] > 1) {
+        return false;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Open a history file of the master node for direct chunk writes.
+ * @details  The file stays open in the netCDF library, which writes the
+ *           time and coordinates and the variables that are not written
+ *           directly. HDF5 shares the open file between the two handles.
+ *****************************************************************************/
+void
+open_direct_chunks(nc_file_struct *nc,
+                   stream_struct  *stream)
+{
+#ifdef VIC_DIRECT_CHUNK
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 j;
+    size_t                 nactive = 0;
+
+    if (!is_direct_chunk_stream(stream, nc)) {
+        return;
+    }
+
+    nc->h5_id = H5Fopen(stream->filename, H5F_ACC_RDWR, H5P_DEFAULT);
+    if (nc->h5_id < 0) {
+        log_err("Error opening %s for direct chunk writes", stream->filename);
+    }
+    for (j = 0; j < stream->nvars; j++) {
+        nc->nc_vars[j].direct.active =
+            open_direct_chunk_var(nc->h5_id,
+                                  out_metadata[stream->varid[j]].varname,
+                                  &(nc->nc_vars[j]),
+                                  &(nc->nc_vars[j].direct));
+        if (nc->nc_vars[j].direct.active) {
+            nactive++;
+        }
+    }
+    nc->direct = true;
+    nc->io_request.nc_vars = nc->nc_vars;
+    debug("%zu of %zu variables of %s written with direct chunk writes",
+          nactive, stream->nvars, stream->filename);
+#else
+    if (is_direct_chunk_stream(stream, nc)) {
+        log_err("COMPRESS_THREADS is set for output stream %s, but VIC was "
+                "compiled without HDF5 support (make DIRECT_CHUNK=TRUE)",
+                stream->prefix);
+    }
+#endif
+}
+
+/******************************************************************************
+ * @brief    Close the HDF5 handle of a history file before the netCDF
+ *           library closes it.
+ *****************************************************************************/
+void
+close_direct_chunks(nc_file_struct *nc,
+                    stream_struct  *stream)
+{
+#ifdef VIC_DIRECT_CHUNK
+    size_t j;
+
+    if (!nc->direct) {
+        return;
+    }
+
+    for (j = 0; j < stream->nvars; j++) {
+        if (nc->nc_vars[j].direct.active) {
+            H5Dclose(nc->nc_vars[j].direct.dset_id);
+            free(nc->nc_vars[j].direct.zbuf);
+            free(nc->nc_vars[j].direct.zsize);
+            nc->nc_vars[j].direct.zbuf = NULL;
+            nc->nc_vars[j].direct.zsize = NULL;
+            nc->nc_vars[j].direct.active = false;
+        }
+    }
+    H5Fclose(nc->h5_id);
+    nc->direct = false;
+    nc->io_request.nc_vars = NULL;
+#else
+    (void) nc;
+    (void) stream;
+#endif
+}
+
+/******************************************************************************
+ * @brief    Compress the chunks of a record of a variable on COMPRESS_THREADS
+ *           threads and write them to the history file.
+ * @details  grid holds the values of the record in the output type, as the
+ *           netCDF library would write them with field->start and
+ *           field->count. Called on the master node with the netCDF lock
+ *           taken.
+ *****************************************************************************/
+void
+put_direct_chunks(direct_chunk_var_struct *var,
+                  nc_io_field_struct      *field,
+                  void                    *grid)
+{
+#ifdef VIC_DIRECT_CHUNK
+    extern option_struct     options;
+
+    direct_chunk_job_struct *jobs;
+    pthread_t               *threads;
+    hsize_t                  dims[MAXDIMS];
+    hsize_t                  offset[MAXDIMS];
+    hid_t                    space;
+    size_t                   nthreads;
+    size_t                   c;
+    size_t                   t;
+    int                      status;
+
+    // the dataset grows with the records along the unlimited time
+    // dimension
+    space = H5Dget_space(var->dset_id);
+    H5Sget_simple_extent_dims(space, dims, NULL);
+    H5Sclose(space);
+    if (dims[0] <= (hsize_t) field->start[0]) {
+        dims[0] = (hsize_t) field->start[0] + 1;
+        if (H5Dset_extent(var->dset_id, dims) < 0) {
+            log_err("Error extending a history variable for direct chunk "
+                    "writes");
+        }
+    }
+
+    nthreads = options.COMPRESS_THREADS;
+    if (nthreads > var->nchunks) {
+        nthreads = var->nchunks;
+    }
+    jobs = malloc(nthreads * sizeof(*jobs));
+    check_alloc_status(jobs, "Memory allocation error.");
+    threads = malloc(nthreads * sizeof(*threads));
+    check_alloc_status(threads, "Memory allocation error.");
+
+    // the calling thread compresses the first share of the chunks
+    for (t = 0; t < nthreads; t++) {
+        jobs[t].var = var;
+        jobs[t].field = field;
+        jobs[t].grid = grid;
+        jobs[t].thread = t;
+        jobs[t].nthreads = nthreads;
+        if (t > 0) {
+            status = pthread_create(&(threads[t]), NULL,
+                                    compress_direct_chunks, &(jobs[t]));
+            if (status != 0) {
+                log_err("Could not start a compression thread: %d", status);
+            }
+        }
+    }
+    compress_direct_chunks(&(jobs[0]));
+    for (t = 1; t < nthreads; t++) {
+        status = pthread_join(threads[t], NULL);
+        if (status != 0) {
+            log_err("Could not join a compression thread: %d", status);
+        }
+    }
+    for (t = 0; t < nthreads; t++) {
+        if (jobs[t].status != Z_OK) {
+            log_err("Error %d compressing a chunk of a history variable",
+                    jobs[t].status);
+        }
+    }
+    free(jobs);
+    free(threads);
+
+    // HDF5 is written from this thread only
+    for (c = 0; c < var->nchunks; c++) {
+        get_direct_chunk_offset(var, c, offset);
+        offset[0] = (hsize_t) field->start[0];
+        if (H5Dwrite_chunk(var->dset_id, H5P_DEFAULT, 0, offset,
+                           var->zsize[c], var->zbuf + c * var->zbound) < 0) {
+            log_err("Error writing a chunk of a history variable");
+        }
+    }
+#else
+    (void) var;
+    (void) field;
+    (void) grid;
+    log_err("VIC was compiled without HDF5 support (make DIRECT_CHUNK=TRUE)");
+#endif
+}
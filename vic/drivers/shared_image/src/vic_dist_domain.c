@@ -0,0 +1,469 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Distributed setup of the domain (DISTRIBUTED_DOMAIN).
+ *
+ * Every process reads the mask, the run_cell flags, the coordinates and the
+ * number of vegetation types of a block of rows of the domain, instead of
+ * the master process reading them for the whole domain. The active cells
+ * are numbered with a prefix sum of their counts per block and sent to the
+ * processes that run them, which get blocks of consecutive active cells of
+ * the same size. The master process, which does the I/O of the global
+ * fields, receives the locations of all cells to set up its maps.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+/******************************************************************************
+ * @brief    Read the coordinates of a block of rows of a netCDF file.
+ * @details  Longitudes are rescaled to [-180, 180] as in get_nc_latlon().
+ *****************************************************************************/
+static void
+get_nc_latlon_rows(char               *nc_name,
+                   domain_info_struct *info,
+                   size_t              y_first,
+                   size_t              ny,
+                   size_t              nx,
+                   double             *lat,
+                   double             *lon)
+{
+    double *var = NULL;
+    size_t  i;
+    size_t  j;
+    size_t  d1count[1];
+    size_t  d1start[1];
+    size_t  d2count[2];
+    size_t  d2start[2];
+    int     ndims;
+
+    ndims = get_nc_varndimensions(nc_name, info->lon_var);
+    if (ndims != get_nc_varndimensions(nc_name, info->lat_var)) {
+        log_err("Un even number of dimensions for %s and %s in: %s",
+                info->lon_var, info->lat_var, nc_name);
+    }
+
+    if (ndims == 1) {
+        var = malloc((nx > ny ? nx : ny) * sizeof(*var));
+        check_alloc_status(var, "Memory allocation error.");
+
+        d1start[0] = 0;
+        d1count[0] = nx;
+        get_nc_field_double(nc_name, info->lon_var, d1start, d1count, var);
+        for (j = 0; j < ny; j++) {
+            for (i = 0; i < nx; i++) {
+                lon[j * nx + i] = var[i];
+            }
+        }
+
+        d1start[0] = y_first;
+        d1count[0] = ny;
+        if (ny > 0) {
+            get_nc_field_double(nc_name, info->lat_var, d1start, d1count,
+                                var);
+        }
+        for (j = 0; j < ny; j++) {
+            for (i = 0; i < nx; i++) {
+                lat[j * nx + i] = var[j];
+            }
+        }
+        free(var);
+    }
+    else if (ndims == 2) {
+        d2start[0] = y_first;
+        d2start[1] = 0;
+        d2count[0] = ny;
+        d2count[1] = nx;
+        if (ny > 0) {
+            get_nc_field_double(nc_name, info->lon_var, d2start, d2count,
+                                lon);
+            get_nc_field_double(nc_name, info->lat_var, d2start, d2count,
+                                lat);
+        }
+    }
+    else {
+        log_err("Number of coordinate dimensions in %s must be 1 or 2: %d",
+                nc_name, ndims);
+    }
+
+    for (i = 0; i < ny * nx; i++) {
+        // rescale to [-180., 180]. Note that the if statement is not strictly
+        // needed, but it prevents -180 from turning into 180 and vice versa
+        if (lon[i] < -180.f || lon[i] > 180.f) {
+            lon[i] -= round(lon[i] / 360.f) * 360.f;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Read an integer field of a block of rows of a netCDF file.
+ *****************************************************************************/
+static void
+get_nc_int_rows(char   *nc_name,
+                char   *var_name,
+                size_t  y_first,
+                size_t  ny,
+                size_t  nx,
+                int    *var)
+{
+    size_t d2count[2];
+    size_t d2start[2];
+
+    if (get_nc_var_type(nc_name, var_name) != NC_INT) {
+        log_err("%s in %s must be integer type.", var_name, nc_name);
+    }
+    if (ny > 0) {
+        d2start[0] = y_first;
+        d2start[1] = 0;
+        d2count[0] = ny;
+        d2count[1] = nx;
+        get_nc_field_int(nc_name, var_name, d2start, d2count, var);
+    }
+}
+
+/******************************************************************************
+ * @brief    Set up the global and local domains with every process reading
+ *           a block of rows of the domain.
+ * @details  Called by all processes instead of get_global_domain() on the
+ *           master process and the scatter of the locations. The active
+ *           cells are run in blocks of consecutive cells of the same size
+ *           by the processes that are not I/O servers.
+ *
+ *           The master process gets the locations of all grid cells, the
+ *           list of active cells and the MPI maps, which it needs to read
+ *           and write the global fields. The other processes get the size
+ *           and the description of the global domain only.
+ *****************************************************************************/
+void
+get_distributed_domain(void)
+{
+    extern domain_struct    global_domain;
+    extern domain_struct    local_domain;
+    extern filenames_struct filenames;
+    extern size_t          *filter_active_cells;
+    extern size_t          *mpi_map_mapping_array;
+    extern size_t          *mpi_map_grid_array;
+    extern int             *mpi_map_local_array_sizes;
+    extern int             *mpi_map_global_array_offsets;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern MPI_Datatype     mpi_location_struct_type;
+    extern int              mpi_rank;
+    extern int              mpi_size;
+    extern option_struct    options;
+
+    size_t                  nx;
+    size_t                  ny;
+    size_t                  y_first;
+    size_t                  ncells;
+    size_t                  nalloc;
+    size_t                  nactive;
+    size_t                  first_active;
+    size_t                  ncompute;
+    size_t                  block_size;
+    size_t                  block_extra;
+    size_t                  owner;
+    size_t                  i;
+    size_t                  j;
+    size_t                  d2count[2];
+    size_t                  d2start[2];
+    int                    *mask = NULL;
+    int                    *run = NULL;
+    int                    *nveg = NULL;
+    int                    *gather_counts = NULL;
+    int                    *gather_offsets = NULL;
+    int                    *send_counts = NULL;
+    int                    *send_offsets = NULL;
+    int                    *recv_counts = NULL;
+    int                    *recv_offsets = NULL;
+    int                     nlocal;
+    int                     status;
+    double                 *var = NULL;
+    double                 *lat = NULL;
+    double                 *lon = NULL;
+    double                 *param_lat = NULL;
+    double                 *param_lon = NULL;
+    location_struct        *block = NULL;
+    location_struct        *active = NULL;
+
+    // the description of the domain is read from the global parameter file
+    // on the master process
+    status = MPI_Bcast(&(global_domain.info), sizeof(domain_info_struct),
+                       MPI_BYTE, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    global_domain.n_nx = get_nc_dimension(filenames.domain,
+                                          global_domain.info.x_dim);
+    global_domain.n_ny = get_nc_dimension(filenames.domain,
+                                          global_domain.info.y_dim);
+    global_domain.ncells_total = global_domain.n_nx * global_domain.n_ny;
+    if (get_nc_dimension(filenames.params, global_domain.info.x_dim) !=
+        global_domain.n_nx) {
+        log_err("x dimension in parameters file does not match domain");
+    }
+    if (get_nc_dimension(filenames.params, global_domain.info.y_dim) !=
+        global_domain.n_ny) {
+        log_err("y dimension in parameters file does not match domain");
+    }
+
+    // the block of rows of this process
+    nx = global_domain.n_nx;
+    y_first = global_domain.n_ny * (size_t) mpi_rank / (size_t) mpi_size;
+    ny = global_domain.n_ny * (size_t) (mpi_rank + 1) / (size_t) mpi_size -
+         y_first;
+    ncells = nx * ny;
+    // a process may have no rows
+    nalloc = ncells > 0 ? ncells : 1;
+
+    mask = malloc(nalloc * sizeof(*mask));
+    check_alloc_status(mask, "Memory allocation error.");
+    run = malloc(nalloc * sizeof(*run));
+    check_alloc_status(run, "Memory allocation error.");
+    nveg = malloc(nalloc * sizeof(*nveg));
+    check_alloc_status(nveg, "Memory allocation error.");
+    var = malloc(nalloc * sizeof(*var));
+    check_alloc_status(var, "Memory allocation error.");
+    lat = malloc(nalloc * sizeof(*lat));
+    check_alloc_status(lat, "Memory allocation error.");
+    lon = malloc(nalloc * sizeof(*lon));
+    check_alloc_status(lon, "Memory allocation error.");
+    param_lat = malloc(nalloc * sizeof(*param_lat));
+    check_alloc_status(param_lat, "Memory allocation error.");
+    param_lon = malloc(nalloc * sizeof(*param_lon));
+    check_alloc_status(param_lon, "Memory allocation error.");
+    block = malloc(nalloc * sizeof(*block));
+    check_alloc_status(block, "Memory allocation error.");
+
+    get_nc_int_rows(filenames.domain, global_domain.info.mask_var, y_first,
+                    ny, nx, mask);
+    get_nc_int_rows(filenames.params, "run_cell", y_first, ny, nx, run);
+    get_nc_int_rows(filenames.params, "Nveg", y_first, ny, nx, nveg);
+    get_nc_latlon_rows(filenames.domain, &(global_domain.info), y_first, ny,
+                       nx, lat, lon);
+    get_nc_latlon_rows(filenames.params, &(global_domain.info), y_first, ny,
+                       nx, param_lat, param_lon);
+
+    // number the active cells of the block
+    nactive = 0;
+    for (i = 0; i < ncells; i++) {
+        if (run[i] == 1 && mask[i] != 1) {
+            log_err("Run_cell = 1 should only appear within the mask of the "
+                    "domain file.");
+        }
+        if (run[i] == 1) {
+            nactive++;
+        }
+    }
+    first_active = 0;
+    status = MPI_Exscan(&nactive, &first_active, 1, MPI_UNSIGNED_LONG,
+                        MPI_SUM, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (mpi_rank == 0) {
+        // the result of MPI_Exscan is undefined on the first process
+        first_active = 0;
+    }
+    status = MPI_Allreduce(&nactive, &(global_domain.ncells_active), 1,
+                           MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    debug("%zu active grid cells found in run_cell in the parameter file.",
+          global_domain.ncells_active);
+
+    for (i = 0, j = first_active; i < ncells; i++) {
+        initialize_location(&(block[i]));
+        block[i].latitude = lat[i];
+        block[i].longitude = lon[i];
+        block[i].nveg = (size_t) nveg[i];
+        // check that the coordinates of the parameter file match
+        if (!assert_close_double(param_lat[i], lat[i], 0, 0.01)) {
+            log_err("latitude in parameter (%lf) file does not match the "
+                    "latitude in the domain file (%lf) for gridcell %zu",
+                    param_lat[i], lat[i], y_first * nx + i);
+        }
+        if (!assert_close_double(param_lon[i], lon[i], 0, 0.01)) {
+            log_err("longitude in parameter (%lf) file does not match the "
+                    "longitude in the domain file (%lf) for gridcell %zu",
+                    param_lon[i], lon[i], y_first * nx + i);
+        }
+        if (run[i] == 1) {
+            block[i].run = true;
+            block[i].io_idx = y_first * nx + i;
+            block[i].global_idx = j++;
+        }
+    }
+
+    // area and fraction of the grid cells
+    if (ny > 0) {
+        d2start[0] = y_first;
+        d2start[1] = 0;
+        d2count[0] = ny;
+        d2count[1] = nx;
+        get_nc_field_double(filenames.domain, global_domain.info.area_var,
+                            d2start, d2count, var);
+        for (i = 0; i < ncells; i++) {
+            block[i].area = var[i];
+        }
+        get_nc_field_double(filenames.domain, global_domain.info.frac_var,
+                            d2start, d2count, var);
+        for (i = 0; i < ncells; i++) {
+            block[i].frac = var[i];
+        }
+    }
+
+    // the active cells of the block, in the order of their global index
+    active = malloc((nactive > 0 ? nactive : 1) * sizeof(*active));
+    check_alloc_status(active, "Memory allocation error.");
+    for (i = 0, j = 0; i < ncells; i++) {
+        if (block[i].run) {
+            active[j++] = block[i];
+        }
+    }
+
+    // blocks of consecutive active cells of the same size, the I/O servers
+    // are the last processes and do not run any cells
+    ncompute = (size_t) mpi_size - options.IO_SERVERS;
+    block_size = global_domain.ncells_active / ncompute;
+    block_extra = global_domain.ncells_active % ncompute;
+
+    mpi_map_local_array_sizes = calloc(mpi_size,
+                                       sizeof(*mpi_map_local_array_sizes));
+    check_alloc_status(mpi_map_local_array_sizes, "Memory allocation error.");
+    mpi_map_global_array_offsets =
+        calloc(mpi_size, sizeof(*mpi_map_global_array_offsets));
+    check_alloc_status(mpi_map_global_array_offsets,
+                       "Memory allocation error.");
+    for (i = 0, j = 0; i < (size_t) mpi_size; i++) {
+        if (i < ncompute) {
+            mpi_map_local_array_sizes[i] =
+                (int) (block_size + (i < block_extra ? 1 : 0));
+        }
+        mpi_map_global_array_offsets[i] = (int) j;
+        j += mpi_map_local_array_sizes[i];
+    }
+
+    // send the active cells to the processes that run them
+    send_counts = calloc(mpi_size, sizeof(*send_counts));
+    check_alloc_status(send_counts, "Memory allocation error.");
+    send_offsets = calloc(mpi_size, sizeof(*send_offsets));
+    check_alloc_status(send_offsets, "Memory allocation error.");
+    recv_counts = calloc(mpi_size, sizeof(*recv_counts));
+    check_alloc_status(recv_counts, "Memory allocation error.");
+    recv_offsets = calloc(mpi_size, sizeof(*recv_offsets));
+    check_alloc_status(recv_offsets, "Memory allocation error.");
+
+    for (i = 0, owner = 0; i < nactive; i++) {
+        while ((size_t) (mpi_map_global_array_offsets[owner] +
+                         mpi_map_local_array_sizes[owner]) <=
+               active[i].global_idx) {
+            owner++;
+        }
+        send_counts[owner]++;
+    }
+    for (i = 1; i < (size_t) mpi_size; i++) {
+        send_offsets[i] = send_offsets[i - 1] + send_counts[i - 1];
+    }
+    status = MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT,
+                          MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    for (i = 1; i < (size_t) mpi_size; i++) {
+        recv_offsets[i] = recv_offsets[i - 1] + recv_counts[i - 1];
+    }
+
+    local_domain.ncells_active =
+        (size_t) mpi_map_local_array_sizes[mpi_rank];
+    local_domain.locations = malloc((local_domain.ncells_active > 0 ?
+                                     local_domain.ncells_active : 1) *
+                                    sizeof(*local_domain.locations));
+    check_alloc_status(local_domain.locations, "Memory allocation error.");
+    status = MPI_Alltoallv(active, send_counts, send_offsets,
+                           mpi_location_struct_type, local_domain.locations,
+                           recv_counts, recv_offsets,
+                           mpi_location_struct_type, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    // the master process gets all grid cells
+    if (mpi_rank == VIC_MPI_ROOT) {
+        gather_counts = malloc(mpi_size * sizeof(*gather_counts));
+        check_alloc_status(gather_counts, "Memory allocation error.");
+        gather_offsets = malloc(mpi_size * sizeof(*gather_offsets));
+        check_alloc_status(gather_offsets, "Memory allocation error.");
+        for (i = 0; i < (size_t) mpi_size; i++) {
+            gather_offsets[i] = (int) (nx * (global_domain.n_ny * i /
+                                             (size_t) mpi_size));
+            gather_counts[i] = (int) (nx * (global_domain.n_ny * (i + 1) /
+                                            (size_t) mpi_size)) -
+                               gather_offsets[i];
+        }
+        global_domain.locations = malloc(global_domain.ncells_total *
+                                         sizeof(*global_domain.locations));
+        check_alloc_status(global_domain.locations,
+                           "Memory allocation error.");
+    }
+    nlocal = (int) ncells;
+    status = MPI_Gatherv(block, nlocal, mpi_location_struct_type,
+                         global_domain.locations, gather_counts,
+                         gather_offsets, mpi_location_struct_type,
+                         VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        // the maps of the master process, the active cells are in the order
+        // of the processes
+        filter_active_cells = malloc(global_domain.ncells_active *
+                                     sizeof(*filter_active_cells));
+        check_alloc_status(filter_active_cells, "Memory allocation error.");
+        mpi_map_mapping_array = malloc(global_domain.ncells_active *
+                                       sizeof(*mpi_map_mapping_array));
+        check_alloc_status(mpi_map_mapping_array, "Memory allocation error.");
+        for (i = 0, j = 0; i < global_domain.ncells_total; i++) {
+            if (global_domain.locations[i].run) {
+                filter_active_cells[j] = global_domain.locations[i].io_idx;
+                mpi_map_mapping_array[j] = j;
+                j++;
+            }
+        }
+        mpi_map_grid_domain(global_domain.ncells_active, filter_active_cells,
+                            mpi_map_mapping_array, &mpi_map_grid_array);
+        free(gather_counts);
+        free(gather_offsets);
+    }
+    else {
+        // the maps are only used on the master process
+        free(mpi_map_local_array_sizes);
+        free(mpi_map_global_array_offsets);
+        mpi_map_local_array_sizes = NULL;
+        mpi_map_global_array_offsets = NULL;
+    }
+
+    free(mask);
+    free(run);
+    free(nveg);
+    free(var);
+    free(lat);
+    free(lon);
+    free(param_lat);
+    free(param_lon);
+    free(block);
+    free(active);
+    free(send_counts);
+    free(send_offsets);
+    free(recv_counts);
+    free(recv_offsets);
+}
@@ -34,10 +34,13 @@ vic_finalize(void)
 {
     extern size_t             *filter_active_cells;
     extern size_t             *mpi_map_mapping_array;
+    extern size_t             *mpi_map_grid_array;
     extern all_vars_struct    *all_vars;
     extern force_data_struct  *force;
     extern domain_struct       global_domain;
     extern domain_struct       local_domain;
+    extern lake_con_struct    *lake_con;
+    extern size_t             *lake_cells;
     extern filep_struct        filep;
     extern int                *mpi_map_local_array_sizes;
     extern int                *mpi_map_global_array_offsets;
@@ -51,7 +54,6 @@ vic_finalize(void)
     extern veg_con_map_struct *veg_con_map;
     extern veg_con_struct    **veg_con;
     extern veg_hist_struct   **veg_hist;
-    extern veg_lib_struct    **veg_lib;
     extern MPI_Datatype        mpi_global_struct_type;
     extern MPI_Datatype        mpi_filenames_struct_type;
     extern MPI_Datatype        mpi_location_struct_type;
@@ -60,46 +62,98 @@ vic_finalize(void)
     extern MPI_Datatype        mpi_param_struct_type;
 
     size_t                     i;
-    size_t                     j;
     int                        status;
 
 
     if (mpi_rank == VIC_MPI_ROOT) {
         // close the global parameter file
         fclose(filep.globalparam);
+    }
+
+    // write the queued history records and stop the writer thread
+    finalize_async_output();
+
+    // write the pending state snapshot and stop the checkpoint thread
+    finalize_async_state();
+
+    // release the base state of incremental state files
+    free_state_fast_base();
+
+    // release the block order of the cell loop
+    free_run_blocks();
+
+    // release the scratch memory of vic_run on each thread
+    #pragma omp parallel num_threads(options.NTHREADS)
+    {
+        free_scratch_arena();
+    }
+
+    // release the buffers of the gather and scatter functions
+    free_mpi_io_buffers();
+    if (options.HIERARCHICAL_IO) {
+        finalize_node_io();
+    }
+
+    // close the netcdf input files that are still open. With PARALLEL_IO,
+    // all nodes have forcing files open
+    close_nc_files();
 
-        // close the netcdf history file if it is still open
-        for (i = 0; i < options.Noutstreams; i++) {
-            if (nc_hist_files[i].open == true) {
-                status = nc_close(nc_hist_files[i].nc_id);
-                check_nc_status(status, "Error closing history file");
+    // the consumers of the published streams see the end of the streams
+    finalize_adios2_streams();
+
+    // close the netcdf history file if it is still open
+    for (i = 0; i < options.Noutstreams; i++) {
+        // write the pending record
+        free_nc_io_request(&(nc_hist_files[i].io_request));
+        free_stream_mask(&(nc_hist_files[i]));
+        free_stream_regions(&(nc_hist_files[i]));
+        if (nc_hist_files[i].open == true) {
+            if (nc_hist_files[i].direct) {
+                close_direct_chunks(&(nc_hist_files[i]), &(output_streams[i]));
             }
-            free(nc_hist_files[i].nc_vars);
+            status = nc_close(nc_hist_files[i].nc_id);
+            check_nc_status(status, "Error closing history file");
+        }
+        if (nc_hist_files[i].template_file[0] != '\0') {
+            remove(nc_hist_files[i].template_file);
         }
-        free(nc_hist_files);
+        free(nc_hist_files[i].nc_vars);
+        free(nc_hist_files[i].io_fields);
+    }
+    free(nc_hist_files);
+    finalize_split_io();
+
+    if (options.PARALLEL_IO) {
+        finalize_par_io();
     }
 
     for (i = 0; i < local_domain.ncells_active; i++) {
-        free_force(&(force[i]));
-        free(soil_con[i].AreaFract);
-        free(soil_con[i].BandElev);
-        free(soil_con[i].Tfactor);
-        free(soil_con[i].Pfactor);
-        free(soil_con[i].AboveTreeLine);
-        for (j = 0; j < veg_con_map[i].nv_active; j++) {
-            free(veg_con[i][j].zone_depth);
-            free(veg_con[i][j].zone_fract);
-            if (options.CARBON) {
-                free(veg_con[i][j].CanopLayerBnd);
-            }
-            free_veg_hist(&(veg_hist[i][j]));
+        free_all_vars(&(all_vars[i]));
+    }
+    if (options.LAKES) {
+        free(lake_cells);
+        free(lake_con);
+    }
+
+    // the remaining arrays of all grid cells are slabs that start at the
+    // first grid cell, see vic_alloc()
+    if (local_domain.ncells_active > 0) {
+        free(soil_con[0].AreaFract);
+        free(soil_con[0].BandElev);
+        free(soil_con[0].Tfactor);
+        free(soil_con[0].Pfactor);
+        free(soil_con[0].AboveTreeLine);
+        free(veg_con[0][0].zone_depth);
+        free(veg_con[0][0].zone_fract);
+        if (options.CARBON) {
+            free(veg_con[0][0].CanopLayerBnd);
         }
-        free_all_vars(&(all_vars[i]), veg_con_map[i].nv_active);
-        free(veg_con_map[i].vidx);
-        free(veg_con_map[i].Cv);
-        free(veg_con[i]);
-        free(veg_hist[i]);
-        free(veg_lib[i]);
+        free_force(force);
+        free_veg_hist(veg_hist[0]);
+        free(veg_con_map[0].vidx);
+        free(veg_con_map[0].Cv);
+        free(veg_con[0]);
+        free(veg_hist[0]);
     }
 
     free_streams(&output_streams);
@@ -109,7 +163,7 @@ vic_finalize(void)
     free(veg_con_map);
     free(veg_con);
     free(veg_hist);
-    free(veg_lib);
+    free_veg_lib();
     free(all_vars);
     free(save_data);
     free(local_domain.locations);
@@ -119,6 +173,7 @@ vic_finalize(void)
         free(mpi_map_local_array_sizes);
         free(mpi_map_global_array_offsets);
         free(mpi_map_mapping_array);
+        free(mpi_map_grid_array);
     }
 
     MPI_Type_free(&mpi_global_struct_type);
@@ -127,5 +182,8 @@ vic_finalize(void)
     MPI_Type_free(&mpi_alarm_struct_type);
     MPI_Type_free(&mpi_option_struct_type);
     MPI_Type_free(&mpi_param_struct_type);
+
+    // warnings by call site of all processes
+    reduce_log_summary();
     finalize_logging();
 }
@@ -0,0 +1,368 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Progress heartbeat of long runs.
+ *
+ * With HEARTBEAT_STEPS or HEARTBEAT_SECONDS, the compute processes reduce
+ * their I/O and compute times since the last heartbeat onto the master
+ * process, which logs the simulated date, the throughput, the estimated time
+ * to completion, the I/O share and the slowest process.
+ *
+ * The reductions are non-blocking: they are posted at the end of a
+ * heartbeat time step and the master process logs the result as soon as it
+ * has arrived, normally one time step later. All processes must post them
+ * in the same time step, so the time step of the next heartbeat is chosen
+ * by the master process and sent along with a non-blocking broadcast, two
+ * or more time steps ahead.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+// values reduced at a heartbeat, over the time since the last one
+enum
+{
+    HEARTBEAT_WALL,     /**< wall time */
+    HEARTBEAT_IO,       /**< forcing and history I/O */
+    HEARTBEAT_COMPUTE,  /**< vic_run and put_data */
+    HEARTBEAT_IO_SHARE, /**< share of the wall time spent in I/O */
+    N_HEARTBEAT_VALUES
+};
+
+enum
+{
+    HEARTBEAT_REQ_MAX,  /**< maximum over the processes */
+    HEARTBEAT_REQ_SUM,  /**< sum over the processes */
+    HEARTBEAT_REQ_LOC,  /**< slowest process */
+    HEARTBEAT_REQ_NEXT, /**< time step of the next heartbeat */
+    N_HEARTBEAT_REQ
+};
+
+static struct {
+    bool active;
+    size_t next;              /**< time step of the next heartbeat */
+    size_t next_bcast;        /**< buffer of the broadcast of next */
+    bool pending;             /**< reductions have been posted */
+    MPI_Request requests[N_HEARTBEAT_REQ];
+    double local[N_HEARTBEAT_VALUES];  /**< this process */
+    double max[N_HEARTBEAT_VALUES];    /**< maximum over the processes */
+    double sum[N_HEARTBEAT_VALUES];    /**< sum over the processes */
+    struct {
+        double value;
+        int rank;
+    } slowest_local, slowest;  /**< compute time and rank of the slowest
+                                  process */
+    double start_wall;        /**< start of the time loop */
+    double last_wall;         /**< wall time of the last heartbeat */
+    double last_io;           /**< I/O time at the last heartbeat */
+    double last_compute;      /**< compute time at the last heartbeat */
+    size_t last_step;         /**< time steps done at the last heartbeat */
+    size_t step;              /**< time steps done at the pending
+                                 heartbeat */
+    size_t nsteps;            /**< time steps since the heartbeat before */
+    dmy_struct dmy;           /**< date of the pending heartbeat */
+} heartbeat;
+
+/******************************************************************************
+ * @brief    I/O time of the calling process from the phase timers.
+ *****************************************************************************/
+static double
+get_heartbeat_io_time(void)
+{
+    extern timer_struct global_timers[N_TIMERS];
+
+    return global_timers[TIMER_VIC_FORCE_READ].delta_wall +
+           global_timers[TIMER_VIC_FORCE_SCATTER].delta_wall +
+           global_timers[TIMER_VIC_HIST_GATHER].delta_wall +
+           global_timers[TIMER_VIC_HIST_WRITE].delta_wall +
+           global_timers[TIMER_VIC_STATE_WRITE].delta_wall;
+}
+
+/******************************************************************************
+ * @brief    Compute time of the calling process from the phase timers.
+ *****************************************************************************/
+static double
+get_heartbeat_compute_time(void)
+{
+    extern timer_struct global_timers[N_TIMERS];
+
+    return global_timers[TIMER_VIC_PHYSICS].delta_wall +
+           global_timers[TIMER_VIC_PUT_DATA].delta_wall +
+           global_timers[TIMER_VIC_ROUTING].delta_wall;
+}
+
+/******************************************************************************
+ * @brief    Write a duration in seconds as days, hours, minutes and seconds.
+ *****************************************************************************/
+static void
+sprint_heartbeat_duration(char  *str,
+                          double seconds)
+{
+    unsigned long total;
+
+    total = (unsigned long) (seconds + 0.5);
+    if (total >= SEC_PER_DAY) {
+        sprintf(str, "%lud %02lu:%02lu:%02lu", total / SEC_PER_DAY,
+                (total % SEC_PER_DAY) / SEC_PER_HOUR,
+                (total % SEC_PER_HOUR) / SEC_PER_MIN, total % SEC_PER_MIN);
+    }
+    else {
+        sprintf(str, "%02lu:%02lu:%02lu", total / SEC_PER_HOUR,
+                (total % SEC_PER_HOUR) / SEC_PER_MIN, total % SEC_PER_MIN);
+    }
+}
+
+/******************************************************************************
+ * @brief    Time step of the next heartbeat, chosen by the master process.
+ * @details  The next heartbeat is at least two time steps ahead, so that the
+ *           other processes have received it before they get there.
+ *****************************************************************************/
+static size_t
+get_next_heartbeat(double interval)
+{
+    extern option_struct options;
+
+    size_t               nsteps = 0;
+    size_t               nseconds;
+
+    if (options.HEARTBEAT_STEPS > 0) {
+        nsteps = options.HEARTBEAT_STEPS;
+    }
+    if (options.HEARTBEAT_SECONDS > 0) {
+        // time steps in HEARTBEAT_SECONDS at the throughput of the last
+        // interval
+        nseconds = 1;
+        if (interval > 0.) {
+            nseconds = (size_t) (options.HEARTBEAT_SECONDS *
+                                 heartbeat.nsteps / interval);
+        }
+        if (nsteps == 0 || nseconds < nsteps) {
+            nsteps = nseconds;
+        }
+    }
+    if (nsteps < 2) {
+        nsteps = 2;
+    }
+
+    return heartbeat.next + nsteps;
+}
+
+/******************************************************************************
+ * @brief    Log the pending heartbeat on the master process.
+ *****************************************************************************/
+static void
+log_heartbeat(void)
+{
+    extern global_param_struct global_param;
+    extern domain_struct       global_domain;
+    extern int                 mpi_size;
+
+    char                       eta_str[MAXSTRING];
+    double                     interval;
+    double                     steps_per_sec = 0.;
+    double                     eta = 0.;
+    double                     io_share = 0.;
+    double                     io_share_max = 0.;
+    double                     imbalance = 1.;
+    double                     compute_mean;
+
+    interval = heartbeat.local[HEARTBEAT_WALL];
+    if (interval > 0.) {
+        steps_per_sec = heartbeat.nsteps / interval;
+    }
+    if (heartbeat.step > 0) {
+        eta = (heartbeat.last_wall - heartbeat.start_wall) *
+              (global_param.nrecs - heartbeat.step) / heartbeat.step;
+    }
+    if (heartbeat.sum[HEARTBEAT_WALL] > 0.) {
+        io_share = heartbeat.sum[HEARTBEAT_IO] /
+                   heartbeat.sum[HEARTBEAT_WALL];
+    }
+    io_share_max = heartbeat.max[HEARTBEAT_IO_SHARE];
+    compute_mean = heartbeat.sum[HEARTBEAT_COMPUTE] / mpi_size;
+    if (compute_mean > 0.) {
+        imbalance = heartbeat.max[HEARTBEAT_COMPUTE] / compute_mean;
+    }
+
+    sprint_heartbeat_duration(eta_str, eta);
+    log_info("Heartbeat: %04d-%02d-%02d-%05d, step %zu of %zu (%.1f%%), "
+             "%.2f steps/s, %.4g cell steps/s, ETA %s, I/O %.1f%% "
+             "(max %.1f%%), compute max/mean %.2f (rank %d)",
+             heartbeat.dmy.year, heartbeat.dmy.month, heartbeat.dmy.day,
+             heartbeat.dmy.dayseconds, heartbeat.step, global_param.nrecs,
+             100. * heartbeat.step / global_param.nrecs, steps_per_sec,
+             steps_per_sec * global_domain.ncells_active, eta_str,
+             100. * io_share, 100. * io_share_max, imbalance,
+             heartbeat.slowest.rank);
+}
+
+/******************************************************************************
+ * @brief    Complete the pending reductions and log them.
+ *****************************************************************************/
+static void
+wait_heartbeat(void)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+    extern int      mpi_rank;
+
+    int             status;
+
+    if (!heartbeat.pending) {
+        return;
+    }
+    status = MPI_Waitall(N_HEARTBEAT_REQ, heartbeat.requests,
+                         MPI_STATUSES_IGNORE);
+    check_mpi_status(status, "MPI error.");
+    heartbeat.pending = false;
+    heartbeat.next = heartbeat.next_bcast;
+    if (mpi_rank == VIC_MPI_ROOT) {
+        log_heartbeat();
+    }
+}
+
+/******************************************************************************
+ * @brief    Start the heartbeat if HEARTBEAT_STEPS or HEARTBEAT_SECONDS is
+ *           set.
+ * @details  Called by the compute processes at the start of the time loop.
+ *           Without a step interval, the first heartbeat is after the first
+ *           time step.
+ *****************************************************************************/
+void
+initialize_heartbeat(void)
+{
+    extern option_struct options;
+
+    if (options.HEARTBEAT_STEPS == 0 && options.HEARTBEAT_SECONDS == 0) {
+        return;
+    }
+
+    heartbeat.active = true;
+    heartbeat.pending = false;
+    heartbeat.start_wall = get_wall_time();
+    heartbeat.last_wall = heartbeat.start_wall;
+    heartbeat.last_io = get_heartbeat_io_time();
+    heartbeat.last_compute = get_heartbeat_compute_time();
+    heartbeat.last_step = 0;
+    heartbeat.next = 0;
+    if (options.HEARTBEAT_SECONDS == 0) {
+        heartbeat.next = options.HEARTBEAT_STEPS - 1;
+    }
+}
+
+/******************************************************************************
+ * @brief    Post the heartbeat reductions at the end of a time step.
+ * @details  Must be called by all compute processes at the end of every time
+ *           step. Does nothing without a heartbeat. Completed reductions are
+ *           logged on the master process.
+ *****************************************************************************/
+void
+update_heartbeat(dmy_struct *dmy_current)
+{
+    extern size_t       current;
+    extern MPI_Comm     MPI_COMM_VIC;
+    extern int          mpi_rank;
+
+    double              now;
+    double              io;
+    double              compute;
+    int                 flag;
+    int                 status;
+
+    if (!heartbeat.active) {
+        return;
+    }
+
+    if (heartbeat.pending) {
+        status = MPI_Testall(N_HEARTBEAT_REQ, heartbeat.requests, &flag,
+                             MPI_STATUSES_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        if (flag || current >= heartbeat.next + 2) {
+            // the next heartbeat is at least two time steps after the
+            // pending one and must be known when it is due
+            wait_heartbeat();
+        }
+    }
+    if (current != heartbeat.next) {
+        return;
+    }
+
+    now = get_wall_time();
+    io = get_heartbeat_io_time();
+    compute = get_heartbeat_compute_time();
+    heartbeat.local[HEARTBEAT_WALL] = now - heartbeat.last_wall;
+    heartbeat.local[HEARTBEAT_IO] = io - heartbeat.last_io;
+    heartbeat.local[HEARTBEAT_COMPUTE] = compute - heartbeat.last_compute;
+    heartbeat.local[HEARTBEAT_IO_SHARE] = 0.;
+    if (heartbeat.local[HEARTBEAT_WALL] > 0.) {
+        heartbeat.local[HEARTBEAT_IO_SHARE] = heartbeat.local[HEARTBEAT_IO] /
+                                              heartbeat.local[HEARTBEAT_WALL];
+    }
+    heartbeat.slowest_local.value = heartbeat.local[HEARTBEAT_COMPUTE];
+    heartbeat.slowest_local.rank = mpi_rank;
+    heartbeat.step = current + 1;
+    heartbeat.nsteps = heartbeat.step - heartbeat.last_step;
+    heartbeat.dmy = *dmy_current;
+    if (mpi_rank == VIC_MPI_ROOT) {
+        heartbeat.next_bcast =
+            get_next_heartbeat(heartbeat.local[HEARTBEAT_WALL]);
+    }
+
+    status = MPI_Ireduce(heartbeat.local, heartbeat.max, N_HEARTBEAT_VALUES,
+                         MPI_DOUBLE, MPI_MAX, VIC_MPI_ROOT, MPI_COMM_VIC,
+                         &(heartbeat.requests[HEARTBEAT_REQ_MAX]));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Ireduce(heartbeat.local, heartbeat.sum, N_HEARTBEAT_VALUES,
+                         MPI_DOUBLE, MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC,
+                         &(heartbeat.requests[HEARTBEAT_REQ_SUM]));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Ireduce(&(heartbeat.slowest_local), &(heartbeat.slowest), 1,
+                         MPI_DOUBLE_INT, MPI_MAXLOC, VIC_MPI_ROOT,
+                         MPI_COMM_VIC,
+                         &(heartbeat.requests[HEARTBEAT_REQ_LOC]));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Ibcast(&(heartbeat.next_bcast), 1, MPI_AINT, VIC_MPI_ROOT,
+                        MPI_COMM_VIC,
+                        &(heartbeat.requests[HEARTBEAT_REQ_NEXT]));
+    check_mpi_status(status, "MPI error.");
+    heartbeat.pending = true;
+
+    heartbeat.last_wall = now;
+    heartbeat.last_io = io;
+    heartbeat.last_compute = compute;
+    heartbeat.last_step = heartbeat.step;
+
+    // the buffered log files can be followed at the heartbeats
+    fflush(LOG_DEST);
+}
+
+/******************************************************************************
+ * @brief    Complete and log the last heartbeat.
+ * @details  Must be called by all compute processes after the time loop.
+ *****************************************************************************/
+void
+finalize_heartbeat(void)
+{
+    if (heartbeat.active) {
+        wait_heartbeat();
+        heartbeat.active = false;
+    }
+}
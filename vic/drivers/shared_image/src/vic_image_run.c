@@ -26,19 +26,153 @@
 
 #include <vic_driver_shared_image.h>
 
+// a block of consecutive cells
+typedef struct {
+    size_t idx;               /**< block number */
+    double cost;              /**< wall time of the block in the last time
+                                 step */
+} run_block_struct;
+
+// blocks in the order in which they are handed out to the threads
+static struct {
+    size_t nblocks;
+    run_block_struct *order;
+} run_blocks;
+
 /******************************************************************************
- * @brief    Run VIC for one timestep and store output data
+ * @brief    Compare two blocks by decreasing cost.
+ * @details  Blocks with the same cost keep the order of their numbers.
+ *****************************************************************************/
+static int
+compare_run_blocks(const void *a,
+                   const void *b)
+{
+    const run_block_struct *x = a;
+    const run_block_struct *y = b;
+
+    if (x->cost > y->cost) {
+        return -1;
+    }
+    if (x->cost < y->cost) {
+        return 1;
+    }
+    if (x->idx < y->idx) {
+        return -1;
+    }
+    return (x->idx > y->idx);
+}
+
+/******************************************************************************
+ * @brief    Number of consecutive cells in a block of the cell loop.
+ * @details  About RUN_BLOCKS_PER_THREAD blocks per thread and at most
+ *           MAX_RUN_BLOCK cells per block.
+ *****************************************************************************/
+size_t
+get_run_block_size(void)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+
+    size_t               block;
+
+    block = local_domain.ncells_active /
+            (options.NTHREADS * RUN_BLOCKS_PER_THREAD);
+    if (block < 1) {
+        block = 1;
+    }
+    else if (block > MAX_RUN_BLOCK) {
+        block = MAX_RUN_BLOCK;
+    }
+
+    return block;
+}
+
+/******************************************************************************
+ * @brief    Order the blocks of cells by their cost in the last time step.
+ * @details  The most expensive blocks are handed out first, so that the
+ *           threads finish the time step with cheap blocks and wait less for
+ *           each other. In the first time step, and with NUMA_FIRST_TOUCH,
+ *           the blocks are in the order of the cells.
+ *****************************************************************************/
+static void
+set_run_block_order(size_t nblocks)
+{
+    extern option_struct options;
+
+    size_t b;
+
+    if (run_blocks.nblocks != nblocks) {
+        free(run_blocks.order);
+        run_blocks.nblocks = nblocks;
+        run_blocks.order = malloc(nblocks * sizeof(*(run_blocks.order)));
+        check_alloc_status(run_blocks.order, "Memory allocation error.");
+        for (b = 0; b < nblocks; b++) {
+            run_blocks.order[b].idx = b;
+            run_blocks.order[b].cost = 0.;
+        }
+    }
+    else if (!options.NUMA_FIRST_TOUCH) {
+        qsort(run_blocks.order, nblocks, sizeof(*(run_blocks.order)),
+              compare_run_blocks);
+    }
+}
+
+/******************************************************************************
+ * @brief    Free the block order of the cell loop.
  *****************************************************************************/
 void
-vic_image_run(dmy_struct *dmy_current)
+free_run_blocks(void)
+{
+    free(run_blocks.order);
+    run_blocks.order = NULL;
+    run_blocks.nblocks = 0;
+}
+
+/******************************************************************************
+ * @brief    Fill the output data of a cell with synthetic values.
+ * @details  Replaces vic_run and put_data with IO_BENCHMARK, so that the I/O
+ *           path of the model can be timed without the physics. The values
+ *           depend on the variable, the element and the air temperature of
+ *           the forcing, so that the output still varies in space and time.
+ *****************************************************************************/
+static void
+fill_synthetic_data(force_data_struct *force,
+                    double           **out_data)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 k;
+    size_t                 e;
+
+    for (k = 0; k < N_OUTVAR_TYPES; k++) {
+        for (e = 0; e < out_metadata[k].nelem; e++) {
+            out_data[k][e] = (double) k + (double) e * 0.01 +
+                             force->air_temp[NR];
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Run VIC and store the output data for the cells of one block and
+ *           aggregate them into the output streams.
+ * @details  n is the position of the block in run_blocks.order. The wall
+ *           times and the solver counters are added to the totals of the
+ *           calling thread.
+ *****************************************************************************/
+static void
+run_cell_block(size_t      n,
+               size_t      block,
+               dmy_struct *dmy_current,
+               double     *run_wall,
+               double     *put_wall,
+               double     *agg_wall,
+               size_t     *solver_totals)
 {
-    extern size_t              current;
     extern all_vars_struct    *all_vars;
     extern force_data_struct  *force;
     extern domain_struct       local_domain;
     extern option_struct       options;
     extern global_param_struct global_param;
-    extern lake_con_struct     lake_con;
     extern double           ***out_data;
     extern stream_struct      *output_streams;
     extern save_data_struct   *save_data;
@@ -47,31 +181,190 @@ vic_image_run(dmy_struct *dmy_current)
     extern veg_hist_struct   **veg_hist;
     extern veg_lib_struct    **veg_lib;
 
-    char                       dmy_str[MAXSTRING];
     size_t                     i;
+    size_t                     j;
+    size_t                     first;
+    size_t                     last;
     timer_struct               timer;
+    bool                       timer_cpu;
+    double                     block_start;
+    double                     put_start;
+    double                     agg_start;
+    double                     now;
 
-    // Print the current timestep info before running vic_run
-    sprint_dmy(dmy_str, dmy_current);
-    debug("Running timestep %zu: %s", current, dmy_str);
+    // the wall time of vic_run is always needed for the timing table and
+    // the cost map, the CPU time only for OUT_TIME_VICRUN_CPU
+    timer_cpu = outvar_group_requested(OUT_GROUP_TIME_CPU);
+
+    block_start = get_wall_time();
+    first = run_blocks.order[n].idx * block;
+    last = first + block;
+    if (last > local_domain.ncells_active) {
+        last = local_domain.ncells_active;
+    }
+
+    for (i = first; i < last; i++) {
+        // Set thread-local reference (for debugging inside vic_run)
+        vic_run_ref.id_name = "io_idx";
+        vic_run_ref.id = local_domain.locations[i].io_idx;
+        vic_run_ref.dmy = dmy_current;
 
-    for (i = 0; i < local_domain.ncells_active; i++) {
-        // Set global reference string (for debugging inside vic_run)
-        sprintf(vic_run_ref_str, "Gridcell io_idx: %zu, timestep info: %s",
-                local_domain.locations[i].io_idx, dmy_str);
+        if (options.IO_BENCHMARK) {
+            timer_start_clocks(&timer, true, false);
+            fill_synthetic_data(&(force[i]), out_data[i]);
+            timer_stop_clocks(&timer, true, false);
+            *run_wall += timer.delta_wall;
+            update_cost_map(i, timer.delta_wall);
+            continue;
+        }
 
         update_step_vars(&(all_vars[i]), veg_con[i], veg_hist[i]);
 
-        timer_start(&timer);
+        timer_start_clocks(&timer, true, timer_cpu);
         vic_run(&(force[i]), &(all_vars[i]), dmy_current, &global_param,
-                &lake_con, &(soil_con[i]), veg_con[i], veg_lib[i]);
-        timer_stop(&timer);
+                get_lake_con(i), &(soil_con[i]), veg_con[i], veg_lib[i]);
+        timer_stop_clocks(&timer, true, timer_cpu);
+        *run_wall += timer.delta_wall;
+        update_cost_map(i, timer.delta_wall);
+        for (j = 0; j < N_SOLVER_STATS; j++) {
+            solver_totals[j] += solver_stats[j];
+        }
 
+        put_start = get_wall_time();
         put_data(&(all_vars[i]), &(force[i]), &(soil_con[i]), veg_con[i],
-                 veg_lib[i], &lake_con, out_data[i], &(save_data[i]),
+                 veg_lib[i], get_lake_con(i), out_data[i], &(save_data[i]),
                  &timer);
+        *put_wall += get_wall_time() - put_start;
     }
+
+    agg_start = get_wall_time();
+    // the output of COMPUTE_BENCHMARK is discarded
+    for (j = 0; j < options.Noutstreams && !options.COMPUTE_BENCHMARK; j++) {
+        agg_stream_cells(&(output_streams[j]), dmy_current, first, last,
+                         out_data);
+    }
+    now = get_wall_time();
+    *agg_wall += now - agg_start;
+    run_blocks.order[n].cost = now - block_start;
+}
+
+/******************************************************************************
+ * @brief    Run VIC for one timestep and store output data
+ * @details  The grid cells on the local domain are distributed over
+ *           options.NTHREADS threads in blocks of consecutive cells (see
+ *           get_run_block_size()), so that the state of neighboring cells is
+ *           processed by the same thread. The cost of a cell varies strongly
+ *           with the number of vegetation tiles, snow bands and the presence
+ *           of lakes and frozen soils, and expensive cells cluster
+ *           geographically, so the blocks are handed out dynamically in the
+ *           order of their cost in the last time step, most expensive first.
+ *           With NUMA_FIRST_TOUCH, each thread instead runs the same
+ *           contiguous share of the blocks in every time step, the share
+ *           whose state it first touched in vic_alloc(), so that the state
+ *           stays in the memory of its own NUMA node. Each block is
+ *           aggregated into the output streams by the thread that ran it, so
+ *           that no serial pass over the cells remains. The master thread
+ *           first completes the history records that vic_write_output()
+ *           started in the last time step, so that their gather and write
+ *           overlap with the physics of this time step.
+ *
+ *           The time of the cell loop is divided between the physics,
+ *           put_data and aggregation timers in proportion to the time the
+ *           threads spent in vic_run, put_data and agg_stream_cells. The
+ *           solver counters of the cells are summed for the timing table.
+ *           With TRACE_FILE, the time each thread spends on its cells is
+ *           traced.
+ *****************************************************************************/
+void
+vic_image_run(dmy_struct *dmy_current)
+{
+#if LOG_LVL < 10
+    extern size_t         current;
+#endif
+    extern domain_struct  local_domain;
+    extern option_struct  options;
+    extern stream_struct *output_streams;
+    extern timer_struct   global_timers[N_TIMERS];
+
+#if LOG_LVL < 10
+    char                  dmy_str[MAXSTRING];
+#endif
+    size_t                i;
+    size_t                n;
+    size_t                block;
+    size_t                nblocks;
+    timer_struct          loop_timer;
+    double                run_wall = 0.;
+    double                put_wall = 0.;
+    double                agg_wall = 0.;
+    double                total_wall;
+    size_t                solver_totals[N_SOLVER_STATS] = {0};
+
+    // Print the current timestep info before running vic_run
+#if LOG_LVL < 10
+    sprint_dmy(dmy_str, dmy_current);
+    debug("Running timestep %zu: %s", current, dmy_str);
+#endif
+
+    block = get_run_block_size();
+    nblocks = (local_domain.ncells_active + block - 1) / block;
+    set_run_block_order(nblocks);
+
+    // the groups sampled at this step are set before the alarms of the
+    // streams are advanced once, the cells are aggregated with their block
+    set_outvar_groups_step(output_streams, dmy_current);
     for (i = 0; i < options.Noutstreams; i++) {
-        agg_stream_data(&(output_streams[i]), dmy_current, out_data);
+        agg_stream_alarm(&(output_streams[i]), dmy_current);
+    }
+
+    timer_start(&loop_timer);
+    #pragma omp parallel num_threads(options.NTHREADS)
+    {
+        // the records of the last time step are written while the other
+        // threads start on the cells; only the master thread calls MPI
+        #pragma omp master
+        {
+            progress_history_records();
+        }
+        trace_begin(TRACE_CELLS);
+        if (options.NUMA_FIRST_TOUCH) {
+            // the same partition as the first touch in vic_alloc()
+            #pragma omp for schedule(static) \
+            reduction(+:run_wall, put_wall, agg_wall, solver_totals) nowait
+            for (n = 0; n < nblocks; n++) {
+                run_cell_block(n, block, dmy_current, &run_wall, &put_wall,
+                               &agg_wall, solver_totals);
+            }
+        }
+        else {
+            #pragma omp for schedule(dynamic, 1) \
+            reduction(+:run_wall, put_wall, agg_wall, solver_totals) nowait
+            for (n = 0; n < nblocks; n++) {
+                run_cell_block(n, block, dmy_current, &run_wall, &put_wall,
+                               &agg_wall, solver_totals);
+            }
+        }
+        // the idle time at the end of the loop is not part of the event
+        trace_end(TRACE_CELLS);
+    }
+    timer_stop(&loop_timer);
+    add_vic_solver_stats(solver_totals);
+
+    total_wall = run_wall + put_wall + agg_wall;
+    if (total_wall <= 0.) {
+        run_wall = 1.;
+        total_wall = 1.;
     }
+    global_timers[TIMER_VIC_PHYSICS].delta_wall +=
+        run_wall / total_wall * loop_timer.delta_wall;
+    global_timers[TIMER_VIC_PHYSICS].delta_cpu +=
+        run_wall / total_wall * loop_timer.delta_cpu;
+    global_timers[TIMER_VIC_PUT_DATA].delta_wall +=
+        put_wall / total_wall * loop_timer.delta_wall;
+    global_timers[TIMER_VIC_PUT_DATA].delta_cpu +=
+        put_wall / total_wall * loop_timer.delta_cpu;
+    global_timers[TIMER_VIC_AGG].delta_wall +=
+        agg_wall / total_wall * loop_timer.delta_wall;
+    global_timers[TIMER_VIC_AGG].delta_cpu +=
+        agg_wall / total_wall * loop_timer.delta_cpu;
 }
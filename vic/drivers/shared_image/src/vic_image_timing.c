@@ -25,6 +25,312 @@
  *****************************************************************************/
 
 #include <vic_driver_shared_image.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// range of the phase timers over the processes, see reduce_vic_phase_timers()
+static struct {
+    bool reduced;
+    int nprocs;
+    double min[N_TIMERS];
+    double max[N_TIMERS];
+    double mean[N_TIMERS];
+} phase_timers;
+
+// solver counters of the process, see add_vic_solver_stats()
+static size_t solver_totals[N_SOLVER_STATS];
+
+// sum and maximum of the solver counters over the processes
+static struct {
+    size_t sum[N_SOLVER_STATS];
+    size_t max[N_SOLVER_STATS];
+} solver_ranks;
+
+// bytes of the I/O phases of the process, see add_vic_io_bytes()
+static size_t io_bytes[N_IO_PHASES];
+
+// bytes of the I/O phases summed over the processes and their wall times,
+// the maximum over the processes
+static struct {
+    double bytes[N_IO_PHASES];
+    double wall[N_IO_PHASES];
+} io_ranks;
+
+// PERF_REGIONS counts summed over the processes
+static unsigned long long perf_counts[N_PERF_REGIONS][N_PERF_COUNTERS];
+
+// growth of the memory high-water mark of the process since the previous
+// sample, per sample point, and the high-water mark at the end (in MB), see
+// sample_vic_memory()
+static double memory_peaks[N_MEMORY_SAMPLES + 1];
+static double memory_last_peak = 0.;
+
+// estimated sizes of the major allocations of the process in MB
+static double memory_items[N_MEMORY_ITEMS];
+
+// range of the memory use over the processes, and the master node values
+static struct {
+    double min[N_MEMORY_SAMPLES + 1];
+    double max[N_MEMORY_SAMPLES + 1];
+    double mean[N_MEMORY_SAMPLES + 1];
+    double master[N_MEMORY_SAMPLES + 1];
+    double item_sum[N_MEMORY_ITEMS];
+    double item_max[N_MEMORY_ITEMS];
+    double item_master[N_MEMORY_ITEMS];
+} memory_ranks;
+
+#define BYTES_TO_MB(b) ((double) (b) / 1048576.)
+
+/******************************************************************************
+ * @brief    Memory high-water mark (peak resident set size) of the process
+ *           in MB.
+ *****************************************************************************/
+static double
+get_peak_memory(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.;
+    }
+#if defined(__APPLE__)
+    // bytes on OS X
+    return BYTES_TO_MB(usage.ru_maxrss);
+#else
+    // kilobytes on Linux and BSD
+    return (double) usage.ru_maxrss / 1024.;
+#endif
+}
+
+/******************************************************************************
+ * @brief    Estimate the sizes of the major allocations of the process.
+ * @details  The sizes follow the allocations of vic_alloc() and
+ *           vic_init_output(); the memory of the allocator itself is not
+ *           included.
+ *****************************************************************************/
+static void
+estimate_vic_memory(void)
+{
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
+    extern stream_struct      *output_streams;
+    extern veg_con_map_struct *veg_con_map;
+
+    size_t                     ncells = local_domain.ncells_active;
+    size_t                     ntiles = 0;
+    size_t                     nelem = 0;
+    size_t                     nforce;
+    size_t                     i;
+    size_t                     j;
+    double                     bytes;
+
+    for (i = 0; i < ncells; i++) {
+        ntiles += veg_con_map[i].nv_active + 1;
+    }
+    memory_items[MEMORY_ALL_VARS] = BYTES_TO_MB(
+        ncells * sizeof(all_vars_struct) +
+        ntiles * (4 * sizeof(void *) + options.SNOW_BAND *
+                  (sizeof(cell_data_struct) + sizeof(energy_bal_struct) +
+                   sizeof(snow_data_struct) + sizeof(veg_var_struct))));
+
+    for (j = 0; j < N_OUTVAR_TYPES; j++) {
+        nelem += out_metadata[j].nelem;
+    }
+    memory_items[MEMORY_OUT_DATA] = BYTES_TO_MB(
+        ncells * (sizeof(double **) + N_OUTVAR_TYPES * sizeof(double *) +
+                  nelem * sizeof(double)));
+
+    bytes = 0.;
+    if (output_streams != NULL) {
+        for (i = 0; i < options.Noutstreams; i++) {
+            nelem = 0;
+            for (j = 0; j < output_streams[i].nvars; j++) {
+                nelem += out_metadata[output_streams[i].varid[j]].nelem;
+            }
+            bytes += output_streams[i].ngridcells *
+                     (sizeof(double ***) +
+                      output_streams[i].nvars * sizeof(double **) +
+                      nelem * (sizeof(double *) + sizeof(double)));
+        }
+    }
+    memory_items[MEMORY_AGGDATA] = BYTES_TO_MB(bytes);
+
+    memory_items[MEMORY_VEG_LIB] = BYTES_TO_MB(
+        ncells * (sizeof(veg_lib_struct *) +
+                  options.NVEGTYPES * sizeof(veg_lib_struct)));
+
+    // the forcing slabs of alloc_force() hold NR + 1 steps
+    nforce = 10;
+    if (options.LAKES) {
+        nforce += 1;
+    }
+    if (options.CARBON) {
+        nforce += 4;
+    }
+    memory_items[MEMORY_FORCE] = BYTES_TO_MB(
+        ncells * (sizeof(force_data_struct) +
+                  nforce * (NR + 1) * sizeof(double)));
+
+    memory_items[MEMORY_SOIL_CON] = BYTES_TO_MB(
+        ncells * (sizeof(soil_con_struct) +
+                  options.SNOW_BAND * (4 * sizeof(double) + sizeof(bool))));
+}
+
+/******************************************************************************
+ * @brief    Sample the memory high-water mark of the process.
+ * @details  The growth of the high-water mark since the previous sample is
+ *           added to the sample point, so that the timing table shows which
+ *           part of the run sets the peak memory use. The sizes of the major
+ *           allocations are estimated at the end of the initialization.
+ *****************************************************************************/
+void
+sample_vic_memory(int sample)
+{
+    double peak;
+    double size;
+
+    peak = get_peak_memory();
+    if (peak > memory_last_peak) {
+        memory_peaks[sample] += peak - memory_last_peak;
+        memory_last_peak = peak;
+    }
+    memory_peaks[N_MEMORY_SAMPLES] = memory_last_peak;
+
+    if (sample == MEMORY_AT_INIT) {
+        estimate_vic_memory();
+    }
+    // the I/O buffers only grow, and are freed at the end of the run
+    size = BYTES_TO_MB(get_mpi_io_buffer_size());
+    if (size > memory_items[MEMORY_IO_BUFFERS]) {
+        memory_items[MEMORY_IO_BUFFERS] = size;
+    }
+}
+
+/******************************************************************************
+ * @brief    Add the solver counters of a time step to the process totals.
+ *****************************************************************************/
+void
+add_vic_solver_stats(size_t *counts)
+{
+    size_t i;
+
+    for (i = 0; i < N_SOLVER_STATS; i++) {
+        solver_totals[i] += counts[i];
+    }
+}
+
+/******************************************************************************
+ * @brief    Add bytes read or written to an I/O phase of the process.
+ * @details  May be called by any thread, e.g. by the history writer thread.
+ *****************************************************************************/
+void
+add_vic_io_bytes(int    phase,
+                 size_t nbytes)
+{
+    #pragma omp atomic
+    io_bytes[phase] += nbytes;
+}
+
+/******************************************************************************
+ * @brief    Reduce the wall times of the phase timers and the solver counters
+ *           over MPI_COMM_VIC.
+ * @details  Must be called on all processes, after the last time step and
+ *           before MPI is finalized. The minimum, maximum and mean over the
+ *           processes are reported by write_vic_timing_table() on the master
+ *           node, as are the total and the maximum of the solver counters,
+ *           the memory high-water marks and the sums of the PERF_REGIONS
+ *           counts.
+ *****************************************************************************/
+void
+reduce_vic_phase_timers(timer_struct *timers)
+{
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern option_struct options;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+
+    double               wall[N_TIMERS];
+    double               io[N_IO_PHASES];
+    unsigned long long   counts[N_PERF_REGIONS][N_PERF_COUNTERS];
+    size_t               i;
+    int                  status;
+
+    for (i = 0; i < N_TIMERS; i++) {
+        wall[i] = timers[i].delta_wall;
+    }
+    status = MPI_Reduce(wall, phase_timers.min, N_TIMERS, MPI_DOUBLE,
+                        MPI_MIN, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(wall, phase_timers.max, N_TIMERS, MPI_DOUBLE,
+                        MPI_MAX, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(wall, phase_timers.mean, N_TIMERS, MPI_DOUBLE,
+                        MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    sample_vic_memory(MEMORY_AT_FINAL);
+    status = MPI_Reduce(memory_peaks, memory_ranks.min, N_MEMORY_SAMPLES + 1,
+                        MPI_DOUBLE, MPI_MIN, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(memory_peaks, memory_ranks.max, N_MEMORY_SAMPLES + 1,
+                        MPI_DOUBLE, MPI_MAX, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(memory_peaks, memory_ranks.mean, N_MEMORY_SAMPLES + 1,
+                        MPI_DOUBLE, MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(memory_items, memory_ranks.item_sum, N_MEMORY_ITEMS,
+                        MPI_DOUBLE, MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(memory_items, memory_ranks.item_max, N_MEMORY_ITEMS,
+                        MPI_DOUBLE, MPI_MAX, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(solver_totals, solver_ranks.sum, N_SOLVER_STATS,
+                        MPI_UNSIGNED_LONG, MPI_SUM, VIC_MPI_ROOT,
+                        MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Reduce(solver_totals, solver_ranks.max, N_SOLVER_STATS,
+                        MPI_UNSIGNED_LONG, MPI_MAX, VIC_MPI_ROOT,
+                        MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    for (i = 0; i < N_IO_PHASES; i++) {
+        io[i] = (double) io_bytes[i];
+    }
+    status = MPI_Reduce(io, io_ranks.bytes, N_IO_PHASES, MPI_DOUBLE,
+                        MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    io[IO_PHASE_FORCE] = wall[TIMER_VIC_FORCE_READ] +
+                         wall[TIMER_VIC_FORCE_SCATTER];
+    io[IO_PHASE_HIST] = wall[TIMER_VIC_HIST_GATHER] +
+                        wall[TIMER_VIC_HIST_WRITE];
+    io[IO_PHASE_STATE] = wall[TIMER_VIC_STATE_WRITE];
+    status = MPI_Reduce(io, io_ranks.wall, N_IO_PHASES, MPI_DOUBLE,
+                        MPI_MAX, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (options.PERF_REGIONS) {
+        collect_perf_regions(counts);
+        status = MPI_Reduce(counts, perf_counts,
+                            N_PERF_REGIONS * N_PERF_COUNTERS,
+                            MPI_UNSIGNED_LONG_LONG, MPI_SUM, VIC_MPI_ROOT,
+                            MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        for (i = 0; i < N_TIMERS; i++) {
+            phase_timers.mean[i] /= mpi_size;
+        }
+        for (i = 0; i <= N_MEMORY_SAMPLES; i++) {
+            memory_ranks.mean[i] /= mpi_size;
+            memory_ranks.master[i] = memory_peaks[i];
+        }
+        for (i = 0; i < N_MEMORY_ITEMS; i++) {
+            memory_ranks.item_master[i] = memory_items[i];
+        }
+        phase_timers.nprocs = mpi_size;
+        phase_timers.reduced = true;
+    }
+}
 
 /******************************************************************************
  * @brief    VIC timing file
@@ -34,11 +340,20 @@ write_vic_timing_table(timer_struct *timers,
                        char         *driver)
 {
     extern FILE               *LOG_DEST;
+    extern domain_struct       global_domain;
     extern filenames_struct    filenames;
     extern global_param_struct global_param;
+    extern option_struct       options;
     extern int                 mpi_size;
 
     char                       machine[MAXSTRING];
+    char                      *phase_names[N_TIMERS] = {NULL};
+    char                      *solver_names[N_SOLVER_STATS] = {NULL};
+    char                      *io_names[N_IO_PHASES] = {NULL};
+    double                     mbytes;
+    char                      *memory_names[N_MEMORY_SAMPLES + 1] = {NULL};
+    char                      *item_names[N_MEMORY_ITEMS] = {NULL};
+    size_t                     i;
     char                       user[MAXSTRING];
     time_t                     curr_date_time;
     struct tm                 *timeinfo;
@@ -46,6 +361,8 @@ write_vic_timing_table(timer_struct *timers,
     struct passwd             *pw;
     double                     ndays;
     double                     nyears;
+    char                       bind[MAXSTRING];
+    int                        nplaces;
 
     // datestr
     curr_date_time = time(NULL);
@@ -109,6 +426,34 @@ write_vic_timing_table(timer_struct *timers,
     fprintf(LOG_DEST, "  Total pes active          : %d\n", mpi_size);
     fprintf(LOG_DEST, "  pes per node              : %ld\n",
             sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(LOG_DEST, "  threads per pe            : %zu\n", options.NTHREADS);
+
+    // thread binding (OMP_PROC_BIND and OMP_PLACES)
+    strcpy(bind, "none");
+    nplaces = 0;
+#if defined(_OPENMP) && _OPENMP >= 201511
+    switch (omp_get_proc_bind()) {
+    case omp_proc_bind_true:
+        strcpy(bind, "true");
+        break;
+    case omp_proc_bind_master:
+        strcpy(bind, "master");
+        break;
+    case omp_proc_bind_close:
+        strcpy(bind, "close");
+        break;
+    case omp_proc_bind_spread:
+        strcpy(bind, "spread");
+        break;
+    default:
+        strcpy(bind, "false");
+    }
+    nplaces = omp_get_num_places();
+#endif
+    fprintf(LOG_DEST, "  thread binding            : %s (%d places)\n", bind,
+            nplaces);
+    fprintf(LOG_DEST, "  NUMA first touch          : %s\n",
+            options.NUMA_FIRST_TOUCH ? "TRUE" : "FALSE");
 
     fprintf(LOG_DEST, "\n");
 
@@ -119,6 +464,16 @@ write_vic_timing_table(timer_struct *timers,
             nyears);
     fprintf(LOG_DEST, "    Model Throughput : %g simulated_years/day\n",
             nyears / (timers[TIMER_VIC_ALL].delta_wall / SEC_PER_DAY));
+    // time steps of the cells per second of the run phase and per thread
+    fprintf(LOG_DEST, "    Cell Throughput  : %g cell_steps/sec/thread\n",
+            (double) global_domain.ncells_active * global_param.nrecs /
+            (timers[TIMER_VIC_RUN].delta_wall * mpi_size * options.NTHREADS));
+    if (options.COMPUTE_BENCHMARK) {
+        fprintf(LOG_DEST, "    Benchmark Mode   : COMPUTE_BENCHMARK\n");
+    }
+    else if (options.IO_BENCHMARK) {
+        fprintf(LOG_DEST, "    Benchmark Mode   : IO_BENCHMARK\n");
+    }
     fprintf(LOG_DEST, "\n");
     fprintf(LOG_DEST, "  Timing Table:\n");
     fprintf(LOG_DEST,
@@ -148,6 +503,141 @@ write_vic_timing_table(timer_struct *timers,
             "|------------|----------------------|----------------------|----------------------|----------------------|\n");
     fprintf(LOG_DEST, "\n");
 
+    if (phase_timers.reduced) {
+        phase_names[TIMER_VIC_FORCE_READ] = "Forcing Read";
+        phase_names[TIMER_VIC_FORCE_SCATTER] = "Forcing Scatter";
+        phase_names[TIMER_VIC_PHYSICS] = "Physics";
+        phase_names[TIMER_VIC_PUT_DATA] = "Put Data";
+        phase_names[TIMER_VIC_AGG] = "Aggregation";
+        phase_names[TIMER_VIC_HIST_GATHER] = "History Gather";
+        phase_names[TIMER_VIC_HIST_WRITE] = "History Write";
+        phase_names[TIMER_VIC_STATE_WRITE] = "State Write";
+        phase_names[TIMER_VIC_ROUTING] = "Routing";
+
+        fprintf(LOG_DEST, "  Phase Timing Table (wall time over %d pes):\n",
+                phase_timers.nprocs);
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST,
+                "| Phase           | Min (secs)           | Max (secs)           | Mean (secs)          |\n");
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        for (i = TIMER_VIC_FORCE_READ; i < N_TIMERS; i++) {
+            fprintf(LOG_DEST, "| %-15s | %20g | %20g | %20g |\n",
+                    phase_names[i], phase_timers.min[i], phase_timers.max[i],
+                    phase_timers.mean[i]);
+        }
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST, "\n");
+
+        io_names[IO_PHASE_FORCE] = "Forcing Read";
+        io_names[IO_PHASE_HIST] = "History Write";
+        io_names[IO_PHASE_STATE] = "State Write";
+
+        fprintf(LOG_DEST,
+                "  I/O Table (bytes summed over %d pes, time of the slowest "
+                "pe):\n", phase_timers.nprocs);
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST,
+                "| I/O             | Volume (MB)          | Time (secs)          | Rate (MB/s)          |\n");
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        for (i = 0; i < N_IO_PHASES; i++) {
+            mbytes = io_ranks.bytes[i] / (1024. * 1024.);
+            fprintf(LOG_DEST, "| %-15s | %20g | %20g | %20g |\n",
+                    io_names[i], mbytes, io_ranks.wall[i],
+                    (io_ranks.wall[i] > 0.) ? mbytes / io_ranks.wall[i] : 0.);
+        }
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST, "\n");
+
+        solver_names[SOLVER_BRENT_ITER] = "Brent Iterations";
+        solver_names[SOLVER_BRENT_BRACKET_FAIL] = "Brent Bracket Fails";
+        solver_names[SOLVER_NEWT_RAPH_ITER] = "Newton Iterations";
+        solver_names[SOLVER_RUNOFF_STEPS] = "Runoff Sub-steps";
+        solver_names[SOLVER_SNOW_MELT] = "Snow Melt Solves";
+        solver_names[SOLVER_LAKE_MIX_ITER] = "Lake Mix Passes";
+        solver_names[SOLVER_SNOW_STEPS] = "Snow Sub-steps";
+        solver_names[SOLVER_BRENT_RETRY] = "Brent Retries";
+        solver_names[SOLVER_BAND_SOLVES] = "Band Solves";
+
+        fprintf(LOG_DEST, "  Solver Table (counts over %d pes):\n",
+                phase_timers.nprocs);
+        fprintf(LOG_DEST,
+                "|---------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST,
+                "| Solver              | Total                | Max per pe           |\n");
+        fprintf(LOG_DEST,
+                "|---------------------|----------------------|----------------------|\n");
+        for (i = 0; i < N_SOLVER_STATS; i++) {
+            fprintf(LOG_DEST, "| %-19s | %20zu | %20zu |\n",
+                    solver_names[i], solver_ranks.sum[i],
+                    solver_ranks.max[i]);
+        }
+        fprintf(LOG_DEST,
+                "|---------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST, "\n");
+
+        memory_names[MEMORY_AT_INIT] = "Init";
+        memory_names[MEMORY_AT_FORCE] = "+ Forcing";
+        memory_names[MEMORY_AT_RUN] = "+ Run";
+        memory_names[MEMORY_AT_WRITE] = "+ History";
+        memory_names[MEMORY_AT_STATE] = "+ State";
+        memory_names[MEMORY_AT_FINAL] = "+ Final";
+        memory_names[N_MEMORY_SAMPLES] = "Peak";
+
+        fprintf(LOG_DEST,
+                "  Memory Table (high-water mark in MB over %d pes):\n",
+                phase_timers.nprocs);
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST,
+                "| Memory          | Min (MB)             | Max (MB)             | Mean (MB)            | Master (MB)          |\n");
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|----------------------|\n");
+        for (i = 0; i <= N_MEMORY_SAMPLES; i++) {
+            fprintf(LOG_DEST, "| %-15s | %20g | %20g | %20g | %20g |\n",
+                    memory_names[i], memory_ranks.min[i], memory_ranks.max[i],
+                    memory_ranks.mean[i], memory_ranks.master[i]);
+        }
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST, "\n");
+
+        item_names[MEMORY_ALL_VARS] = "all_vars";
+        item_names[MEMORY_OUT_DATA] = "out_data";
+        item_names[MEMORY_AGGDATA] = "aggdata";
+        item_names[MEMORY_VEG_LIB] = "veg_lib";
+        item_names[MEMORY_FORCE] = "force";
+        item_names[MEMORY_SOIL_CON] = "soil_con";
+        item_names[MEMORY_IO_BUFFERS] = "I/O buffers";
+
+        fprintf(LOG_DEST,
+                "  Allocation Table (estimated MB over %d pes):\n",
+                phase_timers.nprocs);
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST,
+                "| Allocation      | Total (MB)           | Max per pe (MB)      | Master (MB)          |\n");
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        for (i = 0; i < N_MEMORY_ITEMS; i++) {
+            fprintf(LOG_DEST, "| %-15s | %20g | %20g | %20g |\n",
+                    item_names[i], memory_ranks.item_sum[i],
+                    memory_ranks.item_max[i], memory_ranks.item_master[i]);
+        }
+        fprintf(LOG_DEST,
+                "|-----------------|----------------------|----------------------|----------------------|\n");
+        fprintf(LOG_DEST, "\n");
+
+        if (options.PERF_REGIONS) {
+            write_perf_regions_table(perf_counts, phase_timers.nprocs);
+        }
+    }
+
     fprintf(LOG_DEST,
             "\n------------------------------"
             " END VIC TIMING PROFILE "
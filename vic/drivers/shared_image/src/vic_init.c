@@ -27,13 +27,11 @@
 #include <vic_driver_shared_image.h>
 
 /******************************************************************************
- * @brief    Initialize model parameters
+ * @brief    Read model parameters and compute the derived parameters
  *****************************************************************************/
-void
-vic_init(void)
+static void
+vic_init_params(void)
 {
-    extern all_vars_struct    *all_vars;
-    extern size_t              current;
     extern domain_struct       global_domain;
     extern domain_struct       local_domain;
     extern option_struct       options;
@@ -58,6 +56,8 @@ vic_init(void)
     size_t                     m;
     size_t                     nveg;
     size_t                     max_numnod;
+    size_t                     nslices;
+    size_t                     offset;
     size_t                     Nnodes;
     int                        vidx;
     size_t                     d2count[2];
@@ -66,7 +66,6 @@ vic_init(void)
     size_t                     d3start[3];
     size_t                     d4count[4];
     size_t                     d4start[4];
-    int                        tmp_lake_idx;
     double                     Zsum, dp;
     double                     tmpdp, tmpadj, Bexp;
 
@@ -74,15 +73,33 @@ vic_init(void)
     Cv_sum = malloc(local_domain.ncells_active * sizeof(*Cv_sum));
     check_alloc_status(Cv_sum, "Memory allocation error.");
 
-    // allocate memory for variables to be read
-    dvar = malloc(local_domain.ncells_active * sizeof(*dvar));
+    // allocate memory for variables to be read. Variables with extra
+    // dimensions are read as a single block of 2D slices, so the buffers
+    // must hold the largest block read below
+    nslices = options.NVEGTYPES * MONTHS_PER_YEAR;
+    if (options.NVEGTYPES * options.ROOT_ZONES > nslices) {
+        nslices = options.NVEGTYPES * options.ROOT_ZONES;
+    }
+    if (options.Nlayer > nslices) {
+        nslices = options.Nlayer;
+    }
+    if (options.SNOW_BAND > nslices) {
+        nslices = options.SNOW_BAND;
+    }
+    if (options.LAKES && options.LAKE_PROFILE &&
+        options.NLAKENODES > nslices) {
+        nslices = options.NLAKENODES;
+    }
+    dvar = malloc(nslices * local_domain.ncells_active * sizeof(*dvar));
     check_alloc_status(dvar, "Memory allocation error.");
-    ivar = malloc(local_domain.ncells_active * sizeof(*ivar));
+    ivar = malloc(nslices * local_domain.ncells_active * sizeof(*ivar));
     check_alloc_status(ivar, "Memory allocation error.");
 
     // The method used to convert the NetCDF fields to VIC structures for
-    // individual grid cells is to read a 2D slice and then loop over the
-    // domain cells to assign the values to the VIC structures
+    // individual grid cells is to read a 2D slice, or a block of 2D slices
+    // for variables with extra dimensions, and then loop over the domain
+    // cells to assign the values to the VIC structures. Reading a whole
+    // block at once takes a single collective read and scatter per variable
 
     d2start[0] = 0;
     d2start[1] = 0;
@@ -105,9 +122,6 @@ vic_init(void)
     d4count[2] = global_domain.n_ny;
     d4count[3] = global_domain.n_nx;
 
-    // start the clock
-    current = 0;
-
     // read_veglib()
 
     // Assign veg class ids
@@ -121,146 +135,168 @@ vic_init(void)
     }
 
     // overstory
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_int(filenames.params, "overstory", options.NVEGTYPES,
+                             d3start, d3count, ivar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_int(filenames.params, "overstory",
-                                 d3start, d3count, ivar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].overstory = ivar[i];
+            veg_lib[i][j].overstory = ivar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // rarc
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "rarc", options.NVEGTYPES,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "rarc",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].rarc = (double) dvar[i];
+            veg_lib[i][j].rarc = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // rmin
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "rmin", options.NVEGTYPES,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "rmin",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].rmin = (double) dvar[i];
+            veg_lib[i][j].rmin = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // wind height
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "wind_h", options.NVEGTYPES,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "wind_h",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].wind_h = (double) dvar[i];
+            veg_lib[i][j].wind_h = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // RGL
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "RGL", options.NVEGTYPES,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "RGL",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].RGL = (double)dvar[i];
+            veg_lib[i][j].RGL = (double)dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // rad_atten
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "rad_atten",
+                                options.NVEGTYPES, d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "rad_atten",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].rad_atten = (double) dvar[i];
+            veg_lib[i][j].rad_atten = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // wind_atten
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "wind_atten",
+                                options.NVEGTYPES, d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "wind_atten",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].wind_atten = (double) dvar[i];
+            veg_lib[i][j].wind_atten = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // trunk_ratio
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "trunk_ratio",
+                                options.NVEGTYPES, d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "trunk_ratio",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_lib[i][j].trunk_ratio = (double) dvar[i];
+            veg_lib[i][j].trunk_ratio = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
+    // monthly vegetation parameters are read as one block of
+    // NVEGTYPES x MONTHS_PER_YEAR slices per variable
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = MONTHS_PER_YEAR;
+    nslices = options.NVEGTYPES * MONTHS_PER_YEAR;
+
     // LAI and Wdmax
     if (options.LAI_SRC == FROM_VEGLIB || options.LAI_SRC == FROM_VEGPARAM) {
+        get_scatter_nc_block_double(filenames.params, "LAI", nslices,
+                                    d4start, d4count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d4start[0] = j;
             for (k = 0; k < MONTHS_PER_YEAR; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.params, "LAI",
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
-                    veg_lib[i][j].LAI[k] = (double) dvar[i];
+                    veg_lib[i][j].LAI[k] = (double) dvar[offset + i];
                     veg_lib[i][j].Wdmax[k] = param.VEG_LAI_WATER_FACTOR *
                                              veg_lib[i][j].LAI[k];
                 }
+                offset += local_domain.ncells_active;
             }
         }
     }
 
     // albedo
     if (options.ALB_SRC == FROM_VEGLIB || options.ALB_SRC == FROM_VEGPARAM) {
+        get_scatter_nc_block_double(filenames.params, "albedo", nslices,
+                                    d4start, d4count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d4start[0] = j;
             for (k = 0; k < MONTHS_PER_YEAR; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.params, "albedo",
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
-                    veg_lib[i][j].albedo[k] = (double) dvar[i];
+                    veg_lib[i][j].albedo[k] = (double) dvar[offset + i];
                 }
+                offset += local_domain.ncells_active;
             }
         }
     }
 
     // veg_rough
+    get_scatter_nc_block_double(filenames.params, "veg_rough", nslices,
+                                d4start, d4count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d4start[0] = j;
         for (k = 0; k < MONTHS_PER_YEAR; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.params, "veg_rough",
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].roughness[k] = (double) dvar[i];
+                veg_lib[i][j].roughness[k] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // displacement
+    get_scatter_nc_block_double(filenames.params, "displacement", nslices,
+                                d4start, d4count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d4start[0] = j;
         for (k = 0; k < MONTHS_PER_YEAR; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.params, "displacement",
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].displacement[k] = (double) dvar[i];
+                veg_lib[i][j].displacement[k] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // default value for fcanopy
-    for (j = 0; j < options.NVEGTYPES; j++) {
-        if (options.FCAN_SRC == FROM_DEFAULT) {
+    if (options.FCAN_SRC == FROM_DEFAULT) {
+        for (j = 0; j < options.NVEGTYPES; j++) {
             for (k = 0; k < MONTHS_PER_YEAR; k++) {
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     if (j < options.NVEGTYPES - 1) {
@@ -273,16 +309,18 @@ vic_init(void)
                 }
             }
         }
-        else if (options.FCAN_SRC == FROM_VEGLIB ||
-                 options.FCAN_SRC == FROM_VEGPARAM) {
-            d4start[0] = j;
+    }
+    else if (options.FCAN_SRC == FROM_VEGLIB ||
+             options.FCAN_SRC == FROM_VEGPARAM) {
+        get_scatter_nc_block_double(filenames.params, "fcanopy", nslices,
+                                    d4start, d4count, dvar);
+        offset = 0;
+        for (j = 0; j < options.NVEGTYPES; j++) {
             for (k = 0; k < MONTHS_PER_YEAR; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.params, "fcanopy",
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
-                    veg_lib[i][j].fcanopy[k] = (double) dvar[i];
+                    veg_lib[i][j].fcanopy[k] = (double) dvar[offset + i];
                 }
+                offset += local_domain.ncells_active;
             }
         }
     }
@@ -290,12 +328,13 @@ vic_init(void)
     // read carbon cycle parameters
     if (options.CARBON) {
         // Ctype
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_int(filenames.params, "Ctype", options.NVEGTYPES,
+                                 d3start, d3count, ivar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_int(filenames.params, "Ctype",
-                                     d3start, d3count, ivar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].Ctype = ivar[i];
+                veg_lib[i][j].Ctype = ivar[offset + i];
                 if (veg_lib[i][j].Ctype != PHOTO_C3 &&
                     veg_lib[i][j].Ctype != PHOTO_C4) {
                     log_err("cell %zu veg %zu: Ctype is %d but "
@@ -304,48 +343,54 @@ vic_init(void)
                             PHOTO_C3, PHOTO_C4);
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // MaxCarboxRate
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "MaxCarboxRate",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "MaxCarboxRate",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].MaxCarboxRate = (double) dvar[i];
+                veg_lib[i][j].MaxCarboxRate = (double) dvar[offset + i];
                 if (veg_lib[i][j].MaxCarboxRate < 0) {
                     log_err("cell %zu veg %zu: MaxCarboxRate is %f "
                             "but must be >= 0.",
                             i, j, veg_lib[i][j].MaxCarboxRate);
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // MaxETransport or CO2Specificity
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "MaxiE_or_CO2Spec",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "MaxiE_or_CO2Spec",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                if (dvar[i] < 0) {
+                if (dvar[offset + i] < 0) {
                     log_err("cell %zu veg %zu: MaxE_of_CO2Spec is %f "
-                            "but must be >= 0.", i, j, dvar[i]);
+                            "but must be >= 0.", i, j, dvar[offset + i]);
                 }
                 if (veg_lib[i][j].Ctype == PHOTO_C3) {
-                    veg_lib[i][j].MaxCarboxRate = (double) dvar[i];
+                    veg_lib[i][j].MaxCarboxRate = (double) dvar[offset + i];
                     veg_lib[i][j].CO2Specificity = 0;
                 }
                 else if (veg_lib[i][j].Ctype == PHOTO_C4) {
                     veg_lib[i][j].MaxCarboxRate = 0;
-                    veg_lib[i][j].CO2Specificity = (double) dvar[i];
+                    veg_lib[i][j].CO2Specificity = (double) dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // LightUseEff
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "LUE", options.NVEGTYPES,
+                                    d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "LUE",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].LightUseEff = (double) dvar[i];
+                veg_lib[i][j].LightUseEff = (double) dvar[offset + i];
                 if (veg_lib[i][j].LightUseEff < 0 ||
                     veg_lib[i][j].LightUseEff > 1) {
                     log_err("cell %zu veg %zu: LightUseEff is %f "
@@ -353,14 +398,16 @@ vic_init(void)
                             i, j, veg_lib[i][j].LightUseEff);
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // Nscale flag
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_int(filenames.params, "Nscale", options.NVEGTYPES,
+                                 d3start, d3count, ivar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_int(filenames.params, "Nscale",
-                                     d3start, d3count, ivar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].NscaleFlag = ivar[i];
+                veg_lib[i][j].NscaleFlag = ivar[offset + i];
                 if (veg_lib[i][j].NscaleFlag != 0 &&
                     veg_lib[i][j].NscaleFlag != 1) {
                     log_err("cell %zu veg %zu: NscaleFlag is %d but "
@@ -368,14 +415,16 @@ vic_init(void)
                             i, j, veg_lib[i][j].NscaleFlag);
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // Wnpp_inhib
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "Wnpp_inhib",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "Wnpp_inhib",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].Wnpp_inhib = (double) dvar[i];
+                veg_lib[i][j].Wnpp_inhib = (double) dvar[offset + i];
                 if (veg_lib[i][j].Wnpp_inhib < 0 ||
                     veg_lib[i][j].Wnpp_inhib > 1) {
                     log_err("cell %zu veg %zu: Wnpp_inhib is %f "
@@ -383,14 +432,16 @@ vic_init(void)
                             i, j, veg_lib[i][j].Wnpp_inhib);
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // NPPfactor_sat
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "NPPfactor_sat",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "NPPfactor_sat",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                veg_lib[i][j].NPPfactor_sat = (double) dvar[i];
+                veg_lib[i][j].NPPfactor_sat = (double) dvar[offset + i];
                 if (veg_lib[i][j].NPPfactor_sat < 0 ||
                     veg_lib[i][j].NPPfactor_sat > 1) {
                     log_err("cell %zu veg %zu: NPPfactor_sat is %f "
@@ -398,6 +449,7 @@ vic_init(void)
                             i, j, veg_lib[i][j].NPPfactor_sat);
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
@@ -418,8 +470,8 @@ vic_init(void)
     }
     if (options.Nlayer > MAX_LAYERS) {
         log_err("Global file wants more soil moisture layers (%zu) than "
-                "are defined by MAX_LAYERS (%d).  Edit vic_driver_shared.h and "
-                "recompile.", options.Nlayer, MAX_LAYERS);
+                "are defined by MAX_LAYERS (%d).  Recompile with a larger "
+                "MAX_LAYERS (make MAX_LAYERS=n).", options.Nlayer, MAX_LAYERS);
     }
 
     // latitude and longitude
@@ -464,43 +516,51 @@ vic_init(void)
     }
 
     // expt: unsaturated hydraulic conductivity exponent for each layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "expt", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "expt",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].expt[j] = (double) dvar[i];
+            soil_con[i].expt[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // Ksat: saturated hydraulic conductivity for each layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "Ksat", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "Ksat",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].Ksat[j] = (double) dvar[i];
+            soil_con[i].Ksat[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // init_moist: initial soil moisture for cold start
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "init_moist", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "init_moist",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].init_moist[j] = (double) dvar[i];
+            soil_con[i].init_moist[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // phi_s
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "phi_s", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "phi_s",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].phi_s[j] = (double) dvar[i];
+            soil_con[i].phi_s[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // elevation: mean grid cell elevation
@@ -511,13 +571,15 @@ vic_init(void)
     }
 
     // depth: thickness for each soil layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "depth", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "depth",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].depth[j] = (double) dvar[i];
+            soil_con[i].depth[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // avg_temp: mean grid temperature
@@ -535,99 +597,117 @@ vic_init(void)
     }
 
     // bubble: bubbling pressure for each soil layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "bubble", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "bubble",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].bubble[j] = (double) dvar[i];
+            soil_con[i].bubble[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // quartz: quartz content for each soil layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "quartz", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "quartz",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].quartz[j] = (double) dvar[i];
+            soil_con[i].quartz[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // bulk_dens_min: mineral bulk density for each soil layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "bulk_density",
+                                options.Nlayer, d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "bulk_density",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].bulk_dens_min[j] = (double) dvar[i];
+            soil_con[i].bulk_dens_min[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // soil_dens_min: mineral soil density for each soil layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "soil_density",
+                                options.Nlayer, d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "soil_density",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].soil_dens_min[j] = (double) dvar[i];
+            soil_con[i].soil_dens_min[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
 
     // organic soils
     if (options.ORGANIC_FRACT) {
         // organic
+        d3count[0] = options.Nlayer;
+        get_scatter_nc_block_double(filenames.params, "organic", options.Nlayer,
+                                    d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "organic",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                soil_con[i].organic[j] = (double) dvar[i];
+                soil_con[i].organic[j] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
 
         // bulk_dens_org: organic bulk density for each soil layer
+        d3count[0] = options.Nlayer;
+        get_scatter_nc_block_double(filenames.params, "bulk_density_org",
+                                    options.Nlayer, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "bulk_density_org",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                soil_con[i].bulk_dens_org[j] = (double) dvar[i];
+                soil_con[i].bulk_dens_org[j] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
 
         // soil_dens_org: organic soil density for each soil layer
+        d3count[0] = options.Nlayer;
+        get_scatter_nc_block_double(filenames.params, "soil_density_org",
+                                    options.Nlayer, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "soil_density_org",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                soil_con[i].soil_dens_org[j] = (double) dvar[i];
+                soil_con[i].soil_dens_org[j] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // Wcr: critical point for each layer
     // Note this value is  multiplied with the maximum moisture in each layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "Wcr_FRACT", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "Wcr_FRACT",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].Wcr[j] = (double) dvar[i];
+            soil_con[i].Wcr[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // Wpwp: wilting point for each layer
     // Note this value is  multiplied with the maximum moisture in each layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "Wpwp_FRACT", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "Wpwp_FRACT",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].Wpwp[j] = (double) dvar[i];
+            soil_con[i].Wpwp[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // rough: soil roughness
@@ -652,13 +732,15 @@ vic_init(void)
     }
 
     // resid_moist: residual moisture content for each layer
+    d3count[0] = options.Nlayer;
+    get_scatter_nc_block_double(filenames.params, "resid_moist", options.Nlayer,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.Nlayer; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "resid_moist",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            soil_con[i].resid_moist[j] = (double) dvar[i];
+            soil_con[i].resid_moist[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // fs_active: frozen soil active flag
@@ -946,31 +1028,37 @@ vic_init(void)
     }
     else {
         // AreaFract: fraction of grid cell in each snow band
+        d3count[0] = options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.params, "AreaFract",
+                                    options.SNOW_BAND, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.SNOW_BAND; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "AreaFract",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                soil_con[i].AreaFract[j] = (double) dvar[i];
+                soil_con[i].AreaFract[j] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
         // elevation: elevation of each snow band
+        d3count[0] = options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.params, "elevation",
+                                    options.SNOW_BAND, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.SNOW_BAND; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "elevation",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                soil_con[i].BandElev[j] = (double) dvar[i];
+                soil_con[i].BandElev[j] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
         // Pfactor: precipitation multiplier for each snow band
+        d3count[0] = options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.params, "Pfactor",
+                                    options.SNOW_BAND, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.SNOW_BAND; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "Pfactor",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
-                soil_con[i].Pfactor[j] = (double) dvar[i];
+                soil_con[i].Pfactor[j] = (double) dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
         // Run some checks and corrections for soil
         for (i = 0; i < local_domain.ncells_active; i++) {
@@ -1083,13 +1171,15 @@ vic_init(void)
     // structure. Then assign only the ones with a fraction greater than 0 to
     // the veg_con structure
 
+    d3count[0] = options.NVEGTYPES;
+    get_scatter_nc_block_double(filenames.params, "Cv", options.NVEGTYPES,
+                                d3start, d3count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d3start[0] = j;
-        get_scatter_nc_field_double(filenames.params, "Cv",
-                                    d3start, d3count, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
-            veg_con_map[i].Cv[j] = (double) dvar[i];
+            veg_con_map[i].Cv[j] = (double) dvar[offset + i];
         }
+        offset += local_domain.ncells_active;
     }
 
     // do the mapping
@@ -1128,37 +1218,41 @@ vic_init(void)
                 veg_con_map[i].vidx[j] = NODATA_VEG;
             }
         }
+        veg_con_map[i].nv_classes = k;
     }
 
     // zone_depth: root zone depths
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.ROOT_ZONES;
+    nslices = options.NVEGTYPES * options.ROOT_ZONES;
+    get_scatter_nc_block_double(filenames.params, "root_depth", nslices,
+                                d4start, d4count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d4start[0] = j;
         for (k = 0; k < options.ROOT_ZONES; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.params, "root_depth",
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 vidx = veg_con_map[i].vidx[j];
                 if (vidx != NODATA_VEG) {
-                    veg_con[i][vidx].zone_depth[k] = (double) dvar[i];
+                    veg_con[i][vidx].zone_depth[k] = (double) dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // zone_fract: root fractions
+    get_scatter_nc_block_double(filenames.params, "root_fract", nslices,
+                                d4start, d4count, dvar);
+    offset = 0;
     for (j = 0; j < options.NVEGTYPES; j++) {
-        d4start[0] = j;
         for (k = 0; k < options.ROOT_ZONES; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.params, "root_fract",
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 vidx = veg_con_map[i].vidx[j];
                 if (vidx != NODATA_VEG) {
-                    veg_con[i][vidx].zone_fract[k] = (double) dvar[i];
+                    veg_con[i][vidx].zone_fract[k] = (double) dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
@@ -1235,17 +1329,22 @@ vic_init(void)
         }
     }
 
+    // the monthly vegetation parameters are in veg_con now, the grid cells
+    // share the rest of the vegetation library
+    share_veg_lib();
+
     // read blowing snow parameters
     if (options.BLOWING) {
         // sigma_slope
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "sigma_slope",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "sigma_slope",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 vidx = veg_con_map[i].vidx[j];
                 if (vidx != NODATA_VEG) {
-                    veg_con[i][vidx].sigma_slope = (double) dvar[i];
+                    veg_con[i][vidx].sigma_slope = (double) dvar[offset + i];
                     if (veg_con[i][vidx].sigma_slope <= 0) {
                         log_err("cell %zu veg %d: deviation of terrain slope "
                                 "(sigma_slope) is %f but must be > 0.",
@@ -1253,16 +1352,18 @@ vic_init(void)
                     }
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // lag_one
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "lag_one",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "lag_one",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 vidx = veg_con_map[i].vidx[j];
                 if (vidx != NODATA_VEG) {
-                    veg_con[i][vidx].lag_one = (double) dvar[i];
+                    veg_con[i][vidx].lag_one = (double) dvar[offset + i];
                     if (veg_con[i][vidx].lag_one <= 0) {
                         log_err("cell %zu veg %d: lag_one is %f but "
                                 "must be > 0.",
@@ -1270,16 +1371,18 @@ vic_init(void)
                     }
                 }
             }
+            offset += local_domain.ncells_active;
         }
         // fetch
+        d3count[0] = options.NVEGTYPES;
+        get_scatter_nc_block_double(filenames.params, "fetch",
+                                    options.NVEGTYPES, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NVEGTYPES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.params, "fetch",
-                                        d3start, d3count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 vidx = veg_con_map[i].vidx[j];
                 if (vidx != NODATA_VEG) {
-                    veg_con[i][vidx].fetch = (double) dvar[i];
+                    veg_con[i][vidx].fetch = (double) dvar[offset + i];
                     if (veg_con[i][vidx].fetch <= 1) {
                         log_err("cell %zu veg %d: fetch is %f but "
                                 "must be > 1.",
@@ -1287,6 +1390,7 @@ vic_init(void)
                     }
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
@@ -1428,22 +1532,33 @@ vic_init(void)
             }
         }
         if (options.LAKE_PROFILE) {
-            for (j = 0; j < max_numnod; j++) {
-                d3start[0] = j;
+            // read the full lake_node dimension so that every process takes
+            // part in the same collective read, regardless of its local
+            // max_numnod
+            d3count[0] = options.NLAKENODES;
 
-                // basin_depth
-                get_scatter_nc_field_double(filenames.params, "basin_depth",
-                                            d3start, d3count, dvar);
+            // basin_depth
+            get_scatter_nc_block_double(filenames.params, "basin_depth",
+                                        options.NLAKENODES, d3start, d3count,
+                                        dvar);
+            offset = 0;
+            for (j = 0; j < max_numnod; j++) {
                 for (i = 0; i < local_domain.ncells_active; i++) {
-                    lake_con[i].z[j] = (double) dvar[i];
+                    lake_con[i].z[j] = (double) dvar[offset + i];
                 }
+                offset += local_domain.ncells_active;
+            }
 
-                // basin_area
-                get_scatter_nc_field_double(filenames.params, "basin_area",
-                                            d3start, d3count, dvar);
+            // basin_area
+            get_scatter_nc_block_double(filenames.params, "basin_area",
+                                        options.NLAKENODES, d3start, d3count,
+                                        dvar);
+            offset = 0;
+            for (j = 0; j < max_numnod; j++) {
                 for (i = 0; i < local_domain.ncells_active; i++) {
-                    lake_con[i].Cl[j] = (double) dvar[i];
+                    lake_con[i].Cl[j] = (double) dvar[offset + i];
                 }
+                offset += local_domain.ncells_active;
             }
         }
         else {
@@ -1534,29 +1649,71 @@ vic_init(void)
         }
     }
 
+    // cleanup
+    free(dvar);
+    free(ivar);
+    free(Cv_sum);
+}
+
+/******************************************************************************
+ * @brief    Initialize model parameters
+ * @details  With PARAM_CACHE, the parameters are restored from the cache
+ *           files of an earlier run with the same inputs and decomposition.
+ *           Otherwise they are read from the parameter file and written to
+ *           the cache files.
+ *****************************************************************************/
+void
+vic_init(void)
+{
+    extern all_vars_struct *all_vars;
+    extern size_t           current;
+    extern domain_struct    local_domain;
+    extern filenames_struct filenames;
+    extern option_struct    options;
+    extern soil_con_struct *soil_con;
+    extern veg_con_struct **veg_con;
+    extern lake_con_struct *lake_con;
+    extern size_t          *lake_cells;
+    extern size_t           nlake_cells;
+
+    size_t                  i;
+    size_t                  n;
+    size_t                  nveg;
+
+    // start the clock
+    current = 0;
+
+    if (!read_param_cache()) {
+        vic_init_params();
+        // with PARALLEL_IO, all nodes have the parameter file open
+        if (options.PARALLEL_IO) {
+            close_nc_file(filenames.params);
+        }
+        write_param_cache();
+    }
+
+    // one copy of the vegetation libraries per compute node
+    if (options.NODE_SHARED_TABLES) {
+        share_node_veg_lib();
+    }
+
+    // the lake variables are only made for the cells with a lake
+    set_lake_cells();
+
     // initialize state variables with default values
     for (i = 0; i < local_domain.ncells_active; i++) {
         nveg = veg_con[i][0].vegetat_type_num;
         initialize_snow(all_vars[i].snow, nveg);
         initialize_soil(all_vars[i].cell, nveg);
         initialize_veg(all_vars[i].veg_var, nveg);
-        if (options.LAKES) {
-            tmp_lake_idx = (int)lake_con[i].lake_idx;
-            if (tmp_lake_idx < 0) {
-                tmp_lake_idx = 0;
-            }
-            initialize_lake(&(all_vars[i].lake_var), lake_con[i],
-                            &(soil_con[i]),
-                            &(all_vars[i].cell[tmp_lake_idx][0]), false);
-        }
         initialize_energy(all_vars[i].energy, nveg);
     }
+    for (n = 0; n < nlake_cells; n++) {
+        i = lake_cells[n];
+        initialize_lake(all_vars[i].lake_var, &(lake_con[i]), &(soil_con[i]),
+                        &(all_vars[i].cell[lake_con[i].lake_idx][0]), false);
+    }
 
     // set state metadata structure
     set_state_meta_data_info();
-
-    // cleanup
-    free(dvar);
-    free(ivar);
-    free(Cv_sum);
 }
@@ -40,7 +40,6 @@ vic_init_output(dmy_struct *dmy_current)
     extern MPI_Comm           MPI_COMM_VIC;
     extern int                mpi_rank;
     extern nc_file_struct    *nc_hist_files;
-    extern lake_con_struct    lake_con;
     extern double          ***out_data;
     extern save_data_struct  *save_data;
     extern soil_con_struct   *soil_con;
@@ -49,6 +48,7 @@ vic_init_output(dmy_struct *dmy_current)
     extern option_struct      options;
     extern MPI_Datatype       mpi_alarm_struct_type;
     extern stream_struct     *output_streams;
+    extern timer_struct       global_timers[N_TIMERS];
 
     int                       status;
     size_t                    i;
@@ -66,8 +66,11 @@ vic_init_output(dmy_struct *dmy_current)
     // initialize the save data structures
     for (i = 0; i < local_domain.ncells_active; i++) {
         initialize_save_data(&(all_vars[i]), &(force[i]), &(soil_con[i]),
-                             veg_con[i], veg_lib[i], &lake_con, out_data[i],
-                             &(save_data[i]), &timer);
+                             veg_con[i], veg_lib[i], get_lake_con(i),
+                             out_data[i], &(save_data[i]), &timer);
+        save_data[i].balance_cell =
+            (local_domain.locations[i].global_idx %
+             options.BALANCE_CHECK_N == 0);
     }
 
     if (mpi_rank == VIC_MPI_ROOT) {
@@ -98,6 +101,15 @@ vic_init_output(dmy_struct *dmy_current)
     // allocate netcdf history files array
     nc_hist_files = calloc(options.Noutstreams, sizeof(*nc_hist_files));
     check_alloc_status(nc_hist_files, "Memory allocation error.");
+    for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
+        nc_hist_files[streamnum].io_request.mpi_timer =
+            &(global_timers[TIMER_VIC_HIST_GATHER]);
+        nc_hist_files[streamnum].io_request.io_timer =
+            &(global_timers[TIMER_VIC_HIST_WRITE]);
+    }
+
+    // the groups of processes of split history files
+    initialize_split_io();
 
     // allocate memory for streams, initialize to default/missing values
     for (streamnum = 0; streamnum < options.Noutstreams; streamnum++) {
@@ -140,6 +152,36 @@ vic_init_output(dmy_struct *dmy_current)
                            1, MPI_SHORT, VIC_MPI_ROOT, MPI_COMM_VIC);
         check_mpi_status(status, "MPI error.");
 
+        // flush
+        status = MPI_Bcast(&(output_streams[streamnum].flush),
+                           1, MPI_UNSIGNED_SHORT, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // flush_n
+        status = MPI_Bcast(&(output_streams[streamnum].flush_n),
+                           1, MPI_INT, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // shuffle
+        status = MPI_Bcast(&(output_streams[streamnum].shuffle),
+                           1, MPI_C_BOOL, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // chunk
+        status = MPI_Bcast(&(output_streams[streamnum].chunk),
+                           1, MPI_UNSIGNED_SHORT, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // chunk_n
+        status = MPI_Bcast(output_streams[streamnum].chunk_n,
+                           3, MPI_INT, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // chunk_cache
+        status = MPI_Bcast(&(output_streams[streamnum].chunk_cache),
+                           1, MPI_INT, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
         // type
         status = MPI_Bcast(output_streams[streamnum].type,
                            output_streams[streamnum].nvars,
@@ -167,6 +209,18 @@ vic_init_output(dmy_struct *dmy_current)
                            VIC_MPI_ROOT, MPI_COMM_VIC);
         check_mpi_status(status, "MPI error.");
 
+        // aggparam
+        status = MPI_Bcast(output_streams[streamnum].aggparam,
+                           output_streams[streamnum].nvars, MPI_DOUBLE,
+                           VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // digits
+        status = MPI_Bcast(output_streams[streamnum].digits,
+                           output_streams[streamnum].nvars, MPI_INT,
+                           VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
         // skip agg data
 
         // Now brodcast the alarms
@@ -177,32 +231,195 @@ vic_init_output(dmy_struct *dmy_current)
                            mpi_alarm_struct_type, VIC_MPI_ROOT, MPI_COMM_VIC);
         check_mpi_status(status, "MPI error.");
 
-        // allocate agg data
-        alloc_aggdata(&(output_streams[streamnum]));
+        // mask
+        status = MPI_Bcast(output_streams[streamnum].mask,
+                           MAXSTRING, MPI_CHAR, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // region
+        status = MPI_Bcast(output_streams[streamnum].region,
+                           MAXSTRING, MPI_CHAR, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+
+        // region_reduce
+        status = MPI_Bcast(&(output_streams[streamnum].region_reduce),
+                           1, MPI_UNSIGNED_SHORT, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
 
         // setup netcdf files
         initialize_nc_file(&(nc_hist_files[streamnum]),
                            output_streams[streamnum].nvars,
                            output_streams[streamnum].varid,
                            output_streams[streamnum].type);
+
+        // select the cells of a stream with OUTMASK or OUTREGION
+        set_stream_mask(&(output_streams[streamnum]),
+                        &(nc_hist_files[streamnum]));
+        set_stream_regions(&(output_streams[streamnum]),
+                           &(nc_hist_files[streamnum]));
+
+        // write the other streams to the files of the groups of processes
+        set_stream_split(&(output_streams[streamnum]),
+                         &(nc_hist_files[streamnum]));
+
+        // publish the records of a stream through ADIOS2
+        initialize_adios2_stream(&(output_streams[streamnum]),
+                                 &(nc_hist_files[streamnum]));
+
+        // allocate agg data
+        alloc_aggdata(&(output_streams[streamnum]));
     }
     // validate streams
     validate_streams(&output_streams);
+
+    // continue the records of the run that saved the initial state
+    vic_restore_streams();
+
+    // start the history writer thread
+    initialize_async_output();
+
+    // start the checkpoint thread
+    initialize_async_state();
 }
 
 /******************************************************************************
- * @brief    Initialize history file
+ * @brief    Set the chunk cache of a history variable. The cache is a
+ *           property of the open file, not of the variable in the file.
  *****************************************************************************/
-void
-initialize_history_file(nc_file_struct *nc,
-                        stream_struct  *stream,
-                        dmy_struct     *ref_dmy)
+static void
+set_nc_var_chunk_cache(stream_struct  *stream,
+                       nc_file_struct *nc,
+                       nc_var_struct  *nc_var)
+{
+    size_t cache_size;
+    size_t cache_nelems;
+    float  cache_preemption;
+    int    status;
+
+    if (stream->chunk_cache <= 0 ||
+        (stream->file_format != NETCDF4_CLASSIC &&
+         stream->file_format != NETCDF4)) {
+        return;
+    }
+
+    status = nc_get_var_chunk_cache(nc->nc_id, nc_var->nc_varid,
+                                    &cache_size, &cache_nelems,
+                                    &cache_preemption);
+    check_nc_status(status, "Error getting chunk cache in %s",
+                    stream->filename);
+    cache_size = (size_t) stream->chunk_cache * 1024 * 1024;
+    status = nc_set_var_chunk_cache(nc->nc_id, nc_var->nc_varid,
+                                    cache_size, cache_nelems,
+                                    cache_preemption);
+    check_nc_status(status, "Error setting chunk cache in %s",
+                    stream->filename);
+}
+
+/******************************************************************************
+ * @brief    Set the chunk shape and chunk cache of a history variable. The
+ *           netCDF library defaults are kept unless the stream asks for a
+ *           shape or a cache size; netCDF3 files have no chunks.
+ *****************************************************************************/
+static void
+set_nc_var_chunking(stream_struct  *stream,
+                    nc_file_struct *nc,
+                    nc_var_struct  *nc_var)
+{
+    size_t chunksizes[MAXDIMS];
+    size_t tile;
+    size_t i;
+    int    status;
+
+    if (stream->file_format != NETCDF4_CLASSIC &&
+        stream->file_format != NETCDF4) {
+        return;
+    }
+
+    if (stream->chunk != CHUNK_DEFAULT) {
+        for (i = 0; i < nc_var->nc_dims; i++) {
+            // the time dimension is unlimited, its count is not the extent
+            if (nc_var->nc_dimids[i] == nc->time_dimid) {
+                chunksizes[i] = 1;
+                if (stream->chunk == CHUNK_SERIES) {
+                    chunksizes[i] = (size_t) stream->chunk_n[0];
+                }
+                continue;
+            }
+            chunksizes[i] = nc_var->nc_counts[i];
+            if (stream->chunk != CHUNK_SERIES) {
+                continue;
+            }
+            tile = 0;
+            if (nc_var->nc_dimids[i] == nc->nj_dimid) {
+                tile = (size_t) stream->chunk_n[1];
+            }
+            else if (nc_var->nc_dimids[i] == nc->ni_dimid) {
+                tile = (size_t) stream->chunk_n[2];
+            }
+            else if (nc->land_size > 0 &&
+                     nc_var->nc_dimids[i] == nc->land_dimid) {
+                tile = (size_t) stream->chunk_n[1] * stream->chunk_n[2];
+            }
+            if (tile > 0 && tile < chunksizes[i]) {
+                chunksizes[i] = tile;
+            }
+        }
+        status = nc_def_var_chunking(nc->nc_id, nc_var->nc_varid, NC_CHUNKED,
+                                     chunksizes);
+        check_nc_status(status, "Error setting chunk shape in %s",
+                        stream->filename);
+    }
+
+    set_nc_var_chunk_cache(stream, nc, nc_var);
+}
+
+#ifdef NC_QUANTIZE_BITROUND
+/******************************************************************************
+ * @brief    Set the quantization of a history variable with significant
+ *           digits. netCDF-C (4.9 or later) applies BitRound to the values
+ *           written to a float or double variable of a netCDF4 file, which
+ *           then compresses much better; netCDF3 files are not quantized.
+ *****************************************************************************/
+static void
+set_nc_var_quantize(stream_struct  *stream,
+                    nc_file_struct *nc,
+                    size_t          varidx)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    nc_var_struct         *nc_var;
+    int                    keepbits;
+    int                    status;
+
+    nc_var = &(nc->nc_vars[varidx]);
+    keepbits = get_history_keepbits(stream->digits[varidx], nc_var->nc_type);
+    if (keepbits == 0 ||
+        (stream->file_format != NETCDF4_CLASSIC &&
+         stream->file_format != NETCDF4)) {
+        return;
+    }
+
+    status = nc_def_var_quantize(nc->nc_id, nc_var->nc_varid,
+                                 NC_QUANTIZE_BITROUND, keepbits);
+    check_nc_status(status, "Error setting the quantization in %s for "
+                    "variable: %s", stream->filename,
+                    out_metadata[stream->varid[varidx]].varname);
+}
+#endif
+
+/******************************************************************************
+ * @brief    Create and define the history file stream->filename.
+ *****************************************************************************/
+static void
+define_history_file(nc_file_struct *nc,
+                    stream_struct  *stream)
 {
-    extern filenames_struct    filenames;
     extern domain_struct       global_domain;
     extern option_struct       options;
     extern global_param_struct global_param;
     extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
+    extern size_t             *filter_active_cells;
+    extern int                 mpi_rank;
 
     int                        status;
     int                        old_fill_mode;
@@ -220,51 +437,32 @@ initialize_history_file(nc_file_struct *nc,
     int                        dimids[MAXDIMS];
     int                        lon_var_id;
     int                        lat_var_id;
+    int                        land_var_id;
+    int                        area_var_id;
+    int                       *ivar;
     unsigned int               varid;
     double                    *dvar;
 
-
-    // This could be further refined but for now, I've chosen a file naming
-    // Convention that goes like this:
-    switch (stream->agg_alarm.freq) {
-    // If FREQ_NDAYS -- filename = result_dir/prefix.YYYY-MM-DD.nc
-    case FREQ_NDAYS:
-        sprintf(stream->filename, "%s/%s.%04d-%02d-%02d.nc",
-                filenames.result_dir,
-                stream->prefix, stream->time_bounds[0].year,
-                stream->time_bounds[0].month,
-                stream->time_bounds[0].day);
-        break;
-    case FREQ_NMONTHS:
-        // If FREQ_NMONTHS -- filename = result_dir/prefix.YYYY-MM.nc
-        sprintf(stream->filename, "%s/%s.%04d-%02d.nc", filenames.result_dir,
-                stream->prefix, stream->time_bounds[0].year,
-                stream->time_bounds[0].month);
-        break;
-    case FREQ_NYEARS:
-        // If FREQ_NYEARS -- filename = result_dir/prefix.YYYY.nc
-        sprintf(stream->filename, "%s/%s.%04d.nc", filenames.result_dir,
-                stream->prefix, stream->time_bounds[0].year);
-        break;
-    default:
-        // For all other cases -- filename = result_dir/prefix.YYYY-MM-DD-SSSSS.nc
-        sprintf(stream->filename, "%s/%s.%04d-%02d-%02d-%05u.nc",
-                filenames.result_dir,
-                stream->prefix, stream->time_bounds[0].year,
-                stream->time_bounds[0].month,
-                stream->time_bounds[0].day,
-                stream->time_bounds[0].dayseconds);
-    }
-
     // open the netcdf file
-    status = nc_create(stream->filename,
-                       get_nc_mode(stream->file_format),
-                       &(nc->nc_id));
-    check_nc_status(status, "Error creating %s", stream->filename);
+    if (nc->parallel) {
+        create_par_nc_file(stream->filename,
+                           get_nc_mode(stream->file_format), &(nc->nc_id));
+    }
+    else {
+        status = nc_create(stream->filename,
+                           get_nc_mode(stream->file_format),
+                           &(nc->nc_id));
+        check_nc_status(status, "Error creating %s", stream->filename);
+    }
     nc->open = true;
+    nc->flush_count = 0;
+    nc->flush_time = MPI_Wtime();
 
     // Set netcdf file global attributes
     set_global_nc_attributes(nc->nc_id, NC_HISTORY_FILE);
+    if (nc->split) {
+        set_split_nc_attributes(nc->nc_id);
+    }
 
     // set the NC_FILL attribute
     status = nc_set_fill(nc->nc_id, NC_FILL, &old_fill_mode);
@@ -302,6 +500,47 @@ initialize_history_file(nc_file_struct *nc,
     check_nc_status(status, "Error defining y dimension in %s",
                     stream->filename);
 
+    // the regions of a region stream
+    if (stream->region[0] != '\0') {
+        status = nc_def_dim(nc->nc_id, "region", nc->land_size,
+                            &(nc->land_dimid));
+        check_nc_status(status, "Error defining region dimension in %s",
+                        stream->filename);
+        status = nc_def_var(nc->nc_id, "region", NC_INT, 1,
+                            &(nc->land_dimid), &land_var_id);
+        check_nc_status(status, "Error defining region variable in %s",
+                        stream->filename);
+        put_nc_attr(nc->nc_id, land_var_id, "long_name", "region ID");
+        snprintf(str, MAXSTRING, "values of %s in the domain file",
+                 stream->region);
+        put_nc_attr(nc->nc_id, land_var_id, "description", str);
+        status = nc_def_var(nc->nc_id, "region_area", NC_DOUBLE, 1,
+                            &(nc->land_dimid), &area_var_id);
+        check_nc_status(status, "Error defining region_area variable in %s",
+                        stream->filename);
+        put_nc_attr(nc->nc_id, area_var_id, "long_name", "area of the region");
+        put_nc_attr(nc->nc_id, area_var_id, "units", "m2");
+    }
+    // active cells only, compressed by gathering (CF conventions)
+    else if (nc->land_size > 0) {
+        status = nc_def_dim(nc->nc_id, "land", nc->land_size,
+                            &(nc->land_dimid));
+        check_nc_status(status, "Error defining land dimension in %s",
+                        stream->filename);
+        status = nc_def_var(nc->nc_id, "land", NC_INT, 1, &(nc->land_dimid),
+                            &land_var_id);
+        check_nc_status(status, "Error defining land variable in %s",
+                        stream->filename);
+        sprintf(str, "%s %s", global_domain.info.y_dim,
+                global_domain.info.x_dim);
+        status = nc_put_att_text(nc->nc_id, land_var_id, "compress",
+                                 strlen(str), str);
+        check_nc_status(status, "Error adding attribute in %s",
+                        stream->filename);
+        put_nc_attr(nc->nc_id, land_var_id, "long_name",
+                    "index of the active grid cells in the grid");
+    }
+
     status = nc_def_dim(nc->nc_id, "node", nc->node_size, &(nc->node_dimid));
     check_nc_status(status, "Error defining node dimension in %s",
                     stream->filename);
@@ -372,69 +611,74 @@ initialize_history_file(nc_file_struct *nc,
                              strlen(calendar_str), calendar_str);
     check_nc_status(status, "Error adding attribute in %s", stream->filename);
 
-    ndims = global_domain.info.n_coord_dims;
-    dstart[0] = 0;
-    dstart[1] = 0;
+    // the coordinates of the grid (a region stream has no grid)
+    if (stream->region[0] == '\0') {
+        ndims = global_domain.info.n_coord_dims;
+        dstart[0] = 0;
+        dstart[1] = 0;
 
-    if (global_domain.info.n_coord_dims == 1) {
-        dimids[0] = nc->ni_dimid;
-        dcount[0] = nc->ni_size;
-    }
-    else if (global_domain.info.n_coord_dims == 2) {
-        dimids[0] = nc->nj_dimid;
-        dcount[0] = nc->nj_size;
+        if (global_domain.info.n_coord_dims == 1) {
+            dimids[0] = nc->ni_dimid;
+            dcount[0] = nc->ni_size;
+        }
+        else if (global_domain.info.n_coord_dims == 2) {
+            dimids[0] = nc->nj_dimid;
+            dcount[0] = nc->nj_size;
 
-        dimids[1] = nc->ni_dimid;
-        dcount[1] = nc->ni_size;
-    }
-    else {
-        log_err("n_coord_dims should be 1 or 2");
-    }
+            dimids[1] = nc->ni_dimid;
+            dcount[1] = nc->ni_size;
+        }
+        else {
+            log_err("n_coord_dims should be 1 or 2");
+        }
 
-    // define the netcdf variable longitude
-    status =
-        nc_def_var(nc->nc_id, global_domain.info.lon_var, NC_DOUBLE, ndims,
-                   dimids, &(lon_var_id));
-    check_nc_status(status, "Error defining lon variable in %s",
-                    stream->filename);
+        // define the netcdf variable longitude
+        status =
+            nc_def_var(nc->nc_id, global_domain.info.lon_var, NC_DOUBLE, ndims,
+                       dimids, &(lon_var_id));
+        check_nc_status(status, "Error defining lon variable in %s",
+                        stream->filename);
 
-    status = nc_put_att_text(nc->nc_id, lon_var_id, "long_name",
-                             strlen("longitude"), "longitude");
-    check_nc_status(status, "Error adding longitude long_name attribute in %s",
-                    stream->filename);
-    status = nc_put_att_text(nc->nc_id, lon_var_id, "units",
-                             strlen("degrees_east"), "degrees_east");
-    check_nc_status(status, "Error adding longitude units attribute in %s",
-                    stream->filename);
-    status = nc_put_att_text(nc->nc_id, lon_var_id, "standard_name",
-                             strlen("longitude"), "longitude");
-    check_nc_status(status,
-                    "Error adding longitude standard_name attribute in %s",
-                    stream->filename);
+        status = nc_put_att_text(nc->nc_id, lon_var_id, "long_name",
+                                 strlen("longitude"), "longitude");
+        check_nc_status(status,
+                        "Error adding longitude long_name attribute in %s",
+                        stream->filename);
+        status = nc_put_att_text(nc->nc_id, lon_var_id, "units",
+                                 strlen("degrees_east"), "degrees_east");
+        check_nc_status(status, "Error adding longitude units attribute in %s",
+                        stream->filename);
+        status = nc_put_att_text(nc->nc_id, lon_var_id, "standard_name",
+                                 strlen("longitude"), "longitude");
+        check_nc_status(status,
+                        "Error adding longitude standard_name attribute in %s",
+                        stream->filename);
 
-    if (global_domain.info.n_coord_dims == 1) {
-        dimids[0] = nc->nj_dimid;
-        dcount[0] = nc->nj_size;
-    }
+        if (global_domain.info.n_coord_dims == 1) {
+            dimids[0] = nc->nj_dimid;
+            dcount[0] = nc->nj_size;
+        }
 
-    // define the netcdf variable latitude
-    status = nc_def_var(nc->nc_id, global_domain.info.lat_var, NC_DOUBLE, ndims,
-                        dimids, &(lat_var_id));
-    check_nc_status(status, "Error defining lat variable in %s",
-                    stream->filename);
-    status = nc_put_att_text(nc->nc_id, lat_var_id, "long_name",
-                             strlen("latitude"), "latitude");
-    check_nc_status(status, "Error adding latitude long_name attribute in %s",
-                    stream->filename);
-    status = nc_put_att_text(nc->nc_id, lat_var_id, "units",
-                             strlen("degrees_north"), "degrees_north");
-    check_nc_status(status, "Error adding latitude units attribute in %s",
-                    stream->filename);
-    status = nc_put_att_text(nc->nc_id, lat_var_id, "standard_name",
-                             strlen("latitude"), "latitude");
-    check_nc_status(status,
-                    "Error adding latitude standard_name attribute in %s",
-                    stream->filename);
+        // define the netcdf variable latitude
+        status = nc_def_var(nc->nc_id, global_domain.info.lat_var, NC_DOUBLE,
+                            ndims, dimids, &(lat_var_id));
+        check_nc_status(status, "Error defining lat variable in %s",
+                        stream->filename);
+        status = nc_put_att_text(nc->nc_id, lat_var_id, "long_name",
+                                 strlen("latitude"), "latitude");
+        check_nc_status(status,
+                        "Error adding latitude long_name attribute in %s",
+                        stream->filename);
+        status = nc_put_att_text(nc->nc_id, lat_var_id, "units",
+                                 strlen("degrees_north"), "degrees_north");
+        check_nc_status(status, "Error adding latitude units attribute in %s",
+                        stream->filename);
+        status = nc_put_att_text(nc->nc_id, lat_var_id, "standard_name",
+                                 strlen("latitude"), "latitude");
+        check_nc_status(status,
+                        "Error adding latitude standard_name attribute in %s",
+                        stream->filename);
+    }
 
     // create output variables
     for (j = 0; j < stream->nvars; j++) {
@@ -452,16 +696,28 @@ initialize_history_file(nc_file_struct *nc,
         check_nc_status(status, "Error defining variable %s in %s.  Status: %d",
                         out_metadata[varid].varname, stream->filename, status);
 
+        // set the chunk shape and cache (only works for netCDF4 filetype)
+        set_nc_var_chunking(stream, nc, &(nc->nc_vars[j]));
+
         // Add compression (only works for netCDF4 filetype)
         if (stream->compress) {
             status = nc_def_var_deflate(nc->nc_id, nc->nc_vars[j].nc_varid,
-                                        true, true, stream->compress);
+                                        stream->shuffle, true,
+                                        stream->compress);
             check_nc_status(
                 status,
                 "Error setting compression level in %s for variable: %s",
                 stream->filename, out_metadata[varid].varname);
         }
 
+#ifdef NC_QUANTIZE_BITROUND
+        // keep only the significant digits (only works for netCDF4 filetype
+        // without direct chunk writes, else see round_history_values())
+        if (!is_direct_chunk_stream(stream, nc)) {
+            set_nc_var_quantize(stream, nc, j);
+        }
+#endif
+
         // set the fill value attribute
         switch (nc->nc_vars[j].nc_type) {
         case NC_DOUBLE:
@@ -518,60 +774,271 @@ initialize_history_file(nc_file_struct *nc,
     check_nc_status(status, "Error leaving define mode for %s",
                     stream->filename);
 
-    // fill the netcdf variables lat/lon
-    if (global_domain.info.n_coord_dims == 1) {
-        dvar = calloc(nc->ni_size, sizeof(*dvar));
-        check_alloc_status(dvar, "Memory allocation error.");
+    if (nc->parallel) {
+        // the time is written by all nodes, since writes that extend the
+        // unlimited dimension are collective
+        set_par_nc_var_collective(nc->nc_id, nc->time_varid);
+        set_par_nc_var_collective(nc->nc_id, nc->time_bounds_varid);
+        // the coordinates are only known on the master node
+        if (mpi_rank != VIC_MPI_ROOT) {
+            return;
+        }
+    }
 
-        dcount[0] = nc->ni_size;
-        for (i = 0; i < nc->ni_size; i++) {
-            dvar[i] = (double) global_domain.locations[i].longitude;
+    if (stream->region[0] == '\0') {
+        // fill the netcdf variables lat/lon
+        if (global_domain.info.n_coord_dims == 1) {
+            dvar = calloc(nc->ni_size, sizeof(*dvar));
+            check_alloc_status(dvar, "Memory allocation error.");
+
+            dcount[0] = nc->ni_size;
+            for (i = 0; i < nc->ni_size; i++) {
+                dvar[i] = (double) global_domain.locations[i].longitude;
+            }
+            status =
+                nc_put_vara_double(nc->nc_id, lon_var_id, dstart, dcount, dvar);
+            check_nc_status(status, "Error adding data to lon in %s",
+                            stream->filename);
+            free(dvar);
+
+            dvar = calloc(nc->nj_size, sizeof(*dvar));
+            check_alloc_status(dvar, "Memory allocation error.");
+            dcount[0] = nc->nj_size;
+            for (i = 0; i < nc->nj_size; i++) {
+                dvar[i] =
+                    (double) global_domain.locations[i * nc->ni_size].latitude;
+            }
+
+            status =
+                nc_put_vara_double(nc->nc_id, lat_var_id, dstart, dcount, dvar);
+            check_nc_status(status, "Error adding data to lon in %s",
+                            stream->filename);
+            free(dvar);
         }
-        status =
-            nc_put_vara_double(nc->nc_id, lon_var_id, dstart, dcount, dvar);
-        check_nc_status(status, "Error adding data to lon in %s",
-                        stream->filename);
-        free(dvar);
-
-        dvar = calloc(nc->nj_size, sizeof(*dvar));
-        check_alloc_status(dvar, "Memory allocation error.");
-        dcount[0] = nc->nj_size;
-        for (i = 0; i < nc->nj_size; i++) {
-            dvar[i] =
-                (double) global_domain.locations[i * nc->ni_size].latitude;
+        else if (global_domain.info.n_coord_dims == 2) {
+            dvar = calloc(nc->nj_size * nc->ni_size, sizeof(*dvar));
+            check_alloc_status(dvar, "Memory allocation error.");
+
+            for (i = 0; i < nc->nj_size * nc->ni_size; i++) {
+                dvar[i] = (double) global_domain.locations[i].longitude;
+            }
+            status = nc_put_vara_double(nc->nc_id, lon_var_id, dstart,
+                                        dcount, dvar);
+            check_nc_status(status, "Error adding data to lon in %s",
+                            stream->filename);
+
+            for (i = 0; i < nc->nj_size * nc->ni_size; i++) {
+                dvar[i] = (double) global_domain.locations[i].latitude;
+            }
+            status = nc_put_vara_double(nc->nc_id, lat_var_id, dstart,
+                                        dcount, dvar);
+            check_nc_status(status, "Error adding data to lat in %s",
+                            stream->filename);
+
+            free(dvar);
+        }
+        else {
+            log_err("n_coord_dims should be 1 or 2");
         }
+    }
 
-        status =
-            nc_put_vara_double(nc->nc_id, lat_var_id, dstart, dcount, dvar);
-        check_nc_status(status, "Error adding data to lon in %s",
+    // fill the netcdf variable land with the index of the active (or
+    // selected) cells, or the region variable with the region IDs
+    if (nc->land_size > 0) {
+        ivar = malloc(nc->land_size * sizeof(*ivar));
+        check_alloc_status(ivar, "Memory allocation error.");
+        for (i = 0; i < nc->land_size; i++) {
+            if (stream->region[0] != '\0') {
+                ivar[i] = nc->region.ids[i];
+            }
+            else if (nc->io_request.subset != NULL) {
+                ivar[i] = (int) nc->subset.grid_cells[i];
+            }
+            else if (nc->split) {
+                ivar[i] = get_split_grid_cells()[i];
+            }
+            else {
+                ivar[i] = (int) filter_active_cells[i];
+            }
+        }
+        dstart[0] = 0;
+        dcount[0] = nc->land_size;
+        status = nc_put_vara_int(nc->nc_id, land_var_id, dstart, dcount, ivar);
+        check_nc_status(status, "Error adding data to land in %s",
                         stream->filename);
-        free(dvar);
+        free(ivar);
     }
-    else if (global_domain.info.n_coord_dims == 2) {
-        dvar = calloc(nc->nj_size * nc->ni_size, sizeof(*dvar));
-        check_alloc_status(dvar, "Memory allocation error.");
 
-        for (i = 0; i < nc->nj_size * nc->ni_size; i++) {
-            dvar[i] = (double) global_domain.locations[i].longitude;
-        }
-        status =
-            nc_put_vara_double(nc->nc_id, lon_var_id, dstart, dcount, dvar);
-        check_nc_status(status, "Error adding data to lon in %s",
+    // the area of the regions
+    if (stream->region[0] != '\0') {
+        status = nc_put_vara_double(nc->nc_id, area_var_id, dstart, dcount,
+                                    nc->region.area);
+        check_nc_status(status, "Error adding data to region_area in %s",
                         stream->filename);
+    }
+}
 
-        for (i = 0; i < nc->nj_size * nc->ni_size; i++) {
-            dvar[i] = (double) global_domain.locations[i].latitude;
+/******************************************************************************
+ * @brief    Copy the template of the history files of a stream to a new
+ *           history file.
+ *****************************************************************************/
+static void
+copy_history_template(char *template_file,
+                      char *filename)
+{
+    char  *buffer;
+    FILE  *src;
+    FILE  *dst;
+    size_t n;
+
+    src = fopen(template_file, "rb");
+    if (src == NULL) {
+        log_err("Unable to open history file template %s", template_file);
+    }
+    dst = fopen(filename, "wb");
+    if (dst == NULL) {
+        log_err("Unable to create history file %s", filename);
+    }
+    buffer = malloc(HISTORY_COPY_SIZE);
+    check_alloc_status(buffer, "Memory allocation error.");
+    while ((n = fread(buffer, 1, HISTORY_COPY_SIZE, src)) > 0) {
+        if (fwrite(buffer, 1, n, dst) != n) {
+            log_err("Error writing history file %s", filename);
         }
-        status =
-            nc_put_vara_double(nc->nc_id, lat_var_id, dstart, dcount, dvar);
-        check_nc_status(status, "Error adding data to lat in %s",
-                        stream->filename);
+    }
+    if (ferror(src)) {
+        log_err("Error reading history file template %s", template_file);
+    }
+    free(buffer);
+    fclose(src);
+    if (fclose(dst) != 0) {
+        log_err("Error writing history file %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Initialize history file
+ * @details  The dimensions, variables, attributes and coordinates of the
+ *           files of a stream are the same for every record, so they are
+ *           defined once in a template file (in RESULT_DIR, removed at the
+ *           end of the run) that is copied to each new history file. The
+ *           files that are created by all nodes (PARALLEL_IO) are defined
+ *           every time.
+ *****************************************************************************/
+void
+initialize_history_file(nc_file_struct *nc,
+                        stream_struct  *stream,
+                        dmy_struct     *ref_dmy)
+{
+    extern filenames_struct filenames;
+    extern int              mpi_rank;
 
-        free(dvar);
+    char                    filename[MAXSTRING];
+    int                     status;
+
+    // This could be further refined but for now, I've chosen a file naming
+    // Convention that goes like this:
+    switch (stream->agg_alarm.freq) {
+    // If FREQ_NDAYS -- filename = result_dir/prefix.YYYY-MM-DD.nc
+    case FREQ_NDAYS:
+        sprintf(stream->filename, "%s/%s.%04d-%02d-%02d.nc",
+                filenames.result_dir,
+                stream->prefix, stream->time_bounds[0].year,
+                stream->time_bounds[0].month,
+                stream->time_bounds[0].day);
+        break;
+    case FREQ_NMONTHS:
+        // If FREQ_NMONTHS -- filename = result_dir/prefix.YYYY-MM.nc
+        sprintf(stream->filename, "%s/%s.%04d-%02d.nc", filenames.result_dir,
+                stream->prefix, stream->time_bounds[0].year,
+                stream->time_bounds[0].month);
+        break;
+    case FREQ_NYEARS:
+        // If FREQ_NYEARS -- filename = result_dir/prefix.YYYY.nc
+        sprintf(stream->filename, "%s/%s.%04d.nc", filenames.result_dir,
+                stream->prefix, stream->time_bounds[0].year);
+        break;
+    default:
+        // For all other cases -- filename = result_dir/prefix.YYYY-MM-DD-SSSSS.nc
+        sprintf(stream->filename, "%s/%s.%04d-%02d-%02d-%05u.nc",
+                filenames.result_dir,
+                stream->prefix, stream->time_bounds[0].year,
+                stream->time_bounds[0].month,
+                stream->time_bounds[0].day,
+                stream->time_bounds[0].dayseconds);
     }
-    else {
-        log_err("n_coord_dims should be 1 or 2");
+    // each group of processes writes its own file
+    if (nc->split) {
+        set_split_filename(stream->filename);
+    }
+
+    if (nc->parallel) {
+        define_history_file(nc, stream);
+        return;
+    }
+
+    // define the template of the files of the stream
+    if (nc->template_file[0] == '\0') {
+        strcpy(filename, stream->filename);
+        snprintf(nc->template_file, MAXSTRING, "%s/.%s.%d.template.nc",
+                 filenames.result_dir, stream->prefix, mpi_rank);
+        strcpy(stream->filename, nc->template_file);
+        define_history_file(nc, stream);
+        status = nc_close(nc->nc_id);
+        check_nc_status(status, "Error closing %s", stream->filename);
+        nc->open = false;
+        strcpy(stream->filename, filename);
     }
+
+    copy_history_template(nc->template_file, stream->filename);
+    reopen_history_file(nc, stream);
+    nc->flush_count = 0;
+}
+
+/******************************************************************************
+ * @brief    Reopen a history file that a preempted run left behind, or
+ *           that was copied from the template of the stream.
+ * @details  stream->filename is the file of the current record. The file
+ *           was defined by initialize_history_file(), so only the ids of its
+ *           variables are looked up.
+ *****************************************************************************/
+void
+reopen_history_file(nc_file_struct *nc,
+                    stream_struct  *stream)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    int                    status;
+    size_t                 j;
+    unsigned int           varid;
+
+    if (nc->parallel) {
+        log_err("Parallel history file %s cannot be reopened",
+                stream->filename);
+    }
+
+    status = nc_open(stream->filename, NC_WRITE, &(nc->nc_id));
+    check_nc_status(status, "Error opening %s", stream->filename);
+    nc->open = true;
+    nc->flush_time = MPI_Wtime();
+
+    status = nc_inq_varid(nc->nc_id, "time", &(nc->time_varid));
+    check_nc_status(status, "Error finding time variable in %s",
+                    stream->filename);
+    status = nc_inq_varid(nc->nc_id, "time_bnds", &(nc->time_bounds_varid));
+    check_nc_status(status, "Error finding time bounds variable in %s",
+                    stream->filename);
+    for (j = 0; j < stream->nvars; j++) {
+        varid = stream->varid[j];
+        status = nc_inq_varid(nc->nc_id, out_metadata[varid].varname,
+                              &(nc->nc_vars[j].nc_varid));
+        check_nc_status(status, "Error finding variable %s in %s",
+                        out_metadata[varid].varname, stream->filename);
+        set_nc_var_chunk_cache(stream, nc, &(nc->nc_vars[j]));
+    }
+
+    // the compressed chunks of the records are written by the master node
+    open_direct_chunks(nc, stream);
 }
 
 /******************************************************************************
@@ -582,16 +1049,19 @@ set_global_nc_attributes(int ncid,
                          unsigned short int
                          file_type)
 {
-    char           tmpstr[MAXSTRING];
-    char           userstr[MAXSTRING];
-    char           hoststr[MAXSTRING];
-    char           mpistr[MPI_MAX_LIBRARY_VERSION_STRING];
-    int            len;
-    int            status;
-    time_t         curr_date_time;
-    struct tm     *timeinfo;
-    uid_t          uid;
-    struct passwd *pw;
+    extern option_struct options;
+    extern MPI_Comm      MPI_COMM_VIC;
+
+    char                 tmpstr[MAXSTRING];
+    char                 userstr[MAXSTRING];
+    char                 hoststr[MAXSTRING];
+    char                 mpistr[MPI_MAX_LIBRARY_VERSION_STRING];
+    int                  len;
+    int                  status;
+    time_t               curr_date_time;
+    struct tm           *timeinfo;
+    uid_t                uid;
+    struct passwd       *pw;
 
     // datestr
     curr_date_time = time(NULL);
@@ -623,6 +1093,12 @@ set_global_nc_attributes(int ncid,
     else if (file_type == NC_STATE_FILE) {
         put_nc_attr(ncid, NC_GLOBAL, "title", "VIC State File");
     }
+    else if (file_type == NC_COST_MAP_FILE) {
+        put_nc_attr(ncid, NC_GLOBAL, "title", "VIC Cost Map");
+    }
+    else if (file_type == NC_STREAMFLOW_FILE) {
+        put_nc_attr(ncid, NC_GLOBAL, "title", "VIC Streamflow File");
+    }
     else {
         put_nc_attr(ncid, NC_GLOBAL, "title", "Unknown");
     }
@@ -631,6 +1107,13 @@ set_global_nc_attributes(int ncid,
     put_nc_attr(ncid, NC_GLOBAL, "source", "VIC Image Driver");
     sprintf(tmpstr, "Created by %s on %s on %s",
             userstr, hoststr, asctime(timeinfo));
+    if (options.PARALLEL_IO && file_type == NC_HISTORY_FILE) {
+        // history files are defined by all nodes, which must agree on the
+        // attributes
+        status = MPI_Bcast(tmpstr, MAXSTRING, MPI_CHAR, VIC_MPI_ROOT,
+                           MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
     put_nc_attr(ncid, NC_GLOBAL, "history", tmpstr);
     put_nc_attr(ncid, NC_GLOBAL, "references",
                 "Primary Historical Reference for VIC: Liang, X., D. P. "
@@ -669,6 +1152,9 @@ initialize_nc_file(nc_file_struct     *nc_file,
     size_t               i;
 
     nc_file->open = false;
+    nc_file->parallel = options.PARALLEL_IO;
+    nc_file->split = false;
+    nc_file->template_file[0] = '\0';
 
     // Set fill values
     nc_file->c_fillvalue = NC_FILL_CHAR;
@@ -683,6 +1169,7 @@ initialize_nc_file(nc_file_struct     *nc_file,
     nc_file->front_dimid = MISSING;
     nc_file->frost_dimid = MISSING;
     nc_file->lake_node_dimid = MISSING;
+    nc_file->land_dimid = MISSING;
     nc_file->layer_dimid = MISSING;
     nc_file->ni_dimid = MISSING;
     nc_file->nj_dimid = MISSING;
@@ -696,6 +1183,10 @@ initialize_nc_file(nc_file_struct     *nc_file,
     nc_file->front_size = MAX_FRONTS;
     nc_file->frost_size = options.Nfrost;
     nc_file->layer_size = options.Nlayer;
+    nc_file->land_size = 0;
+    if (options.OUT_LAYOUT == OUT_LAYOUT_LAND) {
+        nc_file->land_size = global_domain.ncells_active;
+    }
     nc_file->ni_size = global_domain.n_nx;
     nc_file->nj_size = global_domain.n_ny;
     nc_file->node_size = options.Nnode;
@@ -710,4 +1201,8 @@ initialize_nc_file(nc_file_struct     *nc_file,
     for (i = 0; i < nvars; i++) {
         set_nc_var_info(varids[i], dtypes[i], nc_file, &(nc_file->nc_vars[i]));
     }
+
+    // allocate memory for the fields of a history record
+    nc_file->io_fields = calloc(nvars, sizeof(*(nc_file->io_fields)));
+    check_alloc_status(nc_file->io_fields, "Memory allocation error.");
 }
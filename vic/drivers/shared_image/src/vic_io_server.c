@@ -0,0 +1,643 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * I/O servers for the history files.
+ *
+ * When IO_SERVERS > 0, the last IO_SERVERS processes do not run any grid
+ * cells. After the initialization they leave MPI_COMM_VIC, which from then on
+ * only contains the compute processes, and write the history files of the
+ * output streams that are assigned to them. For every history record, the
+ * compute processes send their values to the server of the stream with
+ * non-blocking point-to-point messages, and the master process sends a
+ * header with the time information of the record. The compute processes
+ * therefore neither gather the history records nor wait for the writes.
+ *
+ * Forcing files, parameter files and state files are still read and written
+ * by the master process.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+// message tags, the values of stream i use IO_TAG_DATA + i
+enum
+{
+    IO_TAG_INIT,
+    IO_TAG_RECORD,
+    IO_TAG_SYNC,
+    IO_TAG_DONE,
+    IO_TAG_DATA
+};
+
+static io_server_struct io_servers;
+
+/******************************************************************************
+ * @brief    Get the process (in io_servers.comm) that writes a stream.
+ *****************************************************************************/
+static int
+get_io_server(size_t stream_idx)
+{
+    return (int) (io_servers.ncompute + stream_idx % io_servers.nservers);
+}
+
+/******************************************************************************
+ * @brief    Get the number of layers of all variables of a stream.
+ *****************************************************************************/
+static size_t
+get_stream_nlayers(stream_struct *stream)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 nlayers;
+    size_t                 k;
+
+    nlayers = 0;
+    for (k = 0; k < stream->nvars; k++) {
+        nlayers += out_metadata[stream->varid[k]].nelem;
+    }
+    return nlayers;
+}
+
+/******************************************************************************
+ * @brief    Send the global domain and the decomposition from the master
+ *           process to an I/O server.
+ *****************************************************************************/
+static void
+send_io_server_domain(int server)
+{
+    extern domain_struct global_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern MPI_Datatype  mpi_location_struct_type;
+    extern int           mpi_size;
+    extern int          *mpi_map_global_array_offsets;
+    extern int          *mpi_map_local_array_sizes;
+    extern size_t       *filter_active_cells;
+    extern size_t       *mpi_map_mapping_array;
+
+    size_t               sizes[4];
+    int                  status;
+
+    sizes[0] = global_domain.ncells_total;
+    sizes[1] = global_domain.ncells_active;
+    sizes[2] = global_domain.n_nx;
+    sizes[3] = global_domain.n_ny;
+    status = MPI_Send(sizes, 4, MPI_UNSIGNED_LONG, server, IO_TAG_INIT,
+                      io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Send(&(global_domain.info), sizeof(domain_info_struct),
+                      MPI_BYTE, server, IO_TAG_INIT, io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Send(global_domain.locations, global_domain.ncells_total,
+                      mpi_location_struct_type, server, IO_TAG_INIT,
+                      io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Send(filter_active_cells, global_domain.ncells_active,
+                      MPI_UNSIGNED_LONG, server, IO_TAG_INIT,
+                      io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Send(mpi_map_mapping_array, global_domain.ncells_active,
+                      MPI_UNSIGNED_LONG, server, IO_TAG_INIT,
+                      io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Send(mpi_map_local_array_sizes, mpi_size, MPI_INT, server,
+                      IO_TAG_INIT, io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Send(mpi_map_global_array_offsets, mpi_size, MPI_INT, server,
+                      IO_TAG_INIT, io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+}
+
+/******************************************************************************
+ * @brief    Receive the global domain and the decomposition on an I/O server.
+ *****************************************************************************/
+static void
+recv_io_server_domain(void)
+{
+    extern domain_struct global_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern MPI_Datatype  mpi_location_struct_type;
+    extern int           mpi_size;
+    extern int          *mpi_map_global_array_offsets;
+    extern int          *mpi_map_local_array_sizes;
+    extern size_t       *filter_active_cells;
+    extern size_t       *mpi_map_mapping_array;
+    extern size_t       *mpi_map_grid_array;
+
+    size_t               sizes[4];
+    int                  status;
+
+    status = MPI_Recv(sizes, 4, MPI_UNSIGNED_LONG, VIC_MPI_ROOT, IO_TAG_INIT,
+                      io_servers.comm, MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+    global_domain.ncells_total = sizes[0];
+    global_domain.ncells_active = sizes[1];
+    global_domain.n_nx = sizes[2];
+    global_domain.n_ny = sizes[3];
+    status = MPI_Recv(&(global_domain.info), sizeof(domain_info_struct),
+                      MPI_BYTE, VIC_MPI_ROOT, IO_TAG_INIT, io_servers.comm,
+                      MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+
+    global_domain.locations = malloc(global_domain.ncells_total *
+                                     sizeof(*(global_domain.locations)));
+    check_alloc_status(global_domain.locations, "Memory allocation error.");
+    status = MPI_Recv(global_domain.locations, global_domain.ncells_total,
+                      mpi_location_struct_type, VIC_MPI_ROOT, IO_TAG_INIT,
+                      io_servers.comm, MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+
+    filter_active_cells = malloc(global_domain.ncells_active *
+                                 sizeof(*filter_active_cells));
+    check_alloc_status(filter_active_cells, "Memory allocation error.");
+    status = MPI_Recv(filter_active_cells, global_domain.ncells_active,
+                      MPI_UNSIGNED_LONG, VIC_MPI_ROOT, IO_TAG_INIT,
+                      io_servers.comm, MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+
+    mpi_map_mapping_array = malloc(global_domain.ncells_active *
+                                   sizeof(*mpi_map_mapping_array));
+    check_alloc_status(mpi_map_mapping_array, "Memory allocation error.");
+    status = MPI_Recv(mpi_map_mapping_array, global_domain.ncells_active,
+                      MPI_UNSIGNED_LONG, VIC_MPI_ROOT, IO_TAG_INIT,
+                      io_servers.comm, MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+    mpi_map_grid_domain(global_domain.ncells_active, filter_active_cells,
+                        mpi_map_mapping_array, &mpi_map_grid_array);
+
+    mpi_map_local_array_sizes = malloc(mpi_size *
+                                       sizeof(*mpi_map_local_array_sizes));
+    check_alloc_status(mpi_map_local_array_sizes, "Memory allocation error.");
+    status = MPI_Recv(mpi_map_local_array_sizes, mpi_size, MPI_INT,
+                      VIC_MPI_ROOT, IO_TAG_INIT, io_servers.comm,
+                      MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+
+    mpi_map_global_array_offsets = malloc(mpi_size *
+                                          sizeof(*mpi_map_global_array_offsets));
+    check_alloc_status(mpi_map_global_array_offsets,
+                       "Memory allocation error.");
+    status = MPI_Recv(mpi_map_global_array_offsets, mpi_size, MPI_INT,
+                      VIC_MPI_ROOT, IO_TAG_INIT, io_servers.comm,
+                      MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+}
+
+/******************************************************************************
+ * @brief    Check whether the local process is an I/O server.
+ *****************************************************************************/
+bool
+is_io_server(void)
+{
+    return io_servers.server;
+}
+
+/******************************************************************************
+ * @brief    Set up the I/O servers and split them off MPI_COMM_VIC.
+ * @details  Called after the initialization, before the time loop.
+ *****************************************************************************/
+void
+initialize_io_servers(void)
+{
+    extern domain_struct   global_domain;
+    extern domain_struct   local_domain;
+    extern option_struct   options;
+    extern stream_struct  *output_streams;
+    extern MPI_Comm        MPI_COMM_VIC;
+    extern int             mpi_rank;
+    extern int             mpi_size;
+    extern int            *mpi_map_local_array_sizes;
+
+    size_t                 nlayers;
+    size_t                 nelem_max;
+    size_t                 i;
+    int                    server;
+    int                    status;
+
+    if (options.IO_SERVERS == 0) {
+        return;
+    }
+
+    io_servers.active = true;
+    io_servers.nservers = options.IO_SERVERS;
+    io_servers.ncompute = mpi_size - options.IO_SERVERS;
+    io_servers.comm = MPI_COMM_VIC;
+    io_servers.server = ((size_t) mpi_rank >= io_servers.ncompute);
+    create_MPI_io_record_struct_type(&(io_servers.record_type));
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        for (server = io_servers.ncompute; server < mpi_size; server++) {
+            send_io_server_domain(server);
+        }
+    }
+    else if (io_servers.server) {
+        recv_io_server_domain();
+    }
+
+    if (io_servers.server) {
+        // gathered values of the streams written by this server
+        io_servers.data = calloc(options.Noutstreams,
+                                 sizeof(*(io_servers.data)));
+        check_alloc_status(io_servers.data, "Memory allocation error.");
+        nelem_max = 0;
+        for (i = 0; i < io_servers.ncompute; i++) {
+            if ((size_t) mpi_map_local_array_sizes[i] > nelem_max) {
+                nelem_max = (size_t) mpi_map_local_array_sizes[i];
+            }
+        }
+        nlayers = 0;
+        for (i = 0; i < options.Noutstreams; i++) {
+            if (get_io_server(i) != mpi_rank) {
+                continue;
+            }
+            io_servers.data[i] =
+                malloc(get_stream_nlayers(&(output_streams[i])) *
+                       global_domain.ncells_active *
+                       sizeof(*(io_servers.data[i])));
+            check_alloc_status(io_servers.data[i],
+                               "Memory allocation error.");
+            if (get_stream_nlayers(&(output_streams[i])) > nlayers) {
+                nlayers = get_stream_nlayers(&(output_streams[i]));
+            }
+        }
+        io_servers.recvbuf = malloc(nlayers * nelem_max *
+                                    sizeof(*(io_servers.recvbuf)));
+        check_alloc_status(io_servers.recvbuf, "Memory allocation error.");
+        alloc_history_record_buffers();
+    }
+    else {
+        io_servers.sendbuf = malloc(options.Noutstreams *
+                                    sizeof(*(io_servers.sendbuf)));
+        check_alloc_status(io_servers.sendbuf, "Memory allocation error.");
+        io_servers.data_requests =
+            malloc(options.Noutstreams * sizeof(*(io_servers.data_requests)));
+        check_alloc_status(io_servers.data_requests,
+                           "Memory allocation error.");
+        for (i = 0; i < options.Noutstreams; i++) {
+            io_servers.sendbuf[i] =
+                malloc(get_stream_nlayers(&(output_streams[i])) *
+                       local_domain.ncells_active *
+                       sizeof(*(io_servers.sendbuf[i])));
+            check_alloc_status(io_servers.sendbuf[i],
+                               "Memory allocation error.");
+            io_servers.data_requests[i] = MPI_REQUEST_NULL;
+        }
+        if (mpi_rank == VIC_MPI_ROOT) {
+            io_servers.open = calloc(options.Noutstreams,
+                                     sizeof(*(io_servers.open)));
+            check_alloc_status(io_servers.open, "Memory allocation error.");
+            io_servers.headers =
+                malloc(options.Noutstreams * sizeof(*(io_servers.headers)));
+            check_alloc_status(io_servers.headers, "Memory allocation error.");
+            io_servers.header_requests =
+                malloc(options.Noutstreams *
+                       sizeof(*(io_servers.header_requests)));
+            check_alloc_status(io_servers.header_requests,
+                               "Memory allocation error.");
+            for (i = 0; i < options.Noutstreams; i++) {
+                io_servers.header_requests[i] = MPI_REQUEST_NULL;
+            }
+        }
+    }
+
+    // from now on, MPI_COMM_VIC only contains the compute processes
+    status = MPI_Comm_split(io_servers.comm, io_servers.server ? 1 : 0,
+                            mpi_rank, &MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    MPI_Comm_set_errhandler(MPI_COMM_VIC, MPI_ERRORS_RETURN);
+    if (!io_servers.server) {
+        status = MPI_Comm_size(MPI_COMM_VIC, &mpi_size);
+        check_mpi_status(status, "MPI error.");
+    }
+}
+
+/******************************************************************************
+ * @brief    Send a history record to the I/O server of its stream.
+ * @details  Replaces vic_write() on the compute processes when
+ *           IO_SERVERS > 0. Only waits if the previous record of the stream is
+ *           still in flight.
+ *****************************************************************************/
+void
+vic_write_io_server(size_t      stream_idx,
+                    dmy_struct *dmy_current)
+{
+    extern domain_struct   local_domain;
+    extern MPI_Comm        MPI_COMM_VIC;
+    extern stream_struct  *output_streams;
+    extern nc_file_struct *nc_hist_files;
+    extern int             mpi_rank;
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    stream_struct         *stream = &(output_streams[stream_idx]);
+    nc_file_struct        *nc_hist_file = &(nc_hist_files[stream_idx]);
+    io_record_struct      *header = NULL;
+    double                *sendbuf = io_servers.sendbuf[stream_idx];
+    size_t                 offset;
+    size_t                 i;
+    size_t                 j;
+    size_t                 k;
+    bool                   close;
+    int                    status;
+
+    // the buffers of the previous record must have been sent
+    status = MPI_Wait(&(io_servers.data_requests[stream_idx]),
+                      MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+
+    offset = 0;
+    for (k = 0; k < stream->nvars; k++) {
+        for (j = 0; j < out_metadata[stream->varid[k]].nelem; j++) {
+            for (i = 0; i < local_domain.ncells_active; i++) {
+                sendbuf[offset++] = stream->aggdata[i][k][j][0];
+            }
+        }
+    }
+    if (local_domain.ncells_active > 0) {
+        status = MPI_Isend(sendbuf, offset, MPI_DOUBLE,
+                           get_io_server(stream_idx),
+                           IO_TAG_DATA + (int) stream_idx, io_servers.comm,
+                           &(io_servers.data_requests[stream_idx]));
+        check_mpi_status(status, "MPI error.");
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        status = MPI_Wait(&(io_servers.header_requests[stream_idx]),
+                          MPI_STATUS_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        header = &(io_servers.headers[stream_idx]);
+        header->stream_idx = stream_idx;
+        header->time_idx = stream->write_alarm.count;
+        get_history_time_bounds(stream, header->time_bounds);
+        header->start = stream->time_bounds[0];
+    }
+
+    // Advance the position in the history file
+    stream->write_alarm.count++;
+    close = raise_alarm(&(stream->write_alarm), dmy_current);
+    if (close) {
+        reset_alarm(&(stream->write_alarm), dmy_current);
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        // the server opens a new history file with the first record
+        if (!io_servers.open[stream_idx]) {
+            io_servers.open[stream_idx] = true;
+            nc_hist_file->flush_count = 0;
+            nc_hist_file->flush_time = MPI_Wtime();
+        }
+        header->close = close;
+        header->sync = false;
+        if (close) {
+            io_servers.open[stream_idx] = false;
+        }
+        else {
+            nc_hist_file->flush_count++;
+            if (check_flush_history_file(stream, nc_hist_file)) {
+                header->sync = true;
+                nc_hist_file->flush_count = 0;
+                nc_hist_file->flush_time = MPI_Wtime();
+            }
+        }
+
+        status = MPI_Isend(header, 1, io_servers.record_type,
+                           get_io_server(stream_idx), IO_TAG_RECORD,
+                           io_servers.comm,
+                           &(io_servers.header_requests[stream_idx]));
+        check_mpi_status(status, "MPI error.");
+    }
+}
+
+/******************************************************************************
+ * @brief    Ask the I/O server of a stream to sync its history file.
+ * @details  Called on the master process.
+ *****************************************************************************/
+void
+sync_io_server_file(size_t stream_idx)
+{
+    extern MPI_Comm   MPI_COMM_VIC;
+
+    io_record_struct *header = &(io_servers.headers[stream_idx]);
+    int               status;
+
+    if (!io_servers.open[stream_idx]) {
+        return;
+    }
+
+    status = MPI_Wait(&(io_servers.header_requests[stream_idx]),
+                      MPI_STATUS_IGNORE);
+    check_mpi_status(status, "MPI error.");
+    header->stream_idx = stream_idx;
+    status = MPI_Send(header, 1, io_servers.record_type,
+                      get_io_server(stream_idx), IO_TAG_SYNC,
+                      io_servers.comm);
+    check_mpi_status(status, "MPI error.");
+}
+
+/******************************************************************************
+ * @brief    Receive the values of a history record from the compute
+ *           processes.
+ * @details  The values are stored layer by layer, in the order of the nodes.
+ *****************************************************************************/
+static void
+recv_io_server_record(size_t stream_idx)
+{
+    extern domain_struct  global_domain;
+    extern MPI_Comm       MPI_COMM_VIC;
+    extern stream_struct *output_streams;
+    extern int           *mpi_map_global_array_offsets;
+    extern int           *mpi_map_local_array_sizes;
+
+    double               *data = io_servers.data[stream_idx];
+    size_t                nlayers;
+    size_t                ncells;
+    size_t                i;
+    size_t                l;
+    int                   status;
+
+    nlayers = get_stream_nlayers(&(output_streams[stream_idx]));
+    for (i = 0; i < io_servers.ncompute; i++) {
+        ncells = (size_t) mpi_map_local_array_sizes[i];
+        if (ncells == 0) {
+            continue;
+        }
+        status = MPI_Recv(io_servers.recvbuf, nlayers * ncells, MPI_DOUBLE,
+                          (int) i, IO_TAG_DATA + (int) stream_idx,
+                          io_servers.comm, MPI_STATUS_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        for (l = 0; l < nlayers; l++) {
+            memcpy(&(data[l * global_domain.ncells_active +
+                          mpi_map_global_array_offsets[i]]),
+                   &(io_servers.recvbuf[l * ncells]),
+                   ncells * sizeof(*data));
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Main loop of an I/O server: write the history records sent by
+ *           the compute processes until the end of the run.
+ *****************************************************************************/
+void
+vic_io_server(void)
+{
+    extern MPI_Comm        MPI_COMM_VIC;
+    extern stream_struct  *output_streams;
+    extern nc_file_struct *nc_hist_files;
+    extern timer_struct    global_timers[N_TIMERS];
+
+    io_record_struct       header;
+    async_record_struct    record;
+    stream_struct         *stream;
+    nc_file_struct        *nc_hist_file;
+    MPI_Status             mpi_status;
+    int                    status;
+
+    while (true) {
+        status = MPI_Recv(&header, 1, io_servers.record_type, VIC_MPI_ROOT,
+                          MPI_ANY_TAG, io_servers.comm, &mpi_status);
+        check_mpi_status(status, "MPI error.");
+        if (mpi_status.MPI_TAG == IO_TAG_DONE) {
+            break;
+        }
+
+        stream = &(output_streams[header.stream_idx]);
+        nc_hist_file = &(nc_hist_files[header.stream_idx]);
+
+        if (mpi_status.MPI_TAG == IO_TAG_SYNC) {
+            if (nc_hist_file->open) {
+                sync_history_file(stream, nc_hist_file);
+            }
+            continue;
+        }
+
+        if (nc_hist_file->open == false) {
+            timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+            stream->time_bounds[0] = header.start;
+            initialize_history_file(nc_hist_file, stream, &(header.start));
+            timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        }
+        timer_continue(&(global_timers[TIMER_VIC_HIST_GATHER]));
+        recv_io_server_record(header.stream_idx);
+        timer_stop(&(global_timers[TIMER_VIC_HIST_GATHER]));
+
+        record.stream = stream;
+        record.nc_hist_file = nc_hist_file;
+        record.time_idx = header.time_idx;
+        record.time_bounds[0] = header.time_bounds[0];
+        record.time_bounds[1] = header.time_bounds[1];
+        record.close = header.close;
+        record.sync = header.sync;
+        record.data = io_servers.data[header.stream_idx];
+        timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        write_history_record(&record);
+        timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        if (header.close) {
+            nc_hist_file->open = false;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Stop the I/O servers and free their buffers.
+ * @details  Called after the time loop on all processes. Restores
+ *           MPI_COMM_VIC.
+ *****************************************************************************/
+void
+finalize_io_servers(void)
+{
+    extern domain_struct global_domain;
+    extern option_struct options;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+    extern int          *mpi_map_global_array_offsets;
+    extern int          *mpi_map_local_array_sizes;
+    extern size_t       *filter_active_cells;
+    extern size_t       *mpi_map_mapping_array;
+    extern size_t       *mpi_map_grid_array;
+
+    io_record_struct     header;
+    size_t               i;
+    int                  server;
+    int                  status;
+
+    if (!io_servers.active) {
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    if (io_servers.server) {
+        for (i = 0; i < options.Noutstreams; i++) {
+            free(io_servers.data[i]);
+        }
+        free(io_servers.data);
+        free(io_servers.recvbuf);
+        free_history_record_buffers();
+        // the copies of the domain and the decomposition
+        free(global_domain.locations);
+        free(filter_active_cells);
+        free(mpi_map_mapping_array);
+        free(mpi_map_grid_array);
+        free(mpi_map_local_array_sizes);
+        free(mpi_map_global_array_offsets);
+        global_domain.locations = NULL;
+        filter_active_cells = NULL;
+        mpi_map_mapping_array = NULL;
+        mpi_map_grid_array = NULL;
+        mpi_map_local_array_sizes = NULL;
+        mpi_map_global_array_offsets = NULL;
+    }
+    else {
+        status = MPI_Waitall(options.Noutstreams, io_servers.data_requests,
+                             MPI_STATUSES_IGNORE);
+        check_mpi_status(status, "MPI error.");
+        if (mpi_rank == VIC_MPI_ROOT) {
+            status = MPI_Waitall(options.Noutstreams,
+                                 io_servers.header_requests,
+                                 MPI_STATUSES_IGNORE);
+            check_mpi_status(status, "MPI error.");
+            for (server = io_servers.ncompute;
+                 server < (int) (io_servers.ncompute + io_servers.nservers);
+                 server++) {
+                status = MPI_Send(&header, 1, io_servers.record_type, server,
+                                  IO_TAG_DONE, io_servers.comm);
+                check_mpi_status(status, "MPI error.");
+            }
+            free(io_servers.open);
+            free(io_servers.headers);
+            free(io_servers.header_requests);
+        }
+        for (i = 0; i < options.Noutstreams; i++) {
+            free(io_servers.sendbuf[i]);
+        }
+        free(io_servers.sendbuf);
+        free(io_servers.data_requests);
+    }
+
+    MPI_Type_free(&(io_servers.record_type));
+    status = MPI_Comm_free(&MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    MPI_COMM_VIC = io_servers.comm;
+    status = MPI_Comm_size(MPI_COMM_VIC, &mpi_size);
+    check_mpi_status(status, "MPI error.");
+    io_servers.active = false;
+    io_servers.server = false;
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * List of the local cells with a lake for image-like drivers.
+ *
+ * Usually only a few cells of a domain contain a lake. The lake variables are
+ * only made for the cells of this list, and the lake variables of the state
+ * files are only gathered and scattered for them.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+/******************************************************************************
+ * @brief    Make the list of the local cells with a lake and their lake
+ *           variables.
+ * @details  Called once the lake parameters are set, before the lake
+ *           variables are initialized.
+ *****************************************************************************/
+void
+set_lake_cells(void)
+{
+    extern all_vars_struct *all_vars;
+    extern domain_struct    local_domain;
+    extern lake_con_struct *lake_con;
+    extern size_t          *lake_cells;
+    extern size_t           nlake_cells;
+    extern option_struct    options;
+
+    size_t                  i;
+
+    nlake_cells = 0;
+    if (!options.LAKES) {
+        return;
+    }
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (lake_con[i].lake_idx >= 0) {
+            nlake_cells++;
+        }
+    }
+
+    if (nlake_cells > 0) {
+        lake_cells = malloc(nlake_cells * sizeof(*lake_cells));
+        check_alloc_status(lake_cells, "Memory allocation error.");
+    }
+
+    nlake_cells = 0;
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (lake_con[i].lake_idx >= 0) {
+            lake_cells[nlake_cells++] = i;
+            all_vars[i].lake_var = make_lake_var();
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Return the lake parameters of a local cell, or NULL if the lake
+ *           model is not run.
+ *****************************************************************************/
+lake_con_struct *
+get_lake_con(size_t i)
+{
+    extern lake_con_struct *lake_con;
+    extern option_struct    options;
+
+    if (!options.LAKES) {
+        return NULL;
+    }
+
+    return &(lake_con[i]);
+}
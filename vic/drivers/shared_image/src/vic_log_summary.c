@@ -0,0 +1,177 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Summary of the warnings of all processes at the end of the run.
+ *
+ * The warnings that can repeat every time step (log_warn_repeat, e.g. from
+ * root_brent) are counted by call site on every process. At the end of the
+ * run the counts are gathered onto the master process, which logs the total
+ * number of warnings and the number of processes that warned for each call
+ * site, so that the warnings of all processes are seen in one place.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+// warnings of a call site over all processes
+typedef struct {
+    char site[MAXSTRING];
+    size_t count;
+    size_t nprocs;
+} log_site_sum_struct;
+
+/******************************************************************************
+ * @brief    Order the call sites by decreasing number of warnings.
+ *****************************************************************************/
+static int
+compare_log_sites(const void *a,
+                  const void *b)
+{
+    const log_site_sum_struct *sa = a;
+    const log_site_sum_struct *sb = b;
+
+    if (sa->count != sb->count) {
+        return sa->count < sb->count ? 1 : -1;
+    }
+    return strcmp(sa->site, sb->site);
+}
+
+/******************************************************************************
+ * @brief    Gather the warnings by call site of all processes onto the
+ *           master process and log their sums.
+ *
+ * @details  Every process sends one line "count file:line" per call site of
+ *           log_warn_repeat that has warned. This is a collective call over
+ *           MPI_COMM_VIC.
+ *****************************************************************************/
+void
+reduce_log_summary(void)
+{
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+    extern FILE         *LOG_DEST;
+
+    size_t               nsites;
+    size_t               nsums = 0;
+    size_t               count;
+    size_t               i;
+    size_t               j;
+    int                  len = 0;
+    int                  total = 0;
+    int                  line;
+    int                  status;
+    int                 *lens = NULL;
+    int                 *displs = NULL;
+    int                  nprocs = 0;
+    int                  rank;
+    char                *local;
+    char                *all = NULL;
+    char                *ptr;
+    char                *end;
+    char                 site[MAXSTRING];
+    const char          *file;
+    log_site_sum_struct *sums = NULL;
+
+    nsites = get_log_repeat_nsites();
+    local = malloc(nsites * MAXSTRING + 1);
+    check_alloc_status(local, "Memory allocation error.");
+    local[0] = '\0';
+    for (i = 0; i < nsites; i++) {
+        count = get_log_repeat_site(i, &file, &line);
+        snprintf(local + len, MAXSTRING, "%zu %s:%d\n", count, file, line);
+        len += strlen(local + len);
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        lens = malloc(mpi_size * sizeof(*lens));
+        check_alloc_status(lens, "Memory allocation error.");
+        displs = malloc(mpi_size * sizeof(*displs));
+        check_alloc_status(displs, "Memory allocation error.");
+    }
+    status = MPI_Gather(&len, 1, MPI_INT, lens, 1, MPI_INT, VIC_MPI_ROOT,
+                        MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (mpi_rank == VIC_MPI_ROOT) {
+        for (rank = 0; rank < mpi_size; rank++) {
+            displs[rank] = total;
+            total += lens[rank];
+            if (lens[rank] > 0) {
+                nprocs++;
+            }
+        }
+        all = malloc(total + 1);
+        check_alloc_status(all, "Memory allocation error.");
+    }
+    status = MPI_Gatherv(local, len, MPI_CHAR, all, lens, displs, MPI_CHAR,
+                         VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    free(local);
+
+    if (mpi_rank != VIC_MPI_ROOT) {
+        return;
+    }
+
+    if (total > 0) {
+        // sum the counts of the same call site, a call site appears once
+        // in the lines of a process and all processes run the same program
+        sums = calloc(MAX_LOG_SITES, sizeof(*sums));
+        check_alloc_status(sums, "Memory allocation error.");
+        all[total] = '\0';
+        for (ptr = all; *ptr != '\0'; ptr = end + 1) {
+            end = strchr(ptr, '\n');
+            *end = '\0';
+            if (sscanf(ptr, "%zu %s", &count, site) != 2) {
+                continue;
+            }
+            for (j = 0; j < nsums; j++) {
+                if (strcmp(sums[j].site, site) == 0) {
+                    break;
+                }
+            }
+            if (j == MAX_LOG_SITES) {
+                continue;
+            }
+            if (j == nsums) {
+                strcpy(sums[j].site, site);
+                nsums++;
+            }
+            sums[j].count += count;
+            sums[j].nprocs++;
+        }
+        qsort(sums, nsums, sizeof(*sums), compare_log_sites);
+
+        fprintf(LOG_DEST, "[WARN] Warnings by call site over %d processes "
+                "(%d processes warned):\n", mpi_size, nprocs);
+        fprintf(LOG_DEST, "\t%12s  %10s  %s\n", "Warnings", "Processes",
+                "Call site");
+        for (j = 0; j < nsums; j++) {
+            fprintf(LOG_DEST, "\t%12zu  %10zu  %s\n", sums[j].count,
+                    sums[j].nprocs, sums[j].site);
+        }
+        free(sums);
+    }
+
+    free(all);
+    free(lens);
+    free(displs);
+}
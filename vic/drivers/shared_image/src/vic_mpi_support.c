@@ -26,6 +26,15 @@
 
 #include <vic_driver_shared_image.h>
 
+// master node grid buffer and request of the blocking gather and scatter
+// functions, kept for the whole run
+static mpi_io_buffer_struct mpi_io_grid_buffer;
+static nc_io_request_struct mpi_io_request;
+
+// two-level layout of the gather and scatter functions (HIERARCHICAL_IO)
+static node_io_struct       node_io = {
+    MPI_COMM_NULL, MPI_COMM_NULL, 0, NULL, 0, 0, NULL, NULL
+};
 
 /******************************************************************************
 * @brief   Print MPI Error String to LOG_DEST, this function is used by loggers
@@ -100,7 +109,7 @@ create_MPI_global_struct_type(MPI_Datatype *mpi_type)
     MPI_Datatype   *mpi_types;
 
     // nitems has to equal the number of elements in global_param_struct
-    nitems = 32;
+    nitems = 36;
     blocklengths = malloc(nitems * sizeof(*blocklengths));
     check_alloc_status(blocklengths, "Memory allocation error.");
 
@@ -254,6 +263,22 @@ create_MPI_global_struct_type(MPI_Datatype *mpi_type)
     blocklengths[i] = MAXSTRING;
     mpi_types[i++] = MPI_CHAR;
 
+    // size_t spinup_cycles;
+    offsets[i] = offsetof(global_param_struct, spinup_cycles);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t spinup_years;
+    offsets[i] = offsetof(global_param_struct, spinup_years);
+    mpi_types[i++] = MPI_AINT;
+
+    // double spinup_tol;
+    offsets[i] = offsetof(global_param_struct, spinup_tol);
+    mpi_types[i++] = MPI_DOUBLE;
+
+    // size_t spinup_block_steps;
+    offsets[i] = offsetof(global_param_struct, spinup_block_steps);
+    mpi_types[i++] = MPI_AINT;
+
     // make sure that the we have the right number of elements
     if (i != (size_t) nitems) {
         log_err("Miscount: %zd not equal to %d.", i, nitems);
@@ -293,7 +318,7 @@ create_MPI_filenames_struct_type(MPI_Datatype *mpi_type)
     MPI_Datatype   *mpi_types;
 
     // nitems has to equal the number of elements in filenames_struct
-    nitems = 10;
+    nitems = 18;
     blocklengths = malloc(nitems * sizeof(*blocklengths));
     check_alloc_status(blocklengths, "Memory allocation error.");
 
@@ -354,6 +379,38 @@ create_MPI_filenames_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(filenames_struct, log_path);
     mpi_types[i++] = MPI_CHAR;
 
+    // char decomp_cost[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, decomp_cost);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char cost_map[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, cost_map);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char trace[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, trace);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char param_cache[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, param_cache);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char rout_params[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, rout_params);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char checkpoint[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, checkpoint);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char da_port[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, da_port);
+    mpi_types[i++] = MPI_CHAR;
+
+    // char force_stage[MAXSTRING];
+    offsets[i] = offsetof(filenames_struct, force_stage);
+    mpi_types[i++] = MPI_CHAR;
+
 
     // make sure that the we have the right number of elements
     if (i != (size_t) nitems) {
@@ -488,7 +545,7 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     MPI_Datatype   *mpi_types;
 
     // nitems has to equal the number of elements in option_struct
-    nitems = 53;
+    nitems = 98;
     blocklengths = malloc(nitems * sizeof(*blocklengths));
     check_alloc_status(blocklengths, "Memory allocation error.");
 
@@ -538,6 +595,10 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(option_struct, BLOWING_SPATIAL_WIND);
     mpi_types[i++] = MPI_C_BOOL;
 
+    // bool BLOWING_FAST;
+    offsets[i] = offsetof(option_struct, BLOWING_FAST);
+    mpi_types[i++] = MPI_C_BOOL;
+
     // bool CARBON;
     offsets[i] = offsetof(option_struct, CARBON);
     mpi_types[i++] = MPI_C_BOOL;
@@ -582,6 +643,10 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(option_struct, IMPLICIT);
     mpi_types[i++] = MPI_C_BOOL;
 
+    // bool ANALYTIC_JACOBIAN;
+    offsets[i] = offsetof(option_struct, ANALYTIC_JACOBIAN);
+    mpi_types[i++] = MPI_C_BOOL;
+
     // bool JULY_TAVG_SUPPLIED;
     offsets[i] = offsetof(option_struct, JULY_TAVG_SUPPLIED);
     mpi_types[i++] = MPI_C_BOOL;
@@ -634,6 +699,10 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(option_struct, QUICK_SOLVE);
     mpi_types[i++] = MPI_C_BOOL;
 
+    // bool QUIESCENT_SOIL;
+    offsets[i] = offsetof(option_struct, QUIESCENT_SOIL);
+    mpi_types[i++] = MPI_C_BOOL;
+
     // bool SHARE_LAYER_MOIST;
     offsets[i] = offsetof(option_struct, SHARE_LAYER_MOIST);
     mpi_types[i++] = MPI_C_BOOL;
@@ -654,10 +723,30 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(option_struct, SPATIAL_SNOW);
     mpi_types[i++] = MPI_C_BOOL;
 
+    // bool ADAPTIVE_SUBSTEPS;
+    offsets[i] = offsetof(option_struct, ADAPTIVE_SUBSTEPS);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool BAND_MERGE;
+    offsets[i] = offsetof(option_struct, BAND_MERGE);
+    mpi_types[i++] = MPI_C_BOOL;
+
     // bool TFALLBACK;
     offsets[i] = offsetof(option_struct, TFALLBACK);
     mpi_types[i++] = MPI_C_BOOL;
 
+    // bool TSURF_NEWTON;
+    offsets[i] = offsetof(option_struct, TSURF_NEWTON);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool ROOT_RETRY;
+    offsets[i] = offsetof(option_struct, ROOT_RETRY);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool FAST_SVP;
+    offsets[i] = offsetof(option_struct, FAST_SVP);
+    mpi_types[i++] = MPI_C_BOOL;
+
     // bool BASEFLOW;
     offsets[i] = offsetof(option_struct, BASEFLOW);
     mpi_types[i++] = MPI_C_BOOL;
@@ -666,6 +755,10 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(option_struct, GRID_DECIMAL);
     mpi_types[i++] = MPI_UNSIGNED_SHORT;
 
+    // size_t FORCE_WINDOW;
+    offsets[i] = offsetof(option_struct, FORCE_WINDOW);
+    mpi_types[i++] = MPI_AINT;
+
     // bool VEGLIB_FCAN;
     offsets[i] = offsetof(option_struct, VEGLIB_FCAN);
     mpi_types[i++] = MPI_C_BOOL;
@@ -718,6 +811,150 @@ create_MPI_option_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(option_struct, SAVE_STATE);
     mpi_types[i++] = MPI_C_BOOL;
 
+    // bool STATE_INCREMENTAL;
+    offsets[i] = offsetof(option_struct, STATE_INCREMENTAL);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool STATE_ASYNC;
+    offsets[i] = offsetof(option_struct, STATE_ASYNC);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool STATE_STREAMS;
+    offsets[i] = offsetof(option_struct, STATE_STREAMS);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool OUT_CONTAINER;
+    offsets[i] = offsetof(option_struct, OUT_CONTAINER);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool OUT_CASCADE;
+    offsets[i] = offsetof(option_struct, OUT_CASCADE);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool COMPUTE_ZWT;
+    offsets[i] = offsetof(option_struct, COMPUTE_ZWT);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // size_t NTHREADS;
+    offsets[i] = offsetof(option_struct, NTHREADS);
+    mpi_types[i++] = MPI_AINT;
+
+    // unsigned short int DECOMPOSITION;
+    offsets[i] = offsetof(option_struct, DECOMPOSITION);
+    mpi_types[i++] = MPI_UNSIGNED_SHORT;
+
+    // size_t NWORKERS;
+    offsets[i] = offsetof(option_struct, NWORKERS);
+    mpi_types[i++] = MPI_AINT;
+
+    // bool FORCE_PREFETCH;
+    offsets[i] = offsetof(option_struct, FORCE_PREFETCH);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // unsigned short int FORCE_PRECISION;
+    offsets[i] = offsetof(option_struct, FORCE_PRECISION);
+    mpi_types[i++] = MPI_UNSIGNED_SHORT;
+
+    // bool FORCE_DISAGG;
+    offsets[i] = offsetof(option_struct, FORCE_DISAGG);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool FORCE_CATALOG;
+    offsets[i] = offsetof(option_struct, FORCE_CATALOG);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // size_t FORCE_READERS;
+    offsets[i] = offsetof(option_struct, FORCE_READERS);
+    mpi_types[i++] = MPI_AINT;
+
+    // bool PARALLEL_IO;
+    offsets[i] = offsetof(option_struct, PARALLEL_IO);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool ASYNC_OUTPUT;
+    offsets[i] = offsetof(option_struct, ASYNC_OUTPUT);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // size_t IO_SERVERS;
+    offsets[i] = offsetof(option_struct, IO_SERVERS);
+    mpi_types[i++] = MPI_AINT;
+
+    // bool NODE_SHARED_TABLES;
+    offsets[i] = offsetof(option_struct, NODE_SHARED_TABLES);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool HIERARCHICAL_IO;
+    offsets[i] = offsetof(option_struct, HIERARCHICAL_IO);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool DISTRIBUTED_DOMAIN;
+    offsets[i] = offsetof(option_struct, DISTRIBUTED_DOMAIN);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool NUMA_FIRST_TOUCH;
+    offsets[i] = offsetof(option_struct, NUMA_FIRST_TOUCH);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // unsigned short int OUT_LAYOUT;
+    offsets[i] = offsetof(option_struct, OUT_LAYOUT);
+    mpi_types[i++] = MPI_UNSIGNED_SHORT;
+
+    // size_t OUT_SPLIT;
+    offsets[i] = offsetof(option_struct, OUT_SPLIT);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t COMPRESS_THREADS;
+    offsets[i] = offsetof(option_struct, COMPRESS_THREADS);
+    mpi_types[i++] = MPI_AINT;
+
+    // bool SPINUP_FLOAT;
+    offsets[i] = offsetof(option_struct, SPINUP_FLOAT);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool REPRODUCIBLE;
+    offsets[i] = offsetof(option_struct, REPRODUCIBLE);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool PERF_REGIONS;
+    offsets[i] = offsetof(option_struct, PERF_REGIONS);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool IO_BENCHMARK;
+    offsets[i] = offsetof(option_struct, IO_BENCHMARK);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool COMPUTE_BENCHMARK;
+    offsets[i] = offsetof(option_struct, COMPUTE_BENCHMARK);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // size_t HEARTBEAT_STEPS;
+    offsets[i] = offsetof(option_struct, HEARTBEAT_STEPS);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t HEARTBEAT_SECONDS;
+    offsets[i] = offsetof(option_struct, HEARTBEAT_SECONDS);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t LOG_BUFFER;
+    offsets[i] = offsetof(option_struct, LOG_BUFFER);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t REBALANCE_STEPS;
+    offsets[i] = offsetof(option_struct, REBALANCE_STEPS);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t DA_STEPS;
+    offsets[i] = offsetof(option_struct, DA_STEPS);
+    mpi_types[i++] = MPI_AINT;
+
+    // unsigned short int BALANCE_CHECK;
+    offsets[i] = offsetof(option_struct, BALANCE_CHECK);
+    mpi_types[i++] = MPI_UNSIGNED_SHORT;
+
+    // size_t BALANCE_CHECK_N;
+    offsets[i] = offsetof(option_struct, BALANCE_CHECK_N);
+    mpi_types[i++] = MPI_AINT;
+
     // make sure that the we have the right number of elements
     if (i != (size_t) nitems) {
         log_err("Miscount: %zd not equal to %d.", i, nitems);
@@ -755,7 +992,7 @@ create_MPI_param_struct_type(MPI_Datatype *mpi_type)
     MPI_Datatype   *mpi_types;
 
     // nitems has to equal the number of elements in parameters_struct
-    nitems = 153;
+    nitems = 158;
     blocklengths = malloc(nitems * sizeof(*blocklengths));
     check_alloc_status(blocklengths, "Memory allocation error.");
 
@@ -1385,6 +1622,26 @@ create_MPI_param_struct_type(MPI_Datatype *mpi_type)
     offsets[i] = offsetof(parameters_struct, ROOT_BRENT_T);
     mpi_types[i++] = MPI_DOUBLE;
 
+    // double ROOT_BRENT_RETRY_DT
+    offsets[i] = offsetof(parameters_struct, ROOT_BRENT_RETRY_DT);
+    mpi_types[i++] = MPI_DOUBLE;
+
+    // double ADAPT_RUNOFF_FRAC
+    offsets[i] = offsetof(parameters_struct, ADAPT_RUNOFF_FRAC);
+    mpi_types[i++] = MPI_DOUBLE;
+
+    // double ADAPT_SNOW_TAIR
+    offsets[i] = offsetof(parameters_struct, ADAPT_SNOW_TAIR);
+    mpi_types[i++] = MPI_DOUBLE;
+
+    // double BAND_MERGE_TDIFF
+    offsets[i] = offsetof(parameters_struct, BAND_MERGE_TDIFF);
+    mpi_types[i++] = MPI_DOUBLE;
+
+    // double BAND_MERGE_FDIFF
+    offsets[i] = offsetof(parameters_struct, BAND_MERGE_FDIFF);
+    mpi_types[i++] = MPI_DOUBLE;
+
     // make sure that the we have the right number of elements
     if (i != (size_t) nitems) {
         log_err("Miscount: %zd not equal to %d.", i, nitems);
@@ -1559,6 +1816,90 @@ create_MPI_alarm_struct_type(MPI_Datatype *mpi_type)
     MPI_Type_free(&mpi_dmy_type);
 }
 
+/******************************************************************************
+ * @brief   Create an MPI_Datatype that represents the io_record_struct
+ * @details This allows MPI operations in which the entire io_record_struct
+ *          can be treated as an MPI_Datatype.
+ * @param mpi_type MPI_Datatype that can be used in MPI operations
+ *****************************************************************************/
+void
+create_MPI_io_record_struct_type(MPI_Datatype *mpi_type)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+
+    int             nitems; // number of elements in struct
+    int             status;
+    int            *blocklengths;
+    size_t          i;
+    MPI_Aint       *offsets;
+    MPI_Datatype   *mpi_types;
+    MPI_Datatype    mpi_dmy_type;
+
+    // nitems has to equal the number of elements in io_record_struct
+    nitems = 6;
+    blocklengths = malloc(nitems * sizeof(*blocklengths));
+    check_alloc_status(blocklengths, "Memory allocation error.");
+
+    offsets = malloc(nitems * sizeof(*offsets));
+    check_alloc_status(offsets, "Memory allocation error.");
+
+    mpi_types = malloc(nitems * sizeof(*mpi_types));
+    check_alloc_status(mpi_types, "Memory allocation error.");
+
+    // most of the elements in io_record_struct are not arrays. Use 1 as the
+    // default block length and reset as needed
+    for (i = 0; i < (size_t) nitems; i++) {
+        blocklengths[i] = 1;
+    }
+
+    // reset i
+    i = 0;
+
+    // size_t stream_idx;
+    offsets[i] = offsetof(io_record_struct, stream_idx);
+    mpi_types[i++] = MPI_AINT;
+
+    // size_t time_idx;
+    offsets[i] = offsetof(io_record_struct, time_idx);
+    mpi_types[i++] = MPI_AINT;
+
+    // double time_bounds[2];
+    offsets[i] = offsetof(io_record_struct, time_bounds);
+    blocklengths[i] = 2;
+    mpi_types[i++] = MPI_DOUBLE;
+
+    // dmy_struct start;
+    offsets[i] = offsetof(io_record_struct, start);
+    create_MPI_dmy_struct_type(&mpi_dmy_type);
+    mpi_types[i++] = mpi_dmy_type;
+
+    // bool close;
+    offsets[i] = offsetof(io_record_struct, close);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // bool sync;
+    offsets[i] = offsetof(io_record_struct, sync);
+    mpi_types[i++] = MPI_C_BOOL;
+
+    // make sure that the we have the right number of elements
+    if (i != (size_t) nitems) {
+        log_err("Miscount: %zd not equal to %d.", i, nitems);
+    }
+
+    status = MPI_Type_create_struct(nitems, blocklengths, offsets, mpi_types,
+                                    mpi_type);
+    check_mpi_status(status, "MPI error.");
+
+    status = MPI_Type_commit(mpi_type);
+    check_mpi_status(status, "MPI error.");
+
+    // cleanup
+    free(blocklengths);
+    free(offsets);
+    free(mpi_types);
+    MPI_Type_free(&mpi_dmy_type);
+}
+
 /******************************************************************************
  * @brief   Type-agnostic mapping function
  * @details Reorders the elements in 'from' to 'to' according to the ordering
@@ -1622,10 +1963,16 @@ map(size_t  size,
  * @brief   Decompose the domain for MPI operations
  * @details This function sets up the arrays needed to scatter and gather
  *          data from and to the master process to the individual mpi
- *          processes.
+ *          processes. If cell_costs is NULL, cells are dealt out round-robin
+ *          and every process gets the same number of cells.  Otherwise each
+ *          process gets a block of consecutive active cells, with the block
+ *          boundaries chosen so that the summed cost per process is as even
+ *          as possible.
  *
  * @param ncells total number of cells
  * @param mpi_size number of mpi processes
+ * @param cell_costs array with the relative cost of each active cell, or
+ *        NULL for the round-robin decomposition
  * @param mpi_map_local_array_sizes address of integer array with number of
  *        cells assigned to each node (MPI_Scatterv:sendcounts and
  *        MPI_Gatherv:recvcounts)
@@ -1639,6 +1986,7 @@ map(size_t  size,
 void
 mpi_map_decomp_domain(size_t   ncells,
                       size_t   mpi_size,
+                      double  *cell_costs,
                       int    **mpi_map_local_array_sizes,
                       int    **mpi_map_global_array_offsets,
                       size_t **mpi_map_mapping_array)
@@ -1647,6 +1995,10 @@ mpi_map_decomp_domain(size_t   ncells,
     size_t j;
     size_t k;
     size_t n;
+    size_t nmax;
+    double cost_total;
+    double cost_sum;
+    double cost_target;
 
     *mpi_map_local_array_sizes = calloc(mpi_size,
                                         sizeof(*(*mpi_map_local_array_sizes)));
@@ -1655,12 +2007,45 @@ mpi_map_decomp_domain(size_t   ncells,
                                                     mpi_map_global_array_offsets)));
     *mpi_map_mapping_array = calloc(ncells, sizeof(*(*mpi_map_mapping_array)));
 
-    // determine number of cells per node
-    for (n = ncells, i = 0; n > 0; n--, i++) {
-        if (i >= mpi_size) {
-            i = 0;
+    if (cell_costs == NULL) {
+        // determine number of cells per node
+        for (n = ncells, i = 0; n > 0; n--, i++) {
+            if (i >= mpi_size) {
+                i = 0;
+            }
+            (*mpi_map_local_array_sizes)[i] += 1;
+        }
+    }
+    else {
+        cost_total = 0.;
+        for (k = 0; k < ncells; k++) {
+            cost_total += cell_costs[k];
+        }
+
+        // walk along the active cells and close the block for node i once
+        // the cumulative cost passes i + 1 shares of the total, keeping at
+        // least one cell for each of the remaining nodes
+        cost_sum = 0.;
+        for (i = 0, k = 0; i < mpi_size; i++) {
+            if (i == mpi_size - 1) {
+                nmax = ncells;
+            }
+            else if (ncells > k + mpi_size - i - 1) {
+                nmax = ncells - (mpi_size - i - 1);
+            }
+            else {
+                nmax = k + 1;
+            }
+            cost_target = cost_total * (double) (i + 1) / (double) mpi_size;
+            for (n = 0; k < ncells && k < nmax; n++, k++) {
+                if (n > 0 && i < mpi_size - 1 &&
+                    cost_sum + 0.5 * cell_costs[k] > cost_target) {
+                    break;
+                }
+                cost_sum += cell_costs[k];
+            }
+            (*mpi_map_local_array_sizes)[i] = (int) n;
         }
-        (*mpi_map_local_array_sizes)[i] += 1;
     }
 
     // determine offsets to use for MPI_Scatterv and MPI_Gatherv
@@ -1674,293 +2059,1183 @@ mpi_map_decomp_domain(size_t   ncells,
     // set mapping array
     for (i = 0, k = 0; i < (size_t) mpi_size; i++) {
         for (j = 0; j < (size_t) (*mpi_map_local_array_sizes)[i]; j++) {
-            (*mpi_map_mapping_array)[k++] = (size_t) (i + j * mpi_size);
+            if (cell_costs == NULL) {
+                (*mpi_map_mapping_array)[k++] = (size_t) (i + j * mpi_size);
+            }
+            else {
+                (*mpi_map_mapping_array)[k] = k;
+                k++;
+            }
         }
     }
 }
 
 /******************************************************************************
- * @brief   Gather and write double precision NetCDF field
- * @details Values are gathered to the master node and then written from the
- *          master node
+ * @brief   Distance of a grid cell along the Hilbert curve of the grid
+ * @details n is the side of the curve, a power of two that is at least the
+ *          number of rows and columns of the grid.
  *****************************************************************************/
-void
-gather_put_nc_field_double(int     nc_id,
-                           int     var_id,
-                           double  fillval,
-                           size_t *start,
-                           size_t *count,
-                           double *var)
+static size_t
+get_hilbert_distance(size_t n,
+                     size_t x,
+                     size_t y)
 {
-    extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
-    extern domain_struct local_domain;
-    extern int           mpi_rank;
-    extern int          *mpi_map_global_array_offsets;
-    extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    double              *dvar = NULL;
-    double              *dvar_gathered = NULL;
-    double              *dvar_remapped = NULL;
-    size_t               grid_size;
-    size_t               i;
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        grid_size = global_domain.n_nx * global_domain.n_ny;
-        dvar = malloc(grid_size * sizeof(*dvar));
-        check_alloc_status(dvar, "Memory allocation error.");
-
-        for (i = 0; i < grid_size; i++) {
-            dvar[i] = fillval;
+    size_t d = 0;
+    size_t s;
+    size_t rx;
+    size_t ry;
+    size_t tmp;
+
+    for (s = n / 2; s > 0; s /= 2) {
+        rx = (x & s) > 0;
+        ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // rotate the quadrant
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            tmp = x;
+            x = y;
+            y = tmp;
         }
-        dvar_gathered =
-            malloc(global_domain.ncells_active * sizeof(*dvar_gathered));
-        check_alloc_status(dvar_gathered, "Memory allocation error.");
-
-        dvar_remapped =
-            malloc(global_domain.ncells_active * sizeof(*dvar_remapped));
-        check_alloc_status(dvar_remapped, "Memory allocation error.");
-    }
-    // Gather the results from the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Gatherv(var, local_domain.ncells_active, MPI_DOUBLE,
-                         dvar_gathered, mpi_map_local_array_sizes,
-                         mpi_map_global_array_offsets, MPI_DOUBLE,
-                         VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
-    if (mpi_rank == VIC_MPI_ROOT) {
-        // remap the array
-        map(sizeof(double), global_domain.ncells_active, NULL,
-            mpi_map_mapping_array, dvar_gathered, dvar_remapped);
-        // expand to full grid size
-        map(sizeof(double), global_domain.ncells_active, NULL,
-            filter_active_cells, dvar_remapped, dvar);
-
-        status = nc_put_vara_double(nc_id, var_id, start, count, dvar);
-        check_nc_status(status, "Error writing values.");
-        // cleanup
-        free(dvar);
-        free(dvar_gathered);
-        free(dvar_remapped);
     }
+
+    return d;
 }
 
 /******************************************************************************
- * @brief   Gather and write double precision NetCDF field
- * @details Values are gathered to the master node and then written from the
- *          master node
+ * @brief   Compare two cells by their distance along the Hilbert curve
  *****************************************************************************/
-void
-gather_put_nc_field_float(int     nc_id,
-                          int     var_id,
-                          float   fillval,
-                          size_t *start,
-                          size_t *count,
-                          float  *var)
+static int
+compare_hilbert_cells(const void *a,
+                      const void *b)
 {
-    extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
-    extern domain_struct local_domain;
-    extern int           mpi_rank;
-    extern int          *mpi_map_global_array_offsets;
-    extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    float               *fvar = NULL;
-    float               *fvar_gathered = NULL;
-    float               *fvar_remapped = NULL;
-    size_t               grid_size;
-    size_t               i;
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        grid_size = global_domain.n_nx * global_domain.n_ny;
-        fvar = malloc(grid_size * sizeof(*fvar));
-        check_alloc_status(fvar, "Memory allocation error.");
-        for (i = 0; i < grid_size; i++) {
-            fvar[i] = fillval;
-        }
-        fvar_gathered =
-            malloc(global_domain.ncells_active * sizeof(*fvar_gathered));
-        check_alloc_status(fvar_gathered, "Memory allocation error.");
-
-        fvar_remapped =
-            malloc(global_domain.ncells_active * sizeof(*fvar_remapped));
-        check_alloc_status(fvar_remapped, "Memory allocation error.");
-    }
-    // Gather the results from the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Gatherv(var, local_domain.ncells_active, MPI_FLOAT,
-                         fvar_gathered, mpi_map_local_array_sizes,
-                         mpi_map_global_array_offsets, MPI_FLOAT,
-                         VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "Error with gather of floats");
+    const size_t *x = a;
+    const size_t *y = b;
 
-    if (mpi_rank == VIC_MPI_ROOT) {
-        // remap the array
-        map(sizeof(float), global_domain.ncells_active, NULL,
-            mpi_map_mapping_array, fvar_gathered, fvar_remapped);
-        // expand to full grid size
-        map(sizeof(float), global_domain.ncells_active, NULL,
-            filter_active_cells, fvar_remapped, fvar);
-
-        // write to file
-        status = nc_put_vara_float(nc_id, var_id, start, count, fvar);
-        check_nc_status(status, "Error writing values");
-
-        // cleanup
-        free(fvar);
-        free(fvar_gathered);
-        free(fvar_remapped);
+    if (x[0] < y[0]) {
+        return -1;
     }
+    return (x[0] > y[0]);
 }
 
 /******************************************************************************
- * @brief   Gather and write integer NetCDF field
- * @details Values are gathered to the master node and then written from the
- *          master node
+ * @brief   Decompose the domain along a Hilbert curve of the grid
+ * @details The active cells are ordered along a Hilbert curve of the grid and
+ *          each process gets a block of consecutive cells along the curve,
+ *          with the block boundaries chosen as in mpi_map_decomp_domain(), so
+ *          that the summed cost per process is as even as possible. The
+ *          cells of a process are then a compact patch of the grid, and the
+ *          local cells are stored in the order of the curve, so that cells
+ *          that are neighbors in memory are neighbors on the grid.
+ *
+ * @param ncells total number of active cells
+ * @param n_nx number of columns of the grid
+ * @param n_ny number of rows of the grid
+ * @param grid_idx array with the (row major) grid index of each active cell
+ * @param mpi_size number of mpi processes
+ * @param cell_costs array with the relative cost of each active cell
+ * @param mpi_map_local_array_sizes see mpi_map_decomp_domain()
+ * @param mpi_map_global_array_offsets see mpi_map_decomp_domain()
+ * @param mpi_map_mapping_array see mpi_map_decomp_domain()
  *****************************************************************************/
 void
-gather_put_nc_field_int(int     nc_id,
-                        int     var_id,
-                        int     fillval,
-                        size_t *start,
-                        size_t *count,
-                        int    *var)
+mpi_map_decomp_hilbert(size_t   ncells,
+                       size_t   n_nx,
+                       size_t   n_ny,
+                       size_t  *grid_idx,
+                       size_t   mpi_size,
+                       double  *cell_costs,
+                       int    **mpi_map_local_array_sizes,
+                       int    **mpi_map_global_array_offsets,
+                       size_t **mpi_map_mapping_array)
+{
+    size_t  n;
+    size_t  k;
+    size_t *curve = NULL;
+    double *curve_costs = NULL;
+
+    n = 1;
+    while (n < n_nx || n < n_ny) {
+        n *= 2;
+    }
+
+    // pairs of the distance along the curve and the active cell index
+    curve = malloc(2 * ncells * sizeof(*curve));
+    check_alloc_status(curve, "Memory allocation error.");
+    for (k = 0; k < ncells; k++) {
+        curve[2 * k] = get_hilbert_distance(n, grid_idx[k] % n_nx,
+                                            grid_idx[k] / n_nx);
+        curve[2 * k + 1] = k;
+    }
+    qsort(curve, ncells, 2 * sizeof(*curve), compare_hilbert_cells);
+
+    curve_costs = malloc(ncells * sizeof(*curve_costs));
+    check_alloc_status(curve_costs, "Memory allocation error.");
+    for (k = 0; k < ncells; k++) {
+        curve_costs[k] = cell_costs[curve[2 * k + 1]];
+    }
+
+    // contiguous blocks along the curve
+    mpi_map_decomp_domain(ncells, mpi_size, curve_costs,
+                          mpi_map_local_array_sizes,
+                          mpi_map_global_array_offsets,
+                          mpi_map_mapping_array);
+    for (k = 0; k < ncells; k++) {
+        (*mpi_map_mapping_array)[k] =
+            curve[2 * (*mpi_map_mapping_array)[k] + 1];
+    }
+
+    free(curve);
+    free(curve_costs);
+}
+
+/******************************************************************************
+ * @brief   Fuse the MPI and active cell mappings into a single grid mapping
+ * @details Element k of an array in the order of the nodes (as used by
+ *          MPI_Gatherv and MPI_Scatterv) holds the value of grid cell
+ *          mpi_map_grid_array[k], i.e.
+ *          grid_array[k] = filter_active_cells[mapping_array[k]]
+ *          The table replaces the two map() passes per field with one.
+ *
+ * @param ncells number of active cells
+ * @param filter_active_cells array with the grid index of each active cell
+ * @param mpi_map_mapping_array array with the active cell index of each
+ *        element in the order of the nodes
+ * @param mpi_map_grid_array address of size_t array with the grid index of
+ *        each element in the order of the nodes
+ *****************************************************************************/
+void
+mpi_map_grid_domain(size_t   ncells,
+                    size_t  *filter_active_cells,
+                    size_t  *mpi_map_mapping_array,
+                    size_t **mpi_map_grid_array)
+{
+    size_t k;
+
+    *mpi_map_grid_array = malloc(ncells * sizeof(*(*mpi_map_grid_array)));
+    check_alloc_status(*mpi_map_grid_array, "Memory allocation error.");
+
+    for (k = 0; k < ncells; k++) {
+        (*mpi_map_grid_array)[k] =
+            filter_active_cells[mpi_map_mapping_array[k]];
+    }
+}
+
+/******************************************************************************
+ * @brief   Copy values to their grid cells
+ * @details to[grid_map[i]] = from[i] for i < n. The common element sizes use
+ *          a fixed-size copy that compiles to a single load and store, other
+ *          sizes fall back to map().
+ *****************************************************************************/
+void
+map_to_grid(size_t  size,
+            size_t  n,
+            size_t *grid_map,
+            void   *from,
+            void   *to)
+{
+    char  *cfrom = (char *) from;
+    char  *cto = (char *) to;
+    size_t i;
+
+    switch (size) {
+    case 8:
+        for (i = 0; i < n; i++) {
+            memcpy(cto + grid_map[i] * 8, cfrom + i * 8, 8);
+        }
+        break;
+    case 4:
+        for (i = 0; i < n; i++) {
+            memcpy(cto + grid_map[i] * 4, cfrom + i * 4, 4);
+        }
+        break;
+    case 2:
+        for (i = 0; i < n; i++) {
+            memcpy(cto + grid_map[i] * 2, cfrom + i * 2, 2);
+        }
+        break;
+    case 1:
+        for (i = 0; i < n; i++) {
+            cto[grid_map[i]] = cfrom[i];
+        }
+        break;
+    default:
+        map(size, n, NULL, grid_map, from, to);
+    }
+}
+
+/******************************************************************************
+ * @brief   Copy values from their grid cells
+ * @details to[i] = from[grid_map[i]] for i < n. Counterpart of map_to_grid().
+ *****************************************************************************/
+void
+map_from_grid(size_t  size,
+              size_t  n,
+              size_t *grid_map,
+              void   *from,
+              void   *to)
+{
+    char  *cfrom = (char *) from;
+    char  *cto = (char *) to;
+    size_t i;
+
+    switch (size) {
+    case 8:
+        for (i = 0; i < n; i++) {
+            memcpy(cto + i * 8, cfrom + grid_map[i] * 8, 8);
+        }
+        break;
+    case 4:
+        for (i = 0; i < n; i++) {
+            memcpy(cto + i * 4, cfrom + grid_map[i] * 4, 4);
+        }
+        break;
+    case 2:
+        for (i = 0; i < n; i++) {
+            memcpy(cto + i * 2, cfrom + grid_map[i] * 2, 2);
+        }
+        break;
+    case 1:
+        for (i = 0; i < n; i++) {
+            cto[i] = cfrom[grid_map[i]];
+        }
+        break;
+    default:
+        map(size, n, grid_map, NULL, from, to);
+    }
+}
+
+/******************************************************************************
+ * @brief   Set up the two-level layout of the gather and scatter functions
+ * @details Must be called by all nodes after the decomposition of the domain.
+ *          The processes of each compute node are grouped in a shared memory
+ *          communicator whose first process (the node leader) collects their
+ *          values. The master node is the node leader of its compute node
+ *          and the first of the node leaders.
+ *****************************************************************************/
+void
+initialize_node_io(void)
 {
-    extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
     extern domain_struct local_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+
+    int                 *node_ranks = NULL;
+    int                 *leader_sizes = NULL;
+    int                 *displs = NULL;
+    int                  node_rank;
+    int                  ncells;
+    int                  key;
+    int                  i;
+    int                  status;
+
+    // the master node comes first on its compute node and among the leaders
+    key = (mpi_rank == VIC_MPI_ROOT) ? 0 : 1;
+    status = MPI_Comm_split_type(MPI_COMM_VIC, MPI_COMM_TYPE_SHARED, key,
+                                 MPI_INFO_NULL, &(node_io.node_comm));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_rank(node_io.node_comm, &node_rank);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_size(node_io.node_comm, &(node_io.node_size));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_split(MPI_COMM_VIC, node_rank == 0 ? 0 : MPI_UNDEFINED,
+                            key, &(node_io.leader_comm));
+    check_mpi_status(status, "MPI error.");
+
+    // cells and ranks of the processes of the compute node
+    if (node_rank == 0) {
+        node_io.node_ncells = malloc(node_io.node_size *
+                                     sizeof(*(node_io.node_ncells)));
+        check_alloc_status(node_io.node_ncells, "Memory allocation error.");
+        node_ranks = malloc(node_io.node_size * sizeof(*node_ranks));
+        check_alloc_status(node_ranks, "Memory allocation error.");
+    }
+    ncells = (int) local_domain.ncells_active;
+    status = MPI_Gather(&ncells, 1, MPI_INT, node_io.node_ncells, 1, MPI_INT,
+                        0, node_io.node_comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Gather(&mpi_rank, 1, MPI_INT, node_ranks, 1, MPI_INT, 0,
+                        node_io.node_comm);
+    check_mpi_status(status, "MPI error.");
+    node_io.node_ncells_total = 0;
+    if (node_rank == 0) {
+        for (i = 0; i < node_io.node_size; i++) {
+            node_io.node_ncells_total += node_io.node_ncells[i];
+        }
+    }
+
+    // the master node collects the layout of all compute nodes
+    if (node_io.leader_comm != MPI_COMM_NULL) {
+        status = MPI_Comm_size(node_io.leader_comm, &(node_io.nleaders));
+        check_mpi_status(status, "MPI error.");
+        if (mpi_rank == VIC_MPI_ROOT) {
+            node_io.leader_ncells = malloc(node_io.nleaders *
+                                           sizeof(*(node_io.leader_ncells)));
+            check_alloc_status(node_io.leader_ncells,
+                               "Memory allocation error.");
+            leader_sizes = malloc(node_io.nleaders * sizeof(*leader_sizes));
+            check_alloc_status(leader_sizes, "Memory allocation error.");
+            displs = malloc(node_io.nleaders * sizeof(*displs));
+            check_alloc_status(displs, "Memory allocation error.");
+            node_io.order = malloc(mpi_size * sizeof(*(node_io.order)));
+            check_alloc_status(node_io.order, "Memory allocation error.");
+        }
+        status = MPI_Gather(&(node_io.node_ncells_total), 1, MPI_INT,
+                            node_io.leader_ncells, 1, MPI_INT, VIC_MPI_ROOT,
+                            node_io.leader_comm);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Gather(&(node_io.node_size), 1, MPI_INT, leader_sizes, 1,
+                            MPI_INT, VIC_MPI_ROOT, node_io.leader_comm);
+        check_mpi_status(status, "MPI error.");
+        if (mpi_rank == VIC_MPI_ROOT) {
+            displs[0] = 0;
+            for (i = 1; i < node_io.nleaders; i++) {
+                displs[i] = displs[i - 1] + leader_sizes[i - 1];
+            }
+        }
+        status = MPI_Gatherv(node_ranks, node_io.node_size, MPI_INT,
+                             node_io.order, leader_sizes, displs, MPI_INT,
+                             VIC_MPI_ROOT, node_io.leader_comm);
+        check_mpi_status(status, "MPI error.");
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        log_info("Two-level gather and scatter over %d compute nodes",
+                 node_io.nleaders);
+    }
+
+    free(node_ranks);
+    free(leader_sizes);
+    free(displs);
+}
+
+/******************************************************************************
+ * @brief   Free the two-level layout of the gather and scatter functions
+ *****************************************************************************/
+void
+finalize_node_io(void)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+
+    int             status;
+
+    if (node_io.leader_comm != MPI_COMM_NULL) {
+        status = MPI_Comm_free(&(node_io.leader_comm));
+        check_mpi_status(status, "MPI error.");
+    }
+    if (node_io.node_comm != MPI_COMM_NULL) {
+        status = MPI_Comm_free(&(node_io.node_comm));
+        check_mpi_status(status, "MPI error.");
+    }
+    free(node_io.node_ncells);
+    free(node_io.leader_ncells);
+    free(node_io.order);
+    node_io.node_ncells = NULL;
+    node_io.leader_ncells = NULL;
+    node_io.order = NULL;
+}
+
+/******************************************************************************
+ * @brief   Return a buffer of at least nbytes bytes
+ * @details The buffer is kept for the whole run and only grows.
+ *****************************************************************************/
+void *
+get_mpi_io_buffer(mpi_io_buffer_struct *buffer,
+                  size_t                nbytes)
+{
+    if (nbytes > buffer->size) {
+        free(buffer->data);
+        buffer->data = malloc(nbytes);
+        check_alloc_status(buffer->data, "Memory allocation error.");
+        buffer->size = nbytes;
+    }
+
+    return buffer->data;
+}
+
+/******************************************************************************
+ * @brief   Bytes held by the buffers of gather_put_nc_fields() and
+ *          get_scatter_nc_fields(), which only grow during the run
+ *****************************************************************************/
+size_t
+get_mpi_io_buffer_size(void)
+{
+    return mpi_io_grid_buffer.size + mpi_io_request.sendbuf.size +
+           mpi_io_request.recvbuf.size + mpi_io_request.nodebuf.size;
+}
+
+/******************************************************************************
+ * @brief   Size of the values of a netCDF type in memory
+ *****************************************************************************/
+size_t
+get_nc_io_type_size(int nc_type)
+{
+    switch (nc_type) {
+    case NC_DOUBLE:
+        return sizeof(double);
+    case NC_FLOAT:
+        return sizeof(float);
+    case NC_INT:
+        return sizeof(int);
+    case NC_SHORT:
+        return sizeof(short int);
+    case NC_CHAR:
+    case NC_BYTE:
+        return sizeof(char);
+    default:
+        log_err("Unsupported nc_type encountered");
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ * @brief   Set the byte counts and displacements of the two-level layout of
+ *          a request
+ * @details The node leaders receive the values of their compute node in the
+ *          order of the processes of the node, and the master node receives
+ *          the values of the compute nodes one after the other. The
+ *          displacement of each process in the buffer of the master node
+ *          replaces the one of the flat layout.
+ *****************************************************************************/
+static void
+set_nc_io_request_nodes(nc_io_request_struct *request,
+                        size_t                nbytes)
+{
+    extern int  mpi_rank;
+    extern int  mpi_size;
+    extern int *mpi_map_local_array_sizes;
+
+    int         offset;
+    int         i;
+
+    if (node_io.leader_comm != MPI_COMM_NULL) {
+        request->node_counts = realloc(request->node_counts,
+                                       node_io.node_size *
+                                       sizeof(*(request->node_counts)));
+        check_alloc_status(request->node_counts, "Memory allocation error.");
+        request->node_displs = realloc(request->node_displs,
+                                       node_io.node_size *
+                                       sizeof(*(request->node_displs)));
+        check_alloc_status(request->node_displs, "Memory allocation error.");
+        offset = 0;
+        for (i = 0; i < node_io.node_size; i++) {
+            request->node_counts[i] = node_io.node_ncells[i] * (int) nbytes;
+            request->node_displs[i] = offset;
+            offset += request->node_counts[i];
+        }
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        request->leader_counts = realloc(request->leader_counts,
+                                         node_io.nleaders *
+                                         sizeof(*(request->leader_counts)));
+        check_alloc_status(request->leader_counts,
+                           "Memory allocation error.");
+        request->leader_displs = realloc(request->leader_displs,
+                                         node_io.nleaders *
+                                         sizeof(*(request->leader_displs)));
+        check_alloc_status(request->leader_displs,
+                           "Memory allocation error.");
+        offset = 0;
+        for (i = 0; i < node_io.nleaders; i++) {
+            request->leader_counts[i] = node_io.leader_ncells[i] *
+                                        (int) nbytes;
+            request->leader_displs[i] = offset;
+            offset += request->leader_counts[i];
+        }
+        offset = 0;
+        for (i = 0; i < mpi_size; i++) {
+            request->displs[node_io.order[i]] = offset;
+            offset += mpi_map_local_array_sizes[node_io.order[i]] *
+                      (int) nbytes;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief   Copy the fields of a request and set the per-node byte counts and
+ *          displacements
+ * @details All fields of a request travel in a single MPI_BYTE collective.
+ *          Each node sends or receives its share of all fields back to back:
+ *          field after field, and within a field slice after slice.
+ *
+ * @return number of bytes per cell of all fields of the request
+ *****************************************************************************/
+static size_t
+set_nc_io_request(nc_io_request_struct *request,
+                  size_t                nfields,
+                  nc_io_field_struct   *fields,
+                  bool                  gather)
+{
     extern int           mpi_rank;
+    extern int           mpi_size;
     extern int          *mpi_map_global_array_offsets;
     extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    int                 *ivar = NULL;
-    int                 *ivar_gathered = NULL;
-    int                 *ivar_remapped = NULL;
-    size_t               grid_size;
+    extern option_struct options;
+
+    size_t               nbytes = 0;
     size_t               i;
 
+    if (nfields > request->maxfields) {
+        free(request->fields);
+        request->fields = malloc(nfields * sizeof(*(request->fields)));
+        check_alloc_status(request->fields, "Memory allocation error.");
+        request->maxfields = nfields;
+    }
+    for (i = 0; i < nfields; i++) {
+        request->fields[i] = fields[i];
+        nbytes += fields[i].nslices * get_nc_io_type_size(fields[i].nc_type);
+    }
+    request->nfields = nfields;
+    request->nbytes = nbytes;
+    request->gather = gather;
+
     if (mpi_rank == VIC_MPI_ROOT) {
-        grid_size = global_domain.n_nx * global_domain.n_ny;
-        ivar = malloc(grid_size * sizeof(*ivar));
-        check_alloc_status(ivar, "Memory allocation error.");
+        if (request->counts == NULL) {
+            request->counts = malloc(mpi_size * sizeof(*(request->counts)));
+            check_alloc_status(request->counts, "Memory allocation error.");
+            request->displs = malloc(mpi_size * sizeof(*(request->displs)));
+            check_alloc_status(request->displs, "Memory allocation error.");
+        }
+        for (i = 0; i < (size_t) mpi_size; i++) {
+            if (request->subset != NULL) {
+                request->counts[i] = request->subset->node_ncells[i] *
+                                     (int) nbytes;
+                request->displs[i] = request->subset->node_offsets[i] *
+                                     (int) nbytes;
+            }
+            else {
+                request->counts[i] = mpi_map_local_array_sizes[i] *
+                                     (int) nbytes;
+                request->displs[i] = mpi_map_global_array_offsets[i] *
+                                     (int) nbytes;
+            }
+        }
+    }
+    // the few values of selected cells are gathered directly
+    if (options.HIERARCHICAL_IO && request->subset == NULL) {
+        set_nc_io_request_nodes(request, nbytes);
+    }
+
+    return nbytes;
+}
 
-        for (i = 0; i < grid_size; i++) {
-            ivar[i] = fillval;
+/******************************************************************************
+ * @brief   Copy one field between the full grid and the per-node layout of a
+ *          request on the master node
+ * @details offset is the offset of the field from the start of the share of
+ *          a node, in bytes per cell.
+ *****************************************************************************/
+static void
+map_nc_io_field(nc_io_request_struct *request,
+                nc_io_field_struct   *field,
+                size_t                offset,
+                size_t                grid_size,
+                char                 *grid,
+                char                 *nodes,
+                bool                  to_grid)
+{
+    extern int     mpi_size;
+    extern int    *mpi_map_global_array_offsets;
+    extern int    *mpi_map_local_array_sizes;
+    extern size_t *mpi_map_grid_array;
+    extern size_t *mpi_map_mapping_array;
+
+    size_t         size;
+    size_t         ncells;
+    size_t        *grid_map;
+    size_t        *node_map;
+    char          *node;
+    size_t         i;
+    size_t         j;
+
+    // along the land dimension, the cells are in the order of the active
+    // cells
+    grid_map = field->land ? mpi_map_mapping_array : mpi_map_grid_array;
+
+    size = get_nc_io_type_size(field->nc_type);
+    for (i = 0; i < (size_t) mpi_size; i++) {
+        if (request->subset != NULL) {
+            ncells = request->subset->node_ncells[i];
+            node_map = request->subset->map +
+                       request->subset->node_offsets[i];
+        }
+        else {
+            ncells = mpi_map_local_array_sizes[i];
+            node_map = &(grid_map[mpi_map_global_array_offsets[i]]);
         }
+        for (j = 0; j < field->nslices; j++) {
+            node = nodes + request->displs[i] + (offset + j * size) * ncells;
+            if (to_grid) {
+                map_to_grid(size, ncells, node_map, node,
+                            grid + j * grid_size * size);
+            }
+            else {
+                map_from_grid(size, ncells, node_map,
+                              grid + j * grid_size * size, node);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief   Return the send buffer of a gather request
+ * @details The buffer holds at least nbytes bytes and is kept between
+ *          requests. A pending request is completed first. The local values
+ *          of the fields of the next request can be stored directly in the
+ *          buffer, field after field and within a field slice after slice.
+ *****************************************************************************/
+void *
+get_nc_io_send_buffer(nc_io_request_struct *request,
+                      size_t                nbytes)
+{
+    wait_nc_io_request(request);
 
-        ivar_gathered =
-            malloc(global_domain.ncells_active * sizeof(*ivar_gathered));
-        check_alloc_status(ivar_gathered, "Memory allocation error.");
+    return get_mpi_io_buffer(&(request->sendbuf), nbytes);
+}
+
+/******************************************************************************
+ * @brief   Start gathering and writing a list of NetCDF fields
+ * @details The local values of all fields are copied into the request, so
+ *          the var buffers can be reused as soon as this function returns.
+ *          The gather is posted as a single non-blocking collective; the
+ *          fields are written on the master node by
+ *          wait_nc_io_request(), which must be called before the file is
+ *          synced or closed. The start and count arrays of the fields must
+ *          stay valid until then. A pending request is completed first.
+ *
+ *          Fields that were stored in the send buffer of the request (see
+ *          get_nc_io_send_buffer()) in the order of the list are sent
+ *          without a copy.
+ *****************************************************************************/
+void
+start_gather_put_nc_fields(nc_io_request_struct *request,
+                           size_t                nfields,
+                           nc_io_field_struct   *fields)
+{
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern domain_struct global_domain;
+    extern domain_struct local_domain;
+    extern int           mpi_rank;
+
+    extern option_struct options;
+
+    char                *sendbuf;
+    char                *recvbuf = NULL;
+    char                *nodebuf = NULL;
+    size_t               ncells;
+    size_t               ncells_total;
+    size_t               nbytes;
+    size_t               offset;
+    size_t               size;
+    size_t               i;
+    int                  status;
 
+    wait_nc_io_request(request);
 
-        ivar_remapped =
-            malloc(global_domain.ncells_active * sizeof(*ivar_remapped));
-        check_alloc_status(ivar_remapped, "Memory allocation error.");
+    nbytes = set_nc_io_request(request, nfields, fields, true);
+
+    ncells = local_domain.ncells_active;
+    ncells_total = global_domain.ncells_active;
+    if (request->subset != NULL) {
+        ncells = request->subset->ncells;
+        ncells_total = request->subset->ncells_total;
     }
-    // Gather the results from the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Gatherv(var, local_domain.ncells_active, MPI_INT,
-                         ivar_gathered, mpi_map_local_array_sizes,
-                         mpi_map_global_array_offsets, MPI_INT,
-                         VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
 
+    sendbuf = get_mpi_io_buffer(&(request->sendbuf), ncells * nbytes);
+    offset = 0;
+    for (i = 0; i < nfields; i++) {
+        size = fields[i].nslices * ncells *
+               get_nc_io_type_size(fields[i].nc_type);
+        // values stored in place with get_nc_io_send_buffer() are not copied
+        if ((char *) fields[i].var != sendbuf + offset) {
+            memcpy(sendbuf + offset, fields[i].var, size);
+        }
+        offset += size;
+    }
     if (mpi_rank == VIC_MPI_ROOT) {
-        // remap the array
-        map(sizeof(int), global_domain.ncells_active, NULL,
-            mpi_map_mapping_array,
-            ivar_gathered, ivar_remapped);
-        // expand to full grid size
-        map(sizeof(int), global_domain.ncells_active, NULL, filter_active_cells,
-            ivar_remapped, ivar);
-        // write to file
-        status = nc_put_vara_int(nc_id, var_id, start, count, ivar);
-        check_nc_status(status, "Error writing values");
-
-        // cleanup
-        free(ivar);
-        free(ivar_gathered);
-        free(ivar_remapped);
+        recvbuf = get_mpi_io_buffer(&(request->recvbuf),
+                                    ncells_total * nbytes);
     }
+
+    if (options.HIERARCHICAL_IO && request->subset == NULL) {
+        // collect the values of the compute node on its leader, then gather
+        // the compute nodes on the master node
+        if (node_io.leader_comm != MPI_COMM_NULL) {
+            nodebuf = get_mpi_io_buffer(&(request->nodebuf),
+                                        node_io.node_ncells_total * nbytes);
+        }
+        status = MPI_Gatherv(sendbuf,
+                             (int) (local_domain.ncells_active * nbytes),
+                             MPI_BYTE, nodebuf, request->node_counts,
+                             request->node_displs, MPI_BYTE, 0,
+                             node_io.node_comm);
+        check_mpi_status(status, "MPI error.");
+        request->mpi_request = MPI_REQUEST_NULL;
+        if (node_io.leader_comm != MPI_COMM_NULL) {
+            status = MPI_Igatherv(nodebuf,
+                                  (int) (node_io.node_ncells_total * nbytes),
+                                  MPI_BYTE, recvbuf, request->leader_counts,
+                                  request->leader_displs, MPI_BYTE,
+                                  VIC_MPI_ROOT, node_io.leader_comm,
+                                  &(request->mpi_request));
+            check_mpi_status(status, "MPI error.");
+        }
+    }
+    else {
+        status = MPI_Igatherv(sendbuf, (int) (ncells * nbytes),
+                              MPI_BYTE, recvbuf, request->counts,
+                              request->displs, MPI_BYTE, VIC_MPI_ROOT,
+                              MPI_COMM_VIC, &(request->mpi_request));
+        check_mpi_status(status, "MPI error.");
+    }
+    request->pending = true;
 }
 
 /******************************************************************************
- * @brief   Gather and write short integer NetCDF field
- * @details Values are gathered to the master node and then written from the
- *          master node
+ * @brief   Start reading and scattering a list of NetCDF fields
+ * @details The fields are read on the master node (or taken from the grid
+ *          member of a field if it is not NULL) and sent to the local nodes
+ *          in a single non-blocking collective. The var buffers are filled
+ *          by wait_nc_io_request() and must stay valid until then. A pending
+ *          request is completed first.
  *****************************************************************************/
 void
-gather_put_nc_field_short(int        nc_id,
-                          int        var_id,
-                          short int  fillval,
-                          size_t    *start,
-                          size_t    *count,
-                          short int *var)
+start_get_scatter_nc_fields(nc_io_request_struct *request,
+                            size_t                nfields,
+                            nc_io_field_struct   *fields)
 {
     extern MPI_Comm      MPI_COMM_VIC;
     extern domain_struct global_domain;
     extern domain_struct local_domain;
     extern int           mpi_rank;
-    extern int          *mpi_map_global_array_offsets;
-    extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    short int           *svar = NULL;
-    short int           *svar_gathered = NULL;
-    short int           *svar_remapped = NULL;
-    size_t               grid_size;
+
+    extern option_struct options;
+
+    char                *sendbuf = NULL;
+    char                *recvbuf;
+    char                *nodebuf = NULL;
+    char                *grid;
+    size_t               nbytes;
+    size_t               offset;
+    size_t               size;
     size_t               i;
+    int                  status;
 
-    if (mpi_rank == VIC_MPI_ROOT) {
-        grid_size = global_domain.n_nx * global_domain.n_ny;
-        svar = malloc(grid_size * sizeof(*svar));
-        check_alloc_status(svar, "Memory allocation error.");
+    wait_nc_io_request(request);
+
+    nbytes = set_nc_io_request(request, nfields, fields, false);
 
-        for (i = 0; i < grid_size; i++) {
-            svar[i] = fillval;
+    if (mpi_rank == VIC_MPI_ROOT) {
+        if (request->io_timer != NULL) {
+            timer_continue(request->io_timer);
+        }
+        sendbuf = get_mpi_io_buffer(&(request->sendbuf),
+                                    global_domain.ncells_active * nbytes);
+        offset = 0;
+        for (i = 0; i < nfields; i++) {
+            size = get_nc_io_type_size(fields[i].nc_type);
+            grid = fields[i].grid;
+            if (grid == NULL) {
+                grid = get_mpi_io_buffer(&mpi_io_grid_buffer,
+                                         fields[i].nslices *
+                                         global_domain.ncells_total * size);
+                if (fields[i].nc_type == NC_DOUBLE) {
+                    get_nc_field_double(fields[i].nc_name, fields[i].var_name,
+                                        fields[i].start, fields[i].count,
+                                        (double *) grid);
+                }
+                else if (fields[i].nc_type == NC_FLOAT) {
+                    get_nc_field_float(fields[i].nc_name, fields[i].var_name,
+                                       fields[i].start, fields[i].count,
+                                       (float *) grid);
+                }
+                else if (fields[i].nc_type == NC_INT) {
+                    get_nc_field_int(fields[i].nc_name, fields[i].var_name,
+                                     fields[i].start, fields[i].count,
+                                     (int *) grid);
+                }
+                else {
+                    log_err("Unsupported nc_type encountered");
+                }
+            }
+            map_nc_io_field(request, &(fields[i]), offset,
+                            global_domain.ncells_total, grid, sendbuf, false);
+            offset += fields[i].nslices * size;
+        }
+        if (request->io_timer != NULL) {
+            timer_stop(request->io_timer);
+        }
+    }
+    recvbuf = get_mpi_io_buffer(&(request->recvbuf),
+                                local_domain.ncells_active * nbytes);
+
+    if (options.HIERARCHICAL_IO) {
+        // send the values of each compute node to its leader, which hands
+        // them out to the processes of the node in wait_nc_io_request()
+        request->mpi_request = MPI_REQUEST_NULL;
+        if (node_io.leader_comm != MPI_COMM_NULL) {
+            nodebuf = get_mpi_io_buffer(&(request->nodebuf),
+                                        node_io.node_ncells_total * nbytes);
+            status = MPI_Iscatterv(sendbuf, request->leader_counts,
+                                   request->leader_displs, MPI_BYTE, nodebuf,
+                                   (int) (node_io.node_ncells_total * nbytes),
+                                   MPI_BYTE, VIC_MPI_ROOT, node_io.leader_comm,
+                                   &(request->mpi_request));
+            check_mpi_status(status, "MPI error.");
         }
+    }
+    else {
+        status = MPI_Iscatterv(sendbuf, request->counts, request->displs,
+                               MPI_BYTE, recvbuf,
+                               (int) (local_domain.ncells_active * nbytes),
+                               MPI_BYTE, VIC_MPI_ROOT, MPI_COMM_VIC,
+                               &(request->mpi_request));
+        check_mpi_status(status, "MPI error.");
+    }
+    request->pending = true;
+}
 
-        svar_gathered =
-            malloc(global_domain.ncells_active * sizeof(*svar_gathered));
-        check_alloc_status(svar_gathered, "Memory allocation error.");
+/******************************************************************************
+ * @brief   Complete a gather or scatter request
+ * @details For a gather, the master node expands each field to the full grid
+ *          and writes it under the netCDF lock, since the forcing reader
+ *          thread may be reading while the record is completed in the cell
+ *          loop (see progress_history_records()). For a scatter, the
+ *          received values are copied to the var buffers of the fields. Does
+ *          nothing if the request is not pending.
+ *****************************************************************************/
+void
+wait_nc_io_request(nc_io_request_struct *request)
+{
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern domain_struct global_domain;
+    extern domain_struct local_domain;
+    extern int           mpi_rank;
+    extern option_struct options;
 
+    nc_io_field_struct  *field;
+    char                *recvbuf = request->recvbuf.data;
+    void                *grid;
+    size_t               grid_size;
+    size_t               offset;
+    size_t               size;
+    size_t               i;
+    size_t               j;
+    int                  status;
 
-        svar_remapped =
-            malloc(global_domain.ncells_active * sizeof(*svar_remapped));
-        check_alloc_status(svar_remapped, "Memory allocation error.");
+    if (!request->pending) {
+        return;
     }
-    // Gather the results from the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Gatherv(var, local_domain.ncells_active, MPI_SHORT,
-                         svar_gathered, mpi_map_local_array_sizes,
-                         mpi_map_global_array_offsets, MPI_SHORT,
-                         VIC_MPI_ROOT, MPI_COMM_VIC);
+
+    if (request->mpi_timer != NULL) {
+        timer_continue(request->mpi_timer);
+    }
+    status = MPI_Wait(&(request->mpi_request), MPI_STATUS_IGNORE);
     check_mpi_status(status, "MPI error.");
+    request->pending = false;
+    if (request->mpi_timer != NULL) {
+        timer_stop(request->mpi_timer);
+    }
 
-    if (mpi_rank == VIC_MPI_ROOT) {
-        // remap the array
-        map(sizeof(short int), global_domain.ncells_active, NULL,
-            mpi_map_mapping_array,
-            svar_gathered, svar_remapped);
-        // expand to full grid size
-        map(sizeof(short int), global_domain.ncells_active, NULL,
-            filter_active_cells, svar_remapped, svar);
-        // write to file
-        status = nc_put_vara_short(nc_id, var_id, start, count, svar);
-        check_nc_status(status, "Error writing values");
-
-        // cleanup
-        free(svar);
-        free(svar_gathered);
-        free(svar_remapped);
+    if (!request->gather) {
+        if (options.HIERARCHICAL_IO) {
+            status = MPI_Scatterv(request->nodebuf.data, request->node_counts,
+                                  request->node_displs, MPI_BYTE, recvbuf,
+                                  (int) (local_domain.ncells_active *
+                                         request->nbytes),
+                                  MPI_BYTE, 0, node_io.node_comm);
+            check_mpi_status(status, "MPI error.");
+        }
+        offset = 0;
+        for (i = 0; i < request->nfields; i++) {
+            field = &(request->fields[i]);
+            size = field->nslices * local_domain.ncells_active *
+                   get_nc_io_type_size(field->nc_type);
+            memcpy(field->var, recvbuf + offset, size);
+            offset += size;
+        }
+        return;
+    }
+    if (mpi_rank != VIC_MPI_ROOT) {
+        return;
+    }
+
+    if (request->io_timer != NULL) {
+        timer_continue(request->io_timer);
+    }
+    lock_netcdf();
+    offset = 0;
+    for (i = 0; i < request->nfields; i++) {
+        field = &(request->fields[i]);
+        size = get_nc_io_type_size(field->nc_type);
+        grid_size = global_domain.n_nx * global_domain.n_ny;
+        if (field->land) {
+            grid_size = global_domain.ncells_active;
+            if (request->subset != NULL) {
+                grid_size = request->subset->ncells_total;
+            }
+        }
+        grid = get_mpi_io_buffer(&mpi_io_grid_buffer,
+                                 field->nslices * grid_size * size);
+
+        // cells that are not active hold the fill value
+        for (j = 0; j < field->nslices * grid_size; j++) {
+            if (field->nc_type == NC_DOUBLE) {
+                ((double *) grid)[j] = field->fillval;
+            }
+            else if (field->nc_type == NC_FLOAT) {
+                ((float *) grid)[j] = (float) field->fillval;
+            }
+            else if (field->nc_type == NC_INT) {
+                ((int *) grid)[j] = (int) field->fillval;
+            }
+            else if (field->nc_type == NC_SHORT) {
+                ((short int *) grid)[j] = (short int) field->fillval;
+            }
+            else {
+                ((signed char *) grid)[j] = (signed char) field->fillval;
+            }
+        }
+        map_nc_io_field(request, field, offset, grid_size, grid, recvbuf,
+                        true);
+        offset += field->nslices * size;
+
+        // the chunks of a compressed history variable are compressed on
+        // COMPRESS_THREADS threads
+        if (request->nc_vars != NULL && request->nc_vars[i].direct.active) {
+            put_direct_chunks(&(request->nc_vars[i].direct), field, grid);
+            continue;
+        }
+        if (field->nc_type == NC_DOUBLE) {
+            status = nc_put_vara_double(field->nc_id, field->nc_varid,
+                                        field->start, field->count, grid);
+        }
+        else if (field->nc_type == NC_FLOAT) {
+            status = nc_put_vara_float(field->nc_id, field->nc_varid,
+                                       field->start, field->count, grid);
+        }
+        else if (field->nc_type == NC_INT) {
+            status = nc_put_vara_int(field->nc_id, field->nc_varid,
+                                     field->start, field->count, grid);
+        }
+        else if (field->nc_type == NC_SHORT) {
+            status = nc_put_vara_short(field->nc_id, field->nc_varid,
+                                       field->start, field->count, grid);
+        }
+        else {
+            status = nc_put_vara_schar(field->nc_id, field->nc_varid,
+                                       field->start, field->count, grid);
+        }
+        check_nc_status(status, "Error writing values.");
+    }
+    unlock_netcdf();
+    if (request->io_timer != NULL) {
+        timer_stop(request->io_timer);
+    }
+}
+
+/******************************************************************************
+ * @brief   Complete a request and free its buffers
+ *****************************************************************************/
+void
+free_nc_io_request(nc_io_request_struct *request)
+{
+    wait_nc_io_request(request);
+
+    free(request->fields);
+    free(request->sendbuf.data);
+    free(request->recvbuf.data);
+    free(request->counts);
+    free(request->displs);
+    free(request->nodebuf.data);
+    free(request->node_counts);
+    free(request->node_displs);
+    free(request->leader_counts);
+    free(request->leader_displs);
+    memset(request, 0, sizeof(*request));
+}
+
+/******************************************************************************
+ * @brief   Gather and write a list of NetCDF fields
+ * @details Blocking version of start_gather_put_nc_fields().
+ *****************************************************************************/
+void
+gather_put_nc_fields(size_t              nfields,
+                     nc_io_field_struct *fields)
+{
+    start_gather_put_nc_fields(&mpi_io_request, nfields, fields);
+    wait_nc_io_request(&mpi_io_request);
+}
+
+/******************************************************************************
+ * @brief   Read and scatter a list of NetCDF fields
+ * @details Blocking version of start_get_scatter_nc_fields().
+ *****************************************************************************/
+void
+get_scatter_nc_fields(size_t              nfields,
+                      nc_io_field_struct *fields)
+{
+    start_get_scatter_nc_fields(&mpi_io_request, nfields, fields);
+    wait_nc_io_request(&mpi_io_request);
+}
+
+/******************************************************************************
+ * @brief   Gather and write a single field
+ *****************************************************************************/
+static void
+gather_put_nc_field(int     nc_id,
+                    int     var_id,
+                    int     nc_type,
+                    double  fillval,
+                    size_t  nslices,
+                    size_t *start,
+                    size_t *count,
+                    void   *var)
+{
+    nc_io_field_struct field;
+
+    memset(&field, 0, sizeof(field));
+    field.nc_id = nc_id;
+    field.nc_varid = var_id;
+    field.nc_type = nc_type;
+    field.fillval = fillval;
+    field.nslices = nslices;
+    field.start = start;
+    field.count = count;
+    field.var = var;
+    gather_put_nc_fields(1, &field);
+}
+
+/******************************************************************************
+ * @brief   Read and scatter a single field
+ * @details With PARALLEL_IO, fields of the parameter file are read by all
+ *          nodes in parallel instead, so that the master node does not hold
+ *          the whole domain.
+ *****************************************************************************/
+static void
+get_scatter_nc_field(char   *nc_name,
+                     char   *var_name,
+                     int     nc_type,
+                     size_t  nslices,
+                     size_t *start,
+                     size_t *count,
+                     void   *grid,
+                     void   *var)
+{
+    extern option_struct    options;
+    extern filenames_struct filenames;
+
+    nc_io_field_struct      field;
+
+    // with PARALLEL_IO, every node reads its own cells of the parameter file
+    if (options.PARALLEL_IO && nc_name != NULL &&
+        (nc_type == NC_DOUBLE || nc_type == NC_INT) &&
+        strcmp(nc_name, filenames.params) == 0) {
+        if (nc_type == NC_DOUBLE) {
+            get_par_nc_field_double_steps(nc_name, var_name, start, count,
+                                          var);
+        }
+        else {
+            get_par_nc_field_int_steps(nc_name, var_name, start, count, var);
+        }
+        return;
     }
+
+    memset(&field, 0, sizeof(field));
+    field.nc_name = nc_name;
+    field.var_name = var_name;
+    field.nc_type = nc_type;
+    field.nslices = nslices;
+    field.start = start;
+    field.count = count;
+    field.grid = grid;
+    field.var = var;
+    get_scatter_nc_fields(1, &field);
+}
+
+/******************************************************************************
+ * @brief   Free the buffers of the gather and scatter functions
+ *****************************************************************************/
+void
+free_mpi_io_buffers(void)
+{
+    free_nc_io_request(&mpi_io_request);
+    free(mpi_io_grid_buffer.data);
+    mpi_io_grid_buffer.data = NULL;
+    mpi_io_grid_buffer.size = 0;
+}
+
+/******************************************************************************
+ * @brief   Gather and write double precision NetCDF field
+ * @details Values are gathered to the master node and then written from the
+ *          master node
+ *****************************************************************************/
+void
+gather_put_nc_field_double(int     nc_id,
+                           int     var_id,
+                           double  fillval,
+                           size_t *start,
+                           size_t *count,
+                           double *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_DOUBLE, fillval, 1, start, count,
+                        var);
+}
+
+/******************************************************************************
+ * @brief   Gather and write single precision NetCDF field
+ * @details Values are gathered to the master node and then written from the
+ *          master node
+ *****************************************************************************/
+void
+gather_put_nc_field_float(int     nc_id,
+                          int     var_id,
+                          float   fillval,
+                          size_t *start,
+                          size_t *count,
+                          float  *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_FLOAT, fillval, 1, start, count,
+                        var);
+}
+
+/******************************************************************************
+ * @brief   Gather and write integer NetCDF field
+ * @details Values are gathered to the master node and then written from the
+ *          master node
+ *****************************************************************************/
+void
+gather_put_nc_field_int(int     nc_id,
+                        int     var_id,
+                        int     fillval,
+                        size_t *start,
+                        size_t *count,
+                        int    *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_INT, fillval, 1, start, count, var);
+}
+
+/******************************************************************************
+ * @brief   Gather and write short integer NetCDF field
+ * @details Values are gathered to the master node and then written from the
+ *          master node
+ *****************************************************************************/
+void
+gather_put_nc_field_short(int        nc_id,
+                          int        var_id,
+                          short int  fillval,
+                          size_t    *start,
+                          size_t    *count,
+                          short int *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_SHORT, fillval, 1, start, count,
+                        var);
 }
 
 /******************************************************************************
@@ -1975,65 +3250,72 @@ gather_put_nc_field_schar(int     nc_id,
                           size_t *start,
                           size_t *count,
                           char   *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_CHAR, fillval, 1, start, count,
+                        var);
+}
+
+/******************************************************************************
+ * @brief   Gather and write a block of double precision NetCDF fields
+ * @details var holds nslices consecutive 2-D slices on the local node, i.e.
+ *          var[j * ncells + i] holds slice j of local cell i, where ncells is
+ *          the number of active cells on the local node. All slices are
+ *          gathered to the master node in a single collective and written
+ *          with a single hyperslab described by start and count. The product
+ *          of the leading (non-spatial) counts must equal nslices.
+ *****************************************************************************/
+void
+gather_put_nc_block_double(int     nc_id,
+                           int     var_id,
+                           double  fillval,
+                           size_t  nslices,
+                           size_t *start,
+                           size_t *count,
+                           double *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_DOUBLE, fillval, nslices, start,
+                        count, var);
+}
+
+/******************************************************************************
+ * @brief   Gather and write a block of integer NetCDF fields
+ * @details Integer counterpart of gather_put_nc_block_double().
+ *****************************************************************************/
+void
+gather_put_nc_block_int(int     nc_id,
+                        int     var_id,
+                        int     fillval,
+                        size_t  nslices,
+                        size_t *start,
+                        size_t *count,
+                        int    *var)
+{
+    gather_put_nc_field(nc_id, var_id, NC_INT, fillval, nslices, start,
+                        count, var);
+}
+
+/******************************************************************************
+ * @brief   Gather double precision field to the master node
+ * @details The gathered values are left in the order of the nodes, i.e. they
+ *          still need to be remapped with mpi_map_mapping_array. dvar is only
+ *          used on the master node and must hold global_domain.ncells_active
+ *          values.
+ *****************************************************************************/
+void
+gather_field_double(double *var,
+                    double *dvar)
 {
     extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
     extern domain_struct local_domain;
-    extern int           mpi_rank;
     extern int          *mpi_map_global_array_offsets;
     extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
     int                  status;
-    signed char         *cvar = NULL;
-    signed char         *cvar_gathered = NULL;
-    signed char         *cvar_remapped = NULL;
-    size_t               grid_size;
-    size_t               i;
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        grid_size = global_domain.n_nx * global_domain.n_ny;
-        cvar = malloc(grid_size * sizeof(*cvar));
-        check_alloc_status(cvar, "Memory allocation error.");
-
-        for (i = 0; i < grid_size; i++) {
-            cvar[i] = fillval;
-        }
-
-        cvar_gathered =
-            malloc(global_domain.ncells_active * sizeof(*cvar_gathered));
-        check_alloc_status(cvar_gathered, "Memory allocation error.");
-
 
-        cvar_remapped =
-            malloc(global_domain.ncells_active * sizeof(*cvar_remapped));
-        check_alloc_status(cvar_remapped, "Memory allocation error.");
-    }
-    // Gather the results from the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Gatherv(var, local_domain.ncells_active, MPI_CHAR,
-                         cvar_gathered, mpi_map_local_array_sizes,
-                         mpi_map_global_array_offsets, MPI_CHAR,
+    status = MPI_Gatherv(var, local_domain.ncells_active, MPI_DOUBLE,
+                         dvar, mpi_map_local_array_sizes,
+                         mpi_map_global_array_offsets, MPI_DOUBLE,
                          VIC_MPI_ROOT, MPI_COMM_VIC);
     check_mpi_status(status, "MPI error.");
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        // remap the array
-        map(sizeof(char), global_domain.ncells_active, NULL,
-            mpi_map_mapping_array,
-            cvar_gathered, cvar_remapped);
-        // expand to full grid size
-        map(sizeof(char), global_domain.ncells_active, NULL,
-            filter_active_cells, cvar_remapped, cvar);
-        // write to file
-        status = nc_put_vara_schar(nc_id, var_id, start, count, cvar);
-        check_nc_status(status, "Error writing values");
-
-        // cleanup
-        free(cvar);
-        free(cvar_gathered);
-        free(cvar_remapped);
-    }
 }
 
 /******************************************************************************
@@ -2048,53 +3330,119 @@ get_scatter_nc_field_double(char   *nc_name,
                             size_t *count,
                             double *var)
 {
-    extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
-    extern domain_struct local_domain;
-    extern int           mpi_rank;
-    extern int          *mpi_map_global_array_offsets;
-    extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    double              *dvar = NULL;
-    double              *dvar_filtered = NULL;
-    double              *dvar_mapped = NULL;
+    get_scatter_nc_field(nc_name, var_name, NC_DOUBLE, 1, start, count, NULL,
+                         var);
+}
 
-    if (mpi_rank == VIC_MPI_ROOT) {
-        dvar = malloc(global_domain.ncells_total * sizeof(*dvar));
-        check_alloc_status(dvar, "Memory allocation error.");
-
-        dvar_filtered =
-            malloc(global_domain.ncells_active * sizeof(*dvar_filtered));
-        check_alloc_status(dvar_filtered, "Memory allocation error.");
-
-        dvar_mapped =
-            malloc(global_domain.ncells_active * sizeof(*dvar_mapped));
-        check_alloc_status(dvar_mapped, "Memory allocation error.");
-
-        get_nc_field_double(nc_name, var_name, start, count, dvar);
-        // filter the active cells only
-        map(sizeof(double), global_domain.ncells_active, filter_active_cells,
-            NULL, dvar, dvar_filtered);
-        // map to prepare for MPI_Scatterv
-        map(sizeof(double), global_domain.ncells_active, mpi_map_mapping_array,
-            NULL, dvar_filtered, dvar_mapped);
-        free(dvar);
-        free(dvar_filtered);
-    }
-
-    // Scatter the results to the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Scatterv(dvar_mapped, mpi_map_local_array_sizes,
-                          mpi_map_global_array_offsets, MPI_DOUBLE,
-                          var, local_domain.ncells_active, MPI_DOUBLE,
-                          VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
+/******************************************************************************
+ * @brief   Read several time steps of a double precision NetCDF field from
+ *          file and scatter
+ * @details The count[0] time slices starting at start[0] are read with a
+ *          single read on the master node and are then scattered to the local
+ *          nodes in a single collective. The remaining dimensions of each
+ *          slice must cover the whole domain. On return, var[j * ncells + i]
+ *          holds time slice j of local cell i, where ncells is the number of
+ *          active cells on the local node. With PARALLEL_IO, each node reads
+ *          its own cells instead.
+ *****************************************************************************/
+void
+get_scatter_nc_field_double_steps(char   *nc_name,
+                                  char   *var_name,
+                                  size_t *start,
+                                  size_t *count,
+                                  double *var)
+{
+    extern option_struct options;
 
-    if (mpi_rank == VIC_MPI_ROOT) {
-        free(dvar_mapped);
+    if (options.PARALLEL_IO) {
+        get_par_nc_field_double_steps(nc_name, var_name, start, count, var);
+        return;
     }
+
+    get_scatter_nc_field(nc_name, var_name, NC_DOUBLE, count[0], start, count,
+                         NULL, var);
+}
+
+/******************************************************************************
+ * @brief   Scatter several time steps of a double precision field
+ * @details dvar holds nsteps consecutive slices of the whole domain on the
+ *          master node (it is not used on the other nodes). All slices are
+ *          sent to the local nodes in a single collective. On return,
+ *          var[j * ncells + i] holds time slice j of local cell i, where
+ *          ncells is the number of active cells on the local node.
+ *****************************************************************************/
+void
+scatter_field_double_steps(size_t  nsteps,
+                           double *dvar,
+                           double *var)
+{
+    get_scatter_nc_field(NULL, NULL, NC_DOUBLE, nsteps, NULL, NULL, dvar,
+                         var);
+}
+
+/******************************************************************************
+ * @brief   Scatter several time steps of a single precision field
+ * @details Single precision counterpart of scatter_field_double_steps().
+ *****************************************************************************/
+void
+scatter_field_float_steps(size_t  nsteps,
+                          float  *fvar,
+                          float  *var)
+{
+    get_scatter_nc_field(NULL, NULL, NC_FLOAT, nsteps, NULL, NULL, fvar,
+                         var);
+}
+
+/******************************************************************************
+ * @brief   Scatter several time steps of a short integer field
+ * @details Short integer counterpart of scatter_field_double_steps(), used
+ *          for packed fields.
+ *****************************************************************************/
+void
+scatter_field_short_steps(size_t     nsteps,
+                          short int *svar,
+                          short int *var)
+{
+    get_scatter_nc_field(NULL, NULL, NC_SHORT, nsteps, NULL, NULL, svar,
+                         var);
+}
+
+/******************************************************************************
+ * @brief   Read a block of double precision NetCDF fields from file and
+ *          scatter
+ * @details The hyperslab described by start and count holds nslices 2-D
+ *          slices, i.e. the product of the leading (non-spatial) counts must
+ *          equal nslices. The block is read on the master node and scattered
+ *          to the local nodes in a single collective. On return,
+ *          var[j * ncells + i] holds slice j of local cell i, where ncells is
+ *          the number of active cells on the local node.
+ *****************************************************************************/
+void
+get_scatter_nc_block_double(char   *nc_name,
+                            char   *var_name,
+                            size_t  nslices,
+                            size_t *start,
+                            size_t *count,
+                            double *var)
+{
+    get_scatter_nc_field(nc_name, var_name, NC_DOUBLE, nslices, start, count,
+                         NULL, var);
+}
+
+/******************************************************************************
+ * @brief   Read a block of integer NetCDF fields from file and scatter
+ * @details Integer counterpart of get_scatter_nc_block_double().
+ *****************************************************************************/
+void
+get_scatter_nc_block_int(char   *nc_name,
+                         char   *var_name,
+                         size_t  nslices,
+                         size_t *start,
+                         size_t *count,
+                         int    *var)
+{
+    get_scatter_nc_field(nc_name, var_name, NC_INT, nslices, start, count,
+                         NULL, var);
 }
 
 /******************************************************************************
@@ -2109,55 +3457,8 @@ get_scatter_nc_field_float(char   *nc_name,
                            size_t *count,
                            float  *var)
 {
-    extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
-    extern domain_struct local_domain;
-    extern int           mpi_rank;
-    extern int          *mpi_map_global_array_offsets;
-    extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    float               *fvar = NULL;
-    float               *fvar_filtered = NULL;
-    float               *fvar_mapped = NULL;
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        fvar = malloc(global_domain.ncells_total * sizeof(*fvar));
-        check_alloc_status(fvar, "Memory allocation error.");
-
-        fvar_filtered =
-            malloc(global_domain.ncells_active * sizeof(*fvar_filtered));
-        check_alloc_status(fvar_filtered, "Memory allocation error.");
-
-        fvar_mapped =
-            malloc(global_domain.ncells_active * sizeof(*fvar_mapped));
-        check_alloc_status(fvar_mapped, "Memory allocation error.");
-
-        get_nc_field_float(nc_name, var_name, start, count, fvar);
-        // filter the active cells only
-        map(sizeof(float), global_domain.ncells_active, filter_active_cells,
-            NULL,
-            fvar, fvar_filtered);
-        // map to prepare for MPI_Scatterv
-        map(sizeof(float), global_domain.ncells_active, mpi_map_mapping_array,
-            NULL,
-            fvar_filtered, fvar_mapped);
-        free(fvar);
-        free(fvar_filtered);
-    }
-
-    // Scatter the results to the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Scatterv(fvar_mapped, mpi_map_local_array_sizes,
-                          mpi_map_global_array_offsets, MPI_FLOAT,
-                          var, local_domain.ncells_active, MPI_FLOAT,
-                          VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        free(fvar_mapped);
-    }
+    get_scatter_nc_field(nc_name, var_name, NC_FLOAT, 1, start, count, NULL,
+                         var);
 }
 
 /******************************************************************************
@@ -2172,53 +3473,8 @@ get_scatter_nc_field_int(char   *nc_name,
                          size_t *count,
                          int    *var)
 {
-    extern MPI_Comm      MPI_COMM_VIC;
-    extern domain_struct global_domain;
-    extern domain_struct local_domain;
-    extern int           mpi_rank;
-    extern int          *mpi_map_global_array_offsets;
-    extern int          *mpi_map_local_array_sizes;
-    extern size_t       *filter_active_cells;
-    extern size_t       *mpi_map_mapping_array;
-    int                  status;
-    int                 *ivar = NULL;
-    int                 *ivar_filtered = NULL;
-    int                 *ivar_mapped = NULL;
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        ivar = malloc(global_domain.ncells_total * sizeof(*ivar));
-        check_alloc_status(ivar, "Memory allocation error.");
-        ivar_filtered =
-            malloc(global_domain.ncells_active * sizeof(*ivar_filtered));
-        check_alloc_status(ivar_filtered, "Memory allocation error.");
-
-        ivar_mapped =
-            malloc(global_domain.ncells_active * sizeof(*ivar_mapped));
-        check_alloc_status(ivar_mapped, "Memory allocation error.");
-
-        get_nc_field_int(nc_name, var_name, start, count, ivar);
-        // filter the active cells only
-        map(sizeof(int), global_domain.ncells_active, filter_active_cells, NULL,
-            ivar, ivar_filtered);
-        // map to prepare for MPI_Scatterv
-        map(sizeof(int), global_domain.ncells_active, mpi_map_mapping_array,
-            NULL,
-            ivar_filtered, ivar_mapped);
-        free(ivar);
-        free(ivar_filtered);
-    }
-
-    // Scatter the results to the nodes, result for the local node is in the
-    // array *var (which is a function argument)
-    status = MPI_Scatterv(ivar_mapped, mpi_map_local_array_sizes,
-                          mpi_map_global_array_offsets, MPI_INT,
-                          var, local_domain.ncells_active, MPI_INT,
-                          VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        free(ivar_mapped);
-    }
+    get_scatter_nc_field(nc_name, var_name, NC_INT, 1, start, count, NULL,
+                         var);
 }
 
 #ifdef VIC_MPI_SUPPORT_TEST
@@ -2230,9 +3486,10 @@ get_scatter_nc_field_int(char   *nc_name,
 // size_t              current;
 size_t *filter_active_cells = NULL;
 size_t *mpi_map_mapping_array = NULL;
+size_t *mpi_map_grid_array = NULL;
 // all_vars_struct    *all_vars = NULL;
 // force_data_struct  *force = NULL;
-// dmy_struct         *dmy = NULL;
+// dmy_struct          dmy_current;
 filenames_struct filenames;
 filep_struct     filep;
 domain_struct    global_domain;
@@ -106,6 +106,13 @@ set_nc_var_info(unsigned int       varid,
         nc_var->nc_counts[1] = nc_hist_file->nj_size;
         nc_var->nc_counts[2] = nc_hist_file->ni_size;
     }
+
+    // the two grid dimensions are replaced by the land dimension
+    if (nc_hist_file->land_size > 0) {
+        nc_var->nc_dims--;
+        nc_var->nc_counts[nc_var->nc_dims - 1] = nc_hist_file->land_size;
+        nc_var->nc_counts[nc_var->nc_dims] = 0;
+    }
 }
 
 /******************************************************************************
@@ -183,6 +190,17 @@ set_nc_var_dimids(unsigned int    varid,
         nc_var->nc_dimids[1] = nc_hist_file->nj_dimid;
         nc_var->nc_dimids[2] = nc_hist_file->ni_dimid;
     }
+
+    // the two grid dimensions are replaced by the land dimension
+    if (nc_hist_file->land_size > 0) {
+        for (i = 1; i < MAXDIMS - 1; i++) {
+            if (nc_var->nc_dimids[i] == nc_hist_file->nj_dimid) {
+                nc_var->nc_dimids[i] = nc_hist_file->land_dimid;
+                nc_var->nc_dimids[i + 1] = -1;
+                break;
+            }
+        }
+    }
 }
 
 /******************************************************************************
@@ -0,0 +1,615 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Parallel netCDF I/O: every node reads and writes its own cells.
+ *
+ * When PARALLEL_IO is TRUE, the forcing and history files are opened by all
+ * nodes with the parallel netCDF library. Instead of funneling the whole
+ * domain through the master node, each node transfers the rectangular
+ * hyperslabs that cover its own cells with collective calls.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+static par_io_struct par_io;
+
+/******************************************************************************
+ * @brief    Compare two locations by their index in the global list of cells.
+ *****************************************************************************/
+static int
+compare_global_idx(const void *a,
+                   const void *b)
+{
+    const location_struct *loc_a = (const location_struct *) a;
+    const location_struct *loc_b = (const location_struct *) b;
+
+    if (loc_a->global_idx < loc_b->global_idx) {
+        return -1;
+    }
+    else if (loc_a->global_idx > loc_b->global_idx) {
+        return 1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Add a slab to the list of slabs of the local node.
+ *****************************************************************************/
+static void
+add_par_io_slab(size_t y,
+                size_t x,
+                size_t ny,
+                size_t nx)
+{
+    size_t s = par_io.nslabs;
+
+    par_io.slab_start[2 * s] = y;
+    par_io.slab_start[2 * s + 1] = x;
+    par_io.slab_count[2 * s] = ny;
+    par_io.slab_count[2 * s + 1] = nx;
+    par_io.slab_offset[s] = par_io.nelem;
+    par_io.nelem += ny * nx;
+    par_io.nslabs++;
+}
+
+/******************************************************************************
+ * @brief    Cover the cells io_first ... io_last of the 1-D I/O array with at
+ *           most three slabs: a partial first row, a block of full rows and a
+ *           partial last row.
+ *****************************************************************************/
+static void
+add_par_io_segment(size_t io_first,
+                   size_t io_last)
+{
+    extern domain_struct global_domain;
+
+    size_t               nx = global_domain.n_nx;
+    size_t               y_first = io_first / nx;
+    size_t               x_first = io_first % nx;
+    size_t               y_last = io_last / nx;
+    size_t               x_last = io_last % nx;
+    size_t               y_begin;
+    size_t               y_end;
+
+    if (y_first == y_last) {
+        add_par_io_slab(y_first, x_first, 1, x_last - x_first + 1);
+        return;
+    }
+
+    // full rows are put into a single block
+    y_begin = y_first;
+    if (x_first > 0) {
+        add_par_io_slab(y_first, x_first, 1, nx - x_first);
+        y_begin++;
+    }
+    y_end = y_last + 1;
+    if (x_last < nx - 1) {
+        y_end--;
+    }
+    if (y_end > y_begin) {
+        add_par_io_slab(y_begin, 0, y_end - y_begin, nx);
+    }
+    if (x_last < nx - 1) {
+        add_par_io_slab(y_last, 0, 1, x_last + 1);
+    }
+}
+
+/******************************************************************************
+ * @brief    Set up the hyperslabs for parallel I/O.
+ * @details  Runs of local cells that are neighbors in the global list of
+ *           active cells are grouped into segments. The inactive cells
+ *           between them do not belong to any node, so that each segment can
+ *           be read and written as a whole. Contiguous decompositions
+ *           (DECOMPOSITION = COST_WEIGHTED) lead to a few large slabs per
+ *           node, round robin to one slab per cell.
+ *
+ *           The other nodes also receive the size and the description of the
+ *           global domain, which they need to define the history files.
+ *****************************************************************************/
+void
+initialize_par_io(void)
+{
+    extern domain_struct global_domain;
+    extern domain_struct local_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+
+    location_struct     *sorted = NULL;
+    size_t               first;
+    size_t               i;
+    size_t               j;
+    size_t               s;
+    size_t               s_first;
+    size_t               y;
+    size_t               x;
+    int                  status;
+
+    // broadcast the size and description of the global domain
+    status = MPI_Bcast(&(global_domain.ncells_total), 1, MPI_UNSIGNED_LONG,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(&(global_domain.ncells_active), 1, MPI_UNSIGNED_LONG,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(&(global_domain.n_nx), 1, MPI_UNSIGNED_LONG,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(&(global_domain.n_ny), 1, MPI_UNSIGNED_LONG,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Bcast(&(global_domain.info), sizeof(domain_info_struct),
+                       MPI_BYTE, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    // a segment contributes at most three slabs
+    par_io.nslabs = 0;
+    par_io.nelem = 0;
+    par_io.slab_start = malloc(3 * 2 * local_domain.ncells_active *
+                               sizeof(*(par_io.slab_start)));
+    check_alloc_status(par_io.slab_start, "Memory allocation error.");
+    par_io.slab_count = malloc(3 * 2 * local_domain.ncells_active *
+                               sizeof(*(par_io.slab_count)));
+    check_alloc_status(par_io.slab_count, "Memory allocation error.");
+    par_io.slab_offset = malloc(3 * local_domain.ncells_active *
+                                sizeof(*(par_io.slab_offset)));
+    check_alloc_status(par_io.slab_offset, "Memory allocation error.");
+    par_io.cell_slab = malloc(local_domain.ncells_active *
+                              sizeof(*(par_io.cell_slab)));
+    check_alloc_status(par_io.cell_slab, "Memory allocation error.");
+    par_io.cell_pos = malloc(local_domain.ncells_active *
+                             sizeof(*(par_io.cell_pos)));
+    check_alloc_status(par_io.cell_pos, "Memory allocation error.");
+
+    // sort the local cells in the order of the global list
+    sorted = malloc(local_domain.ncells_active * sizeof(*sorted));
+    check_alloc_status(sorted, "Memory allocation error.");
+    memcpy(sorted, local_domain.locations,
+           local_domain.ncells_active * sizeof(*sorted));
+    qsort(sorted, local_domain.ncells_active, sizeof(*sorted),
+          compare_global_idx);
+
+    for (first = 0; first < local_domain.ncells_active; first = i) {
+        // find the end of the segment
+        for (i = first + 1; i < local_domain.ncells_active; i++) {
+            if (sorted[i].global_idx != sorted[i - 1].global_idx + 1) {
+                break;
+            }
+        }
+        s_first = par_io.nslabs;
+        add_par_io_segment(sorted[first].io_idx, sorted[i - 1].io_idx);
+
+        // locate the cells of the segment in its slabs
+        for (j = first; j < i; j++) {
+            y = sorted[j].io_idx / global_domain.n_nx;
+            x = sorted[j].io_idx % global_domain.n_nx;
+            for (s = s_first; s < par_io.nslabs; s++) {
+                if (y >= par_io.slab_start[2 * s] &&
+                    y < par_io.slab_start[2 * s] + par_io.slab_count[2 * s] &&
+                    x >= par_io.slab_start[2 * s + 1] &&
+                    x < par_io.slab_start[2 * s + 1] +
+                    par_io.slab_count[2 * s + 1]) {
+                    break;
+                }
+            }
+            if (s == par_io.nslabs) {
+                log_err("Cell %zu is not covered by the parallel I/O slabs",
+                        sorted[j].global_idx);
+            }
+            par_io.cell_slab[sorted[j].local_idx] = s;
+            par_io.cell_pos[sorted[j].local_idx] =
+                (y - par_io.slab_start[2 * s]) * par_io.slab_count[2 * s + 1] +
+                (x - par_io.slab_start[2 * s + 1]);
+        }
+    }
+    free(sorted);
+
+    // all nodes take part in every collective call
+    status = MPI_Allreduce(&(par_io.nslabs), &(par_io.nslabs_max), 1,
+                           MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    debug("parallel I/O: %zu slabs, %zu elements on this node, %zu slabs max",
+          par_io.nslabs, par_io.nelem, par_io.nslabs_max);
+}
+
+/******************************************************************************
+ * @brief    Free the parallel I/O hyperslabs.
+ *****************************************************************************/
+void
+finalize_par_io(void)
+{
+    free(par_io.slab_start);
+    free(par_io.slab_count);
+    free(par_io.slab_offset);
+    free(par_io.cell_slab);
+    free(par_io.cell_pos);
+}
+
+/******************************************************************************
+ * @brief    Create a netCDF file for parallel access by all nodes.
+ *****************************************************************************/
+void
+create_par_nc_file(char *nc_name,
+                   int   cmode,
+                   int  *nc_id)
+{
+#ifdef VIC_PARALLEL_IO
+    extern MPI_Comm MPI_COMM_VIC;
+
+    int             status;
+
+    status = nc_create_par(nc_name, cmode | NC_MPIIO, MPI_COMM_VIC,
+                           MPI_INFO_NULL, nc_id);
+    check_nc_status(status, "Error creating %s", nc_name);
+#else
+    log_err("Cannot create %s: VIC was compiled against a netCDF library "
+            "without parallel I/O support", nc_name);
+#endif
+}
+
+/******************************************************************************
+ * @brief    Open a netCDF file for parallel read access by all nodes.
+ *****************************************************************************/
+void
+open_par_nc_file(char *nc_name,
+                 int  *nc_id)
+{
+#ifdef VIC_PARALLEL_IO
+    extern MPI_Comm MPI_COMM_VIC;
+
+    int             status;
+
+    status = nc_open_par(nc_name, NC_NOWRITE | NC_MPIIO, MPI_COMM_VIC,
+                         MPI_INFO_NULL, nc_id);
+    check_nc_status(status, "Error opening %s", nc_name);
+#else
+    log_err("Cannot open %s: VIC was compiled against a netCDF library "
+            "without parallel I/O support", nc_name);
+#endif
+}
+
+/******************************************************************************
+ * @brief    Switch a netCDF variable to collective access.
+ *****************************************************************************/
+void
+set_par_nc_var_collective(int nc_id,
+                          int var_id)
+{
+#ifdef VIC_PARALLEL_IO
+    int status;
+
+    status = nc_var_par_access(nc_id, var_id, NC_COLLECTIVE);
+    check_nc_status(status, "Error setting collective access.");
+#else
+    log_err("VIC was compiled against a netCDF library without parallel "
+            "I/O support");
+#endif
+}
+
+/******************************************************************************
+ * @brief    Set the start and count of slab s of a hyperslab whose last two
+ *           dimensions are the domain grid. Nodes with fewer than nslabs_max
+ *           slabs take part in the remaining collective calls with an empty
+ *           hyperslab.
+ *****************************************************************************/
+static void
+set_par_io_slab(size_t  s,
+                int     ndims,
+                size_t *start,
+                size_t *count,
+                size_t *slab_start,
+                size_t *slab_count)
+{
+    int i;
+
+    for (i = 0; i < ndims; i++) {
+        slab_start[i] = start[i];
+        slab_count[i] = count[i];
+    }
+    if (s < par_io.nslabs) {
+        slab_start[ndims - 2] = par_io.slab_start[2 * s];
+        slab_start[ndims - 1] = par_io.slab_start[2 * s + 1];
+        slab_count[ndims - 2] = par_io.slab_count[2 * s];
+        slab_count[ndims - 1] = par_io.slab_count[2 * s + 1];
+    }
+    else {
+        slab_start[ndims - 2] = 0;
+        slab_start[ndims - 1] = 0;
+        for (i = 0; i < ndims; i++) {
+            slab_count[i] = 0;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Write a netCDF field in parallel. nc_type is the type of var.
+ *****************************************************************************/
+static void
+put_par_nc_field(int     nc_id,
+                 int     var_id,
+                 nc_type xtype,
+                 size_t  size,
+                 void   *fillval,
+                 size_t *start,
+                 size_t *count,
+                 void   *var)
+{
+    extern domain_struct local_domain;
+
+    char                *buf = NULL;
+    char                *slab;
+    size_t               slab_start[MAXDIMS];
+    size_t               slab_count[MAXDIMS];
+    size_t               i;
+    size_t               s;
+    int                  ndims;
+    int                  status;
+
+    status = nc_inq_varndims(nc_id, var_id, &ndims);
+    check_nc_status(status, "Error getting number of dimensions");
+
+    // inactive cells in the slabs get the fill value
+    buf = malloc((par_io.nelem + 1) * size);
+    check_alloc_status(buf, "Memory allocation error.");
+    for (i = 0; i < par_io.nelem; i++) {
+        memcpy(buf + i * size, fillval, size);
+    }
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        memcpy(buf + (par_io.slab_offset[par_io.cell_slab[i]] +
+                      par_io.cell_pos[i]) * size,
+               (char *) var + i * size, size);
+    }
+
+    set_par_nc_var_collective(nc_id, var_id);
+    for (s = 0; s < par_io.nslabs_max; s++) {
+        set_par_io_slab(s, ndims, start, count, slab_start, slab_count);
+        slab = buf;
+        if (s < par_io.nslabs) {
+            slab += par_io.slab_offset[s] * size;
+        }
+        if (xtype == NC_DOUBLE) {
+            status = nc_put_vara_double(nc_id, var_id, slab_start, slab_count,
+                                        (double *) slab);
+        }
+        else if (xtype == NC_FLOAT) {
+            status = nc_put_vara_float(nc_id, var_id, slab_start, slab_count,
+                                       (float *) slab);
+        }
+        else if (xtype == NC_INT) {
+            status = nc_put_vara_int(nc_id, var_id, slab_start, slab_count,
+                                     (int *) slab);
+        }
+        else if (xtype == NC_SHORT) {
+            status = nc_put_vara_short(nc_id, var_id, slab_start, slab_count,
+                                       (short int *) slab);
+        }
+        else {
+            status = nc_put_vara_schar(nc_id, var_id, slab_start, slab_count,
+                                       (signed char *) slab);
+        }
+        check_nc_status(status, "Error writing values.");
+    }
+
+    free(buf);
+}
+
+/******************************************************************************
+ * @brief    Write double precision NetCDF field in parallel
+ * @details  Parallel counterpart of gather_put_nc_field_double(). Must be
+ *           called by all nodes.
+ *****************************************************************************/
+void
+put_par_nc_field_double(int     nc_id,
+                        int     var_id,
+                        double  fillval,
+                        size_t *start,
+                        size_t *count,
+                        double *var)
+{
+    put_par_nc_field(nc_id, var_id, NC_DOUBLE, sizeof(*var), &fillval, start,
+                     count, var);
+}
+
+/******************************************************************************
+ * @brief    Write single precision NetCDF field in parallel
+ * @details  Parallel counterpart of gather_put_nc_field_float(). Must be
+ *           called by all nodes.
+ *****************************************************************************/
+void
+put_par_nc_field_float(int     nc_id,
+                       int     var_id,
+                       float   fillval,
+                       size_t *start,
+                       size_t *count,
+                       float  *var)
+{
+    put_par_nc_field(nc_id, var_id, NC_FLOAT, sizeof(*var), &fillval, start,
+                     count, var);
+}
+
+/******************************************************************************
+ * @brief    Write integer NetCDF field in parallel
+ * @details  Parallel counterpart of gather_put_nc_field_int(). Must be
+ *           called by all nodes.
+ *****************************************************************************/
+void
+put_par_nc_field_int(int     nc_id,
+                     int     var_id,
+                     int     fillval,
+                     size_t *start,
+                     size_t *count,
+                     int    *var)
+{
+    put_par_nc_field(nc_id, var_id, NC_INT, sizeof(*var), &fillval, start,
+                     count, var);
+}
+
+/******************************************************************************
+ * @brief    Write short integer NetCDF field in parallel
+ * @details  Parallel counterpart of gather_put_nc_field_short(). Must be
+ *           called by all nodes.
+ *****************************************************************************/
+void
+put_par_nc_field_short(int        nc_id,
+                       int        var_id,
+                       short int  fillval,
+                       size_t    *start,
+                       size_t    *count,
+                       short int *var)
+{
+    put_par_nc_field(nc_id, var_id, NC_SHORT, sizeof(*var), &fillval, start,
+                     count, var);
+}
+
+/******************************************************************************
+ * @brief    Write signed character NetCDF field in parallel
+ * @details  Parallel counterpart of gather_put_nc_field_schar(). Must be
+ *           called by all nodes.
+ *****************************************************************************/
+void
+put_par_nc_field_schar(int     nc_id,
+                       int     var_id,
+                       char    fillval,
+                       size_t *start,
+                       size_t *count,
+                       char   *var)
+{
+    put_par_nc_field(nc_id, var_id, NC_BYTE, sizeof(*var), &fillval, start,
+                     count, var);
+}
+
+/******************************************************************************
+ * @brief    Read a netCDF field in parallel. nc_type is the type of var.
+ * @details  All dimensions except the last two (the domain grid) are treated
+ *           as slices, so that on return var[j * ncells + i] holds slice j of
+ *           local cell i. Each node only reads the slabs that cover its own
+ *           cells.
+ *****************************************************************************/
+static void
+get_par_nc_field(char   *nc_name,
+                 char   *var_name,
+                 nc_type xtype,
+                 size_t  size,
+                 size_t *start,
+                 size_t *count,
+                 void   *var)
+{
+    extern domain_struct local_domain;
+
+    char                *buf = NULL;
+    char                *slab;
+    size_t               slab_start[MAXDIMS];
+    size_t               slab_count[MAXDIMS];
+    size_t               nsteps;
+    size_t               area;
+    size_t               i;
+    size_t               j;
+    size_t               s;
+    int                  nc_id;
+    int                  var_id;
+    int                  ndims;
+    int                  k;
+    int                  status;
+
+    nc_id = get_par_nc_file_id(nc_name);
+
+    status = nc_inq_varid(nc_id, var_name, &var_id);
+    check_nc_status(status, "Error getting variable id for %s in %s",
+                    var_name, nc_name);
+    status = nc_inq_varndims(nc_id, var_id, &ndims);
+    check_nc_status(status, "Error getting number of dimensions for %s in %s",
+                    var_name, nc_name);
+
+    nsteps = 1;
+    for (k = 0; k < ndims - 2; k++) {
+        nsteps *= count[k];
+    }
+
+    // slab s holds nsteps consecutive slices
+    buf = malloc((nsteps * par_io.nelem + 1) * size);
+    check_alloc_status(buf, "Memory allocation error.");
+
+    set_par_nc_var_collective(nc_id, var_id);
+    for (s = 0; s < par_io.nslabs_max; s++) {
+        set_par_io_slab(s, ndims, start, count, slab_start, slab_count);
+        slab = buf;
+        if (s < par_io.nslabs) {
+            slab += nsteps * par_io.slab_offset[s] * size;
+        }
+        if (xtype == NC_DOUBLE) {
+            status = nc_get_vara_double(nc_id, var_id, slab_start, slab_count,
+                                        (double *) slab);
+        }
+        else {
+            status = nc_get_vara_int(nc_id, var_id, slab_start, slab_count,
+                                     (int *) slab);
+        }
+        check_nc_status(status, "Error getting values for %s in %s",
+                        var_name, nc_name);
+    }
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        s = par_io.cell_slab[i];
+        area = par_io.slab_count[2 * s] * par_io.slab_count[2 * s + 1];
+        for (j = 0; j < nsteps; j++) {
+            memcpy((char *) var + (j * local_domain.ncells_active + i) * size,
+                   buf + (nsteps * par_io.slab_offset[s] + j * area +
+                          par_io.cell_pos[i]) * size, size);
+        }
+    }
+
+    free(buf);
+}
+
+/******************************************************************************
+ * @brief    Read several time steps of a double precision NetCDF field in
+ *           parallel
+ * @details  Parallel counterpart of get_scatter_nc_field_double_steps(). Must
+ *           be called by all nodes. All dimensions except the last two (the
+ *           domain grid) are treated as time slices, so that on return
+ *           var[j * ncells + i] holds slice j of local cell i.
+ *****************************************************************************/
+void
+get_par_nc_field_double_steps(char   *nc_name,
+                              char   *var_name,
+                              size_t *start,
+                              size_t *count,
+                              double *var)
+{
+    get_par_nc_field(nc_name, var_name, NC_DOUBLE, sizeof(*var), start, count,
+                     var);
+}
+
+/******************************************************************************
+ * @brief    Read several slices of an integer NetCDF field in parallel
+ * @details  Integer counterpart of get_par_nc_field_double_steps().
+ *****************************************************************************/
+void
+get_par_nc_field_int_steps(char   *nc_name,
+                           char   *var_name,
+                           size_t *start,
+                           size_t *count,
+                           int    *var)
+{
+    get_par_nc_field(nc_name, var_name, NC_INT, sizeof(*var), start, count,
+                     var);
+}
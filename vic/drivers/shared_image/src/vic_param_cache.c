@@ -0,0 +1,481 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Save and restore the initialized model parameters in a parameter cache.
+ *
+ * Every process writes the parameter structures of its own cells, after the
+ * parameters have been read from the parameter file and the derived
+ * parameters have been computed, to a file of its own. A later run with the
+ * same parameter and domain files, decomposition, options, constants and
+ * build restores the structures from these files instead of reading and
+ * processing the parameter file again.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+#include <sys/stat.h>
+
+static param_cache_header_struct param_cache_header;
+
+/******************************************************************************
+ * @brief    Add nbytes of ptr to a 64-bit FNV-1a hash.
+ *****************************************************************************/
+static unsigned long long
+hash_param_cache(unsigned long long hash,
+                 const void        *ptr,
+                 size_t             nbytes)
+{
+    const unsigned char *bytes = (const unsigned char *) ptr;
+    size_t               i;
+
+    for (i = 0; i < nbytes; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/******************************************************************************
+ * @brief    Hash the name, size, inode and modification time of an input
+ *           file.
+ * @details  The file contents are not read: a file that is replaced or
+ *           modified gets a new modification time.
+ *****************************************************************************/
+static unsigned long long
+hash_param_cache_file(unsigned long long hash,
+                      char              *filename)
+{
+    struct stat        st;
+    unsigned long long values[3];
+
+    if (stat(filename, &st) != 0) {
+        log_err("Unable to stat %s", filename);
+    }
+    values[0] = (unsigned long long) st.st_size;
+    values[1] = (unsigned long long) st.st_ino;
+    values[2] = (unsigned long long) st.st_mtime;
+
+    hash = hash_param_cache(hash, filename, strlen(filename));
+
+    return hash_param_cache(hash, values, sizeof(values));
+}
+
+/******************************************************************************
+ * @brief    Fill the header of the parameter cache file of the local node.
+ * @details  The input files are checked by the master node and the hash is
+ *           broadcast, so all nodes must call this function.
+ *****************************************************************************/
+static void
+set_param_cache_header(param_cache_header_struct *header)
+{
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern filenames_struct    filenames;
+    extern option_struct       options;
+    extern parameters_struct   param;
+    extern veg_con_map_struct *veg_con_map;
+    extern int                 mpi_rank;
+    extern int                 mpi_size;
+    extern MPI_Comm            MPI_COMM_VIC;
+
+    unsigned long long         hash;
+    size_t                     values[3];
+    size_t                     i;
+    int                        status;
+
+    memset(header, 0, sizeof(*header));
+    strncpy(header->magic, PARAM_CACHE_MAGIC, sizeof(header->magic));
+    header->version = PARAM_CACHE_VERSION;
+    header->mpi_rank = mpi_rank;
+    header->mpi_size = mpi_size;
+    header->ncells = local_domain.ncells_active;
+
+    // global index and number of vegetation tiles of the local cells
+    values[0] = global_domain.ncells_active;
+    values[1] = global_domain.n_nx;
+    values[2] = global_domain.n_ny;
+    hash = hash_param_cache(14695981039346656037ULL, values, sizeof(values));
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        values[0] = local_domain.locations[i].global_idx;
+        values[1] = veg_con_map[i].nv_active;
+        hash = hash_param_cache(hash, values, 2 * sizeof(*values));
+        header->nv_total += veg_con_map[i].nv_active;
+    }
+    header->domain_hash = hash;
+
+    // parameter and domain files
+    if (mpi_rank == VIC_MPI_ROOT) {
+        hash = hash_param_cache_file(14695981039346656037ULL,
+                                     filenames.params);
+        hash = hash_param_cache_file(hash, filenames.domain);
+    }
+    status = MPI_Bcast(&hash, 1, MPI_UNSIGNED_LONG_LONG, VIC_MPI_ROOT,
+                       MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    header->input_hash = hash;
+
+    // any change of the options or constants invalidates the cache
+    hash = hash_param_cache(14695981039346656037ULL, &options,
+                            sizeof(options));
+    header->options_hash = hash_param_cache(hash, &param, sizeof(param));
+
+    header->soil_con_size = sizeof(soil_con_struct);
+    header->veg_con_size = sizeof(veg_con_struct);
+    header->veg_lib_size = sizeof(veg_lib_struct);
+    header->lake_con_size = sizeof(lake_con_struct);
+}
+
+/******************************************************************************
+ * @brief    Write n items to a parameter cache file.
+ *****************************************************************************/
+static void
+write_param_cache_items(const void *ptr,
+                        size_t      size,
+                        size_t      n,
+                        FILE       *fp,
+                        char       *filename)
+{
+    if (fwrite(ptr, size, n, fp) != n) {
+        log_err("Error writing parameter cache file %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read n items from a parameter cache file.
+ *****************************************************************************/
+static void
+read_param_cache_items(void   *ptr,
+                       size_t  size,
+                       size_t  n,
+                       FILE   *fp,
+                       char   *filename)
+{
+    if (fread(ptr, size, n, fp) != n) {
+        log_err("Error reading parameter cache file %s, the file is "
+                "truncated", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read the parameter structures of the local cells from a
+ *           parameter cache file.
+ * @details  The structures are copied into the arrays allocated by
+ *           vic_alloc(), their pointers are kept. The vegetation libraries
+ *           are shared again by share_veg_lib().
+ *****************************************************************************/
+static void
+read_param_cache_data(FILE *fp,
+                      char *filename)
+{
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_map_struct *veg_con_map;
+    extern veg_con_struct    **veg_con;
+    extern veg_lib_struct    **veg_lib;
+    extern lake_con_struct    *lake_con;
+
+    soil_con_struct            tmp_soil_con;
+    veg_con_struct             tmp_veg_con;
+    veg_lib_struct            *tables;
+    size_t                    *index;
+    size_t                     ncells;
+    size_t                     nv_total;
+    size_t                     ntables;
+    size_t                     i;
+    size_t                     j;
+
+    ncells = local_domain.ncells_active;
+    nv_total = param_cache_header.nv_total;
+
+    // soil parameters and snow bands
+    for (i = 0; i < ncells; i++) {
+        read_param_cache_items(&tmp_soil_con, sizeof(tmp_soil_con), 1, fp,
+                               filename);
+        tmp_soil_con.BandElev = soil_con[i].BandElev;
+        tmp_soil_con.AreaFract = soil_con[i].AreaFract;
+        tmp_soil_con.Pfactor = soil_con[i].Pfactor;
+        tmp_soil_con.Tfactor = soil_con[i].Tfactor;
+        tmp_soil_con.AboveTreeLine = soil_con[i].AboveTreeLine;
+        soil_con[i] = tmp_soil_con;
+    }
+    read_param_cache_items(soil_con[0].BandElev, sizeof(double),
+                           ncells * options.SNOW_BAND, fp, filename);
+    read_param_cache_items(soil_con[0].AreaFract, sizeof(double),
+                           ncells * options.SNOW_BAND, fp, filename);
+    read_param_cache_items(soil_con[0].Pfactor, sizeof(double),
+                           ncells * options.SNOW_BAND, fp, filename);
+    read_param_cache_items(soil_con[0].Tfactor, sizeof(double),
+                           ncells * options.SNOW_BAND, fp, filename);
+    read_param_cache_items(soil_con[0].AboveTreeLine, sizeof(bool),
+                           ncells * options.SNOW_BAND, fp, filename);
+
+    // vegetation mapping
+    read_param_cache_items(veg_con_map[0].vidx, sizeof(int),
+                           ncells * options.NVEGTYPES, fp, filename);
+    read_param_cache_items(veg_con_map[0].Cv, sizeof(double),
+                           ncells * options.NVEGTYPES, fp, filename);
+    for (i = 0; i < ncells; i++) {
+        veg_con_map[i].nv_classes = 0;
+        for (j = 0; j < options.NVEGTYPES; j++) {
+            if (veg_con_map[i].vidx[j] != NODATA_VEG) {
+                veg_con_map[i].nv_classes++;
+            }
+        }
+    }
+
+    // vegetation tiles
+    for (i = 0; i < nv_total; i++) {
+        read_param_cache_items(&tmp_veg_con, sizeof(tmp_veg_con), 1, fp,
+                               filename);
+        tmp_veg_con.zone_depth = veg_con[0][i].zone_depth;
+        tmp_veg_con.zone_fract = veg_con[0][i].zone_fract;
+        tmp_veg_con.CanopLayerBnd = veg_con[0][i].CanopLayerBnd;
+        veg_con[0][i] = tmp_veg_con;
+    }
+    read_param_cache_items(veg_con[0][0].zone_depth, sizeof(double),
+                           nv_total * options.ROOT_ZONES, fp, filename);
+    read_param_cache_items(veg_con[0][0].zone_fract, sizeof(double),
+                           nv_total * options.ROOT_ZONES, fp, filename);
+    if (options.CARBON) {
+        read_param_cache_items(veg_con[0][0].CanopLayerBnd, sizeof(double),
+                               nv_total * options.Ncanopy, fp, filename);
+    }
+
+    // distinct vegetation libraries and the library of each cell
+    read_param_cache_items(&ntables, sizeof(ntables), 1, fp, filename);
+    if (ntables == 0 || ntables > ncells) {
+        log_err("Parameter cache file %s holds %zu vegetation libraries for "
+                "%zu grid cells", filename, ntables, ncells);
+    }
+    tables = malloc(ntables * options.NVEGTYPES * sizeof(*tables));
+    check_alloc_status(tables, "Memory allocation error.");
+    index = malloc(ncells * sizeof(*index));
+    check_alloc_status(index, "Memory allocation error.");
+    read_param_cache_items(tables, sizeof(*tables),
+                           ntables * options.NVEGTYPES, fp, filename);
+    read_param_cache_items(index, sizeof(*index), ncells, fp, filename);
+    for (i = 0; i < ncells; i++) {
+        if (index[i] >= ntables) {
+            log_err("Parameter cache file %s refers to vegetation library "
+                    "%zu of %zu", filename, index[i], ntables);
+        }
+        memcpy(veg_lib[i], tables + index[i] * options.NVEGTYPES,
+               options.NVEGTYPES * sizeof(*tables));
+    }
+    free(tables);
+    free(index);
+    share_veg_lib();
+
+    // lakes
+    if (options.LAKES) {
+        read_param_cache_items(lake_con, sizeof(*lake_con), ncells, fp,
+                               filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Restore the model parameters from the parameter cache.
+ * @details  Every node checks its own file filenames.param_cache.<rank>.
+ *           The parameters are only restored if the files of all nodes match
+ *           this run, otherwise they have to be read from the parameter file
+ *           by all nodes. Nodes without active cells (e.g. I/O servers) do
+ *           not have a file. Must be called by all nodes.
+ *
+ * @return   TRUE if the parameters were restored
+ *****************************************************************************/
+bool
+read_param_cache(void)
+{
+    extern domain_struct      local_domain;
+    extern filenames_struct   filenames;
+    extern int                mpi_rank;
+    extern MPI_Comm           MPI_COMM_VIC;
+
+    char                      filename[MAXSTRING];
+    FILE                     *fp = NULL;
+    param_cache_header_struct header;
+    int                       valid;
+    int                       all_valid;
+    int                       status;
+
+    if (strcasecmp(filenames.param_cache, "MISSING") == 0) {
+        return false;
+    }
+
+    set_param_cache_header(&param_cache_header);
+
+    valid = 1;
+    if (local_domain.ncells_active > 0) {
+        snprintf(filename, MAXSTRING, "%s.%04d", filenames.param_cache,
+                 mpi_rank);
+        fp = fopen(filename, "rb");
+        if (fp == NULL) {
+            debug("No parameter cache file %s", filename);
+            valid = 0;
+        }
+        else if (fread(&header, sizeof(header), 1, fp) != 1 ||
+                 memcmp(&header, &param_cache_header, sizeof(header)) != 0) {
+            debug("Parameter cache file %s does not match this run",
+                  filename);
+            valid = 0;
+        }
+    }
+
+    status = MPI_Allreduce(&valid, &all_valid, 1, MPI_INT, MPI_MIN,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    if (!all_valid) {
+        if (fp != NULL && fclose(fp) != 0) {
+            log_err("Error closing parameter cache file %s", filename);
+        }
+        if (mpi_rank == VIC_MPI_ROOT) {
+            log_info("Parameter cache %s is missing or out of date, reading "
+                     "the parameters from %s", filenames.param_cache,
+                     filenames.params);
+        }
+        return false;
+    }
+
+    if (fp != NULL) {
+        read_param_cache_data(fp, filename);
+        if (fclose(fp) != 0) {
+            log_err("Error closing parameter cache file %s", filename);
+        }
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        log_info("Restored the parameters from the parameter cache %s",
+                 filenames.param_cache);
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Write the model parameters of the local cells to the parameter
+ *           cache.
+ * @details  Called after read_param_cache() found no valid cache and the
+ *           parameters have been read. The local node writes
+ *           filenames.param_cache.<rank>; the file is written under a
+ *           temporary name and renamed when it is complete, so a run that
+ *           is interrupted does not leave a partial cache behind.
+ *****************************************************************************/
+void
+write_param_cache(void)
+{
+    extern domain_struct       local_domain;
+    extern filenames_struct    filenames;
+    extern option_struct       options;
+    extern soil_con_struct    *soil_con;
+    extern veg_con_map_struct *veg_con_map;
+    extern veg_con_struct    **veg_con;
+    extern lake_con_struct    *lake_con;
+    extern int                 mpi_rank;
+
+    char                       filename[MAXSTRING];
+    char                       tmp_filename[MAXSTRING];
+    FILE                      *fp;
+    veg_lib_struct           **tables;
+    size_t                    *index;
+    size_t                     ncells;
+    size_t                     nv_total;
+    size_t                     ntables;
+    size_t                     i;
+
+    if (strcasecmp(filenames.param_cache, "MISSING") == 0 ||
+        local_domain.ncells_active == 0) {
+        return;
+    }
+
+    ncells = local_domain.ncells_active;
+    nv_total = param_cache_header.nv_total;
+
+    snprintf(filename, MAXSTRING, "%s.%04d", filenames.param_cache,
+             mpi_rank);
+    snprintf(tmp_filename, MAXSTRING, "%s.tmp", filename);
+    fp = fopen(tmp_filename, "wb");
+    if (fp == NULL) {
+        log_err("Unable to open parameter cache file %s", tmp_filename);
+    }
+
+    write_param_cache_items(&param_cache_header, sizeof(param_cache_header),
+                            1, fp, tmp_filename);
+
+    // soil parameters and snow bands
+    write_param_cache_items(soil_con, sizeof(*soil_con), ncells, fp,
+                            tmp_filename);
+    write_param_cache_items(soil_con[0].BandElev, sizeof(double),
+                            ncells * options.SNOW_BAND, fp, tmp_filename);
+    write_param_cache_items(soil_con[0].AreaFract, sizeof(double),
+                            ncells * options.SNOW_BAND, fp, tmp_filename);
+    write_param_cache_items(soil_con[0].Pfactor, sizeof(double),
+                            ncells * options.SNOW_BAND, fp, tmp_filename);
+    write_param_cache_items(soil_con[0].Tfactor, sizeof(double),
+                            ncells * options.SNOW_BAND, fp, tmp_filename);
+    write_param_cache_items(soil_con[0].AboveTreeLine, sizeof(bool),
+                            ncells * options.SNOW_BAND, fp, tmp_filename);
+
+    // vegetation mapping
+    write_param_cache_items(veg_con_map[0].vidx, sizeof(int),
+                            ncells * options.NVEGTYPES, fp, tmp_filename);
+    write_param_cache_items(veg_con_map[0].Cv, sizeof(double),
+                            ncells * options.NVEGTYPES, fp, tmp_filename);
+
+    // vegetation tiles
+    write_param_cache_items(veg_con[0], sizeof(veg_con_struct), nv_total, fp,
+                            tmp_filename);
+    write_param_cache_items(veg_con[0][0].zone_depth, sizeof(double),
+                            nv_total * options.ROOT_ZONES, fp, tmp_filename);
+    write_param_cache_items(veg_con[0][0].zone_fract, sizeof(double),
+                            nv_total * options.ROOT_ZONES, fp, tmp_filename);
+    if (options.CARBON) {
+        write_param_cache_items(veg_con[0][0].CanopLayerBnd, sizeof(double),
+                                nv_total * options.Ncanopy, fp,
+                                tmp_filename);
+    }
+
+    // distinct vegetation libraries and the library of each cell
+    ntables = get_veg_lib_tables(&tables, &index);
+    write_param_cache_items(&ntables, sizeof(ntables), 1, fp, tmp_filename);
+    for (i = 0; i < ntables; i++) {
+        write_param_cache_items(tables[i], sizeof(veg_lib_struct),
+                                options.NVEGTYPES, fp, tmp_filename);
+    }
+    write_param_cache_items(index, sizeof(*index), ncells, fp, tmp_filename);
+
+    // lakes
+    if (options.LAKES) {
+        write_param_cache_items(lake_con, sizeof(*lake_con), ncells, fp,
+                                tmp_filename);
+    }
+
+    if (fclose(fp) != 0) {
+        log_err("Error closing parameter cache file %s", tmp_filename);
+    }
+    if (rename(tmp_filename, filename) != 0) {
+        log_err("Unable to rename parameter cache file %s to %s",
+                tmp_filename, filename);
+    }
+}
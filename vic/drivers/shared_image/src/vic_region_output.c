@@ -0,0 +1,586 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Region streams.
+ *
+ * With OUTREGION, an output stream holds the area weighted means (or sums)
+ * of its variables over regions, e.g. basins or administrative units,
+ * instead of the values of the cells. The region of each cell is an integer
+ * variable of the domain file, cells with a region ID of 0 or less belong to
+ * no region. The stream aggregates the cells of the regions in time as any
+ * other stream. When a record is complete, every node reduces its cells to
+ * one value per region and the partial sums are added on the master node
+ * with MPI_Reduce, which writes a small file along a region dimension
+ * instead of the full grid.
+ *
+ * With REPRODUCIBLE, the sums of the regions are exact: each value is added
+ * to an integer in units of 2^-1074 (the smallest double), held as signed
+ * 32-bit digits, and the digits are added with MPI_Reduce over integers.
+ * Integer sums do not depend on their order, so the values of the regions
+ * are the same for any number of processes and any decomposition, and they
+ * are rounded to a double only once on the master node.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+/******************************************************************************
+ * @brief    Compare two region IDs.
+ *****************************************************************************/
+static int
+compare_region_ids(const void *a,
+                   const void *b)
+{
+    const int *x = a;
+    const int *y = b;
+
+    if (*x < *y) {
+        return -1;
+    }
+    return (*x > *y);
+}
+
+/******************************************************************************
+ * @brief    Number of aggregated values per cell of a stream.
+ *****************************************************************************/
+static size_t
+get_region_nelem(stream_struct *stream)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 nelem;
+    size_t                 j;
+
+    nelem = 0;
+    for (j = 0; j < stream->nvars; j++) {
+        nelem += out_metadata[stream->varid[j]].nelem;
+    }
+
+    return nelem;
+}
+
+/******************************************************************************
+ * @brief    Add a value to an exact sum.
+ * @details  The 53-bit significand of the value is added at the position of
+ *           its exponent, spread over up to three digits. A digit may grow
+ *           beyond 32 bits until normalize_exact_sum() propagates the
+ *           carries, which leaves room for 2^31 values. Values that are not
+ *           finite are added to special instead.
+ *****************************************************************************/
+static void
+add_exact_sum(int64_t *words,
+              double   value,
+              double  *special)
+{
+    uint64_t bits;
+    uint64_t mant;
+    int64_t  digits[3];
+    unsigned expo;
+    size_t   w;
+    unsigned s;
+
+    if (!isfinite(value)) {
+        *special += value;
+        return;
+    }
+
+    memcpy(&bits, &value, sizeof(bits));
+    expo = (unsigned) ((bits >> 52) & 0x7ff);
+    mant = bits & 0xfffffffffffffULL;
+    if (expo > 0) {
+        mant |= 1ULL << 52;
+    }
+    else {
+        // subnormal numbers have the exponent of the smallest normal number
+        expo = 1;
+    }
+    if (mant == 0) {
+        return;
+    }
+
+    // the value is mant * 2^(expo - 1) in units of 2^-1074
+    w = (expo - 1) / 32;
+    s = (expo - 1) % 32;
+    digits[0] = (int64_t) ((mant << s) & 0xffffffffULL);
+    if (s == 0) {
+        digits[1] = (int64_t) (mant >> 32);
+        digits[2] = 0;
+    }
+    else {
+        digits[1] = (int64_t) ((mant >> (32 - s)) & 0xffffffffULL);
+        digits[2] = (int64_t) (mant >> (64 - s));
+    }
+    if (bits >> 63) {
+        words[w] -= digits[0];
+        words[w + 1] -= digits[1];
+        words[w + 2] -= digits[2];
+    }
+    else {
+        words[w] += digits[0];
+        words[w + 1] += digits[1];
+        words[w + 2] += digits[2];
+    }
+}
+
+/******************************************************************************
+ * @brief    Propagate the carries of an exact sum.
+ * @details  All digits but the last are in [0, 2^32) afterwards, the last
+ *           digit holds the sign of the sum.
+ *****************************************************************************/
+static void
+normalize_exact_sum(int64_t *words)
+{
+    int64_t low;
+    size_t  w;
+
+    for (w = 0; w < REGION_EXACT_NWORDS - 1; w++) {
+        low = (int64_t) ((uint64_t) words[w] & 0xffffffffULL);
+        words[w + 1] += (words[w] - low) / 4294967296LL;
+        words[w] = low;
+    }
+}
+
+/******************************************************************************
+ * @brief    Round an exact sum to a double.
+ * @details  The sum is changed. The result depends on the digits only, and
+ *           it is within one unit in the last place of the exact sum.
+ *****************************************************************************/
+static double
+get_exact_sum(int64_t *words)
+{
+    double value;
+    bool   negative;
+    size_t w;
+    int    e;
+
+    normalize_exact_sum(words);
+    negative = words[REGION_EXACT_NWORDS - 1] < 0;
+    if (negative) {
+        for (w = 0; w < REGION_EXACT_NWORDS; w++) {
+            words[w] = -words[w];
+        }
+        normalize_exact_sum(words);
+    }
+
+    for (w = REGION_EXACT_NWORDS; w > 0; w--) {
+        if (words[w - 1] != 0) {
+            break;
+        }
+    }
+    if (w == 0) {
+        return 0.;
+    }
+
+    // the three highest digits hold more than the 53 bits of a double, and
+    // they are added from the lowest one
+    w--;
+    e = 32 * (int) w - 1074;
+    value = 0.;
+    if (w > 1) {
+        value += ldexp((double) words[w - 2], e - 64);
+    }
+    if (w > 0) {
+        value += ldexp((double) words[w - 1], e - 32);
+    }
+    value += ldexp((double) words[w], e);
+
+    return negative ? -value : value;
+}
+
+/******************************************************************************
+ * @brief    Reduce the exact sums of all nodes to doubles on the master node.
+ * @details  special holds the sums of the values that are not finite, which
+ *           take the place of the exact sums in values.
+ *****************************************************************************/
+static void
+reduce_exact_sums(size_t   n,
+                  int64_t *exact,
+                  double  *special,
+                  double  *values)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+    extern int      mpi_rank;
+
+    size_t          i;
+    int             status;
+
+    for (i = 0; i < n; i++) {
+        normalize_exact_sum(exact + i * REGION_EXACT_NWORDS);
+    }
+
+    status = MPI_Reduce(special, values, (int) n, MPI_DOUBLE, MPI_SUM,
+                        VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (mpi_rank == VIC_MPI_ROOT) {
+        status = MPI_Reduce(MPI_IN_PLACE, exact,
+                            (int) (n * REGION_EXACT_NWORDS), MPI_INT64_T,
+                            MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+    }
+    else {
+        status = MPI_Reduce(exact, NULL, (int) (n * REGION_EXACT_NWORDS),
+                            MPI_INT64_T, MPI_SUM, VIC_MPI_ROOT,
+                            MPI_COMM_VIC);
+    }
+    check_mpi_status(status, "MPI error.");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        for (i = 0; i < n; i++) {
+            if (values[i] == 0.) {
+                values[i] = get_exact_sum(exact + i * REGION_EXACT_NWORDS);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Region IDs of the active cells in ascending order, without
+ *           duplicates (master node).
+ * @return   number of regions
+ *****************************************************************************/
+static size_t
+get_region_ids(int  *grid,
+               int **ids)
+{
+    extern domain_struct global_domain;
+    extern size_t       *filter_active_cells;
+
+    size_t               nregions;
+    size_t               n;
+    size_t               i;
+
+    *ids = malloc((global_domain.ncells_active + 1) * sizeof(*(*ids)));
+    check_alloc_status(*ids, "Memory allocation error.");
+    n = 0;
+    for (i = 0; i < global_domain.ncells_active; i++) {
+        if (grid[filter_active_cells[i]] > 0) {
+            (*ids)[n++] = grid[filter_active_cells[i]];
+        }
+    }
+    qsort(*ids, n, sizeof(*(*ids)), compare_region_ids);
+
+    nregions = 0;
+    for (i = 0; i < n; i++) {
+        if (nregions == 0 || (*ids)[i] != (*ids)[nregions - 1]) {
+            (*ids)[nregions++] = (*ids)[i];
+        }
+    }
+
+    return nregions;
+}
+
+/******************************************************************************
+ * @brief    Set up the regions of a stream with OUTREGION.
+ * @details  Called by vic_init_output() after the history file of the stream
+ *           is set up and before its aggregation buffers are allocated. The
+ *           stream holds the local cells that belong to a region, which may
+ *           be none.
+ *****************************************************************************/
+void
+set_stream_regions(stream_struct  *stream,
+                   nc_file_struct *nc)
+{
+    extern filenames_struct filenames;
+    extern domain_struct    global_domain;
+    extern domain_struct    local_domain;
+    extern option_struct    options;
+    extern soil_con_struct *soil_con;
+    extern double        ***out_data;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern int              mpi_rank;
+
+    nc_region_struct       *region;
+    nc_io_field_struct      field;
+    size_t                  d2start[2];
+    size_t                  d2count[2];
+    int                    *grid = NULL;
+    int                    *ivar;
+    int                    *id;
+    double                 *area;
+    size_t                  nelem;
+    size_t                  i;
+    size_t                  n;
+    int                     status;
+
+    if (stream->region[0] == '\0') {
+        return;
+    }
+
+    // the record is reduced and written by the model on the master node
+    if (options.IO_SERVERS > 0 || options.ASYNC_OUTPUT) {
+        log_err("OUTREGION of output stream %s is not supported with "
+                "IO_SERVERS or ASYNC_OUTPUT", stream->prefix);
+    }
+    if (stream->mask[0] != '\0') {
+        log_err("Output stream %s has both OUTMASK and OUTREGION, cells "
+                "outside the regions of OUTREGION are not part of the "
+                "stream anyway", stream->prefix);
+    }
+
+    d2start[0] = 0;
+    d2start[1] = 0;
+    d2count[0] = global_domain.n_ny;
+    d2count[1] = global_domain.n_nx;
+
+    region = &(nc->region);
+
+    // the region map is read once and scattered to the nodes
+    if (mpi_rank == VIC_MPI_ROOT) {
+        grid = malloc(global_domain.ncells_total * sizeof(*grid));
+        check_alloc_status(grid, "Memory allocation error.");
+        get_nc_field_int(filenames.domain, stream->region, d2start, d2count,
+                         grid);
+        region->nregions = get_region_ids(grid, &(region->ids));
+    }
+    ivar = malloc((local_domain.ncells_active + 1) * sizeof(*ivar));
+    check_alloc_status(ivar, "Memory allocation error.");
+    memset(&field, 0, sizeof(field));
+    field.nc_type = NC_INT;
+    field.nslices = 1;
+    field.start = d2start;
+    field.count = d2count;
+    field.grid = grid;
+    field.var = ivar;
+    get_scatter_nc_fields(1, &field);
+    free(grid);
+
+    status = MPI_Bcast(&(region->nregions), 1, MPI_AINT, VIC_MPI_ROOT,
+                       MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (region->nregions == 0) {
+        log_err("OUTREGION %s of output stream %s has no region with an ID "
+                "greater than 0", stream->region, stream->prefix);
+    }
+    if (mpi_rank != VIC_MPI_ROOT) {
+        region->ids = malloc(region->nregions * sizeof(*(region->ids)));
+        check_alloc_status(region->ids, "Memory allocation error.");
+    }
+    status = MPI_Bcast(region->ids, (int) region->nregions, MPI_INT,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    // the local cells of the regions
+    n = 0;
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (ivar[i] > 0) {
+            n++;
+        }
+    }
+    stream->ngridcells = n;
+    stream->cells = malloc((n + 1) * sizeof(*(stream->cells)));
+    check_alloc_status(stream->cells, "Memory allocation error.");
+    stream->cell_data = malloc((n + 1) * sizeof(*(stream->cell_data)));
+    check_alloc_status(stream->cell_data, "Memory allocation error.");
+    region->cell_region = malloc((n + 1) * sizeof(*(region->cell_region)));
+    check_alloc_status(region->cell_region, "Memory allocation error.");
+    region->cell_area = malloc((n + 1) * sizeof(*(region->cell_area)));
+    check_alloc_status(region->cell_area, "Memory allocation error.");
+    n = 0;
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (ivar[i] > 0) {
+            id = bsearch(&(ivar[i]), region->ids, region->nregions,
+                         sizeof(*(region->ids)), compare_region_ids);
+            stream->cells[n] = i;
+            stream->cell_data[n] = out_data[i];
+            region->cell_region[n] = (size_t) (id - region->ids);
+            region->cell_area[n] = soil_con[i].cell_area;
+            n++;
+        }
+    }
+    free(ivar);
+
+    // the area of the regions
+    nelem = get_region_nelem(stream);
+    region->sums = malloc(nelem * region->nregions *
+                          sizeof(*(region->sums)));
+    check_alloc_status(region->sums, "Memory allocation error.");
+    area = region->sums;
+    for (i = 0; i < region->nregions; i++) {
+        area[i] = 0.;
+    }
+    if (mpi_rank == VIC_MPI_ROOT) {
+        region->area = malloc(region->nregions * sizeof(*(region->area)));
+        check_alloc_status(region->area, "Memory allocation error.");
+        region->values = malloc(nelem * region->nregions *
+                                sizeof(*(region->values)));
+        check_alloc_status(region->values, "Memory allocation error.");
+    }
+    if (options.REPRODUCIBLE) {
+        region->exact = malloc(nelem * region->nregions *
+                               REGION_EXACT_NWORDS * sizeof(*(region->exact)));
+        check_alloc_status(region->exact, "Memory allocation error.");
+        memset(region->exact, 0, region->nregions * REGION_EXACT_NWORDS *
+               sizeof(*(region->exact)));
+        for (i = 0; i < stream->ngridcells; i++) {
+            n = region->cell_region[i];
+            add_exact_sum(region->exact + n * REGION_EXACT_NWORDS,
+                          region->cell_area[i], &(area[n]));
+        }
+        reduce_exact_sums(region->nregions, region->exact, area,
+                          region->area);
+    }
+    else {
+        for (i = 0; i < stream->ngridcells; i++) {
+            area[region->cell_region[i]] += region->cell_area[i];
+        }
+        status = MPI_Reduce(area, region->area, (int) region->nregions,
+                            MPI_DOUBLE, MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
+
+    debug("output stream %s holds %zu regions of OUTREGION %s",
+          stream->prefix, region->nregions, stream->region);
+
+    // the regions are written along the land dimension by the master node
+    nc->land_size = region->nregions;
+    nc->parallel = false;
+    for (i = 0; i < stream->nvars; i++) {
+        set_nc_var_info(stream->varid[i], stream->type[i], nc,
+                        &(nc->nc_vars[i]));
+    }
+}
+
+/******************************************************************************
+ * @brief    Reduce the record of a region stream and write it.
+ * @details  Called by vic_write() on all nodes. The values of the regions
+ *           are written by the master node.
+ *****************************************************************************/
+void
+put_region_record(stream_struct  *stream,
+                  nc_file_struct *nc)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+    extern option_struct   options;
+    extern MPI_Comm        MPI_COMM_VIC;
+    extern int             mpi_rank;
+
+    nc_region_struct      *region = &(nc->region);
+    nc_var_struct         *nc_var;
+    double                *aggvalues;
+    double                *sums;
+    int64_t               *exact;
+    double                *values;
+    size_t                 nregions;
+    size_t                 nelem;
+    size_t                 i;
+    size_t                 j;
+    size_t                 k;
+    int                    status;
+
+    nregions = region->nregions;
+    nelem = get_region_nelem(stream);
+
+    // area weighted sums of the local cells of each region
+    for (i = 0; i < nelem * nregions; i++) {
+        region->sums[i] = 0.;
+    }
+    aggvalues = stream->aggvalues;
+    if (options.REPRODUCIBLE) {
+        memset(region->exact, 0, nelem * nregions * REGION_EXACT_NWORDS *
+               sizeof(*(region->exact)));
+        for (k = 0; k < nelem; k++) {
+            sums = region->sums + k * nregions;
+            exact = region->exact + k * nregions * REGION_EXACT_NWORDS;
+            for (i = 0; i < stream->ngridcells; i++) {
+                j = region->cell_region[i];
+                add_exact_sum(exact + j * REGION_EXACT_NWORDS,
+                              aggvalues[i] * region->cell_area[i],
+                              &(sums[j]));
+            }
+            aggvalues += stream->ngridcells;
+        }
+        reduce_exact_sums(nelem * nregions, region->exact, region->sums,
+                          region->values);
+    }
+    else {
+        for (k = 0; k < nelem; k++) {
+            sums = region->sums + k * nregions;
+            for (i = 0; i < stream->ngridcells; i++) {
+                sums[region->cell_region[i]] += aggvalues[i] *
+                                                region->cell_area[i];
+            }
+            aggvalues += stream->ngridcells;
+        }
+
+        status = MPI_Reduce(region->sums, region->values,
+                            (int) (nelem * nregions), MPI_DOUBLE, MPI_SUM,
+                            VIC_MPI_ROOT, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
+
+    if (mpi_rank != VIC_MPI_ROOT) {
+        return;
+    }
+
+    values = region->values;
+    for (k = 0; k < stream->nvars; k++) {
+        nc_var = &(nc->nc_vars[k]);
+        nelem = out_metadata[stream->varid[k]].nelem;
+
+        if (stream->region_reduce == REGION_MEAN) {
+            for (j = 0; j < nelem; j++) {
+                for (i = 0; i < nregions; i++) {
+                    if (region->area[i] > 0.) {
+                        values[j * nregions + i] /= region->area[i];
+                    }
+                    else {
+                        values[j * nregions + i] = nc->d_fillvalue;
+                    }
+                }
+            }
+        }
+
+        round_history_values(stream, nc, k, values, nelem * nregions);
+
+        // all elements of the variable are written with one hyperslab
+        for (j = 0; j < nc_var->nc_dims; j++) {
+            nc_var->io_start[j] = 0;
+            nc_var->io_count[j] = 1;
+        }
+        nc_var->io_count[nc_var->nc_dims - 1] = nregions;
+        if (nc_var->nc_dims > 2) {
+            nc_var->io_count[1] = nelem;
+        }
+        nc_var->io_start[0] = stream->write_alarm.count;
+
+        status = nc_put_vara_double(nc->nc_id, nc_var->nc_varid,
+                                    nc_var->io_start, nc_var->io_count,
+                                    values);
+        check_nc_status(status, "Error writing values to %s",
+                        stream->filename);
+        values += nelem * nregions;
+    }
+}
+
+/******************************************************************************
+ * @brief    Free the regions of a region stream.
+ *****************************************************************************/
+void
+free_stream_regions(nc_file_struct *nc)
+{
+    free(nc->region.ids);
+    free(nc->region.cell_region);
+    free(nc->region.cell_area);
+    free(nc->region.area);
+    free(nc->region.sums);
+    free(nc->region.exact);
+    free(nc->region.values);
+}
@@ -35,6 +35,8 @@ vic_restore(void)
     extern all_vars_struct    *all_vars;
     extern domain_struct       global_domain;
     extern domain_struct       local_domain;
+    extern size_t             *lake_cells;
+    extern size_t              nlake_cells;
     extern option_struct       options;
     extern veg_con_map_struct *veg_con_map;
     extern filenames_struct    filenames;
@@ -45,7 +47,10 @@ vic_restore(void)
     size_t                     j;
     size_t                     k;
     size_t                     m;
+    size_t                     n;
     size_t                     p;
+    size_t                     nslices;
+    size_t                     offset;
     int                       *ivar = NULL;
     double                    *dvar = NULL;
     size_t                     d2count[2];
@@ -59,15 +64,27 @@ vic_restore(void)
     size_t                     d6count[6];
     size_t                     d6start[6];
 
+    if (options.STATE_FORMAT == BINARY_FAST) {
+        vic_restore_fast();
+        return;
+    }
+
     // validate state file dimensions and coordinate variables
     check_init_state_file();
     // read state variables
 
-    // allocate memory for variables to be stored
-    ivar = malloc(local_domain.ncells_active * sizeof(*ivar));
+    // each state variable is read and scattered as one block of 2-D slices,
+    // allocate memory for the largest block
+    nslices = max(options.Nlayer * options.Nfrost, options.Nnode);
+    nslices *= options.NVEGTYPES * options.SNOW_BAND;
+    if (options.LAKES && options.NLAKENODES > nslices) {
+        nslices = options.NLAKENODES;
+    }
+
+    ivar = malloc(nslices * local_domain.ncells_active * sizeof(*ivar));
     check_alloc_status(ivar, "Memory allocation error");
 
-    dvar = malloc(local_domain.ncells_active * sizeof(*dvar));
+    dvar = malloc(nslices * local_domain.ncells_active * sizeof(*dvar));
     check_alloc_status(dvar, "Memory allocation error");
 
     // initialize starts and counts
@@ -117,436 +134,524 @@ vic_restore(void)
     d6count[5] = global_domain.n_nx;
 
     // total soil moisture
+    d5count[0] = options.NVEGTYPES;
+    d5count[1] = options.SNOW_BAND;
+    d5count[2] = options.Nlayer;
+    nslices = options.NVEGTYPES * options.SNOW_BAND * options.Nlayer;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SOIL_MOISTURE].varname,
+                                nslices, d5start, d5count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d5start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d5start[1] = k;
             for (j = 0; j < options.Nlayer; j++) {
-                d5start[2] = j;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_SOIL_MOISTURE].varname,
-                                            d5start, d5count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].cell[v][k].layer[j].moist = dvar[i];
+                        all_vars[i].cell[v][k].layer[j].moist =
+                            dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
     }
 
     // ice content
+    d6count[0] = options.NVEGTYPES;
+    d6count[1] = options.SNOW_BAND;
+    d6count[2] = options.Nlayer;
+    d6count[3] = options.Nfrost;
+    nslices = options.NVEGTYPES * options.SNOW_BAND * options.Nlayer *
+              options.Nfrost;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SOIL_ICE].varname,
+                                nslices, d6start, d6count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d6start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d6start[1] = k;
             for (j = 0; j < options.Nlayer; j++) {
-                d6start[2] = j;
                 for (p = 0; p < options.Nfrost; p++) {
-                    d6start[3] = p;
-                    get_scatter_nc_field_double(filenames.init_state,
-                                                state_metadata[STATE_SOIL_ICE].varname,
-                                                d6start, d6count, dvar);
                     for (i = 0; i < local_domain.ncells_active; i++) {
                         v = veg_con_map[i].vidx[m];
                         if (v >= 0) {
-                            all_vars[i].cell[v][k].layer[j].ice[p] = dvar[i];
+                            all_vars[i].cell[v][k].layer[j].ice[p] =
+                                dvar[offset + i];
                         }
                     }
+                    offset += local_domain.ncells_active;
                 }
             }
         }
     }
 
     // dew storage: tmpval = veg_var[veg][band].Wdew;
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_CANOPY_WATER].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_CANOPY_WATER].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].veg_var[v][k].Wdew = dvar[i];
+                    all_vars[i].veg_var[v][k].Wdew = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     if (options.CARBON) {
         // cumulative NPP: tmpval = veg_var[veg][band].AnnualNPP;
+        d4count[0] = options.NVEGTYPES;
+        d4count[1] = options.SNOW_BAND;
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[STATE_ANNUALNPP].varname,
+                                    nslices, d4start, d4count, dvar);
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_ANNUALNPP].varname,
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].veg_var[v][k].AnnualNPP = dvar[i];
+                        all_vars[i].veg_var[v][k].AnnualNPP = dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
 
         // previous NPP: tmpval = veg_var[veg][band].AnnualNPPPrev;
+        d4count[0] = options.NVEGTYPES;
+        d4count[1] = options.SNOW_BAND;
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[
+                                        STATE_ANNUALNPPPREV].varname,
+                                    nslices, d4start, d4count, dvar);
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_ANNUALNPPPREV].varname,
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].veg_var[v][k].AnnualNPPPrev = dvar[i];
+                        all_vars[i].veg_var[v][k].AnnualNPPPrev =
+                            dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
 
         // litter carbon: tmpval = cell[veg][band].CLitter;
+        d4count[0] = options.NVEGTYPES;
+        d4count[1] = options.SNOW_BAND;
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[STATE_CLITTER].varname,
+                                    nslices, d4start, d4count, dvar);
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_CLITTER].varname,
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].cell[v][k].CLitter = dvar[i];
+                        all_vars[i].cell[v][k].CLitter = dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
 
         // intermediate carbon: tmpval = cell[veg][band].CInter;
+        d4count[0] = options.NVEGTYPES;
+        d4count[1] = options.SNOW_BAND;
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[STATE_CINTER].varname,
+                                    nslices, d4start, d4count, dvar);
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_CINTER].varname,
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].cell[v][k].CInter = dvar[i];
+                        all_vars[i].cell[v][k].CInter = dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
 
         // slow carbon: tmpval = cell[veg][band].CSlow;
+        d4count[0] = options.NVEGTYPES;
+        d4count[1] = options.SNOW_BAND;
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[STATE_CSLOW].varname,
+                                    nslices, d4start, d4count, dvar);
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_CSLOW].varname,
-                                            d4start, d4count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].cell[v][k].CSlow = dvar[i];
+                        all_vars[i].cell[v][k].CSlow = dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
     }
 
     // snow age: snow[veg][band].last_snow
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_int(filenames.init_state,
+                             state_metadata[STATE_SNOW_AGE].varname,
+                             nslices, d4start, d4count, ivar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_int(filenames.init_state,
-                                     state_metadata[STATE_SNOW_AGE].varname,
-                                     d4start, d4count, ivar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].last_snow = ivar[i];
+                    all_vars[i].snow[v][k].last_snow = ivar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // melting state: (int)snow[veg][band].MELTING
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_int(filenames.init_state,
+                             state_metadata[STATE_SNOW_MELT_STATE].varname,
+                             nslices, d4start, d4count, ivar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_int(filenames.init_state,
-                                     state_metadata[STATE_SNOW_MELT_STATE].varname,
-                                     d4start, d4count, ivar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].MELTING = ivar[i];
+                    all_vars[i].snow[v][k].MELTING = ivar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow covered fraction: snow[veg][band].coverage
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_COVERAGE].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_COVERAGE].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].coverage = dvar[i];
+                    all_vars[i].snow[v][k].coverage = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow water equivalent: snow[veg][band].swq
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[
+                                    STATE_SNOW_WATER_EQUIVALENT].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[
-                                            STATE_SNOW_WATER_EQUIVALENT].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].swq = dvar[i];
+                    all_vars[i].snow[v][k].swq = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow surface temperature: snow[veg][band].surf_temp
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_SURF_TEMP].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_SURF_TEMP].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].surf_temp = dvar[i];
+                    all_vars[i].snow[v][k].surf_temp = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow surface water: snow[veg][band].surf_water
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_SURF_WATER].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_SURF_WATER].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].surf_water = dvar[i];
+                    all_vars[i].snow[v][k].surf_water = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow pack temperature: snow[veg][band].pack_temp
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_PACK_TEMP].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_PACK_TEMP].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].pack_temp = dvar[i];
+                    all_vars[i].snow[v][k].pack_temp = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow pack water: snow[veg][band].pack_water
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_PACK_WATER].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_PACK_WATER].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].pack_water = dvar[i];
+                    all_vars[i].snow[v][k].pack_water = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow density: snow[veg][band].density
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_DENSITY].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_DENSITY].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].density = dvar[i];
+                    all_vars[i].snow[v][k].density = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow cold content: snow[veg][band].coldcontent
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[
+                                    STATE_SNOW_COLD_CONTENT].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_COLD_CONTENT].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].coldcontent = dvar[i];
+                    all_vars[i].snow[v][k].coldcontent = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // snow canopy storage: snow[veg][band].snow_canopy
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SNOW_CANOPY].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_SNOW_CANOPY].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].snow[v][k].snow_canopy = dvar[i];
+                    all_vars[i].snow[v][k].snow_canopy = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // soil node temperatures: energy[veg][band].T[nidx]
+    d5count[0] = options.NVEGTYPES;
+    d5count[1] = options.SNOW_BAND;
+    d5count[2] = options.Nnode;
+    nslices = options.NVEGTYPES * options.SNOW_BAND * options.Nnode;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_SOIL_NODE_TEMP].varname,
+                                nslices, d5start, d5count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d5start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d5start[1] = k;
             for (j = 0; j < options.Nnode; j++) {
-                d5start[2] = j;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_SOIL_NODE_TEMP].varname,
-                                            d5start, d5count, dvar);
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        all_vars[i].energy[v][k].T[j] = dvar[i];
+                        all_vars[i].energy[v][k].T[j] = dvar[offset + i];
                     }
                 }
+                offset += local_domain.ncells_active;
             }
         }
     }
 
     // Foliage temperature: energy[veg][band].Tfoliage
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[
+                                    STATE_FOLIAGE_TEMPERATURE].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_FOLIAGE_TEMPERATURE].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].energy[v][k].Tfoliage = dvar[i];
+                    all_vars[i].energy[v][k].Tfoliage = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // Outgoing longwave from understory: energy[veg][band].LongUnderOut
     // This is a flux. Saving it to state file is a temporary solution!!
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[
+                                    STATE_ENERGY_LONGUNDEROUT].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_ENERGY_LONGUNDEROUT].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].energy[v][k].LongUnderOut = dvar[i];
+                    all_vars[i].energy[v][k].LongUnderOut = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     // Thermal flux through the snow pack: energy[veg][band].snow_flux
     // This is a flux. Saving it to state file is a temporary solution!!
+    d4count[0] = options.NVEGTYPES;
+    d4count[1] = options.SNOW_BAND;
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    get_scatter_nc_block_double(filenames.init_state,
+                                state_metadata[STATE_ENERGY_SNOW_FLUX].varname,
+                                nslices, d4start, d4count, dvar);
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_ENERGY_SNOW_FLUX].varname,
-                                        d4start, d4count, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    all_vars[i].energy[v][k].snow_flux = dvar[i];
+                    all_vars[i].energy[v][k].snow_flux = dvar[offset + i];
                 }
             }
+            offset += local_domain.ncells_active;
         }
     }
 
     if (options.LAKES) {
         // total soil moisture
+        d3count[0] = options.Nlayer;
+        nslices = options.Nlayer;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[
+                                        STATE_LAKE_SOIL_MOISTURE].varname,
+                                    nslices, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_LAKE_SOIL_MOISTURE].varname,
-                                        d3start, d3count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.soil.layer[j].moist = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->soil.layer[j].moist = dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
 
         // ice content
+        d4count[0] = options.Nlayer;
+        d4count[1] = options.Nfrost;
+        nslices = options.Nlayer * options.Nfrost;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[
+                                        STATE_LAKE_SOIL_ICE].varname,
+                                    nslices, d4start, d4count, dvar);
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d4start[0] = j;
             for (p = 0; p < options.Nfrost; p++) {
-                d4start[1] = p;
-                get_scatter_nc_field_double(filenames.init_state,
-                                            state_metadata[STATE_LAKE_SOIL_ICE].varname,
-                                            d4start, d4count, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    all_vars[i].lake_var.soil.layer[j].ice[p] = dvar[i];
+                for (n = 0; n < nlake_cells; n++) {
+                    i = lake_cells[n];
+                    all_vars[i].lake_var->soil.layer[j].ice[p] =
+                        dvar[offset + i];
                 }
+                offset += local_domain.ncells_active;
             }
         }
 
@@ -555,24 +660,27 @@ vic_restore(void)
             get_scatter_nc_field_double(filenames.init_state,
                                         state_metadata[STATE_LAKE_CLITTER].varname,
                                         d2start, d2count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.soil.CLitter = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->soil.CLitter = dvar[i];
             }
 
             // intermediate carbon: tmpval = lake_var.soil.CInter;
             get_scatter_nc_field_double(filenames.init_state,
                                         state_metadata[STATE_LAKE_CINTER].varname,
                                         d2start, d2count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.soil.CInter = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->soil.CInter = dvar[i];
             }
 
             // slow carbon: tmpval = lake_var.soil.CSlow;
             get_scatter_nc_field_double(filenames.init_state,
                                         state_metadata[STATE_LAKE_CSLOW].varname,
                                         d2start, d2count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.soil.CSlow = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->soil.CSlow = dvar[i];
             }
         }
 
@@ -580,24 +688,27 @@ vic_restore(void)
         get_scatter_nc_field_int(filenames.init_state,
                                  state_metadata[STATE_LAKE_SNOW_AGE].varname,
                                  d2start, d2count, ivar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.last_snow = ivar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.last_snow = ivar[i];
         }
 
         // melting state: (int)lake_var.snow.MELTING
         get_scatter_nc_field_int(filenames.init_state,
                                  state_metadata[STATE_LAKE_SNOW_MELT_STATE].varname,
                                  d2start, d2count, ivar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.MELTING = ivar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.MELTING = ivar[i];
         }
 
         // snow covered fraction: lake_var.snow.coverage
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_COVERAGE].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.coverage = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.coverage = dvar[i];
         }
 
         // snow water equivalent: lake_var.snow.swq
@@ -605,170 +716,201 @@ vic_restore(void)
                                     state_metadata[
                                         STATE_LAKE_SNOW_WATER_EQUIVALENT].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.swq = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.swq = dvar[i];
         }
 
         // snow surface temperature: lake_var.snow.surf_temp
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_SURF_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.surf_temp = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.surf_temp = dvar[i];
         }
 
         // snow surface water: lake_var.snow.surf_water
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_SURF_WATER].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.surf_water = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.surf_water = dvar[i];
         }
 
         // snow pack temperature: lake_var.snow.pack_temp
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_PACK_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.pack_temp = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.pack_temp = dvar[i];
         }
 
         // snow pack water: lake_var.snow.pack_water
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_PACK_WATER].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.pack_water = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.pack_water = dvar[i];
         }
 
         // snow density: lake_var.snow.density
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_SURF_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.density = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.density = dvar[i];
         }
 
         // snow cold content: lake_var.snow.coldcontent
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_COLD_CONTENT].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.coldcontent = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.coldcontent = dvar[i];
         }
 
         // snow canopy storage: lake_var.snow.snow_canopy
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SNOW_CANOPY].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.snow.snow_canopy = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->snow.snow_canopy = dvar[i];
         }
 
         // soil node temperatures: lake_var.energy.T[nidx]
+        d3count[0] = options.Nnode;
+        nslices = options.Nnode;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[
+                                        STATE_LAKE_SOIL_NODE_TEMP].varname,
+                                    nslices, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.Nnode; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_LAKE_SOIL_NODE_TEMP].varname,
-                                        d3start, d3count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.soil.layer[j].moist = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->soil.layer[j].moist = dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
 
         // lake active layers: lake_var.activenod
         get_scatter_nc_field_int(filenames.init_state,
                                  state_metadata[STATE_LAKE_ACTIVE_LAYERS].varname,
                                  d2start, d2count, ivar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.activenod = ivar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->activenod = ivar[i];
         }
 
         // lake layer thickness: lake_var.dz
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_LAYER_DZ].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.dz = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->dz = dvar[i];
         }
 
         // lake surface layer thickness: lake_var.surfdz
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SURF_LAYER_DZ].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.surfdz = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->surfdz = dvar[i];
         }
 
         // lake depth: lake_var.ldepth
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_DEPTH].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.ldepth = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->ldepth = dvar[i];
         }
 
         // lake layer surface areas: lake_var.surface[ndix]
+        d3count[0] = options.NLAKENODES;
+        nslices = options.NLAKENODES;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[
+                                        STATE_LAKE_LAYER_SURF_AREA].varname,
+                                    nslices, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NLAKENODES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[
-                                            STATE_LAKE_LAYER_SURF_AREA].varname,
-                                        d3start, d3count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.surface[j] = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->surface[j] = dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
 
         // lake surface area: lake_var.sarea
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_SURF_AREA].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.sarea = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->sarea = dvar[i];
         }
 
         // lake volume: lake_var.volume
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_VOLUME].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.volume = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->volume = dvar[i];
         }
 
         // lake layer temperatures: lake_var.temp[nidx]
+        d3count[0] = options.NLAKENODES;
+        nslices = options.NLAKENODES;
+        get_scatter_nc_block_double(filenames.init_state,
+                                    state_metadata[
+                                        STATE_LAKE_LAYER_TEMP].varname,
+                                    nslices, d3start, d3count, dvar);
+        offset = 0;
         for (j = 0; j < options.NLAKENODES; j++) {
-            d3start[0] = j;
-            get_scatter_nc_field_double(filenames.init_state,
-                                        state_metadata[STATE_LAKE_LAYER_TEMP].varname,
-                                        d3start, d3count, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                all_vars[i].lake_var.temp[j] = dvar[i];
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                all_vars[i].lake_var->temp[j] = dvar[offset + i];
             }
+            offset += local_domain.ncells_active;
         }
 
         // vertical average lake temperature: lake_var.tempavg
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_AVERAGE_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.tempavg = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->tempavg = dvar[i];
         }
 
         // lake ice area fraction: lake_var.areai
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_AREA_FRAC].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.areai = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->areai = dvar[i];
         }
 
         // new lake ice area fraction: lake_var.new_ice_area
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_AREA_FRAC_NEW].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.new_ice_area = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->new_ice_area = dvar[i];
         }
 
         // lake ice water equivalent: lake_var.ice_water_eq
@@ -776,48 +918,54 @@ vic_restore(void)
                                     state_metadata[
                                         STATE_LAKE_ICE_WATER_EQUIVALENT].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.ice_water_eq = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->ice_water_eq = dvar[i];
         }
 
         // lake ice height: lake_var.hice
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_HEIGHT].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.hice = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->hice = dvar[i];
         }
 
         // lake ice temperature: lake_var.tempi
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.tempi = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->tempi = dvar[i];
         }
 
         // lake ice snow water equivalent: lake_var.swe
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_SWE].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.swe = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->swe = dvar[i];
         }
 
         // lake ice snow surface temperature: lake_var.surf_temp
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_SNOW_SURF_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.surf_temp = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->surf_temp = dvar[i];
         }
 
         // lake ice snow pack temperature: lake_var.pack_temp
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_SNOW_PACK_TEMP].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.pack_temp = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->pack_temp = dvar[i];
         }
 
         // lake ice snow coldcontent: lake_var.coldcontent
@@ -825,8 +973,9 @@ vic_restore(void)
                                     state_metadata[
                                         STATE_LAKE_ICE_SNOW_COLD_CONTENT].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.coldcontent = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->coldcontent = dvar[i];
         }
 
         // lake ice snow surface water: lake_var.surf_water
@@ -834,8 +983,9 @@ vic_restore(void)
                                     state_metadata[
                                         STATE_LAKE_ICE_SNOW_SURF_WATER].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.surf_water = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->surf_water = dvar[i];
         }
 
         // lake ice snow pack water: lake_var.pack_water
@@ -843,24 +993,27 @@ vic_restore(void)
                                     state_metadata[
                                         STATE_LAKE_ICE_SNOW_PACK_WATER].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.pack_water = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->pack_water = dvar[i];
         }
 
         // lake ice snow albedo: lake_var.SAlbedo
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_SNOW_ALBEDO].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.SAlbedo = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->SAlbedo = dvar[i];
         }
 
         // lake ice snow depth: lake_var.sdepth
         get_scatter_nc_field_double(filenames.init_state,
                                     state_metadata[STATE_LAKE_ICE_SNOW_DEPTH].varname,
                                     d2start, d2count, dvar);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            all_vars[i].lake_var.sdepth = dvar[i];
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            all_vars[i].lake_var->sdepth = dvar[i];
         }
     }
 
@@ -0,0 +1,359 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * History files split over groups of processes.
+ *
+ * With OUT_SPLIT = M, the processes are divided into groups of M consecutive
+ * ranks. Each group writes its own history file of every output stream
+ * (prefix.<date>.<group>.nc), with the active cells of the group along a
+ * land dimension and a land variable with the index of each cell in the
+ * full grid. The values of a record are gathered on the first process of
+ * the group, so the write bandwidth grows with the number of groups and no
+ * process holds a record of the whole domain. OUT_SPLIT = 1 writes one file
+ * per process.
+ *
+ * The files of a record can be read directly, or merged into a single file
+ * on the full grid with tools/merge_history/merge_history.py.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+static split_io_struct split_io = {
+    .comm = MPI_COMM_NULL
+};
+
+/******************************************************************************
+ * @brief    Set up the groups of processes of split history files.
+ * @details  Called by all processes in vic_init_output() before the history
+ *           files are set up.
+ *****************************************************************************/
+void
+initialize_split_io(void)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+    extern MPI_Comm      MPI_COMM_VIC;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+
+    int                 *cells;
+    int                  size;
+    int                  ncells;
+    int                  i;
+    int                  status;
+
+    if (options.OUT_SPLIT == 0) {
+        return;
+    }
+
+    split_io.group = mpi_rank / (int) options.OUT_SPLIT;
+    split_io.ngroups = (mpi_size + (int) options.OUT_SPLIT - 1) /
+                       (int) options.OUT_SPLIT;
+    status = MPI_Comm_split(MPI_COMM_VIC, split_io.group, mpi_rank,
+                            &(split_io.comm));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_rank(split_io.comm, &(split_io.rank));
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_size(split_io.comm, &size);
+    check_mpi_status(status, "MPI error.");
+
+    // cells of the processes of the group
+    if (split_io.rank == 0) {
+        split_io.counts = malloc(size * sizeof(*(split_io.counts)));
+        check_alloc_status(split_io.counts, "Memory allocation error.");
+        split_io.displs = malloc(size * sizeof(*(split_io.displs)));
+        check_alloc_status(split_io.displs, "Memory allocation error.");
+        split_io.byte_counts = malloc(size * sizeof(*(split_io.byte_counts)));
+        check_alloc_status(split_io.byte_counts, "Memory allocation error.");
+        split_io.byte_displs = malloc(size * sizeof(*(split_io.byte_displs)));
+        check_alloc_status(split_io.byte_displs, "Memory allocation error.");
+    }
+    ncells = (int) local_domain.ncells_active;
+    status = MPI_Gather(&ncells, 1, MPI_INT, split_io.counts, 1, MPI_INT, 0,
+                        split_io.comm);
+    check_mpi_status(status, "MPI error.");
+    split_io.ncells_total = 0;
+    if (split_io.rank == 0) {
+        for (i = 0; i < size; i++) {
+            split_io.displs[i] = (int) split_io.ncells_total;
+            split_io.ncells_total += split_io.counts[i];
+        }
+    }
+    status = MPI_Bcast(&(split_io.ncells_total), 1, MPI_AINT, 0,
+                       split_io.comm);
+    check_mpi_status(status, "MPI error.");
+    if (split_io.ncells_total == 0) {
+        log_err("The processes of split history file %d have no active "
+                "cells. Use a larger OUT_SPLIT.", split_io.group);
+    }
+
+    // the grid index of the cells, in the order of the processes
+    cells = malloc((local_domain.ncells_active + 1) * sizeof(*cells));
+    check_alloc_status(cells, "Memory allocation error.");
+    for (i = 0; i < ncells; i++) {
+        cells[i] = (int) local_domain.locations[i].io_idx;
+    }
+    if (split_io.rank == 0) {
+        split_io.grid_cells = malloc(split_io.ncells_total *
+                                     sizeof(*(split_io.grid_cells)));
+        check_alloc_status(split_io.grid_cells, "Memory allocation error.");
+    }
+    status = MPI_Gatherv(cells, ncells, MPI_INT, split_io.grid_cells,
+                         split_io.counts, split_io.displs, MPI_INT, 0,
+                         split_io.comm);
+    check_mpi_status(status, "MPI error.");
+    free(cells);
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        log_info("History files split into %d files of %zu processes",
+                 split_io.ngroups, options.OUT_SPLIT);
+    }
+}
+
+/******************************************************************************
+ * @brief    Free the groups of processes of split history files.
+ *****************************************************************************/
+void
+finalize_split_io(void)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+
+    int             status;
+
+    if (split_io.comm != MPI_COMM_NULL) {
+        status = MPI_Comm_free(&(split_io.comm));
+        check_mpi_status(status, "MPI error.");
+    }
+    free(split_io.counts);
+    free(split_io.displs);
+    free(split_io.grid_cells);
+    free(split_io.byte_counts);
+    free(split_io.byte_displs);
+    free(split_io.recvbuf.data);
+    free(split_io.gridbuf.data);
+    memset(&split_io, 0, sizeof(split_io));
+    split_io.comm = MPI_COMM_NULL;
+}
+
+/******************************************************************************
+ * @brief    Split the history files of a stream over the groups of
+ *           processes.
+ * @details  Called by vic_init_output() after the cells of the stream are
+ *           selected. Streams with OUTMASK or OUTREGION are small and keep a
+ *           single history file, and published streams have no history
+ *           files.
+ *****************************************************************************/
+void
+set_stream_split(stream_struct  *stream,
+                 nc_file_struct *nc)
+{
+    extern option_struct options;
+
+    size_t               i;
+
+    if (options.OUT_SPLIT == 0 || stream->mask[0] != '\0' ||
+        stream->region[0] != '\0' || is_published_stream(stream)) {
+        return;
+    }
+
+    nc->split = true;
+    nc->parallel = false;
+    nc->land_size = split_io.ncells_total;
+    for (i = 0; i < stream->nvars; i++) {
+        set_nc_var_info(stream->varid[i], stream->type[i], nc,
+                        &(nc->nc_vars[i]));
+    }
+}
+
+/******************************************************************************
+ * @brief    Check whether the local process opens and writes a history file.
+ *****************************************************************************/
+bool
+is_history_writer(nc_file_struct *nc)
+{
+    extern int mpi_rank;
+
+    if (nc->parallel) {
+        return true;
+    }
+    if (nc->split) {
+        return (split_io.rank == 0);
+    }
+    return (mpi_rank == VIC_MPI_ROOT);
+}
+
+/******************************************************************************
+ * @brief    Add the index of the group to the name of a split history file.
+ * @details  prefix.<date>.nc becomes prefix.<date>.<group>.nc.
+ *****************************************************************************/
+void
+set_split_filename(char *filename)
+{
+    char  *ext;
+    size_t len;
+
+    len = strlen(filename);
+    ext = filename + len;
+    if (len >= 3 && strcmp(filename + len - 3, ".nc") == 0) {
+        ext = filename + len - 3;
+    }
+    if ((size_t) (ext - filename) + 9 >= MAXSTRING) {
+        log_err("History file name %s is too long", filename);
+    }
+    sprintf(ext, ".%04d.nc", split_io.group);
+}
+
+/******************************************************************************
+ * @brief    Global attributes of a split history file.
+ *****************************************************************************/
+void
+set_split_nc_attributes(int nc_id)
+{
+    int status;
+
+    status = nc_put_att_int(nc_id, NC_GLOBAL, "split_file", NC_INT, 1,
+                            &(split_io.group));
+    check_nc_status(status, "Error adding split_file attribute");
+    status = nc_put_att_int(nc_id, NC_GLOBAL, "split_nfiles", NC_INT, 1,
+                            &(split_io.ngroups));
+    check_nc_status(status, "Error adding split_nfiles attribute");
+}
+
+/******************************************************************************
+ * @brief    Grid index of the cells of the split history file of the group
+ *           (group leader).
+ *****************************************************************************/
+int *
+get_split_grid_cells(void)
+{
+    return split_io.grid_cells;
+}
+
+/******************************************************************************
+ * @brief    Gather a list of fields on the group leader and write them to
+ *           the split history file of the group.
+ * @details  The local values of the fields are stored back to back in the
+ *           order of the list, as for start_gather_put_nc_fields(). The
+ *           fields travel in a single collective of the group.
+ *****************************************************************************/
+void
+gather_put_split_fields(size_t              nfields,
+                        nc_io_field_struct *fields)
+{
+    extern domain_struct local_domain;
+    extern MPI_Comm      MPI_COMM_VIC;
+
+    nc_io_field_struct  *field;
+    char                *sendbuf;
+    char                *recvbuf = NULL;
+    char                *grid;
+    char                *node;
+    size_t               nbytes = 0;
+    size_t               offset;
+    size_t               size;
+    size_t               ncells;
+    size_t               i;
+    size_t               j;
+    int                  node_ncells;
+    int                  size_group;
+    int                  p;
+    int                  status;
+
+    for (i = 0; i < nfields; i++) {
+        nbytes += fields[i].nslices * get_nc_io_type_size(fields[i].nc_type);
+    }
+    ncells = local_domain.ncells_active;
+
+    // the fields are stored back to back, see start_history_record()
+    sendbuf = fields[0].var;
+    status = MPI_Comm_size(split_io.comm, &size_group);
+    check_mpi_status(status, "MPI error.");
+    if (split_io.rank == 0) {
+        for (p = 0; p < size_group; p++) {
+            split_io.byte_counts[p] = split_io.counts[p] * (int) nbytes;
+            split_io.byte_displs[p] = split_io.displs[p] * (int) nbytes;
+        }
+        recvbuf = get_mpi_io_buffer(&(split_io.recvbuf),
+                                    split_io.ncells_total * nbytes);
+    }
+    status = MPI_Gatherv(sendbuf, (int) (ncells * nbytes), MPI_BYTE, recvbuf,
+                         split_io.byte_counts, split_io.byte_displs,
+                         MPI_BYTE, 0, split_io.comm);
+    check_mpi_status(status, "MPI error.");
+
+    if (split_io.rank != 0) {
+        return;
+    }
+
+    lock_netcdf();
+    offset = 0;
+    for (i = 0; i < nfields; i++) {
+        field = &(fields[i]);
+        size = get_nc_io_type_size(field->nc_type);
+        grid = get_mpi_io_buffer(&(split_io.gridbuf),
+                                 field->nslices * split_io.ncells_total *
+                                 size);
+
+        // the values of each process are moved to the cells of the process
+        // along the land dimension
+        for (p = 0; p < size_group; p++) {
+            node_ncells = split_io.counts[p];
+            for (j = 0; j < field->nslices; j++) {
+                node = recvbuf + split_io.byte_displs[p] +
+                       (offset + j * size) * node_ncells;
+                memcpy(grid + (j * split_io.ncells_total +
+                               split_io.displs[p]) * size,
+                       node, node_ncells * size);
+            }
+        }
+        offset += field->nslices * size;
+
+        if (field->nc_type == NC_DOUBLE) {
+            status = nc_put_vara_double(field->nc_id, field->nc_varid,
+                                        field->start, field->count,
+                                        (double *) grid);
+        }
+        else if (field->nc_type == NC_FLOAT) {
+            status = nc_put_vara_float(field->nc_id, field->nc_varid,
+                                       field->start, field->count,
+                                       (float *) grid);
+        }
+        else if (field->nc_type == NC_INT) {
+            status = nc_put_vara_int(field->nc_id, field->nc_varid,
+                                     field->start, field->count,
+                                     (int *) grid);
+        }
+        else if (field->nc_type == NC_SHORT) {
+            status = nc_put_vara_short(field->nc_id, field->nc_varid,
+                                       field->start, field->count,
+                                       (short int *) grid);
+        }
+        else {
+            status = nc_put_vara_schar(field->nc_id, field->nc_varid,
+                                       field->start, field->count,
+                                       (signed char *) grid);
+        }
+        check_nc_status(status, "Error writing values.");
+    }
+    unlock_netcdf();
+}
@@ -27,115 +27,203 @@
 #include <vic_driver_shared_image.h>
 
 /******************************************************************************
- * @brief    Wrapper function for VIC startup tasks.
+ * @brief    Broadcast the model configuration from the master node.
+ * @details  NF, NR, global_param, options and param are packed into a single
+ *           buffer with their MPI derived types and sent in one broadcast
+ *           instead of one broadcast per structure.
  *****************************************************************************/
-void
-vic_start(void)
+static void
+broadcast_configuration(void)
 {
-    int                        local_ncells_active;
-    int                        status;
-    location_struct           *mapped_locations = NULL;
-    location_struct           *active_locations = NULL;
-    size_t                     i;
-    extern size_t             *filter_active_cells;
-    extern size_t             *mpi_map_mapping_array;
-    extern filenames_struct    filenames;
-    extern filep_struct        filep;
-    extern domain_struct       global_domain;
-    extern domain_struct       local_domain;
+    extern size_t              NF;
+    extern size_t              NR;
     extern global_param_struct global_param;
     extern MPI_Comm            MPI_COMM_VIC;
     extern MPI_Datatype        mpi_global_struct_type;
-    extern MPI_Datatype        mpi_filenames_struct_type;
-    extern MPI_Datatype        mpi_location_struct_type;
     extern MPI_Datatype        mpi_option_struct_type;
     extern MPI_Datatype        mpi_param_struct_type;
-    extern int                *mpi_map_local_array_sizes;
-    extern int                *mpi_map_global_array_offsets;
     extern int                 mpi_rank;
-    extern int                 mpi_size;
     extern option_struct       options;
     extern parameters_struct   param;
-    size_t                     j;
 
-    status = MPI_Bcast(&filenames, 1, mpi_filenames_struct_type,
-                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    char                      *buf = NULL;
+    int                        size;
+    int                        nbytes;
+    int                        position;
+    int                        status;
+
+    // upper bound of the packed size, the same on all nodes
+    status = MPI_Pack_size(2, MPI_UNSIGNED_LONG, MPI_COMM_VIC, &size);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Pack_size(1, mpi_global_struct_type, MPI_COMM_VIC, &nbytes);
+    check_mpi_status(status, "MPI error.");
+    size += nbytes;
+    status = MPI_Pack_size(1, mpi_option_struct_type, MPI_COMM_VIC, &nbytes);
     check_mpi_status(status, "MPI error.");
+    size += nbytes;
+    status = MPI_Pack_size(1, mpi_param_struct_type, MPI_COMM_VIC, &nbytes);
+    check_mpi_status(status, "MPI error.");
+    size += nbytes;
 
-    // Set Log Destination
-    setup_logging(mpi_rank, filenames.log_path, &(filep.logfile));
+    buf = malloc(size);
+    check_alloc_status(buf, "Memory allocation error.");
 
     if (mpi_rank == VIC_MPI_ROOT) {
-        // set model constants
-        if (strcasecmp(filenames.constants, "MISSING")) {
-            filep.constants = open_file(filenames.constants, "r");
-            get_parameters(filep.constants);
-            fclose(filep.constants);
-        }
-
-        // read domain info
-        get_global_domain(filenames.domain, filenames.params,
-                          &global_domain);
-
-        // add the number of vegetation type to the location info in the
-        // global domain struct. This just makes life easier
-        add_nveg_to_global_domain(filenames.params, &global_domain);
+        position = 0;
+        status = MPI_Pack(&NF, 1, MPI_UNSIGNED_LONG, buf, size, &position,
+                          MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Pack(&NR, 1, MPI_UNSIGNED_LONG, buf, size, &position,
+                          MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Pack(&global_param, 1, mpi_global_struct_type, buf, size,
+                          &position, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Pack(&options, 1, mpi_option_struct_type, buf, size,
+                          &position, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Pack(&param, 1, mpi_param_struct_type, buf, size,
+                          &position, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
 
-        // decompose the mask
-        mpi_map_decomp_domain(global_domain.ncells_active, mpi_size,
-                              &mpi_map_local_array_sizes,
-                              &mpi_map_global_array_offsets,
-                              &mpi_map_mapping_array);
+    status = MPI_Bcast(buf, size, MPI_PACKED, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
 
-        // get the indices for the active cells (used in reading and writing)
-        filter_active_cells = malloc(global_domain.ncells_active *
-                                     sizeof(*filter_active_cells));
+    if (mpi_rank != VIC_MPI_ROOT) {
+        position = 0;
+        status = MPI_Unpack(buf, size, &position, &NF, 1, MPI_UNSIGNED_LONG,
+                            MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Unpack(buf, size, &position, &NR, 1, MPI_UNSIGNED_LONG,
+                            MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Unpack(buf, size, &position, &global_param, 1,
+                            mpi_global_struct_type, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Unpack(buf, size, &position, &options, 1,
+                            mpi_option_struct_type, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+        status = MPI_Unpack(buf, size, &position, &param, 1,
+                            mpi_param_struct_type, MPI_COMM_VIC);
+        check_mpi_status(status, "MPI error.");
+    }
 
-        j = 0;
-        for (i = 0; i < global_domain.ncells_total; i++) {
-            if (global_domain.locations[i].run) {
-                filter_active_cells[j] = global_domain.locations[i].io_idx;
-                j++;
-            }
-        }
+    free(buf);
+}
 
-        // get dimensions (number of vegetation types, soil zones, etc)
-        options.ROOT_ZONES = get_nc_dimension(filenames.params, "root_zone");
-        options.Nlayer = get_nc_dimension(filenames.params, "nlayer");
-        options.NVEGTYPES = get_nc_dimension(filenames.params, "veg_class");
-        if (options.SNOW_BAND == SNOW_BAND_TRUE_BUT_UNSET) {
-            options.SNOW_BAND = get_nc_dimension(filenames.params, "snow_band");
-        }
-        if (options.LAKES) {
-            options.NLAKENODES = get_nc_dimension(filenames.params,
-                                                  "lake_node");
-        }
+/******************************************************************************
+ * @brief    Read the global domain on the master process and decompose it.
+ *****************************************************************************/
+static void
+get_decomposed_domain(void)
+{
+    double                    *cell_costs = NULL;
+    size_t                     i;
+    size_t                     j;
+    extern size_t             *filter_active_cells;
+    extern size_t             *mpi_map_mapping_array;
+    extern size_t             *mpi_map_grid_array;
+    extern filenames_struct    filenames;
+    extern domain_struct       global_domain;
+    extern int                *mpi_map_local_array_sizes;
+    extern int                *mpi_map_global_array_offsets;
+    extern int                 mpi_size;
+    extern option_struct       options;
 
-        // Check that model parameters are valid
-        validate_parameters();
-    }
+    // read domain info
+    get_global_domain(filenames.domain, filenames.params,
+                      &global_domain);
 
-    // broadcast global, option, param structures as well as global valies
-    // such as NF and NR
-    status = MPI_Bcast(&NF, 1, MPI_UNSIGNED_LONG, VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
+    // add the number of vegetation type to the location info in the
+    // global domain struct. This just makes life easier
+    add_nveg_to_global_domain(filenames.params, &global_domain);
 
-    status = MPI_Bcast(&NR, 1, MPI_UNSIGNED_LONG, VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
+    // get the indices for the active cells (used in reading and writing)
+    filter_active_cells = malloc(global_domain.ncells_active *
+                                 sizeof(*filter_active_cells));
+    check_alloc_status(filter_active_cells, "Memory allocation error.");
 
-    status = MPI_Bcast(&global_param, 1, mpi_global_struct_type,
-                       VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
+    j = 0;
+    for (i = 0; i < global_domain.ncells_total; i++) {
+        if (global_domain.locations[i].run) {
+            filter_active_cells[j] = global_domain.locations[i].io_idx;
+            j++;
+        }
+    }
 
-    status = MPI_Bcast(&options, 1, mpi_option_struct_type,
-                       VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
+    // decompose the mask
+    if (options.DECOMPOSITION == DECOMP_COST_WEIGHTED ||
+        options.DECOMPOSITION == DECOMP_HILBERT) {
+        cell_costs = malloc(global_domain.ncells_active *
+                            sizeof(*cell_costs));
+        check_alloc_status(cell_costs, "Memory allocation error.");
+        get_global_domain_costs(filenames.params, filenames.decomp_cost,
+                                &global_domain, cell_costs);
+    }
+    // the I/O servers are the last processes and do not run any cells
+    if (options.DECOMPOSITION == DECOMP_HILBERT) {
+        mpi_map_decomp_hilbert(global_domain.ncells_active,
+                               global_domain.n_nx, global_domain.n_ny,
+                               filter_active_cells,
+                               mpi_size - options.IO_SERVERS,
+                               cell_costs, &mpi_map_local_array_sizes,
+                               &mpi_map_global_array_offsets,
+                               &mpi_map_mapping_array);
+    }
+    else {
+        mpi_map_decomp_domain(global_domain.ncells_active,
+                              mpi_size - options.IO_SERVERS,
+                              cell_costs, &mpi_map_local_array_sizes,
+                              &mpi_map_global_array_offsets,
+                              &mpi_map_mapping_array);
+    }
+    free(cell_costs);
+    if (options.IO_SERVERS > 0) {
+        mpi_map_local_array_sizes =
+            realloc(mpi_map_local_array_sizes,
+                    mpi_size * sizeof(*mpi_map_local_array_sizes));
+        check_alloc_status(mpi_map_local_array_sizes,
+                           "Memory allocation error.");
+        mpi_map_global_array_offsets =
+            realloc(mpi_map_global_array_offsets,
+                    mpi_size * sizeof(*mpi_map_global_array_offsets));
+        check_alloc_status(mpi_map_global_array_offsets,
+                           "Memory allocation error.");
+        for (i = mpi_size - options.IO_SERVERS; i < (size_t) mpi_size;
+             i++) {
+            mpi_map_local_array_sizes[i] = 0;
+            mpi_map_global_array_offsets[i] =
+                (int) global_domain.ncells_active;
+        }
+    }
 
-    status = MPI_Bcast(&param, 1, mpi_param_struct_type,
-                       VIC_MPI_ROOT, MPI_COMM_VIC);
-    check_mpi_status(status, "MPI error.");
+    // fuse the MPI and active cell mappings for gathering and scattering
+    mpi_map_grid_domain(global_domain.ncells_active, filter_active_cells,
+                        mpi_map_mapping_array, &mpi_map_grid_array);
+}
 
-    // setup the local domain_structs
+/******************************************************************************
+ * @brief    Scatter the locations of the active cells from the master process
+ *           to the processes that run them.
+ *****************************************************************************/
+static void
+scatter_locations(void)
+{
+    int                        local_ncells_active;
+    int                        status;
+    location_struct           *mapped_locations = NULL;
+    location_struct           *active_locations = NULL;
+    size_t                     i;
+    size_t                     j;
+    extern size_t             *mpi_map_mapping_array;
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern MPI_Datatype        mpi_location_struct_type;
+    extern int                *mpi_map_local_array_sizes;
+    extern int                *mpi_map_global_array_offsets;
+    extern int                 mpi_rank;
 
     // First scatter the array sizes
     status = MPI_Scatter(mpi_map_local_array_sizes, 1, MPI_INT,
@@ -194,10 +282,6 @@ vic_start(void)
                           mpi_location_struct_type,
                           VIC_MPI_ROOT, MPI_COMM_VIC);
     check_mpi_status(status, "MPI error.");
-    // Set the local index value
-    for (i = 0; i < (size_t) local_domain.ncells_active; i++) {
-        local_domain.locations[i].local_idx = i;
-    }
 
     // cleanup
     if (mpi_rank == VIC_MPI_ROOT) {
@@ -205,3 +289,93 @@ vic_start(void)
         free(active_locations);
     }
 }
+
+/******************************************************************************
+ * @brief    Wrapper function for VIC startup tasks.
+ *****************************************************************************/
+void
+vic_start(void)
+{
+    int                        status;
+    size_t                     i;
+    extern filenames_struct    filenames;
+    extern filep_struct        filep;
+    extern domain_struct       local_domain;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern MPI_Datatype        mpi_filenames_struct_type;
+    extern int                 mpi_rank;
+    extern option_struct       options;
+
+    status = MPI_Bcast(&filenames, 1, mpi_filenames_struct_type,
+                       VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    // Set Log Destination
+    setup_logging(mpi_rank, filenames.log_path, &(filep.logfile));
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        // set model constants
+        if (strcasecmp(filenames.constants, "MISSING")) {
+            filep.constants = open_file(filenames.constants, "r");
+            get_parameters(filep.constants);
+            fclose(filep.constants);
+        }
+
+        // get dimensions (number of vegetation types, soil zones, etc)
+        options.ROOT_ZONES = get_nc_dimension(filenames.params, "root_zone");
+        options.Nlayer = get_nc_dimension(filenames.params, "nlayer");
+        options.NVEGTYPES = get_nc_dimension(filenames.params, "veg_class");
+        if (options.SNOW_BAND == SNOW_BAND_TRUE_BUT_UNSET) {
+            options.SNOW_BAND = get_nc_dimension(filenames.params, "snow_band");
+        }
+        if (options.LAKES) {
+            options.NLAKENODES = get_nc_dimension(filenames.params,
+                                                  "lake_node");
+        }
+
+        // read and decompose the domain, with DISTRIBUTED_DOMAIN by all
+        // processes below
+        if (!options.DISTRIBUTED_DOMAIN) {
+            get_decomposed_domain();
+        }
+
+        // Check that model parameters are valid
+        validate_parameters();
+        check_specialized_options();
+    }
+
+    // broadcast global, option, param structures as well as global values
+    // such as NF and NR
+    broadcast_configuration();
+
+    // write the log file of each process in larger blocks
+    if (options.LOG_BUFFER > 0) {
+        buffer_logging(options.LOG_BUFFER * 1024, &(filep.logfile));
+    }
+
+    // the saturated vapor pressure tables depend on the model constants
+    initialize_svp_table();
+
+    // setup the local domain_structs
+    if (options.DISTRIBUTED_DOMAIN) {
+        get_distributed_domain();
+    }
+    else {
+        scatter_locations();
+    }
+
+    // Set the local index value
+    for (i = 0; i < (size_t) local_domain.ncells_active; i++) {
+        local_domain.locations[i].local_idx = i;
+    }
+
+    // set up the hyperslabs for parallel I/O
+    if (options.PARALLEL_IO) {
+        initialize_par_io();
+    }
+
+    // group the processes of each compute node for the gather and scatter
+    if (options.HIERARCHICAL_IO) {
+        initialize_node_io();
+    }
+}
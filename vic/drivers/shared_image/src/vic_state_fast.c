@@ -0,0 +1,1368 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Save and restore the model state in the native BINARY_FAST format.
+ *
+ * Every process writes the raw state structures of its own cells to a file
+ * of its own, with the io_idx of the cells. The files can only be read back
+ * by a model run with the same domain and build. A run with another number
+ * of processes or another decomposition reads the files of the processes that
+ * wrote them and sends the state of every cell to the process that now runs
+ * it.
+ *
+ * The state of a cell is stored as a set of components (soil, energy, snow,
+ * vegetation, lake and save data). An incremental state file
+ * (STATE_INCREMENTAL) only holds the components that changed since its base
+ * state, plus a mask of the stored components of every cell.
+ *
+ * With STATE_ASYNC, vic_store_fast copies the state into a snapshot arena that
+ * is allocated once, and a checkpoint thread writes the snapshot while the
+ * model advances.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+#include <limits.h>
+
+static state_fast_base_struct     state_base;
+static state_fast_snapshot_struct state_snapshot;
+
+/******************************************************************************
+ * @brief    Hash the cells of the local domain.
+ * @details  64-bit FNV-1a hash of the global domain size and of the global
+ *           index and number of active vegetation tiles of every local cell.
+ *****************************************************************************/
+static unsigned long long
+get_state_fast_domain_hash(void)
+{
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern veg_con_map_struct *veg_con_map;
+
+    unsigned long long         hash = 14695981039346656037ULL;
+    size_t                     values[3];
+    unsigned char             *bytes;
+    size_t                     i;
+    size_t                     j;
+    size_t                     n;
+
+    for (i = 0; i <= local_domain.ncells_active; i++) {
+        if (i == 0) {
+            values[0] = global_domain.ncells_active;
+            values[1] = global_domain.n_nx;
+            values[2] = global_domain.n_ny;
+            n = 3;
+        }
+        else {
+            values[0] = local_domain.locations[i - 1].global_idx;
+            values[1] = veg_con_map[i - 1].nv_active;
+            n = 2;
+        }
+        bytes = (unsigned char *) values;
+        for (j = 0; j < n * sizeof(*values); j++) {
+            hash ^= bytes[j];
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+/******************************************************************************
+ * @brief    Fill the header of a BINARY_FAST state file for the local node.
+ *****************************************************************************/
+static void
+set_state_fast_header(state_fast_header_struct *header,
+                      dmy_struct               *dmy)
+{
+    extern domain_struct global_domain;
+    extern domain_struct local_domain;
+    extern option_struct options;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+
+    memset(header, 0, sizeof(*header));
+    strncpy(header->magic, STATE_FAST_MAGIC, sizeof(header->magic));
+    header->version = STATE_FAST_VERSION;
+    header->mpi_rank = mpi_rank;
+    header->mpi_size = mpi_size;
+    header->domain_hash = get_state_fast_domain_hash();
+    header->ncells = local_domain.ncells_active;
+    header->global_ncells = global_domain.ncells_active;
+    header->nlayer = options.Nlayer;
+    header->nnode = options.Nnode;
+    header->nfrost = options.Nfrost;
+    header->snow_band = options.SNOW_BAND;
+    header->ncanopy = options.Ncanopy;
+    header->nlakenodes = options.NLAKENODES;
+    header->lakes = options.LAKES;
+    header->carbon = options.CARBON;
+    header->cell_size = sizeof(cell_data_struct);
+    header->energy_size = sizeof(energy_bal_struct);
+    header->snow_size = sizeof(snow_data_struct);
+    header->veg_var_size = sizeof(veg_var_struct);
+    header->lake_var_size = sizeof(lake_var_struct);
+    header->save_data_size = sizeof(save_data_struct);
+    if (dmy != NULL) {
+        header->dmy = *dmy;
+    }
+}
+
+/******************************************************************************
+ * @brief    Number of bytes of one state component of a cell with nveg
+ *           active vegetation tiles.
+ *****************************************************************************/
+static size_t
+get_state_fast_nveg_size(size_t nveg,
+                         int    comp)
+{
+    extern option_struct options;
+
+    size_t               nitems;
+
+    // vegetation tiles and bare soil
+    nitems = (nveg + 1) * options.SNOW_BAND;
+
+    switch (comp) {
+    case STATE_FAST_CELL:
+        return nitems * sizeof(cell_data_struct);
+    case STATE_FAST_ENERGY:
+        return nitems * sizeof(energy_bal_struct);
+    case STATE_FAST_SNOW:
+        return nitems * sizeof(snow_data_struct);
+    case STATE_FAST_VEG_VAR:
+        if (options.CARBON) {
+            return nitems * (sizeof(veg_var_struct) +
+                             4 * options.Ncanopy * sizeof(double));
+        }
+        return nitems * sizeof(veg_var_struct);
+    case STATE_FAST_LAKE:
+        if (options.LAKES) {
+            return sizeof(lake_var_struct);
+        }
+        return 0;
+    case STATE_FAST_SAVE_DATA:
+        return sizeof(save_data_struct);
+    default:
+        log_err("Unknown state component %d", comp);
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Number of bytes of one state component of a local cell.
+ *****************************************************************************/
+static size_t
+get_state_fast_size(size_t i,
+                    int    comp)
+{
+    extern veg_con_map_struct *veg_con_map;
+
+    return get_state_fast_nveg_size(veg_con_map[i].nv_active, comp);
+}
+
+/******************************************************************************
+ * @brief    Copy one state component of a local cell to buf.
+ *****************************************************************************/
+static void
+pack_state_fast(size_t i,
+                int    comp,
+                char  *buf)
+{
+    extern all_vars_struct    *all_vars;
+    extern option_struct       options;
+    extern save_data_struct   *save_data;
+    extern veg_con_map_struct *veg_con_map;
+
+    veg_var_struct            *veg_var;
+    size_t                     j;
+    size_t                     k;
+    size_t                     n;
+    size_t                     nitems;
+
+    nitems = veg_con_map[i].nv_active + 1;
+    n = options.Ncanopy * sizeof(double);
+
+    for (j = 0; j < nitems; j++) {
+        switch (comp) {
+        case STATE_FAST_CELL:
+            memcpy(buf, all_vars[i].cell[j],
+                   options.SNOW_BAND * sizeof(cell_data_struct));
+            buf += options.SNOW_BAND * sizeof(cell_data_struct);
+            break;
+        case STATE_FAST_ENERGY:
+            memcpy(buf, all_vars[i].energy[j],
+                   options.SNOW_BAND * sizeof(energy_bal_struct));
+            buf += options.SNOW_BAND * sizeof(energy_bal_struct);
+            break;
+        case STATE_FAST_SNOW:
+            memcpy(buf, all_vars[i].snow[j],
+                   options.SNOW_BAND * sizeof(snow_data_struct));
+            buf += options.SNOW_BAND * sizeof(snow_data_struct);
+            break;
+        case STATE_FAST_VEG_VAR:
+            memcpy(buf, all_vars[i].veg_var[j],
+                   options.SNOW_BAND * sizeof(veg_var_struct));
+            buf += options.SNOW_BAND * sizeof(veg_var_struct);
+            if (options.CARBON) {
+                for (k = 0; k < options.SNOW_BAND; k++) {
+                    veg_var = &(all_vars[i].veg_var[j][k]);
+                    memcpy(buf, veg_var->CiLayer, n);
+                    memcpy(buf + n, veg_var->NscaleFactor, n);
+                    memcpy(buf + 2 * n, veg_var->rsLayer, n);
+                    memcpy(buf + 3 * n, veg_var->aPARLayer, n);
+                    buf += 4 * n;
+                }
+            }
+            break;
+        }
+    }
+    if (comp == STATE_FAST_LAKE && options.LAKES) {
+        // the cells without a lake have no lake variables, zeros are written
+        if (all_vars[i].lake_var != NULL) {
+            memcpy(buf, all_vars[i].lake_var, sizeof(lake_var_struct));
+        }
+        else {
+            memset(buf, 0, sizeof(lake_var_struct));
+        }
+    }
+    else if (comp == STATE_FAST_SAVE_DATA) {
+        memcpy(buf, &(save_data[i]), sizeof(save_data_struct));
+    }
+}
+
+/******************************************************************************
+ * @brief    Copy one state component of a local cell from buf.
+ * @details  The carbon arrays of the vegetation variables are copied into
+ *           the arrays of this run, their pointers are kept.
+ *****************************************************************************/
+static void
+unpack_state_fast(size_t i,
+                  int    comp,
+                  char  *buf)
+{
+    extern all_vars_struct    *all_vars;
+    extern option_struct       options;
+    extern save_data_struct   *save_data;
+    extern veg_con_map_struct *veg_con_map;
+
+    veg_var_struct            *veg_var;
+    veg_var_struct             tmp_veg_var;
+    size_t                     j;
+    size_t                     k;
+    size_t                     n;
+    size_t                     nitems;
+
+    nitems = veg_con_map[i].nv_active + 1;
+    n = options.Ncanopy * sizeof(double);
+
+    for (j = 0; j < nitems; j++) {
+        switch (comp) {
+        case STATE_FAST_CELL:
+            memcpy(all_vars[i].cell[j], buf,
+                   options.SNOW_BAND * sizeof(cell_data_struct));
+            buf += options.SNOW_BAND * sizeof(cell_data_struct);
+            break;
+        case STATE_FAST_ENERGY:
+            memcpy(all_vars[i].energy[j], buf,
+                   options.SNOW_BAND * sizeof(energy_bal_struct));
+            buf += options.SNOW_BAND * sizeof(energy_bal_struct);
+            break;
+        case STATE_FAST_SNOW:
+            memcpy(all_vars[i].snow[j], buf,
+                   options.SNOW_BAND * sizeof(snow_data_struct));
+            buf += options.SNOW_BAND * sizeof(snow_data_struct);
+            break;
+        case STATE_FAST_VEG_VAR:
+            for (k = 0; k < options.SNOW_BAND; k++) {
+                veg_var = &(all_vars[i].veg_var[j][k]);
+                memcpy(&tmp_veg_var, buf, sizeof(veg_var_struct));
+                tmp_veg_var.CiLayer = veg_var->CiLayer;
+                tmp_veg_var.NscaleFactor = veg_var->NscaleFactor;
+                tmp_veg_var.rsLayer = veg_var->rsLayer;
+                tmp_veg_var.aPARLayer = veg_var->aPARLayer;
+                *veg_var = tmp_veg_var;
+                buf += sizeof(veg_var_struct);
+            }
+            if (options.CARBON) {
+                for (k = 0; k < options.SNOW_BAND; k++) {
+                    veg_var = &(all_vars[i].veg_var[j][k]);
+                    memcpy(veg_var->CiLayer, buf, n);
+                    memcpy(veg_var->NscaleFactor, buf + n, n);
+                    memcpy(veg_var->rsLayer, buf + 2 * n, n);
+                    memcpy(veg_var->aPARLayer, buf + 3 * n, n);
+                    buf += 4 * n;
+                }
+            }
+            break;
+        }
+    }
+    if (comp == STATE_FAST_LAKE && options.LAKES) {
+        if (all_vars[i].lake_var != NULL) {
+            memcpy(all_vars[i].lake_var, buf, sizeof(lake_var_struct));
+        }
+    }
+    else if (comp == STATE_FAST_SAVE_DATA) {
+        memcpy(&(save_data[i]), buf, sizeof(save_data_struct));
+    }
+}
+
+/******************************************************************************
+ * @brief    Allocate a buffer for the largest state component of the local
+ *           cells.
+ *****************************************************************************/
+static char *
+alloc_state_fast_buffer(void)
+{
+    extern domain_struct local_domain;
+
+    char                *buf;
+    size_t               size = 0;
+    size_t               i;
+    int                  comp;
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+            size = max(size, get_state_fast_size(i, comp));
+        }
+    }
+    buf = malloc(size);
+    check_alloc_status(buf, "Memory allocation error");
+
+    return buf;
+}
+
+/******************************************************************************
+ * @brief    Number of bytes of the packed state components of all local
+ *           cells.
+ *****************************************************************************/
+static size_t
+get_state_fast_total_size(void)
+{
+    extern domain_struct local_domain;
+
+    size_t               size = 0;
+    size_t               i;
+    int                  comp;
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+            size += get_state_fast_size(i, comp);
+        }
+    }
+
+    return size;
+}
+
+/******************************************************************************
+ * @brief    Allocate the copy of the last saved or restored state.
+ *****************************************************************************/
+static void
+alloc_state_fast_base(void)
+{
+    if (state_base.data != NULL) {
+        return;
+    }
+    state_base.size = get_state_fast_total_size();
+    state_base.data = malloc(state_base.size);
+    check_alloc_status(state_base.data, "Memory allocation error");
+    state_base.valid = false;
+}
+
+/******************************************************************************
+ * @brief    Allocate the arena for the snapshot of the state of the local
+ *           cells.
+ *****************************************************************************/
+static void
+alloc_state_fast_snapshot(void)
+{
+    if (state_snapshot.data != NULL) {
+        return;
+    }
+    state_snapshot.size = get_state_fast_total_size();
+    state_snapshot.data = malloc(state_snapshot.size);
+    check_alloc_status(state_snapshot.data, "Memory allocation error");
+}
+
+/******************************************************************************
+ * @brief    Pack the state components of all local cells into data.
+ * @details  data holds the components in the order of the cells, which is
+ *           also the order of a complete BINARY_FAST state file.
+ *****************************************************************************/
+static void
+pack_state_fast_all(char *data)
+{
+    extern domain_struct local_domain;
+
+    size_t               i;
+    int                  comp;
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+            pack_state_fast(i, comp, data);
+            data += get_state_fast_size(i, comp);
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Write n items to a BINARY_FAST state file.
+ *****************************************************************************/
+static void
+write_state_fast(const void *ptr,
+                 size_t      size,
+                 size_t      n,
+                 FILE       *fp,
+                 char       *filename)
+{
+    if (fwrite(ptr, size, n, fp) != n) {
+        log_err("Error writing state file %s", filename);
+    }
+    add_vic_io_bytes(IO_PHASE_STATE, size * n);
+}
+
+/******************************************************************************
+ * @brief    Read n items from a BINARY_FAST state file.
+ *****************************************************************************/
+static void
+read_state_fast(void   *ptr,
+                size_t  size,
+                size_t  n,
+                FILE   *fp,
+                char   *filename)
+{
+    if (fread(ptr, size, n, fp) != n) {
+        log_err("Error reading state file %s, the file is truncated",
+                filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write the map of the local cells to a BINARY_FAST state file.
+ *****************************************************************************/
+static void
+write_state_fast_map(FILE *fp,
+                     char *filename)
+{
+    extern domain_struct       local_domain;
+    extern veg_con_map_struct *veg_con_map;
+
+    size_t                     cell[2];
+    size_t                     i;
+
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        cell[0] = local_domain.locations[i].io_idx;
+        cell[1] = veg_con_map[i].nv_active;
+        write_state_fast(cell, sizeof(*cell), 2, fp, filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Return whether a BINARY_FAST state file was written by the local
+ *           node for the cells that it runs.
+ *****************************************************************************/
+static bool
+is_state_fast_layout(state_fast_header_struct *header)
+{
+    extern domain_struct local_domain;
+    extern int           mpi_rank;
+    extern int           mpi_size;
+
+    return header->mpi_rank == mpi_rank && header->mpi_size == mpi_size &&
+           header->domain_hash == get_state_fast_domain_hash() &&
+           header->ncells == local_domain.ncells_active;
+}
+
+/******************************************************************************
+ * @brief    Read the header of a BINARY_FAST state file and check that it
+ *           matches this run.
+ * @details  With layout FALSE, the file may have been written by any process
+ *           of a run with another decomposition of the same domain.
+ *****************************************************************************/
+static void
+read_state_fast_header(state_fast_header_struct *header,
+                       FILE                     *fp,
+                       char                     *filename,
+                       bool                      layout)
+{
+    extern domain_struct     global_domain;
+
+    state_fast_header_struct expected;
+
+    read_state_fast(header, sizeof(*header), 1, fp, filename);
+    set_state_fast_header(&expected, NULL);
+    if (strncmp(header->magic, expected.magic, sizeof(header->magic)) != 0) {
+        log_err("%s is not a BINARY_FAST state file", filename);
+    }
+    if (header->version != expected.version) {
+        log_err("State file %s has version %u, expected version %u",
+                filename, header->version, expected.version);
+    }
+    if (layout && !is_state_fast_layout(header)) {
+        log_err("State file %s was written by process %d for a different "
+                "domain or decomposition", filename, header->mpi_rank);
+    }
+    if (!layout && header->global_ncells != global_domain.ncells_active) {
+        log_err("State file %s was written for a domain with %zu active "
+                "cells, this domain has %zu", filename, header->global_ncells,
+                global_domain.ncells_active);
+    }
+    if (header->nlayer != expected.nlayer ||
+        header->nnode != expected.nnode ||
+        header->nfrost != expected.nfrost ||
+        header->snow_band != expected.snow_band ||
+        header->ncanopy != expected.ncanopy ||
+        header->nlakenodes != expected.nlakenodes ||
+        header->lakes != expected.lakes ||
+        header->carbon != expected.carbon) {
+        log_err("The model options of state file %s do not match the "
+                "options of this run", filename);
+    }
+    if (header->cell_size != expected.cell_size ||
+        header->energy_size != expected.energy_size ||
+        header->snow_size != expected.snow_size ||
+        header->veg_var_size != expected.veg_var_size ||
+        header->lake_var_size != expected.lake_var_size ||
+        header->save_data_size != expected.save_data_size) {
+        log_err("State file %s was written by an incompatible build of VIC",
+                filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read a BINARY_FAST state into all_vars and save_data.
+ * @details  An incremental state is read on top of its base state, which is
+ *           read first.
+ *****************************************************************************/
+static void
+read_state_fast_file(char   *filename,
+                     size_t  depth)
+{
+    extern domain_struct     local_domain;
+    extern int               mpi_rank;
+
+    char                     rank_filename[MAXSTRING];
+    FILE                    *fp;
+    state_fast_header_struct header;
+    unsigned char           *mask = NULL;
+    char                    *buf;
+    size_t                   i;
+    int                      comp;
+
+    snprintf(rank_filename, MAXSTRING, "%s.%04d", filename, mpi_rank);
+    fp = fopen(rank_filename, "rb");
+    if (fp == NULL) {
+        log_err("Unable to open state file %s", rank_filename);
+    }
+
+    read_state_fast_header(&header, fp, rank_filename, true);
+    // the cells are those of the local node
+    if (fseek(fp, (long) (2 * header.ncells * sizeof(size_t)), SEEK_CUR) !=
+        0) {
+        log_err("Error reading state file %s, the file is truncated",
+                rank_filename);
+    }
+    debug("reading state for %04d-%02d-%02d-%05u from %s", header.dmy.year,
+          header.dmy.month, header.dmy.day, header.dmy.dayseconds,
+          rank_filename);
+
+    if (header.incremental) {
+        if (depth >= MAX_STATE_FAST_DEPTH) {
+            log_err("State file %s is more than %d increments away from a "
+                    "full state", rank_filename, MAX_STATE_FAST_DEPTH);
+        }
+        read_state_fast_file(header.base, depth + 1);
+
+        mask = malloc(local_domain.ncells_active * sizeof(*mask));
+        check_alloc_status(mask, "Memory allocation error");
+        read_state_fast(mask, sizeof(*mask), local_domain.ncells_active, fp,
+                        rank_filename);
+    }
+
+    buf = alloc_state_fast_buffer();
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+            if (mask != NULL && !(mask[i] & (1 << comp))) {
+                continue;
+            }
+            read_state_fast(buf, 1, get_state_fast_size(i, comp), fp,
+                            rank_filename);
+            unpack_state_fast(i, comp, buf);
+        }
+    }
+    free(buf);
+    free(mask);
+
+    if (fclose(fp) != 0) {
+        log_err("Error closing state file %s", rank_filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Number of bytes of all state components of a cell with nveg
+ *           active vegetation tiles.
+ *****************************************************************************/
+static size_t
+get_state_fast_cell_size(size_t nveg)
+{
+    size_t size = 0;
+    int    comp;
+
+    for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+        size += get_state_fast_nveg_size(nveg, comp);
+    }
+
+    return size;
+}
+
+/******************************************************************************
+ * @brief    Read the BINARY_FAST state that a process of another
+ *           decomposition wrote.
+ * @details  An incremental state is applied to its base state, which was
+ *           written by the same process for the same cells.
+ *
+ * @return   FALSE if the process did not write a state file, i.e. it had no
+ *           active cells
+ *****************************************************************************/
+static bool
+read_state_fast_piece(char                    *filename,
+                      int                      rank,
+                      size_t                   depth,
+                      state_fast_piece_struct *piece)
+{
+    char                     rank_filename[MAXSTRING];
+    FILE                    *fp;
+    state_fast_header_struct header;
+    state_fast_piece_struct  base;
+    unsigned char           *mask = NULL;
+    size_t                  *cells;
+    char                    *data;
+    size_t                   size;
+    size_t                   i;
+    int                      comp;
+
+    snprintf(rank_filename, MAXSTRING, "%s.%04d", filename, rank);
+    fp = fopen(rank_filename, "rb");
+    if (fp == NULL) {
+        if (depth > 0) {
+            log_err("Unable to open state file %s", rank_filename);
+        }
+        return false;
+    }
+
+    read_state_fast_header(&header, fp, rank_filename, false);
+    if (header.mpi_rank != rank) {
+        log_err("State file %s was written by process %d", rank_filename,
+                header.mpi_rank);
+    }
+
+    piece->ncells = header.ncells;
+    piece->io_idx = malloc(piece->ncells * sizeof(*(piece->io_idx)));
+    check_alloc_status(piece->io_idx, "Memory allocation error");
+    piece->nveg = malloc(piece->ncells * sizeof(*(piece->nveg)));
+    check_alloc_status(piece->nveg, "Memory allocation error");
+    cells = malloc(2 * piece->ncells * sizeof(*cells));
+    check_alloc_status(cells, "Memory allocation error");
+    read_state_fast(cells, sizeof(*cells), 2 * piece->ncells, fp,
+                    rank_filename);
+    piece->size = 0;
+    for (i = 0; i < piece->ncells; i++) {
+        piece->io_idx[i] = cells[2 * i];
+        piece->nveg[i] = cells[2 * i + 1];
+        piece->size += get_state_fast_cell_size(piece->nveg[i]);
+    }
+    free(cells);
+
+    if (header.incremental) {
+        if (depth >= MAX_STATE_FAST_DEPTH) {
+            log_err("State file %s is more than %d increments away from a "
+                    "full state", rank_filename, MAX_STATE_FAST_DEPTH);
+        }
+        read_state_fast_piece(header.base, rank, depth + 1, &base);
+        if (base.ncells != piece->ncells ||
+            memcmp(base.io_idx, piece->io_idx,
+                   piece->ncells * sizeof(*(piece->io_idx))) != 0) {
+            log_err("State file %s has other cells than its base state %s",
+                    rank_filename, header.base);
+        }
+        piece->data = base.data;
+        free(base.io_idx);
+        free(base.nveg);
+
+        mask = malloc(piece->ncells * sizeof(*mask));
+        check_alloc_status(mask, "Memory allocation error");
+        read_state_fast(mask, sizeof(*mask), piece->ncells, fp,
+                        rank_filename);
+    }
+    else {
+        piece->data = malloc(piece->size);
+        check_alloc_status(piece->data, "Memory allocation error");
+    }
+
+    // the stored components of the cells, in the order of the cells
+    data = piece->data;
+    for (i = 0; i < piece->ncells; i++) {
+        for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+            size = get_state_fast_nveg_size(piece->nveg[i], comp);
+            if (mask == NULL || (mask[i] & (1 << comp))) {
+                read_state_fast(data, 1, size, fp, rank_filename);
+            }
+            data += size;
+        }
+    }
+    free(mask);
+
+    if (fclose(fp) != 0) {
+        log_err("Error closing state file %s", rank_filename);
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Node of this run that runs the cell of a state file of another
+ *           decomposition.
+ *
+ * @param io_idx   io_idx of the cell
+ * @param map      position of every cell in the cells of all nodes
+ *                 [ncells_total], ncells_total if the cell is not run
+ * @param displs   position of the first cell of every node [mpi_size]
+ * @param filename name of the state
+ *****************************************************************************/
+static int
+get_state_fast_owner(size_t  io_idx,
+                     size_t *map,
+                     int    *displs,
+                     char   *filename)
+{
+    extern domain_struct global_domain;
+    extern int           mpi_size;
+
+    int                  first = 0;
+    int                  last = mpi_size - 1;
+    int                  mid;
+
+    if (io_idx >= global_domain.ncells_total ||
+        map[io_idx] == global_domain.ncells_total) {
+        log_err("The state of cell %zu is in %s, but the cell is not run",
+                io_idx, filename);
+    }
+
+    // the last node whose first cell is at or before the cell, nodes
+    // without cells have the position of the next node
+    while (first < last) {
+        mid = (first + last + 1) / 2;
+        if ((size_t) displs[mid] <= map[io_idx]) {
+            first = mid;
+        }
+        else {
+            last = mid - 1;
+        }
+    }
+
+    return first;
+}
+
+/******************************************************************************
+ * @brief    Read a BINARY_FAST state that was written with another number of
+ *           processes or another decomposition of the domain.
+ * @details  The state files of the nfiles processes of the other run are
+ *           read round-robin by the nodes of this run. The state of every
+ *           cell is sent, with its io_idx and number of vegetation tiles, to
+ *           the node that runs the cell in this decomposition, with one
+ *           MPI_Alltoallv. Collective over MPI_COMM_VIC.
+ *****************************************************************************/
+static void
+read_state_fast_repartition(char *filename,
+                            int   nfiles)
+{
+    extern domain_struct       global_domain;
+    extern domain_struct       local_domain;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern int                 mpi_rank;
+    extern int                 mpi_size;
+    extern veg_con_map_struct *veg_con_map;
+
+    state_fast_piece_struct   *pieces;
+    size_t                    *ncells;
+    size_t                    *io_idx;
+    size_t                    *local_io_idx;
+    size_t                    *map;
+    size_t                    *send_pos;
+    int                       *counts;
+    int                       *displs;
+    int                       *send_counts;
+    int                       *send_displs;
+    int                       *recv_counts;
+    int                       *recv_displs;
+    bool                      *restored;
+    char                      *sendbuf;
+    char                      *recvbuf;
+    char                      *data;
+    char                      *buf;
+    size_t                     cell[2];
+    size_t                     npieces = 0;
+    size_t                     ntotal;
+    size_t                     nrecv;
+    size_t                     pos;
+    size_t                     size;
+    size_t                     i;
+    size_t                     j;
+    int                        owner;
+    int                        comp;
+    int                        status;
+    int                        f;
+
+    // the io_idx of the cells of every node of this run, in the order of the
+    // nodes and of their local cells
+    ncells = malloc(mpi_size * sizeof(*ncells));
+    check_alloc_status(ncells, "Memory allocation error");
+    counts = malloc(mpi_size * sizeof(*counts));
+    check_alloc_status(counts, "Memory allocation error");
+    displs = malloc(mpi_size * sizeof(*displs));
+    check_alloc_status(displs, "Memory allocation error");
+    status = MPI_Allgather(&(local_domain.ncells_active), 1,
+                           MPI_UNSIGNED_LONG, ncells, 1, MPI_UNSIGNED_LONG,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    for (f = 0, ntotal = 0; f < mpi_size; f++) {
+        counts[f] = (int) ncells[f];
+        displs[f] = (int) ntotal;
+        ntotal += ncells[f];
+    }
+    free(ncells);
+
+    local_io_idx = malloc((local_domain.ncells_active > 0 ?
+                           local_domain.ncells_active : 1) *
+                          sizeof(*local_io_idx));
+    check_alloc_status(local_io_idx, "Memory allocation error");
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        local_io_idx[i] = local_domain.locations[i].io_idx;
+    }
+    io_idx = malloc((ntotal > 0 ? ntotal : 1) * sizeof(*io_idx));
+    check_alloc_status(io_idx, "Memory allocation error");
+    status = MPI_Allgatherv(local_io_idx, counts[mpi_rank], MPI_UNSIGNED_LONG,
+                            io_idx, counts, displs, MPI_UNSIGNED_LONG,
+                            MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    free(local_io_idx);
+
+    map = malloc(global_domain.ncells_total * sizeof(*map));
+    check_alloc_status(map, "Memory allocation error");
+    for (i = 0; i < global_domain.ncells_total; i++) {
+        map[i] = global_domain.ncells_total;
+    }
+    for (i = 0; i < ntotal; i++) {
+        map[io_idx[i]] = i;
+    }
+    free(io_idx);
+
+    // the state files of the other run
+    pieces = malloc(((size_t) (nfiles / mpi_size) + 1) * sizeof(*pieces));
+    check_alloc_status(pieces, "Memory allocation error");
+    for (f = mpi_rank; f < nfiles; f += mpi_size) {
+        if (read_state_fast_piece(filename, f, 0, &(pieces[npieces]))) {
+            npieces++;
+        }
+    }
+
+    // the cells of the files are sent to the nodes that run them, as
+    // [io_idx, nveg, components] for every cell
+    send_pos = calloc(mpi_size, sizeof(*send_pos));
+    check_alloc_status(send_pos, "Memory allocation error");
+    for (j = 0; j < npieces; j++) {
+        for (i = 0; i < pieces[j].ncells; i++) {
+            owner = get_state_fast_owner(pieces[j].io_idx[i], map, displs,
+                                         filename);
+            send_pos[owner] += sizeof(cell) +
+                               get_state_fast_cell_size(pieces[j].nveg[i]);
+        }
+    }
+    send_counts = malloc(mpi_size * sizeof(*send_counts));
+    check_alloc_status(send_counts, "Memory allocation error");
+    send_displs = malloc(mpi_size * sizeof(*send_displs));
+    check_alloc_status(send_displs, "Memory allocation error");
+    for (f = 0, pos = 0; f < mpi_size; f++) {
+        if (pos + send_pos[f] > INT_MAX) {
+            log_err("The state of the cells of %s is too large to be "
+                    "redistributed", filename);
+        }
+        send_counts[f] = (int) send_pos[f];
+        send_displs[f] = (int) pos;
+        send_pos[f] = pos;
+        pos += (size_t) send_counts[f];
+    }
+    sendbuf = malloc(pos > 0 ? pos : 1);
+    check_alloc_status(sendbuf, "Memory allocation error");
+    for (j = 0; j < npieces; j++) {
+        data = pieces[j].data;
+        for (i = 0; i < pieces[j].ncells; i++) {
+            owner = get_state_fast_owner(pieces[j].io_idx[i], map, displs,
+                                         filename);
+            size = get_state_fast_cell_size(pieces[j].nveg[i]);
+            cell[0] = pieces[j].io_idx[i];
+            cell[1] = pieces[j].nveg[i];
+            memcpy(sendbuf + send_pos[owner], cell, sizeof(cell));
+            memcpy(sendbuf + send_pos[owner] + sizeof(cell), data, size);
+            send_pos[owner] += sizeof(cell) + size;
+            data += size;
+        }
+        free(pieces[j].io_idx);
+        free(pieces[j].nveg);
+        free(pieces[j].data);
+    }
+    free(pieces);
+    free(send_pos);
+
+    recv_counts = malloc(mpi_size * sizeof(*recv_counts));
+    check_alloc_status(recv_counts, "Memory allocation error");
+    recv_displs = malloc(mpi_size * sizeof(*recv_displs));
+    check_alloc_status(recv_displs, "Memory allocation error");
+    status = MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT,
+                          MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    for (f = 0, nrecv = 0; f < mpi_size; f++) {
+        if (nrecv + (size_t) recv_counts[f] > INT_MAX) {
+            log_err("The state of the cells of %s is too large to be "
+                    "redistributed", filename);
+        }
+        recv_displs[f] = (int) nrecv;
+        nrecv += (size_t) recv_counts[f];
+    }
+    recvbuf = malloc(nrecv > 0 ? nrecv : 1);
+    check_alloc_status(recvbuf, "Memory allocation error");
+    status = MPI_Alltoallv(sendbuf, send_counts, send_displs, MPI_BYTE,
+                           recvbuf, recv_counts, recv_displs, MPI_BYTE,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    free(sendbuf);
+
+    // the state of the local cells, every cell must be restored once
+    restored = calloc(local_domain.ncells_active > 0 ?
+                      local_domain.ncells_active : 1, sizeof(*restored));
+    check_alloc_status(restored, "Memory allocation error");
+    buf = alloc_state_fast_buffer();
+    for (pos = 0; pos < nrecv;) {
+        memcpy(cell, recvbuf + pos, sizeof(cell));
+        pos += sizeof(cell);
+        i = map[cell[0]] - (size_t) displs[mpi_rank];
+        if (restored[i]) {
+            log_err("The state files %s.* hold more than one state for "
+                    "cell %zu", filename, cell[0]);
+        }
+        if (cell[1] != veg_con_map[i].nv_active) {
+            log_err("The state of cell %zu in %s has %zu vegetation tiles, "
+                    "the cell has %zu", cell[0], filename, cell[1],
+                    veg_con_map[i].nv_active);
+        }
+        for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+            size = get_state_fast_size(i, comp);
+            memcpy(buf, recvbuf + pos, size);
+            unpack_state_fast(i, comp, buf);
+            pos += size;
+        }
+        restored[i] = true;
+    }
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (!restored[i]) {
+            log_err("The state files %s.* hold no state for cell %zu",
+                    filename, local_domain.locations[i].io_idx);
+        }
+    }
+    free(buf);
+    free(restored);
+    free(recvbuf);
+    free(recv_displs);
+    free(recv_counts);
+    free(send_displs);
+    free(send_counts);
+    free(map);
+    free(displs);
+    free(counts);
+}
+
+/******************************************************************************
+ * @brief    Write the snapshot of the state of the local cells to its state
+ *           file.
+ * @details  Called by the main thread, or by the checkpoint thread when
+ *           STATE_ASYNC is TRUE. Only the snapshot, the base state and
+ *           read-only model parameters are used.
+ *
+ *           With STATE_INCREMENTAL, the snapshot is compared with the base
+ *           state. Only the components that changed are written, and the
+ *           snapshot becomes the base of the next state.
+ *****************************************************************************/
+static void
+write_state_fast_snapshot(state_fast_snapshot_struct *snapshot)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+
+    FILE                *fp;
+    unsigned char       *mask;
+    char                *data;
+    char                *base;
+    size_t               size;
+    size_t               i;
+    int                  comp;
+
+    fp = fopen(snapshot->filename, "wb");
+    if (fp == NULL) {
+        log_err("Unable to open state file %s", snapshot->filename);
+    }
+
+    if (!options.STATE_INCREMENTAL) {
+        write_state_fast(&(snapshot->header), sizeof(snapshot->header), 1,
+                         fp, snapshot->filename);
+        write_state_fast_map(fp, snapshot->filename);
+        write_state_fast(snapshot->data, 1, snapshot->size, fp,
+                         snapshot->filename);
+    }
+    else {
+        alloc_state_fast_base();
+        if (state_base.valid) {
+            snapshot->header.incremental = true;
+            strncpy(snapshot->header.base, state_base.name,
+                    sizeof(snapshot->header.base));
+        }
+        write_state_fast(&(snapshot->header), sizeof(snapshot->header), 1,
+                         fp, snapshot->filename);
+        write_state_fast_map(fp, snapshot->filename);
+
+        // mark the components that changed and update the base state
+        mask = calloc(local_domain.ncells_active, sizeof(*mask));
+        check_alloc_status(mask, "Memory allocation error");
+        data = snapshot->data;
+        base = state_base.data;
+        for (i = 0; i < local_domain.ncells_active; i++) {
+            for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+                size = get_state_fast_size(i, comp);
+                if (!snapshot->header.incremental ||
+                    memcmp(data, base, size) != 0) {
+                    mask[i] |= 1 << comp;
+                    memcpy(base, data, size);
+                }
+                data += size;
+                base += size;
+            }
+        }
+        if (snapshot->header.incremental) {
+            write_state_fast(mask, sizeof(*mask), local_domain.ncells_active,
+                             fp, snapshot->filename);
+        }
+        base = state_base.data;
+        for (i = 0; i < local_domain.ncells_active; i++) {
+            for (comp = 0; comp < N_STATE_FAST_COMPONENTS; comp++) {
+                size = get_state_fast_size(i, comp);
+                if (mask[i] & (1 << comp)) {
+                    write_state_fast(base, 1, size, fp, snapshot->filename);
+                }
+                base += size;
+            }
+        }
+        free(mask);
+        strncpy(state_base.name, snapshot->name, sizeof(state_base.name));
+        state_base.valid = true;
+    }
+
+    if (fclose(fp) != 0) {
+        log_err("Error closing state file %s", snapshot->filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Checkpoint thread: write the pending snapshots.
+ *****************************************************************************/
+static void *
+write_state_fast_thread(void *arg)
+{
+    state_fast_snapshot_struct *snapshot = (state_fast_snapshot_struct *) arg;
+
+    pthread_mutex_lock(&(snapshot->mutex));
+    while (true) {
+        while (!snapshot->pending && !snapshot->done) {
+            pthread_cond_wait(&(snapshot->cond), &(snapshot->mutex));
+        }
+        if (!snapshot->pending) {
+            break;
+        }
+        pthread_mutex_unlock(&(snapshot->mutex));
+
+        write_state_fast_snapshot(snapshot);
+
+        pthread_mutex_lock(&(snapshot->mutex));
+        snapshot->pending = false;
+        pthread_cond_broadcast(&(snapshot->cond));
+    }
+    pthread_mutex_unlock(&(snapshot->mutex));
+
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief    Allocate the snapshot arena and start the checkpoint thread.
+ * @details  Only used with STATE_ASYNC. Nodes without active cells do not
+ *           write state files and do not start a thread.
+ *****************************************************************************/
+void
+initialize_async_state(void)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+
+    int                  status;
+
+    if (!options.STATE_ASYNC || local_domain.ncells_active == 0) {
+        return;
+    }
+
+    alloc_state_fast_snapshot();
+    state_snapshot.pending = false;
+    state_snapshot.done = false;
+
+    pthread_mutex_init(&(state_snapshot.mutex), NULL);
+    pthread_cond_init(&(state_snapshot.cond), NULL);
+    status = pthread_create(&(state_snapshot.thread), NULL,
+                            write_state_fast_thread, &state_snapshot);
+    if (status != 0) {
+        log_err("Could not start checkpoint thread: %d", status);
+    }
+    state_snapshot.active = true;
+}
+
+/******************************************************************************
+ * @brief    Wait until the pending snapshot has been written.
+ *****************************************************************************/
+void
+wait_async_state(void)
+{
+    if (!state_snapshot.active) {
+        return;
+    }
+
+    pthread_mutex_lock(&(state_snapshot.mutex));
+    while (state_snapshot.pending) {
+        pthread_cond_wait(&(state_snapshot.cond), &(state_snapshot.mutex));
+    }
+    pthread_mutex_unlock(&(state_snapshot.mutex));
+}
+
+/******************************************************************************
+ * @brief    Write the pending snapshot, stop the checkpoint thread and free
+ *           the snapshot arena.
+ *****************************************************************************/
+void
+finalize_async_state(void)
+{
+    int status;
+
+    if (state_snapshot.active) {
+        pthread_mutex_lock(&(state_snapshot.mutex));
+        state_snapshot.done = true;
+        pthread_cond_broadcast(&(state_snapshot.cond));
+        pthread_mutex_unlock(&(state_snapshot.mutex));
+
+        status = pthread_join(state_snapshot.thread, NULL);
+        if (status != 0) {
+            log_err("Could not join checkpoint thread: %d", status);
+        }
+        state_snapshot.active = false;
+
+        pthread_cond_destroy(&(state_snapshot.cond));
+        pthread_mutex_destroy(&(state_snapshot.mutex));
+    }
+    free(state_snapshot.data);
+    state_snapshot.data = NULL;
+}
+
+/******************************************************************************
+ * @brief    Save model state in the BINARY_FAST format.
+ * @details  filename is the name of the state, the local node writes to
+ *           filename.<rank>. Nodes without active cells do not write a file.
+ *
+ *           The state is first copied into a contiguous snapshot. With
+ *           STATE_ASYNC, the checkpoint thread writes the snapshot while the
+ *           model advances, otherwise it is written before returning.
+ *****************************************************************************/
+void
+vic_store_fast(dmy_struct *dmy_current,
+               char       *filename)
+{
+    extern domain_struct local_domain;
+    extern int           mpi_rank;
+
+    if (local_domain.ncells_active == 0) {
+        return;
+    }
+
+    // the previous snapshot must have been written
+    wait_async_state();
+
+    alloc_state_fast_snapshot();
+    set_state_fast_header(&(state_snapshot.header), dmy_current);
+    strncpy(state_snapshot.name, filename, sizeof(state_snapshot.name));
+    snprintf(state_snapshot.filename, MAXSTRING, "%s.%04d", filename,
+             mpi_rank);
+    pack_state_fast_all(state_snapshot.data);
+
+    if (state_snapshot.active) {
+        pthread_mutex_lock(&(state_snapshot.mutex));
+        state_snapshot.pending = true;
+        pthread_cond_broadcast(&(state_snapshot.cond));
+        pthread_mutex_unlock(&(state_snapshot.mutex));
+    }
+    else {
+        write_state_fast_snapshot(&state_snapshot);
+    }
+}
+
+/******************************************************************************
+ * @brief    Check whether the BINARY_FAST state files of a state were written
+ *           with the decomposition of this run.
+ * @details  Collective over MPI_COMM_VIC.
+ *
+ * @param filename name of the state
+ * @param nfiles   number of processes of the run that wrote the state
+ *
+ * @return   TRUE if every node of this run wrote the file of its rank for
+ *           the cells that it runs
+ *****************************************************************************/
+static bool
+check_state_fast_layout(char *filename,
+                        int  *nfiles)
+{
+    extern domain_struct     local_domain;
+    extern MPI_Comm          MPI_COMM_VIC;
+    extern int               mpi_rank;
+
+    char                     rank_filename[MAXSTRING];
+    FILE                    *fp;
+    state_fast_header_struct header;
+    int                      layout[2];
+    int                      all[2];
+    int                      status;
+
+    // [0]: the file of the rank matches, [1]: processes of the other run
+    layout[0] = 1;
+    layout[1] = 0;
+    snprintf(rank_filename, MAXSTRING, "%s.%04d", filename, mpi_rank);
+    fp = fopen(rank_filename, "rb");
+    if (fp != NULL) {
+        read_state_fast_header(&header, fp, rank_filename, false);
+        layout[0] = is_state_fast_layout(&header);
+        layout[1] = header.mpi_size;
+        if (fclose(fp) != 0) {
+            log_err("Error closing state file %s", rank_filename);
+        }
+    }
+    else if (local_domain.ncells_active > 0) {
+        layout[0] = 0;
+    }
+
+    status = MPI_Allreduce(&(layout[0]), &(all[0]), 1, MPI_INT, MPI_MIN,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Allreduce(&(layout[1]), &(all[1]), 1, MPI_INT, MPI_MAX,
+                           MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (all[1] == 0 && local_domain.ncells_active > 0) {
+        log_err("Unable to open state file %s", rank_filename);
+    }
+    *nfiles = all[1];
+
+    return all[0] == 1;
+}
+
+/******************************************************************************
+ * @brief    Read initial model state in the BINARY_FAST format.
+ * @details  The local node reads filenames.init_state.<rank>. Nodes without
+ *           active cells (e.g. I/O servers) have nothing to read. If the
+ *           state was written with another number of processes or another
+ *           decomposition of the domain, the state files of all processes
+ *           are read and redistributed to the nodes that run their cells.
+ *           Called by all nodes.
+ *
+ *           With STATE_INCREMENTAL, the restored state is kept as the base
+ *           of the next saved state, unless it was redistributed, in which
+ *           case the next saved state is complete.
+ *****************************************************************************/
+void
+vic_restore_fast(void)
+{
+    extern domain_struct    local_domain;
+    extern filenames_struct filenames;
+    extern option_struct    options;
+    extern int              mpi_rank;
+
+    int                     nfiles;
+
+    if (!check_state_fast_layout(filenames.init_state, &nfiles)) {
+        if (mpi_rank == VIC_MPI_ROOT) {
+            log_info("Redistributing the state %s of %d processes",
+                     filenames.init_state, nfiles);
+        }
+        read_state_fast_repartition(filenames.init_state, nfiles);
+        return;
+    }
+
+    if (local_domain.ncells_active == 0) {
+        return;
+    }
+
+    read_state_fast_file(filenames.init_state, 0);
+
+    if (options.STATE_INCREMENTAL) {
+        alloc_state_fast_base();
+        pack_state_fast_all(state_base.data);
+        strncpy(state_base.name, filenames.init_state,
+                sizeof(state_base.name));
+        state_base.valid = true;
+    }
+}
+
+/******************************************************************************
+ * @brief    Read the model state of the local node from a BINARY_FAST state
+ *           file other than the initial state, e.g. a checkpoint.
+ *****************************************************************************/
+void
+vic_restore_fast_file(char *filename)
+{
+    extern domain_struct local_domain;
+
+    if (local_domain.ncells_active == 0) {
+        return;
+    }
+
+    read_state_fast_file(filename, 0);
+}
+
+/******************************************************************************
+ * @brief    Free the copy of the last saved or restored state.
+ *****************************************************************************/
+void
+free_state_fast_base(void)
+{
+    free(state_base.data);
+    state_base.data = NULL;
+    state_base.valid = false;
+}
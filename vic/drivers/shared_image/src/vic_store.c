@@ -25,6 +25,7 @@
  *****************************************************************************/
 
 #include <vic_driver_shared_image.h>
+#include <sys/stat.h>
 
 /******************************************************************************
  * @brief    Save model state.
@@ -36,10 +37,13 @@ vic_store(dmy_struct *dmy_current,
     extern filenames_struct    filenames;
     extern all_vars_struct    *all_vars;
     extern domain_struct       local_domain;
+    extern size_t             *lake_cells;
+    extern size_t              nlake_cells;
     extern option_struct       options;
     extern veg_con_map_struct *veg_con_map;
     extern int                 mpi_rank;
     extern global_param_struct global_param;
+    extern timer_struct        global_timers[N_TIMERS];
 
     int                        status;
     int                        v;
@@ -47,16 +51,34 @@ vic_store(dmy_struct *dmy_current,
     size_t                     j;
     size_t                     k;
     size_t                     m;
+    size_t                     n;
     size_t                     p;
     int                       *ivar = NULL;
     double                    *dvar = NULL;
-    size_t                     d2start[2];
-    size_t                     d3start[3];
-    size_t                     d4start[4];
-    size_t                     d5start[5];
-    size_t                     d6start[6];
+    size_t                     nslices;
+    size_t                     offset;
+    size_t                     nvalues;
+    size_t                     dstart[MAXDIMS];
     nc_file_struct             nc_state_file;
     nc_var_struct             *nc_var;
+    struct stat                st;
+
+    timer_continue(&(global_timers[TIMER_VIC_STATE_WRITE]));
+
+    if (options.STATE_FORMAT == BINARY_FAST) {
+        sprintf(filename, "%s.%04i%02i%02i_%05u.bin",
+                filenames.statefile, global_param.stateyear,
+                global_param.statemonth, global_param.stateday,
+                global_param.statesec);
+        vic_store_fast(dmy_current, filename);
+        vic_store_streams(filename);
+        timer_stop(&(global_timers[TIMER_VIC_STATE_WRITE]));
+        return;
+    }
+
+    // the history writer thread must be done before the netCDF library is
+    // used
+    wait_async_output();
 
     set_nc_state_file_info(&nc_state_file);
 
@@ -73,40 +95,25 @@ vic_store(dmy_struct *dmy_current,
 
     // write state variables
 
-    // allocate memory for variables to be stored
-    ivar = malloc(local_domain.ncells_active * sizeof(*ivar));
-    check_alloc_status(ivar, "Memory allocation error");
+    // each state variable is gathered and written as one block of 2-D
+    // slices, allocate memory for the largest block
+    nslices = max(options.Nlayer * options.Nfrost, options.Nnode);
+    nslices *= options.NVEGTYPES * options.SNOW_BAND;
+    if (options.LAKES && options.NLAKENODES > nslices) {
+        nslices = options.NLAKENODES;
+    }
 
+    nvalues = nslices * local_domain.ncells_active;
+    ivar = malloc(nvalues * sizeof(*ivar));
+    check_alloc_status(ivar, "Memory allocation error");
 
-    dvar = malloc(local_domain.ncells_active * sizeof(*dvar));
+    dvar = malloc(nvalues * sizeof(*dvar));
     check_alloc_status(dvar, "Memory allocation error");
 
-
-    // initialize starts and counts
-    d2start[0] = 0;
-    d2start[1] = 0;
-
-    d3start[0] = 0;
-    d3start[1] = 0;
-    d3start[2] = 0;
-
-    d4start[0] = 0;
-    d4start[1] = 0;
-    d4start[2] = 0;
-    d4start[3] = 0;
-
-    d5start[0] = 0;
-    d5start[1] = 0;
-    d5start[2] = 0;
-    d5start[3] = 0;
-    d5start[4] = 0;
-
-    d6start[0] = 0;
-    d6start[1] = 0;
-    d6start[2] = 0;
-    d6start[3] = 0;
-    d6start[4] = 0;
-    d6start[5] = 0;
+    // blocks always start at the origin of the state variable
+    for (i = 0; i < MAXDIMS; i++) {
+        dstart[i] = 0;
+    }
 
     // set missing values
     for (i = 0; i < local_domain.ncells_active; i++) {
@@ -116,689 +123,639 @@ vic_store(dmy_struct *dmy_current,
 
     // total soil moisture
     nc_var = &(nc_state_file.nc_vars[STATE_SOIL_MOISTURE]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND * options.Nlayer;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d5start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d5start[1] = k;
             for (j = 0; j < options.Nlayer; j++) {
-                d5start[2] = j;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] =
+                        dvar[offset + i] =
                             (double) all_vars[i].cell[v][k].layer[j].moist;
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d5start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
     // ice content
     nc_var = &(nc_state_file.nc_vars[STATE_SOIL_ICE]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND * options.Nlayer *
+              options.Nfrost;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d6start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d6start[1] = k;
             for (j = 0; j < options.Nlayer; j++) {
-                d6start[2] = j;
                 for (p = 0; p < options.Nfrost; p++) {
-                    d6start[3] = p;
                     for (i = 0; i < local_domain.ncells_active; i++) {
                         v = veg_con_map[i].vidx[m];
                         if (v >= 0) {
-                            dvar[i] =
+                            dvar[offset + i] =
                                 (double) all_vars[i].cell[v][k].layer[j].ice[p];
                         }
                         else {
-                            dvar[i] = nc_state_file.d_fillvalue;
+                            dvar[offset + i] = nc_state_file.d_fillvalue;
                         }
                     }
-                    gather_put_nc_field_double(nc_state_file.nc_id,
-                                               nc_var->nc_varid,
-                                               nc_state_file.d_fillvalue,
-                                               d6start, nc_var->nc_counts,
-                                               dvar);
-                    for (i = 0; i < local_domain.ncells_active; i++) {
-                        dvar[i] = nc_state_file.d_fillvalue;
-                    }
+                    offset += local_domain.ncells_active;
                 }
             }
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // dew storage: tmpval = veg_var[veg][band].Wdew;
     nc_var = &(nc_state_file.nc_vars[STATE_CANOPY_WATER]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].veg_var[v][k].Wdew;
+                    dvar[offset + i] = (double) all_vars[i].veg_var[v][k].Wdew;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     if (options.CARBON) {
         // cumulative NPP: tmpval = veg_var[veg][band].AnnualNPP;
         nc_var = &(nc_state_file.nc_vars[STATE_ANNUALNPP]);
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] = (double) all_vars[i].veg_var[v][k].AnnualNPP;
+                        dvar[offset + i] =
+                            (double) all_vars[i].veg_var[v][k].AnnualNPP;
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d4start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // previous NPP: tmpval = veg_var[veg][band].AnnualNPPPrev;
         nc_var = &(nc_state_file.nc_vars[STATE_ANNUALNPPPREV]);
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] =
+                        dvar[offset + i] =
                             (double) all_vars[i].veg_var[v][k].AnnualNPPPrev;
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d4start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // litter carbon: tmpval = cell[veg][band].CLitter;
         nc_var = &(nc_state_file.nc_vars[STATE_CLITTER]);
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] = (double) all_vars[i].cell[v][k].CLitter;
+                        dvar[offset + i] =
+                            (double) all_vars[i].cell[v][k].CLitter;
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d4start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // intermediate carbon: tmpval = tmpval = cell[veg][band].CInter;
         nc_var = &(nc_state_file.nc_vars[STATE_CINTER]);
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] = (double) all_vars[i].cell[v][k].CInter;
+                        dvar[offset + i] =
+                            (double) all_vars[i].cell[v][k].CInter;
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d4start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // slow carbon: tmpval = cell[veg][band].CSlow;
         nc_var = &(nc_state_file.nc_vars[STATE_CSLOW]);
+        nslices = options.NVEGTYPES * options.SNOW_BAND;
+        offset = 0;
         for (m = 0; m < options.NVEGTYPES; m++) {
-            d4start[0] = m;
             for (k = 0; k < options.SNOW_BAND; k++) {
-                d4start[1] = k;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] = (double) all_vars[i].cell[v][k].CSlow;
+                        dvar[offset + i] =
+                            (double) all_vars[i].cell[v][k].CSlow;
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d4start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
     }
 
     // snow age: snow[veg][band].last_snow
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_AGE]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    ivar[i] = (int) all_vars[i].snow[v][k].last_snow;
+                    ivar[offset + i] = (int) all_vars[i].snow[v][k].last_snow;
                 }
                 else {
-                    ivar[i] = nc_state_file.i_fillvalue;
+                    ivar[offset + i] = nc_state_file.i_fillvalue;
                 }
             }
-            gather_put_nc_field_int(nc_state_file.nc_id,
-                                    nc_var->nc_varid,
-                                    nc_state_file.d_fillvalue,
-                                    d4start, nc_var->nc_counts, ivar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                ivar[i] = nc_state_file.i_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_int(nc_state_file.nc_id, nc_var->nc_varid,
+                            nc_state_file.d_fillvalue, nslices,
+                            dstart, nc_var->nc_counts, ivar);
 
 
     // melting state: (int)snow[veg][band].MELTING
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_MELT_STATE]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    ivar[i] = (int) all_vars[i].snow[v][k].MELTING;
+                    ivar[offset + i] = (int) all_vars[i].snow[v][k].MELTING;
                 }
                 else {
-                    ivar[i] = nc_state_file.i_fillvalue;
+                    ivar[offset + i] = nc_state_file.i_fillvalue;
                 }
             }
-            gather_put_nc_field_int(nc_state_file.nc_id,
-                                    nc_var->nc_varid,
-                                    nc_state_file.d_fillvalue,
-                                    d4start, nc_var->nc_counts, ivar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                ivar[i] = nc_state_file.i_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_int(nc_state_file.nc_id, nc_var->nc_varid,
+                            nc_state_file.d_fillvalue, nslices,
+                            dstart, nc_var->nc_counts, ivar);
 
 
     // snow covered fraction: snow[veg][band].coverage
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_COVERAGE]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].coverage;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].coverage;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow water equivalent: snow[veg][band].swq
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_WATER_EQUIVALENT]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].swq;
+                    dvar[offset + i] = (double) all_vars[i].snow[v][k].swq;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow surface temperature: snow[veg][band].surf_temp
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_SURF_TEMP]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].surf_temp;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].surf_temp;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow surface water: snow[veg][band].surf_water
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_SURF_WATER]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].surf_water;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].surf_water;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow pack temperature: snow[veg][band].pack_temp
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_PACK_TEMP]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].pack_temp;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].pack_temp;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow pack water: snow[veg][band].pack_water
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_PACK_WATER]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].pack_water;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].pack_water;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow density: snow[veg][band].density
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_DENSITY]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].density;
+                    dvar[offset + i] = (double) all_vars[i].snow[v][k].density;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow cold content: snow[veg][band].coldcontent
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_COLD_CONTENT]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].coldcontent;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].coldcontent;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // snow canopy storage: snow[veg][band].snow_canopy
     nc_var = &(nc_state_file.nc_vars[STATE_SNOW_CANOPY]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].snow[v][k].snow_canopy;
+                    dvar[offset + i] =
+                        (double) all_vars[i].snow[v][k].snow_canopy;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // soil node temperatures: energy[veg][band].T[nidx]
     nc_var = &(nc_state_file.nc_vars[STATE_SOIL_NODE_TEMP]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND * options.Nnode;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d5start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d5start[1] = k;
             for (j = 0; j < options.Nnode; j++) {
-                d5start[2] = j;
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     v = veg_con_map[i].vidx[m];
                     if (v >= 0) {
-                        dvar[i] = (double) all_vars[i].energy[v][k].T[j];
+                        dvar[offset + i] =
+                            (double) all_vars[i].energy[v][k].T[j];
                     }
                     else {
-                        dvar[i] = nc_state_file.d_fillvalue;
+                        dvar[offset + i] = nc_state_file.d_fillvalue;
                     }
                 }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d5start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
-                }
+                offset += local_domain.ncells_active;
             }
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // Foliage temperature: energy[veg][band].Tfoliage
     nc_var = &(nc_state_file.nc_vars[STATE_FOLIAGE_TEMPERATURE]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].energy[v][k].Tfoliage;
+                    dvar[offset + i] =
+                        (double) all_vars[i].energy[v][k].Tfoliage;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // Outgoing longwave from understory: energy[veg][band].LongUnderOut
     // This is a flux, and saving it to state file is a temporary solution!!
     nc_var = &(nc_state_file.nc_vars[STATE_ENERGY_LONGUNDEROUT]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].energy[v][k].LongUnderOut;
+                    dvar[offset + i] =
+                        (double) all_vars[i].energy[v][k].LongUnderOut;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     // Thermal flux through the snow pack: energy[veg][band].snow_flux
     // This is a flux, and saving it to state file is a temporary solution!!
     nc_var = &(nc_state_file.nc_vars[STATE_ENERGY_SNOW_FLUX]);
+    nslices = options.NVEGTYPES * options.SNOW_BAND;
+    offset = 0;
     for (m = 0; m < options.NVEGTYPES; m++) {
-        d4start[0] = m;
         for (k = 0; k < options.SNOW_BAND; k++) {
-            d4start[1] = k;
             for (i = 0; i < local_domain.ncells_active; i++) {
                 v = veg_con_map[i].vidx[m];
                 if (v >= 0) {
-                    dvar[i] = (double) all_vars[i].energy[v][k].snow_flux;
+                    dvar[offset + i] =
+                        (double) all_vars[i].energy[v][k].snow_flux;
                 }
                 else {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                    dvar[offset + i] = nc_state_file.d_fillvalue;
                 }
             }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d4start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
-            }
+            offset += local_domain.ncells_active;
         }
     }
+    gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                               nc_state_file.d_fillvalue, nslices,
+                               dstart, nc_var->nc_counts, dvar);
 
 
     if (options.LAKES) {
+        // only the cells with a lake have lake variables, the other cells
+        // keep the missing values
+        for (i = 0; i < nvalues; i++) {
+            ivar[i] = nc_state_file.i_fillvalue;
+            dvar[i] = nc_state_file.d_fillvalue;
+        }
+
         // total soil moisture
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SOIL_MOISTURE]);
+        nslices = options.Nlayer;
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d3start[0] = j;
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.soil.layer[j].moist;
-            }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d3start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[offset + i] =
+                    (double) all_vars[i].lake_var->soil.layer[j].moist;
             }
+            offset += local_domain.ncells_active;
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // ice content
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SOIL_ICE]);
+        nslices = options.Nlayer * options.Nfrost;
+        offset = 0;
         for (j = 0; j < options.Nlayer; j++) {
-            d4start[0] = j;
             for (p = 0; p < options.Nfrost; p++) {
-                d4start[1] = p;
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] =
-                        (double) all_vars[i].lake_var.soil.layer[j].ice[p];
-                }
-                gather_put_nc_field_double(nc_state_file.nc_id,
-                                           nc_var->nc_varid,
-                                           nc_state_file.d_fillvalue,
-                                           d4start, nc_var->nc_counts, dvar);
-                for (i = 0; i < local_domain.ncells_active; i++) {
-                    dvar[i] = nc_state_file.d_fillvalue;
+                for (n = 0; n < nlake_cells; n++) {
+                    i = lake_cells[n];
+                    dvar[offset + i] =
+                        (double) all_vars[i].lake_var->soil.layer[j].ice[p];
                 }
+                offset += local_domain.ncells_active;
             }
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         if (options.CARBON) {
             // litter carbon: tmpval = lake_var.soil.CLitter;
             nc_var = &(nc_state_file.nc_vars[STATE_LAKE_CLITTER]);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.soil.CLitter;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[i] = (double) all_vars[i].lake_var->soil.CLitter;
             }
             gather_put_nc_field_double(nc_state_file.nc_id,
                                        nc_var->nc_varid,
                                        nc_state_file.d_fillvalue,
-                                       d2start, nc_var->nc_counts, dvar);
+                                       dstart, nc_var->nc_counts, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 dvar[i] = nc_state_file.d_fillvalue;
             }
 
             // intermediate carbon: tmpval = lake_var.soil.CInter;
             nc_var = &(nc_state_file.nc_vars[STATE_LAKE_CINTER]);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.soil.CInter;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[i] = (double) all_vars[i].lake_var->soil.CInter;
             }
             gather_put_nc_field_double(nc_state_file.nc_id,
                                        nc_var->nc_varid,
                                        nc_state_file.d_fillvalue,
-                                       d2start, nc_var->nc_counts, dvar);
+                                       dstart, nc_var->nc_counts, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 dvar[i] = nc_state_file.d_fillvalue;
             }
 
             // slow carbon: tmpval = lake_var.soil.CSlow;
             nc_var = &(nc_state_file.nc_vars[STATE_LAKE_CSLOW]);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.soil.CSlow;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[i] = (double) all_vars[i].lake_var->soil.CSlow;
             }
             gather_put_nc_field_double(nc_state_file.nc_id,
                                        nc_var->nc_varid,
                                        nc_state_file.d_fillvalue,
-                                       d2start, nc_var->nc_counts, dvar);
+                                       dstart, nc_var->nc_counts, dvar);
             for (i = 0; i < local_domain.ncells_active; i++) {
                 dvar[i] = nc_state_file.d_fillvalue;
             }
@@ -806,451 +763,480 @@ vic_store(dmy_struct *dmy_current,
 
         // snow age: lake_var.snow.last_snow
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_AGE]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            ivar[i] = (int) all_vars[i].lake_var.snow.last_snow;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            ivar[i] = (int) all_vars[i].lake_var->snow.last_snow;
         }
         gather_put_nc_field_int(nc_state_file.nc_id,
                                 nc_var->nc_varid,
                                 nc_state_file.d_fillvalue,
-                                d2start, nc_var->nc_counts, ivar);
+                                dstart, nc_var->nc_counts, ivar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             ivar[i] = nc_state_file.i_fillvalue;
         }
 
         // melting state: (int)lake_var.snow.MELTING
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_MELT_STATE]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            ivar[i] = (int) all_vars[i].lake_var.snow.MELTING;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            ivar[i] = (int) all_vars[i].lake_var->snow.MELTING;
         }
         gather_put_nc_field_int(nc_state_file.nc_id,
                                 nc_var->nc_varid,
                                 nc_state_file.d_fillvalue,
-                                d2start, nc_var->nc_counts, ivar);
+                                dstart, nc_var->nc_counts, ivar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             ivar[i] = nc_state_file.i_fillvalue;
         }
 
         // snow covered fraction: lake_var.snow.coverage
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_COVERAGE]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.coverage;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.coverage;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow water equivalent: lake_var.snow.swq
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_WATER_EQUIVALENT]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.swq;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.swq;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow surface temperature: lake_var.snow.surf_temp
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_SURF_TEMP]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.surf_temp;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.surf_temp;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow surface water: lake_var.snow.surf_water
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_SURF_WATER]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.surf_water;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.surf_water;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow pack temperature: lake_var.snow.pack_temp
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_PACK_TEMP]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.pack_temp;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.pack_temp;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow pack water: lake_var.snow.pack_water
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_PACK_WATER]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.pack_water;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.pack_water;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow density: lake_var.snow.density
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_DENSITY]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.density;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.density;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow cold content: lake_var.snow.coldcontent
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_COLD_CONTENT]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.coldcontent;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.coldcontent;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // snow canopy storage: lake_var.snow.snow_canopy
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SNOW_CANOPY]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.snow.snow_canopy;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->snow.snow_canopy;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // soil node temperatures: lake_var.energy.T[nidx]
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SOIL_NODE_TEMP]);
+        nslices = options.Nnode;
+        offset = 0;
         for (j = 0; j < options.Nnode; j++) {
-            d3start[0] = j;
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.soil.layer[j].moist;
-            }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d2start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[offset + i] =
+                    (double) all_vars[i].lake_var->soil.layer[j].moist;
             }
+            offset += local_domain.ncells_active;
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // lake active layers: lake_var.activenod
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ACTIVE_LAYERS]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            ivar[i] = (int) all_vars[i].lake_var.activenod;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            ivar[i] = (int) all_vars[i].lake_var->activenod;
         }
         gather_put_nc_field_int(nc_state_file.nc_id,
                                 nc_var->nc_varid,
                                 nc_state_file.d_fillvalue,
-                                d2start, nc_var->nc_counts, ivar);
+                                dstart, nc_var->nc_counts, ivar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             ivar[i] = nc_state_file.i_fillvalue;
         }
 
         // lake layer thickness: lake_var.dz
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_LAYER_DZ]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.dz;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->dz;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake surface layer thickness: lake_var.surfdz
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SURF_LAYER_DZ]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.surfdz;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->surfdz;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake depth: lake_var.ldepth
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_DEPTH]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.ldepth;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->ldepth;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake layer surface areas: lake_var.surface[ndix]
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_LAYER_SURF_AREA]);
+        nslices = options.NLAKENODES;
+        offset = 0;
         for (j = 0; j < options.NLAKENODES; j++) {
-            d3start[0] = j;
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.surface[j];
-            }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d3start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[offset + i] = (double) all_vars[i].lake_var->surface[j];
             }
+            offset += local_domain.ncells_active;
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // lake surface area: lake_var.sarea
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_SURF_AREA]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.sarea;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->sarea;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake volume: lake_var.volume
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_VOLUME]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.volume;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->volume;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake layer temperatures: lake_var.temp[nidx]
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_LAYER_TEMP]);
+        nslices = options.NLAKENODES;
+        offset = 0;
         for (j = 0; j < options.NLAKENODES; j++) {
-            d3start[0] = j;
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = (double) all_vars[i].lake_var.temp[j];
-            }
-            gather_put_nc_field_double(nc_state_file.nc_id,
-                                       nc_var->nc_varid,
-                                       nc_state_file.d_fillvalue,
-                                       d2start, nc_var->nc_counts, dvar);
-            for (i = 0; i < local_domain.ncells_active; i++) {
-                dvar[i] = nc_state_file.d_fillvalue;
+            for (n = 0; n < nlake_cells; n++) {
+                i = lake_cells[n];
+                dvar[offset + i] = (double) all_vars[i].lake_var->temp[j];
             }
+            offset += local_domain.ncells_active;
         }
+        gather_put_nc_block_double(nc_state_file.nc_id, nc_var->nc_varid,
+                                   nc_state_file.d_fillvalue, nslices,
+                                   dstart, nc_var->nc_counts, dvar);
 
         // vertical average lake temperature: lake_var.tempavg
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_AVERAGE_TEMP]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.tempavg;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->tempavg;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice area fraction: lake_var.areai
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_AREA_FRAC]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.areai;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->areai;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // new lake ice area fraction: lake_var.new_ice_area
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_AREA_FRAC_NEW]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.new_ice_area;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->new_ice_area;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice water equivalent: lake_var.ice_water_eq
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_WATER_EQUIVALENT]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.ice_water_eq;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->ice_water_eq;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice height: lake_var.hice
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_HEIGHT]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.hice;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->hice;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice temperature: lake_var.tempi
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_TEMP]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.tempi;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->tempi;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow water equivalent: lake_var.swe
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SWE]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.swe;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->swe;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow surface temperature: lake_var.surf_temp
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_SURF_TEMP]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.surf_temp;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->surf_temp;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow pack temperature: lake_var.pack_temp
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_PACK_TEMP]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.pack_temp;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->pack_temp;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow coldcontent: lake_var.coldcontent
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_COLD_CONTENT]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.coldcontent;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->coldcontent;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow surface water: lake_var.surf_water
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_SURF_WATER]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.surf_water;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->surf_water;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow pack water: lake_var.pack_water
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_PACK_WATER]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.pack_water;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->pack_water;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow albedo: lake_var.SAlbedo
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_ALBEDO]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.SAlbedo;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->SAlbedo;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
 
         // lake ice snow depth: lake_var.sdepth
         nc_var = &(nc_state_file.nc_vars[STATE_LAKE_ICE_SNOW_DEPTH]);
-        for (i = 0; i < local_domain.ncells_active; i++) {
-            dvar[i] = (double) all_vars[i].lake_var.sdepth;
+        for (n = 0; n < nlake_cells; n++) {
+            i = lake_cells[n];
+            dvar[i] = (double) all_vars[i].lake_var->sdepth;
         }
         gather_put_nc_field_double(nc_state_file.nc_id,
                                    nc_var->nc_varid,
                                    nc_state_file.d_fillvalue,
-                                   d2start, nc_var->nc_counts, dvar);
+                                   dstart, nc_var->nc_counts, dvar);
         for (i = 0; i < local_domain.ncells_active; i++) {
             dvar[i] = nc_state_file.d_fillvalue;
         }
@@ -1262,8 +1248,18 @@ vic_store(dmy_struct *dmy_current,
             status = nc_close(nc_state_file.nc_id);
             check_nc_status(status, "Error closing %s", filename);
         }
+        if (stat(filename, &st) == 0) {
+            add_vic_io_bytes(IO_PHASE_STATE, (size_t) st.st_size);
+        }
     }
 
+    // the aggregation of the output streams
+    vic_store_streams(filename);
+    timer_stop(&(global_timers[TIMER_VIC_STATE_WRITE]));
+
+    // bring the history files on disk up to date with the state file
+    sync_history_files_on_state();
+
     free(ivar);
     free(dvar);
 }
@@ -1290,6 +1286,7 @@ set_nc_state_file_info(nc_file_struct *nc_state_file)
     nc_state_file->front_dimid = MISSING;
     nc_state_file->frost_dimid = MISSING;
     nc_state_file->lake_node_dimid = MISSING;
+    nc_state_file->land_dimid = MISSING;
     nc_state_file->layer_dimid = MISSING;
     nc_state_file->ni_dimid = MISSING;
     nc_state_file->nj_dimid = MISSING;
@@ -1298,11 +1295,16 @@ set_nc_state_file_info(nc_file_struct *nc_state_file)
     nc_state_file->time_dimid = MISSING;
     nc_state_file->veg_dimid = MISSING;
 
+    // state files are always written by the master node
+    nc_state_file->parallel = false;
+
     // Set dimension sizes
     nc_state_file->band_size = options.SNOW_BAND;
     nc_state_file->front_size = MAX_FRONTS;
     nc_state_file->frost_size = options.Nfrost;
+    nc_state_file->lake_node_size = options.NLAKENODES;
     nc_state_file->layer_size = options.Nlayer;
+    nc_state_file->land_size = 0;
     nc_state_file->ni_size = global_domain.n_nx;
     nc_state_file->nj_size = global_domain.n_ny;
     nc_state_file->node_size = options.Nnode;
@@ -1355,9 +1357,9 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[2] = nc->layer_dimid;
             nc->nc_vars[i].nc_dimids[3] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[4] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
-            nc->nc_vars[i].nc_counts[1] = 1;
-            nc->nc_vars[i].nc_counts[2] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->veg_size;
+            nc->nc_vars[i].nc_counts[1] = nc->band_size;
+            nc->nc_vars[i].nc_counts[2] = nc->layer_size;
             nc->nc_vars[i].nc_counts[3] = nc->nj_size;
             nc->nc_vars[i].nc_counts[4] = nc->ni_size;
             break;
@@ -1370,10 +1372,10 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[3] = nc->frost_dimid;
             nc->nc_vars[i].nc_dimids[4] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[5] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
-            nc->nc_vars[i].nc_counts[1] = 1;
-            nc->nc_vars[i].nc_counts[2] = 1;
-            nc->nc_vars[i].nc_counts[3] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->veg_size;
+            nc->nc_vars[i].nc_counts[1] = nc->band_size;
+            nc->nc_vars[i].nc_counts[2] = nc->layer_size;
+            nc->nc_vars[i].nc_counts[3] = nc->frost_size;
             nc->nc_vars[i].nc_counts[4] = nc->nj_size;
             nc->nc_vars[i].nc_counts[5] = nc->ni_size;
             break;
@@ -1403,8 +1405,8 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[1] = nc->band_dimid;
             nc->nc_vars[i].nc_dimids[2] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[3] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
-            nc->nc_vars[i].nc_counts[1] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->veg_size;
+            nc->nc_vars[i].nc_counts[1] = nc->band_size;
             nc->nc_vars[i].nc_counts[2] = nc->nj_size;
             nc->nc_vars[i].nc_counts[3] = nc->ni_size;
             break;
@@ -1416,9 +1418,9 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[2] = nc->node_dimid;
             nc->nc_vars[i].nc_dimids[3] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[4] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
-            nc->nc_vars[i].nc_counts[1] = 1;
-            nc->nc_vars[i].nc_counts[2] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->veg_size;
+            nc->nc_vars[i].nc_counts[1] = nc->band_size;
+            nc->nc_vars[i].nc_counts[2] = nc->node_size;
             nc->nc_vars[i].nc_counts[3] = nc->nj_size;
             nc->nc_vars[i].nc_counts[4] = nc->ni_size;
             break;
@@ -1428,6 +1430,9 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[0] = nc->layer_dimid;
             nc->nc_vars[i].nc_dimids[1] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[2] = nc->ni_dimid;
+            nc->nc_vars[i].nc_counts[0] = nc->layer_size;
+            nc->nc_vars[i].nc_counts[1] = nc->nj_size;
+            nc->nc_vars[i].nc_counts[2] = nc->ni_size;
             break;
         case STATE_LAKE_SOIL_ICE:
             // 4d vars [layer, frost, j, i]
@@ -1436,8 +1441,8 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[1] = nc->frost_dimid;
             nc->nc_vars[i].nc_dimids[2] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[3] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
-            nc->nc_vars[i].nc_counts[1] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->layer_size;
+            nc->nc_vars[i].nc_counts[1] = nc->frost_size;
             nc->nc_vars[i].nc_counts[2] = nc->nj_size;
             nc->nc_vars[i].nc_counts[3] = nc->ni_size;
             break;
@@ -1488,7 +1493,7 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[0] = nc->node_dimid;
             nc->nc_vars[i].nc_dimids[1] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[2] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->node_size;
             nc->nc_vars[i].nc_counts[1] = nc->nj_size;
             nc->nc_vars[i].nc_counts[2] = nc->ni_size;
             break;
@@ -1499,7 +1504,7 @@ set_nc_state_var_info(nc_file_struct *nc)
             nc->nc_vars[i].nc_dimids[0] = nc->lake_node_dimid;
             nc->nc_vars[i].nc_dimids[1] = nc->nj_dimid;
             nc->nc_vars[i].nc_dimids[2] = nc->ni_dimid;
-            nc->nc_vars[i].nc_counts[0] = 1;
+            nc->nc_vars[i].nc_counts[0] = nc->lake_node_size;
             nc->nc_vars[i].nc_counts[1] = nc->nj_size;
             nc->nc_vars[i].nc_counts[2] = nc->ni_size;
             break;
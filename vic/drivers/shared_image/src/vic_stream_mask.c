@@ -0,0 +1,221 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Output streams of selected cells.
+ *
+ * With OUTMASK, an output stream holds only the active cells where a variable
+ * of the domain file is not 0, e.g. a few gauge or flux tower cells or a
+ * basin of a continental domain. The stream aggregates only the selected
+ * cells of each node and gathers only their values to the master node, which
+ * writes them along a land dimension (compression by gathering, as with
+ * OUT_LAYOUT = LAND) in the order of the active cells of the domain.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+/******************************************************************************
+ * @brief    Layout of the gathered values of a stream of selected cells on
+ *           the master node.
+ * @details  grid is the mask on the full grid. The values of each node are
+ *           received in the order of its local cells and are moved to the
+ *           position of their cell along the land dimension.
+ *****************************************************************************/
+static void
+set_stream_mask_layout(nc_io_subset_struct *subset,
+                       int                 *grid)
+{
+    extern domain_struct global_domain;
+    extern size_t       *filter_active_cells;
+    extern int          *mpi_map_global_array_offsets;
+    extern int          *mpi_map_local_array_sizes;
+    extern size_t       *mpi_map_mapping_array;
+    extern int           mpi_size;
+
+    size_t              *position;
+    size_t               cell;
+    size_t               n;
+    size_t               i;
+    size_t               j;
+
+    // position of each active cell along the land dimension
+    position = malloc(global_domain.ncells_active * sizeof(*position));
+    check_alloc_status(position, "Memory allocation error.");
+    n = 0;
+    for (i = 0; i < global_domain.ncells_active; i++) {
+        position[i] = n;
+        if (grid[filter_active_cells[i]] != 0) {
+            n++;
+        }
+    }
+    subset->ncells_total = n;
+
+    subset->node_ncells = malloc(mpi_size * sizeof(*(subset->node_ncells)));
+    check_alloc_status(subset->node_ncells, "Memory allocation error.");
+    subset->node_offsets = malloc(mpi_size *
+                                  sizeof(*(subset->node_offsets)));
+    check_alloc_status(subset->node_offsets, "Memory allocation error.");
+    subset->map = malloc((n + 1) * sizeof(*(subset->map)));
+    check_alloc_status(subset->map, "Memory allocation error.");
+    subset->grid_cells = malloc((n + 1) * sizeof(*(subset->grid_cells)));
+    check_alloc_status(subset->grid_cells, "Memory allocation error.");
+
+    n = 0;
+    for (i = 0; i < (size_t) mpi_size; i++) {
+        subset->node_offsets[i] = (int) n;
+        for (j = 0; j < (size_t) mpi_map_local_array_sizes[i]; j++) {
+            cell = mpi_map_mapping_array[mpi_map_global_array_offsets[i] + j];
+            if (grid[filter_active_cells[cell]] != 0) {
+                subset->map[n++] = position[cell];
+                subset->grid_cells[position[cell]] =
+                    filter_active_cells[cell];
+            }
+        }
+        subset->node_ncells[i] = (int) n - subset->node_offsets[i];
+    }
+
+    free(position);
+}
+
+/******************************************************************************
+ * @brief    Select the cells of a stream with OUTMASK.
+ * @details  Called by vic_init_output() after the history file of the stream
+ *           is set up and before its aggregation buffers are allocated.
+ *           ngridcells becomes the number of selected cells of the local
+ *           node, which may be 0.
+ *****************************************************************************/
+void
+set_stream_mask(stream_struct  *stream,
+                nc_file_struct *nc)
+{
+    extern filenames_struct filenames;
+    extern domain_struct    global_domain;
+    extern domain_struct    local_domain;
+    extern option_struct    options;
+    extern double        ***out_data;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern int              mpi_rank;
+
+    nc_io_subset_struct    *subset;
+    nc_io_field_struct      field;
+    size_t                  d2start[2];
+    size_t                  d2count[2];
+    int                    *grid = NULL;
+    int                    *ivar;
+    size_t                  i;
+    size_t                  n;
+    int                     status;
+
+    if (stream->mask[0] == '\0') {
+        return;
+    }
+
+    // the record is gathered and written by the model on the master node
+    if (options.IO_SERVERS > 0 || options.ASYNC_OUTPUT) {
+        log_err("OUTMASK of output stream %s is not supported with "
+                "IO_SERVERS or ASYNC_OUTPUT", stream->prefix);
+    }
+
+    d2start[0] = 0;
+    d2start[1] = 0;
+    d2count[0] = global_domain.n_ny;
+    d2count[1] = global_domain.n_nx;
+
+    // the mask is read once and scattered to the nodes
+    if (mpi_rank == VIC_MPI_ROOT) {
+        grid = malloc(global_domain.ncells_total * sizeof(*grid));
+        check_alloc_status(grid, "Memory allocation error.");
+        get_nc_field_int(filenames.domain, stream->mask, d2start, d2count,
+                         grid);
+    }
+    ivar = malloc((local_domain.ncells_active + 1) * sizeof(*ivar));
+    check_alloc_status(ivar, "Memory allocation error.");
+    memset(&field, 0, sizeof(field));
+    field.nc_type = NC_INT;
+    field.nslices = 1;
+    field.start = d2start;
+    field.count = d2count;
+    field.grid = grid;
+    field.var = ivar;
+    get_scatter_nc_fields(1, &field);
+
+    // the selected local cells
+    n = 0;
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (ivar[i] != 0) {
+            n++;
+        }
+    }
+    stream->ngridcells = n;
+    stream->cells = malloc((n + 1) * sizeof(*(stream->cells)));
+    check_alloc_status(stream->cells, "Memory allocation error.");
+    stream->cell_data = malloc((n + 1) * sizeof(*(stream->cell_data)));
+    check_alloc_status(stream->cell_data, "Memory allocation error.");
+    n = 0;
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (ivar[i] != 0) {
+            stream->cells[n] = i;
+            stream->cell_data[n] = out_data[i];
+            n++;
+        }
+    }
+    free(ivar);
+
+    subset = &(nc->subset);
+    subset->ncells = stream->ngridcells;
+    if (mpi_rank == VIC_MPI_ROOT) {
+        set_stream_mask_layout(subset, grid);
+        free(grid);
+    }
+    status = MPI_Bcast(&(subset->ncells_total), 1, MPI_AINT, VIC_MPI_ROOT,
+                       MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    if (subset->ncells_total == 0) {
+        log_err("OUTMASK %s of output stream %s selects no active cells",
+                stream->mask, stream->prefix);
+    }
+    debug("output stream %s holds %zu of %zu cells of OUTMASK %s",
+          stream->prefix, subset->ncells, subset->ncells_total, stream->mask);
+
+    // the selected cells are written along the land dimension by the master
+    // node
+    nc->land_size = subset->ncells_total;
+    nc->parallel = false;
+    nc->io_request.subset = subset;
+    for (i = 0; i < stream->nvars; i++) {
+        set_nc_var_info(stream->varid[i], stream->type[i], nc,
+                        &(nc->nc_vars[i]));
+    }
+}
+
+/******************************************************************************
+ * @brief    Free the layout of a stream of selected cells.
+ *****************************************************************************/
+void
+free_stream_mask(nc_file_struct *nc)
+{
+    free(nc->subset.node_ncells);
+    free(nc->subset.node_offsets);
+    free(nc->subset.map);
+    free(nc->subset.grid_cells);
+    nc->io_request.subset = NULL;
+}
@@ -0,0 +1,250 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Save and restore the state of the output streams.
+ *
+ * The state of an output stream is the aggregation of its current record
+ * (the aggregated values, the aggregation alarm and the start of the
+ * record) and its position in the history files (the write alarm, the
+ * history file and whether it is open). With STATE_STREAMS, every process
+ * writes the state of its streams next to each state file, so that a run
+ * that restarts from the state file in the middle of a record (e.g. of a
+ * monthly stream) continues the aggregation of that record instead of
+ * starting a short record. A restart writes new history files, so only the
+ * aggregation is restored. A checkpoint also restores the position in the
+ * history files.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+/******************************************************************************
+ * @brief    Number of aggregated values of a stream, including the state of
+ *           the aggregation types with more than one bin.
+ *****************************************************************************/
+static size_t
+get_stream_state_nvalues(stream_struct *stream)
+{
+    return stream->naggvalues;
+}
+
+/******************************************************************************
+ * @brief    Write to a stream state file.
+ *****************************************************************************/
+static void
+write_stream_state_data(const void *ptr,
+                        size_t      size,
+                        size_t      nmemb,
+                        FILE       *fp,
+                        char       *filename)
+{
+    if (fwrite(ptr, size, nmemb, fp) != nmemb) {
+        log_err("Error writing stream state file %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read from a stream state file.
+ *****************************************************************************/
+static void
+read_stream_state_data(void   *ptr,
+                       size_t  size,
+                       size_t  nmemb,
+                       FILE   *fp,
+                       char   *filename)
+{
+    if (fread(ptr, size, nmemb, fp) != nmemb) {
+        log_err("Error reading stream state file %s", filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write the state of the output streams of the local node.
+ *****************************************************************************/
+void
+write_stream_state(FILE *fp,
+                   char *filename)
+{
+    extern option_struct   options;
+    extern stream_struct  *output_streams;
+    extern nc_file_struct *nc_hist_files;
+    extern int             mpi_rank;
+
+    stream_state_header_struct header;
+    stream_state_struct        state;
+    stream_struct             *stream;
+    size_t                     i;
+
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, STREAM_STATE_MAGIC, sizeof(header.magic));
+    header.version = STREAM_STATE_VERSION;
+    header.mpi_rank = mpi_rank;
+    header.nstreams = options.Noutstreams;
+    write_stream_state_data(&header, sizeof(header), 1, fp, filename);
+
+    for (i = 0; i < options.Noutstreams; i++) {
+        stream = &(output_streams[i]);
+        memset(&state, 0, sizeof(state));
+        state.nvars = stream->nvars;
+        state.ngridcells = stream->ngridcells;
+        state.agg_alarm = stream->agg_alarm;
+        state.write_alarm = stream->write_alarm;
+        state.time_bounds[0] = stream->time_bounds[0];
+        state.time_bounds[1] = stream->time_bounds[1];
+        strncpy(state.filename, stream->filename, sizeof(state.filename));
+        state.open = nc_hist_files[i].open;
+        state.flush_count = nc_hist_files[i].flush_count;
+        write_stream_state_data(&state, sizeof(state), 1, fp, filename);
+        write_stream_state_data(stream->aggvalues,
+                                sizeof(*(stream->aggvalues)),
+                                get_stream_state_nvalues(stream), fp,
+                                filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Read the state of the output streams of the local node.
+ * @details  With history, the position in the history files is restored as
+ *           well and the open history files are reopened, otherwise the
+ *           history files of this run are kept.
+ *****************************************************************************/
+void
+read_stream_state(FILE *fp,
+                  char *filename,
+                  bool  history)
+{
+    extern option_struct   options;
+    extern stream_struct  *output_streams;
+    extern nc_file_struct *nc_hist_files;
+    extern int             mpi_rank;
+
+    stream_state_header_struct header;
+    stream_state_struct        state;
+    stream_struct             *stream;
+    size_t                     i;
+
+    read_stream_state_data(&header, sizeof(header), 1, fp, filename);
+    if (strncmp(header.magic, STREAM_STATE_MAGIC,
+                sizeof(header.magic)) != 0 ||
+        header.version != STREAM_STATE_VERSION) {
+        log_err("%s is not a stream state file of this version of VIC",
+                filename);
+    }
+    if (header.mpi_rank != mpi_rank ||
+        header.nstreams != options.Noutstreams) {
+        log_err("Stream state file %s was written with a different number "
+                "of processes or output streams", filename);
+    }
+
+    for (i = 0; i < options.Noutstreams; i++) {
+        stream = &(output_streams[i]);
+        read_stream_state_data(&state, sizeof(state), 1, fp, filename);
+        if (state.nvars != stream->nvars ||
+            state.ngridcells != stream->ngridcells ||
+            state.agg_alarm.freq != stream->agg_alarm.freq ||
+            state.agg_alarm.n != stream->agg_alarm.n) {
+            log_err("Output stream %zu of %s does not match output stream "
+                    "%zu of the global parameter file", i, filename, i);
+        }
+        read_stream_state_data(stream->aggvalues,
+                               sizeof(*(stream->aggvalues)),
+                               get_stream_state_nvalues(stream), fp,
+                               filename);
+        stream->agg_alarm = state.agg_alarm;
+        stream->time_bounds[0] = state.time_bounds[0];
+        stream->time_bounds[1] = state.time_bounds[1];
+        if (history) {
+            stream->write_alarm = state.write_alarm;
+            strncpy(stream->filename, state.filename,
+                    sizeof(stream->filename));
+            nc_hist_files[i].open = state.open;
+            nc_hist_files[i].flush_count = state.flush_count;
+            if (nc_hist_files[i].open) {
+                reopen_history_file(&(nc_hist_files[i]), stream);
+            }
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Save the state of the output streams next to a state file.
+ * @details  Called after the state file is written. Every node writes
+ *           <state file>.streams.<rank>.
+ *****************************************************************************/
+void
+vic_store_streams(char *filename)
+{
+    extern option_struct options;
+    extern int           mpi_rank;
+
+    char                 stream_filename[MAXSTRING];
+    FILE                *fp;
+
+    if (!options.STATE_STREAMS) {
+        return;
+    }
+
+    snprintf(stream_filename, MAXSTRING, "%s.streams.%04d", filename,
+             mpi_rank);
+    fp = fopen(stream_filename, "wb");
+    if (fp == NULL) {
+        log_err("Unable to open stream state file %s", stream_filename);
+    }
+    write_stream_state(fp, stream_filename);
+    if (fclose(fp) != 0) {
+        log_err("Error closing stream state file %s", stream_filename);
+    }
+}
+
+/******************************************************************************
+ * @brief    Restore the aggregation of the output streams from the stream
+ *           state file next to the initial state file.
+ * @details  Called by vic_init_output() after the streams are set up.
+ *****************************************************************************/
+void
+vic_restore_streams(void)
+{
+    extern filenames_struct filenames;
+    extern option_struct    options;
+    extern int              mpi_rank;
+
+    char                    stream_filename[MAXSTRING];
+    FILE                   *fp;
+
+    if (!options.STATE_STREAMS || !options.INIT_STATE) {
+        return;
+    }
+
+    snprintf(stream_filename, MAXSTRING, "%s.streams.%04d",
+             filenames.init_state, mpi_rank);
+    fp = fopen(stream_filename, "rb");
+    if (fp == NULL) {
+        log_err("Unable to open stream state file %s. STATE_STREAMS = TRUE "
+                "requires an initial state that was saved with "
+                "STATE_STREAMS = TRUE by the same number of processes.",
+                stream_filename);
+    }
+    read_stream_state(fp, stream_filename, false);
+    if (fclose(fp) != 0) {
+        log_err("Error closing stream state file %s", stream_filename);
+    }
+}
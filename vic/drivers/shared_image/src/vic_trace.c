@@ -0,0 +1,419 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Event trace of the image driver.
+ *
+ * When TRACE_FILE is given in the global parameter file, the start and the
+ * end of the initialization stages, of each time step and of its phases are
+ * recorded on every thread of every process, and the events are written at
+ * the end of the run to a file in the Chrome trace event format, which can be
+ * opened with chrome://tracing, Perfetto or Speedscope. Each process is shown
+ * as its MPI rank, each thread of a process as its own track.
+ *
+ * The phases are traced through the global timers of the same name, so that
+ * the trace shows exactly the intervals of the timing table. Each thread
+ * records into its own ring buffer of TRACE_RING_SIZE events; in long runs
+ * only the most recent events are kept and the number of lost events is
+ * written to the trace.
+ *
+ * The time stamps are the wall clocks of the processes relative to the start
+ * of the run on the master node, so the processes are only aligned as well
+ * as the clocks of their hosts.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+// events recorded by one thread
+typedef struct {
+    trace_event_struct *events; /**< ring buffer of TRACE_RING_SIZE events */
+    size_t nevents;             /**< number of events recorded */
+    double open[N_TRACE_EVENTS]; /**< start of the open events, < 0 = closed */
+} trace_thread_struct;
+
+static const char *trace_names[N_TRACE_EVENTS] = {
+    "init", "vic_start", "vic_alloc", "vic_init", "model_state",
+    "vic_init_output", "io_servers", "run", "final", "time_step",
+    "force_read", "force_prefetch", "force_scatter", "cells", "agg",
+    "hist_gather", "hist_write", "state_write"
+};
+
+// event of each global timer, -1 = not traced
+static const int timer_events[N_TIMERS] = {
+    -1, TRACE_INIT, TRACE_RUN, TRACE_FINAL, TRACE_FORCE_READ,
+    TRACE_FORCE_SCATTER, -1, -1, TRACE_AGG, TRACE_HIST_GATHER,
+    TRACE_HIST_WRITE, TRACE_STATE_WRITE, -1
+};
+
+static struct {
+    bool active;
+    MPI_Comm comm;                 /**< all processes of the run */
+    double epoch;                  /**< start of the run on the master node */
+    size_t nthreads;               /**< number of thread slots */
+    size_t nclaimed;               /**< number of slots taken by threads */
+    size_t nlost;                  /**< events of threads without a slot */
+    trace_thread_struct *threads;  /**< [nthreads] */
+} trace;
+
+// slot of the calling thread, -1 = none yet, -2 = all slots were taken
+static int trace_slot = -1;
+#pragma omp threadprivate(trace_slot)
+
+/******************************************************************************
+ * @brief    Events of the calling thread, NULL if all slots are taken.
+ * @details  A thread takes the next free slot at its first event. Slot 0 is
+ *           the main thread, since it calls initialize_trace().
+ *****************************************************************************/
+static trace_thread_struct *
+get_trace_thread(void)
+{
+    size_t               slot;
+    size_t               i;
+    trace_thread_struct *thread;
+
+    if (trace_slot == -2) {
+        return NULL;
+    }
+    else if (trace_slot < 0) {
+        #pragma omp atomic capture
+        slot = trace.nclaimed++;
+        if (slot >= trace.nthreads) {
+            trace_slot = -2;
+            return NULL;
+        }
+        thread = &(trace.threads[slot]);
+        thread->events = malloc(TRACE_RING_SIZE * sizeof(*(thread->events)));
+        check_alloc_status(thread->events, "Memory allocation error.");
+        thread->nevents = 0;
+        for (i = 0; i < N_TRACE_EVENTS; i++) {
+            thread->open[i] = -1.;
+        }
+        trace_slot = (int) slot;
+    }
+
+    return &(trace.threads[trace_slot]);
+}
+
+/******************************************************************************
+ * @brief    Open or close an event of the calling thread at a given time.
+ *****************************************************************************/
+static void
+trace_mark(int    event,
+           double time,
+           bool   start)
+{
+    trace_thread_struct *thread;
+    trace_event_struct  *record;
+
+    thread = get_trace_thread();
+    if (thread == NULL) {
+        if (!start) {
+            #pragma omp atomic
+            trace.nlost++;
+        }
+        return;
+    }
+    if (start) {
+        thread->open[event] = time;
+    }
+    else if (thread->open[event] >= 0.) {
+        record = &(thread->events[thread->nevents % TRACE_RING_SIZE]);
+        record->event = event;
+        record->thread = trace_slot;
+        record->start = thread->open[event];
+        record->end = time;
+        thread->nevents++;
+        thread->open[event] = -1.;
+    }
+}
+
+/******************************************************************************
+ * @brief    Trace the global timers as the phases of the run.
+ *****************************************************************************/
+static void
+trace_timer_hook(timer_struct *t,
+                 bool          start)
+{
+    extern timer_struct global_timers[N_TIMERS];
+
+    int                 event;
+
+    if (t < global_timers || t >= global_timers + N_TIMERS) {
+        return;
+    }
+    event = timer_events[t - global_timers];
+    if (event >= 0) {
+        trace_mark(event, start ? t->start_wall : t->stop_wall, start);
+    }
+}
+
+/******************************************************************************
+ * @brief    Start the event trace if TRACE_FILE is set.
+ * @details  Must be called by all processes after vic_start(), while
+ *           MPI_COMM_VIC still holds all processes of the run. The
+ *           initialization up to this point is recorded as the first stage.
+ *****************************************************************************/
+void
+initialize_trace(void)
+{
+    extern filenames_struct filenames;
+    extern option_struct    options;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern timer_struct     global_timers[N_TIMERS];
+
+    double                  now;
+    int                     status;
+
+    if (strcasecmp(filenames.trace, "MISSING") == 0) {
+        return;
+    }
+
+    trace.comm = MPI_COMM_VIC;
+    trace.epoch = global_timers[TIMER_VIC_ALL].start_wall;
+    status = MPI_Bcast(&(trace.epoch), 1, MPI_DOUBLE, VIC_MPI_ROOT,
+                       trace.comm);
+    check_mpi_status(status, "MPI error.");
+
+    // the OpenMP threads, the forcing reader, the history writer and the
+    // checkpoint thread
+    trace.nthreads = options.NTHREADS + 3;
+    trace.threads = calloc(trace.nthreads, sizeof(*(trace.threads)));
+    check_alloc_status(trace.threads, "Memory allocation error.");
+    trace.nclaimed = 0;
+    trace.nlost = 0;
+    trace.active = true;
+
+    now = get_wall_time();
+    trace_mark(TRACE_INIT, global_timers[TIMER_VIC_INIT].start_wall, true);
+    trace_mark(TRACE_INIT_START, global_timers[TIMER_VIC_INIT].start_wall,
+               true);
+    trace_mark(TRACE_INIT_START, now, false);
+
+    set_timer_hook(trace_timer_hook);
+}
+
+/******************************************************************************
+ * @brief    Start an event on the calling thread.
+ * @details  Does nothing without TRACE_FILE. May be called by any thread.
+ *****************************************************************************/
+void
+trace_begin(int event)
+{
+    if (trace.active) {
+        trace_mark(event, get_wall_time(), true);
+    }
+}
+
+/******************************************************************************
+ * @brief    End an event on the calling thread.
+ * @details  Does nothing without TRACE_FILE or if the event was not started
+ *           on the calling thread.
+ *****************************************************************************/
+void
+trace_end(int event)
+{
+    if (trace.active) {
+        trace_mark(event, get_wall_time(), false);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write the trace file and free the trace.
+ * @details  Must be called by all processes of the run after
+ *           reduce_vic_phase_timers() and before MPI is finalized. Does
+ *           nothing without TRACE_FILE. Events that are still open, such as
+ *           the finalization, end at the time of the call.
+ *
+ *           The events of all processes are gathered on the master node,
+ *           which writes them as complete events ("ph": "X") with the
+ *           process as pid and the thread slot as tid. Time stamps and
+ *           durations are in microseconds since the start of the run.
+ *****************************************************************************/
+void
+write_trace(void)
+{
+    extern filenames_struct filenames;
+    extern MPI_Comm         MPI_COMM_VIC;
+
+    trace_event_struct     *events = NULL;
+    trace_event_struct     *all_events = NULL;
+    trace_thread_struct    *thread;
+    unsigned long           lost;
+    unsigned long          *all_lost = NULL;
+    int                     nbytes;
+    int                    *all_nbytes = NULL;
+    int                    *displs = NULL;
+    int                     rank;
+    int                     nranks;
+    int                     nthreads;
+    int                     status;
+    size_t                  nevents;
+    size_t                  ntotal;
+    size_t                  nkept;
+    size_t                  first;
+    size_t                  i;
+    size_t                  j;
+    int                     k;
+    double                  now;
+    FILE                   *fp = NULL;
+    bool                    comma;
+
+    if (!trace.active) {
+        return;
+    }
+    set_timer_hook(NULL);
+
+    // close the open events of the calling thread
+    now = get_wall_time();
+    thread = get_trace_thread();
+    if (thread != NULL) {
+        for (i = 0; i < N_TRACE_EVENTS; i++) {
+            trace_mark(i, now, false);
+        }
+    }
+
+    // kept events of this process, oldest first
+    nthreads = (int) trace.nthreads;
+    if (trace.nclaimed < trace.nthreads) {
+        nthreads = (int) trace.nclaimed;
+    }
+    lost = trace.nlost;
+    nevents = 0;
+    for (k = 0; k < nthreads; k++) {
+        nevents += min(trace.threads[k].nevents, TRACE_RING_SIZE);
+    }
+    events = malloc((nevents + 1) * sizeof(*events));
+    check_alloc_status(events, "Memory allocation error.");
+    nevents = 0;
+    for (k = 0; k < nthreads; k++) {
+        thread = &(trace.threads[k]);
+        nkept = min(thread->nevents, TRACE_RING_SIZE);
+        first = thread->nevents - nkept;
+        for (j = 0; j < nkept; j++) {
+            events[nevents++] =
+                thread->events[(first + j) % TRACE_RING_SIZE];
+        }
+        lost += thread->nevents - nkept;
+        free(thread->events);
+    }
+    free(trace.threads);
+    trace.active = false;
+
+    status = MPI_Comm_rank(trace.comm, &rank);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Comm_size(trace.comm, &nranks);
+    check_mpi_status(status, "MPI error.");
+
+    if (rank == VIC_MPI_ROOT) {
+        all_nbytes = malloc(nranks * sizeof(*all_nbytes));
+        check_alloc_status(all_nbytes, "Memory allocation error.");
+        displs = malloc(nranks * sizeof(*displs));
+        check_alloc_status(displs, "Memory allocation error.");
+        all_lost = malloc(nranks * sizeof(*all_lost));
+        check_alloc_status(all_lost, "Memory allocation error.");
+    }
+    nbytes = (int) (nevents * sizeof(*events));
+    status = MPI_Gather(&nbytes, 1, MPI_INT, all_nbytes, 1, MPI_INT,
+                        VIC_MPI_ROOT, trace.comm);
+    check_mpi_status(status, "MPI error.");
+    status = MPI_Gather(&lost, 1, MPI_UNSIGNED_LONG, all_lost, 1,
+                        MPI_UNSIGNED_LONG, VIC_MPI_ROOT, trace.comm);
+    check_mpi_status(status, "MPI error.");
+    ntotal = 0;
+    if (rank == VIC_MPI_ROOT) {
+        for (k = 0; k < nranks; k++) {
+            displs[k] = (int) (ntotal * sizeof(*events));
+            ntotal += all_nbytes[k] / sizeof(*events);
+        }
+        all_events = malloc((ntotal + 1) * sizeof(*all_events));
+        check_alloc_status(all_events, "Memory allocation error.");
+    }
+    status = MPI_Gatherv(events, nbytes, MPI_BYTE, all_events, all_nbytes,
+                         displs, MPI_BYTE, VIC_MPI_ROOT, trace.comm);
+    check_mpi_status(status, "MPI error.");
+    free(events);
+
+    if (rank == VIC_MPI_ROOT) {
+        fp = open_file(filenames.trace, "w");
+        fprintf(fp, "{\"displayTimeUnit\": \"ms\",\n");
+        fprintf(fp, " \"otherData\": {\"version\": \"%s\", \"lost\": [",
+                SHORT_VERSION);
+        lost = 0;
+        for (k = 0; k < nranks; k++) {
+            fprintf(fp, "%s%lu", k > 0 ? ", " : "", all_lost[k]);
+            lost += all_lost[k];
+        }
+        fprintf(fp, "]},\n \"traceEvents\": [\n");
+
+        // names of the processes and the threads
+        comma = false;
+        i = 0;
+        for (k = 0; k < nranks; k++) {
+            fprintf(fp, "%s  {\"name\": \"process_name\", \"ph\": \"M\", "
+                    "\"pid\": %d, \"tid\": 0, "
+                    "\"args\": {\"name\": \"rank %d\"}}",
+                    comma ? ",\n" : "", k, k);
+            comma = true;
+            nthreads = 0;
+            for (j = 0; j < all_nbytes[k] / sizeof(*events); j++, i++) {
+                if (all_events[i].thread >= nthreads) {
+                    nthreads = all_events[i].thread + 1;
+                }
+            }
+            for (j = 0; j < (size_t) nthreads; j++) {
+                fprintf(fp, ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", "
+                        "\"pid\": %d, \"tid\": %zu, "
+                        "\"args\": {\"name\": \"thread %zu%s\"}}",
+                        k, j, j, j == 0 ? " (main)" : "");
+            }
+        }
+
+        // events
+        i = 0;
+        for (k = 0; k < nranks; k++) {
+            for (j = 0; j < all_nbytes[k] / sizeof(*events); j++, i++) {
+                fprintf(fp, ",\n  {\"name\": \"%s\", \"cat\": \"vic\", "
+                        "\"ph\": \"X\", \"pid\": %d, \"tid\": %d, "
+                        "\"ts\": %.3f, \"dur\": %.3f}",
+                        trace_names[all_events[i].event], k,
+                        all_events[i].thread,
+                        (all_events[i].start - trace.epoch) * 1e6,
+                        (all_events[i].end - all_events[i].start) * 1e6);
+            }
+        }
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+
+        if (lost > 0) {
+            log_warn("%lu events were lost in the trace file %s; only the "
+                     "last %d events of each thread are kept", lost,
+                     filenames.trace, TRACE_RING_SIZE);
+        }
+        log_info("Wrote %zu events of %d processes to the trace file %s",
+                 ntotal, nranks, filenames.trace);
+
+        free(all_events);
+        free(all_nbytes);
+        free(displs);
+        free(all_lost);
+    }
+}
@@ -25,6 +25,123 @@
  *****************************************************************************/
 
 #include <vic_driver_shared_image.h>
+#include <stdint.h>
+
+/******************************************************************************
+ * @brief    Number of mantissa bits kept for the significant decimal digits
+ *           of a float or double history variable, 0 if all are kept.
+ *****************************************************************************/
+int
+get_history_keepbits(int digits,
+                     int nc_type)
+{
+    int keepbits;
+
+    if (digits <= 0 || (nc_type != NC_FLOAT && nc_type != NC_DOUBLE)) {
+        return 0;
+    }
+
+    keepbits = (int) ceil(digits * log2(10.));
+    if (keepbits >= (nc_type == NC_FLOAT ? FLT_MANT_DIG : DBL_MANT_DIG) - 1) {
+        return 0;
+    }
+
+    return keepbits;
+}
+
+/******************************************************************************
+ * @brief    Round the values of a history variable to its significant
+ *           digits.
+ * @details  The same BitRound (round to nearest, ties to even, of the
+ *           mantissa) as netCDF-C, so that the trailing zero bits compress
+ *           with deflate. Nothing is done where the netCDF library already
+ *           quantizes the variable, i.e. in netCDF4 files that are not
+ *           written with direct chunk writes. Fill values and MISSING are
+ *           kept.
+ *****************************************************************************/
+void
+round_history_values(stream_struct  *stream,
+                     nc_file_struct *nc,
+                     size_t          varidx,
+                     double         *values,
+                     size_t          nvalues)
+{
+    uint64_t bits;
+    uint64_t half;
+    uint64_t mask;
+    int      keepbits;
+    int      shift;
+    size_t   i;
+
+    keepbits = get_history_keepbits(stream->digits[varidx],
+                                    nc->nc_vars[varidx].nc_type);
+    if (keepbits == 0) {
+        return;
+    }
+#ifdef NC_QUANTIZE_BITROUND
+    if ((stream->file_format == NETCDF4_CLASSIC ||
+         stream->file_format == NETCDF4) &&
+        !is_direct_chunk_stream(stream, nc)) {
+        return;
+    }
+#endif
+
+    shift = DBL_MANT_DIG - 1 - keepbits;
+    half = (uint64_t) 1 << (shift - 1);
+    mask = ~(((uint64_t) 1 << shift) - 1);
+    for (i = 0; i < nvalues; i++) {
+        if (!isfinite(values[i]) || values[i] == nc->d_fillvalue ||
+            values[i] == (double) nc->f_fillvalue || values[i] == MISSING) {
+            continue;
+        }
+        memcpy(&bits, &(values[i]), sizeof(bits));
+        bits += half - 1 + ((bits >> shift) & 1);
+        bits &= mask;
+        memcpy(&(values[i]), &bits, sizeof(bits));
+    }
+}
+
+/******************************************************************************
+ * @brief    Round the aggregated values of a record to the significant
+ *           digits of its variables before they are written.
+ *****************************************************************************/
+static void
+round_history_record(stream_struct  *stream,
+                     nc_file_struct *nc)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    double                *aggvalues;
+    size_t                 nvalues;
+    size_t                 k;
+
+    aggvalues = stream->aggvalues;
+    for (k = 0; k < stream->nvars; k++) {
+        nvalues = out_metadata[stream->varid[k]].nelem * stream->ngridcells;
+        round_history_values(stream, nc, k, aggvalues, nvalues);
+        aggvalues += nvalues;
+    }
+}
+
+/******************************************************************************
+ * @brief    Bytes of a history record of the local cells of a stream.
+ *****************************************************************************/
+static size_t
+get_history_record_bytes(stream_struct  *stream,
+                         nc_file_struct *nc)
+{
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    size_t                 nbytes = 0;
+    size_t                 k;
+
+    for (k = 0; k < stream->nvars; k++) {
+        nbytes += out_metadata[stream->varid[k]].nelem *
+                  get_nc_io_type_size(nc->nc_vars[k].nc_type);
+    }
+
+    return nbytes * stream->ngridcells;
+}
 
 /******************************************************************************
  * @brief    Write output data and convert units if necessary.
@@ -35,6 +152,7 @@ vic_write_output(dmy_struct *dmy)
     extern option_struct   options;
     extern stream_struct  *output_streams;
     extern nc_file_struct *nc_hist_files;
+    extern timer_struct    global_timers[N_TIMERS];
 
     size_t                 stream_idx;
 
@@ -42,32 +160,54 @@ vic_write_output(dmy_struct *dmy)
     for (stream_idx = 0; stream_idx < options.Noutstreams; stream_idx++) {
         if (raise_alarm(&(output_streams[stream_idx].agg_alarm), dmy)) {
             debug("raised alarm for stream %zu", stream_idx);
-            vic_write(&(output_streams[stream_idx]),
-                      &(nc_hist_files[stream_idx]), dmy);
+            // the regions are rounded after the reduction
+            if (output_streams[stream_idx].region[0] == '\0') {
+                round_history_record(&(output_streams[stream_idx]),
+                                     &(nc_hist_files[stream_idx]));
+            }
+            if (is_published_stream(&(output_streams[stream_idx]))) {
+                // every node publishes its own cells
+                put_adios2_record(&(output_streams[stream_idx]),
+                                  &(nc_hist_files[stream_idx]), dmy);
+            }
+            else if (options.IO_SERVERS > 0) {
+                // the record is written by the I/O server
+                timer_continue(&(global_timers[TIMER_VIC_HIST_GATHER]));
+                vic_write_io_server(stream_idx, dmy);
+                timer_stop(&(global_timers[TIMER_VIC_HIST_GATHER]));
+            }
+            else if (options.ASYNC_OUTPUT) {
+                vic_write_async(&(output_streams[stream_idx]),
+                                &(nc_hist_files[stream_idx]), dmy);
+            }
+            else {
+                vic_write(&(output_streams[stream_idx]),
+                          &(nc_hist_files[stream_idx]), dmy);
+            }
+            add_vic_io_bytes(IO_PHASE_HIST,
+                             get_history_record_bytes(
+                                 &(output_streams[stream_idx]),
+                                 &(nc_hist_files[stream_idx])));
             reset_stream(&(output_streams[stream_idx]), dmy);
         }
     }
 }
 
 /******************************************************************************
- * @brief    Write output to netcdf file. Currently everything is cast to
- *           double
+ * @brief    Write the variables of a record of a parallel history file.
+ * @details  All nodes write their own cells, one slice at a time.
  *****************************************************************************/
-void
-vic_write(stream_struct  *stream,
-          nc_file_struct *nc_hist_file,
-          dmy_struct     *dmy_current)
+static void
+put_par_history_record(stream_struct  *stream,
+                       nc_file_struct *nc_hist_file)
 {
-    extern global_param_struct global_param;
     extern domain_struct       local_domain;
-    extern int                 mpi_rank;
     extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
 
     size_t                     i;
     size_t                     j;
     size_t                     k;
     size_t                     ndims;
-    double                     dtime;
     double                    *dvar = NULL;
     float                     *fvar = NULL;
     int                       *ivar = NULL;
@@ -76,17 +216,6 @@ vic_write(stream_struct  *stream,
     size_t                     dcount[MAXDIMS];
     size_t                     dstart[MAXDIMS];
     unsigned int               varid;
-    int                        status;
-    double                     offset;
-    double                     bounds[2];
-
-    if (mpi_rank == VIC_MPI_ROOT) {
-        // If the output file is not open, initialize the history file now.
-        if (nc_hist_file->open == false) {
-            // open the netcdf history file
-            initialize_history_file(nc_hist_file, stream, dmy_current);
-        }
-    }
 
     // initialize dimids to invalid values - helps debugging
     for (i = 0; i < MAXDIMS; i++) {
@@ -156,49 +285,46 @@ vic_write(stream_struct  *stream,
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     dvar[i] = (double) stream->aggdata[i][k][j][0];
                 }
-                gather_put_nc_field_double(nc_hist_file->nc_id,
-                                           nc_hist_file->nc_vars[k].nc_varid,
-                                           nc_hist_file->d_fillvalue,
-                                           dstart, dcount, dvar);
+                put_par_nc_field_double(nc_hist_file->nc_id,
+                                        nc_hist_file->nc_vars[k].nc_varid,
+                                        nc_hist_file->d_fillvalue,
+                                        dstart, dcount, dvar);
             }
             else if (nc_hist_file->nc_vars[k].nc_type == NC_FLOAT) {
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     fvar[i] = (float) stream->aggdata[i][k][j][0];
                 }
-                gather_put_nc_field_float(nc_hist_file->nc_id,
-                                          nc_hist_file->nc_vars[k].nc_varid,
-                                          nc_hist_file->f_fillvalue,
-                                          dstart, dcount, fvar);
+                put_par_nc_field_float(nc_hist_file->nc_id,
+                                       nc_hist_file->nc_vars[k].nc_varid,
+                                       nc_hist_file->f_fillvalue,
+                                       dstart, dcount, fvar);
             }
             else if (nc_hist_file->nc_vars[k].nc_type == NC_INT) {
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     ivar[i] = (int) stream->aggdata[i][k][j][0];
                 }
-                gather_put_nc_field_int(nc_hist_file->nc_id,
-                                        nc_hist_file->nc_vars[k].nc_varid,
-                                        nc_hist_file->i_fillvalue,
-                                        dstart, dcount, ivar);
+                put_par_nc_field_int(nc_hist_file->nc_id,
+                                     nc_hist_file->nc_vars[k].nc_varid,
+                                     nc_hist_file->i_fillvalue,
+                                     dstart, dcount, ivar);
             }
             else if (nc_hist_file->nc_vars[k].nc_type == NC_SHORT) {
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     svar[i] = (short int) stream->aggdata[i][k][j][0];
                 }
-                gather_put_nc_field_short(nc_hist_file->nc_id,
-                                          nc_hist_file->nc_vars[k].nc_varid,
-                                          nc_hist_file->s_fillvalue,
-                                          dstart, dcount, svar);
+                put_par_nc_field_short(nc_hist_file->nc_id,
+                                       nc_hist_file->nc_vars[k].nc_varid,
+                                       nc_hist_file->s_fillvalue,
+                                       dstart, dcount, svar);
             }
-            else if (nc_hist_file->nc_vars[k].nc_type == NC_CHAR) {
+            else {
                 for (i = 0; i < local_domain.ncells_active; i++) {
                     cvar[i] = (char) stream->aggdata[i][k][j][0];
                 }
-                gather_put_nc_field_schar(nc_hist_file->nc_id,
-                                          nc_hist_file->nc_vars[k].nc_varid,
-                                          nc_hist_file->d_fillvalue,
-                                          dstart, dcount, cvar);
-            }
-            else {
-                log_err("Unsupported nc_type encountered");
+                put_par_nc_field_schar(nc_hist_file->nc_id,
+                                       nc_hist_file->nc_vars[k].nc_varid,
+                                       nc_hist_file->d_fillvalue,
+                                       dstart, dcount, cvar);
             }
         }
 
@@ -209,73 +335,400 @@ vic_write(stream_struct  *stream,
         }
     }
 
+    // free memory
+    free(dvar);
+    free(fvar);
+    free(ivar);
+    free(svar);
+    free(cvar);
+}
+
+/******************************************************************************
+ * @brief    Start gathering and writing the variables of a record.
+ * @details  All variables and layers of the record are gathered in a single
+ *           non-blocking collective. The record is written on the master
+ *           node by wait_nc_io_request(&(nc_hist_file->io_request)), in the
+ *           cell loop of the next time step (progress_history_records()) or
+ *           at the latest before the next record of the file, a sync or a
+ *           close. The record of a split history file is gathered and
+ *           written by the group leader at once.
+ *****************************************************************************/
+static void
+start_history_record(stream_struct  *stream,
+                     nc_file_struct *nc_hist_file)
+{
+    extern metadata_struct     out_metadata[N_OUTVAR_TYPES];
+
+    nc_io_field_struct        *fields;
+    nc_var_struct             *nc_var;
+    double                    *aggvalues;
+    char                      *values;
+    size_t                     ncells;
+    size_t                     nelem;
+    size_t                     nbytes;
+    size_t                     ngrid;
+    size_t                     i;
+    size_t                     j;
+    size_t                     k;
+    size_t                     n;
+
+    // a stream of selected cells holds only those cells
+    ncells = stream->ngridcells;
+    fields = nc_hist_file->io_fields;
+    ngrid = (nc_hist_file->land_size > 0) ? 1 : 2;
+
+    nbytes = 0;
+    for (k = 0; k < stream->nvars; k++) {
+        nbytes += out_metadata[stream->varid[k]].nelem *
+                  get_nc_io_type_size(nc_hist_file->nc_vars[k].nc_type);
+    }
+    // the record is stored in the send buffer of the request in the output
+    // type of each variable: [nvars][nelem][ncells]
+    values = get_nc_io_send_buffer(&(nc_hist_file->io_request),
+                                   ncells * nbytes);
+
+    for (k = 0; k < stream->nvars; k++) {
+        nc_var = &(nc_hist_file->nc_vars[k]);
+        nelem = out_metadata[stream->varid[k]].nelem;
+
+        // all layers of the variable are written with one hyperslab; the
+        // size of the last two dimensions (or of the land dimension) are the
+        // grid size
+        for (j = 0; j < nc_var->nc_dims; j++) {
+            nc_var->io_start[j] = 0;
+            nc_var->io_count[j] = 1;
+        }
+        for (j = nc_var->nc_dims - ngrid; j < nc_var->nc_dims; j++) {
+            nc_var->io_count[j] = nc_var->nc_counts[j];
+        }
+        if (nc_var->nc_dims > 1 + ngrid) {
+            nc_var->io_count[1] = nelem;
+        }
+        // Position in the time dimensions
+        nc_var->io_start[0] = stream->write_alarm.count;
+
+        fields[k].nc_id = nc_hist_file->nc_id;
+        fields[k].nc_varid = nc_var->nc_varid;
+        fields[k].nc_type = nc_var->nc_type;
+        fields[k].nslices = nelem;
+        fields[k].start = nc_var->io_start;
+        fields[k].count = nc_var->io_count;
+        fields[k].land = (ngrid == 1);
+        fields[k].var = values;
+        values += nelem * ncells * get_nc_io_type_size(nc_var->nc_type);
+
+        if (nc_var->nc_type == NC_DOUBLE) {
+            fields[k].fillval = nc_hist_file->d_fillvalue;
+        }
+        else if (nc_var->nc_type == NC_FLOAT) {
+            fields[k].fillval = nc_hist_file->f_fillvalue;
+        }
+        else if (nc_var->nc_type == NC_INT) {
+            fields[k].fillval = nc_hist_file->i_fillvalue;
+        }
+        else if (nc_var->nc_type == NC_SHORT) {
+            fields[k].fillval = nc_hist_file->s_fillvalue;
+        }
+        else if (nc_var->nc_type == NC_CHAR) {
+            fields[k].fillval = nc_hist_file->d_fillvalue;
+        }
+        else {
+            log_err("Unsupported nc_type encountered");
+        }
+    }
+
+    // the aggregated values have the layout of the record and are converted
+    // to the output type of each variable when they are stored
+    aggvalues = stream->aggvalues;
+    for (k = 0; k < stream->nvars; k++) {
+        n = fields[k].nslices * ncells;
+        if (fields[k].nc_type == NC_DOUBLE) {
+            for (i = 0; i < n; i++) {
+                ((double *) fields[k].var)[i] = aggvalues[i];
+            }
+        }
+        else if (fields[k].nc_type == NC_FLOAT) {
+            for (i = 0; i < n; i++) {
+                ((float *) fields[k].var)[i] = (float) aggvalues[i];
+            }
+        }
+        else if (fields[k].nc_type == NC_INT) {
+            for (i = 0; i < n; i++) {
+                ((int *) fields[k].var)[i] = (int) aggvalues[i];
+            }
+        }
+        else if (fields[k].nc_type == NC_SHORT) {
+            for (i = 0; i < n; i++) {
+                ((short int *) fields[k].var)[i] = (short int) aggvalues[i];
+            }
+        }
+        else {
+            for (i = 0; i < n; i++) {
+                ((char *) fields[k].var)[i] = (char) aggvalues[i];
+            }
+        }
+        aggvalues += n;
+    }
+
+    if (nc_hist_file->split) {
+        // the record is written by the group leader
+        gather_put_split_fields(stream->nvars, fields);
+    }
+    else {
+        // the values are sent from the buffer of the request without a copy
+        start_gather_put_nc_fields(&(nc_hist_file->io_request),
+                                   stream->nvars, fields);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write output to netcdf file.
+ * @details  Except for parallel and split history files, the record is
+ *           gathered with a non-blocking collective and written on the
+ *           master node while the model advances, see
+ *           start_history_record().
+ *****************************************************************************/
+void
+vic_write(stream_struct  *stream,
+          nc_file_struct *nc_hist_file,
+          dmy_struct     *dmy_current)
+{
+    extern timer_struct        global_timers[N_TIMERS];
+
+    size_t                     dcount[MAXDIMS];
+    size_t                     dstart[MAXDIMS];
+    int                        status;
+    double                     bounds[2];
+
+    // the previous record of the file must be complete
+    wait_nc_io_request(&(nc_hist_file->io_request));
+
+    // the times of the gather and of the writes of the record by
+    // wait_nc_io_request() are added by the request
+    timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+    // parallel history files are opened and written by all nodes
+    if (is_history_writer(nc_hist_file)) {
+        // If the output file is not open, initialize the history file now.
+        if (nc_hist_file->open == false) {
+            // open the netcdf history file
+            initialize_history_file(nc_hist_file, stream, dmy_current);
+        }
+    }
+
+    if (nc_hist_file->parallel) {
+        put_par_history_record(stream, nc_hist_file);
+    }
+    else if (stream->region[0] != '\0') {
+        // the regions are small enough to be reduced and written at once
+        timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        timer_continue(&(global_timers[TIMER_VIC_HIST_GATHER]));
+        put_region_record(stream, nc_hist_file);
+        timer_stop(&(global_timers[TIMER_VIC_HIST_GATHER]));
+        timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+    }
+    else {
+        timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        timer_continue(&(global_timers[TIMER_VIC_HIST_GATHER]));
+        start_history_record(stream, nc_hist_file);
+        timer_stop(&(global_timers[TIMER_VIC_HIST_GATHER]));
+        timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+    }
+
     // write to file
-    if (mpi_rank == VIC_MPI_ROOT) {
+    if (is_history_writer(nc_hist_file)) {
         // Add time variable
         dstart[0] = stream->write_alarm.count;
-
-        // timestamp is the beginning of the aggregation window
-        dtime = date2num(global_param.time_origin_num,
-                         &(stream->time_bounds[0]), 0.,
-                         global_param.calendar, global_param.time_units);
+        get_history_time_bounds(stream, bounds);
 
         status = nc_put_var1_double(nc_hist_file->nc_id,
                                     nc_hist_file->time_varid,
-                                    dstart, &dtime);
+                                    dstart, &(bounds[0]));
         check_nc_status(status, "Error writing time variable");
 
         // Add time bounds variable
         dstart[1] = 0;
         dcount[0] = 1;
         dcount[1] = 2;
-        bounds[0] = dtime;
-        dt_seconds_to_time_units(global_param.time_units, global_param.dt,
-                                 &offset);
-        bounds[1] = offset + date2num(global_param.time_origin_num,
-                                      &(stream->time_bounds[1]), 0.,
-                                      global_param.calendar,
-                                      global_param.time_units);
 
         status = nc_put_vara_double(nc_hist_file->nc_id,
                                     nc_hist_file->time_bounds_varid,
                                     dstart, dcount, bounds);
         check_nc_status(status, "Error writing time bounds variable");
     }
+    timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
 
     // Advance the position in the history file
     stream->write_alarm.count++;
     if (raise_alarm(&(stream->write_alarm), dmy_current)) {
+        // the record must be written before the file is closed
+        wait_nc_io_request(&(nc_hist_file->io_request));
+
         // close this history file
-        if (mpi_rank == VIC_MPI_ROOT) {
+        if (is_history_writer(nc_hist_file)) {
+            timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+            if (nc_hist_file->direct) {
+                close_direct_chunks(nc_hist_file, stream);
+            }
             status = nc_close(nc_hist_file->nc_id);
             check_nc_status(status, "Error closing history file");
             nc_hist_file->open = false;
+            timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
         }
         reset_alarm(&(stream->write_alarm), dmy_current);
     }
     else {
-        // Force sync with disk (GH:#596)
-        if (mpi_rank == VIC_MPI_ROOT) {
-            status = nc_sync(nc_hist_file->nc_id);
-            check_nc_status(status, "Error syncing netCDF file %s",
-                            stream->filename);
+        // Force sync with disk (GH:#596), as often as the flush policy of
+        // the stream asks for
+        if (is_history_writer(nc_hist_file)) {
+            nc_hist_file->flush_count++;
+            if (check_flush_history_file(stream, nc_hist_file)) {
+                sync_history_file(stream, nc_hist_file);
+            }
         }
     }
+}
 
-    // free memory
-    if (dvar != NULL) {
-        free(dvar);
-    }
-    if (fvar != NULL) {
-        free(fvar);
+/******************************************************************************
+ * @brief    Compute the time bounds of the record of a stream in the time
+ *           units of the history files.
+ * @details  The timestamp of the record (bounds[0]) is the beginning of the
+ *           aggregation window.
+ *****************************************************************************/
+void
+get_history_time_bounds(stream_struct *stream,
+                        double        *bounds)
+{
+    extern global_param_struct global_param;
+
+    double                     offset;
+
+    bounds[0] = date2num(global_param.time_origin_num,
+                         &(stream->time_bounds[0]), 0.,
+                         global_param.calendar, global_param.time_units);
+    dt_seconds_to_time_units(global_param.time_units, global_param.dt,
+                             &offset);
+    bounds[1] = offset + date2num(global_param.time_origin_num,
+                                  &(stream->time_bounds[1]), 0.,
+                                  global_param.calendar,
+                                  global_param.time_units);
+}
+
+/******************************************************************************
+ * @brief    Check whether the flush policy of a stream asks for a sync of
+ *           its history file after the record that was just written.
+ *****************************************************************************/
+bool
+check_flush_history_file(stream_struct  *stream,
+                         nc_file_struct *nc_hist_file)
+{
+    extern MPI_Comm MPI_COMM_VIC;
+
+    bool            flush;
+    int             status;
+
+    switch (stream->flush) {
+    case FLUSH_ALWAYS:
+        flush = true;
+        break;
+    case FLUSH_NRECORDS:
+        flush = nc_hist_file->flush_count >= (unsigned int) stream->flush_n;
+        break;
+    case FLUSH_SECONDS:
+        flush = MPI_Wtime() - nc_hist_file->flush_time >=
+                (double) stream->flush_n;
+        if (nc_hist_file->parallel) {
+            // nc_sync is collective, so all nodes follow the master clock
+            status = MPI_Bcast(&flush, 1, MPI_C_BOOL, VIC_MPI_ROOT,
+                               MPI_COMM_VIC);
+            check_mpi_status(status, "MPI error.");
+        }
+        break;
+    default:
+        // FLUSH_NEVER and FLUSH_STATE
+        flush = false;
     }
-    if (ivar != NULL) {
-        free(ivar);
+
+    return flush;
+}
+
+/******************************************************************************
+ * @brief    Sync a history file with disk.
+ *****************************************************************************/
+void
+sync_history_file(stream_struct  *stream,
+                  nc_file_struct *nc_hist_file)
+{
+    extern timer_struct global_timers[N_TIMERS];
+
+    int                 status;
+
+    // the pending record must be written first
+    wait_nc_io_request(&(nc_hist_file->io_request));
+
+    timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+    status = nc_sync(nc_hist_file->nc_id);
+    check_nc_status(status, "Error syncing netCDF file %s", stream->filename);
+    timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+    nc_hist_file->flush_count = 0;
+    nc_hist_file->flush_time = MPI_Wtime();
+}
+
+/******************************************************************************
+ * @brief    Sync the open history files of the streams with FLUSH = STATE.
+ * @details  Called when a state file is written, so that the history files
+ *           on disk are consistent with the state file.
+ *****************************************************************************/
+void
+sync_history_files_on_state(void)
+{
+    extern option_struct   options;
+    extern stream_struct  *output_streams;
+    extern nc_file_struct *nc_hist_files;
+    extern int             mpi_rank;
+
+    size_t                 stream_idx;
+
+    for (stream_idx = 0; stream_idx < options.Noutstreams; stream_idx++) {
+        if (output_streams[stream_idx].flush != FLUSH_STATE) {
+            continue;
+        }
+        if (options.IO_SERVERS > 0) {
+            // the history files are open on the I/O servers
+            if (mpi_rank == VIC_MPI_ROOT) {
+                sync_io_server_file(stream_idx);
+            }
+        }
+        else if (nc_hist_files[stream_idx].open &&
+                 is_history_writer(&(nc_hist_files[stream_idx]))) {
+            sync_history_file(&(output_streams[stream_idx]),
+                              &(nc_hist_files[stream_idx]));
+        }
     }
-    if (svar != NULL) {
-        free(svar);
+}
+
+/******************************************************************************
+ * @brief    Complete the pending records of the history files.
+ * @details  Called by the master thread at the start of the cell loop of
+ *           vic_image_run(), so that the records of the last time step are
+ *           gathered and written by the master node while the other threads
+ *           run the physics of the current time step. The record of a stream
+ *           is held in the send buffer of its request, so the aggregated
+ *           values of the stream are free for the current time step.
+ *****************************************************************************/
+void
+progress_history_records(void)
+{
+    extern option_struct   options;
+    extern nc_file_struct *nc_hist_files;
+
+    size_t                 stream_idx;
+
+    if (options.IO_SERVERS > 0 || options.ASYNC_OUTPUT) {
+        return;
     }
-    if (cvar != NULL) {
-        free(cvar);
+    for (stream_idx = 0; stream_idx < options.Noutstreams; stream_idx++) {
+        if (!nc_hist_files[stream_idx].parallel) {
+            wait_nc_io_request(&(nc_hist_files[stream_idx].io_request));
+        }
     }
 }
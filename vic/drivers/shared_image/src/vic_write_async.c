@@ -0,0 +1,523 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Asynchronous history writer.
+ *
+ * When ASYNC_OUTPUT is TRUE, vic_write_async gathers the aggregated values of
+ * a history record to the master node and queues them in a ring buffer. A
+ * writer thread on the master node converts the values to the netCDF type of
+ * each variable, expands them to the full grid and writes them while the model
+ * advances. The gather itself remains on the main thread, since MPI is only
+ * called from there.
+ *
+ * The netCDF library is not thread-safe. The writer thread, the forcing reader
+ * thread and vic_force therefore take the netCDF lock around their netCDF
+ * calls, and all other netCDF access on the master node must be preceded by
+ * wait_async_output().
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_driver_shared_image.h>
+
+static async_output_struct async_output;
+static pthread_mutex_t     nc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/******************************************************************************
+ * @brief    Take the netCDF lock.
+ *****************************************************************************/
+void
+lock_netcdf(void)
+{
+    int status;
+
+    status = pthread_mutex_lock(&nc_lock);
+    if (status != 0) {
+        log_err("Could not lock netCDF library: %d", status);
+    }
+}
+
+/******************************************************************************
+ * @brief    Release the netCDF lock.
+ *****************************************************************************/
+void
+unlock_netcdf(void)
+{
+    int status;
+
+    status = pthread_mutex_unlock(&nc_lock);
+    if (status != 0) {
+        log_err("Could not unlock netCDF library: %d", status);
+    }
+}
+
+/******************************************************************************
+ * @brief    Write one layer of a variable of a queued record.
+ * @details  values holds the gathered values of the layer in the order of the
+ *           nodes.
+ *****************************************************************************/
+static void
+write_async_field(nc_file_struct *nc_hist_file,
+                  nc_var_struct  *nc_var,
+                  size_t         *start,
+                  size_t         *count,
+                  double         *values)
+{
+    extern domain_struct global_domain;
+    extern size_t       *mpi_map_grid_array;
+
+    double              *dvar;
+    float               *fvar;
+    int                 *ivar;
+    short int           *svar;
+    char                *cvar;
+    size_t               grid_size;
+    size_t               size;
+    size_t               i;
+    int                  status;
+
+    grid_size = global_domain.n_nx * global_domain.n_ny;
+
+    // convert to the type of the variable
+    if (nc_var->nc_type == NC_DOUBLE) {
+        size = sizeof(*dvar);
+        dvar = (double *) async_output.cvar;
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            dvar[i] = (double) values[i];
+        }
+        dvar = (double *) async_output.cvar_grid;
+        for (i = 0; i < grid_size; i++) {
+            dvar[i] = nc_hist_file->d_fillvalue;
+        }
+    }
+    else if (nc_var->nc_type == NC_FLOAT) {
+        size = sizeof(*fvar);
+        fvar = (float *) async_output.cvar;
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            fvar[i] = (float) values[i];
+        }
+        fvar = (float *) async_output.cvar_grid;
+        for (i = 0; i < grid_size; i++) {
+            fvar[i] = nc_hist_file->f_fillvalue;
+        }
+    }
+    else if (nc_var->nc_type == NC_INT) {
+        size = sizeof(*ivar);
+        ivar = (int *) async_output.cvar;
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            ivar[i] = (int) values[i];
+        }
+        ivar = (int *) async_output.cvar_grid;
+        for (i = 0; i < grid_size; i++) {
+            ivar[i] = nc_hist_file->i_fillvalue;
+        }
+    }
+    else if (nc_var->nc_type == NC_SHORT) {
+        size = sizeof(*svar);
+        svar = (short int *) async_output.cvar;
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            svar[i] = (short int) values[i];
+        }
+        svar = (short int *) async_output.cvar_grid;
+        for (i = 0; i < grid_size; i++) {
+            svar[i] = nc_hist_file->s_fillvalue;
+        }
+    }
+    else if (nc_var->nc_type == NC_CHAR) {
+        size = sizeof(*cvar);
+        cvar = (char *) async_output.cvar;
+        for (i = 0; i < global_domain.ncells_active; i++) {
+            cvar[i] = (char) values[i];
+        }
+        cvar = (char *) async_output.cvar_grid;
+        for (i = 0; i < grid_size; i++) {
+            cvar[i] = (char) nc_hist_file->d_fillvalue;
+        }
+    }
+    else {
+        log_err("Unsupported nc_type encountered");
+    }
+
+    // remap the array and expand to full grid size
+    map_to_grid(size, global_domain.ncells_active, mpi_map_grid_array,
+                async_output.cvar, async_output.cvar_grid);
+
+    lock_netcdf();
+    if (nc_var->nc_type == NC_DOUBLE) {
+        status = nc_put_vara_double(nc_hist_file->nc_id, nc_var->nc_varid,
+                                    start, count, async_output.cvar_grid);
+    }
+    else if (nc_var->nc_type == NC_FLOAT) {
+        status = nc_put_vara_float(nc_hist_file->nc_id, nc_var->nc_varid,
+                                   start, count, async_output.cvar_grid);
+    }
+    else if (nc_var->nc_type == NC_INT) {
+        status = nc_put_vara_int(nc_hist_file->nc_id, nc_var->nc_varid,
+                                 start, count, async_output.cvar_grid);
+    }
+    else if (nc_var->nc_type == NC_SHORT) {
+        status = nc_put_vara_short(nc_hist_file->nc_id, nc_var->nc_varid,
+                                   start, count, async_output.cvar_grid);
+    }
+    else {
+        status = nc_put_vara_schar(nc_hist_file->nc_id, nc_var->nc_varid,
+                                   start, count, async_output.cvar_grid);
+    }
+    unlock_netcdf();
+    check_nc_status(status, "Error writing values.");
+}
+
+/******************************************************************************
+ * @brief    Write a gathered record to its history file.
+ * @details  Used by the writer thread and by the I/O servers (IO_SERVERS).
+ *           The buffers must have been allocated with
+ *           alloc_history_record_buffers().
+ *****************************************************************************/
+void
+write_history_record(async_record_struct *record)
+{
+    extern domain_struct   global_domain;
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+
+    stream_struct         *stream = record->stream;
+    nc_file_struct        *nc_hist_file = record->nc_hist_file;
+    nc_var_struct         *nc_var;
+    size_t                 dcount[MAXDIMS];
+    size_t                 dstart[MAXDIMS];
+    size_t                 ndims;
+    size_t                 offset;
+    size_t                 j;
+    size_t                 k;
+    int                    status;
+
+    offset = 0;
+    for (k = 0; k < stream->nvars; k++) {
+        nc_var = &(nc_hist_file->nc_vars[k]);
+
+        // files are written one slice at a time, see vic_write
+        ndims = nc_var->nc_dims;
+        for (j = 0; j < ndims; j++) {
+            dstart[j] = 0;
+            dcount[j] = 1;
+        }
+        for (j = ndims - 2; j < ndims; j++) {
+            dcount[j] = nc_var->nc_counts[j];
+        }
+        dstart[0] = record->time_idx;
+
+        for (j = 0; j < out_metadata[stream->varid[k]].nelem; j++) {
+            dstart[1] = j;
+            write_async_field(nc_hist_file, nc_var, dstart, dcount,
+                              &(record->data[offset]));
+            offset += global_domain.ncells_active;
+        }
+    }
+
+    lock_netcdf();
+    dstart[0] = record->time_idx;
+    status = nc_put_var1_double(nc_hist_file->nc_id,
+                                nc_hist_file->time_varid,
+                                dstart, &(record->time_bounds[0]));
+    check_nc_status(status, "Error writing time variable");
+
+    dstart[1] = 0;
+    dcount[0] = 1;
+    dcount[1] = 2;
+    status = nc_put_vara_double(nc_hist_file->nc_id,
+                                nc_hist_file->time_bounds_varid,
+                                dstart, dcount, record->time_bounds);
+    check_nc_status(status, "Error writing time bounds variable");
+
+    if (record->close) {
+        status = nc_close(nc_hist_file->nc_id);
+        check_nc_status(status, "Error closing history file");
+    }
+    else if (record->sync) {
+        status = nc_sync(nc_hist_file->nc_id);
+        check_nc_status(status, "Error syncing netCDF file %s",
+                        stream->filename);
+    }
+    unlock_netcdf();
+}
+
+/******************************************************************************
+ * @brief    Writer thread: write the queued records in order.
+ *****************************************************************************/
+static void *
+write_async_records(void *arg)
+{
+    async_output_struct *output = (async_output_struct *) arg;
+
+    pthread_mutex_lock(&(output->mutex));
+    while (true) {
+        while (output->nqueued == 0 && !output->done) {
+            pthread_cond_wait(&(output->cond), &(output->mutex));
+        }
+        if (output->nqueued == 0) {
+            break;
+        }
+        pthread_mutex_unlock(&(output->mutex));
+
+        write_history_record(&(output->records[output->first]));
+
+        pthread_mutex_lock(&(output->mutex));
+        output->first = (output->first + 1) % MAX_ASYNC_RECORDS;
+        output->nqueued--;
+        pthread_cond_broadcast(&(output->cond));
+    }
+    pthread_mutex_unlock(&(output->mutex));
+
+    return NULL;
+}
+
+/******************************************************************************
+ * @brief    Allocate the buffers used by write_history_record().
+ *****************************************************************************/
+void
+alloc_history_record_buffers(void)
+{
+    extern domain_struct global_domain;
+
+    size_t               grid_size;
+
+    // the buffers are large enough for the widest type (double)
+    grid_size = global_domain.n_nx * global_domain.n_ny;
+    async_output.cvar = malloc(global_domain.ncells_active * sizeof(double));
+    check_alloc_status(async_output.cvar, "Memory allocation error.");
+    async_output.cvar_grid = malloc(grid_size * sizeof(double));
+    check_alloc_status(async_output.cvar_grid, "Memory allocation error.");
+}
+
+/******************************************************************************
+ * @brief    Free the buffers used by write_history_record().
+ *****************************************************************************/
+void
+free_history_record_buffers(void)
+{
+    free(async_output.cvar);
+    free(async_output.cvar_grid);
+    async_output.cvar = NULL;
+    async_output.cvar_grid = NULL;
+}
+
+/******************************************************************************
+ * @brief    Allocate the buffers of the asynchronous history writer and start
+ *           the writer thread on the master node.
+ *****************************************************************************/
+void
+initialize_async_output(void)
+{
+    extern domain_struct local_domain;
+    extern option_struct options;
+    extern int           mpi_rank;
+
+    size_t               i;
+    int                  status;
+
+    if (!options.ASYNC_OUTPUT) {
+        return;
+    }
+
+    async_output.dvar = malloc(local_domain.ncells_active *
+                               sizeof(*(async_output.dvar)));
+    check_alloc_status(async_output.dvar, "Memory allocation error.");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        alloc_history_record_buffers();
+
+        for (i = 0; i < MAX_ASYNC_RECORDS; i++) {
+            async_output.records[i].nelem = 0;
+            async_output.records[i].data = NULL;
+        }
+        async_output.first = 0;
+        async_output.nqueued = 0;
+        async_output.done = false;
+
+        pthread_mutex_init(&(async_output.mutex), NULL);
+        pthread_cond_init(&(async_output.cond), NULL);
+        status = pthread_create(&(async_output.thread), NULL,
+                                write_async_records, &async_output);
+        if (status != 0) {
+            log_err("Could not start history writer thread: %d", status);
+        }
+        async_output.active = true;
+    }
+}
+
+/******************************************************************************
+ * @brief    Wait until all queued history records have been written.
+ *****************************************************************************/
+void
+wait_async_output(void)
+{
+    if (!async_output.active) {
+        return;
+    }
+
+    pthread_mutex_lock(&(async_output.mutex));
+    while (async_output.nqueued > 0) {
+        pthread_cond_wait(&(async_output.cond), &(async_output.mutex));
+    }
+    pthread_mutex_unlock(&(async_output.mutex));
+}
+
+/******************************************************************************
+ * @brief    Write the queued history records, stop the writer thread and free
+ *           the buffers of the asynchronous history writer.
+ *****************************************************************************/
+void
+finalize_async_output(void)
+{
+    size_t i;
+    int    status;
+
+    if (async_output.active) {
+        pthread_mutex_lock(&(async_output.mutex));
+        async_output.done = true;
+        pthread_cond_broadcast(&(async_output.cond));
+        pthread_mutex_unlock(&(async_output.mutex));
+
+        status = pthread_join(async_output.thread, NULL);
+        if (status != 0) {
+            log_err("Could not join history writer thread: %d", status);
+        }
+        async_output.active = false;
+
+        pthread_cond_destroy(&(async_output.cond));
+        pthread_mutex_destroy(&(async_output.mutex));
+
+        for (i = 0; i < MAX_ASYNC_RECORDS; i++) {
+            free(async_output.records[i].data);
+            async_output.records[i].data = NULL;
+            async_output.records[i].nelem = 0;
+        }
+        free_history_record_buffers();
+    }
+    free(async_output.dvar);
+    async_output.dvar = NULL;
+}
+
+/******************************************************************************
+ * @brief    Gather a history record and queue it for the writer thread.
+ * @details  Drop-in replacement for vic_write() when ASYNC_OUTPUT is TRUE.
+ *           Waits if the ring buffer is full.
+ *****************************************************************************/
+void
+vic_write_async(stream_struct  *stream,
+                nc_file_struct *nc_hist_file,
+                dmy_struct     *dmy_current)
+{
+    extern domain_struct   global_domain;
+    extern domain_struct   local_domain;
+    extern int             mpi_rank;
+    extern metadata_struct out_metadata[N_OUTVAR_TYPES];
+    extern timer_struct    global_timers[N_TIMERS];
+
+    async_record_struct   *record = NULL;
+    size_t                 nelem;
+    size_t                 offset;
+    size_t                 i;
+    size_t                 j;
+    size_t                 k;
+    bool                   close;
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        // the writer thread does not take the timers; the history write time
+        // is the time the model waits for it
+        timer_continue(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        if (nc_hist_file->open == false) {
+            // initialize_history_file uses the netCDF library directly
+            wait_async_output();
+            initialize_history_file(nc_hist_file, stream, dmy_current);
+        }
+
+        // wait for a free slot in the ring buffer
+        pthread_mutex_lock(&(async_output.mutex));
+        while (async_output.nqueued == MAX_ASYNC_RECORDS) {
+            pthread_cond_wait(&(async_output.cond), &(async_output.mutex));
+        }
+        record = &(async_output.records[(async_output.first +
+                                         async_output.nqueued) %
+                                        MAX_ASYNC_RECORDS]);
+        pthread_mutex_unlock(&(async_output.mutex));
+        timer_stop(&(global_timers[TIMER_VIC_HIST_WRITE]));
+        record->time_idx = stream->write_alarm.count;
+
+        nelem = 0;
+        for (k = 0; k < stream->nvars; k++) {
+            nelem += out_metadata[stream->varid[k]].nelem *
+                     global_domain.ncells_active;
+        }
+        if (nelem > record->nelem) {
+            free(record->data);
+            record->data = malloc(nelem * sizeof(*(record->data)));
+            check_alloc_status(record->data, "Memory allocation error.");
+            record->nelem = nelem;
+        }
+    }
+
+    // snapshot the aggregated values on the master node
+    timer_continue(&(global_timers[TIMER_VIC_HIST_GATHER]));
+    offset = 0;
+    for (k = 0; k < stream->nvars; k++) {
+        for (j = 0; j < out_metadata[stream->varid[k]].nelem; j++) {
+            for (i = 0; i < local_domain.ncells_active; i++) {
+                async_output.dvar[i] = stream->aggdata[i][k][j][0];
+            }
+            gather_field_double(async_output.dvar,
+                                record == NULL ? NULL :
+                                &(record->data[offset]));
+            offset += global_domain.ncells_active;
+        }
+    }
+    timer_stop(&(global_timers[TIMER_VIC_HIST_GATHER]));
+
+    // Advance the position in the history file
+    stream->write_alarm.count++;
+    close = raise_alarm(&(stream->write_alarm), dmy_current);
+    if (close) {
+        reset_alarm(&(stream->write_alarm), dmy_current);
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        record->stream = stream;
+        record->nc_hist_file = nc_hist_file;
+        get_history_time_bounds(stream, record->time_bounds);
+        record->close = close;
+        record->sync = false;
+        if (close) {
+            nc_hist_file->open = false;
+        }
+        else {
+            nc_hist_file->flush_count++;
+            if (check_flush_history_file(stream, nc_hist_file)) {
+                record->sync = true;
+                nc_hist_file->flush_count = 0;
+                nc_hist_file->flush_time = MPI_Wtime();
+            }
+        }
+
+        pthread_mutex_lock(&(async_output.mutex));
+        async_output.nqueued++;
+        pthread_cond_broadcast(&(async_output.cond));
+        pthread_mutex_unlock(&(async_output.mutex));
+    }
+}
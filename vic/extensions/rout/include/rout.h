@@ -0,0 +1,142 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Header file for the inline runoff routing extension of the image driver
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef ROUT_H
+#define ROUT_H
+
+#include <vic_driver_shared_image.h>
+
+#define ROUT_TAG_FLOW 1    /**< message tag of the flows between processes */
+#define ROUT_OUTLET -1     /**< downstream process of an outlet cell */
+#define ROUT_NO_GAUGE -1   /**< gauge of a cell without a gauge */
+#define ROUT_NSLOTS 8      /**< inflows of a cell with REPRODUCIBLE, one per
+                                D8 direction of the upstream cell */
+
+/******************************************************************************
+ * @brief   D8 flow directions of the routing parameter file, clockwise from
+ *          north as in the routing model of Lohmann et al. (1996). Any other
+ *          value marks an outlet.
+ *****************************************************************************/
+enum
+{
+    ROUT_DIR_N = 1,
+    ROUT_DIR_NE,
+    ROUT_DIR_E,
+    ROUT_DIR_SE,
+    ROUT_DIR_S,
+    ROUT_DIR_SW,
+    ROUT_DIR_W,
+    ROUT_DIR_NW
+};
+
+/******************************************************************************
+ * @brief   Flows of one level of the river network that are sent to or
+ *          received from another process in each time step.
+ * @details The message holds pairs of the local index of the downstream cell
+ *          on the receiving process and the flow (m3/s). With REPRODUCIBLE,
+ *          the index is that of the inflow slot of the downstream cell in
+ *          up_flow.
+ *****************************************************************************/
+typedef struct {
+    size_t level;                /**< level of the upstream cells */
+    int peer;                    /**< rank of the other process */
+    size_t count;                /**< number of flows */
+    size_t *cells;               /**< local upstream cells (sends only)
+                                    [count] */
+    double *buf;                 /**< packed pairs [2 * count] */
+} rout_exchange_struct;
+
+/******************************************************************************
+ * @brief   River network and channel storage of the local cells.
+ * @details Each cell passes the water that enters it (its own runoff and the
+ *          outflow of its upstream cells) through its unit hydrograph to its
+ *          downstream cell. The level of a cell is the length of the longest
+ *          path from a headwater cell to the cell, so all upstream cells of a
+ *          cell have a lower level. The cells of a level are independent of
+ *          each other and are routed in parallel, and the outflows of a
+ *          level that cross to another process are exchanged before the
+ *          next level is routed. With REPRODUCIBLE, each upstream cell
+ *          stores its outflow in the slot of its flow direction, and the
+ *          inflow of a cell is the sum of its slots in a fixed order, which
+ *          does not depend on the decomposition of the domain.
+ *****************************************************************************/
+typedef struct {
+    bool active;                 /**< TRUE = ROUT_PARAM was given */
+    size_t nuh;                  /**< time steps of the unit hydrographs */
+    size_t nlevels;              /**< levels of the whole river network */
+    size_t *level_start;         /**< first entry of each level in cells
+                                    [nlevels + 1] */
+    size_t *cells;               /**< local cells sorted by level [ncells] */
+    int *down_rank;              /**< process of the downstream cell,
+                                    ROUT_OUTLET = the water leaves the
+                                    domain [ncells] */
+    size_t *down_idx;            /**< local index of the downstream cell on
+                                    down_rank [ncells] */
+    size_t *down_slot;           /**< inflow slot of the cell in its
+                                    downstream cell, the flow direction
+                                    minus one [ncells] */
+    double *uh;                  /**< unit hydrograph of each cell, the
+                                    fraction of the water entering the cell
+                                    that leaves it k time steps later
+                                    [ncells * nuh] */
+    double *ring;                /**< water that entered each cell in the
+                                    last nuh time steps (m3/s)
+                                    [ncells * nuh] */
+    size_t ring_pos;             /**< position of the current time step in
+                                    ring */
+    double *runin;               /**< runoff and baseflow of each cell
+                                    (m3/s) [ncells] */
+    double *inflow;              /**< inflow from the upstream cells (m3/s)
+                                    [ncells] */
+    double *up_flow;             /**< outflow of the upstream cells of each
+                                    cell by inflow slot (m3/s, REPRODUCIBLE
+                                    only) [ncells * ROUT_NSLOTS] */
+    double *outflow;             /**< outflow of each cell (m3/s) [ncells] */
+    size_t nsends;               /**< number of sends per time step */
+    rout_exchange_struct *sends; /**< sends sorted by level [nsends] */
+    size_t nrecvs;               /**< number of receives per time step */
+    rout_exchange_struct *recvs; /**< receives sorted by level [nrecvs] */
+    MPI_Request *requests;       /**< requests of one level
+                                    [nsends + nrecvs] */
+    size_t ngauges;              /**< number of gauges of the domain */
+    int *gauge;                  /**< gauge of each cell, ROUT_NO_GAUGE = none
+                                    [ncells] */
+    double *gauge_flow;          /**< streamflow at the gauges of the local
+                                    cells (m3/s) [ngauges] */
+    double *streamflow;          /**< streamflow at all gauges (m3/s, master
+                                    node) [ngauges] */
+    char filename[MAXSTRING];    /**< streamflow file (master node) */
+    int nc_id;                   /**< streamflow file id (master node) */
+    int time_varid;              /**< time variable id (master node) */
+    int flow_varid;              /**< streamflow variable id (master node) */
+    size_t nrecs;                /**< records written to the streamflow file */
+} rout_struct;
+
+void rout_finalize(void);
+void rout_init(void);
+void rout_run(dmy_struct *dmy_current);
+
+#endif
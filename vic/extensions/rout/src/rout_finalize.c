@@ -0,0 +1,77 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Finalize the inline routing of the image driver.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <rout.h>
+
+/******************************************************************************
+ * @brief    Close the streamflow file and free the river network.
+ *****************************************************************************/
+void
+rout_finalize(void)
+{
+    extern int         mpi_rank;
+    extern rout_struct rout;
+
+    size_t             k;
+    int                status;
+
+    if (!rout.active) {
+        return;
+    }
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        lock_netcdf();
+        status = nc_close(rout.nc_id);
+        check_nc_status(status, "Error closing %s", rout.filename);
+        unlock_netcdf();
+        free(rout.streamflow);
+    }
+
+    for (k = 0; k < rout.nsends; k++) {
+        free(rout.sends[k].cells);
+        free(rout.sends[k].buf);
+    }
+    for (k = 0; k < rout.nrecvs; k++) {
+        free(rout.recvs[k].buf);
+    }
+    free(rout.sends);
+    free(rout.recvs);
+    free(rout.requests);
+    free(rout.level_start);
+    free(rout.cells);
+    free(rout.down_rank);
+    free(rout.down_idx);
+    free(rout.down_slot);
+    free(rout.gauge);
+    free(rout.uh);
+    free(rout.ring);
+    free(rout.runin);
+    free(rout.inflow);
+    free(rout.up_flow);
+    free(rout.outflow);
+    free(rout.gauge_flow);
+    rout.active = false;
+}
@@ -0,0 +1,725 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Read the river network and partition it over the MPI processes.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <rout.h>
+
+// values per cell scattered from the master node
+enum
+{
+    ROUT_INFO_DOWN_RANK,
+    ROUT_INFO_DOWN_IDX,
+    ROUT_INFO_DOWN_SLOT,
+    ROUT_INFO_LEVEL,
+    ROUT_INFO_GAUGE,
+    N_ROUT_INFO
+};
+
+/******************************************************************************
+ * @brief    Compare two rows of three integers, for qsort.
+ *****************************************************************************/
+static int
+compare_rout_rows(const void *a,
+                  const void *b)
+{
+    const int *ra = (const int *) a;
+    const int *rb = (const int *) b;
+    size_t     i;
+
+    for (i = 0; i < 3; i++) {
+        if (ra[i] != rb[i]) {
+            return ra[i] < rb[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * @brief    Downstream cell of a grid cell from its D8 flow direction.
+ * @details  Returns the grid index of the downstream cell, or ncells_total
+ *           if the direction is an outlet or points outside the grid. North
+ *           is the direction of increasing latitude and east the direction
+ *           of increasing x.
+ *****************************************************************************/
+static size_t
+get_rout_downstream(size_t grid_idx,
+                    int    flow_dir,
+                    int    north)
+{
+    extern domain_struct global_domain;
+
+    long                 x;
+    long                 y;
+    long                 dx;
+    long                 dy;
+
+    switch (flow_dir) {
+    case ROUT_DIR_N:
+        dx = 0;
+        dy = 1;
+        break;
+    case ROUT_DIR_NE:
+        dx = 1;
+        dy = 1;
+        break;
+    case ROUT_DIR_E:
+        dx = 1;
+        dy = 0;
+        break;
+    case ROUT_DIR_SE:
+        dx = 1;
+        dy = -1;
+        break;
+    case ROUT_DIR_S:
+        dx = 0;
+        dy = -1;
+        break;
+    case ROUT_DIR_SW:
+        dx = -1;
+        dy = -1;
+        break;
+    case ROUT_DIR_W:
+        dx = -1;
+        dy = 0;
+        break;
+    case ROUT_DIR_NW:
+        dx = -1;
+        dy = 1;
+        break;
+    default:
+        return global_domain.ncells_total;
+    }
+
+    x = (long) (grid_idx % global_domain.n_nx) + dx;
+    y = (long) (grid_idx / global_domain.n_nx) + dy * north;
+    if (x < 0 || x >= (long) global_domain.n_nx ||
+        y < 0 || y >= (long) global_domain.n_ny) {
+        return global_domain.ncells_total;
+    }
+    return (size_t) y * global_domain.n_nx + (size_t) x;
+}
+
+/******************************************************************************
+ * @brief    Build the river network of the whole domain on the master node.
+ * @details  The cells are numbered in the order of the MPI decomposition.
+ *           Sets the downstream process and local index, the level and the
+ *           gauge of each cell in info, the flows that each process receives
+ *           from other processes (rows of level, sending process and number
+ *           of flows, grouped by the receiving process) in recv_rows and
+ *           recv_counts, and the gauge ids and coordinates in gauge_ids,
+ *           gauge_lats and gauge_lons.
+ *****************************************************************************/
+static void
+build_rout_network(int     *info,
+                   int    **recv_rows,
+                   int     *recv_counts,
+                   int    **gauge_ids,
+                   double **gauge_lats,
+                   double **gauge_lons)
+{
+    extern domain_struct    global_domain;
+    extern filenames_struct filenames;
+    extern int             *mpi_map_global_array_offsets;
+    extern int             *mpi_map_local_array_sizes;
+    extern size_t          *mpi_map_grid_array;
+    extern int              mpi_size;
+    extern rout_struct      rout;
+
+    size_t                  d2count[2];
+    size_t                  d2start[2];
+    size_t                  nactive;
+    size_t                  ngrid;
+    size_t                  ncross;
+    size_t                  nrows;
+    size_t                  head;
+    size_t                  tail;
+    size_t                  i;
+    size_t                  k;
+    size_t                  d;
+    size_t                 *pos;
+    size_t                 *down;
+    size_t                 *indeg;
+    size_t                 *level;
+    size_t                 *queue;
+    int                    *rank;
+    int                    *flow_dir;
+    int                    *gauge_id;
+    int                    *cross;
+    int                     north;
+    int                     r;
+
+    nactive = global_domain.ncells_active;
+    ngrid = global_domain.ncells_total;
+
+    compare_ncdomain_with_global_domain(filenames.rout_params);
+
+    d2start[0] = 0;
+    d2start[1] = 0;
+    d2count[0] = global_domain.n_ny;
+    d2count[1] = global_domain.n_nx;
+
+    flow_dir = malloc(ngrid * sizeof(*flow_dir));
+    check_alloc_status(flow_dir, "Memory allocation error.");
+    gauge_id = malloc(ngrid * sizeof(*gauge_id));
+    check_alloc_status(gauge_id, "Memory allocation error.");
+    get_nc_field_int(filenames.rout_params, "flow_direction", d2start, d2count,
+                     flow_dir);
+    get_nc_field_int(filenames.rout_params, "gauge", d2start, d2count,
+                     gauge_id);
+
+    // position of each active grid cell in the MPI decomposition
+    pos = malloc(ngrid * sizeof(*pos));
+    check_alloc_status(pos, "Memory allocation error.");
+    for (i = 0; i < ngrid; i++) {
+        pos[i] = nactive;
+    }
+    for (k = 0; k < nactive; k++) {
+        pos[mpi_map_grid_array[k]] = k;
+    }
+    rank = malloc(nactive * sizeof(*rank));
+    check_alloc_status(rank, "Memory allocation error.");
+    for (r = 0; r < mpi_size; r++) {
+        for (i = 0; i < (size_t) mpi_map_local_array_sizes[r]; i++) {
+            rank[mpi_map_global_array_offsets[r] + i] = r;
+        }
+    }
+
+    // downstream cell of each cell, nactive = outlet
+    north = 1;
+    if (global_domain.n_ny > 1 &&
+        global_domain.locations[global_domain.n_nx].latitude <
+        global_domain.locations[0].latitude) {
+        north = -1;
+    }
+    down = malloc(nactive * sizeof(*down));
+    check_alloc_status(down, "Memory allocation error.");
+    indeg = calloc(nactive, sizeof(*indeg));
+    check_alloc_status(indeg, "Memory allocation error.");
+    for (k = 0; k < nactive; k++) {
+        d = get_rout_downstream(mpi_map_grid_array[k],
+                                flow_dir[mpi_map_grid_array[k]], north);
+        down[k] = d < ngrid ? pos[d] : nactive;
+        if (down[k] < nactive) {
+            indeg[down[k]]++;
+        }
+    }
+
+    // levels of the cells in topological order, starting at the headwaters
+    level = calloc(nactive, sizeof(*level));
+    check_alloc_status(level, "Memory allocation error.");
+    queue = malloc(nactive * sizeof(*queue));
+    check_alloc_status(queue, "Memory allocation error.");
+    head = 0;
+    tail = 0;
+    for (k = 0; k < nactive; k++) {
+        if (indeg[k] == 0) {
+            queue[tail++] = k;
+        }
+    }
+    rout.nlevels = 0;
+    while (head < tail) {
+        k = queue[head++];
+        if (level[k] + 1 > rout.nlevels) {
+            rout.nlevels = level[k] + 1;
+        }
+        d = down[k];
+        if (d < nactive) {
+            if (level[d] < level[k] + 1) {
+                level[d] = level[k] + 1;
+            }
+            indeg[d]--;
+            if (indeg[d] == 0) {
+                queue[tail++] = d;
+            }
+        }
+    }
+    if (tail < nactive) {
+        log_err("The flow directions in %s form a loop through %zu grid "
+                "cells", filenames.rout_params, nactive - tail);
+    }
+
+    // gauges in the order of the grid
+    rout.ngauges = 0;
+    for (i = 0; i < ngrid; i++) {
+        if (pos[i] < nactive && gauge_id[i] > 0) {
+            rout.ngauges++;
+        }
+    }
+    if (rout.ngauges == 0) {
+        log_err("There are no gauges (gauge > 0) on the active grid cells "
+                "of %s", filenames.rout_params);
+    }
+    *gauge_ids = malloc(rout.ngauges * sizeof(**gauge_ids));
+    check_alloc_status(*gauge_ids, "Memory allocation error.");
+    *gauge_lats = malloc(rout.ngauges * sizeof(**gauge_lats));
+    check_alloc_status(*gauge_lats, "Memory allocation error.");
+    *gauge_lons = malloc(rout.ngauges * sizeof(**gauge_lons));
+    check_alloc_status(*gauge_lons, "Memory allocation error.");
+    for (k = 0; k < nactive; k++) {
+        info[k * N_ROUT_INFO + ROUT_INFO_GAUGE] = ROUT_NO_GAUGE;
+    }
+    for (i = 0, k = 0; i < ngrid; i++) {
+        if (pos[i] < nactive && gauge_id[i] > 0) {
+            info[pos[i] * N_ROUT_INFO + ROUT_INFO_GAUGE] = (int) k;
+            (*gauge_ids)[k] = gauge_id[i];
+            (*gauge_lats)[k] = global_domain.locations[i].latitude;
+            (*gauge_lons)[k] = global_domain.locations[i].longitude;
+            k++;
+        }
+    }
+
+    // downstream process and local index, and the flows between processes
+    // as rows of receiving process, level and sending process
+    cross = malloc(3 * nactive * sizeof(*cross));
+    check_alloc_status(cross, "Memory allocation error.");
+    ncross = 0;
+    for (k = 0; k < nactive; k++) {
+        d = down[k];
+        info[k * N_ROUT_INFO + ROUT_INFO_LEVEL] = (int) level[k];
+        if (d < nactive) {
+            info[k * N_ROUT_INFO + ROUT_INFO_DOWN_RANK] = rank[d];
+            info[k * N_ROUT_INFO + ROUT_INFO_DOWN_IDX] =
+                (int) d - mpi_map_global_array_offsets[rank[d]];
+            info[k * N_ROUT_INFO + ROUT_INFO_DOWN_SLOT] =
+                flow_dir[mpi_map_grid_array[k]] - ROUT_DIR_N;
+            if (rank[d] != rank[k]) {
+                cross[3 * ncross] = rank[d];
+                cross[3 * ncross + 1] = (int) level[k];
+                cross[3 * ncross + 2] = rank[k];
+                ncross++;
+            }
+        }
+        else {
+            info[k * N_ROUT_INFO + ROUT_INFO_DOWN_RANK] = ROUT_OUTLET;
+            info[k * N_ROUT_INFO + ROUT_INFO_DOWN_IDX] = 0;
+            info[k * N_ROUT_INFO + ROUT_INFO_DOWN_SLOT] = 0;
+        }
+    }
+    qsort(cross, ncross, 3 * sizeof(*cross), compare_rout_rows);
+
+    // one receive per receiving process, level and sending process
+    *recv_rows = malloc((3 * ncross + 1) * sizeof(**recv_rows));
+    check_alloc_status(*recv_rows, "Memory allocation error.");
+    for (r = 0; r < mpi_size; r++) {
+        recv_counts[r] = 0;
+    }
+    nrows = 0;
+    for (i = 0; i < ncross; i++) {
+        if (i == 0 || compare_rout_rows(&(cross[3 * i]),
+                                        &(cross[3 * (i - 1)])) != 0) {
+            (*recv_rows)[3 * nrows] = cross[3 * i + 1];
+            (*recv_rows)[3 * nrows + 1] = cross[3 * i + 2];
+            (*recv_rows)[3 * nrows + 2] = 0;
+            recv_counts[cross[3 * i]] += 3;
+            nrows++;
+        }
+        (*recv_rows)[3 * (nrows - 1) + 2]++;
+    }
+
+    free(cross);
+    free(queue);
+    free(level);
+    free(indeg);
+    free(down);
+    free(rank);
+    free(pos);
+    free(gauge_id);
+    free(flow_dir);
+}
+
+/******************************************************************************
+ * @brief    Create the streamflow file on the master node.
+ *****************************************************************************/
+static void
+initialize_rout_file(int    *gauge_ids,
+                     double *gauge_lats,
+                     double *gauge_lons)
+{
+    extern filenames_struct    filenames;
+    extern global_param_struct global_param;
+    extern rout_struct         rout;
+
+    char                       unit_str[MAXSTRING];
+    char                       calendar_str[MAXSTRING];
+    char                       str[MAXSTRING];
+    int                        dimids[2];
+    int                        gauge_varid;
+    int                        lat_varid;
+    int                        lon_varid;
+    int                        status;
+    size_t                     start;
+    size_t                     count;
+    double                     fillval = NC_FILL_DOUBLE;
+
+    sprintf(rout.filename, "%s/streamflow.%04d-%02d-%02d-%05u.nc",
+            filenames.result_dir, global_param.startyear,
+            global_param.startmonth, global_param.startday,
+            global_param.startsec);
+
+    status = nc_create(rout.filename, NC_CLOBBER | NC_64BIT_OFFSET,
+                       &(rout.nc_id));
+    check_nc_status(status, "Error creating %s", rout.filename);
+    set_global_nc_attributes(rout.nc_id, NC_STREAMFLOW_FILE);
+
+    status = nc_def_dim(rout.nc_id, "time", NC_UNLIMITED, &(dimids[0]));
+    check_nc_status(status, "Error defining time dimension in %s",
+                    rout.filename);
+    status = nc_def_dim(rout.nc_id, "gauge", rout.ngauges, &(dimids[1]));
+    check_nc_status(status, "Error defining gauge dimension in %s",
+                    rout.filename);
+
+    status = nc_def_var(rout.nc_id, "time", NC_DOUBLE, 1, &(dimids[0]),
+                        &(rout.time_varid));
+    check_nc_status(status, "Error defining time variable in %s",
+                    rout.filename);
+    put_nc_attr(rout.nc_id, rout.time_varid, "standard_name", "time");
+    str_from_time_units(global_param.time_units, unit_str);
+    sprintf(str, "%s since %s", unit_str, global_param.time_origin_str);
+    put_nc_attr(rout.nc_id, rout.time_varid, "units", str);
+    str_from_calendar(global_param.calendar, calendar_str);
+    put_nc_attr(rout.nc_id, rout.time_varid, "calendar", calendar_str);
+
+    status = nc_def_var(rout.nc_id, "gauge", NC_INT, 1, &(dimids[1]),
+                        &gauge_varid);
+    check_nc_status(status, "Error defining gauge variable in %s",
+                    rout.filename);
+    put_nc_attr(rout.nc_id, gauge_varid, "long_name", "gauge id");
+    status = nc_def_var(rout.nc_id, "lat", NC_DOUBLE, 1, &(dimids[1]),
+                        &lat_varid);
+    check_nc_status(status, "Error defining lat variable in %s",
+                    rout.filename);
+    put_nc_attr(rout.nc_id, lat_varid, "standard_name", "latitude");
+    put_nc_attr(rout.nc_id, lat_varid, "units", "degrees_north");
+    status = nc_def_var(rout.nc_id, "lon", NC_DOUBLE, 1, &(dimids[1]),
+                        &lon_varid);
+    check_nc_status(status, "Error defining lon variable in %s",
+                    rout.filename);
+    put_nc_attr(rout.nc_id, lon_varid, "standard_name", "longitude");
+    put_nc_attr(rout.nc_id, lon_varid, "units", "degrees_east");
+
+    status = nc_def_var(rout.nc_id, "streamflow", NC_DOUBLE, 2, dimids,
+                        &(rout.flow_varid));
+    check_nc_status(status, "Error defining streamflow variable in %s",
+                    rout.filename);
+    status = nc_put_att_double(rout.nc_id, rout.flow_varid, "_FillValue",
+                               NC_DOUBLE, 1, &fillval);
+    check_nc_status(status, "Error adding attribute in %s", rout.filename);
+    put_nc_attr(rout.nc_id, rout.flow_varid, "long_name", "streamflow");
+    put_nc_attr(rout.nc_id, rout.flow_varid, "units", "m3 s-1");
+    put_nc_attr(rout.nc_id, rout.flow_varid, "coordinates", "lat lon");
+    put_nc_attr(rout.nc_id, rout.flow_varid, "description",
+                "streamflow at the outlet of the gauge cell at the end of "
+                "the time step");
+
+    status = nc_enddef(rout.nc_id);
+    check_nc_status(status, "Error leaving define mode for %s",
+                    rout.filename);
+
+    start = 0;
+    count = rout.ngauges;
+    status = nc_put_vara_int(rout.nc_id, gauge_varid, &start, &count,
+                             gauge_ids);
+    check_nc_status(status, "Error writing gauge ids to %s", rout.filename);
+    status = nc_put_vara_double(rout.nc_id, lat_varid, &start, &count,
+                                gauge_lats);
+    check_nc_status(status, "Error writing lat to %s", rout.filename);
+    status = nc_put_vara_double(rout.nc_id, lon_varid, &start, &count,
+                                gauge_lons);
+    check_nc_status(status, "Error writing lon to %s", rout.filename);
+}
+
+/******************************************************************************
+ * @brief    Initialize the inline routing of the image driver.
+ * @details  The river network of the routing parameter file (ROUT_PARAM) is
+ *           built on the master node and every process receives the
+ *           downstream cell, the level and the unit hydrograph of its own
+ *           cells, i.e. the network is partitioned along the domain
+ *           decomposition. Each process lists the flows it sends to and
+ *           receives from other processes at each level, so that the
+ *           exchange in rout_run() is point to point between the processes
+ *           that share a river.
+ *****************************************************************************/
+void
+rout_init(void)
+{
+    extern domain_struct    global_domain;
+    extern domain_struct    local_domain;
+    extern filenames_struct filenames;
+    extern option_struct    options;
+    extern MPI_Comm         MPI_COMM_VIC;
+    extern int             *mpi_map_global_array_offsets;
+    extern int             *mpi_map_local_array_sizes;
+    extern int              mpi_rank;
+    extern int              mpi_size;
+    extern rout_struct      rout;
+
+    size_t                  sizes[3];
+    size_t                  d3count[3];
+    size_t                  d3start[3];
+    size_t                  ncells;
+    size_t                  nsends;
+    size_t                  i;
+    size_t                  j;
+    size_t                  k;
+    int                    *all_info = NULL;
+    int                    *info;
+    int                    *recv_rows = NULL;
+    int                    *recv_counts = NULL;
+    int                    *recv_displs = NULL;
+    int                    *info_counts = NULL;
+    int                    *info_displs = NULL;
+    int                    *local_rows;
+    int                    *send_rows;
+    int                    *gauge_ids = NULL;
+    int                     nlocal_rows;
+    int                     r;
+    int                     status;
+    double                 *gauge_lats = NULL;
+    double                 *gauge_lons = NULL;
+    double                 *uh;
+
+    memset(&rout, 0, sizeof(rout));
+    if (strcasecmp(filenames.rout_params, "MISSING") == 0) {
+        return;
+    }
+    rout.active = true;
+    ncells = local_domain.ncells_active;
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        rout.nuh = get_nc_dimension(filenames.rout_params, "uh_step");
+        all_info = malloc(N_ROUT_INFO * global_domain.ncells_active *
+                          sizeof(*all_info));
+        check_alloc_status(all_info, "Memory allocation error.");
+        recv_counts = malloc(mpi_size * sizeof(*recv_counts));
+        check_alloc_status(recv_counts, "Memory allocation error.");
+        recv_displs = malloc(mpi_size * sizeof(*recv_displs));
+        check_alloc_status(recv_displs, "Memory allocation error.");
+        info_counts = malloc(mpi_size * sizeof(*info_counts));
+        check_alloc_status(info_counts, "Memory allocation error.");
+        info_displs = malloc(mpi_size * sizeof(*info_displs));
+        check_alloc_status(info_displs, "Memory allocation error.");
+
+        build_rout_network(all_info, &recv_rows, recv_counts, &gauge_ids,
+                           &gauge_lats, &gauge_lons);
+
+        for (r = 0; r < mpi_size; r++) {
+            info_counts[r] = N_ROUT_INFO * mpi_map_local_array_sizes[r];
+            info_displs[r] = N_ROUT_INFO * mpi_map_global_array_offsets[r];
+            recv_displs[r] = r == 0 ? 0 : recv_displs[r - 1] +
+                             recv_counts[r - 1];
+        }
+        sizes[0] = rout.nuh;
+        sizes[1] = rout.nlevels;
+        sizes[2] = rout.ngauges;
+    }
+
+    status = MPI_Bcast(sizes, 3, MPI_UNSIGNED_LONG, VIC_MPI_ROOT,
+                       MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    rout.nuh = sizes[0];
+    rout.nlevels = sizes[1];
+    rout.ngauges = sizes[2];
+    if (rout.nuh < 1) {
+        log_err("The unit hydrographs in %s have no time steps",
+                filenames.rout_params);
+    }
+
+    // network of the local cells
+    info = malloc((N_ROUT_INFO * ncells + 1) * sizeof(*info));
+    check_alloc_status(info, "Memory allocation error.");
+    status = MPI_Scatterv(all_info, info_counts, info_displs, MPI_INT, info,
+                          N_ROUT_INFO * ncells, MPI_INT, VIC_MPI_ROOT,
+                          MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    // flows received from other processes
+    status = MPI_Scatter(recv_counts, 1, MPI_INT, &nlocal_rows, 1, MPI_INT,
+                         VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+    local_rows = malloc((nlocal_rows + 1) * sizeof(*local_rows));
+    check_alloc_status(local_rows, "Memory allocation error.");
+    status = MPI_Scatterv(recv_rows, recv_counts, recv_displs, MPI_INT,
+                          local_rows, nlocal_rows, MPI_INT, VIC_MPI_ROOT,
+                          MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    // local cells sorted by level
+    rout.level_start = calloc(rout.nlevels + 1, sizeof(*(rout.level_start)));
+    check_alloc_status(rout.level_start, "Memory allocation error.");
+    rout.cells = malloc((ncells + 1) * sizeof(*(rout.cells)));
+    check_alloc_status(rout.cells, "Memory allocation error.");
+    rout.down_rank = malloc((ncells + 1) * sizeof(*(rout.down_rank)));
+    check_alloc_status(rout.down_rank, "Memory allocation error.");
+    rout.down_idx = malloc((ncells + 1) * sizeof(*(rout.down_idx)));
+    check_alloc_status(rout.down_idx, "Memory allocation error.");
+    rout.down_slot = malloc((ncells + 1) * sizeof(*(rout.down_slot)));
+    check_alloc_status(rout.down_slot, "Memory allocation error.");
+    rout.gauge = malloc((ncells + 1) * sizeof(*(rout.gauge)));
+    check_alloc_status(rout.gauge, "Memory allocation error.");
+    for (i = 0; i < ncells; i++) {
+        rout.down_rank[i] = info[i * N_ROUT_INFO + ROUT_INFO_DOWN_RANK];
+        rout.down_idx[i] = (size_t) info[i * N_ROUT_INFO + ROUT_INFO_DOWN_IDX];
+        rout.down_slot[i] =
+            (size_t) info[i * N_ROUT_INFO + ROUT_INFO_DOWN_SLOT];
+        rout.gauge[i] = info[i * N_ROUT_INFO + ROUT_INFO_GAUGE];
+        rout.level_start[info[i * N_ROUT_INFO + ROUT_INFO_LEVEL] + 1]++;
+    }
+    for (j = 0; j < rout.nlevels; j++) {
+        rout.level_start[j + 1] += rout.level_start[j];
+    }
+    for (i = 0; i < ncells; i++) {
+        k = (size_t) info[i * N_ROUT_INFO + ROUT_INFO_LEVEL];
+        rout.cells[rout.level_start[k]++] = i;
+    }
+    for (j = rout.nlevels; j > 0; j--) {
+        rout.level_start[j] = rout.level_start[j - 1];
+    }
+    rout.level_start[0] = 0;
+
+    // flows sent to other processes, as rows of level, receiving process
+    // and local cell
+    send_rows = malloc((3 * ncells + 1) * sizeof(*send_rows));
+    check_alloc_status(send_rows, "Memory allocation error.");
+    nsends = 0;
+    for (i = 0; i < ncells; i++) {
+        if (rout.down_rank[i] != ROUT_OUTLET &&
+            rout.down_rank[i] != mpi_rank) {
+            send_rows[3 * nsends] = info[i * N_ROUT_INFO + ROUT_INFO_LEVEL];
+            send_rows[3 * nsends + 1] = rout.down_rank[i];
+            send_rows[3 * nsends + 2] = (int) i;
+            nsends++;
+        }
+    }
+    qsort(send_rows, nsends, 3 * sizeof(*send_rows), compare_rout_rows);
+    rout.nsends = 0;
+    for (i = 0; i < nsends; i++) {
+        if (i == 0 || send_rows[3 * i] != send_rows[3 * (i - 1)] ||
+            send_rows[3 * i + 1] != send_rows[3 * (i - 1) + 1]) {
+            rout.nsends++;
+        }
+    }
+    rout.sends = calloc(rout.nsends + 1, sizeof(*(rout.sends)));
+    check_alloc_status(rout.sends, "Memory allocation error.");
+    for (i = 0, k = 0; i < nsends; i++) {
+        if (i > 0 && (send_rows[3 * i] != send_rows[3 * (i - 1)] ||
+                      send_rows[3 * i + 1] != send_rows[3 * (i - 1) + 1])) {
+            k++;
+        }
+        rout.sends[k].level = (size_t) send_rows[3 * i];
+        rout.sends[k].peer = send_rows[3 * i + 1];
+        rout.sends[k].count++;
+    }
+    for (k = 0, j = 0; k < rout.nsends; k++) {
+        rout.sends[k].cells = malloc(rout.sends[k].count *
+                                     sizeof(*(rout.sends[k].cells)));
+        check_alloc_status(rout.sends[k].cells, "Memory allocation error.");
+        rout.sends[k].buf = malloc(2 * rout.sends[k].count *
+                                   sizeof(*(rout.sends[k].buf)));
+        check_alloc_status(rout.sends[k].buf, "Memory allocation error.");
+        for (i = 0; i < rout.sends[k].count; i++, j++) {
+            rout.sends[k].cells[i] = (size_t) send_rows[3 * j + 2];
+        }
+    }
+
+    rout.nrecvs = (size_t) nlocal_rows / 3;
+    rout.recvs = calloc(rout.nrecvs + 1, sizeof(*(rout.recvs)));
+    check_alloc_status(rout.recvs, "Memory allocation error.");
+    for (k = 0; k < rout.nrecvs; k++) {
+        rout.recvs[k].level = (size_t) local_rows[3 * k];
+        rout.recvs[k].peer = local_rows[3 * k + 1];
+        rout.recvs[k].count = (size_t) local_rows[3 * k + 2];
+        rout.recvs[k].buf = malloc(2 * rout.recvs[k].count *
+                                   sizeof(*(rout.recvs[k].buf)));
+        check_alloc_status(rout.recvs[k].buf, "Memory allocation error.");
+    }
+    rout.requests = malloc((rout.nsends + rout.nrecvs + 1) *
+                           sizeof(*(rout.requests)));
+    check_alloc_status(rout.requests, "Memory allocation error.");
+
+    // unit hydrographs of the local cells
+    uh = malloc((rout.nuh * ncells + 1) * sizeof(*uh));
+    check_alloc_status(uh, "Memory allocation error.");
+    d3start[0] = 0;
+    d3start[1] = 0;
+    d3start[2] = 0;
+    d3count[0] = rout.nuh;
+    d3count[1] = global_domain.n_ny;
+    d3count[2] = global_domain.n_nx;
+    get_scatter_nc_block_double(filenames.rout_params, "uh", rout.nuh,
+                                d3start, d3count, uh);
+    rout.uh = malloc((rout.nuh * ncells + 1) * sizeof(*(rout.uh)));
+    check_alloc_status(rout.uh, "Memory allocation error.");
+    for (i = 0; i < ncells; i++) {
+        for (k = 0; k < rout.nuh; k++) {
+            if (!(uh[k * ncells + i] >= 0.)) {
+                log_err("The unit hydrograph of grid cell %zu in %s is "
+                        "negative or missing at step %zu",
+                        local_domain.locations[i].global_idx,
+                        filenames.rout_params, k);
+            }
+            rout.uh[i * rout.nuh + k] = uh[k * ncells + i];
+        }
+    }
+
+    rout.ring = calloc(rout.nuh * ncells + 1, sizeof(*(rout.ring)));
+    check_alloc_status(rout.ring, "Memory allocation error.");
+    rout.runin = calloc(ncells + 1, sizeof(*(rout.runin)));
+    check_alloc_status(rout.runin, "Memory allocation error.");
+    rout.inflow = calloc(ncells + 1, sizeof(*(rout.inflow)));
+    check_alloc_status(rout.inflow, "Memory allocation error.");
+    if (options.REPRODUCIBLE) {
+        rout.up_flow = calloc(ROUT_NSLOTS * ncells + 1,
+                              sizeof(*(rout.up_flow)));
+        check_alloc_status(rout.up_flow, "Memory allocation error.");
+    }
+    rout.outflow = calloc(ncells + 1, sizeof(*(rout.outflow)));
+    check_alloc_status(rout.outflow, "Memory allocation error.");
+    rout.gauge_flow = calloc(rout.ngauges, sizeof(*(rout.gauge_flow)));
+    check_alloc_status(rout.gauge_flow, "Memory allocation error.");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        rout.streamflow = calloc(rout.ngauges, sizeof(*(rout.streamflow)));
+        check_alloc_status(rout.streamflow, "Memory allocation error.");
+        initialize_rout_file(gauge_ids, gauge_lats, gauge_lons);
+        close_nc_file(filenames.rout_params);
+        log_info("Routing %zu levels of the river network to %zu gauges, "
+                 "writing streamflow to %s", rout.nlevels, rout.ngauges,
+                 rout.filename);
+    }
+
+    free(uh);
+    free(send_rows);
+    free(local_rows);
+    free(info);
+    free(all_info);
+    free(recv_rows);
+    free(recv_counts);
+    free(recv_displs);
+    free(info_counts);
+    free(info_displs);
+    free(gauge_ids);
+    free(gauge_lats);
+    free(gauge_lons);
+}
@@ -0,0 +1,243 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Route the runoff of one time step through the river network.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <rout.h>
+
+/******************************************************************************
+ * @brief    Route the cells of one level.
+ * @details  The water entering a cell in this time step is its runoff and
+ *           the inflow from its upstream cells, which have a lower level and
+ *           are complete. The outflow is the convolution of the water that
+ *           entered the cell in the last nuh time steps with its unit
+ *           hydrograph.
+ *****************************************************************************/
+static void
+rout_level(size_t  level,
+           double *runin)
+{
+    extern option_struct options;
+    extern int           mpi_rank;
+    extern rout_struct   rout;
+
+    size_t               first;
+    size_t               last;
+    size_t               nuh;
+    size_t               pos;
+    size_t               i;
+    size_t               j;
+    size_t               k;
+    double              *uh;
+    double              *ring;
+    double               flow;
+
+    first = rout.level_start[level];
+    last = rout.level_start[level + 1];
+    nuh = rout.nuh;
+    pos = rout.ring_pos;
+
+    #pragma omp parallel for num_threads(options.NTHREADS) \
+    if (last - first > 1024) private(i, k, uh, ring, flow)
+    for (j = first; j < last; j++) {
+        i = rout.cells[j];
+        uh = &(rout.uh[i * nuh]);
+        ring = &(rout.ring[i * nuh]);
+        if (options.REPRODUCIBLE) {
+            rout.inflow[i] = 0.;
+            for (k = 0; k < ROUT_NSLOTS; k++) {
+                rout.inflow[i] += rout.up_flow[i * ROUT_NSLOTS + k];
+            }
+        }
+        ring[pos] = runin[i] + rout.inflow[i];
+
+        // ring[pos - k] entered the cell k time steps ago
+        flow = 0.;
+        for (k = 0; k <= pos; k++) {
+            flow += uh[k] * ring[pos - k];
+        }
+        for (k = pos + 1; k < nuh; k++) {
+            flow += uh[k] * ring[nuh + pos - k];
+        }
+        rout.outflow[i] = flow;
+    }
+
+    // the downstream cells are summed in a fixed order, so that the result
+    // does not depend on the number of threads
+    for (j = first; j < last; j++) {
+        i = rout.cells[j];
+        if (rout.down_rank[i] != mpi_rank) {
+            continue;
+        }
+        if (options.REPRODUCIBLE) {
+            rout.up_flow[rout.down_idx[i] * ROUT_NSLOTS +
+                         rout.down_slot[i]] = rout.outflow[i];
+        }
+        else {
+            rout.inflow[rout.down_idx[i]] += rout.outflow[i];
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Route the runoff of the current time step and write the
+ *           streamflow at the gauges.
+ * @details  Called after vic_image_run(). The runoff and baseflow of the
+ *           cells are routed level by level, starting at the headwaters.
+ *           After each level, the outflows to cells on other processes are
+ *           sent to those processes only, and receiving processes wait for
+ *           them before they route the next level. The streamflow at the
+ *           gauges is summed on the master node and written as one record of
+ *           the streamflow file.
+ *****************************************************************************/
+void
+rout_run(dmy_struct *dmy_current)
+{
+    extern global_param_struct global_param;
+    extern domain_struct       local_domain;
+    extern option_struct       options;
+    extern double           ***out_data;
+    extern MPI_Comm            MPI_COMM_VIC;
+    extern int                 mpi_rank;
+    extern timer_struct        global_timers[N_TIMERS];
+    extern rout_struct         rout;
+
+    size_t                     level;
+    size_t                     first_recv;
+    size_t                     s;
+    size_t                     r;
+    size_t                     i;
+    size_t                     n;
+    size_t                     start[2];
+    size_t                     count[2];
+    int                        nrequests;
+    int                        status;
+    double                    *buf;
+    double                     time_value;
+
+    if (!rout.active) {
+        return;
+    }
+
+    timer_continue(&(global_timers[TIMER_VIC_ROUTING]));
+
+    // runoff and baseflow of the local cells (m3/s)
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        rout.runin[i] = (out_data[i][OUT_RUNOFF][0] +
+                         out_data[i][OUT_BASEFLOW][0]) *
+                        local_domain.locations[i].area *
+                        local_domain.locations[i].frac /
+                        MM_PER_M / global_param.dt;
+        rout.inflow[i] = 0.;
+    }
+
+    s = 0;
+    r = 0;
+    for (level = 0; level < rout.nlevels; level++) {
+        nrequests = 0;
+        first_recv = r;
+        for (; r < rout.nrecvs && rout.recvs[r].level == level; r++) {
+            status = MPI_Irecv(rout.recvs[r].buf, 2 * rout.recvs[r].count,
+                               MPI_DOUBLE, rout.recvs[r].peer, ROUT_TAG_FLOW,
+                               MPI_COMM_VIC, &(rout.requests[nrequests++]));
+            check_mpi_status(status, "MPI error.");
+        }
+
+        rout_level(level, rout.runin);
+
+        for (; s < rout.nsends && rout.sends[s].level == level; s++) {
+            buf = rout.sends[s].buf;
+            for (n = 0; n < rout.sends[s].count; n++) {
+                i = rout.sends[s].cells[n];
+                if (options.REPRODUCIBLE) {
+                    buf[2 * n] = (double) (rout.down_idx[i] * ROUT_NSLOTS +
+                                           rout.down_slot[i]);
+                }
+                else {
+                    buf[2 * n] = (double) rout.down_idx[i];
+                }
+                buf[2 * n + 1] = rout.outflow[i];
+            }
+            status = MPI_Isend(buf, 2 * rout.sends[s].count, MPI_DOUBLE,
+                               rout.sends[s].peer, ROUT_TAG_FLOW, MPI_COMM_VIC,
+                               &(rout.requests[nrequests++]));
+            check_mpi_status(status, "MPI error.");
+        }
+
+        if (nrequests > 0) {
+            status = MPI_Waitall(nrequests, rout.requests,
+                                 MPI_STATUSES_IGNORE);
+            check_mpi_status(status, "MPI error.");
+        }
+
+        for (; first_recv < r; first_recv++) {
+            buf = rout.recvs[first_recv].buf;
+            for (n = 0; n < rout.recvs[first_recv].count; n++) {
+                if (options.REPRODUCIBLE) {
+                    rout.up_flow[(size_t) buf[2 * n]] = buf[2 * n + 1];
+                }
+                else {
+                    rout.inflow[(size_t) buf[2 * n]] += buf[2 * n + 1];
+                }
+            }
+        }
+    }
+    rout.ring_pos = (rout.ring_pos + 1) % rout.nuh;
+
+    // streamflow at the gauges
+    for (n = 0; n < rout.ngauges; n++) {
+        rout.gauge_flow[n] = 0.;
+    }
+    for (i = 0; i < local_domain.ncells_active; i++) {
+        if (rout.gauge[i] != ROUT_NO_GAUGE) {
+            rout.gauge_flow[rout.gauge[i]] = rout.outflow[i];
+        }
+    }
+    status = MPI_Reduce(rout.gauge_flow, rout.streamflow, rout.ngauges,
+                        MPI_DOUBLE, MPI_SUM, VIC_MPI_ROOT, MPI_COMM_VIC);
+    check_mpi_status(status, "MPI error.");
+
+    if (mpi_rank == VIC_MPI_ROOT) {
+        time_value = date2num(global_param.time_origin_num, dmy_current, 0.,
+                              global_param.calendar, global_param.time_units);
+        start[0] = rout.nrecs;
+        start[1] = 0;
+        count[0] = 1;
+        count[1] = rout.ngauges;
+
+        // the history files may be written on another thread
+        lock_netcdf();
+        status = nc_put_var1_double(rout.nc_id, rout.time_varid, start,
+                                    &time_value);
+        check_nc_status(status, "Error writing time to %s", rout.filename);
+        status = nc_put_vara_double(rout.nc_id, rout.flow_varid, start, count,
+                                    rout.streamflow);
+        check_nc_status(status, "Error writing streamflow to %s",
+                        rout.filename);
+        unlock_netcdf();
+    }
+    rout.nrecs++;
+
+    timer_stop(&(global_timers[TIMER_VIC_ROUTING]));
+}
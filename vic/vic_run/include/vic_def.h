@@ -58,14 +58,36 @@
 #define NODATA_VEG   -1        /**< flag for veg types not in grid cell */
 #define ERROR        -999      /**< Error Flag returned by subroutines */
 
+/***** Floating point type of the mixed precision kernels *****/
+// With make MIXED_PRECISION=1, the water balance kernels (runoff and
+// arno_evap) compute in single precision. The model state and the water
+// balance check in put_data stay in double precision.
+#ifdef VIC_MIXED_PRECISION
+typedef float vic_real;
+#else
+typedef double vic_real;
+#endif
+
 /***** Define maximum array sizes for model source code *****/
+// MAX_LAYERS, MAX_NODES, MAX_BANDS and MAX_LAKE_NODES may be set when
+// compiling (e.g. make MAX_NODES=10). The structures of every tile embed
+// arrays of these sizes, so values close to the sizes used by the model
+// configuration reduce memory use.
 #define MAX_VEG         12     /**< maximum number of vegetation types per cell */
+#ifndef MAX_LAYERS
 #define MAX_LAYERS      3      /**< maximum number of soil moisture layers */
+#endif
+#ifndef MAX_NODES
 #define MAX_NODES       50     /**< maximum number of soil thermal nodes */
+#endif
+#ifndef MAX_BANDS
 #define MAX_BANDS       10     /**< maximum number of snow bands */
+#endif
 #define MAX_FRONTS      3      /**< maximum number of freezing and thawing front depths to store */
 #define MAX_FROST_AREAS 10     /**< maximum number of frost sub-areas */
+#ifndef MAX_LAKE_NODES
 #define MAX_LAKE_NODES  20     /**< maximum number of lake thermal nodes */
+#endif
 #define MAX_ZWTVMOIST   11     /**< maximum number of points in water table vs moisture curve for each soil layer; should include points at lower and upper boundaries of the layer */
 
 /***** Define minimum values for model parameters *****/
@@ -77,6 +99,26 @@
 #define MIN_SUBDAILY_STEPS_PER_DAY  4
 #define MAX_SUBDAILY_STEPS_PER_DAY  1440
 
+/***** Define iteration limits of the secant root finder *****/
+#define MAX_NEWTON_ITER 10     /**< maximum number of secant steps before falling back to Brent */
+#define NEWTON_DT_FRACT 0.01   /**< first secant step as a fraction of the bracket width */
+
+/***** Define the size of the scratch memory of vic_run *****/
+#define SCRATCH_BLOCK_SIZE 65536  /**< bytes of the first block of the scratch arena */
+#define SCRATCH_ALIGN 16       /**< alignment of the scratch allocations */
+
+/***** Define the quadrature of the blowing snow suspension layer *****/
+#define BLOWING_FAST_PANELS 4      /**< Gauss-Legendre panels in ln(z) */
+#define BLOWING_FAST_MIN_EXP 1e-3  /**< smallest |m| of the closed form transport integral */
+
+/***** Define the ice content step of the implicit soil thermal Jacobian *****/
+#define FDA_JAC_DICE 1e-6      /**< step of soil_conductivity in unfrozen water (fraction) */
+
+/***** Define the range and resolution of the saturated vapor pressure tables *****/
+#define SVP_TABLE_TMIN -100    /**< lowest tabulated temperature (C) */
+#define SVP_TABLE_TMAX 100     /**< highest tabulated temperature (C) */
+#define SVP_TABLE_RES 64       /**< table entries per degree C */
+
 #ifndef WET
 #define WET 0
 #define DRY 1
@@ -94,7 +136,6 @@ extern size_t NR;       /**< array index for force struct that indicates
                              the model step avarage or sum */
 extern size_t NF;       /**< array index loop counter limit for force
                              struct that indicates the SNOW_STEP values */
-char          vic_run_ref_str[MAXSTRING];
 
 /******************************************************************************
  * @brief   Snow Density parametrizations
@@ -161,6 +202,45 @@ enum
     PHOTO_C4
 };
 
+/******************************************************************************
+ * @brief   Domain decomposition options
+ *****************************************************************************/
+enum
+{
+    DECOMP_ROUND_ROBIN,
+    DECOMP_COST_WEIGHTED,
+    DECOMP_HILBERT
+};
+
+/******************************************************************************
+ * @brief   History file layout options
+ *****************************************************************************/
+enum
+{
+    OUT_LAYOUT_GRID,
+    OUT_LAYOUT_LAND
+};
+
+/******************************************************************************
+ * @brief   Precision in which the forcings are read and scattered
+ *****************************************************************************/
+enum
+{
+    FORCE_PRECISION_DOUBLE,
+    FORCE_PRECISION_SINGLE
+};
+
+/******************************************************************************
+ * @brief   Water and energy balance check policies
+ *****************************************************************************/
+enum
+{
+    BALANCE_CHECK_ALL,
+    BALANCE_CHECK_STEPS,
+    BALANCE_CHECK_CELLS,
+    BALANCE_CHECK_OUTPUT
+};
+
 /***** Data Structures *****/
 
 /******************************************************************************
@@ -200,6 +280,10 @@ typedef struct {
     bool BLOWING_SIMPLE;
     bool BLOWING_FETCH;
     bool BLOWING_SPATIAL_WIND;
+    bool BLOWING_FAST;   /**< TRUE = integrate the suspension layer with a
+                            closed form (transport) and Gauss-Legendre
+                            quadrature (sublimation) instead of Romberg
+                            integration */
     bool CARBON;         /**< TRUE = simulate carbon cycling processes;
                             FALSE = no carbon cycling (default) */
     bool CLOSE_ENERGY;   /**< TRUE = all energy balance calculations are
@@ -224,6 +308,11 @@ typedef struct {
                                           "GF_410"  = use formulas from VIC 4.1.0 */
     bool IMPLICIT;       /**< TRUE = Use implicit solution when computing
                             soil thermal fluxes */
+    bool ANALYTIC_JACOBIAN; /**< TRUE = build the Newton-Raphson Jacobian of
+                                the implicit solution from the derivatives of
+                                the heat equation
+                               FALSE = use finite differences
+                               Default = FALSE */
     bool JULY_TAVG_SUPPLIED; /**< If TRUE and COMPUTE_TREELINE is also true,
                                 then average July air temperature will be read
                                 from soil file and used in calculating treeline */
@@ -248,6 +337,12 @@ typedef struct {
     bool QUICK_SOLVE;    /**< TRUE = Use Liang et al., 1999 formulation for
                             iteration, but explicit finite difference
                             method for final step. */
+    bool QUIESCENT_SOIL; /**< TRUE = in the explicit soil thermal solution,
+                                   solve the frozen nodes of columns without
+                                   a node near 0 C with a linearized ice
+                                   content instead of root_brent
+                            FALSE = always use root_brent
+                            Default = FALSE */
     bool SHARE_LAYER_MOIST; /**< TRUE = transpiration in moisture-limited layers can draw from other layers (default) */
     unsigned short int SNOW_DENSITY;   /**< DENS_BRAS: Use algorithm of Bras, 1990; DENS_SNTHRM: Use algorithm of SNTHRM89 adapted for 1-layer pack */
     size_t SNOW_BAND;    /**< Number of elevation bands over which to solve the
@@ -259,6 +354,13 @@ typedef struct {
                              partial coverage of the surface by a thin snowpack.
                              Coverage is assumed to be uniform after snowfall
                              until the pack begins to melt. */
+    bool ADAPTIVE_SUBSTEPS; /**< TRUE = choose the number of runoff sub-steps
+                               of each cell and time step from the soil
+                               moisture fluxes, and run the snow model of a
+                               cold, dry snow pack in one step */
+    bool BAND_MERGE;     /**< TRUE = solve the snow-free elevation bands of
+                            a veg tile with similar forcings and states as
+                            one band */
     bool TFALLBACK;      /**< TRUE = when any temperature iterations fail to converge,
                                    use temperature from previous time step; the number
                                    of instances when this occurs will be logged and
@@ -266,10 +368,30 @@ typedef struct {
                             FALSE = when iterations fail to converge, report an error
                                     and abort simulation for current grid cell
                             Default = TRUE */
+    bool TSURF_NEWTON;   /**< TRUE = solve the surface and snow pack energy
+                                   balances with a secant iteration started from
+                                   the previous temperature; Brent is used when the
+                                   iteration leaves the bracket
+                            FALSE = always use Brent
+                            Default = FALSE */
+    bool ROOT_RETRY;     /**< TRUE = when the surface or snow pack energy
+                                 balance fails to bracket its root, search
+                                 again within ROOT_BRENT_RETRY_DT of the last
+                                 temperature solved for the tile before
+                                 falling back or stopping
+                            FALSE = fall back or stop after the first search
+                            Default = FALSE */
+    bool FAST_SVP;       /**< TRUE = interpolate the saturated vapor pressure
+                                   and its slope in tables built from
+                                   SVP_A, SVP_B and SVP_C
+                            FALSE = evaluate the exact expressions
+                            Default = FALSE */
 
     // input options
     bool BASEFLOW;       /**< ARNO: read Ds, Dm, Ws, c; NIJSSEN2001: read d1, d2, d3, d4 */
     unsigned short int GRID_DECIMAL; /**< Number of decimal places in grid file extensions */
+    size_t FORCE_WINDOW; /**< Number of days of forcings the classic driver
+                            keeps in memory; 0 = the whole simulation */
     bool VEGLIB_FCAN;    /**< TRUE = veg library file contains monthly fcanopy values */
     bool VEGLIB_PHOTO;   /**< TRUE = veg library contains photosynthesis parameters */
     bool VEGPARAM_ALB;   /**< TRUE = veg param file contains monthly albedo values */
@@ -288,9 +410,102 @@ typedef struct {
     unsigned short int STATE_FORMAT;  /**< TRUE = model state file is binary (default) */
     bool INIT_STATE;     /**< TRUE = initialize model state from file */
     bool SAVE_STATE;     /**< TRUE = save state file */
+    bool STATE_INCREMENTAL; /**< TRUE = save only the state that changed
+                               since the initial state (BINARY_FAST) */
+    bool STATE_ASYNC;    /**< TRUE = write the state file in the background
+                            (BINARY_FAST) */
+    bool STATE_STREAMS;  /**< TRUE = save and restore the aggregation of the
+                            output streams with the state file */
 
     // output options
     size_t Noutstreams;  /**< Number of output stream */
+    bool OUT_CONTAINER;  /**< TRUE = write the output of all grid cells of a
+                            stream into one cell container file */
+    bool OUT_CASCADE;    /**< TRUE = aggregate coarse streams from the records
+                            of finer streams */
+    bool COMPUTE_ZWT;    /**< TRUE = update the water table position every
+                            time step; set from the output streams and
+                            CARBON */
+
+    // parallelization options
+    size_t NTHREADS;     /**< Number of shared-memory threads used to run
+                            the grid cells assigned to each process */
+    unsigned short int DECOMPOSITION; /**< DECOMP_ROUND_ROBIN = deal cells out
+                                         to processes in turn;
+                                         DECOMP_COST_WEIGHTED = contiguous
+                                         blocks of cells with balanced cost;
+                                         DECOMP_HILBERT = the same along a
+                                         Hilbert curve of the grid */
+    size_t NWORKERS;     /**< Number of processes used by the classic driver
+                            to run grid cells concurrently */
+    bool FORCE_PREFETCH; /**< TRUE = read the forcings of the next time step
+                            while the current time step is run */
+    unsigned short int FORCE_PRECISION; /**< FORCE_PRECISION_SINGLE = read
+                                           and scatter the forcings in
+                                           single precision, or packed */
+    bool FORCE_DISAGG;   /**< TRUE = generate the sub-steps of the
+                            meteorological forcings from daily forcings */
+    bool FORCE_CATALOG;  /**< TRUE = FORCING1 is a glob pattern or a list of
+                            forcing files of any period */
+    size_t FORCE_READERS; /**< Number of processes that read and scatter the
+                             forcing fields of a time step */
+    bool PARALLEL_IO;    /**< TRUE = every process reads and writes its own
+                            cells of the forcing and history files */
+    bool ASYNC_OUTPUT;   /**< TRUE = the history files are written on a
+                            writer thread while the model advances */
+    size_t IO_SERVERS;   /**< Number of processes that only write the
+                            history files */
+    bool NODE_SHARED_TABLES; /**< TRUE = one copy of the read-only tables
+                                per compute node in shared memory */
+    bool HIERARCHICAL_IO; /**< TRUE = gather and scatter through one leader
+                             process per compute node */
+    bool DISTRIBUTED_DOMAIN; /**< TRUE = every process reads the domain of
+                                its own block of rows */
+    bool NUMA_FIRST_TOUCH; /**< TRUE = the state of a cell is first touched
+                              and run by the same thread */
+    unsigned short int OUT_LAYOUT; /**< OUT_LAYOUT_GRID = history files on the
+                                      full grid; OUT_LAYOUT_LAND = active
+                                      cells only, along a land dimension */
+    size_t OUT_SPLIT;    /**< Number of processes per history file, 0 = one
+                            history file per stream */
+    size_t COMPRESS_THREADS; /**< Number of threads that compress the chunks
+                                of the history files on the master process,
+                                0 = compressed by the netCDF library */
+    bool SPINUP_FLOAT;   /**< TRUE = keep the spin-up forcings in single
+                            precision */
+    bool REPRODUCIBLE;   /**< TRUE = sums over cells that do not depend on
+                            the number of processes and threads */
+
+    // profiling options
+    bool PERF_REGIONS;   /**< TRUE = count cycles, instructions and cache
+                            misses of the physics stages of vic_run */
+    bool IO_BENCHMARK;   /**< TRUE = replace vic_run and put_data with
+                            synthetic output values to time the I/O only */
+    bool COMPUTE_BENCHMARK; /**< TRUE = synthetic forcings in memory and no
+                               output, to time vic_run and put_data only */
+    size_t HEARTBEAT_STEPS; /**< log the progress of the run every
+                               HEARTBEAT_STEPS time steps; 0 = never */
+    size_t HEARTBEAT_SECONDS; /**< log the progress of the run about every
+                                 HEARTBEAT_SECONDS seconds; 0 = never */
+    size_t LOG_BUFFER;   /**< size (kB) of the buffer of the log file of each
+                            process; 0 = block size of the file system */
+    size_t REBALANCE_STEPS; /**< evaluate the decomposition on the measured
+                               cell costs every REBALANCE_STEPS time steps;
+                               0 = never */
+    size_t DA_STEPS; /**< exchange the state with the data assimilation
+                        program every DA_STEPS time steps; 0 = never */
+    unsigned short int BALANCE_CHECK; /**< BALANCE_CHECK_ALL = check the
+                                         water and energy balances of every
+                                         cell at every time step;
+                                         BALANCE_CHECK_STEPS = every
+                                         BALANCE_CHECK_N time steps;
+                                         BALANCE_CHECK_CELLS = every
+                                         BALANCE_CHECK_N-th cell;
+                                         BALANCE_CHECK_OUTPUT = only if
+                                         OUT_WATER_ERROR or OUT_ENERGY_ERROR
+                                         is written */
+    size_t BALANCE_CHECK_N; /**< interval of the balance checks in time steps
+                               or cells */
 } option_struct;
 
 /******************************************************************************
@@ -336,6 +551,17 @@ typedef struct {
     unsigned short int time_units;  /**< Units for numeric times */
     double time_origin_num;        /**< Numeric date origin */
     char time_origin_str[MAXSTRING];  /**< string date origin */
+    size_t spinup_cycles;          /**< Number of spin-up cycles run before
+                                      the simulation */
+    size_t spinup_years;           /**< Number of years at the start of the
+                                      simulation that make up a spin-up
+                                      cycle */
+    double spinup_tol;             /**< Spin-up stops early when no water
+                                      storage changes more than this over a
+                                      cycle (mm) */
+    size_t spinup_block_steps;     /**< Number of time steps each grid cell
+                                      is advanced at a time in the spin-up
+                                      cycles after the first */
 } global_param_struct;
 
 /******************************************************************************
@@ -534,8 +760,43 @@ typedef struct {
     int ROOT_BRENT_MAXITER;
     double ROOT_BRENT_TSTEP;
     double ROOT_BRENT_T;
+    double ROOT_BRENT_RETRY_DT; /**< half width (C) of the bracket searched
+                                   again with ROOT_RETRY */
+
+    // Adaptive Sub-step Parameters
+    double ADAPT_RUNOFF_FRAC; /**< largest fraction of the moisture range of a
+                                 soil layer that may flow through it in one
+                                 runoff sub-step */
+    double ADAPT_SNOW_TAIR;   /**< air temperature (C) below which a cold, dry
+                                 snow pack is run in one step */
+
+    // Band Merging Parameters
+    double BAND_MERGE_TDIFF;  /**< largest difference (C) of the air
+                                 temperatures and soil temperatures of
+                                 merged snow bands */
+    double BAND_MERGE_FDIFF;  /**< largest difference of the precipitation
+                                 factors and of the soil moistures (fraction
+                                 of the maximum moisture) of merged snow
+                                 bands */
 } parameters_struct;
 
+/******************************************************************************
+ * @brief   This structure stores the terms of the thermal conductivity and the
+ * volumetric heat capacity of a soil layer that do not depend on its water
+ * and ice contents.
+ *****************************************************************************/
+typedef struct {
+    double Kdry;       /**< dry thermal conductivity (W/m/K) */
+    double Ks_pow;     /**< thermal conductivity of the solids (W/m/K) to
+                          the power of the solid fraction of the volume */
+    double Ksat_thaw;  /**< saturated thermal conductivity of unfrozen soil
+                          (W/m/K) */
+    double porosity;   /**< porosity (fraction) */
+    double soil_fract; /**< solid fraction of the volume */
+    double Cs_solid;   /**< volumetric heat capacity of the solids
+                          (J/m^3/K) */
+} soil_thermal_coef_struct;
+
 /******************************************************************************
  * @brief   This structure stores the soil parameters for a grid cell.
  *****************************************************************************/
@@ -592,6 +853,7 @@ typedef struct {
     double soil_density[MAX_LAYERS];  /**< soil particle density (kg/m^3) */
     double soil_dens_min[MAX_LAYERS]; /**< particle density of mineral soil (kg/m^3) */
     double soil_dens_org[MAX_LAYERS]; /**< particle density of organic soil (kg/m^3) */
+    soil_thermal_coef_struct thermal_coef[MAX_LAYERS]; /**< moisture-independent thermal properties of each layer, see set_soil_thermal_coef */
     double *BandElev;                 /**< Elevation of each snow elevation band */
     double *AreaFract;                /**< Fraction of grid cell included in each snow elevation band */
     double *Pfactor;                  /**< Change in Precipitation due to elevation (fract) in each snow elevation band */
@@ -712,6 +974,36 @@ typedef struct {
     double *roughness;    /**< vegetation roughness length (m) */
 } veg_hist_struct;
 
+/******************************************************************************
+ * @brief   This structure stores the terms of the photosynthesis that only
+ * depend on the foliage temperature and the irradiance, and are therefore
+ * shared by all canopy layers of a tile.
+ *****************************************************************************/
+typedef struct {
+    double Tfoliage;  /**< foliage temperature (C) */
+    double T;         /**< foliage temperature (K) */
+    double Vcmax_T;   /**< temperature factor of the carboxylation capacity */
+    double Rdark_T;   /**< temperature factor of the dark respiration */
+    double K_T;       /**< temperature factor of the PEPcase CO2 specificity
+                         (C4) */
+    double KC;        /**< Michaelis-Menten constant for CO2 (C3) */
+    double KO;        /**< Michaelis-Menten constant for O2 (C3) */
+    double gamma;     /**< CO2 compensation point (C3) (mol/mol) */
+    double hiTinhib;  /**< high temperature inhibition */
+    double darkinhib; /**< inhibition of the dark respiration in light */
+} photo_kinetics_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the time-invariant solar geometry of a grid
+ * cell, used to compute the cosine of the solar zenith angle.
+ *****************************************************************************/
+typedef struct {
+    double coslat;      /**< cosine of latitude */
+    double sinlat;      /**< sine of latitude */
+    double hour_offset; /**< offset of local solar time from the time zone
+                           (hours) */
+} solar_geom_struct;
+
 /******************************************************************************
  * @brief   This structure stores the forcing data for each model
  * time step for a single grid cell.  Each array stores the values for the
@@ -755,6 +1047,103 @@ typedef struct {
     unsigned int dayseconds;        /**< seconds since midnight */
 } dmy_struct;                       /**< array of length nrec created */
 
+/******************************************************************************
+ * @brief   This structure identifies the grid cell and time step that
+ *          vic_run is working on. It is only formatted into a message when
+ *          vic_run reports an error.
+ *****************************************************************************/
+typedef struct {
+    const char *id_name; /**< name of the grid cell identifier */
+    size_t id;           /**< grid cell identifier */
+    dmy_struct *dmy;     /**< current time step */
+} vic_run_ref_struct;
+
+extern vic_run_ref_struct vic_run_ref; /**< reference for debugging inside
+                                            vic_run */
+#pragma omp threadprivate(vic_run_ref)
+
+/******************************************************************************
+ * @brief   Scratch memory of the temporaries of vic_run, see scratch_calloc().
+ *          The blocks are kept for the life of the thread, and their memory
+ *          is handed out in order and taken back all at once.
+ *****************************************************************************/
+typedef struct {
+    char *data;                 /**< memory of the block */
+    size_t size;                /**< bytes of the block */
+} scratch_block_struct;
+
+typedef struct {
+    scratch_block_struct *blocks; /**< blocks of the arena */
+    size_t nblocks;             /**< number of allocated blocks */
+    size_t block;               /**< block that is in use */
+    size_t offset;              /**< bytes in use of that block */
+} scratch_arena_struct;
+
+typedef struct {
+    size_t block;               /**< block in use at the mark */
+    size_t offset;              /**< bytes in use of that block */
+} scratch_mark_struct;
+
+extern scratch_arena_struct vic_scratch; /**< scratch memory of the thread */
+#pragma omp threadprivate(vic_scratch)
+
+/******************************************************************************
+ * @brief   Counters of the iterative solvers in vic_run, see solver_stats.
+ *****************************************************************************/
+enum solver_stats
+{
+    SOLVER_BRENT_ITER,         /**< iterations of root_brent */
+    SOLVER_BRENT_BRACKET_FAIL, /**< root_brent calls that did not bracket the
+                                    root */
+    SOLVER_NEWT_RAPH_ITER,     /**< iterations of newt_raph */
+    SOLVER_RUNOFF_STEPS,       /**< sub-steps of runoff */
+    SOLVER_SNOW_MELT,          /**< snow pack energy balance solutions */
+    SOLVER_LAKE_MIX_ITER,      /**< convective mixing passes of the lake */
+    SOLVER_SNOW_STEPS,         /**< sub-steps of the surface energy balance */
+    SOLVER_BRENT_RETRY,        /**< roots bracketed by the ROOT_RETRY search */
+    SOLVER_BAND_SOLVES,        /**< surface flux solutions of the snow bands */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_SOLVER_STATS             /**< used as a loop counter*/
+};
+
+extern size_t solver_stats[N_SOLVER_STATS]; /**< solver counters of the
+                                                 current vic_run call */
+#pragma omp threadprivate(solver_stats)
+
+/******************************************************************************
+ * @brief   Physics stages of vic_run measured by the hardware performance
+ *          counters, see PERF_REGIONS.
+ *****************************************************************************/
+enum perf_regions
+{
+    PERF_SURFACE_FLUXES,  /**< surface_fluxes */
+    PERF_SOLVE_SNOW,      /**< solve_snow */
+    PERF_SURF_ENERGY_BAL, /**< calc_surf_energy_bal */
+    PERF_RUNOFF,          /**< runoff */
+    PERF_FROZEN_SOIL,     /**< solve_T_profile and solve_T_profile_implicit */
+    PERF_LAKES,           /**< solve_lake and the lake water balance */
+    PERF_CARBON,          /**< canopy_assimilation and soil_carbon_balance */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_PERF_REGIONS        /**< used as a loop counter*/
+};
+
+/******************************************************************************
+ * @brief   Counts recorded for each region in enum perf_regions.
+ *****************************************************************************/
+enum perf_counters
+{
+    PERF_CALLS,           /**< number of times the region was run */
+    PERF_CYCLES,          /**< CPU cycles */
+    PERF_INSTRUCTIONS,    /**< retired instructions */
+    PERF_CACHE_REFS,      /**< last level cache references */
+    PERF_CACHE_MISSES,    /**< last level cache misses */
+    // Last value of enum - DO NOT ADD ANYTHING BELOW THIS LINE!!
+    // used as a loop counter and must be >= the largest value in this enum
+    N_PERF_COUNTERS       /**< used as a loop counter*/
+};
+
 /******************************************************************************
  * @brief   This structure stores all soil variables for each layer in the
  *          soil column.
@@ -781,19 +1170,21 @@ typedef struct {
  *          for each grid cell.
  *****************************************************************************/
 typedef struct {
-    // State variables
-    double aero_resist[2];             /**< The (stability-corrected) aerodynamic
-                                          resistance (s/m) that was actually used
-                                          in flux calculations.
-                                          [0] = surface (bare soil, non-overstory veg, or snow pack)
-                                          [1] = overstory */
-    double asat;                       /**< saturated area fraction */
+    // State variables written to the state files
     double CLitter;                    /**< carbon storage in litter pool [gC/m2] */
     double CInter;                     /**< carbon storage in intermediate pool [gC/m2] */
     double CSlow;                      /**< carbon storage in slow pool [gC/m2] */
     layer_data_struct layer[MAX_LAYERS]; /**< structure containing soil variables
                                             for each layer (see above; including both
                                             state and flux variables) */
+
+    // Other state and solver variables
+    double aero_resist[2];             /**< The (stability-corrected) aerodynamic
+                                          resistance (s/m) that was actually used
+                                          in flux calculations.
+                                          [0] = surface (bare soil, non-overstory veg, or snow pack)
+                                          [1] = overstory */
+    double asat;                       /**< saturated area fraction */
     double rootmoist;                  /**< total of layer.moist over all layers
                                           in the root zone (mm) */
     double wetness;                    /**< average of
@@ -820,35 +1211,40 @@ typedef struct {
  *          to solve the thermal fluxes through the soil column.
  *****************************************************************************/
 typedef struct {
-    // State variables
+    // State variables written to the state files
+    double T[MAX_NODES];         /**< thermal node temperatures (C) */
+    double Tfoliage;             /**< temperature of the overstory vegetation */
+    double LongUnderOut;         /**< outgoing longwave from understory */
+    double snow_flux;            /**< thermal flux through the snow pack (Wm-2) */
+
+    // Other state and solver variables
     double AlbedoLake;           /**< albedo of lake surface (fract) */
     double AlbedoOver;           /**< albedo of intercepted snow (fract) */
     double AlbedoUnder;          /**< surface albedo (fraction) */
-    double Cs[2];                /**< heat capacity for top two layers (J/m^3/K) */
-    double Cs_node[MAX_NODES];   /**< heat capacity of the soil thermal nodes (J/m^3/K) */
-    double fdepth[MAX_FRONTS];   /**< all simulated freezing front depths */
     bool frozen;                   /**< TRUE = frozen soil present */
-    double ice[MAX_NODES];       /**< thermal node ice content */
-    double kappa[2];             /**< soil thermal conductivity for top two layers (W/m/K) */
-    double kappa_node[MAX_NODES]; /**< thermal conductivity of the soil thermal nodes (W/m/K) */
-    double moist[MAX_NODES];     /**< thermal node moisture content */
     size_t Nfrost;               /**< number of simulated freezing fronts */
     size_t Nthaw;                /**< number of simulated thawing fronts */
-    double T[MAX_NODES];         /**< thermal node temperatures (C) */
-    bool T_fbflag[MAX_NODES];      /**< flag indicating if previous step's temperature was used */
-    unsigned int T_fbcount[MAX_NODES]; /**< running total number of times that previous step's temperature was used */
     int T1_index;                   /**< soil node at the bottom of the top layer */
     double Tcanopy;              /**< temperature of the canopy air */
     bool Tcanopy_fbflag;           /**< flag indicating if previous step's temperature was used */
     unsigned int Tcanopy_fbcount;    /**< running total number of times that previous step's temperature was used */
-    double tdepth[MAX_FRONTS];   /**< all simulated thawing front depths */
-    double Tfoliage;             /**< temperature of the overstory vegetation */
     bool Tfoliage_fbflag;            /**< flag indicating if previous step's temperature was used */
     unsigned int Tfoliage_fbcount;   /**< running total number of times that previous step's temperature was used */
     double Tsurf;                /**< temperature of the understory */
     bool Tsurf_fbflag;           /**< flag indicating if previous step's temperature was used */
     unsigned int Tsurf_fbcount;      /**< running total number of times that previous step's temperature was used */
     double unfrozen;             /**< frozen layer water content that is unfrozen */
+    double Cs[2];                /**< heat capacity for top two layers (J/m^3/K) */
+    double kappa[2];             /**< soil thermal conductivity for top two layers (W/m/K) */
+    double fdepth[MAX_FRONTS];   /**< all simulated freezing front depths */
+    double tdepth[MAX_FRONTS];   /**< all simulated thawing front depths */
+    double Cs_node[MAX_NODES];   /**< heat capacity of the soil thermal nodes (J/m^3/K) */
+    double ice[MAX_NODES];       /**< thermal node ice content */
+    double kappa_node[MAX_NODES]; /**< thermal conductivity of the soil thermal nodes (W/m/K) */
+    double moist[MAX_NODES];     /**< thermal node moisture content */
+    bool T_fbflag[MAX_NODES];      /**< flag indicating if previous step's temperature was used */
+    unsigned int T_fbcount[MAX_NODES]; /**< running total number of times that previous step's temperature was used */
+
     // Fluxes
     double advected_sensible;    /**< net sensible heat flux advected to snowpack (Wm-2) */
     double advection;            /**< advective flux (Wm-2) */
@@ -871,7 +1267,6 @@ typedef struct {
     double longwave;             /**< net longwave flux (Wm-2) */
     double LongOverIn;           /**< incoming longwave to overstory */
     double LongUnderIn;          /**< incoming longwave to understory */
-    double LongUnderOut;         /**< outgoing longwave from understory */
     double melt_energy;          /**< energy used to reduce snow cover fraction (Wm-2) */
     double NetLongAtmos;         /**< net longwave radiation to the atmosphere (W/m^2) */
     double NetLongOver;          /**< net longwave radiation from the overstory (W/m^2) */
@@ -887,7 +1282,6 @@ typedef struct {
     double shortwave;            /**< net shortwave radiation (Wm-2) */
     double ShortOverIn;          /**< incoming shortwave to overstory */
     double ShortUnderIn;         /**< incoming shortwave to understory */
-    double snow_flux;            /**< thermal flux through the snow pack (Wm-2) */
 } energy_bal_struct;
 
 /******************************************************************************
@@ -958,34 +1352,37 @@ typedef struct {
  *          model.
  *****************************************************************************/
 typedef struct {
-    // State variables
-    double albedo;          /**< snow surface albedo (fraction) */
-    double canopy_albedo;   /**< albedo of the canopy (fract) */
+    // State variables written to the state files
     double coldcontent;     /**< cold content of snow pack */
     double coverage;        /**< fraction of snow band that is covered with snow */
     double density;         /**< snow density (kg/m^3) */
-    double depth;           /**< snow depth (m) */
     unsigned int last_snow;     /**< time steps since last snowfall */
-    double max_snow_depth;  /**< last maximum snow depth - used to determine coverage
-                               fraction during current melt period (m) */
     bool MELTING;           /**< flag indicating that snowpack melted
                                previously */
     double pack_temp;       /**< depth averaged temperature of the snowpack (C) */
     double pack_water;      /**< liquid water content of the snow pack (m) */
-    bool snow;              /**< TRUE = snow, FALSE = no snow */
     double snow_canopy;     /**< amount of snow on canopy (m) */
+    double surf_temp;       /**< depth averaged temperature of the snow pack surface layer (C) */
+    double surf_water;      /**< liquid water content of the surface layer (m) */
+    double swq;             /**< snow water equivalent of the entire pack (m) */
+
+    // Other state and solver variables
+    double albedo;          /**< snow surface albedo (fraction) */
+    double canopy_albedo;   /**< albedo of the canopy (fract) */
+    double depth;           /**< snow depth (m) */
+    double max_snow_depth;  /**< last maximum snow depth - used to determine coverage
+                               fraction during current melt period (m) */
+    bool snow;              /**< TRUE = snow, FALSE = no snow */
     double store_coverage;  /**< stores coverage fraction covered by new snow (m) */
     bool store_snow;        /**< flag indicating whether or not new accumulation
                                is stored on top of an existing distribution */
     double store_swq;       /**< stores newly accumulated snow over an
                                established snowpack melt distribution (m) */
-    double surf_temp;       /**< depth averaged temperature of the snow pack surface layer (C) */
     unsigned int surf_temp_fbcount; /**< running total number of times that previous step's temperature was used */
     bool surf_temp_fbflag;    /**< flag indicating if previous step's temperature was used */
-    double surf_water;      /**< liquid water content of the surface layer (m) */
-    double swq;             /**< snow water equivalent of the entire pack (m) */
     double snow_distrib_slope; /**< current slope of uniform snow distribution (m/fract) */
     double tmp_int_storage; /**< temporary canopy storage, used in snow_canopy */
+
     // Fluxes
     double blowing_flux;    /**< depth of sublimation from blowing snow (m) */
     double canopy_vapor_flux; /**< depth of water evaporation, sublimation, or
@@ -1008,6 +1405,7 @@ typedef struct {
     double z[MAX_LAKE_NODES + 1]; /**< Elevation of each lake node (when lake storage is at maximum), relative to lake's deepest point (m) */
     double basin[MAX_LAKE_NODES + 1]; /**< Area of lake basin at each lake node (when lake storage is at maximum) (m^2) */
     double Cl[MAX_LAKE_NODES + 1]; /**< Fractional coverage of lake basin at each node (when lake storage is at maximum) (fraction of grid cell area) */
+    double basin_volume[MAX_LAKE_NODES + 1]; /**< Volume of lake basin below each lake node (m^3) */
     double b;                     /**< Exponent in default lake depth-area profile (y=Ax^b) */
     double maxdepth;              /**< Maximum allowable depth of liquid portion of lake (m) */
     double mindepth;              /**< Minimum allowable depth of liquid portion of lake (m) */
@@ -1082,9 +1480,400 @@ typedef struct {
 typedef struct {
     cell_data_struct **cell;      /**< Stores soil layer variables */
     energy_bal_struct **energy;   /**< Stores energy balance variables */
-    lake_var_struct lake_var;     /**< Stores lake/wetland variables */
+    lake_var_struct *lake_var;    /**< Stores lake/wetland variables, NULL
+                                     for cells without lake variables */
     snow_data_struct **snow;      /**< Stores snow variables */
     veg_var_struct **veg_var;     /**< Stores vegetation variables */
 } all_vars_struct;
 
+/******************************************************************************
+ * @brief   This structure stores the scratch state of the soil thermal
+ *          solvers for one surface energy balance solution.  It is owned by
+ *          the caller so that vic_run holds no static state.
+ *****************************************************************************/
+typedef struct {
+    int FIRST_SOLN[2];            /**< TRUE = coefficients must be computed */
+    double A[MAX_NODES];          /**< explicit scheme coefficients */
+    double B[MAX_NODES];          /**< explicit scheme coefficients */
+    double C[MAX_NODES];          /**< explicit scheme coefficients */
+    double D[MAX_NODES];          /**< explicit scheme coefficients */
+    double E[MAX_NODES];          /**< explicit scheme coefficients */
+    // implicit scheme inputs, set when fda_heat_eqn is initialized
+    double deltat;                /**< model time step (s) */
+    int NOFLUX;                   /**< TRUE = no flux bottom boundary */
+    int EXP_TRANS;                /**< TRUE = exponential node distribution */
+    double *T0;                   /**< node temperatures at start of step */
+    double *moist;                /**< node moisture contents */
+    double *ice;                  /**< node ice contents at start of step */
+    double *kappa;                /**< node thermal conductivities */
+    double *Cs;                   /**< node heat capacities */
+    double *max_moist;            /**< node maximum moisture contents */
+    double *bubble;               /**< node bubbling pressures */
+    double *expt;                 /**< node exponents */
+    double *alpha;                /**< node spacing terms */
+    double *beta;                 /**< node spacing terms */
+    double *gamma;                /**< node spacing terms */
+    double *Zsum;                 /**< node depths */
+    double Dp;                    /**< soil thermal damping depth (m) */
+    soil_thermal_coef_struct *thermal_coef; /**< layer thermal terms */
+    double *depth;                /**< layer thicknesses (m) */
+    size_t Nlayers;               /**< number of soil layers */
+    double Ts;                    /**< surface boundary temperature */
+    double Tb;                    /**< bottom boundary temperature */
+    double Bexp;                  /**< exponential grid transformation term */
+    // implicit scheme work arrays, kept between residual evaluations
+    double ice_new[MAX_NODES];    /**< updated node ice contents */
+    double Cs_new[MAX_NODES];     /**< updated node heat capacities */
+    double kappa_new[MAX_NODES];  /**< updated node thermal conductivities */
+    double DT[MAX_NODES];         /**< centered temperature differences */
+    double DT_down[MAX_NODES];    /**< downward temperature differences */
+    double DT_up[MAX_NODES];      /**< upward temperature differences */
+    double Dkappa[MAX_NODES];     /**< centered conductivity differences */
+} soil_thermal_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the terms of the atmospheric stability
+ *          correction that depend only on the reference height, displacement
+ *          and roughness of a surface, see set_stability_coef().
+ *****************************************************************************/
+typedef struct {
+    double Z_d;        /**< reference height above the displacement (m) */
+    double log_Z_d_Z0; /**< log((Z - d) / Z0) + 5 of the Richardson number
+                          limit */
+} stability_coef_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the terms of the Penman-Monteith equation
+ *          that depend only on the air temperature and the elevation, see
+ *          set_penman_atmos().
+ *****************************************************************************/
+typedef struct {
+    double slope;  /**< slope of the saturated vapor pressure curve (Pa/K) */
+    double lv;     /**< latent heat of vaporization (J/kg) */
+    double gamma;  /**< psychrometric constant (Pa/K) */
+    double r_air;  /**< density of air (kg/m3) */
+} penman_atmos_struct;
+
+/******************************************************************************
+ * @brief   This structure stores the terms of the lake thermal diffusion
+ *          that depend only on the active nodes and their surface areas, see
+ *          set_lake_column(), and the tridiagonal matrix of one eddy
+ *          diffusivity profile, see set_lake_column_diffusion().
+ *****************************************************************************/
+typedef struct {
+    int numnod;                   /**< number of active lake nodes */
+    double dz;                    /**< thickness of the lower nodes (m) */
+    double surfdz;                /**< thickness of the surface node (m) */
+    double *surface;              /**< surface area at the top of each node
+                                     (m2) */
+    double z[MAX_LAKE_NODES];     /**< node thicknesses (m) */
+    double zhalf[MAX_LAKE_NODES]; /**< distances between node centers (m) */
+    double surface_avg[MAX_LAKE_NODES]; /**< mean surface area of each node
+                                           (m2) */
+    double expsw[MAX_LAKE_NODES]; /**< visible attenuation at the bottom of
+                                     each node */
+    double explw[MAX_LAKE_NODES]; /**< near infrared attenuation at the
+                                     bottom of each node */
+    double dt;                    /**< time step of the matrix (s) */
+    double de[MAX_LAKE_NODES];    /**< eddy diffusivity of the matrix (m2/s) */
+    double a[MAX_LAKE_NODES];     /**< diagonal of the matrix */
+    double b[MAX_LAKE_NODES];     /**< upper diagonal of the matrix */
+    double c[MAX_LAKE_NODES];     /**< lower diagonal of the matrix */
+} lake_column_struct;
+
+/******************************************************************************
+ * @brief   This structure holds the water balance runoff state of a set of
+ *          cells as flat arrays, see runoff_flat(). The fields of layer l of
+ *          cell i are at [l * ncells + i].
+ *****************************************************************************/
+typedef struct {
+    size_t ncells;         /**< number of cells */
+    size_t nlayers;        /**< number of soil layers */
+    // soil parameters of each cell
+    double *b_infilt;      /**< infiltration parameter */
+    double *Ds;            /**< fraction of maximum subsurface flow rate */
+    double *Dsmax;         /**< maximum subsurface flow rate (mm/day) */
+    double *Ws;            /**< fraction of maximum soil moisture */
+    double *c;             /**< exponent of the ARNO baseflow curve */
+    // soil parameters of each layer
+    double *expt;          /**< Brooks & Corey exponent */
+    double *Ksat;          /**< saturated hydraulic conductivity (mm/day) */
+    double *max_moist;     /**< maximum moisture content (mm) */
+    double *resid_moist;   /**< residual moisture content (mm) */
+    // state of each layer
+    double *moist;         /**< total soil moisture (mm) */
+    // forcing
+    double *ppt;           /**< liquid water reaching the soil (mm) */
+    double *evap;          /**< evaporation of each layer (mm), the bottom
+                              layer is reduced by negative baseflow */
+    // output of each cell
+    double *runoff;        /**< surface runoff (mm) */
+    double *baseflow;      /**< baseflow (mm) */
+    double *asat;          /**< saturated area fraction */
+} runoff_flat_struct;
+
+/******************************************************************************
+ * @brief   This structure holds the arguments of the surface energy balance
+ *          residual, see func_surf_energy_bal_ctx().
+ *****************************************************************************/
+typedef struct {
+    // general model terms
+    int VEG;
+    int veg_class;
+    veg_lib_struct *veg_lib;
+    double delta_t;
+
+    // soil layer terms
+    double Cs1;
+    double Cs2;
+    double D1;
+    double D2;
+    double T1_old;
+    double T2;
+    double Ts_old;
+    double *Told_node;
+    double bubble;
+    double dp;
+    double expt;
+    double ice0;
+    double kappa1;
+    double kappa2;
+    double max_moist;
+    double moist;
+
+    double *root;
+    double *CanopLayerBnd;
+
+    // meteorological forcing terms
+    int UnderStory;
+    int overstory;
+
+    double NetShortBare;
+    double NetShortGrnd;
+    double NetShortSnow;
+    double Tair;
+    double atmos_density;
+    double atmos_pressure;
+    double emissivity;
+    double LongBareIn;
+    double LongSnowIn;
+    double surf_atten;
+    double vp;
+    double vpd;
+    double shortwave;
+    double Catm;
+    double *dryFrac;
+
+    double *Wdew;
+    double *displacement;
+    double *ra;
+    double *Ra_veg;
+    double *Ra_used;
+    double rainfall;
+    double *ref_height;
+    double *roughness;
+    double *wind;
+
+    // latent heat terms
+    double Le;
+
+    // snowpack terms
+    double Advection;
+    double OldTSurf;
+    double Tsnow_surf;
+    double kappa_snow;
+    double melt_energy;
+    double snow_coverage;
+    double snow_density;
+    double snow_swq;
+    double snow_water;
+
+    double *deltaCC;
+    double *refreeze_energy;
+    double *vapor_flux;
+    double *blowing_flux;
+    double *surface_flux;
+
+    // soil node terms
+    int Nnodes;
+
+    double *Cs_node;
+    double *T_node;
+    double *Tnew_node;
+    char *Tnew_fbflag;
+    unsigned *Tnew_fbcount;
+    double *alpha;
+    double *beta;
+    double *bubble_node;
+    double *Zsum_node;
+    double *expt_node;
+    double *gamma;
+    double *ice_node;
+    double *kappa_node;
+    double *max_moist_node;
+    double *moist_node;
+
+    // model structures
+    soil_con_struct *soil_con;
+    layer_data_struct *layer;
+    veg_var_struct *veg_var;
+
+    // control flags
+    int INCLUDE_SNOW;
+    int NOFLUX;
+    int EXP_TRANS;
+    int SNOWING;
+
+    soil_thermal_struct *soil_thermal;
+
+    // aerodynamic terms that do not depend on the surface temperature, set by
+    // set_surf_energy_bal_aero()
+    stability_coef_struct stab_veg;
+    stability_coef_struct stab_bare;
+    double Ra_bare;
+    double U_bare;
+
+    // Penman-Monteith terms of the canopy air temperature, set by
+    // set_surf_energy_bal_aero()
+    penman_atmos_struct penman_atmos;
+
+    // returned energy balance terms
+    double *NetLongBare;
+    double *NetLongSnow;
+    double *T1;
+    double *deltaH;
+    double *fusion;
+    double *grnd_flux;
+    double *latent_heat;
+    double *latent_heat_sub;
+    double *sensible_heat;
+    double *snow_flux;
+    double *store_error;
+} surf_energy_bal_args_struct;
+
+/******************************************************************************
+ * @brief   This structure holds the arguments of the snow pack energy balance
+ *          residual, see SnowPackEnergyBalance_ctx().
+ *****************************************************************************/
+typedef struct {
+    // general model terms
+    double Dt;
+    double Ra;
+    double *Ra_used;
+    stability_coef_struct *stab;
+
+    // atmospheric forcing terms
+    double AirDens;
+    double EactAir;
+    double LongSnowIn;
+    double Lv;
+    double Press;
+    double Rain;
+    double NetShortUnder;
+    double Vpd;
+    double Wind;
+
+    // snowpack terms
+    double OldTSurf;
+    double SnowCoverFract;
+    double SnowDepth;
+    double SnowDensity;
+    double SurfaceLiquidWater;
+    double SweSurfaceLayer;
+
+    // energy balance terms
+    double Tair;
+    double TGrnd;
+
+    // terms that do not depend on the surface temperature, set by
+    // set_snow_pack_energy_bal_terms()
+    double AdvectedEnergyMelt;
+    double ColdContentCoef;
+    double GroundFluxCoef;
+    double RefreezeEnergyMax;
+
+    // returned energy balance terms
+    double *AdvectedEnergy;
+    double *AdvectedSensibleHeat;
+    double *DeltaColdContent;
+    double *GroundFlux;
+    double *LatentHeat;
+    double *LatentHeatSub;
+    double *NetLongUnder;
+    double *RefreezeEnergy;
+    double *SensibleHeat;
+    double *vapor_flux;
+    double *blowing_flux;
+    double *surface_flux;
+} snow_pack_energy_bal_args_struct;
+
+/******************************************************************************
+ * @brief   This structure holds the arguments of the canopy energy balance
+ *          residual, see func_canopy_energy_bal_ctx().
+ *****************************************************************************/
+typedef struct {
+    // general model terms
+    double delta_t;
+    double elevation;
+    double *Wmax;
+    double *Wcr;
+    double *Wpwp;
+    double *frost_fract;
+
+    // atmospheric forcing terms
+    double AirDens;
+    double EactAir;
+    double Press;
+    double Le;
+    double Tcanopy;
+    double Vpd;
+    double shortwave;
+    double Catm;
+    double *dryFrac;
+    double *Evap;
+    double *Ra;
+    double *Ra_used;
+    double Rainfall;
+    double *Wind;
+
+    // vegetation terms
+    int veg_class;
+    veg_lib_struct *veg_lib;
+    double *displacement;
+    double *ref_height;
+    double *roughness;
+    double *root;
+    double *CanopLayerBnd;
+
+    // water flux terms
+    double IntRain;
+    double IntSnow;
+    double *Wdew;
+    layer_data_struct *layer;
+    veg_var_struct *veg_var;
+
+    // energy flux terms
+    double LongOverIn;
+    double LongUnderOut;
+    double NetShortOver;
+
+    // terms that do not depend on the foliage temperature, set by
+    // set_canopy_energy_bal_terms()
+    stability_coef_struct stab;
+    double AdvectedEnergyRain;
+    double RadiationIn;
+    double RefreezeEnergyMax;
+
+    // returned energy balance terms
+    double *AdvectedEnergy;
+    double *LatentHeat;
+    double *LatentHeatSub;
+    double *LongOverOut;
+    double *NetLongOver;
+    double *NetRadiation;
+    double *RefreezeEnergy;
+    double *SensibleHeat;
+    double *VaporMassFlux;
+} canopy_energy_bal_args_struct;
+
 #endif
@@ -41,6 +41,7 @@
 #ifndef __vic_log_h__
 #define __vic_log_h__
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <errno.h>
 #include <execinfo.h>
@@ -58,9 +59,25 @@
 #define LOG_LVL 25
 #endif
 
+// Warnings that can repeat every time step (e.g. from the physics) are
+// printed at most LOG_WARN_REPEAT times from each call site, further
+// occurrences are only counted. Set LOG_WARN_REPEAT to 0 to print them all.
+#ifndef LOG_WARN_REPEAT
+#define LOG_WARN_REPEAT 10
+#endif
+
+// Largest number of call sites of log_warn_repeat in the summary of the
+// warnings at the end of the run
+#define MAX_LOG_SITES 64
+
 FILE *LOG_DEST;
 
+void buffer_logging(size_t size, FILE **logfile);
+bool count_log_repeat(size_t *count, const char *file, int line);
 void finalize_logging(void);
+size_t get_log_repeat_nsites(void);
+size_t get_log_repeat_site(size_t i, const char **file, int *line);
+void print_log_summary(void);
 void get_logname(const char *path, int id, char *filename);
 void initialize_log(void);
 void print_trace(void);
@@ -106,6 +123,19 @@ void setup_logging(int id, char log_path[], FILE **logfile);
 
 #endif
 
+// Rate-limited Warn Level, the arguments are only evaluated when the warning
+// is printed
+#if LOG_LVL < 30
+#define log_warn_repeat(M, ...) do { \
+        static size_t log_repeat_count = 0; \
+        if (count_log_repeat(&log_repeat_count, __FILE__, __LINE__)) { \
+            log_warn(M, ## __VA_ARGS__); \
+        } \
+} while (0)
+#else
+#define log_warn_repeat(M, ...)
+#endif
+
 // Error Level is always active
 #ifdef NO_LINENOS
 #define log_err(M, ...) print_trace(); fprintf(LOG_DEST, \
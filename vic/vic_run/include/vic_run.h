@@ -28,6 +28,7 @@
 #define VIC_RUN_H
 
 #include <vic_def.h>
+#include <vic_specialize.h>
 
 void advect_carbon_storage(double, double, lake_var_struct *,
                            cell_data_struct *);
@@ -35,7 +36,7 @@ void advect_snow_storage(double, double, double, snow_data_struct *);
 void advect_soil_veg_storage(double, double, double, double *,
                              soil_con_struct *, veg_con_struct *,
                              cell_data_struct *, veg_var_struct *,
-                             lake_con_struct);
+                             lake_con_struct *);
 double advected_sensible_heat(double, double, double, double, double);
 void alblake(double, double, double *, double *, double *, double *, double,
              double, double, unsigned int *, double, bool *, unsigned short int,
@@ -63,6 +64,10 @@ double calc_rc(double, double, double, double, double, double, double, char);
 void calc_rc_ps(char, double, double, double, double *, double, double,
                 double *, double, double, double *, double, double, double,
                 double *, double *);
+void calc_rc_ps_demand(char, double, double, double, double *, double, double,
+                       double *, double, double, double *, double, double *,
+                       double *);
+void calc_rc_ps_stress(double, double, double, double *, double *);
 double calc_snow_coverage(bool *, double, double, double, double, double,
                           double, double, double *, double, double *, double *,
                           double *);
@@ -78,8 +83,9 @@ double calc_surf_energy_bal(double, double, double, double, double, double,
                             double, double *, double *, double, double *,
                             double *, int, int, size_t, size_t, double, size_t,
                             unsigned short int, int, unsigned short int,
-                            double *, double *, force_data_struct *,
-                            dmy_struct *, energy_bal_struct *,
+                            veg_lib_struct *, double *, double *,
+                            force_data_struct *, dmy_struct *,
+                            energy_bal_struct *,
                             layer_data_struct *, snow_data_struct *,
                             soil_con_struct *, veg_var_struct *);
 double calc_veg_displacement(double);
@@ -101,13 +107,18 @@ void canopy_assimilation(char, double, double, double, double *, double, double,
                          double *, double *, double *, double *, double *,
                          double *, double *, double *, double *, double *);
 double canopy_evap(layer_data_struct *, veg_var_struct *, bool,
-                   unsigned short int, double *, double, double, double, double,
+                   unsigned short int, veg_lib_struct *, double *, double,
+                   double, double, double,
                    double, double, double, double, double *, double *, double *,
-                   double *, double *, double *, double, double, double *);
+                   double *, double *, double *, double, double, double *,
+                   penman_atmos_struct *);
 void colavg(double *, double *, double *, double, double *, int, double,
             double);
 double compute_coszen(double, double, double, unsigned short int, unsigned int);
-void compute_derived_lake_dimensions(lake_var_struct *, lake_con_struct);
+void compute_coszen_cells(size_t, solar_geom_struct *, double, double,
+                          unsigned int, double *);
+void compute_derived_lake_dimensions(lake_var_struct *, lake_con_struct *);
+void compute_lake_basin_volume(lake_con_struct *);
 void compute_pot_evap(size_t, double, double, double, double, double, double,
                       double, double, double, double *, char, double, double,
                       double, double *);
@@ -116,17 +127,20 @@ void compute_runoff_and_asat(soil_con_struct *, double *, double, double *,
 void compute_soil_resp(int, double *, double, double, double *, double *,
                        double, double, double, double *, double *, double *);
 void compute_soil_layer_thermal_properties(layer_data_struct *, double *,
-                                           double *, double *, double *,
-                                           double *, double *, double *,
+                                           soil_thermal_coef_struct *,
                                            double *, size_t);
+void compute_solar_decl(unsigned short int, double *, double *);
+void compute_solar_geom(double, double, double, solar_geom_struct *);
 double compute_zwt(soil_con_struct *, int, double);
+void copy_snow_band(unsigned short iveg, size_t rep, size_t band,
+                    all_vars_struct *all_vars);
 void correct_precip(double *, double, double, double, double);
 double darkinhib(double);
 int distribute_node_moisture_properties(double *, double *, double *, double *,
                                         double *, double *, double *, double *,
-                                        double *, double *, double *, double *,
-                                        double *, double *, double *, double *,
-                                        double *, int, int, char);
+                                        double *, double *, double *,
+                                        soil_thermal_coef_struct *, int, int,
+                                        char);
 void eddy(int, double, double *, double *, double, int, double, double);
 void energycalc(double *, double *, int, double, double, double *, double *,
                 double *);
@@ -161,25 +175,34 @@ double estimate_T1(double, double, double, double, double, double, double,
                    double, double, double);
 void faparl(double *, double, double, double, double, double *, double *);
 void fda_heat_eqn(double *, double *, int, int, ...);
+void fda_heat_eqn_jacobian(double *, double *, double *, double *, int,
+                           soil_thermal_struct *);
 void fdjac3(double *, double *, double *, double *, double *, void (*vecfunc)(
-                double *, double *, int, int, ...), int);
+                double *, double *, int, int, ...), int, soil_thermal_struct *);
 void find_0_degree_fronts(energy_bal_struct *, double *, double *, int);
 void free_2d_double(size_t *shape, double **array);
+double gauss_log_integral(double (*funcd)(), double es, double Wind,
+                          double AirDens, double ZO, double EactAir, double F,
+                          double hsalt, double phi_r, double ushear,
+                          double Zrh, double a, double b);
 void free_3d_double(size_t *shape, double ***array);
+void free_scratch_arena(void);
+bool frost_area_repeats(layer_data_struct *, double [][MAX_FROST_AREAS], int);
 double func_atmos_energy_bal(double, va_list);
 double func_atmos_moist_bal(double, va_list);
 double func_canopy_energy_bal(double, va_list);
+double func_canopy_energy_bal_ctx(double, void *);
 double func_surf_energy_bal(double, va_list);
-double (*funcd)(double z, double es, double Wind, double AirDens, double ZO,
-                double EactAir, double F, double hsalt, double phi_r,
-                double ushear,
-                double Zrh);
-int get_depth(lake_con_struct, double, double *);
+double func_surf_energy_bal_ctx(double, void *);
+int get_depth(lake_con_struct *, double, double *);
+unsigned short get_runoff_steps(layer_data_struct *layer,
+                                soil_con_struct *soil_con, double ppt,
+                                double *resid_moist, unsigned short max_steps);
 double get_prob(double Tair, double Age, double SurfaceLiquidWater, double U10);
-int get_sarea(lake_con_struct, double, double *);
+int get_sarea(lake_con_struct *, double, double *);
 void get_shear(double x, double *f, double *df, double Ur, double Zr);
 double get_thresh(double Tair, double SurfaceLiquidWater, double Zo_salt);
-int get_volume(lake_con_struct, double, double *);
+int get_volume(lake_con_struct *, double, double *);
 double hiTinhib(double);
 int ice_melt(double, double, double *, double, snow_data_struct *,
              lake_var_struct *, double, double, double, double, double, double,
@@ -190,8 +213,9 @@ double IceEnergyBalance(double, va_list);
 void iceform(double *, double *, double, double, double *, int, double, double,
              double, double *, double *, double *, double *, double);
 void icerad(double, double, double, double *, double *, double *);
-void initialize_lake(lake_var_struct *, lake_con_struct, soil_con_struct *,
+void initialize_lake(lake_var_struct *, lake_con_struct *, soil_con_struct *,
                      cell_data_struct *, bool);
+void initialize_svp_table(void);
 int lakeice(double, double, double, double, double, double *, double, double *,
             double *, double, double);
 void latent_heat_from_snow(double, double, double, double, double, double,
@@ -205,16 +229,33 @@ void malloc_2d_double(size_t *shape, double ***array);
 void malloc_3d_double(size_t *shape, double ****array);
 void MassRelease(double *, double *, double *, double *);
 double maximum_unfrozen_water(double, double, double, double);
+void merge_snow_bands(unsigned short iveg, size_t Nbands,
+                      all_vars_struct *all_vars, force_data_struct *force,
+                      soil_con_struct *soil_con, size_t *band_rep,
+                      double *Tfactor, double *Pfactor);
 double new_snow_density(double);
 int newt_raph(void (*vecfunc)(double *, double *, int, int,
-                              ...), double *, int);
+                              ...),
+              void (*jacfunc)(double *, double *, double *, double *, int,
+                              soil_thermal_struct *), double *, int,
+              soil_thermal_struct *);
 double penman(double, double, double, double, double, double, double);
+double penman_atmos(penman_atmos_struct *, double, double, double, double,
+                    double);
+void perf_region_start(enum perf_regions region);
+void perf_region_stop(enum perf_regions region);
+void perf_regions_collect(
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS]);
 void photosynth(char, double, double, double, double, double, double, double,
                 double, double, char *, double *, double *, double *, double *,
                 double *);
+void photosynth_kinetics(char, double, double, photo_kinetics_struct *);
+void photosynth_layer(char, double, double, double, double, double, double,
+                      double, bool, photo_kinetics_struct *, double *, double *,
+                      double *, double *, double *);
 void polint(double xa[], double ya[], int n, double x, double *y, double *dy);
-void prepare_full_energy(int, all_vars_struct *, soil_con_struct *, double *,
-                         double *);
+void prepare_full_energy(int, size_t, all_vars_struct *, soil_con_struct *,
+                         double *, double *);
 double qromb(
     double (*sub_with_height)(), double es, double Wind, double AirDens, double ZO, double EactAir, double F, double hsalt, double phi_r, double ushear, double Zrh, double a,
     double b);
@@ -225,15 +266,45 @@ void rescale_soil_veg_fluxes(double, double, cell_data_struct *,
                              veg_var_struct *);
 void rhoinit(double *, double);
 double root_brent(double, double, double (*Function)(double, va_list), ...);
+void root_brent_batch_ctx(size_t, const double *, const double *,
+                          void (*Function)(size_t, const double *,
+                                           const bool *, double *, void *),
+                          void *, double *);
+double root_brent_ctx(double, double, double (*Function)(double, void *),
+                      void *);
+double root_brent_retry_ctx(double, double (*Function)(double, void *),
+                            void *);
+double root_newton_ctx(double, double, double,
+                       double (*Function)(double, void *), void *);
 double rtnewt(double x1, double x2, double xacc, double Ur, double Zr);
 int runoff(cell_data_struct *, energy_bal_struct *, soil_con_struct *, double,
            double *, int);
+void runoff_flat(runoff_flat_struct *, unsigned short, double);
+void runoff_flat_enter(runoff_flat_struct *);
+void runoff_flat_exit(runoff_flat_struct *);
+double **scratch_2d_double(size_t *shape);
+double ***scratch_3d_double(size_t *shape);
+void *scratch_calloc(size_t n, size_t size);
+scratch_mark_struct scratch_mark(void);
+void scratch_release(scratch_mark_struct mark);
+void scratch_reset(void);
+void set_canopy_energy_bal_terms(canopy_energy_bal_args_struct *);
+void set_lake_column(int, double, double, double *, lake_column_struct *);
+void set_lake_column_diffusion(double *, double, lake_column_struct *);
 void set_node_parameters(double *, double *, double *, double *, double *,
                          double *, double *, double *, double *, double *,
                          double *, int, int);
+void set_penman_atmos(double, double, penman_atmos_struct *);
+void set_snow_pack_energy_bal_terms(snow_pack_energy_bal_args_struct *);
+void set_soil_thermal_coef(double, double, double, double, double, double,
+                           soil_thermal_coef_struct *);
+void set_stability_coef(double, double, double, stability_coef_struct *);
+void set_surf_energy_bal_aero(surf_energy_bal_args_struct *);
 void shear_stress(double U10, double ZO, double *ushear, double *Zo_salt,
                   double utshear);
 double snow_albedo(double, double, double, double, double, int, bool);
+bool snow_single_step(snow_data_struct *snow, force_data_struct *force,
+                      double Tfactor);
 double snow_density(snow_data_struct *, double, double, double, double);
 int snow_intercept(double, double, double, double, double, double, double,
                    double, double, double, double *, double *, double *,
@@ -241,8 +312,9 @@ int snow_intercept(double, double, double, double, double, double, double,
                    double *, double *, double *, double *, double *, double *,
                    double *, bool *, unsigned int *, double *, double *,
                    double *, double *, double *, double *, double *, int, int,
-                   int, int, int, unsigned short int, double *, double *,
-                   force_data_struct *, layer_data_struct *, soil_con_struct *,
+                   int, int, int, unsigned short int, veg_lib_struct *,
+                   double *, double *, force_data_struct *,
+                   layer_data_struct *, soil_con_struct *,
                    veg_var_struct *);
 int snow_melt(double, double, double, double, double *, double, double *,
               double, double, double, double, double, double, double, double,
@@ -251,10 +323,12 @@ int snow_melt(double, double, double, double, double *, double, double *,
               double *, double *, double *, double *, int, int, int,
               snow_data_struct *);
 double SnowPackEnergyBalance(double, va_list);
+double SnowPackEnergyBalance_ctx(double, void *);
 void soil_carbon_balance(soil_con_struct *, energy_bal_struct *,
                          cell_data_struct *, veg_var_struct *);
 double soil_conductivity(double, double, double, double, double, double, double,
                          double);
+double soil_conductivity_coef(double, double, soil_thermal_coef_struct *);
 double soil_thermal_eqn(double, va_list);
 double solve_atmos_energy_bal(double Tcanopy, ...);
 double solve_atmos_moist_bal(double, ...);
@@ -269,22 +343,29 @@ double solve_snow(char, double, double, double, double, double, double, double,
                   double *, double *, double *, double *, double *, double *,
                   double *, double *, double *, double *, double *, double *,
                   int, size_t, unsigned short int, unsigned short int, double,
-                  size_t, int, int *, double *, double *, dmy_struct *,
+                  size_t, int, veg_lib_struct *, int *, double *, double *,
+                  dmy_struct *,
                   force_data_struct *, energy_bal_struct *, layer_data_struct *,
                   snow_data_struct *, soil_con_struct *, veg_var_struct *);
+void solve_snow_free(double, double, double, double *, double *, double *,
+                     double *, double *, int *, energy_bal_struct *,
+                     snow_data_struct *);
 double solve_surf_energy_bal(double Tsurf, ...);
 int solve_T_profile(double *, double *, char *, unsigned int *, double *,
                     double *, double *, double *, double, double *, double *,
                     double *, double *, double *, double *, double *, double,
-                    int, int *, int, int, int);
+                    int, soil_thermal_struct *, int, int, int);
 int solve_T_profile_implicit(double *, double *, char *, unsigned int *,
                              double *, double *, double *, double *, double,
                              double *, double *, double *, double *, double *,
-                             double *, double *, double, int, int *, int, int,
-                             double *, double *, double *, double *, double *,
-                             double *, double *);
+                             double *, double *, double, int,
+                             soil_thermal_struct *, int, int,
+                             soil_thermal_coef_struct *, double *);
 double specheat(double);
+char *sprint_vic_run_ref(char *);
 double StabilityCorrection(double, double, double, double, double, double);
+double StabilityCorrection_coef(double, double, double,
+                                stability_coef_struct *);
 double sub_with_height(double z, double es, double Wind, double AirDens,
                        double ZO, double EactAir, double F, double hsalt,
                        double phi_r, double ushear, double Zrh);
@@ -292,34 +373,42 @@ int surface_fluxes(bool, double, double, double, double, double *, double *,
                    double *, double *, double *, double *, double *, double *,
                    double *, double *, double *, double *, double *, size_t,
                    size_t, unsigned short int, double, unsigned short int,
-                   unsigned short int, force_data_struct *, dmy_struct *,
-                   energy_bal_struct *, global_param_struct *,
+                   unsigned short int, veg_lib_struct *, force_data_struct *,
+                   dmy_struct *, energy_bal_struct *, global_param_struct *,
                    cell_data_struct *, snow_data_struct *, soil_con_struct *,
                    veg_var_struct *, double, double, double, double *);
 double svp(double);
+double svp_exact(double);
 double svp_slope(double);
+double svp_slope_exact(double);
 void temp_area(double, double, double, double *, double *, double *, double *,
-               double, double *, int, double, double, double *, double *,
-               double *);
+               lake_column_struct *, double *, double *);
 void tracer_mixer(double *, int *, double *, int, double, double, double *);
 void transpiration(layer_data_struct *, veg_var_struct *, unsigned short int,
-                   double, double, double, double, double, double, double,
+                   veg_lib_struct *, double, double, double, double, double, double, double,
                    double, double *, double *, double *, double *, double *,
-                   double *, double, double, double *);
+                   double *, double, double, double *, penman_atmos_struct *);
+double transport_integral(double Wind, double ZO, double hsalt, double phi_r,
+                          double ushear, double a, double b);
 double transport_with_height(double z, double es, double Wind, double AirDens,
                              double ZO, double EactAir, double F, double hsalt,
                              double phi_r, double ushear, double Zrh);
 double trapzd(
     double (*funcd)(), double es, double Wind, double AirDens, double ZO, double EactAir, double F, double hsalt, double phi_r, double ushear, double Zrh, double a, double b,
-    int n);
+    int n, double s);
 void tridia(int, double *, double *, double *, double *, double *);
 void tridiag(double *, double *, double *, double *, unsigned int);
+void tridiag_batch(size_t, size_t, const double *, const double *,
+                   const double *, const double *, double *, double *);
 int vic_run(force_data_struct *, all_vars_struct *, dmy_struct *,
             global_param_struct *, lake_con_struct *, soil_con_struct *,
             veg_con_struct *, veg_lib_struct *);
 double volumetric_heat_capacity(double, double, double, double);
-int water_balance(lake_var_struct *, lake_con_struct, double, all_vars_struct *,
-                  int, int, double, soil_con_struct, veg_con_struct);
+double volumetric_heat_capacity_coef(double, double,
+                                     soil_thermal_coef_struct *);
+int water_balance(lake_var_struct *, lake_con_struct *, double,
+                  all_vars_struct *, int, int, double, soil_con_struct,
+                  veg_con_struct);
 int water_energy_balance(int, double *, double *, double, double, double,
                          double, double, double, double, double, double, double,
                          double, double, double, double *, double *, double *,
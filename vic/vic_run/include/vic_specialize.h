@@ -0,0 +1,121 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Options of the model physics that may be fixed when compiling
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VIC_SPECIALIZE_H
+#define VIC_SPECIALIZE_H
+
+/******************************************************************************
+ * A specialized build (e.g. make SPECIALIZE=wb_3layer) defines
+ * VIC_SPECIALIZE and VIC_SPECIALIZE_<profile>. The profile fixes some of the
+ * options read by vic_run as constants, so that the compiler can remove the
+ * branches of the other options and unroll the loops over the soil layers
+ * and thermal nodes. vic_run reads these options only through the OPT_*
+ * macros below, which still name options, so that the extern declarations of
+ * options in vic_run are used in all builds. check_specialized_options()
+ * stops a run with options that differ from the profile.
+ *****************************************************************************/
+#ifdef VIC_SPECIALIZE
+#if defined(VIC_SPECIALIZE_wb_3layer)
+// water balance, 3 soil layers
+#define SPECIALIZED_FULL_ENERGY false
+#define SPECIALIZED_FROZEN_SOIL false
+#define SPECIALIZED_QUICK_FLUX  true
+#define SPECIALIZED_CARBON      false
+#define SPECIALIZED_LAKES       false
+#define SPECIALIZED_BLOWING     false
+#define SPECIALIZED_Nlayer      3
+#define SPECIALIZED_Nnode       3
+#elif defined(VIC_SPECIALIZE_eb_3layer)
+// energy balance without frozen soil, 3 soil layers
+#define SPECIALIZED_FULL_ENERGY true
+#define SPECIALIZED_FROZEN_SOIL false
+#define SPECIALIZED_QUICK_FLUX  true
+#define SPECIALIZED_CARBON      false
+#define SPECIALIZED_LAKES       false
+#define SPECIALIZED_BLOWING     false
+#define SPECIALIZED_Nlayer      3
+#define SPECIALIZED_Nnode       3
+#elif defined(VIC_SPECIALIZE_fs_3layer)
+// energy balance with frozen soil, 3 soil layers
+#define SPECIALIZED_FULL_ENERGY true
+#define SPECIALIZED_FROZEN_SOIL true
+#define SPECIALIZED_QUICK_FLUX  false
+#define SPECIALIZED_CARBON      false
+#define SPECIALIZED_LAKES       false
+#define SPECIALIZED_BLOWING     false
+#define SPECIALIZED_Nlayer      3
+#else
+#error "Unknown SPECIALIZE profile, see vic_run/include/vic_specialize.h"
+#endif
+#endif
+
+#ifdef SPECIALIZED_FULL_ENERGY
+#define OPT_FULL_ENERGY ((void) options.FULL_ENERGY, SPECIALIZED_FULL_ENERGY)
+#else
+#define OPT_FULL_ENERGY options.FULL_ENERGY
+#endif
+#ifdef SPECIALIZED_FROZEN_SOIL
+#define OPT_FROZEN_SOIL ((void) options.FROZEN_SOIL, SPECIALIZED_FROZEN_SOIL)
+#else
+#define OPT_FROZEN_SOIL options.FROZEN_SOIL
+#endif
+#ifdef SPECIALIZED_QUICK_FLUX
+#define OPT_QUICK_FLUX ((void) options.QUICK_FLUX, SPECIALIZED_QUICK_FLUX)
+#else
+#define OPT_QUICK_FLUX options.QUICK_FLUX
+#endif
+#ifdef SPECIALIZED_CARBON
+#define OPT_CARBON ((void) options.CARBON, SPECIALIZED_CARBON)
+#else
+#define OPT_CARBON options.CARBON
+#endif
+#ifdef SPECIALIZED_LAKES
+#define OPT_LAKES ((void) options.LAKES, SPECIALIZED_LAKES)
+#else
+#define OPT_LAKES options.LAKES
+#endif
+#ifdef SPECIALIZED_BLOWING
+#define OPT_BLOWING ((void) options.BLOWING, SPECIALIZED_BLOWING)
+#else
+#define OPT_BLOWING options.BLOWING
+#endif
+#ifdef SPECIALIZED_SNOW_BAND
+#define OPT_SNOW_BAND ((void) options.SNOW_BAND, SPECIALIZED_SNOW_BAND)
+#else
+#define OPT_SNOW_BAND options.SNOW_BAND
+#endif
+#ifdef SPECIALIZED_Nlayer
+#define OPT_Nlayer ((void) options.Nlayer, SPECIALIZED_Nlayer)
+#else
+#define OPT_Nlayer options.Nlayer
+#endif
+#ifdef SPECIALIZED_Nnode
+#define OPT_Nnode ((void) options.Nnode, SPECIALIZED_Nnode)
+#else
+#define OPT_Nnode options.Nnode
+#endif
+
+#endif
@@ -175,8 +175,8 @@ CalcAerodynamic(bool    OverStory,          /* overstory flag */
                     log((ref_height[0] -
                          d_Upper) / Z0_Upper) / (n * K2 * (Zw - d_Upper)) *
                     (exp(n * (1 - Zt / Height)) - 1);
-            log_warn("Top of overstory is less than 2 meters above the lower "
-                     "boundary");
+            log_warn_repeat("Top of overstory is less than 2 meters above "
+                            "the lower boundary");
         }
 
         /** Set aerodynamic resistance terms for canopy */
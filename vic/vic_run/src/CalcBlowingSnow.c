@@ -292,9 +292,10 @@ qromb(double (*funcd)(),
     int                      j;
 
     h[1] = 1.0;
+    s[0] = 0.0;
     for (j = 1; j <= param.BLOWING_MAX_ITER; j++) {
         s[j] = trapzd(funcd, es, Wind, AirDens, ZO, EactAir, F, hsalt, phi_r,
-                      ushear, Zrh, a, b, j);
+                      ushear, Zrh, a, b, j, s[j - 1]);
         if (j >= param.BLOWING_K) {
             polint(&h[j - param.BLOWING_K], &s[j - param.BLOWING_K],
                    param.BLOWING_K, 0.0, &ss, &dss);
@@ -322,14 +323,13 @@ polint(double  xa[],
     double  den, dif, dift, ho, hp, w;
     double *c = NULL;
     double *d = NULL;
+    scratch_mark_struct scratch_start;
 
     ns = 1;
     dif = fabs(x - xa[1]);
-    c = (double *)malloc((size_t) ((n + 1) * sizeof(double)));
-    check_alloc_status(c, "Memory allocation error.");
-    d = (double *)malloc((size_t) ((n + 1) * sizeof(double)));
-    check_alloc_status(d, "Memory allocation error.");
-
+    scratch_start = scratch_mark();
+    c = scratch_calloc(n + 1, sizeof(*c));
+    d = scratch_calloc(n + 1, sizeof(*d));
 
     for (i = 1; i <= n; i++) {
         if ((dift = fabs(x - xa[i])) < dif) {
@@ -354,12 +354,13 @@ polint(double  xa[],
         }
         *y += (*dy = (2 * ns < (n - m) ? c[ns + 1] : d[ns--]));
     }
-    free(d);
-    free(c);
+    scratch_release(scratch_start);
 }
 
 /******************************************************************************
  * @brief    Compute the nth stage of refinement of an extended trapezoidal rule.
+ * @details  s is the result of stage n - 1 (ignored when n == 1), which the
+ *           caller keeps so that this routine carries no state between calls.
  *****************************************************************************/
 double
 trapzd(double (*funcd)(),
@@ -375,20 +376,20 @@ trapzd(double (*funcd)(),
        double   Zrh,
        double   a,
        double   b,
-       int      n)
+       int      n,
+       double   s)
 {
-    double        x, tnm, sum, del;
-    static double s;
-    int           it, j;
+    double x, tnm, sum, del;
+    int    it, j;
 
     if (n == 1) {
-        return (s = 0.5 *
-                    (b -
-                     a) *
-                    ((*funcd)(a, es, Wind, AirDens, ZO, EactAir, F, hsalt,
-                              phi_r, ushear, Zrh) +
-                     (*funcd)(b, es, Wind, AirDens, ZO, EactAir, F, hsalt,
-                              phi_r, ushear, Zrh)));
+        return (0.5 *
+                (b -
+                 a) *
+                ((*funcd)(a, es, Wind, AirDens, ZO, EactAir, F, hsalt,
+                          phi_r, ushear, Zrh) +
+                 (*funcd)(b, es, Wind, AirDens, ZO, EactAir, F, hsalt,
+                          phi_r, ushear, Zrh)));
     }
     else {
         for (it = 1, j = 1; j < n - 1; j++) {
@@ -402,8 +403,7 @@ trapzd(double (*funcd)(),
                 (*funcd)(x, es, Wind, AirDens, ZO, EactAir, F, hsalt, phi_r,
                          ushear, Zrh);
         }
-        s = 0.5 * (s + (b - a) * sum / tnm);
-        return s;
+        return (0.5 * (s + (b - a) * sum / tnm));
     }
 }
 
@@ -774,19 +774,36 @@ CalcSubFlux(double  EactAir,
             SubFlux = phi_s * psi_s * hsalt;
 
             // Suspension layer must be integrated
-            SubFlux += qromb(sub_with_height, es, U10, AirDens, Zo_salt,
-                             EactAir, F, hsalt,
-                             phi_s, ushear, Zrh, hsalt, ztop);
+            if (options.BLOWING_FAST) {
+                SubFlux += gauss_log_integral(sub_with_height, es, U10,
+                                              AirDens, Zo_salt, EactAir, F,
+                                              hsalt, phi_s, ushear, Zrh,
+                                              hsalt, ztop);
+            }
+            else {
+                SubFlux += qromb(sub_with_height, es, U10, AirDens, Zo_salt,
+                                 EactAir, F, hsalt,
+                                 phi_s, ushear, Zrh, hsalt, ztop);
+            }
         }
 
         // Transport out of the domain by saltation Qs(fe) (kg/m*s), eq 10 Liston and Sturm
         saltation_transport = Qsalt * (1 - exp(-3. * fe / 500.));
 
         // Transport in the suspension layer
-        suspension_transport = qromb(transport_with_height, es, U10, AirDens,
-                                     Zo_salt,
-                                     EactAir, F, hsalt, phi_s, ushear, Zrh,
-                                     hsalt, ztop);
+        if (options.BLOWING_FAST &&
+            fabs(1. - param.BLOWING_SETTLING / (CONST_KARMAN * ushear)) >
+            BLOWING_FAST_MIN_EXP) {
+            suspension_transport = transport_integral(U10, Zo_salt, hsalt,
+                                                      phi_s, ushear, hsalt,
+                                                      ztop);
+        }
+        else {
+            suspension_transport = qromb(transport_with_height, es, U10,
+                                         AirDens, Zo_salt,
+                                         EactAir, F, hsalt, phi_s, ushear,
+                                         Zrh, hsalt, ztop);
+        }
 
         // Transport at the downstream edge of the fetch in kg/m*s
         *Transport = (suspension_transport + saltation_transport);
@@ -838,3 +855,104 @@ transport_with_height(double z,
 
     return u_z * phi_t;
 }
+
+/******************************************************************************
+ * @brief    Integrate the transport rate of transport_with_height between a
+ *           and b in closed form.
+ *
+ * @details  The integrand is the logarithmic wind profile times the
+ *           concentration of Kind (1992), u* / k * ln(z / ZO) * phi_r *
+ *           ((T + 1) * (z / hsalt)^e - T), with e = -settling / (k * u*).
+ *           Both terms have the antiderivative z^m / m * (ln(z / ZO) - 1 / m),
+ *           with m = e + 1 and m = 1. The caller has to make sure that e is
+ *           not close to -1, where that form loses its precision.
+ *****************************************************************************/
+double
+transport_integral(double Wind,
+                   double ZO,
+                   double hsalt,
+                   double phi_r,
+                   double ushear,
+                   double a,
+                   double b)
+{
+    extern parameters_struct param;
+
+    double                   temp;
+    double                   m;
+    double                   za;
+    double                   zb;
+
+    temp = (0.5 * ushear * ushear) / (Wind * param.BLOWING_SETTLING);
+    m = 1. - param.BLOWING_SETTLING / (CONST_KARMAN * ushear);
+
+    // (z / hsalt)^e * z is the integrated power of z, scaled by hsalt^-e
+    za = pow(a / hsalt, m - 1.) * a / m * (log(a / ZO) - 1. / m);
+    zb = pow(b / hsalt, m - 1.) * b / m * (log(b / ZO) - 1. / m);
+
+    return ushear / CONST_KARMAN * phi_r *
+           ((temp + 1.) * (zb - za) -
+            temp * (b * (log(b / ZO) - 1.) - a * (log(a / ZO) - 1.)));
+}
+
+/******************************************************************************
+ * @brief    Integrate funcd between a and b by composite Gauss-Legendre
+ *           quadrature in ln(z).
+ *
+ * @details  The profiles of the suspension layer vary smoothly in ln(z), so
+ *           BLOWING_FAST_PANELS panels of the 8 point rule in ln(z) replace
+ *           the Romberg integration of qromb, which refines to DBL_EPSILON.
+ *****************************************************************************/
+double
+gauss_log_integral(double (*funcd)(),
+                   double   es,
+                   double   Wind,
+                   double   AirDens,
+                   double   ZO,
+                   double   EactAir,
+                   double   F,
+                   double   hsalt,
+                   double   phi_r,
+                   double   ushear,
+                   double   Zrh,
+                   double   a,
+                   double   b)
+{
+    // 8 point Gauss-Legendre nodes and weights on [-1, 1]
+    static const double xg[4] = {
+        0.1834346424956498, 0.5255324099163290,
+        0.7966664774136267, 0.9602898564975363
+    };
+    static const double wg[4] = {
+        0.3626837833783620, 0.3137066458778873,
+        0.2223810344533745, 0.1012285362903763
+    };
+    double              half;
+    double              mid;
+    double              z;
+    double              sum;
+    int                 p;
+    int                 j;
+
+    if (b <= a) {
+        return 0.;
+    }
+
+    half = 0.5 * log(b / a) / BLOWING_FAST_PANELS;
+    sum = 0.;
+    for (p = 0; p < BLOWING_FAST_PANELS; p++) {
+        mid = log(a) + (2 * p + 1) * half;
+        for (j = 0; j < 4; j++) {
+            z = exp(mid - half * xg[j]);
+            sum += wg[j] * z *
+                   (*funcd)(z, es, Wind, AirDens, ZO, EactAir, F, hsalt,
+                            phi_r, ushear, Zrh);
+            z = exp(mid + half * xg[j]);
+            sum += wg[j] * z *
+                   (*funcd)(z, es, Wind, AirDens, ZO, EactAir, F, hsalt,
+                            phi_r, ushear, Zrh);
+        }
+    }
+
+    return sum * half;
+}
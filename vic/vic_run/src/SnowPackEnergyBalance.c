@@ -27,142 +27,36 @@
 #include <vic_run.h>
 
 /******************************************************************************
- * @brief    Calculate the surface energy balance for the snow pack.
+ * @brief    Calculate the surface energy balance for the snow pack from the
+ *           arguments in a snow_pack_energy_bal_args_struct.
+ * @details  Only the terms that depend on the surface temperature are
+ *           computed here, the others are set once per solution by
+ *           set_snow_pack_energy_bal_terms().
  *****************************************************************************/
 double
-SnowPackEnergyBalance(double  TSurf,
-                      va_list ap)
+SnowPackEnergyBalance_ctx(double TSurf,
+                          void  *ctx)
 {
-    extern option_struct     options;
-    extern parameters_struct param;
-
-    /* Define Variable Argument List */
-
-    /* General Model Parameters */
-    double  Dt;                   /* Model time step (sec) */
-    double  Ra;                   /* Aerodynamic resistance (s/m) */
-    double *Ra_used;              /* Aerodynamic resistance (s/m) after stability correction */
+    extern option_struct              options;
+    extern parameters_struct          param;
 
-    /* Vegetation Parameters */
-    double  Z;                    /* Reference height (m) */
-    double *Z0;                    /* surface roughness height (m) */
-
-    /* Atmospheric Forcing Variables */
-    double  AirDens;              /* Density of air (kg/m3) */
-    double  EactAir;              /* Actual vapor pressure of air (Pa) */
-    double  LongSnowIn;            /* Incoming longwave radiation (W/m2) */
-    double  Lv;                   /* Latent heat of vaporization (J/kg3) */
-    double  Press;                /* Air pressure (Pa) */
-    double  Rain;                 /* Rain fall (m/timestep) */
-    double  NetShortUnder;        /* Net incident shortwave radiation
-                                     (W/m2) */
-    double  Vpd;                  /* Vapor pressure deficit (Pa) */
-    double  Wind;                 /* Wind speed (m/s) */
-
-    /* Snowpack Variables */
-    double  OldTSurf;             /* Surface temperature during previous time
-                                     step */
-    double  SnowCoverFract;       /* Fraction of area covered by snow */
-    double  SnowDepth;            /* Depth of snowpack (m) */
-    double  SnowDensity;          /* Density of snowpack (kg/m^3) */
-    double  SurfaceLiquidWater;   /* Liquid water in the surface layer (m) */
-    double  SweSurfaceLayer;      /* Snow water equivalent in surface layer
-                                     (m) */
-
-    /* Energy Balance Components */
-    double  Tair;                 /* Canopy air / Air temperature (C) */
-    double  TGrnd;                /* Ground surface temperature (C) */
-
-    double *AdvectedEnergy;       /* Energy advected by precipitation (W/m2) */
-    double *AdvectedSensibleHeat; /* Sensible heat advected from snow-free
-                                     area into snow covered area (W/m^2) */
-    double *DeltaColdContent;     /* Change in cold content of surface
-                                     layer (W/m2) */
-    double *GroundFlux;           /* Ground Heat Flux (W/m2) */
-    double *LatentHeat;           /* Latent heat exchange at surface (W/m2) */
-    double *LatentHeatSub; /* Latent heat of sublimation exchange at
-                                      surface (W/m2) */
-    double *NetLongUnder;         /* Net longwave radiation at snowpack
-                                     surface (W/m^2) */
-    double *RefreezeEnergy;       /* Refreeze energy (W/m2) */
-    double *SensibleHeat;         /* Sensible heat exchange at surface
-                                     (W/m2) */
-    double *vapor_flux;           /* Mass flux of water vapor to or from the
-                                     intercepted snow (m/timestep) */
-    double *blowing_flux;         /* Mass flux of water vapor from blowing snow. (m/timestep) */
-    double *surface_flux;         /* Mass flux of water vapor from pack snow. (m/timestep) */
+    snow_pack_energy_bal_args_struct *args;
 
     /* Internal Routine Variables */
 
-    double Density;               /* Density of water/ice at TMean (kg/m3) */
-    double NetRad;                /* Net radiation exchange at surface
-                                     (W/m2) */
-    double RestTerm;              /* Rest term in surface energy balance
-                                     (W/m2) */
-    double TMean;                 /* Average temperature for time step (C) */
-    double Tmp;
-    double VaporMassFlux;         /* Mass flux of water vapor to or from the
-                                     intercepted snow (kg/m2s) */
-    double BlowingMassFlux;       /* Mass flux of water vapor from blowing snow. (kg/m2s) */
-    double SurfaceMassFlux;       /* Mass flux of water vapor from pack snow. (kg/m2s) */
+    double                            Density; /* Density of water/ice at TMean (kg/m3) */
+    double                            NetRad; /* Net radiation exchange at surface
+                                                 (W/m2) */
+    double                            RestTerm; /* Rest term in surface energy balance
+                                                   (W/m2) */
+    double                            TMean; /* Average temperature for time step (C) */
+    double                            Tmp;
+    double                            VaporMassFlux; /* Mass flux of water vapor to or from the
+                                                        intercepted snow (kg/m2s) */
+    double                            BlowingMassFlux; /* Mass flux of water vapor from blowing snow. (kg/m2s) */
+    double                            SurfaceMassFlux; /* Mass flux of water vapor from pack snow. (kg/m2s) */
 
-    /* Assign the elements of the array to the appropriate variables.  The list
-       is traversed as if the elements are doubles, because:
-
-       In the variable-length part of variable-length argument lists, the old
-       ``default argument promotions'' apply: arguments of type double are
-       always promoted (widened) to type double, and types char and short int
-       are promoted to int. Therefore, it is never correct to invoke
-       va_arg(argp, double); instead you should always use va_arg(argp,
-       double).
-
-       (quoted from the comp.lang.c FAQ list)
-     */
-
-    /* General Model Parameters */
-    Dt = (double) va_arg(ap, double);
-    Ra = (double) va_arg(ap, double);
-    Ra_used = (double *) va_arg(ap, double *);
-
-    /* Vegetation Parameters */
-    Z = (double) va_arg(ap, double);
-    Z0 = (double *) va_arg(ap, double *);
-
-    /* Atmospheric Forcing Variables */
-    AirDens = (double) va_arg(ap, double);
-    EactAir = (double) va_arg(ap, double);
-    LongSnowIn = (double) va_arg(ap, double);
-    Lv = (double) va_arg(ap, double);
-    Press = (double) va_arg(ap, double);
-    Rain = (double) va_arg(ap, double);
-    NetShortUnder = (double) va_arg(ap, double);
-    Vpd = (double) va_arg(ap, double);
-    Wind = (double) va_arg(ap, double);
-
-    /* Snowpack Variables */
-    OldTSurf = (double) va_arg(ap, double);
-    SnowCoverFract = (double) va_arg(ap, double);
-    SnowDepth = (double) va_arg(ap, double);
-    SnowDensity = (double) va_arg(ap, double);
-    SurfaceLiquidWater = (double) va_arg(ap, double);
-    SweSurfaceLayer = (double) va_arg(ap, double);
-
-    /* Energy Balance Components */
-    Tair = (double) va_arg(ap, double);
-    TGrnd = (double) va_arg(ap, double);
-
-    AdvectedEnergy = (double *) va_arg(ap, double *);
-    AdvectedSensibleHeat = (double *)va_arg(ap, double *);
-    DeltaColdContent = (double *) va_arg(ap, double *);
-    GroundFlux = (double *) va_arg(ap, double *);
-    LatentHeat = (double *) va_arg(ap, double *);
-    LatentHeatSub = (double *) va_arg(ap, double *);
-    NetLongUnder = (double *) va_arg(ap, double *);
-    RefreezeEnergy = (double *) va_arg(ap, double *);
-    SensibleHeat = (double *) va_arg(ap, double *);
-    vapor_flux = (double *) va_arg(ap, double *);
-    blowing_flux = (double *) va_arg(ap, double *);
-    surface_flux = (double *) va_arg(ap, double *);
+    args = (snow_pack_energy_bal_args_struct *) ctx;
 
     /* Calculate active temp for energy balance as average of old and new  */
 
@@ -179,101 +73,200 @@ SnowPackEnergyBalance(double  TSurf,
        reference level */
 
 
-    if (Wind > 0.0) {
-        Ra_used[0] = Ra / StabilityCorrection(Z, 0.f, TMean, Tair, Wind, Z0[2]);
+    if (args->Wind > 0.0) {
+        args->Ra_used[0] = args->Ra / StabilityCorrection_coef(TMean,
+                                                               args->Tair,
+                                                               args->Wind,
+                                                               args->stab);
     }
     else {
-        Ra_used[0] = param.HUGE_RESIST;
+        args->Ra_used[0] = param.HUGE_RESIST;
     }
 
     /* Calculate longwave exchange and net radiation */
 
     Tmp = TMean + CONST_TKFRZ;
-    (*NetLongUnder) = LongSnowIn - calc_outgoing_longwave(Tmp,
-                                                          param.EMISS_SNOW);
-    NetRad = NetShortUnder + (*NetLongUnder);
+    (*args->NetLongUnder) = args->LongSnowIn -
+                            calc_outgoing_longwave(Tmp, param.EMISS_SNOW);
+    NetRad = args->NetShortUnder + (*args->NetLongUnder);
 
     /* Calculate the sensible heat flux */
 
-    *SensibleHeat = calc_sensible_heat(AirDens, Tair, TMean, Ra_used[0]);
+    *args->SensibleHeat = calc_sensible_heat(args->AirDens, args->Tair, TMean,
+                                             args->Ra_used[0]);
 
     if (options.SPATIAL_SNOW) {
         /* Add in Sensible heat flux turbulent exchange from surrounding
            snow free patches - if present */
-        if (SnowCoverFract > 0.) {
-            *(AdvectedSensibleHeat) = advected_sensible_heat(SnowCoverFract,
-                                                             AirDens, Tair,
-                                                             TGrnd,
-                                                             Ra_used[0]);
+        if (args->SnowCoverFract > 0.) {
+            *(args->AdvectedSensibleHeat) = advected_sensible_heat(
+                args->SnowCoverFract, args->AirDens, args->Tair, args->TGrnd,
+                args->Ra_used[0]);
         }
         else {
-            (*AdvectedSensibleHeat) = 0.;
+            (*args->AdvectedSensibleHeat) = 0.;
         }
     }
     else {
-        (*AdvectedSensibleHeat) = 0.;
+        (*args->AdvectedSensibleHeat) = 0.;
     }
 
     /* Convert sublimation terms from m/timestep to kg/m2s */
-    VaporMassFlux = *vapor_flux * Density / Dt;
-    BlowingMassFlux = *blowing_flux * Density / Dt;
-    SurfaceMassFlux = *surface_flux * Density / Dt;
+    VaporMassFlux = *args->vapor_flux * Density / args->Dt;
+    BlowingMassFlux = *args->blowing_flux * Density / args->Dt;
+    SurfaceMassFlux = *args->surface_flux * Density / args->Dt;
 
     /* Calculate the mass flux of ice to or from the surface layer */
 
     /* Calculate the saturated vapor pressure in the snow pack,
        (Equation 3.32, Bras 1990) */
 
-    latent_heat_from_snow(AirDens, EactAir, Lv, Press, Ra_used[0], TMean, Vpd,
-                          LatentHeat, LatentHeatSub, &VaporMassFlux,
-                          &BlowingMassFlux,
-                          &SurfaceMassFlux);
+    latent_heat_from_snow(args->AirDens, args->EactAir, args->Lv, args->Press,
+                          args->Ra_used[0], TMean, args->Vpd,
+                          args->LatentHeat, args->LatentHeatSub,
+                          &VaporMassFlux, &BlowingMassFlux, &SurfaceMassFlux);
 
     /* Convert sublimation terms from kg/m2s to m/timestep */
-    *vapor_flux = VaporMassFlux * Dt / Density;
-    *blowing_flux = BlowingMassFlux * Dt / Density;
-    *surface_flux = SurfaceMassFlux * Dt / Density;
+    *args->vapor_flux = VaporMassFlux * args->Dt / Density;
+    *args->blowing_flux = BlowingMassFlux * args->Dt / Density;
+    *args->surface_flux = SurfaceMassFlux * args->Dt / Density;
 
     /* Calculate advected heat flux from rain
        Equation 7.3.12 from H.B.H. for rain falling on melting snowpack */
 
     if (TMean == 0.) {
-        *AdvectedEnergy = (CONST_CPFW * CONST_RHOFW * (Tair) * Rain) / (Dt);
+        *args->AdvectedEnergy = args->AdvectedEnergyMelt;
     }
     else {
-        *AdvectedEnergy = 0.;
+        *args->AdvectedEnergy = 0.;
     }
 
     /* Calculate change in cold content */
-    *DeltaColdContent = CONST_VCPICE_WQ * SweSurfaceLayer *
-                        (TSurf - OldTSurf) / (Dt);
+    *args->DeltaColdContent = args->ColdContentCoef *
+                              (TSurf - args->OldTSurf) / (args->Dt);
 
     /* Calculate Ground Heat Flux */
-    if (SnowDepth > 0.) {
-        *GroundFlux = 2.9302e-6 * SnowDensity * SnowDensity *
-                      (TGrnd - TMean) / SnowDepth / (Dt);
+    if (args->SnowDepth > 0.) {
+        *args->GroundFlux = args->GroundFluxCoef * (args->TGrnd - TMean) /
+                            args->SnowDepth / (args->Dt);
     }
     else {
-        *GroundFlux = 0;
+        *args->GroundFlux = 0;
     }
-    *DeltaColdContent -= *GroundFlux;
+    *args->DeltaColdContent -= *args->GroundFlux;
 
     /* Calculate energy balance error at the snowpack surface */
-    RestTerm = NetRad + *SensibleHeat + *LatentHeat + *LatentHeatSub +
-               *AdvectedEnergy + *GroundFlux - *DeltaColdContent +
-               *AdvectedSensibleHeat;
+    RestTerm = NetRad + *args->SensibleHeat + *args->LatentHeat +
+               *args->LatentHeatSub + *args->AdvectedEnergy +
+               *args->GroundFlux - *args->DeltaColdContent +
+               *args->AdvectedSensibleHeat;
 
-    *RefreezeEnergy = (SurfaceLiquidWater * CONST_LATICE * Density) / (Dt);
+    *args->RefreezeEnergy = args->RefreezeEnergyMax;
 
-    if (TSurf == 0.0 && RestTerm > -(*RefreezeEnergy)) {
-        *RefreezeEnergy = -RestTerm; /* available energy input over cold content
-                                        used to melt, i.e. Qrf is negative value
-                                        (energy out of pack)*/
+    if (TSurf == 0.0 && RestTerm > -(*args->RefreezeEnergy)) {
+        *args->RefreezeEnergy = -RestTerm; /* available energy input over cold content
+                                              used to melt, i.e. Qrf is negative value
+                                              (energy out of pack)*/
         RestTerm = 0.0;
     }
     else {
-        RestTerm += *RefreezeEnergy; /* add this positive value to the pack */
+        RestTerm += *args->RefreezeEnergy; /* add this positive value to the pack */
     }
 
     return RestTerm;
 }
+
+/******************************************************************************
+ * @brief    Set the terms of the snow pack energy balance residual that do not
+ *           depend on the surface temperature.
+ *****************************************************************************/
+void
+set_snow_pack_energy_bal_terms(snow_pack_energy_bal_args_struct *args)
+{
+    /* advected heat flux from rain on a melting snowpack */
+    args->AdvectedEnergyMelt = (CONST_CPFW * CONST_RHOFW * (args->Tair) *
+                                args->Rain) / (args->Dt);
+
+    /* cold content of the surface layer per degree */
+    args->ColdContentCoef = CONST_VCPICE_WQ * args->SweSurfaceLayer;
+
+    /* conductance of the snowpack for the ground heat flux */
+    args->GroundFluxCoef = 2.9302e-6 * args->SnowDensity * args->SnowDensity;
+
+    /* energy released if all liquid water in the surface layer refreezes */
+    args->RefreezeEnergyMax = (args->SurfaceLiquidWater * CONST_LATICE *
+                               CONST_RHOFW) / (args->Dt);
+}
+
+/******************************************************************************
+ * @brief    Calculate the surface energy balance for the snow pack from a
+ *           variable argument list, in the order of the
+ *           snow_pack_energy_bal_args_struct members.
+ *****************************************************************************/
+double
+SnowPackEnergyBalance(double  TSurf,
+                      va_list ap)
+{
+    snow_pack_energy_bal_args_struct args;
+
+    /* Assign the elements of the array to the appropriate variables.  The list
+       is traversed as if the elements are doubles, because:
+
+       In the variable-length part of variable-length argument lists, the old
+       ``default argument promotions'' apply: arguments of type double are
+       always promoted (widened) to type double, and types char and short int
+       are promoted to int. Therefore, it is never correct to invoke
+       va_arg(argp, double); instead you should always use va_arg(argp,
+       double).
+
+       (quoted from the comp.lang.c FAQ list)
+     */
+
+    /* General Model Parameters */
+    args.Dt = (double) va_arg(ap, double);
+    args.Ra = (double) va_arg(ap, double);
+    args.Ra_used = (double *) va_arg(ap, double *);
+
+    /* Vegetation Parameters */
+    args.stab = (stability_coef_struct *) va_arg(ap, stability_coef_struct *);
+
+    /* Atmospheric Forcing Variables */
+    args.AirDens = (double) va_arg(ap, double);
+    args.EactAir = (double) va_arg(ap, double);
+    args.LongSnowIn = (double) va_arg(ap, double);
+    args.Lv = (double) va_arg(ap, double);
+    args.Press = (double) va_arg(ap, double);
+    args.Rain = (double) va_arg(ap, double);
+    args.NetShortUnder = (double) va_arg(ap, double);
+    args.Vpd = (double) va_arg(ap, double);
+    args.Wind = (double) va_arg(ap, double);
+
+    /* Snowpack Variables */
+    args.OldTSurf = (double) va_arg(ap, double);
+    args.SnowCoverFract = (double) va_arg(ap, double);
+    args.SnowDepth = (double) va_arg(ap, double);
+    args.SnowDensity = (double) va_arg(ap, double);
+    args.SurfaceLiquidWater = (double) va_arg(ap, double);
+    args.SweSurfaceLayer = (double) va_arg(ap, double);
+
+    /* Energy Balance Components */
+    args.Tair = (double) va_arg(ap, double);
+    args.TGrnd = (double) va_arg(ap, double);
+
+    args.AdvectedEnergy = (double *) va_arg(ap, double *);
+    args.AdvectedSensibleHeat = (double *)va_arg(ap, double *);
+    args.DeltaColdContent = (double *) va_arg(ap, double *);
+    args.GroundFlux = (double *) va_arg(ap, double *);
+    args.LatentHeat = (double *) va_arg(ap, double *);
+    args.LatentHeatSub = (double *) va_arg(ap, double *);
+    args.NetLongUnder = (double *) va_arg(ap, double *);
+    args.RefreezeEnergy = (double *) va_arg(ap, double *);
+    args.SensibleHeat = (double *) va_arg(ap, double *);
+    args.vapor_flux = (double *) va_arg(ap, double *);
+    args.blowing_flux = (double *) va_arg(ap, double *);
+    args.surface_flux = (double *) va_arg(ap, double *);
+
+    set_snow_pack_energy_bal_terms(&args);
+
+    return SnowPackEnergyBalance_ctx(TSurf, &args);
+}
@@ -26,17 +26,29 @@
 
 #include <vic_run.h>
 
+/******************************************************************************
+ * @brief    Compute the terms of the atmospheric stability correction that
+ *           depend only on the reference height, displacement and roughness.
+ *****************************************************************************/
+void
+set_stability_coef(double                 Z,
+                   double                 d,
+                   double                 Z0,
+                   stability_coef_struct *coef)
+{
+    coef->Z_d = Z - d;
+    coef->log_Z_d_Z0 = log((Z - d) / Z0) + 5;
+}
+
 /******************************************************************************
  * @brief    Calculate atmospheric stability correction for non-neutral
- *           conditions
+ *           conditions from the terms of set_stability_coef.
  *****************************************************************************/
 double
-StabilityCorrection(double Z,
-                    double d,
-                    double TSurf,
-                    double Tair,
-                    double Wind,
-                    double Z0)
+StabilityCorrection_coef(double                 TSurf,
+                         double                 Tair,
+                         double                 Wind,
+                         stability_coef_struct *coef)
 {
     double Correction;          /* Correction to aerodynamic resistance */
     double Ri;                   /* Richardson's Number */
@@ -51,14 +63,14 @@ StabilityCorrection(double Z,
     if (TSurf != Tair) {
         /* Non-neutral conditions */
 
-        Ri = CONST_G * (Tair - TSurf) * (Z - d) /
+        Ri = CONST_G * (Tair - TSurf) * coef->Z_d /
              (((Tair +
                 CONST_TKFRZ) + (TSurf + CONST_TKFRZ)) / 2.0 * Wind * Wind);
 
         RiLimit = (Tair + CONST_TKFRZ) /
                   (((Tair +
                      CONST_TKFRZ) +
-                    (TSurf + CONST_TKFRZ)) / 2.0 * (log((Z - d) / Z0) + 5));
+                    (TSurf + CONST_TKFRZ)) / 2.0 * coef->log_Z_d_Z0);
 
         if (Ri > RiLimit) {
             Ri = RiLimit;
@@ -78,3 +90,22 @@ StabilityCorrection(double Z,
 
     return Correction;
 }
+
+/******************************************************************************
+ * @brief    Calculate atmospheric stability correction for non-neutral
+ *           conditions
+ *****************************************************************************/
+double
+StabilityCorrection(double Z,
+                    double d,
+                    double TSurf,
+                    double Tair,
+                    double Wind,
+                    double Z0)
+{
+    stability_coef_struct coef;
+
+    set_stability_coef(Z, d, Z0, &coef);
+
+    return StabilityCorrection_coef(TSurf, Tair, Wind, &coef);
+}
@@ -100,3 +100,152 @@ free_3d_double(size_t   *shape,
     }
     free(array);
 }
+
+/******************************************************************************
+ * @brief    Allocate zeroed memory for n items of a size on the scratch arena
+ *           of the thread.
+ * @details  The memory is valid until it is taken back by scratch_release()
+ *           or scratch_reset(), and must not be freed. A request that does
+ *           not fit in the block in use moves on to the next block, which is
+ *           allocated at least twice as large as the last one.
+ *****************************************************************************/
+void *
+scratch_calloc(size_t n,
+               size_t size)
+{
+    scratch_block_struct *block;
+    size_t                nbytes;
+    size_t                offset;
+    size_t                new_size;
+    void                 *ptr;
+
+    nbytes = n * size;
+    if (nbytes == 0) {
+        nbytes = 1;
+    }
+
+    for (;; ) {
+        if (vic_scratch.block < vic_scratch.nblocks) {
+            block = &(vic_scratch.blocks[vic_scratch.block]);
+            offset = (vic_scratch.offset + SCRATCH_ALIGN - 1) /
+                     SCRATCH_ALIGN * SCRATCH_ALIGN;
+            if (offset + nbytes <= block->size) {
+                vic_scratch.offset = offset + nbytes;
+                ptr = block->data + offset;
+                memset(ptr, 0, nbytes);
+                return ptr;
+            }
+            if (vic_scratch.block + 1 < vic_scratch.nblocks) {
+                vic_scratch.block++;
+                vic_scratch.offset = 0;
+                continue;
+            }
+        }
+
+        // a new block
+        new_size = SCRATCH_BLOCK_SIZE;
+        if (vic_scratch.nblocks > 0) {
+            new_size = 2 * vic_scratch.blocks[vic_scratch.nblocks - 1].size;
+        }
+        while (new_size < nbytes) {
+            new_size *= 2;
+        }
+        vic_scratch.blocks = realloc(vic_scratch.blocks,
+                                     (vic_scratch.nblocks + 1) *
+                                     sizeof(*(vic_scratch.blocks)));
+        check_alloc_status(vic_scratch.blocks, "Memory allocation error.");
+        block = &(vic_scratch.blocks[vic_scratch.nblocks]);
+        block->data = malloc(new_size);
+        check_alloc_status(block->data, "Memory allocation error.");
+        block->size = new_size;
+        vic_scratch.block = vic_scratch.nblocks;
+        vic_scratch.offset = 0;
+        vic_scratch.nblocks++;
+    }
+}
+
+/******************************************************************************
+ * @brief    Allocate a 2-dimensional double array on the scratch arena.
+ *****************************************************************************/
+double **
+scratch_2d_double(size_t *shape)
+{
+    double **array;
+    size_t   i;
+
+    array = scratch_calloc(shape[0], sizeof(*array));
+    for (i = 0; i < shape[0]; i++) {
+        array[i] = scratch_calloc(shape[1], sizeof(*(array[i])));
+    }
+
+    return array;
+}
+
+/******************************************************************************
+ * @brief    Allocate a 3-dimensional double array on the scratch arena.
+ *****************************************************************************/
+double ***
+scratch_3d_double(size_t *shape)
+{
+    double ***array;
+    size_t    i;
+
+    array = scratch_calloc(shape[0], sizeof(*array));
+    for (i = 0; i < shape[0]; i++) {
+        array[i] = scratch_2d_double(&(shape[1]));
+    }
+
+    return array;
+}
+
+/******************************************************************************
+ * @brief    Position of the scratch arena, to take back the memory allocated
+ *           after it with scratch_release().
+ *****************************************************************************/
+scratch_mark_struct
+scratch_mark(void)
+{
+    scratch_mark_struct mark;
+
+    mark.block = vic_scratch.block;
+    mark.offset = vic_scratch.offset;
+
+    return mark;
+}
+
+/******************************************************************************
+ * @brief    Take back the scratch memory allocated after a mark.
+ *****************************************************************************/
+void
+scratch_release(scratch_mark_struct mark)
+{
+    vic_scratch.block = mark.block;
+    vic_scratch.offset = mark.offset;
+}
+
+/******************************************************************************
+ * @brief    Take back all scratch memory of the thread.
+ *****************************************************************************/
+void
+scratch_reset(void)
+{
+    vic_scratch.block = 0;
+    vic_scratch.offset = 0;
+}
+
+/******************************************************************************
+ * @brief    Free the blocks of the scratch arena of the thread.
+ *****************************************************************************/
+void
+free_scratch_arena(void)
+{
+    size_t i;
+
+    for (i = 0; i < vic_scratch.nblocks; i++) {
+        free(vic_scratch.blocks[i].data);
+    }
+    free(vic_scratch.blocks);
+    vic_scratch.blocks = NULL;
+    vic_scratch.nblocks = 0;
+    scratch_reset();
+}
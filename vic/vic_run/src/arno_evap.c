@@ -55,14 +55,14 @@ arno_evap(layer_data_struct *layer,
     int                      num_term;
     int                      i;
     size_t                   frost_area;
-    double                   tmp, beta_asp, dummy;
-    double                   ratio, as;
-    double                   Epot; /* potential bare soil evaporation */
-    double                   moist;
-    double                   evap;
-    double                   max_infil;
+    vic_real                 tmp, beta_asp, dummy;
+    vic_real                 ratio, as;
+    vic_real                 Epot; /* potential bare soil evaporation */
+    vic_real                 moist;
+    vic_real                 evap;
+    vic_real                 max_infil;
     double                   Evap;
-    double                   tmpsum;
+    vic_real                 tmpsum;
 
     Evap = 0;
 
@@ -98,10 +98,27 @@ calc_atmos_energy_bal(double    InOverSensible,
         T_lower = (Tair) - param.CANOPY_DT;
         T_upper = (Tair) + param.CANOPY_DT;
 
-        // iterate for canopy air temperature
-        Tcanopy = root_brent(T_lower, T_upper,
-                             func_atmos_energy_bal, Ra, Tair, atmos_density,
-                             InSensible, SensibleHeat);
+        if (options.TSURF_NEWTON) {
+            // the balance is linear in the canopy air temperature, a Newton
+            // step from Tair with the exact derivative is the root
+            Tcanopy = Tair - InSensible * Ra / (CONST_CPMAIR * atmos_density);
+            if (Tcanopy < T_lower - param.ROOT_BRENT_MAXTRIES *
+                param.ROOT_BRENT_TSTEP ||
+                Tcanopy > T_upper + param.ROOT_BRENT_MAXTRIES *
+                param.ROOT_BRENT_TSTEP) {
+                // outside of the range searched by root_brent, which fails
+                // in the same way
+                Tcanopy = root_brent(T_lower, T_upper,
+                                     func_atmos_energy_bal, Ra, Tair,
+                                     atmos_density, InSensible, SensibleHeat);
+            }
+        }
+        else {
+            // iterate for canopy air temperature
+            Tcanopy = root_brent(T_lower, T_upper,
+                                 func_atmos_energy_bal, Ra, Tair,
+                                 atmos_density, InSensible, SensibleHeat);
+        }
 
         if (Tcanopy <= -998) {
             if (options.TFALLBACK) {
@@ -157,9 +174,16 @@ double
 error_calc_atmos_energy_bal(double Tcanopy,
                             ...)
 {
-    va_list ap;
+    va_list       ap;
 
-    double  error;
+    double        error;
+    static size_t dump_count = 0;
+
+    // the variable values are only dumped for the first LOG_WARN_REPEAT
+    // failures, later failures return at once
+    if (!count_log_repeat(&dump_count, __FILE__, __LINE__)) {
+        return(ERROR);
+    }
 
     va_start(ap, Tcanopy);
     error = error_print_atmos_energy_bal(Tcanopy, ap);
@@ -78,6 +78,7 @@ calc_surf_energy_bal(double             Le,
                      unsigned short     iveg,
                      int                overstory,
                      unsigned short     veg_class,
+                     veg_lib_struct    *veg_lib,
                      double            *CanopLayerBnd,
                      double            *dryFrac,
                      force_data_struct *force,
@@ -91,7 +92,8 @@ calc_surf_energy_bal(double             Le,
     extern option_struct     options;
     extern parameters_struct param;
 
-    int                      FIRST_SOLN[2];
+    soil_thermal_struct      soil_thermal;
+    surf_energy_bal_args_struct surf_args;
     int                      VEG;
     int                      i;
     size_t                   nidx;
@@ -178,7 +180,7 @@ calc_surf_energy_bal(double             Le,
     T2 = soil_con->avg_temp;                // soil temperature at very deep depth (>> dp; *NOT* at depth D2)
     Ts_old = energy->T[0];            // previous surface temperature
     /* Compute previous temperature at boundary between first and second layers */
-    if (options.QUICK_FLUX || !options.EXP_TRANS) {
+    if (OPT_QUICK_FLUX || !options.EXP_TRANS) {
         // T[1] is defined to be the temperature at the boundary between first and second layers
         T1_old = energy->T[1];
     }
@@ -204,7 +206,7 @@ calc_surf_energy_bal(double             Le,
     atmos_density = force->density[hidx];     // atmospheric density
     atmos_pressure = force->pressure[hidx];    // atmospheric pressure
     atmos_shortwave = force->shortwave[hidx];   // incoming shortwave radiation
-    if (options.CARBON) {
+    if (OPT_CARBON) {
         atmos_Catm = force->Catm[hidx];        // CO2 mixing ratio
     }
     else {
@@ -217,8 +219,8 @@ calc_surf_energy_bal(double             Le,
     expt = soil_con->expt[0];
     Tsnow_surf = snow->surf_temp;
     Wdew = veg_var->Wdew;
-    FIRST_SOLN[0] = true;
-    FIRST_SOLN[1] = true;
+    soil_thermal.FIRST_SOLN[0] = true;
+    soil_thermal.FIRST_SOLN[1] = true;
     if (snow->depth > 0.) {
         kappa_snow = param.SNOW_CONDUCT * (snow->density) *
                      (snow->density) / snow_depth;
@@ -260,10 +262,113 @@ calc_surf_energy_bal(double             Le,
     Zsum_node = soil_con->Zsum_node;
     ice_node = energy->ice;
 
+    /*************************************************************
+       Arguments of the surface energy balance residual, the number
+       of soil nodes is set for each solution
+    *************************************************************/
+    surf_args.VEG = VEG;
+    surf_args.veg_class = veg_class;
+    surf_args.veg_lib = veg_lib;
+    surf_args.delta_t = delta_t;
+    surf_args.Cs1 = Cs1;
+    surf_args.Cs2 = Cs2;
+    surf_args.D1 = D1;
+    surf_args.D2 = D2;
+    surf_args.T1_old = T1_old;
+    surf_args.T2 = T2;
+    surf_args.Ts_old = Ts_old;
+    surf_args.Told_node = energy->T;
+    surf_args.bubble = bubble;
+    surf_args.dp = dp;
+    surf_args.expt = expt;
+    surf_args.ice0 = ice0;
+    surf_args.kappa1 = kappa1;
+    surf_args.kappa2 = kappa2;
+    surf_args.max_moist = max_moist;
+    surf_args.moist = moist;
+    surf_args.root = root;
+    surf_args.CanopLayerBnd = CanopLayerBnd;
+    surf_args.UnderStory = UnderStory;
+    surf_args.overstory = overstory;
+    surf_args.NetShortBare = NetShortBare;
+    surf_args.NetShortGrnd = NetShortGrnd;
+    surf_args.NetShortSnow = TmpNetShortSnow;
+    surf_args.Tair = Tair;
+    surf_args.atmos_density = atmos_density;
+    surf_args.atmos_pressure = atmos_pressure;
+    surf_args.emissivity = emissivity;
+    surf_args.LongBareIn = LongBareIn;
+    surf_args.LongSnowIn = LongSnowIn;
+    surf_args.surf_atten = surf_atten;
+    surf_args.vp = VPcanopy;
+    surf_args.vpd = VPDcanopy;
+    surf_args.shortwave = atmos_shortwave;
+    surf_args.Catm = atmos_Catm;
+    surf_args.dryFrac = dryFrac;
+    surf_args.Wdew = &Wdew;
+    surf_args.displacement = displacement;
+    surf_args.ra = aero_resist;
+    surf_args.Ra_veg = aero_resist_veg;
+    surf_args.Ra_used = aero_resist_used;
+    surf_args.rainfall = rainfall;
+    surf_args.ref_height = ref_height;
+    surf_args.roughness = roughness;
+    surf_args.wind = wind;
+    surf_args.Le = Le;
+    surf_args.Advection = energy->advection;
+    surf_args.OldTSurf = OldTSurf;
+    surf_args.Tsnow_surf = Tsnow_surf;
+    surf_args.kappa_snow = kappa_snow;
+    surf_args.melt_energy = melt_energy;
+    surf_args.snow_coverage = snow_coverage;
+    surf_args.snow_density = snow->density;
+    surf_args.snow_swq = snow->swq;
+    surf_args.snow_water = snow->surf_water;
+    surf_args.deltaCC = &energy->deltaCC;
+    surf_args.refreeze_energy = &energy->refreeze_energy;
+    surf_args.vapor_flux = &snow->vapor_flux;
+    surf_args.blowing_flux = &snow->blowing_flux;
+    surf_args.surface_flux = &snow->surface_flux;
+    surf_args.Cs_node = Cs_node;
+    surf_args.T_node = T_node;
+    surf_args.Tnew_node = Tnew_node;
+    surf_args.Tnew_fbflag = Tnew_fbflag;
+    surf_args.Tnew_fbcount = Tnew_fbcount;
+    surf_args.alpha = alpha;
+    surf_args.beta = beta;
+    surf_args.bubble_node = bubble_node;
+    surf_args.Zsum_node = Zsum_node;
+    surf_args.expt_node = expt_node;
+    surf_args.gamma = gamma;
+    surf_args.ice_node = ice_node;
+    surf_args.kappa_node = kappa_node;
+    surf_args.max_moist_node = max_moist_node;
+    surf_args.moist_node = moist_node;
+    surf_args.soil_con = soil_con;
+    surf_args.layer = layer;
+    surf_args.veg_var = veg_var;
+    surf_args.INCLUDE_SNOW = INCLUDE_SNOW;
+    surf_args.NOFLUX = options.NOFLUX;
+    surf_args.EXP_TRANS = options.EXP_TRANS;
+    surf_args.SNOWING = snow->snow;
+    surf_args.soil_thermal = &soil_thermal;
+    surf_args.NetLongBare = &NetLongBare;
+    surf_args.NetLongSnow = &TmpNetLongSnow;
+    surf_args.T1 = &T1;
+    surf_args.deltaH = &energy->deltaH;
+    surf_args.fusion = &energy->fusion;
+    surf_args.grnd_flux = &energy->grnd_flux;
+    surf_args.latent_heat = &energy->latent;
+    surf_args.latent_heat_sub = &energy->latent_sub;
+    surf_args.sensible_heat = &energy->sensible;
+    surf_args.snow_flux = &energy->snow_flux;
+    surf_args.store_error = &energy->error;
+    set_surf_energy_bal_aero(&surf_args);
+
     /**************************************************
        Find Surface Temperature Using Root Brent Method
     **************************************************/
-    if (options.FULL_ENERGY) {
+    if (OPT_FULL_ENERGY) {
         /** If snow included in solution, temperature cannot exceed 0C  **/
         if (INCLUDE_SNOW) {
             T_lower = energy->T[0] - param.SURF_DT;
@@ -274,7 +379,7 @@ calc_surf_energy_bal(double             Le,
             T_upper = 0.5 * (energy->T[0] + Tair) + param.SURF_DT;
         }
 
-        if (options.QUICK_SOLVE && !options.QUICK_FLUX) {
+        if (options.QUICK_SOLVE && !OPT_QUICK_FLUX) {
             // Set iterative Nnodes using the depth of the thaw layer
             tmpNnodes = 0;
             for (inidx = Nnodes - 5; inidx >= 0; inidx--) {
@@ -298,34 +403,20 @@ calc_surf_energy_bal(double             Le,
             tmpNnodes = Nnodes;
         }
 
-        Tsurf = root_brent(T_lower, T_upper, func_surf_energy_bal,
-                           VEG, veg_class, delta_t, Cs1, Cs2, D1, D2,
-                           T1_old, T2, Ts_old, energy->T, bubble, dp, expt,
-                           ice0, kappa1, kappa2, max_moist, moist, root,
-                           CanopLayerBnd, UnderStory, overstory, NetShortBare,
-                           NetShortGrnd, TmpNetShortSnow, Tair, atmos_density,
-                           atmos_pressure, emissivity, LongBareIn, LongSnowIn,
-                           surf_atten, VPcanopy, VPDcanopy, atmos_shortwave,
-                           atmos_Catm, dryFrac, &Wdew, displacement,
-                           aero_resist, aero_resist_veg, aero_resist_used,
-                           rainfall, ref_height,
-                           roughness, wind, Le, energy->advection, OldTSurf,
-                           Tsnow_surf, kappa_snow, melt_energy, snow_coverage,
-                           snow->density, snow->swq, snow->surf_water,
-                           &energy->deltaCC, &energy->refreeze_energy,
-                           &snow->vapor_flux, &snow->blowing_flux,
-                           &snow->surface_flux, tmpNnodes, Cs_node, T_node,
-                           Tnew_node, Tnew_fbflag, Tnew_fbcount, alpha, beta,
-                           bubble_node, Zsum_node, expt_node, gamma, ice_node,
-                           kappa_node, max_moist_node, moist_node, soil_con,
-                           layer, veg_var, INCLUDE_SNOW, options.NOFLUX,
-                           options.EXP_TRANS,
-                           snow->snow, FIRST_SOLN, &NetLongBare,
-                           &TmpNetLongSnow, &T1, &energy->deltaH,
-                           &energy->fusion, &energy->grnd_flux,
-                           &energy->latent, &energy->latent_sub,
-                           &energy->sensible, &energy->snow_flux,
-                           &energy->error);
+        surf_args.Nnodes = tmpNnodes;
+        if (options.TSURF_NEWTON) {
+            // warm start from the surface temperature of the previous step
+            Tsurf = root_newton_ctx(Ts_old, T_lower, T_upper,
+                                    func_surf_energy_bal_ctx, &surf_args);
+        }
+        else {
+            Tsurf = root_brent_ctx(T_lower, T_upper, func_surf_energy_bal_ctx,
+                                   &surf_args);
+        }
+        if (Tsurf <= -998 && options.ROOT_RETRY) {
+            Tsurf = root_brent_retry_ctx(Ts_old, func_surf_energy_bal_ctx,
+                                         &surf_args);
+        }
 
         if (Tsurf <= -998) {
             if (options.TFALLBACK) {
@@ -340,8 +431,8 @@ calc_surf_energy_bal(double             Le,
                                                    (int) dmy->day,
                                                    (int) dmy->dayseconds,
                                                    VEG, iveg,
-                                                   veg_class, delta_t, Cs1, Cs2,
-                                                   D1, D2,
+                                                   veg_class, veg_lib, delta_t,
+                                                   Cs1, Cs2, D1, D2,
                                                    T1_old, T2, Ts_old,
                                                    energy->T,
                                                    soil_con->b_infilt, bubble,
@@ -395,7 +486,7 @@ calc_surf_energy_bal(double             Le,
                                                    soil_con->FS_ACTIVE,
                                                    options.NOFLUX,
                                                    options.EXP_TRANS,
-                                                   snow->snow, FIRST_SOLN,
+                                                   snow->snow, &soil_thermal,
                                                    &NetLongBare,
                                                    &TmpNetLongSnow, &T1,
                                                    &energy->deltaH,
@@ -416,39 +507,22 @@ calc_surf_energy_bal(double             Le,
 
         if (Ts_old * Tsurf < 0 && options.QUICK_SOLVE) {
             tmpNnodes = Nnodes;
-            FIRST_SOLN[0] = true;
-
-            Tsurf = root_brent(T_lower, T_upper,
-                               func_surf_energy_bal, VEG, veg_class,
-                               delta_t, Cs1, Cs2, D1, D2, T1_old, T2, Ts_old,
-                               energy->T, bubble, dp, expt, ice0, kappa1,
-                               kappa2, max_moist, moist, root, CanopLayerBnd,
-                               UnderStory, overstory, NetShortBare,
-                               NetShortGrnd,
-                               TmpNetShortSnow, Tair, atmos_density,
-                               atmos_pressure, emissivity, LongBareIn,
-                               LongSnowIn, surf_atten, VPcanopy, VPDcanopy,
-                               atmos_shortwave, atmos_Catm, dryFrac, &Wdew,
-                               displacement, aero_resist, aero_resist_veg,
-                               aero_resist_used,
-                               rainfall, ref_height, roughness, wind, Le,
-                               energy->advection, OldTSurf, Tsnow_surf,
-                               kappa_snow, melt_energy, snow_coverage,
-                               snow->density, snow->swq, snow->surf_water,
-                               &energy->deltaCC, &energy->refreeze_energy,
-                               &snow->vapor_flux, &snow->blowing_flux,
-                               &snow->surface_flux, tmpNnodes, Cs_node, T_node,
-                               Tnew_node, Tnew_fbflag, Tnew_fbcount, alpha,
-                               beta, bubble_node, Zsum_node, expt_node, gamma,
-                               ice_node, kappa_node, max_moist_node,
-                               moist_node, soil_con, layer, veg_var,
-                               INCLUDE_SNOW, options.NOFLUX, options.EXP_TRANS,
-                               snow->snow,
-                               FIRST_SOLN, &NetLongBare, &TmpNetLongSnow, &T1,
-                               &energy->deltaH, &energy->fusion,
-                               &energy->grnd_flux, &energy->latent,
-                               &energy->latent_sub, &energy->sensible,
-                               &energy->snow_flux, &energy->error);
+            soil_thermal.FIRST_SOLN[0] = true;
+
+            surf_args.Nnodes = tmpNnodes;
+            if (options.TSURF_NEWTON) {
+                // start from the solution of the reduced soil column
+                Tsurf = root_newton_ctx(Tsurf, T_lower, T_upper,
+                                        func_surf_energy_bal_ctx, &surf_args);
+            }
+            else {
+                Tsurf = root_brent_ctx(T_lower, T_upper,
+                                       func_surf_energy_bal_ctx, &surf_args);
+            }
+            if (Tsurf <= -998 && options.ROOT_RETRY) {
+                Tsurf = root_brent_retry_ctx(Ts_old, func_surf_energy_bal_ctx,
+                                             &surf_args);
+            }
 
             if (Tsurf <= -998) {
                 if (options.TFALLBACK) {
@@ -462,8 +536,8 @@ calc_surf_energy_bal(double             Le,
                                                        (int) dmy->day,
                                                        (int) dmy->dayseconds,
                                                        VEG, iveg,
-                                                       veg_class, delta_t, Cs1,
-                                                       Cs2, D1,
+                                                       veg_class, veg_lib,
+                                                       delta_t, Cs1, Cs2, D1,
                                                        D2, T1_old, T2, Ts_old,
                                                        energy->T,
                                                        soil_con->b_infilt,
@@ -523,7 +597,7 @@ calc_surf_energy_bal(double             Le,
                                                        soil_con->FS_ACTIVE,
                                                        options.NOFLUX,
                                                        options.EXP_TRANS,
-                                                       snow->snow, FIRST_SOLN,
+                                                       snow->snow, &soil_thermal,
                                                        &NetLongBare,
                                                        &TmpNetLongSnow, &T1,
                                                        &energy->deltaH,
@@ -544,42 +618,13 @@ calc_surf_energy_bal(double             Le,
         Tsurf = Tair;
     }
 
-    if (options.QUICK_SOLVE && !options.QUICK_FLUX) {
+    if (options.QUICK_SOLVE && !OPT_QUICK_FLUX) {
         // Reset model so that it solves thermal fluxes for full soil column
-        FIRST_SOLN[0] = true;
+        soil_thermal.FIRST_SOLN[0] = true;
     }
 
-    error = solve_surf_energy_bal(Tsurf, VEG, veg_class, delta_t, Cs1,
-                                  Cs2, D1, D2, T1_old, T2, Ts_old, energy->T,
-                                  bubble, dp, expt, ice0, kappa1, kappa2,
-                                  max_moist, moist, root, CanopLayerBnd,
-                                  UnderStory, overstory, NetShortBare,
-                                  NetShortGrnd, TmpNetShortSnow, Tair,
-                                  atmos_density, atmos_pressure, emissivity,
-                                  LongBareIn, LongSnowIn, surf_atten, VPcanopy,
-                                  VPDcanopy, atmos_shortwave, atmos_Catm,
-                                  dryFrac, &Wdew, displacement, aero_resist,
-                                  aero_resist_veg, aero_resist_used, rainfall,
-                                  ref_height,
-                                  roughness, wind, Le, energy->advection,
-                                  OldTSurf, Tsnow_surf, kappa_snow,
-                                  melt_energy, snow_coverage, snow->density,
-                                  snow->swq, snow->surf_water,
-                                  &energy->deltaCC, &energy->refreeze_energy,
-                                  &snow->vapor_flux, &snow->blowing_flux,
-                                  &snow->surface_flux, (int) Nnodes, Cs_node,
-                                  T_node, Tnew_node, Tnew_fbflag, Tnew_fbcount,
-                                  alpha, beta, bubble_node, Zsum_node,
-                                  expt_node, gamma, ice_node, kappa_node,
-                                  max_moist_node, moist_node, soil_con, layer,
-                                  veg_var, INCLUDE_SNOW, options.NOFLUX,
-                                  options.EXP_TRANS,
-                                  snow->snow, FIRST_SOLN, &NetLongBare,
-                                  &TmpNetLongSnow, &T1, &energy->deltaH,
-                                  &energy->fusion, &energy->grnd_flux,
-                                  &energy->latent, &energy->latent_sub,
-                                  &energy->sensible, &energy->snow_flux,
-                                  &energy->error);
+    surf_args.Nnodes = (int) Nnodes;
+    error = func_surf_energy_bal_ctx(Tsurf, &surf_args);
     if (error == ERROR) {
         return(ERROR);
     }
@@ -590,7 +635,7 @@ calc_surf_energy_bal(double             Le,
     /***************************************************
        Recalculate Soil Moisture and Thermal Properties
     ***************************************************/
-    if (options.QUICK_FLUX) {
+    if (OPT_QUICK_FLUX) {
         Tnew_node[0] = Tsurf;
         Tnew_node[1] = T1;
         Tnew_node[2] = soil_con->avg_temp +
@@ -776,9 +821,16 @@ double
 error_calc_surf_energy_bal(double Tsurf,
                            ...)
 {
-    va_list ap;
+    va_list       ap;
 
-    double  error;
+    double        error;
+    static size_t dump_count = 0;
+
+    // the variable values are only dumped for the first LOG_WARN_REPEAT
+    // failures, later failures return at once
+    if (!count_log_repeat(&dump_count, __FILE__, __LINE__)) {
+        return(ERROR);
+    }
 
     va_start(ap, Tsurf);
     error = error_print_surf_energy_bal(Tsurf, ap);
@@ -917,7 +969,7 @@ error_print_surf_energy_bal(double  Ts,
 
     int                SNOWING;
 
-    int               *FIRST_SOLN;
+    soil_thermal_struct *soil_thermal;
 
     /* returned energy balance terms */
     double            *NetLongBare; // net LW from snow-free ground
@@ -947,6 +999,7 @@ error_print_surf_energy_bal(double  Ts,
     VEG = (int) va_arg(ap, int);
     iveg = (int) va_arg(ap, int);
     veg_class = (int) va_arg(ap, int);
+    va_arg(ap, veg_lib_struct *); // veg library is not printed
 
     delta_t = (double) va_arg(ap, double);
 
@@ -1057,7 +1110,7 @@ error_print_surf_energy_bal(double  Ts,
     EXP_TRANS = (int) va_arg(ap, int);
     SNOWING = (int) va_arg(ap, int);
 
-    FIRST_SOLN = (int *) va_arg(ap, int *);
+    soil_thermal = (soil_thermal_struct *) va_arg(ap, soil_thermal_struct *);
 
     /* returned energy balance terms */
     NetLongBare = (double *) va_arg(ap, double *);
@@ -1182,7 +1235,7 @@ error_print_surf_energy_bal(double  Ts,
     fprintf(LOG_DEST, "EXP_TRANS = %i\n", EXP_TRANS);
     fprintf(LOG_DEST, "SNOWING = %i\n", SNOWING);
 
-    fprintf(LOG_DEST, "*FIRST_SOLN = %i\n", *FIRST_SOLN);
+    fprintf(LOG_DEST, "FIRST_SOLN = %i\n", soil_thermal->FIRST_SOLN[0]);
 
     /* returned energy balance terms */
     fprintf(LOG_DEST, "*NetLongBare = %f\n", *NetLongBare);
@@ -1200,7 +1253,7 @@ error_print_surf_energy_bal(double  Ts,
     write_layer(layer, iveg, frost_fract);
     write_vegvar(&(veg_var[0]), iveg);
 
-    if (!options.QUICK_FLUX) {
+    if (!OPT_QUICK_FLUX) {
         fprintf(LOG_DEST,
                 "Node\tT\tTnew\tTold\talpha\tbeta\tZsum\tkappa\tCs\tmoist\t"
                 "bubble\texpt\tgamma\tmax_moist\tice\n");
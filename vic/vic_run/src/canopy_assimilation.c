@@ -61,11 +61,13 @@ canopy_assimilation(char    Ctype,
     double                   pz;
     size_t                   cidx;
     double                   dLAI;
-    double                  *CiLayer = NULL;
+    double                   CiLayer;
     double                   AgrossLayer;
     double                   RdarkLayer;
     double                   RphotoLayer;
     double                   gc; /* 1/rs */
+    bool                     ci_mode;
+    photo_kinetics_struct    kinetics;
 
     /* calculate scale height based on average temperature in the column */
     h = calc_scale_height(Tfoliage, elevation);
@@ -74,22 +76,18 @@ canopy_assimilation(char    Ctype,
        temperature is equal air_temp */
     pz = CONST_PSTD * exp(-(double) elevation / h);
 
-    CiLayer = calloc(options.Ncanopy, sizeof(*CiLayer));
-    check_alloc_status(CiLayer, "Memory allocation error.");
+    /* the temperature- and irradiance-dependent terms are the same for all
+       canopy layers; note: divide by Epar to convert from W/m2 to
+       mol(photons)/m2s */
+    photosynth_kinetics(Ctype, Tfoliage, SWdown / param.PHOTO_EPAR,
+                        &kinetics);
 
-    if (!strcasecmp(mode, "ci")) {
+    ci_mode = !strcasecmp(mode, "ci");
+    if (ci_mode) {
         /* Assume a default leaf-internal CO2; compute assimilation,
            respiration, and stomatal resistance */
 
         /* Default leaf-internal CO2 */
-        for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-            if (Ctype == PHOTO_C3) {
-                CiLayer[cidx] = param.PHOTO_FCI1C3 * Catm;
-            }
-            else if (Ctype == PHOTO_C4) {
-                CiLayer[cidx] = param.PHOTO_FCI1C4 * Catm;
-            }
-        }
         if (Ctype == PHOTO_C3) {
             *Ci = param.PHOTO_FCI1C3 * Catm;
         }
@@ -103,22 +101,22 @@ canopy_assimilation(char    Ctype,
         *Rphoto = 0.0;
         gc = 0.0;
         for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-            photosynth(Ctype,
-                       MaxCarboxRate,
-                       MaxETransport,
-                       CO2Specificity,
-                       NscaleFactor[cidx],
-                       Tfoliage,
-                       SWdown / param.PHOTO_EPAR, /* note: divide by Epar to convert from W/m2 to mol(photons)/m2s */
-                       aPAR[cidx],
-                       pz,
-                       Catm,
-                       mode,
-                       &(rsLayer[cidx]),
-                       &(CiLayer[cidx]),
-                       &RdarkLayer,
-                       &RphotoLayer,
-                       &AgrossLayer);
+            CiLayer = *Ci;
+            photosynth_layer(Ctype,
+                             MaxCarboxRate,
+                             MaxETransport,
+                             CO2Specificity,
+                             NscaleFactor[cidx],
+                             aPAR[cidx],
+                             pz,
+                             Catm,
+                             ci_mode,
+                             &kinetics,
+                             &(rsLayer[cidx]),
+                             &CiLayer,
+                             &RdarkLayer,
+                             &RphotoLayer,
+                             &AgrossLayer);
 
             if (cidx > 0) {
                 dLAI = LAItotal *
@@ -151,22 +149,21 @@ canopy_assimilation(char    Ctype,
         *Rphoto = 0.0;
         *Ci = 0.0;
         for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-            photosynth(Ctype,
-                       MaxCarboxRate,
-                       MaxETransport,
-                       CO2Specificity,
-                       NscaleFactor[cidx],
-                       Tfoliage,
-                       SWdown / param.PHOTO_EPAR,
-                       aPAR[cidx],
-                       pz,
-                       Catm,
-                       mode,
-                       &(rsLayer[cidx]),
-                       &(CiLayer[cidx]),
-                       &RdarkLayer,
-                       &RphotoLayer,
-                       &AgrossLayer);
+            photosynth_layer(Ctype,
+                             MaxCarboxRate,
+                             MaxETransport,
+                             CO2Specificity,
+                             NscaleFactor[cidx],
+                             aPAR[cidx],
+                             pz,
+                             Catm,
+                             ci_mode,
+                             &kinetics,
+                             &(rsLayer[cidx]),
+                             &CiLayer,
+                             &RdarkLayer,
+                             &RphotoLayer,
+                             &AgrossLayer);
 
             if (cidx > 0) {
                 dLAI = LAItotal *
@@ -179,7 +176,7 @@ canopy_assimilation(char    Ctype,
             *GPP += AgrossLayer * dLAI;
             *Rdark += RdarkLayer * dLAI;
             *Rphoto += RphotoLayer * dLAI;
-            *Ci += CiLayer[cidx] * dLAI;
+            *Ci += CiLayer * dLAI;
         }
     }
 
@@ -189,6 +186,4 @@ canopy_assimilation(char    Ctype,
                ((*GPP) - (*Rmaint));
     *Raut = *Rmaint + *Rgrowth;
     *NPP = *GPP - *Raut;
-
-    free((char*) CiLayer);
 }
@@ -39,6 +39,7 @@ canopy_evap(layer_data_struct *layer,
             veg_var_struct    *veg_var,
             bool               CALC_EVAP,
             unsigned short     veg_class,
+            veg_lib_struct    *veg_lib,
             double            *Wdew,
             double             delta_t,
             double             rad,
@@ -56,11 +57,11 @@ canopy_evap(layer_data_struct *layer,
             double            *dryFrac,
             double             shortwave,
             double             Catm,
-            double            *CanopLayerBnd)
+            double            *CanopLayerBnd,
+            penman_atmos_struct *atmos)
 {
     /** declare global variables **/
-    extern veg_lib_struct *vic_run_veg_lib;
-    extern option_struct   options;
+    extern option_struct options;
 
     /** declare local variables **/
     size_t                 i;
@@ -72,11 +73,19 @@ canopy_evap(layer_data_struct *layer,
     double                 tmp_Wdew;
     double                 layerevap[MAX_LAYERS];
     double                 rc;
+    penman_atmos_struct    local_atmos;
 
     Evap = 0;
 
+    /* the Penman-Monteith terms of the air temperature are the same for the
+       canopy evaporation and the transpiration from every layer */
+    if (atmos == NULL) {
+        set_penman_atmos(air_temp, elevation, &local_atmos);
+        atmos = &local_atmos;
+    }
+
     /* Initialize variables */
-    for (i = 0; i < options.Nlayer; i++) {
+    for (i = 0; i < OPT_Nlayer; i++) {
         layerevap[i] = 0;
     }
     canopyevap = 0;
@@ -93,12 +102,12 @@ canopy_evap(layer_data_struct *layer,
         tmp_Wdew = veg_var->Wdmax;
     }
 
-    rc = calc_rc((double) 0.0, net_short, vic_run_veg_lib[veg_class].RGL,
+    rc = calc_rc((double) 0.0, net_short, veg_lib[veg_class].RGL,
                  air_temp, vpd, veg_var->LAI, (double) 1.0, false);
     if (veg_var->LAI > 0) {
         canopyevap = pow((tmp_Wdew / veg_var->Wdmax), (2.0 / 3.0)) *
-                     penman(air_temp, elevation, rad, vpd, ra, rc,
-                            vic_run_veg_lib[veg_class].rarc) *
+                     penman_atmos(atmos, rad, vpd, ra, rc,
+                                  veg_lib[veg_class].rarc) *
                      delta_t / CONST_CDAY;
     }
     else {
@@ -142,17 +151,17 @@ canopy_evap(layer_data_struct *layer,
        Compute Evapotranspiration from Vegetation
     *******************************************/
     if (CALC_EVAP) {
-        transpiration(layer, veg_var, veg_class, rad, vpd, net_short,
+        transpiration(layer, veg_var, veg_class, veg_lib, rad, vpd, net_short,
                       air_temp, ra, *dryFrac, delta_t, elevation, Wmax, Wcr,
                       Wpwp, layerevap, frost_fract, root, shortwave, Catm,
-                      CanopLayerBnd);
+                      CanopLayerBnd, atmos);
     }
 
     veg_var->canopyevap = canopyevap;
     veg_var->throughfall = throughfall;
     veg_var->Wdew = tmp_Wdew;
     tmp_Evap = canopyevap;
-    for (i = 0; i < options.Nlayer; i++) {
+    for (i = 0; i < OPT_Nlayer; i++) {
         layer[i].evap = layerevap[i];
         tmp_Evap += layerevap[i];
     }
@@ -169,6 +178,7 @@ void
 transpiration(layer_data_struct *layer,
               veg_var_struct    *veg_var,
               unsigned short     veg_class,
+              veg_lib_struct    *veg_lib,
               double             rad,
               double             vpd,
               double             net_short,
@@ -185,9 +195,9 @@ transpiration(layer_data_struct *layer,
               double            *root,
               double             shortwave,
               double             Catm,
-              double            *CanopLayerBnd)
+              double            *CanopLayerBnd,
+              penman_atmos_struct *atmos)
 {
-    extern veg_lib_struct   *vic_run_veg_lib;
     extern option_struct     options;
     extern parameters_struct param;
 
@@ -203,6 +213,13 @@ transpiration(layer_data_struct *layer,
     double                   ice[MAX_LAYERS];
     double                   gc;
     double                  *gsLayer = NULL;
+    scratch_mark_struct      scratch_start;
+    double                  *rsLayer0 = NULL; /* layer resistances in absence
+                                                 of soil moisture stress */
+    double                   rc0;       /* canopy resistance in absence of
+                                           soil moisture stress */
+    bool                     demand_set = false; /* rc0 and rsLayer0 are
+                                                    set */
     size_t                   cidx;
 
     /**********************************************************************
@@ -220,7 +237,7 @@ transpiration(layer_data_struct *layer,
     /**************************************************
        Set ice content in all individual layers
     **************************************************/
-    for (i = 0; i < options.Nlayer; i++) {
+    for (i = 0; i < OPT_Nlayer; i++) {
         ice[i] = 0;
         for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
             ice[i] += layer[i].ice[frost_area] * frost_fract[frost_area];
@@ -232,7 +249,7 @@ transpiration(layer_data_struct *layer,
     **************************************************/
     moist1 = 0.0;
     Wcr1 = 0.0;
-    for (i = 0; i < options.Nlayer - 1; i++) {
+    for (i = 0; i < OPT_Nlayer - 1; i++) {
         if (root[i] > 0.) {
             avail_moist[i] = 0;
             for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
@@ -251,7 +268,7 @@ transpiration(layer_data_struct *layer,
     /*****************************************
        Compute moisture content in lowest layer
     *****************************************/
-    i = options.Nlayer - 1;
+    i = OPT_Nlayer - 1;
     moist2 = 0;
     for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
         moist2 +=
@@ -261,11 +278,11 @@ transpiration(layer_data_struct *layer,
     avail_moist[i] = moist2;
 
     /** Set photosynthesis inhibition factor **/
-    if (layer[0].moist > vic_run_veg_lib[veg_class].Wnpp_inhib * Wmax[0]) {
-        veg_var->NPPfactor = vic_run_veg_lib[veg_class].NPPfactor_sat +
-                             (1 - vic_run_veg_lib[veg_class].NPPfactor_sat) *
+    if (layer[0].moist > veg_lib[veg_class].Wnpp_inhib * Wmax[0]) {
+        veg_var->NPPfactor = veg_lib[veg_class].NPPfactor_sat +
+                             (1 - veg_lib[veg_class].NPPfactor_sat) *
                              (Wmax[0] - layer[0].moist) / (Wmax[0] -
-                                                           vic_run_veg_lib[
+                                                           veg_lib[
                                                                veg_class].
                                                            Wnpp_inhib *
                                                            Wmax[0]);
@@ -285,19 +302,19 @@ transpiration(layer_data_struct *layer,
     ******************************************************************/
 
     if (options.SHARE_LAYER_MOIST &&
-        ((moist1 >= Wcr1 && moist2 >= Wcr[options.Nlayer - 1] && Wcr1 > 0.) ||
-         (moist1 >= Wcr1 && (1 - root[options.Nlayer - 1]) >= 0.5) ||
-         (moist2 >= Wcr[options.Nlayer - 1] && root[options.Nlayer - 1] >=
+        ((moist1 >= Wcr1 && moist2 >= Wcr[OPT_Nlayer - 1] && Wcr1 > 0.) ||
+         (moist1 >= Wcr1 && (1 - root[OPT_Nlayer - 1]) >= 0.5) ||
+         (moist2 >= Wcr[OPT_Nlayer - 1] && root[OPT_Nlayer - 1] >=
           0.5))) {
         gsm_inv = 1.0;
 
         /* compute whole-canopy stomatal resistance */
-        if (!options.CARBON || options.RC_MODE == RC_JARVIS) {
+        if (!OPT_CARBON || options.RC_MODE == RC_JARVIS) {
             /* Jarvis scheme, using resistance factors from Wigmosta et al., 1994 */
-            veg_var->rc = calc_rc(vic_run_veg_lib[veg_class].rmin, net_short,
-                                  vic_run_veg_lib[veg_class].RGL, air_temp, vpd,
+            veg_var->rc = calc_rc(veg_lib[veg_class].rmin, net_short,
+                                  veg_lib[veg_class].RGL, air_temp, vpd,
                                   veg_var->LAI, gsm_inv, false);
-            if (options.CARBON) {
+            if (OPT_CARBON) {
                 for (cidx = 0; cidx < options.Ncanopy; cidx++) {
                     if (veg_var->LAI > 0) {
                         veg_var->rsLayer[cidx] = veg_var->rc / veg_var->LAI;
@@ -313,10 +330,10 @@ transpiration(layer_data_struct *layer,
         }
         else {
             /* Compute rc based on photosynthetic demand from Knorr 1997 */
-            calc_rc_ps(vic_run_veg_lib[veg_class].Ctype,
-                       vic_run_veg_lib[veg_class].MaxCarboxRate,
-                       vic_run_veg_lib[veg_class].MaxETransport,
-                       vic_run_veg_lib[veg_class].CO2Specificity,
+            calc_rc_ps(veg_lib[veg_class].Ctype,
+                       veg_lib[veg_class].MaxCarboxRate,
+                       veg_lib[veg_class].MaxETransport,
+                       veg_lib[veg_class].CO2Specificity,
                        veg_var->NscaleFactor, air_temp, shortwave,
                        veg_var->aPARLayer, elevation, Catm,
                        CanopLayerBnd, veg_var->LAI, gsm_inv, vpd,
@@ -324,15 +341,15 @@ transpiration(layer_data_struct *layer,
         }
 
         /* compute transpiration */
-        evap = penman(air_temp, elevation, rad, vpd, ra, veg_var->rc,
-                      vic_run_veg_lib[veg_class].rarc) *
+        evap = penman_atmos(atmos, rad, vpd, ra, veg_var->rc,
+                            veg_lib[veg_class].rarc) *
                delta_t / CONST_CDAY * dryFrac;
 
         /** divide up evap based on root distribution **/
         /** Note the indexing of the roots **/
         root_sum = 1.0;
         spare_evap = 0.0;
-        for (i = 0; i < options.Nlayer; i++) {
+        for (i = 0; i < OPT_Nlayer; i++) {
             if (avail_moist[i] >= Wcr[i]) {
                 layerevap[i] = evap * (double) root[i];
             }
@@ -353,7 +370,7 @@ transpiration(layer_data_struct *layer,
 
         /** Assign excess evaporation to wetter layer **/
         if (spare_evap > 0.0) {
-            for (i = 0; i < options.Nlayer; i++) {
+            for (i = 0; i < OPT_Nlayer; i++) {
                 if (avail_moist[i] >= Wcr[i]) {
                     layerevap[i] += (double) root[i] * spare_evap / root_sum;
                 }
@@ -371,15 +388,15 @@ transpiration(layer_data_struct *layer,
     else {
         /* Initialize conductances for aggregation over soil layers */
         gc = 0;
-        if (options.CARBON) {
-            gsLayer = calloc(options.Ncanopy, sizeof(*gsLayer));
-            check_alloc_status(gsLayer, "Memory allocation error.");
-            for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-                gsLayer[cidx] = 0;
+        if (OPT_CARBON) {
+            scratch_start = scratch_mark();
+            gsLayer = scratch_calloc(options.Ncanopy, sizeof(*gsLayer));
+            if (options.RC_MODE != RC_JARVIS) {
+                rsLayer0 = scratch_calloc(options.Ncanopy, sizeof(*rsLayer0));
             }
         }
 
-        for (i = 0; i < options.Nlayer; i++) {
+        for (i = 0; i < OPT_Nlayer; i++) {
             /** Set evaporation restriction factor **/
             if (avail_moist[i] >= Wcr[i]) {
                 gsm_inv = 1.0;
@@ -393,14 +410,14 @@ transpiration(layer_data_struct *layer,
 
             if (gsm_inv > 0.0) {
                 /* compute whole-canopy stomatal resistance */
-                if (!options.CARBON || options.RC_MODE == RC_JARVIS) {
+                if (!OPT_CARBON || options.RC_MODE == RC_JARVIS) {
                     /* Jarvis scheme, using resistance factors from Wigmosta et al., 1994 */
-                    veg_var->rc = calc_rc(vic_run_veg_lib[veg_class].rmin,
+                    veg_var->rc = calc_rc(veg_lib[veg_class].rmin,
                                           net_short,
-                                          vic_run_veg_lib[veg_class].RGL,
+                                          veg_lib[veg_class].RGL,
                                           air_temp, vpd,
                                           veg_var->LAI, gsm_inv, false);
-                    if (options.CARBON) {
+                    if (OPT_CARBON) {
                         for (cidx = 0; cidx < options.Ncanopy; cidx++) {
                             if (veg_var->LAI > 0) {
                                 veg_var->rsLayer[cidx] = veg_var->rc /
@@ -416,21 +433,31 @@ transpiration(layer_data_struct *layer,
                     }
                 }
                 else {
-                    /* Compute rc based on photosynthetic demand from Knorr 1997 */
-                    calc_rc_ps(vic_run_veg_lib[veg_class].Ctype,
-                               vic_run_veg_lib[veg_class].MaxCarboxRate,
-                               vic_run_veg_lib[veg_class].MaxETransport,
-                               vic_run_veg_lib[veg_class].CO2Specificity,
-                               veg_var->NscaleFactor, air_temp, shortwave,
-                               veg_var->aPARLayer, elevation, Catm,
-                               CanopLayerBnd, veg_var->LAI, gsm_inv, vpd,
-                               veg_var->rsLayer, &(veg_var->rc));
+                    /* Compute rc based on photosynthetic demand from Knorr 1997;
+                       the demand does not depend on the soil moisture and is
+                       computed for the first layer only */
+                    if (!demand_set) {
+                        calc_rc_ps_demand(veg_lib[veg_class].Ctype,
+                                          veg_lib[veg_class].MaxCarboxRate,
+                                          veg_lib[veg_class].MaxETransport,
+                                          veg_lib[veg_class].CO2Specificity,
+                                          veg_var->NscaleFactor, air_temp,
+                                          shortwave, veg_var->aPARLayer,
+                                          elevation, Catm, CanopLayerBnd,
+                                          veg_var->LAI, rsLayer0, &rc0);
+                        demand_set = true;
+                    }
+                    for (cidx = 0; cidx < options.Ncanopy; cidx++) {
+                        veg_var->rsLayer[cidx] = rsLayer0[cidx];
+                    }
+                    calc_rc_ps_stress(rc0, gsm_inv, vpd, veg_var->rsLayer,
+                                      &(veg_var->rc));
                 }
 
                 /* compute transpiration */
-                layerevap[i] = penman(air_temp, elevation, rad, vpd, ra,
-                                      veg_var->rc,
-                                      vic_run_veg_lib[veg_class].rarc) *
+                layerevap[i] = penman_atmos(atmos, rad, vpd, ra,
+                                            veg_var->rc,
+                                            veg_lib[veg_class].rarc) *
                                delta_t / CONST_CDAY * dryFrac *
                                (double) root[i];
 
@@ -441,7 +468,7 @@ transpiration(layer_data_struct *layer,
                     gc += param.HUGE_RESIST;
                 }
 
-                if (options.CARBON) {
+                if (OPT_CARBON) {
                     for (cidx = 0; cidx < options.Ncanopy; cidx++) {
                         if (veg_var->rsLayer[cidx] > 0) {
                             gsLayer[cidx] += 1 / (veg_var->rsLayer[cidx]);
@@ -455,7 +482,7 @@ transpiration(layer_data_struct *layer,
             else {
                 layerevap[i] = 0.0;
                 gc += 0;
-                if (options.CARBON) {
+                if (OPT_CARBON) {
                     for (cidx = 0; cidx < options.Ncanopy; cidx++) {
                         gsLayer[cidx] += 0;
                     }
@@ -474,7 +501,7 @@ transpiration(layer_data_struct *layer,
             veg_var->rc = param.CANOPY_RSMAX;
         }
 
-        if (options.CARBON) {
+        if (OPT_CARBON) {
             for (cidx = 0; cidx < options.Ncanopy; cidx++) {
                 if (gsLayer[cidx] > 0) {
                     veg_var->rsLayer[cidx] = 1 / gsLayer[cidx];
@@ -488,8 +515,8 @@ transpiration(layer_data_struct *layer,
             }
         }
 
-        if (options.CARBON) {
-            free((char *) gsLayer);
+        if (OPT_CARBON) {
+            scratch_release(scratch_start);
         }
     }
 
@@ -497,7 +524,7 @@ transpiration(layer_data_struct *layer,
        Check that evapotransipration does not cause soil moisture to
        fall below wilting point.
     ****************************************************************/
-    for (i = 0; i < options.Nlayer; i++) {
+    for (i = 0; i < OPT_Nlayer; i++) {
         if (ice[i] > 0) {
             if (ice[i] >= Wpwp[i]) {
                 // ice content greater than wilting point can use all unfrozen moist
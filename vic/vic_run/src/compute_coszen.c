@@ -28,57 +28,87 @@
 #include <vic_run.h>
 
 /******************************************************************************
- * @brief    This subroutine computes the cosine of the solar zenith angle.
+ * @brief    Compute the time-invariant solar geometry of a grid cell.
  *****************************************************************************/
-double
-compute_coszen(double         lat,
-               double         lng,
-               double         time_zone_lng,
-               unsigned short day_in_year,
-               unsigned       second)
+void
+compute_solar_geom(double             lat,
+                   double             lng,
+                   double             time_zone_lng,
+                   solar_geom_struct *geom)
 {
-    double coslat;
-    double sinlat;
-    double decl;
-    double cosdecl;
-    double sindecl;
-    double cosegeom;
-    double sinegeom;
-    double coshss;
-    double hour_offset;
-    double cosh;
-    double coszen;
-    double hour;
+    /* calculate cos and sin of latitude */
+    geom->coslat = cos(lat * CONST_PI / 180);
+    geom->sinlat = sin(lat * CONST_PI / 180);
 
-    hour = second / SEC_PER_HOUR;
+    /* offset of local solar time from the time zone */
+    geom->hour_offset = (time_zone_lng - lng) * HOURS_PER_DAY / 360;
+}
 
-    /* calculate cos and sin of latitude */
-    coslat = cos(lat * CONST_PI / 180);
-    sinlat = sin(lat * CONST_PI / 180);
+/******************************************************************************
+ * @brief    Compute the cosine and sine of the solar declination of a day.
+ *****************************************************************************/
+void
+compute_solar_decl(unsigned short day_in_year,
+                   double        *cosdecl,
+                   double        *sindecl)
+{
+    double decl;
 
-    /* calculate cos and sin of declination */
     decl = CONST_MINDECL * cos(((double) day_in_year + CONST_DAYSOFF) *
                                CONST_RADPERDAY);
-    cosdecl = cos(decl);
-    sindecl = sin(decl);
+    *cosdecl = cos(decl);
+    *sindecl = sin(decl);
+}
 
-    /* calculate daylength as a function of lat and decl */
-    cosegeom = coslat * cosdecl;
-    sinegeom = sinlat * sindecl;
-    coshss = -(sinegeom) / cosegeom;
-    if (coshss < -1.0) {
-        coshss = -1.0; /* 24-hr daylight */
-    }
-    if (coshss > 1.0) {
-        coshss = 1.0; /* 0-hr daylight */
+/******************************************************************************
+ * @brief    Compute the cosine of the solar zenith angle of a set of grid
+ *           cells at the same time.
+ * @details  The declination terms are computed once per day by
+ *           compute_solar_decl and the cell terms once per run by
+ *           compute_solar_geom, which leaves one cosine per cell.
+ *****************************************************************************/
+void
+compute_coszen_cells(size_t             ncells,
+                     solar_geom_struct *geom,
+                     double             cosdecl,
+                     double             sindecl,
+                     unsigned           second,
+                     double            *coszen)
+{
+    double hour;
+    double cosh;
+    size_t i;
+
+    hour = second / SEC_PER_HOUR;
+
+    for (i = 0; i < ncells; i++) {
+        /* calculate cos of hour angle */
+        cosh = cos((hour + geom[i].hour_offset - 12) * CONST_PI / 12);
+
+        /* calculate cosine of solar zenith angle */
+        coszen[i] = geom[i].coslat * cosdecl * cosh +
+                    geom[i].sinlat * sindecl;
     }
+}
 
-    /* calculate cos of hour angle */
-    hour_offset = (time_zone_lng - lng) * HOURS_PER_DAY / 360;
-    cosh = cos((hour + hour_offset - 12) * CONST_PI / 12);
+/******************************************************************************
+ * @brief    This subroutine computes the cosine of the solar zenith angle.
+ *****************************************************************************/
+double
+compute_coszen(double         lat,
+               double         lng,
+               double         time_zone_lng,
+               unsigned short day_in_year,
+               unsigned       second)
+{
+    solar_geom_struct geom;
+    double            cosdecl;
+    double            sindecl;
+    double            coszen;
 
-    /* calculate cosine of solar zenith angle */
-    coszen = cosegeom * cosh + sinegeom;
+    compute_solar_geom(lat, lng, time_zone_lng, &geom);
+    compute_solar_decl(day_in_year, &cosdecl, &sindecl);
+    compute_coszen_cells(1, &geom, cosdecl, sindecl, second, &coszen);
 
     return coszen;
 }
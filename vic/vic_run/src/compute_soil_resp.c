@@ -26,8 +26,48 @@
 
 #include <vic_run.h>
 
+/******************************************************************************
+ * @brief    Moisture dependence of soil respiration.
+ *****************************************************************************/
+static inline double
+soil_resp_moist(double w)
+{
+    extern parameters_struct param;
+
+    double                   fM;
+
+    if (w < param.SRESP_WMINFM) {
+        w = param.SRESP_WMINFM;
+    }
+    if (w > param.SRESP_WMAXFM) {
+        w = param.SRESP_WMAXFM;
+    }
+    if (w <= param.SRESP_WOPTFM) {
+        fM = (w - param.SRESP_WMINFM) * (w - param.SRESP_WMAXFM) /
+             ((w - param.SRESP_WMINFM) * (w - param.SRESP_WMAXFM) -
+              (w - param.SRESP_WOPTFM) * (w - param.SRESP_WOPTFM));
+    }
+    else {
+        fM = param.SRESP_RHSAT + (1 - param.SRESP_RHSAT) *
+             (w - param.SRESP_WMINFM) * (w - param.SRESP_WMAXFM) /
+             ((w - param.SRESP_WMINFM) * (w - param.SRESP_WMAXFM) -
+              (w - param.SRESP_WOPTFM) * (w - param.SRESP_WOPTFM));
+    }
+    if (fM > 1.0) {
+        fM = 1.0;
+    }
+    if (fM < 0.0) {
+        fM = 0.0;
+    }
+
+    return fM;
+}
+
 /******************************************************************************
  * @brief    Calculate soil respiration (heterotrophic respiration, or Rh).
+ * @note     The litter pool sits at the top node, so its temperature and
+ *           moisture dependence are those of node 0. The factors are
+ *           evaluated once per node and the time step terms once per call.
  *****************************************************************************/
 void
 compute_soil_resp(int     Nnodes,
@@ -47,158 +87,45 @@ compute_soil_resp(int     Nnodes,
 
     int                      i;
     double                   Tref;
-    double                  *TK = NULL;
-    double                   fTLitter;
-    double                  *fTSoil = NULL;
-    double                   fMLitter;
-    double                  *fMSoil = NULL;
-    double                  *CInterNode = NULL;
-    double                  *CSlowNode = NULL;
-    double                  *RhInter = NULL;
-    double                  *RhSlow = NULL;
+    double                   TK;
+    double                   fTRef;
+    double                   fTM;
+    double                   fTMLitter;
+    double                   tauInter;
+    double                   tauSlow;
+    double                   CInterNode;
+    double                   CSlowNode;
 
-    /* Allocate temp arrays */
-    TK = calloc(Nnodes, sizeof(*TK));
-    check_alloc_status(TK, "Memory allocation error.");
-    fTSoil = calloc(Nnodes, sizeof(*fTSoil));
-    check_alloc_status(fTSoil, "Memory allocation error.");
-    fMSoil = calloc(Nnodes, sizeof(*fMSoil));
-    check_alloc_status(fMSoil, "Memory allocation error.");
-    CInterNode = calloc(Nnodes, sizeof(*CInterNode));
-    check_alloc_status(CInterNode, "Memory allocation error.");
-    CSlowNode = calloc(Nnodes, sizeof(*CSlowNode));
-    check_alloc_status(CSlowNode, "Memory allocation error.");
-    RhInter = calloc(Nnodes, sizeof(*RhInter));
-    check_alloc_status(RhInter, "Memory allocation error.");
-    RhSlow = calloc(Nnodes, sizeof(*RhSlow));
-    check_alloc_status(RhSlow, "Memory allocation error.");
+    /* Lloyd-Taylor temperature dependence relative to 10 C */
+    Tref = 10. + CONST_TKFRZ;
+    fTRef = 1 / (Tref - param.SRESP_T0_LT);
 
-    /* Compute Lloyd-Taylor temperature dependence */
-    Tref = 10. + CONST_TKFRZ; /* reference temperature of 10 C */
-    for (i = 0; i < Nnodes; i++) {
-        TK[i] = T[i] + CONST_TKFRZ;
-        if (TK[i] < param.SRESP_T0_LT) {
-            TK[i] = param.SRESP_T0_LT;
-        }
-    }
-    fTLitter =
-        exp(param.SRESP_E0_LT *
-            (1 / (Tref - param.SRESP_T0_LT) - 1 / (TK[0] - param.SRESP_T0_LT)));
-    for (i = 0; i < Nnodes; i++) {
-        fTSoil[i] =
-            exp(param.SRESP_E0_LT *
-                (1 /
-                 (Tref - param.SRESP_T0_LT) - 1 / (TK[i] - param.SRESP_T0_LT)));
-    }
+    /* Turnover times of the soil pools in time steps */
+    tauInter = param.SRESP_TAUINTER * CONST_DDAYS_PER_YEAR * HOURS_PER_DAY / dt;
+    tauSlow = param.SRESP_TAUSLOW * CONST_DDAYS_PER_YEAR * HOURS_PER_DAY / dt;
 
-    /* Compute moisture dependence */
-    for (i = 0; i < Nnodes; i++) {
-        if (w[i] < param.SRESP_WMINFM) {
-            w[i] = param.SRESP_WMINFM;
-        }
-        if (w[i] > param.SRESP_WMAXFM) {
-            w[i] = param.SRESP_WMAXFM;
-        }
-    }
-    if (w[0] <= param.SRESP_WOPTFM) {
-        fMLitter =
-            (w[0] -
-             param.SRESP_WMINFM) *
-            (w[0] -
-             param.SRESP_WMAXFM) /
-            ((w[0] -
-              param.SRESP_WMINFM) *
-             (w[0] -
-              param.SRESP_WMAXFM) -
-             (w[0] - param.SRESP_WOPTFM) * (w[0] - param.SRESP_WOPTFM));
-    }
-    else {
-        fMLitter = param.SRESP_RHSAT +
-                   (1 -
-                    param.SRESP_RHSAT) *
-                   (w[0] -
-                    param.SRESP_WMINFM) *
-                   (w[0] -
-                    param.SRESP_WMAXFM) /
-                   ((w[0] -
-                     param.SRESP_WMINFM) *
-                    (w[0] -
-                     param.SRESP_WMAXFM) -
-                    (w[0] - param.SRESP_WOPTFM) * (w[0] - param.SRESP_WOPTFM));
-    }
-    if (fMLitter > 1.0) {
-        fMLitter = 1.0;
-    }
-    if (fMLitter < 0.0) {
-        fMLitter = 0.0;
-    }
+    /* Compute Rh for various pools, nodes; C fluxes in [gC/m2d] */
+    fTMLitter = 0.;
+    *RhInterTot = 0;
+    *RhSlowTot = 0;
     for (i = 0; i < Nnodes; i++) {
-        if (w[i] <= param.SRESP_WOPTFM) {
-            fMSoil[i] =
-                (w[i] -
-                 param.SRESP_WMINFM) *
-                (w[i] -
-                 param.SRESP_WMAXFM) /
-                ((w[i] -
-                  param.SRESP_WMINFM) *
-                 (w[i] -
-                  param.SRESP_WMAXFM) -
-                 (w[i] - param.SRESP_WOPTFM) * (w[i] - param.SRESP_WOPTFM));
+        TK = T[i] + CONST_TKFRZ;
+        if (TK < param.SRESP_T0_LT) {
+            TK = param.SRESP_T0_LT;
         }
-        else {
-            fMSoil[i] = param.SRESP_RHSAT +
-                        (1 -
-                         param.SRESP_RHSAT) *
-                        (w[i] -
-                         param.SRESP_WMINFM) *
-                        (w[i] -
-                         param.SRESP_WMAXFM) /
-                        ((w[i] -
-                          param.SRESP_WMINFM) *
-                         (w[i] -
-                          param.SRESP_WMAXFM) -
-                         (w[i] -
-                          param.SRESP_WOPTFM) * (w[i] - param.SRESP_WOPTFM));
+        fTM = exp(param.SRESP_E0_LT * (fTRef - 1 / (TK - param.SRESP_T0_LT))) *
+              soil_resp_moist(w[i]);
+        if (i == 0) {
+            fTMLitter = fTM;
         }
-        if (fMSoil[i] > 1.0) {
-            fMSoil[i] = 1.0;
-        }
-        if (fMSoil[i] < 0.0) {
-            fMSoil[i] = 0.0;
-        }
-    }
 
-    /* Compute C per node */
-    for (i = 0; i < Nnodes; i++) {
-        CInterNode[i] = CInter * dZ[i] / dZTot;
-        CSlowNode[i] = CSlow * dZ[i] / dZTot;
+        CInterNode = CInter * dZ[i] / dZTot;
+        CSlowNode = CSlow * dZ[i] / dZTot;
+        *RhInterTot += param.SRESP_RFACTOR * (fTM / tauInter) * CInterNode;
+        *RhSlowTot += param.SRESP_RFACTOR * (fTM / tauSlow) * CSlowNode;
     }
-
-    /* Compute Rh for various pools, nodes; C fluxes in [gC/m2d] */
     *RhLitter = param.SRESP_RFACTOR *
-                (fTLitter * fMLitter /
+                (fTMLitter /
                  (param.SRESP_TAULITTER * CONST_DDAYS_PER_YEAR * SEC_PER_DAY /
                   dt)) * CLitter;
-    *RhInterTot = 0;
-    *RhSlowTot = 0;
-    for (i = 0; i < Nnodes; i++) {
-        RhInter[i] = param.SRESP_RFACTOR *
-                     (fTSoil[i] * fMSoil[i] /
-                      (param.SRESP_TAUINTER * CONST_DDAYS_PER_YEAR *
-                       HOURS_PER_DAY / dt)) * CInterNode[i];
-        RhSlow[i] = param.SRESP_RFACTOR *
-                    (fTSoil[i] * fMSoil[i] /
-                     (param.SRESP_TAUSLOW * CONST_DDAYS_PER_YEAR *
-                      HOURS_PER_DAY / dt)) * CSlowNode[i];
-        *RhInterTot += RhInter[i];
-        *RhSlowTot += RhSlow[i];
-    }
-
-    free((char *) TK);
-    free((char *) fTSoil);
-    free((char *) fMSoil);
-    free((char *) CInterNode);
-    free((char *) CSlowNode);
-    free((char *) RhInter);
-    free((char *) RhSlow);
 }
@@ -36,14 +36,25 @@ compute_zwt(soil_con_struct *soil_con,
             double           moist)
 {
     int    i;
+    int    imax;
+    int    imid;
     double zwt;
 
     zwt = MISSING;
 
     /** Compute zwt using soil moisture v zwt curve **/
-    i = MAX_ZWTVMOIST - 1;
-    while (i >= 1 && moist > soil_con->zwtvmoist_moist[lindex][i]) {
-        i--;
+    // The moisture of the curve decreases with depth of the water table, so
+    // find the deepest point whose moisture is not exceeded by bisection
+    i = 0;
+    imax = MAX_ZWTVMOIST - 1;
+    while (i < imax) {
+        imid = (i + imax + 1) / 2;
+        if (moist > soil_con->zwtvmoist_moist[lindex][imid]) {
+            imax = imid - 1;
+        }
+        else {
+            i = imid;
+        }
     }
     if (i == MAX_ZWTVMOIST - 1) {
         if (moist < soil_con->zwtvmoist_moist[lindex][i]) {
@@ -90,20 +101,20 @@ wrap_compute_zwt(soil_con_struct  *soil_con,
 
     /** Compute total soil column depth **/
     total_depth = 0;
-    for (lindex = 0; lindex < options.Nlayer; lindex++) {
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
         total_depth += soil_con->depth[lindex];
     }
 
     /** Compute each layer's zwt using soil moisture v zwt curve **/
-    for (lindex = 0; lindex < options.Nlayer; lindex++) {
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
         cell->layer[lindex].zwt =
             compute_zwt(soil_con, lindex, cell->layer[lindex].moist);
     }
-    if (cell->layer[options.Nlayer - 1].zwt == 999) {
-        cell->layer[options.Nlayer - 1].zwt = -total_depth * CM_PER_M;                                     // in cm
+    if (cell->layer[OPT_Nlayer - 1].zwt == 999) {
+        cell->layer[OPT_Nlayer - 1].zwt = -total_depth * CM_PER_M;                                     // in cm
     }
     /** Compute total soil column's zwt; this will be the zwt of the lowest layer that isn't completely saturated **/
-    idx = options.Nlayer - 1;
+    idx = OPT_Nlayer - 1;
     tmp_depth = total_depth;
     while (idx >= 0 && soil_con->max_moist[idx] -
            cell->layer[idx].moist <= DBL_EPSILON) {
@@ -113,7 +124,7 @@ wrap_compute_zwt(soil_con_struct  *soil_con,
     if (idx < 0) {
         cell->zwt = 0;
     }
-    else if (idx < (short) (options.Nlayer - 1)) {
+    else if (idx < (short) (OPT_Nlayer - 1)) {
         if (cell->layer[idx].zwt != 999) {
             cell->zwt = cell->layer[idx].zwt;
         }
@@ -127,10 +138,10 @@ wrap_compute_zwt(soil_con_struct  *soil_con,
 
     /** Compute total soil column's zwt_lumped; this will be the zwt of all N layers lumped together. **/
     tmp_moist = 0;
-    for (lindex = 0; lindex < options.Nlayer; lindex++) {
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
         tmp_moist += cell->layer[lindex].moist;
     }
-    cell->zwt_lumped = compute_zwt(soil_con, options.Nlayer + 1, tmp_moist);
+    cell->zwt_lumped = compute_zwt(soil_con, OPT_Nlayer + 1, tmp_moist);
     if (cell->zwt_lumped == 999) {
         cell->zwt_lumped = -total_depth * CM_PER_M;                      // in cm;
     }
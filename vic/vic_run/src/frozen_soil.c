@@ -43,20 +43,23 @@ calc_layer_average_thermal_props(energy_bal_struct *energy,
     size_t               i;
     int                  ErrorFlag;
     size_t               tmpTshape[] = {
-        options.Nlayer, Nnodes,
+        OPT_Nlayer, Nnodes,
         options.Nfrost + 1
     };
     size_t               tmpZshape[] = {
-        options.Nlayer, Nnodes
+        OPT_Nlayer, Nnodes
     };
     double            ***tmpT;
     double             **tmpZ;
+    scratch_mark_struct  scratch_start;
 
-    // allocate memory for tmpT and tmpZ
-    malloc_3d_double(tmpTshape, &tmpT);
-    malloc_2d_double(tmpZshape, &tmpZ);
+    // tmpT and tmpZ are taken back at the next vic_run call if this one
+    // fails
+    scratch_start = scratch_mark();
+    tmpT = scratch_3d_double(tmpTshape);
+    tmpZ = scratch_2d_double(tmpZshape);
 
-    if (options.FROZEN_SOIL && soil_con->FS_ACTIVE) {
+    if (OPT_FROZEN_SOIL && soil_con->FS_ACTIVE) {
         find_0_degree_fronts(energy, soil_con->Zsum_node, T, Nnodes);
     }
     else {
@@ -76,7 +79,7 @@ calc_layer_average_thermal_props(energy_bal_struct *energy,
     }
 
     /** Compute Soil Layer average  properties **/
-    if (options.QUICK_FLUX) {
+    if (OPT_QUICK_FLUX) {
         ErrorFlag = estimate_layer_temperature_quick_flux(layer,
                                                           soil_con->depth,
                                                           soil_con->dp,
@@ -107,14 +110,14 @@ calc_layer_average_thermal_props(energy_bal_struct *energy,
                                              soil_con->frost_fract,
                                              soil_con->frost_slope,
                                              Nnodes,
-                                             options.Nlayer);
+                                             OPT_Nlayer);
         ErrorFlag = estimate_layer_temperature(layer,
                                                tmpT,
                                                tmpZ,
                                                soil_con->Zsum_node,
                                                soil_con->depth,
                                                Nnodes,
-                                               options.Nlayer);
+                                               OPT_Nlayer);
         if (ErrorFlag == ERROR) {
             return (ERROR);
         }
@@ -127,16 +130,14 @@ calc_layer_average_thermal_props(energy_bal_struct *energy,
                                                soil_con->expt,
                                                soil_con->bubble,
                                                Nnodes,
-                                               options.Nlayer,
+                                               OPT_Nlayer,
                                                soil_con->FS_ACTIVE);
         if (ErrorFlag == ERROR) {
             return (ERROR);
         }
     }
 
-    // free memory for tmpT and tmpZ
-    free_3d_double(tmpTshape, tmpT);
-    free_2d_double(tmpZshape, tmpZ);
+    scratch_release(scratch_start);
 
     return (0);
 }
@@ -165,28 +166,27 @@ solve_T_profile(double   *T,
                 double   *gamma,
                 double    Dp,
                 int       Nnodes,
-                int      *FIRST_SOLN,
+                soil_thermal_struct *soil_thermal,
                 int       FS_ACTIVE,
                 int       NOFLUX,
                 int       EXP_TRANS)
 {
-    static double A[MAX_NODES];
-    static double B[MAX_NODES];
-    static double C[MAX_NODES];
-    static double D[MAX_NODES];
-    static double E[MAX_NODES];
-
+    double       *A = soil_thermal->A;
+    double       *B = soil_thermal->B;
+    double       *C = soil_thermal->C;
+    double       *D = soil_thermal->D;
+    double       *E = soil_thermal->E;
     double       *aa, *bb, *cc, *dd, *ee, Bexp;
 
     int           Error;
     int           j;
 
-    if (FIRST_SOLN[0]) {
+    if (soil_thermal->FIRST_SOLN[0]) {
         if (EXP_TRANS) {
             Bexp = logf(Dp + 1.) / (double) (Nnodes - 1);
         }
 
-        FIRST_SOLN[0] = false;
+        soil_thermal->FIRST_SOLN[0] = false;
         if (!EXP_TRANS) {
             for (j = 1; j < Nnodes - 1; j++) {
                 A[j] = Cs[j] * alpha[j - 1] * alpha[j - 1];
@@ -269,15 +269,10 @@ solve_T_profile_implicit(double   *T,                               // update
                          double   *gamma,                     // soil parameter
                          double    Dp,                        // soil parameter
                          int       Nnodes,                   // model parameter
-                         int      *FIRST_SOLN,               // update
+                         soil_thermal_struct *soil_thermal,  // update
                          int       NOFLUX,
                          int       EXP_TRANS,
-                         double   *bulk_dens_min,              // soil parameter
-                         double   *soil_dens_min,              // soil parameter
-                         double   *quartz,                    // soil parameter
-                         double   *bulk_density,              // soil parameter
-                         double   *soil_density,              // soil parameter
-                         double   *organic,                    // soil parameter
+                         soil_thermal_coef_struct *thermal_coef, // soil parameter
                          double   *depth)                     // soil parameter
 {
     extern option_struct options;
@@ -286,8 +281,8 @@ solve_T_profile_implicit(double   *T,                               // update
     void                 (*vecfunc)(double *, double *, int, int, ...);
     int                  j;
 
-    if (FIRST_SOLN[0]) {
-        FIRST_SOLN[0] = false;
+    if (soil_thermal->FIRST_SOLN[0]) {
+        soil_thermal->FIRST_SOLN[0] = false;
     }
 
     // initialize fda_heat_eqn:
@@ -300,15 +295,19 @@ solve_T_profile_implicit(double   *T,                               // update
         n = Nnodes - 1;
     }
 
-    fda_heat_eqn(&T[1], res, n, 1, deltat, NOFLUX, EXP_TRANS, T0,
+    fda_heat_eqn(&T[1], res, n, 1, soil_thermal, deltat, NOFLUX, EXP_TRANS, T0,
                  moist, ice, kappa, Cs, max_moist, bubble, expt,
-                 alpha, beta, gamma, Zsum, Dp, bulk_dens_min, soil_dens_min,
-                 quartz, bulk_density, soil_density, organic, depth,
-                 options.Nlayer);
+                 alpha, beta, gamma, Zsum, Dp, thermal_coef, depth, OPT_Nlayer);
 
     // modified Newton-Raphson to solve for new T
     vecfunc = &(fda_heat_eqn);
-    Error = newt_raph(vecfunc, &T[1], n);
+    if (options.ANALYTIC_JACOBIAN) {
+        Error = newt_raph(vecfunc, &(fda_heat_eqn_jacobian), &T[1], n,
+                          soil_thermal);
+    }
+    else {
+        Error = newt_raph(vecfunc, NULL, &T[1], n, soil_thermal);
+    }
 
     // update temperature boundaries
     if (Error == 0) {
@@ -339,6 +338,89 @@ solve_T_profile_implicit(double   *T,                               // update
     return (Error);
 }
 
+/******************************************************************************
+ * @brief    Check whether the soil column is quiescent, i.e. no thermal node
+ *           of the profile at the start of the time step is within SOIL_DT
+ *           of 0 C and no two adjacent nodes bracket a frost front.
+ *****************************************************************************/
+static bool
+soil_column_quiescent(int     Nnodes,
+                      double *T0)
+{
+    extern parameters_struct param;
+
+    int                      j;
+
+    for (j = 0; j < Nnodes; j++) {
+        if (fabs(T0[j]) <= param.SOIL_DT) {
+            return false;
+        }
+        if (j > 0 && (T0[j] < 0.) != (T0[j - 1] < 0.)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Solve the heat equation of a frozen node with the ice content
+ *           linearized around the current node temperature, in place of the
+ *           root_brent solution of soil_thermal_eqn.
+ *
+ * @return   false if the linearization does not apply (ice content at a
+ *           limit, cold nose correction of the near-surface node, or the new
+ *           temperature leaves the SOIL_DT bracket), otherwise true.
+ *****************************************************************************/
+static bool
+linear_frozen_node_T(double  T,
+                     double  TL,
+                     double  TU,
+                     double  T0,
+                     double  moist,
+                     double  max_moist,
+                     double  bubble,
+                     double  expt,
+                     double  ice0,
+                     double  A,
+                     double  B,
+                     double  C,
+                     double  D,
+                     double  E,
+                     int     EXP_TRANS,
+                     int     node,
+                     double *Tnew)
+{
+    extern parameters_struct param;
+
+    double                   unfrozen;
+    double                   ice;
+    double                   dice;
+
+    if (node == 1 && fabs(TL - TU) > 5.) {
+        return false;
+    }
+
+    unfrozen = maximum_unfrozen_water(T, max_moist, bubble, expt);
+    ice = moist - unfrozen;
+    if (unfrozen >= max_moist || ice <= 0. || ice >= max_moist) {
+        return false;
+    }
+    // the unfrozen water content is a power of -T
+    dice = 2.0 / (expt - 3.0) * unfrozen / T;
+
+    if (!EXP_TRANS) {
+        *Tnew = (A * T0 + B * (TL - TU) + C * TL + D * TU +
+                 E * (ice - dice * T - ice0)) / (A + C + D - E * dice);
+    }
+    else {
+        *Tnew = (A * T0 + B * (TL - TU) + C * (TL + TU) - D * (TL - TU) +
+                 E * (ice - dice * T - ice0)) / (A + 2. * C - E * dice);
+    }
+
+    return (fabs(*Tnew - T0) <= param.SOIL_DT);
+}
+
 /******************************************************************************
  * @brief    Calculate soil thermal fluxes
  *****************************************************************************/
@@ -374,12 +456,19 @@ calc_soil_thermal_fluxes(int       Nnodes,
     double                   maxdiff;
     double                   diff;
     double                   oldT;
+    double                   Tlin;
     double                   Tlast[MAX_NODES];
+    bool                     quiescent;
 
     Error = 0;
     Done = false;
     ItCount = 0;
 
+    /* frozen nodes of a quiescent column are solved with a linearized ice
+       content; nodes for which the linearization fails use root_brent */
+    quiescent = options.QUIESCENT_SOIL && FS_ACTIVE && OPT_FROZEN_SOIL &&
+                soil_column_quiescent(Nnodes, T0);
+
     /* initialize Tlast */
     for (j = 0; j < Nnodes; j++) {
         Tlast[j] = T[j];
@@ -399,7 +488,7 @@ calc_soil_thermal_fluxes(int       Nnodes,
 
             /**	2nd order variable kappa equation **/
 
-            if (T[j] >= 0 || !FS_ACTIVE || !options.FROZEN_SOIL) {
+            if (T[j] >= 0 || !FS_ACTIVE || !OPT_FROZEN_SOIL) {
                 if (!EXP_TRANS) {
                     T[j] = (A[j] * T0[j] +
                             B[j] * (T[j + 1] - T[j - 1]) +
@@ -415,6 +504,13 @@ calc_soil_thermal_fluxes(int       Nnodes,
                             E[j] * (0. - ice[j])) / (A[j] + 2. * C[j]);
                 }
             }
+            else if (quiescent &&
+                     linear_frozen_node_T(T[j], T[j + 1], T[j - 1], T0[j],
+                                          moist[j], max_moist[j], bubble[j],
+                                          expt[j], ice[j], A[j], B[j], C[j],
+                                          D[j], E[j], EXP_TRANS, j, &Tlin)) {
+                T[j] = Tlin;
+            }
             else {
                 T[j] =
                     root_brent(T0[j] - (param.SOIL_DT), T0[j] + (param.SOIL_DT),
@@ -452,7 +548,7 @@ calc_soil_thermal_fluxes(int       Nnodes,
             j = Nnodes - 1;
             oldT = T[j];
 
-            if (T[j] >= 0 || !FS_ACTIVE || !options.FROZEN_SOIL) {
+            if (T[j] >= 0 || !FS_ACTIVE || !OPT_FROZEN_SOIL) {
                 if (!EXP_TRANS) {
                     T[j] =
                         (A[j] * T0[j] + B[j] * (T[j] - T[j - 1]) +
@@ -467,6 +563,13 @@ calc_soil_thermal_fluxes(int       Nnodes,
                             E[j] * (0. - ice[j])) / (A[j] + 2. * C[j]);
                 }
             }
+            else if (quiescent &&
+                     linear_frozen_node_T(T[j], T[j], T[j - 1], T0[j],
+                                          moist[j], max_moist[j], bubble[j],
+                                          expt[j], ice[j], A[j], B[j], C[j],
+                                          D[j], E[j], EXP_TRANS, j, &Tlin)) {
+                T[j] = Tlin;
+            }
             else {
                 T[Nnodes - 1] = root_brent(T0[Nnodes - 1] - param.SOIL_DT,
                                            T0[Nnodes - 1] + param.SOIL_DT,
@@ -560,9 +663,16 @@ double
 error_solve_T_profile(double Tj,
                       ...)
 {
-    va_list ap;
+    va_list       ap;
 
-    double  error;
+    double        error;
+    static size_t dump_count = 0;
+
+    // the variable values are only dumped for the first LOG_WARN_REPEAT
+    // failures, later failures return at once
+    if (!count_log_repeat(&dump_count, __FILE__, __LINE__)) {
+        return(ERROR);
+    }
 
     va_start(ap, Tj);
     error = error_print_solve_T_profile(Tj, ap);
@@ -646,105 +756,139 @@ fda_heat_eqn(double T_2[],
              int    init,
              ...)
 {
-    static double  deltat;
-    static int     NOFLUX;
-    static int     EXP_TRANS;
-    static double *T0;
-    static double *moist;
-    static double *ice;
-    static double *kappa;
-    static double *Cs;
-    static double *max_moist;
-    static double *bubble;
-    static double *expt;
-    static double *alpha;
-    static double *beta;
-    static double *gamma;
-    static double *Zsum;
-    static double  Dp;
-    static double *bulk_dens_min;
-    static double *soil_dens_min;
-    static double *quartz;
-    static double *bulk_density;
-    static double *soil_density;
-    static double *organic;
-    static double *depth;
-    static size_t  Nlayers;
-
-    // variables used to calculate residual of the heat equation
-    // defined here
-    static double Ts;
-    static double Tb;
-
-    // locally used variables
-    static double ice_new[MAX_NODES], Cs_new[MAX_NODES], kappa_new[MAX_NODES];
-    static double DT[MAX_NODES], DT_down[MAX_NODES], DT_up[MAX_NODES];
-    static double Dkappa[MAX_NODES];
-    static double Bexp;
-    char          PAST_BOTTOM;
-    double        storage_term, flux_term, phase_term, flux_term1, flux_term2;
-    double        Lsum;
-    int           i;
-    size_t        lidx;
-    int           focus, left, right;
+    soil_thermal_struct      *soil_thermal;
+    double                    deltat;
+    int                       NOFLUX;
+    int                       EXP_TRANS;
+    double                   *T0;
+    double                   *moist;
+    double                   *ice;
+    double                   *Cs;
+    double                   *kappa;
+    double                   *max_moist;
+    double                   *bubble;
+    double                   *expt;
+    double                   *alpha;
+    double                   *beta;
+    double                   *gamma;
+    double                   *Zsum;
+    soil_thermal_coef_struct *thermal_coef;
+    double                   *depth;
+    size_t                    Nlayers;
+    double                    Ts;
+    double                    Tb;
+    double                    Bexp;
+
+    // work arrays are kept in the solver state between residual evaluations
+    double                   *ice_new, *Cs_new, *kappa_new;
+    double                   *DT, *DT_down, *DT_up, *Dkappa;
+    char                      PAST_BOTTOM;
+    double                    storage_term, flux_term, phase_term, flux_term1,
+                              flux_term2;
+    double                    Lsum;
+    int                       i;
+    size_t                    lidx;
+    int                       focus, left, right;
 
     // argument list handling
-    va_list       arg_addr;
+    va_list                   arg_addr;
+
+    va_start(arg_addr, init);
+    soil_thermal = va_arg(arg_addr, soil_thermal_struct *);
 
     // initialize variables if init==1
     if (init == 1) {
-        va_start(arg_addr, init);
-        deltat = va_arg(arg_addr, double);
-        NOFLUX = va_arg(arg_addr, int);
-        EXP_TRANS = va_arg(arg_addr, int);
-        T0 = va_arg(arg_addr, double *);
-        moist = va_arg(arg_addr, double *);
-        ice = va_arg(arg_addr, double *);
-        kappa = va_arg(arg_addr, double *);
-        Cs = va_arg(arg_addr, double *);
-        max_moist = va_arg(arg_addr, double *);
-        bubble = va_arg(arg_addr, double *);
-        expt = va_arg(arg_addr, double *);
-        alpha = va_arg(arg_addr, double *);
-        beta = va_arg(arg_addr, double *);
-        gamma = va_arg(arg_addr, double *);
-        Zsum = va_arg(arg_addr, double *);
-        Dp = va_arg(arg_addr, double);
-        bulk_dens_min = va_arg(arg_addr, double *);
-        soil_dens_min = va_arg(arg_addr, double *);
-        quartz = va_arg(arg_addr, double *);
-        bulk_density = va_arg(arg_addr, double *);
-        soil_density = va_arg(arg_addr, double *);
-        organic = va_arg(arg_addr, double *);
-        depth = va_arg(arg_addr, double *);
-        Nlayers = va_arg(arg_addr, size_t);
-
-        if (EXP_TRANS) {
+        soil_thermal->deltat = va_arg(arg_addr, double);
+        soil_thermal->NOFLUX = va_arg(arg_addr, int);
+        soil_thermal->EXP_TRANS = va_arg(arg_addr, int);
+        soil_thermal->T0 = va_arg(arg_addr, double *);
+        soil_thermal->moist = va_arg(arg_addr, double *);
+        soil_thermal->ice = va_arg(arg_addr, double *);
+        soil_thermal->kappa = va_arg(arg_addr, double *);
+        soil_thermal->Cs = va_arg(arg_addr, double *);
+        soil_thermal->max_moist = va_arg(arg_addr, double *);
+        soil_thermal->bubble = va_arg(arg_addr, double *);
+        soil_thermal->expt = va_arg(arg_addr, double *);
+        soil_thermal->alpha = va_arg(arg_addr, double *);
+        soil_thermal->beta = va_arg(arg_addr, double *);
+        soil_thermal->gamma = va_arg(arg_addr, double *);
+        soil_thermal->Zsum = va_arg(arg_addr, double *);
+        soil_thermal->Dp = va_arg(arg_addr, double);
+        soil_thermal->thermal_coef = va_arg(arg_addr,
+                                            soil_thermal_coef_struct *);
+        soil_thermal->depth = va_arg(arg_addr, double *);
+        soil_thermal->Nlayers = va_arg(arg_addr, size_t);
+
+        T0 = soil_thermal->T0;
+        NOFLUX = soil_thermal->NOFLUX;
+        if (soil_thermal->EXP_TRANS) {
             if (!NOFLUX) {
-                Bexp = logf(Dp + 1.) / (double)(n + 1);
+                soil_thermal->Bexp = logf(soil_thermal->Dp + 1.) /
+                                     (double)(n + 1);
             }
             else {
-                Bexp = logf(Dp + 1.) / (double)(n);
+                soil_thermal->Bexp = logf(soil_thermal->Dp + 1.) /
+                                     (double)(n);
             }
         }
 
-        Ts = T0[0];
+        soil_thermal->Ts = T0[0];
         if (!NOFLUX) {
-            Tb = T0[n + 1];
+            soil_thermal->Tb = T0[n + 1];
         }
         else {
-            Tb = T0[n];
+            soil_thermal->Tb = T0[n];
         }
         for (i = 0; i < n; i++) {
             T_2[i] = T0[i + 1];
         }
+
+        // the residual reads the bottom boundary entries of the work arrays
+        // without setting them, so start every solution from zeros
+        for (i = 0; i < MAX_NODES; i++) {
+            soil_thermal->ice_new[i] = 0.;
+            soil_thermal->Cs_new[i] = 0.;
+            soil_thermal->kappa_new[i] = 0.;
+            soil_thermal->DT[i] = 0.;
+            soil_thermal->DT_down[i] = 0.;
+            soil_thermal->DT_up[i] = 0.;
+            soil_thermal->Dkappa[i] = 0.;
+        }
     }
     // calculate residuals if init==0
     else {
         // get the range of columns to calculate
-        va_start(arg_addr, init);
         focus = va_arg(arg_addr, int);
 
+        deltat = soil_thermal->deltat;
+        NOFLUX = soil_thermal->NOFLUX;
+        EXP_TRANS = soil_thermal->EXP_TRANS;
+        T0 = soil_thermal->T0;
+        moist = soil_thermal->moist;
+        ice = soil_thermal->ice;
+        kappa = soil_thermal->kappa;
+        Cs = soil_thermal->Cs;
+        max_moist = soil_thermal->max_moist;
+        bubble = soil_thermal->bubble;
+        expt = soil_thermal->expt;
+        alpha = soil_thermal->alpha;
+        beta = soil_thermal->beta;
+        gamma = soil_thermal->gamma;
+        Zsum = soil_thermal->Zsum;
+        thermal_coef = soil_thermal->thermal_coef;
+        depth = soil_thermal->depth;
+        Nlayers = soil_thermal->Nlayers;
+        Ts = soil_thermal->Ts;
+        Tb = soil_thermal->Tb;
+        Bexp = soil_thermal->Bexp;
+        ice_new = soil_thermal->ice_new;
+        Cs_new = soil_thermal->Cs_new;
+        kappa_new = soil_thermal->kappa_new;
+        DT = soil_thermal->DT;
+        DT_down = soil_thermal->DT_down;
+        DT_up = soil_thermal->DT_up;
+        Dkappa = soil_thermal->Dkappa;
+
         // calculate all entries if focus == -1
         if (focus == -1) {
             lidx = 0;
@@ -772,17 +916,12 @@ fda_heat_eqn(double T_2[],
                     // update other states due to ice content change
                     /***********************************************/
                     if (ice_new[i] != ice[i]) {
-                        kappa_new[i] = soil_conductivity(moist[i],
-                                                         moist[i] - ice_new[i],
-                                                         soil_dens_min[lidx],
-                                                         bulk_dens_min[lidx],
-                                                         quartz[lidx],
-                                                         soil_density[lidx],
-                                                         bulk_density[lidx],
-                                                         organic[lidx]);
-                        Cs_new[i] = volumetric_heat_capacity(
-                            bulk_density[lidx] / soil_density[lidx],
-                            moist[i] - ice_new[i], ice_new[i], organic[lidx]);
+                        kappa_new[i] = soil_conductivity_coef(
+                            moist[i], moist[i] - ice_new[i],
+                            &(thermal_coef[lidx]));
+                        Cs_new[i] = volumetric_heat_capacity_coef(
+                            moist[i] - ice_new[i], ice_new[i],
+                            &(thermal_coef[lidx]));
                     }
                     /************************************************/
                 }
@@ -911,17 +1050,12 @@ fda_heat_eqn(double T_2[],
             for (i = 0; i <= right + 1; i++) {
                 if (i >= left + 1) {
                     if (ice_new[i] != ice[i]) {
-                        kappa_new[i] = soil_conductivity(moist[i],
-                                                         moist[i] - ice_new[i],
-                                                         soil_dens_min[lidx],
-                                                         bulk_dens_min[lidx],
-                                                         quartz[lidx],
-                                                         soil_density[lidx],
-                                                         bulk_density[lidx],
-                                                         organic[lidx]);
-                        Cs_new[i] = volumetric_heat_capacity(
-                            bulk_density[lidx] / soil_density[lidx],
-                            moist[i] - ice_new[i], ice_new[i], organic[lidx]);
+                        kappa_new[i] = soil_conductivity_coef(
+                            moist[i], moist[i] - ice_new[i],
+                            &(thermal_coef[lidx]));
+                        Cs_new[i] = volumetric_heat_capacity_coef(
+                            moist[i] - ice_new[i], ice_new[i],
+                            &(thermal_coef[lidx]));
                     }
                 }
                 if (Zsum[i] > Lsum + depth[lidx] && !PAST_BOTTOM) {
@@ -1014,4 +1148,175 @@ fda_heat_eqn(double T_2[],
             }
         } // end of calculation of focus node only
     } // end of non-init
+    va_end(arg_addr);
+}
+
+/******************************************************************************
+ * @brief    Tridiagonal Jacobian of the heat equation residual of
+ *           fda_heat_eqn
+ *
+ * @note     Must be called after a residual evaluation of fda_heat_eqn for
+ *           all nodes (focus == -1) at T_2, whose work arrays it reads.
+ *           a[i], b[i] and c[i] are the derivatives of res[i] with respect
+ *           to T_2[i - 1], T_2[i] and T_2[i + 1]. The derivative of the ice
+ *           content follows from maximum_unfrozen_water, that of the heat
+ *           capacity from the linearity of volumetric_heat_capacity in the
+ *           ice content, and that of the thermal conductivity from a
+ *           node-local difference of soil_conductivity.
+ *****************************************************************************/
+void
+fda_heat_eqn_jacobian(double               T_2[],
+                      double               a[],
+                      double               b[],
+                      double               c[],
+                      int                  n,
+                      soil_thermal_struct *soil_thermal)
+{
+    double                    deltat;
+    int                       NOFLUX;
+    int                       EXP_TRANS;
+    double                   *T0;
+    double                   *moist;
+    double                   *Cs;
+    double                   *max_moist;
+    double                   *expt;
+    double                   *alpha;
+    double                   *beta;
+    double                   *gamma;
+    double                   *Zsum;
+    soil_thermal_coef_struct *thermal_coef;
+    double                   *depth;
+    double                   *ice_new;
+    double                   *Cs_new;
+    double                   *kappa_new;
+    double                   *DT;
+    double                   *DT_down;
+    double                   *DT_up;
+    double                   *Dkappa;
+    double                    Bexp;
+    double                    dice[MAX_NODES];
+    double                    dCs[MAX_NODES];
+    double                    dkappa[MAX_NODES];
+    double                    unfrozen;
+    double                    kappa_ice;
+    double                    kappa_node;
+    double                    dDkappa;
+    double                    dstorage;
+    double                    dflux;
+    double                    zz;
+    double                    w;
+    double                    Lsum;
+    char                      PAST_BOTTOM;
+    size_t                    lidx;
+    int                       i;
+
+    deltat = soil_thermal->deltat;
+    NOFLUX = soil_thermal->NOFLUX;
+    EXP_TRANS = soil_thermal->EXP_TRANS;
+    T0 = soil_thermal->T0;
+    moist = soil_thermal->moist;
+    Cs = soil_thermal->Cs;
+    max_moist = soil_thermal->max_moist;
+    expt = soil_thermal->expt;
+    alpha = soil_thermal->alpha;
+    beta = soil_thermal->beta;
+    gamma = soil_thermal->gamma;
+    Zsum = soil_thermal->Zsum;
+    thermal_coef = soil_thermal->thermal_coef;
+    depth = soil_thermal->depth;
+    Bexp = soil_thermal->Bexp;
+    ice_new = soil_thermal->ice_new;
+    Cs_new = soil_thermal->Cs_new;
+    kappa_new = soil_thermal->kappa_new;
+    DT = soil_thermal->DT;
+    DT_down = soil_thermal->DT_down;
+    DT_up = soil_thermal->DT_up;
+    Dkappa = soil_thermal->Dkappa;
+
+    // derivatives of the node properties with respect to the node
+    // temperature; the boundary nodes are fixed
+    lidx = 0;
+    Lsum = 0.;
+    PAST_BOTTOM = false;
+    for (i = 0; i < n + 2; i++) {
+        dice[i] = 0.;
+        dCs[i] = 0.;
+        dkappa[i] = 0.;
+        if (i >= 1 && i <= n && T_2[i - 1] < 0 && ice_new[i] > 0) {
+            // the unfrozen water content is a power of -T
+            unfrozen = moist[i] - ice_new[i];
+            if (unfrozen > 0 && unfrozen < max_moist[i]) {
+                dice[i] = 2.0 / (expt[i] - 3.0) * unfrozen / T_2[i - 1];
+            }
+            dCs[i] = dice[i] *
+                     (volumetric_heat_capacity_coef(0., 1.,
+                                                    &(thermal_coef[lidx])) -
+                      volumetric_heat_capacity_coef(1., 0.,
+                                                    &(thermal_coef[lidx])));
+            kappa_ice = soil_conductivity_coef(moist[i],
+                                               unfrozen - FDA_JAC_DICE,
+                                               &(thermal_coef[lidx]));
+            kappa_node = soil_conductivity_coef(moist[i], unfrozen,
+                                                &(thermal_coef[lidx]));
+            dkappa[i] = dice[i] * (kappa_ice - kappa_node) / FDA_JAC_DICE;
+        }
+        if (i < n + 1 && Zsum[i] > Lsum + depth[lidx] && !PAST_BOTTOM) {
+            Lsum += depth[lidx];
+            lidx++;
+            if (lidx == soil_thermal->Nlayers) {
+                PAST_BOTTOM = true;
+                lidx = soil_thermal->Nlayers - 1;
+            }
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        // storage and phase change terms only depend on T_2[i]
+        dstorage = (dCs[i + 1] * (T_2[i] - T0[i + 1]) + Cs_new[i + 1] +
+                    Cs_new[i + 1] - Cs[i + 1] + T_2[i] * dCs[i + 1]) / deltat;
+        b[i] = CONST_RHOICE * CONST_LATICE * dice[i + 1] / deltat - dstorage;
+
+        // Dkappa only depends on T_2[i] at a no flux bottom boundary
+        if (i == n - 1 && NOFLUX) {
+            dDkappa = dkappa[i + 1];
+        }
+        else {
+            dDkappa = 0.;
+        }
+
+        if (!EXP_TRANS) {
+            b[i] += dDkappa / alpha[i] * DT[i] / alpha[i] +
+                    dkappa[i + 1] * (DT_down[i] / gamma[i] - DT_up[i] /
+                                     beta[i]) / (0.5 * alpha[i]) -
+                    kappa_new[i + 1] * (1. / gamma[i] + 1. / beta[i]) /
+                    (0.5 * alpha[i]);
+            if (i < n - 1) {
+                dflux = (dkappa[i + 2] * DT[i] + Dkappa[i]) / alpha[i] /
+                        alpha[i];
+                c[i] = dflux + kappa_new[i + 1] / gamma[i] / (0.5 * alpha[i]);
+            }
+            if (i > 0) {
+                dflux = -(dkappa[i] * DT[i] + Dkappa[i]) / alpha[i] /
+                        alpha[i];
+                a[i] = dflux + kappa_new[i + 1] / beta[i] / (0.5 * alpha[i]);
+            }
+        }
+        else { // grid transformation
+            zz = Bexp * (Zsum[i + 1] + 1.);
+            zz *= zz;
+            w = 1. / (Bexp * (Zsum[i + 1] + 1.) * (Zsum[i + 1] + 1.));
+            b[i] += dDkappa * DT[i] / 4. / zz +
+                    dkappa[i + 1] * ((DT_down[i] - DT_up[i]) / zz -
+                                     DT[i] / 2. * w) -
+                    kappa_new[i + 1] * 2. / zz;
+            if (i < n - 1) {
+                dflux = (dkappa[i + 2] * DT[i] + Dkappa[i]) / 4. / zz;
+                c[i] = dflux + kappa_new[i + 1] * (1. / zz - w / 2.);
+            }
+            if (i > 0) {
+                dflux = -(dkappa[i] * DT[i] + Dkappa[i]) / 4. / zz;
+                a[i] = dflux + kappa_new[i + 1] * (1. / zz + w / 2.);
+            }
+        }
+    }
 }
@@ -29,164 +29,46 @@
 #include <vic_run.h>
 
 /******************************************************************************
- * @brief    Calculate the canopy energy balance.
+ * @brief    Calculate the canopy energy balance from the arguments in a
+ *           canopy_energy_bal_args_struct.
  *****************************************************************************/
 double
-func_canopy_energy_bal(double  Tfoliage,
-                       va_list ap)
+func_canopy_energy_bal_ctx(double Tfoliage,
+                           void  *ctx)
 {
-    extern option_struct     options;
-    extern parameters_struct param;
-
-    /* General Model Parameters */
-    double                   delta_t;
-    double                   elevation;
-
-    double                  *Wmax;
-    double                  *Wcr;
-    double                  *Wpwp;
-    double                  *frost_fract;
-
-    /* Atmopheric Condition and Forcings */
-    double                   AirDens;
-    double                   EactAir;
-    double                   Press;
-    double                   Le;
-    double                   Tcanopy;
-    double                   Vpd;
-    double                   shortwave;
-    double                   Catm;
-    double                  *dryFrac;
-
-    double                  *Evap;
-    double                  *Ra;
-    double                  *Ra_used;
-    double                   Rainfall;
-    double                  *Wind;
-
-    /* Vegetation Terms */
-    int                      veg_class;
+    extern option_struct           options;
+    extern parameters_struct       param;
 
-    double                  *displacement;
-    double                  *ref_height;
-    double                  *roughness;
-
-    double                  *root;
-    double                  *CanopLayerBnd;
-
-    /* Water Flux Terms */
-    double                   IntRain;
-    double                   IntSnow;
-
-    double                  *Wdew;
-
-    layer_data_struct       *layer;
-    veg_var_struct          *veg_var;
-
-    /* Energy Flux Terms */
-    double                   LongOverIn;
-    double                   LongUnderOut;
-    double                   NetShortOver;
-
-    double                  *AdvectedEnergy;
-    double                  *LatentHeat;
-    double                  *LatentHeatSub;
-    double                  *LongOverOut;
-    double                  *NetLongOver;
-    double                  *NetRadiation;
-    double                  *RefreezeEnergy;
-    double                  *SensibleHeat;
-    double                  *VaporMassFlux;
+    canopy_energy_bal_args_struct *args;
 
     /* Internal Variables */
-    double                   EsSnow;
-    double                   Ls;
-    double                   RestTerm;
-    double                   prec;
+    double                         EsSnow;
+    double                         Ls;
+    double                         RestTerm;
+    double                         prec;
 
-    /** Read variables from variable length argument list **/
-
-    /* General Model Parameters */
-    delta_t = (double) va_arg(ap, double);
-    elevation = (double) va_arg(ap, double);
-
-    Wmax = (double *) va_arg(ap, double *);
-    Wcr = (double *) va_arg(ap, double *);
-    Wpwp = (double *) va_arg(ap, double *);
-    frost_fract = (double *) va_arg(ap, double *);
-
-    /* Atmopheric Condition and Forcings */
-    AirDens = (double) va_arg(ap, double);
-    EactAir = (double) va_arg(ap, double);
-    Press = (double) va_arg(ap, double);
-    Le = (double) va_arg(ap, double);
-    Tcanopy = (double) va_arg(ap, double);
-    Vpd = (double) va_arg(ap, double);
-    shortwave = (double) va_arg(ap, double);
-    Catm = (double) va_arg(ap, double);
-    dryFrac = (double *) va_arg(ap, double *);
-
-    Evap = (double *) va_arg(ap, double *);
-    Ra = (double *) va_arg(ap, double *);
-    Ra_used = (double *) va_arg(ap, double *);
-    Rainfall = (double) va_arg(ap, double);
-    Wind = (double *) va_arg(ap, double *);
-
-    /* Vegetation Terms */
-    veg_class = (unsigned int) va_arg(ap, unsigned int);
-
-    displacement = (double *) va_arg(ap, double *);
-    ref_height = (double *) va_arg(ap, double *);
-    roughness = (double *) va_arg(ap, double *);
-
-    root = (double *) va_arg(ap, double *);
-    CanopLayerBnd = (double *) va_arg(ap, double *);
-
-    /* Water Flux Terms */
-    IntRain = (double) va_arg(ap, double);
-    IntSnow = (double) va_arg(ap, double);
-
-    Wdew = (double *) va_arg(ap, double *);
-
-    layer = (layer_data_struct *) va_arg(ap, layer_data_struct *);
-    veg_var = (veg_var_struct *) va_arg(ap, veg_var_struct *);
-
-    /* Energy Flux Terms */
-    LongOverIn = (double) va_arg(ap, double);
-    LongUnderOut = (double) va_arg(ap, double);
-    NetShortOver = (double) va_arg(ap, double);
-
-    AdvectedEnergy = (double *) va_arg(ap, double *);
-    LatentHeat = (double *) va_arg(ap, double *);
-    LatentHeatSub = (double *) va_arg(ap, double *);
-    LongOverOut = (double *) va_arg(ap, double *);
-    NetLongOver = (double *) va_arg(ap, double *);
-    NetRadiation = (double *) va_arg(ap, double *);
-    RefreezeEnergy = (double *) va_arg(ap, double *);
-    SensibleHeat = (double *) va_arg(ap, double *);
-    VaporMassFlux = (double *) va_arg(ap, double *);
+    args = (canopy_energy_bal_args_struct *) ctx;
 
     /* Calculate the net radiation at the canopy surface, using the canopy
        temperature.  The outgoing longwave is subtracted twice, because the
        canopy radiates in two directions */
 
-    *LongOverOut = calc_outgoing_longwave(Tfoliage + CONST_TKFRZ,
-                                          param.EMISS_VEG);
-    *NetRadiation = NetShortOver + LongOverIn + LongUnderOut -
-                    2 * (*LongOverOut);
+    *args->LongOverOut = calc_outgoing_longwave(Tfoliage + CONST_TKFRZ,
+                                                param.EMISS_VEG);
+    *args->NetRadiation = args->RadiationIn - 2 * (*args->LongOverOut);
 
-    *NetLongOver = LongOverIn - (*LongOverOut);
+    *args->NetLongOver = args->LongOverIn - (*args->LongOverOut);
 
-    if (IntSnow > 0) {
-        Ra_used[0] = Ra[0];
-        Ra_used[1] = Ra[1];
+    if (args->IntSnow > 0) {
+        args->Ra_used[0] = args->Ra[0];
+        args->Ra_used[1] = args->Ra[1];
 
         /** Added multiplication by 10 to incorporate change in canopy resistance due
             to smoothing by intercepted snow **/
         if (options.AERO_RESIST_CANSNOW == AR_406 ||
             options.AERO_RESIST_CANSNOW == AR_406_LS ||
             options.AERO_RESIST_CANSNOW == AR_406_FULL) {
-            Ra_used[1] *= 10.;
+            args->Ra_used[1] *= 10.;
         }
 
         /** Calculate the vapor mass flux between intercepted snow in
@@ -196,93 +78,201 @@ func_canopy_energy_bal(double  Tfoliage,
 
         /* Apply stability correction to aerodynamic resistance */
         if (options.AERO_RESIST_CANSNOW == AR_410) {
-            if (Wind[1] > 0.0) {
-                Ra_used[1] /= StabilityCorrection(ref_height[1],
-                                                  displacement[1], Tfoliage,
-                                                  Tcanopy, Wind[1],
-                                                  roughness[1]);
+            if (args->Wind[1] > 0.0) {
+                args->Ra_used[1] /= StabilityCorrection_coef(Tfoliage,
+                                                             args->Tcanopy,
+                                                             args->Wind[1],
+                                                             &args->stab);
             }
             else {
-                Ra_used[1] = param.HUGE_RESIST;
+                args->Ra_used[1] = param.HUGE_RESIST;
             }
         }
 
-        *VaporMassFlux = AirDens * (CONST_EPS / Press) * (EactAir - EsSnow) /
-                         Ra_used[1] / CONST_RHOFW;
+        *args->VaporMassFlux = args->AirDens * (CONST_EPS / args->Press) *
+                               (args->EactAir - EsSnow) /
+                               args->Ra_used[1] / CONST_RHOFW;
 
-        if (Vpd == 0.0 && *VaporMassFlux < 0.0) {
-            *VaporMassFlux = 0.0;
+        if (args->Vpd == 0.0 && *args->VaporMassFlux < 0.0) {
+            *args->VaporMassFlux = 0.0;
         }
 
         /* Calculate the latent heat flux */
 
         Ls = calc_latent_heat_of_sublimation(Tfoliage);
-        *LatentHeatSub = Ls * *VaporMassFlux * CONST_RHOFW;
-        *LatentHeat = 0;
-        *Evap = 0;
-        veg_var->throughfall = 0;
+        *args->LatentHeatSub = Ls * *args->VaporMassFlux * CONST_RHOFW;
+        *args->LatentHeat = 0;
+        *args->Evap = 0;
+        args->veg_var->throughfall = 0;
 
         if (options.AERO_RESIST_CANSNOW == AR_406) {
-            Ra_used[1] /= 10;
+            args->Ra_used[1] /= 10;
         }
     }
     else {
         if (options.AERO_RESIST_CANSNOW == AR_406_FULL ||
             options.AERO_RESIST_CANSNOW == AR_410) {
-            Ra_used[0] = Ra[0];
-            Ra_used[1] = Ra[1];
+            args->Ra_used[0] = args->Ra[0];
+            args->Ra_used[1] = args->Ra[1];
         }
         else {
-            Ra_used[0] = Ra[0];
-            Ra_used[1] = Ra[0];
+            args->Ra_used[0] = args->Ra[0];
+            args->Ra_used[1] = args->Ra[0];
         }
 
-        *Wdew = IntRain * MM_PER_M;
-        prec = Rainfall * MM_PER_M;
-        *Evap = canopy_evap(layer, veg_var, false,
-                            veg_class, Wdew, delta_t, *NetRadiation,
-                            Vpd, NetShortOver, Tcanopy, Ra_used[1],
-                            elevation, prec, Wmax, Wcr, Wpwp, frost_fract,
-                            root, dryFrac, shortwave, Catm, CanopLayerBnd);
-        *Wdew /= MM_PER_M;
-
-        *LatentHeat = Le * *Evap * CONST_RHOFW;
-        *LatentHeatSub = 0;
+        *args->Wdew = args->IntRain * MM_PER_M;
+        prec = args->Rainfall * MM_PER_M;
+        *args->Evap = canopy_evap(args->layer, args->veg_var, false,
+                                  args->veg_class, args->veg_lib, args->Wdew,
+                                  args->delta_t, *args->NetRadiation,
+                                  args->Vpd, args->NetShortOver,
+                                  args->Tcanopy, args->Ra_used[1],
+                                  args->elevation, prec, args->Wmax,
+                                  args->Wcr, args->Wpwp, args->frost_fract,
+                                  args->root, args->dryFrac, args->shortwave,
+                                  args->Catm, args->CanopLayerBnd, NULL);
+        *args->Wdew /= MM_PER_M;
+
+        *args->LatentHeat = args->Le * *args->Evap * CONST_RHOFW;
+        *args->LatentHeatSub = 0;
     }
 
     /* Calculate the sensible heat flux */
 
-    *SensibleHeat = calc_sensible_heat(AirDens, Tcanopy, Tfoliage, Ra_used[1]);
+    *args->SensibleHeat = calc_sensible_heat(args->AirDens, args->Tcanopy,
+                                             Tfoliage, args->Ra_used[1]);
 
     /* Calculate the advected energy */
 
-    *AdvectedEnergy = (CONST_CPFW * CONST_RHOFW * Tcanopy * Rainfall) /
-                      (delta_t);
+    *args->AdvectedEnergy = args->AdvectedEnergyRain;
 
     /* Calculate the amount of energy available for refreezing */
 
-    RestTerm = *SensibleHeat + *LatentHeat + *LatentHeatSub + *NetRadiation +
-               *AdvectedEnergy;
+    RestTerm = *args->SensibleHeat + *args->LatentHeat +
+               *args->LatentHeatSub + *args->NetRadiation +
+               *args->AdvectedEnergy;
 
-    if (IntSnow > 0) {
+    if (args->IntSnow > 0) {
         /* Intercepted snow present, check if excess energy can be used to
            melt or refreeze it */
 
-        *RefreezeEnergy = (IntRain * CONST_LATICE * CONST_RHOFW) / (delta_t);
+        *args->RefreezeEnergy = args->RefreezeEnergyMax;
 
-        if (Tfoliage == 0.0 && RestTerm > -(*RefreezeEnergy)) {
-            *RefreezeEnergy = -RestTerm; /* available energy input over cold content
-                                            used to melt, i.e. Qrf is negative value
-                                            (energy out of pack)*/
+        if (Tfoliage == 0.0 && RestTerm > -(*args->RefreezeEnergy)) {
+            *args->RefreezeEnergy = -RestTerm; /* available energy input over cold content
+                                                  used to melt, i.e. Qrf is negative value
+                                                  (energy out of pack)*/
             RestTerm = 0.0;
         }
         else {
-            RestTerm += *RefreezeEnergy; /* add this positive value to the pack */
+            RestTerm += *args->RefreezeEnergy; /* add this positive value to the pack */
         }
     }
     else {
-        *RefreezeEnergy = 0;
+        *args->RefreezeEnergy = 0;
     }
 
     return (RestTerm);
 }
+
+/******************************************************************************
+ * @brief    Set the terms of the canopy energy balance residual that do not
+ *           depend on the foliage temperature.
+ *****************************************************************************/
+void
+set_canopy_energy_bal_terms(canopy_energy_bal_args_struct *args)
+{
+    /* stability correction of the aerodynamic resistance of the canopy */
+    set_stability_coef(args->ref_height[1], args->displacement[1],
+                       args->roughness[1], &args->stab);
+
+    /* shortwave and incoming longwave absorbed by the canopy */
+    args->RadiationIn = args->NetShortOver + args->LongOverIn +
+                        args->LongUnderOut;
+
+    /* energy advected by the rain */
+    args->AdvectedEnergyRain = (CONST_CPFW * CONST_RHOFW * args->Tcanopy *
+                                args->Rainfall) / (args->delta_t);
+
+    /* energy released if all intercepted rain refreezes */
+    args->RefreezeEnergyMax = (args->IntRain * CONST_LATICE * CONST_RHOFW) /
+                              (args->delta_t);
+}
+
+/******************************************************************************
+ * @brief    Calculate the canopy energy balance from a variable argument list,
+ *           in the order of the canopy_energy_bal_args_struct members.
+ *****************************************************************************/
+double
+func_canopy_energy_bal(double  Tfoliage,
+                       va_list ap)
+{
+    canopy_energy_bal_args_struct args;
+
+    /** Read variables from variable length argument list **/
+
+    /* General Model Parameters */
+    args.delta_t = (double) va_arg(ap, double);
+    args.elevation = (double) va_arg(ap, double);
+
+    args.Wmax = (double *) va_arg(ap, double *);
+    args.Wcr = (double *) va_arg(ap, double *);
+    args.Wpwp = (double *) va_arg(ap, double *);
+    args.frost_fract = (double *) va_arg(ap, double *);
+
+    /* Atmopheric Condition and Forcings */
+    args.AirDens = (double) va_arg(ap, double);
+    args.EactAir = (double) va_arg(ap, double);
+    args.Press = (double) va_arg(ap, double);
+    args.Le = (double) va_arg(ap, double);
+    args.Tcanopy = (double) va_arg(ap, double);
+    args.Vpd = (double) va_arg(ap, double);
+    args.shortwave = (double) va_arg(ap, double);
+    args.Catm = (double) va_arg(ap, double);
+    args.dryFrac = (double *) va_arg(ap, double *);
+
+    args.Evap = (double *) va_arg(ap, double *);
+    args.Ra = (double *) va_arg(ap, double *);
+    args.Ra_used = (double *) va_arg(ap, double *);
+    args.Rainfall = (double) va_arg(ap, double);
+    args.Wind = (double *) va_arg(ap, double *);
+
+    /* Vegetation Terms */
+    args.veg_class = (unsigned int) va_arg(ap, unsigned int);
+    args.veg_lib = (veg_lib_struct *) va_arg(ap, veg_lib_struct *);
+
+    args.displacement = (double *) va_arg(ap, double *);
+    args.ref_height = (double *) va_arg(ap, double *);
+    args.roughness = (double *) va_arg(ap, double *);
+
+    args.root = (double *) va_arg(ap, double *);
+    args.CanopLayerBnd = (double *) va_arg(ap, double *);
+
+    /* Water Flux Terms */
+    args.IntRain = (double) va_arg(ap, double);
+    args.IntSnow = (double) va_arg(ap, double);
+
+    args.Wdew = (double *) va_arg(ap, double *);
+
+    args.layer = (layer_data_struct *) va_arg(ap, layer_data_struct *);
+    args.veg_var = (veg_var_struct *) va_arg(ap, veg_var_struct *);
+
+    /* Energy Flux Terms */
+    args.LongOverIn = (double) va_arg(ap, double);
+    args.LongUnderOut = (double) va_arg(ap, double);
+    args.NetShortOver = (double) va_arg(ap, double);
+
+    args.AdvectedEnergy = (double *) va_arg(ap, double *);
+    args.LatentHeat = (double *) va_arg(ap, double *);
+    args.LatentHeatSub = (double *) va_arg(ap, double *);
+    args.LongOverOut = (double *) va_arg(ap, double *);
+    args.NetLongOver = (double *) va_arg(ap, double *);
+    args.NetRadiation = (double *) va_arg(ap, double *);
+    args.RefreezeEnergy = (double *) va_arg(ap, double *);
+    args.SensibleHeat = (double *) va_arg(ap, double *);
+    args.VaporMassFlux = (double *) va_arg(ap, double *);
+
+    set_canopy_energy_bal_terms(&args);
+
+    return func_canopy_energy_bal_ctx(Tfoliage, &args);
+}
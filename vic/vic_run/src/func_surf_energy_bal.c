@@ -34,20 +34,25 @@
 
 /******************************************************************************
  * @brief    Calculate the surface energy balance.
+ * @details  The arguments are read from a surf_energy_bal_args_struct, ctx
+ *           has the signature of the root_brent_ctx() residual.
  *****************************************************************************/
 double
-func_surf_energy_bal(double  Ts,
-                     va_list ap)
+func_surf_energy_bal_ctx(double Ts,
+                         void  *ctx)
 {
     extern parameters_struct param;
     extern option_struct     options;
 
+    surf_energy_bal_args_struct *args;
+
     /* define routine input variables */
 
     /* general model terms */
     size_t             i;
     int                VEG;
     int                veg_class;
+    veg_lib_struct    *veg_lib;
     int                Error;
 
     double             delta_t;
@@ -76,19 +81,12 @@ func_surf_energy_bal(double  Ts,
     double            *Wpwp;
     double            *depth;
     double            *resid_moist;
-    double            *bulk_dens_min;
-    double            *soil_dens_min;
-    double            *quartz;
-    double            *bulk_density;
-    double            *soil_density;
-    double            *organic;
 
     double            *root;
     double            *CanopLayerBnd;
 
     /* meteorological forcing terms */
     int                UnderStory;
-    int                overstory;
 
     double             NetShortBare; // net SW that reaches bare ground
     double             NetShortGrnd; // net SW that penetrates snowpack
@@ -108,13 +106,10 @@ func_surf_energy_bal(double  Ts,
     double            *dryFrac;
 
     double            *Wdew;
-    double            *displacement;
     double            *ra;
     double            *Ra_veg;
     double            *Ra_used;
     double             rainfall;
-    double            *ref_height;
-    double            *roughness;
     double            *wind;
 
     /* latent heat terms */
@@ -171,7 +166,7 @@ func_surf_energy_bal(double  Ts,
     int                EXP_TRANS;
     int                SNOWING;
 
-    int               *FIRST_SOLN;
+    soil_thermal_struct *soil_thermal;
 
     /* returned energy balance terms */
     double            *NetLongBare; // net LW from snow-free ground
@@ -203,141 +198,135 @@ func_surf_energy_bal(double  Ts,
     double             T1_plus;
     double             D1_minus;
     double             D1_plus;
-    double            *transp = NULL;
-    double             Ra_bare[3];
-    double             tmp_wind[3];
-    double             tmp_height;
-    double             tmp_displacement[3];
-    double             tmp_roughness[3];
-    double             tmp_ref_height[3];
+    double             transp[MAX_LAYERS];
+    double             Ra_bare;
     double             ga_veg;
     double             ga_bare;
     double             ga_average;
 
-    /************************************
-       Read variables from variable list
-    ************************************/
+    /*******************************
+       Read variables from arguments
+    *******************************/
+    args = (surf_energy_bal_args_struct *) ctx;
+
 
     /* general model terms */
-    VEG = (int) va_arg(ap, int);
-    veg_class = (int) va_arg(ap, int);
-    delta_t = (double) va_arg(ap, double);
+    VEG = args->VEG;
+    veg_class = args->veg_class;
+    veg_lib = args->veg_lib;
+    delta_t = args->delta_t;
 
     /* soil layer terms */
-    Cs1 = (double) va_arg(ap, double);
-    Cs2 = (double) va_arg(ap, double);
-    D1 = (double) va_arg(ap, double);
-    D2 = (double) va_arg(ap, double);
-    T1_old = (double) va_arg(ap, double);
-    T2 = (double) va_arg(ap, double);
-    Ts_old = (double) va_arg(ap, double);
-    Told_node = (double *) va_arg(ap, double *);
-    bubble = (double) va_arg(ap, double);
-    dp = (double) va_arg(ap, double);
-    expt = (double) va_arg(ap, double);
-    ice0 = (double) va_arg(ap, double);
-    kappa1 = (double) va_arg(ap, double);
-    kappa2 = (double) va_arg(ap, double);
-    max_moist = (double) va_arg(ap, double);
-    moist = (double) va_arg(ap, double);
-
-    root = (double  *) va_arg(ap, double  *);
-    CanopLayerBnd = (double *) va_arg(ap, double *);
+    Cs1 = args->Cs1;
+    Cs2 = args->Cs2;
+    D1 = args->D1;
+    D2 = args->D2;
+    T1_old = args->T1_old;
+    T2 = args->T2;
+    Ts_old = args->Ts_old;
+    Told_node = args->Told_node;
+    bubble = args->bubble;
+    dp = args->dp;
+    expt = args->expt;
+    ice0 = args->ice0;
+    kappa1 = args->kappa1;
+    kappa2 = args->kappa2;
+    max_moist = args->max_moist;
+    moist = args->moist;
+
+    root = args->root;
+    CanopLayerBnd = args->CanopLayerBnd;
 
     /* meteorological forcing terms */
-    UnderStory = (int) va_arg(ap, int);
-    overstory = (int) va_arg(ap, int);
-
-    NetShortBare = (double) va_arg(ap, double);
-    NetShortGrnd = (double) va_arg(ap, double);
-    NetShortSnow = (double) va_arg(ap, double);
-    Tair = (double) va_arg(ap, double);
-    atmos_density = (double) va_arg(ap, double);
-    atmos_pressure = (double) va_arg(ap, double);
-    emissivity = (double) va_arg(ap, double);
-    LongBareIn = (double) va_arg(ap, double);
-    LongSnowIn = (double) va_arg(ap, double);
-    surf_atten = (double) va_arg(ap, double);
-    vp = (double) va_arg(ap, double);
-    vpd = (double) va_arg(ap, double);
-    shortwave = (double) va_arg(ap, double);
-    Catm = (double) va_arg(ap, double);
-    dryFrac = (double *) va_arg(ap, double *);
-
-    Wdew = (double *) va_arg(ap, double *);
-    displacement = (double *) va_arg(ap, double *);
-    ra = (double *) va_arg(ap, double *);
-    Ra_veg = (double *) va_arg(ap, double *);
-    Ra_used = (double *) va_arg(ap, double *);
-    rainfall = (double) va_arg(ap, double);
-    ref_height = (double *) va_arg(ap, double *);
-    roughness = (double *) va_arg(ap, double *);
-    wind = (double *) va_arg(ap, double *);
+    UnderStory = args->UnderStory;
+
+    NetShortBare = args->NetShortBare;
+    NetShortGrnd = args->NetShortGrnd;
+    NetShortSnow = args->NetShortSnow;
+    Tair = args->Tair;
+    atmos_density = args->atmos_density;
+    atmos_pressure = args->atmos_pressure;
+    emissivity = args->emissivity;
+    LongBareIn = args->LongBareIn;
+    LongSnowIn = args->LongSnowIn;
+    surf_atten = args->surf_atten;
+    vp = args->vp;
+    vpd = args->vpd;
+    shortwave = args->shortwave;
+    Catm = args->Catm;
+    dryFrac = args->dryFrac;
+
+    Wdew = args->Wdew;
+    ra = args->ra;
+    Ra_veg = args->Ra_veg;
+    Ra_used = args->Ra_used;
+    rainfall = args->rainfall;
+    wind = args->wind;
 
     /* latent heat terms */
-    Le = (double) va_arg(ap, double);
+    Le = args->Le;
 
     /* snowpack terms */
-    Advection = (double) va_arg(ap, double);
-    OldTSurf = (double) va_arg(ap, double);
-    Tsnow_surf = (double) va_arg(ap, double);
-    kappa_snow = (double) va_arg(ap, double);
-    melt_energy = (double) va_arg(ap, double);
-    snow_coverage = (double) va_arg(ap, double);
-    snow_density = (double) va_arg(ap, double);
-    snow_swq = (double) va_arg(ap, double);
-    snow_water = (double) va_arg(ap, double);
-
-    deltaCC = (double *) va_arg(ap, double *);
-    refreeze_energy = (double *) va_arg(ap, double *);
-    vapor_flux = (double *) va_arg(ap, double *);
-    blowing_flux = (double *) va_arg(ap, double *);
-    surface_flux = (double *) va_arg(ap, double *);
+    Advection = args->Advection;
+    OldTSurf = args->OldTSurf;
+    Tsnow_surf = args->Tsnow_surf;
+    kappa_snow = args->kappa_snow;
+    melt_energy = args->melt_energy;
+    snow_coverage = args->snow_coverage;
+    snow_density = args->snow_density;
+    snow_swq = args->snow_swq;
+    snow_water = args->snow_water;
+
+    deltaCC = args->deltaCC;
+    refreeze_energy = args->refreeze_energy;
+    vapor_flux = args->vapor_flux;
+    blowing_flux = args->blowing_flux;
+    surface_flux = args->surface_flux;
 
     /* soil node terms */
-    Nnodes = (int) va_arg(ap, int);
-
-    Cs_node = (double *) va_arg(ap, double *);
-    T_node = (double *) va_arg(ap, double *);
-    Tnew_node = (double *) va_arg(ap, double *);
-    Tnew_fbflag = (char *) va_arg(ap, char *);
-    Tnew_fbcount = (unsigned *) va_arg(ap, unsigned *);
-    alpha = (double *) va_arg(ap, double *);
-    beta = (double *) va_arg(ap, double *);
-    bubble_node = (double *) va_arg(ap, double *);
-    Zsum_node = (double *) va_arg(ap, double *);
-    expt_node = (double *) va_arg(ap, double *);
-    gamma = (double *) va_arg(ap, double *);
-    ice_node = (double *) va_arg(ap, double *);
-    kappa_node = (double *) va_arg(ap, double *);
-    max_moist_node = (double *) va_arg(ap, double *);
-    moist_node = (double *) va_arg(ap, double *);
+    Nnodes = args->Nnodes;
+
+    Cs_node = args->Cs_node;
+    T_node = args->T_node;
+    Tnew_node = args->Tnew_node;
+    Tnew_fbflag = args->Tnew_fbflag;
+    Tnew_fbcount = args->Tnew_fbcount;
+    alpha = args->alpha;
+    beta = args->beta;
+    bubble_node = args->bubble_node;
+    Zsum_node = args->Zsum_node;
+    expt_node = args->expt_node;
+    gamma = args->gamma;
+    ice_node = args->ice_node;
+    kappa_node = args->kappa_node;
+    max_moist_node = args->max_moist_node;
+    moist_node = args->moist_node;
 
     /* model structures */
-    soil_con = (soil_con_struct *) va_arg(ap, soil_con_struct *);
-    layer = (layer_data_struct *) va_arg(ap, layer_data_struct *);
-    veg_var = (veg_var_struct *) va_arg(ap, veg_var_struct *);
+    soil_con = args->soil_con;
+    layer = args->layer;
+    veg_var = args->veg_var;
 
     /* control flags */
-    INCLUDE_SNOW = (int) va_arg(ap, int);
-    NOFLUX = (int) va_arg(ap, int);
-    EXP_TRANS = (int) va_arg(ap, int);
-    SNOWING = (int) va_arg(ap, int);
+    INCLUDE_SNOW = args->INCLUDE_SNOW;
+    NOFLUX = args->NOFLUX;
+    EXP_TRANS = args->EXP_TRANS;
+    SNOWING = args->SNOWING;
 
-    FIRST_SOLN = (int *) va_arg(ap, int *);
+    soil_thermal = args->soil_thermal;
 
     /* returned energy balance terms */
-    NetLongBare = (double *) va_arg(ap, double *);
-    NetLongSnow = (double *) va_arg(ap, double *);
-    T1 = (double *) va_arg(ap, double *);
-    deltaH = (double *) va_arg(ap, double *);
-    fusion = (double *) va_arg(ap, double *);
-    grnd_flux = (double *) va_arg(ap, double *);
-    latent_heat = (double *) va_arg(ap, double *);
-    latent_heat_sub = (double *) va_arg(ap, double *);
-    sensible_heat = (double *) va_arg(ap, double *);
-    snow_flux = (double *) va_arg(ap, double *);
-    store_error = (double *) va_arg(ap, double *);
+    NetLongBare = args->NetLongBare;
+    NetLongSnow = args->NetLongSnow;
+    T1 = args->T1;
+    deltaH = args->deltaH;
+    fusion = args->fusion;
+    grnd_flux = args->grnd_flux;
+    latent_heat = args->latent_heat;
+    latent_heat_sub = args->latent_heat_sub;
+    sensible_heat = args->sensible_heat;
+    snow_flux = args->snow_flux;
+    store_error = args->store_error;
 
     /* take additional variables from soil_con structure */
     b_infilt = soil_con->b_infilt;
@@ -349,13 +338,6 @@ func_surf_energy_bal(double  Ts,
     elevation = (double)soil_con->elevation;
     frost_fract = soil_con->frost_fract;
     FS_ACTIVE = soil_con->FS_ACTIVE;
-    /* more soil layer terms for IMPLICIT option*/
-    bulk_dens_min = soil_con->bulk_dens_min;
-    soil_dens_min = soil_con->soil_dens_min;
-    quartz = soil_con->quartz;
-    bulk_density = soil_con->bulk_density;
-    soil_density = soil_con->soil_density;
-    organic = soil_con->organic;
 
 
     /***************
@@ -366,9 +348,7 @@ func_surf_energy_bal(double  Ts,
 
     TMean = Ts;
 
-    transp = calloc(options.Nlayer, sizeof(*transp));
-    check_alloc_status(transp, "Memory allocation error.");
-    for (i = 0; i < options.Nlayer; i++) {
+    for (i = 0; i < OPT_Nlayer; i++) {
         transp[i] = 0.;
     }
 
@@ -395,7 +375,7 @@ func_surf_energy_bal(double  Ts,
        Estimate soil temperatures for ground heat flux calculations
     ***************************************************************/
 
-    if (options.QUICK_FLUX) {
+    if (OPT_QUICK_FLUX) {
         /**************************************************************
            Use Liang et al. 1999 Equations to Calculate Ground Heat Flux
            NOTE: T2 is not the temperature of layer 2, nor of node 2, nor at depth dp;
@@ -437,34 +417,36 @@ func_surf_energy_bal(double  Ts,
 
         /* IMPLICIT Solution */
         if (options.IMPLICIT) {
+            perf_region_start(PERF_FROZEN_SOIL);
             Error = solve_T_profile_implicit(Tnew_node, T_node, Tnew_fbflag,
                                              Tnew_fbcount, Zsum_node,
                                              kappa_node, Cs_node, moist_node,
                                              delta_t, max_moist_node,
                                              bubble_node, expt_node, ice_node,
                                              alpha, beta, gamma, dp, Nnodes,
-                                             FIRST_SOLN, NOFLUX, EXP_TRANS,
-                                             bulk_dens_min, soil_dens_min,
-                                             quartz, bulk_density,
-                                             soil_density, organic, depth);
+                                             soil_thermal, NOFLUX, EXP_TRANS,
+                                             soil_con->thermal_coef, depth);
+            perf_region_stop(PERF_FROZEN_SOIL);
 
-            if (FIRST_SOLN[1]) {
-                FIRST_SOLN[1] = false;
+            if (soil_thermal->FIRST_SOLN[1]) {
+                soil_thermal->FIRST_SOLN[1] = false;
             }
         }
 
         /* EXPLICIT Solution, or if IMPLICIT Solution Failed */
         if (!options.IMPLICIT || Error == 1) {
             if (options.IMPLICIT) {
-                FIRST_SOLN[0] = true;
+                soil_thermal->FIRST_SOLN[0] = true;
             }
+            perf_region_start(PERF_FROZEN_SOIL);
             Error = solve_T_profile(Tnew_node, T_node, Tnew_fbflag,
                                     Tnew_fbcount, Zsum_node, kappa_node,
                                     Cs_node, moist_node, delta_t,
                                     max_moist_node, bubble_node,
                                     expt_node, ice_node, alpha, beta, gamma, dp,
-                                    Nnodes, FIRST_SOLN, FS_ACTIVE, NOFLUX,
+                                    Nnodes, soil_thermal, FS_ACTIVE, NOFLUX,
                                     EXP_TRANS);
+            perf_region_stop(PERF_FROZEN_SOIL);
         }
 
         if ((int) Error == ERROR) {
@@ -558,7 +540,7 @@ func_surf_energy_bal(double  Ts,
     /******************************************************
        Compute the change in heat due to solid-liquid phase changes in the region between layers 0 and 1
     ******************************************************/
-    if (FS_ACTIVE && options.FROZEN_SOIL) {
+    if (FS_ACTIVE && OPT_FROZEN_SOIL) {
         if (!options.EXP_TRANS) {
             if ((TMean + *T1) / 2. < 0.) {
                 ice = moist - maximum_unfrozen_water((TMean + *T1) / 2.,
@@ -664,19 +646,10 @@ func_surf_energy_bal(double  Ts,
         (NetShortBare + (*NetLongBare) + *grnd_flux + *deltaH + *fusion);
 
     /** Compute atmospheric stability correction **/
-    if (wind[UnderStory] > 0.0 && overstory && SNOWING) {
-        Ra_veg[0] = ra[UnderStory] /
-                    StabilityCorrection(ref_height[UnderStory], 0., TMean,
-                                        Tair,
-                                        wind[UnderStory],
-                                        roughness[UnderStory]);
-    }
-    else if (wind[UnderStory] > 0.0) {
+    if (wind[UnderStory] > 0.0) {
         Ra_veg[0] = ra[UnderStory] /
-                    StabilityCorrection(ref_height[UnderStory],
-                                        displacement[UnderStory],
-                                        TMean, Tair, wind[UnderStory],
-                                        roughness[UnderStory]);
+                    StabilityCorrection_coef(TMean, Tair, wind[UnderStory],
+                                             &(args->stab_veg));
     }
     else {
         Ra_veg[0] = param.HUGE_RESIST;
@@ -705,28 +678,17 @@ func_surf_energy_bal(double  Ts,
         if (Ra_veg[0] > 0) {
             /** aerodynamic conductance under vegetation **/
             ga_veg = 1 / Ra_veg[0];
-            /** compute aerodynamic resistance over exposed soil (Ra_bare) **/
-            tmp_wind[0] = wind[0];
-            tmp_wind[1] = MISSING; // unused
-            tmp_wind[2] = MISSING; // unused
-            tmp_height = soil_con->rough / param.VEG_RATIO_RL_HEIGHT;
-            tmp_displacement[0] = calc_veg_displacement(tmp_height);
-            tmp_roughness[0] = soil_con->rough;
-            tmp_ref_height[0] = param.SOIL_WINDH; // wind height over bare soil
-            Error = CalcAerodynamic(0, 0, 0, soil_con->snow_rough,
-                                    soil_con->rough, 0, Ra_bare, tmp_wind,
-                                    tmp_displacement, tmp_ref_height,
-                                    tmp_roughness);
-            Ra_bare[0] /= StabilityCorrection(tmp_ref_height[0],
-                                              tmp_displacement[0], TMean,
-                                              Tair, tmp_wind[0],
-                                              tmp_roughness[0]);
+            /** compute aerodynamic resistance over exposed soil (Ra_bare);
+                the neutral resistance is set by set_surf_energy_bal_aero **/
+            Ra_bare = args->Ra_bare /
+                      StabilityCorrection_coef(TMean, Tair, args->U_bare,
+                                               &(args->stab_bare));
 
             /** if Ra_bare is non-zero, compute area-weighted average
                 aerodynamic conductance **/
-            if (Ra_bare[0] > 0) {
+            if (Ra_bare > 0) {
                 /** aerodynamic conductance over exposed soil **/
-                ga_bare = 1 / Ra_bare[0];
+                ga_bare = 1 / Ra_bare;
                 /** area-weighted average aerodynamic conductance **/
                 ga_average = veg_var->fcanopy * ga_veg +
                              (1 - veg_var->fcanopy) * ga_bare;
@@ -755,12 +717,13 @@ func_surf_energy_bal(double  Ts,
     *************************************************/
     if (VEG && !SNOWING && veg_var->fcanopy > 0) {
         Evap = canopy_evap(layer, veg_var, true,
-                           veg_class, Wdew, delta_t, NetBareRad, vpd,
+                           veg_class, veg_lib, Wdew, delta_t, NetBareRad, vpd,
                            NetShortBare, Tair, Ra_veg[1], elevation, rainfall,
                            Wmax, Wcr, Wpwp, frost_fract, root, dryFrac,
-                           shortwave, Catm, CanopLayerBnd);
+                           shortwave, Catm, CanopLayerBnd,
+                           &(args->penman_atmos));
         if (veg_var->fcanopy < 1) {
-            for (i = 0; i < options.Nlayer; i++) {
+            for (i = 0; i < OPT_Nlayer; i++) {
                 transp[i] = layer[i].evap;
                 layer[i].evap = 0.;
             }
@@ -770,7 +733,7 @@ func_surf_energy_bal(double  Ts,
                               depth[0], max_moist * depth[0] * MM_PER_M,
                               elevation, b_infilt, Ra_used[0], delta_t,
                               resid_moist[0], frost_fract);
-            for (i = 0; i < options.Nlayer; i++) {
+            for (i = 0; i < OPT_Nlayer; i++) {
                 layer[i].evap = veg_var->fcanopy * transp[i] +
                                 (1 - veg_var->fcanopy) * layer[i].evap;
                 if (layer[i].evap > 0.) {
@@ -790,7 +753,7 @@ func_surf_energy_bal(double  Ts,
             veg_var->Wdew *= veg_var->fcanopy;
         }
         else {
-            for (i = 0; i < options.Nlayer; i++) {
+            for (i = 0; i < OPT_Nlayer; i++) {
                 layer[i].bare_evap_frac = 0.;
             }
         }
@@ -800,7 +763,7 @@ func_surf_energy_bal(double  Ts,
                          depth[0], max_moist * depth[0] * MM_PER_M,
                          elevation, b_infilt, Ra_used[0], delta_t,
                          resid_moist[0], frost_fract);
-        for (i = 0; i < options.Nlayer; i++) {
+        for (i = 0; i < OPT_Nlayer; i++) {
             layer[i].bare_evap_frac = 1;
         }
     }
@@ -808,8 +771,6 @@ func_surf_energy_bal(double  Ts,
         Evap = 0.;
     }
 
-    free(transp);
-
     /**********************************************************************
        Compute the Latent Heat Flux from the Surface and Covering Vegetation
     **********************************************************************/
@@ -882,3 +843,197 @@ func_surf_energy_bal(double  Ts,
 
     return error;
 }
+
+/******************************************************************************
+ * @brief    Set the aerodynamic terms of the surface energy balance residual
+ *           that do not depend on the surface temperature: the stability
+ *           correction terms of the understory and the neutral aerodynamic
+ *           resistance and wind over exposed soil between plants. The
+ *           Penman-Monteith terms of the canopy air temperature are set here
+ *           as well.
+ *****************************************************************************/
+void
+set_surf_energy_bal_aero(surf_energy_bal_args_struct *args)
+{
+    extern parameters_struct param;
+
+    double                   Ra_bare[3];
+    double                   tmp_wind[3];
+    double                   tmp_height;
+    double                   tmp_displacement[3];
+    double                   tmp_roughness[3];
+    double                   tmp_ref_height[3];
+    int                      UnderStory;
+
+    UnderStory = args->UnderStory;
+    if (args->wind[UnderStory] > 0.0 && args->overstory && args->SNOWING) {
+        set_stability_coef(args->ref_height[UnderStory], 0.,
+                           args->roughness[UnderStory], &(args->stab_veg));
+    }
+    else if (args->wind[UnderStory] > 0.0) {
+        set_stability_coef(args->ref_height[UnderStory],
+                           args->displacement[UnderStory],
+                           args->roughness[UnderStory], &(args->stab_veg));
+    }
+
+    if (args->veg_var->fcanopy < 1) {
+        tmp_wind[0] = args->wind[0];
+        tmp_wind[1] = MISSING; // unused
+        tmp_wind[2] = MISSING; // unused
+        tmp_height = args->soil_con->rough / param.VEG_RATIO_RL_HEIGHT;
+        tmp_displacement[0] = calc_veg_displacement(tmp_height);
+        tmp_roughness[0] = args->soil_con->rough;
+        tmp_ref_height[0] = param.SOIL_WINDH; // wind height over bare soil
+        CalcAerodynamic(0, 0, 0, args->soil_con->snow_rough,
+                        args->soil_con->rough, 0, Ra_bare, tmp_wind,
+                        tmp_displacement, tmp_ref_height, tmp_roughness);
+        args->Ra_bare = Ra_bare[0];
+        args->U_bare = tmp_wind[0];
+        set_stability_coef(tmp_ref_height[0], tmp_displacement[0],
+                           tmp_roughness[0], &(args->stab_bare));
+    }
+
+    if (args->VEG) {
+        set_penman_atmos(args->Tair, args->soil_con->elevation,
+                         &(args->penman_atmos));
+    }
+}
+
+/******************************************************************************
+ * @brief    Calculate the surface energy balance from a variable argument
+ *           list, in the order of the surf_energy_bal_args_struct members.
+ *****************************************************************************/
+double
+func_surf_energy_bal(double  Ts,
+                     va_list ap)
+{
+    surf_energy_bal_args_struct args;
+
+
+    /* general model terms */
+    args.VEG = (int) va_arg(ap, int);
+    args.veg_class = (int) va_arg(ap, int);
+    args.veg_lib = (veg_lib_struct *) va_arg(ap, veg_lib_struct *);
+    args.delta_t = (double) va_arg(ap, double);
+
+    /* soil layer terms */
+    args.Cs1 = (double) va_arg(ap, double);
+    args.Cs2 = (double) va_arg(ap, double);
+    args.D1 = (double) va_arg(ap, double);
+    args.D2 = (double) va_arg(ap, double);
+    args.T1_old = (double) va_arg(ap, double);
+    args.T2 = (double) va_arg(ap, double);
+    args.Ts_old = (double) va_arg(ap, double);
+    args.Told_node = (double *) va_arg(ap, double *);
+    args.bubble = (double) va_arg(ap, double);
+    args.dp = (double) va_arg(ap, double);
+    args.expt = (double) va_arg(ap, double);
+    args.ice0 = (double) va_arg(ap, double);
+    args.kappa1 = (double) va_arg(ap, double);
+    args.kappa2 = (double) va_arg(ap, double);
+    args.max_moist = (double) va_arg(ap, double);
+    args.moist = (double) va_arg(ap, double);
+
+    args.root = (double *) va_arg(ap, double *);
+    args.CanopLayerBnd = (double *) va_arg(ap, double *);
+
+    /* meteorological forcing terms */
+    args.UnderStory = (int) va_arg(ap, int);
+    args.overstory = (int) va_arg(ap, int);
+
+    args.NetShortBare = (double) va_arg(ap, double);
+    args.NetShortGrnd = (double) va_arg(ap, double);
+    args.NetShortSnow = (double) va_arg(ap, double);
+    args.Tair = (double) va_arg(ap, double);
+    args.atmos_density = (double) va_arg(ap, double);
+    args.atmos_pressure = (double) va_arg(ap, double);
+    args.emissivity = (double) va_arg(ap, double);
+    args.LongBareIn = (double) va_arg(ap, double);
+    args.LongSnowIn = (double) va_arg(ap, double);
+    args.surf_atten = (double) va_arg(ap, double);
+    args.vp = (double) va_arg(ap, double);
+    args.vpd = (double) va_arg(ap, double);
+    args.shortwave = (double) va_arg(ap, double);
+    args.Catm = (double) va_arg(ap, double);
+    args.dryFrac = (double *) va_arg(ap, double *);
+
+    args.Wdew = (double *) va_arg(ap, double *);
+    args.displacement = (double *) va_arg(ap, double *);
+    args.ra = (double *) va_arg(ap, double *);
+    args.Ra_veg = (double *) va_arg(ap, double *);
+    args.Ra_used = (double *) va_arg(ap, double *);
+    args.rainfall = (double) va_arg(ap, double);
+    args.ref_height = (double *) va_arg(ap, double *);
+    args.roughness = (double *) va_arg(ap, double *);
+    args.wind = (double *) va_arg(ap, double *);
+
+    /* latent heat terms */
+    args.Le = (double) va_arg(ap, double);
+
+    /* snowpack terms */
+    args.Advection = (double) va_arg(ap, double);
+    args.OldTSurf = (double) va_arg(ap, double);
+    args.Tsnow_surf = (double) va_arg(ap, double);
+    args.kappa_snow = (double) va_arg(ap, double);
+    args.melt_energy = (double) va_arg(ap, double);
+    args.snow_coverage = (double) va_arg(ap, double);
+    args.snow_density = (double) va_arg(ap, double);
+    args.snow_swq = (double) va_arg(ap, double);
+    args.snow_water = (double) va_arg(ap, double);
+
+    args.deltaCC = (double *) va_arg(ap, double *);
+    args.refreeze_energy = (double *) va_arg(ap, double *);
+    args.vapor_flux = (double *) va_arg(ap, double *);
+    args.blowing_flux = (double *) va_arg(ap, double *);
+    args.surface_flux = (double *) va_arg(ap, double *);
+
+    /* soil node terms */
+    args.Nnodes = (int) va_arg(ap, int);
+
+    args.Cs_node = (double *) va_arg(ap, double *);
+    args.T_node = (double *) va_arg(ap, double *);
+    args.Tnew_node = (double *) va_arg(ap, double *);
+    args.Tnew_fbflag = (char *) va_arg(ap, char *);
+    args.Tnew_fbcount = (unsigned *) va_arg(ap, unsigned *);
+    args.alpha = (double *) va_arg(ap, double *);
+    args.beta = (double *) va_arg(ap, double *);
+    args.bubble_node = (double *) va_arg(ap, double *);
+    args.Zsum_node = (double *) va_arg(ap, double *);
+    args.expt_node = (double *) va_arg(ap, double *);
+    args.gamma = (double *) va_arg(ap, double *);
+    args.ice_node = (double *) va_arg(ap, double *);
+    args.kappa_node = (double *) va_arg(ap, double *);
+    args.max_moist_node = (double *) va_arg(ap, double *);
+    args.moist_node = (double *) va_arg(ap, double *);
+
+    /* model structures */
+    args.soil_con = (soil_con_struct *) va_arg(ap, soil_con_struct *);
+    args.layer = (layer_data_struct *) va_arg(ap, layer_data_struct *);
+    args.veg_var = (veg_var_struct *) va_arg(ap, veg_var_struct *);
+
+    /* control flags */
+    args.INCLUDE_SNOW = (int) va_arg(ap, int);
+    args.NOFLUX = (int) va_arg(ap, int);
+    args.EXP_TRANS = (int) va_arg(ap, int);
+    args.SNOWING = (int) va_arg(ap, int);
+
+    args.soil_thermal =
+        (soil_thermal_struct *) va_arg(ap, soil_thermal_struct *);
+
+    /* returned energy balance terms */
+    args.NetLongBare = (double *) va_arg(ap, double *);
+    args.NetLongSnow = (double *) va_arg(ap, double *);
+    args.T1 = (double *) va_arg(ap, double *);
+    args.deltaH = (double *) va_arg(ap, double *);
+    args.fusion = (double *) va_arg(ap, double *);
+    args.grnd_flux = (double *) va_arg(ap, double *);
+    args.latent_heat = (double *) va_arg(ap, double *);
+    args.latent_heat_sub = (double *) va_arg(ap, double *);
+    args.sensible_heat = (double *) va_arg(ap, double *);
+    args.snow_flux = (double *) va_arg(ap, double *);
+    args.store_error = (double *) va_arg(ap, double *);
+
+    set_surf_energy_bal_aero(&args);
+
+    return func_surf_energy_bal_ctx(Ts, &args);
+}
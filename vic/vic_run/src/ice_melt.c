@@ -197,7 +197,7 @@ ice_melt(double            z2,
     // flat terrain. Fetch = 2000 m (i.e. unlimited fetch), roughness and displacement
     // calculated assuming 10 cm high protrusions on frozen ponds.
 
-    if (options.BLOWING && snow->swq > 0.) {
+    if (OPT_BLOWING && snow->swq > 0.) {
         Ls = calc_latent_heat_of_sublimation(snow->surf_temp);
         snow->blowing_flux = CalcBlowingSnow(delta_t, air_temp,
                                              snow->last_snow, snow->surf_water,
@@ -637,10 +637,17 @@ double
 ErrorIcePackEnergyBalance(double Tsurf,
                           ...)
 {
-    va_list ap;                 /* Used in traversing variable argument list
-                                 */
-    double  Qnet;                /* Net energy exchange at the IcePack snow
-                                    surface (W/m^2) */
+    va_list       ap;                 /* Used in traversing variable argument list
+                                       */
+    double        Qnet;                /* Net energy exchange at the IcePack snow
+                                          surface (W/m^2) */
+    static size_t dump_count = 0;
+
+    // the variable values are only dumped for the first LOG_WARN_REPEAT
+    // failures, later failures return at once
+    if (!count_log_repeat(&dump_count, __FILE__, __LINE__)) {
+        return(ERROR);
+    }
 
     va_start(ap, Tsurf);
     Qnet = ErrorPrintIcePackEnergyBalance(Tsurf, ap);
@@ -33,7 +33,7 @@
  *****************************************************************************/
 void
 initialize_lake(lake_var_struct  *lake,
-                lake_con_struct   lake_con,
+                lake_con_struct  *lake_con,
                 soil_con_struct  *soil_con,
                 cell_data_struct *cell,
                 bool              preserve_essentials)
@@ -222,7 +222,7 @@ initialize_lake(lake_var_struct  *lake,
     }
     lake->soil.zwt = 0.0;
     lake->soil.zwt_lumped = 0.0;
-    if (options.CARBON) {
+    if (OPT_CARBON) {
         lake->soil.RhLitter = 0.0;
         lake->soil.RhLitter2Atm = 0.0;
         lake->soil.RhInter = 0.0;
@@ -26,14 +26,65 @@
 
 #include <vic_run.h>
 
+/******************************************************************************
+ * @brief    Function to compute the volume of the lake basin below each lake
+ *           node, stored in lake_con->basin_volume for get_volume() and
+ *           get_depth().
+ *****************************************************************************/
+void
+compute_lake_basin_volume(lake_con_struct *lake_con)
+{
+    int i;
+
+    lake_con->basin_volume[lake_con->numnod] = 0.0;
+    for (i = lake_con->numnod - 1; i >= 0; i--) {
+        lake_con->basin_volume[i] = lake_con->basin_volume[i + 1] +
+                                    (lake_con->basin[i] +
+                                     lake_con->basin[i + 1]) *
+                                    (lake_con->z[i] - lake_con->z[i + 1]) / 2.;
+    }
+}
+
+/******************************************************************************
+ * @brief    Function to find the lake basin layer holding a given depth.
+ *
+ * @details  Returns the smallest node index i with z[i + 1] < depth (or
+ *           z[i + 1] <= depth if closed is true), searching the nodes from 0
+ *           to numnod - 1 by bisection. z decreases with the node index.
+ *****************************************************************************/
+static size_t
+get_lake_layer(lake_con_struct *lake_con,
+               double           depth,
+               bool             closed)
+{
+    size_t lo;
+    size_t hi;
+    size_t mid;
+
+    lo = 0;
+    hi = lake_con->numnod - 1;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (depth > lake_con->z[mid + 1] ||
+            (closed && depth == lake_con->z[mid + 1])) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+
+    return lo;
+}
+
 /******************************************************************************
  * @brief    Function to compute surface area of liquid water in the lake,
  *           given the current depth of liquid water.
  *****************************************************************************/
 int
-get_sarea(lake_con_struct lake_con,
-          double          depth,
-          double         *sarea)
+get_sarea(lake_con_struct *lake_con,
+          double           depth,
+          double          *sarea)
 {
     size_t i;
     int    status;
@@ -41,22 +92,16 @@ get_sarea(lake_con_struct lake_con,
     status = 0;
     *sarea = 0.0;
 
-    if (depth > lake_con.z[0]) {
-        *sarea = lake_con.basin[0];
+    if (depth > lake_con->z[0]) {
+        *sarea = lake_con->basin[0];
     }
     else {
-        for (i = 0; i < lake_con.numnod; i++) {
-            if (depth <= lake_con.z[i] && depth > lake_con.z[i + 1]) {
-                *sarea =
-                    lake_con.basin[i +
-                                   1] +
-                    (depth -
-                     lake_con.z[i +
-                                1]) *
-                    (lake_con.basin[i] -
-                     lake_con.basin[i +
-                                    1]) / (lake_con.z[i] - lake_con.z[i + 1]);
-            }
+        if (depth > lake_con->z[lake_con->numnod]) {
+            i = get_lake_layer(lake_con, depth, false);
+            *sarea = lake_con->basin[i + 1] +
+                     (depth - lake_con->z[i + 1]) *
+                     (lake_con->basin[i] - lake_con->basin[i + 1]) /
+                     (lake_con->z[i] - lake_con->z[i + 1]);
         }
         if (*sarea == 0.0 && depth != 0.0) {
             status = ERROR;
@@ -71,39 +116,32 @@ get_sarea(lake_con_struct lake_con,
  *           basin, given the current depth of liquid water.
  *****************************************************************************/
 int
-get_volume(lake_con_struct lake_con,
-           double          depth,
-           double         *volume)
+get_volume(lake_con_struct *lake_con,
+           double           depth,
+           double          *volume)
 {
-    int    i;
+    size_t i;
     int    status;
     double m;
 
     status = 0;
     *volume = 0.0;
 
-    if (depth > lake_con.z[0]) {
+    if (depth > lake_con->z[0]) {
         status = 1;
-        *volume = lake_con.maxvolume;
+        *volume = lake_con->maxvolume + lake_con->basin_volume[0];
     }
-
-    for (i = lake_con.numnod - 1; i >= 0; i--) {
-        if (depth >= lake_con.z[i]) {
-            *volume +=
-                (lake_con.basin[i] +
-                 lake_con.basin[i +
-                                1]) * (lake_con.z[i] - lake_con.z[i + 1]) / 2.;
-        }
-        else if (depth < lake_con.z[i] && depth >= lake_con.z[i + 1]) {
-            m =
-                (lake_con.basin[i] -
-                 lake_con.basin[i + 1]) / (lake_con.z[i] - lake_con.z[i + 1]);
-            *volume +=
-                (depth -
-                 lake_con.z[i +
-                            1]) *
-                (m * (depth - lake_con.z[i + 1]) / 2. + lake_con.basin[i + 1]);
-        }
+    else if (depth == lake_con->z[0]) {
+        *volume = lake_con->basin_volume[0];
+    }
+    else if (depth >= lake_con->z[lake_con->numnod]) {
+        i = get_lake_layer(lake_con, depth, true);
+        m = (lake_con->basin[i] - lake_con->basin[i + 1]) /
+            (lake_con->z[i] - lake_con->z[i + 1]);
+        *volume = lake_con->basin_volume[i + 1] +
+                  (depth - lake_con->z[i + 1]) *
+                  (m * (depth - lake_con->z[i + 1]) / 2. +
+                   lake_con->basin[i + 1]);
     }
 
     if (*volume == 0.0 && depth != 0.0) {
@@ -119,11 +157,13 @@ get_volume(lake_con_struct lake_con,
  *           liquid water currently stored in lake.
  *****************************************************************************/
 int
-get_depth(lake_con_struct lake_con,
-          double          volume,
-          double         *depth)
+get_depth(lake_con_struct *lake_con,
+          double           volume,
+          double          *depth)
 {
-    int    k;
+    size_t lo;
+    size_t hi;
+    size_t k;
     int    status;
     double m;
     double tempvolume;
@@ -135,53 +175,49 @@ get_depth(lake_con_struct lake_con,
         status = 1;
     }
 
-    if (volume >= lake_con.maxvolume) {
-        *depth = lake_con.maxdepth;
-        *depth += (volume - lake_con.maxvolume) / lake_con.basin[0];
+    if (volume >= lake_con->maxvolume) {
+        *depth = lake_con->maxdepth;
+        *depth += (volume - lake_con->maxvolume) / lake_con->basin[0];
     }
     else if (volume < DBL_EPSILON) {
         *depth = 0.0;
     }
+    else if (volume > lake_con->basin_volume[0]) {
+        // all layers filled, the remainder is a rounding error
+        *depth = lake_con->z[0];
+        tempvolume = volume - lake_con->basin_volume[0];
+        if (tempvolume / lake_con->basin[0] > DBL_EPSILON) {
+            status = ERROR;
+        }
+    }
     else {
-        // Update lake depth
-        *depth = 0.0;
-        tempvolume = volume;
-        for (k = lake_con.numnod - 1; k >= 0; k--) {
-            if (tempvolume > ((lake_con.z[k] - lake_con.z[k + 1]) *
-                              (lake_con.basin[k] +
-                               lake_con.basin[k + 1]) / 2.)) {
-                // current layer completely filled
-                tempvolume -=
-                    (lake_con.z[k] -
-                     lake_con.z[k +
-                                1]) *
-                    (lake_con.basin[k] + lake_con.basin[k + 1]) / 2.;
-                *depth += lake_con.z[k] - lake_con.z[k + 1];
+        // smallest k with basin_volume[k + 1] < volume, basin_volume
+        // decreases with the node index
+        lo = 0;
+        hi = lake_con->numnod - 1;
+        while (lo < hi) {
+            k = (lo + hi) / 2;
+            if (volume > lake_con->basin_volume[k + 1]) {
+                hi = k;
             }
-            else if (tempvolume > 0.0) {
-                if (lake_con.basin[k] == lake_con.basin[k + 1]) {
-                    *depth += tempvolume / lake_con.basin[k + 1];
-                    tempvolume = 0.0;
-                }
-                else {
-                    m =
-                        (lake_con.basin[k] -
-                         lake_con.basin[k +
-                                        1]) /
-                        (lake_con.z[k] - lake_con.z[k + 1]);
-                    *depth +=
-                        ((-1 *
-                          lake_con.basin[k +
-                                         1]) +
-                         sqrt(lake_con.basin[k +
-                                             1] *
-                              lake_con.basin[k + 1] + 2. * m * tempvolume)) / m;
-                    tempvolume = 0.0;
-                }
+            else {
+                lo = k + 1;
             }
         }
-        if (tempvolume / lake_con.basin[0] > DBL_EPSILON) {
-            status = ERROR;
+        k = lo;
+
+        // partially filled layer k above the filled layers
+        *depth = lake_con->z[k + 1];
+        tempvolume = volume - lake_con->basin_volume[k + 1];
+        if (lake_con->basin[k] == lake_con->basin[k + 1]) {
+            *depth += tempvolume / lake_con->basin[k + 1];
+        }
+        else {
+            m = (lake_con->basin[k] - lake_con->basin[k + 1]) /
+                (lake_con->z[k] - lake_con->z[k + 1]);
+            *depth += ((-1 * lake_con->basin[k + 1]) +
+                       sqrt(lake_con->basin[k + 1] * lake_con->basin[k + 1] +
+                            2. * m * tempvolume)) / m;
         }
     }
 
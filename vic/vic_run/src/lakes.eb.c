@@ -1288,68 +1288,153 @@ specheat(double t)
 }
 
 /******************************************************************************
- * @brief    Calculate the water temperature for different levels in the lake.
+ * @brief    Set the terms of the lake thermal diffusion that depend only on
+ *           the active nodes and their surface areas.  They are constant
+ *           for the iterations of one time step.
  *****************************************************************************/
 void
-temp_area(double  sw_visible,
-          double  sw_nir,
-          double  surface_force,
-          double *T,
-          double *Tnew,
-          double *water_density,
-          double *de,
-          double  dt,
-          double *surface,
-          int     numnod,
-          double  dz,
-          double  surfdz,
-          double *temph,
-          double *cp,
-          double *energy_out_bottom)
+set_lake_column(int                 numnod,
+                double              dz,
+                double              surfdz,
+                double             *surface,
+                lake_column_struct *column)
 {
     extern parameters_struct param;
 
-    double                   z[MAX_LAKE_NODES], zhalf[MAX_LAKE_NODES];
-    double                   a[MAX_LAKE_NODES], b[MAX_LAKE_NODES],
-                             c[MAX_LAKE_NODES];
-    double                   d[MAX_LAKE_NODES];
-
     int                      k;
-    double                   surface_1, surface_2, surface_avg, T1;
-    double                   cnextra;
-    double                   top, bot; /* The depth of the top and the bottom of the current water layer. */
-    double                   energyinput;
-    double                   joulenew;
-    double                   energymixed;
-    double                   term1, term2;
 
-/**********************************************************************
-* Calculate the distance between the centers of the surface and first
-* lake layers.
-**********************************************************************/
-
-/**********************************************************************
-* Initialize the water density at all the nodes and the depth of all
-* and distance between all nodes.
-**********************************************************************/
+    column->numnod = numnod;
+    column->dz = dz;
+    column->surfdz = surfdz;
+    column->surface = surface;
 
     for (k = 0; k < numnod; k++) {
         if (k == 0) {
-            z[k] = surfdz;
+            column->z[k] = surfdz;
         }
         else {
-            z[k] = dz;
+            column->z[k] = dz;
         }
-        zhalf[k] = dz;
+        column->zhalf[k] = dz;
+
+        // the deepest node has no area below it
+        if (k == 0 || k < numnod - 1) {
+            column->surface_avg[k] = (surface[k] + surface[k + 1]) / 2.;
+        }
+        else {
+            column->surface_avg[k] = surface[k];
+        }
+
+        column->expsw[k] = exp(-param.LAKE_LAMWSW * (surfdz + k * dz));
+        column->explw[k] = exp(-param.LAKE_LAMWLW * (surfdz + k * dz));
     }
     if (numnod > 1) {
-        zhalf[0] = 0.5 * (z[0] + z[1]);
+        column->zhalf[0] = 0.5 * (column->z[0] + column->z[1]);
     }
     else {
-        zhalf[0] = 0.5 * z[0];
+        column->zhalf[0] = 0.5 * column->z[0];
     }
-    energyinput = 0.0;
-    energymixed = 0.0;
+}
+
+/******************************************************************************
+ * @brief    Set the tridiagonal matrix of the lake thermal diffusion for one
+ *           eddy diffusivity profile and time step.
+ *****************************************************************************/
+void
+set_lake_column_diffusion(double             *de,
+                          double              dt,
+                          lake_column_struct *column)
+{
+    int     numnod = column->numnod;
+    double *surface = column->surface;
+    double *z = column->z;
+    double *zhalf = column->zhalf;
+    double *a = column->a;
+    double *b = column->b;
+    double *c = column->c;
+    int     k;
+    double  surface_1, surface_2, surface_avg;
+
+    column->dt = dt;
+    for (k = 0; k < numnod; k++) {
+        column->de[k] = de[k];
+    }
+
+    if (numnod == 1) {
+        return;
+    }
+
+    /* --------------------------------------------------------------------
+     * Top node of the column.
+     * --------------------------------------------------------------------*/
+
+    surface_2 = surface[1];
+    surface_avg = column->surface_avg[0];
+
+    b[0] = -0.5 * (de[0] / zhalf[0]) *
+           (dt / z[0]) * surface_2 / surface_avg;
+    a[0] = 1. - b[0];
+
+    /* --------------------------------------------------------------------
+     * Second to second last node of the column.
+     * --------------------------------------------------------------------*/
+
+    for (k = 1; k < numnod - 1; k++) {
+        surface_1 = surface[k];
+        surface_2 = surface[k + 1];
+        surface_avg = column->surface_avg[k];
+
+        b[k] = -0.5 * (de[k] / zhalf[k]) *
+               (dt / z[k]) * surface_2 / surface_avg;
+        c[k] = -0.5 * (de[k - 1] / zhalf[k - 1]) *
+               (dt / z[k]) * surface_1 / surface_avg;
+        a[k] = 1. - b[k] - c[k];
+    }
+
+    /* --------------------------------------------------------------------
+     * Deepest node of the column.
+     * --------------------------------------------------------------------*/
+
+    surface_1 = surface[numnod - 1];
+    surface_avg = column->surface_avg[numnod - 1];
+    c[numnod - 1] = -0.5 * (de[numnod - 1] / zhalf[numnod - 1]) *
+                    (dt /
+                     z[numnod - 1]) * surface_1 / surface_avg;
+    a[numnod - 1] = 1. - c[numnod - 1];
+}
+
+/******************************************************************************
+ * @brief    Calculate the water temperature for different levels in the lake.
+ *           The column and its tridiagonal matrix are set by
+ *           set_lake_column() and set_lake_column_diffusion().
+ *****************************************************************************/
+void
+temp_area(double              sw_visible,
+          double              sw_nir,
+          double              surface_force,
+          double             *T,
+          double             *Tnew,
+          double             *water_density,
+          double             *cp,
+          lake_column_struct *column,
+          double             *temph,
+          double             *energy_out_bottom)
+{
+    int     numnod = column->numnod;
+    double *surface = column->surface;
+    double *z = column->z;
+    double *zhalf = column->zhalf;
+    double *expsw = column->expsw;
+    double *explw = column->explw;
+    double *de = column->de;
+    double  dt = column->dt;
+    double  d[MAX_LAKE_NODES];
+
+    int     k;
+    double  surface_1, surface_2, surface_avg, T1;
+    double  cnextra;
+    double  joulenew;
+    double  term1, term2;
 
 /**********************************************************************
 * Calculate the right hand side vector in the tridiagonal matrix system
@@ -1358,25 +1443,15 @@ temp_area(double  sw_visible,
 
     surface_1 = surface[0];
     surface_2 = surface[1];
-    surface_avg = (surface_1 + surface_2) / 2.;
+    surface_avg = column->surface_avg[0];
 
     T1 =
         (sw_visible *
-         (1 * surface_1 - surface_2 * exp(-param.LAKE_LAMWSW * surfdz)) +
+         (1 * surface_1 - surface_2 * expsw[0]) +
          sw_nir *
-         (1 * surface_1 - surface_2 *
-          exp(-param.LAKE_LAMWLW * surfdz))) / surface_avg +
+         (1 * surface_1 - surface_2 * explw[0])) / surface_avg +
         (surface_force * surface_1) / surface_avg;  /* W/m2 */
 
-    energyinput += T1 * surface_avg;
-    cnextra = 0.5 *
-              (surface_2 /
-               surface_avg) * (de[0] / zhalf[0]) * ((T[1] - T[0]) / z[0]);
-
-    energymixed += cnextra;
-
-    *temph = 0.0;
-
     if (numnod == 1) {
         Tnew[0] = T[0] +
                   (T1 * dt) / ((1.e3 + water_density[0]) * cp[0] * z[0]);
@@ -1386,19 +1461,16 @@ temp_area(double  sw_visible,
          * First calculate d for the surface layer of the lake.
          * -------------------------------------------------------------------- */
 
+        cnextra = 0.5 *
+                  (surface_2 /
+                   surface_avg) * (de[0] / zhalf[0]) * ((T[1] - T[0]) / z[0]);
+
         d[0] = T[0] +
                (T1 * dt) /
                ((1.e3 +
                  water_density[0]) * cp[0] *
                 z[0]) + cnextra * dt;
 
-        *energy_out_bottom =
-            (surface_1 -
-             surface_2) * (sw_visible * exp(-param.LAKE_LAMWSW * surfdz) +
-                           sw_nir *
-                           exp(-param.LAKE_LAMWLW * surfdz));
-
-
         /* --------------------------------------------------------------------
          * Calculate d for the remainder of the column.
          * --------------------------------------------------------------------*/
@@ -1408,26 +1480,17 @@ temp_area(double  sw_visible,
          * ....................................................................*/
 
         for (k = 1; k < numnod - 1; k++) {
-            top = (surfdz + (k - 1) * dz);
-            bot = (surfdz + (k) * dz);
-
             surface_1 = surface[k];
             surface_2 = surface[k + 1];
-            surface_avg = (surface[k] + surface[k + 1]) / 2.;
-
+            surface_avg = column->surface_avg[k];
 
             T1 =
                 (sw_visible *
-                 (surface_1 *
-                  exp(-param.LAKE_LAMWSW *
-                      top) - surface_2 * exp(-param.LAKE_LAMWSW * bot)) +
+                 (surface_1 * expsw[k - 1] - surface_2 * expsw[k]) +
                  sw_nir *
-                 (surface_1 *
-                  exp(-param.LAKE_LAMWLW *
-                      top) - surface_2 *
-                  exp(-param.LAKE_LAMWLW * bot))) / surface_avg;
+                 (surface_1 * explw[k - 1] - surface_2 * explw[k])) /
+                surface_avg;
 
-            energyinput += T1 * surface_avg;
             term1 = 0.5 *
                     (1. /
                      surface_avg) *
@@ -1442,16 +1505,9 @@ temp_area(double  sw_visible,
 
             cnextra = term1 + term2;
 
-            energymixed += (term1 + term2);
             d[k] = T[k] +
                    (T1 * dt) / ((1.e3 + water_density[k]) * cp[k] * z[k]) +
                    cnextra * dt;
-
-            *energy_out_bottom +=
-                (surface_1 -
-                 surface_2) * (sw_visible * exp(-param.LAKE_LAMWSW * bot) +
-                               sw_nir *
-                               exp(-param.LAKE_LAMWLW * bot));
         }
 
         /* ....................................................................
@@ -1460,92 +1516,33 @@ temp_area(double  sw_visible,
         k = numnod - 1;
         surface_1 = surface[k];
         surface_2 = surface[k];
-        surface_avg = surface[k];
-
-        top = (surfdz + (k - 1) * dz);
-        bot = (surfdz + (k) * dz);
+        surface_avg = column->surface_avg[k];
 
         T1 =
             (sw_visible *
-             (surface_1 *
-              exp(-param.LAKE_LAMWSW *
-                  top) - surface_2 * exp(-param.LAKE_LAMWSW * bot)) +
+             (surface_1 * expsw[k - 1] - surface_2 * expsw[k]) +
              sw_nir *
-             (surface_1 *
-              exp(-param.LAKE_LAMWLW *
-                  top) - surface_2 *
-              exp(-param.LAKE_LAMWLW * bot))) / surface_avg;
-
-        energyinput += T1 * surface_avg;
-        energyinput /= surface[0];
+             (surface_1 * explw[k - 1] - surface_2 * explw[k])) /
+            surface_avg;
 
         cnextra = 0.5 *
                   (-1. * surface_1 /
                    surface_avg) *
                   ((de[k - 1] / zhalf[k - 1]) * ((T[k] - T[k - 1]) / z[k]));
 
-        *energy_out_bottom = 0.;
-        *energy_out_bottom += surface_2 *
-                              (sw_visible *
-                               exp(-param.LAKE_LAMWSW *
-                                   bot) + sw_nir *
-                               exp(-param.LAKE_LAMWLW * bot));
+        *energy_out_bottom = surface_2 *
+                             (sw_visible * expsw[k] + sw_nir * explw[k]);
         *energy_out_bottom /= surface[0];
 
-        energymixed += cnextra;
-
         d[k] = T[k] +
                (T1 * dt) / ((1.e3 + water_density[k]) * cp[k] * z[k]) +
                cnextra * dt;
 
-        /**********************************************************************
-        * Calculate arrays for tridiagonal matrix.
-        **********************************************************************/
-
-        /* --------------------------------------------------------------------
-         * Top node of the column.
-         * --------------------------------------------------------------------*/
-
-
-        surface_2 = surface[1];
-        surface_avg = (surface[0] + surface[1]) / 2.;
-
-        b[0] = -0.5 * (de[0] / zhalf[0]) *
-               (dt / z[0]) * surface_2 / surface_avg;
-        a[0] = 1. - b[0];
-
-        /* --------------------------------------------------------------------
-         * Second to second last node of the column.
-         * --------------------------------------------------------------------*/
-
-        for (k = 1; k < numnod - 1; k++) {
-            surface_1 = surface[k];
-            surface_2 = surface[k + 1];
-            surface_avg = (surface[k] + surface[k + 1]) / 2.;
-
-            b[k] = -0.5 * (de[k] / zhalf[k]) *
-                   (dt / z[k]) * surface_2 / surface_avg;
-            c[k] = -0.5 * (de[k - 1] / zhalf[k - 1]) *
-                   (dt / z[k]) * surface_1 / surface_avg;
-            a[k] = 1. - b[k] - c[k];
-        }
-
-        /* --------------------------------------------------------------------
-         * Deepest node of the column.
-         * --------------------------------------------------------------------*/
-
-        surface_1 = surface[numnod - 1];
-        surface_avg = surface[numnod - 1];
-        c[numnod - 1] = -0.5 * (de[numnod - 1] / zhalf[numnod - 1]) *
-                        (dt /
-                         z[numnod - 1]) * surface_1 / surface_avg;
-        a[numnod - 1] = 1. - c[numnod - 1];
-
         /**********************************************************************
         * Solve the tridiagonal matrix.
         **********************************************************************/
 
-        tridia(numnod, c, a, b, d, Tnew);
+        tridia(numnod, column->c, column->a, column->b, d, Tnew);
     }
 
     /**********************************************************************
@@ -1553,9 +1550,8 @@ temp_area(double  sw_visible,
     * moving to lagrangian scheme
     **********************************************************************/
 
-    energycalc(Tnew, &joulenew, numnod, dz, surfdz, surface, cp, water_density);
-
-    *temph = 0.0;
+    energycalc(Tnew, &joulenew, numnod, column->dz, column->surfdz, surface,
+               cp, water_density);
 
     *temph = joulenew;
 }
@@ -1589,6 +1585,7 @@ tracer_mixer(double *T,
 **********************************************************************/
 
     mixprev = 0;
+    solver_stats[SOLVER_LAKE_MIX_ITER]++;
 
     for (k = 0; k < numnod - 1; k++) {
 /**********************************************************************
@@ -1673,6 +1670,7 @@ tracer_mixer(double *T,
             if (rho_max > (CONST_RHOFW + densnew)) {
                 /* If there are still instabilities iterate again..*/
                 mixprev = 0;
+                solver_stats[SOLVER_LAKE_MIX_ITER]++;
                 k = -1;
             }
         }
@@ -1720,42 +1718,9 @@ tridia(int     ne,
        double *y,
        double *x)
 {
-    double alpha[MAX_LAKE_NODES], gamma[MAX_LAKE_NODES];  /* Work arrays dimensioned (nd,ne).*/
-
-    int    nm1, i;
-
-    nm1 = ne - 1;
-
-/**********************************************************************
-* Obtain the LU decompositions.
-**********************************************************************/
-
-    alpha[0] = 1. / b[0];
-    gamma[0] = c[0] * alpha[0];
-
-
-    for (i = 1; i < nm1; i++) {
-        alpha[i] = 1. / (b[i] - a[i] * gamma[i - 1]);
-        gamma[i] = c[i] * alpha[i];
-    }
+    double work[2 * MAX_LAKE_NODES];
 
-/**********************************************************************
-* Solve the system.
-**********************************************************************/
-
-    x[0] = y[0] * alpha[0];
-
-    for (i = 1; i < nm1; i++) {
-        x[i] = (y[i] - a[i] * x[i - 1]) * alpha[i];
-    }
-
-
-    x[nm1] = (y[nm1] - a[nm1] * x[nm1 - 1]) /
-             (b[nm1] - a[nm1] * gamma[nm1 - 1]);
-
-    for (i = nm1 - 1; i >= 0; i--) {
-        x[i] = x[i] - gamma[i] * x[i + 1];
-    }
+    tridiag_batch((size_t) ne, 1, a, b, c, y, x, work);
 }
 
 /******************************************************************************
@@ -1807,7 +1772,7 @@ energycalc(double *finaltemp,
  *****************************************************************************/
 int
 water_balance(lake_var_struct *lake,
-              lake_con_struct  lake_con,
+              lake_con_struct *lake_con,
               double           dt,
               all_vars_struct *all_vars,
               int              iveg,
@@ -1841,8 +1806,8 @@ water_balance(lake_var_struct *lake,
     double                     Dsmax, resid_moist, liq, rel_moist;
     double                    *frost_fract;
     double                     volume_save;
-    double                    *delta_moist = NULL;
-    double                    *moist = NULL;
+    double                     delta_moist[MAX_LAYERS];
+    double                     moist[MAX_LAYERS];
     double                     max_newfraction;
 
     cell = all_vars->cell;
@@ -1852,11 +1817,6 @@ water_balance(lake_var_struct *lake,
 
     frost_fract = soil_con.frost_fract;
 
-    delta_moist = calloc(options.Nlayer, sizeof(*delta_moist));
-    check_alloc_status(delta_moist, "Memory allocation error.");
-    moist = calloc(options.Nlayer, sizeof(*moist));
-    check_alloc_status(moist, "Memory allocation error.");
-
     /**********************************************************************
     * 1. Preliminary stuff
     **********************************************************************/
@@ -1909,7 +1869,7 @@ water_balance(lake_var_struct *lake,
     if (lake->new_ice_area > surfacearea) {
         surfacearea = lake->new_ice_area;
     }
-    newfraction = surfacearea / lake_con.basin[0];
+    newfraction = surfacearea / lake_con->basin[0];
 
     // Save this estimate of the new lake fraction for use later
     max_newfraction = newfraction;
@@ -1943,21 +1903,21 @@ water_balance(lake_var_struct *lake,
     // after runoff and baseflow are subtracted from the lake.
 
     lake->recharge = 0.0;
-    for (j = 0; j < options.Nlayer; j++) {
+    for (j = 0; j < OPT_Nlayer; j++) {
         delta_moist[j] = 0; // mm over (1-lakefrac)
     }
 
     if (max_newfraction > lakefrac) {
         // Lake must fill soil to saturation in the newly-flooded area
-        for (j = 0; j < options.Nlayer; j++) {
+        for (j = 0; j < OPT_Nlayer; j++) {
             delta_moist[j] +=
                 (soil_con.max_moist[j] -
                  cell[iveg][band].layer[j].moist) *
                 (max_newfraction - lakefrac) / (1 - lakefrac);                                                           // mm over (1-lakefrac)
         }
-        for (j = 0; j < options.Nlayer; j++) {
+        for (j = 0; j < OPT_Nlayer; j++) {
             lake->recharge += (delta_moist[j]) / MM_PER_M *
-                              (1 - lakefrac) * lake_con.basin[0];                    // m^3
+                              (1 - lakefrac) * lake_con->basin[0];                    // m^3
         }
 
         // Above-ground storage in newly-flooded area is liberated and goes to lake
@@ -1965,7 +1925,7 @@ water_balance(lake_var_struct *lake,
             (veg_var[iveg][band].Wdew / MM_PER_M +
              snow[iveg][band].snow_canopy +
              snow[iveg][band].swq) *
-            (max_newfraction - lakefrac) * lake_con.basin[0];
+            (max_newfraction - lakefrac) * lake_con->basin[0];
         lake->recharge -= abovegrnd_storage;
 
         // Fill the soil to saturation if possible in inundated area
@@ -1980,12 +1940,12 @@ water_balance(lake_var_struct *lake,
             Recharge = MM_PER_M * lake->recharge /
                        ((max_newfraction -
                          lakefrac) *
-                        lake_con.basin[0]) +
+                        lake_con->basin[0]) +
                        (veg_var[iveg][band].Wdew +
                         snow[iveg][band].snow_canopy * MM_PER_M +
                         snow[iveg][band].swq * MM_PER_M);                                                                                                                               // mm over area that has been flooded
 
-            for (j = 0; j < options.Nlayer; j++) {
+            for (j = 0; j < OPT_Nlayer; j++) {
                 if (Recharge >
                     (soil_con.max_moist[j] - cell[iveg][band].layer[j].moist)) {
                     Recharge -=
@@ -2014,7 +1974,7 @@ water_balance(lake_var_struct *lake,
     **********************************************************************/
 
     Dsmax = soil_con.Dsmax / global_param.model_steps_per_day;
-    lindex = options.Nlayer - 1;
+    lindex = OPT_Nlayer - 1;
     liq = 0;
     for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
         liq +=
@@ -2070,24 +2030,24 @@ water_balance(lake_var_struct *lake,
     }
 
     // Compute runoff volume in m^3 and extract runoff volume from lake
-    if (ldepth <= lake_con.mindepth) {
+    if (ldepth <= lake_con->mindepth) {
         lake->runoff_out = 0.0;
     }
     else {
         circum = 2 * CONST_PI * pow(surfacearea / CONST_PI, 0.5);
-        lake->runoff_out = lake_con.wfrac * circum * dt *
-                           1.6 * pow(ldepth - lake_con.mindepth, 1.5);
+        lake->runoff_out = lake_con->wfrac * circum * dt *
+                           1.6 * pow(ldepth - lake_con->mindepth, 1.5);
         if ((lake->volume - lake->ice_water_eq) >= lake->runoff_out) {
             /*liquid water is available */
-            if ((lake->volume - lake->runoff_out) < lake_con.minvolume) {
-                lake->runoff_out = lake->volume - lake_con.minvolume;
+            if ((lake->volume - lake->runoff_out) < lake_con->minvolume) {
+                lake->runoff_out = lake->volume - lake_con->minvolume;
             }
             lake->volume -= lake->runoff_out;
         }
         else {
             lake->runoff_out = lake->volume - lake->ice_water_eq;
-            if ((lake->volume - lake->runoff_out) < lake_con.minvolume) {
-                lake->runoff_out = lake->volume - lake_con.minvolume;
+            if ((lake->volume - lake->runoff_out) < lake_con->minvolume) {
+                lake->runoff_out = lake->volume - lake_con->minvolume;
             }
             lake->volume -= lake->runoff_out;
         }
@@ -2103,14 +2063,14 @@ water_balance(lake_var_struct *lake,
     }
 
     // check that lake volume does not exceed its maximum
-    if (lake->volume - lake_con.maxvolume > DBL_EPSILON) {
-        if (lake->ice_water_eq > lake_con.maxvolume) {
+    if (lake->volume - lake_con->maxvolume > DBL_EPSILON) {
+        if (lake->ice_water_eq > lake_con->maxvolume) {
             lake->runoff_out += (lake->volume - lake->ice_water_eq);
             lake->volume = lake->ice_water_eq;
         }
         else {
-            lake->runoff_out += (lake->volume - lake_con.maxvolume);
-            lake->volume = lake_con.maxvolume;
+            lake->runoff_out += (lake->volume - lake_con->maxvolume);
+            lake->volume = lake_con->maxvolume;
         }
     }
     else if (lake->volume < DBL_EPSILON) {
@@ -2143,7 +2103,7 @@ water_balance(lake_var_struct *lake,
     else {
         lake->sarea = lake->surface[0];
     }
-    newfraction = lake->sarea / lake_con.basin[0];
+    newfraction = lake->sarea / lake_con->basin[0];
 
     /*******************************************************************/
 
@@ -2191,7 +2151,7 @@ water_balance(lake_var_struct *lake,
                             &(snow[iveg][band]));
         rescale_snow_energy_fluxes((1 - lakefrac), (1 - newfraction),
                                    &(snow[iveg][band]), &(energy[iveg][band]));
-        for (j = 0; j < options.Nlayer; j++) {
+        for (j = 0; j < OPT_Nlayer; j++) {
             moist[j] = cell[iveg][band].layer[j].moist;
         }
         ErrorFlag = distribute_node_moisture_properties(
@@ -2204,13 +2164,8 @@ water_balance(lake_var_struct *lake,
             soil_con.expt_node,
             soil_con.bubble_node,
             moist, soil_con.depth,
-            soil_con.soil_dens_min,
-            soil_con.bulk_dens_min,
-            soil_con.quartz,
-            soil_con.soil_density,
-            soil_con.bulk_density,
-            soil_con.organic, options.Nnode,
-            options.Nlayer,
+            soil_con.thermal_coef, OPT_Nnode,
+            OPT_Nlayer,
             soil_con.FS_ACTIVE);
         if (ErrorFlag == ERROR) {
             return (ERROR);
@@ -2218,16 +2173,16 @@ water_balance(lake_var_struct *lake,
     }
     else if (lakefrac < 1.0) { // wetland is gone at end of time step, but existed at beginning of step
         if (lakefrac > 0.0) { // lake also existed at beginning of step
-            for (j = 0; j < options.Nlayer; j++) {
+            for (j = 0; j < OPT_Nlayer; j++) {
                 lake->evapw += cell[iveg][band].layer[j].evap / MM_PER_M *
-                               (1. - lakefrac) * lake_con.basin[0];
+                               (1. - lakefrac) * lake_con->basin[0];
             }
             lake->evapw += veg_var[iveg][band].canopyevap / MM_PER_M *
-                           (1. - lakefrac) * lake_con.basin[0];
+                           (1. - lakefrac) * lake_con->basin[0];
             lake->evapw += snow[iveg][band].canopy_vapor_flux *
-                           (1. - lakefrac) * lake_con.basin[0];
+                           (1. - lakefrac) * lake_con->basin[0];
             lake->evapw += snow[iveg][band].vapor_flux *
-                           (1. - lakefrac) * lake_con.basin[0];
+                           (1. - lakefrac) * lake_con->basin[0];
         }
     }
 
@@ -2235,16 +2190,16 @@ water_balance(lake_var_struct *lake,
     if (newfraction > 0.0) { // lake exists at end of time step
         // Copy moisture fluxes into lake->soil structure, mm over end-of-step lake area
         lake->soil.runoff = lake->runoff_out * MM_PER_M /
-                            (newfraction * lake_con.basin[0]);
+                            (newfraction * lake_con->basin[0]);
         lake->soil.baseflow = lake->baseflow_out * MM_PER_M /
-                              (newfraction * lake_con.basin[0]);
+                              (newfraction * lake_con->basin[0]);
         lake->soil.inflow = lake->baseflow_out * MM_PER_M /
-                            (newfraction * lake_con.basin[0]);
-        for (lindex = 0; lindex < options.Nlayer; lindex++) {
+                            (newfraction * lake_con->basin[0]);
+        for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
             lake->soil.layer[lindex].evap = 0;
         }
         lake->soil.layer[0].evap += lake->evapw * MM_PER_M /
-                                    (newfraction * lake_con.basin[0]);
+                                    (newfraction * lake_con->basin[0]);
         // Rescale other fluxes and storages to mm over end-of-step lake area
         if (lakefrac > 0.0) { // lake existed at beginning of time step
             rescale_snow_storage(lakefrac, newfraction, &(lake->snow));
@@ -2271,10 +2226,10 @@ water_balance(lake_var_struct *lake,
             }
             lake->tempavg = lake->temp[0];
             lake->energy.Tsurf = all_vars->energy[iveg][band].Tsurf;
-            for (k = 0; k < options.Nnode; k++) {
+            for (k = 0; k < OPT_Nnode; k++) {
                 lake->energy.T[k] = all_vars->energy[iveg][band].T[k];
             }
-            for (k = 0; k < options.Nlayer; k++) {
+            for (k = 0; k < OPT_Nlayer; k++) {
                 lake->soil.layer[k].T = all_vars->cell[iveg][band].layer[k].T;
             }
         }
@@ -2284,24 +2239,21 @@ water_balance(lake_var_struct *lake,
             cell[iveg][band].layer[0].evap += MM_PER_M * lake->evapw /
                                               ((1. -
                                                 newfraction) *
-                                               lake_con.basin[0]);
+                                               lake_con->basin[0]);
             cell[iveg][band].runoff += MM_PER_M * lake->runoff_out /
-                                       ((1. - newfraction) * lake_con.basin[0]);
+                                       ((1. - newfraction) * lake_con->basin[0]);
             cell[iveg][band].baseflow += MM_PER_M * lake->baseflow_out /
                                          ((1. -
-                                           newfraction) * lake_con.basin[0]);
+                                           newfraction) * lake_con->basin[0]);
             cell[iveg][band].inflow += MM_PER_M * lake->baseflow_out /
-                                       ((1. - newfraction) * lake_con.basin[0]);
+                                       ((1. - newfraction) * lake_con->basin[0]);
         }
     }
 
-    if (options.CARBON) {
+    if (OPT_CARBON) {
         advect_carbon_storage(lakefrac, newfraction, lake, &(cell[iveg][band]));
     }
 
-    free((char*) delta_moist);
-    free((char*) moist);
-
     return(0);
 }
 
@@ -2318,7 +2270,7 @@ advect_soil_veg_storage(double            lakefrac,
                         veg_con_struct   *veg_con,
                         cell_data_struct *cell,
                         veg_var_struct   *veg_var,
-                        lake_con_struct   lake_con)
+                        lake_con_struct  *lake_con)
 {
     extern option_struct options;
     int                  ilidx;
@@ -2330,11 +2282,11 @@ advect_soil_veg_storage(double            lakefrac,
 
     if (lakefrac < 1.0) { // wetland existed during this step
         // Add delta_moist to wetland, using wetland's initial area (1-lakefrac)
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
             new_moist[lidx] = cell->layer[lidx].moist + delta_moist[lidx]; // mm over (1-lakefrac)
             delta_moist[lidx] = 0;
             if (new_moist[lidx] > soil_con->max_moist[lidx]) {
-                if (lidx < options.Nlayer - 1) {
+                if (lidx < OPT_Nlayer - 1) {
                     delta_moist[lidx +
                                 1] += new_moist[lidx] -
                                       soil_con->max_moist[lidx];
@@ -2346,7 +2298,7 @@ advect_soil_veg_storage(double            lakefrac,
                 new_moist[lidx] = soil_con->max_moist[lidx];
             }
         }
-        for (ilidx = (int) options.Nlayer - 1; ilidx >= 0; ilidx--) {
+        for (ilidx = (int) OPT_Nlayer - 1; ilidx >= 0; ilidx--) {
             new_moist[ilidx] += delta_moist[ilidx]; // mm over (1-lakefrac)
             delta_moist[ilidx] = 0;
             if (new_moist[ilidx] > soil_con->max_moist[ilidx]) {
@@ -2366,12 +2318,12 @@ advect_soil_veg_storage(double            lakefrac,
         // Any recharge that cannot be accomodated by wetland goes to baseflow
         if (delta_moist[0] > 0) {
             cell->baseflow += delta_moist[0] / MM_PER_M *
-                              (1 - lakefrac) * lake_con.basin[0];            // m^3
+                              (1 - lakefrac) * lake_con->basin[0];            // m^3
             delta_moist[0] = 0;
         }
 
         // Rescale wetland moisture to wetland's final area (= 1-newfraction)
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
             new_moist[lidx] *= (1 - lakefrac); // mm over lake/wetland tile
             new_moist[lidx] += soil_con->max_moist[lidx] *
                                (lakefrac - newfraction);                   // Add the saturated portion between lakefrac and newfraction; this works whether newfraction is > or < or == lakefrac
@@ -2380,14 +2332,16 @@ advect_soil_veg_storage(double            lakefrac,
         }
 
         // Recompute saturated areas
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
             tmp_moist[lidx] = cell->layer[lidx].moist;
         }
         compute_runoff_and_asat(soil_con, tmp_moist, 0, &(cell->asat),
                                 &tmp_runoff);
 
         // Recompute zwt's
-        wrap_compute_zwt(soil_con, cell);
+        if (options.COMPUTE_ZWT) {
+            wrap_compute_zwt(soil_con, cell);
+        }
 
         // Update Wdew
         if (max_newfraction <= lakefrac) { // lake only receded
@@ -2402,7 +2356,7 @@ advect_soil_veg_storage(double            lakefrac,
         }
     }
     else { // Wetland didn't exist until now; create new wetland
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
             cell->layer[lidx].moist = soil_con->max_moist[lidx];
             for (fidx = 0; fidx < options.Nfrost; fidx++) {
                 cell->layer[lidx].ice[fidx] = 0.0;
@@ -2420,7 +2374,7 @@ advect_soil_veg_storage(double            lakefrac,
     // Compute rootmoist and wetness
     cell->rootmoist = 0;
     cell->wetness = 0;
-    for (lidx = 0; lidx < options.Nlayer; lidx++) {
+    for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
         if (veg_con->root[lidx] > 0) {
             cell->rootmoist += cell->layer[lidx].moist;
         }
@@ -2430,7 +2384,7 @@ advect_soil_veg_storage(double            lakefrac,
             (soil_con->porosity[lidx] * soil_con->depth[lidx] * MM_PER_M -
              soil_con->Wpwp[lidx]);
     }
-    cell->wetness /= options.Nlayer;
+    cell->wetness /= OPT_Nlayer;
 }
 
 /******************************************************************************
@@ -2451,7 +2405,7 @@ rescale_soil_veg_fluxes(double            oldfrac,
     }
 
     if (oldfrac > 0.0) { // existed at beginning of time step
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
             cell->layer[lidx].evap *= oldfrac / newfrac;
         }
         cell->baseflow *= oldfrac / newfrac;
@@ -2463,7 +2417,7 @@ rescale_soil_veg_fluxes(double            oldfrac,
         }
     }
     else { // didn't exist at beginning of time step; set fluxes to 0
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
             cell->layer[lidx].evap = 0.0;
         }
         cell->baseflow = 0.0;
@@ -0,0 +1,303 @@
+/******************************************************************************
+ * @section DESCRIPTION
+ *
+ * Merge the snow-free elevation bands of a vegetation tile that have similar
+ * forcings and states, so that vic_run solves them as one band.
+ *
+ * @section LICENSE
+ *
+ * The Variable Infiltration Capacity (VIC) macroscale hydrological model
+ * Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+ * and Environmental Engineering, University of Washington.
+ *
+ * The VIC model is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *****************************************************************************/
+
+#include <vic_run.h>
+
+/******************************************************************************
+ * @brief    Check whether a snow band stays free of snow during the time
+ *           step.
+ * @details  The band has no snow on the ground or on the canopy, and all
+ *           precipitation of the snow model sub-steps falls as rain.
+ *****************************************************************************/
+static bool
+snow_free_band(snow_data_struct  *snow,
+               force_data_struct *force,
+               double             Tfactor)
+{
+    extern parameters_struct param;
+
+    size_t                   i;
+
+    if (snow->swq > 0 || snow->snow_canopy > 0 || snow->pack_water > 0 ||
+        snow->surf_water > 0) {
+        return false;
+    }
+    for (i = 0; i < NF; i++) {
+        if (force->prec[i] > 0 &&
+            !(force->air_temp[i] + Tfactor >= param.SNOW_MAX_SNOW_TEMP)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Check whether a snow band may be solved with the representative
+ *           band of a group.
+ * @details  The lapse rate factors of the forcings, the soil moistures and
+ *           the soil temperatures of the two bands differ by at most
+ *           BAND_MERGE_TDIFF and BAND_MERGE_FDIFF.
+ *****************************************************************************/
+static bool
+similar_bands(unsigned short   iveg,
+              size_t           rep,
+              size_t           band,
+              all_vars_struct *all_vars,
+              soil_con_struct *soil_con)
+{
+    extern option_struct     options;
+    extern parameters_struct param;
+
+    size_t                   i;
+    cell_data_struct        *cell_rep = &(all_vars->cell[iveg][rep]);
+    cell_data_struct        *cell = &(all_vars->cell[iveg][band]);
+    energy_bal_struct       *energy_rep = &(all_vars->energy[iveg][rep]);
+    energy_bal_struct       *energy = &(all_vars->energy[iveg][band]);
+    veg_var_struct          *veg_var_rep = &(all_vars->veg_var[iveg][rep]);
+    veg_var_struct          *veg_var = &(all_vars->veg_var[iveg][band]);
+
+    if (fabs(soil_con->Tfactor[band] - soil_con->Tfactor[rep]) >
+        param.BAND_MERGE_TDIFF ||
+        fabs(soil_con->Pfactor[band] - soil_con->Pfactor[rep]) >
+        param.BAND_MERGE_FDIFF) {
+        return false;
+    }
+    for (i = 0; i < OPT_Nlayer; i++) {
+        if (fabs(cell->layer[i].moist - cell_rep->layer[i].moist) >
+            param.BAND_MERGE_FDIFF * soil_con->max_moist[i]) {
+            return false;
+        }
+    }
+    for (i = 0; i < OPT_Nnode; i++) {
+        if (fabs(energy->T[i] - energy_rep->T[i]) > param.BAND_MERGE_TDIFF) {
+            return false;
+        }
+    }
+    if (fabs(veg_var->Wdew - veg_var_rep->Wdew) >
+        param.BAND_MERGE_FDIFF * veg_var_rep->Wdmax) {
+        return false;
+    }
+
+    return true;
+}
+
+/******************************************************************************
+ * @brief    Group the snow bands of a vegetation tile that are solved as one
+ *           band with BAND_MERGE.
+ *
+ * @details  A group is made of snow-free bands that are similar to its first
+ *           band, the representative band. The water and carbon stores and
+ *           the soil temperatures of the representative band are set to the
+ *           area weighted means over the group, and the group is solved with
+ *           the area weighted means of the lapse rate factors, so that the
+ *           water of the grid cell is conserved when the results of the
+ *           representative band are copied to the other bands with
+ *           copy_snow_band(). A band that has snow, or receives snowfall,
+ *           is always solved on its own.
+ *
+ * @param iveg     vegetation tile
+ * @param Nbands   number of snow bands of the tile
+ * @param all_vars states and fluxes of the grid cell
+ * @param force    forcings of the time step
+ * @param soil_con soil parameters of the grid cell
+ * @param band_rep on output, representative band of each band
+ * @param Tfactor  on output, air temperature factor (C) of each
+ *                 representative band
+ * @param Pfactor  on output, precipitation factor of each representative
+ *                 band
+ *****************************************************************************/
+void
+merge_snow_bands(unsigned short     iveg,
+                 size_t             Nbands,
+                 all_vars_struct   *all_vars,
+                 force_data_struct *force,
+                 soil_con_struct   *soil_con,
+                 size_t            *band_rep,
+                 double            *Tfactor,
+                 double            *Pfactor)
+{
+    extern option_struct options;
+
+    bool                 snow_free[MAX_BANDS];
+    size_t               rep;
+    size_t               band;
+    size_t               nmembers;
+    size_t               i;
+    size_t               j;
+    double               area;
+    double               w;
+    cell_data_struct    *cell;
+    energy_bal_struct   *energy;
+    veg_var_struct      *veg_var;
+    layer_data_struct   *layer;
+
+    for (band = 0; band < Nbands; band++) {
+        band_rep[band] = band;
+        Tfactor[band] = soil_con->Tfactor[band];
+        Pfactor[band] = soil_con->Pfactor[band];
+        snow_free[band] = soil_con->AreaFract[band] > 0 &&
+                          snow_free_band(&(all_vars->snow[iveg][band]), force,
+                                         soil_con->Tfactor[band]);
+    }
+
+    for (rep = 0; rep < Nbands; rep++) {
+        if (!snow_free[rep] || band_rep[rep] != rep) {
+            continue;
+        }
+        nmembers = 1;
+        for (band = rep + 1; band < Nbands; band++) {
+            if (snow_free[band] && band_rep[band] == band &&
+                similar_bands(iveg, rep, band, all_vars, soil_con)) {
+                band_rep[band] = rep;
+                nmembers++;
+            }
+        }
+        if (nmembers == 1) {
+            continue;
+        }
+
+        // area weighted means of the stores and the forcings of the group
+        cell = &(all_vars->cell[iveg][rep]);
+        energy = &(all_vars->energy[iveg][rep]);
+        veg_var = &(all_vars->veg_var[iveg][rep]);
+        area = soil_con->AreaFract[rep];
+        Tfactor[rep] *= area;
+        Pfactor[rep] *= area;
+        for (i = 0; i < OPT_Nlayer; i++) {
+            cell->layer[i].moist *= area;
+            for (j = 0; j < options.Nfrost; j++) {
+                cell->layer[i].ice[j] *= area;
+            }
+        }
+        for (i = 0; i < OPT_Nnode; i++) {
+            energy->T[i] *= area;
+        }
+        veg_var->Wdew *= area;
+        if (OPT_CARBON) {
+            cell->CLitter *= area;
+            cell->CInter *= area;
+            cell->CSlow *= area;
+            veg_var->AnnualNPP *= area;
+            veg_var->AnnualNPPPrev *= area;
+        }
+        for (band = rep + 1; band < Nbands; band++) {
+            if (band_rep[band] != rep) {
+                continue;
+            }
+            w = soil_con->AreaFract[band];
+            area += w;
+            Tfactor[rep] += w * soil_con->Tfactor[band];
+            Pfactor[rep] += w * soil_con->Pfactor[band];
+            for (i = 0; i < OPT_Nlayer; i++) {
+                layer = &(all_vars->cell[iveg][band].layer[i]);
+                cell->layer[i].moist += w * layer->moist;
+                for (j = 0; j < options.Nfrost; j++) {
+                    cell->layer[i].ice[j] += w * layer->ice[j];
+                }
+            }
+            for (i = 0; i < OPT_Nnode; i++) {
+                energy->T[i] += w * all_vars->energy[iveg][band].T[i];
+            }
+            veg_var->Wdew += w * all_vars->veg_var[iveg][band].Wdew;
+            if (OPT_CARBON) {
+                cell->CLitter += w * all_vars->cell[iveg][band].CLitter;
+                cell->CInter += w * all_vars->cell[iveg][band].CInter;
+                cell->CSlow += w * all_vars->cell[iveg][band].CSlow;
+                veg_var->AnnualNPP +=
+                    w * all_vars->veg_var[iveg][band].AnnualNPP;
+                veg_var->AnnualNPPPrev +=
+                    w * all_vars->veg_var[iveg][band].AnnualNPPPrev;
+            }
+        }
+        Tfactor[rep] /= area;
+        Pfactor[rep] /= area;
+        for (i = 0; i < OPT_Nlayer; i++) {
+            cell->layer[i].moist /= area;
+            for (j = 0; j < options.Nfrost; j++) {
+                cell->layer[i].ice[j] /= area;
+            }
+        }
+        for (i = 0; i < OPT_Nnode; i++) {
+            energy->T[i] /= area;
+        }
+        veg_var->Wdew /= area;
+        if (OPT_CARBON) {
+            cell->CLitter /= area;
+            cell->CInter /= area;
+            cell->CSlow /= area;
+            veg_var->AnnualNPP /= area;
+            veg_var->AnnualNPPPrev /= area;
+        }
+    }
+}
+
+/******************************************************************************
+ * @brief    Copy the states and fluxes of the representative band of a group
+ *           of merged snow bands to another band of the group.
+ *
+ * @details  The carbon arrays of the vegetation of the band are kept, as in
+ *           copy_all_vars().
+ *****************************************************************************/
+void
+copy_snow_band(unsigned short   iveg,
+               size_t           rep,
+               size_t           band,
+               all_vars_struct *all_vars)
+{
+    extern option_struct options;
+
+    veg_var_struct      *veg_var;
+    double              *NscaleFactor;
+    double              *aPARLayer;
+    double              *CiLayer;
+    double              *rsLayer;
+
+    all_vars->cell[iveg][band] = all_vars->cell[iveg][rep];
+    all_vars->energy[iveg][band] = all_vars->energy[iveg][rep];
+    all_vars->snow[iveg][band] = all_vars->snow[iveg][rep];
+
+    veg_var = &(all_vars->veg_var[iveg][band]);
+    NscaleFactor = veg_var->NscaleFactor;
+    aPARLayer = veg_var->aPARLayer;
+    CiLayer = veg_var->CiLayer;
+    rsLayer = veg_var->rsLayer;
+    *veg_var = all_vars->veg_var[iveg][rep];
+    veg_var->NscaleFactor = NscaleFactor;
+    veg_var->aPARLayer = aPARLayer;
+    veg_var->CiLayer = CiLayer;
+    veg_var->rsLayer = rsLayer;
+    if (OPT_CARBON) {
+        memcpy(NscaleFactor, all_vars->veg_var[iveg][rep].NscaleFactor,
+               options.Ncanopy * sizeof(*NscaleFactor));
+        memcpy(aPARLayer, all_vars->veg_var[iveg][rep].aPARLayer,
+               options.Ncanopy * sizeof(*aPARLayer));
+        memcpy(CiLayer, all_vars->veg_var[iveg][rep].CiLayer,
+               options.Ncanopy * sizeof(*CiLayer));
+        memcpy(rsLayer, all_vars->veg_var[iveg][rep].rsLayer,
+               options.Ncanopy * sizeof(*rsLayer));
+    }
+}
@@ -34,11 +34,18 @@
 /******************************************************************************
  * @brief    Newton-Raphson method to solve non-linear system adapted from
  *           "Numerical Recipes"
+ *
+ * @note     The tridiagonal Jacobian is computed by jacfunc from the state of
+ *           the last residual evaluation of vecfunc. If jacfunc is NULL, it
+ *           is approximated by forward differences of vecfunc (fdjac3).
  *****************************************************************************/
 int
 newt_raph(void (*vecfunc)(double x[], double fvec[], int n, int init, ...),
+          void (*jacfunc)(double x[], double a[], double b[], double c[],
+                          int n, soil_thermal_struct *soil_thermal),
           double x[],
-          int n)
+          int n,
+          soil_thermal_struct *soil_thermal)
 {
     extern parameters_struct param;
 
@@ -49,8 +56,10 @@ newt_raph(void (*vecfunc)(double x[], double fvec[], int n, int init, ...),
     Error = 0;
 
     for (k = 0; k < param.NEWT_RAPH_MAXTRIAL; k++) {
+        solver_stats[SOLVER_NEWT_RAPH_ITER]++;
+
         // calculate function value for all nodes, i.e. focus = -1
-        (*vecfunc)(x, fvec, n, 0, -1);
+        (*vecfunc)(x, fvec, n, 0, soil_thermal, -1);
 
         // stop if TOLF is satisfied
         errf = 0.0;
@@ -62,7 +71,12 @@ newt_raph(void (*vecfunc)(double x[], double fvec[], int n, int init, ...),
         }
 
         // calculate the Jacobian
-        fdjac3(x, fvec, a, b, c, vecfunc, n);
+        if (jacfunc != NULL) {
+            (*jacfunc)(x, a, b, c, n, soil_thermal);
+        }
+        else {
+            fdjac3(x, fvec, a, b, c, vecfunc, n, soil_thermal);
+        }
 
         for (i = 0; i < n; i++) {
             p[i] = -fvec[i];
@@ -114,7 +128,8 @@ fdjac3(double x[],
        double b[],
        double c[],
        void (*vecfunc)(double x[], double fvec[], int n, int init, ...),
-       int n)
+       int n,
+       soil_thermal_struct *soil_thermal)
 {
     extern parameters_struct param;
 
@@ -131,7 +146,7 @@ fdjac3(double x[],
         h = x[j] - temp;
 
         // only update column j-1, j and j+1, caused by change in x[j]
-        (*vecfunc)(x, f, n, 0, j);
+        (*vecfunc)(x, f, n, 0, soil_thermal, j);
 
         x[j] = temp;
 
@@ -106,30 +106,53 @@ calc_rc_ps(char    Ctype,
            double *rsLayer,
            double *rc)
 {
-    extern option_struct     options;
-    extern parameters_struct param;
+    double rc0;                 /* aggregate canopy resistance in absence of
+                                   soil moisture stress */
 
-    double                   GPP0; /* aggregate canopy assimilation (photosynthesis)
-                                      in absence of soil moisture stress */
-    double                   Rdark0; /* aggregate canopy dark respiration in absence of
-                                        soil moisture stress */
-    double                   Rphoto0; /* aggregate canopy photorespiration in absence of
-                                         soil moisture stress */
-    double                   Rmaint0; /* aggregate plant maintenance respiration in absence of
-                                         soil moisture stress */
-    double                   Rgrowth0; /* aggregate plant growth respiration in absence of
-                                          soil moisture stress */
-    double                   Raut0; /* aggregate plant respiration in absence of
-                                       soil moisture stress */
-    double                   NPP0; /* aggregate net primary productivity in absence of
-                                      soil moisture stress */
-    double                   Ci0; /* aggregate canopy leaf-internal CO2 mixing ratio
-                                     in absence of soil moisture stress */
-    double                   rc0; /* aggregate canopy resistance in absence of
-                                     soil moisture stress */
-    double                   rcRatio;
-    double                   vpdfactor; /* factor for canopy resistance based on vpd */
-    size_t                   cidx;
+    calc_rc_ps_demand(Ctype, MaxCarboxRate, MaxETransport, CO2Specificity,
+                      NscaleFactor, tair, shortwave, aPAR, elevation, Catm,
+                      CanopLayerBnd, lai, rsLayer, &rc0);
+    calc_rc_ps_stress(rc0, gsm_inv, vpd, rsLayer, rc);
+}
+
+/******************************************************************************
+ * @brief    Calculate the canopy resistance from the photosynthetic demand in
+ *           absence of soil moisture stress.
+ * @details  The result does not depend on the soil moisture, so it can be
+ *           shared by all soil layers and scaled with calc_rc_ps_stress().
+ *****************************************************************************/
+void
+calc_rc_ps_demand(char    Ctype,
+                  double  MaxCarboxRate,
+                  double  MaxETransport,
+                  double  CO2Specificity,
+                  double *NscaleFactor,
+                  double  tair,
+                  double  shortwave,
+                  double *aPAR,
+                  double  elevation,
+                  double  Catm,
+                  double *CanopLayerBnd,
+                  double  lai,
+                  double *rsLayer0,
+                  double *rc0)
+{
+    double GPP0;                /* aggregate canopy assimilation (photosynthesis)
+                                   in absence of soil moisture stress */
+    double Rdark0;              /* aggregate canopy dark respiration in absence of
+                                   soil moisture stress */
+    double Rphoto0;             /* aggregate canopy photorespiration in absence of
+                                   soil moisture stress */
+    double Rmaint0;             /* aggregate plant maintenance respiration in absence of
+                                   soil moisture stress */
+    double Rgrowth0;            /* aggregate plant growth respiration in absence of
+                                   soil moisture stress */
+    double Raut0;               /* aggregate plant respiration in absence of
+                                   soil moisture stress */
+    double NPP0;                /* aggregate net primary productivity in absence of
+                                   soil moisture stress */
+    double Ci0;                 /* aggregate canopy leaf-internal CO2 mixing ratio
+                                   in absence of soil moisture stress */
 
     /* Compute canopy resistance and photosynthetic demand in absence of soil moisture stress */
     canopy_assimilation(Ctype,
@@ -145,8 +168,8 @@ calc_rc_ps(char    Ctype,
                         CanopLayerBnd,
                         lai,
                         "ci",
-                        rsLayer,
-                        &rc0,
+                        rsLayer0,
+                        rc0,
                         &Ci0,
                         &GPP0,
                         &Rdark0,
@@ -155,6 +178,27 @@ calc_rc_ps(char    Ctype,
                         &Rgrowth0,
                         &Raut0,
                         &NPP0);
+}
+
+/******************************************************************************
+ * @brief    Scale the canopy resistance of calc_rc_ps_demand() for soil
+ *           moisture stress and vapor pressure deficit.
+ * @details  On entry rsLayer holds the layer resistances of
+ *           calc_rc_ps_demand(), on return the stressed ones.
+ *****************************************************************************/
+void
+calc_rc_ps_stress(double  rc0,
+                  double  gsm_inv,
+                  double  vpd,
+                  double *rsLayer,
+                  double *rc)
+{
+    extern option_struct     options;
+    extern parameters_struct param;
+
+    double                   rcRatio;
+    double                   vpdfactor; /* factor for canopy resistance based on vpd */
+    size_t                   cidx;
 
     /* calculate vapor pressure deficit factor */
     vpdfactor = 1 - vpd / param.CANOPY_CLOSURE;
@@ -187,16 +231,27 @@ penman(double tair,
        double rc,
        double rarc)
 {
-    double evap;                /* Penman-Monteith evapotranspiration */
-    double slope;               /* slope of saturated vapor pressure curve */
-    double r_air;               /* density of air in kg/m3 */
+    penman_atmos_struct atmos;
+
+    set_penman_atmos(tair, elevation, &atmos);
+
+    return penman_atmos(&atmos, rad, vpd, ra, rc, rarc);
+}
+
+/******************************************************************************
+ * @brief    Set the terms of the combination equation that depend only on the
+ *           air temperature and the elevation.
+ *****************************************************************************/
+void
+set_penman_atmos(double               tair,
+                 double               elevation,
+                 penman_atmos_struct *atmos)
+{
     double h;                   /* scale height in the atmosphere (m) */
-    double lv;                  /* latent heat of vaporization (J/kg) */
     double pz;                  /* surface air pressure */
-    double gamma;               /* psychrometric constant (Pa/C) */
 
     /* calculate the slope of the saturated vapor pressure curve in Pa/K */
-    slope = svp_slope(tair);
+    atmos->slope = svp_slope(tair);
 
     /* calculate scale height based on average temperature in the column */
     h = calc_scale_height(tair, elevation);
@@ -207,21 +262,35 @@ penman(double tair,
 
     /* calculate latent heat of vaporization. Eq. 4.2.1 in Handbook of
        Hydrology, assume Ts is Tair */
-    lv = calc_latent_heat_of_vaporization(tair);
+    atmos->lv = calc_latent_heat_of_vaporization(tair);
 
     /* calculate gamma. Eq. 4.2.28. Handbook of Hydrology */
-    gamma = 1628.6 * pz / lv;
-
-    /* calculate factor to be applied to rc/ra */
+    atmos->gamma = 1628.6 * pz / atmos->lv;
 
     /* calculate the air density, using eq. 4.2.4 Handbook of Hydrology */
-    r_air = 0.003486 * pz / (275 + tair);
+    atmos->r_air = 0.003486 * pz / (275 + tair);
+}
+
+/******************************************************************************
+ * @brief    Calculate daily evapotranspiration using the combination equation
+ *           with the terms of set_penman_atmos().
+ *****************************************************************************/
+double
+penman_atmos(penman_atmos_struct *atmos,
+             double               rad,
+             double               vpd,
+             double               ra,
+             double               rc,
+             double               rarc)
+{
+    double evap;                /* Penman-Monteith evapotranspiration */
 
     /* calculate the evaporation in mm/day (by not dividing by the density
        of water (~1000 kg/m3)), the result ends up being in mm instead of m */
 
-    evap = (slope * rad + r_air * CONST_CPMAIR * vpd / ra) /
-           (lv * (slope + gamma * (1 + (rc + rarc) / ra))) * CONST_CDAY;
+    evap = (atmos->slope * rad + atmos->r_air * CONST_CPMAIR * vpd / ra) /
+           (atmos->lv * (atmos->slope + atmos->gamma * (1 + (rc + rarc) / ra))) *
+           CONST_CDAY;
 
     if (vpd >= 0.0 && evap < 0.0) {
         evap = 0.0;
@@ -0,0 +1,216 @@
+/******************************************************************************
+* @section DESCRIPTION
+*
+* Hardware performance counters of the physics stages of vic_run.
+*
+* When PERF_REGIONS is TRUE, each thread opens a group of Linux perf_event
+* counters the first time it enters a region. The counters are read at the
+* start and the end of each region and the differences are accumulated per
+* thread. Regions may be nested, e.g. PERF_SOLVE_SNOW inside
+* PERF_SURFACE_FLUXES, so the counts of a region include those of the
+* regions it contains. Only user space events of the calling thread are
+* counted.
+*
+* @section LICENSE
+*
+* The Variable Infiltration Capacity (VIC) macroscale hydrological model
+* Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+* and Environmental Engineering, University of Washington.
+*
+* The VIC model is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+******************************************************************************/
+
+#include <vic_run.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// number of hardware counters, all of enum perf_counters but PERF_CALLS
+#define N_PERF_EVENTS (N_PERF_COUNTERS - 1)
+
+// counters of the calling thread
+static struct {
+    bool opened;                /**< TRUE = the counters have been opened */
+    int fd[N_PERF_EVENTS];      /**< perf_event descriptors, fd[0] is the
+                                   group leader; -1 = not available */
+    bool started[N_PERF_REGIONS]; /**< TRUE = start holds the counters at
+                                     the start of the region */
+    unsigned long long start[N_PERF_REGIONS][N_PERF_EVENTS];
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS];
+} perf_thread;
+#pragma omp threadprivate(perf_thread)
+
+/******************************************************************************
+* @brief    Open the counters of the calling thread.
+* @details  If the counters are not available, e.g. because of
+*           /proc/sys/kernel/perf_event_paranoid or because the system has no
+*           hardware counters, a warning is printed once and the regions of
+*           the thread only count the calls.
+******************************************************************************/
+static void
+perf_thread_open(void)
+{
+    static bool        warned = false;
+    size_t             i;
+    int                err = 0;
+
+#ifdef __linux__
+    unsigned long long config[N_PERF_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES
+    };
+    struct perf_event_attr attr;
+
+    for (i = 0; i < N_PERF_EVENTS; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config[i];
+        attr.disabled = (i == 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        perf_thread.fd[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1,
+                                          i == 0 ? -1 : perf_thread.fd[0], 0);
+        if (perf_thread.fd[i] < 0) {
+            err = errno;
+            break;
+        }
+    }
+    if (err == 0 &&
+        ioctl(perf_thread.fd[0], PERF_EVENT_IOC_ENABLE,
+              PERF_IOC_FLAG_GROUP) != 0) {
+        err = errno;
+    }
+    if (err != 0) {
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+            if (perf_thread.fd[i] >= 0) {
+                close(perf_thread.fd[i]);
+            }
+        }
+    }
+#else
+    err = ENOSYS;
+#endif
+
+    if (err != 0) {
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+            perf_thread.fd[i] = -1;
+        }
+        #pragma omp critical (perf_regions_warning)
+        {
+            if (!warned) {
+                warned = true;
+                errno = err;
+                log_warn("Hardware performance counters are not available, "
+                         "PERF_REGIONS only counts the calls of the regions.");
+            }
+        }
+    }
+    perf_thread.opened = true;
+}
+
+/******************************************************************************
+* @brief    Read the counters of the calling thread.
+* @return   false if the counters are not available
+******************************************************************************/
+static bool
+perf_thread_read(unsigned long long values[N_PERF_EVENTS])
+{
+    // PERF_FORMAT_GROUP: number of events, followed by their values
+    unsigned long long buf[1 + N_PERF_EVENTS];
+    size_t             i;
+
+    if (!perf_thread.opened) {
+        perf_thread_open();
+    }
+    if (perf_thread.fd[0] < 0 ||
+        read(perf_thread.fd[0], buf, sizeof(buf)) != (ssize_t) sizeof(buf)) {
+        return false;
+    }
+    for (i = 0; i < N_PERF_EVENTS; i++) {
+        values[i] = buf[i + 1];
+    }
+    return true;
+}
+
+/******************************************************************************
+* @brief    Start a region. Does nothing unless PERF_REGIONS is TRUE.
+******************************************************************************/
+void
+perf_region_start(enum perf_regions region)
+{
+    extern option_struct options;
+
+    if (!options.PERF_REGIONS) {
+        return;
+    }
+    perf_thread.started[region] = perf_thread_read(perf_thread.start[region]);
+}
+
+/******************************************************************************
+* @brief    Stop a region started by perf_region_start() and add its counts.
+******************************************************************************/
+void
+perf_region_stop(enum perf_regions region)
+{
+    extern option_struct options;
+
+    unsigned long long   values[N_PERF_EVENTS];
+    size_t               i;
+
+    if (!options.PERF_REGIONS) {
+        return;
+    }
+    perf_thread.counts[region][PERF_CALLS]++;
+    if (perf_thread.started[region] && perf_thread_read(values)) {
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+            perf_thread.counts[region][i + 1] +=
+                values[i] - perf_thread.start[region][i];
+        }
+    }
+}
+
+/******************************************************************************
+* @brief    Add the counts of the calling thread to counts and close its
+*           counters.
+* @details  Must be called by each thread that ran regions, one thread at a
+*           time.
+******************************************************************************/
+void
+perf_regions_collect(
+    unsigned long long counts[N_PERF_REGIONS][N_PERF_COUNTERS])
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < N_PERF_REGIONS; i++) {
+        for (j = 0; j < N_PERF_COUNTERS; j++) {
+            counts[i][j] += perf_thread.counts[i][j];
+            perf_thread.counts[i][j] = 0;
+        }
+    }
+    if (perf_thread.opened) {
+        for (i = 0; i < N_PERF_EVENTS; i++) {
+            if (perf_thread.fd[i] >= 0) {
+                close(perf_thread.fd[i]);
+            }
+        }
+        perf_thread.opened = false;
+    }
+}
@@ -27,6 +27,53 @@
 
 #include <vic_run.h>
 
+/******************************************************************************
+ * @brief    Compute the temperature- and irradiance-dependent terms of the
+ *           photosynthesis, which are the same for all canopy layers.
+ *****************************************************************************/
+void
+photosynth_kinetics(char                   Ctype,
+                    double                 Tfoliage,
+                    double                 PIRRIN,
+                    photo_kinetics_struct *kinetics)
+{
+    extern parameters_struct param;
+
+    double                   T;
+    double                   T1;
+    double                   T0;
+
+    T1 = 25 + CONST_TKFRZ;
+    T = Tfoliage + CONST_TKFRZ;     // Canopy or Vegetation Temperature in Kelvin
+    T0 = T - T1;               // T relative to 25 degree Celsius, means T - 25
+
+    kinetics->Tfoliage = Tfoliage;
+    kinetics->T = T;
+
+    /* see photosynth_layer for the equations */
+    kinetics->Vcmax_T = exp(param.PHOTO_EV * (T0 / T1) / (CONST_RGAS * T));
+    kinetics->Rdark_T = exp(param.PHOTO_ER * (T0 / T1) / (CONST_RGAS * T));
+    kinetics->hiTinhib = hiTinhib(Tfoliage);
+    kinetics->darkinhib = darkinhib(PIRRIN);
+    if (Ctype == PHOTO_C3) {
+        kinetics->KC = param.PHOTO_KC *
+                       exp(param.PHOTO_EC * (T0 / T1) / (CONST_RGAS * T));
+        kinetics->KO = param.PHOTO_KO *
+                       exp(param.PHOTO_EO * (T0 / T1) / (CONST_RGAS * T));
+        kinetics->gamma = 1.7E-6 * Tfoliage;
+        if (kinetics->gamma < 0) {
+            kinetics->gamma = 0;
+        }
+        kinetics->K_T = 0.;
+    }
+    else {
+        kinetics->KC = 0.;
+        kinetics->KO = 0.;
+        kinetics->gamma = 0.;
+        kinetics->K_T = exp(param.PHOTO_EK * (T0 / T1) / (CONST_RGAS * T));
+    }
+}
+
 /******************************************************************************
  * @brief    Calculate photosynthesis, based on Farquhar (C3) and Collatz (C4)
  *           formulations
@@ -48,12 +95,45 @@ photosynth(char    Ctype,
            double *Rdark,
            double *Rphoto,
            double *Agross)
+{
+    photo_kinetics_struct kinetics;
+
+    photosynth_kinetics(Ctype, Tfoliage, PIRRIN, &kinetics);
+    photosynth_layer(Ctype, MaxCarboxRate, MaxETransport, CO2Specificity,
+                     NscaleFactor, aPAR, Psurf, Catm,
+                     !strcasecmp(mode, "ci"), &kinetics, rs, Ci, Rdark,
+                     Rphoto, Agross);
+}
+
+/******************************************************************************
+ * @brief    Calculate photosynthesis of a canopy layer, based on Farquhar (C3)
+ *           and Collatz (C4) formulations
+ * @details  The terms that only depend on the foliage temperature and the
+ *           irradiance are taken from photosynth_kinetics. With ci_mode, Ci
+ *           is given and rs is computed, otherwise rs is given and Ci is
+ *           computed.
+ *****************************************************************************/
+void
+photosynth_layer(char                   Ctype,
+                 double                 MaxCarboxRate,
+                 double                 MaxETransport,
+                 double                 CO2Specificity,
+                 double                 NscaleFactor,
+                 double                 aPAR,
+                 double                 Psurf,
+                 double                 Catm,
+                 bool                   ci_mode,
+                 photo_kinetics_struct *kinetics,
+                 double                *rs,
+                 double                *Ci,
+                 double                *Rdark,
+                 double                *Rphoto,
+                 double                *Agross)
 {
     extern parameters_struct param;
 
     double                   T;
-    double                   T1;
-    double                   T0;
+    double                   Tfoliage;
     double                   Vcmax;
     double                   KC;
     double                   KO;
@@ -73,9 +153,8 @@ photosynth(char    Ctype,
     double                   C;
     double                   tmp;
 
-    T1 = 25 + CONST_TKFRZ;
-    T = Tfoliage + CONST_TKFRZ;     // Canopy or Vegetation Temperature in Kelvin
-    T0 = T - T1;               // T relative to 25 degree Celsius, means T - 25
+    T = kinetics->T;
+    Tfoliage = kinetics->Tfoliage;
 
     /********************************************************************************
        ! Vcmax and Jmax are not only temperature dependent but also differ inside the canopy.
@@ -85,8 +164,7 @@ photosynth(char    Ctype,
        ! exponentially inside the canopy. This is reflected directly in the values of Vcmax
        ! and Jmax at 25 Celsius (Vcmax * nscl),  Knorr (107/108)
     ********************************************************************************/
-    Vcmax = MaxCarboxRate * NscaleFactor *
-            exp(param.PHOTO_EV * (T0 / T1) / (CONST_RGAS * T));
+    Vcmax = MaxCarboxRate * NscaleFactor * kinetics->Vcmax_T;
 
     /********************************************************************************
        ! Determine temperature-dependent rates, compensation point, and 'dark' respiration
@@ -108,20 +186,15 @@ photosynth(char    Ctype,
            !    Rdark-Dark respiration, K-PEPcase CO2 specivity
            !    Knorr (106)
         ********************************************************************************/
-        KC = param.PHOTO_KC *
-             exp(param.PHOTO_EC * (T0 / T1) / (CONST_RGAS * T));
-        KO = param.PHOTO_KO *
-             exp(param.PHOTO_EO * (T0 / T1) / (CONST_RGAS * T));
+        KC = kinetics->KC;
+        KO = kinetics->KO;
 
         /********************************************************************************
            ! CO2 compensation point without leaf respiration, gamma* is assumed to be linearly
            ! dependent on vegetation temperature, gamma* = 1.7 * TC (if gamma* in microMol/Mol)
            ! Here, gamma in Mol/Mol,       Knorr (105)
         ********************************************************************************/
-        gamma = 1.7E-6 * Tfoliage;
-        if (gamma < 0) {
-            gamma = 0;
-        }
+        gamma = kinetics->gamma;
 
         /********************************************************************************
            ! The temperature dependence of the electron transport capacity follows
@@ -150,10 +223,7 @@ photosynth(char    Ctype,
            ! goes with ER (for respiration) and not with EV (for Vcmax)
         ********************************************************************************/
         *Rdark = param.PHOTO_FRDC3 * MaxCarboxRate * NscaleFactor *
-                 exp(param.PHOTO_ER *
-                     (T0 /
-                      T1) / (CONST_RGAS * T)) * hiTinhib(Tfoliage) * darkinhib(
-            PIRRIN);
+                 kinetics->Rdark_T * kinetics->hiTinhib * kinetics->darkinhib;
     }
     else if (Ctype == PHOTO_C4) {
         /********************************************************************************
@@ -183,8 +253,7 @@ photosynth(char    Ctype,
            !   which is not considered in INITVEGDATA
            ! K scales of course with EK
         ********************************************************************************/
-        K = CO2Specificity * 1.E3 * NscaleFactor * exp(
-            param.PHOTO_EK * (T0 / T1) / (CONST_RGAS * T));
+        K = CO2Specificity * 1.E3 * NscaleFactor * kinetics->K_T;
 
         /********************************************************************************
            !  Compute 'dark' respiration
@@ -192,13 +261,10 @@ photosynth(char    Ctype,
            !    0.011 for C3,  0.0042 for C4
         ********************************************************************************/
         *Rdark = param.PHOTO_FRDC4 * MaxCarboxRate * NscaleFactor *
-                 exp(param.PHOTO_ER *
-                     (T0 /
-                      T1) / (CONST_RGAS * T)) * hiTinhib(Tfoliage) * darkinhib(
-            PIRRIN);
+                 kinetics->Rdark_T * kinetics->hiTinhib * kinetics->darkinhib;
     } // End computation of T-dependent rates and dark respiration
 
-    if (!strcasecmp(mode, "ci")) {
+    if (ci_mode) {
         /********************************************************************************
            ! If Ci given, compute gross photosynthesis components at given leaf-internal CO2
         ********************************************************************************/
@@ -365,17 +431,17 @@ photosynth(char    Ctype,
     ********************************************************************************/
     if (JE < JC) {
         /* light limitation */
-        *Agross = JE * hiTinhib(Tfoliage);
+        *Agross = JE * kinetics->hiTinhib;
     }
     else {
         /* CO2 limitation */
-        *Agross = JC * hiTinhib(Tfoliage);
+        *Agross = JC * kinetics->hiTinhib;
     }
 
     /********************************************************************************
        ! If rs given, compute leaf-internal CO2 concentration
     ********************************************************************************/
-    if (!strcasecmp(mode, "rs")) {
+    if (!ci_mode) {
         /********************************************************************************
            ! A = gs / 1.6 * (Catm - Ci) * p / Rgas / T
            ! <=> Ci = Catm - 1.6 * Rgas * T / p / gs * A = Catm - A / G0
@@ -405,8 +471,8 @@ photosynth(char    Ctype,
            ! Photorespiration = Vcmax * gamma / (Ci + K2)
         ********************************************************************************/
         *Rphoto = Vcmax * gamma /
-                  ((*Ci) + KC * (1. + param.PHOTO_OX / KO)) * hiTinhib(
-            Tfoliage);
+                  ((*Ci) + KC * (1. + param.PHOTO_OX / KO)) *
+                  kinetics->hiTinhib;
     }
     else {
         /********************************************************************************
@@ -418,7 +484,7 @@ photosynth(char    Ctype,
     /********************************************************************************
        ! If ci given, compute stomatal resistance
     ********************************************************************************/
-    if (!strcasecmp(mode, "ci")) {
+    if (ci_mode) {
         /********************************************************************************
            ! Diffusion equation Flux = (Catm - CI) / resistence, rs
            !   conductance gs = 1 / rs  =>  Flux = (Catm-CI) * gs
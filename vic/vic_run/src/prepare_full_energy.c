@@ -32,9 +32,15 @@
  * @brief    This subroutine returns the soil thermal properties, moisture and
  *           ice contents for the top two layers for use with the QUICK_FLUX
  *           ground heat flux solution.
+ *
+ * @details  Only the first Nbands elevation bands are processed, the lake
+ *           tile uses a single band.  The thermal properties are only
+ *           computed for the top two layers, which are the only ones
+ *           stored in the energy balance structure.
  *****************************************************************************/
 void
 prepare_full_energy(int              iveg,
+                    size_t           Nbands,
                     all_vars_struct *all_vars,
                     soil_con_struct *soil_con,
                     double          *moist0,
@@ -43,14 +49,14 @@ prepare_full_energy(int              iveg,
     extern option_struct options;
 
     size_t               i, band;
-    layer_data_struct   *layer = NULL;
+    size_t               Nlayers;
+    layer_data_struct    layer[2];
 
-    layer = calloc(options.Nlayer, sizeof(*layer));
-    check_alloc_status(layer, "Memory allocation error.");
+    Nlayers = OPT_Nlayer < 2 ? OPT_Nlayer : 2;
 
-    for (band = 0; band < options.SNOW_BAND; band++) {
+    for (band = 0; band < Nbands; band++) {
         if (soil_con->AreaFract[band] > 0.0) {
-            for (i = 0; i < options.Nlayer; i++) {
+            for (i = 0; i < 2; i++) {
                 layer[i] = all_vars->cell[iveg][band].layer[i];
             }
 
@@ -60,7 +66,7 @@ prepare_full_energy(int              iveg,
 
             /* Compute top soil layer ice content (mm/mm) */
 
-            if (options.FROZEN_SOIL && soil_con->FS_ACTIVE) {
+            if (OPT_FROZEN_SOIL && soil_con->FS_ACTIVE) {
                 if ((all_vars->energy[iveg][band].T[0] +
                      all_vars->energy[iveg][band].T[1]) / 2. < 0.) {
                     ice0[band] = moist0[band] -
@@ -87,14 +93,9 @@ prepare_full_energy(int              iveg,
 
             /** Compute Soil Thermal Properties **/
             compute_soil_layer_thermal_properties(layer, soil_con->depth,
-                                                  soil_con->bulk_dens_min,
-                                                  soil_con->soil_dens_min,
-                                                  soil_con->quartz,
-                                                  soil_con->bulk_density,
-                                                  soil_con->soil_density,
-                                                  soil_con->organic,
+                                                  soil_con->thermal_coef,
                                                   soil_con->frost_fract,
-                                                  options.Nlayer);
+                                                  Nlayers);
 
             /** Save Thermal Conductivities for Energy Balance **/
             all_vars->energy[iveg][band].kappa[0] = layer[0].kappa;
@@ -106,6 +107,4 @@ prepare_full_energy(int              iveg,
             ice0[band] = 0.;
         }
     }
-
-    free((char *) layer);
 }
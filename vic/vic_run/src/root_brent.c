@@ -60,18 +60,17 @@
 * @param LowerBound Lower bound for root
 * @param UpperBound Upper bound for root
 * @param Function
-* @param ap Variable arguments
+* @param ctx Arguments of Function, passed unchanged to every evaluation
 * @return b
 ******************************************************************************/
 double
-root_brent(double LowerBound,
-           double UpperBound,
-           double (*Function)(double Estimate, va_list ap),
-           ...)
+root_brent_ctx(double LowerBound,
+               double UpperBound,
+               double (*Function)(double Estimate, void *ctx),
+               void  *ctx)
 {
     extern parameters_struct param;
 
-    va_list                  ap; /* Used in traversing variable argument list */
     double                   a;
     double                   b;
     double                   c;
@@ -91,23 +90,23 @@ root_brent(double LowerBound,
     int                      which_err;
     int                      i;
     int                      j;
+#if LOG_LVL < 30
+    char                     ref_str[MAXSTRING];
+#endif
 
-    /* initialize variable argument list */
     a = LowerBound;
     b = UpperBound;
-    va_start(ap, Function);
-    fa = Function(a, ap);
-    va_start(ap, Function);
-    fb = Function(b, ap);
+    fa = Function(a, ctx);
+    fb = Function(b, ctx);
 
     which_err = 0;
 
     // If Function returns values of ERROR for both bounds, give up
     if (fa == ERROR && fb == ERROR) {
-        log_warn("lower and upper bounds %f and %f "
-                 "failed to bracket the root because the given function was "
-                 "not defined at either point.", a, b);
-        va_end(ap);
+        log_warn_repeat("lower and upper bounds %f and %f failed to bracket "
+                        "the root because the given function was not defined "
+                        "at either point.", a, b);
+        solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
         return(ERROR);
     }
 
@@ -126,27 +125,25 @@ root_brent(double LowerBound,
         }
 
         c = 0.5 * (last_bad + last_good);
-        va_start(ap, Function);
-        fc = Function(c, ap);
+        fc = Function(c, ctx);
 
         /* search for valid point via bisection */
         j = 0;
         while (fc == ERROR && j < param.ROOT_BRENT_MAXITER) {
             last_bad = c;
             c = 0.5 * (last_bad + last_good);
-            va_start(ap, Function);
-            fc = Function(c, ap);
+            fc = Function(c, ctx);
             j++;
         }
 
         if (fc == ERROR) {
             /* if we get here, we could not find a bound for which the function
                returns a valid value */
-            log_warn("the given function produced "
-                     "undefined values while attempting to "
-                     "bracket the root between %f and %f. Driver info: %s.",
-                     LowerBound, UpperBound, vic_run_ref_str);
-            va_end(ap);
+            log_warn_repeat("the given function produced undefined values "
+                            "while attempting to bracket the root between %f "
+                            "and %f. Driver info: %s.", LowerBound, UpperBound,
+                            sprint_vic_run_ref(ref_str));
+            solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
             return(ERROR);
         }
         else {
@@ -172,39 +169,36 @@ root_brent(double LowerBound,
         if (which_err == 0) { // No undefined values were encountered
             a -= param.ROOT_BRENT_TSTEP;
             b += param.ROOT_BRENT_TSTEP;
-            va_start(ap, Function);
-            fa = Function(a, ap);
-            va_start(ap, Function);
-            fb = Function(b, ap);
+            fa = Function(a, ctx);
+            fb = Function(b, ctx);
         }
         else { // Undefined values were encountered
             if (which_err == -1) { // Undefined values encountered in the lower direction
                 b += param.ROOT_BRENT_TSTEP;
-                va_start(ap, Function);
-                fb = Function(b, ap);
+                fb = Function(b, ctx);
                 if (fb == ERROR) {
                     /* Undefined function values in both directions - give up */
-                    log_warn("the given function "
-                             "produced undefined values while "
-                             "attempting to bracket the root "
-                             "between %f and %f. Driver info: %s.",
-                             LowerBound, UpperBound, vic_run_ref_str);
-                    va_end(ap);
+                    log_warn_repeat("the given function produced undefined "
+                                    "values while attempting to bracket the "
+                                    "root between %f and %f. Driver info: %s.",
+                                    LowerBound, UpperBound,
+                                    sprint_vic_run_ref(ref_str));
+                    solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
                     return(ERROR);
                 }
                 last_good = a;
             }
             else { // Undefined values encountered in the upper direction
                 a -= param.ROOT_BRENT_TSTEP;
-                va_start(ap, Function);
-                fa = Function(a, ap);
+                fa = Function(a, ctx);
                 if (fa == ERROR) {
                     /* Undefined function values in both directions - give up */
-                    log_warn("the given function produced undefined "
-                             "values while attempting to bracket the root "
-                             "between %f and %f. Driver info: %s.",
-                             LowerBound, UpperBound, vic_run_ref_str);
-                    va_end(ap);
+                    log_warn_repeat("the given function produced undefined "
+                                    "values while attempting to bracket the "
+                                    "root between %f and %f. Driver info: %s.",
+                                    LowerBound, UpperBound,
+                                    sprint_vic_run_ref(ref_str));
+                    solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
                     return(ERROR);
                 }
                 last_good = b;
@@ -212,24 +206,22 @@ root_brent(double LowerBound,
 
             /* search for valid point via bisection */
             c = 0.5 * (last_good + last_bad);
-            va_start(ap, Function);
-            fc = Function(c, ap);
+            fc = Function(c, ctx);
             i = 0;
             while (fc == ERROR && i < param.ROOT_BRENT_MAXITER) {
                 last_bad = c;
                 c = 0.5 * (last_bad + last_good);
-                va_start(ap, Function);
-                fc = Function(c, ap);
+                fc = Function(c, ctx);
                 i++;
             }
 
             if (fc == ERROR) {
                 /* if we get here, we could not find a bound for which the function returns a valid value */
-                log_warn("the given function produced undefined "
-                         "values while attempting to bracket the root between "
-                         "%f and %f. Driver info: %s.",
-                         LowerBound, UpperBound, vic_run_ref_str);
-                va_end(ap);
+                log_warn_repeat("the given function produced undefined values "
+                                "while attempting to bracket the root between "
+                                "%f and %f. Driver info: %s.", LowerBound,
+                                UpperBound, sprint_vic_run_ref(ref_str));
+                solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
                 return(ERROR);
             }
             else {
@@ -248,10 +240,10 @@ root_brent(double LowerBound,
     }
     if ((fa * fb) >= 0) {
         /* if we get here, the lower and upper bounds did not bracket the root */
-        log_warn("lower and upper bounds %f and %f failed to "
-                 "bracket the root. Driver info: %s.",
-                 a, b, vic_run_ref_str);
-        va_end(ap);
+        log_warn_repeat("lower and upper bounds %f and %f failed to bracket "
+                        "the root. Driver info: %s.", a, b,
+                        sprint_vic_run_ref(ref_str));
+        solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
         return(ERROR);
     }
 
@@ -262,6 +254,8 @@ root_brent(double LowerBound,
     fc = fb;
 
     for (i = 0; i < param.ROOT_BRENT_MAXITER; i++) {
+        solver_stats[SOLVER_BRENT_ITER]++;
+
         if (fb * fc > 0) {
             c = a;
             fc = fa;
@@ -282,7 +276,6 @@ root_brent(double LowerBound,
         m = 0.5 * (c - b);
 
         if (fabs(m) <= tol || fb == 0) {
-            va_end(ap);
             return b;
         }
         else {
@@ -328,21 +321,109 @@ root_brent(double LowerBound,
             a = b;
             fa = fb;
             b += (fabs(d) > tol) ? d : ((m > 0) ? tol : -tol);
-            va_start(ap, Function);
-            fb = Function(b, ap);
+            fb = Function(b, ctx);
 
             // Catch ERROR values returned from Function
             if (fb == ERROR) {
-                log_warn("iteration %d: temperature = %.4f. Driver info: %s.",
-                         i + 1, b, vic_run_ref_str);
-                va_end(ap);
+                log_warn_repeat("iteration %d: temperature = %.4f. Driver "
+                                "info: %s.", i + 1, b,
+                                sprint_vic_run_ref(ref_str));
                 return(ERROR);
             }
         }
     }
     /* If we get here, there were too many iterations */
-    log_warn("too many iterations. Driver info: %s.",
-             vic_run_ref_str);
-    va_end(ap);
+    log_warn_repeat("too many iterations. Driver info: %s.",
+                    sprint_vic_run_ref(ref_str));
     return(ERROR);
 }
+
+/******************************************************************************
+* @brief Search a root again after root_brent_ctx() or root_newton_ctx()
+*        failed, with ROOT_RETRY.
+*
+* @details
+*
+* The bracket [Tlast - ROOT_BRENT_RETRY_DT, Tlast + ROOT_BRENT_RETRY_DT] is
+* centered on the last temperature solved for the tile, i.e. the state of
+* the previous time step, which TFALLBACK keeps when a solution fails. It is
+* usually much wider than the bracket of the first search, so that the root
+* is found in one more root_brent_ctx() call instead of failing every step.
+* Each root found counts towards SOLVER_BRENT_RETRY; the first search still
+* counts towards SOLVER_BRENT_BRACKET_FAIL.
+*
+* @param Tlast Last temperature solved for the tile
+* @param Function
+* @param ctx Arguments of Function, passed unchanged to every evaluation
+* @return root, or ERROR if the retry failed too
+******************************************************************************/
+double
+root_brent_retry_ctx(double Tlast,
+                     double (*Function)(double Estimate, void *ctx),
+                     void  *ctx)
+{
+    extern parameters_struct param;
+
+    double                   root;
+
+    root = root_brent_ctx(Tlast - param.ROOT_BRENT_RETRY_DT,
+                          Tlast + param.ROOT_BRENT_RETRY_DT, Function, ctx);
+    if (root > -998) {
+        solver_stats[SOLVER_BRENT_RETRY]++;
+    }
+
+    return root;
+}
+
+/******************************************************************************
+* @brief Residual and argument list of a root_brent() call
+******************************************************************************/
+typedef struct {
+    double (*Function)(double Estimate, va_list ap);
+    va_list ap;
+} root_brent_va_struct;
+
+/******************************************************************************
+* @brief Evaluate a variable argument list residual with a copy of the list
+******************************************************************************/
+static double
+root_brent_va(double Estimate,
+              void  *ctx)
+{
+    root_brent_va_struct *va = (root_brent_va_struct *) ctx;
+    va_list               ap;
+    double                value;
+
+    va_copy(ap, va->ap);
+    value = va->Function(Estimate, ap);
+    va_end(ap);
+
+    return value;
+}
+
+/******************************************************************************
+* @brief Brent (1973) root finding algorithm for a residual that reads its
+*        arguments from a variable argument list, see root_brent_ctx().
+*
+* @param LowerBound Lower bound for root
+* @param UpperBound Upper bound for root
+* @param Function
+* @param ... Variable arguments
+* @return b
+******************************************************************************/
+double
+root_brent(double LowerBound,
+           double UpperBound,
+           double (*Function)(double Estimate, va_list ap),
+           ...)
+{
+    root_brent_va_struct va;
+    double               b;
+
+    va.Function = Function;
+    va_start(va.ap, Function);
+    b = root_brent_ctx(LowerBound, UpperBound, root_brent_va, &va);
+    va_end(va.ap);
+
+    return b;
+}
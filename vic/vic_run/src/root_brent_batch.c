@@ -0,0 +1,331 @@
+/******************************************************************************
+* @section DESCRIPTION
+*
+* Batched Brent root finding algorithm
+*
+* @section LICENSE
+*
+* The Variable Infiltration Capacity (VIC) macroscale hydrological model
+* Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+* and Environmental Engineering, University of Washington.
+*
+* The VIC model is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+******************************************************************************/
+
+#include <vic_run.h>
+
+enum
+{
+    BRENT_LANE_ACTIVE,   /**< lane is being solved */
+    BRENT_LANE_DONE,     /**< root (or ERROR) found */
+    BRENT_LANE_SCALAR    /**< undefined residual at a bound, see root_brent_ctx */
+};
+
+/******************************************************************************
+* @brief Batched residual and the lane of a single-lane evaluation
+******************************************************************************/
+typedef struct {
+    void (*Function)(size_t n, const double *x, const bool *active, double *f,
+                     void *ctx);
+    void *ctx;
+    size_t n;
+    size_t lane;
+    double *x;
+    bool *active;
+    double *f;
+} root_brent_lane_struct;
+
+/******************************************************************************
+* @brief Evaluate one lane of a batched residual
+******************************************************************************/
+static double
+root_brent_lane(double Estimate,
+                void  *ctx)
+{
+    root_brent_lane_struct *lane = (root_brent_lane_struct *) ctx;
+
+    lane->x[lane->lane] = Estimate;
+    lane->active[lane->lane] = true;
+    lane->Function(lane->n, lane->x, lane->active, lane->f, lane->ctx);
+    lane->active[lane->lane] = false;
+
+    return lane->f[lane->lane];
+}
+
+/******************************************************************************
+* @brief Brent (1973) root finding algorithm for n independent residuals
+*
+* @details
+*
+* Runs the iteration of root_brent_ctx() for n lanes at once, e.g. the energy
+* balances of the tiles of a cell or of a block of cells. Function evaluates
+* the residuals f[k] at x[k] of the lanes k with active[k] set, and must leave
+* the other lanes alone, so that each call can be a vector loop over the
+* batch. Lanes leave the batch as their roots are found and the iteration
+* continues with the others.
+*
+* Every lane takes the steps of root_brent_ctx() on its own bracket, so that
+* root[k] is the value that root_brent_ctx() returns for the residual of lane
+* k, or ERROR. A lane whose residual is undefined (ERROR) at one of its
+* bounds is solved on its own with root_brent_ctx() once the batch is done,
+* since its bracket search does not follow the other lanes.
+*
+* The state of the lanes is taken from the scratch memory of vic_run.
+*
+* @param n Number of lanes
+* @param LowerBound Lower bounds for the roots [n]
+* @param UpperBound Upper bounds for the roots [n]
+* @param Function Batched residual
+* @param ctx Arguments of Function, passed unchanged to every evaluation
+* @param root Roots [n]
+******************************************************************************/
+void
+root_brent_batch_ctx(size_t        n,
+                     const double *LowerBound,
+                     const double *UpperBound,
+                     void (       *Function)(size_t n, const double *x,
+                                             const bool *active, double *f,
+                                             void *ctx),
+                     void         *ctx,
+                     double       *root)
+{
+    extern parameters_struct param;
+
+    double                  *a;
+    double                  *b;
+    double                  *c;
+    double                  *d;
+    double                  *e;
+    double                  *fa;
+    double                  *fb;
+    double                  *fc;
+    double                  *x;
+    double                  *f;
+    bool                    *active;
+    int                     *state;
+    double                   m;
+    double                   p;
+    double                   q;
+    double                   r;
+    double                   s;
+    double                   tol;
+    size_t                   k;
+    size_t                   nactive;
+    int                      i;
+    int                      j;
+    scratch_mark_struct      scratch_start;
+    root_brent_lane_struct   lane;
+#if LOG_LVL < 30
+    char                     ref_str[MAXSTRING];
+#endif
+
+    if (n == 0) {
+        return;
+    }
+
+    scratch_start = scratch_mark();
+    a = scratch_calloc(n, sizeof(*a));
+    b = scratch_calloc(n, sizeof(*b));
+    c = scratch_calloc(n, sizeof(*c));
+    d = scratch_calloc(n, sizeof(*d));
+    e = scratch_calloc(n, sizeof(*e));
+    fa = scratch_calloc(n, sizeof(*fa));
+    fb = scratch_calloc(n, sizeof(*fb));
+    fc = scratch_calloc(n, sizeof(*fc));
+    x = scratch_calloc(n, sizeof(*x));
+    f = scratch_calloc(n, sizeof(*f));
+    active = scratch_calloc(n, sizeof(*active));
+    state = scratch_calloc(n, sizeof(*state));
+
+    for (k = 0; k < n; k++) {
+        a[k] = LowerBound[k];
+        b[k] = UpperBound[k];
+        active[k] = true;
+    }
+    Function(n, a, active, fa, ctx);
+    Function(n, b, active, fb, ctx);
+
+    // lanes with an undefined residual at a bound search their bracket on
+    // their own
+    for (k = 0; k < n; k++) {
+        state[k] = BRENT_LANE_ACTIVE;
+        if (fa[k] == ERROR || fb[k] == ERROR) {
+            state[k] = BRENT_LANE_SCALAR;
+        }
+    }
+
+    /*  if root not bracketed attempt to bracket the root */
+    for (j = 0; j < param.ROOT_BRENT_MAXTRIES; j++) {
+        nactive = 0;
+        for (k = 0; k < n; k++) {
+            active[k] = state[k] == BRENT_LANE_ACTIVE && (fa[k] * fb[k]) >= 0;
+            if (active[k]) {
+                a[k] -= param.ROOT_BRENT_TSTEP;
+                b[k] += param.ROOT_BRENT_TSTEP;
+                nactive++;
+            }
+        }
+        if (nactive == 0) {
+            break;
+        }
+        Function(n, a, active, fa, ctx);
+        Function(n, b, active, fb, ctx);
+    }
+    for (k = 0; k < n; k++) {
+        active[k] = false;
+        if (state[k] != BRENT_LANE_ACTIVE) {
+            continue;
+        }
+        if ((fa[k] * fb[k]) >= 0) {
+            /* if we get here, the lower and upper bounds did not bracket the
+               root */
+            log_warn_repeat("lower and upper bounds %f and %f failed to "
+                            "bracket the root. Driver info: %s.", a[k], b[k],
+                            sprint_vic_run_ref(ref_str));
+            solver_stats[SOLVER_BRENT_BRACKET_FAIL]++;
+            root[k] = ERROR;
+            state[k] = BRENT_LANE_DONE;
+        }
+        else {
+            fc[k] = fb[k];
+        }
+    }
+
+    // At this point, the roots of the active lanes are bracketed
+
+    for (i = 0; i < param.ROOT_BRENT_MAXITER; i++) {
+        nactive = 0;
+        for (k = 0; k < n; k++) {
+            active[k] = false;
+            if (state[k] != BRENT_LANE_ACTIVE) {
+                continue;
+            }
+            solver_stats[SOLVER_BRENT_ITER]++;
+
+            if (fb[k] * fc[k] > 0) {
+                c[k] = a[k];
+                fc[k] = fa[k];
+                d[k] = b[k] - a[k];
+                e[k] = d[k];
+            }
+
+            if (fabs(fc[k]) < fabs(fb[k])) {
+                a[k] = b[k];
+                b[k] = c[k];
+                c[k] = a[k];
+                fa[k] = fb[k];
+                fb[k] = fc[k];
+                fc[k] = fa[k];
+            }
+
+            tol = 2 * DBL_EPSILON * fabs(b[k]) + param.ROOT_BRENT_T;
+            m = 0.5 * (c[k] - b[k]);
+
+            if (fabs(m) <= tol || fb[k] == 0) {
+                root[k] = b[k];
+                state[k] = BRENT_LANE_DONE;
+                continue;
+            }
+
+            if (fabs(e[k]) < tol || fabs(fa[k]) <= fabs(fb[k])) {
+                d[k] = m;
+                e[k] = d[k];
+            }
+            else {
+                s = fb[k] / fa[k];
+
+                if (a[k] == c[k]) {
+                    /* linear interpolation */
+
+                    p = 2 * m * s;
+                    q = 1 - s;
+                }
+                else {
+                    /* inverse quadratic interpolation */
+
+                    q = fa[k] / fc[k];
+                    r = fb[k] / fc[k];
+                    p = s * (2 * m * q * (q - r) - (b[k] - a[k]) * (r - 1));
+                    q = (q - 1) * (r - 1) * (s - 1);
+                }
+
+                if (p > 0) {
+                    q = -q;
+                }
+                else {
+                    p = -p;
+                }
+                s = e[k];
+                e[k] = d[k];
+                if ((2 * p) < (3 * m * q - fabs(tol * q)) && p <
+                    fabs(0.5 * s * q)) {
+                    d[k] = p / q;
+                }
+                else {
+                    d[k] = m;
+                    e[k] = d[k];
+                }
+            }
+            a[k] = b[k];
+            fa[k] = fb[k];
+            b[k] += (fabs(d[k]) > tol) ? d[k] : ((m > 0) ? tol : -tol);
+            active[k] = true;
+            nactive++;
+        }
+        if (nactive == 0) {
+            break;
+        }
+
+        Function(n, b, active, fb, ctx);
+
+        // Catch ERROR values returned from Function
+        for (k = 0; k < n; k++) {
+            if (active[k] && fb[k] == ERROR) {
+                log_warn_repeat("iteration %d: temperature = %.4f. Driver "
+                                "info: %s.", i + 1, b[k],
+                                sprint_vic_run_ref(ref_str));
+                root[k] = ERROR;
+                state[k] = BRENT_LANE_DONE;
+            }
+        }
+    }
+    for (k = 0; k < n; k++) {
+        active[k] = false;
+        if (state[k] == BRENT_LANE_ACTIVE) {
+            /* If we get here, there were too many iterations */
+            log_warn_repeat("too many iterations. Driver info: %s.",
+                            sprint_vic_run_ref(ref_str));
+            root[k] = ERROR;
+            state[k] = BRENT_LANE_DONE;
+        }
+    }
+
+    // the lanes that are solved on their own
+    lane.Function = Function;
+    lane.ctx = ctx;
+    lane.n = n;
+    lane.x = x;
+    lane.active = active;
+    lane.f = f;
+    for (k = 0; k < n; k++) {
+        if (state[k] == BRENT_LANE_SCALAR) {
+            lane.lane = k;
+            root[k] = root_brent_ctx(LowerBound[k], UpperBound[k],
+                                     root_brent_lane, &lane);
+        }
+    }
+
+    scratch_release(scratch_start);
+}
@@ -0,0 +1,128 @@
+/******************************************************************************
+* @section DESCRIPTION
+*
+* Safeguarded secant root finding algorithm with a Brent fallback
+*
+* @section LICENSE
+*
+* The Variable Infiltration Capacity (VIC) macroscale hydrological model
+* Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+* and Environmental Engineering, University of Washington.
+*
+* The VIC model is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+******************************************************************************/
+
+#include <vic_run.h>
+
+/******************************************************************************
+* @brief Secant (finite difference Newton) root finding algorithm
+*
+* @details
+*
+* The iteration starts at Estimate, typically the solution of the previous
+* time step, and takes a first step of NEWTON_DT_FRACT times the width of the
+* bracket [LowerBound, UpperBound] towards its center. Every following step
+* uses the secant through the last two points as the derivative of Function.
+* The root is accepted when a step is smaller than the tolerance of
+* root_brent_ctx() (2 * MACHEPS * |x| + T). Like root_brent_ctx(), which
+* widens a bracket that does not contain the root by ROOT_BRENT_TSTEP up to
+* ROOT_BRENT_MAXTRIES times, the iterates may leave the bracket by that much.
+*
+* If Function is not defined at an iterate, if the secant is flat, if an
+* iterate leaves the widened bracket or if no root is found within
+* MAX_NEWTON_ITER steps, the root is searched with root_brent_ctx() on the
+* original bracket.
+* Close to the solution of the previous time step this needs 3 to 4
+* evaluations of Function instead of 8 to 15.
+*
+* @param Estimate Initial estimate of the root
+* @param LowerBound Lower bound for root
+* @param UpperBound Upper bound for root
+* @param Function
+* @param ctx Arguments of Function, passed unchanged to every evaluation
+* @return root
+******************************************************************************/
+double
+root_newton_ctx(double Estimate,
+                double LowerBound,
+                double UpperBound,
+                double (*Function)(double Estimate, void *ctx),
+                void  *ctx)
+{
+    extern parameters_struct param;
+
+    double                   x0;
+    double                   x1;
+    double                   x2;
+    double                   f0;
+    double                   f1;
+    double                   tol;
+    double                   xmin;
+    double                   xmax;
+    int                      i;
+
+    if (Estimate < LowerBound || Estimate > UpperBound) {
+        Estimate = 0.5 * (LowerBound + UpperBound);
+    }
+
+    // the range searched by root_brent_ctx() when widening the bracket
+    xmin = LowerBound - param.ROOT_BRENT_MAXTRIES * param.ROOT_BRENT_TSTEP;
+    xmax = UpperBound + param.ROOT_BRENT_MAXTRIES * param.ROOT_BRENT_TSTEP;
+
+    x0 = Estimate;
+    f0 = Function(x0, ctx);
+    if (f0 == ERROR) {
+        return root_brent_ctx(LowerBound, UpperBound, Function, ctx);
+    }
+    if (f0 == 0) {
+        return x0;
+    }
+
+    // first step towards the center of the bracket
+    if (x0 < 0.5 * (LowerBound + UpperBound)) {
+        x1 = x0 + NEWTON_DT_FRACT * (UpperBound - LowerBound);
+    }
+    else {
+        x1 = x0 - NEWTON_DT_FRACT * (UpperBound - LowerBound);
+    }
+    f1 = Function(x1, ctx);
+
+    for (i = 0; i < MAX_NEWTON_ITER && f1 != ERROR; i++) {
+        if (f1 == 0) {
+            return x1;
+        }
+        if (f1 == f0) {
+            break;
+        }
+
+        x2 = x1 - f1 * (x1 - x0) / (f1 - f0);
+        if (x2 < xmin || x2 > xmax) {
+            break;
+        }
+
+        tol = 2 * DBL_EPSILON * fabs(x2) + param.ROOT_BRENT_T;
+        if (fabs(x2 - x1) <= tol) {
+            return x2;
+        }
+
+        x0 = x1;
+        f0 = f1;
+        x1 = x2;
+        f1 = Function(x1, ctx);
+    }
+
+    // the secant iteration did not converge inside the bracket
+    return root_brent_ctx(LowerBound, UpperBound, Function, ctx);
+}
@@ -55,24 +55,29 @@ runoff(cell_data_struct  *cell,
     double                     resid_moist[MAX_LAYERS]; // residual moisture (mm)
     double                     org_moist[MAX_LAYERS]; // total soil moisture (liquid and frozen) at beginning of this function (mm)
     double                     avail_liq[MAX_LAYERS][MAX_FROST_AREAS]; // liquid soil moisture available for evap/drainage (mm)
-    double                     liq[MAX_LAYERS]; // current liquid soil moisture (mm)
-    double                     ice[MAX_LAYERS]; // current frozen soil moisture (mm)
+    vic_real                   liq[MAX_LAYERS]; // current liquid soil moisture (mm)
+    vic_real                   ice[MAX_LAYERS]; // current frozen soil moisture (mm)
     double                     moist[MAX_LAYERS]; // current total soil moisture (liquid and frozen) (mm)
-    double                     max_moist[MAX_LAYERS]; // maximum storable moisture (liquid and frozen) (mm)
-    double                     Ksat[MAX_LAYERS];
-    double                     Q12[MAX_LAYERS - 1];
+    vic_real                   max_moist[MAX_LAYERS]; // maximum storable moisture (liquid and frozen) (mm)
+    vic_real                   moist_range[MAX_LAYERS]; // maximum minus residual moisture (mm)
+    vic_real                   Ksat[MAX_LAYERS];
+    vic_real                   Q12[MAX_LAYERS - 1];
     double                     Dsmax;
-    double                     tmp_inflow;
-    double                     tmp_moist;
+    vic_real                   tmp_inflow;
+    vic_real                   tmp_moist;
     double                     tmp_moist_for_runoff[MAX_LAYERS];
-    double                     tmp_liq;
-    double                     dt_inflow;
-    double                     dt_runoff;
+    vic_real                   tmp_liq;
+    vic_real                   dt_inflow;
+    vic_real                   dt_runoff;
     double                     runoff[MAX_FROST_AREAS];
     double                     tmp_dt_runoff[MAX_FROST_AREAS];
     double                     baseflow[MAX_FROST_AREAS];
-    double                     dt_baseflow;
-    double                     rel_moist;
+    double                     raw_baseflow;
+    vic_real                   dt_baseflow;
+    vic_real                   Ds_frac;
+    vic_real                   Ds_nonlin;
+    vic_real                   Ws_range;
+    vic_real                   rel_moist;
     double                     evap[MAX_LAYERS][MAX_FROST_AREAS];
     double                     sum_liq;
     double                     evap_fraction;
@@ -80,9 +85,10 @@ runoff(cell_data_struct  *cell,
     layer_data_struct         *layer;
     layer_data_struct          tmp_layer;
     unsigned short             runoff_steps_per_dt;
+    double                     runoff_steps_per_day;
 
     /** Set Residual Moisture **/
-    for (lindex = 0; lindex < options.Nlayer; lindex++) {
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
         resid_moist[lindex] = soil_con->resid_moist[lindex] *
                               soil_con->depth[lindex] * MM_PER_M;
     }
@@ -96,12 +102,21 @@ runoff(cell_data_struct  *cell,
 
     runoff_steps_per_dt = global_param.runoff_steps_per_day /
                           global_param.model_steps_per_day;
+    runoff_steps_per_day = (double) global_param.runoff_steps_per_day;
+    if (options.ADAPTIVE_SUBSTEPS) {
+        // RUNOFF_STEPS_PER_DAY is the largest number of sub-steps
+        runoff_steps_per_dt = get_runoff_steps(layer, soil_con, ppt,
+                                               resid_moist,
+                                               runoff_steps_per_dt);
+        runoff_steps_per_day = (double) runoff_steps_per_dt *
+                               global_param.model_steps_per_day;
+    }
 
     for (fidx = 0; fidx < (int)options.Nfrost; fidx++) {
         baseflow[fidx] = 0;
     }
 
-    for (lindex = 0; lindex < options.Nlayer; lindex++) {
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
         evap[lindex][0] = layer[lindex].evap / (double) runoff_steps_per_dt;
         org_moist[lindex] = layer[lindex].moist;
         layer[lindex].moist = 0;
@@ -140,32 +155,60 @@ runoff(cell_data_struct  *cell,
         }
     }
 
+    /** Set the parameters that are the same for all frost sub areas **/
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
+        Ksat[lindex] = soil_con->Ksat[lindex] / runoff_steps_per_day;
+
+        /** Set Layer Maximum Moisture Content **/
+        max_moist[lindex] = soil_con->max_moist[lindex];
+        moist_range[lindex] = soil_con->max_moist[lindex] -
+                              resid_moist[lindex];
+    }
+    Dsmax = soil_con->Dsmax / runoff_steps_per_day;
+    Ds_frac = Dsmax * soil_con->Ds / soil_con->Ws;
+    Ds_nonlin = Dsmax * (1 - soil_con->Ds / soil_con->Ws);
+    Ws_range = 1 - soil_con->Ws;
+    raw_baseflow = 0;
+
     for (fidx = 0; fidx < (int)options.Nfrost; fidx++) {
+        /** A frost sub area with the same ice content and evaporation as
+            the previous one has the same moisture fluxes **/
+        if (fidx > 0 && frost_area_repeats(layer, evap, fidx)) {
+            runoff[fidx] = runoff[fidx - 1];
+            baseflow[fidx] = raw_baseflow;
+            if (baseflow[fidx] < 0) {
+                layer[OPT_Nlayer - 1].evap += baseflow[fidx];
+                baseflow[fidx] = 0;
+            }
+            for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
+                layer[lindex].moist +=
+                    ((liq[lindex] + ice[lindex]) * frost_fract[fidx]);
+            }
+            cell->asat += A * frost_fract[fidx];
+            cell->runoff += runoff[fidx] * frost_fract[fidx];
+            cell->baseflow += baseflow[fidx] * frost_fract[fidx];
+            continue;
+        }
+
         /** ppt = amount of liquid water coming to the surface **/
         inflow = ppt;
 
         /**************************************************
            Initialize Variables
         **************************************************/
-        for (lindex = 0; lindex < options.Nlayer; lindex++) {
-            Ksat[lindex] = soil_con->Ksat[lindex] /
-                           global_param.runoff_steps_per_day;
-
+        for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
             /** Set Layer Liquid Moisture Content **/
             liq[lindex] = org_moist[lindex] - layer[lindex].ice[fidx];
 
             /** Set Layer Frozen Moisture Content **/
             ice[lindex] = layer[lindex].ice[fidx];
-
-            /** Set Layer Maximum Moisture Content **/
-            max_moist[lindex] = soil_con->max_moist[lindex];
         }
 
         /******************************************************
            Runoff Based on Soil Moisture Level of Upper Layers
         ******************************************************/
 
-        for (lindex = 0; lindex < options.Nlayer; lindex++) {
+        for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
             tmp_moist_for_runoff[lindex] = (liq[lindex] + ice[lindex]);
         }
         compute_runoff_and_asat(soil_con, tmp_moist_for_runoff, inflow, &A,
@@ -182,16 +225,15 @@ runoff(cell_data_struct  *cell,
 
         dt_inflow = inflow / (double) runoff_steps_per_dt;
 
-        Dsmax = soil_con->Dsmax / global_param.runoff_steps_per_day;
-
         for (time_step = 0; time_step < runoff_steps_per_dt; time_step++) {
+            solver_stats[SOLVER_RUNOFF_STEPS]++;
             inflow = dt_inflow;
 
             /*************************************
                Compute Drainage between Sublayers
             *************************************/
 
-            for (lindex = 0; lindex < options.Nlayer - 1; lindex++) {
+            for (lindex = 0; lindex < OPT_Nlayer - 1; lindex++) {
                 /** Brooks & Corey relation for hydraulic conductivity **/
 
                 if ((tmp_liq = liq[lindex] - evap[lindex][fidx]) <
@@ -199,15 +241,16 @@ runoff(cell_data_struct  *cell,
                     tmp_liq = resid_moist[lindex];
                 }
 
-                if (liq[lindex] > resid_moist[lindex]) {
+                if (liq[lindex] > resid_moist[lindex] &&
+                    tmp_liq > resid_moist[lindex]) {
                     Q12[lindex] = Ksat[lindex] *
                                   pow(((tmp_liq -
                                         resid_moist[lindex]) /
-                                       (soil_con->max_moist[lindex] -
-                                        resid_moist[lindex])),
+                                       moist_range[lindex]),
                                       soil_con->expt[lindex]);
                 }
                 else {
+                    // no drainage at or below residual moisture
                     Q12[lindex] = 0.;
                 }
             }
@@ -218,7 +261,7 @@ runoff(cell_data_struct  *cell,
             **************************************************/
 
             last_index = 0;
-            for (lindex = 0; lindex < options.Nlayer - 1; lindex++) {
+            for (lindex = 0; lindex < OPT_Nlayer - 1; lindex++) {
                 if (lindex == 0) {
                     dt_runoff = tmp_dt_runoff[fidx];
                 }
@@ -299,21 +342,18 @@ runoff(cell_data_struct  *cell,
             /** ARNO model for the bottom soil layer (based on bottom
                 soil layer moisture from previous time step) **/
 
-            lindex = options.Nlayer - 1;
+            lindex = OPT_Nlayer - 1;
 
             /** Compute relative moisture **/
             rel_moist =
                 (liq[lindex] -
-                 resid_moist[lindex]) /
-                (soil_con->max_moist[lindex] - resid_moist[lindex]);
+                 resid_moist[lindex]) / moist_range[lindex];
 
             /** Compute baseflow as function of relative moisture **/
-            frac = Dsmax * soil_con->Ds / soil_con->Ws;
-            dt_baseflow = frac * rel_moist;
+            dt_baseflow = Ds_frac * rel_moist;
             if (rel_moist > soil_con->Ws) {
-                frac = (rel_moist - soil_con->Ws) / (1 - soil_con->Ws);
-                dt_baseflow += Dsmax * (1 - soil_con->Ds / soil_con->Ws) * pow(
-                    frac, soil_con->c);
+                frac = (rel_moist - soil_con->Ws) / Ws_range;
+                dt_baseflow += Ds_nonlin * pow(frac, soil_con->c);
             }
 
             /** Make sure baseflow isn't negative **/
@@ -370,6 +410,7 @@ runoff(cell_data_struct  *cell,
 
             baseflow[fidx] += dt_baseflow;
         } /* end of sub-dt time step loop */
+        raw_baseflow = baseflow[fidx];
 
         /** If negative baseflow, reduce evap accordingly **/
         if (baseflow[fidx] < 0) {
@@ -378,14 +419,14 @@ runoff(cell_data_struct  *cell,
         }
 
         /** Recompute Asat based on final moisture level of upper layers **/
-        for (lindex = 0; lindex < options.Nlayer; lindex++) {
+        for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
             tmp_moist_for_runoff[lindex] = (liq[lindex] + ice[lindex]);
         }
         compute_runoff_and_asat(soil_con, tmp_moist_for_runoff, 0, &A,
                                 &tmp_runoff);
 
         /** Store tile-wide values **/
-        for (lindex = 0; lindex < options.Nlayer; lindex++) {
+        for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
             layer[lindex].moist +=
                 ((liq[lindex] + ice[lindex]) * frost_fract[fidx]);
         }
@@ -395,11 +436,13 @@ runoff(cell_data_struct  *cell,
     }
 
     /** Compute water table depth **/
-    wrap_compute_zwt(soil_con, cell);
+    if (options.COMPUTE_ZWT) {
+        wrap_compute_zwt(soil_con, cell);
+    }
 
     /** Recompute Thermal Parameters Based on New Moisture Distribution **/
-    if (options.FULL_ENERGY || options.FROZEN_SOIL) {
-        for (lindex = 0; lindex < options.Nlayer; lindex++) {
+    if (OPT_FULL_ENERGY || OPT_FROZEN_SOIL) {
+        for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
             tmp_layer = cell->layer[lindex];
             moist[lindex] = tmp_layer.moist;
         }
@@ -414,13 +457,9 @@ runoff(cell_data_struct  *cell,
                                                         soil_con->expt_node,
                                                         soil_con->bubble_node,
                                                         moist, soil_con->depth,
-                                                        soil_con->soil_dens_min,
-                                                        soil_con->bulk_dens_min,
-                                                        soil_con->quartz,
-                                                        soil_con->soil_density,
-                                                        soil_con->bulk_density,
-                                                        soil_con->organic, Nnodes,
-                                                        options.Nlayer,
+                                                        soil_con->thermal_coef,
+                                                        Nnodes,
+                                                        OPT_Nlayer,
                                                         soil_con->FS_ACTIVE);
         if (ErrorFlag == ERROR) {
             return (ERROR);
@@ -429,6 +468,104 @@ runoff(cell_data_struct  *cell,
     return (0);
 }
 
+/******************************************************************************
+* @brief    Number of runoff sub-steps of a time step with ADAPTIVE_SUBSTEPS.
+* @details  The inflow, drainage (or baseflow) and evaporation of each layer
+*           over the time step are estimated from the moisture at its start.
+*           Each sub-step may move at most ADAPT_RUNOFF_FRAC of the moisture
+*           range of a layer, and at most max_steps sub-steps are used.
+******************************************************************************/
+unsigned short
+get_runoff_steps(layer_data_struct *layer,
+                 soil_con_struct   *soil_con,
+                 double             ppt,
+                 double            *resid_moist,
+                 unsigned short     max_steps)
+{
+    extern option_struct       options;
+    extern global_param_struct global_param;
+    extern parameters_struct   param;
+
+    size_t                     lindex;
+    double                     inflow;
+    double                     drainage;
+    double                     moist_range;
+    double                     rel_moist;
+    double                     frac;
+    double                     steps;
+    double                     max_flux_steps;
+
+    max_flux_steps = 1.;
+    inflow = ppt;
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
+        moist_range = soil_con->max_moist[lindex] - resid_moist[lindex];
+        if (!(moist_range > 0.)) {
+            return max_steps;
+        }
+        rel_moist = (layer[lindex].moist - resid_moist[lindex]) / moist_range;
+        if (rel_moist < 0.) {
+            rel_moist = 0.;
+        }
+        else if (rel_moist > 1.) {
+            rel_moist = 1.;
+        }
+
+        if (lindex < OPT_Nlayer - 1) {
+            // Brooks & Corey drainage to the next layer
+            drainage = soil_con->Ksat[lindex] /
+                       global_param.model_steps_per_day *
+                       pow(rel_moist, soil_con->expt[lindex]);
+        }
+        else {
+            // ARNO baseflow of the bottom layer
+            drainage = soil_con->Dsmax * soil_con->Ds / soil_con->Ws *
+                       rel_moist;
+            if (rel_moist > soil_con->Ws) {
+                frac = (rel_moist - soil_con->Ws) / (1 - soil_con->Ws);
+                drainage += soil_con->Dsmax *
+                            (1 - soil_con->Ds / soil_con->Ws) *
+                            pow(frac, soil_con->c);
+            }
+            drainage /= global_param.model_steps_per_day;
+        }
+
+        steps = (inflow + drainage + fabs(layer[lindex].evap)) /
+                (param.ADAPT_RUNOFF_FRAC * moist_range);
+        if (steps > max_flux_steps) {
+            max_flux_steps = steps;
+        }
+        inflow = drainage;
+    }
+
+    if (max_flux_steps >= max_steps) {
+        return max_steps;
+    }
+    return (unsigned short) ceil(max_flux_steps);
+}
+
+/******************************************************************************
+* @brief    Check whether a frost sub area has the same ice content and
+*           evaporation in every layer as the previous frost sub area.
+******************************************************************************/
+bool
+frost_area_repeats(layer_data_struct *layer,
+                   double             evap[][MAX_FROST_AREAS],
+                   int                fidx)
+{
+    extern option_struct options;
+
+    size_t               lindex;
+
+    for (lindex = 0; lindex < OPT_Nlayer; lindex++) {
+        if (layer[lindex].ice[fidx] != layer[lindex].ice[fidx - 1] ||
+            evap[lindex][fidx] != evap[lindex][fidx - 1]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /******************************************************************************
 * @brief    Calculate the saturated area and runoff
 ******************************************************************************/
@@ -450,7 +587,7 @@ compute_runoff_and_asat(soil_con_struct *soil_con,
 
     top_moist = 0.;
     top_max_moist = 0.;
-    for (lindex = 0; lindex < options.Nlayer - 1; lindex++) {
+    for (lindex = 0; lindex < OPT_Nlayer - 1; lindex++) {
         top_moist += moist[lindex];
         top_max_moist += soil_con->max_moist[lindex];
     }
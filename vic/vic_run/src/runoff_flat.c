@@ -0,0 +1,424 @@
+/******************************************************************************
+* @section DESCRIPTION
+*
+* Water balance runoff of a set of cells stored as flat arrays. Built with
+* VIC_OFFLOAD, the cells are computed in an OpenMP target region.
+*
+* @section LICENSE
+*
+* The Variable Infiltration Capacity (VIC) macroscale hydrological model
+* Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+* and Environmental Engineering, University of Washington.
+*
+* The VIC model is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+******************************************************************************/
+
+#include <vic_run.h>
+
+#ifdef VIC_OFFLOAD
+#pragma omp declare target
+#endif
+
+/******************************************************************************
+* @brief    Calculate the saturated area and runoff of cell i, see
+*           compute_runoff_and_asat().
+******************************************************************************/
+static void
+compute_runoff_and_asat_flat(runoff_flat_struct *rf,
+                             size_t              i,
+                             double             *moist,
+                             double              inflow,
+                             double             *A,
+                             double             *runoff)
+{
+    double b_infilt = rf->b_infilt[i];
+    double top_moist;
+    double top_max_moist;
+    size_t lindex;
+    double ex;
+    double max_infil;
+    double i_0;
+    double basis;
+
+    top_moist = 0.;
+    top_max_moist = 0.;
+    for (lindex = 0; lindex < rf->nlayers - 1; lindex++) {
+        top_moist += moist[lindex];
+        top_max_moist += rf->max_moist[lindex * rf->ncells + i];
+    }
+    if (top_moist > top_max_moist) {
+        top_moist = top_max_moist;
+    }
+
+    ex = b_infilt / (1.0 + b_infilt);
+    *A = 1.0 - pow((1.0 - top_moist / top_max_moist), ex);
+
+    max_infil = (1.0 + b_infilt) * top_max_moist;
+    i_0 = max_infil * (1.0 - pow((1.0 - *A), (1.0 / b_infilt)));
+
+    if (inflow == 0.0) {
+        *runoff = 0.0;
+    }
+    else if (max_infil == 0.0) {
+        *runoff = inflow;
+    }
+    else if ((i_0 + inflow) > max_infil) {
+        *runoff = inflow - top_max_moist + top_moist;
+    }
+    else {
+        basis = 1.0 - (i_0 + inflow) / max_infil;
+        *runoff = (inflow - top_max_moist + top_moist +
+                   top_max_moist *
+                   pow(basis, 1.0 * (1.0 + b_infilt)));
+    }
+    if (*runoff < 0.) {
+        *runoff = 0.;
+    }
+}
+
+/******************************************************************************
+* @brief    Runoff of cell i, see runoff(). The cell has a single frost area
+*           without ice.
+******************************************************************************/
+static void
+runoff_flat_cell(runoff_flat_struct *rf,
+                 size_t              i,
+                 unsigned short      runoff_steps_per_dt,
+                 double              runoff_steps_per_day)
+{
+    size_t         nlayers = rf->nlayers;
+    size_t         lindex;
+    size_t         idx;
+    size_t         time_step;
+    int            tmplayer;
+    double         A, frac;
+    double         tmp_runoff;
+    double         inflow;
+    double         avail_liq;
+    double         resid_moist[MAX_LAYERS];
+    double         evap[MAX_LAYERS];
+    vic_real       liq[MAX_LAYERS];
+    vic_real       max_moist[MAX_LAYERS];
+    vic_real       moist_range[MAX_LAYERS];
+    vic_real       Ksat[MAX_LAYERS];
+    vic_real       Q12[MAX_LAYERS - 1];
+    double         Dsmax;
+    vic_real       tmp_inflow;
+    vic_real       tmp_moist;
+    double         tmp_moist_for_runoff[MAX_LAYERS];
+    vic_real       tmp_liq;
+    vic_real       dt_inflow;
+    vic_real       dt_runoff;
+    double         runoff;
+    double         tmp_dt_runoff;
+    double         baseflow;
+    vic_real       dt_baseflow;
+    vic_real       Ds_frac;
+    vic_real       Ds_nonlin;
+    vic_real       Ws_range;
+    vic_real       rel_moist;
+    double         Ws = rf->Ws[i];
+
+    for (lindex = 0; lindex < nlayers; lindex++) {
+        idx = lindex * rf->ncells + i;
+        resid_moist[lindex] = rf->resid_moist[idx];
+        liq[lindex] = rf->moist[idx];
+
+        evap[lindex] = rf->evap[idx] / (double) runoff_steps_per_dt;
+        if (evap[lindex] > 0) {
+            avail_liq = rf->moist[idx] - resid_moist[lindex];
+            if (avail_liq < 0) {
+                avail_liq = 0;
+            }
+            if (avail_liq > 0) {
+                evap[lindex] = avail_liq * (evap[lindex] / avail_liq);
+            }
+            else {
+                evap[lindex] = avail_liq;
+            }
+        }
+
+        Ksat[lindex] = rf->Ksat[idx] / runoff_steps_per_day;
+        max_moist[lindex] = rf->max_moist[idx];
+        moist_range[lindex] = rf->max_moist[idx] - resid_moist[lindex];
+    }
+    Dsmax = rf->Dsmax[i] / runoff_steps_per_day;
+    Ds_frac = Dsmax * rf->Ds[i] / Ws;
+    Ds_nonlin = Dsmax * (1 - rf->Ds[i] / Ws);
+    Ws_range = 1 - Ws;
+    baseflow = 0;
+
+    inflow = rf->ppt[i];
+
+    for (lindex = 0; lindex < nlayers; lindex++) {
+        tmp_moist_for_runoff[lindex] = liq[lindex];
+    }
+    compute_runoff_and_asat_flat(rf, i, tmp_moist_for_runoff, inflow, &A,
+                                 &runoff);
+    tmp_dt_runoff = runoff / (double) runoff_steps_per_dt;
+
+    dt_inflow = inflow / (double) runoff_steps_per_dt;
+
+    for (time_step = 0; time_step < runoff_steps_per_dt; time_step++) {
+        inflow = dt_inflow;
+
+        /** Brooks & Corey drainage between the layers **/
+        for (lindex = 0; lindex < nlayers - 1; lindex++) {
+            if ((tmp_liq = liq[lindex] - evap[lindex]) < resid_moist[lindex]) {
+                tmp_liq = resid_moist[lindex];
+            }
+            if (liq[lindex] > resid_moist[lindex] &&
+                tmp_liq > resid_moist[lindex]) {
+                Q12[lindex] = Ksat[lindex] *
+                              pow(((tmp_liq - resid_moist[lindex]) /
+                                   moist_range[lindex]),
+                                  rf->expt[lindex * rf->ncells + i]);
+            }
+            else {
+                Q12[lindex] = 0.;
+            }
+        }
+
+        /** Layer moisture within its minimum and maximum **/
+        for (lindex = 0; lindex < nlayers - 1; lindex++) {
+            if (lindex == 0) {
+                dt_runoff = tmp_dt_runoff;
+            }
+            else {
+                dt_runoff = 0;
+            }
+
+            tmp_inflow = 0.;
+
+            liq[lindex] = liq[lindex] + (inflow - dt_runoff) -
+                          (Q12[lindex] + evap[lindex]);
+
+            if (liq[lindex] > max_moist[lindex]) {
+                tmp_inflow = liq[lindex] - max_moist[lindex];
+                liq[lindex] = max_moist[lindex];
+
+                if (lindex == 0) {
+                    Q12[lindex] += tmp_inflow;
+                    tmp_inflow = 0;
+                }
+                else {
+                    tmplayer = lindex;
+                    while (tmp_inflow > 0) {
+                        tmplayer--;
+                        if (tmplayer < 0) {
+                            runoff += tmp_inflow;
+                            tmp_inflow = 0;
+                        }
+                        else {
+                            liq[tmplayer] += tmp_inflow;
+                            if (liq[tmplayer] > max_moist[tmplayer]) {
+                                tmp_inflow = liq[tmplayer] -
+                                             max_moist[tmplayer];
+                                liq[tmplayer] = max_moist[tmplayer];
+                            }
+                            else {
+                                tmp_inflow = 0;
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (liq[lindex] < 0) {
+                Q12[lindex] += liq[lindex];
+                liq[lindex] = 0;
+            }
+            if (liq[lindex] < resid_moist[lindex]) {
+                Q12[lindex] += liq[lindex] - resid_moist[lindex];
+                liq[lindex] = resid_moist[lindex];
+            }
+
+            inflow = (Q12[lindex] + tmp_inflow);
+            Q12[lindex] += tmp_inflow;
+        }
+
+        /** ARNO baseflow of the bottom layer **/
+        lindex = nlayers - 1;
+
+        rel_moist = (liq[lindex] - resid_moist[lindex]) / moist_range[lindex];
+
+        dt_baseflow = Ds_frac * rel_moist;
+        if (rel_moist > Ws) {
+            frac = (rel_moist - Ws) / Ws_range;
+            dt_baseflow += Ds_nonlin * pow(frac, rf->c[i]);
+        }
+        if (dt_baseflow < 0) {
+            dt_baseflow = 0;
+        }
+
+        liq[lindex] += Q12[lindex - 1] - (evap[lindex] + dt_baseflow);
+
+        tmp_moist = 0;
+        if (liq[lindex] < resid_moist[lindex]) {
+            dt_baseflow += liq[lindex] - resid_moist[lindex];
+            liq[lindex] = resid_moist[lindex];
+        }
+
+        if (liq[lindex] > max_moist[lindex]) {
+            tmp_moist = liq[lindex] - max_moist[lindex];
+            liq[lindex] = max_moist[lindex];
+            tmplayer = lindex;
+            while (tmp_moist > 0) {
+                tmplayer--;
+                if (tmplayer < 0) {
+                    runoff += tmp_moist;
+                    tmp_moist = 0;
+                }
+                else {
+                    liq[tmplayer] += tmp_moist;
+                    if (liq[tmplayer] > max_moist[tmplayer]) {
+                        tmp_moist = liq[tmplayer] - max_moist[tmplayer];
+                        liq[tmplayer] = max_moist[tmplayer];
+                    }
+                    else {
+                        tmp_moist = 0;
+                    }
+                }
+            }
+        }
+
+        baseflow += dt_baseflow;
+    }
+
+    /** If negative baseflow, reduce evap accordingly **/
+    if (baseflow < 0) {
+        rf->evap[(nlayers - 1) * rf->ncells + i] += baseflow;
+        baseflow = 0;
+    }
+
+    /** Recompute Asat based on final moisture level of upper layers **/
+    for (lindex = 0; lindex < nlayers; lindex++) {
+        tmp_moist_for_runoff[lindex] = liq[lindex];
+    }
+    compute_runoff_and_asat_flat(rf, i, tmp_moist_for_runoff, 0, &A,
+                                 &tmp_runoff);
+
+    for (lindex = 0; lindex < nlayers; lindex++) {
+        rf->moist[lindex * rf->ncells + i] = liq[lindex];
+    }
+    rf->asat[i] = A;
+    rf->runoff[i] = runoff;
+    rf->baseflow[i] = baseflow;
+}
+
+#ifdef VIC_OFFLOAD
+#pragma omp end declare target
+#endif
+
+/******************************************************************************
+* @brief    Runoff of all cells of rf for one time step, see runoff(). The
+*           cells have a single frost area without ice, and the water table
+*           and the thermal node moisture are not computed.
+* @details  Built with VIC_OFFLOAD, the cells are computed on the default
+*           device. The parameters and the soil moisture stay on the device
+*           between calls after runoff_flat_enter(); only ppt and evap are
+*           copied in, and evap and the cell outputs are copied out.
+******************************************************************************/
+void
+runoff_flat(runoff_flat_struct *rf,
+            unsigned short      runoff_steps_per_dt,
+            double              runoff_steps_per_day)
+{
+    size_t ncells = rf->ncells;
+    size_t nlayers = rf->nlayers;
+    size_t nvalues = ncells * nlayers;
+    double *b_infilt = rf->b_infilt;
+    double *Ds = rf->Ds;
+    double *Dsmax = rf->Dsmax;
+    double *Ws = rf->Ws;
+    double *c = rf->c;
+    double *expt = rf->expt;
+    double *Ksat = rf->Ksat;
+    double *max_moist = rf->max_moist;
+    double *resid_moist = rf->resid_moist;
+    double *moist = rf->moist;
+    double *ppt = rf->ppt;
+    double *evap = rf->evap;
+    double *runoff = rf->runoff;
+    double *baseflow = rf->baseflow;
+    double *asat = rf->asat;
+    size_t i;
+
+#ifdef VIC_OFFLOAD
+    #pragma omp target teams distribute parallel for \
+    map(to: b_infilt[0:ncells], Ds[0:ncells], Dsmax[0:ncells], \
+    Ws[0:ncells], c[0:ncells], expt[0:nvalues], Ksat[0:nvalues], \
+    max_moist[0:nvalues], resid_moist[0:nvalues]) \
+    map(tofrom: moist[0:nvalues]) \
+    map(always, to: ppt[0:ncells]) \
+    map(always, tofrom: evap[0:nvalues]) \
+    map(always, from: runoff[0:ncells], baseflow[0:ncells], asat[0:ncells])
+#else
+    (void) nvalues;
+#endif
+    for (i = 0; i < ncells; i++) {
+        runoff_flat_struct cells = {
+            ncells, nlayers, b_infilt, Ds, Dsmax, Ws, c, expt, Ksat,
+            max_moist, resid_moist, moist, ppt, evap, runoff, baseflow, asat
+        };
+        runoff_flat_cell(&cells, i, runoff_steps_per_dt,
+                         runoff_steps_per_day);
+    }
+}
+
+/******************************************************************************
+* @brief    Copy the parameters and the soil moisture of rf to the device.
+*           They stay there until runoff_flat_exit(). Without VIC_OFFLOAD,
+*           this does nothing.
+******************************************************************************/
+void
+runoff_flat_enter(runoff_flat_struct *rf)
+{
+#ifdef VIC_OFFLOAD
+    size_t ncells = rf->ncells;
+    size_t nvalues = rf->ncells * rf->nlayers;
+
+    #pragma omp target enter data \
+    map(to: rf->b_infilt[0:ncells], rf->Ds[0:ncells], rf->Dsmax[0:ncells], \
+    rf->Ws[0:ncells], rf->c[0:ncells], rf->expt[0:nvalues], \
+    rf->Ksat[0:nvalues], rf->max_moist[0:nvalues], \
+    rf->resid_moist[0:nvalues], rf->moist[0:nvalues])
+#else
+    (void) rf;
+#endif
+}
+
+/******************************************************************************
+* @brief    Copy the soil moisture of rf back from the device and release the
+*           parameters copied by runoff_flat_enter(). Without VIC_OFFLOAD,
+*           this does nothing.
+******************************************************************************/
+void
+runoff_flat_exit(runoff_flat_struct *rf)
+{
+#ifdef VIC_OFFLOAD
+    size_t ncells = rf->ncells;
+    size_t nvalues = rf->ncells * rf->nlayers;
+
+    #pragma omp target exit data \
+    map(release: rf->b_infilt[0:ncells], rf->Ds[0:ncells], \
+    rf->Dsmax[0:ncells], rf->Ws[0:ncells], rf->c[0:ncells], \
+    rf->expt[0:nvalues], rf->Ksat[0:nvalues], rf->max_moist[0:nvalues], \
+    rf->resid_moist[0:nvalues]) \
+    map(from: rf->moist[0:nvalues])
+#else
+    (void) rf;
+#endif
+}
@@ -72,6 +72,7 @@ snow_intercept(double             Dt,
                int                month,
                int                hidx,
                unsigned short     veg_class,
+               veg_lib_struct    *veg_lib,
                double            *CanopLayerBnd,
                double            *dryFrac,
                force_data_struct *force,
@@ -117,6 +118,8 @@ snow_intercept(double             Dt,
     double                   Tlower;
     double                   Evap;
     double                   OldTfoliage;
+    canopy_energy_bal_args_struct canopy_args; /* arguments of the canopy
+                                                  energy balance */
 
     double                   AirDens;
     double                   EactAir;
@@ -130,7 +133,7 @@ snow_intercept(double             Dt,
     Press = force->pressure[hidx];
     Vpd = force->vpd[hidx];
     shortwave = force->shortwave[hidx];
-    if (options.CARBON) {
+    if (OPT_CARBON) {
         Catm = force->Catm[hidx];
     }
     else {
@@ -290,6 +293,52 @@ snow_intercept(double             Dt,
        temperature.  The outgoing longwave is subtracted twice, because the
        canopy radiates in two directions */
 
+    // arguments of the canopy energy balance, the intercepted rain is the
+    // one at the start of the step
+    canopy_args.delta_t = Dt;
+    canopy_args.elevation = soil_con->elevation;
+    canopy_args.Wmax = soil_con->max_moist;
+    canopy_args.Wcr = soil_con->Wcr;
+    canopy_args.Wpwp = soil_con->Wpwp;
+    canopy_args.frost_fract = soil_con->frost_fract;
+    canopy_args.AirDens = AirDens;
+    canopy_args.EactAir = EactAir;
+    canopy_args.Press = Press;
+    canopy_args.Le = Le;
+    canopy_args.Tcanopy = Tcanopy;
+    canopy_args.Vpd = Vpd;
+    canopy_args.shortwave = shortwave;
+    canopy_args.Catm = Catm;
+    canopy_args.dryFrac = dryFrac;
+    canopy_args.Evap = &Evap;
+    canopy_args.Ra = Ra;
+    canopy_args.Ra_used = Ra_used;
+    canopy_args.Rainfall = *RainFall;
+    canopy_args.Wind = Wind;
+    canopy_args.veg_class = veg_class;
+    canopy_args.veg_lib = veg_lib;
+    canopy_args.displacement = displacement;
+    canopy_args.ref_height = ref_height;
+    canopy_args.roughness = roughness;
+    canopy_args.root = root;
+    canopy_args.CanopLayerBnd = CanopLayerBnd;
+    canopy_args.IntRain = IntRainOrg;
+    canopy_args.IntSnow = *IntSnow;
+    canopy_args.Wdew = IntRain;
+    canopy_args.layer = layer;
+    canopy_args.veg_var = veg_var;
+    canopy_args.LongOverIn = LongOverIn;
+    canopy_args.LongUnderOut = LongUnderOut;
+    canopy_args.AdvectedEnergy = AdvectedEnergy;
+    canopy_args.LatentHeat = LatentHeat;
+    canopy_args.LatentHeatSub = LatentHeatSub;
+    canopy_args.LongOverOut = LongOverOut;
+    canopy_args.NetLongOver = NetLongOver;
+    canopy_args.NetRadiation = &NetRadiation;
+    canopy_args.RefreezeEnergy = &RefreezeEnergy;
+    canopy_args.SensibleHeat = SensibleHeat;
+    canopy_args.VaporMassFlux = VaporMassFlux;
+
     Tupper = Tlower = MISSING;
 
     if (*IntSnow > 0 || *SnowFall > 0) {
@@ -297,21 +346,10 @@ snow_intercept(double             Dt,
 
         *AlbedoOver = param.SNOW_NEW_SNOW_ALB; // albedo of intercepted snow in canopy
         *NetShortOver = (1. - *AlbedoOver) * ShortOverIn; // net SW in canopy
+        canopy_args.NetShortOver = *NetShortOver;
+        set_canopy_energy_bal_terms(&canopy_args);
 
-        Qnet = solve_canopy_energy_bal(0., Dt, soil_con->elevation,
-                                       soil_con->max_moist, soil_con->Wcr,
-                                       soil_con->Wpwp, soil_con->frost_fract,
-                                       AirDens, EactAir, Press, Le, Tcanopy,
-                                       Vpd, shortwave, Catm, dryFrac, &Evap,
-                                       Ra, Ra_used, *RainFall, Wind, veg_class,
-                                       displacement, ref_height, roughness,
-                                       root, CanopLayerBnd, IntRainOrg,
-                                       *IntSnow, IntRain, layer, veg_var,
-                                       LongOverIn, LongUnderOut, *NetShortOver,
-                                       AdvectedEnergy, LatentHeat,
-                                       LatentHeatSub, LongOverOut, NetLongOver,
-                                       &NetRadiation, &RefreezeEnergy,
-                                       SensibleHeat, VaporMassFlux);
+        Qnet = func_canopy_energy_bal_ctx(0., &canopy_args);
 
         if (Qnet != 0) {
             /* Intercepted snow not melting - need to find temperature */
@@ -331,31 +369,25 @@ snow_intercept(double             Dt,
         /* No snow in canopy */
         *AlbedoOver = bare_albedo;
         *NetShortOver = (1. - *AlbedoOver) * ShortOverIn; // net SW in canopy
+        canopy_args.NetShortOver = *NetShortOver;
+        set_canopy_energy_bal_terms(&canopy_args);
         Qnet = -9999;
         Tupper = (*Tfoliage) + param.SNOW_DT;
         Tlower = (*Tfoliage) - param.SNOW_DT;
     }
 
     if (Tupper != MISSING && Tlower != MISSING) {
-        *Tfoliage = root_brent(Tlower, Tupper,
-                               func_canopy_energy_bal, Dt,
-                               soil_con->elevation, soil_con->max_moist,
-                               soil_con->Wcr, soil_con->Wpwp,
-                               soil_con->frost_fract,
-                               AirDens, EactAir, Press, Le,
-                               Tcanopy, Vpd, shortwave, Catm, dryFrac,
-                               &Evap, Ra, Ra_used, *RainFall, Wind,
-                               veg_class, displacement, ref_height,
-                               roughness, root, CanopLayerBnd, IntRainOrg,
-                               *IntSnow,
-                               IntRain, layer, veg_var,
-                               LongOverIn, LongUnderOut,
-                               *NetShortOver,
-                               AdvectedEnergy,
-                               LatentHeat, LatentHeatSub,
-                               LongOverOut, NetLongOver, &NetRadiation,
-                               &RefreezeEnergy, SensibleHeat,
-                               VaporMassFlux);
+        if (options.TSURF_NEWTON) {
+            // warm start from the foliage temperature of the previous step
+            *Tfoliage = root_newton_ctx(*Tfoliage, Tlower, Tupper,
+                                        func_canopy_energy_bal_ctx,
+                                        &canopy_args);
+        }
+        else {
+            *Tfoliage = root_brent_ctx(Tlower, Tupper,
+                                       func_canopy_energy_bal_ctx,
+                                       &canopy_args);
+        }
 
         if (*Tfoliage <= -998) {
             if (options.TFALLBACK) {
@@ -377,8 +409,8 @@ snow_intercept(double             Dt,
                                                     &Evap, Ra, Ra_used,
                                                     *RainFall, Wind, UnderStory,
                                                     iveg,
-                                                    veg_class, displacement,
-                                                    ref_height,
+                                                    veg_class, veg_lib,
+                                                    displacement, ref_height,
                                                     roughness, root,
                                                     CanopLayerBnd, IntRainOrg,
                                                     *IntSnow,
@@ -396,20 +428,7 @@ snow_intercept(double             Dt,
             }
         }
 
-        Qnet = solve_canopy_energy_bal(*Tfoliage, Dt, soil_con->elevation,
-                                       soil_con->max_moist, soil_con->Wcr,
-                                       soil_con->Wpwp, soil_con->frost_fract,
-                                       AirDens, EactAir, Press, Le, Tcanopy,
-                                       Vpd, shortwave, Catm, dryFrac, &Evap,
-                                       Ra, Ra_used, *RainFall, Wind, veg_class,
-                                       displacement, ref_height, roughness,
-                                       root, CanopLayerBnd, IntRainOrg,
-                                       *IntSnow, IntRain, layer, veg_var,
-                                       LongOverIn, LongUnderOut, *NetShortOver,
-                                       AdvectedEnergy, LatentHeat,
-                                       LatentHeatSub, LongOverOut, NetLongOver,
-                                       &NetRadiation, &RefreezeEnergy,
-                                       SensibleHeat, VaporMassFlux);
+        Qnet = func_canopy_energy_bal_ctx(*Tfoliage, &canopy_args);
     }
 
     if (*IntSnow <= 0) {
@@ -586,8 +605,15 @@ double
 error_calc_canopy_energy_bal(double Tfoliage,
                              ...)
 {
-    va_list ap;
-    double  Qnet;
+    va_list       ap;
+    double        Qnet;
+    static size_t dump_count = 0;
+
+    // the variable values are only dumped for the first LOG_WARN_REPEAT
+    // failures, later failures return at once
+    if (!count_log_repeat(&dump_count, __FILE__, __LINE__)) {
+        return(ERROR);
+    }
 
     va_start(ap, Tfoliage);
     Qnet = error_print_canopy_energy_bal(Tfoliage, ap);
@@ -709,6 +735,7 @@ error_print_canopy_energy_bal(double  Tfoliage,
     UnderStory = (int) va_arg(ap, int);
     iveg = (int) va_arg(ap, int);
     veg_class = (unsigned int) va_arg(ap, unsigned int);
+    va_arg(ap, veg_lib_struct *); // veg library is not printed
 
     displacement = (double *) va_arg(ap, double *);
     ref_height = (double *) va_arg(ap, double *);
@@ -790,7 +817,7 @@ error_print_canopy_energy_bal(double  Tfoliage,
 
     fprintf(LOG_DEST, "root = %f\n", *root);
 
-    if (options.CARBON) {
+    if (OPT_CARBON) {
         fprintf(LOG_DEST, "CanopLayerBnd =");
         for (cidx = 0; cidx < options.Ncanopy; cidx++) {
             fprintf(LOG_DEST, " %f", CanopLayerBnd[cidx]);
@@ -99,6 +99,10 @@ snow_melt(double            Le,
     double                   sensible_heat;
     double                   advected_sensible_heat;
     double                   melt_energy = 0.;
+    stability_coef_struct    stab; /* stability correction terms of the snow
+                                      surface */
+    snow_pack_energy_bal_args_struct snow_args; /* arguments of the snow pack
+                                                   energy balance */
 
     SnowFall = snowfall / MM_PER_M; /* convet to m */
     RainFall = rainfall / MM_PER_M; /* convet to m */
@@ -167,23 +171,50 @@ snow_melt(double            Le,
     Ice += SnowFall;
     snow->surf_water += RainFall;
 
+    /* The stability correction terms do not depend on the snow surface
+       temperature */
+    set_stability_coef(z2, 0., Z0[2], &stab);
+
+    /* The arguments of the snow pack energy balance are the same for every
+       evaluation */
+    snow_args.Dt = delta_t;
+    snow_args.Ra = aero_resist;
+    snow_args.Ra_used = aero_resist_used;
+    snow_args.stab = &stab;
+    snow_args.AirDens = density;
+    snow_args.EactAir = vp;
+    snow_args.LongSnowIn = LongSnowIn;
+    snow_args.Lv = Le;
+    snow_args.Press = pressure;
+    snow_args.Rain = RainFall;
+    snow_args.NetShortUnder = NetShortSnow;
+    snow_args.Vpd = vpd;
+    snow_args.Wind = wind;
+    snow_args.OldTSurf = (*OldTSurf);
+    snow_args.SnowCoverFract = coverage;
+    snow_args.SnowDepth = snow->depth;
+    snow_args.SnowDensity = snow->density;
+    snow_args.SurfaceLiquidWater = snow->surf_water;
+    snow_args.SweSurfaceLayer = SurfaceSwq;
+    snow_args.Tair = Tcanopy;
+    snow_args.TGrnd = Tgrnd;
+    snow_args.AdvectedEnergy = &advection;
+    snow_args.AdvectedSensibleHeat = &advected_sensible_heat;
+    snow_args.DeltaColdContent = &deltaCC;
+    snow_args.GroundFlux = &grnd_flux;
+    snow_args.LatentHeat = &latent_heat;
+    snow_args.LatentHeatSub = &latent_heat_sub;
+    snow_args.NetLongUnder = NetLongSnow;
+    snow_args.RefreezeEnergy = &RefreezeEnergy;
+    snow_args.SensibleHeat = &sensible_heat;
+    snow_args.vapor_flux = &snow->vapor_flux;
+    snow_args.blowing_flux = &snow->blowing_flux;
+    snow_args.surface_flux = &snow->surface_flux;
+    set_snow_pack_energy_bal_terms(&snow_args);
+
     /* Calculate the surface energy balance for snow_temp = 0.0 */
 
-    Qnet = CalcSnowPackEnergyBalance((double) 0.0, delta_t, aero_resist,
-                                     aero_resist_used, z2, Z0,
-                                     density, vp, LongSnowIn, Le, pressure,
-                                     RainFall, NetShortSnow, vpd,
-                                     wind, (*OldTSurf), coverage,
-                                     snow->depth, snow->density,
-                                     snow->surf_water, SurfaceSwq,
-                                     Tcanopy, Tgrnd,
-                                     &advection, &advected_sensible_heat,
-                                     &deltaCC,
-                                     &grnd_flux, &latent_heat,
-                                     &latent_heat_sub, NetLongSnow,
-                                     &RefreezeEnergy, &sensible_heat,
-                                     &snow->vapor_flux, &snow->blowing_flux,
-                                     &snow->surface_flux);
+    Qnet = SnowPackEnergyBalance_ctx(0.0, &snow_args);
 
     /* Check that snow swq exceeds minimum value for model stability */
     if (!UNSTABLE_SNOW) {
@@ -264,24 +295,25 @@ snow_melt(double            Le,
         else {
             /* Calculate surface layer temperature using "Brent method" */
             if (SurfaceSwq > param.SNOW_MIN_SWQ_EB_THRES) {
-                snow->surf_temp = root_brent(
-                    (double) (snow->surf_temp - param.SNOW_DT),
-                    (double) (snow->surf_temp + param.SNOW_DT),
-                    SnowPackEnergyBalance,
-                    delta_t, aero_resist, aero_resist_used, z2, Z0,
-                    density, vp, LongSnowIn, Le, pressure,
-                    RainFall, NetShortSnow, vpd,
-                    wind, (*OldTSurf), coverage,
-                    snow->depth, snow->density,
-                    snow->surf_water, SurfaceSwq,
-                    Tcanopy, Tgrnd,
-                    &advection, &advected_sensible_heat,
-                    &deltaCC,
-                    &grnd_flux, &latent_heat,
-                    &latent_heat_sub, NetLongSnow,
-                    &RefreezeEnergy, &sensible_heat,
-                    &snow->vapor_flux, &snow->blowing_flux,
-                    &snow->surface_flux);
+                if (options.TSURF_NEWTON) {
+                    // warm start from the surface temperature of the
+                    // previous step
+                    snow->surf_temp = root_newton_ctx(
+                        snow->surf_temp,
+                        snow->surf_temp - param.SNOW_DT,
+                        snow->surf_temp + param.SNOW_DT,
+                        SnowPackEnergyBalance_ctx, &snow_args);
+                }
+                else {
+                    snow->surf_temp = root_brent_ctx(
+                        snow->surf_temp - param.SNOW_DT,
+                        snow->surf_temp + param.SNOW_DT,
+                        SnowPackEnergyBalance_ctx, &snow_args);
+                }
+                if (snow->surf_temp <= -998 && options.ROOT_RETRY) {
+                    snow->surf_temp = root_brent_retry_ctx(
+                        *OldTSurf, SnowPackEnergyBalance_ctx, &snow_args);
+                }
 
                 if (snow->surf_temp <= -998) {
                     if (options.TFALLBACK) {
@@ -294,7 +326,7 @@ snow_melt(double            Le,
                                                            iveg, band,
                                                            delta_t, aero_resist,
                                                            aero_resist_used,
-                                                           z2, Z0, density, vp,
+                                                           &stab, density, vp,
                                                            LongSnowIn, Le,
                                                            pressure,
                                                            RainFall,
@@ -324,26 +356,8 @@ snow_melt(double            Le,
                 snow->surf_temp = 999;
             }
             if (snow->surf_temp > -998 && snow->surf_temp < 999) {
-                Qnet = CalcSnowPackEnergyBalance(snow->surf_temp,
-                                                 delta_t, aero_resist,
-                                                 aero_resist_used, z2, Z0,
-                                                 density, vp, LongSnowIn, Le,
-                                                 pressure,
-                                                 RainFall, NetShortSnow, vpd,
-                                                 wind, (*OldTSurf), coverage,
-                                                 snow->depth, snow->density,
-                                                 snow->surf_water, SurfaceSwq,
-                                                 Tcanopy, Tgrnd,
-                                                 &advection,
-                                                 &advected_sensible_heat,
-                                                 &deltaCC,
-                                                 &grnd_flux, &latent_heat,
-                                                 &latent_heat_sub,
-                                                 NetLongSnow, &RefreezeEnergy,
-                                                 &sensible_heat,
-                                                 &snow->vapor_flux,
-                                                 &snow->blowing_flux,
-                                                 &snow->surface_flux);
+                Qnet = SnowPackEnergyBalance_ctx(snow->surf_temp,
+                                                 &snow_args);
 
                 /* since we iterated, the surface layer is below freezing and no snowmelt */
 
@@ -538,9 +552,16 @@ int
 ErrorSnowPackEnergyBalance(double Tsurf,
                            ...)
 {
-    va_list ap;                 /* Used in traversing variable argument list
-                                 */
-    int     error;             /* error from ErrorPrintSnowPackEnergyBalance */
+    va_list       ap;                 /* Used in traversing variable argument list
+                                       */
+    int           error;             /* error from ErrorPrintSnowPackEnergyBalance */
+    static size_t dump_count = 0;
+
+    // the variable values are only dumped for the first LOG_WARN_REPEAT
+    // failures, later failures return at once
+    if (!count_log_repeat(&dump_count, __FILE__, __LINE__)) {
+        return(ERROR);
+    }
 
     va_start(ap, Tsurf);
     error = ErrorPrintSnowPackEnergyBalance(Tsurf, ap);
@@ -563,9 +584,10 @@ ErrorPrintSnowPackEnergyBalance(double  TSurf,
     double Dt;                    /* Model time step (sec) */
 
     /* Vegetation Parameters */
-    double Ra;                    /* Aerodynamic resistance (s/m) */
-    double Z;                     /* Reference height (m) */
-    double Z0;                    /* surface roughness height (m) */
+    double                 Ra;      /* Aerodynamic resistance (s/m) */
+    double                *Ra_used; /* Aerodynamic resistance (s/m) after
+                                       stability correction */
+    stability_coef_struct *stab;    /* stability correction terms */
 
     /* Atmospheric Forcing Variables */
     double AirDens;               /* Density of air (kg/m3) */
@@ -624,8 +646,8 @@ ErrorPrintSnowPackEnergyBalance(double  TSurf,
 
     /* Vegetation Parameters */
     Ra = (double) va_arg(ap, double);
-    Z = (double) va_arg(ap, double);
-    Z0 = (double) va_arg(ap, double);
+    Ra_used = (double *) va_arg(ap, double *);
+    stab = (stability_coef_struct *) va_arg(ap, stability_coef_struct *);
 
     /* Atmospheric Forcing Variables */
     AirDens = (double) va_arg(ap, double);
@@ -675,8 +697,9 @@ ErrorPrintSnowPackEnergyBalance(double  TSurf,
 
     /* land surface parameters */
     fprintf(LOG_DEST, "Ra = %f\n", Ra);
-    fprintf(LOG_DEST, "Z = %f\n", Z);
-    fprintf(LOG_DEST, "Z0 = %f\n", Z0);
+    fprintf(LOG_DEST, "Ra_used = %f\n", Ra_used[0]);
+    fprintf(LOG_DEST, "Z - d = %f\n", stab->Z_d);
+    fprintf(LOG_DEST, "log((Z - d) / Z0) + 5 = %f\n", stab->log_Z_d_Z0);
 
     /* meteorological terms */
     fprintf(LOG_DEST, "AirDens = %f\n", AirDens);
@@ -48,39 +48,30 @@ soil_carbon_balance(soil_con_struct   *soil_con,
 
     size_t                     i;
     size_t                     Nnodes;
-    double                    *dZ = NULL;
-    double                    *dZCum = NULL;
+    double                     dZ[MAX_NODES];
+    double                     dZCum[MAX_NODES];
     double                     dZTot;
-    double                    *T = NULL;
-    double                    *w = NULL;
+    double                     T[MAX_NODES];
+    double                     w[MAX_NODES];
     double                     tmp_double;
-    double                     b;
+    double                     b_inv;
     double                     wtd;
     double                     w0;
     double                     w1;
 
     // Find subset of thermal nodes that span soil hydrologic layers
     dZTot = 0;
-    for (i = 0; i < options.Nlayer; i++) {
+    for (i = 0; i < OPT_Nlayer; i++) {
         dZTot += soil_con->depth[i];
     }
     i = 0;
-    while (i < options.Nnode - 1 && soil_con->Zsum_node[i] < dZTot) {
+    while (i < OPT_Nnode - 1 && soil_con->Zsum_node[i] < dZTot) {
         i++;
     }
     Nnodes = i;
     if (soil_con->Zsum_node[i] > dZTot) {
         Nnodes--;
     }
-    dZ = calloc(Nnodes, sizeof(*dZ));
-    check_alloc_status(dZ, "Memory allocation error");
-    dZCum = calloc(Nnodes, sizeof(*dZCum));
-    check_alloc_status(dZCum, "Memory allocation error");
-    T = calloc(Nnodes, sizeof(*T));
-    check_alloc_status(T, "Memory allocation error");
-    w = calloc(Nnodes, sizeof(*w));
-    check_alloc_status(w, "Memory allocation error");
-
     // Assign node thicknesses and temperatures for subset
     dZTot = 0;
     for (i = 0; i < Nnodes; i++) {
@@ -91,34 +82,35 @@ soil_carbon_balance(soil_con_struct   *soil_con,
     }
 
     // Compute node relative moistures based on lumped water table depth
+    wtd = -(cell->zwt_lumped) * 10; // mm, positive downwards
     for (i = 0; i < Nnodes; i++) {
-        b = 0.5 * (soil_con->expt_node[i] - 3);
-        wtd = -(cell->zwt_lumped) * 10; // mm, positive downwards
+        // exponent -1/b of the Campbell retention curve
+        b_inv = -1 / (0.5 * (soil_con->expt_node[i] - 3));
         if (wtd > dZCum[i]) {
             if (i > 0) {
                 w0 = pow(
                     (wtd + soil_con->bubble_node[i] -
-                     dZCum[i - 1]) / soil_con->bubble_node[i], -1 / b);
+                     dZCum[i - 1]) / soil_con->bubble_node[i], b_inv);
             }
             else {
                 w0 = pow(
                     (wtd + soil_con->bubble_node[i]) / soil_con->bubble_node[i],
-                    -1 / b);
+                    b_inv);
             }
             w1 = pow(
                 (wtd + soil_con->bubble_node[i] -
-                 dZCum[i]) / soil_con->bubble_node[i], -1 / b);
+                 dZCum[i]) / soil_con->bubble_node[i], b_inv);
             w[i] = 0.5 * (w0 + w1);
         }
         else if ((i == 0 && wtd > 0) || (i > 0 && wtd > dZCum[i - 1])) {
             if (i > 0) {
                 w0 = pow(
                     (wtd + soil_con->bubble_node[i] -
-                     dZCum[i - 1]) / soil_con->bubble_node[i], -1 / b);
+                     dZCum[i - 1]) / soil_con->bubble_node[i], b_inv);
                 tmp_double = 0.5 * (dZCum[i - 1] + wtd);
                 w1 = pow(
                     (wtd + soil_con->bubble_node[i] -
-                     tmp_double) / soil_con->bubble_node[i], -1 / b);
+                     tmp_double) / soil_con->bubble_node[i], b_inv);
                 w[i] =
                     (0.5 *
                      (w0 +
@@ -135,11 +127,11 @@ soil_carbon_balance(soil_con_struct   *soil_con,
             else {
                 w0 = pow(
                     (wtd + soil_con->bubble_node[i]) / soil_con->bubble_node[i],
-                    -1 / b);
+                    b_inv);
                 tmp_double = 0.5 * (0 + wtd);
                 w1 = pow(
                     (wtd + soil_con->bubble_node[i] -
-                     tmp_double) / soil_con->bubble_node[i], -1 / b);
+                     tmp_double) / soil_con->bubble_node[i], b_inv);
                 w[i] =
                     (0.5 *
                      (w0 +
@@ -177,11 +169,4 @@ soil_carbon_balance(soil_con_struct   *soil_con,
     cell->CSlow +=
         (1 -
          param.SRESP_FAIR) * cell->RhLitter *
-        (1 - param.SRESP_FINTER) - cell->RhSlow;
-
-    // Free temporary dynamic arrays
-    free((char *) dZ);
-    free((char *) dZCum);
-    free((char *) T);
-    free((char *) w);
-}
+        (1 - param.SRESP_FINTER) - cell->RhSlow;}
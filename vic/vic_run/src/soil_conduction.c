@@ -27,81 +27,125 @@
 #include <vic_run.h>
 
 /******************************************************************************
-* @brief    Soil thermal conductivity calculated using Johansen's method.
+* @brief    Compute the terms of the thermal conductivity and the volumetric
+*           heat capacity of a soil layer that do not depend on its water and
+*           ice contents.
 *
 * @note     Reference: Farouki, O.T., "Thermal Properties of Soils" 1986
 *               Chapter 7: Methods for Calculating the Thermal Conductivity
 *               of Soils
 ******************************************************************************/
-double
-soil_conductivity(double moist,
-                  double Wu,
-                  double soil_dens_min,
-                  double bulk_dens_min,
-                  double quartz,
-                  double soil_density,
-                  double bulk_density,
-                  double organic)
+void
+set_soil_thermal_coef(double                    soil_dens_min,
+                      double                    bulk_dens_min,
+                      double                    quartz,
+                      double                    soil_density,
+                      double                    bulk_density,
+                      double                    organic,
+                      soil_thermal_coef_struct *coef)
 {
-    double Ke;
-    double Ki = 2.2;    /* thermal conductivity of ice (W/mK) */
     double Kw = 0.57;   /* thermal conductivity of water (W/mK) */
-    double Ksat;
-    double Kdry;        /* Dry thermal conductivity of soil (W/mK), including mineral and organic fractions */
     double Kdry_org = 0.05; /* Dry thermal conductivity of organic fraction (W/mK) (Farouki 1981) */
     double Kdry_min;    /* Dry thermal conductivity of mineral fraction (W/mK) */
     double Ks;          /* thermal conductivity of solid (W/mK), including mineral and organic fractions */
     double Ks_org = 0.25; /* thermal conductivity of organic fraction of solid (W/mK) (Farouki 1981) */
     double Ks_min;      /* thermal conductivity of mineral fraction of solid (W/mK) */
-    double Sr;          /* fractional degree of saturation */
-    double K;
     double porosity;
 
     /* Calculate dry conductivity as weighted average of mineral and organic fractions. */
     Kdry_min =
         (0.135 * bulk_dens_min +
          64.7) / (soil_dens_min - 0.947 * bulk_dens_min);
-    Kdry = (1 - organic) * Kdry_min + organic * Kdry_org;
+    coef->Kdry = (1 - organic) * Kdry_min + organic * Kdry_org;
 
-    if (moist > 0.) {
-        porosity = 1.0 - bulk_density / soil_density; // NOTE: if excess_ice present,
-                                                      // this is actually effective_porosity
+    porosity = 1.0 - bulk_density / soil_density; // NOTE: if excess_ice present,
+                                                  // this is actually effective_porosity
+    coef->porosity = porosity;
 
-        Sr = moist / porosity;
+    // Compute Ks of mineral soil; here "quartz" is the fraction (quartz volume / mineral soil volume)
+    if (quartz < .2) {
+        Ks_min = pow(7.7, quartz) * pow(3.0, 1.0 - quartz); // when quartz is less than 0.2
+    }
+    else {
+        Ks_min = pow(7.7, quartz) * pow(2.2, 1.0 - quartz); // when quartz is greater than 0.2
+    }
+    Ks = (1 - organic) * Ks_min + organic * Ks_org;
+    coef->Ks_pow = pow(Ks, 1.0 - porosity);
+    coef->Ksat_thaw = coef->Ks_pow * pow(Kw, porosity);
 
-        // Compute Ks of mineral soil; here "quartz" is the fraction (quartz volume / mineral soil volume)
-        if (quartz < .2) {
-            Ks_min = pow(7.7, quartz) * pow(3.0, 1.0 - quartz); // when quartz is less than 0.2
-        }
-        else {
-            Ks_min = pow(7.7, quartz) * pow(2.2, 1.0 - quartz); // when quartz is greater than 0.2
-        }
-        Ks = (1 - organic) * Ks_min + organic * Ks_org;
+    // Constant values are volumetric heat capacities in J/m^3/K
+    coef->soil_fract = bulk_density / soil_density;
+    coef->Cs_solid = 2.0e6 * coef->soil_fract * (1 - organic);
+    coef->Cs_solid += 2.7e6 * coef->soil_fract * organic;
+}
+
+/******************************************************************************
+* @brief    Soil thermal conductivity calculated using Johansen's method, from
+*           the moisture-independent terms of set_soil_thermal_coef.
+******************************************************************************/
+double
+soil_conductivity_coef(double                    moist,
+                       double                    Wu,
+                       soil_thermal_coef_struct *coef)
+{
+    double Ke;
+    double Ki = 2.2;    /* thermal conductivity of ice (W/mK) */
+    double Kw = 0.57;   /* thermal conductivity of water (W/mK) */
+    double Ksat;
+    double Sr;          /* fractional degree of saturation */
+    double K;
+
+    if (moist > 0.) {
+        Sr = moist / coef->porosity;
 
         if (Wu == moist) {
             /** Soil unfrozen **/
-            Ksat = pow(Ks, 1.0 - porosity) * pow(Kw, porosity);
+            Ksat = coef->Ksat_thaw;
             Ke = 0.7 * log10(Sr) + 1.0;
         }
         else {
             /** Soil frozen **/
-            Ksat =
-                pow(Ks, 1.0 - porosity) * pow(Ki, porosity - Wu) * pow(Kw, Wu);
+            Ksat = coef->Ks_pow * pow(Ki, coef->porosity - Wu) * pow(Kw, Wu);
             Ke = Sr;
         }
 
-        K = (Ksat - Kdry) * Ke + Kdry;
-        if (K < Kdry) {
-            K = Kdry;
+        K = (Ksat - coef->Kdry) * Ke + coef->Kdry;
+        if (K < coef->Kdry) {
+            K = coef->Kdry;
         }
     }
     else {
-        K = Kdry;
+        K = coef->Kdry;
     }
 
     return (K);
 }
 
+/******************************************************************************
+* @brief    Soil thermal conductivity calculated using Johansen's method.
+*
+* @note     Reference: Farouki, O.T., "Thermal Properties of Soils" 1986
+*               Chapter 7: Methods for Calculating the Thermal Conductivity
+*               of Soils
+******************************************************************************/
+double
+soil_conductivity(double moist,
+                  double Wu,
+                  double soil_dens_min,
+                  double bulk_dens_min,
+                  double quartz,
+                  double soil_density,
+                  double bulk_density,
+                  double organic)
+{
+    soil_thermal_coef_struct coef;
+
+    set_soil_thermal_coef(soil_dens_min, bulk_dens_min, quartz, soil_density,
+                          bulk_density, organic, &coef);
+
+    return soil_conductivity_coef(moist, Wu, &coef);
+}
+
 /******************************************************************************
 * @brief    This subroutine calculates the soil volumetric heat capacity
             based on the fractional volume of its component parts.
@@ -124,6 +168,26 @@ volumetric_heat_capacity(double soil_fract,
     return (Cs);
 }
 
+/******************************************************************************
+* @brief    This subroutine calculates the soil volumetric heat capacity
+            from the heat capacity of the solids of set_soil_thermal_coef.
+******************************************************************************/
+double
+volumetric_heat_capacity_coef(double                    water_fract,
+                              double                    ice_fract,
+                              soil_thermal_coef_struct *coef)
+{
+    double Cs;
+
+    // Constant values are volumetric heat capacities in J/m^3/K
+    Cs = coef->Cs_solid;
+    Cs += 4.2e6 * water_fract;
+    Cs += 1.9e6 * ice_fract;
+    Cs += 1.3e3 * (1. - (coef->soil_fract + water_fract + ice_fract)); // air
+
+    return (Cs);
+}
+
 /******************************************************************************
 * @brief    This subroutine sets the thermal node soil parameters to constant
 *           values based on those defined for the current grid cells soil type.
@@ -207,26 +271,21 @@ set_node_parameters(double *Zsum_node,
 *           moisture contents.
 ******************************************************************************/
 int
-distribute_node_moisture_properties(double *moist_node,
-                                    double *ice_node,
-                                    double *kappa_node,
-                                    double *Cs_node,
-                                    double *Zsum_node,
-                                    double *T_node,
-                                    double *max_moist_node,
-                                    double *expt_node,
-                                    double *bubble_node,
-                                    double *moist,
-                                    double *depth,
-                                    double *soil_dens_min,
-                                    double *bulk_dens_min,
-                                    double *quartz,
-                                    double *soil_density,
-                                    double *bulk_density,
-                                    double *organic,
-                                    int     Nnodes,
-                                    int     Nlayers,
-                                    char    FS_ACTIVE)
+distribute_node_moisture_properties(double                   *moist_node,
+                                    double                   *ice_node,
+                                    double                   *kappa_node,
+                                    double                   *Cs_node,
+                                    double                   *Zsum_node,
+                                    double                   *T_node,
+                                    double                   *max_moist_node,
+                                    double                   *expt_node,
+                                    double                   *bubble_node,
+                                    double                   *moist,
+                                    double                   *depth,
+                                    soil_thermal_coef_struct *thermal_coef,
+                                    int                       Nnodes,
+                                    int                       Nlayers,
+                                    char                      FS_ACTIVE)
 {
     extern option_struct     options;
     extern parameters_struct param;
@@ -266,7 +325,7 @@ distribute_node_moisture_properties(double *moist_node,
             // HACK!!!!!!!!!!!
             moist_node[nidx] = max_moist_node[nidx];
         }
-        if (T_node[nidx] < 0 && (FS_ACTIVE && options.FROZEN_SOIL)) {
+        if (T_node[nidx] < 0 && (FS_ACTIVE && OPT_FROZEN_SOIL)) {
             /* compute moisture and ice contents */
             ice_node[nidx] =
                 moist_node[nidx] - maximum_unfrozen_water(T_node[nidx],
@@ -279,29 +338,21 @@ distribute_node_moisture_properties(double *moist_node,
 
             /* compute thermal conductivity */
             kappa_node[nidx] =
-                soil_conductivity(moist_node[nidx], moist_node[nidx] -
-                                  ice_node[nidx],
-                                  soil_dens_min[lidx], bulk_dens_min[lidx],
-                                  quartz[lidx],
-                                  soil_density[lidx], bulk_density[lidx],
-                                  organic[lidx]);
+                soil_conductivity_coef(moist_node[nidx], moist_node[nidx] -
+                                       ice_node[nidx], &(thermal_coef[lidx]));
         }
         else {
             /* compute moisture and ice contents */
             ice_node[nidx] = 0;
             /* compute thermal conductivity */
             kappa_node[nidx] =
-                soil_conductivity(moist_node[nidx], moist_node[nidx],
-                                  soil_dens_min[lidx], bulk_dens_min[lidx],
-                                  quartz[lidx],
-                                  soil_density[lidx], bulk_density[lidx],
-                                  organic[lidx]);
+                soil_conductivity_coef(moist_node[nidx], moist_node[nidx],
+                                       &(thermal_coef[lidx]));
         }
         /* compute volumetric heat capacity */
-        Cs_node[nidx] = volumetric_heat_capacity(
-            bulk_density[lidx] / soil_density[lidx],
-            moist_node[nidx] -
-            ice_node[nidx], ice_node[nidx], organic[lidx]);
+        Cs_node[nidx] = volumetric_heat_capacity_coef(
+            moist_node[nidx] - ice_node[nidx], ice_node[nidx],
+            &(thermal_coef[lidx]));
 
         if (Zsum_node[nidx] > Lsum + depth[lidx] && !PAST_BOTTOM) {
             Lsum += depth[lidx];
@@ -356,9 +407,9 @@ estimate_frost_temperature_and_depth(double ***tmpT,
             max_nidx++;
         }
         if (max_nidx >= Nnodes) {
-            log_warn("Soil thermal nodes do not extend below bottom "
-                     "soil layer; using deepest node temperature for "
-                     "all deeper depths.");
+            log_warn_repeat("Soil thermal nodes do not extend below bottom "
+                            "soil layer; using deepest node temperature for "
+                            "all deeper depths.");
             // If we get here, soil thermal nodes don't extend all the way
             // down to the bottom of the lowest layer.  In this case, just
             // use the deepest node to represent all deeper temperatures.
@@ -462,9 +513,9 @@ estimate_layer_temperature(layer_data_struct *layer,
             max_nidx++;
         }
         if (max_nidx >= Nnodes) {
-            log_warn("Soil thermal nodes do not extend below bottom "
-                     "soil layer; using deepest node temperature for "
-                     "all deeper depths.");
+            log_warn_repeat("Soil thermal nodes do not extend below bottom "
+                            "soil layer; using deepest node temperature for "
+                            "all deeper depths.");
             // If we get here, soil thermal nodes don't extend all the way
             // down to the bottom of the lowest layer.  In this case, just
             // use the deepest node to represent all deeper temperatures.
@@ -505,6 +556,7 @@ estimate_layer_ice_content(layer_data_struct *layer,
 
     size_t               nidx, min_nidx;
     size_t               lidx, frost_area, max_nidx;
+    size_t               nfrost;
     double               Lsum[MAX_LAYERS + 1];
     double               tmp_ice[MAX_NODES][MAX_FROST_AREAS];
 
@@ -531,20 +583,31 @@ estimate_layer_ice_content(layer_data_struct *layer,
             max_nidx++;
         }
         if (max_nidx >= Nnodes) {
-            log_warn("Soil thermal nodes do not extend below bottom "
-                     "soil layer; using deepest node temperature for "
-                     "all deeper depths.");
+            log_warn_repeat("Soil thermal nodes do not extend below bottom "
+                            "soil layer; using deepest node temperature for "
+                            "all deeper depths.");
             // If we get here, soil thermal nodes don't extend all the way
             // down to the bottom of the lowest layer.  In this case, just
             // use the deepest node to represent all deeper temperatures.
             max_nidx = Nnodes - 1;
         }
 
+        // Above freezing all frost sub-areas hold the same ice content, so
+        // the coldest one is computed and copied to the others
+        nfrost = 1;
+        if (OPT_FROZEN_SOIL && FS_ACTIVE) {
+            for (nidx = min_nidx; nidx <= max_nidx; nidx++) {
+                if (tmpT[lidx][nidx][0] < 0.) {
+                    nfrost = options.Nfrost;
+                    break;
+                }
+            }
+        }
+
         // Get soil node ice content for current layer
-        if (options.FROZEN_SOIL && FS_ACTIVE) {
+        if (OPT_FROZEN_SOIL && FS_ACTIVE) {
             for (nidx = min_nidx; nidx <= max_nidx; nidx++) {
-                for (frost_area = 0; frost_area < options.Nfrost;
-                     frost_area++) {
+                for (frost_area = 0; frost_area < nfrost; frost_area++) {
                     tmp_ice[nidx][frost_area] = layer[lidx].moist -
                                                 maximum_unfrozen_water(
                         tmpT[lidx][nidx][frost_area], max_moist[lidx],
@@ -558,25 +621,25 @@ estimate_layer_ice_content(layer_data_struct *layer,
         }
         else {
             for (nidx = min_nidx; nidx <= max_nidx; nidx++) {
-                for (frost_area = 0; frost_area < options.Nfrost;
-                     frost_area++) {
-                    tmp_ice[nidx][frost_area] = 0;
-                }
+                tmp_ice[nidx][0] = 0;
             }
         }
 
         // Compute average soil layer ice content
         for (nidx = min_nidx; nidx < max_nidx; nidx++) {
-            for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
+            for (frost_area = 0; frost_area < nfrost; frost_area++) {
                 layer[lidx].ice[frost_area] +=
                     (tmpZ[lidx][nidx + 1] - tmpZ[lidx][nidx]) *
                     (tmp_ice[nidx + 1][frost_area] +
                      tmp_ice[nidx][frost_area]) / 2.;
             }
         }
-        for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
+        for (frost_area = 0; frost_area < nfrost; frost_area++) {
             layer[lidx].ice[frost_area] /= depth[lidx];
         }
+        for (frost_area = nfrost; frost_area < options.Nfrost; frost_area++) {
+            layer[lidx].ice[frost_area] = layer[lidx].ice[0];
+        }
     }
 
     return (0);
@@ -609,13 +672,13 @@ estimate_layer_temperature_quick_flux(layer_data_struct *layer,
 
     // compute cumulative layer depths
     Lsum[0] = 0;
-    for (lidx = 1; lidx <= options.Nlayer; lidx++) {
+    for (lidx = 1; lidx <= OPT_Nlayer; lidx++) {
         Lsum[lidx] = depth[lidx - 1] + Lsum[lidx - 1];
     }
 
     // estimate soil layer average temperatures
     layer[0].T = 0.5 * (Tsurf + T1); // linear profile in topmost layer
-    for (lidx = 1; lidx < options.Nlayer; lidx++) {
+    for (lidx = 1; lidx < OPT_Nlayer; lidx++) {
         layer[lidx].T = Tp - Dp / (depth[lidx]) *
                         (T1 -
                          Tp) *
@@ -654,17 +717,17 @@ estimate_layer_ice_content_quick_flux(layer_data_struct *layer,
 
     // compute cumulative layer depths
     Lsum[0] = 0;
-    for (lidx = 1; lidx <= options.Nlayer; lidx++) {
+    for (lidx = 1; lidx <= OPT_Nlayer; lidx++) {
         Lsum[lidx] = depth[lidx - 1] + Lsum[lidx - 1];
     }
 
     // estimate soil layer ice contents
-    for (lidx = 0; lidx < options.Nlayer; lidx++) {
+    for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
         for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
             layer[lidx].ice[frost_area] = 0;
         }
 
-        if (options.FROZEN_SOIL && FS_ACTIVE) {
+        if (OPT_FROZEN_SOIL && FS_ACTIVE) {
             min_temp = layer[lidx].T - frost_slope / 2.;
             max_temp = min_temp + frost_slope;
             for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
@@ -701,16 +764,11 @@ estimate_layer_ice_content_quick_flux(layer_data_struct *layer,
 *           activated.
 ******************************************************************************/
 void
-compute_soil_layer_thermal_properties(layer_data_struct *layer,
-                                      double            *depth,
-                                      double            *bulk_dens_min,
-                                      double            *soil_dens_min,
-                                      double            *quartz,
-                                      double            *bulk_density,
-                                      double            *soil_density,
-                                      double            *organic,
-                                      double            *frost_fract,
-                                      size_t             Nlayers)
+compute_soil_layer_thermal_properties(layer_data_struct        *layer,
+                                      double                   *depth,
+                                      soil_thermal_coef_struct *thermal_coef,
+                                      double                   *frost_fract,
+                                      size_t                    Nlayers)
 {
     extern option_struct options;
     size_t               lidx;
@@ -725,15 +783,10 @@ compute_soil_layer_thermal_properties(layer_data_struct *layer,
             ice += layer[lidx].ice[frost_area] / depth[lidx] / MM_PER_M *
                    frost_fract[frost_area];
         }
-        layer[lidx].kappa =
-            soil_conductivity(moist, moist - ice,
-                              soil_dens_min[lidx], bulk_dens_min[lidx],
-                              quartz[lidx],
-                              soil_density[lidx], bulk_density[lidx],
-                              organic[lidx]);
-        layer[lidx].Cs =
-            volumetric_heat_capacity(bulk_density[lidx] / soil_density[lidx],
-                                     moist - ice, ice, organic[lidx]);
+        layer[lidx].kappa = soil_conductivity_coef(moist, moist - ice,
+                                                   &(thermal_coef[lidx]));
+        layer[lidx].Cs = volumetric_heat_capacity_coef(moist - ice, ice,
+                                                       &(thermal_coef[lidx]));
     }
 }
 
@@ -28,6 +28,52 @@
 
 #include <vic_run.h>
 
+/******************************************************************************
+* @brief        Set the snow terms of a tile without snow on the ground or in
+*               the canopy, and without snowfall.
+******************************************************************************/
+void
+solve_snow_free(double             BareAlbedo,
+                double             Tcanopy,
+                double             air_temp,
+                double            *AlbedoUnder,
+                double            *NetLongSnow,
+                double            *NetShortGrnd,
+                double            *NetShortSnow,
+                double            *delta_coverage,
+                int               *UnderStory,
+                energy_bal_struct *energy,
+                snow_data_struct  *snow)
+{
+    extern parameters_struct param;
+
+    /** Initialize variables **/
+    *UnderStory = 0;
+    snow->snow = false;
+    energy->Tfoliage = air_temp;
+
+    /** Compute Radiation Balance for Bare Surface **/
+    energy->AlbedoOver = 0.;
+    (*AlbedoUnder) = BareAlbedo;
+    energy->NetLongOver = 0.;
+    energy->LongOverIn = 0.;
+    energy->NetShortOver = 0.;
+    energy->ShortOverIn = 0.;
+    energy->latent = 0.;
+    energy->latent_sub = 0.;
+    energy->sensible = 0.;
+    (*NetLongSnow) = 0.;
+    (*NetShortSnow) = 0.;
+    (*NetShortGrnd) = 0.;
+    (*delta_coverage) = 0.;
+    energy->Tfoliage = Tcanopy;
+    snow->store_swq = 0;
+    snow->store_coverage = 1;
+    snow->MELTING = false;
+    snow->last_snow = 0;
+    snow->albedo = param.SNOW_NEW_SNOW_ALB;
+}
+
 /******************************************************************************
 * @brief        This routine was written to handle the various calls and data
 *               handling needed to solve the various components of the new VIC
@@ -79,6 +125,7 @@ solve_snow(char               overstory,
            double             dt,
            size_t             hidx,
            int                veg_class,
+           veg_lib_struct    *veg_lib,
            int               *UnderStory,
            double            *CanopLayerBnd,
            double            *dryFrac,
@@ -132,6 +179,26 @@ solve_snow(char               overstory,
     /* initialize change in snowpack heat storage */
     (*delta_snow_heat) = 0.;
 
+    /** Fast path: no snow on the ground or in the canopy, and all of the
+        precipitation falls as rain **/
+    if (snow->swq <= 0. && (snow->snow_canopy <= 0. || !overstory) &&
+        (prec <= 0. || air_temp >= MAX_SNOW_TEMP)) {
+        *snowfall = 0.;
+        *rainfall = gauge_correction[RAIN] * prec;
+        (*out_prec) = *rainfall;
+        (*out_rain) = *rainfall;
+        (*out_snow) = 0.;
+        (*Le) = calc_latent_heat_of_vaporization(air_temp);
+        (*ShortUnderIn) = shortwave;
+        (*LongUnderIn) = longwave;
+        solve_snow_free(BareAlbedo, Tcanopy, air_temp, AlbedoUnder,
+                        NetLongSnow, NetShortGrnd, NetShortSnow,
+                        delta_coverage, UnderStory, energy, snow);
+        energy->melt_energy *= -1.;
+
+        return(melt);
+    }
+
     /** Calculate Fraction of Precipitation that falls as Rain **/
     rainonly = calc_rainonly(air_temp, prec, MAX_SNOW_TEMP,
                              MIN_RAIN_TEMP);
@@ -216,7 +283,7 @@ solve_snow(char               overstory,
                                            ref_height, roughness, root,
                                            *UnderStory, band,
                                            iveg, month, hidx,
-                                           veg_class,
+                                           veg_class, veg_lib,
                                            CanopLayerBnd, dryFrac, force,
                                            layer, soil_con, veg_var);
                 if (ErrorFlag == ERROR) {
@@ -327,6 +394,7 @@ solve_snow(char               overstory,
             (*NetShortSnow) = (1.0 - *AlbedoUnder) * (*ShortUnderIn);
 
             /** Call snow pack accumulation and ablation algorithm **/
+            solver_stats[SOLVER_SNOW_MELT]++;
             ErrorFlag = snow_melt((*Le), (*NetShortSnow), Tcanopy, Tgrnd,
                                   roughness, aero_resist[*UnderStory],
                                   aero_resist_used,
@@ -507,31 +575,9 @@ solve_snow(char               overstory,
            No Snow Present or Falling
         *****************************/
 
-        /** Initialize variables **/
-        *UnderStory = 0;
-        snow->snow = false;
-        energy->Tfoliage = air_temp;
-
-        /** Compute Radiation Balance for Bare Surface **/
-        energy->AlbedoOver = 0.;
-        (*AlbedoUnder) = BareAlbedo;
-        energy->NetLongOver = 0.;
-        energy->LongOverIn = 0.;
-        energy->NetShortOver = 0.;
-        energy->ShortOverIn = 0.;
-        energy->latent = 0.;
-        energy->latent_sub = 0.;
-        energy->sensible = 0.;
-        (*NetLongSnow) = 0.;
-        (*NetShortSnow) = 0.;
-        (*NetShortGrnd) = 0.;
-        (*delta_coverage) = 0.;
-        energy->Tfoliage = Tcanopy;
-        snow->store_swq = 0;
-        snow->store_coverage = 1;
-        snow->MELTING = false;
-        snow->last_snow = 0;
-        snow->albedo = param.SNOW_NEW_SNOW_ALB;
+        solve_snow_free(BareAlbedo, Tcanopy, air_temp, AlbedoUnder,
+                        NetLongSnow, NetShortGrnd, NetShortSnow,
+                        delta_coverage, UnderStory, energy, snow);
     }
 
     energy->melt_energy *= -1.;
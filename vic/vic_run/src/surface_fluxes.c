@@ -28,6 +28,107 @@
 
 #include <vic_run.h>
 
+/******************************************************************************
+* @brief    Quantities that are summed or averaged over the snow steps of a
+*           surface_fluxes() call
+******************************************************************************/
+typedef struct {
+    // energy structure
+    double  AlbedoOver;
+    double  AlbedoUnder;
+    double  AtmosLatent;
+    double  AtmosLatentSub;
+    double  AtmosSensible;
+    double  LongOverIn;
+    double  LongUnderIn;
+    double  LongUnderOut;
+    double  NetLongAtmos;
+    double  NetLongOver;
+    double  NetLongUnder;
+    double  NetShortAtmos;
+    double  NetShortGrnd;
+    double  NetShortOver;
+    double  NetShortUnder;
+    double  ShortOverIn;
+    double  ShortUnderIn;
+    double  advected_sensible;
+    double  advection;
+    double  canopy_advection;
+    double  canopy_latent;
+    double  canopy_latent_sub;
+    double  canopy_sensible;
+    double  canopy_refreeze;
+    double  deltaCC;
+    double  deltaH;
+    double  fusion;
+    double  grnd_flux;
+    double  latent;
+    double  latent_sub;
+    double  melt_energy;
+    double  refreeze_energy;
+    double  sensible;
+    double  snow_flux;
+    // snow structure
+    double  canopy_vapor_flux;
+    double  melt;
+    double  vapor_flux;
+    double  blowing_flux;
+    double  surface_flux;
+    // veg_var structure
+    double  canopyevap;
+    double  throughfall;
+    // cell structure
+    double  layerevap[MAX_LAYERS];
+    double  ppt;
+    double  aero_cond_used[2];
+    double  pot_evap;
+    // carbon cycling
+    double  gc;
+    double *gsLayer;
+    double  Ci;
+    double  GPP;
+    double  Rdark;
+    double  Rphoto;
+    double  Rmaint;
+    double  Rgrowth;
+    double  Raut;
+    double  NPP;
+} surface_fluxes_store_struct;
+
+/******************************************************************************
+* @brief    Values of a snow step, or of an iteration of a snow step, in
+*           surface_fluxes()
+******************************************************************************/
+typedef struct {
+    energy_bal_struct snow_energy;    // energy fluxes at snowpack surface
+    energy_bal_struct soil_energy;    // energy fluxes at soil surface
+    veg_var_struct    snow_veg_var;    // veg fluxes/storages in presence of snow
+    veg_var_struct    soil_veg_var;    // veg fluxes/storages in soil energy balance
+    snow_data_struct  snow;
+    layer_data_struct layer[MAX_LAYERS];
+} surface_fluxes_state_struct;
+
+/******************************************************************************
+* @brief    Point the step or iteration variables of surface_fluxes() to one
+*           of its two sets of values.
+******************************************************************************/
+static void
+set_surface_fluxes_state(surface_fluxes_state_struct *state,
+                         energy_bal_struct          **snow_energy,
+                         energy_bal_struct          **soil_energy,
+                         veg_var_struct             **snow_veg_var,
+                         veg_var_struct             **soil_veg_var,
+                         snow_data_struct           **snow,
+                         layer_data_struct          **layer)
+{
+    (*snow_energy) = &(state->snow_energy);
+    (*soil_energy) = &(state->soil_energy);
+    (*snow_veg_var) = &(state->snow_veg_var);
+    (*soil_veg_var) = &(state->soil_veg_var);
+    (*snow) = &(state->snow);
+    (*layer) = state->layer;
+}
+
 /******************************************************************************
 * @brief        This routine computes all surface fluxes
 ******************************************************************************/
@@ -56,6 +157,7 @@ surface_fluxes(bool                 overstory,
                double               dp,
                unsigned short       iveg,
                unsigned short       veg_class,
+               veg_lib_struct      *veg_lib,
                force_data_struct   *force,
                dmy_struct          *dmy,
                energy_bal_struct   *energy,
@@ -69,7 +171,6 @@ surface_fluxes(bool                 overstory,
                double               fetch,
                double              *CanopLayerBnd)
 {
-    extern veg_lib_struct   *vic_run_veg_lib;
     extern option_struct     options;
     extern parameters_struct param;
 
@@ -79,6 +180,8 @@ surface_fluxes(bool                 overstory,
     int                      UNSTABLE_CNT;
     int                      UNSTABLE_SNOW = false;
     int                      N_steps;
+    bool                     single_step;
+    unsigned int             fine_last_snow;
     int                      UnderStory;
     size_t                   hidx; // index of initial element of atmos array
     size_t                   step_inc; // number of atmos array elements to skip per surface fluxes step
@@ -132,71 +235,29 @@ surface_fluxes(bool                 overstory,
     double                   step_prec;
 
     // Quantities that need to be summed or averaged over multiple snow steps
-    // energy structure
-    double            store_AlbedoOver;
-    double            store_AlbedoUnder;
-    double            store_AtmosLatent;
-    double            store_AtmosLatentSub;
-    double            store_AtmosSensible;
-    double            store_LongOverIn;
-    double            store_LongUnderIn;
-    double            store_LongUnderOut;
-    double            store_NetLongAtmos;
-    double            store_NetLongOver;
-    double            store_NetLongUnder;
-    double            store_NetShortAtmos;
-    double            store_NetShortGrnd;
-    double            store_NetShortOver;
-    double            store_NetShortUnder;
-    double            store_ShortOverIn;
-    double            store_ShortUnderIn;
-    double            store_advected_sensible;
-    double            store_advection;
-    double            store_canopy_advection;
-    double            store_canopy_latent;
-    double            store_canopy_latent_sub;
-    double            store_canopy_sensible;
-    double            store_canopy_refreeze;
-    double            store_deltaCC;
-    double            store_deltaH;
-    double            store_fusion;
-    double            store_grnd_flux;
-    double            store_latent;
-    double            store_latent_sub;
-    double            store_melt_energy;
-    double            store_refreeze_energy;
-    double            store_sensible;
-    double            store_snow_flux;
-    // snow structure
-    double            store_canopy_vapor_flux;
-    double            store_melt;
-    double            store_vapor_flux;
-    double            store_blowing_flux;
-    double            store_surface_flux;
-    // veg_var structure
-    double            store_canopyevap;
-    double            store_throughfall;
-    // cell structure
-    double            store_layerevap[MAX_LAYERS];
-    double            store_ppt;
-    double            store_aero_cond_used[2];
-    double            store_pot_evap;
+    surface_fluxes_store_struct store;
+
+    // Structures holding values for the current snow step and the current
+    // iteration. The two sets are swapped at the end of each snow step
+    // instead of copying the iteration results back.
+    surface_fluxes_state_struct state[2];
 
     // Structures holding values for current snow step
-    energy_bal_struct snow_energy;    // energy fluxes at snowpack surface
-    energy_bal_struct soil_energy;    // energy fluxes at soil surface
-    veg_var_struct    snow_veg_var;    // veg fluxes/storages in presence of snow
-    veg_var_struct    soil_veg_var;    // veg fluxes/storages in soil energy balance
-    snow_data_struct  step_snow;
-    layer_data_struct step_layer[MAX_LAYERS];
+    energy_bal_struct *snow_energy;    // energy fluxes at snowpack surface
+    energy_bal_struct *soil_energy;    // energy fluxes at soil surface
+    veg_var_struct    *snow_veg_var;    // veg fluxes/storages in presence of snow
+    veg_var_struct    *soil_veg_var;    // veg fluxes/storages in soil energy balance
+    snow_data_struct  *step_snow;
+    layer_data_struct *step_layer;
 
     // Structures holding values for current iteration
-    energy_bal_struct iter_snow_energy;    // energy fluxes at snowpack surface
-    energy_bal_struct iter_soil_energy;    // energy fluxes at soil surface
-    veg_var_struct    iter_snow_veg_var;    // veg fluxes/storages in presence of snow
-    veg_var_struct    iter_soil_veg_var;    // veg fluxes/storages in soil energy balance
-    snow_data_struct  iter_snow;
-    layer_data_struct iter_layer[MAX_LAYERS];
+    energy_bal_struct *iter_snow_energy;    // energy fluxes at snowpack surface
+    energy_bal_struct *iter_soil_energy;    // energy fluxes at soil surface
+    veg_var_struct    *iter_snow_veg_var;    // veg fluxes/storages in presence of snow
+    veg_var_struct    *iter_soil_veg_var;    // veg fluxes/storages in soil energy balance
+    snow_data_struct  *iter_snow;
+    layer_data_struct *iter_layer;
+    size_t             step_state;
     double            iter_aero_resist[3];
     double            iter_aero_resist_veg[3];
     double            iter_aero_resist_used[2];
@@ -211,19 +272,11 @@ surface_fluxes(bool                 overstory,
 
     // Carbon cycling
     double            dryFrac;
+    double           *workspace = NULL;
+    scratch_mark_struct scratch_start;
     double           *LAIlayer = NULL;
     double           *faPAR = NULL;
     size_t            cidx;
-    double            store_gc;
-    double           *store_gsLayer = NULL;
-    double            store_Ci;
-    double            store_GPP;
-    double            store_Rdark;
-    double            store_Rphoto;
-    double            store_Rmaint;
-    double            store_Rgrowth;
-    double            store_Raut;
-    double            store_NPP;
 
     if (options.CLOSE_ENERGY) {
         MAX_ITER_GRND_CANOPY = 10;
@@ -232,10 +285,23 @@ surface_fluxes(bool                 overstory,
         MAX_ITER_GRND_CANOPY = 0;
     }
 
-    if (options.CARBON) {
-        store_gsLayer = calloc(options.Ncanopy, sizeof(*store_gsLayer));
-        check_alloc_status(store_gsLayer, "Memory allocation error.");
+    // the sums of the stomatal conductances and the LAI and absorbed PAR
+    // of the canopy layers share one allocation for all snow steps
+    memset(&store, 0, sizeof(store));
+    scratch_start = scratch_mark();
+    if (OPT_CARBON) {
+        workspace = scratch_calloc(3 * options.Ncanopy, sizeof(*workspace));
+        store.gsLayer = workspace;
+        LAIlayer = workspace + options.Ncanopy;
+        faPAR = workspace + 2 * options.Ncanopy;
     }
+    step_state = 0;
+    set_surface_fluxes_state(&(state[step_state]), &snow_energy, &soil_energy,
+                             &snow_veg_var, &soil_veg_var, &step_snow,
+                             &step_layer);
+    set_surface_fluxes_state(&(state[1 - step_state]), &iter_snow_energy,
+                             &iter_soil_energy, &iter_snow_veg_var,
+                             &iter_soil_veg_var, &iter_snow, &iter_layer);
 
     /***********************************************************************
        Set temporary variables for convenience
@@ -259,22 +325,22 @@ surface_fluxes(bool                 overstory,
     }
     energy->refreeze_energy = 0;
     coverage = snow->coverage;
-    snow_energy = (*energy);
-    soil_energy = (*energy);
-    iter_soil_energy = (*energy);
-    snow_veg_var = (*veg_var);
-    soil_veg_var = (*veg_var);
-    step_snow = (*snow);
+    (*snow_energy) = (*energy);
+    (*soil_energy) = (*energy);
+    (*iter_soil_energy) = (*energy);
+    (*snow_veg_var) = (*veg_var);
+    (*soil_veg_var) = (*veg_var);
+    (*step_snow) = (*snow);
     for (lidx = 0; lidx < Nlayers; lidx++) {
         step_layer[lidx] = layer[lidx];
     }
     for (lidx = 0; lidx < Nlayers; lidx++) {
         step_layer[lidx].evap = 0;
     }
-    soil_veg_var.canopyevap = 0;
-    snow_veg_var.canopyevap = 0;
-    soil_veg_var.throughfall = 0;
-    snow_veg_var.throughfall = 0;
+    soil_veg_var->canopyevap = 0;
+    snow_veg_var->canopyevap = 0;
+    soil_veg_var->throughfall = 0;
+    snow_veg_var->throughfall = 0;
 
     /********************************
        Set-up sub-time step controls
@@ -282,7 +348,18 @@ surface_fluxes(bool                 overstory,
        if frozen soils are present)
     ********************************/
 
-    if (snow->swq > 0 || snow->snow_canopy > 0 || force->snowflag[NR]) {
+    single_step = false;
+    if (options.ADAPTIVE_SUBSTEPS &&
+        snow_single_step(snow, force, soil_con->Tfactor[band])) {
+        // a cold, dry snow pack is run in one step with the forcings of the
+        // whole time step
+        single_step = true;
+        hidx = NR;
+        step_inc = 1;
+        endhidx = hidx + step_inc;
+        step_dt = gp->dt;
+    }
+    else if (snow->swq > 0 || snow->snow_canopy > 0 || force->snowflag[NR]) {
         hidx = 0;
         step_inc = 1;
         endhidx = hidx + NF;
@@ -299,77 +376,15 @@ surface_fluxes(bool                 overstory,
        Initialize sub-model time step variables
     *******************************************/
 
-    // energy structure
-    store_AlbedoOver = 0;
-    store_AlbedoUnder = 0;
-    store_AtmosLatent = 0;
-    store_AtmosLatentSub = 0;
-    store_AtmosSensible = 0;
-    store_LongOverIn = 0;
-    store_LongUnderIn = 0;
-    store_LongUnderOut = 0;
-    store_NetLongAtmos = 0;
-    store_NetLongOver = 0;
-    store_NetLongUnder = 0;
-    store_NetShortAtmos = 0;
-    store_NetShortGrnd = 0;
-    store_NetShortOver = 0;
-    store_NetShortUnder = 0;
-    store_ShortOverIn = 0;
-    store_ShortUnderIn = 0;
-    store_advected_sensible = 0;
-    store_advection = 0;
-    store_canopy_advection = 0;
-    store_canopy_latent = 0;
-    store_canopy_latent_sub = 0;
-    store_canopy_sensible = 0;
-    store_canopy_refreeze = 0;
-    store_deltaCC = 0;
-    store_deltaH = 0;
-    store_fusion = 0;
-    store_grnd_flux = 0;
-    store_latent = 0;
-    store_latent_sub = 0;
-    store_melt_energy = 0;
-    store_refreeze_energy = 0;
-    store_sensible = 0;
-    store_snow_flux = 0;
-    // snow structure
     last_snow_coverage = snow->coverage;
-    store_canopy_vapor_flux = 0;
-    store_melt = 0;
-    store_vapor_flux = 0;
-    store_surface_flux = 0;
-    store_blowing_flux = 0;
-    // veg_var and cell structures
-    store_throughfall = 0.;
-    store_canopyevap = 0.;
-    for (lidx = 0; lidx < options.Nlayer; lidx++) {
-        store_layerevap[lidx] = 0.;
-    }
     step_Wdew = veg_var->Wdew;
-    // misc
-    store_ppt = 0;
-    store_aero_cond_used[0] = 0;
-    store_aero_cond_used[1] = 0;
     (*snow_inflow) = 0;
-    store_pot_evap = 0;
     N_steps = 0;
 
-    // Carbon cycling
-    if (options.CARBON) {
-        store_gc = 0;
-        for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-            store_gsLayer[cidx] = 0;
-        }
-        store_Ci = 0;
-        store_GPP = 0;
-        store_Rdark = 0;
-        store_Rphoto = 0;
-        store_Rmaint = 0;
-        store_Rgrowth = 0;
-        store_Raut = 0;
-        store_NPP = 0;
+    // the age of the snow surface is counted in snow model sub-steps
+    fine_last_snow = step_snow->last_snow;
+    if (single_step) {
+        step_snow->last_snow = (fine_last_snow + NF / 2) / NF;
     }
 
     /*************************
@@ -400,12 +415,7 @@ surface_fluxes(bool                 overstory,
         last_snow_flux = 999;
 
         // compute LAI and absorbed PAR per canopy layer
-        if (options.CARBON && iveg < Nveg) {
-            LAIlayer = calloc(options.Ncanopy, sizeof(*LAIlayer));
-            check_alloc_status(LAIlayer, "Memory allocation error.");
-            faPAR = calloc(options.Ncanopy, sizeof(*faPAR));
-            check_alloc_status(faPAR, "Memory allocation error.");
-
+        if (OPT_CARBON && iveg < Nveg) {
             /* Compute absorbed PAR per ground area per canopy layer (W/m2)
                normalized to PAR = 1 W, i.e. the canopy albedo in the PAR
                range (alb_total ~ 0.45*alb_par + 0.55*alb_other) */
@@ -435,35 +445,34 @@ surface_fluxes(bool                 overstory,
                     veg_var->aPAR += force->par[hidx] * faPAR[cidx] / 1e-10;
                 }
             }
-            free((char*) LAIlayer);
-            free((char*) faPAR);
         }
 
         // Compute mass flux of blowing snow
-        if (!overstory && options.BLOWING && step_snow.swq > 0.) {
-            Ls = calc_latent_heat_of_sublimation(step_snow.surf_temp);
-            step_snow.blowing_flux = CalcBlowingSnow(step_dt, Tair,
-                                                     step_snow.last_snow,
-                                                     step_snow.surf_water,
-                                                     wind[2], Ls,
-                                                     force->density[hidx],
-                                                     force->vp[hidx],
-                                                     roughness[2],
-                                                     ref_height[2],
-                                                     step_snow.depth,
-                                                     lag_one, sigma_slope,
-                                                     step_snow.surf_temp, iveg,
-                                                     Nveg, fetch,
-                                                     displacement[1],
-                                                     roughness[1],
-                                                     &step_snow.transport);
-            if ((int) step_snow.blowing_flux == ERROR) {
+        if (!overstory && OPT_BLOWING && step_snow->swq > 0.) {
+            Ls = calc_latent_heat_of_sublimation(step_snow->surf_temp);
+            step_snow->blowing_flux = CalcBlowingSnow(step_dt, Tair,
+                                                      step_snow->last_snow,
+                                                      step_snow->surf_water,
+                                                      wind[2], Ls,
+                                                      force->density[hidx],
+                                                      force->vp[hidx],
+                                                      roughness[2],
+                                                      ref_height[2],
+                                                      step_snow->depth,
+                                                      lag_one, sigma_slope,
+                                                      step_snow->surf_temp, iveg,
+                                                      Nveg, fetch,
+                                                      displacement[1],
+                                                      roughness[1],
+                                                      &step_snow->transport);
+            if ((int) step_snow->blowing_flux == ERROR) {
+                scratch_release(scratch_start);
                 return (ERROR);
             }
-            step_snow.blowing_flux *= step_dt / CONST_RHOFW; /* m/time step */
+            step_snow->blowing_flux *= step_dt / CONST_RHOFW; /* m/time step */
         }
         else {
-            step_snow.blowing_flux = 0.0;
+            step_snow->blowing_flux = 0.0;
         }
 
         do
@@ -510,7 +519,7 @@ surface_fluxes(bool                 overstory,
                     }
                     else if (!INCLUDE_SNOW) { // stepped the wrong way
                         snow_flux =
-                            (last_snow_flux + iter_soil_energy.snow_flux) / 2.;
+                            (last_snow_flux + iter_soil_energy->snow_flux) / 2.;
                     }
                 }
                 last_snow_flux = snow_flux;
@@ -519,18 +528,18 @@ surface_fluxes(bool                 overstory,
                 snow_grnd_flux = -snow_flux;
 
                 // Initialize structures for new iteration
-                iter_snow_energy = snow_energy;
-                iter_soil_energy = soil_energy;
-                iter_snow_veg_var = snow_veg_var;
-                iter_soil_veg_var = soil_veg_var;
-                iter_snow = step_snow;
+                (*iter_snow_energy) = (*snow_energy);
+                (*iter_soil_energy) = (*soil_energy);
+                (*iter_snow_veg_var) = (*snow_veg_var);
+                (*iter_soil_veg_var) = (*soil_veg_var);
+                (*iter_snow) = (*step_snow);
                 for (lidx = 0; lidx < Nlayers; lidx++) {
                     iter_layer[lidx] = step_layer[lidx];
                 }
-                iter_snow_veg_var.Wdew = step_Wdew;
-                iter_soil_veg_var.Wdew = step_Wdew;
-                iter_snow_veg_var.canopyevap = 0;
-                iter_soil_veg_var.canopyevap = 0;
+                iter_snow_veg_var->Wdew = step_Wdew;
+                iter_soil_veg_var->Wdew = step_Wdew;
+                iter_snow_veg_var->canopyevap = 0;
+                iter_soil_veg_var->canopyevap = 0;
                 for (lidx = 0; lidx < Nlayers; lidx++) {
                     iter_layer[lidx].evap = 0;
                 }
@@ -540,14 +549,15 @@ surface_fluxes(bool                 overstory,
                 }
                 iter_aero_resist_used[0] = aero_resist_used[0];
                 iter_aero_resist_used[1] = aero_resist_used[1];
-                iter_snow.canopy_vapor_flux = 0;
-                iter_snow.vapor_flux = 0;
-                iter_snow.surface_flux = 0;
-                /* iter_snow.blowing_flux has already been reset to step_snow.blowing_flux */
-                LongUnderOut = iter_soil_energy.LongUnderOut;
+                iter_snow->canopy_vapor_flux = 0;
+                iter_snow->vapor_flux = 0;
+                iter_snow->surface_flux = 0;
+                /* iter_snow->blowing_flux has already been reset to step_snow->blowing_flux */
+                LongUnderOut = iter_soil_energy->LongUnderOut;
                 dryFrac = -1;
 
                 /** Solve snow accumulation, ablation and interception **/
+                perf_region_start(PERF_SOLVE_SNOW);
                 step_melt = solve_snow(overstory, BareAlbedo, LongUnderOut,
                                        param.SNOW_MIN_RAIN_TEMP,
                                        param.SNOW_MAX_SNOW_TEMP,
@@ -568,32 +578,34 @@ surface_fluxes(bool                 overstory,
                                        &surf_atten,
                                        wind, root, UNSTABLE_SNOW,
                                        Nveg, iveg, band, step_dt, hidx,
-                                       veg_class,
+                                       veg_class, veg_lib,
                                        &UnderStory, CanopLayerBnd, &dryFrac,
-                                       dmy, force, &(iter_snow_energy),
-                                       iter_layer, &(iter_snow),
+                                       dmy, force, iter_snow_energy,
+                                       iter_layer, iter_snow,
                                        soil_con,
-                                       &(iter_snow_veg_var));
+                                       iter_snow_veg_var);
+                perf_region_stop(PERF_SOLVE_SNOW);
 
                 if (step_melt == ERROR) {
+                    scratch_release(scratch_start);
                     return (ERROR);
                 }
 
                 /* Check that the snow surface temperature was estimated, if not
                    prepare to include thin snowpack in the estimation of the
                    snow-free surface energy balance */
-                if ((iter_snow.surf_temp == 999 || UNSTABLE_SNOW) &&
-                    iter_snow.swq > 0) {
+                if ((iter_snow->surf_temp == 999 || UNSTABLE_SNOW) &&
+                    iter_snow->swq > 0) {
                     INCLUDE_SNOW = UnderStory + 1;
-                    iter_soil_energy.advection = iter_snow_energy.advection;
-                    iter_snow.surf_temp = step_snow.surf_temp;
+                    iter_soil_energy->advection = iter_snow_energy->advection;
+                    iter_snow->surf_temp = step_snow->surf_temp;
                     step_melt_energy = 0;
                 }
                 else {
                     INCLUDE_SNOW = false;
                 }
 
-                if (iter_snow.snow) {
+                if (iter_snow->snow) {
                     iter_aero_resist_veg[0] = iter_aero_resist_used[0];
                     iter_aero_resist_veg[1] = iter_aero_resist_used[1];
                 }
@@ -602,35 +614,39 @@ surface_fluxes(bool                 overstory,
                    Solve Energy Balance Components at Soil Surface
                 **************************************************/
 
+                perf_region_start(PERF_SURF_ENERGY_BAL);
                 Tsurf = calc_surf_energy_bal((*Le), LongUnderIn, NetLongSnow,
                                              NetShortGrnd, NetShortSnow,
                                              OldTSurf,
-                                             ShortUnderIn, iter_snow.albedo,
-                                             iter_snow_energy.latent,
-                                             iter_snow_energy.latent_sub,
-                                             iter_snow_energy.sensible,
+                                             ShortUnderIn, iter_snow->albedo,
+                                             iter_snow_energy->latent,
+                                             iter_snow_energy->latent_sub,
+                                             iter_snow_energy->sensible,
                                              Tcanopy, VPDcanopy,
                                              VPcanopy,
                                              delta_coverage, dp,
                                              ice0, step_melt_energy, moist0,
-                                             iter_snow.coverage,
-                                             (step_snow.depth + iter_snow.depth) / 2.,
+                                             iter_snow->coverage,
+                                             (step_snow->depth + iter_snow->depth) / 2.,
                                              BareAlbedo, surf_atten,
                                              iter_aero_resist, iter_aero_resist_veg, iter_aero_resist_used,
                                              displacement, &step_melt, &step_ppt,
                                              rainfall, ref_height, roughness,
                                              snowfall, wind, root, INCLUDE_SNOW,
-                                             UnderStory, options.Nnode, Nveg,
+                                             UnderStory, OPT_Nnode, Nveg,
                                              step_dt, hidx, iveg,
                                              (int) overstory, veg_class,
-                                             CanopLayerBnd, &dryFrac, force,
-                                             dmy, &iter_soil_energy,
+                                             veg_lib, CanopLayerBnd, &dryFrac,
+                                             force,
+                                             dmy, iter_soil_energy,
                                              iter_layer,
-                                             &(iter_snow), soil_con,
-                                             &iter_soil_veg_var);
+                                             iter_snow, soil_con,
+                                             iter_soil_veg_var);
+                perf_region_stop(PERF_SURF_ENERGY_BAL);
 
                 if ((int) Tsurf == ERROR) {
                     // Return error flag to skip rest of grid cell
+                    scratch_release(scratch_start);
                     return (ERROR);
                 }
 
@@ -642,29 +658,29 @@ surface_fluxes(bool                 overstory,
                 /*****************************************
                    Compute energy balance with atmosphere
                 *****************************************/
-                if (iter_snow.snow && overstory) {
+                if (iter_snow->snow && overstory) {
                     // do this if overstory is active and energy balance is closed
                     Tcanopy = calc_atmos_energy_bal(
-                        iter_snow_energy.canopy_sensible,
-                        iter_soil_energy.sensible,
-                        iter_snow_energy.canopy_latent,
-                        iter_soil_energy.latent,
-                        iter_snow_energy.canopy_latent_sub,
-                        iter_soil_energy.latent_sub,
-                        iter_snow_energy.NetLongOver,
-                        iter_soil_energy.NetLongUnder,
-                        iter_snow_energy.NetShortOver,
-                        iter_soil_energy.NetShortUnder,
+                        iter_snow_energy->canopy_sensible,
+                        iter_soil_energy->sensible,
+                        iter_snow_energy->canopy_latent,
+                        iter_soil_energy->latent,
+                        iter_snow_energy->canopy_latent_sub,
+                        iter_soil_energy->latent_sub,
+                        iter_snow_energy->NetLongOver,
+                        iter_soil_energy->NetLongUnder,
+                        iter_snow_energy->NetShortOver,
+                        iter_soil_energy->NetShortUnder,
                         iter_aero_resist_veg[1], Tair,
                         force->density[hidx],
-                        &iter_soil_energy.AtmosError,
-                        &iter_soil_energy.AtmosLatent,
-                        &iter_soil_energy.AtmosLatentSub,
-                        &iter_soil_energy.NetLongAtmos,
-                        &iter_soil_energy.NetShortAtmos,
-                        &iter_soil_energy.AtmosSensible,
-                        &iter_soil_energy.Tcanopy_fbflag,
-                        &iter_soil_energy.Tcanopy_fbcount);
+                        &iter_soil_energy->AtmosError,
+                        &iter_soil_energy->AtmosLatent,
+                        &iter_soil_energy->AtmosLatentSub,
+                        &iter_soil_energy->NetLongAtmos,
+                        &iter_soil_energy->NetShortAtmos,
+                        &iter_soil_energy->AtmosSensible,
+                        &iter_soil_energy->Tcanopy_fbflag,
+                        &iter_soil_energy->Tcanopy_fbcount);
 
                     /* iterate to find Tcanopy which will solve the atmospheric energy
                        balance.  Since I do not know vp in the canopy, use the
@@ -673,23 +689,24 @@ surface_fluxes(bool                 overstory,
                        canopy air to the mixing level */
                     if ((int) Tcanopy == ERROR) {
                         // Return error flag to skip rest of grid cell
+                        scratch_release(scratch_start);
                         return (ERROR);
                     }
                 }
                 else {
                     // else put surface fluxes into atmospheric flux storage so that
                     // the model will continue to function
-                    iter_soil_energy.AtmosLatent = iter_soil_energy.latent;
-                    iter_soil_energy.AtmosLatentSub =
-                        iter_soil_energy.latent_sub;
-                    iter_soil_energy.AtmosSensible = iter_soil_energy.sensible;
-                    iter_soil_energy.NetLongAtmos =
-                        iter_soil_energy.NetLongUnder;
-                    iter_soil_energy.NetShortAtmos =
-                        iter_soil_energy.NetShortUnder;
+                    iter_soil_energy->AtmosLatent = iter_soil_energy->latent;
+                    iter_soil_energy->AtmosLatentSub =
+                        iter_soil_energy->latent_sub;
+                    iter_soil_energy->AtmosSensible = iter_soil_energy->sensible;
+                    iter_soil_energy->NetLongAtmos =
+                        iter_soil_energy->NetLongUnder;
+                    iter_soil_energy->NetShortAtmos =
+                        iter_soil_energy->NetShortUnder;
                 }
-                iter_soil_energy.Tcanopy = Tcanopy;
-                iter_snow_energy.Tcanopy = Tcanopy;
+                iter_soil_energy->Tcanopy = Tcanopy;
+                iter_snow_energy->Tcanopy = Tcanopy;
 
                 /*****************************************
                    Compute iteration tolerance statistics
@@ -697,12 +714,12 @@ surface_fluxes(bool                 overstory,
 
                 // compute understory tolerance
                 if (INCLUDE_SNOW ||
-                    (iter_snow.swq == 0 && delta_coverage == 0)) {
+                    (iter_snow->swq == 0 && delta_coverage == 0)) {
                     store_tol_under = 0;
                     tol_under = 0;
                 }
                 else {
-                    store_tol_under = snow_flux - iter_soil_energy.snow_flux;
+                    store_tol_under = snow_flux - iter_soil_energy->snow_flux;
                     tol_under = fabs(store_tol_under);
                 }
                 if (fabs(tol_under - last_tol_under) < param.TOL_GRND &&
@@ -712,7 +729,7 @@ surface_fluxes(bool                 overstory,
                 }
 
                 // compute overstory tolerance
-                if (overstory && iter_snow.snow) {
+                if (overstory && iter_snow->snow) {
                     store_tol_over = Tcanopy - last_Tcanopy;
                     tol_over = fabs(store_tol_over);
                 }
@@ -731,62 +748,64 @@ surface_fluxes(bool                 overstory,
         /**************************************
            Compute GPP, Raut, and NPP
         **************************************/
-        if (options.CARBON) {
-            if (iveg < Nveg && !step_snow.snow && dryFrac > 0) {
-                canopy_assimilation(vic_run_veg_lib[veg_class].Ctype,
-                                    vic_run_veg_lib[veg_class].MaxCarboxRate,
-                                    vic_run_veg_lib[veg_class].MaxETransport,
-                                    vic_run_veg_lib[veg_class].CO2Specificity,
-                                    iter_soil_veg_var.NscaleFactor,
+        if (OPT_CARBON) {
+            if (iveg < Nveg && !step_snow->snow && dryFrac > 0) {
+                perf_region_start(PERF_CARBON);
+                canopy_assimilation(veg_lib[veg_class].Ctype,
+                                    veg_lib[veg_class].MaxCarboxRate,
+                                    veg_lib[veg_class].MaxETransport,
+                                    veg_lib[veg_class].CO2Specificity,
+                                    iter_soil_veg_var->NscaleFactor,
                                     Tair,
                                     force->shortwave[hidx],
-                                    iter_soil_veg_var.aPARLayer,
+                                    iter_soil_veg_var->aPARLayer,
                                     soil_con->elevation,
                                     force->Catm[hidx],
                                     CanopLayerBnd,
                                     veg_var->LAI,
                                     "rs",
-                                    iter_soil_veg_var.rsLayer,
-                                    &(iter_soil_veg_var.rc),
-                                    &(iter_soil_veg_var.Ci),
-                                    &(iter_soil_veg_var.GPP),
-                                    &(iter_soil_veg_var.Rdark),
-                                    &(iter_soil_veg_var.Rphoto),
-                                    &(iter_soil_veg_var.Rmaint),
-                                    &(iter_soil_veg_var.Rgrowth),
-                                    &(iter_soil_veg_var.Raut),
-                                    &(iter_soil_veg_var.NPP));
+                                    iter_soil_veg_var->rsLayer,
+                                    &(iter_soil_veg_var->rc),
+                                    &(iter_soil_veg_var->Ci),
+                                    &(iter_soil_veg_var->GPP),
+                                    &(iter_soil_veg_var->Rdark),
+                                    &(iter_soil_veg_var->Rphoto),
+                                    &(iter_soil_veg_var->Rmaint),
+                                    &(iter_soil_veg_var->Rgrowth),
+                                    &(iter_soil_veg_var->Raut),
+                                    &(iter_soil_veg_var->NPP));
+                perf_region_stop(PERF_CARBON);
                 /* Adjust by fraction of canopy that was dry and account for any other inhibition`*/
-                dryFrac *= iter_soil_veg_var.NPPfactor;
-                iter_soil_veg_var.GPP *= dryFrac;
-                iter_soil_veg_var.Rdark *= dryFrac;
-                iter_soil_veg_var.Rphoto *= dryFrac;
-                iter_soil_veg_var.Rmaint *= dryFrac;
-                iter_soil_veg_var.Rgrowth *= dryFrac;
-                iter_soil_veg_var.Raut *= dryFrac;
-                iter_soil_veg_var.NPP *= dryFrac;
+                dryFrac *= iter_soil_veg_var->NPPfactor;
+                iter_soil_veg_var->GPP *= dryFrac;
+                iter_soil_veg_var->Rdark *= dryFrac;
+                iter_soil_veg_var->Rphoto *= dryFrac;
+                iter_soil_veg_var->Rmaint *= dryFrac;
+                iter_soil_veg_var->Rgrowth *= dryFrac;
+                iter_soil_veg_var->Raut *= dryFrac;
+                iter_soil_veg_var->NPP *= dryFrac;
                 /* Adjust by veg cover fraction */
-                iter_soil_veg_var.GPP *= iter_soil_veg_var.fcanopy;
-                iter_soil_veg_var.Rdark *= iter_soil_veg_var.fcanopy;
-                iter_soil_veg_var.Rphoto *= iter_soil_veg_var.fcanopy;
-                iter_soil_veg_var.Rmaint *= iter_soil_veg_var.fcanopy;
-                iter_soil_veg_var.Rgrowth *= iter_soil_veg_var.fcanopy;
-                iter_soil_veg_var.Raut *= iter_soil_veg_var.fcanopy;
-                iter_soil_veg_var.NPP *= iter_soil_veg_var.fcanopy;
+                iter_soil_veg_var->GPP *= iter_soil_veg_var->fcanopy;
+                iter_soil_veg_var->Rdark *= iter_soil_veg_var->fcanopy;
+                iter_soil_veg_var->Rphoto *= iter_soil_veg_var->fcanopy;
+                iter_soil_veg_var->Rmaint *= iter_soil_veg_var->fcanopy;
+                iter_soil_veg_var->Rgrowth *= iter_soil_veg_var->fcanopy;
+                iter_soil_veg_var->Raut *= iter_soil_veg_var->fcanopy;
+                iter_soil_veg_var->NPP *= iter_soil_veg_var->fcanopy;
             }
             else {
-                iter_soil_veg_var.rc = param.HUGE_RESIST;
+                iter_soil_veg_var->rc = param.HUGE_RESIST;
                 for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-                    iter_soil_veg_var.rsLayer[cidx] = param.HUGE_RESIST;
+                    iter_soil_veg_var->rsLayer[cidx] = param.HUGE_RESIST;
                 }
-                iter_soil_veg_var.Ci = 0;
-                iter_soil_veg_var.GPP = 0;
-                iter_soil_veg_var.Rdark = 0;
-                iter_soil_veg_var.Rphoto = 0;
-                iter_soil_veg_var.Rmaint = 0;
-                iter_soil_veg_var.Rgrowth = 0;
-                iter_soil_veg_var.Raut = 0;
-                iter_soil_veg_var.NPP = 0;
+                iter_soil_veg_var->Ci = 0;
+                iter_soil_veg_var->GPP = 0;
+                iter_soil_veg_var->Rdark = 0;
+                iter_soil_veg_var->Rphoto = 0;
+                iter_soil_veg_var->Rmaint = 0;
+                iter_soil_veg_var->Rgrowth = 0;
+                iter_soil_veg_var->Raut = 0;
+                iter_soil_veg_var->NPP = 0;
             }
         }
 
@@ -795,81 +814,82 @@ surface_fluxes(bool                 overstory,
         **************************************/
 
         compute_pot_evap(gp->model_steps_per_day,
-                         vic_run_veg_lib[veg_class].rmin,
-                         iter_soil_veg_var.albedo, force->shortwave[hidx],
-                         iter_soil_energy.NetLongAtmos,
-                         vic_run_veg_lib[veg_class].RGL, Tair, VPDcanopy,
-                         iter_soil_veg_var.LAI, soil_con->elevation,
+                         veg_lib[veg_class].rmin,
+                         iter_soil_veg_var->albedo, force->shortwave[hidx],
+                         iter_soil_energy->NetLongAtmos,
+                         veg_lib[veg_class].RGL, Tair, VPDcanopy,
+                         iter_soil_veg_var->LAI, soil_con->elevation,
                          iter_aero_resist_veg,
-                         vic_run_veg_lib[veg_class].overstory,
-                         vic_run_veg_lib[veg_class].rarc,
-                         iter_soil_veg_var.fcanopy, iter_aero_resist_used[0],
+                         veg_lib[veg_class].overstory,
+                         veg_lib[veg_class].rarc,
+                         iter_soil_veg_var->fcanopy, iter_aero_resist_used[0],
                          &iter_pot_evap);
 
         /**************************************
            Store sub-model time step variables
         **************************************/
 
-        snow_energy = iter_snow_energy;
-        soil_energy = iter_soil_energy;
-        snow_veg_var = iter_snow_veg_var;
-        soil_veg_var = iter_soil_veg_var;
-        step_snow = iter_snow;
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
-            step_layer[lidx] = iter_layer[lidx];
-        }
+        // the iteration results become the values of the snow step, and
+        // the next iteration starts from a copy of them
+        step_state = 1 - step_state;
+        set_surface_fluxes_state(&(state[step_state]), &snow_energy,
+                                 &soil_energy, &snow_veg_var, &soil_veg_var,
+                                 &step_snow, &step_layer);
+        set_surface_fluxes_state(&(state[1 - step_state]), &iter_snow_energy,
+                                 &iter_soil_energy, &iter_snow_veg_var,
+                                 &iter_soil_veg_var, &iter_snow, &iter_layer);
 
         if (iveg != Nveg) {
-            if (step_snow.snow) {
-                store_throughfall += snow_veg_var.throughfall;
-                store_canopyevap += snow_veg_var.canopyevap;
-                soil_veg_var.Wdew = snow_veg_var.Wdew;
+            if (step_snow->snow) {
+                store.throughfall += snow_veg_var->throughfall;
+                store.canopyevap += snow_veg_var->canopyevap;
+                soil_veg_var->Wdew = snow_veg_var->Wdew;
             }
             else {
-                store_throughfall += soil_veg_var.throughfall;
-                store_canopyevap += soil_veg_var.canopyevap;
-                snow_veg_var.Wdew = soil_veg_var.Wdew;
+                store.throughfall += soil_veg_var->throughfall;
+                store.canopyevap += soil_veg_var->canopyevap;
+                snow_veg_var->Wdew = soil_veg_var->Wdew;
             }
-            step_Wdew = soil_veg_var.Wdew;
-            if (options.CARBON) {
-                store_gc += 1 / soil_veg_var.rc;
+            step_Wdew = soil_veg_var->Wdew;
+            if (OPT_CARBON) {
+                store.gc += 1 / soil_veg_var->rc;
                 for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-                    store_gsLayer[cidx] += 1 / soil_veg_var.rsLayer[cidx];
+                    store.gsLayer[cidx] += 1 / soil_veg_var->rsLayer[cidx];
                 }
-                store_Ci += soil_veg_var.Ci;
-                store_GPP += soil_veg_var.GPP;
-                store_Rdark += soil_veg_var.Rdark;
-                store_Rphoto += soil_veg_var.Rphoto;
-                store_Rmaint += soil_veg_var.Rmaint;
-                store_Rgrowth += soil_veg_var.Rgrowth;
-                store_Raut += soil_veg_var.Raut;
-                store_NPP += soil_veg_var.NPP;
+                store.Ci += soil_veg_var->Ci;
+                store.GPP += soil_veg_var->GPP;
+                store.Rdark += soil_veg_var->Rdark;
+                store.Rphoto += soil_veg_var->Rphoto;
+                store.Rmaint += soil_veg_var->Rmaint;
+                store.Rgrowth += soil_veg_var->Rgrowth;
+                store.Raut += soil_veg_var->Raut;
+                store.NPP += soil_veg_var->NPP;
             }
         }
-        for (lidx = 0; lidx < options.Nlayer; lidx++) {
-            store_layerevap[lidx] += step_layer[lidx].evap;
+        for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
+            store.layerevap[lidx] += step_layer[lidx].evap;
         }
-        store_ppt += step_ppt;
+        store.ppt += step_ppt;
         if (iter_aero_resist_used[0] > 0) {
-            store_aero_cond_used[0] += 1 / iter_aero_resist_used[0];
+            store.aero_cond_used[0] += 1 / iter_aero_resist_used[0];
         }
         else {
-            store_aero_cond_used[0] += param.HUGE_RESIST;
+            store.aero_cond_used[0] += param.HUGE_RESIST;
         }
         if (iter_aero_resist_used[1] > 0) {
-            store_aero_cond_used[1] += 1 / iter_aero_resist_used[1];
+            store.aero_cond_used[1] += 1 / iter_aero_resist_used[1];
         }
         else {
-            store_aero_cond_used[1] += param.HUGE_RESIST;
+            store.aero_cond_used[1] += param.HUGE_RESIST;
         }
 
         if (iveg != Nveg) {
-            store_canopy_vapor_flux += step_snow.canopy_vapor_flux;
+            store.canopy_vapor_flux += step_snow->canopy_vapor_flux;
         }
-        store_melt += step_melt;
-        store_vapor_flux += step_snow.vapor_flux;
-        store_surface_flux += step_snow.surface_flux;
-        store_blowing_flux += step_snow.blowing_flux;
+        store.melt += step_melt;
+        store.vapor_flux += step_snow->vapor_flux;
+        store.surface_flux += step_snow->surface_flux;
+        store.blowing_flux += step_snow->blowing_flux;
 
         out_prec[0] += step_out_prec;
         out_rain[0] += step_out_rain;
@@ -877,147 +897,152 @@ surface_fluxes(bool                 overstory,
 
         if (INCLUDE_SNOW) {
             /* copy needed flux terms to the snowpack */
-            snow_energy.advected_sensible = soil_energy.advected_sensible;
-            snow_energy.advection = soil_energy.advection;
-            snow_energy.deltaCC = soil_energy.deltaCC;
-            snow_energy.latent = soil_energy.latent;
-            snow_energy.latent_sub = soil_energy.latent_sub;
-            snow_energy.refreeze_energy = soil_energy.refreeze_energy;
-            snow_energy.sensible = soil_energy.sensible;
-            snow_energy.snow_flux = soil_energy.snow_flux;
+            snow_energy->advected_sensible = soil_energy->advected_sensible;
+            snow_energy->advection = soil_energy->advection;
+            snow_energy->deltaCC = soil_energy->deltaCC;
+            snow_energy->latent = soil_energy->latent;
+            snow_energy->latent_sub = soil_energy->latent_sub;
+            snow_energy->refreeze_energy = soil_energy->refreeze_energy;
+            snow_energy->sensible = soil_energy->sensible;
+            snow_energy->snow_flux = soil_energy->snow_flux;
         }
 
-        store_AlbedoOver += snow_energy.AlbedoOver;
-        store_AlbedoUnder += soil_energy.AlbedoUnder;
-        store_AtmosLatent += soil_energy.AtmosLatent;
-        store_AtmosLatentSub += soil_energy.AtmosLatentSub;
-        store_AtmosSensible += soil_energy.AtmosSensible;
-        store_LongOverIn += snow_energy.LongOverIn;
-        store_LongUnderIn += LongUnderIn;
-        store_LongUnderOut += soil_energy.LongUnderOut;
-        store_NetLongAtmos += soil_energy.NetLongAtmos;
-        store_NetLongOver += snow_energy.NetLongOver;
-        store_NetLongUnder += soil_energy.NetLongUnder;
-        store_NetShortAtmos += soil_energy.NetShortAtmos;
-        store_NetShortGrnd += NetShortGrnd;
-        store_NetShortOver += snow_energy.NetShortOver;
-        store_NetShortUnder += soil_energy.NetShortUnder;
-        store_ShortOverIn += snow_energy.ShortOverIn;
-        store_ShortUnderIn += soil_energy.ShortUnderIn;
-        store_canopy_advection += snow_energy.canopy_advection;
-        store_canopy_latent += snow_energy.canopy_latent;
-        store_canopy_latent_sub += snow_energy.canopy_latent_sub;
-        store_canopy_sensible += snow_energy.canopy_sensible;
-        store_canopy_refreeze += snow_energy.canopy_refreeze;
-        store_deltaH += soil_energy.deltaH;
-        store_fusion += soil_energy.fusion;
-        store_grnd_flux += soil_energy.grnd_flux;
-        store_latent += soil_energy.latent;
-        store_latent_sub += soil_energy.latent_sub;
-        store_melt_energy += step_melt_energy;
-        store_sensible += soil_energy.sensible;
-        if (step_snow.swq == 0 && INCLUDE_SNOW) {
+        store.AlbedoOver += snow_energy->AlbedoOver;
+        store.AlbedoUnder += soil_energy->AlbedoUnder;
+        store.AtmosLatent += soil_energy->AtmosLatent;
+        store.AtmosLatentSub += soil_energy->AtmosLatentSub;
+        store.AtmosSensible += soil_energy->AtmosSensible;
+        store.LongOverIn += snow_energy->LongOverIn;
+        store.LongUnderIn += LongUnderIn;
+        store.LongUnderOut += soil_energy->LongUnderOut;
+        store.NetLongAtmos += soil_energy->NetLongAtmos;
+        store.NetLongOver += snow_energy->NetLongOver;
+        store.NetLongUnder += soil_energy->NetLongUnder;
+        store.NetShortAtmos += soil_energy->NetShortAtmos;
+        store.NetShortGrnd += NetShortGrnd;
+        store.NetShortOver += snow_energy->NetShortOver;
+        store.NetShortUnder += soil_energy->NetShortUnder;
+        store.ShortOverIn += snow_energy->ShortOverIn;
+        store.ShortUnderIn += soil_energy->ShortUnderIn;
+        store.canopy_advection += snow_energy->canopy_advection;
+        store.canopy_latent += snow_energy->canopy_latent;
+        store.canopy_latent_sub += snow_energy->canopy_latent_sub;
+        store.canopy_sensible += snow_energy->canopy_sensible;
+        store.canopy_refreeze += snow_energy->canopy_refreeze;
+        store.deltaH += soil_energy->deltaH;
+        store.fusion += soil_energy->fusion;
+        store.grnd_flux += soil_energy->grnd_flux;
+        store.latent += soil_energy->latent;
+        store.latent_sub += soil_energy->latent_sub;
+        store.melt_energy += step_melt_energy;
+        store.sensible += soil_energy->sensible;
+        if (step_snow->swq == 0 && INCLUDE_SNOW) {
             if (last_snow_coverage == 0 && step_prec > 0) {
                 last_snow_coverage = 1;
             }
-            store_advected_sensible += snow_energy.advected_sensible *
+            store.advected_sensible += snow_energy->advected_sensible *
                                        last_snow_coverage;
-            store_advection += snow_energy.advection * last_snow_coverage;
-            store_deltaCC += snow_energy.deltaCC * last_snow_coverage;
-            store_snow_flux += soil_energy.snow_flux * last_snow_coverage;
-            store_refreeze_energy += snow_energy.refreeze_energy *
+            store.advection += snow_energy->advection * last_snow_coverage;
+            store.deltaCC += snow_energy->deltaCC * last_snow_coverage;
+            store.snow_flux += soil_energy->snow_flux * last_snow_coverage;
+            store.refreeze_energy += snow_energy->refreeze_energy *
                                      last_snow_coverage;
         }
-        else if (step_snow.snow || INCLUDE_SNOW) {
-            store_advected_sensible += snow_energy.advected_sensible *
-                                       (step_snow.coverage + delta_coverage);
-            store_advection += snow_energy.advection *
-                               (step_snow.coverage + delta_coverage);
-            store_deltaCC += snow_energy.deltaCC *
-                             (step_snow.coverage + delta_coverage);
-            store_snow_flux += soil_energy.snow_flux *
-                               (step_snow.coverage + delta_coverage);
-            store_refreeze_energy += snow_energy.refreeze_energy *
-                                     (step_snow.coverage + delta_coverage);
+        else if (step_snow->snow || INCLUDE_SNOW) {
+            store.advected_sensible += snow_energy->advected_sensible *
+                                       (step_snow->coverage + delta_coverage);
+            store.advection += snow_energy->advection *
+                               (step_snow->coverage + delta_coverage);
+            store.deltaCC += snow_energy->deltaCC *
+                             (step_snow->coverage + delta_coverage);
+            store.snow_flux += soil_energy->snow_flux *
+                               (step_snow->coverage + delta_coverage);
+            store.refreeze_energy += snow_energy->refreeze_energy *
+                                     (step_snow->coverage + delta_coverage);
         }
-        store_pot_evap += iter_pot_evap;
+        store.pot_evap += iter_pot_evap;
 
         /* increment time step */
         N_steps++;
+        solver_stats[SOLVER_SNOW_STEPS]++;
         hidx += step_inc;
     }
     while (hidx < endhidx);
 
+    if (single_step && step_snow->last_snow > 0) {
+        step_snow->last_snow = fine_last_snow + NF;
+    }
+
     /************************************************
        Store snow variables for sub-model time steps
     ************************************************/
 
-    (*snow) = step_snow;
-    snow->vapor_flux = store_vapor_flux;
-    snow->blowing_flux = store_blowing_flux;
-    snow->surface_flux = store_surface_flux;
-    snow->canopy_vapor_flux = store_canopy_vapor_flux;
-    (*Melt) = store_melt;
-    snow->melt = store_melt;
-    ppt = store_ppt;
+    (*snow) = (*step_snow);
+    snow->vapor_flux = store.vapor_flux;
+    snow->blowing_flux = store.blowing_flux;
+    snow->surface_flux = store.surface_flux;
+    snow->canopy_vapor_flux = store.canopy_vapor_flux;
+    (*Melt) = store.melt;
+    snow->melt = store.melt;
+    ppt = store.ppt;
 
     /******************************************************
        Store energy flux averages for sub-model time steps
     ******************************************************/
 
-    (*energy) = soil_energy;
-    energy->AlbedoOver = store_AlbedoOver / (double) N_steps;
-    energy->AlbedoUnder = store_AlbedoUnder / (double) N_steps;
-    energy->AtmosLatent = store_AtmosLatent / (double) N_steps;
-    energy->AtmosLatentSub = store_AtmosLatentSub / (double) N_steps;
-    energy->AtmosSensible = store_AtmosSensible / (double) N_steps;
-    energy->LongOverIn = store_LongOverIn / (double) N_steps;
-    energy->LongUnderIn = store_LongUnderIn / (double) N_steps;
-    energy->LongUnderOut = store_LongUnderOut / (double) N_steps;
-    energy->NetLongAtmos = store_NetLongAtmos / (double) N_steps;
-    energy->NetLongOver = store_NetLongOver / (double) N_steps;
-    energy->NetLongUnder = store_NetLongUnder / (double) N_steps;
-    energy->NetShortAtmos = store_NetShortAtmos / (double) N_steps;
-    energy->NetShortGrnd = store_NetShortGrnd / (double) N_steps;
-    energy->NetShortOver = store_NetShortOver / (double) N_steps;
-    energy->NetShortUnder = store_NetShortUnder / (double) N_steps;
-    energy->ShortOverIn = store_ShortOverIn / (double) N_steps;
-    energy->ShortUnderIn = store_ShortUnderIn / (double) N_steps;
-    energy->advected_sensible = store_advected_sensible / (double) N_steps;
-    energy->canopy_advection = store_canopy_advection / (double) N_steps;
-    energy->canopy_latent = store_canopy_latent / (double) N_steps;
-    energy->canopy_latent_sub = store_canopy_latent_sub / (double) N_steps;
-    energy->canopy_refreeze = store_canopy_refreeze / (double) N_steps;
-    energy->canopy_sensible = store_canopy_sensible / (double) N_steps;
-    energy->deltaH = store_deltaH / (double) N_steps;
-    energy->fusion = store_fusion / (double) N_steps;
-    energy->grnd_flux = store_grnd_flux / (double) N_steps;
-    energy->latent = store_latent / (double) N_steps;
-    energy->latent_sub = store_latent_sub / (double) N_steps;
-    energy->melt_energy = store_melt_energy / (double) N_steps;
-    energy->sensible = store_sensible / (double) N_steps;
+    (*energy) = (*soil_energy);
+    energy->AlbedoOver = store.AlbedoOver / (double) N_steps;
+    energy->AlbedoUnder = store.AlbedoUnder / (double) N_steps;
+    energy->AtmosLatent = store.AtmosLatent / (double) N_steps;
+    energy->AtmosLatentSub = store.AtmosLatentSub / (double) N_steps;
+    energy->AtmosSensible = store.AtmosSensible / (double) N_steps;
+    energy->LongOverIn = store.LongOverIn / (double) N_steps;
+    energy->LongUnderIn = store.LongUnderIn / (double) N_steps;
+    energy->LongUnderOut = store.LongUnderOut / (double) N_steps;
+    energy->NetLongAtmos = store.NetLongAtmos / (double) N_steps;
+    energy->NetLongOver = store.NetLongOver / (double) N_steps;
+    energy->NetLongUnder = store.NetLongUnder / (double) N_steps;
+    energy->NetShortAtmos = store.NetShortAtmos / (double) N_steps;
+    energy->NetShortGrnd = store.NetShortGrnd / (double) N_steps;
+    energy->NetShortOver = store.NetShortOver / (double) N_steps;
+    energy->NetShortUnder = store.NetShortUnder / (double) N_steps;
+    energy->ShortOverIn = store.ShortOverIn / (double) N_steps;
+    energy->ShortUnderIn = store.ShortUnderIn / (double) N_steps;
+    energy->advected_sensible = store.advected_sensible / (double) N_steps;
+    energy->canopy_advection = store.canopy_advection / (double) N_steps;
+    energy->canopy_latent = store.canopy_latent / (double) N_steps;
+    energy->canopy_latent_sub = store.canopy_latent_sub / (double) N_steps;
+    energy->canopy_refreeze = store.canopy_refreeze / (double) N_steps;
+    energy->canopy_sensible = store.canopy_sensible / (double) N_steps;
+    energy->deltaH = store.deltaH / (double) N_steps;
+    energy->fusion = store.fusion / (double) N_steps;
+    energy->grnd_flux = store.grnd_flux / (double) N_steps;
+    energy->latent = store.latent / (double) N_steps;
+    energy->latent_sub = store.latent_sub / (double) N_steps;
+    energy->melt_energy = store.melt_energy / (double) N_steps;
+    energy->sensible = store.sensible / (double) N_steps;
     if (snow->snow || INCLUDE_SNOW) {
-        energy->advection = store_advection / (double) N_steps;
-        energy->deltaCC = store_deltaCC / (double) N_steps;
-        energy->refreeze_energy = store_refreeze_energy / (double) N_steps;
-        energy->snow_flux = store_snow_flux / (double) N_steps;
+        energy->advection = store.advection / (double) N_steps;
+        energy->deltaCC = store.deltaCC / (double) N_steps;
+        energy->refreeze_energy = store.refreeze_energy / (double) N_steps;
+        energy->snow_flux = store.snow_flux / (double) N_steps;
     }
-    energy->Tfoliage = snow_energy.Tfoliage;
-    energy->Tfoliage_fbflag = snow_energy.Tfoliage_fbflag;
-    energy->Tfoliage_fbcount = snow_energy.Tfoliage_fbcount;
+    energy->Tfoliage = snow_energy->Tfoliage;
+    energy->Tfoliage_fbflag = snow_energy->Tfoliage_fbflag;
+    energy->Tfoliage_fbcount = snow_energy->Tfoliage_fbcount;
 
     /**********************************************************
        Store vegetation variable sums for sub-model time steps
     **********************************************************/
 
     if (iveg != Nveg) {
-        veg_var->throughfall = store_throughfall;
-        veg_var->canopyevap = store_canopyevap;
+        veg_var->throughfall = store.throughfall;
+        veg_var->canopyevap = store.canopyevap;
         if (snow->snow) {
-            veg_var->Wdew = snow_veg_var.Wdew;
+            veg_var->Wdew = snow_veg_var->Wdew;
         }
         else {
-            veg_var->Wdew = soil_veg_var.Wdew;
+            veg_var->Wdew = soil_veg_var->Wdew;
         }
     }
 
@@ -1027,51 +1052,51 @@ surface_fluxes(bool                 overstory,
 
     for (lidx = 0; lidx < Nlayers; lidx++) {
         layer[lidx] = step_layer[lidx];
-        layer[lidx].evap = store_layerevap[lidx];
+        layer[lidx].evap = store.layerevap[lidx];
     }
-    if (store_aero_cond_used[0] > 0 && store_aero_cond_used[0] <
+    if (store.aero_cond_used[0] > 0 && store.aero_cond_used[0] <
         param.HUGE_RESIST) {
-        aero_resist_used[0] = 1 / (store_aero_cond_used[0] / (double) N_steps);
+        aero_resist_used[0] = 1 / (store.aero_cond_used[0] / (double) N_steps);
     }
-    else if (store_aero_cond_used[0] >= param.HUGE_RESIST) {
+    else if (store.aero_cond_used[0] >= param.HUGE_RESIST) {
         aero_resist_used[0] = 0;
     }
     else {
         aero_resist_used[0] = param.HUGE_RESIST;
     }
-    if (store_aero_cond_used[1] > 0 && store_aero_cond_used[1] <
+    if (store.aero_cond_used[1] > 0 && store.aero_cond_used[1] <
         param.HUGE_RESIST) {
-        aero_resist_used[1] = 1 / (store_aero_cond_used[1] / (double) N_steps);
+        aero_resist_used[1] = 1 / (store.aero_cond_used[1] / (double) N_steps);
     }
-    else if (store_aero_cond_used[1] >= param.HUGE_RESIST) {
+    else if (store.aero_cond_used[1] >= param.HUGE_RESIST) {
         aero_resist_used[1] = 0;
     }
     else {
         aero_resist_used[1] = param.HUGE_RESIST;
     }
-    cell->pot_evap = store_pot_evap;
+    cell->pot_evap = store.pot_evap;
 
     /**********************************************************
        Store carbon cycle variable sums for sub-model time steps
     **********************************************************/
 
-    if (options.CARBON && iveg != Nveg) {
-        veg_var->rc = 1 / store_gc / (double) N_steps;
+    if (OPT_CARBON && iveg != Nveg) {
+        veg_var->rc = 1 / store.gc / (double) N_steps;
         for (cidx = 0; cidx < options.Ncanopy; cidx++) {
-            veg_var->rsLayer[cidx] = 1 / store_gsLayer[cidx] / (double) N_steps;
+            veg_var->rsLayer[cidx] = 1 / store.gsLayer[cidx] / (double) N_steps;
         }
-        veg_var->Ci = store_Ci / (double) N_steps;
-        veg_var->GPP = store_GPP / (double) N_steps;
-        veg_var->Rdark = store_Rdark / (double) N_steps;
-        veg_var->Rphoto = store_Rphoto / (double) N_steps;
-        veg_var->Rmaint = store_Rmaint / (double) N_steps;
-        veg_var->Rgrowth = store_Rgrowth / (double) N_steps;
-        veg_var->Raut = store_Raut / (double) N_steps;
-        veg_var->NPP = store_NPP / (double) N_steps;
-
-        free((char *) (store_gsLayer));
-
+        veg_var->Ci = store.Ci / (double) N_steps;
+        veg_var->GPP = store.GPP / (double) N_steps;
+        veg_var->Rdark = store.Rdark / (double) N_steps;
+        veg_var->Rphoto = store.Rphoto / (double) N_steps;
+        veg_var->Rmaint = store.Rmaint / (double) N_steps;
+        veg_var->Rgrowth = store.Rgrowth / (double) N_steps;
+        veg_var->Raut = store.Raut / (double) N_steps;
+        veg_var->NPP = store.NPP / (double) N_steps;
+
+        perf_region_start(PERF_CARBON);
         soil_carbon_balance(soil_con, energy, cell, veg_var);
+        perf_region_stop(PERF_CARBON);
 
         // Update running total annual NPP
         if (veg_var->NPP > 0) {
@@ -1079,6 +1104,7 @@ surface_fluxes(bool                 overstory,
                                   gp->dt;
         }
     }
+    scratch_release(scratch_start);
 
     /********************************************************
        Compute Runoff, Baseflow, and Soil Moisture Transport
@@ -1086,8 +1112,38 @@ surface_fluxes(bool                 overstory,
 
     (*inflow) = ppt;
 
+    perf_region_start(PERF_RUNOFF);
     ErrorFlag = runoff(cell, energy, soil_con, ppt, soil_con->frost_fract,
-                       options.Nnode);
+                       OPT_Nnode);
+    perf_region_stop(PERF_RUNOFF);
 
     return(ErrorFlag);
 }
+
+/******************************************************************************
+ * @brief    Check whether the snow model can run a time step in one step with
+ *           ADAPTIVE_SUBSTEPS.
+ * @details  The snow pack must be dry and not melting, and the air
+ *           temperature of every snow model sub-step must be below
+ *           ADAPT_SNOW_TAIR, so that no rain falls and no melt water forms.
+ *****************************************************************************/
+bool
+snow_single_step(snow_data_struct  *snow,
+                 force_data_struct *force,
+                 double             Tfactor)
+{
+    extern parameters_struct param;
+
+    size_t                   i;
+
+    if (NF <= 1 || !(snow->swq > 0) || snow->MELTING ||
+        snow->pack_water > 0 || snow->surf_water > 0) {
+        return false;
+    }
+    for (i = 0; i < NF; i++) {
+        if (!(force->air_temp[i] + Tfactor < param.ADAPT_SNOW_TAIR)) {
+            return false;
+        }
+    }
+    return true;
+}
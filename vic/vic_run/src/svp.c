@@ -26,13 +26,66 @@
 
 #include <vic_run.h>
 
+#define SVP_TABLE_SIZE ((SVP_TABLE_TMAX - SVP_TABLE_TMIN) * SVP_TABLE_RES + 1)
+
+static double svp_table[SVP_TABLE_SIZE];
+static double svp_slope_table[SVP_TABLE_SIZE];
+static bool   svp_table_set = false;
+
+/******************************************************************************
+* @brief        Linear interpolation in a saturated vapor pressure table
+*
+* @return       false if temp lies outside of the table
+******************************************************************************/
+static bool
+svp_table_lookup(const double *table,
+                 double        temp,
+                 double       *value)
+{
+    double x;
+    size_t i;
+
+    x = (temp - SVP_TABLE_TMIN) * SVP_TABLE_RES;
+    if (!(x >= 0 && x < SVP_TABLE_SIZE - 1)) {
+        return false;
+    }
+    i = (size_t) x;
+    x -= (double) i;
+    *value = table[i] + x * (table[i + 1] - table[i]);
+
+    return true;
+}
+
+/******************************************************************************
+* @brief        Build the saturated vapor pressure tables used when
+*               options.FAST_SVP is set.
+*
+* @note         The tables depend on param.SVP_A, param.SVP_B and param.SVP_C
+*               and have to be rebuilt when these change. The nodes are exact
+*               binary fractions of a degree, so that 0 C is a node and no
+*               interval straddles the change of expression at 0 C.
+******************************************************************************/
+void
+initialize_svp_table(void)
+{
+    size_t i;
+    double temp;
+
+    for (i = 0; i < SVP_TABLE_SIZE; i++) {
+        temp = SVP_TABLE_TMIN + (double) i / SVP_TABLE_RES;
+        svp_table[i] = svp_exact(temp);
+        svp_slope_table[i] = svp_slope_exact(temp);
+    }
+    svp_table_set = true;
+}
+
 /******************************************************************************
 * @brief        This routine computes the saturated vapor pressure
 *
 * @note         Handbook of Hydrology eqn 4.2.2.
 ******************************************************************************/
 double
-svp(double temp)
+svp_exact(double temp)
 {
     extern parameters_struct param;
 
@@ -53,10 +106,50 @@ svp(double temp)
 * @note         Handbook of Hydrology eqn 4.2.3
 ******************************************************************************/
 double
-svp_slope(double temp)
+svp_slope_exact(double temp)
 {
     extern parameters_struct param;
 
     return (param.SVP_B * param.SVP_C) / ((param.SVP_C + temp) *
-                                          (param.SVP_C + temp)) * svp(temp);
+                                          (param.SVP_C + temp)) *
+           svp_exact(temp);
+}
+
+/******************************************************************************
+* @brief        Saturated vapor pressure (Pa), interpolated in the table when
+*               options.FAST_SVP is set and temp lies inside of it.
+******************************************************************************/
+double
+svp(double temp)
+{
+    extern option_struct options;
+
+    double               SVP;
+
+    if (options.FAST_SVP && svp_table_set &&
+        svp_table_lookup(svp_table, temp, &SVP)) {
+        return SVP;
+    }
+
+    return svp_exact(temp);
+}
+
+/******************************************************************************
+* @brief        Gradient of the saturated vapor pressure (Pa/K), interpolated
+*               in the table when options.FAST_SVP is set and temp lies inside
+*               of it.
+******************************************************************************/
+double
+svp_slope(double temp)
+{
+    extern option_struct options;
+
+    double               slope;
+
+    if (options.FAST_SVP && svp_table_set &&
+        svp_table_lookup(svp_slope_table, temp, &slope)) {
+        return slope;
+    }
+
+    return svp_slope_exact(temp);
 }
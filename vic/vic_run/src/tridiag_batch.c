@@ -0,0 +1,104 @@
+/******************************************************************************
+* @section DESCRIPTION
+*
+* Batched tridiagonal solver
+*
+* @section LICENSE
+*
+* The Variable Infiltration Capacity (VIC) macroscale hydrological model
+* Copyright (C) 2016 The Computational Hydrology Group, Department of Civil
+* and Environmental Engineering, University of Washington.
+*
+* The VIC model is free software; you can redistribute it and/or
+* modify it under the terms of the GNU General Public License
+* as published by the Free Software Foundation; either version 2
+* of the License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License along with
+* this program; if not, write to the Free Software Foundation, Inc.,
+* 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+******************************************************************************/
+
+#include <vic_run.h>
+
+/******************************************************************************
+* @brief    Solve nsys tridiagonal systems of the same size n at once.
+*
+* @details  The systems are stored interleaved: element i of system s is at
+*           index i * nsys + s of a, b, c, y and x, so that the loops over the
+*           systems are contiguous and vectorize. a is the sub-diagonal (a[0]
+*           is not used), b the diagonal and c the super-diagonal (c[n - 1] is
+*           not used). The inputs are not modified.
+*
+*           The arithmetic is that of tridia(): LU decomposition with the
+*           diagonal elements as pivots, followed by the solution. As there,
+*           no tests for singularity are made, so the matrices must be
+*           diagonally dominant and non-singular.
+*
+* @param n      Number of equations of every system (at least 2)
+* @param nsys   Number of systems
+* @param a      Sub-diagonals [n * nsys]
+* @param b      Diagonals [n * nsys]
+* @param c      Super-diagonals [n * nsys]
+* @param y      Right hand sides [n * nsys]
+* @param x      Solutions [n * nsys], may not alias the inputs
+* @param work   Caller-provided workspace of 2 * n * nsys doubles
+******************************************************************************/
+void
+tridiag_batch(size_t        n,
+              size_t        nsys,
+              const double *a,
+              const double *b,
+              const double *c,
+              const double *y,
+              double       *x,
+              double       *work)
+{
+    double *alpha;
+    double *gamma;
+    size_t  nm1;
+    size_t  i;
+    size_t  j;
+    size_t  s;
+
+    alpha = work;
+    gamma = work + n * nsys;
+    nm1 = n - 1;
+
+    // Obtain the LU decompositions
+    #pragma omp simd
+    for (s = 0; s < nsys; s++) {
+        alpha[s] = 1. / b[s];
+        gamma[s] = c[s] * alpha[s];
+        x[s] = y[s] * alpha[s];
+    }
+    for (i = 1; i < nm1; i++) {
+        j = i * nsys;
+        #pragma omp simd
+        for (s = j; s < j + nsys; s++) {
+            alpha[s] = 1. / (b[s] - a[s] * gamma[s - nsys]);
+            gamma[s] = c[s] * alpha[s];
+            x[s] = (y[s] - a[s] * x[s - nsys]) * alpha[s];
+        }
+    }
+
+    // Solve the systems
+    j = nm1 * nsys;
+    #pragma omp simd
+    for (s = j; s < j + nsys; s++) {
+        x[s] = (y[s] - a[s] * x[s - nsys]) /
+               (b[s] - a[s] * gamma[s - nsys]);
+    }
+    for (i = nm1; i-- > 0;) {
+        j = i * nsys;
+        #pragma omp simd
+        for (s = j; s < j + nsys; s++) {
+            x[s] = x[s] - gamma[s] * x[s + nsys];
+        }
+    }
+}
@@ -27,7 +27,9 @@
 
 #include <vic_run.h>
 
-veg_lib_struct *vic_run_veg_lib;
+vic_run_ref_struct   vic_run_ref;
+size_t               solver_stats[N_SOLVER_STATS];
+scratch_arena_struct vic_scratch;
 
 /******************************************************************************
 * @brief        This subroutine controls the model core, it solves both the
@@ -54,6 +56,9 @@ vic_run(force_data_struct   *force,
     unsigned short           veg_class;
     unsigned short           band;
     size_t                   Nbands;
+    size_t                   rep;
+    size_t                   band_rep[MAX_BANDS];
+    bool                     merge_bands;
     int                      ErrorFlag;
     double                   out_prec[2 * MAX_BANDS];
     double                   out_rain[2 * MAX_BANDS];
@@ -73,6 +78,10 @@ vic_run(force_data_struct   *force,
     double                   Melt[2 * MAX_BANDS];
     double                   bare_albedo;
     double                   snow_inflow[MAX_BANDS];
+    double                   Tfactor[MAX_BANDS];
+    double                   Pfactor[MAX_BANDS];
+    double                   Tfactor_band;
+    double                   Pfactor_band;
     double                   rainonly;
     double                   sum_runoff;
     double                   sum_baseflow;
@@ -94,19 +103,19 @@ vic_run(force_data_struct   *force,
     energy_bal_struct      **energy;
     snow_data_struct       **snow;
 
-    // assign vic_run_veg_lib to veg_lib, so that the veg_lib for the correct
-    // grid cell is used within vic_run. For simplicity sake, use vic_run_veg_lib
-    // everywhere within vic_run
-    vic_run_veg_lib = veg_lib;
+    // reset the solver counters of the grid cell
+    memset(solver_stats, 0, sizeof(solver_stats));
+    // temporaries left by a failed call of the last grid cell
+    scratch_reset();
 
     /* set local pointers */
     cell = all_vars->cell;
     energy = all_vars->energy;
-    lake_var = &all_vars->lake_var;
+    lake_var = all_vars->lake_var;
     snow = all_vars->snow;
     veg_var = all_vars->veg_var;
 
-    Nbands = options.SNOW_BAND;
+    Nbands = OPT_SNOW_BAND;
 
     /* Set number of vegetation types */
     Nveg = veg_con[0].vegetat_type_num;
@@ -149,7 +158,7 @@ vic_run(force_data_struct   *force,
         /** Solve Veg Type only if Coverage Greater than 0% **/
         if (veg_con[iveg].Cv > 0.0) {
             Cv = veg_con[iveg].Cv;
-            Nbands = options.SNOW_BAND;
+            Nbands = OPT_SNOW_BAND;
 
             /** Lake-specific processing **/
             if (veg_con[iveg].LAKE) {
@@ -216,16 +225,27 @@ vic_run(force_data_struct   *force,
 
             /** Assign wind_h **/
             /** Note: this is ignored below **/
-            wind_h = vic_run_veg_lib[veg_class].wind_h;
+            wind_h = veg_lib[veg_class].wind_h;
 
             /** Compute Surface Attenuation due to Vegetation Coverage **/
             surf_atten = (1 - veg_var[iveg][0].fcanopy) * 1.0 +
                          veg_var[iveg][0].fcanopy *
-                         exp(-vic_run_veg_lib[veg_class].rad_atten *
+                         exp(-veg_lib[veg_class].rad_atten *
                              veg_var[iveg][0].LAI);
 
+            /* Solve the similar snow-free bands as one band */
+            merge_bands = options.BAND_MERGE && Nbands > 1;
+            for (band = 0; band < Nbands; band++) {
+                band_rep[band] = band;
+            }
+            if (merge_bands) {
+                merge_snow_bands(iveg, Nbands, all_vars, force, soil_con,
+                                 band_rep, Tfactor, Pfactor);
+            }
+
             /* Initialize soil thermal properties for the top two layers */
-            prepare_full_energy(iveg, all_vars, soil_con, moist0, ice0);
+            prepare_full_energy(iveg, Nbands, all_vars, soil_con, moist0,
+                                ice0);
 
             /** Compute Bare (free of snow) Albedo **/
             if (iveg != Nveg) {
@@ -250,7 +270,7 @@ vic_run(force_data_struct   *force,
             if (roughness[0] == 0) {
                 roughness[0] = soil_con->rough;
             }
-            overstory = vic_run_veg_lib[veg_class].overstory;
+            overstory = veg_lib[veg_class].overstory;
 
             /* Estimate vegetation height */
             height = calc_veg_height(displacement[0]);
@@ -265,9 +285,9 @@ vic_run(force_data_struct   *force,
 
             /* Compute aerodynamic resistance */
             ErrorFlag = CalcAerodynamic(overstory, height,
-                                        vic_run_veg_lib[veg_class].trunk_ratio,
+                                        veg_lib[veg_class].trunk_ratio,
                                         soil_con->snow_rough, soil_con->rough,
-                                        vic_run_veg_lib[veg_class].wind_atten,
+                                        veg_lib[veg_class].wind_atten,
                                         aero_resist, tmp_wind,
                                         displacement, ref_height,
                                         roughness);
@@ -286,14 +306,14 @@ vic_run(force_data_struct   *force,
             }
 
             // Compute nitrogen scaling factors and initialize other veg vars
-            if (options.CARBON && iveg < Nveg) {
+            if (OPT_CARBON && iveg < Nveg) {
                 for (band = 0; band < Nbands; band++) {
                     for (cidx = 0; cidx < options.Ncanopy; cidx++) {
                         veg_var[iveg][band].rsLayer[cidx] = param.HUGE_RESIST;
                     }
                     veg_var[iveg][band].aPAR = 0;
                     calc_Nscale_factors(
-                        vic_run_veg_lib[veg_class].NscaleFlag,
+                        veg_lib[veg_class].NscaleFlag,
                         veg_con[iveg].CanopLayerBnd,
                         veg_var[iveg][band].LAI,
                         force->coszen[NR],
@@ -312,7 +332,24 @@ vic_run(force_data_struct   *force,
             ******************************/
 
             for (band = 0; band < Nbands; band++) {
-                if (soil_con->AreaFract[band] > 0) {
+                if (soil_con->AreaFract[band] > 0 && band_rep[band] != band) {
+                    /* the band was solved with its representative band */
+                    rep = band_rep[band];
+                    copy_snow_band(iveg, rep, band, all_vars);
+                    Melt[band * 2] = Melt[rep * 2];
+                    snow_inflow[band] = snow_inflow[rep];
+                    out_prec[band * 2] = out_prec[rep * 2];
+                    out_rain[band * 2] = out_rain[rep * 2];
+                    out_snow[band * 2] = out_snow[rep * 2];
+
+                    force->out_prec +=
+                        out_prec[band * 2] * Cv * soil_con->AreaFract[band];
+                    force->out_rain +=
+                        out_rain[band * 2] * Cv * soil_con->AreaFract[band];
+                    force->out_snow +=
+                        out_snow[band * 2] * Cv * soil_con->AreaFract[band];
+                }
+                else if (soil_con->AreaFract[band] > 0) {
                     lag_one = veg_con[iveg].lag_one;
                     sigma_slope = veg_con[iveg].sigma_slope;
                     fetch = veg_con[iveg].fetch;
@@ -320,6 +357,17 @@ vic_run(force_data_struct   *force,
                     /* Initialize pot_evap */
                     cell[iveg][band].pot_evap = 0;
 
+                    // a group of merged bands is solved with its mean
+                    // lapse rate factors
+                    Tfactor_band = soil_con->Tfactor[band];
+                    Pfactor_band = soil_con->Pfactor[band];
+                    if (merge_bands) {
+                        soil_con->Tfactor[band] = Tfactor[band];
+                        soil_con->Pfactor[band] = Pfactor[band];
+                    }
+                    solver_stats[SOLVER_BAND_SOLVES]++;
+
+                    perf_region_start(PERF_SURFACE_FLUXES);
                     ErrorFlag = surface_fluxes(overstory, bare_albedo,
                                                ice0[band], moist0[band],
                                                surf_atten, &(Melt[band * 2]),
@@ -332,14 +380,19 @@ vic_run(force_data_struct   *force,
                                                ref_height, roughness,
                                                &snow_inflow[band],
                                                tmp_wind, veg_con[iveg].root,
-                                               options.Nlayer, Nveg, band, dp,
-                                               iveg, veg_class, force, dmy,
+                                               OPT_Nlayer, Nveg, band, dp,
+                                               iveg, veg_class, veg_lib, force,
+                                               dmy,
                                                &(energy[iveg][band]), gp,
                                                &(cell[iveg][band]),
                                                &(snow[iveg][band]),
                                                soil_con, &(veg_var[iveg][band]),
                                                lag_one, sigma_slope, fetch,
                                                veg_con[iveg].CanopLayerBnd);
+                    perf_region_stop(PERF_SURFACE_FLUXES);
+
+                    soil_con->Tfactor[band] = Tfactor_band;
+                    soil_con->Pfactor[band] = Pfactor_band;
 
                     if (ErrorFlag == ERROR) {
                         return (ERROR);
@@ -357,7 +410,7 @@ vic_run(force_data_struct   *force,
                     ********************************************************/
                     cell[iveg][band].rootmoist = 0;
                     cell[iveg][band].wetness = 0;
-                    for (lidx = 0; lidx < options.Nlayer; lidx++) {
+                    for (lidx = 0; lidx < OPT_Nlayer; lidx++) {
                         if (veg_con[iveg].root[lidx] > 0) {
                             cell[iveg][band].rootmoist +=
                                 cell[iveg][band].layer[lidx].moist;
@@ -368,7 +421,7 @@ vic_run(force_data_struct   *force,
                             (soil_con->porosity[lidx] * soil_con->depth[lidx] *
                              MM_PER_M - soil_con->Wpwp[lidx]);
                     }
-                    cell[iveg][band].wetness /= options.Nlayer;
+                    cell[iveg][band].wetness /= OPT_Nlayer;
                 } /** End non-zero area band **/
             } /** End Loop Through Elevation Bands **/
         } /** end non-zero area veg tile **/
@@ -388,7 +441,7 @@ vic_run(force_data_struct   *force,
 
     /** Compute total runoff and baseflow for all vegetation types
         within each snowband. **/
-    if (options.LAKES && lake_con->lake_idx >= 0) {
+    if (OPT_LAKES && lake_con->lake_idx >= 0) {
         wetland_runoff = wetland_baseflow = 0;
         sum_runoff = sum_baseflow = 0;
 
@@ -397,7 +450,7 @@ vic_run(force_data_struct   *force,
             /** Solve Veg Tile only if Coverage Greater than 0% **/
             if (veg_con[iveg].Cv > 0.) {
                 Cv = veg_con[iveg].Cv;
-                Nbands = options.SNOW_BAND;
+                Nbands = OPT_SNOW_BAND;
                 if (veg_con[iveg].LAKE) {
                     Cv *= (1 - lakefrac);
                     Nbands = 1;
@@ -459,6 +512,7 @@ vic_run(force_data_struct   *force,
         force->out_rain += rainprec * Cv;
         force->out_snow += snowprec * Cv;
 
+        perf_region_start(PERF_LAKES);
         ErrorFlag = solve_lake(snowprec, rainprec, force->air_temp[NR],
                                force->wind[NR], force->vp[NR] / PA_PER_KPA,
                                force->shortwave[NR], force->longwave[NR],
@@ -475,13 +529,35 @@ vic_run(force_data_struct   *force,
            Solve the water budget for the lake.
         **********************************************************************/
 
-        ErrorFlag = water_balance(lake_var, *lake_con, gp->dt, all_vars,
+        ErrorFlag = water_balance(lake_var, lake_con, gp->dt, all_vars,
                                   iveg, band, lakefrac, *soil_con,
                                   veg_con[iveg]);
         if (ErrorFlag == ERROR) {
             return (ERROR);
         }
-    } // end if (options.LAKES && lake_con->lake_idx >= 0)
+        perf_region_stop(PERF_LAKES);
+    } // end if (OPT_LAKES && lake_con->lake_idx >= 0)
 
     return (0);
 }
+
+/******************************************************************************
+* @brief        Print the grid cell and time step vic_run is working on.
+******************************************************************************/
+char *
+sprint_vic_run_ref(char *str)
+{
+    const char *id_name;
+
+    id_name = vic_run_ref.id_name != NULL ? vic_run_ref.id_name : "index";
+    if (vic_run_ref.dmy == NULL) {
+        sprintf(str, "Gridcell %s: %zu", id_name, vic_run_ref.id);
+    }
+    else {
+        sprintf(str, "Gridcell %s: %zu, timestep info: %04d-%02hu-%02hu "
+                "%05u seconds", id_name, vic_run_ref.id,
+                vic_run_ref.dmy->year, vic_run_ref.dmy->month,
+                vic_run_ref.dmy->day, vic_run_ref.dmy->dayseconds);
+    }
+    return str;
+}
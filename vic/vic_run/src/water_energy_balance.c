@@ -79,6 +79,7 @@ water_energy_balance(int     numnod,
 
     double                   de[MAX_LAKE_NODES];
     double                   epsilon = 0.0001;
+    lake_column_struct       column;
 
     /* Calculate the surface energy balance for water surface temp = 0.0 */
 
@@ -91,6 +92,15 @@ water_energy_balance(int     numnod,
 
     energycalc(T, &jouleold, numnod, dz, surfdz, surface, cp, water_density);
 
+    /* --------------------------------------------------------------------
+     * Calculate the eddy diffusivity and the tridiagonal matrix, neither
+     * of which changes between the iterations on the skin temperature.
+     * -------------------------------------------------------------------- */
+
+    eddy(1, wind, water_density, de, lat, numnod, dz, surfdz);
+    set_lake_column(numnod, dz, surfdz, surface, &column);
+    set_lake_column_diffusion(de, dt, &column);
+
     while ((fabs(Tmean - Ts) > epsilon) && iterations < param.LAKE_MAX_ITER) {
         if (iterations == 0) {
             Ts = T[0];
@@ -134,21 +144,14 @@ water_energy_balance(int     numnod,
            Temperatures at Water Thermal Nodes
         *************************************************************/
 
-        /* --------------------------------------------------------------------
-         * Calculate the eddy diffusivity.
-         * -------------------------------------------------------------------- */
-
-        eddy(1, wind, water_density, de, lat, numnod, dz, surfdz);
-
         /* --------------------------------------------------------------------
          * Calculate the lake temperatures at different levels for the
          * new timestep.
          * -------------------------------------------------------------------- */
 
         temp_area(shortwave * param.LAKE_A1, shortwave * param.LAKE_A2,
-                  *Qle + *Qh + *LWnet, T, Tnew,
-                  water_density, de, dt, surface, numnod,
-                  dz, surfdz, &joulenew, cp, energy_out_bottom);
+                  *Qle + *Qh + *LWnet, T, Tnew, water_density, cp, &column,
+                  &joulenew, energy_out_bottom);
 
         /* Surface temperature < 0.0, then ice will form. */
         if (Tnew[0] < Tcutoff) {
@@ -61,6 +61,7 @@ water_under_ice(int     freezeflag,
     double                   epsilon = 0.0001;
     double                   qw_init, qw_mean, qw_final;
     double                   sw_underice_visible, sw_underice_nir;
+    lake_column_struct       column;
 
     iterations = 0;
 
@@ -70,6 +71,8 @@ water_under_ice(int     freezeflag,
 
     // compute the eddy diffusivity
     eddy(freezeflag, wind, water_density, de, lat, numnod, dz, surfdz);
+    set_lake_column(numnod, dz, surfdz, surface, &column);
+    set_lake_column_diffusion(de, dt, &column);
 
     // estimate the flux out of the water
     qw_init = 0.57 * (Ti[0] - Tcutoff) / (surfdz / 2.);
@@ -102,8 +105,8 @@ water_under_ice(int     freezeflag,
          * -------------------------------------------------------------------- */
 
         temp_area(sw_underice_visible, sw_underice_nir, -1. * (*qw), Ti, Tnew,
-                  water_density, de, dt, surface, numnod,
-                  dz, surfdz, &joulenew, water_cp, energy_out_bottom);
+                  water_density, water_cp, &column, &joulenew,
+                  energy_out_bottom);
 
         // recompute storage of heat in the lake
         *deltaH = (joulenew - jouleold) / (surface[0] * dt);
@@ -48,28 +48,28 @@ write_layer(layer_data_struct *layer,
 
     printf("Layer Data for Vegetation Type #%i\n", veg);
     printf("Layer:\t");
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         printf("\t\t%zu", index + 1);
     }
     printf("\nEvaporation:\t");
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         printf("\t%f", layer[index].evap);
     }
     printf("\n      Kappa:\t");
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         printf("\t%f", layer[index].kappa);
     }
     printf("\n         Cs:\t");
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         printf("\t%f", layer[index].Cs);
     }
     printf(
         "\n\nMoisture Table\n---------------------------------------------------------------------------\n Moist:\t");
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         printf("\t%f", layer[index].moist);
     }
     printf("\n        Ice:\t");
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         avg_ice = 0;
         for (frost_area = 0; frost_area < options.Nfrost; frost_area++) {
             avg_ice += layer[index].ice[frost_area] * frost_fract[frost_area];
@@ -79,7 +79,7 @@ write_layer(layer_data_struct *layer,
     printf(
         "\n---------------------------------------------------------------------------\nLayer Moist:\t");
     sum_moist = 0.;
-    for (index = 0; index < options.Nlayer; index++) {
+    for (index = 0; index < OPT_Nlayer; index++) {
         layer_moist = layer[index].moist;
         sum_moist += layer_moist;
         printf("\t%f", layer_moist);